@@ -14,7 +14,10 @@ in the source distribution for its full text.
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
+#include "Batch.h"
 #include "CRT.h"
 #include "CategoriesPanel.h"
 #include "CommandScreen.h"
@@ -30,12 +33,15 @@ in the source distribution for its full text.
 #include "OpenFilesScreen.h"
 #include "Process.h"
 #include "ProcessLocksScreen.h"
+#include "ProfileScreen.h"
 #include "ProvideCurses.h"
+#include "Replay.h"
 #include "Row.h"
 #include "RowField.h"
 #include "Scheduling.h"
 #include "ScreenManager.h"
 #include "SignalsPanel.h"
+#include "SortPanel.h"
 #include "Table.h"
 #include "TraceScreen.h"
 #include "UsersTable.h"
@@ -98,6 +104,9 @@ static void Action_runSetup(State* st) {
    ScreenManager_delete(scr);
    if (settings->changed) {
       CRT_setMouse(settings->enableMouse);
+      CRT_setFocusReporting(settings->unfocusedDelay > 0);
+      if (!settings->unfocusedDelay)
+         st->unfocused = false;
       Header_writeBackToSettings(st->header);
    }
 }
@@ -183,34 +192,25 @@ static bool Action_readableProcess(State* st) {
 
 static Htop_Reaction actionSetSortColumn(State* st) {
    Htop_Reaction reaction = HTOP_OK;
-   Panel* sortPanel = Panel_new(0, 0, 0, 0, Class(ListItem), true, FunctionBar_newEnterEsc("Sort   ", "Cancel "));
-   Panel_setHeader(sortPanel, "Sort by");
    Machine* host = st->host;
    Settings* settings = host->settings;
-   const RowField* fields = settings->ss->fields;
-   Hashtable* dynamicColumns = settings->dynamicColumns;
-   for (int i = 0; fields[i]; i++) {
-      char* name = NULL;
-      if (fields[i] >= ROW_DYNAMIC_FIELDS) {
-         DynamicColumn* column = Hashtable_get(dynamicColumns, fields[i]);
-         if (!column)
-            continue;
-         name = xStrdup(column->caption ? column->caption : column->name);
-      } else {
-         name = String_trim(Process_fields[fields[i]].name);
-      }
-      Panel_add(sortPanel, (Object*) ListItem_new(name, fields[i]));
-      if (fields[i] == ScreenSettings_getActiveSortKey(settings->ss))
-         Panel_setSelected(sortPanel, i);
+   ScreenSettings* ss = settings->ss;
 
-      free(name);
-   }
-   const ListItem* field = (const ListItem*) Action_pickFromVector(st, sortPanel, 14, false);
+   RowField thenSortKeys[SCREEN_THEN_SORT_KEYS + 1];
+   memcpy(thenSortKeys, ss->thenSortKeys, sizeof(thenSortKeys));
+
+   /* only processes compare by further keys */
+   SortPanel* sortPanel = SortPanel_new(ss, settings->dynamicColumns, host->activeTable == host->processTable);
+
+   const ListItem* field = (const ListItem*) Action_pickFromVector(st, (Panel*) sortPanel, 14, false);
    if (field) {
       reaction |= Action_setSortKey(settings, field->key);
    }
    Object_delete(sortPanel);
 
+   if (memcmp(thenSortKeys, ss->thenSortKeys, sizeof(thenSortKeys)) != 0)
+      reaction |= HTOP_SAVE_SETTINGS;
+
    host->activeTable->needsSort = true;
 
    return reaction | HTOP_REFRESH | HTOP_REDRAW_BAR | HTOP_UPDATE_PANELHDR;
@@ -372,6 +372,14 @@ static inline void setActiveScreen(Settings* settings, State* st, unsigned int s
    settings->ss = settings->screens[ssIdx];
    if (!settings->ss->table)
       settings->ss->table = host->processTable;
+
+   // screens added in the setup can bring a table not scanned so far
+   if (Machine_addTable(host, settings->ss->table))
+      Table_setPanel(settings->ss->table, (Panel*) st->mainPanel);
+
+   // tables of other screens are not kept up to date, catch up on the next update
+   if (host->activeTable != settings->ss->table && settings->ss->table != host->processTable)
+      settings->ss->table->nextScanMs = 0;
    host->activeTable = settings->ss->table;
 
    // set correct functionBar - readonly if requested, and/or with non-process screens
@@ -637,6 +645,56 @@ static Htop_Reaction actionTogglePauseUpdate(State* st) {
    return HTOP_REFRESH | HTOP_REDRAW_BAR;
 }
 
+/* The rows are taken from the scan this asks for, while paused from the rows shown */
+static Htop_Reaction actionExport(ATTR_UNUSED State* st) {
+   if (!Batch_requestExport())
+      return HTOP_OK;
+
+   return HTOP_RECALCULATE | HTOP_REDRAW_BAR | HTOP_KEEP_FOLLOWING;
+}
+
+static Htop_Reaction Action_replayStep(State* st, int frames) {
+   Replay_step(frames);
+   Machine_scanTables(st->host);
+   return HTOP_REFRESH | HTOP_REDRAW_BAR | HTOP_KEEP_FOLLOWING;
+}
+
+static Htop_Reaction actionReplayBack(State* st) {
+   return Action_replayStep(st, -1);
+}
+
+static Htop_Reaction actionReplayForward(State* st) {
+   return Action_replayStep(st, 1);
+}
+
+static Htop_Reaction actionReplayJump(State* st) {
+   Panel* timePanel = Panel_new(0, 0, 0, 0, Class(ListItem), true, FunctionBar_newEnterEsc("Jump   ", "Cancel "));
+   Panel_setHeader(timePanel, "Jump to");
+
+   size_t keys = Replay_keyCount();
+   uint64_t now = Replay_time();
+   for (size_t i = 0; i < keys; i++) {
+      uint64_t realtimeMs = Replay_keyTime(i);
+      time_t t = (time_t)(realtimeMs / 1000);
+      struct tm tm;
+      char when[32] = "?";
+      if (localtime_r(&t, &tm))
+         strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &tm);
+      Panel_add(timePanel, (Object*) ListItem_new(when, (int)i));
+      if (realtimeMs <= now)
+         Panel_setSelected(timePanel, (int)i);
+   }
+
+   const ListItem* item = (const ListItem*) Action_pickFromVector(st, timePanel, 21, false);
+   if (item) {
+      Replay_jump((size_t)item->key);
+      Machine_scanTables(st->host);
+   }
+   Object_delete(timePanel);
+
+   return HTOP_REFRESH | HTOP_REDRAW_BAR;
+}
+
 static const struct {
    const char* key;
    bool roInactive;
@@ -667,6 +725,7 @@ static const struct {
 static const struct {
    const char* key;
    bool roInactive;
+   bool rootOnly;         /* greyed out unless htop runs as root */
    const char* info;
 } helpRight[] = {
    { .key = "  S-Tab: ", .roInactive = false, .info = "switch to previous screen tab" },
@@ -678,16 +737,28 @@ static const struct {
    { .key = "   F8 [: ", .roInactive = true,  .info = "lower priority (+ nice)" },
 #if (defined(HAVE_LIBHWLOC) || defined(HAVE_AFFINITY))
    { .key = "      a: ", .roInactive = true, .info = "set CPU affinity" },
+#endif
+#ifdef HAVE_PERF_EVENTS
+   { .key = "      b: ", .roInactive = true,  .info = "sample CPU stacks of process" },
 #endif
    { .key = "      e: ", .roInactive = false, .info = "show process environment" },
    { .key = "      i: ", .roInactive = true,  .info = "set IO priority" },
-   { .key = "      l: ", .roInactive = true,  .info = "list open files with lsof" },
+   { .key = "      l: ", .roInactive = true,  .info = "list open files" },
+#ifdef HTOP_LINUX
+   { .key = "      L: ", .roInactive = false, .info = "show page cache residency of open files" },
+#endif
    { .key = "      x: ", .roInactive = false, .info = "list file locks of process" },
+#ifdef HTOP_LINUX
+   { .key = "      X: ", .roInactive = false, .info = "show commands exec'd most, by parent" },
+   { .key = "      B: ", .roInactive = false, .rootOnly = true, .info = "show kernel slab caches" },
+#endif
    { .key = "      s: ", .roInactive = true,  .info = "trace syscalls with strace" },
    { .key = "      w: ", .roInactive = false, .info = "wrap process command in multiple lines" },
 #ifdef SCHEDULER_SUPPORT
    { .key = "      Y: ", .roInactive = true,  .info = "set scheduling policy" },
 #endif
+   { .key = "      D: ", .roInactive = false, .info = "show timings of htop itself" },
+   { .key = "      E: ", .roInactive = false, .info = "export the rows shown to a file" },
    { .key = " F2 C S: ", .roInactive = false, .info = "setup" },
    { .key = " F1 h ?: ", .roInactive = false, .info = "show this help screen" },
    { .key = "  F10 q: ", .roInactive = false, .info = "quit" },
@@ -744,9 +815,10 @@ static Htop_Reaction actionHelp(State* st) {
    addbartext(CRT_colors[MEMORY_USED], "", "used");
    addbartext(CRT_colors[MEMORY_SHARED], "/", "shared");
    addbartext(CRT_colors[MEMORY_COMPRESSED], "/", "compressed");
+   addbartext(CRT_colors[MEMORY_SLAB], "/", "slab");
    addbartext(CRT_colors[MEMORY_BUFFERS_TEXT], "/", "buffers");
    addbartext(CRT_colors[MEMORY_CACHE], "/", "cache");
-   addbartext(CRT_colors[BAR_SHADOW], "          ", "used");
+   addbartext(CRT_colors[BAR_SHADOW], "     ", "used");
    addbartext(CRT_colors[BAR_SHADOW], "/", "total");
    addattrstr(CRT_colors[BAR_BORDER], "]");
 
@@ -811,10 +883,12 @@ static Htop_Reaction actionHelp(State* st) {
    }
    int leftHelpItems = item;
 
+   const bool root = geteuid() == 0;
    for (item = 0; helpRight[item].key; item++) {
-      attrset((helpRight[item].roInactive && readonly) ? CRT_colors[HELP_SHADOW] : CRT_colors[HELP_BOLD]);
+      const bool inactive = (helpRight[item].roInactive && readonly) || (helpRight[item].rootOnly && !root);
+      attrset(inactive ? CRT_colors[HELP_SHADOW] : CRT_colors[HELP_BOLD]);
       mvaddstr(line + item, 43, helpRight[item].key);
-      attrset((helpRight[item].roInactive && readonly) ? CRT_colors[HELP_SHADOW] : CRT_colors[DEFAULT_COLOR]);
+      attrset(inactive ? CRT_colors[HELP_SHADOW] : CRT_colors[DEFAULT_COLOR]);
       mvaddstr(line + item, 52, helpRight[item].info);
    }
    line += MAXIMUM(leftHelpItems, item);
@@ -865,6 +939,15 @@ static Htop_Reaction actionShowEnvScreen(State* st) {
    return HTOP_REFRESH | HTOP_REDRAW_BAR;
 }
 
+static Htop_Reaction actionShowProfileScreen(ATTR_UNUSED State* st) {
+   ProfileScreen* ps = ProfileScreen_new();
+   InfoScreen_run((InfoScreen*)ps);
+   ProfileScreen_delete((Object*)ps);
+   clear();
+   CRT_enableDelay();
+   return HTOP_REFRESH | HTOP_REDRAW_BAR;
+}
+
 static Htop_Reaction actionShowCommandScreen(State* st) {
    if (!Action_readableProcess(st))
       return HTOP_OK;
@@ -897,6 +980,8 @@ void Action_setBindings(Htop_Action* keys) {
    keys['>'] = actionSetSortColumn;
    keys['?'] = actionHelp;
    keys['C'] = actionSetup;
+   keys['D'] = actionShowProfileScreen;
+   keys['E'] = actionExport;
    keys['F'] = Action_follow;
    keys['H'] = actionToggleUserlandThreads;
    keys['I'] = actionInvertSortOrder;
@@ -945,4 +1030,11 @@ void Action_setBindings(Htop_Action* keys) {
    keys[KEY_RECLICK] = actionExpandOrCollapse;
    keys[KEY_SHIFT_TAB] = actionPrevScreen;
    keys['\t'] = actionNextScreen;
+
+   /* the recording is read only, so the priority keys step through it instead */
+   if (Replay_isOpen()) {
+      keys['['] = actionReplayBack;
+      keys[']'] = actionReplayForward;
+      keys['g'] = actionReplayJump;
+   }
 }
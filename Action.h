@@ -39,6 +39,7 @@ typedef struct State_ {
    bool pauseUpdate;
    bool hideSelection;
    bool hideMeters;
+   bool unfocused;       /* the terminal reported losing focus */
 } State;
 
 static inline bool State_hideFunctionBar(const State* st) {
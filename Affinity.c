@@ -11,8 +11,11 @@ in the source distribution for its full text.
 #include "Affinity.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "Macros.h"
 #include "Process.h"
 #include "XUtils.h"
 
@@ -25,35 +28,78 @@ in the source distribution for its full text.
 #define HTOP_HWLOC_CPUBIND_FLAG HWLOC_CPUBIND_PROCESS
 #endif
 #elif defined(HAVE_AFFINITY)
+#include <errno.h>
 #include <sched.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <stdio.h>
+#endif
 #endif
 
 
+#define AFFINITY_WORD_BITS (CHAR_BIT * sizeof(unsigned long))
+
+static size_t Affinity_words(unsigned int size) {
+   return (size + AFFINITY_WORD_BITS - 1) / AFFINITY_WORD_BITS;
+}
+
 Affinity* Affinity_new(Machine* host) {
    Affinity* this = xCalloc(1, sizeof(Affinity));
-   this->size = 8;
-   this->cpus = xCalloc(this->size, sizeof(unsigned int));
+   this->size = MAXIMUM(host->existingCPUs, 1U);
+   this->mask = xCalloc(Affinity_words(this->size), sizeof(unsigned long));
    this->host = host;
    return this;
 }
 
+#if defined(HAVE_LIBHWLOC)
+
+static void Affinity_freePlatformMask(void* platformMask) {
+   if (platformMask)
+      hwloc_bitmap_free(platformMask);
+}
+
+#elif defined(HAVE_AFFINITY) && defined(CPU_ALLOC)
+
+static void Affinity_freePlatformMask(void* platformMask) {
+   if (platformMask)
+      CPU_FREE(platformMask);
+}
+
+#else
+
+static void Affinity_freePlatformMask(void* platformMask) {
+   free(platformMask);
+}
+
+#endif
+
 void Affinity_delete(Affinity* this) {
-   free(this->cpus);
+   Affinity_freePlatformMask(this->platformMask);
+   free(this->mask);
    free(this);
 }
 
 void Affinity_add(Affinity* this, unsigned int id) {
-   if (this->used == this->size) {
-      this->size *= 2;
-      this->cpus = xRealloc(this->cpus, sizeof(unsigned int) * this->size);
+   if (id >= this->size) {
+      const size_t words = Affinity_words(this->size);
+      const size_t newWords = Affinity_words(id + 1);
+      this->mask = xReallocArray(this->mask, newWords, sizeof(unsigned long));
+      memset(this->mask + words, 0, (newWords - words) * sizeof(unsigned long));
+      this->size = (unsigned int)(newWords * AFFINITY_WORD_BITS);
    }
-   this->cpus[this->used] = id;
-   this->used++;
+   this->mask[id / AFFINITY_WORD_BITS] |= 1UL << (id % AFFINITY_WORD_BITS);
+}
+
+bool Affinity_isSet(const Affinity* this, unsigned int id) {
+   return id < this->size && (this->mask[id / AFFINITY_WORD_BITS] & (1UL << (id % AFFINITY_WORD_BITS)));
 }
 
 #if defined(HAVE_LIBHWLOC)
 
 static Affinity* Affinity_get(const Process* p, Machine* host) {
+   if (!Machine_loadTopology(host))
+      return NULL;
+
    hwloc_cpuset_t cpuset = hwloc_bitmap_alloc();
    bool ok = (hwloc_get_proc_cpubind(host->topology, Process_getPid(p), cpuset, HTOP_HWLOC_CPUBIND_FLAG) == 0);
    Affinity* affinity = NULL;
@@ -76,17 +122,76 @@ static Affinity* Affinity_get(const Process* p, Machine* host) {
 
 static bool Affinity_set(Process* p, Arg arg) {
    Affinity* this = arg.v;
-   hwloc_cpuset_t cpuset = hwloc_bitmap_alloc();
-   for (unsigned int i = 0; i < this->used; i++) {
-      hwloc_bitmap_set(cpuset, this->cpus[i]);
+   if (!this->platformMask) {
+      hwloc_cpuset_t cpuset = hwloc_bitmap_alloc();
+      for (unsigned int i = 0; i < this->size; i++) {
+         if (Affinity_isSet(this, i))
+            hwloc_bitmap_set(cpuset, i);
+      }
+      this->platformMask = cpuset;
    }
-   bool ok = (hwloc_set_proc_cpubind(this->host->topology, Process_getPid(p), cpuset, HTOP_HWLOC_CPUBIND_FLAG) == 0);
-   hwloc_bitmap_free(cpuset);
-   return ok;
+
+   /* a process takes the mask for all its threads, a thread shown on its own just for itself */
+   int flags = HTOP_HWLOC_CPUBIND_FLAG;
+   if (!Process_isUserlandThread(p))
+      flags = HWLOC_CPUBIND_PROCESS;
+
+   return hwloc_set_proc_cpubind(this->host->topology, Process_getPid(p), this->platformMask, flags) == 0;
 }
 
 #elif defined(HAVE_AFFINITY)
 
+#ifdef CPU_ALLOC
+
+static Affinity* Affinity_get(const Process* p, Machine* host) {
+   /* the kernel refuses masks smaller than the CPUs it was built for */
+   for (size_t cpus = MAXIMUM(host->existingCPUs, 1U); cpus <= 1U << 20; cpus *= 2) {
+      cpu_set_t* cpuset = CPU_ALLOC(cpus);
+      if (!cpuset)
+         return NULL;
+
+      const size_t setSize = CPU_ALLOC_SIZE(cpus);
+      if (sched_getaffinity(Process_getPid(p), setSize, cpuset) != 0) {
+         const bool tooSmall = errno == EINVAL;
+         CPU_FREE(cpuset);
+         if (tooSmall)
+            continue;
+         return NULL;
+      }
+
+      Affinity* affinity = Affinity_new(host);
+      for (size_t i = 0; i < cpus; i++) {
+         if (CPU_ISSET_S(i, setSize, cpuset)) {
+            Affinity_add(affinity, (unsigned int)i);
+         }
+      }
+      CPU_FREE(cpuset);
+      return affinity;
+   }
+
+   return NULL;
+}
+
+static bool Affinity_setTask(pid_t tid, const Affinity* this) {
+   return sched_setaffinity(tid, CPU_ALLOC_SIZE(this->size), this->platformMask) == 0;
+}
+
+static void Affinity_buildPlatformMask(Affinity* this) {
+   cpu_set_t* cpuset = CPU_ALLOC(this->size);
+   if (!cpuset)
+      fail();
+
+   const size_t setSize = CPU_ALLOC_SIZE(this->size);
+   CPU_ZERO_S(setSize, cpuset);
+   for (unsigned int i = 0; i < this->size; i++) {
+      if (Affinity_isSet(this, i))
+         CPU_SET_S(i, setSize, cpuset);
+   }
+   this->platformMask = cpuset;
+}
+
+#else
+
 static Affinity* Affinity_get(const Process* p, Machine* host) {
    cpu_set_t cpuset;
    bool ok = (sched_getaffinity(Process_getPid(p), sizeof(cpu_set_t), &cpuset) == 0);
@@ -94,7 +199,7 @@ static Affinity* Affinity_get(const Process* p, Machine* host) {
       return NULL;
 
    Affinity* affinity = Affinity_new(host);
-   for (unsigned int i = 0; i < host->existingCPUs; i++) {
+   for (unsigned int i = 0; i < MINIMUM(host->existingCPUs, (unsigned int)CPU_SETSIZE); i++) {
       if (CPU_ISSET(i, &cpuset)) {
          Affinity_add(affinity, i);
       }
@@ -102,15 +207,59 @@ static Affinity* Affinity_get(const Process* p, Machine* host) {
    return affinity;
 }
 
+static bool Affinity_setTask(pid_t tid, const Affinity* this) {
+   return sched_setaffinity(tid, sizeof(cpu_set_t), this->platformMask) == 0;
+}
+
+static void Affinity_buildPlatformMask(Affinity* this) {
+   cpu_set_t* cpuset = xMalloc(sizeof(cpu_set_t));
+   CPU_ZERO(cpuset);
+   for (unsigned int i = 0; i < MINIMUM(this->size, (unsigned int)CPU_SETSIZE); i++) {
+      if (Affinity_isSet(this, i))
+         CPU_SET(i, cpuset);
+   }
+   this->platformMask = cpuset;
+}
+
+#endif /* CPU_ALLOC */
+
 static bool Affinity_set(Process* p, Arg arg) {
    Affinity* this = arg.v;
-   cpu_set_t cpuset;
-   CPU_ZERO(&cpuset);
-   for (unsigned int i = 0; i < this->used; i++) {
-      CPU_SET(this->cpus[i], &cpuset);
+   if (!this->platformMask)
+      Affinity_buildPlatformMask(this);
+
+   const pid_t pid = Process_getPid(p);
+   if (!Affinity_setTask(pid, this))
+      return false;
+
+#ifdef __linux__
+   /* the mask of a process is the one of its main thread, so the other threads follow on their own */
+   if (Process_isUserlandThread(p))
+      return true;
+
+   char path[64];
+   xSnprintf(path, sizeof(path), PROCDIR "/%d/task", (int)pid);
+   DIR* dir = opendir(path);
+   if (!dir)
+      return true;
+
+   bool ok = true;
+   const struct dirent* entry;
+   while ((entry = readdir(dir)) != NULL) {
+      char* end;
+      const long tid = strtol(entry->d_name, &end, 10);
+      if (*end || tid <= 0 || tid == pid)
+         continue;
+
+      /* a thread that exited meanwhile needs no mask */
+      if (!Affinity_setTask((pid_t)tid, this) && errno != ESRCH)
+         ok = false;
    }
-   bool ok = (sched_setaffinity(Process_getPid(p), sizeof(unsigned long), &cpuset) == 0);
+   closedir(dir);
    return ok;
+#else
+   return true;
+#endif
 }
 
 #endif
@@ -8,11 +8,11 @@ Released under the GNU GPLv2+, see the COPYING file
 in the source distribution for its full text.
 */
 
+#include <stdbool.h>
+
 #include "Machine.h"
 
 #if defined(HAVE_LIBHWLOC) || defined(HAVE_AFFINITY)
-#include <stdbool.h>
-
 #include "Object.h"
 #include "Row.h"
 #endif
@@ -23,11 +23,12 @@ in the source distribution for its full text.
 #endif
 
 
+/* A set of CPUs, as a bitmap sized for the CPUs of the machine */
 typedef struct Affinity_ {
    Machine* host;
-   unsigned int size;
-   unsigned int used;
-   unsigned int* cpus;
+   unsigned int size;                  /* CPUs the mask has room for */
+   unsigned long* mask;
+   void* platformMask;                 /* the mask as the platform takes it, built once for all processes it is set for */
 } Affinity;
 
 Affinity* Affinity_new(Machine* host);
@@ -36,6 +37,8 @@ void Affinity_delete(Affinity* this);
 
 void Affinity_add(Affinity* this, unsigned int id);
 
+bool Affinity_isSet(const Affinity* this, unsigned int id);
+
 #if defined(HAVE_LIBHWLOC) || defined(HAVE_AFFINITY)
 
 Affinity* Affinity_rowGet(const Row* row, Machine* host);
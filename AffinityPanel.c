@@ -16,6 +16,7 @@ in the source distribution for its full text.
 
 #include "CRT.h"
 #include "FunctionBar.h"
+#include "Macros.h"
 #include "Object.h"
 #include "ProvideCurses.h"
 #include "RichString.h"
@@ -35,12 +36,11 @@ typedef struct MaskItem_ {
    char* indent; /* used also as an condition whether this is a tree node */
    int value; /* tri-state: 0 - off, 1 - some set, 2 - all set */
    int sub_tree; /* tri-state: 0 - no sub-tree, 1 - open sub-tree, 2 - closed sub-tree */
-   Vector* children;
+   int cpu; /* of a singleton */
    #ifdef HAVE_LIBHWLOC
-   bool ownCpuset;
-   hwloc_bitmap_t cpuset;
-   #else
-   int cpu;
+   hwloc_obj_t obj; /* of a tree node */
+   unsigned childIndent; /* the tree lines drawn before its children */
+   Vector* children; /* NULL until the node is first opened */
    #endif
 } MaskItem;
 
@@ -48,10 +48,9 @@ static void MaskItem_delete(Object* cast) {
    MaskItem* this = (MaskItem*) cast;
    free(this->text);
    free(this->indent);
-   Vector_delete(this->children);
    #ifdef HAVE_LIBHWLOC
-   if (this->ownCpuset)
-      hwloc_bitmap_free(this->cpuset);
+   if (this->children)
+      Vector_delete(this->children);
    #endif
    free(this);
 }
@@ -87,15 +86,15 @@ static const ObjectClass MaskItem_class = {
 
 #ifdef HAVE_LIBHWLOC
 
-static MaskItem* MaskItem_newMask(const char* text, const char* indent, hwloc_bitmap_t cpuset, bool owner) {
+static MaskItem* MaskItem_newNode(const char* text, const char* indent, hwloc_obj_t obj) {
    MaskItem* this = AllocThis(MaskItem);
    this->text = xStrdup(text);
    this->indent = xStrdup(indent); /* nonnull for tree node */
    this->value = 0;
-   this->ownCpuset = owner;
-   this->cpuset = cpuset;
-   this->sub_tree = hwloc_bitmap_weight(cpuset) > 1 ? 1 : 0;
-   this->children = Vector_new(Class(MaskItem), true, DEFAULT_SIZE);
+   this->cpu = -1;
+   this->obj = obj;
+   this->sub_tree = hwloc_bitmap_weight(obj->complete_cpuset) > 1 ? 1 : 0;
+   this->children = NULL;
    return this;
 }
 
@@ -106,14 +105,10 @@ static MaskItem* MaskItem_newSingleton(const char* text, int cpu, bool isSet) {
    this->text = xStrdup(text);
    this->indent = NULL; /* not a tree node */
    this->sub_tree = 0;
-   this->children = Vector_new(Class(MaskItem), true, DEFAULT_SIZE);
-
-   #ifdef HAVE_LIBHWLOC
-   this->ownCpuset = true;
-   this->cpuset = hwloc_bitmap_alloc();
-   hwloc_bitmap_set(this->cpuset, cpu);
-   #else
    this->cpu = cpu;
+   #ifdef HAVE_LIBHWLOC
+   this->obj = NULL;
+   this->children = NULL;
    #endif
    this->value = isSet ? 2 : 0;
 
@@ -151,18 +146,35 @@ static void AffinityPanel_delete(Object* cast) {
 static void AffinityPanel_updateItem(AffinityPanel* this, MaskItem* item) {
    Panel* super = (Panel*) this;
 
-   item->value = hwloc_bitmap_isincluded(item->cpuset, this->workCpuset) ? 2 :
-                 hwloc_bitmap_intersects(item->cpuset, this->workCpuset) ? 1 : 0;
+   if (item->obj) {
+      item->value = hwloc_bitmap_isincluded(item->obj->complete_cpuset, this->workCpuset) ? 2 :
+                    hwloc_bitmap_intersects(item->obj->complete_cpuset, this->workCpuset) ? 1 : 0;
+   } else {
+      item->value = hwloc_bitmap_isset(this->workCpuset, (unsigned)item->cpu) ? 2 : 0;
+   }
 
    Panel_add(super, (Object*) item);
 }
 
+static MaskItem* AffinityPanel_addObject(AffinityPanel* this, hwloc_obj_t obj, unsigned indent, MaskItem* parent);
+
+/* The nodes below a node are only made once it is shown open, a large machine has thousands */
+static void AffinityPanel_openItem(AffinityPanel* this, MaskItem* item) {
+   if (item->children)
+      return;
+
+   item->children = Vector_new(Class(MaskItem), true, MAXIMUM((int)item->obj->arity, 1));
+   for (unsigned i = 0; i < item->obj->arity; i++)
+      AffinityPanel_addObject(this, item->obj->children[i], item->childIndent, item);
+}
+
 static void AffinityPanel_updateTopo(AffinityPanel* this, MaskItem* item) {
    AffinityPanel_updateItem(this, item);
 
-   if (item->sub_tree == 2)
+   if (item->sub_tree == 2 || item->obj->arity == 0)
       return;
 
+   AffinityPanel_openItem(this, item);
    for (int i = 0; i < Vector_size(item->children); i++)
       AffinityPanel_updateTopo(this, (MaskItem*) Vector_get(item->children, i));
 }
@@ -208,12 +220,18 @@ static HandlerResult AffinityPanel_eventHandler(Panel* super, int ch) {
          #ifdef HAVE_LIBHWLOC
          if (selected->value == 2) {
             /* Item was selected, so remove this mask from the top cpuset. */
-            hwloc_bitmap_andnot(this->workCpuset, this->workCpuset, selected->cpuset);
+            if (selected->obj)
+               hwloc_bitmap_andnot(this->workCpuset, this->workCpuset, selected->obj->complete_cpuset);
+            else
+               hwloc_bitmap_clr(this->workCpuset, (unsigned)selected->cpu);
             selected->value = 0;
          } else {
             /* Item was not or only partial selected, so set all bits from this object
                in the top cpuset. */
-            hwloc_bitmap_or(this->workCpuset, this->workCpuset, selected->cpuset);
+            if (selected->obj)
+               hwloc_bitmap_or(this->workCpuset, this->workCpuset, selected->obj->complete_cpuset);
+            else
+               hwloc_bitmap_set(this->workCpuset, (unsigned)selected->cpu);
             selected->value = 2;
          }
          #else
@@ -263,13 +281,10 @@ static HandlerResult AffinityPanel_eventHandler(Panel* super, int ch) {
 
 #ifdef HAVE_LIBHWLOC
 
-static MaskItem* AffinityPanel_addObject(AffinityPanel* this, hwloc_obj_t obj, unsigned indent, MaskItem* parent) {
+static void AffinityPanel_objectName(const AffinityPanel* this, hwloc_obj_t obj, char* buf, size_t size) {
    const char* type_name = hwloc_obj_type_string(obj->type);
    const char* index_prefix = "#";
-   unsigned depth = obj->depth;
    unsigned index = obj->logical_index;
-   size_t off = 0, left = 10 * depth;
-   char buf[64], indent_buf[left + 1];
 
    if (obj->type == HWLOC_OBJ_PU) {
       index = Settings_cpuId(this->host->settings, obj->os_index);
@@ -277,6 +292,14 @@ static MaskItem* AffinityPanel_addObject(AffinityPanel* this, hwloc_obj_t obj, u
       index_prefix = "";
    }
 
+   xSnprintf(buf, size, "%s %s%u", type_name, index_prefix, index);
+}
+
+static MaskItem* AffinityPanel_addObject(AffinityPanel* this, hwloc_obj_t obj, unsigned indent, MaskItem* parent) {
+   unsigned depth = obj->depth;
+   size_t off = 0, left = 10 * depth;
+   char buf[64], indent_buf[left + 1];
+
    indent_buf[0] = '\0';
    if (depth > 0) {
       for (unsigned i = 1; i < depth; i++) {
@@ -293,45 +316,43 @@ static MaskItem* AffinityPanel_addObject(AffinityPanel* this, hwloc_obj_t obj, u
       //left -= len;
    }
 
-   xSnprintf(buf, sizeof(buf), "%s %s%u", type_name, index_prefix, index);
+   AffinityPanel_objectName(this, obj, buf, sizeof(buf));
 
-   MaskItem* item = MaskItem_newMask(buf, indent_buf, obj->complete_cpuset, false);
+   MaskItem* item = MaskItem_newNode(buf, indent_buf, obj);
+   if (obj->next_sibling) {
+      item->childIndent = indent | (1U << depth);
+   } else {
+      item->childIndent = indent & ~(1U << depth);
+   }
    if (parent)
       Vector_add(parent->children, item);
 
-   if (item->sub_tree && parent && parent->sub_tree == 1) {
+   if (item->sub_tree && parent) {
       /* if obj is fully included or fully excluded, collapse the item */
-      hwloc_bitmap_t result = hwloc_bitmap_alloc();
-      hwloc_bitmap_and(result, obj->complete_cpuset, this->workCpuset);
-      int weight = hwloc_bitmap_weight(result);
-      hwloc_bitmap_free(result);
-      if (weight == 0 || weight == (hwloc_bitmap_weight(this->workCpuset) + hwloc_bitmap_weight(obj->complete_cpuset))) {
+      if (hwloc_bitmap_isincluded(obj->complete_cpuset, this->workCpuset) ||
+          !hwloc_bitmap_intersects(obj->complete_cpuset, this->workCpuset)) {
          item->sub_tree = 2;
       }
    }
 
+   return item;
+}
+
+/* The width of the widest node, whether or not it is opened */
+static void AffinityPanel_measureTopology(AffinityPanel* this, hwloc_obj_t obj) {
+   char buf[64];
+   AffinityPanel_objectName(this, obj, buf, sizeof(buf));
+
    /* "[x] " + "|- " * depth + ("- ")?(if root node) + name */
+   unsigned depth = obj->depth;
    unsigned width = 4 + 3 * depth + (2 * !depth) + strlen(buf);
    if (width > this->width) {
       this->width = width;
    }
 
-   return item;
-}
-
-static MaskItem* AffinityPanel_buildTopology(AffinityPanel* this, hwloc_obj_t obj, unsigned indent, MaskItem* parent) {
-   MaskItem* item = AffinityPanel_addObject(this, obj, indent, parent);
-   if (obj->next_sibling) {
-      indent |= (1U << obj->depth);
-   } else {
-      indent &= ~(1U << obj->depth);
-   }
-
    for (unsigned i = 0; i < obj->arity; i++) {
-      AffinityPanel_buildTopology(this, obj->children[i], indent, item);
+      AffinityPanel_measureTopology(this, obj->children[i]);
    }
-
-   return parent == NULL ? item : NULL;
 }
 
 #endif
@@ -382,7 +403,6 @@ Panel* AffinityPanel_new(Machine* host, const Affinity* affinity, int* width) {
 
    Panel_setHeader(super, "Use CPUs:");
 
-   unsigned int curCpu = 0;
    for (unsigned int i = 0; i < host->existingCPUs; i++) {
       if (!Machine_isCPUonline(host, i))
          continue;
@@ -394,21 +414,20 @@ Panel* AffinityPanel_new(Machine* host, const Affinity* affinity, int* width) {
          this->width = cpu_width;
       }
 
-      bool isSet = false;
-      if (curCpu < affinity->used && affinity->cpus[curCpu] == i) {
-         #ifdef HAVE_LIBHWLOC
+      bool isSet = Affinity_isSet(affinity, i);
+      #ifdef HAVE_LIBHWLOC
+      if (isSet)
          hwloc_bitmap_set(this->workCpuset, i);
-         #endif
-         isSet = true;
-         curCpu++;
-      }
+      #endif
 
       MaskItem* cpuItem = MaskItem_newSingleton(number, i, isSet);
       Vector_add(this->cpuids, (Object*) cpuItem);
    }
 
    #ifdef HAVE_LIBHWLOC
-   this->topoRoot = AffinityPanel_buildTopology(this, hwloc_get_root_obj(host->topology), 0, NULL);
+   hwloc_obj_t root = hwloc_get_root_obj(host->topology);
+   AffinityPanel_measureTopology(this, root);
+   this->topoRoot = AffinityPanel_addObject(this, root, 0, NULL);
    #endif
 
    if (width) {
@@ -433,7 +452,7 @@ Affinity* AffinityPanel_getAffinity(Panel* super, Machine* host) {
    for (int i = 0; i < Vector_size(this->cpuids); i++) {
       const MaskItem* item = (const MaskItem*)Vector_get(this->cpuids, i);
       if (item->value) {
-         Affinity_add(affinity, item->cpu);
+         Affinity_add(affinity, (unsigned)item->cpu);
       }
    }
    #endif
@@ -82,8 +82,9 @@ static HandlerResult AvailableMetersPanel_eventHandler(Panel* super, int ch) {
       settings->changed = true;
       settings->lastUpdate++;
       Header_calculateHeight(header);
+      Header_updateCollectors(header);
       Header_updateData(header);
-      Header_draw(header);
+      Header_draw(header, true);
       ScreenManager_resize(this->scr);
    }
 
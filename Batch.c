@@ -0,0 +1,644 @@
+/*
+htop - Batch.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "Batch.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+#include "CRT.h"
+#include "DynamicColumn.h"
+#include "Macros.h"
+#include "Platform.h"
+#include "Process.h"
+#include "Replay.h"
+#include "RichString.h"
+#include "Row.h"
+#include "RowField.h"
+#include "Settings.h"
+#include "Table.h"
+#include "Vector.h"
+#include "XUtils.h"
+
+
+/* Everything written for one update, handed to stdout with a single write */
+typedef struct BatchBuffer_ {
+   char* data;
+   size_t len;
+   size_t alloc;
+} BatchBuffer;
+
+typedef struct Batch_ {
+   BatchFormat format;
+   int maxRows;
+   BatchBuffer out;
+   BatchBuffer field;         /* text of the field being written */
+} Batch;
+
+BatchFormat Batch_parseFormat(const char* name) {
+   if (String_eq(name, "jsonl") || String_eq(name, "json"))
+      return BATCH_FORMAT_JSONL;
+   if (String_eq(name, "csv"))
+      return BATCH_FORMAT_CSV;
+   return BATCH_FORMAT_NONE;
+}
+
+static void Batch_putBytes(BatchBuffer* this, const char* data, size_t len) {
+   if (this->len + len > this->alloc) {
+      this->alloc = MAXIMUM(2 * this->alloc, this->len + len + 4096);
+      this->data = xRealloc(this->data, this->alloc);
+   }
+   memcpy(this->data + this->len, data, len);
+   this->len += len;
+}
+
+static inline void Batch_putChar(BatchBuffer* this, char c) {
+   Batch_putBytes(this, &c, 1);
+}
+
+static inline void Batch_putString(BatchBuffer* this, const char* str) {
+   Batch_putBytes(this, str, strlen(str));
+}
+
+static bool Batch_flush(BatchBuffer* this, int fd) {
+   const char* data = this->data;
+   size_t left = this->len;
+   while (left > 0) {
+      ssize_t written = write(fd, data, left);
+      if (written < 0) {
+         if (errno == EINTR)
+            continue;
+         return false;
+      }
+      data += written;
+      left -= (size_t)written;
+   }
+
+   this->len = 0;
+   return true;
+}
+
+static const char* Batch_columnName(const ScreenColumn* column) {
+   if (column->field >= ROW_DYNAMIC_FIELDS)
+      return column->dynamic ? column->dynamic->name : "?";
+   return Process_fields[column->field].name;
+}
+
+#ifdef HAVE_LIBNCURSESW
+/* UTF-8 whatever the locale, for the few characters htop itself draws */
+static void Batch_putUtf8(BatchBuffer* this, uint32_t c) {
+   if (c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+      c = 0xFFFD;
+
+   if (c < 0x80) {
+      Batch_putChar(this, (char)c);
+   } else if (c < 0x800) {
+      Batch_putChar(this, (char)(0xC0 | (c >> 6)));
+      Batch_putChar(this, (char)(0x80 | (c & 0x3F)));
+   } else if (c < 0x10000) {
+      Batch_putChar(this, (char)(0xE0 | (c >> 12)));
+      Batch_putChar(this, (char)(0x80 | ((c >> 6) & 0x3F)));
+      Batch_putChar(this, (char)(0x80 | (c & 0x3F)));
+   } else {
+      Batch_putChar(this, (char)(0xF0 | (c >> 18)));
+      Batch_putChar(this, (char)(0x80 | ((c >> 12) & 0x3F)));
+      Batch_putChar(this, (char)(0x80 | ((c >> 6) & 0x3F)));
+      Batch_putChar(this, (char)(0x80 | (c & 0x3F)));
+   }
+}
+#endif
+
+/*
+ * The text the row shows in the column, without its padding. Strings of
+ * the processes, like command lines, are taken byte for byte rather than
+ * decoded per the locale of the terminal, which would lose what it can
+ * not decode.
+ */
+static void Batch_fieldText(Batch* this, const Row* row, RowField field) {
+   BatchBuffer* text = &this->field;
+   text->len = 0;
+
+   RichString_begin(str);
+   RichString_rawBytes = true;
+   As_Row(row)->writeField(row, &str, field);
+   RichString_rawBytes = false;
+
+#ifdef HAVE_LIBNCURSESW
+   for (int i = 0; i < RichString_sizeVal(str); i++) {
+      const wchar_t c = RichString_getCharVal(str, i);
+      if (RichString_isRawByte(c))
+         Batch_putChar(text, (char)(c - RICHSTRING_RAW_BYTE(0)));
+      else
+         Batch_putUtf8(text, (uint32_t)c);
+   }
+#else
+   for (int i = 0; i < RichString_sizeVal(str); i++)
+      Batch_putChar(text, (char)RichString_getCharVal(str, i));
+#endif
+
+   RichString_delete(&str);
+
+   while (text->len > 0 && text->data[text->len - 1] == ' ')
+      text->len--;
+}
+
+/* Numbers as JSON accepts them; values with units like 1.5G stay strings */
+static bool Batch_isNumber(const char* s, size_t len) {
+   size_t i = 0;
+   if (i < len && s[i] == '-')
+      i++;
+   if (i == len || !isdigit((unsigned char)s[i]))
+      return false;
+   if (s[i] == '0' && i + 1 < len && isdigit((unsigned char)s[i + 1]))
+      return false;
+   while (i < len && isdigit((unsigned char)s[i]))
+      i++;
+   if (i < len && s[i] == '.') {
+      i++;
+      if (i == len || !isdigit((unsigned char)s[i]))
+         return false;
+      while (i < len && isdigit((unsigned char)s[i]))
+         i++;
+   }
+   return i == len;
+}
+
+/* Length of the well-formed UTF-8 sequence of a character not in ASCII at s, 0 if it is not one */
+static size_t Batch_utf8Length(const unsigned char* s, size_t len) {
+   size_t n;
+   unsigned char min = 0x80, max = 0xBF;
+   if (s[0] >= 0xC2 && s[0] <= 0xDF) {
+      n = 2;
+   } else if (s[0] >= 0xE0 && s[0] <= 0xEF) {
+      n = 3;
+      if (s[0] == 0xE0)
+         min = 0xA0;        /* overlong */
+      else if (s[0] == 0xED)
+         max = 0x9F;        /* surrogates */
+   } else if (s[0] >= 0xF0 && s[0] <= 0xF4) {
+      n = 4;
+      if (s[0] == 0xF0)
+         min = 0x90;
+      else if (s[0] == 0xF4)
+         max = 0x8F;        /* beyond U+10FFFF */
+   } else {
+      return 0;
+   }
+
+   if (n > len || s[1] < min || s[1] > max)
+      return 0;
+   for (size_t i = 2; i < n; i++) {
+      if (s[i] < 0x80 || s[i] > 0xBF)
+         return 0;
+   }
+   return n;
+}
+
+/* A JSON string is UTF-8, bytes of the text that are not are written as U+FFFD */
+static void Batch_putJsonString(BatchBuffer* out, const char* s, size_t len) {
+   const unsigned char* u = (const unsigned char*)s;
+
+   Batch_putChar(out, '"');
+   for (size_t i = 0; i < len; i++) {
+      unsigned char c = u[i];
+      if (c == '"' || c == '\\') {
+         Batch_putChar(out, '\\');
+         Batch_putChar(out, (char)c);
+      } else if (c < 0x20 || c == 0x7F) {
+         char esc[8];
+         xSnprintf(esc, sizeof(esc), "\\u%04x", c);
+         Batch_putString(out, esc);
+      } else if (c < 0x80) {
+         Batch_putChar(out, (char)c);
+      } else {
+         size_t n = Batch_utf8Length(u + i, len - i);
+         if (n) {
+            Batch_putBytes(out, s + i, n);
+            i += n - 1;
+         } else {
+            Batch_putString(out, "\\ufffd");
+         }
+      }
+   }
+   Batch_putChar(out, '"');
+}
+
+static void Batch_putCsvField(BatchBuffer* out, const char* s, size_t len) {
+   if (!memchr(s, ',', len) && !memchr(s, '"', len) && !memchr(s, '\n', len) && !memchr(s, '\r', len) &&
+       (len == 0 || (s[0] != ' ' && s[len - 1] != ' '))) {
+      Batch_putBytes(out, s, len);
+      return;
+   }
+
+   Batch_putChar(out, '"');
+   for (size_t i = 0; i < len; i++) {
+      if (s[i] == '"')
+         Batch_putChar(out, '"');
+      Batch_putChar(out, s[i]);
+   }
+   Batch_putChar(out, '"');
+}
+
+static void Batch_writeHeader(Batch* this, const Settings* settings) {
+   if (this->format != BATCH_FORMAT_CSV)
+      return;
+
+   int count;
+   const ScreenColumn* columns = ScreenSettings_getColumns(settings->ss, settings->dynamicColumns, &count);
+   Batch_putString(&this->out, "time");
+   for (int i = 0; i < count; i++) {
+      const char* name = Batch_columnName(&columns[i]);
+      Batch_putChar(&this->out, ',');
+      Batch_putCsvField(&this->out, name, strlen(name));
+   }
+   Batch_putChar(&this->out, '\n');
+}
+
+static void Batch_writeRow(Batch* this, const Settings* settings, const Row* row, const char* time) {
+   int count;
+   const ScreenColumn* columns = ScreenSettings_getColumns(settings->ss, settings->dynamicColumns, &count);
+   BatchBuffer* out = &this->out;
+
+   if (this->format == BATCH_FORMAT_JSONL) {
+      Batch_putString(out, "{\"time\":");
+      Batch_putString(out, time);
+   } else {
+      Batch_putString(out, time);
+   }
+
+   for (int i = 0; i < count; i++) {
+      Batch_fieldText(this, row, columns[i].field);
+
+      const char* text = this->field.data ? this->field.data : "";
+      size_t len = this->field.len;
+      while (len > 0 && *text == ' ') {
+         text++;
+         len--;
+      }
+
+      if (this->format == BATCH_FORMAT_JSONL) {
+         const char* name = Batch_columnName(&columns[i]);
+         Batch_putChar(out, ',');
+         Batch_putJsonString(out, name, strlen(name));
+         Batch_putChar(out, ':');
+         if (Batch_isNumber(text, len))
+            Batch_putBytes(out, text, len);
+         else
+            Batch_putJsonString(out, text, len);
+      } else {
+         Batch_putChar(out, ',');
+         Batch_putCsvField(out, text, len);
+      }
+   }
+
+   Batch_putString(out, this->format == BATCH_FORMAT_JSONL ? "}\n" : "\n");
+}
+
+/* Returns the number of rows written */
+static int Batch_writeUpdate(Batch* this, Machine* host) {
+   const Settings* settings = host->settings;
+   Table* table = host->activeTable;
+
+   table->needsSort = true;
+   Table_updateDisplayList(table);
+
+   char time[32];
+   xSnprintf(time, sizeof(time), "%" PRIu64 ".%03u", host->realtimeMs / 1000, (unsigned int)(host->realtimeMs % 1000));
+
+   int written = 0;
+   for (int i = 0; i < Vector_size(table->displayList); i++) {
+      if (this->maxRows > 0 && written >= this->maxRows)
+         break;
+
+      Row* row = (Row*) Vector_get(table->displayList, i);
+      if (!row->show || Row_matchesFilter(row, table))
+         continue;
+
+      Batch_writeRow(this, settings, row, time);
+      written++;
+   }
+
+   return written;
+}
+
+bool Batch_run(Machine* host, BatchFormat format, int maxRows) {
+   Settings* settings = host->settings;
+
+   Batch batch = {
+      .format = format,
+      .maxRows = maxRows,
+   };
+
+   /* nothing is drawn, exited processes are not kept around and no row is left to read lazily */
+   settings->highlightChanges = false;
+   settings->lazyCollection = false;
+   Row_plainNumbers = true;
+   CRT_initHeadless();
+
+   const uint64_t interval = MAXIMUM(100 * (uint64_t)settings->delay, 100);
+
+   /* the first scan gives no CPU usage yet */
+   Machine_scan(host);
+   Machine_scanTables(host);
+
+   Batch_writeHeader(&batch, settings);
+
+   bool ok = true;
+   uint64_t next;
+   Platform_gettime_monotonic(&next);
+
+   /* a recording is written from its first frame, which has the CPU usage, up to its last */
+   const bool replaying = Replay_isOpen();
+   if (replaying && host->iterationsRemaining != 0) {
+      Batch_writeUpdate(&batch, host);
+      ok = Batch_flush(&batch.out, STDOUT_FILENO);
+      if (host->iterationsRemaining > 0)
+         host->iterationsRemaining--;
+   }
+
+   while (ok && host->iterationsRemaining != 0 && !(replaying && Replay_atEnd())) {
+      next += interval;
+
+      uint64_t now;
+      Platform_gettime_monotonic(&now);
+      if (next > now) {
+         const uint64_t wait = next - now;
+         struct timespec ts = { .tv_sec = (time_t)(wait / 1000), .tv_nsec = (long)(wait % 1000) * 1000000L };
+         nanosleep(&ts, NULL);
+      } else {
+         /* behind after a stall, do not catch up with a burst of scans */
+         next = now;
+      }
+
+      Platform_gettime_realtime(&host->realtime, &host->realtimeMs);
+      Machine_scan(host);
+      Machine_scanTables(host);
+
+      Batch_writeUpdate(&batch, host);
+      ok = Batch_flush(&batch.out, STDOUT_FILENO);
+
+      if (host->iterationsRemaining > 0)
+         host->iterationsRemaining--;
+   }
+
+   free(batch.out.data);
+   free(batch.field.data);
+   return ok;
+}
+
+/* Messages about an export stay in the function bar this long after it was written */
+#define BATCH_EXPORT_SHOWN_MS 10000
+
+typedef enum BatchExportState_ {
+   BATCH_EXPORT_IDLE,
+   BATCH_EXPORT_WRITING,
+   BATCH_EXPORT_WRITTEN,
+   BATCH_EXPORT_FAILED,
+} BatchExportState;
+
+typedef struct BatchExport_ {
+   BatchFormat format;
+   bool requested;            /* taken by the next scan, UI thread only */
+
+   /* below guarded by Batch_exportLock while there is a writer thread */
+   BatchExportState state;
+   BatchBuffer data;          /* the formatted rows, owned by the writer while writing */
+   char path[64];
+   int rows;
+   int error;                 /* errno of a failed write */
+   uint64_t doneMs;
+} BatchExport;
+
+static BatchExport Batch_export = { .format = BATCH_FORMAT_JSONL };
+
+void Batch_setExportFormat(BatchFormat format) {
+   Batch_export.format = format;
+}
+
+/* Writes the rows to a new file, returns 0 or an errno */
+static int Batch_writeExport(const char* path, BatchBuffer* data) {
+   int fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC | O_NOCTTY, 0644);
+   if (fd < 0)
+      return errno;
+
+   int error = Batch_flush(data, fd) ? 0 : errno;
+   if (close(fd) < 0 && !error)
+      error = errno;
+   if (error)
+      unlink(path);
+   return error;
+}
+
+/* With the export locked, where there is a writer thread */
+static void Batch_finishExport(BatchExport* this, int error) {
+   free(this->data.data);
+   this->data = (BatchBuffer) { 0 };
+   this->error = error;
+   this->state = error ? BATCH_EXPORT_FAILED : BATCH_EXPORT_WRITTEN;
+   Platform_gettime_monotonic(&this->doneMs);
+}
+
+#ifdef HAVE_PTHREAD
+
+static pthread_mutex_t Batch_exportLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Batch_exportCond = PTHREAD_COND_INITIALIZER;
+
+/* The single writer: formatting is done by the time it gets the rows, only the disk is waited for */
+static void* Batch_exportWriter(ATTR_UNUSED void* arg) {
+   BatchExport* this = &Batch_export;
+
+   pthread_mutex_lock(&Batch_exportLock);
+   for (;;) {
+      while (this->state != BATCH_EXPORT_WRITING)
+         pthread_cond_wait(&Batch_exportCond, &Batch_exportLock);
+
+      pthread_mutex_unlock(&Batch_exportLock);
+      int error = Batch_writeExport(this->path, &this->data);
+      pthread_mutex_lock(&Batch_exportLock);
+
+      Batch_finishExport(this, error);
+      pthread_cond_broadcast(&Batch_exportCond);
+   }
+
+   return NULL;
+}
+
+static bool Batch_startExportWriter(void) {
+   static bool started = false;
+   static bool failed = false;
+
+   if (started || failed)
+      return started;
+
+   /* signals are to be handled by the main thread only */
+   sigset_t all, old;
+   sigfillset(&all);
+   pthread_sigmask(SIG_BLOCK, &all, &old);
+
+   pthread_t thread;
+   int err = pthread_create(&thread, NULL, Batch_exportWriter, NULL);
+
+   pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+   if (err != 0) {
+      failed = true;
+      return false;
+   }
+
+   pthread_detach(thread);
+   started = true;
+   return true;
+}
+
+static inline void Batch_lockExport(void) {
+   pthread_mutex_lock(&Batch_exportLock);
+}
+
+static inline void Batch_unlockExport(void) {
+   pthread_mutex_unlock(&Batch_exportLock);
+}
+
+#else /* HAVE_PTHREAD */
+
+static bool Batch_startExportWriter(void) {
+   return false;
+}
+
+static inline void Batch_lockExport(void) { }
+
+static inline void Batch_unlockExport(void) { }
+
+#endif /* HAVE_PTHREAD */
+
+bool Batch_requestExport(void) {
+   Batch_lockExport();
+   bool writing = Batch_export.state == BATCH_EXPORT_WRITING;
+   Batch_unlockExport();
+
+   if (writing)
+      return false;
+
+   Batch_export.requested = true;
+   return true;
+}
+
+void Batch_exportScan(Machine* host) {
+   BatchExport* this = &Batch_export;
+   if (!this->requested)
+      return;
+
+   this->requested = false;
+
+   Batch batch = {
+      .format = this->format,
+   };
+
+   /* the numbers as --batch writes them, not shortened to the width of the columns */
+   const bool plainNumbers = Row_plainNumbers;
+   Row_plainNumbers = true;
+   Batch_writeHeader(&batch, host->settings);
+   int rows = Batch_writeUpdate(&batch, host);
+   Row_plainNumbers = plainNumbers;
+   free(batch.field.data);
+
+   char stamp[32];
+   struct tm tm;
+   const time_t seconds = host->realtime.tv_sec;
+   strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime_r(&seconds, &tm));
+
+   Batch_lockExport();
+   xSnprintf(this->path, sizeof(this->path), "htop-%s.%03u.%s", stamp, (unsigned int)(host->realtimeMs % 1000),
+             this->format == BATCH_FORMAT_CSV ? "csv" : "jsonl");
+   this->data = batch.out;
+   this->rows = rows;
+   this->state = BATCH_EXPORT_WRITING;
+
+   if (Batch_startExportWriter()) {
+#ifdef HAVE_PTHREAD
+      pthread_cond_broadcast(&Batch_exportCond);
+#endif
+      Batch_unlockExport();
+      return;
+   }
+   Batch_unlockExport();
+
+   /* no thread to hand the rows to */
+   int error = Batch_writeExport(this->path, &this->data);
+   Batch_finishExport(this, error);
+}
+
+/* The state the function bar tells, idle once the last export is old; with the export locked */
+static BatchExportState Batch_shownExport(const BatchExport* this) {
+   if (this->requested)
+      return BATCH_EXPORT_WRITING;
+   if (this->state == BATCH_EXPORT_WRITTEN || this->state == BATCH_EXPORT_FAILED) {
+      uint64_t now;
+      Platform_gettime_monotonic(&now);
+      if (now - this->doneMs > BATCH_EXPORT_SHOWN_MS)
+         return BATCH_EXPORT_IDLE;
+   }
+   return this->state;
+}
+
+bool Batch_describeExport(char* buffer, size_t size) {
+   const BatchExport* this = &Batch_export;
+
+   Batch_lockExport();
+   BatchExportState shown = Batch_shownExport(this);
+   switch (shown) {
+      case BATCH_EXPORT_IDLE:
+         break;
+      case BATCH_EXPORT_WRITING:
+         xSnprintf(buffer, size, "EXPORTING");
+         break;
+      case BATCH_EXPORT_WRITTEN:
+         xSnprintf(buffer, size, "EXPORTED %d ROWS TO %s", this->rows, this->path);
+         break;
+      case BATCH_EXPORT_FAILED:
+         xSnprintf(buffer, size, "EXPORT TO %s FAILED: %s", this->path, strerror(this->error));
+         break;
+   }
+   Batch_unlockExport();
+
+   return shown != BATCH_EXPORT_IDLE;
+}
+
+bool Batch_exportChanged(void) {
+   static BatchExportState last = BATCH_EXPORT_IDLE;
+
+   Batch_lockExport();
+   BatchExportState shown = Batch_shownExport(&Batch_export);
+   Batch_unlockExport();
+
+   bool changed = shown != last;
+   last = shown;
+   return changed;
+}
+
+void Batch_exportDone(void) {
+#ifdef HAVE_PTHREAD
+   pthread_mutex_lock(&Batch_exportLock);
+   while (Batch_export.state == BATCH_EXPORT_WRITING)
+      pthread_cond_wait(&Batch_exportCond, &Batch_exportLock);
+   pthread_mutex_unlock(&Batch_exportLock);
+#endif
+}
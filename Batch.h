@@ -0,0 +1,57 @@
+#ifndef HEADER_Batch
+#define HEADER_Batch
+/*
+htop - Batch.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "Machine.h"
+
+
+typedef enum BatchFormat_ {
+   BATCH_FORMAT_NONE,
+   BATCH_FORMAT_JSONL,
+   BATCH_FORMAT_CSV,
+} BatchFormat;
+
+/* The format named by the argument of --format, BATCH_FORMAT_NONE if there is none of that name */
+BatchFormat Batch_parseFormat(const char* name);
+
+/*
+ * Scans at the configured delay and writes the rows of the active screen,
+ * with its columns and in its order, to stdout until the iterations are
+ * done. Only the first `maxRows` rows of each update are written, unless
+ * it is 0. False if stdout can not be written to.
+ */
+bool Batch_run(Machine* host, BatchFormat format, int maxRows);
+
+/* Format of the exports of the interactive mode, JSONL unless set */
+void Batch_setExportFormat(BatchFormat format);
+
+/* Asks for the rows to be exported after the next scan, false while the last export is still being written */
+bool Batch_requestExport(void);
+
+/*
+ * Right after a scan, if an export was asked for: formats all the rows of
+ * the active screen as --batch writes them, stamped with the time of the
+ * scan, and hands them to a writer thread. It writes them to a new file
+ * htop-<time>.jsonl (or .csv) in the working directory; without threads
+ * they are written at once.
+ */
+void Batch_exportScan(Machine* host);
+
+/* Text for the function bar about the last export, false if there is nothing to tell */
+bool Batch_describeExport(char* buffer, size_t size);
+
+/* True once after each change of what Batch_describeExport() tells, for the function bar to be drawn again */
+bool Batch_exportChanged(void);
+
+/* Waits for the export being written, if any, so that it is complete on exit */
+void Batch_exportDone(void);
+
+#endif
@@ -67,5 +67,6 @@ const MeterClass BatteryMeter_class = {
    .attributes = BatteryMeter_attributes,
    .name = "Battery",
    .uiName = "Battery",
-   .caption = "Battery: "
+   .caption = "Battery: ",
+   .slowInterval = 10000
 };
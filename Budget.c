@@ -0,0 +1,121 @@
+/*
+htop - Budget.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "Budget.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include "BatteryMeter.h"
+#include "Platform.h"
+
+
+/* Updates in a row well below the budget before a level is given back */
+#define BUDGET_CALM_UPDATES 3
+
+/* Between reads of the power supply while the setting is on */
+#define BUDGET_BATTERY_CHECK_MS 10000
+
+/* Timer slack on battery, the kernel may delay the wakeups of htop by that much to batch them with others */
+#define BUDGET_BATTERY_TIMERSLACK_NS 50000000UL
+
+unsigned int Budget_level;
+
+bool Budget_onBattery;
+
+double Budget_usage = NAN;
+
+static uint64_t Budget_lastMs;
+static uint64_t Budget_lastCpuUs;
+static unsigned int Budget_calmUpdates;
+static uint64_t Budget_batteryCheckMs;
+
+static uint64_t Budget_timevalUs(const struct timeval* tv) {
+   return (uint64_t)tv->tv_sec * 1000000 + (uint64_t)tv->tv_usec;
+}
+
+static void Budget_setOnBattery(bool onBattery) {
+   if (onBattery == Budget_onBattery)
+      return;
+
+   Budget_onBattery = onBattery;
+#ifdef __linux__
+   /* 0 gives back the default slack */
+   prctl(PR_SET_TIMERSLACK, onBattery ? BUDGET_BATTERY_TIMERSLACK_NS : 0UL, 0UL, 0UL, 0UL);
+#endif
+}
+
+static void Budget_updateBattery(const Settings* settings, uint64_t nowMs) {
+   if (!settings->batterySaver) {
+      Budget_setOnBattery(false);
+      Budget_batteryCheckMs = 0;
+      return;
+   }
+
+   if (Budget_batteryCheckMs && nowMs - Budget_batteryCheckMs < BUDGET_BATTERY_CHECK_MS)
+      return;
+
+   Budget_batteryCheckMs = nowMs;
+
+   double percent;
+   ACPresence isOnAC;
+   Platform_getBattery(&percent, &isOnAC);
+   Budget_setOnBattery(isOnAC == AC_ABSENT);
+}
+
+void Budget_update(const Settings* settings) {
+   struct rusage usage;
+   if (getrusage(RUSAGE_SELF, &usage) != 0)
+      return;
+
+   const uint64_t cpuUs = Budget_timevalUs(&usage.ru_utime) + Budget_timevalUs(&usage.ru_stime);
+
+   uint64_t nowMs;
+   Platform_gettime_monotonic(&nowMs);
+
+   if (Budget_lastMs && nowMs > Budget_lastMs && cpuUs >= Budget_lastCpuUs)
+      Budget_usage = (double)(cpuUs - Budget_lastCpuUs) / 10.0 / (double)(nowMs - Budget_lastMs);
+
+   Budget_lastMs = nowMs;
+   Budget_lastCpuUs = cpuUs;
+
+   Budget_updateBattery(settings, nowMs);
+
+   if (!settings->cpuBudget || isNaN(Budget_usage)) {
+      Budget_level = 0;
+      Budget_calmUpdates = 0;
+      return;
+   }
+
+   /* in percent, the setting is in tenths of a percent */
+   const double budget = settings->cpuBudget / 10.0;
+
+   if (Budget_usage > budget) {
+      if (Budget_level < BUDGET_MAX_LEVEL)
+         Budget_level++;
+      Budget_calmUpdates = 0;
+      return;
+   }
+
+   /* half the interval roughly doubles the usage, leave some room before going back */
+   if (Budget_level > 0 && Budget_usage * 2 < budget * 0.75) {
+      if (++Budget_calmUpdates >= BUDGET_CALM_UPDATES) {
+         Budget_level--;
+         Budget_calmUpdates = 0;
+      }
+   } else {
+      Budget_calmUpdates = 0;
+   }
+}
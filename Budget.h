@@ -0,0 +1,57 @@
+#ifndef HEADER_Budget
+#define HEADER_Budget
+/*
+htop - Budget.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+
+#include "Macros.h"
+#include "Settings.h"
+
+
+/*
+ * Keeps htop within the CPU budget set in the settings. While over it,
+ * each level doubles the update interval, and from BUDGET_THRIFTY_LEVEL
+ * on optional collectors are skipped; levels are given back once the
+ * usage stays well below the budget.
+ *
+ * With the setting to save power on battery, the same happens while the
+ * machine runs on battery: the interval is at least BUDGET_BATTERY_DELAY,
+ * optional and expensive collectors are skipped and wakeups are batched.
+ */
+
+#define BUDGET_MAX_LEVEL 3
+
+#define BUDGET_THRIFTY_LEVEL 2
+
+/* Shortest update interval on battery, in tenths of a second */
+#define BUDGET_BATTERY_DELAY 50
+
+/* 0 - within the budget, or none set */
+extern unsigned int Budget_level;
+
+/* Saving power: the setting is on and the machine runs on battery */
+extern bool Budget_onBattery;
+
+/* Percent of one CPU used by all threads of htop between the last two updates, NAN if unknown */
+extern double Budget_usage;
+
+/* Measures the usage since the previous call and adjusts the level, once per update; checks the power supply now and then */
+void Budget_update(const Settings* settings);
+
+/* Update interval in tenths of a second */
+static inline int Budget_delay(const Settings* settings) {
+   const int delay = settings->delay << Budget_level;
+   return Budget_onBattery ? MAXIMUM(delay, BUDGET_BATTERY_DELAY) : delay;
+}
+
+/* Whether optional collectors, like CPU frequency and temperature, are to be skipped */
+static inline bool Budget_isThrifty(void) {
+   return Budget_level >= BUDGET_THRIFTY_LEVEL || Budget_onBattery;
+}
+
+#endif
@@ -60,19 +60,10 @@ static void CPUMeter_getUiName(const Meter* this, char* buffer, size_t length) {
       xSnprintf(buffer, length, "%s", Meter_uiName(this));
 }
 
-static void CPUMeter_updateValues(Meter* this) {
-   memset(this->values, 0, sizeof(double) * CPU_METER_ITEMCOUNT);
-
-   const Machine* host = this->host;
-   const Settings* settings = host->settings;
+/* Fills the text of a CPU meter whose values are set from the usage in percent */
+static void CPUMeter_formatText(Meter* this, double percent) {
+   const Settings* settings = this->host->settings;
 
-   unsigned int cpu = this->param;
-   if (cpu > host->existingCPUs) {
-      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "absent");
-      return;
-   }
-
-   double percent = Platform_setCPUValues(this, cpu);
    if (!isNonnegative(percent)) {
       xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "offline");
       return;
@@ -115,6 +106,21 @@ static void CPUMeter_updateValues(Meter* this) {
              cpuTemperatureBuffer);
 }
 
+static void CPUMeter_updateValues(Meter* this) {
+   memset(this->values, 0, sizeof(double) * CPU_METER_ITEMCOUNT);
+
+   const Machine* host = this->host;
+
+   unsigned int cpu = this->param;
+   if (cpu > host->existingCPUs) {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "absent");
+      return;
+   }
+
+   double percent = Platform_setCPUValues(this, cpu);
+   CPUMeter_formatText(this, percent);
+}
+
 static void CPUMeter_display(const Object* cast, RichString* out) {
    char buffer[50];
    int len;
@@ -314,11 +320,7 @@ static void OctoColCPUsMeter_updateMode(Meter* this, int mode) {
    CPUMeterCommonUpdateMode(this, mode, 8);
 }
 
-static void CPUMeterCommonDraw(Meter* this, int x, int y, int w, int ncol) {
-   CPUMeterData* data = this->meterData;
-   Meter** meters = data->meters;
-   int start, count;
-   AllCPUsMeter_getRange(this, &start, &count);
+static void CPUMeterDrawColumns(Meter** meters, int count, int x, int y, int w, int ncol) {
    int colwidth = (w - ncol) / ncol + 1;
    int diff = (w - (colwidth * ncol));
    int nrows = (count + ncol - 1) / ncol;
@@ -330,6 +332,13 @@ static void CPUMeterCommonDraw(Meter* this, int x, int y, int w, int ncol) {
    }
 }
 
+static void CPUMeterCommonDraw(Meter* this, int x, int y, int w, int ncol) {
+   CPUMeterData* data = this->meterData;
+   int start, count;
+   AllCPUsMeter_getRange(this, &start, &count);
+   CPUMeterDrawColumns(data->meters, count, x, y, w, ncol);
+}
+
 static void DualColCPUsMeter_draw(Meter* this, int x, int y, int w) {
    CPUMeterCommonDraw(this, x, y, w, 2);
 }
@@ -355,6 +364,344 @@ static void SingleColCPUsMeter_draw(Meter* this, int x, int y, int w) {
 }
 
 
+#ifdef HAVE_LIBHWLOC
+
+/* CPUs grouped by the topology: the use of each group, or of the CPUs in the busiest one */
+
+typedef enum {
+   CPU_GROUP_NODE,
+   CPU_GROUP_SOCKET,
+   CPU_GROUP_CACHE,
+   CPU_GROUP_CORE,
+} CPUGroupLevel;
+
+#define CPU_GROUP_NONE UINT_MAX
+
+typedef struct CPUGroupMeterData_ {
+   unsigned int cpus;
+   unsigned int* cpuGroup;     /* group of each CPU, CPU_GROUP_NONE if not in the topology */
+   unsigned int groups;
+   unsigned int* groupStart;   /* groupCPUs offset of each group, and of the end */
+   unsigned int* groupCPUs;    /* CPU ids by group */
+   unsigned int maxGroupSize;
+   unsigned int busiest;
+   double* sums;               /* CPU_METER_ITEMCOUNT values per group */
+   Meter* scratch;             /* takes the values of one CPU after the other */
+   unsigned int* online;       /* per group, during an update */
+   double* usage;
+   uint8_t* items;
+   Meter** meters;             /* one per group, or one per CPU of the busiest group */
+   unsigned int count;
+   unsigned int shown;
+   bool drillDown;
+} CPUGroupMeterData;
+
+static const char CPUGroupMeter_captionPrefix[] = { 'N', 'S', 'L', 'C' };
+
+static CPUGroupLevel CPUGroupMeter_level(const Meter* this, bool* drillDown) {
+   const MeterClass* type = As_Meter(this);
+   *drillDown = type == &BusiestCPUNodeMeter_class || type == &BusiestCPUSocketMeter_class ||
+                type == &BusiestCPUCacheMeter_class || type == &BusiestCPUCoreMeter_class;
+
+   if (type == &CPUNodesMeter_class || type == &BusiestCPUNodeMeter_class)
+      return CPU_GROUP_NODE;
+   if (type == &CPUSocketsMeter_class || type == &BusiestCPUSocketMeter_class)
+      return CPU_GROUP_SOCKET;
+   if (type == &CPUCachesMeter_class || type == &BusiestCPUCacheMeter_class)
+      return CPU_GROUP_CACHE;
+   return CPU_GROUP_CORE;
+}
+
+static bool CPUGroupMeter_isLevel(hwloc_obj_t obj, CPUGroupLevel level) {
+   switch (level) {
+      case CPU_GROUP_SOCKET:
+         return obj->type == HWLOC_OBJ_PACKAGE;
+      case CPU_GROUP_CACHE:
+#if HWLOC_API_VERSION < 0x00020000
+         return obj->type == HWLOC_OBJ_CACHE && obj->attr->cache.depth == 3;
+#else
+         return obj->type == HWLOC_OBJ_L3CACHE;
+#endif
+      case CPU_GROUP_CORE:
+         return obj->type == HWLOC_OBJ_CORE;
+      default:
+         return false;
+   }
+}
+
+/*
+ * The object of the level a PU belongs to. Machine keeps only the objects
+ * that add structure: a missing core has a single PU, a missing L3 cache
+ * or package spans all CPUs of the next package or of the machine.
+ */
+static hwloc_obj_t CPUGroupMeter_groupOf(hwloc_topology_t topology, hwloc_obj_t pu, CPUGroupLevel level) {
+   for (hwloc_obj_t obj = pu->parent; obj; obj = obj->parent)
+      if (CPUGroupMeter_isLevel(obj, level))
+         return obj;
+
+   if (level == CPU_GROUP_CORE)
+      return pu;
+
+   for (hwloc_obj_t obj = pu->parent; obj && level == CPU_GROUP_CACHE; obj = obj->parent)
+      if (CPUGroupMeter_isLevel(obj, CPU_GROUP_SOCKET))
+         return obj;
+
+   return hwloc_get_root_obj(topology);
+}
+
+static unsigned int CPUGroupMeter_addGroup(hwloc_obj_t* objects, unsigned int* groups, hwloc_obj_t obj) {
+   for (unsigned int i = 0; i < *groups; i++)
+      if (objects[i] == obj)
+         return i;
+
+   objects[*groups] = obj;
+   return (*groups)++;
+}
+
+static void CPUGroupMeter_buildGroups(CPUGroupMeterData* data, const Machine* host, CPUGroupLevel level) {
+   unsigned int cpus = data->cpus;
+   data->cpuGroup = xMallocArray(cpus, sizeof(*data->cpuGroup));
+   for (unsigned int i = 0; i < cpus; i++)
+      data->cpuGroup[i] = CPU_GROUP_NONE;
+   data->groups = 0;
+
+   if (Machine_loadTopology(host)) {
+      hwloc_topology_t topology = host->topology;
+      hwloc_obj_t* objects = xCalloc(cpus, sizeof(hwloc_obj_t));
+
+      if (level == CPU_GROUP_NODE) {
+         /* NUMA nodes are not among the ancestors of PUs with hwloc 2 */
+         int nodes = hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_NUMANODE);
+         for (int i = 0; i < nodes; i++) {
+            hwloc_obj_t node = hwloc_get_obj_by_type(topology, HWLOC_OBJ_NUMANODE, i);
+            if (!node || !node->cpuset)
+               continue;
+
+            int id;
+            hwloc_bitmap_foreach_begin(id, node->cpuset)
+               if ((unsigned int)id < cpus && data->cpuGroup[id] == CPU_GROUP_NONE)
+                  data->cpuGroup[id] = CPUGroupMeter_addGroup(objects, &data->groups, node);
+            hwloc_bitmap_foreach_end();
+         }
+      } else {
+         int pus = hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_PU);
+         for (int i = 0; i < pus; i++) {
+            hwloc_obj_t pu = hwloc_get_obj_by_type(topology, HWLOC_OBJ_PU, i);
+            if (!pu || pu->os_index >= cpus)
+               continue;
+
+            hwloc_obj_t group = CPUGroupMeter_groupOf(topology, pu, level);
+            data->cpuGroup[pu->os_index] = CPUGroupMeter_addGroup(objects, &data->groups, group);
+         }
+      }
+
+      free(objects);
+   }
+
+   /* without a topology, all CPUs make one group */
+   if (data->groups == 0) {
+      for (unsigned int i = 0; i < cpus; i++)
+         data->cpuGroup[i] = 0;
+      data->groups = 1;
+   }
+
+   data->groupStart = xCalloc(data->groups + 1, sizeof(*data->groupStart));
+   for (unsigned int i = 0; i < cpus; i++)
+      if (data->cpuGroup[i] != CPU_GROUP_NONE)
+         data->groupStart[data->cpuGroup[i] + 1]++;
+
+   data->maxGroupSize = 0;
+   for (unsigned int g = 0; g < data->groups; g++) {
+      data->maxGroupSize = MAXIMUM(data->maxGroupSize, data->groupStart[g + 1]);
+      data->groupStart[g + 1] += data->groupStart[g];
+   }
+
+   data->groupCPUs = xMallocArray(MAXIMUM(data->groupStart[data->groups], 1), sizeof(*data->groupCPUs));
+   unsigned int* fill = xMallocArray(data->groups, sizeof(*fill));
+   memcpy(fill, data->groupStart, data->groups * sizeof(*fill));
+   for (unsigned int i = 0; i < cpus; i++)
+      if (data->cpuGroup[i] != CPU_GROUP_NONE)
+         data->groupCPUs[fill[data->cpuGroup[i]]++] = i;
+   free(fill);
+}
+
+static void CPUGroupMeter_noUpdate(ATTR_UNUSED Meter* this) {
+   /* the values are set by the meter of all groups */
+}
+
+static const MeterClass CPUGroupMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = CPUMeter_display
+   },
+   .updateValues = CPUGroupMeter_noUpdate,
+   .defaultMode = BAR_METERMODE,
+   .maxItems = CPU_METER_ITEMCOUNT,
+   .total = 100.0,
+   .attributes = CPUMeter_attributes,
+   .name = "CPUGroup",
+   .uiName = "CPU group",
+   .caption = "CPU"
+};
+
+/* Columns to lay out count bars in, so that large topologies take a few rows */
+static int CPUGroupMeter_columns(unsigned int count) {
+   return count <= 8 ? 1 : count <= 32 ? 2 : count <= 64 ? 4 : 8;
+}
+
+static void CPUGroupMeter_init(Meter* this) {
+   CPUGroupMeterData* data = this->meterData;
+   if (!data) {
+      bool drillDown;
+      CPUGroupLevel level = CPUGroupMeter_level(this, &drillDown);
+
+      data = this->meterData = xCalloc(1, sizeof(CPUGroupMeterData));
+      data->cpus = this->host->existingCPUs;
+      data->drillDown = drillDown;
+      CPUGroupMeter_buildGroups(data, this->host, level);
+      data->sums = xCalloc((size_t)data->groups * CPU_METER_ITEMCOUNT, sizeof(double));
+      data->online = xCalloc(data->groups, sizeof(*data->online));
+      data->usage = xCalloc(data->groups, sizeof(*data->usage));
+      data->items = xCalloc(data->groups, sizeof(*data->items));
+      data->scratch = Meter_new(this->host, 0, (const MeterClass*) Class(CPUMeter));
+
+      data->count = drillDown ? data->maxGroupSize : data->groups;
+      data->shown = data->count;
+      data->meters = xCalloc(data->count, sizeof(Meter*));
+      for (unsigned int i = 0; i < data->count; i++) {
+         if (drillDown) {
+            data->meters[i] = Meter_new(this->host, data->groupCPUs[i] + 1, (const MeterClass*) Class(CPUMeter));
+         } else {
+            data->meters[i] = Meter_new(this->host, i + 1, &CPUGroupMeter_class);
+
+            char caption[10];
+            xSnprintf(caption, sizeof(caption), "%c%-2u", CPUGroupMeter_captionPrefix[level], i);
+            Meter_setCaption(data->meters[i], caption);
+         }
+      }
+   }
+
+   if (this->mode == 0)
+      this->mode = BAR_METERMODE;
+
+   int ncol = CPUGroupMeter_columns(data->count);
+   this->h = Meter_modes[this->mode]->h * (((int)data->count + ncol - 1) / ncol);
+}
+
+static void CPUGroupMeter_updateMode(Meter* this, int mode) {
+   CPUGroupMeterData* data = this->meterData;
+   this->mode = mode;
+   for (unsigned int i = 0; i < data->count; i++)
+      Meter_setMode(data->meters[i], mode);
+
+   int ncol = CPUGroupMeter_columns(data->count);
+   this->h = Meter_modes[mode]->h * (((int)data->count + ncol - 1) / ncol);
+}
+
+/* Averages the values of the online CPUs of each group, in one pass over all CPUs */
+static void CPUGroupMeter_updateValues(Meter* this) {
+   CPUGroupMeterData* data = this->meterData;
+   Meter* scratch = data->scratch;
+   double* sums = data->sums;
+   unsigned int groups = data->groups;
+
+   unsigned int* online = data->online;
+   double* usage = data->usage;
+   uint8_t* items = data->items;
+   memset(online, 0, groups * sizeof(*online));
+   memset(usage, 0, groups * sizeof(*usage));
+   memset(items, 0, groups * sizeof(*items));
+   for (size_t i = 0; i < (size_t)groups * CPU_METER_ITEMCOUNT; i++)
+      sums[i] = NAN;
+
+   unsigned int cpus = MINIMUM(data->cpus, this->host->existingCPUs);
+   for (unsigned int cpu = 0; cpu < cpus; cpu++) {
+      unsigned int g = data->cpuGroup[cpu];
+      if (g == CPU_GROUP_NONE)
+         continue;
+
+      double percent = Platform_setCPUValues(scratch, cpu + 1);
+      if (!isNonnegative(percent))
+         continue;
+
+      online[g]++;
+      usage[g] += percent;
+      items[g] = MAXIMUM(items[g], scratch->curItems);
+
+      double* sum = &sums[(size_t)g * CPU_METER_ITEMCOUNT];
+      for (int i = 0; i < CPU_METER_ITEMCOUNT; i++) {
+         double value = scratch->values[i];
+         if (isNaN(value))
+            continue;
+
+         if (i == CPU_METER_TEMPERATURE)
+            sum[i] = isNaN(sum[i]) ? value : MAXIMUM(sum[i], value);
+         else
+            sum[i] = isNaN(sum[i]) ? value : sum[i] + value;
+      }
+   }
+
+   data->busiest = 0;
+   for (unsigned int g = 0; g < groups; g++) {
+      if (online[g] == 0)
+         continue;
+
+      usage[g] /= online[g];
+      if (online[data->busiest] == 0 || usage[g] > usage[data->busiest])
+         data->busiest = g;
+   }
+
+   if (data->drillDown) {
+      unsigned int first = data->groupStart[data->busiest];
+      data->shown = data->groupStart[data->busiest + 1] - first;
+      for (unsigned int i = 0; i < data->shown; i++) {
+         Meter* meter = data->meters[i];
+         unsigned int param = data->groupCPUs[first + i] + 1;
+         if (meter->param != param) {
+            meter->param = param;
+            Meter_init(meter);
+         }
+         Meter_updateValues(meter);
+      }
+   } else {
+      for (unsigned int g = 0; g < groups; g++) {
+         Meter* meter = data->meters[g];
+         const double* sum = &sums[(size_t)g * CPU_METER_ITEMCOUNT];
+
+         meter->curItems = online[g] ? items[g] : 0;
+         for (int i = 0; i < CPU_METER_ITEMCOUNT; i++)
+            meter->values[i] = (i == CPU_METER_TEMPERATURE || !online[g]) ? sum[i] : sum[i] / online[g];
+
+         CPUMeter_formatText(meter, online[g] ? usage[g] : NAN);
+      }
+   }
+}
+
+static void CPUGroupMeter_draw(Meter* this, int x, int y, int w) {
+   const CPUGroupMeterData* data = this->meterData;
+   CPUMeterDrawColumns(data->meters, (int)data->shown, x, y, w, CPUGroupMeter_columns(data->count));
+}
+
+static void CPUGroupMeter_done(Meter* this) {
+   CPUGroupMeterData* data = this->meterData;
+   for (unsigned int i = 0; i < data->count; i++)
+      Meter_delete((Object*)data->meters[i]);
+   free(data->meters);
+   Meter_delete((Object*)data->scratch);
+   free(data->items);
+   free(data->usage);
+   free(data->online);
+   free(data->sums);
+   free(data->groupCPUs);
+   free(data->groupStart);
+   free(data->cpuGroup);
+   free(data);
+}
+
+#endif /* HAVE_LIBHWLOC */
+
+
 const MeterClass CPUMeter_class = {
    .super = {
       .extends = Class(Meter),
@@ -623,3 +970,175 @@ const MeterClass RightCPUs8Meter_class = {
    .updateMode = OctoColCPUsMeter_updateMode,
    .done = AllCPUsMeter_done
 };
+
+#ifdef HAVE_LIBHWLOC
+
+const MeterClass CPUNodesMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = CPUMeter_display
+   },
+   .updateValues = CPUGroupMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .isMultiColumn = true,
+   .total = 100.0,
+   .attributes = CPUMeter_attributes,
+   .name = "CPUNodes",
+   .uiName = "CPU NUMA nodes",
+   .description = "CPU NUMA nodes: average use of the CPUs of each NUMA node",
+   .caption = "CPU",
+   .draw = CPUGroupMeter_draw,
+   .init = CPUGroupMeter_init,
+   .updateMode = CPUGroupMeter_updateMode,
+   .done = CPUGroupMeter_done
+};
+
+const MeterClass CPUSocketsMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = CPUMeter_display
+   },
+   .updateValues = CPUGroupMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .isMultiColumn = true,
+   .total = 100.0,
+   .attributes = CPUMeter_attributes,
+   .name = "CPUSockets",
+   .uiName = "CPU sockets",
+   .description = "CPU sockets: average use of the CPUs of each socket",
+   .caption = "CPU",
+   .draw = CPUGroupMeter_draw,
+   .init = CPUGroupMeter_init,
+   .updateMode = CPUGroupMeter_updateMode,
+   .done = CPUGroupMeter_done
+};
+
+const MeterClass CPUCachesMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = CPUMeter_display
+   },
+   .updateValues = CPUGroupMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .isMultiColumn = true,
+   .total = 100.0,
+   .attributes = CPUMeter_attributes,
+   .name = "CPUCaches",
+   .uiName = "CPU L3 groups",
+   .description = "CPU L3 groups: average use of the CPUs sharing each L3 cache (CCX)",
+   .caption = "CPU",
+   .draw = CPUGroupMeter_draw,
+   .init = CPUGroupMeter_init,
+   .updateMode = CPUGroupMeter_updateMode,
+   .done = CPUGroupMeter_done
+};
+
+const MeterClass CPUCoresMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = CPUMeter_display
+   },
+   .updateValues = CPUGroupMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .isMultiColumn = true,
+   .total = 100.0,
+   .attributes = CPUMeter_attributes,
+   .name = "CPUCores",
+   .uiName = "CPU cores",
+   .description = "CPU cores: average use of the hardware threads of each core",
+   .caption = "CPU",
+   .draw = CPUGroupMeter_draw,
+   .init = CPUGroupMeter_init,
+   .updateMode = CPUGroupMeter_updateMode,
+   .done = CPUGroupMeter_done
+};
+
+const MeterClass BusiestCPUNodeMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = CPUMeter_display
+   },
+   .updateValues = CPUGroupMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .isMultiColumn = true,
+   .total = 100.0,
+   .attributes = CPUMeter_attributes,
+   .name = "BusiestCPUNode",
+   .uiName = "CPUs of busiest node",
+   .description = "CPUs of busiest node: each CPU of the NUMA node with the highest use",
+   .caption = "CPU",
+   .draw = CPUGroupMeter_draw,
+   .init = CPUGroupMeter_init,
+   .updateMode = CPUGroupMeter_updateMode,
+   .done = CPUGroupMeter_done
+};
+
+const MeterClass BusiestCPUSocketMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = CPUMeter_display
+   },
+   .updateValues = CPUGroupMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .isMultiColumn = true,
+   .total = 100.0,
+   .attributes = CPUMeter_attributes,
+   .name = "BusiestCPUSocket",
+   .uiName = "CPUs of busiest socket",
+   .description = "CPUs of busiest socket: each CPU of the socket with the highest use",
+   .caption = "CPU",
+   .draw = CPUGroupMeter_draw,
+   .init = CPUGroupMeter_init,
+   .updateMode = CPUGroupMeter_updateMode,
+   .done = CPUGroupMeter_done
+};
+
+const MeterClass BusiestCPUCacheMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = CPUMeter_display
+   },
+   .updateValues = CPUGroupMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .isMultiColumn = true,
+   .total = 100.0,
+   .attributes = CPUMeter_attributes,
+   .name = "BusiestCPUCache",
+   .uiName = "CPUs of busiest L3 group",
+   .description = "CPUs of busiest L3 group: each CPU of the L3 cache (CCX) with the highest use",
+   .caption = "CPU",
+   .draw = CPUGroupMeter_draw,
+   .init = CPUGroupMeter_init,
+   .updateMode = CPUGroupMeter_updateMode,
+   .done = CPUGroupMeter_done
+};
+
+const MeterClass BusiestCPUCoreMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = CPUMeter_display
+   },
+   .updateValues = CPUGroupMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .isMultiColumn = true,
+   .total = 100.0,
+   .attributes = CPUMeter_attributes,
+   .name = "BusiestCPUCore",
+   .uiName = "CPUs of busiest core",
+   .description = "CPUs of busiest core: each hardware thread of the core with the highest use",
+   .caption = "CPU",
+   .draw = CPUGroupMeter_draw,
+   .init = CPUGroupMeter_init,
+   .updateMode = CPUGroupMeter_updateMode,
+   .done = CPUGroupMeter_done
+};
+
+#endif /* HAVE_LIBHWLOC */
@@ -50,4 +50,24 @@ extern const MeterClass LeftCPUs8Meter_class;
 
 extern const MeterClass RightCPUs8Meter_class;
 
+#ifdef HAVE_LIBHWLOC
+
+extern const MeterClass CPUNodesMeter_class;
+
+extern const MeterClass CPUSocketsMeter_class;
+
+extern const MeterClass CPUCachesMeter_class;
+
+extern const MeterClass CPUCoresMeter_class;
+
+extern const MeterClass BusiestCPUNodeMeter_class;
+
+extern const MeterClass BusiestCPUSocketMeter_class;
+
+extern const MeterClass BusiestCPUCacheMeter_class;
+
+extern const MeterClass BusiestCPUCoreMeter_class;
+
+#endif
+
 #endif
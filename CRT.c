@@ -9,11 +9,15 @@ in the source distribution for its full text.
 
 #include "CRT.h"
 
+#include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <langinfo.h>
+#include <limits.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -95,6 +99,29 @@ const char* const* CRT_treeStr = CRT_treeStrAscii;
 static const Settings* CRT_crashSettings;
 static const int* CRT_delay;
 
+/* Whether CRT_getCh() waits for input at all, see CRT_disableDelay() */
+static bool CRT_waitForInput = true;
+
+/* Written to by CRT_wake(), so that waiting for input also ends on events of other threads and signals */
+static int CRT_wakePipe[2] = { -1, -1 };
+
+/* Descriptors of CRT_watchFds(), and room to poll them along with the terminal */
+static const int* CRT_watched;
+static size_t CRT_watchedCount;
+static const int* CRT_triggers;
+static size_t CRT_triggerCount;
+static unsigned int CRT_triggered;
+static struct pollfd* CRT_pollFds;
+static size_t CRT_pollFdsAlloc;
+
+static struct sigaction CRT_oldWinchHandler;
+
+static bool CRT_focusReporting = false;
+static const bool* CRT_lowBandwidth;
+
+/* The terminal announced synchronized updates (DEC private mode 2026) in its terminfo entry */
+static bool CRT_syncUpdates = false;
+
 const char* CRT_degreeSign;
 
 static const char* initDegreeSign(void) {
@@ -173,6 +200,7 @@ static int CRT_colorSchemes[LAST_COLORSCHEME][LAST_COLORELEMENT] = {
       [MEMORY_CACHE] = ColorPair(Yellow, Black),
       [MEMORY_SHARED] = ColorPair(Magenta, Black),
       [MEMORY_COMPRESSED] = A_BOLD | ColorPairGrayBlack,
+      [MEMORY_SLAB] = ColorPair(Red, Black),
       [HUGEPAGE_1] = ColorPair(Green, Black),
       [HUGEPAGE_2] = ColorPair(Yellow, Black),
       [HUGEPAGE_3] = ColorPair(Red, Black),
@@ -286,6 +314,7 @@ static int CRT_colorSchemes[LAST_COLORSCHEME][LAST_COLORELEMENT] = {
       [MEMORY_CACHE] = A_NORMAL,
       [MEMORY_SHARED] = A_NORMAL,
       [MEMORY_COMPRESSED] = A_DIM,
+      [MEMORY_SLAB] = A_NORMAL,
       [HUGEPAGE_1] = A_BOLD,
       [HUGEPAGE_2] = A_NORMAL,
       [HUGEPAGE_3] = A_REVERSE | A_BOLD,
@@ -399,6 +428,7 @@ static int CRT_colorSchemes[LAST_COLORSCHEME][LAST_COLORELEMENT] = {
       [MEMORY_CACHE] = ColorPair(Yellow, White),
       [MEMORY_SHARED] = ColorPair(Magenta, White),
       [MEMORY_COMPRESSED] = A_BOLD | ColorPair(Black, White),
+      [MEMORY_SLAB] = ColorPair(Red, White),
       [HUGEPAGE_1] = ColorPair(Green, White),
       [HUGEPAGE_2] = ColorPair(Yellow, White),
       [HUGEPAGE_3] = ColorPair(Red, White),
@@ -512,6 +542,7 @@ static int CRT_colorSchemes[LAST_COLORSCHEME][LAST_COLORELEMENT] = {
       [MEMORY_CACHE] = ColorPair(Yellow, Black),
       [MEMORY_SHARED] = ColorPair(Magenta, Black),
       [MEMORY_COMPRESSED] = ColorPairGrayBlack,
+      [MEMORY_SLAB] = ColorPair(Red, Black),
       [HUGEPAGE_1] = ColorPair(Green, Black),
       [HUGEPAGE_2] = ColorPair(Yellow, Black),
       [HUGEPAGE_3] = ColorPair(Red, Black),
@@ -625,6 +656,7 @@ static int CRT_colorSchemes[LAST_COLORSCHEME][LAST_COLORELEMENT] = {
       [MEMORY_CACHE] = A_BOLD | ColorPair(Yellow, Blue),
       [MEMORY_SHARED] = A_BOLD | ColorPair(Magenta, Blue),
       [MEMORY_COMPRESSED] = A_BOLD | ColorPair(Black, Blue),
+      [MEMORY_SLAB] = A_BOLD | ColorPair(Red, Blue),
       [HUGEPAGE_1] = A_BOLD | ColorPair(Green, Blue),
       [HUGEPAGE_2] = A_BOLD | ColorPair(Yellow, Blue),
       [HUGEPAGE_3] = A_BOLD | ColorPair(Red, Blue),
@@ -738,6 +770,7 @@ static int CRT_colorSchemes[LAST_COLORSCHEME][LAST_COLORELEMENT] = {
       [MEMORY_CACHE] = ColorPair(Yellow, Black),
       [MEMORY_SHARED] = ColorPair(Magenta, Black),
       [MEMORY_COMPRESSED] = ColorPair(Yellow, Black),
+      [MEMORY_SLAB] = ColorPair(Red, Black),
       [HUGEPAGE_1] = ColorPair(Green, Black),
       [HUGEPAGE_2] = ColorPair(Yellow, Black),
       [HUGEPAGE_3] = ColorPair(Red, Black),
@@ -926,6 +959,54 @@ static void CRT_installSignalHandlers(void) {
    signal(SIGQUIT, CRT_handleSIGTERM);
 }
 
+void CRT_wake(void) {
+   if (CRT_wakePipe[1] < 0)
+      return;
+
+   /* a full pipe already wakes the next wait */
+   int saved = errno;
+   ssize_t r = write(CRT_wakePipe[1], "", 1);
+   (void) r;
+   errno = saved;
+}
+
+/* Chains to the handler of curses, which notes the new size for getch() to report KEY_RESIZE */
+static void CRT_handleSIGWINCH(int sgn) {
+   if (CRT_oldWinchHandler.sa_handler != SIG_DFL && CRT_oldWinchHandler.sa_handler != SIG_IGN)
+      CRT_oldWinchHandler.sa_handler(sgn);
+
+   CRT_wake();
+}
+
+static void CRT_initWake(void) {
+   if (pipe(CRT_wakePipe) != 0) {
+      CRT_wakePipe[0] = CRT_wakePipe[1] = -1;
+      return;
+   }
+
+   for (size_t i = 0; i < ARRAYSIZE(CRT_wakePipe); i++) {
+      fcntl(CRT_wakePipe[i], F_SETFL, fcntl(CRT_wakePipe[i], F_GETFL) | O_NONBLOCK);
+      fcntl(CRT_wakePipe[i], F_SETFD, FD_CLOEXEC);
+   }
+
+   struct sigaction act;
+   sigemptyset(&act.sa_mask);
+   act.sa_flags = 0;
+   act.sa_handler = CRT_handleSIGWINCH;
+   sigaction(SIGWINCH, &act, &CRT_oldWinchHandler);
+}
+
+static void CRT_doneWake(void) {
+   if (CRT_wakePipe[0] < 0)
+      return;
+
+   sigaction(SIGWINCH, &CRT_oldWinchHandler, NULL);
+
+   close(CRT_wakePipe[0]);
+   close(CRT_wakePipe[1]);
+   CRT_wakePipe[0] = CRT_wakePipe[1] = -1;
+}
+
 void CRT_resetSignalHandlers(void) {
    sigaction(SIGSEGV, &old_sig_handler[SIGSEGV], NULL);
    sigaction(SIGFPE, &old_sig_handler[SIGFPE], NULL);
@@ -940,6 +1021,29 @@ void CRT_resetSignalHandlers(void) {
    signal(SIGQUIT, SIG_DFL);
 }
 
+void CRT_setFocusReporting(bool enabled) {
+   if (enabled == CRT_focusReporting)
+      return;
+
+   if (enabled) {
+#ifdef HTOP_NETBSD
+#define define_key(s_, k_) define_key((char*)s_, k_)
+IGNORE_WCASTQUAL_BEGIN
+#endif
+      define_key("\033[I", KEY_FOCUS_IN);
+      define_key("\033[O", KEY_FOCUS_OUT);
+#ifdef HTOP_NETBSD
+IGNORE_WCASTQUAL_END
+#undef define_key
+#endif
+   }
+
+   /* terminals without it ignore the mode */
+   fputs(enabled ? "\033[?1004h" : "\033[?1004l", stdout);
+   fflush(stdout);
+   CRT_focusReporting = enabled;
+}
+
 #ifdef HAVE_GETMOUSE
 void CRT_setMouse(bool enabled) {
    if (enabled) {
@@ -971,6 +1075,7 @@ void CRT_init(const Settings* settings, bool allowUnicode, bool retainScreenOnEx
    noecho();
    CRT_crashSettings = settings;
    CRT_delay = &(settings->delay);
+   CRT_lowBandwidth = &(settings->lowBandwidth);
    CRT_colors = CRT_colorSchemes[settings->colorScheme];
    CRT_colorScheme = settings->colorScheme;
 
@@ -979,7 +1084,10 @@ void CRT_init(const Settings* settings, bool allowUnicode, bool retainScreenOnEx
       CRT_colorSchemes[COLORSCHEME_BROKENGRAY][i] = color == (A_BOLD | ColorPairGrayBlack) ? ColorPair(White, Black) : color;
    }
 
-   halfdelay(*CRT_delay);
+   /* input is waited for in CRT_getCh(), getch() only reads what is there */
+   cbreak();
+   nodelay(stdscr, TRUE);
+   CRT_initWake();
    nonl();
    intrflush(stdscr, false);
    keypad(stdscr, true);
@@ -1058,6 +1166,10 @@ IGNORE_WCASTQUAL_END
       CRT_treeStrAscii;
 
    CRT_setMouse(settings->enableMouse);
+   CRT_setFocusReporting(settings->unfocusedDelay > 0);
+
+   const char* sync = tigetstr("Sync");
+   CRT_syncUpdates = sync && sync != (const char*)-1;
 
    CRT_degreeSign = initDegreeSign();
 }
@@ -1077,6 +1189,9 @@ void CRT_done(void) {
    curs_set(1);
    endwin();
 
+   CRT_setFocusReporting(false);
+   CRT_doneWake();
+
    dumpStderr();
 }
 
@@ -1088,22 +1203,117 @@ void CRT_fatalError(const char* note) {
 }
 
 int CRT_readKey(void) {
-   nocbreak();
-   cbreak();
    nodelay(stdscr, FALSE);
    int ret = getch();
-   halfdelay(*CRT_delay);
+   nodelay(stdscr, TRUE);
    return ret;
 }
 
 void CRT_disableDelay(void) {
-   nocbreak();
-   cbreak();
-   nodelay(stdscr, TRUE);
+   CRT_waitForInput = false;
 }
 
 void CRT_enableDelay(void) {
-   halfdelay(*CRT_delay);
+   CRT_waitForInput = true;
+}
+
+int CRT_getCh(int timeoutMs) {
+   /* keys left over from an escape sequence are buffered by curses, not pending on the terminal */
+   int ch = getch();
+   if (ch != ERR || !CRT_waitForInput)
+      return ch;
+
+   if (timeoutMs < 0)
+      timeoutMs = 100 * *CRT_delay;
+
+   const size_t count = 2 + CRT_watchedCount + CRT_triggerCount;
+   if (count > CRT_pollFdsAlloc) {
+      CRT_pollFdsAlloc = count;
+      CRT_pollFds = xReallocArray(CRT_pollFds, CRT_pollFdsAlloc, sizeof(struct pollfd));
+   }
+
+   /* a negative fd is ignored by poll(), as the wake pipe is when there is none */
+   struct pollfd* fds = CRT_pollFds;
+   fds[0] = (struct pollfd) { .fd = STDIN_FILENO, .events = POLLIN };
+   fds[1] = (struct pollfd) { .fd = CRT_wakePipe[0], .events = POLLIN };
+   for (size_t i = 0; i < CRT_watchedCount; i++)
+      fds[2 + i] = (struct pollfd) { .fd = CRT_watched[i], .events = POLLIN };
+   struct pollfd* triggers = &fds[2 + CRT_watchedCount];
+   for (size_t i = 0; i < CRT_triggerCount; i++)
+      triggers[i] = (struct pollfd) { .fd = CRT_triggers[i], .events = POLLPRI };
+
+   int r = poll(fds, (nfds_t)count, timeoutMs);
+   if (r == 0)
+      return ERR;
+
+   for (size_t i = 0; r > 0 && i < CRT_triggerCount; i++) {
+      if (triggers[i].revents & POLLPRI)
+         CRT_triggered |= 1U << i;
+   }
+
+   if (r > 0 && (fds[1].revents & POLLIN)) {
+      char buffer[64];
+      while (read(CRT_wakePipe[0], buffer, sizeof(buffer)) > 0)
+         ;
+   }
+
+   /* a key, a resize noted by curses, or ERR if only woken */
+   return getch();
+}
+
+void CRT_watchFds(const int* fds, size_t count) {
+   CRT_watched = fds;
+   CRT_watchedCount = count;
+}
+
+void CRT_watchTriggers(const int* fds, size_t count) {
+   assert(count <= sizeof(CRT_triggered) * CHAR_BIT);
+   CRT_triggers = fds;
+   CRT_triggerCount = count;
+}
+
+unsigned int CRT_takeTriggered(void) {
+   unsigned int triggered = CRT_triggered;
+   CRT_triggered = 0;
+   return triggered;
+}
+
+bool CRT_watchedReady(void) {
+   for (size_t i = 0; i < CRT_watchedCount; i++) {
+      struct pollfd fd = { .fd = CRT_watched[i], .events = POLLIN };
+      if (poll(&fd, 1, 0) > 0)
+         return true;
+   }
+   return false;
+}
+
+bool CRT_inputPending(int timeoutMs) {
+   struct pollfd fd = { .fd = STDIN_FILENO, .events = POLLIN };
+   int r = poll(&fd, 1, timeoutMs);
+
+   /* interrupted, most likely by a resize that curses reports as the next key */
+   return r > 0 || (r < 0 && errno == EINTR);
+}
+
+void CRT_updateScreen(void) {
+   /* Without changes there is nothing to wrap; terminals ignore the unknown mode in low bandwidth mode */
+   if (!is_wintouched(stdscr) || !(CRT_syncUpdates || (CRT_lowBandwidth && *CRT_lowBandwidth))) {
+      refresh();
+      return;
+   }
+
+   /* Curses writes to the terminal on its own, flush around it to keep the order */
+   wnoutrefresh(stdscr);
+   fputs("\033[?2026h", stdout);
+   fflush(stdout);
+   doupdate();
+   fputs("\033[?2026l", stdout);
+   fflush(stdout);
+}
+
+void CRT_initHeadless(void) {
+   CRT_colorScheme = COLORSCHEME_MONOCHROME;
+   CRT_colors = CRT_colorSchemes[COLORSCHEME_MONOCHROME];
 }
 
 void CRT_setColors(int colorScheme) {
@@ -8,6 +8,7 @@ in the source distribution for its full text.
 */
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "Macros.h"
 #include "ProvideCurses.h"
@@ -95,6 +96,7 @@ typedef enum ColorElements_ {
    MEMORY_CACHE,
    MEMORY_SHARED,
    MEMORY_COMPRESSED,
+   MEMORY_SLAB,
    HUGEPAGE_1,
    HUGEPAGE_2,
    HUGEPAGE_3,
@@ -167,6 +169,8 @@ void CRT_handleSIGSEGV(int signal) ATTR_NORETURN;
 #define KEY_WHEELDOWN KEY_F(31)
 #define KEY_RECLICK   KEY_F(32)
 #define KEY_SHIFT_TAB KEY_F(33)
+#define KEY_FOCUS_IN  KEY_F(34)
+#define KEY_FOCUS_OUT KEY_F(35)
 #define KEY_ALT(x)    (KEY_F(64 - 26) + ((x) - 'A'))
 
 extern const char* CRT_degreeSign;
@@ -199,14 +203,48 @@ void CRT_init(const Settings* settings, bool allowUnicode, bool retainScreenOnEx
 
 void CRT_done(void);
 
+/* Attributes for modes that scan without a terminal, like `--record`; CRT_init() is not called there */
+void CRT_initHeadless(void);
+
 void CRT_resetSignalHandlers(void);
 
 int CRT_readKey(void);
 
+/* Lets CRT_getCh() return at once without input, e.g. when waiting on something else than keys */
 void CRT_disableDelay(void);
 
 void CRT_enableDelay(void);
 
+/* Timeout of CRT_getCh() of one update interval */
+#define CRT_UPDATE_TIMEOUT (-1)
+
+/* A key, or ERR once the timeout in milliseconds is over or CRT_wake() was called */
+int CRT_getCh(int timeoutMs);
+
+/* Ends the wait of CRT_getCh() early; safe from other threads and signal handlers */
+void CRT_wake(void);
+
+/* Descriptors CRT_getCh() also returns ERR for once one is readable; the array stays the caller's, NULL for none */
+void CRT_watchFds(const int* fds, size_t count);
+
+/* Whether one of the descriptors of CRT_watchFds() is readable now */
+bool CRT_watchedReady(void);
+
+/* Descriptors polled for POLLPRI by CRT_getCh(), whose events are gone once polled; -1 entries are skipped */
+void CRT_watchTriggers(const int* fds, size_t count);
+
+/* Bits of the indices of the triggers that fired since the last call */
+unsigned int CRT_takeTriggered(void);
+
+/* Whether input arrives on the terminal within timeoutMs (0 for what is pending now), or a signal like a resize */
+bool CRT_inputPending(int timeoutMs);
+
+/* Asks the terminal to report focus changes as KEY_FOCUS_IN and KEY_FOCUS_OUT (xterm mode 1004, also passed on by tmux) */
+void CRT_setFocusReporting(bool enabled);
+
 void CRT_setColors(int colorScheme);
 
+/* Sends pending changes of the screen to the terminal, as one synchronized update if possible */
+void CRT_updateScreen(void);
+
 #endif
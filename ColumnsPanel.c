@@ -162,4 +162,5 @@ void ColumnsPanel_update(Panel* super) {
          this->ss->flags |= Process_fields[key].flags;
    }
    this->ss->fields[size] = 0;
+   ScreenSettings_fieldsChanged(this->ss);
 }
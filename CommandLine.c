@@ -18,14 +18,15 @@ in the source distribution for its full text.
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 #include <unistd.h>
 
 #include "Action.h"
+#include "Batch.h"
 #include "CRT.h"
 #include "DynamicColumn.h"
 #include "DynamicMeter.h"
 #include "DynamicScreen.h"
+#include "Exporter.h"
 #include "Hashtable.h"
 #include "Header.h"
 #include "IncSet.h"
@@ -36,12 +37,23 @@ in the source distribution for its full text.
 #include "Platform.h"
 #include "Process.h"
 #include "ProcessTable.h"
+#include "Profile.h"
+#include "Recorder.h"
+#include "RecorderTrigger.h"
 #include "ScreenManager.h"
 #include "Settings.h"
 #include "Table.h"
 #include "UsersTable.h"
 #include "XUtils.h"
 
+#if defined(HTOP_LINUX) && !defined(HTOP_PCP)
+#include "linux/SharedScan.h"
+#endif
+
+#ifdef HTOP_PCP
+#include "pcp/PCPBench.h"
+#endif
+
 
 static void printVersionFlag(const char* name) {
    printf("%s " VERSION "\n", name);
@@ -51,19 +63,32 @@ static void printHelpFlag(const char* name) {
    printf("%s " VERSION "\n"
           COPYRIGHT "\n"
           "Released under the GNU GPLv2+.\n\n"
+          "   --batch                      Write the rows of every update to stdout instead of showing them\n"
           "-C --no-color                   Use a monochrome color scheme\n"
           "-d --delay=DELAY                Set the delay between updates, in tenths of seconds\n"
           "-F --filter=FILTER              Show only the commands matching the given filter\n"
+          "   --format=jsonl|csv           Format of --batch and of exports with E (default: jsonl)\n"
           "-h --help                       Print this help screen\n"
-          "-H --highlight-changes[=DELAY]  Highlight new and old processes\n", name);
+          "-H --highlight-changes[=DELAY]  Highlight new and old processes\n"
+          "   --listen=[HOST:]PORT         Serve the metrics of every update for Prometheus on\n"
+          "                                http://HOST:PORT/metrics instead of showing them\n", name);
 #ifdef HAVE_GETMOUSE
    printf("-M --no-mouse                   Disable the mouse\n");
 #endif
    printf("-n --max-iterations=NUMBER      Exit htop after NUMBER iterations/frame updates\n"
           "-p --pid=PID[,PID,PID...]       Show only the given PIDs\n"
+          "   --profile                    Print timings of htop itself on exit\n"
           "   --readonly                   Disable all system and process changing features\n"
+          "   --record=FILE                Record the processes of every update to the ring file FILE\n"
+          "                                instead of showing them (16 MiB, or the size FILE has)\n"
+          "   --record-before=SECONDS      Keep this much before a --record-trigger (default: 30)\n"
+          "   --record-trigger=RULE        Record only around the incidents of RULE, at 10 updates per\n"
+          "                                second for 10 seconds: cpu>PERCENT[/SECONDS],\n"
+          "                                mem>PERCENT[/SECONDS] or rss+SIZE[/SECONDS] (repeatable)\n"
           "-s --sort-key=COLUMN            Sort by COLUMN in list view (try --sort-key=help for a list)\n"
           "-t --tree                       Show the tree view (can be combined with -s)\n"
+          "   --top=N                      Write only the first N rows of every update with --batch,\n"
+          "                                or export only the first N processes with --listen\n"
           "-u --user[=USERNAME]            Show only processes for a given user (or $USER)\n"
           "-U --no-unicode                 Do not use unicode but plain ASCII\n"
           "-V --version                    Print version info\n");
@@ -91,6 +116,13 @@ typedef struct CommandLineSettings_ {
    bool highlightChanges;
    int highlightDelaySecs;
    bool readonly;
+   bool profile;
+   const char* recordFile;
+   bool recordBefore;
+   bool batch;
+   BatchFormat batchFormat;
+   int batchRows;
+   const char* listenAddr;
 } CommandLineSettings;
 
 static CommandLineStatus parseArguments(int argc, char** argv, CommandLineSettings* flags) {
@@ -111,6 +143,13 @@ static CommandLineStatus parseArguments(int argc, char** argv, CommandLineSettin
       .highlightChanges = false,
       .highlightDelaySecs = -1,
       .readonly = false,
+      .profile = false,
+      .recordFile = NULL,
+      .recordBefore = false,
+      .batch = false,
+      .batchFormat = BATCH_FORMAT_NONE,
+      .batchRows = 0,
+      .listenAddr = NULL,
    };
 
    const struct option long_opts[] =
@@ -130,6 +169,14 @@ static CommandLineStatus parseArguments(int argc, char** argv, CommandLineSettin
       {"filter",     required_argument,   0, 'F'},
       {"highlight-changes", optional_argument, 0, 'H'},
       {"readonly",   no_argument,         0, 128},
+      {"profile",    no_argument,         0, 129},
+      {"record",     required_argument,   0, 130},
+      {"batch",      no_argument,         0, 131},
+      {"format",     required_argument,   0, 132},
+      {"top",        required_argument,   0, 133},
+      {"listen",     required_argument,   0, 134},
+      {"record-trigger", required_argument, 0, 135},
+      {"record-before", required_argument, 0, 136},
       PLATFORM_LONG_OPTIONS
       {0, 0, 0, 0}
    };
@@ -272,6 +319,45 @@ static CommandLineStatus parseArguments(int argc, char** argv, CommandLineSettin
          case 128:
             flags->readonly = true;
             break;
+         case 129:
+            flags->profile = true;
+            break;
+         case 130:
+            flags->recordFile = optarg;
+            break;
+         case 131:
+            flags->batch = true;
+            break;
+         case 132:
+            flags->batchFormat = Batch_parseFormat(optarg);
+            if (flags->batchFormat == BATCH_FORMAT_NONE) {
+               fprintf(stderr, "Error: invalid batch format \"%s\".\n", optarg);
+               return STATUS_ERROR_EXIT;
+            }
+            break;
+         case 133:
+            if (sscanf(optarg, "%16d", &(flags->batchRows)) != 1 || flags->batchRows < 1) {
+               fprintf(stderr, "Error: invalid number of rows \"%s\".\n", optarg);
+               return STATUS_ERROR_EXIT;
+            }
+            break;
+         case 134:
+            flags->listenAddr = optarg;
+            break;
+         case 135:
+            if (!RecorderTrigger_add(optarg))
+               return STATUS_ERROR_EXIT;
+            break;
+         case 136: {
+            int secs;
+            if (sscanf(optarg, "%16d", &secs) != 1 || secs < 1 || secs > 3600) {
+               fprintf(stderr, "Error: invalid number of seconds \"%s\".\n", optarg);
+               return STATUS_ERROR_EXIT;
+            }
+            RecorderTrigger_beforeMs = 1000 * (uint64_t)secs;
+            flags->recordBefore = true;
+            break;
+         }
 
          default: {
             CommandLineStatus status;
@@ -282,6 +368,26 @@ static CommandLineStatus parseArguments(int argc, char** argv, CommandLineSettin
       }
    }
 
+   if (flags->listenAddr && flags->batchFormat != BATCH_FORMAT_NONE) {
+      fprintf(stderr, "Error: --format does not apply to --listen.\n");
+      return STATUS_ERROR_EXIT;
+   }
+
+   if (!flags->batch && !flags->listenAddr && flags->batchRows) {
+      fprintf(stderr, "Error: --top only applies to --batch and --listen.\n");
+      return STATUS_ERROR_EXIT;
+   }
+
+   if (!flags->recordFile && (RecorderTrigger_count() || flags->recordBefore)) {
+      fprintf(stderr, "Error: --record-trigger and --record-before only apply to --record.\n");
+      return STATUS_ERROR_EXIT;
+   }
+
+   if (flags->batch && flags->listenAddr) {
+      fprintf(stderr, "Error: --batch and --listen can not be combined.\n");
+      return STATUS_ERROR_EXIT;
+   }
+
    if (optind < argc) {
       fprintf(stderr, "Error: unsupported non-option ARGV-elements:");
       while (optind < argc)
@@ -293,16 +399,6 @@ static CommandLineStatus parseArguments(int argc, char** argv, CommandLineSettin
    return STATUS_OK;
 }
 
-static void CommandLine_delay(Machine* host, unsigned long millisec) {
-   struct timespec req = {
-      .tv_sec = 0,
-      .tv_nsec = millisec * 1000000L
-   };
-   while (nanosleep(&req, &req) == -1)
-      continue;
-   Platform_gettime_realtime(&host->realtime, &host->realtimeMs);
-}
-
 static void setCommFilter(State* state, char** commFilter) {
    Table* table = state->host->activeTable;
    IncSet* inc = state->mainPanel->inc;
@@ -315,6 +411,7 @@ static void setCommFilter(State* state, char** commFilter) {
 }
 
 int CommandLine_run(int argc, char** argv) {
+   Profile_startup = Profile_begin();
 
    /* initialize locale */
    const char* lc_ctype;
@@ -332,6 +429,9 @@ int CommandLine_run(int argc, char** argv) {
    if (flags.readonly)
       Settings_enableReadonly();
 
+   if (flags.profile && !Profile_enableSyscalls())
+      fprintf(stderr, "Warning: syscalls of htop cannot be counted on this system.\n");
+
    if (!Platform_init())
       return 1;
 
@@ -345,6 +445,9 @@ int CommandLine_run(int argc, char** argv) {
    Settings* settings = Settings_new(host->activeCPUs, dm, dc, ds);
    Machine_populateTablesFromSettings(host, settings, &pt->super);
 
+   if (settings->preloadUsers)
+      UsersTable_preload(ut);
+
    Header* header = Header_new(host, 2);
    Header_populateFromSettings(header);
 
@@ -372,6 +475,63 @@ int CommandLine_run(int argc, char** argv) {
    }
 
    host->iterationsRemaining = flags.iterationsRemaining;
+
+#if defined(HTOP_LINUX) && !defined(HTOP_PCP)
+   const bool serve = SharedScan_mode == SHARED_SCAN_SERVE;
+#else
+   const bool serve = false;
+#endif
+
+#ifdef HTOP_PCP
+   const bool bench = PCPBench_enabled;
+#else
+   const bool bench = false;
+#endif
+
+   /* modes without a terminal */
+   if (flags.recordFile || serve || bench || flags.batch || flags.listenAddr) {
+      /* the filter of -F is otherwise set up with the search bar */
+      host->activeTable->incFilter = flags.commFilter;
+
+#if defined(HTOP_LINUX) && !defined(HTOP_PCP)
+      /* no key has to be answered, all of htop can yield */
+      if (Platform_lowImpact)
+         Platform_lowerThreadPriority();
+#endif
+
+      bool done;
+#ifdef HTOP_PCP
+      if (bench) {
+         done = PCPBench_run(host);
+      } else
+#endif
+      if (flags.listenAddr) {
+         done = Exporter_run(host, flags.listenAddr, flags.batchRows);
+      } else if (flags.batch) {
+         done = Batch_run(host, flags.batchFormat != BATCH_FORMAT_NONE ? flags.batchFormat : BATCH_FORMAT_JSONL, flags.batchRows);
+      } else {
+#if defined(HTOP_LINUX) && !defined(HTOP_PCP)
+         done = serve ? SharedScan_serve(host) : Recorder_run(host, flags.recordFile);
+#else
+         done = Recorder_run(host, flags.recordFile);
+#endif
+      }
+
+      Platform_done();
+      Header_delete(header);
+      Machine_delete(host);
+      UsersTable_delete(ut);
+      if (flags.pidMatchList)
+         Hashtable_delete(flags.pidMatchList);
+      free(flags.commFilter);
+      Settings_delete(settings);
+      DynamicColumns_delete(dc);
+      DynamicMeters_delete(dm);
+      DynamicScreens_delete(ds);
+
+      return done ? 0 : 1;
+   }
+
    CRT_init(settings, flags.allowUnicode, flags.iterationsRemaining != -1);
 
    MainPanel* panel = MainPanel_new();
@@ -384,6 +544,7 @@ int CommandLine_run(int argc, char** argv) {
       .mainPanel = panel,
       .header = header,
       .pauseUpdate = false,
+      .unfocused = false,
       .hideSelection = false,
       .hideMeters = false,
    };
@@ -395,21 +556,20 @@ int CommandLine_run(int argc, char** argv) {
    ScreenManager* scr = ScreenManager_new(header, host, &state, true);
    ScreenManager_add(scr, (Panel*) panel, -1);
 
-   Machine_scan(host);
-   Machine_scanTables(host);
-   CommandLine_delay(host, 75);
-   Machine_scan(host);
-   Machine_scanTables(host);
-
-   if (settings->ss->allBranchesCollapsed)
-      Table_collapseAllBranches(&pt->super);
+   if (flags.batchFormat != BATCH_FORMAT_NONE)
+      Batch_setExportFormat(flags.batchFormat);
 
    ScreenManager_run(scr, NULL, NULL, NULL);
 
+   Batch_exportDone();
+
    Platform_done();
 
    CRT_done();
 
+   if (flags.profile)
+      Profile_dump(stdout);
+
    if (settings->changed) {
       int r = Settings_write(settings, false);
       if (r < 0)
@@ -9,13 +9,14 @@ in the source distribution for its full text.
 
 #include "DiskIOMeter.h"
 
-#include <stdbool.h>
+#include <math.h>
 
 #include "CRT.h"
 #include "Machine.h"
 #include "Macros.h"
 #include "Object.h"
 #include "Platform.h"
+#include "Rate.h"
 #include "RichString.h"
 #include "Row.h"
 #include "XUtils.h"
@@ -32,68 +33,47 @@ static char cached_read_diff_str[6];
 static char cached_write_diff_str[6];
 static double cached_utilisation_diff;
 
+static Rate readRate;
+static Rate writeRate;
+static Rate busyRate;
+
 static void DiskIOMeter_updateValues(Meter* this) {
    const Machine* host = this->host;
 
    static uint64_t cached_last_update;
    uint64_t passedTimeInMs = host->realtimeMs - cached_last_update;
-   bool hasNewData = false;
    DiskIOData data;
 
    /* update only every 500ms to have a sane span for rate calculation */
    if (passedTimeInMs > 500) {
-      hasNewData = Platform_getDiskIO(&data);
-      if (!hasNewData) {
+      if (!Platform_getDiskIO(&data)) {
          status = RATESTATUS_NODATA;
-      } else if (cached_last_update == 0) {
-         status = RATESTATUS_INIT;
-      } else if (passedTimeInMs > 30000) {
-         status = RATESTATUS_STALE;
+         Rate_reset(&readRate);
+         Rate_reset(&writeRate);
+         Rate_reset(&busyRate);
       } else {
-         status = RATESTATUS_DATA;
-      }
-
-      cached_last_update = host->realtimeMs;
-   }
-
-   if (hasNewData) {
-      static uint64_t cached_read_total;
-      static uint64_t cached_write_total;
-      static uint64_t cached_msTimeSpend_total;
-
-      if (status != RATESTATUS_INIT) {
-         uint64_t diff;
-
-         if (data.totalBytesRead > cached_read_total) {
-            diff = data.totalBytesRead - cached_read_total;
-            diff = (1000 * diff) / passedTimeInMs; /* convert to B/s */
-            diff /= ONE_K; /* convert to KiB/s */
+         Rate_update(&readRate, data.totalBytesRead, host->realtimeMs);
+         Rate_update(&writeRate, data.totalBytesWritten, host->realtimeMs);
+         Rate_update(&busyRate, data.totalMsTimeSpend, host->realtimeMs);
+
+         /* a device gone since the last read lowers the totals, begin anew */
+         if (isnan(Rate_value(&readRate)) || isnan(Rate_value(&writeRate)) || isnan(Rate_value(&busyRate))) {
+            status = RATESTATUS_INIT;
+         } else if (passedTimeInMs > 30000) {
+            status = RATESTATUS_STALE;
          } else {
-            diff = 0;
+            status = RATESTATUS_DATA;
          }
-         Meter_humanUnit(cached_read_diff_str, diff, sizeof(cached_read_diff_str));
-
-         if (data.totalBytesWritten > cached_write_total) {
-            diff = data.totalBytesWritten - cached_write_total;
-            diff = (1000 * diff) / passedTimeInMs; /* convert to B/s */
-            diff /= ONE_K; /* convert to KiB/s */
-         } else {
-            diff = 0;
-         }
-         Meter_humanUnit(cached_write_diff_str, diff, sizeof(cached_write_diff_str));
+      }
 
-         if (data.totalMsTimeSpend > cached_msTimeSpend_total) {
-            diff = data.totalMsTimeSpend - cached_msTimeSpend_total;
-            cached_utilisation_diff = 100.0 * (double)diff / passedTimeInMs;
-            cached_utilisation_diff = MINIMUM(cached_utilisation_diff, 100.0);
-         } else {
-            cached_utilisation_diff = 0.0;
-         }
+      if (status != RATESTATUS_NODATA && status != RATESTATUS_INIT) {
+         Meter_humanUnit(cached_read_diff_str, Rate_value(&readRate) / ONE_K, sizeof(cached_read_diff_str));
+         Meter_humanUnit(cached_write_diff_str, Rate_value(&writeRate) / ONE_K, sizeof(cached_write_diff_str));
+         /* milliseconds busy per second */
+         cached_utilisation_diff = MINIMUM(Rate_value(&busyRate) / 10.0, 100.0);
       }
 
-      cached_read_total = data.totalBytesRead;
-      cached_write_total = data.totalBytesWritten;
-      cached_msTimeSpend_total = data.totalMsTimeSpend;
+      cached_last_update = host->realtimeMs;
    }
 
    this->values[0] = cached_utilisation_diff;
@@ -78,7 +78,7 @@ static HandlerResult DisplayOptionsPanel_eventHandler(Panel* super, int ch) {
       Header_calculateHeight(header);
       Header_reinit(header);
       Header_updateData(header);
-      Header_draw(header);
+      Header_draw(header, true);
       ScreenManager_resize(this->scr);
    }
 
@@ -152,11 +152,32 @@ DisplayOptionsPanel* DisplayOptionsPanel_new(Settings* settings, ScreenManager*
    Panel_add(super, (Object*) CheckItem_newByRef("Enable the mouse", &(settings->enableMouse)));
    #endif
    Panel_add(super, (Object*) NumberItem_newByRef("Update interval (in seconds)", &(settings->delay), -1, 1, 255));
+   Panel_add(super, (Object*) NumberItem_newByRef("- Process list update interval (in seconds, 0 - same)", &(settings->tableDelay), -1, 0, 255));
+   Panel_add(super, (Object*) NumberItem_newByRef("- Update interval while the terminal is not focused (in seconds, 0 - same)", &(settings->unfocusedDelay), -1, 0, 3000));
+   Panel_add(super, (Object*) NumberItem_newByRef("CPU budget of htop, longer intervals when over (in % of one CPU, 0 - unlimited)", &(settings->cpuBudget), -1, 0, 1000));
+   Panel_add(super, (Object*) CheckItem_newByRef("Save power on battery: update every 5 seconds or less often, skip expensive columns", &(settings->batterySaver)));
+   Panel_add(super, (Object*) NumberItem_newByRef("Lines kept when tracing a process (in thousands)", &(settings->traceLines), 0, 1, 10000));
+   Panel_add(super, (Object*) NumberItem_newByRef("Window of the memory growth column (in minutes)", &(settings->memGrowthWindow), 0, 1, 24 * 60));
    Panel_add(super, (Object*) CheckItem_newByRef("Highlight new and old processes", &(settings->highlightChanges)));
    Panel_add(super, (Object*) NumberItem_newByRef("- Highlight time (in seconds)", &(settings->highlightDelaySecs), 0, 1, 24 * 60 * 60));
    Panel_add(super, (Object*) NumberItem_newByRef("Hide main function bar (0 - off, 1 - on ESC until next input, 2 - permanently)", &(settings->hideFunctionBar), 0, 0, 2));
+   Panel_add(super, (Object*) CheckItem_newByRef("Reduce terminal output for slow connections (graphs move every few updates)", &(settings->lowBandwidth)));
    #ifdef HAVE_LIBHWLOC
    Panel_add(super, (Object*) CheckItem_newByRef("Show topology when selecting affinity by default", &(settings->topologyAffinity)));
    #endif
+   #ifdef HAVE_PROC_CONNECTOR
+   Panel_add(super, (Object*) CheckItem_newByRef("Track new processes and exec via kernel process events (requires root)", &(settings->procConnector)));
+   #endif
+   #if defined(HAVE_PTHREAD) && defined(HTOP_LINUX)
+   Panel_add(super, (Object*) NumberItem_newByRef("Threads for scanning processes (0 - off)", &(settings->scanThreads), 0, 0, 64));
+   #endif
+   #ifdef HTOP_LINUX
+   Panel_add(super, (Object*) CheckItem_newByRef("Read expensive columns only for processes on screen", &(settings->lazyCollection)));
+   Panel_add(super, (Object*) CheckItem_newByRef("Keep reading the columns of other screens, less often", &(settings->warmScreens)));
+   Panel_add(super, (Object*) NumberItem_newByRef("Update faster while CPU, memory or I/O stall for (% of a second, 0 - off)", &(settings->pressureTrigger), 0, 0, 100));
+   Panel_add(super, (Object*) CheckItem_newByRef("Name docker, containerd and CRI-O containers after their runtime metadata", &(settings->containerNames)));
+   Panel_add(super, (Object*) CheckItem_newByRef("Compute CPU% from nanosecond run times (schedstat) rather than clock ticks", &(settings->preciseCpu)));
+   #endif
+   Panel_add(super, (Object*) CheckItem_newByRef("Preload all user names at startup", &(settings->preloadUsers)));
    return this;
 }
@@ -14,11 +14,11 @@ in the source distribution for its full text.
 #include <stdlib.h>
 #include <string.h>
 
+#include "LineStore.h"
 #include "Macros.h"
 #include "Panel.h"
 #include "Platform.h"
 #include "ProvideCurses.h"
-#include "Vector.h"
 #include "XUtils.h"
 
 
@@ -52,8 +52,7 @@ static void EnvScreen_scan(InfoScreen* this) {
       InfoScreen_addLine(this, "Could not read process environment.");
    }
 
-   Vector_insertionSort(this->lines);
-   Vector_insertionSort(panel->items);
+   LineStore_sort(this->lines);
    Panel_setSelected(panel, idx);
 }
 
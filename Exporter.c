@@ -0,0 +1,752 @@
+/*
+htop - Exporter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "Exporter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "CRT.h"
+#include "Macros.h"
+#include "Platform.h"
+#include "Process.h"
+#include "ProcessSnapshot.h"
+#include "ProcessTable.h"
+#include "Row.h"
+#include "Settings.h"
+#include "Table.h"
+#include "Vector.h"
+#include "XUtils.h"
+
+#if defined(HTOP_LINUX) && !defined(HTOP_PCP)
+#include "linux/LinuxMachine.h"
+#include "linux/LinuxProcess.h"
+#endif
+
+
+/* A scraper that does not send its request and read the response in this time is dropped */
+#define EXPORTER_CLIENT_TIMEOUT_MS 2000
+
+/* Scrapers served at once */
+#define EXPORTER_CLIENTS_MAX 16
+
+#define EXPORTER_REQUEST_MAX 4096
+
+typedef struct ExporterBuffer_ {
+   char* data;
+   size_t len;
+   size_t alloc;
+} ExporterBuffer;
+
+typedef struct ExporterClient_ {
+   int fd;
+   uint64_t deadlineMs;       /* monotonic */
+   char request[EXPORTER_REQUEST_MAX + 1];
+   size_t requestLen;
+   ExporterBuffer response;   /* empty until the request was read */
+   size_t sent;
+} ExporterClient;
+
+typedef struct Exporter_ {
+   int fd;
+   int maxRows;
+   uint64_t scans;
+
+   ExporterClient* clients;
+   size_t clientCount;
+
+   /* the metrics of the last scan, once they were scraped */
+   ExporterBuffer body;
+   uint64_t bodyScan;
+
+   ExporterBuffer labels;     /* label set of the sample being written */
+} Exporter;
+
+/* Per user or cgroup sums of the processes */
+typedef struct ExporterGroup_ {
+   const char* name;
+   const Process* proc;
+} ExporterGroup;
+
+static volatile sig_atomic_t Exporter_stop = 0;
+
+static void Exporter_putBytes(ExporterBuffer* this, const char* data, size_t len) {
+   if (this->len + len > this->alloc) {
+      this->alloc = MAXIMUM(2 * this->alloc, this->len + len + 4096);
+      this->data = xRealloc(this->data, this->alloc);
+   }
+   memcpy(this->data + this->len, data, len);
+   this->len += len;
+}
+
+static inline void Exporter_putString(ExporterBuffer* this, const char* str) {
+   Exporter_putBytes(this, str, strlen(str));
+}
+
+ATTR_FORMAT(printf, 2, 3)
+static void Exporter_printf(ExporterBuffer* this, const char* fmt, ...) {
+   char buffer[256];
+   va_list ap;
+   va_start(ap, fmt);
+   int len = vsnprintf(buffer, sizeof(buffer), fmt, ap);
+   va_end(ap);
+
+   if (len > 0)
+      Exporter_putBytes(this, buffer, MINIMUM((size_t)len, sizeof(buffer) - 1));
+}
+
+static void Exporter_family(Exporter* this, const char* name, const char* type, const char* help) {
+   Exporter_printf(&this->body, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/* Adds a label to the label set of the next sample, escaped as the text format wants it */
+static void Exporter_label(Exporter* this, const char* key, const char* value) {
+   ExporterBuffer* labels = &this->labels;
+   if (labels->len)
+      Exporter_putString(labels, ",");
+   Exporter_putString(labels, key);
+   Exporter_putString(labels, "=\"");
+   for (const char* c = value; *c; c++) {
+      if (*c == '\\' || *c == '"') {
+         Exporter_putBytes(labels, "\\", 1);
+         Exporter_putBytes(labels, c, 1);
+      } else if (*c == '\n') {
+         Exporter_putString(labels, "\\n");
+      } else {
+         Exporter_putBytes(labels, c, 1);
+      }
+   }
+   Exporter_putString(labels, "\"");
+}
+
+static void Exporter_sampleName(Exporter* this, const char* name) {
+   Exporter_putString(&this->body, name);
+   if (this->labels.len) {
+      Exporter_putString(&this->body, "{");
+      Exporter_putBytes(&this->body, this->labels.data, this->labels.len);
+      Exporter_putString(&this->body, "}");
+   }
+   this->labels.len = 0;
+}
+
+static void Exporter_sample(Exporter* this, const char* name, double value) {
+   if (isnan(value)) {
+      this->labels.len = 0;
+      return;
+   }
+
+   Exporter_sampleName(this, name);
+   Exporter_printf(&this->body, " %.10g\n", value);
+}
+
+static void Exporter_sampleCount(Exporter* this, const char* name, unsigned long long value) {
+   Exporter_sampleName(this, name);
+   Exporter_printf(&this->body, " %llu\n", value);
+}
+
+static void Exporter_sampleKind(Exporter* this, const char* name, const char* kind, unsigned long long value) {
+   Exporter_label(this, "kind", kind);
+   Exporter_sampleCount(this, name, value);
+}
+
+static void Exporter_encodeMachine(Exporter* this, const Machine* host) {
+   const ProcessTable* pt = (const ProcessTable*) host->processTable;
+
+   Exporter_family(this, "htop_memory_bytes", "gauge", "Memory of the machine by kind.");
+   Exporter_sampleKind(this, "htop_memory_bytes", "total", host->totalMem * ONE_K);
+   Exporter_sampleKind(this, "htop_memory_bytes", "used", host->usedMem * ONE_K);
+   Exporter_sampleKind(this, "htop_memory_bytes", "buffers", host->buffersMem * ONE_K);
+   Exporter_sampleKind(this, "htop_memory_bytes", "cached", host->cachedMem * ONE_K);
+   Exporter_sampleKind(this, "htop_memory_bytes", "shared", host->sharedMem * ONE_K);
+   Exporter_sampleKind(this, "htop_memory_bytes", "available", host->availableMem * ONE_K);
+
+   Exporter_family(this, "htop_swap_bytes", "gauge", "Swap of the machine by kind.");
+   Exporter_sampleKind(this, "htop_swap_bytes", "total", host->totalSwap * ONE_K);
+   Exporter_sampleKind(this, "htop_swap_bytes", "used", host->usedSwap * ONE_K);
+   Exporter_sampleKind(this, "htop_swap_bytes", "cached", host->cachedSwap * ONE_K);
+
+   Exporter_family(this, "htop_cpus", "gauge", "CPUs of the machine by state.");
+   Exporter_sampleKind(this, "htop_cpus", "active", host->activeCPUs);
+   Exporter_sampleKind(this, "htop_cpus", "existing", host->existingCPUs);
+
+   Exporter_family(this, "htop_tasks", "gauge", "Tasks of the machine by kind.");
+   Exporter_sampleKind(this, "htop_tasks", "total", pt->totalTasks);
+   Exporter_sampleKind(this, "htop_tasks", "running", pt->runningTasks);
+   Exporter_sampleKind(this, "htop_tasks", "userland_threads", pt->userlandThreads);
+   Exporter_sampleKind(this, "htop_tasks", "kernel_threads", pt->kernelThreads);
+
+   /* from the snapshot of the scan, threads are counted with their process */
+   unsigned int states[SLEEPING + 1];
+   ProcessSnapshot_countStates(&pt->snapshot, PROCESS_SNAPSHOT_KERNEL_THREAD | PROCESS_SNAPSHOT_USERLAND_THREAD, states);
+   Exporter_family(this, "htop_processes_state", "gauge", "Processes by the letter of their state.");
+   for (int s = UNKNOWN; s <= SLEEPING; s++) {
+      if (!states[s])
+         continue;
+
+      const char letter[2] = { Process_stateChar((ProcessState)s), '\0' };
+      Exporter_label(this, "state", letter);
+      Exporter_sampleCount(this, "htop_processes_state", states[s]);
+   }
+
+   double load[3];
+   Platform_getLoadAverage(&load[0], &load[1], &load[2]);
+   static const char* const periods[] = { "1", "5", "15" };
+   Exporter_family(this, "htop_load_average", "gauge", "Load average over minutes.");
+   for (size_t i = 0; i < ARRAYSIZE(periods); i++) {
+      Exporter_label(this, "minutes", periods[i]);
+      Exporter_sample(this, "htop_load_average", load[i]);
+   }
+
+   int uptime = Platform_getUptime();
+   if (uptime > 0) {
+      Exporter_family(this, "htop_uptime_seconds", "gauge", "Time since the machine booted.");
+      Exporter_sampleCount(this, "htop_uptime_seconds", (unsigned long long)uptime);
+   }
+}
+
+#if defined(HTOP_LINUX) && !defined(HTOP_PCP)
+
+static void Exporter_encodeLinux(Exporter* this, const LinuxMachine* lhost) {
+   const Machine* host = &lhost->super;
+   const double jiffies = lhost->jiffies > 0 ? (double)lhost->jiffies : 100.0;
+
+   Exporter_family(this, "htop_cpu_seconds_total", "counter", "Time the CPUs spent in each mode.");
+   for (unsigned int i = 1; i <= host->existingCPUs; i++) {
+      const CPUData* cpu = &lhost->cpuData[i];
+      if (!cpu->online)
+         continue;
+
+      const struct {
+         const char* mode;
+         unsigned long long int time;
+      } modes[] = {
+         { "user", cpu->userTime },
+         { "nice", cpu->niceTime },
+         { "system", cpu->systemTime },
+         { "idle", cpu->idleTime },
+         { "iowait", cpu->ioWaitTime },
+         { "irq", cpu->irqTime },
+         { "softirq", cpu->softIrqTime },
+         { "steal", cpu->stealTime },
+         { "guest", cpu->guestTime },
+      };
+
+      char id[16];
+      xSnprintf(id, sizeof(id), "%u", i - 1);
+      for (size_t m = 0; m < ARRAYSIZE(modes); m++) {
+         Exporter_label(this, "cpu", id);
+         Exporter_label(this, "mode", modes[m].mode);
+         Exporter_sample(this, "htop_cpu_seconds_total", (double)modes[m].time / jiffies);
+      }
+   }
+
+   static const char* const resources[] = { "cpu", "io", "memory", "irq" };
+   static const char* const windows[] = { "10", "60", "300" };
+   Exporter_family(this, "htop_pressure_stall_ratio", "gauge", "Share of time tasks stalled on a resource, averaged over seconds.");
+   for (size_t r = 0; r < ARRAYSIZE(resources); r++) {
+      for (int some = 1; some >= 0; some--) {
+         /* the irq pressure only has a full line */
+         if (some && String_eq(resources[r], "irq"))
+            continue;
+
+         double avg[3];
+         Platform_getPressureStall(resources[r], some, &avg[0], &avg[1], &avg[2]);
+         for (size_t w = 0; w < ARRAYSIZE(windows); w++) {
+            Exporter_label(this, "resource", resources[r]);
+            Exporter_label(this, "kind", some ? "some" : "full");
+            Exporter_label(this, "window", windows[w]);
+            Exporter_sample(this, "htop_pressure_stall_ratio", avg[w] / 100.0);
+         }
+      }
+   }
+
+   const ZramStats* zram = &lhost->zram;
+   if (zram->totalZram > 0) {
+      Exporter_family(this, "htop_zram_bytes", "gauge", "Compressed RAM disks by kind.");
+      Exporter_sampleKind(this, "htop_zram_bytes", "total", zram->totalZram * ONE_K);
+      Exporter_sampleKind(this, "htop_zram_bytes", "compressed", zram->usedZramComp * ONE_K);
+      Exporter_sampleKind(this, "htop_zram_bytes", "original", zram->usedZramOrig * ONE_K);
+   }
+
+   const ZfsArcStats* zfs = &lhost->zfs;
+   if (zfs->enabled) {
+      Exporter_family(this, "htop_zfs_arc_bytes", "gauge", "ZFS adaptive replacement cache by kind.");
+      Exporter_sampleKind(this, "htop_zfs_arc_bytes", "size", zfs->size * ONE_K);
+      Exporter_sampleKind(this, "htop_zfs_arc_bytes", "min", zfs->min * ONE_K);
+      Exporter_sampleKind(this, "htop_zfs_arc_bytes", "max", zfs->max * ONE_K);
+      Exporter_sampleKind(this, "htop_zfs_arc_bytes", "mfu", zfs->MFU * ONE_K);
+      Exporter_sampleKind(this, "htop_zfs_arc_bytes", "mru", zfs->MRU * ONE_K);
+      Exporter_sampleKind(this, "htop_zfs_arc_bytes", "anon", zfs->anon * ONE_K);
+      Exporter_sampleKind(this, "htop_zfs_arc_bytes", "header", zfs->header * ONE_K);
+      Exporter_sampleKind(this, "htop_zfs_arc_bytes", "other", zfs->other * ONE_K);
+      if (zfs->isCompressed) {
+         Exporter_sampleKind(this, "htop_zfs_arc_bytes", "compressed", zfs->compressed * ONE_K);
+         Exporter_sampleKind(this, "htop_zfs_arc_bytes", "uncompressed", zfs->uncompressed * ONE_K);
+      }
+   }
+}
+
+#endif
+
+/* The name of the program, as the Command column would start */
+static void Exporter_processName(const Process* proc, char* buffer, size_t size) {
+   if (proc->procComm) {
+      String_safeStrncpy(buffer, proc->procComm, size);
+      return;
+   }
+
+   const char* cmdline = proc->cmdline ? proc->cmdline : "";
+   int start = proc->cmdline ? proc->cmdlineBasenameStart : 0;
+   int end = proc->cmdline && proc->cmdlineBasenameEnd > start ? proc->cmdlineBasenameEnd : (int)strlen(cmdline);
+   String_safeStrncpy(buffer, cmdline + start, MINIMUM(size, (size_t)(end - start) + 1));
+}
+
+static void Exporter_processLabels(Exporter* this, const Process* proc) {
+   char pid[16];
+   char name[64];
+   xSnprintf(pid, sizeof(pid), "%d", Process_getPid(proc));
+   Exporter_processName(proc, name, sizeof(name));
+
+   Exporter_label(this, "pid", pid);
+   Exporter_label(this, "user", proc->user ? proc->user : "");
+   Exporter_label(this, "name", name);
+}
+
+static void Exporter_encodeProcesses(Exporter* this, const Process* const* procs, size_t count) {
+   Exporter_family(this, "htop_process_cpu_percent", "gauge", "CPU usage of the process over the last update.");
+   for (size_t i = 0; i < count; i++) {
+      Exporter_processLabels(this, procs[i]);
+      Exporter_sample(this, "htop_process_cpu_percent", procs[i]->percent_cpu);
+   }
+
+   Exporter_family(this, "htop_process_cpu_seconds_total", "counter", "CPU time the process used.");
+   for (size_t i = 0; i < count; i++) {
+      Exporter_processLabels(this, procs[i]);
+      Exporter_sample(this, "htop_process_cpu_seconds_total", (double)procs[i]->time / 100.0);
+   }
+
+   Exporter_family(this, "htop_process_resident_bytes", "gauge", "Resident memory of the process.");
+   for (size_t i = 0; i < count; i++) {
+      Exporter_processLabels(this, procs[i]);
+      Exporter_sampleCount(this, "htop_process_resident_bytes", (unsigned long long)procs[i]->m_resident * ONE_K);
+   }
+
+   Exporter_family(this, "htop_process_virtual_bytes", "gauge", "Virtual memory of the process.");
+   for (size_t i = 0; i < count; i++) {
+      Exporter_processLabels(this, procs[i]);
+      Exporter_sampleCount(this, "htop_process_virtual_bytes", (unsigned long long)procs[i]->m_virt * ONE_K);
+   }
+
+   Exporter_family(this, "htop_process_threads", "gauge", "Threads of the process.");
+   for (size_t i = 0; i < count; i++) {
+      Exporter_processLabels(this, procs[i]);
+      Exporter_sampleCount(this, "htop_process_threads", (unsigned long long)MAXIMUM(procs[i]->nlwp, 0));
+   }
+}
+
+static int Exporter_compareGroups(const void* v1, const void* v2) {
+   const ExporterGroup* g1 = v1;
+   const ExporterGroup* g2 = v2;
+   return strcmp(g1->name, g2->name);
+}
+
+/* Sums the processes of each group, sorted by name so equal names are adjacent */
+static void Exporter_encodeGroups(Exporter* this, const char* kind, const char* label, ExporterGroup* groups, size_t count) {
+   qsort(groups, count, sizeof(ExporterGroup), Exporter_compareGroups);
+
+   static const char* const suffixes[] = { "processes", "cpu_percent", "resident_bytes" };
+   static const char* const helps[] = { "Processes", "CPU usage of the processes", "Resident memory of the processes" };
+
+   for (size_t s = 0; s < ARRAYSIZE(suffixes); s++) {
+      char name[64];
+      char help[96];
+      xSnprintf(name, sizeof(name), "htop_%s_%s", kind, suffixes[s]);
+      xSnprintf(help, sizeof(help), "%s of each %s.", helps[s], kind);
+      Exporter_family(this, name, "gauge", help);
+
+      for (size_t i = 0; i < count; ) {
+         size_t end = i;
+         double cpu = 0.0;
+         unsigned long long resident = 0;
+         for (; end < count && String_eq(groups[end].name, groups[i].name); end++) {
+            const Process* proc = groups[end].proc;
+            if (isNonnegative(proc->percent_cpu))
+               cpu += proc->percent_cpu;
+            resident += (unsigned long long)proc->m_resident * ONE_K;
+         }
+
+         Exporter_label(this, label, groups[i].name);
+         if (s == 0)
+            Exporter_sampleCount(this, name, end - i);
+         else if (s == 1)
+            Exporter_sample(this, name, cpu);
+         else
+            Exporter_sampleCount(this, name, resident);
+
+         i = end;
+      }
+   }
+}
+
+static void Exporter_encode(Exporter* this, const Machine* host) {
+   Table* table = host->processTable;
+
+   this->body.len = 0;
+   Exporter_encodeMachine(this, host);
+
+#if defined(HTOP_LINUX) && !defined(HTOP_PCP)
+   Exporter_encodeLinux(this, (const LinuxMachine*) host);
+#endif
+
+   table->needsSort = true;
+   Table_updateDisplayList(table);
+
+   /* the processes left by the filters, threads are part of their process */
+   const int size = Vector_size(table->displayList);
+   const Process** procs = xMallocArray((size_t)MAXIMUM(size, 1), sizeof(Process*));
+   size_t count = 0;
+   for (int i = 0; i < size; i++) {
+      Row* row = (Row*) Vector_get(table->displayList, i);
+      const Process* proc = (const Process*) row;
+      if (!row->show || Row_matchesFilter(row, table) || Process_isUserlandThread(proc))
+         continue;
+      procs[count++] = proc;
+   }
+
+   size_t shown = this->maxRows > 0 ? MINIMUM(count, (size_t)this->maxRows) : count;
+   Exporter_encodeProcesses(this, procs, shown);
+
+   ExporterGroup* groups = xMallocArray(MAXIMUM(count, 1), sizeof(ExporterGroup));
+   size_t groupCount = 0;
+   for (size_t i = 0; i < count; i++) {
+      if (procs[i]->user)
+         groups[groupCount++] = (ExporterGroup) { .name = procs[i]->user, .proc = procs[i] };
+   }
+   Exporter_encodeGroups(this, "user", "user", groups, groupCount);
+
+#if defined(HTOP_LINUX) && !defined(HTOP_PCP)
+   groupCount = 0;
+   for (size_t i = 0; i < count; i++) {
+      const LinuxProcess* lp = (const LinuxProcess*) procs[i];
+      if (lp->cgroup && lp->cgroup->raw)
+         groups[groupCount++] = (ExporterGroup) { .name = lp->cgroup->raw, .proc = procs[i] };
+   }
+   if (groupCount)
+      Exporter_encodeGroups(this, "cgroup", "cgroup", groups, groupCount);
+#endif
+
+   free(groups);
+   free(procs);
+}
+
+static int Exporter_listen(const char* addr) {
+   char host[256] = "";
+   const char* port = addr;
+
+   const char* colon = strrchr(addr, ':');
+   if (colon) {
+      const char* start = addr;
+      size_t len = (size_t)(colon - addr);
+      /* [::1]:9100 */
+      if (len >= 2 && addr[0] == '[' && addr[len - 1] == ']') {
+         start++;
+         len -= 2;
+      }
+      String_safeStrncpy(host, start, MINIMUM(sizeof(host), len + 1));
+      port = colon + 1;
+   }
+
+   struct addrinfo hints;
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+   hints.ai_flags = AI_PASSIVE;
+
+   struct addrinfo* res;
+   int err = getaddrinfo(host[0] ? host : NULL, port, &hints, &res);
+   if (err != 0) {
+      fprintf(stderr, "Error: can not listen on %s: %s\n", addr, gai_strerror(err));
+      return -1;
+   }
+
+   int fd = -1;
+   int lastErrno = 0;
+   for (const struct addrinfo* ai = res; ai; ai = ai->ai_next) {
+      fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+      if (fd < 0) {
+         lastErrno = errno;
+         continue;
+      }
+
+      const int one = 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+      if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 16) == 0)
+         break;
+
+      lastErrno = errno;
+      close(fd);
+      fd = -1;
+   }
+   freeaddrinfo(res);
+
+   if (fd < 0)
+      fprintf(stderr, "Error: can not listen on %s: %s\n", addr, strerror(lastErrno));
+   return fd;
+}
+
+/* A response, written to the client as it takes it */
+static void Exporter_respond(ExporterClient* client, const char* status, const char* type, const char* body, size_t len) {
+   ExporterBuffer* out = &client->response;
+   out->len = 0;
+   Exporter_printf(out,
+      "HTTP/1.1 %s\r\n"
+      "Content-Type: %s\r\n"
+      "Content-Length: %zu\r\n"
+      "Connection: close\r\n"
+      "\r\n", status, type, len);
+   Exporter_putBytes(out, body, len);
+   client->sent = 0;
+}
+
+/* Answers a complete request; the metrics are encoded by the first scrape after a scan */
+static void Exporter_answer(Exporter* this, const Machine* host, ExporterClient* client) {
+   const char* request = client->request;
+
+   static const char notFound[] = "Not found, try /metrics\n";
+   static const char badMethod[] = "Only GET is served\n";
+
+   if (!String_startsWith(request, "GET ")) {
+      Exporter_respond(client, "405 Method Not Allowed", "text/plain", badMethod, sizeof(badMethod) - 1);
+      return;
+   }
+
+   const char* path = request + 4;
+   size_t pathLen = strcspn(path, " ?\r\n");
+   if (pathLen != strlen("/metrics") || strncmp(path, "/metrics", pathLen) != 0) {
+      Exporter_respond(client, "404 Not Found", "text/plain", notFound, sizeof(notFound) - 1);
+      return;
+   }
+
+   if (this->bodyScan != this->scans) {
+      Exporter_encode(this, host);
+      this->bodyScan = this->scans;
+   }
+
+   Exporter_respond(client, "200 OK", "text/plain; version=0.0.4; charset=utf-8", this->body.data, this->body.len);
+}
+
+static void Exporter_dropClient(Exporter* this, size_t i) {
+   close(this->clients[i].fd);
+   free(this->clients[i].response.data);
+   this->clients[i] = this->clients[--this->clientCount];
+}
+
+/* Takes the connections waiting, up to EXPORTER_CLIENTS_MAX; the others stay in the backlog */
+static void Exporter_accept(Exporter* this, uint64_t now) {
+   while (this->clientCount < EXPORTER_CLIENTS_MAX) {
+      int fd = accept(this->fd, NULL, NULL);
+      if (fd < 0) {
+         if (errno == EINTR)
+            continue;
+         return;
+      }
+
+      fcntl(fd, F_SETFD, FD_CLOEXEC);
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+      this->clients[this->clientCount++] = (ExporterClient) {
+         .fd = fd,
+         .deadlineMs = now + EXPORTER_CLIENT_TIMEOUT_MS,
+      };
+   }
+}
+
+/* Reads what came of the request, or writes what the client takes of the response; false once it is done with */
+static bool Exporter_progress(Exporter* this, const Machine* host, ExporterClient* client) {
+   if (client->response.len == 0) {
+      for (;;) {
+         ssize_t r = read(client->fd, client->request + client->requestLen, EXPORTER_REQUEST_MAX - client->requestLen);
+         if (r < 0 && errno == EINTR)
+            continue;
+         if (r < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+         if (r == 0)
+            return false;
+
+         client->requestLen += (size_t)r;
+         client->request[client->requestLen] = '\0';
+         if (strstr(client->request, "\r\n\r\n") || strstr(client->request, "\n\n") || client->requestLen == EXPORTER_REQUEST_MAX)
+            break;
+      }
+
+      Exporter_answer(this, host, client);
+   }
+
+   while (client->sent < client->response.len) {
+      ssize_t written = write(client->fd, client->response.data + client->sent, client->response.len - client->sent);
+      if (written < 0 && errno == EINTR)
+         continue;
+      if (written < 0)
+         return errno == EAGAIN || errno == EWOULDBLOCK;
+      client->sent += (size_t)written;
+   }
+   return false;
+}
+
+/*
+ * Serves scrapes until the monotonic time `until`. Clients are handled as
+ * their sockets become ready, so a slow scraper only holds its own
+ * response, and is dropped after EXPORTER_CLIENT_TIMEOUT_MS.
+ */
+static void Exporter_serve(Exporter* this, const Machine* host, uint64_t until) {
+   struct pollfd fds[EXPORTER_CLIENTS_MAX + 1];
+
+   for (;;) {
+      uint64_t now;
+      Platform_gettime_monotonic(&now);
+
+      for (size_t i = 0; i < this->clientCount; ) {
+         if (now >= this->clients[i].deadlineMs)
+            Exporter_dropClient(this, i);
+         else
+            i++;
+      }
+
+      if (now >= until || Exporter_stop)
+         return;
+
+      uint64_t wake = until;
+      nfds_t count = 0;
+      if (this->clientCount < EXPORTER_CLIENTS_MAX)
+         fds[count++] = (struct pollfd) { .fd = this->fd, .events = POLLIN };
+      const nfds_t first = count;
+      for (size_t i = 0; i < this->clientCount; i++) {
+         const ExporterClient* client = &this->clients[i];
+         fds[count++] = (struct pollfd) { .fd = client->fd, .events = client->response.len ? POLLOUT : POLLIN };
+         wake = MINIMUM(wake, client->deadlineMs);
+      }
+
+      int ready = poll(fds, count, (int)MINIMUM(wake - now, (uint64_t)INT_MAX));
+      if (ready <= 0)
+         continue;
+
+      /* from the last, as dropping a client moves the last one into its slot */
+      for (size_t i = this->clientCount; i-- > 0; ) {
+         if (fds[first + i].revents && !Exporter_progress(this, host, &this->clients[i]))
+            Exporter_dropClient(this, i);
+      }
+
+      if (first && (fds[0].revents & POLLIN))
+         Exporter_accept(this, now);
+   }
+}
+
+static void Exporter_handleSignal(ATTR_UNUSED int sgn) {
+   Exporter_stop = 1;
+}
+
+bool Exporter_run(Machine* host, const char* addr, int maxRows) {
+   Exporter exporter = {
+      .fd = Exporter_listen(addr),
+      .maxRows = maxRows,
+   };
+   if (exporter.fd < 0)
+      return false;
+
+   fcntl(exporter.fd, F_SETFL, fcntl(exporter.fd, F_GETFL) | O_NONBLOCK);
+   exporter.clients = xCalloc(EXPORTER_CLIENTS_MAX, sizeof(ExporterClient));
+
+   /*
+    * Processes are ranked by the sort key of the screen and nothing is on
+    * screen to read lazily. The scans go by a copy of the settings made so,
+    * the ones of the user stay as they are.
+    */
+   Settings* userSettings = host->settings;
+   Settings exporterSettings = *userSettings;
+   ScreenSettings exporterScreen = *userSettings->ss;
+   exporterSettings.ss = &exporterScreen;
+   exporterSettings.highlightChanges = false;
+   exporterSettings.lazyCollection = false;
+   exporterScreen.treeView = false;
+#if defined(HTOP_LINUX) && !defined(HTOP_PCP)
+   exporterScreen.flags |= PROCESS_FLAG_LINUX_CGROUP;
+#endif
+   const Settings* settings = &exporterSettings;
+   host->settings = &exporterSettings;
+   /* exported without a meter */
+   host->activeCollectors = MACHINE_COLLECTORS_ALL;
+   CRT_initHeadless();
+
+   struct sigaction act;
+   memset(&act, 0, sizeof(act));
+   act.sa_handler = Exporter_handleSignal;
+   sigemptyset(&act.sa_mask);
+   sigaction(SIGINT, &act, NULL);
+   sigaction(SIGTERM, &act, NULL);
+   sigaction(SIGHUP, &act, NULL);
+
+   /* a scraper hanging up must not end the exporter */
+   act.sa_handler = SIG_IGN;
+   sigaction(SIGPIPE, &act, NULL);
+
+   const uint64_t interval = MAXIMUM(100 * (uint64_t)settings->delay, 100);
+
+   /* the first scan gives no CPU usage yet */
+   Machine_scan(host);
+   Machine_scanTables(host);
+
+   uint64_t next;
+   Platform_gettime_monotonic(&next);
+
+   while (!Exporter_stop && host->iterationsRemaining != 0) {
+      next += interval;
+
+      /* serve scrapes until the next scan is due */
+      Exporter_serve(&exporter, host, next);
+      if (Exporter_stop)
+         break;
+
+      /* behind after a stall, do not catch up with a burst of scans */
+      uint64_t now;
+      Platform_gettime_monotonic(&now);
+      if (now - next > interval)
+         next = now;
+
+      Platform_gettime_realtime(&host->realtime, &host->realtimeMs);
+      Machine_scan(host);
+      Machine_scanTables(host);
+      exporter.scans++;
+
+      if (host->iterationsRemaining > 0)
+         host->iterationsRemaining--;
+   }
+
+   while (exporter.clientCount > 0)
+      Exporter_dropClient(&exporter, 0);
+   free(exporter.clients);
+   close(exporter.fd);
+   free(exporter.body.data);
+   free(exporter.labels.data);
+
+   host->settings = userSettings;
+   return true;
+}
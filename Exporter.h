@@ -0,0 +1,24 @@
+#ifndef HEADER_Exporter
+#define HEADER_Exporter
+/*
+htop - Exporter.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+
+#include "Machine.h"
+
+
+/*
+ * Scans at the configured delay and serves the latest scan as Prometheus
+ * metrics on http://ADDR/metrics until SIGINT or SIGTERM. ADDR is
+ * [HOST:]PORT; the metrics are only encoded when they are scraped. Only
+ * the first `maxRows` processes of the active screen get metrics of
+ * their own, unless it is 0. False if ADDR can not be listened on.
+ */
+bool Exporter_run(Machine* host, const char* addr, int maxRows);
+
+#endif
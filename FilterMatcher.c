@@ -0,0 +1,181 @@
+/*
+htop - FilterMatcher.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "FilterMatcher.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "XUtils.h"
+
+
+#define FILTERMATCHER_NO_STATE UINT_MAX
+
+static inline unsigned char FilterMatcher_fold(unsigned char c) {
+   return (c >= 'A' && c <= 'Z') ? (unsigned char)(c - 'A' + 'a') : c;
+}
+
+static void FilterMatcher_free(FilterMatcher* this) {
+   free(this->pattern);
+   free(this->next);
+   free(this->accepting);
+   this->pattern = NULL;
+   this->next = NULL;
+   this->accepting = NULL;
+   this->matchesAll = false;
+}
+
+void FilterMatcher_done(FilterMatcher* this) {
+   FilterMatcher_free(this);
+}
+
+/* Builds the Aho-Corasick automaton of the alternatives, with the failure links folded into the transitions */
+static void FilterMatcher_compile(FilterMatcher* this, const char* pattern) {
+   /* like String_contains_i, only a pattern with a '|' has alternatives */
+   const bool multi = strchr(pattern, '|') != NULL;
+
+   const size_t maxStates = strlen(pattern) + 1;
+   unsigned int* next = xMallocArray(maxStates * 256, sizeof(unsigned int));
+   bool* accepting = xCalloc(maxStates, sizeof(bool));
+   for (size_t i = 0; i < maxStates * 256; i++)
+      next[i] = FILTERMATCHER_NO_STATE;
+
+   unsigned int states = 1;
+   const char* alt = pattern;
+   for (;;) {
+      const size_t len = multi ? strcspn(alt, "|") : strlen(alt);
+      const bool last = alt[len] == '\0';
+
+      if (len == 0) {
+         /* String_split only drops an empty last alternative */
+         if (!last || !multi)
+            this->matchesAll = true;
+      } else {
+         unsigned int state = 0;
+         for (size_t i = 0; i < len; i++) {
+            unsigned int* t = &next[state * 256 + FilterMatcher_fold((unsigned char)alt[i])];
+            if (*t == FILTERMATCHER_NO_STATE)
+               *t = states++;
+            state = *t;
+         }
+         accepting[state] = true;
+      }
+
+      if (last)
+         break;
+      alt += len + 1;
+   }
+
+   /* breadth first, so the failure state of each state is complete before it */
+   unsigned int* fail = xCalloc(states, sizeof(unsigned int));
+   unsigned int* queue = xMallocArray(states, sizeof(unsigned int));
+   size_t head = 0;
+   size_t tail = 0;
+
+   for (unsigned int c = 0; c < 256; c++) {
+      unsigned int* t = &next[c];
+      if (*t == FILTERMATCHER_NO_STATE) {
+         *t = 0;
+      } else {
+         fail[*t] = 0;
+         queue[tail++] = *t;
+      }
+   }
+
+   while (head < tail) {
+      const unsigned int state = queue[head++];
+      const unsigned int* failNext = &next[fail[state] * 256];
+      accepting[state] |= accepting[fail[state]];
+
+      for (unsigned int c = 0; c < 256; c++) {
+         unsigned int* t = &next[state * 256 + c];
+         if (*t == FILTERMATCHER_NO_STATE) {
+            *t = failNext[c];
+         } else {
+            fail[*t] = failNext[c];
+            queue[tail++] = *t;
+         }
+      }
+   }
+
+   free(queue);
+   free(fail);
+
+   this->next = xReallocArray(next, (size_t)states * 256, sizeof(unsigned int));
+   this->accepting = accepting;
+}
+
+/* Typing on at the end of the last alternative only finds fewer texts; a new alternative finds more */
+static bool FilterMatcher_narrows(const char* old, const char* pattern) {
+   if (!old || !pattern || !old[0])
+      return false;
+
+   const size_t len = strlen(old);
+   return old[len - 1] != '|' && String_startsWith(pattern, old) && !strchr(pattern + len, '|');
+}
+
+bool FilterMatcher_update(FilterMatcher* this, const char* pattern) {
+   if (pattern ? (this->pattern && String_eq(this->pattern, pattern)) : !this->pattern)
+      return false;
+
+   const bool narrows = FilterMatcher_narrows(this->pattern, pattern);
+
+   FilterMatcher_free(this);
+   if (pattern) {
+      this->pattern = xStrdup(pattern);
+      FilterMatcher_compile(this, pattern);
+   }
+
+   if (++this->generation == 0)
+      this->generation = 1;
+   if (!narrows)
+      this->narrowedSince = this->generation;
+   return true;
+}
+
+bool FilterMatcher_narrowedSince(const FilterMatcher* this, unsigned int generation) {
+   return generation != 0 && this->generation - generation <= this->generation - this->narrowedSince;
+}
+
+bool FilterMatcher_matches(const FilterMatcher* this, const char* text) {
+   if (!this->pattern || this->matchesAll)
+      return true;
+   if (!text)
+      return false;
+
+   const unsigned int* next = this->next;
+   const bool* accepting = this->accepting;
+   unsigned int state = 0;
+   for (const unsigned char* c = (const unsigned char*) text; *c; c++) {
+      state = next[state * 256 + FilterMatcher_fold(*c)];
+      if (accepting[state])
+         return true;
+   }
+   return false;
+}
+
+const char* FilterMatcher_find(const FilterMatcher* this, const char* text, size_t len) {
+   assert(!FilterMatcher_matchesAny(this));
+
+   const unsigned int* next = this->next;
+   const bool* accepting = this->accepting;
+   const unsigned char* c = (const unsigned char*) text;
+
+   /* no alternative holds a '\0', it leads back to the start state */
+   unsigned int state = 0;
+   for (size_t i = 0; i < len; i++) {
+      state = next[state * 256 + FilterMatcher_fold(c[i])];
+      if (accepting[state])
+         return text + i;
+   }
+
+   return NULL;
+}
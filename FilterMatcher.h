@@ -0,0 +1,54 @@
+#ifndef HEADER_FilterMatcher
+#define HEADER_FilterMatcher
+/*
+htop - FilterMatcher.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/*
+ * A filter compiled into an automaton that finds any of its `|` separated
+ * alternatives, ignoring ASCII case, in a single pass over the text. It
+ * matches the same texts as String_contains_i(text, pattern, true).
+ */
+typedef struct FilterMatcher_ {
+   char* pattern;             /* compiled filter, NULL if there is none */
+   unsigned int generation;   /* incremented whenever the pattern changes, never 0 */
+   unsigned int narrowedSince;  /* generation since which each change only extended the last alternative */
+   bool matchesAll;           /* an empty alternative is found in any text */
+   unsigned int* next;        /* states x 256 transitions over case folded bytes, state 0 is the start */
+   bool* accepting;           /* states that end an alternative */
+} FilterMatcher;
+
+void FilterMatcher_done(FilterMatcher* this);
+
+/* Compiles `pattern` (NULL for no filter) unless it is the one compiled; true if it changed */
+bool FilterMatcher_update(FilterMatcher* this, const char* pattern);
+
+/*
+ * Whether each change since `generation` only narrowed the pattern, so a
+ * text that did not match the pattern of that generation can not match now
+ */
+bool FilterMatcher_narrowedSince(const FilterMatcher* this, unsigned int generation);
+
+/* Whether any alternative of the compiled pattern occurs in `text`, true if there is no pattern */
+bool FilterMatcher_matches(const FilterMatcher* this, const char* text);
+
+/* Whether the compiled pattern leaves no text out */
+static inline bool FilterMatcher_matchesAny(const FilterMatcher* this) {
+   return !this->pattern || this->matchesAll;
+}
+
+/*
+ * Where the first alternative found in the `len` bytes at `text` ends, NULL
+ * if none is; the bytes may hold several texts separated by '\0', no
+ * alternative is found across them. Only for a pattern that can leave texts out.
+ */
+const char* FilterMatcher_find(const FilterMatcher* this, const char* text, size_t len);
+
+#endif
@@ -7,6 +7,8 @@ in the source distribution for its full text.
 
 #include "config.h" // IWYU pragma: keep
 
+#define HEAP_CLASS HEAP_HASHTABLES
+
 #include "Hashtable.h"
 
 #include <assert.h>
@@ -131,6 +131,26 @@ void Header_populateFromSettings(Header* this) {
    }
 
    Header_calculateHeight(this);
+   Header_updateCollectors(this);
+}
+
+void Header_updateCollectors(const Header* this) {
+   Machine* host = this->host;
+   if (!host->collectors)
+      return;
+
+   unsigned int active = 0;
+   for (unsigned int i = 0; host->collectors[i].name; i++) {
+      Header_forEachColumn(this, col) {
+         const Vector* meters = this->columns[col];
+         for (int j = 0; j < Vector_size(meters); j++) {
+            const Meter* meter = (const Meter*) Vector_get(meters, j);
+            if (Machine_collectorReadBy(host, i, As_Meter(meter)))
+               active |= 1U << i;
+         }
+      }
+   }
+   host->activeCollectors = active;
 }
 
 void Header_writeBackToSettings(const Header* this) {
@@ -192,12 +212,41 @@ void Header_reinit(Header* this) {
    }
 }
 
-void Header_draw(const Header* this) {
+/* Identifies where the meters go: the screen width, the layout and the meters of each column */
+static uint64_t Header_layoutKey(const Header* this) {
+   uint64_t key = (uint64_t)COLS << 48 ^ (uint64_t)this->height << 32 ^ (uint64_t)this->pad << 16 ^ (uint64_t)this->headerLayout;
+   Header_forEachColumn(this, col) {
+      const Vector* meters = this->columns[col];
+      key = key * 31 + (uint64_t)Vector_size(meters);
+      for (int i = 0; i < Vector_size(meters); i++) {
+         const Meter* meter = (const Meter*) Vector_get(meters, i);
+         key = key * 31 + (uint64_t)(uintptr_t)meter;
+         key = key * 31 + (uint64_t)meter->h;
+         key = key * 31 + (uint64_t)meter->columnWidthCount;
+      }
+   }
+   return key;
+}
+
+void Header_draw(Header* this, bool force) {
    const int height = this->height;
    const int pad = this->pad;
+
+#ifdef HAVE_IS_CLEARED
+   /* meters not drawn again are only still shown if nothing cleared the screen since */
+   force |= is_cleared(stdscr);
+#else
+   force = true;
+#endif
+   const uint64_t layout = Header_layoutKey(this);
+   force |= layout != this->drawnLayout;
+   this->drawnLayout = layout;
+
    attrset(CRT_colors[RESET_COLOR]);
-   for (int y = 0; y < height; y++) {
-      mvhline(y, 0, ' ', COLS);
+   if (force) {
+      for (int y = 0; y < height; y++) {
+         mvhline(y, 0, ' ', COLS);
+      }
    }
    const int numCols = HeaderLayout_getColumns(this->headerLayout);
    const int width = COLS - 2 * pad - (numCols - 1);
@@ -228,8 +277,19 @@ void Header_draw(const Header* this) {
             }
          }
 
-         assert(meter->draw);
-         meter->draw(meter, x, y, floorf(actualWidth));
+         const int w = floorf(actualWidth);
+         const bool changed = Meter_drawChanged(meter, x, y, w);
+         if (force || changed) {
+            if (!force) {
+               attrset(CRT_colors[RESET_COLOR]);
+               for (int line = 0; line < meter->h; line++) {
+                  mvhline(y + line, x, ' ', w);
+               }
+            }
+
+            assert(meter->draw);
+            meter->draw(meter, x, y, w);
+         }
          y += meter->h;
       }
 
@@ -244,7 +304,7 @@ void Header_updateData(Header* this) {
       int items = Vector_size(meters);
       for (int i = 0; i < items; i++) {
          Meter* meter = (Meter*) Vector_get(meters, i);
-         Meter_updateValues(meter);
+         Meter_update(meter);
       }
    }
 }
@@ -7,7 +7,9 @@ Released under the GNU GPLv2+, see the COPYING file
 in the source distribution for its full text.
 */
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include "HeaderLayout.h"
 #include "Machine.h"
@@ -21,6 +23,7 @@ typedef struct Header_ {
    HeaderLayout headerLayout;
    int pad;
    int height;
+   uint64_t drawnLayout;   /* where the meters were last drawn, to draw only changed ones while it holds */
 } Header;
 
 #define Header_forEachColumn(this_, i_) for (size_t (i_)=0, H_fEC_numColumns_ = HeaderLayout_getColumns((this_)->headerLayout); (i_) < H_fEC_numColumns_; ++(i_))
@@ -33,13 +36,17 @@ void Header_setLayout(Header* this, HeaderLayout hLayout);
 
 void Header_populateFromSettings(Header* this);
 
+/* Lets Machine_scan() skip the collectors none of the meters reads, after they changed */
+void Header_updateCollectors(const Header* this);
+
 void Header_writeBackToSettings(const Header* this);
 
 Meter* Header_addMeterByClass(Header* this, const MeterClass* type, unsigned int param, unsigned int column);
 
 void Header_reinit(Header* this);
 
-void Header_draw(const Header* this);
+/* Draws the meters that changed since they were last drawn, or all of them if forced */
+void Header_draw(Header* this, bool force);
 
 void Header_updateData(Header* this);
 
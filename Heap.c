@@ -0,0 +1,157 @@
+/*
+htop - Heap.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "Heap.h"
+
+#ifdef HEAP_ACCOUNTING
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "XUtils.h"
+
+
+typedef struct HeapBlock_ {
+   const void* ptr;
+   size_t size;
+   HeapClass heapClass;
+} HeapBlock;
+
+const char* const Heap_classNames[HEAP_CLASSES] = {
+   [HEAP_OTHER] = "other",
+   [HEAP_PROCESSES] = "processes",
+   [HEAP_STRINGS] = "strings",
+   [HEAP_VECTORS] = "vectors",
+   [HEAP_HASHTABLES] = "hashtables",
+   [HEAP_GRAPHS] = "meter graphs",
+};
+
+/* The live blocks, open addressed by address and at most half full; the
+   scanner threads allocate too, so all of it is taken under the lock */
+static HeapBlock* Heap_blocks;
+static size_t Heap_slots;
+static size_t Heap_count;
+static HeapStats Heap_classStats[HEAP_CLASSES];
+static pthread_mutex_t Heap_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t Heap_slotOf(const void* ptr) {
+   uint64_t h = (uint64_t)(uintptr_t)ptr >> 4;
+   h *= UINT64_C(0x9E3779B97F4A7C15);
+   return (size_t)(h >> 32) & (Heap_slots - 1);
+}
+
+static void Heap_place(HeapBlock block) {
+   size_t i = Heap_slotOf(block.ptr);
+   while (Heap_blocks[i].ptr)
+      i = (i + 1) & (Heap_slots - 1);
+   Heap_blocks[i] = block;
+}
+
+static void Heap_grow(void) {
+   HeapBlock* old = Heap_blocks;
+   const size_t oldSlots = Heap_slots;
+
+   /* plain calloc and free, the wrappers would account the table itself */
+   Heap_slots = oldSlots ? 2 * oldSlots : 4096;
+   Heap_blocks = calloc(Heap_slots, sizeof(HeapBlock));
+   if (!Heap_blocks)
+      fail();
+
+   for (size_t i = 0; i < oldSlots; i++) {
+      if (old[i].ptr) {
+         Heap_place(old[i]);
+      }
+   }
+   (free)(old);
+}
+
+/* Takes the block out of the table, returning it with ptr NULL if absent */
+static HeapBlock Heap_remove(const void* ptr) {
+   HeapBlock found = { .ptr = NULL };
+   if (!Heap_slots)
+      return found;
+
+   size_t i = Heap_slotOf(ptr);
+   while (Heap_blocks[i].ptr && Heap_blocks[i].ptr != ptr)
+      i = (i + 1) & (Heap_slots - 1);
+   if (!Heap_blocks[i].ptr)
+      return found;
+
+   found = Heap_blocks[i];
+   Heap_count--;
+
+   /* backward shift deletion: move up the following blocks that probed past the hole */
+   size_t hole = i;
+   for (size_t j = (i + 1) & (Heap_slots - 1); Heap_blocks[j].ptr; j = (j + 1) & (Heap_slots - 1)) {
+      const size_t home = Heap_slotOf(Heap_blocks[j].ptr);
+      const bool movable = hole <= j ? (home <= hole || home > j) : (home <= hole && home > j);
+      if (movable) {
+         Heap_blocks[hole] = Heap_blocks[j];
+         hole = j;
+      }
+   }
+   Heap_blocks[hole].ptr = NULL;
+
+   return found;
+}
+
+static void Heap_account(HeapBlock block) {
+   HeapStats* stats = &Heap_classStats[block.heapClass];
+   stats->liveBytes -= block.size;
+   stats->liveBlocks--;
+}
+
+void Heap_track(void* ptr, size_t size, HeapClass heapClass) {
+   if (!ptr)
+      return;
+
+   pthread_mutex_lock(&Heap_lock);
+
+   /* a block reallocated behind the wrappers' back may still be listed */
+   HeapBlock stale = Heap_remove(ptr);
+   if (stale.ptr)
+      Heap_account(stale);
+
+   if (2 * (Heap_count + 1) > Heap_slots)
+      Heap_grow();
+
+   Heap_place((HeapBlock) { .ptr = ptr, .size = size, .heapClass = heapClass });
+   Heap_count++;
+
+   HeapStats* stats = &Heap_classStats[heapClass];
+   stats->liveBytes += size;
+   stats->liveBlocks++;
+   stats->allocations++;
+   if (stats->liveBytes > stats->peakBytes)
+      stats->peakBytes = stats->liveBytes;
+
+   pthread_mutex_unlock(&Heap_lock);
+}
+
+void Heap_forget(const void* ptr) {
+   if (!ptr)
+      return;
+
+   pthread_mutex_lock(&Heap_lock);
+   HeapBlock block = Heap_remove(ptr);
+   if (block.ptr)
+      Heap_account(block);
+   pthread_mutex_unlock(&Heap_lock);
+}
+
+void Heap_stats(HeapStats stats[HEAP_CLASSES]) {
+   pthread_mutex_lock(&Heap_lock);
+   memcpy(stats, Heap_classStats, sizeof(Heap_classStats));
+   pthread_mutex_unlock(&Heap_lock);
+}
+
+#endif /* HEAP_ACCOUNTING */
@@ -0,0 +1,52 @@
+#ifndef HEADER_Heap
+#define HEADER_Heap
+/*
+htop - Heap.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*
+ * Heap accounting of builds configured with --enable-heap-accounting: the
+ * allocation wrappers of XUtils account each block to the class of its call
+ * site, a file allocating for one defining HEAP_CLASS before its includes.
+ * Strings made by the string functions are always HEAP_STRINGS.
+ */
+typedef enum HeapClass_ {
+   HEAP_OTHER,
+   HEAP_PROCESSES,
+   HEAP_STRINGS,
+   HEAP_VECTORS,
+   HEAP_HASHTABLES,
+   HEAP_GRAPHS,
+   HEAP_CLASSES
+} HeapClass;
+
+#ifdef HEAP_ACCOUNTING
+
+typedef struct HeapStats_ {
+   size_t liveBytes;
+   size_t liveBlocks;
+   size_t peakBytes;
+   uint64_t allocations;
+} HeapStats;
+
+extern const char* const Heap_classNames[HEAP_CLASSES];
+
+/* Accounts a block just allocated, or the new place of one reallocated */
+void Heap_track(void* ptr, size_t size, HeapClass heapClass);
+
+/* Forgets a block about to be freed or reallocated; blocks not tracked are ignored */
+void Heap_forget(const void* ptr);
+
+/* Copies the statistics of all classes */
+void Heap_stats(HeapStats stats[HEAP_CLASSES]);
+
+#endif
+
+#endif
@@ -0,0 +1,195 @@
+/*
+htop - History.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#define HEAP_CLASS HEAP_GRAPHS
+
+#include "History.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Macros.h"
+#include "Meter.h"
+#include "XUtils.h"
+
+
+/* Histories per slab, 64 KiB */
+#define HISTORY_SLAB_SIZE 1024
+
+typedef union HistoryBlock_ {
+   History history;
+   union HistoryBlock_* nextFree;
+} HistoryBlock;
+
+static struct {
+   HistoryBlock* free;
+   HistoryBlock** slabs;
+   size_t slabCount;
+   size_t used;
+} History_pool;
+
+History* History_new(void) {
+   if (!History_pool.free) {
+      HistoryBlock* slab = xMallocArray(HISTORY_SLAB_SIZE, sizeof(HistoryBlock));
+      for (size_t i = 0; i < HISTORY_SLAB_SIZE; i++)
+         slab[i].nextFree = i + 1 < HISTORY_SLAB_SIZE ? &slab[i + 1] : NULL;
+
+      History_pool.slabs = xReallocArray(History_pool.slabs, History_pool.slabCount + 1, sizeof(HistoryBlock*));
+      History_pool.slabs[History_pool.slabCount++] = slab;
+      History_pool.free = slab;
+   }
+
+   HistoryBlock* block = History_pool.free;
+   History_pool.free = block->nextFree;
+   History_pool.used++;
+
+   memset(block, 0, sizeof(*block));
+   return &block->history;
+}
+
+void History_delete(History* this) {
+   if (!this)
+      return;
+
+   HistoryBlock* block = (HistoryBlock*) this;
+   block->nextFree = History_pool.free;
+   History_pool.free = block;
+   History_pool.used--;
+}
+
+void History_releasePool(void) {
+   assert(History_pool.used == 0);
+
+   for (size_t i = 0; i < History_pool.slabCount; i++)
+      free(History_pool.slabs[i]);
+
+   free(History_pool.slabs);
+   memset(&History_pool, 0, sizeof(History_pool));
+}
+
+void History_add(History* this, uint8_t sample) {
+   this->samples[this->next] = sample;
+   this->next = (uint8_t)((this->next + 1) % HISTORY_SAMPLES);
+   if (this->count < HISTORY_SAMPLES)
+      this->count++;
+}
+
+void History_addScaled(History* this, unsigned long long value) {
+   while ((value >> this->shift) > UINT8_MAX && this->shift < 63) {
+      this->shift++;
+      for (size_t i = 0; i < HISTORY_SAMPLES; i++)
+         this->samples[i] >>= 1;
+   }
+
+   History_add(this, (uint8_t)(value >> this->shift));
+}
+
+/* Sample i, counting from the oldest one kept */
+static inline uint8_t History_sample(const History* this, unsigned int i) {
+   return this->samples[(this->next + HISTORY_SAMPLES - this->count + i) % HISTORY_SAMPLES];
+}
+
+unsigned int History_sum(const History* this) {
+   unsigned int sum = 0;
+   for (unsigned int i = 0; i < this->count; i++)
+      sum += History_sample(this, i);
+   return sum;
+}
+
+/* Dots high of a sample, any sample above zero showing at least one */
+static inline int History_pixels(unsigned int sample, unsigned int full, int pixPerRow) {
+   if (sample == 0 || full == 0)
+      return 0;
+   return (int)MINIMUM((sample * (unsigned int)pixPerRow + full - 1) / full, (unsigned int)pixPerRow);
+}
+
+void History_writeSparkline(const History* this, RichString* str, int attr, bool relative) {
+   int pixPerRow;
+   const char* const* glyphs = GraphMeterMode_glyphs(&pixPerRow);
+
+   unsigned int full = UINT8_MAX;
+   if (relative) {
+      full = 0;
+      for (unsigned int i = 0; i < this->count; i++)
+         full = MAXIMUM(full, (unsigned int)History_sample(this, i));
+   }
+
+   /* the shown samples end with the newest one, those before the first are blank */
+   const unsigned int shown = HISTORY_SPARKLINE_WIDTH * 2;
+   const unsigned int first = this->count > shown ? this->count - shown : 0;
+   const unsigned int missing = shown - (this->count - first);
+   for (unsigned int i = 0; i < shown; i += 2) {
+      int pixels[2];
+      for (unsigned int j = 0; j < 2; j++)
+         pixels[j] = i + j < missing ? 0 : History_pixels(History_sample(this, first + i + j - missing), full, pixPerRow);
+
+      RichString_appendWide(str, attr, glyphs[pixels[0] * (pixPerRow + 1) + pixels[1]]);
+   }
+   RichString_appendAscii(str, attr, " ");
+}
+
+Trend* Trend_new(void) {
+   Trend* this = xCalloc(1, sizeof(Trend));
+   this->slope = NAN;
+   return this;
+}
+
+void Trend_delete(Trend* this) {
+   free(this);
+}
+
+static void Trend_fit(Trend* this) {
+   this->slope = NAN;
+   if (this->count < 3)
+      return;
+
+   /* relative to the oldest sample, the sums stay small */
+   const unsigned int oldest = (this->next + TREND_SAMPLES - this->count) % TREND_SAMPLES;
+   double meanX = 0.0;
+   double meanY = 0.0;
+   for (unsigned int i = 0; i < this->count; i++) {
+      const unsigned int k = (oldest + i) % TREND_SAMPLES;
+      meanX += (double)(this->times[k] - this->times[oldest]);
+      meanY += (double)this->values[k] - (double)this->values[oldest];
+   }
+   meanX /= this->count;
+   meanY /= this->count;
+
+   double sxy = 0.0;
+   double sxx = 0.0;
+   for (unsigned int i = 0; i < this->count; i++) {
+      const unsigned int k = (oldest + i) % TREND_SAMPLES;
+      const double dx = (double)(this->times[k] - this->times[oldest]) - meanX;
+      const double dy = (double)this->values[k] - (double)this->values[oldest] - meanY;
+      sxy += dx * dy;
+      sxx += dx * dx;
+   }
+
+   if (sxx > 0.0)
+      this->slope = sxy / sxx;
+}
+
+void Trend_add(Trend* this, uint32_t now, uint64_t value, uint32_t window) {
+   if (this->count > 0) {
+      const uint32_t last = this->times[(this->next + TREND_SAMPLES - 1) % TREND_SAMPLES];
+      if (now - last < window / TREND_SAMPLES)
+         return;
+   }
+
+   this->times[this->next] = now;
+   this->values[this->next] = value;
+   this->next = (uint8_t)((this->next + 1) % TREND_SAMPLES);
+   if (this->count < TREND_SAMPLES)
+      this->count++;
+
+   Trend_fit(this);
+}
@@ -0,0 +1,81 @@
+#ifndef HEADER_History
+#define HEADER_History
+/*
+htop - History.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "RichString.h"
+
+
+/* Samples kept per history, making it 64 bytes with the header */
+#define HISTORY_SAMPLES 61
+
+/* Glyphs of a sparkline, two samples each */
+#define HISTORY_SPARKLINE_WIDTH (HISTORY_SAMPLES / 2)
+
+/*
+ * The last samples of a value of a row, quantized to a byte each. Values
+ * above the byte range are stored shifted right by `shift`, which grows
+ * (halving the older samples) as larger values come in.
+ */
+typedef struct History_ {
+   uint8_t next;                       /* slot the next sample goes to */
+   uint8_t count;                      /* samples taken, up to HISTORY_SAMPLES */
+   uint8_t shift;
+   uint8_t samples[HISTORY_SAMPLES];
+} History;
+
+/* Takes a zeroed history from a pool of slabs, sparing the allocator overhead of small blocks */
+History* History_new(void);
+
+void History_delete(History* this);
+
+/* Frees the slabs of the pool, once all histories are deleted */
+void History_releasePool(void);
+
+/* Adds a sample in the range 0 to 255 */
+void History_add(History* this, uint8_t sample);
+
+/* Adds a sample of any size, raising the shift as needed */
+void History_addScaled(History* this, unsigned long long value);
+
+/* Sum of the samples, for sorting */
+unsigned int History_sum(const History* this);
+
+/*
+ * Writes the newest samples as a sparkline of HISTORY_SPARKLINE_WIDTH glyphs
+ * and a space, the newest on the right. Full height is 255, or the largest
+ * sample kept if `relative` is set. Missing samples are blank.
+ */
+void History_writeSparkline(const History* this, RichString* str, int attr, bool relative);
+
+/* Samples kept by a trend, spread evenly over its window */
+#define TREND_SAMPLES 16
+
+/*
+ * Samples of a value over a long window, for its slope. A sample is only
+ * taken once the last one is a sixteenth of the window old, and the slope
+ * is fitted by least squares, so short spikes move it little.
+ */
+typedef struct Trend_ {
+   uint8_t next;
+   uint8_t count;
+   uint32_t times[TREND_SAMPLES];      /* seconds of the monotonic clock */
+   uint64_t values[TREND_SAMPLES];
+   double slope;                       /* per second, NAN until three samples are taken */
+} Trend;
+
+Trend* Trend_new(void);
+
+void Trend_delete(Trend* this);
+
+/* Takes a sample at `now` (in seconds) if the last one is `window` / TREND_SAMPLES old */
+void Trend_add(Trend* this, uint32_t now, uint64_t value, uint32_t window);
+
+#endif
@@ -0,0 +1,174 @@
+/*
+htop - HtopCollect.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "HtopCollect.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "CRT.h"
+#include "DynamicColumn.h"
+#include "DynamicMeter.h"
+#include "DynamicScreen.h"
+#include "Hashtable.h"
+#include "Machine.h"
+#include "Macros.h"
+#include "Platform.h"
+#include "Process.h"
+#include "ProcessTable.h"
+#include "Settings.h"
+#include "Table.h"
+#include "UsersTable.h"
+#include "Vector.h"
+#include "XUtils.h"
+
+
+/* Named in the messages of a crash; htop and its helpers have their own */
+const char* program = "htop-collect";
+
+struct HtopCollector_ {
+   UsersTable* usersTable;
+   Hashtable* dynamicMeters;
+   Hashtable* dynamicColumns;
+   Hashtable* dynamicScreens;
+   Machine* host;
+   Settings* settings;
+   uint64_t baseFlags;             /* of the default columns */
+};
+
+static bool HtopCollector_exists;
+
+HtopCollector* HtopCollector_new(uint64_t flags, bool withThreads) {
+   if (HtopCollector_exists || !Platform_init())
+      return NULL;
+
+   HtopCollector_exists = true;
+
+   HtopCollector* this = xCalloc(1, sizeof(HtopCollector));
+   this->usersTable = UsersTable_new();
+   this->dynamicMeters = DynamicMeters_new();
+   this->dynamicColumns = DynamicColumns_new();
+   this->dynamicScreens = DynamicScreens_new();
+
+   Machine* host = this->host = Machine_new(this->usersTable, (uid_t)-1);
+   ProcessTable* pt = ProcessTable_new(host, NULL);
+   Settings* settings = this->settings = Settings_newDefault(host->activeCPUs, this->dynamicMeters, this->dynamicColumns, this->dynamicScreens);
+   Machine_populateTablesFromSettings(host, settings, &pt->super);
+
+   /* nothing is drawn, but the rows still get attributes for their command */
+   CRT_initHeadless();
+
+   settings->hideKernelThreads = false;
+   settings->hideUserlandThreads = !withThreads;
+   settings->highlightChanges = false;
+   settings->lazyCollection = false;
+#ifdef HAVE_PROC_CONNECTOR
+   settings->procConnector = false;
+#endif
+
+   this->baseFlags = settings->ss->flags;
+   HtopCollector_setFlags(this, flags);
+
+   return this;
+}
+
+void HtopCollector_setFlags(HtopCollector* this, uint64_t flags) {
+   this->settings->ss->flags = this->baseFlags | flags;
+}
+
+static int HtopCollectProcess_compareByPid(const void* v1, const void* v2) {
+   const HtopCollectProcess* p1 = (const HtopCollectProcess*) v1;
+   const HtopCollectProcess* p2 = (const HtopCollectProcess*) v2;
+   return SPACESHIP_NUMBER(p1->pid, p2->pid);
+}
+
+static void HtopCollectProcess_set(HtopCollectProcess* this, const Process* p) {
+   this->pid = Process_getPid(p);
+   this->ppid = Process_getParent(p);
+   this->tgid = Process_getThreadGroup(p);
+   this->uid = p->st_uid;
+   this->state = Process_stateChar(p->state);
+   this->kernelThread = Process_isKernelThread(p);
+   this->userlandThread = Process_isUserlandThread(p);
+   this->priority = p->priority;
+   this->nice = p->nice;
+   this->threads = p->nlwp;
+   this->cpuPercent = p->percent_cpu;
+   this->memPercent = p->percent_mem;
+   this->residentKB = p->m_resident > 0 ? (unsigned long long)p->m_resident : 0;
+   this->virtualKB = p->m_virt > 0 ? (unsigned long long)p->m_virt : 0;
+   this->timeCs = p->time;
+   this->startTime = p->starttime_ctime;
+
+   /* the name of the executable, from the command line if the platform has none of its own */
+   const char* cmdline = p->cmdline ? p->cmdline : "";
+   if (p->procComm) {
+      xSnprintf(this->comm, sizeof(this->comm), "%.*s", (int)sizeof(this->comm) - 1, p->procComm);
+   } else {
+      const int start = CLAMP(p->cmdlineBasenameStart, 0, (int)strlen(cmdline));
+      const int end = CLAMP(p->cmdlineBasenameEnd, start, (int)strlen(cmdline));
+      xSnprintf(this->comm, sizeof(this->comm), "%.*s", MINIMUM(end - start, (int)sizeof(this->comm) - 1), cmdline + start);
+   }
+
+   /* Linux separates the arguments by newlines, shown as spaces */
+   this->cmdline = xStrdup(cmdline);
+   for (char* c = this->cmdline; (c = strchr(c, '\n')); c++)
+      *c = ' ';
+}
+
+HtopCollectSnapshot* HtopCollector_snapshot(HtopCollector* this) {
+   Machine* host = this->host;
+   Machine_scan(host);
+   Machine_scanTables(host);
+
+   const Vector* rows = host->processTable->rows;
+   HtopCollectSnapshot* snapshot = xCalloc(1, sizeof(HtopCollectSnapshot));
+   snapshot->realtimeMs = host->realtimeMs;
+   snapshot->activeCPUs = host->activeCPUs;
+   snapshot->totalMemKB = host->totalMem;
+   snapshot->usedMemKB = host->usedMem;
+   snapshot->processes = xCalloc(MAXIMUM(Vector_size(rows), 1), sizeof(HtopCollectProcess));
+
+   for (int i = 0; i < Vector_size(rows); i++) {
+      const Process* p = (const Process*) Vector_get(rows, i);
+
+      /* hidden threads may still be read, for the totals of their process */
+      if (!this->settings->hideUserlandThreads || !Process_isUserlandThread(p))
+         HtopCollectProcess_set(&snapshot->processes[snapshot->count++], p);
+   }
+
+   qsort(snapshot->processes, snapshot->count, sizeof(HtopCollectProcess), HtopCollectProcess_compareByPid);
+   return snapshot;
+}
+
+void HtopCollectSnapshot_delete(HtopCollectSnapshot* this) {
+   if (!this)
+      return;
+
+   for (size_t i = 0; i < this->count; i++)
+      free(this->processes[i].cmdline);
+   free(this->processes);
+   free(this);
+}
+
+void HtopCollector_delete(HtopCollector* this) {
+   if (!this)
+      return;
+
+   Machine_delete(this->host);
+   UsersTable_delete(this->usersTable);
+   Settings_delete(this->settings);
+   DynamicColumns_delete(this->dynamicColumns);
+   DynamicMeters_delete(this->dynamicMeters);
+   DynamicScreens_delete(this->dynamicScreens);
+   free(this);
+
+   Platform_done();
+   HtopCollector_exists = false;
+}
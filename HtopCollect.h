@@ -0,0 +1,82 @@
+#ifndef HEADER_HtopCollect
+#define HEADER_HtopCollect
+/*
+htop - HtopCollect.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+
+
+/*
+ * The process scanner of htop as a library (libhtop-collect.a), for programs
+ * wanting the processes without drawing them. Neither the terminal nor the
+ * configuration file of htop is touched: the scanner runs on its defaults.
+ *
+ * The platform keeps global state, so there is at most one collector in a
+ * program at a time. Snapshots are copies, valid after further scans and
+ * after the collector is gone.
+ */
+
+#define HTOP_COLLECT_COMM_LEN 64
+
+typedef struct HtopCollectProcess_ {
+   pid_t pid;
+   pid_t ppid;
+   pid_t tgid;                      /* the pid of the process of a thread */
+   uid_t uid;
+   char state;                      /* the letter of the S column */
+   bool kernelThread;
+   bool userlandThread;
+   long priority;
+   long nice;
+   long threads;
+   float cpuPercent;                /* of one CPU, since the previous snapshot */
+   float memPercent;
+   unsigned long long residentKB;
+   unsigned long long virtualKB;
+   unsigned long long timeCs;       /* user and system time, in hundredths of a second */
+   time_t startTime;                /* 0 where unknown */
+   char comm[HTOP_COLLECT_COMM_LEN];
+   char* cmdline;                   /* arguments separated by spaces, never NULL */
+} HtopCollectProcess;
+
+typedef struct HtopCollectSnapshot_ {
+   uint64_t realtimeMs;             /* when the scan was done, since the epoch */
+   unsigned int activeCPUs;
+   unsigned long long totalMemKB;
+   unsigned long long usedMemKB;
+   size_t count;
+   HtopCollectProcess* processes;   /* in the order of their pid */
+} HtopCollectSnapshot;
+
+typedef struct HtopCollector_ HtopCollector;
+
+/*
+ * Starts scanning. `flags` are PROCESS_FLAG_* of Process.h and of the
+ * ProcessField.h of the platform, for what the scanner reads beyond the
+ * process list itself. NULL if the platform can not be initialised or a
+ * collector exists already.
+ */
+HtopCollector* HtopCollector_new(uint64_t flags, bool withThreads);
+
+/* Further data to read from the next scan on */
+void HtopCollector_setFlags(HtopCollector* this, uint64_t flags);
+
+/*
+ * Scans the processes. The CPU usage is over the time since the previous
+ * snapshot; to be freed with HtopCollectSnapshot_delete.
+ */
+HtopCollectSnapshot* HtopCollector_snapshot(HtopCollector* this);
+
+void HtopCollectSnapshot_delete(HtopCollectSnapshot* this);
+
+void HtopCollector_delete(HtopCollector* this);
+
+#endif
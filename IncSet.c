@@ -57,6 +57,7 @@ static inline void IncMode_initFilter(IncMode* filter) {
 }
 
 static inline void IncMode_done(IncMode* mode) {
+   FilterMatcher_done(&mode->matcher);
    FunctionBar_delete(mode->bar);
 }
 
@@ -77,38 +78,20 @@ void IncSet_delete(IncSet* this) {
    free(this);
 }
 
-static void updateWeakPanel(const IncSet* this, Panel* panel, Vector* lines) {
-   const Object* selected = Panel_getSelected(panel);
-   Panel_prune(panel);
-   if (this->filtering) {
-      int n = 0;
-      const char* incFilter = this->modes[INC_FILTER].buffer;
-      for (int i = 0; i < Vector_size(lines); i++) {
-         ListItem* line = (ListItem*)Vector_get(lines, i);
-         if (String_contains_i(line->value, incFilter, true)) {
-            Panel_add(panel, (Object*)line);
-            if (selected == (Object*)line) {
-               Panel_setSelected(panel, n);
-            }
+static inline const FilterMatcher* IncMode_matcher(IncMode* mode) {
+   FilterMatcher_update(&mode->matcher, mode->buffer);
+   return &mode->matcher;
+}
 
-            n++;
-         }
-      }
-   } else {
-      for (int i = 0; i < Vector_size(lines); i++) {
-         Object* line = Vector_get(lines, i);
-         Panel_add(panel, line);
-         if (selected == line) {
-            Panel_setSelected(panel, i);
-         }
-      }
-   }
+const FilterMatcher* IncSet_filterMatcher(IncSet* this) {
+   return this->filtering ? IncMode_matcher(&this->modes[INC_FILTER]) : NULL;
 }
 
 static bool search(const IncSet* this, Panel* panel, IncMode_GetPanelValue getPanelValue) {
+   const FilterMatcher* matcher = IncMode_matcher(this->active);
    int size = Panel_size(panel);
    for (int i = 0; i < size; i++) {
-      if (String_contains_i(getPanelValue(panel, i), this->active->buffer, true)) {
+      if (FilterMatcher_matches(matcher, getPanelValue(panel, i))) {
          Panel_setSelected(panel, i);
          return true;
       }
@@ -132,7 +115,8 @@ static void IncSet_deactivate(IncSet* this, Panel* panel) {
    FunctionBar_draw(this->defaultBar);
 }
 
-static bool IncMode_find(const IncMode* mode, Panel* panel, IncMode_GetPanelValue getPanelValue, int step) {
+static bool IncMode_find(IncMode* mode, Panel* panel, IncMode_GetPanelValue getPanelValue, int step) {
+   const FilterMatcher* matcher = IncMode_matcher(mode);
    int size = Panel_size(panel);
    int here = Panel_getSelectedIndex(panel);
    int i = here;
@@ -148,14 +132,14 @@ static bool IncMode_find(const IncMode* mode, Panel* panel, IncMode_GetPanelValu
          return false;
       }
 
-      if (String_contains_i(getPanelValue(panel, i), mode->buffer, true)) {
+      if (FilterMatcher_matches(matcher, getPanelValue(panel, i))) {
          Panel_setSelected(panel, i);
          return true;
       }
    }
 }
 
-bool IncSet_handleKey(IncSet* this, int ch, Panel* panel, IncMode_GetPanelValue getPanelValue, Vector* lines) {
+bool IncSet_handleKey(IncSet* this, int ch, Panel* panel, IncMode_GetPanelValue getPanelValue) {
    if (ch == ERR)
       return true;
 
@@ -215,9 +199,6 @@ bool IncSet_handleKey(IncSet* this, int ch, Panel* panel, IncMode_GetPanelValue
    if (doSearch) {
       this->found = search(this, panel, getPanelValue);
    }
-   if (filterChanged && lines) {
-      updateWeakPanel(this, panel, lines);
-   }
    return filterChanged;
 }
 
@@ -10,9 +10,9 @@ in the source distribution for its full text.
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "FilterMatcher.h"
 #include "FunctionBar.h"
 #include "Panel.h"
-#include "Vector.h"
 
 
 #define INCMODE_MAX 128
@@ -25,6 +25,7 @@ typedef enum {
 typedef struct IncMode_ {
    char buffer[INCMODE_MAX + 1];
    int index;
+   FilterMatcher matcher;     /* buffer compiled, brought up to date before each use */
    FunctionBar* bar;
    bool isFilter;
 } IncMode;
@@ -44,6 +45,9 @@ static inline const char* IncSet_filter(const IncSet* this) {
 
 void IncSet_setFilter(IncSet* this, const char* filter);
 
+/* The filter compiled, NULL when not filtering */
+const FilterMatcher* IncSet_filterMatcher(IncSet* this);
+
 typedef const char* (*IncMode_GetPanelValue)(Panel*, int);
 
 void IncSet_reset(IncSet* this, IncType type);
@@ -52,7 +56,8 @@ IncSet* IncSet_new(FunctionBar* bar);
 
 void IncSet_delete(IncSet* this);
 
-bool IncSet_handleKey(IncSet* this, int ch, Panel* panel, IncMode_GetPanelValue getPanelValue, Vector* lines);
+/* Returns whether the filter changed */
+bool IncSet_handleKey(IncSet* this, int ch, Panel* panel, IncMode_GetPanelValue getPanelValue);
 
 const char* IncSet_getListItemValue(Panel* panel, int i);
 
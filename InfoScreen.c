@@ -13,10 +13,13 @@ in the source distribution for its full text.
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "CRT.h"
 #include "IncSet.h"
+#include "LineStore.h"
 #include "ListItem.h"
+#include "Macros.h"
 #include "Object.h"
 #include "ProvideCurses.h"
 #include "XUtils.h"
@@ -28,22 +31,43 @@ static const char* const InfoScreenKeys[] = {"F3", "F4", "F5", "Esc"};
 
 static const int InfoScreenEvents[] = {KEY_F(3), KEY_F(4), KEY_F(5), 27};
 
+static int InfoScreen_lineCount(const void* data) {
+   const InfoScreen* this = data;
+   return LineStore_shownCount(this->lines);
+}
+
+/* Only one line is handed out at a time, the panel displays each before asking for the next */
+static Object* InfoScreen_lineAt(const void* data, int i) {
+   const InfoScreen* this = data;
+   const LineStore* lines = this->lines;
+   this->item->value = lines->text[LineStore_shownLine(lines, i)];
+   return (Object*) this->item;
+}
+
 InfoScreen* InfoScreen_init(InfoScreen* this, const Process* process, FunctionBar* bar, int height, const char* panelHeader) {
    this->process = process;
+   this->exitFd = process ? Process_openExitFd(process) : -1;
+   this->exited = false;
    if (!bar) {
       bar = FunctionBar_new(InfoScreenFunctions, InfoScreenKeys, InfoScreenEvents);
    }
    this->display = Panel_new(0, 1, COLS, height, Class(ListItem), false, bar);
    this->inc = IncSet_new(bar);
-   this->lines = Vector_new(Vector_type(this->display->items), true, DEFAULT_SIZE);
+   this->lines = LineStore_new();
+   this->item = xCalloc(1, sizeof(ListItem));
+   Object_setClass(this->item, Class(ListItem));
+   Panel_setSource(this->display, InfoScreen_lineCount, InfoScreen_lineAt, this);
    Panel_setHeader(this->display, panelHeader);
    return this;
 }
 
 InfoScreen* InfoScreen_done(InfoScreen* this) {
+   if (this->exitFd >= 0)
+      close(this->exitFd);
    Panel_delete((Object*)this->display);
    IncSet_delete(this->inc);
-   Vector_delete(this->lines);
+   LineStore_delete(this->lines);
+   free(this->item);
    return this;
 }
 
@@ -55,6 +79,11 @@ void InfoScreen_drawTitled(InfoScreen* this, const char* fmt, ...) {
    int len = vsnprintf(title, sizeof(title), fmt, ap);
    va_end(ap);
 
+   if (this->exited && len >= 0 && len < COLS) {
+      const int extra = snprintf(title + len, sizeof(title) - (size_t)len, " (exited)");
+      len += MAXIMUM(extra, 0);
+   }
+
    if (len > COLS) {
       memset(&title[COLS - 3], '.', 3);
    }
@@ -69,20 +98,23 @@ void InfoScreen_drawTitled(InfoScreen* this, const char* fmt, ...) {
 }
 
 void InfoScreen_addLine(InfoScreen* this, const char* line) {
-   Vector_add(this->lines, (Object*) ListItem_new(line, 0));
-   const char* incFilter = IncSet_filter(this->inc);
-   if (!incFilter || String_contains_i(line, incFilter, true)) {
-      Panel_add(this->display, Vector_get(this->lines, Vector_size(this->lines) - 1));
-   }
+   LineStore_add(this->lines, line);
 }
 
 void InfoScreen_appendLine(InfoScreen* this, const char* line) {
-   ListItem* last = (ListItem*)Vector_get(this->lines, Vector_size(this->lines) - 1);
-   ListItem_append(last, line);
-   const char* incFilter = IncSet_filter(this->inc);
-   if (incFilter && Panel_get(this->display, Panel_size(this->display) - 1) != (Object*)last && String_contains_i(line, incFilter, true)) {
-      Panel_add(this->display, (Object*)last);
-   }
+   LineStore_appendToLast(this->lines, line);
+}
+
+/* Shows the lines matching the filter as it is now, the selected line stays selected if it still matches */
+void InfoScreen_filterLines(InfoScreen* this) {
+   Panel* panel = this->display;
+   const int selected = Panel_size(panel) > 0 ? LineStore_shownLine(this->lines, Panel_getSelectedIndex(panel)) : -1;
+
+   LineStore_filter(this->lines, IncSet_filterMatcher(this->inc));
+
+   panel->scrollV = 0;
+   panel->needsRedraw = true;
+   Panel_setSelected(panel, MAXIMUM(LineStore_findShown(this->lines, selected), 0));
 }
 
 void InfoScreen_run(InfoScreen* this) {
@@ -99,7 +131,16 @@ void InfoScreen_run(InfoScreen* this) {
       Panel_draw(panel, false, true, true, false);
       IncSet_drawBar(this->inc, CRT_colors[FUNCTION_BAR]);
 
-      int ch = Panel_getCh(panel);
+      /* the exit is shown at once, the descriptor stays readable after it */
+      const bool watching = this->exitFd >= 0 && !this->exited;
+      CRT_watchFds(watching ? &this->exitFd : NULL, watching ? 1 : 0);
+
+      int ch = Panel_getCh(panel, CRT_UPDATE_TIMEOUT);
+
+      if (ch == ERR && watching && CRT_watchedReady()) {
+         this->exited = true;
+         InfoScreen_draw(this);
+      }
 
       if (ch == ERR) {
          if (As_InfoScreen(this)->onErr) {
@@ -133,7 +174,8 @@ void InfoScreen_run(InfoScreen* this) {
 #endif
 
       if (this->inc->active) {
-         IncSet_handleKey(this->inc, ch, panel, IncSet_getListItemValue, this->lines);
+         if (IncSet_handleKey(this->inc, ch, panel, IncSet_getListItemValue))
+            InfoScreen_filterLines(this);
          continue;
       }
 
@@ -151,7 +193,7 @@ void InfoScreen_run(InfoScreen* this) {
          case KEY_F(5):
             clear();
             if (As_InfoScreen(this)->scan) {
-               Vector_prune(this->lines);
+               LineStore_clear(this->lines);
                InfoScreen_scan(this);
             }
 
@@ -169,7 +211,7 @@ void InfoScreen_run(InfoScreen* this) {
          case KEY_RESIZE:
             Panel_resize(panel, COLS, LINES - 2);
             if (As_InfoScreen(this)->scan) {
-               Vector_prune(this->lines);
+               LineStore_clear(this->lines);
                InfoScreen_scan(this);
             }
 
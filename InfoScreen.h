@@ -12,19 +12,23 @@ in the source distribution for its full text.
 
 #include "FunctionBar.h"
 #include "IncSet.h"
+#include "LineStore.h"
+#include "ListItem.h"
 #include "Macros.h"
 #include "Object.h"
 #include "Panel.h"
 #include "Process.h"
-#include "Vector.h"
 
 
 typedef struct InfoScreen_ {
    Object super;
    const Process* process;
-   Panel* display;
+   Panel* display;        /* shows the lines through InfoScreen_lineAt, they are not copied */
    IncSet* inc;
-   Vector* lines;
+   LineStore* lines;
+   ListItem* item;        /* the line last handed to the panel */
+   int exitFd;            /* readable once the process exited, -1 if that cannot be told */
+   bool exited;           /* noted in the title */
 } InfoScreen;
 
 typedef void(*InfoScreen_Scan)(InfoScreen*);
@@ -57,6 +61,8 @@ void InfoScreen_addLine(InfoScreen* this, const char* line);
 
 void InfoScreen_appendLine(InfoScreen* this, const char* line);
 
+void InfoScreen_filterLines(InfoScreen* this);
+
 void InfoScreen_run(InfoScreen* this);
 
 #endif
@@ -0,0 +1,314 @@
+/*
+htop - LineStore.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "LineStore.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Macros.h"
+#include "XUtils.h"
+
+
+LineStore* LineStore_new(void) {
+   LineStore* this = xCalloc(1, sizeof(LineStore));
+   return this;
+}
+
+void LineStore_delete(LineStore* this) {
+   LineStore_clear(this);
+   free(this->chunks);
+   free(this->text);
+   free(this->shown);
+   free(this);
+}
+
+void LineStore_clear(LineStore* this) {
+   for (int i = 0; i < this->chunkCount; i++)
+      free(this->chunks[i].data);
+
+   this->chunkCount = 0;
+   this->count = 0;
+   this->shownCount = 0;
+   free(this->order);
+   this->order = NULL;
+}
+
+static LineStoreChunk* LineStore_newChunk(LineStore* this, size_t minSize) {
+   if (this->chunkCount == this->chunksAlloc) {
+      this->chunksAlloc = this->chunksAlloc ? this->chunksAlloc * 2 : 16;
+      this->chunks = xReallocArray(this->chunks, this->chunksAlloc, sizeof(LineStoreChunk));
+   }
+
+   LineStoreChunk* chunk = &this->chunks[this->chunkCount++];
+   chunk->size = MAXIMUM(minSize, LINESTORE_CHUNK_SIZE);
+   chunk->data = xMalloc(chunk->size);
+   chunk->used = 0;
+   chunk->firstLine = this->count;
+   return chunk;
+}
+
+static void LineStore_addShown(LineStore* this, int line) {
+   if (this->shownCount == this->shownAlloc) {
+      this->shownAlloc = this->shownAlloc ? this->shownAlloc * 2 : 256;
+      this->shown = xReallocArray(this->shown, this->shownAlloc, sizeof(int));
+   }
+
+   this->shown[this->shownCount++] = line;
+}
+
+void LineStore_add(LineStore* this, const char* line) {
+   const size_t len = strlen(line) + 1;
+
+   LineStoreChunk* chunk = this->chunkCount ? &this->chunks[this->chunkCount - 1] : NULL;
+   if (!chunk || chunk->used + len > chunk->size)
+      chunk = LineStore_newChunk(this, len);
+
+   char* start = chunk->data + chunk->used;
+   memcpy(start, line, len);
+   chunk->used += len;
+
+   if (this->count == this->alloc) {
+      this->alloc = this->alloc ? this->alloc * 2 : 256;
+      this->text = xReallocArray(this->text, this->alloc, sizeof(char*));
+      if (this->order)
+         this->order = xReallocArray(this->order, this->alloc, sizeof(int));
+   }
+
+   if (this->order)
+      this->order[this->count] = this->count;
+   this->text[this->count++] = start;
+
+   if (this->filter && FilterMatcher_matches(this->filter, start))
+      LineStore_addShown(this, this->count - 1);
+}
+
+void LineStore_appendToLast(LineStore* this, const char* text) {
+   assert(this->count > 0);
+
+   const int line = this->count - 1;
+   LineStoreChunk* chunk = &this->chunks[this->chunkCount - 1];
+   size_t offset = (size_t)(this->text[line] - chunk->data);
+   const size_t oldLen = strlen(this->text[line]);
+   const size_t textLen = strlen(text);
+   const size_t size = oldLen + textLen + 1;
+
+   /* the last line ends its chunk, move it along when it outgrows it */
+   if (offset + size > chunk->size) {
+      if (offset == 0) {
+         chunk->data = xRealloc(chunk->data, size);
+         chunk->size = size;
+      } else {
+         const char* old = this->text[line];
+         chunk->used = offset;
+         chunk = LineStore_newChunk(this, size);
+         chunk->firstLine = line;
+         memcpy(chunk->data, old, oldLen + 1);
+         offset = 0;
+      }
+      this->text[line] = chunk->data + offset;
+   }
+
+   memcpy(this->text[line] + oldLen, text, textLen + 1);
+   chunk->used = offset + size;
+
+   /* the line as a whole may only match now */
+   if (this->filter && (this->shownCount == 0 || this->shown[this->shownCount - 1] != line) && FilterMatcher_matches(this->filter, this->text[line]))
+      LineStore_addShown(this, line);
+}
+
+int LineStore_dropFirst(LineStore* this, int n) {
+   assert(!this->order);
+
+   n = MINIMUM(n, this->count);
+   if (n <= 0)
+      return 0;
+
+   int shownDropped = n;
+   if (this->filter) {
+      shownDropped = 0;
+      while (shownDropped < this->shownCount && this->shown[shownDropped] < n)
+         shownDropped++;
+
+      this->shownCount -= shownDropped;
+      for (int i = 0; i < this->shownCount; i++)
+         this->shown[i] = this->shown[i + shownDropped] - n;
+   }
+
+   if (n == this->count) {
+      LineStore_clear(this);
+      return shownDropped;
+   }
+
+   /* chunks holding dropped lines only */
+   int freed = 0;
+   while (freed < this->chunkCount - 1 && this->chunks[freed + 1].firstLine <= n)
+      free(this->chunks[freed++].data);
+
+   this->chunkCount -= freed;
+   memmove(this->chunks, this->chunks + freed, this->chunkCount * sizeof(LineStoreChunk));
+   for (int i = 0; i < this->chunkCount; i++)
+      this->chunks[i].firstLine = MAXIMUM(this->chunks[i].firstLine - n, 0);
+
+   this->count -= n;
+   memmove(this->text, this->text + n, this->count * sizeof(char*));
+
+   return shownDropped;
+}
+
+/* Brings the lines shown, found in the order added, into display order */
+static void LineStore_arrangeShown(LineStore* this) {
+   if (!this->order)
+      return;
+
+   unsigned char* marked = xCalloc(this->count, sizeof(unsigned char));
+   for (int i = 0; i < this->shownCount; i++)
+      marked[this->shown[i]] = 1;
+
+   this->shownCount = 0;
+   for (int i = 0; i < this->count; i++) {
+      if (marked[this->order[i]]) {
+         LineStore_addShown(this, this->order[i]);
+      }
+   }
+
+   free(marked);
+}
+
+typedef struct LineStoreSortItem_ {
+   const char* text;
+   int line;
+} LineStoreSortItem;
+
+static int LineStore_compareItems(const void* v1, const void* v2) {
+   const LineStoreSortItem* item1 = v1;
+   const LineStoreSortItem* item2 = v2;
+
+   int r = strcmp(item1->text, item2->text);
+   return r ? r : SPACESHIP_NUMBER(item1->line, item2->line);
+}
+
+void LineStore_sort(LineStore* this) {
+   if (this->count == 0)
+      return;
+
+   LineStoreSortItem* items = xMallocArray(this->count, sizeof(LineStoreSortItem));
+   for (int i = 0; i < this->count; i++)
+      items[i] = (LineStoreSortItem) { .text = this->text[i], .line = i };
+
+   qsort(items, this->count, sizeof(LineStoreSortItem), LineStore_compareItems);
+
+   if (!this->order)
+      this->order = xMallocArray(this->alloc, sizeof(int));
+   for (int i = 0; i < this->count; i++)
+      this->order[i] = items[i].line;
+
+   free(items);
+
+   if (this->filter)
+      LineStore_arrangeShown(this);
+}
+
+/* Runs the filter over the chunks, skipping to the end of each line it is found in */
+static void LineStore_scan(LineStore* this) {
+   this->shownCount = 0;
+
+   for (int c = 0; c < this->chunkCount; c++) {
+      const LineStoreChunk* chunk = &this->chunks[c];
+      const int lastLine = (c + 1 < this->chunkCount ? this->chunks[c + 1].firstLine : this->count) - 1;
+      if (chunk->firstLine > lastLine)
+         continue;
+
+      /* the chunk may still hold lines dropped before its first one */
+      const char* at = this->text[chunk->firstLine];
+      const char* end = chunk->data + chunk->used;
+      int line = chunk->firstLine;
+      while (at < end) {
+         const char* found = FilterMatcher_find(this->filter, at, (size_t)(end - at));
+         if (!found)
+            break;
+
+         /* the last line starting at or before the match */
+         int lo = line;
+         int hi = lastLine;
+         while (lo < hi) {
+            const int mid = lo + (hi - lo + 1) / 2;
+            if (this->text[mid] <= found) {
+               lo = mid;
+            } else {
+               hi = mid - 1;
+            }
+         }
+
+         LineStore_addShown(this, lo);
+         at = this->text[lo] + strlen(this->text[lo]) + 1;
+         line = lo + 1;
+      }
+   }
+
+   LineStore_arrangeShown(this);
+}
+
+void LineStore_filter(LineStore* this, const FilterMatcher* filter) {
+   if (filter && FilterMatcher_matchesAny(filter))
+      filter = NULL;
+
+   /* only lines shown before can match a narrowed pattern */
+   const bool narrowed = filter && filter == this->filter && FilterMatcher_narrowedSince(filter, this->filterGeneration);
+
+   this->filter = filter;
+   if (!filter)
+      return;
+
+   this->filterGeneration = filter->generation;
+   if (!narrowed) {
+      LineStore_scan(this);
+      return;
+   }
+
+   int n = 0;
+   for (int i = 0; i < this->shownCount; i++) {
+      if (FilterMatcher_matches(filter, this->text[this->shown[i]])) {
+         this->shown[n++] = this->shown[i];
+      }
+   }
+   this->shownCount = n;
+}
+
+int LineStore_findShown(const LineStore* this, int line) {
+   if (!this->filter && !this->order)
+      return line >= 0 && line < this->count ? line : -1;
+
+   const int size = LineStore_shownCount(this);
+
+   /* the lines shown follow the order added */
+   if (!this->order) {
+      int lo = 0;
+      int hi = size - 1;
+      while (lo <= hi) {
+         const int mid = lo + (hi - lo) / 2;
+         if (this->shown[mid] == line)
+            return mid;
+         if (this->shown[mid] < line) {
+            lo = mid + 1;
+         } else {
+            hi = mid - 1;
+         }
+      }
+      return -1;
+   }
+
+   for (int i = 0; i < size; i++) {
+      if (LineStore_shownLine(this, i) == line) {
+         return i;
+      }
+   }
+   return -1;
+}
@@ -0,0 +1,92 @@
+#ifndef HEADER_LineStore
+#define HEADER_LineStore
+/*
+htop - LineStore.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "FilterMatcher.h"
+
+
+/* Lines are copied into chunks of this size, longer ones get a chunk of their own */
+#define LINESTORE_CHUNK_SIZE 65536
+
+typedef struct LineStoreChunk_ {
+   char* data;
+   size_t size;
+   size_t used;
+   int firstLine;         /* the lines of a chunk follow each other, up to the first line of the next one */
+} LineStoreChunk;
+
+/*
+ * Append-only store of text lines, kept back to back in large chunks with
+ * an index of where each line starts. The lines shown are those matching a
+ * filter, found by running it over the chunks rather than line by line.
+ */
+typedef struct LineStore_ {
+   LineStoreChunk* chunks;
+   int chunkCount;
+   int chunksAlloc;
+
+   char** text;           /* start of each line, in the order added */
+   int count;
+   int alloc;
+
+   int* order;            /* lines in display order after LineStore_sort, NULL for the order added */
+
+   const FilterMatcher* filter;    /* lines not matching are left out, NULL to show all */
+   unsigned int filterGeneration;  /* generation of the filter when the lines shown were found */
+   int* shown;            /* lines shown in display order, only with a filter */
+   int shownCount;
+   int shownAlloc;
+} LineStore;
+
+LineStore* LineStore_new(void);
+
+void LineStore_delete(LineStore* this);
+
+/* Drops all lines, the filter stays */
+void LineStore_clear(LineStore* this);
+
+void LineStore_add(LineStore* this, const char* line);
+
+/* Appends text to the last line */
+void LineStore_appendToLast(LineStore* this, const char* text);
+
+/* Drops the `n` oldest lines of an unsorted store; returns how many of them were shown */
+int LineStore_dropFirst(LineStore* this, int n);
+
+/* Orders the lines by their text */
+void LineStore_sort(LineStore* this);
+
+/* Shows the lines matching `filter` (NULL for all), its pattern may have changed in place */
+void LineStore_filter(LineStore* this, const FilterMatcher* filter);
+
+/* Index of `line` among the lines shown, -1 if it is not shown */
+int LineStore_findShown(const LineStore* this, int line);
+
+static inline int LineStore_size(const LineStore* this) {
+   return this->count;
+}
+
+static inline const char* LineStore_get(const LineStore* this, int line) {
+   return this->text[line];
+}
+
+static inline int LineStore_shownCount(const LineStore* this) {
+   return this->filter ? this->shownCount : this->count;
+}
+
+static inline int LineStore_shownLine(const LineStore* this, int i) {
+   if (this->filter)
+      return this->shown[i];
+
+   return this->order ? this->order[i] : i;
+}
+
+#endif
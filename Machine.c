@@ -13,26 +13,22 @@ in the source distribution for its full text.
 #include <stdlib.h>
 #include <unistd.h>
 
+#if defined(HAVE_LIBHWLOC) && defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include "Budget.h"
+#include "Macros.h"
 #include "Object.h"
 #include "Platform.h"
+#include "Profile.h"
 #include "Row.h"
 #include "XUtils.h"
 
 
-void Machine_init(Machine* this, UsersTable* usersTable, uid_t userId) {
-   this->usersTable = usersTable;
-   this->userId = userId;
-
-   this->htopUserId = getuid();
-
-   // discover fixed column width limits
-   Row_setPidColumnWidth(Platform_getMaxPid());
-
-   // always maintain valid realtime timestamps
-   Platform_gettime_realtime(&this->realtime, &this->realtimeMs);
-
 #ifdef HAVE_LIBHWLOC
-   this->topologyOk = false;
+
+static void Machine_doLoadTopology(Machine* this) {
    if (hwloc_topology_init(&this->topology) == 0) {
       this->topologyOk =
          #if HWLOC_API_VERSION < 0x00020000
@@ -47,36 +43,115 @@ void Machine_init(Machine* this, UsersTable* usersTable, uid_t userId) {
          #endif
          0 == hwloc_topology_load(this->topology);
    }
+}
+
+#ifdef HAVE_PTHREAD
+
+/* Loading the topology takes long on large NUMA hosts, so it is done while the first frame is drawn */
+static struct {
+   pthread_t thread;
+   bool started;
+} Machine_topologyLoader;
+
+static void* Machine_loadTopologyThread(void* arg) {
+   Machine_doLoadTopology(arg);
+   return NULL;
+}
+
+#endif /* HAVE_PTHREAD */
+
+#endif /* HAVE_LIBHWLOC */
+
+void Machine_init(Machine* this, UsersTable* usersTable, uid_t userId) {
+   this->usersTable = usersTable;
+   this->userId = userId;
+
+   this->htopUserId = getuid();
+
+   // discover fixed column width limits
+   Row_setPidColumnWidth(Platform_getMaxPid());
+
+   // always maintain valid realtime timestamps
+   Platform_gettime_realtime(&this->realtime, &this->realtimeMs);
+
+   for (size_t i = 0; i < ARRAYSIZE(this->pressureFds); i++)
+      this->pressureFds[i] = -1;
+
+   this->activeCollectors = MACHINE_COLLECTORS_ALL;
+
+#ifdef HAVE_LIBHWLOC
+   this->topologyOk = false;
+#ifdef HAVE_PTHREAD
+   Machine_topologyLoader.started = pthread_create(&Machine_topologyLoader.thread, NULL, Machine_loadTopologyThread, this) == 0;
+   if (!Machine_topologyLoader.started)
+#endif
+      Machine_doLoadTopology(this);
+#endif
+}
+
+#ifdef HAVE_LIBHWLOC
+bool Machine_loadTopology(const Machine* this) {
+#ifdef HAVE_PTHREAD
+   if (Machine_topologyLoader.started) {
+      pthread_join(Machine_topologyLoader.thread, NULL);
+      Machine_topologyLoader.started = false;
+   }
 #endif
+   return this->topologyOk;
 }
+#endif
 
 void Machine_done(Machine* this) {
 #ifdef HAVE_LIBHWLOC
-   if (this->topologyOk) {
+   if (Machine_loadTopology(this)) {
       hwloc_topology_destroy(this->topology);
    }
 #endif
+   for (size_t i = 0; i < ARRAYSIZE(this->pressureFds); i++) {
+      if (this->pressureFds[i] >= 0)
+         close(this->pressureFds[i]);
+   }
    Object_delete(this->processTable);
    free(this->tables);
 }
 
-static void Machine_addTable(Machine* this, Table* table) {
+bool Machine_collects(const Machine* this, unsigned int collector) {
+   if (this->activeCollectors & (1U << collector))
+      return true;
+
+   const ScreenSettings* ss = this->settings ? this->settings->ss : NULL;
+   return ss && (this->collectors[collector].processFlags & ss->flags);
+}
+
+bool Machine_collectorReadBy(const Machine* this, unsigned int collector, const struct MeterClass_* type) {
+   for (const struct MeterClass_* const* meter = this->collectors[collector].meters; meter && *meter; meter++) {
+      if (*meter == type)
+         return true;
+   }
+   return false;
+}
+
+bool Machine_addTable(Machine* this, Table* table) {
    /* check that this table has not been seen previously */
    for (size_t i = 0; i < this->tableCount; i++)
       if (this->tables[i] == table)
-         return;
+         return false;
 
    size_t nmemb = this->tableCount + 1;
    Table** tables = xReallocArray(this->tables, nmemb, sizeof(Table*));
    tables[nmemb - 1] = table;
    this->tables = tables;
    this->tableCount++;
+   return true;
 }
 
 void Machine_populateTablesFromSettings(Machine* this, Settings* settings, Table* processTable) {
    this->settings = settings;
    this->processTable = processTable;
 
+   /* first, as other tables can be built from what the process scan read */
+   Machine_addTable(this, processTable);
+
    for (size_t i = 0; i < settings->nScreens; i++) {
       ScreenSettings* ss = settings->screens[i];
       Table* table = ss->table;
@@ -95,7 +170,23 @@ void Machine_setTablesPanel(Machine* this, Panel* panel) {
    }
 }
 
-void Machine_scanTables(Machine* this) {
+/* Ticks of the meters can be up to half an update late or early relative to the table interval */
+static bool Machine_isTableDue(const Machine* this, const Table* table, uint64_t now) {
+   return table->nextScanMs <= now + 50 * (uint64_t)Budget_delay(this->settings);
+}
+
+bool Machine_isTableShown(const Machine* this, const Table* table) {
+   return table == this->activeTable || table == this->processTable;
+}
+
+static bool Machine_wantsTableScan(const Machine* this, const Table* table, bool shownOnly, bool dueOnly) {
+   if (shownOnly && !Machine_isTableShown(this, table))
+      return false;
+
+   return !dueOnly || Machine_isTableDue(this, table, this->monotonicMs);
+}
+
+static bool Machine_doScanTables(Machine* this, bool shownOnly, bool dueOnly) {
    // set scan timestamp
    static bool firstScanDone = false;
 
@@ -104,12 +195,40 @@ void Machine_scanTables(Machine* this) {
    else
       firstScanDone = true;
 
-   this->maxUserId = 0;
-   Row_resetFieldWidths();
+   bool any = false;
+   bool allShown = true;
+   for (size_t i = 0; i < this->tableCount; i++) {
+      const Table* table = this->tables[i];
+      bool wanted = Machine_wantsTableScan(this, table, shownOnly, dueOnly);
+
+      any |= wanted;
+      if (!wanted && Machine_isTableShown(this, table))
+         allShown = false;
+   }
+   if (!any)
+      return false;
+
+   // column widths are only for what is on screen, keep them until all of it is scanned again
+   if (allShown) {
+      this->maxUserId = 0;
+      Row_resetFieldWidths();
+   }
+
+   // pick up user names resolved meanwhile
+   UsersTable_update(this->usersTable);
+
+   uint64_t interval = (100 * (uint64_t)this->settings->tableDelay) << Budget_level;
+   if (this->monotonicMs < this->burstUntilMs)
+      interval = 0;
 
    for (size_t i = 0; i < this->tableCount; i++) {
       Table* table = this->tables[i];
 
+      if (!Machine_wantsTableScan(this, table, shownOnly, dueOnly))
+         continue;
+
+      const ProfileMark mark = Profile_begin();
+
       // pre-processing of each row
       Table_scanPrepare(table);
 
@@ -118,7 +237,68 @@ void Machine_scanTables(Machine* this) {
 
       // post-process after scanning
       Table_scanCleanup(table);
+
+      Profile_end(PROFILE_TABLE_SCAN, mark);
+
+      Table_markRowsChanged(table);
+
+      table->nextScanMs = interval ? this->monotonicMs + interval : 0;
+      table->scanTime = this->realtime.tv_sec;
    }
 
    Row_setUidColumnWidth(this->maxUserId);
+   return true;
+}
+
+void Machine_scanTables(Machine* this) {
+   Machine_doScanTables(this, false, false);
+}
+
+void Machine_notePressure(Machine* this, unsigned int events) {
+   uint64_t now;
+   Platform_gettime_monotonic(&now);
+
+   this->pressureEvents |= events;
+   this->burstUntilMs = now + MACHINE_BURST_MS;
+
+   /* the tables with an interval of their own catch up at once */
+   for (size_t i = 0; i < this->tableCount; i++)
+      this->tables[i]->nextScanMs = 0;
+}
+
+int Machine_delay(const Machine* this, int delay) {
+   if (!this->burstUntilMs)
+      return delay;
+
+   uint64_t now;
+   Platform_gettime_monotonic(&now);
+   return now < this->burstUntilMs ? MINIMUM(delay, MACHINE_BURST_DELAY) : delay;
+}
+
+bool Machine_scanShownTables(Machine* this, bool dueOnly) {
+   return Machine_doScanTables(this, true, dueOnly);
+}
+
+bool Machine_prefetchTables(Machine* this) {
+   bool started = false;
+   uint64_t now;
+   Platform_gettime_monotonic(&now);
+
+   for (size_t i = 0; i < this->tableCount; i++) {
+      Table* table = this->tables[i];
+      if (Machine_isTableShown(this, table) && Machine_isTableDue(this, table, now))
+         started |= Table_scanPrefetch(table);
+   }
+
+   return started;
+}
+
+bool Machine_tablesPrefetched(const Machine* this) {
+   for (size_t i = 0; i < this->tableCount; i++) {
+      const Table* table = this->tables[i];
+      if (!Table_scanPrefetched(table))
+         return false;
+   }
+
+   return true;
 }
@@ -35,6 +35,30 @@ in the source distribution for its full text.
 typedef unsigned long long int memory_t;
 #define MEMORY_MAX ULLONG_MAX
 
+/* Pressure on the system a platform can be notified of, see Machine.pressureFds */
+typedef enum MachinePressure_ {
+   MACHINE_PRESSURE_CPU,
+   MACHINE_PRESSURE_MEMORY,
+   MACHINE_PRESSURE_IO,
+   MACHINE_PRESSURE_KINDS
+} MachinePressure;
+
+/* Update interval in tenths of a second after pressure was noted, and for how long */
+#define MACHINE_BURST_DELAY 2
+#define MACHINE_BURST_MS 10000
+
+struct MeterClass_;
+
+/* A part of Machine_scan() a platform skips while nothing shows what it reads */
+typedef struct MachineCollector_ {
+   const char* name;
+   const struct MeterClass_* const* meters;  /* NULL-terminated, the meters reading it */
+   uint64_t processFlags;                    /* the columns reading it, see ScreenSettings.flags */
+} MachineCollector;
+
+/* Every collector runs, until a header picks them by its meters */
+#define MACHINE_COLLECTORS_ALL UINT_MAX
+
 typedef struct Machine_ {
    struct Settings_* settings;
 
@@ -44,8 +68,19 @@ typedef struct Machine_ {
 
    int64_t iterationsRemaining;
 
+   /* Descriptors becoming ready for POLLPRI on pressure above the setting pressure_trigger,
+      by MachinePressure; -1 where the platform has none, opened by Machine_scan() */
+   int pressureFds[MACHINE_PRESSURE_KINDS];
+   unsigned int pressureEvents;  /* bits of the kinds noted, until taken by the recorder */
+   uint64_t burstUntilMs;        /* monotonic, updates are MACHINE_BURST_DELAY apart until then */
+
+   /* Up to one without a name, NULL if the platform has none; by index in activeCollectors,
+      set by Header_updateCollectors() */
+   const MachineCollector* collectors;
+   unsigned int activeCollectors;
+
    #ifdef HAVE_LIBHWLOC
-   hwloc_topology_t topology;
+   hwloc_topology_t topology;  /* loaded in the background, see Machine_loadTopology() */
    bool topologyOk;
    #endif
 
@@ -85,12 +120,44 @@ void Machine_done(Machine* this);
 
 bool Machine_isCPUonline(const Machine* this, unsigned int id);
 
+/* Whether the collector at the index is read by a meter of the header or a column of the active screen */
+bool Machine_collects(const Machine* this, unsigned int collector);
+
+/* Whether the collector at the index is read by the meters of this class */
+bool Machine_collectorReadBy(const Machine* this, unsigned int collector, const struct MeterClass_* type);
+
+#ifdef HAVE_LIBHWLOC
+/* Waits for the hwloc topology started loading by Machine_init(); false if it could not be loaded */
+bool Machine_loadTopology(const Machine* this);
+#endif
+
 void Machine_populateTablesFromSettings(Machine* this, Settings* settings, Table* processTable);
 
+/* Adds the table of a screen to the scanned ones, false if it is one already */
+bool Machine_addTable(Machine* this, Table* table);
+
 void Machine_setTablesPanel(Machine* host, Panel* panel);
 
 void Machine_scan(Machine* this);
 
 void Machine_scanTables(Machine* this);
 
+/* Notes the pressure events, a bit for each MachinePressure, and updates faster for MACHINE_BURST_MS */
+void Machine_notePressure(Machine* this, unsigned int events);
+
+/* Update interval in tenths of a second, shortened while pressure was noted recently */
+int Machine_delay(const Machine* this, int delay);
+
+/* The active table and the process table the meters count from; others are only scanned once selected */
+bool Machine_isTableShown(const Machine* this, const Table* table);
+
+/* Like Machine_scanTables(), but only of the shown tables, if dueOnly those whose update interval is over; false if there were none */
+bool Machine_scanShownTables(Machine* this, bool dueOnly);
+
+/* Lets the shown tables due next read their scan in the background; false if none of them can */
+bool Machine_prefetchTables(Machine* this);
+
+/* Whether Machine_scanTables() can merge the background reading without waiting */
+bool Machine_tablesPrefetched(const Machine* this);
+
 #endif
@@ -14,11 +14,13 @@ in the source distribution for its full text.
 #include <stdlib.h>
 #include <sys/types.h>
 
+#include "Batch.h"
 #include "CRT.h"
 #include "FunctionBar.h"
 #include "Machine.h"
 #include "Platform.h"
 #include "ProvideCurses.h"
+#include "Replay.h"
 #include "Row.h"
 #include "RowField.h"
 #include "Settings.h"
@@ -73,8 +75,10 @@ static HandlerResult MainPanel_eventHandler(Panel* super, int ch) {
    if (!(ch != KEY_MOUSE || host->settings->enableMouse))
       needReset = false;
    #endif
-   if (needReset)
+   if (needReset && this->state->hideSelection) {
       this->state->hideSelection = false;
+      super->needsRedraw = true;
+   }
 
    Settings* settings = host->settings;
    ScreenSettings* ss = settings->ss;
@@ -99,7 +103,7 @@ static HandlerResult MainPanel_eventHandler(Panel* super, int ch) {
       reaction |= Action_setScreenTab(this->state, x);
       result = HANDLED;
    } else if (ch != ERR && this->inc->active) {
-      bool filterChanged = IncSet_handleKey(this->inc, ch, super, MainPanel_getValue, NULL);
+      bool filterChanged = IncSet_handleKey(this->inc, ch, super, MainPanel_getValue);
       if (filterChanged) {
          host->activeTable->incFilter = IncSet_filter(this->inc);
          reaction = HTOP_REFRESH | HTOP_REDRAW_BAR;
@@ -111,6 +115,7 @@ static HandlerResult MainPanel_eventHandler(Panel* super, int ch) {
       result = HANDLED;
    } else if (ch == 27) {
       this->state->hideSelection = true;
+      super->needsRedraw = true;
       return HANDLED;
    } else if (ch != ERR && ch > 0 && ch < KEY_MAX && this->keys[ch]) {
       reaction |= (this->keys[ch])(this->state);
@@ -125,6 +130,13 @@ static HandlerResult MainPanel_eventHandler(Panel* super, int ch) {
       }
    }
 
+   /* Actions and filters may change which rows show and how, e.g. by tagging
+      them, and some cleared the screen to show their own */
+   if (result & HANDLED) {
+      Table_markRowsChanged(host->activeTable);
+      super->needsRedraw = true;
+   }
+
    if ((reaction & HTOP_REDRAW_BAR) == HTOP_REDRAW_BAR) {
       MainPanel_updateLabels(this, settings->ss->treeView, host->activeTable->incFilter);
    }
@@ -193,6 +205,15 @@ static void MainPanel_drawFunctionBar(Panel* super, bool hideFunctionBar) {
    if (this->state->pauseUpdate) {
       FunctionBar_append("PAUSED", CRT_colors[PAUSED]);
    }
+   if (Replay_isOpen()) {
+      char buffer[64];
+      Replay_describe(buffer, sizeof(buffer));
+      FunctionBar_append(buffer, CRT_colors[PAUSED]);
+   }
+   char exported[128];
+   if (Batch_describeExport(exported, sizeof(exported))) {
+      FunctionBar_append(exported, CRT_colors[PAUSED]);
+   }
 }
 
 static void MainPanel_printHeader(Panel* super) {
@@ -24,6 +24,7 @@ static const int MemoryMeter_attributes[] = {
    MEMORY_USED,
    MEMORY_SHARED,
    MEMORY_COMPRESSED,
+   MEMORY_SLAB,
    MEMORY_BUFFERS,
    MEMORY_CACHE
 };
@@ -33,9 +34,10 @@ static void MemoryMeter_updateValues(Meter* this) {
    size_t size = sizeof(this->txtBuffer);
    int written;
 
-   /* shared, compressed and available memory are not supported on all platforms */
+   /* shared, compressed, kernel slab and available memory are not supported on all platforms */
    this->values[MEMORY_METER_SHARED] = NAN;
    this->values[MEMORY_METER_COMPRESSED] = NAN;
+   this->values[MEMORY_METER_SLAB] = NAN;
    this->values[MEMORY_METER_AVAILABLE] = NAN;
    Platform_setMemoryValues(this);
 
@@ -44,12 +46,14 @@ static void MemoryMeter_updateValues(Meter* this) {
       "MEMORY_METER_AVAILABLE is not the last item in MemoryMeterValues");
    this->curItems = MEMORY_METER_AVAILABLE;
 
-   /* we actually want to show "used + shared + compressed" */
+   /* we actually want to show "used + shared + compressed + slab" */
    double used = this->values[MEMORY_METER_USED];
    if (isPositive(this->values[MEMORY_METER_SHARED]))
       used += this->values[MEMORY_METER_SHARED];
    if (isPositive(this->values[MEMORY_METER_COMPRESSED]))
       used += this->values[MEMORY_METER_COMPRESSED];
+   if (isPositive(this->values[MEMORY_METER_SLAB]))
+      used += this->values[MEMORY_METER_SLAB];
 
    written = Meter_humanUnit(buffer, used, size);
    METER_BUFFER_CHECK(buffer, size, written);
@@ -85,6 +89,13 @@ static void MemoryMeter_display(const Object* cast, RichString* out) {
       RichString_appendAscii(out, CRT_colors[MEMORY_COMPRESSED], buffer);
    }
 
+   /* unreclaimable kernel slab memory is not supported on all platforms */
+   if (isNonnegative(this->values[MEMORY_METER_SLAB])) {
+      Meter_humanUnit(buffer, this->values[MEMORY_METER_SLAB], sizeof(buffer));
+      RichString_appendAscii(out, CRT_colors[METER_TEXT], " slab:");
+      RichString_appendAscii(out, CRT_colors[MEMORY_SLAB], buffer);
+   }
+
    Meter_humanUnit(buffer, this->values[MEMORY_METER_BUFFERS], sizeof(buffer));
    RichString_appendAscii(out, CRT_colors[METER_TEXT], " buffers:");
    RichString_appendAscii(out, CRT_colors[MEMORY_BUFFERS_TEXT], buffer);
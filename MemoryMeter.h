@@ -13,10 +13,11 @@ typedef enum {
    MEMORY_METER_USED = 0,
    MEMORY_METER_SHARED = 1,
    MEMORY_METER_COMPRESSED = 2,
-   MEMORY_METER_BUFFERS = 3,
-   MEMORY_METER_CACHE = 4,
-   MEMORY_METER_AVAILABLE = 5,
-   MEMORY_METER_ITEMCOUNT = 6, // number of entries in this enum
+   MEMORY_METER_SLAB = 3,
+   MEMORY_METER_BUFFERS = 4,
+   MEMORY_METER_CACHE = 5,
+   MEMORY_METER_AVAILABLE = 6,
+   MEMORY_METER_ITEMCOUNT = 7, // number of entries in this enum
 } MemoryMeterValues;
 
 extern const MeterClass MemoryMeter_class;
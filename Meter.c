@@ -7,15 +7,19 @@ in the source distribution for its full text.
 
 #include "config.h" // IWYU pragma: keep
 
+#define HEAP_CLASS HEAP_GRAPHS
+
 #include "Meter.h"
 
 #include <assert.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "CRT.h"
 #include "Macros.h"
+#include "MeterJob.h"
 #include "Object.h"
 #include "ProvideCurses.h"
 #include "RichString.h"
@@ -25,6 +29,7 @@ in the source distribution for its full text.
 
 
 #define GRAPH_HEIGHT 4 /* Unit: rows (lines) */
+#define GRAPH_LOW_BANDWIDTH_VALUES 4 /* values recorded between graph moves in low bandwidth mode */
 
 const MeterClass Meter_class = {
    .super = {
@@ -83,7 +88,16 @@ int Meter_humanUnit(char* buffer, double value, size_t size) {
       }
    }
 
-   return xSnprintf(buffer, size, "%.*f%c", precision, value, unitPrefixes[i]);
+   int len = String_formatDouble(buffer, size - 1, value, precision, 0);
+   buffer[len++] = unitPrefixes[i];
+   buffer[len] = '\0';
+   return len;
+}
+
+static void GraphData_done(GraphData* this) {
+   free(this->values);
+   free(this->columns);
+   *this = (GraphData) { .time = this->time };
 }
 
 void Meter_delete(Object* cast) {
@@ -91,15 +105,36 @@ void Meter_delete(Object* cast) {
       return;
 
    Meter* this = (Meter*) cast;
-   if (Meter_doneFn(this)) {
+   if (this->job) {
+      MeterJob_delete(this->job);
+   } else if (Meter_doneFn(this)) {
       Meter_done(this);
    }
-   free(this->drawData.values);
+   GraphData_done(&this->drawData);
    free(this->caption);
    free(this->values);
    free(this);
 }
 
+void Meter_update(Meter* this) {
+   if (As_Meter(this)->slowInterval && !this->job) {
+      this->job = MeterJob_new(this);
+
+      /* nothing to show until the first background update is over */
+      if (this->job) {
+         for (uint8_t i = 0; i < As_Meter(this)->maxItems; i++)
+            this->values[i] = NAN;
+         this->curItems = 0;
+      }
+   }
+
+   if (this->job) {
+      MeterJob_update(this->job, this);
+   } else {
+      Meter_updateValues(this);
+   }
+}
+
 void Meter_setCaption(Meter* this, const char* caption) {
    free_and_xStrdup(&this->caption, caption);
 }
@@ -110,6 +145,9 @@ static inline void Meter_displayBuffer(const Meter* this, RichString* out) {
    } else {
       RichString_writeWide(out, CRT_colors[Meter_attributes(this)[0]], this->txtBuffer);
    }
+
+   if (this->stale)
+      RichString_appendAscii(out, CRT_colors[METER_SHADOW], " (stale)");
 }
 
 void Meter_setMode(Meter* this, int modeIndex) {
@@ -129,9 +167,7 @@ void Meter_setMode(Meter* this, int modeIndex) {
       }
    } else {
       assert(modeIndex >= 1);
-      free(this->drawData.values);
-      this->drawData.values = NULL;
-      this->drawData.nValues = 0;
+      GraphData_done(&this->drawData);
 
       const MeterMode* mode = Meter_modes[modeIndex];
       this->draw = mode->draw;
@@ -159,6 +195,58 @@ ListItem* Meter_toListItem(const Meter* this, bool moving) {
    return li;
 }
 
+static uint64_t Meter_hash(uint64_t hash, const void* data, size_t size) {
+   /* FNV-1a */
+   const unsigned char* bytes = data;
+   for (size_t i = 0; i < size; i++) {
+      hash ^= bytes[i];
+      hash *= UINT64_C(0x100000001B3);
+   }
+   return hash;
+}
+
+bool Meter_drawChanged(Meter* this, int x, int y, int w) {
+   /* custom drawn meters, like those of all CPUs, draw from more than their own values */
+   if (Meter_defaultMode(this) == CUSTOM_METERMODE)
+      return true;
+
+#ifdef HAVE_LIBNCURSESW
+   const int utf8 = CRT_utf8;
+#else
+   const int utf8 = 0;
+#endif
+   const int place[] = { x, y, w, this->mode, utf8 };
+   uint64_t key = Meter_hash(UINT64_C(0xCBF29CE484222325), place, sizeof(place));
+   const char* caption = Meter_getCaption(this);
+   key = Meter_hash(key, caption, strlen(caption));
+   key = Meter_hash(key, &this->stale, sizeof(this->stale));
+
+   bool changed = false;
+   if (this->mode == GRAPH_METERMODE) {
+      /* a graph only changes with its next sample, which is taken by drawing it */
+      changed = !timercmp(&this->host->realtime, &this->drawData.time, <);
+   } else {
+      key = Meter_hash(key, &this->curItems, sizeof(this->curItems));
+      key = Meter_hash(key, &this->curAttributes, sizeof(this->curAttributes));
+      key = Meter_hash(key, &this->total, sizeof(this->total));
+      if (this->curItems)
+         key = Meter_hash(key, this->values, this->curItems * sizeof(*this->values));
+      key = Meter_hash(key, this->txtBuffer, strlen(this->txtBuffer));
+
+      /* the text and LED modes show what the meter displays, which may depend on more than the above */
+      if (this->mode != BAR_METERMODE && Object_displayFn(this)) {
+         RichString_begin(out);
+         Meter_displayBuffer(this, &out);
+         key = Meter_hash(key, out.chptr, (size_t)RichString_sizeVal(out) * sizeof(*out.chptr));
+         RichString_delete(&out);
+      }
+   }
+
+   changed |= key != this->drawnKey;
+   this->drawnKey = key;
+   return changed;
+}
+
 /* ---------- TextMeterMode ---------- */
 
 static void TextMeterMode_draw(Meter* this, int x, int y, int w) {
@@ -206,7 +294,7 @@ static void BarMeterMode_draw(Meter* this, int x, int y, int w) {
    // Pad with maximal spaces and then calculate needed starting position offset
    RichString_begin(bar);
    RichString_appendChr(&bar, 0, ' ', w);
-   RichString_appendWide(&bar, 0, this->txtBuffer);
+   RichString_appendWide(&bar, 0, this->stale ? "stale" : this->txtBuffer);
    int startPos = RichString_sizeVal(bar) - w;
    if (startPos > w) {
       // Text is too large for bar
@@ -296,6 +384,69 @@ static const char* const GraphMeterMode_dotsAscii[] = {
    /*20*/":", /*21*/":", /*22*/":"
 };
 
+const char* const* GraphMeterMode_glyphs(int* pixPerRow) {
+#ifdef HAVE_LIBNCURSESW
+   if (CRT_utf8) {
+      *pixPerRow = PIXPERROW_UTF8;
+      return GraphMeterMode_dotsUtf8;
+   }
+#endif
+
+   *pixPerRow = PIXPERROW_ASCII;
+   return GraphMeterMode_dotsAscii;
+}
+
+void Meter_appendHeatCell(RichString* out, int level) {
+   static const int colors[] = { METER_VALUE_OK, METER_VALUE_NOTICE, METER_VALUE_WARN, METER_VALUE_ERROR };
+
+   if (level < 0) {
+      RichString_appendChr(out, CRT_colors[METER_SHADOW], '.', 1);
+      return;
+   }
+
+   level = MINIMUM(level, 3);
+#ifdef HAVE_LIBNCURSESW
+   if (CRT_utf8) {
+      static const char* const shadesUtf8[] = { "░", "▒", "▓", "█" };
+      RichString_appendWide(out, CRT_colors[colors[level]], shadesUtf8[level]);
+      return;
+   }
+#endif
+
+   static const char shadesAscii[] = { ':', '-', '=', '#' };
+   RichString_appendChr(out, CRT_colors[colors[level]], shadesAscii[level], 1);
+}
+
+/* Sample i, counting from the oldest one */
+static inline uint16_t GraphData_sample(const GraphData* this, size_t i) {
+   size_t index = this->head + i;
+   if (index >= this->nValues)
+      index -= this->nValues;
+   return this->values[index];
+}
+
+/* Makes room for at least wanted samples, the older ones before the kept ones being empty */
+static void GraphData_grow(GraphData* this, size_t wanted) {
+   size_t oldNValues = this->nValues;
+   size_t nValues = MAXIMUM(oldNValues + oldNValues / 2, wanted);
+   nValues = MINIMUM(nValues, MAX_METER_GRAPHDATA_VALUES);
+
+   uint16_t* values = xCalloc(nValues, sizeof(*values));
+   uint16_t* kept = values + (nValues - oldNValues);
+   for (size_t i = 0; i < oldNValues; i++)
+      kept[i] = GraphData_sample(this, i);
+
+   free(this->values);
+   this->values = values;
+   this->nValues = nValues;
+   this->head = 0;
+}
+
+/* Height of a sample in pixels, at least one */
+static inline int GraphMeterMode_pixels(uint16_t sample, int pix) {
+   return CLAMP((int)((sample * (uint32_t)pix + GRAPH_SAMPLE_MAX / 2) / GRAPH_SAMPLE_MAX), 1, pix);
+}
+
 static void GraphMeterMode_draw(Meter* this, int x, int y, int w) {
    const char* caption = Meter_getCaption(this);
    attrset(CRT_colors[METER_TEXT]);
@@ -306,14 +457,10 @@ static void GraphMeterMode_draw(Meter* this, int x, int y, int w) {
 
    GraphData* data = &this->drawData;
    assert(data->nValues / 2 <= INT_MAX);
-   if (w > (int)(data->nValues / 2) && MAX_METER_GRAPHDATA_VALUES > data->nValues) {
-      size_t oldNValues = data->nValues;
-      data->nValues = MAXIMUM(oldNValues + oldNValues / 2, (size_t)w * 2);
-      data->nValues = MINIMUM(data->nValues, MAX_METER_GRAPHDATA_VALUES);
-      data->values = xReallocArray(data->values, data->nValues, sizeof(*data->values));
-      memmove(data->values + (data->nValues - oldNValues), data->values, oldNValues * sizeof(*data->values));
-      memset(data->values, 0, (data->nValues - oldNValues) * sizeof(*data->values));
-   }
+   /* keep room for the values not drawn yet in low bandwidth mode */
+   const size_t wanted = w > 0 ? (size_t)w * 2 + GRAPH_LOW_BANDWIDTH_VALUES : 0;
+   if (wanted > data->nValues && MAX_METER_GRAPHDATA_VALUES > data->nValues)
+      GraphData_grow(data, wanted);
 
    const size_t nValues = data->nValues;
    if (nValues < 1)
@@ -325,9 +472,17 @@ static void GraphMeterMode_draw(Meter* this, int x, int y, int w) {
       struct timeval delay = { .tv_sec = globalDelay / 10, .tv_usec = (globalDelay % 10) * 100000L };
       timeradd(&host->realtime, &delay, &(data->time));
 
-      memmove(&data->values[0], &data->values[1], (nValues - 1) * sizeof(*data->values));
-
-      data->values[nValues - 1] = sumPositiveValues(this->values, this->curItems);
+      /* the newest sample replaces the oldest one */
+      double total = MAXIMUM(this->total, 1);
+      double fraction = CLAMP(sumPositiveValues(this->values, this->curItems) / total, 0.0, 1.0);
+      data->values[data->head] = (uint16_t) lround(fraction * GRAPH_SAMPLE_MAX);
+      data->head = (data->head + 1) % nValues;
+
+      /* every graph move repaints all of its cells, so move several values at once */
+      if (host->settings->lowBandwidth)
+         data->pendingValues = (data->pendingValues + 1) % GRAPH_LOW_BANDWIDTH_VALUES;
+      else
+         data->pendingValues = 0;
    }
 
    if (w <= 0)
@@ -338,25 +493,33 @@ static void GraphMeterMode_draw(Meter* this, int x, int y, int w) {
       w = nValues / 2;
    }
 
-   const char* const* GraphMeterMode_dots;
    int GraphMeterMode_pixPerRow;
-#ifdef HAVE_LIBNCURSESW
-   if (CRT_utf8) {
-      GraphMeterMode_dots = GraphMeterMode_dotsUtf8;
-      GraphMeterMode_pixPerRow = PIXPERROW_UTF8;
-   } else
-#endif
-   {
-      GraphMeterMode_dots = GraphMeterMode_dotsAscii;
-      GraphMeterMode_pixPerRow = PIXPERROW_ASCII;
+   const char* const* GraphMeterMode_dots = GraphMeterMode_glyphs(&GraphMeterMode_pixPerRow);
+
+   const int pix = GraphMeterMode_pixPerRow * GRAPH_HEIGHT;
+   if ((size_t)w > data->nColumns || pix != data->columnsPix) {
+      data->nColumns = MAXIMUM(data->nColumns, (size_t)w);
+      free(data->columns);
+      data->columns = xCalloc(data->nColumns, sizeof(*data->columns));
+      data->columnsPix = pix;
    }
 
-   size_t i = nValues - (size_t)w * 2;
-   for (int col = 0; i < nValues - 1; i += 2, col++) {
-      int pix = GraphMeterMode_pixPerRow * GRAPH_HEIGHT;
-      double total = MAXIMUM(this->total, 1);
-      int v1 = CLAMP((int) lround(data->values[i] / total * pix), 1, pix);
-      int v2 = CLAMP((int) lround(data->values[i + 1] / total * pix), 1, pix);
+   const size_t shown = nValues - MINIMUM(data->pendingValues, nValues - (size_t)w * 2);
+   size_t i = shown - (size_t)w * 2;
+   for (int col = 0; i < shown - 1; i += 2, col++) {
+      uint16_t sample1 = GraphData_sample(data, i);
+      uint16_t sample2 = GraphData_sample(data, i + 1);
+      uint32_t samples = ((uint32_t)sample1 << 16) | sample2;
+
+      /* flat stretches, like the graphs of idle CPUs, keep the heights they were drawn with */
+      GraphColumn* column = &data->columns[col];
+      if (column->samples != samples || column->v1 == 0) {
+         column->samples = samples;
+         column->v1 = (uint8_t) GraphMeterMode_pixels(sample1, pix);
+         column->v2 = (uint8_t) GraphMeterMode_pixels(sample2, pix);
+      }
+      int v1 = column->v1;
+      int v2 = column->v2;
 
       int colorIdx = GRAPH_1;
       for (int line = 0; line < GRAPH_HEIGHT; line++) {
@@ -72,6 +72,7 @@ typedef struct MeterClass_ {
    const char* const description;          /* optional meter description in header setup menu */
    const uint8_t maxItems;
    const bool isMultiColumn;               /* whether the meter draws multiple sub-columns (defaults to false) */
+   const unsigned int slowInterval;        /* if set, updateValues may block: it runs off the UI thread, at most every that many ms; see MeterJob */
 } MeterClass;
 
 #define As_Meter(this_)                ((const MeterClass*)((this_)->super.klass))
@@ -93,10 +94,24 @@ typedef struct MeterClass_ {
 #define Meter_uiName(this_)            As_Meter(this_)->uiName
 #define Meter_isMultiColumn(this_)     As_Meter(this_)->isMultiColumn
 
+/* Largest graph sample, for a value of (at least) the meter total */
+#define GRAPH_SAMPLE_MAX UINT16_MAX
+
+/* What a graph column was last drawn from */
+typedef struct GraphColumn_ {
+   uint32_t samples;      /* both samples of the column */
+   uint8_t v1, v2;        /* their heights in pixels */
+} GraphColumn;
+
 typedef struct GraphData_ {
    struct timeval time;
    size_t nValues;
-   double* values;
+   size_t head;           /* ring buffer position of the oldest sample, the next one to be replaced */
+   uint16_t* values;      /* fractions of the meter total, scaled to GRAPH_SAMPLE_MAX */
+   size_t pendingValues;  /* recorded but not drawn yet, in low bandwidth mode */
+   GraphColumn* columns;
+   size_t nColumns;
+   int columnsPix;        /* pixels per column the heights are for, 0 if none are cached */
 } GraphData;
 
 struct Meter_ {
@@ -116,6 +131,9 @@ struct Meter_ {
    double* values;
    double total;
    void* meterData;
+   struct MeterJob_* job;     /* background updates of a slow meter */
+   bool stale;                /* values of a slow meter are overdue */
+   uint64_t drawnKey;         /* what the meter was last drawn from, see Meter_drawChanged() */
 };
 
 typedef struct MeterMode_ {
@@ -150,12 +168,33 @@ int Meter_humanUnit(char* buffer, double value, size_t size);
 
 void Meter_delete(Object* cast);
 
+/*
+ * Glyphs of the graph mode, each showing two samples side by side: the one
+ * for a left sample l and right sample r dots high is at l * (*pixPerRow + 1) + r.
+ */
+const char* const* GraphMeterMode_glyphs(int* pixPerRow);
+
+/*
+ * Appends a heatmap cell of one column: a level from 0 to 3 in growing shades
+ * and colors of alarm, or a dot for a level below 0.
+ */
+void Meter_appendHeatCell(RichString* out, int level);
+
+/* Meter_updateValues(), or for slow meters taking the values of their last background update */
+void Meter_update(Meter* this);
+
 void Meter_setCaption(Meter* this, const char* caption);
 
 void Meter_setMode(Meter* this, int modeIndex);
 
 ListItem* Meter_toListItem(const Meter* this, bool moving);
 
+/*
+ * Whether drawing the meter at x, y with width w would draw anything else than
+ * it did the last time; remembers what it is drawn from for the next call.
+ */
+bool Meter_drawChanged(Meter* this, int x, int y, int w);
+
 extern const MeterMode* const Meter_modes[];
 
 extern const MeterClass BlankMeter_class;
@@ -0,0 +1,211 @@
+/*
+htop - MeterJob.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "MeterJob.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Macros.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <signal.h>
+
+#include "Machine.h"
+#include "Object.h"
+#include "Platform.h"
+#include "XUtils.h"
+#endif
+
+
+#ifdef HAVE_PTHREAD
+
+typedef enum MeterJobState_ {
+   METERJOB_IDLE,
+   METERJOB_QUEUED,
+   METERJOB_RUNNING,
+   METERJOB_DONE,             /* the copy holds values not taken yet */
+} MeterJobState;
+
+struct MeterJob_ {
+   const MeterClass* type;
+   const Machine* host;
+   unsigned int param;
+   int mode;
+
+   /* below guarded by MeterJob_lock */
+   MeterJobState state;
+   bool deleted;
+   Meter* copy;               /* only touched by the worker, and by the UI thread once done */
+   MeterJob* next;            /* in the queue */
+
+   /* UI thread only */
+   uint64_t nextMs;           /* when the next update is due */
+   uint64_t resultMs;         /* when the last values were taken, or the job was created */
+};
+
+static pthread_mutex_t MeterJob_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t MeterJob_cond = PTHREAD_COND_INITIALIZER;
+static MeterJob* MeterJob_queueHead;
+static MeterJob* MeterJob_queueTail;
+
+/* Called with the lock held */
+static void MeterJob_enqueue(MeterJob* this) {
+   this->next = NULL;
+   if (MeterJob_queueTail)
+      MeterJob_queueTail->next = this;
+   else
+      MeterJob_queueHead = this;
+   MeterJob_queueTail = this;
+   pthread_cond_signal(&MeterJob_cond);
+}
+
+static void* MeterJob_run(ATTR_UNUSED void* data) {
+   pthread_mutex_lock(&MeterJob_lock);
+   for (;;) {
+      while (!MeterJob_queueHead)
+         pthread_cond_wait(&MeterJob_cond, &MeterJob_lock);
+
+      MeterJob* job = MeterJob_queueHead;
+      MeterJob_queueHead = job->next;
+      if (!MeterJob_queueHead)
+         MeterJob_queueTail = NULL;
+
+      bool deleted = job->deleted;
+      job->state = METERJOB_RUNNING;
+      int mode = job->mode;
+      pthread_mutex_unlock(&MeterJob_lock);
+
+      if (!deleted) {
+         if (!job->copy)
+            job->copy = Meter_new(job->host, job->param, job->type);
+
+         /* for meters whose text depends on it */
+         job->copy->mode = mode;
+         Meter_updateValues(job->copy);
+      }
+
+      pthread_mutex_lock(&MeterJob_lock);
+      if (job->deleted) {
+         pthread_mutex_unlock(&MeterJob_lock);
+         Meter_delete((Object*) job->copy);
+         free(job);
+         pthread_mutex_lock(&MeterJob_lock);
+      } else {
+         job->state = METERJOB_DONE;
+      }
+   }
+
+   return NULL;
+}
+
+static bool MeterJob_start(void) {
+   static bool started = false;
+   static bool failed = false;
+
+   if (started || failed)
+      return started;
+
+   /* signals are to be handled by the main thread only */
+   sigset_t all, old;
+   sigfillset(&all);
+   pthread_sigmask(SIG_BLOCK, &all, &old);
+
+   pthread_t thread;
+   int err = pthread_create(&thread, NULL, MeterJob_run, NULL);
+
+   pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+   if (err != 0) {
+      failed = true;
+      return false;
+   }
+
+   /* never joined: an update stuck on a hung service must not delay exiting */
+   pthread_detach(thread);
+   started = true;
+   return true;
+}
+
+MeterJob* MeterJob_new(const Meter* meter) {
+   if (!MeterJob_start())
+      return NULL;
+
+   MeterJob* this = xCalloc(1, sizeof(MeterJob));
+   this->type = As_Meter(meter);
+   this->host = meter->host;
+   this->param = meter->param;
+   this->state = METERJOB_IDLE;
+   Platform_gettime_monotonic(&this->resultMs);
+   return this;
+}
+
+void MeterJob_delete(MeterJob* this) {
+   pthread_mutex_lock(&MeterJob_lock);
+   this->deleted = true;
+   /* the copy is deleted on the worker too, some done functions share state with the updates */
+   if (this->state == METERJOB_IDLE || this->state == METERJOB_DONE) {
+      this->state = METERJOB_QUEUED;
+      MeterJob_enqueue(this);
+   }
+   pthread_mutex_unlock(&MeterJob_lock);
+}
+
+static void MeterJob_takeValues(const Meter* copy, Meter* meter) {
+   uint8_t maxItems = As_Meter(meter)->maxItems;
+   if (maxItems)
+      memcpy(meter->values, copy->values, maxItems * sizeof(*meter->values));
+   meter->curItems = copy->curItems;
+   meter->curAttributes = copy->curAttributes;
+   meter->total = copy->total;
+   memcpy(meter->txtBuffer, copy->txtBuffer, sizeof(meter->txtBuffer));
+}
+
+void MeterJob_update(MeterJob* this, Meter* meter) {
+   uint64_t now;
+   Platform_gettime_monotonic(&now);
+
+   const uint64_t interval = As_Meter(meter)->slowInterval;
+
+   pthread_mutex_lock(&MeterJob_lock);
+   if (this->state == METERJOB_DONE) {
+      MeterJob_takeValues(this->copy, meter);
+      this->resultMs = now;
+      this->state = METERJOB_IDLE;
+   }
+
+   if (this->state == METERJOB_IDLE && now >= this->nextMs) {
+      this->mode = meter->mode;
+      this->nextMs = now + interval;
+      this->state = METERJOB_QUEUED;
+      MeterJob_enqueue(this);
+   }
+   pthread_mutex_unlock(&MeterJob_lock);
+
+   /* allow an update to take as long as the interval before its values count as old */
+   meter->stale = now - this->resultMs > 2 * interval;
+}
+
+#else /* HAVE_PTHREAD */
+
+MeterJob* MeterJob_new(ATTR_UNUSED const Meter* meter) {
+   return NULL;
+}
+
+void MeterJob_delete(ATTR_UNUSED MeterJob* this) {
+}
+
+void MeterJob_update(ATTR_UNUSED MeterJob* this, ATTR_UNUSED Meter* meter) {
+}
+
+#endif /* HAVE_PTHREAD */
@@ -0,0 +1,29 @@
+#ifndef HEADER_MeterJob
+#define HEADER_MeterJob
+/*
+htop - MeterJob.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "Meter.h"
+
+
+/*
+ * Background updates of a meter whose class sets slowInterval. A copy of
+ * the meter is created, updated and deleted on a worker thread shared by
+ * all slow meters; the meter itself only takes the values of the copy.
+ */
+typedef struct MeterJob_ MeterJob;
+
+/* NULL if there are no threads, the meter is then updated inline */
+MeterJob* MeterJob_new(const Meter* meter);
+
+/* The copy is deleted, and its done function called, once a running update is over */
+void MeterJob_delete(MeterJob* this);
+
+/* Takes the values of the last finished update and starts the next one once due */
+void MeterJob_update(MeterJob* this, Meter* meter);
+
+#endif
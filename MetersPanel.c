@@ -171,6 +171,7 @@ static HandlerResult MetersPanel_eventHandler(Panel* super, int ch) {
       this->settings->changed = true;
       this->settings->lastUpdate++;
       Header_calculateHeight(header);
+      Header_updateCollectors(header);
       ScreenManager_resize(this->scr);
    }
 
@@ -9,7 +9,7 @@ in the source distribution for its full text.
 
 #include "NetworkIOMeter.h"
 
-#include <stdbool.h>
+#include <math.h>
 
 #include "CRT.h"
 #include "Machine.h"
@@ -17,6 +17,7 @@ in the source distribution for its full text.
 #include "Meter.h"
 #include "Object.h"
 #include "Platform.h"
+#include "Rate.h"
 #include "RichString.h"
 #include "Row.h"
 #include "XUtils.h"
@@ -35,78 +36,47 @@ static double cached_txb_diff;
 static char cached_txb_diff_str[6];
 static uint32_t cached_txp_diff;
 
+static Rate rxBytesRate;
+static Rate rxPacketsRate;
+static Rate txBytesRate;
+static Rate txPacketsRate;
+
 static void NetworkIOMeter_updateValues(Meter* this) {
    const Machine* host = this->host;
 
    static uint64_t cached_last_update = 0;
    uint64_t passedTimeInMs = host->realtimeMs - cached_last_update;
-   bool hasNewData = false;
    NetworkIOData data;
 
    /* update only every 500ms to have a sane span for rate calculation */
    if (passedTimeInMs > 500) {
-      hasNewData = Platform_getNetworkIO(&data);
-      if (!hasNewData) {
+      if (!Platform_getNetworkIO(&data)) {
          status = RATESTATUS_NODATA;
-      } else if (cached_last_update == 0) {
-         status = RATESTATUS_INIT;
-      } else if (passedTimeInMs > 30000) {
-         status = RATESTATUS_STALE;
+         Rate_reset(&rxBytesRate);
+         Rate_reset(&rxPacketsRate);
+         Rate_reset(&txBytesRate);
+         Rate_reset(&txPacketsRate);
       } else {
-         status = RATESTATUS_DATA;
-      }
-
-      cached_last_update = host->realtimeMs;
-   }
-
-   if (hasNewData) {
-      static uint64_t cached_rxb_total;
-      static uint64_t cached_rxp_total;
-      static uint64_t cached_txb_total;
-      static uint64_t cached_txp_total;
-
-      if (status != RATESTATUS_INIT) {
-         uint64_t diff;
-
-         if (data.bytesReceived > cached_rxb_total) {
-            diff = data.bytesReceived - cached_rxb_total;
-            diff = (1000 * diff) / passedTimeInMs; /* convert to B/s */
-            cached_rxb_diff = diff;
-         } else {
+         cached_rxb_diff = Rate_update(&rxBytesRate, data.bytesReceived, host->realtimeMs);
+         double rxp = Rate_update(&rxPacketsRate, data.packetsReceived, host->realtimeMs);
+         cached_txb_diff = Rate_update(&txBytesRate, data.bytesTransmitted, host->realtimeMs);
+         double txp = Rate_update(&txPacketsRate, data.packetsTransmitted, host->realtimeMs);
+
+         /* an interface gone since the last read lowers the totals, begin anew */
+         if (isnan(cached_rxb_diff) || isnan(rxp) || isnan(cached_txb_diff) || isnan(txp)) {
+            status = RATESTATUS_INIT;
             cached_rxb_diff = 0;
-         }
-         Meter_humanUnit(cached_rxb_diff_str, cached_rxb_diff / ONE_K, sizeof(cached_rxb_diff_str));
-
-         if (data.packetsReceived > cached_rxp_total) {
-            diff = data.packetsReceived - cached_rxp_total;
-            diff = (1000 * diff) / passedTimeInMs; /* convert to pkts/s */
-            cached_rxp_diff = (uint32_t)diff;
-         } else {
-            cached_rxp_diff = 0;
-         }
-
-         if (data.bytesTransmitted > cached_txb_total) {
-            diff = data.bytesTransmitted - cached_txb_total;
-            diff = (1000 * diff) / passedTimeInMs; /* convert to B/s */
-            cached_txb_diff = diff;
-         } else {
             cached_txb_diff = 0;
-         }
-         Meter_humanUnit(cached_txb_diff_str, cached_txb_diff / ONE_K, sizeof(cached_txb_diff_str));
-
-         if (data.packetsTransmitted > cached_txp_total) {
-            diff = data.packetsTransmitted - cached_txp_total;
-            diff = (1000 * diff) / passedTimeInMs; /* convert to pkts/s */
-            cached_txp_diff = (uint32_t)diff;
          } else {
-            cached_txp_diff = 0;
+            status = passedTimeInMs > 30000 ? RATESTATUS_STALE : RATESTATUS_DATA;
+            cached_rxp_diff = (uint32_t)rxp;
+            cached_txp_diff = (uint32_t)txp;
+            Meter_humanUnit(cached_rxb_diff_str, cached_rxb_diff / ONE_K, sizeof(cached_rxb_diff_str));
+            Meter_humanUnit(cached_txb_diff_str, cached_txb_diff / ONE_K, sizeof(cached_txb_diff_str));
          }
       }
 
-      cached_rxb_total = data.bytesReceived;
-      cached_rxp_total = data.packetsReceived;
-      cached_txb_total = data.bytesTransmitted;
-      cached_txp_total = data.packetsTransmitted;
+      cached_last_update = host->realtimeMs;
    }
 
    this->values[0] = cached_rxb_diff;
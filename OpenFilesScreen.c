@@ -20,10 +20,11 @@ in the source distribution for its full text.
 #include <sys/wait.h>
 #include <sys/stat.h>
 
+#include "LineStore.h"
 #include "Macros.h"
 #include "Panel.h"
+#include "Platform.h"
 #include "ProvideCurses.h"
-#include "Vector.h"
 #include "XUtils.h"
 
 
@@ -108,6 +109,7 @@ static OpenFiles_ProcessData* OpenFilesScreen_getProcessData(pid_t pid) {
    }
 
    if (child == 0) {
+      restoreFileLimit();
       close(fdpair[0]);
       dup2(fdpair[1], STDOUT_FILENO);
       close(fdpair[1]);
@@ -239,10 +241,49 @@ static void OpenFiles_Data_clear(OpenFiles_Data* data) {
       free(data->data[i]);
 }
 
-static void OpenFilesScreen_scan(InfoScreen* this) {
-   Panel* panel = this->display;
-   int idx = Panel_getSelectedIndex(panel);
-   Panel_prune(panel);
+static void OpenFilesScreen_addEntry(InfoScreen* this, const char* fd, const char* type, const char* mode, const char* device, const char* size, const char* offset, const char* node, const char* name) {
+   char* entry = NULL;
+   xAsprintf(&entry, "%5.5s %-7.7s %-4.4s %-10.10s %10.10s %10.10s %10.10s  %s",
+             fd, type, mode, device, size, offset, node, name);
+   InfoScreen_addLine(this, entry);
+   free(entry);
+}
+
+/* While a long listing is read, what there is so far is shown every this many milliseconds */
+#define OPENFILES_DRAW_INTERVAL_MS 200
+
+static void OpenFilesScreen_addFile(void* context, const OpenFiles_FileInfo* file) {
+   OpenFilesScreen* this = context;
+
+   char fd[12];
+   char mode[2] = { file->mode, '\0' };
+   char device[24] = "";
+   char size[21] = "";
+   char offset[21] = "";
+   xSnprintf(fd, sizeof(fd), "%d", file->fd);
+   if (file->hasDevice)
+      xSnprintf(device, sizeof(device), "%u,%u", file->devMajor, file->devMinor);
+   if (file->hasSize)
+      xSnprintf(size, sizeof(size), "%"PRIu64, file->size);
+   if (file->hasOffset)
+      xSnprintf(offset, sizeof(offset), "%"PRIu64, file->offset);
+
+   OpenFilesScreen_addEntry(&this->super, fd, file->type, mode, device, size, offset, file->node ? file->node : "", file->name);
+
+   if (++this->added % 256)
+      return;
+
+   uint64_t now;
+   Platform_gettime_monotonic(&now);
+   if (now - this->drawnAt < OPENFILES_DRAW_INTERVAL_MS)
+      return;
+
+   this->drawnAt = now;
+   InfoScreen_draw(this);
+   refresh();
+}
+
+static void OpenFilesScreen_scanLsof(InfoScreen* this) {
    OpenFiles_ProcessData* pdata = OpenFilesScreen_getProcessData(((OpenFilesScreen*)this)->pid);
    if (pdata->error == 127) {
       InfoScreen_addLine(this, "Could not execute 'lsof'. Please make sure it is available in your $PATH.");
@@ -252,18 +293,15 @@ static void OpenFilesScreen_scan(InfoScreen* this) {
       OpenFiles_FileData* fdata = pdata->files;
       while (fdata) {
          OpenFiles_Data* data = &fdata->data;
-         char* entry = NULL;
-         xAsprintf(&entry, "%5.5s %-7.7s %-4.4s %-10.10s %10.10s %10.10s %10.10s  %s",
-                   getDataForType(data, 'f'),
-                   getDataForType(data, 't'),
-                   getDataForType(data, 'a'),
-                   getDataForType(data, 'D'),
-                   getDataForType(data, 's'),
-                   getDataForType(data, 'o'),
-                   getDataForType(data, 'i'),
-                   getDataForType(data, 'n'));
-         InfoScreen_addLine(this, entry);
-         free(entry);
+         OpenFilesScreen_addEntry(this,
+                                  getDataForType(data, 'f'),
+                                  getDataForType(data, 't'),
+                                  getDataForType(data, 'a'),
+                                  getDataForType(data, 'D'),
+                                  getDataForType(data, 's'),
+                                  getDataForType(data, 'o'),
+                                  getDataForType(data, 'i'),
+                                  getDataForType(data, 'n'));
          OpenFiles_Data_clear(data);
          OpenFiles_FileData* old = fdata;
          fdata = fdata->next;
@@ -272,8 +310,21 @@ static void OpenFilesScreen_scan(InfoScreen* this) {
       OpenFiles_Data_clear(&pdata->data);
    }
    free(pdata);
-   Vector_insertionSort(this->lines);
-   Vector_insertionSort(panel->items);
+}
+
+static void OpenFilesScreen_scan(InfoScreen* this) {
+   OpenFilesScreen* ofs = (OpenFilesScreen*)this;
+   Panel* panel = this->display;
+   int idx = Panel_getSelectedIndex(panel);
+   Panel_prune(panel);
+
+   /* lsof where the platform cannot list the files itself */
+   ofs->added = 0;
+   Platform_gettime_monotonic(&ofs->drawnAt);
+   if (!Platform_getProcessOpenFiles(ofs->pid, OpenFilesScreen_addFile, ofs))
+      OpenFilesScreen_scanLsof(this);
+
+   LineStore_sort(this->lines);
    Panel_setSelected(panel, idx);
 }
 
@@ -7,6 +7,8 @@ Released under the GNU GPLv2+, see the COPYING file
 in the source distribution for its full text.
 */
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <sys/types.h>
 
 #include "InfoScreen.h"
@@ -17,8 +19,29 @@ in the source distribution for its full text.
 typedef struct OpenFilesScreen_ {
    InfoScreen super;
    pid_t pid;
+   size_t added;            /* files listed by the current scan */
+   uint64_t drawnAt;        /* monotonic time the partial listing was last drawn at */
 } OpenFilesScreen;
 
+/* A file open in a process, as read by the platform itself */
+typedef struct OpenFiles_FileInfo_ {
+   int fd;
+   char mode;               /* 'r', 'w' or 'u' as lsof reports it, '\0' if unknown */
+   const char* type;        /* as lsof names it, e.g. "REG" or "IPv4" */
+   bool hasDevice;
+   unsigned int devMajor;
+   unsigned int devMinor;
+   bool hasSize;
+   uint64_t size;
+   bool hasOffset;
+   uint64_t offset;
+   const char* node;        /* inode number or protocol, may be NULL */
+   const char* name;
+} OpenFiles_FileInfo;
+
+/* Called for every file as it is read, with the screen as context */
+typedef void (*OpenFiles_AddFile)(void* context, const OpenFiles_FileInfo* file);
+
 extern const InfoScreenClass OpenFilesScreen_class;
 
 OpenFilesScreen* OpenFilesScreen_new(const Process* process);
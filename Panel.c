@@ -11,6 +11,7 @@ in the source distribution for its full text.
 
 #include <assert.h>
 #include <ctype.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -55,12 +56,17 @@ void Panel_init(Panel* this, int x, int y, int w, int h, const ObjectClass* type
    this->cursorY = 0;
    this->eventHandlerState = NULL;
    this->items = Vector_new(type, owner, DEFAULT_SIZE);
+   this->sourceCount = NULL;
+   this->sourceGet = NULL;
+   this->sourceData = NULL;
    this->scrollV = 0;
    this->scrollH = 0;
    this->selected = 0;
    this->oldSelected = 0;
    this->selectedLen = 0;
    this->needsRedraw = true;
+   this->dirtyFirst = INT_MAX;
+   this->dirtyLast = -1;
    this->cursorOn = false;
    this->wasFocus = false;
    RichString_beginAllocated(this->header);
@@ -117,8 +123,35 @@ void Panel_prune(Panel* this) {
    this->needsRedraw = true;
 }
 
+/*
+ * Shows the items of a source instead of the panel's own: only the ones on
+ * screen are ever looked at. The owner of the source marks the items it
+ * replaced with Panel_markDirty; the selection and scroll position are kept.
+ */
+void Panel_setSource(Panel* this, Panel_SourceCount count, Panel_SourceGet get, const void* data) {
+   assert (this != NULL);
+   assert (count != NULL && get != NULL);
+
+   if (this->sourceCount == count && this->sourceGet == get && this->sourceData == data)
+      return;
+
+   Vector_prune(this->items);
+   this->sourceCount = count;
+   this->sourceGet = get;
+   this->sourceData = data;
+   this->needsRedraw = true;
+}
+
+void Panel_markDirty(Panel* this, int i) {
+   assert (this != NULL);
+
+   this->dirtyFirst = MINIMUM(this->dirtyFirst, i);
+   this->dirtyLast = MAXIMUM(this->dirtyLast, i);
+}
+
 void Panel_add(Panel* this, Object* o) {
    assert (this != NULL);
+   assert (!Panel_isVirtual(this));
 
    Vector_add(this->items, o);
    this->needsRedraw = true;
@@ -126,6 +159,7 @@ void Panel_add(Panel* this, Object* o) {
 
 void Panel_insert(Panel* this, int i, Object* o) {
    assert (this != NULL);
+   assert (!Panel_isVirtual(this));
 
    Vector_insert(this->items, i, o);
    this->needsRedraw = true;
@@ -133,18 +167,52 @@ void Panel_insert(Panel* this, int i, Object* o) {
 
 void Panel_set(Panel* this, int i, Object* o) {
    assert (this != NULL);
+   assert (!Panel_isVirtual(this));
 
    Vector_set(this->items, i, o);
+   Panel_markDirty(this, i);
 }
 
 Object* Panel_get(Panel* this, int i) {
    assert (this != NULL);
 
+   if (this->sourceGet) {
+      assert (i >= 0 && i < this->sourceCount(this->sourceData));
+      return this->sourceGet(this->sourceData, i);
+   }
+
    return Vector_get(this->items, i);
 }
 
+// Compares addresses only, the item there may have been freed meanwhile
+bool Panel_hasItemAt(const Panel* this, int i, const Object* o) {
+   assert (this != NULL);
+
+   if (this->sourceGet)
+      return i >= 0 && i < this->sourceCount(this->sourceData) && this->sourceGet(this->sourceData, i) == o;
+
+   return i >= 0 && i < Vector_size(this->items) && this->items->array[i] == o;
+}
+
+void Panel_truncate(Panel* this, int size) {
+   assert (this != NULL);
+   assert (size >= 0);
+   assert (!Panel_isVirtual(this));
+
+   while (Vector_size(this->items) > size)
+      Vector_remove(this->items, Vector_size(this->items) - 1);
+
+   if (this->selected > 0 && this->selected >= size)
+      this->selected = MAXIMUM(size - 1, 0);
+   if (this->oldSelected >= size)
+      this->oldSelected = this->selected;
+
+   this->needsRedraw = true;
+}
+
 Object* Panel_remove(Panel* this, int i) {
    assert (this != NULL);
+   assert (!Panel_isVirtual(this));
 
    this->needsRedraw = true;
    Object* removed = Vector_remove(this->items, i);
@@ -157,8 +225,8 @@ Object* Panel_remove(Panel* this, int i) {
 
 Object* Panel_getSelected(Panel* this) {
    assert (this != NULL);
-   if (Vector_size(this->items) > 0) {
-      return Vector_get(this->items, this->selected);
+   if (Panel_size(this) > 0) {
+      return Panel_get(this, this->selected);
    } else {
       return NULL;
    }
@@ -166,6 +234,7 @@ Object* Panel_getSelected(Panel* this) {
 
 void Panel_moveSelectedUp(Panel* this) {
    assert (this != NULL);
+   assert (!Panel_isVirtual(this));
 
    Vector_moveUp(this->items, this->selected);
    if (this->selected > 0) {
@@ -175,6 +244,7 @@ void Panel_moveSelectedUp(Panel* this) {
 
 void Panel_moveSelectedDown(Panel* this) {
    assert (this != NULL);
+   assert (!Panel_isVirtual(this));
 
    Vector_moveDown(this->items, this->selected);
    if (this->selected + 1 < Vector_size(this->items)) {
@@ -191,13 +261,16 @@ int Panel_getSelectedIndex(const Panel* this) {
 int Panel_size(const Panel* this) {
    assert (this != NULL);
 
+   if (this->sourceCount)
+      return this->sourceCount(this->sourceData);
+
    return Vector_size(this->items);
 }
 
 void Panel_setSelected(Panel* this, int selected) {
    assert (this != NULL);
 
-   int size = Vector_size(this->items);
+   int size = Panel_size(this);
    if (selected >= size) {
       selected = size - 1;
    }
@@ -213,15 +286,38 @@ void Panel_setSelected(Panel* this, int selected) {
 void Panel_splice(Panel* this, Vector* from) {
    assert (this != NULL);
    assert (from != NULL);
+   assert (!Panel_isVirtual(this));
 
    Vector_splice(this->items, from);
    this->needsRedraw = true;
 }
 
+static void Panel_drawItem(Panel* this, int i, int y, bool highlightSelected, int selectionColor) {
+   const Object* itemObj = Panel_get(this, i);
+   RichString_begin(item);
+   Object_display(itemObj, &item);
+   int itemLen = RichString_sizeVal(item);
+   int amt = MINIMUM(itemLen - this->scrollH, this->w);
+   if (highlightSelected && i == this->selected) {
+      item.highlightAttr = selectionColor;
+   }
+   if (item.highlightAttr) {
+      attrset(item.highlightAttr);
+      RichString_setAttr(&item, item.highlightAttr);
+      this->selectedLen = itemLen;
+   }
+   mvhline(y, this->x, ' ', this->w);
+   if (amt > 0)
+      RichString_printoffnVal(item, y, this->x, this->scrollH, amt);
+   if (item.highlightAttr)
+      attrset(CRT_colors[RESET_COLOR]);
+   RichString_delete(&item);
+}
+
 void Panel_draw(Panel* this, bool force_redraw, bool focus, bool highlightSelected, bool hideFunctionBar) {
    assert (this != NULL);
 
-   int size = Vector_size(this->items);
+   int size = Panel_size(this);
    int scrollH = this->scrollH;
    int y = this->y;
    int x = this->x;
@@ -279,25 +375,7 @@ void Panel_draw(Panel* this, bool force_redraw, bool focus, bool highlightSelect
    if (this->needsRedraw || force_redraw) {
       int line = 0;
       for (int i = first; line < h && i < upTo; i++) {
-         const Object* itemObj = Vector_get(this->items, i);
-         RichString_begin(item);
-         Object_display(itemObj, &item);
-         int itemLen = RichString_sizeVal(item);
-         int amt = MINIMUM(itemLen - scrollH, this->w);
-         if (highlightSelected && i == this->selected) {
-            item.highlightAttr = selectionColor;
-         }
-         if (item.highlightAttr) {
-            attrset(item.highlightAttr);
-            RichString_setAttr(&item, item.highlightAttr);
-            this->selectedLen = itemLen;
-         }
-         mvhline(y + line, x, ' ', this->w);
-         if (amt > 0)
-            RichString_printoffnVal(item, y + line, x, scrollH, amt);
-         if (item.highlightAttr)
-            attrset(CRT_colors[RESET_COLOR]);
-         RichString_delete(&item);
+         Panel_drawItem(this, i, y + line, highlightSelected, selectionColor);
          line++;
       }
       while (line < h) {
@@ -305,12 +383,16 @@ void Panel_draw(Panel* this, bool force_redraw, bool focus, bool highlightSelect
          line++;
       }
 
-   } else {
-      const Object* oldObj = Vector_get(this->items, this->oldSelected);
+   } else if (size > 0) {
+      // Repaint the replaced items, then the old and new selection
+      for (int i = MAXIMUM(this->dirtyFirst, first); i <= this->dirtyLast && i < upTo; i++)
+         Panel_drawItem(this, i, y + i - first, highlightSelected, selectionColor);
+
+      const Object* oldObj = Panel_get(this, this->oldSelected);
       RichString_begin(old);
       Object_display(oldObj, &old);
       int oldLen = RichString_sizeVal(old);
-      const Object* newObj = Vector_get(this->items, this->selected);
+      const Object* newObj = Panel_get(this, this->selected);
       RichString_begin(new);
       Object_display(newObj, &new);
       int newLen = RichString_sizeVal(new);
@@ -340,6 +422,8 @@ void Panel_draw(Panel* this, bool force_redraw, bool focus, bool highlightSelect
    this->oldSelected = this->selected;
    this->wasFocus = focus;
    this->needsRedraw = false;
+   this->dirtyFirst = INT_MAX;
+   this->dirtyLast = -1;
 }
 
 static int Panel_headerHeight(const Panel* this) {
@@ -349,7 +433,7 @@ static int Panel_headerHeight(const Panel* this) {
 bool Panel_onKey(Panel* this, int key) {
    assert (this != NULL);
 
-   const int size = Vector_size(this->items);
+   const int size = Panel_size(this);
 
    #define PANEL_SCROLL(amount)                                                                                     \
    do {                                                                                                             \
@@ -501,7 +585,7 @@ HandlerResult Panel_selectByTyping(Panel* this, int ch) {
    return IGNORED;
 }
 
-int Panel_getCh(Panel* this) {
+int Panel_getCh(Panel* this, int timeoutMs) {
    if (this->cursorOn) {
       move(this->cursorY, this->cursorX);
       curs_set(1);
@@ -511,5 +595,6 @@ int Panel_getCh(Panel* this) {
 #ifdef HAVE_SET_ESCDELAY
    set_escdelay(25);
 #endif
-   return getch();
+   CRT_updateScreen();
+   return CRT_getCh(timeoutMs);
 }
@@ -45,6 +45,10 @@ typedef HandlerResult (*Panel_EventHandler)(Panel*, int);
 typedef void (*Panel_DrawFunctionBar)(Panel*, bool);
 typedef void (*Panel_PrintHeader)(Panel*);
 
+/* Items kept elsewhere, shown without being copied into the panel; see Panel_setSource */
+typedef int (*Panel_SourceCount)(const void* data);
+typedef Object* (*Panel_SourceGet)(const void* data, int i);
+
 typedef struct PanelClass_ {
    const ObjectClass super;
    const Panel_EventHandler eventHandler;
@@ -65,6 +69,9 @@ struct Panel_ {
    int x, y, w, h;
    int cursorX, cursorY;
    Vector* items;
+   Panel_SourceCount sourceCount;  /* when set, the items come from the source */
+   Panel_SourceGet sourceGet;      /* and the items vector stays empty */
+   const void* sourceData;
    int selected;
    int oldSelected;
    int selectedLen;
@@ -72,6 +79,8 @@ struct Panel_ {
    int scrollV;
    int scrollH;
    bool needsRedraw;
+   int dirtyFirst;        /* range of items replaced since the last draw, */
+   int dirtyLast;         /* repainted without a full redraw; empty if dirtyFirst > dirtyLast */
    bool cursorOn;
    bool wasFocus;
    FunctionBar* currentBar;
@@ -106,6 +115,14 @@ void Panel_resize(Panel* this, int w, int h);
 
 void Panel_prune(Panel* this);
 
+void Panel_setSource(Panel* this, Panel_SourceCount count, Panel_SourceGet get, const void* data);
+
+static inline bool Panel_isVirtual(const Panel* this) {
+   return this->sourceCount != NULL;
+}
+
+void Panel_markDirty(Panel* this, int i);
+
 void Panel_add(Panel* this, Object* o);
 
 void Panel_insert(Panel* this, int i, Object* o);
@@ -114,6 +131,10 @@ void Panel_set(Panel* this, int i, Object* o);
 
 Object* Panel_get(Panel* this, int i);
 
+bool Panel_hasItemAt(const Panel* this, int i, const Object* o);
+
+void Panel_truncate(Panel* this, int size);
+
 Object* Panel_remove(Panel* this, int i);
 
 Object* Panel_getSelected(Panel* this);
@@ -136,6 +157,7 @@ bool Panel_onKey(Panel* this, int key);
 
 HandlerResult Panel_selectByTyping(Panel* this, int ch);
 
-int Panel_getCh(Panel* this);
+/* Updates the screen and waits for a key, see CRT_getCh() */
+int Panel_getCh(Panel* this, int timeoutMs);
 
 #endif
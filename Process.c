@@ -8,9 +8,12 @@ in the source distribution for its full text.
 
 #include "config.h" // IWYU pragma: keep
 
+#define HEAP_CLASS HEAP_PROCESSES
+
 #include "Process.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <math.h>
 #include <signal.h>
 #include <stdbool.h>
@@ -18,9 +21,11 @@ in the source distribution for its full text.
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <wchar.h>
 #include <sys/resource.h>
 
 #include "CRT.h"
+#include "FilterMatcher.h"
 #include "Hashtable.h"
 #include "Machine.h"
 #include "Macros.h"
@@ -29,6 +34,8 @@ in the source distribution for its full text.
 #include "RichString.h"
 #include "Scheduling.h"
 #include "Settings.h"
+#include "StringPool.h"
+#include "StringRank.h"
 #include "Table.h"
 #include "XUtils.h"
 
@@ -173,14 +180,11 @@ static inline char* stpcpyWithNewlineConversion(char* dstStr, const char* srcStr
 }
 
 /*
- * This function makes the merged Command string. It also stores the offsets of the
- * basename, comm w.r.t the merged Command string - these offsets will be used by
- * Process_writeCommand() for coloring. The merged Command string is also
- * returned by Process_getCommand() for searching, sorting and filtering.
+ * Writes the merged Command string of the process to strStart, which has
+ * room for it, and the portions to highlight to highlights, of which it
+ * returns the count.
  */
-void Process_makeCommandStr(Process* this, const Settings* settings) {
-   ProcessMergedCommand* mc = &this->mergedCommand;
-
+static size_t Process_buildCommandStr(const Process* this, const Settings* settings, char* strStart, ProcessCmdlineHighlight* highlights) {
    bool showMergedCommand = settings->showMergedCommand;
    bool showProgramPath = settings->showProgramPath;
    bool searchCommInCmdline = settings->findCommInCmdline;
@@ -188,55 +192,25 @@ void Process_makeCommandStr(Process* this, const Settings* settings) {
    bool showThreadNames = settings->showThreadNames;
    bool shadowDistPathPrefix = settings->shadowDistPathPrefix;
 
-   uint64_t settingsStamp = settings->lastUpdate;
-
-   /* Nothing to do to (Re)Generate the Command string, if the process is:
-    * - a kernel thread, or
-    * - a zombie from before being under htop's watch, or
-    * - a user thread and showThreadNames is not set */
-   if (Process_isKernelThread(this))
-      return;
-   if (this->state == ZOMBIE && !this->mergedCommand.str)
-      return;
-
-   /* this->mergedCommand.str needs updating only if its state or contents changed.
-    * Its content is based on the fields cmdline, comm, and exe. */
-   if (mc->lastUpdate >= settingsStamp)
-      return;
-
-   mc->lastUpdate = settingsStamp;
-
    /* The field separator "│" has been chosen such that it will not match any
     * valid string used for searching or filtering */
    const char* SEPARATOR = CRT_treeStr[TREE_STR_VERT];
    const int SEPARATOR_LEN = strlen(SEPARATOR);
 
-   /* Accommodate the column text, two field separators and terminating NUL */
-   size_t maxLen = 2 * SEPARATOR_LEN + 1;
-   maxLen += this->cmdline ? strlen(this->cmdline) : strlen("(zombie)");
-   maxLen += this->procComm ? strlen(this->procComm) : 0;
-   maxLen += this->procExe ? strlen(this->procExe) : 0;
-
-   free(mc->str);
-   mc->str = xCalloc(1, maxLen);
-
-   /* Reset all locations that need extra handling when actually displaying */
-   mc->highlightCount = 0;
-   memset(mc->highlights, 0, sizeof(mc->highlights));
-
+   size_t highlightCount = 0;
    size_t mbMismatch = 0;
    #define WRITE_HIGHLIGHT(_offset, _length, _attr, _flags)                                   \
       do {                                                                                    \
          /* Check if we still have capacity */                                                \
-         assert(mc->highlightCount < ARRAYSIZE(mc->highlights));                              \
-         if (mc->highlightCount >= ARRAYSIZE(mc->highlights))                                 \
+         assert(highlightCount < PROCESS_MAX_HIGHLIGHTS);                                     \
+         if (highlightCount >= PROCESS_MAX_HIGHLIGHTS)                                        \
             break;                                                                            \
                                                                                               \
-         mc->highlights[mc->highlightCount].offset = str - strStart + (_offset) - mbMismatch; \
-         mc->highlights[mc->highlightCount].length = _length;                                 \
-         mc->highlights[mc->highlightCount].attr = _attr;                                     \
-         mc->highlights[mc->highlightCount].flags = _flags;                                   \
-         mc->highlightCount++;                                                                \
+         highlights[highlightCount].offset = str - strStart + (_offset) - mbMismatch;         \
+         highlights[highlightCount].length = _length;                                         \
+         highlights[highlightCount].attr = _attr;                                             \
+         highlights[highlightCount].flags = _flags;                                           \
+         highlightCount++;                                                                    \
       } while (0)
 
    #define WRITE_SEPARATOR                                                                    \
@@ -306,7 +280,6 @@ void Process_makeCommandStr(Process* this, const Settings* settings) {
    const char* procComm = this->procComm;
    const char* procExe = this->procExe;
 
-   char* strStart = mc->str;
    char* str = strStart;
 
    int cmdlineBasenameStart = this->cmdlineBasenameStart;
@@ -328,7 +301,7 @@ void Process_makeCommandStr(Process* this, const Settings* settings) {
             str = stpcpy(str, procComm);
 
             if (!showMergedCommand)
-               return;
+               return highlightCount;
 
             WRITE_SEPARATOR;
          }
@@ -347,7 +320,7 @@ void Process_makeCommandStr(Process* this, const Settings* settings) {
 
       (void)stpcpyWithNewlineConversion(str, cmdline + (showProgramPath ? 0 : cmdlineBasenameStart));
 
-      return;
+      return highlightCount;
    }
 
    int exeLen = strlen(this->procExe);
@@ -437,6 +410,103 @@ void Process_makeCommandStr(Process* this, const Settings* settings) {
    #undef CHECK_AND_MARK
    #undef WRITE_SEPARATOR
    #undef WRITE_HIGHLIGHT
+
+   return highlightCount;
+}
+
+/*
+ * This function makes the merged Command string. It also stores the offsets of the
+ * basename, comm w.r.t the merged Command string - these offsets will be used by
+ * Process_writeCommand() for coloring. The merged Command string is also
+ * returned by Process_getCommand() for searching, sorting and filtering.
+ *
+ * The string is built in a scratch buffer and then interned together with its
+ * highlights, so processes showing the same command share one copy, and keep
+ * the same pointer when it is built again unchanged.
+ */
+void Process_makeCommandStr(Process* this, const Settings* settings) {
+   static char* buffer;
+   static size_t bufferSize;
+
+   ProcessMergedCommand* mc = &this->mergedCommand;
+
+   uint64_t settingsStamp = settings->lastUpdate;
+
+   /* Nothing to do to (Re)Generate the Command string, if the process is:
+    * - a kernel thread, or
+    * - a zombie from before being under htop's watch, or
+    * - a user thread and showThreadNames is not set */
+   if (Process_isKernelThread(this))
+      return;
+   if (this->state == ZOMBIE && !this->mergedCommand.str)
+      return;
+
+   /* this->mergedCommand.str needs updating only if its state or contents changed.
+    * Its content is based on the fields cmdline, comm, and exe. */
+   if (mc->lastUpdate >= settingsStamp)
+      return;
+
+   mc->lastUpdate = settingsStamp;
+
+   /* Accommodate the column text, two field separators and terminating NUL */
+   size_t maxLen = 2 * strlen(CRT_treeStr[TREE_STR_VERT]) + 1;
+   maxLen += this->cmdline ? strlen(this->cmdline) : strlen("(zombie)");
+   maxLen += this->procComm ? strlen(this->procComm) : 0;
+   maxLen += this->procExe ? strlen(this->procExe) : 0;
+
+   const size_t hlSize = sizeof(ProcessCmdlineHighlight);
+   const size_t needed = (maxLen + hlSize - 1) / hlSize * hlSize + PROCESS_MAX_HIGHLIGHTS * hlSize;
+   if (needed > bufferSize) {
+      bufferSize = MAXIMUM(needed, 2 * bufferSize);
+      free(buffer);
+      buffer = xMalloc(bufferSize);
+   }
+
+   /* Unused bytes take part in the comparison of interned entries */
+   memset(buffer, 0, needed);
+   ProcessCmdlineHighlight* highlights = (ProcessCmdlineHighlight*)(void*)(buffer + needed - PROCESS_MAX_HIGHLIGHTS * hlSize);
+   const size_t highlightCount = Process_buildCommandStr(this, settings, buffer, highlights);
+
+   /* The highlights follow the string in its entry, so rows whose command is never built carry none */
+   const size_t strSize = (strlen(buffer) + hlSize) / hlSize * hlSize;
+   memmove(buffer + strSize, highlights, highlightCount * hlSize);
+   const char* str = StringPool_intern(buffer, strSize + highlightCount * hlSize);
+
+   if (str == mc->str) {
+      StringPool_release(str);
+   } else {
+      StringPool_release(mc->str);
+      mc->str = str;
+      this->commandGeneration++;
+   }
+   mc->highlightCount = highlightCount;
+   mc->highlights = (const ProcessCmdlineHighlight*)(const void*)(str + strSize);
+}
+
+/* Appends no more than the first `chars` characters of `text`, without converting the rest */
+static void Process_appendVisible(RichString* str, int attr, const char* text, int chars) {
+   if (chars == INT_MAX) {
+      RichString_appendWide(str, attr, text);
+      return;
+   }
+
+#ifdef HAVE_LIBNCURSESW
+   mbstate_t ps;
+   memset(&ps, 0, sizeof(ps));
+   size_t at = 0;
+   for (int i = 0; i < chars && text[at]; i++) {
+      size_t n = mbrlen(text + at, MB_CUR_MAX, &ps);
+      if (n == (size_t)-1 || n == (size_t)-2) {
+         /* not valid in the locale, handled like the full text */
+         RichString_appendWide(str, attr, text);
+         return;
+      }
+      at += n;
+   }
+   RichString_appendnWide(str, attr, text, (int)at);
+#else
+   RichString_appendnWide(str, attr, text, (int)strnlen(text, (size_t)chars));
+#endif
 }
 
 void Process_writeCommand(const Process* this, int attr, int baseAttr, RichString* str) {
@@ -447,6 +517,10 @@ void Process_writeCommand(const Process* this, int attr, int baseAttr, RichStrin
 
    int strStart = RichString_size(str);
 
+   /* Long command lines are cut at the right edge of the panel, highlights past it fall off */
+   const int limit = Row_displayLimit(&this->super);
+   const int visible = limit == INT_MAX ? INT_MAX : MAXIMUM(limit - strStart, 0);
+
    const Settings* settings = this->super.host->settings;
    const bool highlightBaseName = settings->highlightBaseName;
    const bool highlightSeparator = true;
@@ -476,7 +550,7 @@ void Process_writeCommand(const Process* this, int attr, int baseAttr, RichStrin
          }
       }
 
-      RichString_appendWide(str, attr, cmdline);
+      Process_appendVisible(str, attr, cmdline, visible);
 
       if (settings->highlightBaseName) {
          RichString_setAttrn(str, baseAttr, strStart, len);
@@ -485,9 +559,9 @@ void Process_writeCommand(const Process* this, int attr, int baseAttr, RichStrin
       return;
    }
 
-   RichString_appendWide(str, attr, mergedCommand);
+   Process_appendVisible(str, attr, mergedCommand, visible);
 
-   for (size_t i = 0, hlCount = CLAMP(mc->highlightCount, 0, ARRAYSIZE(mc->highlights)); i < hlCount; i++) {
+   for (size_t i = 0, hlCount = CLAMP(mc->highlightCount, 0, PROCESS_MAX_HIGHLIGHTS); i < hlCount; i++) {
       const ProcessCmdlineHighlight* hl = &mc->highlights[i];
 
       if (!hl->length)
@@ -513,7 +587,7 @@ void Process_writeCommand(const Process* this, int attr, int baseAttr, RichStrin
    }
 }
 
-static inline char processStateChar(ProcessState state) {
+char Process_stateChar(ProcessState state) {
    switch (state) {
       case UNKNOWN: return '?';
       case RUNNABLE: return 'U';
@@ -559,33 +633,12 @@ void Process_writeField(const Process* this, RichString* str, RowField field) {
          baseattr = CRT_colors[PROCESS_THREAD_BASENAME];
       }
       const ScreenSettings* ss = settings->ss;
-      if (!ss->treeView || super->indent == 0) {
+      if (!ss->treeView) {
          Process_writeCommand(this, attr, baseattr, str);
          return;
       }
 
-      char* buf = buffer;
-      const bool lastItem = (super->indent < 0);
-
-      for (uint32_t indent = (super->indent < 0 ? -super->indent : super->indent); indent > 1; indent >>= 1) {
-         int written, ret;
-         if (indent & 1U) {
-            ret = xSnprintf(buf, n, "%s  ", CRT_treeStr[TREE_STR_VERT]);
-         } else {
-            ret = xSnprintf(buf, n, "   ");
-         }
-         if (ret < 0 || (size_t)ret >= n) {
-            written = n;
-         } else {
-            written = ret;
-         }
-         buf += written;
-         n -= written;
-      }
-
-      const char* draw = CRT_treeStr[lastItem ? TREE_STR_BEND : TREE_STR_RTEE];
-      xSnprintf(buf, n, "%s%s ", draw, super->showChildren ? CRT_treeStr[TREE_STR_SHUT] : CRT_treeStr[TREE_STR_OPEN] );
-      RichString_appendWide(str, CRT_colors[PROCESS_TREE], buffer);
+      Row_printTreeBranch(super, str);
       Process_writeCommand(this, attr, baseattr, str);
       return;
    }
@@ -635,6 +688,42 @@ void Process_writeField(const Process* this, RichString* str, RowField field) {
       Row_printLeftAlignedField(str, attr, cwd, 25);
       return;
    }
+   case CPU_HISTORY:
+   case MEM_HISTORY: {
+      const History* history = field == CPU_HISTORY ? this->cpuHistory : this->memHistory;
+      if (!history) {
+         Row_printLeftAlignedField(str, CRT_colors[PROCESS_SHADOW], "N/A", HISTORY_SPARKLINE_WIDTH);
+         return;
+      }
+      /* memory is drawn against its own peak, CPU against one CPU busy */
+      History_writeSparkline(history, str, CRT_colors[GRAPH_1], field == MEM_HISTORY);
+      return;
+   }
+   case MEM_GROWTH: {
+      const double growth = Process_memGrowth(this);
+      if (isNaN(growth)) {
+         Row_printLeftAlignedField(str, CRT_colors[PROCESS_SHADOW], "N/A", 7);
+         RichString_appendAscii(str, CRT_colors[PROCESS_SHADOW], " ");
+         return;
+      }
+
+      const double magnitude = fabs(growth);
+      if (magnitude < 1024.0) {
+         xSnprintf(buffer, n, "%+6.0fK ", growth);
+      } else if (magnitude < 1024.0 * 1024.0) {
+         xSnprintf(buffer, n, "%+6.1fM ", growth / 1024.0);
+      } else {
+         xSnprintf(buffer, n, "%+6.1fG ", growth / (1024.0 * 1024.0));
+      }
+
+      /* shrinking or flat is of no concern, a MiB an hour or more stands out */
+      if (growth < 0.5) {
+         attr = CRT_colors[PROCESS_SHADOW];
+      } else if (coloring && growth >= 1024.0) {
+         attr = CRT_colors[LARGE_NUMBER];
+      }
+      break;
+   }
    case ELAPSED: {
       const uint64_t rt = host->realtimeMs;
       const uint64_t st = this->starttime_ctime * 1000;
@@ -689,7 +778,7 @@ void Process_writeField(const Process* this, RichString* str, RowField field) {
    case SESSION: xSnprintf(buffer, n, "%*d ", Process_pidDigits, this->session); break;
    case STARTTIME: xSnprintf(buffer, n, "%s", this->starttime_show); break;
    case STATE:
-      xSnprintf(buffer, n, "%c ", processStateChar(this->state));
+      xSnprintf(buffer, n, "%c ", Process_stateChar(this->state));
       switch (this->state) {
       case RUNNABLE:
       case RUNNING:
@@ -761,12 +850,16 @@ void Process_writeField(const Process* this, RichString* str, RowField field) {
 
 void Process_done(Process* this) {
    assert(this != NULL);
-   free(this->cmdline);
-   free(this->procComm);
-   free(this->procExe);
+   Row_done(&this->super);
+   StringPool_release(this->cmdline);
+   StringPool_release(this->procComm);
+   StringPool_release(this->procExe);
    free(this->procCwd);
-   free(this->mergedCommand.str);
+   StringPool_release(this->mergedCommand.str);
    free(this->tty_name);
+   History_delete(this->cpuHistory);
+   History_delete(this->memHistory);
+   Trend_delete(this->memTrend);
 }
 
 /* This function returns the string displayed in Command column, so that sorting
@@ -819,14 +912,27 @@ bool Process_rowIsVisible(const Row* super, const Table* table) {
 }
 
 /* Test whether display must filter out this process (various mechanisms) */
-static bool Process_matchesFilter(const Process* this, const Table* table) {
+static bool Process_matchesFilter(Process* this, const Table* table) {
    const Machine* host = table->host;
    if (host->userId != (uid_t) -1 && this->st_uid != host->userId)
       return true;
 
-   const char* incFilter = table->incFilter;
-   if (incFilter && !String_contains_i(Process_getCommand(this), incFilter, true))
-      return true;
+   const FilterMatcher* filter = &table->filter;
+   if (filter->pattern) {
+      /* only rescan the command when it changed, or when the filter changed
+         other than narrowing down on a command it did not match already */
+      const char* command = Process_getCommand(this);
+      const bool commandChanged = this->filterCommandGeneration != this->commandGeneration || this->filterCommand != command;
+      if (commandChanged || this->filterGeneration != filter->generation) {
+         if (commandChanged || this->filterMatch || !FilterMatcher_narrowedSince(filter, this->filterGeneration))
+            this->filterMatch = FilterMatcher_matches(filter, command);
+         this->filterGeneration = filter->generation;
+         this->filterCommandGeneration = this->commandGeneration;
+         this->filterCommand = command;
+      }
+      if (!this->filterMatch)
+         return true;
+   }
 
    const ProcessTable* pt = (const ProcessTable*) host->activeTable;
    assert(Object_isA((const Object*) pt, (const ObjectClass*) &ProcessTable_class));
@@ -836,8 +942,8 @@ static bool Process_matchesFilter(const Process* this, const Table* table) {
    return false;
 }
 
-bool Process_rowMatchesFilter(const Row* super, const Table* table) {
-   const Process* this = (const Process*) super;
+bool Process_rowMatchesFilter(Row* super, const Table* table) {
+   Process* this = (Process*) super;
    assert(Object_isA((const Object*) this, (const ObjectClass*) &Process_class));
    return Process_matchesFilter(this, table);
 }
@@ -849,6 +955,60 @@ void Process_init(Process* this, const Machine* host) {
    this->st_uid = (uid_t)-1;
 }
 
+/*
+ * Exited processes leave their struct behind for the next new one, so process
+ * churn does not go through malloc. All process structs of a build share the
+ * platform's size; requests of any other size bypass the pool.
+ */
+#define PROCESS_POOL_MAX 1024
+
+typedef struct ProcessPoolEntry_ {
+   struct ProcessPoolEntry_* next;
+} ProcessPoolEntry;
+
+static struct {
+   ProcessPoolEntry* entries;
+   size_t size;
+   unsigned int count;
+} Process_pool;
+
+void* Process_allocate(size_t size) {
+   ProcessPoolEntry* entry = Process_pool.entries;
+   if (!entry || size != Process_pool.size)
+      return xCalloc(1, size);
+
+   Process_pool.entries = entry->next;
+   Process_pool.count--;
+   memset(entry, 0, size);
+   return entry;
+}
+
+void Process_release(void* ptr, size_t size) {
+   assert(size >= sizeof(ProcessPoolEntry));
+
+   if (!Process_pool.size)
+      Process_pool.size = size;
+
+   if (size != Process_pool.size || Process_pool.count >= PROCESS_POOL_MAX) {
+      free(ptr);
+      return;
+   }
+
+   ProcessPoolEntry* entry = ptr;
+   entry->next = Process_pool.entries;
+   Process_pool.entries = entry;
+   Process_pool.count++;
+}
+
+void Process_releasePool(void) {
+   while (Process_pool.entries) {
+      ProcessPoolEntry* entry = Process_pool.entries;
+      Process_pool.entries = entry->next;
+      free(entry);
+   }
+   Process_pool.count = 0;
+}
+
 static bool Process_setPriority(Process* this, int priority) {
    if (Settings_isReadonly())
       return false;
@@ -874,10 +1034,17 @@ bool Process_rowChangePriorityBy(Row* super, Arg delta) {
    return Process_setPriority(this, this->nice + delta.i);
 }
 
-static bool Process_sendSignal(Process* this, Arg sgn) {
+static bool Process_sendSignal(const Process* this, Arg sgn) {
+   if (As_Process(this)->sendSignal)
+      return As_Process(this)->sendSignal(this, sgn.i);
+
    return kill(Process_getPid(this), sgn.i) == 0;
 }
 
+int Process_openExitFd(const Process* this) {
+   return As_Process(this)->openExitFd ? As_Process(this)->openExitFd(this) : -1;
+}
+
 bool Process_rowSendSignal(Row* super, Arg sgn) {
    Process* this = (Process*) super;
    assert(Object_isA((const Object*) this, (const ObjectClass*) &Process_class));
@@ -893,12 +1060,20 @@ int Process_compare(const void* v1, const void* v2) {
    ProcessField key = ScreenSettings_getActiveSortKey(ss);
 
    int result = Process_compareByKey(p1, p2, key);
+   if (result)
+      return (ScreenSettings_getActiveDirection(ss) == 1) ? result : -result;
 
-   // Implement tie-breaker (needed to make tree mode more stable)
-   if (!result)
-      return SPACESHIP_NUMBER(Process_getPid(p1), Process_getPid(p2));
+   for (const RowField* then = ss->thenSortKeys; *then; then++) {
+      if (*then == key)
+         continue;
 
-   return (ScreenSettings_getActiveDirection(ss) == 1) ? result : -result;
+      result = Process_compareByKey(p1, p2, *then);
+      if (result)
+         return ScreenSettings_isSortDescByDefault(*then) ? -result : result;
+   }
+
+   // Implement tie-breaker (needed to make tree mode more stable)
+   return SPACESHIP_NUMBER(Process_getPid(p1), Process_getPid(p2));
 }
 
 int Process_compareByParent(const Row* r1, const Row* r2) {
@@ -910,6 +1085,15 @@ int Process_compareByParent(const Row* r1, const Row* r2) {
    return Process_compare(r1, r2);
 }
 
+/* Recent CPU usage, a process busy for the whole window sorting above one that just spiked */
+static inline unsigned int Process_historySum(const History* history) {
+   return history ? History_sum(history) : 0;
+}
+
+double Process_memGrowth(const Process* this) {
+   return this->memTrend ? this->memTrend->slope * 3600.0 : NAN;
+}
+
 int Process_compareByKey_Base(const Process* p1, const Process* p2, ProcessField key) {
    int r;
 
@@ -933,6 +1117,12 @@ int Process_compareByKey_Base(const Process* p1, const Process* p2, ProcessField
    }
    case CWD:
       return SPACESHIP_NULLSTR(p1->procCwd, p2->procCwd);
+   case CPU_HISTORY:
+      return SPACESHIP_NUMBER(Process_historySum(p1->cpuHistory), Process_historySum(p2->cpuHistory));
+   case MEM_HISTORY:
+      return SPACESHIP_NUMBER(p1->m_resident, p2->m_resident);
+   case MEM_GROWTH:
+      return compareRealNumbers(Process_memGrowth(p1), Process_memGrowth(p2));
    case ELAPSED:
       r = -SPACESHIP_NUMBER(p1->starttime_ctime, p2->starttime_ctime);
       return r != 0 ? r : SPACESHIP_NUMBER(Process_getPid(p1), Process_getPid(p2));
@@ -987,15 +1177,134 @@ int Process_compareByKey_Base(const Process* p1, const Process* p2, ProcessField
    }
 }
 
+RowSortKeyKind Process_sortKeyByKey_Base(const Process* this, ProcessField key, uint64_t* value) {
+   switch (key) {
+   case PERCENT_CPU:
+   case PERCENT_NORM_CPU:
+      *value = Row_sortKeyFromDouble(this->percent_cpu);
+      return ROW_SORTKEY_EXACT;
+   case PERCENT_MEM:
+   case M_RESIDENT:
+   case MEM_HISTORY:
+      *value = Row_sortKeyFromSigned(this->m_resident);
+      return ROW_SORTKEY_EXACT;
+   case CPU_HISTORY:
+      *value = Process_historySum(this->cpuHistory);
+      return ROW_SORTKEY_EXACT;
+   case MEM_GROWTH:
+      *value = Row_sortKeyFromDouble(Process_memGrowth(this));
+      return ROW_SORTKEY_EXACT;
+   case M_VIRT:
+      *value = Row_sortKeyFromSigned(this->m_virt);
+      return ROW_SORTKEY_EXACT;
+   case MAJFLT:
+      *value = this->majflt;
+      return ROW_SORTKEY_EXACT;
+   case MINFLT:
+      *value = this->minflt;
+      return ROW_SORTKEY_EXACT;
+   case NICE:
+      *value = Row_sortKeyFromSigned(this->nice);
+      return ROW_SORTKEY_EXACT;
+   case NLWP:
+      *value = Row_sortKeyFromSigned(this->nlwp);
+      return ROW_SORTKEY_EXACT;
+   case PGRP:
+      *value = Row_sortKeyFromSigned(this->pgrp);
+      return ROW_SORTKEY_EXACT;
+   case PID:
+      *value = Row_sortKeyFromSigned(Process_getPid(this));
+      return ROW_SORTKEY_EXACT;
+   case PPID:
+      *value = Row_sortKeyFromSigned(Process_getParent(this));
+      return ROW_SORTKEY_EXACT;
+   case PRIORITY:
+      *value = Row_sortKeyFromSigned(this->priority);
+      return ROW_SORTKEY_EXACT;
+   case PROCESSOR:
+      *value = Row_sortKeyFromSigned(this->processor);
+      return ROW_SORTKEY_EXACT;
+   case SCHEDULERPOLICY:
+      *value = Row_sortKeyFromSigned(this->scheduling_policy);
+      return ROW_SORTKEY_EXACT;
+   case SESSION:
+      *value = Row_sortKeyFromSigned(this->session);
+      return ROW_SORTKEY_EXACT;
+   case STATE:
+      *value = Row_sortKeyFromSigned(this->state);
+      return ROW_SORTKEY_EXACT;
+   case ST_UID:
+      *value = this->st_uid;
+      return ROW_SORTKEY_EXACT;
+   case TIME:
+      *value = this->time;
+      return ROW_SORTKEY_EXACT;
+   case TGID:
+      *value = Row_sortKeyFromSigned(Process_getThreadGroup(this));
+      return ROW_SORTKEY_EXACT;
+   case TPGID:
+      *value = Row_sortKeyFromSigned(this->tpgid);
+      return ROW_SORTKEY_EXACT;
+   case COMM:
+      *value = Row_sortKeyFromString(Process_getCommand(this));
+      return ROW_SORTKEY_PREFIX;
+   case PROC_COMM:
+      *value = Row_sortKeyFromString(this->procComm ? this->procComm : (Process_isKernelThread(this) ? kthreadID : ""));
+      return ROW_SORTKEY_PREFIX;
+   case PROC_EXE:
+      *value = Row_sortKeyFromString(this->procExe ? (this->procExe + this->procExeBasenameOffset) : (Process_isKernelThread(this) ? kthreadID : ""));
+      return ROW_SORTKEY_PREFIX;
+   case CWD:
+      *value = Row_sortKeyFromString(this->procCwd);
+      return ROW_SORTKEY_PREFIX;
+   case TTY:
+      *value = StringRank_of(this->tty_name ? this->tty_name : "\x7F");
+      return ROW_SORTKEY_EXACT;
+   case USER:
+      *value = StringRank_of(this->user);
+      return ROW_SORTKEY_EXACT;
+   default:
+      /* STARTTIME and ELAPSED break ties themselves, in sort direction */
+      return ROW_SORTKEY_NONE;
+   }
+}
+
+RowSortKeyKind Process_rowSortKey(const Row* super, uint64_t* value) {
+   const Process* this = (const Process*) super;
+   const ScreenSettings* ss = super->host->settings->ss;
+
+   RowSortKeyKind kind = Process_sortKeyByKey(this, ScreenSettings_getActiveSortKey(ss), value);
+   if (kind != ROW_SORTKEY_NONE && ScreenSettings_getActiveDirection(ss) != 1)
+      *value = ~*value;
+
+   return kind;
+}
+
+RowSortKeyKind Process_rowSortKeyByField(const Row* super, RowField field, uint64_t* value) {
+   return Process_sortKeyByKey((const Process*) super, field, value);
+}
+
+/*
+ * Replaces one of cmdline, procComm and procExe by the interned copy of
+ * value, which may be the string it replaces. Workers of one pool share a
+ * single copy of their strings.
+ */
+static void Process_setString(Process* this, const char** slot, const char* value) {
+   const char* interned = StringPool_get(value);
+   StringPool_release(*slot);
+   *slot = interned;
+
+   this->commandGeneration++;
+}
+
 void Process_updateComm(Process* this, const char* comm) {
-   if (!this->procComm && !comm)
+   if (this->procComm == comm)
       return;
 
    if (this->procComm && comm && String_eq(this->procComm, comm))
       return;
 
-   free(this->procComm);
-   this->procComm = comm ? xStrdup(comm) : NULL;
+   Process_setString(this, &this->procComm, comm);
 
    this->mergedCommand.lastUpdate = 0;
 }
@@ -1027,34 +1336,32 @@ void Process_updateCmdline(Process* this, const char* cmdline, int basenameStart
    assert((basenameEnd > basenameStart) || (basenameEnd == 0 && basenameStart == 0));
    assert((cmdline && basenameEnd <= (int)strlen(cmdline)) || (!cmdline && basenameEnd == 0));
 
-   if (!this->cmdline && !cmdline)
+   if (this->cmdline == cmdline)
       return;
 
    if (this->cmdline && cmdline && String_eq(this->cmdline, cmdline))
       return;
 
-   free(this->cmdline);
-   this->cmdline = cmdline ? xStrdup(cmdline) : NULL;
-   this->cmdlineBasenameStart = (basenameStart || !cmdline) ? basenameStart : skipPotentialPath(cmdline, basenameEnd);
+   Process_setString(this, &this->cmdline, cmdline);
+   this->cmdlineBasenameStart = (basenameStart || !cmdline) ? basenameStart : skipPotentialPath(this->cmdline, basenameEnd);
    this->cmdlineBasenameEnd = basenameEnd;
 
    this->mergedCommand.lastUpdate = 0;
 }
 
 void Process_updateExe(Process* this, const char* exe) {
-   if (!this->procExe && !exe)
+   if (this->procExe == exe)
       return;
 
    if (this->procExe && exe && String_eq(this->procExe, exe))
       return;
 
-   free(this->procExe);
+   Process_setString(this, &this->procExe, exe);
    if (exe) {
-      this->procExe = xStrdup(exe);
+      exe = this->procExe;
       const char* lastSlash = strrchr(exe, '/');
       this->procExeBasenameOffset = (lastSlash && *(lastSlash + 1) != '\0' && lastSlash != exe) ? (lastSlash - exe + 1) : 0;
    } else {
-      this->procExe = NULL;
       this->procExeBasenameOffset = 0;
    }
 
@@ -12,6 +12,7 @@ in the source distribution for its full text.
 #include <stdint.h>
 #include <sys/types.h>
 
+#include "History.h"
 #include "Object.h"
 #include "RichString.h"
 #include "Row.h"
@@ -21,12 +22,14 @@ in the source distribution for its full text.
 #define PROCESS_FLAG_IO              0x00000001
 #define PROCESS_FLAG_CWD             0x00000002
 #define PROCESS_FLAG_SCHEDPOL        0x00000004
+#define PROCESS_FLAG_HISTORY         0x00000008
+#define PROCESS_FLAG_MEM_GROWTH      0x00000010
 
 #define DEFAULT_HIGHLIGHT_SECS 5
 
 /* Core process states (shared by platforms)
  * NOTE: The enum has an ordering that is important!
- * See processStateChar in process.c for ProcessSate -> letter mapping */
+ * See Process_stateChar in Process.c for ProcessSate -> letter mapping */
 typedef enum ProcessState_ {
    UNKNOWN = 1,
    RUNNABLE,
@@ -56,15 +59,17 @@ typedef struct ProcessCmdlineHighlight_ {
    int flags;     /* Special flags used for selective highlighting, zero for always */
 } ProcessCmdlineHighlight;
 
+#define PROCESS_MAX_HIGHLIGHTS 8
+
 /* ProcessMergedCommand is populated by Process_makeCommandStr: It
  * contains the merged Command string, and the information needed by
  * Process_writeCommand to color the string. str will be NULL for kernel
  * threads and zombies */
 typedef struct ProcessMergedCommand_ {
    uint64_t lastUpdate;                        /* Marker based on settings->lastUpdate to track when the rendering needs refreshing */
-   char* str;                                  /* merged Command string */
+   const char* str;                            /* merged Command string, shared through the StringPool with its highlights */
    size_t highlightCount;                      /* how many portions of cmdline to highlight */
-   ProcessCmdlineHighlight highlights[8];      /* which portions of cmdline to highlight */
+   const ProcessCmdlineHighlight* highlights;  /* which portions of cmdline to highlight; stored behind str in its entry */
 } ProcessMergedCommand;
 
 typedef struct Process_ {
@@ -114,8 +119,9 @@ typedef struct Process_ {
    /*
     * Process name including arguments.
     * Use Process_getCommand() for Command actually displayed.
+    * Like procComm and procExe, shared through the StringPool.
     */
-   char* cmdline;
+   const char* cmdline;
 
    /* End Offset in cmdline of the process basename */
    int cmdlineBasenameEnd;
@@ -124,10 +130,10 @@ typedef struct Process_ {
    int cmdlineBasenameStart;
 
    /* The process' "command" name */
-   char* procComm;
+   const char* procComm;
 
    /* The main process executable */
-   char* procExe;
+   const char* procExe;
 
    /* The process/thread working directory */
    char* procCwd;
@@ -183,10 +189,27 @@ typedef struct Process_ {
    /* Current scheduling policy */
    int scheduling_policy;
 
+   /* Samples of percent_cpu and m_resident, kept while a history column is shown */
+   History* cpuHistory;
+   History* memHistory;
+
+   /* Sparse samples of m_resident, kept while the growth column is on any screen */
+   Trend* memTrend;
+
    /*
     * Internal state for merged Command display
     */
    ProcessMergedCommand mergedCommand;
+
+   /* Incremented whenever a string Process_getCommand may return is replaced by another */
+   unsigned int commandGeneration;
+
+   /* Whether the command matched the filter of the table, computed for
+    * the filter generation, command generation and command string below */
+   bool filterMatch;
+   unsigned int filterGeneration;
+   unsigned int filterCommandGeneration;
+   const char* filterCommand;
 } Process;
 
 typedef struct ProcessFieldData_ {
@@ -200,7 +223,7 @@ typedef struct ProcessFieldData_ {
    const char* description;
 
    /* Scan flag to enable scan-method otherwise not run */
-   uint32_t flags;
+   uint64_t flags;
 
    /* Whether the values are process identifiers; adjusts the width of title and values if true */
    bool pidColumn;
@@ -226,15 +249,24 @@ extern const ProcessFieldData Process_fields[LAST_PROCESSFIELD];
 
 typedef Process* (*Process_New)(const struct Machine_*);
 typedef int (*Process_CompareByKey)(const Process*, const Process*, ProcessField);
+typedef RowSortKeyKind (*Process_SortKeyByKey)(const Process*, ProcessField, uint64_t*);
+typedef bool (*Process_SendSignal)(const Process*, int);
+typedef int (*Process_OpenExitFd)(const Process*);
+typedef void (*Process_SnapshotValues)(const Process*, float*, uint64_t*);
 
 typedef struct ProcessClass_ {
    const RowClass super;
    const Process_CompareByKey compareByKey;
+   const Process_SortKeyByKey sortKeyByKey;  /* must order exactly like compareByKey */
+   const Process_SendSignal sendSignal;      /* NULL to signal the PID with kill(2) */
+   const Process_OpenExitFd openExitFd;      /* NULL if exits cannot be waited for */
+   const Process_SnapshotValues snapshotValues; /* I/O rate and control group of ProcessSnapshot, NULL if unknown */
 } ProcessClass;
 
 #define As_Process(this_)   ((const ProcessClass*)((this_)->super.super.klass))
 
 #define Process_compareByKey(p1_, p2_, key_)   (As_Process(p1_)->compareByKey ? (As_Process(p1_)->compareByKey(p1_, p2_, key_)) : Process_compareByKey_Base(p1_, p2_, key_))
+#define Process_sortKeyByKey(p_, key_, v_)     (As_Process(p_)->sortKeyByKey ? (As_Process(p_)->sortKeyByKey(p_, key_, v_)) : Process_sortKeyByKey_Base(p_, key_, v_))
 
 
 static inline void Process_setPid(Process* this, pid_t pid) {
@@ -291,26 +323,53 @@ extern const ProcessClass Process_class;
 
 void Process_init(Process* this, const struct Machine_* host);
 
+/* Zeroed storage for a platform process struct, recycled from exited processes */
+void* Process_allocate(size_t size);
+
+/* Returns storage obtained from Process_allocate */
+void Process_release(void* ptr, size_t size);
+
+/* Frees the storage kept for reuse */
+void Process_releasePool(void);
+
 const char* Process_rowGetSortKey(Row* super);
 
 bool Process_rowSetPriority(Row* super, int priority);
 
 bool Process_rowChangePriorityBy(Row* super, Arg delta);
 
+/* A new descriptor polling readable once the process exited, -1 if there is none; the caller closes it */
+int Process_openExitFd(const Process* this);
+
 bool Process_rowSendSignal(Row* super, Arg sgn);
 
 bool Process_rowIsHighlighted(const Row* super);
 
 bool Process_rowIsVisible(const Row* super, const struct Table_* table);
 
-bool Process_rowMatchesFilter(const Row* super, const struct Table_* table);
+bool Process_rowMatchesFilter(Row* super, const struct Table_* table);
 
 static inline int Process_pidEqualCompare(const void* v1, const void* v2) {
    return Row_idEqualCompare(v1, v2);
 }
 
+/* Growth of m_resident in KiB per hour, NAN until enough of it was sampled */
+double Process_memGrowth(const Process* this);
+
 int Process_compareByKey_Base(const Process* p1, const Process* p2, ProcessField key);
 
+/* Sort key encoding matching Process_compareByKey_Base */
+RowSortKeyKind Process_sortKeyByKey_Base(const Process* this, ProcessField key, uint64_t* value);
+
+/* Row_SortKey for platforms whose compareByKey is matched by a sortKeyByKey */
+RowSortKeyKind Process_rowSortKey(const Row* super, uint64_t* value);
+
+/* Row_SortKeyByField for the same platforms */
+RowSortKeyKind Process_rowSortKeyByField(const Row* super, RowField field, uint64_t* value);
+
+/* The letter of the state column */
+char Process_stateChar(ProcessState state);
+
 const char* Process_getCommand(const Process* this);
 
 void Process_updateComm(Process* this, const char* comm);
@@ -13,10 +13,10 @@ in the source distribution for its full text.
 #include <limits.h>
 #include <stdlib.h>
 
+#include "LineStore.h"
 #include "Panel.h"
 #include "Platform.h"
 #include "ProvideCurses.h"
-#include "Vector.h"
 #include "XUtils.h"
 
 
@@ -91,8 +91,7 @@ static void ProcessLocksScreen_scan(InfoScreen* this) {
       }
    }
    free(pdata);
-   Vector_insertionSort(this->lines);
-   Vector_insertionSort(panel->items);
+   LineStore_sort(this->lines);
    Panel_setSelected(panel, idx);
 }
 
@@ -0,0 +1,87 @@
+/*
+htop - ProcessSnapshot.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "ProcessSnapshot.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Macros.h"
+#include "XUtils.h"
+
+
+void ProcessSnapshot_done(ProcessSnapshot* this) {
+   free(this->pid);
+   free(this->ppid);
+   free(this->tgid);
+   free(this->uid);
+   free(this->startTime);
+   free(this->state);
+   free(this->kind);
+   free(this->cpuPercent);
+   free(this->residentKB);
+   free(this->ioRate);
+   free(this->group);
+   memset(this, 0, sizeof(ProcessSnapshot));
+}
+
+static void ProcessSnapshot_grow(ProcessSnapshot* this, size_t alloc) {
+   this->pid = xReallocArray(this->pid, alloc, sizeof(*this->pid));
+   this->ppid = xReallocArray(this->ppid, alloc, sizeof(*this->ppid));
+   this->tgid = xReallocArray(this->tgid, alloc, sizeof(*this->tgid));
+   this->uid = xReallocArray(this->uid, alloc, sizeof(*this->uid));
+   this->startTime = xReallocArray(this->startTime, alloc, sizeof(*this->startTime));
+   this->state = xReallocArray(this->state, alloc, sizeof(*this->state));
+   this->kind = xReallocArray(this->kind, alloc, sizeof(*this->kind));
+   this->cpuPercent = xReallocArray(this->cpuPercent, alloc, sizeof(*this->cpuPercent));
+   this->residentKB = xReallocArray(this->residentKB, alloc, sizeof(*this->residentKB));
+   this->ioRate = xReallocArray(this->ioRate, alloc, sizeof(*this->ioRate));
+   this->group = xReallocArray(this->group, alloc, sizeof(*this->group));
+   this->alloc = alloc;
+}
+
+void ProcessSnapshot_begin(ProcessSnapshot* this, size_t expected) {
+   this->count = 0;
+   if (expected > this->alloc)
+      ProcessSnapshot_grow(this, expected + expected / 4);
+}
+
+void ProcessSnapshot_add(ProcessSnapshot* this, const Process* proc) {
+   if (this->count == this->alloc)
+      ProcessSnapshot_grow(this, MAXIMUM(2 * this->alloc, 64));
+
+   const size_t i = this->count++;
+   this->pid[i] = Process_getPid(proc);
+   this->ppid[i] = Process_getParent(proc);
+   this->tgid[i] = Process_getThreadGroup(proc);
+   this->uid[i] = proc->st_uid;
+   this->startTime[i] = proc->starttime_ctime;
+   this->state[i] = (uint8_t)proc->state;
+   this->kind[i] = (Process_isKernelThread(proc) ? PROCESS_SNAPSHOT_KERNEL_THREAD : 0) |
+                   (Process_isUserlandThread(proc) ? PROCESS_SNAPSHOT_USERLAND_THREAD : 0);
+   this->cpuPercent[i] = proc->percent_cpu;
+   this->residentKB[i] = proc->m_resident > 0 ? (uint64_t)proc->m_resident : 0;
+
+   float ioRate = NAN;
+   uint64_t group = 0;
+   if (As_Process(proc)->snapshotValues)
+      As_Process(proc)->snapshotValues(proc, &ioRate, &group);
+   this->ioRate[i] = ioRate;
+   this->group[i] = group;
+}
+
+void ProcessSnapshot_countStates(const ProcessSnapshot* this, uint8_t skipKinds, unsigned int counts[SLEEPING + 1]) {
+   memset(counts, 0, (SLEEPING + 1) * sizeof(unsigned int));
+
+   const uint8_t* state = this->state;
+   const uint8_t* kind = this->kind;
+   for (size_t i = 0; i < this->count; i++)
+      counts[MINIMUM(state[i], SLEEPING)] += !(kind[i] & skipKinds);
+}
@@ -0,0 +1,58 @@
+#ifndef HEADER_ProcessSnapshot
+#define HEADER_ProcessSnapshot
+/*
+htop - ProcessSnapshot.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+
+#include "Process.h"
+
+
+/*
+ * The values of the processes of the latest scan in one array per value,
+ * filled in by the process table while it finishes the scan. Sums, counts
+ * and numeric filters run over them in plain loops the compiler can
+ * vectorize, without going through the Process objects. Entries are in no
+ * particular order; threads are included, as far as they were read.
+ */
+
+/* Kinds of task, in ProcessSnapshot.kind */
+#define PROCESS_SNAPSHOT_KERNEL_THREAD   0x01
+#define PROCESS_SNAPSHOT_USERLAND_THREAD 0x02
+
+typedef struct ProcessSnapshot_ {
+   size_t count;
+   size_t alloc;
+
+   pid_t* pid;
+   pid_t* ppid;
+   pid_t* tgid;
+   uid_t* uid;
+   time_t* startTime;             /* tells apart processes of a reused pid */
+   uint8_t* state;                /* ProcessState */
+   uint8_t* kind;
+   float* cpuPercent;             /* NAN while unknown */
+   uint64_t* residentKB;
+   float* ioRate;                 /* bytes read and written per second, NAN where not read */
+   uint64_t* group;               /* the same for processes of one control group, 0 if unknown */
+} ProcessSnapshot;
+
+void ProcessSnapshot_done(ProcessSnapshot* this);
+
+/* Forgets the entries of the previous scan, keeping room for `expected` */
+void ProcessSnapshot_begin(ProcessSnapshot* this, size_t expected);
+
+void ProcessSnapshot_add(ProcessSnapshot* this, const Process* proc);
+
+/* Entries by state whose kind has none of the bits of `skipKinds`, `counts` indexed by ProcessState */
+void ProcessSnapshot_countStates(const ProcessSnapshot* this, uint8_t skipKinds, unsigned int counts[SLEEPING + 1]);
+
+#endif
@@ -7,30 +7,60 @@ in the source distribution for its full text.
 
 #include "config.h" // IWYU pragma: keep
 
+#define HEAP_CLASS HEAP_PROCESSES
+
 #include "ProcessTable.h"
 
 #include <assert.h>
 #include <stdlib.h>
 
 #include "Hashtable.h"
+#include "History.h"
+#include "Macros.h"
+#include "Platform.h"
+#include "ProcessSnapshot.h"
 #include "Row.h"
 #include "Settings.h"
+#include "StringRank.h"
 #include "Vector.h"
+#include "XUtils.h"
+
 
+/* Largest pid_max for which PIDs index the process map directly (Linux' PID_MAX_LIMIT) */
+#define PROCESSTABLE_DIRECT_INDEX_MAX_PID (4 * 1024 * 1024)
 
 void ProcessTable_init(ProcessTable* this, const ObjectClass* klass, Machine* host, Hashtable* pidMatchList) {
    Table_init(&this->super, klass, host);
 
+   /* Bounded PIDs are dense enough to skip hashing altogether */
+   pid_t maxPid = Platform_getMaxPid();
+   if (maxPid > 0 && maxPid <= PROCESSTABLE_DIRECT_INDEX_MAX_PID)
+      Table_useDirectIndex(&this->super);
+
    this->pidMatchList = pidMatchList;
 }
 
 void ProcessTable_done(ProcessTable* this) {
    Table_done(&this->super);
+   Process_releasePool();
+   History_releasePool();
+   StringRank_clear();
+   free(this->exitFds);
+   ProcessSnapshot_done(&this->snapshot);
+}
+
+void ProcessTable_addExitFd(ProcessTable* this, int fd) {
+   if (this->exitFdCount == this->exitFdsAlloc) {
+      this->exitFdsAlloc = this->exitFdsAlloc ? this->exitFdsAlloc * 2 : 8;
+      this->exitFds = xReallocArray(this->exitFds, this->exitFdsAlloc, sizeof(int));
+   }
+
+   this->exitFds[this->exitFdCount++] = fd;
 }
 
 Process* ProcessTable_getProcess(ProcessTable* this, pid_t pid, bool* preExisting, Process_New constructor) {
    const Table* table = &this->super;
-   Process* proc = (Process*) Hashtable_get(table->table, pid);
+   Process* proc = (Process*) Table_findRow(&this->super, pid);
    *preExisting = proc != NULL;
    if (proc) {
       assert(Vector_indexOf(table->rows, proc, Row_idEqualCompare) != -1);
@@ -59,26 +89,111 @@ static void ProcessTable_iterateEntries(Table* super) {
    ProcessTable_goThroughEntries(this);
 }
 
+#ifdef HAVE_PTHREAD
+static bool ProcessTable_prefetch(Table* super) {
+   return ProcessTable_prefetchEntries((ProcessTable*) super);
+}
+
+static bool ProcessTable_prefetched(const Table* super) {
+   return ProcessTable_entriesPrefetched((const ProcessTable*) super);
+}
+#endif
+
+/* Takes the samples of the history columns, or drops the histories once no such column is shown */
+static void ProcessTable_updateHistory(const Table* table, Process* p, bool keep) {
+   if (!keep) {
+      History_delete(p->cpuHistory);
+      History_delete(p->memHistory);
+      p->cpuHistory = NULL;
+      p->memHistory = NULL;
+      return;
+   }
+
+   if (!Table_isUpdated(table, &p->super))
+      return;
+
+   if (!p->cpuHistory)
+      p->cpuHistory = History_new();
+   if (!p->memHistory)
+      p->memHistory = History_new();
+
+   /* one CPU busy is the full height */
+   const float cpu = isNonnegative(p->percent_cpu) ? MINIMUM(p->percent_cpu, 100.0F) : 0.0F;
+   History_add(p->cpuHistory, (uint8_t)(cpu * 2.55F + 0.5F));
+   History_addScaled(p->memHistory, (unsigned long long)MAXIMUM(p->m_resident, 0L));
+}
+
+/* Samples m_resident for the growth column, over the window that is set; the trend is kept while any screen shows the column */
+static void ProcessTable_updateTrend(const Table* table, Process* p, bool keep) {
+   if (!keep || Process_isUserlandThread(p)) {
+      Trend_delete(p->memTrend);
+      p->memTrend = NULL;
+      return;
+   }
+
+   if (!Table_isUpdated(table, &p->super))
+      return;
+
+   if (!p->memTrend)
+      p->memTrend = Trend_new();
+
+   const Machine* host = table->host;
+   Trend_add(p->memTrend, (uint32_t)(host->monotonicMs / 1000), (uint64_t)MAXIMUM(p->m_resident, 0L), (uint32_t)host->settings->memGrowthWindow * 60);
+}
+
+static bool ProcessTable_growthShown(const Settings* settings) {
+   for (unsigned int i = 0; i < settings->nScreens; i++) {
+      if (settings->screens[i]->flags & PROCESS_FLAG_MEM_GROWTH)
+         return true;
+   }
+   return false;
+}
+
 static void ProcessTable_cleanupEntries(Table* super) {
+   ProcessTable* this = (ProcessTable*) super;
    Machine* host = super->host;
    const Settings* settings = host->settings;
 
+   /* Collecting lazily, only rows on screen get their merged command, unless
+      all of them are filtered or sorted by it */
+   const bool mergeAll = !settings->lazyCollection || super->incFilter || ScreenSettings_getActiveSortKey(settings->ss) == COMM;
+   const bool keepHistory = settings->ss->flags & PROCESS_FLAG_HISTORY;
+   const bool keepTrend = ProcessTable_growthShown(settings);
+
    // Finish process table update, culling any exit'd processes
+   const bool culling = Table_needsCulling(super);
+   if (culling)
+      super->tombRows = 0;
+
+   ProcessSnapshot_begin(&this->snapshot, (size_t)Vector_size(super->rows));
+
    for (int i = Vector_size(super->rows) - 1; i >= 0; i--) {
       Process* p = (Process*) Vector_get(super->rows, i);
 
       // tidy up Process state after refreshing the ProcessTable table
-      Process_makeCommandStr(p, settings);
+      if (mergeAll || Table_isRowOnScreen(super, &p->super))
+         Process_makeCommandStr(p, settings);
+
+      if (keepHistory || p->cpuHistory)
+         ProcessTable_updateHistory(super, p, keepHistory);
+
+      if (keepTrend || p->memTrend)
+         ProcessTable_updateTrend(super, p, keepTrend);
 
       // keep track of the highest UID for column scaling
       if (p->st_uid > host->maxUserId)
          host->maxUserId = p->st_uid;
 
-      Table_cleanupRow(super, (Row*) p, i);
+      if (Table_isUpdated(super, &p->super) && !p->super.tombStampMs)
+         ProcessSnapshot_add(&this->snapshot, p);
+
+      if (culling)
+         Table_cleanupRow(super, (Row*) p, i);
    }
 
    // compact the table in case of deletions
-   Table_compact(super);
+   if (culling)
+      Table_compact(super);
 }
 
 const TableClass ProcessTable_class = {
@@ -89,4 +204,8 @@ const TableClass ProcessTable_class = {
    .prepare = ProcessTable_prepareEntries,
    .iterate = ProcessTable_iterateEntries,
    .cleanup = ProcessTable_cleanupEntries,
+#ifdef HAVE_PTHREAD
+   .prefetch = ProcessTable_prefetch,
+   .prefetched = ProcessTable_prefetched,
+#endif
 };
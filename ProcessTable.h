@@ -14,6 +14,7 @@ in the source distribution for its full text.
 #include "Machine.h"
 #include "Object.h"
 #include "Process.h"
+#include "ProcessSnapshot.h"
 #include "Table.h"
 
 
@@ -26,6 +27,14 @@ typedef struct ProcessTable_ {
    unsigned int runningTasks;
    unsigned int userlandThreads;
    unsigned int kernelThreads;
+
+   /* The processes of the latest scan by value, see ProcessSnapshot.h */
+   ProcessSnapshot snapshot;
+
+   /* Polled with the terminal, readable once a watched process exited (set by platforms) */
+   int* exitFds;
+   size_t exitFdCount;
+   size_t exitFdsAlloc;
 } ProcessTable;
 
 /* Implemented by platforms */
@@ -33,10 +42,18 @@ ProcessTable* ProcessTable_new(Machine* host, Hashtable* pidMatchList);
 void ProcessTable_delete(Object* cast);
 void ProcessTable_goThroughEntries(ProcessTable* this);
 
+#ifdef HAVE_PTHREAD
+/* Starts reading the next scan in the background, ProcessTable_goThroughEntries() merges it */
+bool ProcessTable_prefetchEntries(ProcessTable* this);
+bool ProcessTable_entriesPrefetched(const ProcessTable* this);
+#endif
+
 void ProcessTable_init(ProcessTable* this, const ObjectClass* klass, Machine* host, Hashtable* pidMatchList);
 
 void ProcessTable_done(ProcessTable* this);
 
+void ProcessTable_addExitFd(ProcessTable* this, int fd);
+
 extern const TableClass ProcessTable_class;
 
 static inline void ProcessTable_add(ProcessTable* this, Process* process) {
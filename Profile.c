@@ -0,0 +1,260 @@
+/*
+htop - Profile.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "Profile.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "Heap.h"
+#include "Macros.h"
+#include "XUtils.h"
+
+
+ProfileStats Profile_stats[PROFILE_MAX_PHASES] = {
+   [PROFILE_MACHINE_SCAN]  = { .name = "system scan" },
+   [PROFILE_TABLE_SCAN]    = { .name = "table scan" },
+   [PROFILE_DISPLAY_LIST]  = { .name = "sort/tree" },
+   [PROFILE_REBUILD_PANEL] = { .name = "panel rebuild" },
+   [PROFILE_HEADER_DRAW]   = { .name = "header draw" },
+   [PROFILE_PANEL_DRAW]    = { .name = "panel draw" },
+   [PROFILE_FIRST_FRAME]   = { .name = "first frame" },
+   [PROFILE_FIRST_TABLE]   = { .name = "first table" },
+};
+
+size_t Profile_phaseCount = PROFILE_BUILTIN_PHASES;
+
+ProfileMark Profile_startup;
+
+ProfileRowMemory Profile_rowMemory;
+
+bool Profile_syscallsEnabled;
+
+/* Syscalls spent on counting syscalls, per sample and in total */
+static uint64_t Profile_samplingCost;
+static uint64_t Profile_sampling;
+
+static uint64_t Profile_now(void) {
+#if defined(HAVE_CLOCK_GETTIME)
+   struct timespec ts;
+   if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+      return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+
+   struct timeval tv;
+   if (gettimeofday(&tv, NULL) == 0)
+      return (uint64_t)tv.tv_sec * 1000000000 + (uint64_t)tv.tv_usec * 1000;
+
+   return 0;
+}
+
+#ifdef HTOP_LINUX
+
+/* Read and write syscalls of all threads, from the I/O accounting of the kernel */
+static bool Profile_readSyscalls(uint64_t* count) {
+   char buffer[512];
+   if (xReadfile("/proc/self/io", buffer, sizeof(buffer)) <= 0)
+      return false;
+
+   const char* syscr = strstr(buffer, "syscr: ");
+   const char* syscw = strstr(buffer, "syscw: ");
+   if (!syscr || !syscw)
+      return false;
+
+   *count = strtoull(syscr + strlen("syscr: "), NULL, 10) + strtoull(syscw + strlen("syscw: "), NULL, 10);
+   return true;
+}
+
+#else
+
+static bool Profile_readSyscalls(ATTR_UNUSED uint64_t* count) {
+   return false;
+}
+
+#endif
+
+bool Profile_enableSyscalls(void) {
+   uint64_t first;
+   uint64_t second;
+   if (!Profile_readSyscalls(&first) || !Profile_readSyscalls(&second))
+      return false;
+
+   Profile_samplingCost = second - first;
+   Profile_syscallsEnabled = true;
+   return true;
+}
+
+int Profile_addPhase(const char* name) {
+   for (size_t i = 0; i < Profile_phaseCount; i++) {
+      if (String_eq(Profile_stats[i].name, name))
+         return (int)i;
+   }
+
+   if (Profile_phaseCount == PROFILE_MAX_PHASES)
+      return -1;
+
+   Profile_stats[Profile_phaseCount].name = name;
+   return (int)Profile_phaseCount++;
+}
+
+ProfileMark Profile_begin(void) {
+   ProfileMark mark = { .ns = 0, .counted = false, .syscalls = 0, .sampling = 0 };
+
+   if (Profile_syscallsEnabled && Profile_readSyscalls(&mark.syscalls)) {
+      Profile_sampling += Profile_samplingCost;
+      mark.counted = true;
+      mark.sampling = Profile_sampling;
+   }
+
+   mark.ns = Profile_now();
+   return mark;
+}
+
+void Profile_end(int phase, ProfileMark mark) {
+   const uint64_t elapsed = saturatingSub(Profile_now(), mark.ns);
+
+   if (phase < 0 || (size_t)phase >= Profile_phaseCount)
+      return;
+
+   ProfileStats* stats = &Profile_stats[phase];
+   stats->count++;
+   stats->totalNs += elapsed;
+   stats->lastNs = elapsed;
+   stats->maxNs = MAXIMUM(stats->maxNs, elapsed);
+
+   size_t bucket = 0;
+   for (uint64_t us = elapsed / 1000; us && bucket < PROFILE_BUCKETS - 1; us >>= 1)
+      bucket++;
+   stats->histogram[bucket]++;
+
+   uint64_t syscalls;
+   if (mark.counted && Profile_readSyscalls(&syscalls)) {
+      /* leave out what counting took, here and for the phases nested inside */
+      const uint64_t sampling = Profile_sampling - mark.sampling + Profile_samplingCost;
+      stats->syscalls += saturatingSub(saturatingSub(syscalls, mark.syscalls), sampling);
+      Profile_sampling += Profile_samplingCost;
+   }
+}
+
+uint64_t Profile_percentile(const ProfileStats* stats, double fraction) {
+   if (!stats->count)
+      return 0;
+
+   const double wanted = fraction * (double)stats->count;
+   uint64_t seen = 0;
+   for (size_t i = 0; i < PROFILE_BUCKETS - 1; i++) {
+      seen += stats->histogram[i];
+      if ((double)seen >= wanted)
+         return MINIMUM((UINT64_C(1) << i) * 1000, stats->maxNs);
+   }
+
+   return stats->maxNs;
+}
+
+bool Profile_formatRowMemory(char* buffer, size_t size) {
+   const ProfileRowMemory* mem = &Profile_rowMemory;
+   if (!mem->rows)
+      return false;
+
+   const size_t total = mem->rows * mem->rowSize + mem->details * mem->detailsSize;
+   xSnprintf(buffer, size, "process rows: %zu of %zu bytes, %zu with %zu bytes of details, %zu bytes per process",
+             mem->rows, mem->rowSize, mem->details, mem->detailsSize, total / mem->rows);
+   return true;
+}
+
+bool Profile_formatHeap(size_t line, char* buffer, size_t size) {
+#ifdef HEAP_ACCOUNTING
+   if (line > HEAP_CLASSES + 1)
+      return false;
+
+   if (line == 0) {
+      xSnprintf(buffer, size, "%-16s %12s %10s %12s %12s", "heap", "live KiB", "blocks", "peak KiB", "allocations");
+      return true;
+   }
+
+   HeapStats stats[HEAP_CLASSES];
+   Heap_stats(stats);
+
+   if (line <= HEAP_CLASSES) {
+      const HeapStats* s = &stats[line - 1];
+      xSnprintf(buffer, size, "%-16s %12.1f %10zu %12.1f %12" PRIu64,
+                Heap_classNames[line - 1], (double)s->liveBytes / 1024.0, s->liveBlocks, (double)s->peakBytes / 1024.0, s->allocations);
+      return true;
+   }
+
+   HeapStats total = { 0 };
+   for (size_t i = 0; i < HEAP_CLASSES; i++) {
+      total.liveBytes += stats[i].liveBytes;
+      total.liveBlocks += stats[i].liveBlocks;
+      total.allocations += stats[i].allocations;
+   }
+   xSnprintf(buffer, size, "%-16s %12.1f %10zu %12s %12" PRIu64,
+             "total", (double)total.liveBytes / 1024.0, total.liveBlocks, "", total.allocations);
+   return true;
+#else
+   (void)line;
+   (void)buffer;
+   (void)size;
+   return false;
+#endif
+}
+
+void Profile_dump(FILE* out) {
+   fprintf(out, "%-16s %9s %10s %10s %10s %10s %10s", "phase", "count", "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms");
+   if (Profile_syscallsEnabled)
+      fprintf(out, " %10s", "syscalls");
+   fputc('\n', out);
+
+   for (size_t i = 0; i < Profile_phaseCount; i++) {
+      const ProfileStats* stats = &Profile_stats[i];
+      if (!stats->count)
+         continue;
+
+      fprintf(out, "%-16s %9" PRIu64 " %10.3f %10.3f %10.3f %10.3f %10.3f",
+              stats->name, stats->count,
+              (double)stats->totalNs / (double)stats->count / 1e6,
+              (double)Profile_percentile(stats, 0.5) / 1e6,
+              (double)Profile_percentile(stats, 0.9) / 1e6,
+              (double)Profile_percentile(stats, 0.99) / 1e6,
+              (double)stats->maxNs / 1e6);
+      if (Profile_syscallsEnabled)
+         fprintf(out, " %10.1f", (double)stats->syscalls / (double)stats->count);
+      fputc('\n', out);
+   }
+
+   fprintf(out, "\nhistogram (samples below the given duration)\n");
+   for (size_t i = 0; i < Profile_phaseCount; i++) {
+      const ProfileStats* stats = &Profile_stats[i];
+      if (!stats->count)
+         continue;
+
+      fprintf(out, "%s:", stats->name);
+      for (size_t b = 0; b < PROFILE_BUCKETS; b++) {
+         if (!stats->histogram[b])
+            continue;
+
+         if (b == PROFILE_BUCKETS - 1)
+            fprintf(out, " longer:%" PRIu64, stats->histogram[b]);
+         else
+            fprintf(out, " %" PRIu64 "us:%" PRIu64, UINT64_C(1) << b, stats->histogram[b]);
+      }
+      fputc('\n', out);
+   }
+
+   char rowMemory[256];
+   if (Profile_formatRowMemory(rowMemory, sizeof(rowMemory)))
+      fprintf(out, "\n%s\n", rowMemory);
+
+   char heap[128];
+   for (size_t line = 0; Profile_formatHeap(line, heap, sizeof(heap)); line++)
+      fprintf(out, "%s%s\n", line ? "" : "\n", heap);
+}
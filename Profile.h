@@ -0,0 +1,92 @@
+#ifndef HEADER_Profile
+#define HEADER_Profile
+/*
+htop - Profile.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/* Phases of an update that are always timed; platforms can add more with Profile_addPhase() */
+typedef enum ProfilePhase_ {
+   PROFILE_MACHINE_SCAN,
+   PROFILE_TABLE_SCAN,
+   PROFILE_DISPLAY_LIST,
+   PROFILE_REBUILD_PANEL,
+   PROFILE_HEADER_DRAW,
+   PROFILE_PANEL_DRAW,
+   PROFILE_FIRST_FRAME,      /* from Profile_startup to the first frame drawn */
+   PROFILE_FIRST_TABLE,      /* from Profile_startup to the first frame with the table scanned */
+   PROFILE_BUILTIN_PHASES
+} ProfilePhase;
+
+#define PROFILE_MAX_PHASES 24
+
+/* Bucket i counts durations below 2^i microseconds, the last one everything longer */
+#define PROFILE_BUCKETS 24
+
+typedef struct ProfileStats_ {
+   const char* name;
+   uint64_t count;
+   uint64_t totalNs;
+   uint64_t lastNs;
+   uint64_t maxNs;
+   uint64_t syscalls;      /* read and write syscalls, only counted with Profile_enableSyscalls() */
+   uint64_t histogram[PROFILE_BUCKETS];
+} ProfileStats;
+
+typedef struct ProfileMark_ {
+   uint64_t ns;
+   bool counted;
+   uint64_t syscalls;
+   uint64_t sampling;
+} ProfileMark;
+
+/* Memory of the process rows, counted by the platform as rows and their optional details come and go */
+typedef struct ProfileRowMemory_ {
+   size_t rowSize;
+   size_t rows;
+   size_t detailsSize;
+   size_t details;
+} ProfileRowMemory;
+
+extern ProfileStats Profile_stats[PROFILE_MAX_PHASES];
+
+extern ProfileRowMemory Profile_rowMemory;
+
+extern size_t Profile_phaseCount;
+
+/* Taken first thing on startup, the start of the first frame phases */
+extern ProfileMark Profile_startup;
+
+/* Whether syscalls are counted, which costs a few syscalls for each timed phase */
+extern bool Profile_syscallsEnabled;
+
+/* Returns false if syscalls cannot be counted on this platform */
+bool Profile_enableSyscalls(void);
+
+/* Registers a phase by name, or returns the one already using it; -1 if there are too many */
+int Profile_addPhase(const char* name);
+
+ProfileMark Profile_begin(void);
+
+void Profile_end(int phase, ProfileMark mark);
+
+/* Upper bound of the bucket the given fraction of samples falls into, in nanoseconds */
+uint64_t Profile_percentile(const ProfileStats* stats, double fraction);
+
+/* One line on the memory of the process rows; false if none were counted */
+bool Profile_formatRowMemory(char* buffer, size_t size);
+
+/* Line `line` of the table of heap memory by class, a header first; false past the last, or without heap accounting */
+bool Profile_formatHeap(size_t line, char* buffer, size_t size);
+
+void Profile_dump(FILE* out);
+
+#endif
@@ -0,0 +1,95 @@
+/*
+htop - ProfileScreen.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "ProfileScreen.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "LineStore.h"
+#include "Macros.h"
+#include "Panel.h"
+#include "Profile.h"
+#include "ProvideCurses.h"
+#include "XUtils.h"
+
+
+ProfileScreen* ProfileScreen_new(void) {
+   ProfileScreen* this = xMalloc(sizeof(ProfileScreen));
+   Object_setClass(this, Class(ProfileScreen));
+
+   char header[128];
+   xSnprintf(header, sizeof(header), "%-16s %9s %9s %9s %9s %9s %9s%s",
+             "phase", "count", "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms",
+             Profile_syscallsEnabled ? "  syscalls" : "");
+   return (ProfileScreen*) InfoScreen_init(&this->super, NULL, NULL, LINES - 2, header);
+}
+
+void ProfileScreen_delete(Object* this) {
+   free(InfoScreen_done((InfoScreen*)this));
+}
+
+static void ProfileScreen_draw(InfoScreen* this) {
+   InfoScreen_drawTitled(this, "Timings of htop itself");
+}
+
+static void ProfileScreen_scan(InfoScreen* this) {
+   Panel* panel = this->display;
+   int idx = MAXIMUM(Panel_getSelectedIndex(panel), 0);
+
+   Panel_prune(panel);
+
+   for (size_t i = 0; i < Profile_phaseCount; i++) {
+      const ProfileStats* stats = &Profile_stats[i];
+      if (!stats->count)
+         continue;
+
+      char syscalls[16] = "";
+      if (Profile_syscallsEnabled)
+         xSnprintf(syscalls, sizeof(syscalls), " %9.1f", (double)stats->syscalls / (double)stats->count);
+
+      char line[256];
+      xSnprintf(line, sizeof(line), "%-16s %9" PRIu64 " %9.3f %9.3f %9.3f %9.3f %9.3f%s",
+                stats->name, stats->count,
+                (double)stats->totalNs / (double)stats->count / 1e6,
+                (double)Profile_percentile(stats, 0.5) / 1e6,
+                (double)Profile_percentile(stats, 0.9) / 1e6,
+                (double)Profile_percentile(stats, 0.99) / 1e6,
+                (double)stats->maxNs / 1e6,
+                syscalls);
+      InfoScreen_addLine(this, line);
+   }
+
+   if (LineStore_size(this->lines) == 0)
+      InfoScreen_addLine(this, "Nothing has been timed yet.");
+
+   char rowMemory[256];
+   if (Profile_formatRowMemory(rowMemory, sizeof(rowMemory))) {
+      InfoScreen_addLine(this, "");
+      InfoScreen_addLine(this, rowMemory);
+   }
+
+   char heap[128];
+   for (size_t line = 0; Profile_formatHeap(line, heap, sizeof(heap)); line++) {
+      if (line == 0)
+         InfoScreen_addLine(this, "");
+      InfoScreen_addLine(this, heap);
+   }
+
+   Panel_setSelected(panel, idx);
+}
+
+const InfoScreenClass ProfileScreen_class = {
+   .super = {
+      .extends = Class(Object),
+      .delete = ProfileScreen_delete
+   },
+   .scan = ProfileScreen_scan,
+   .draw = ProfileScreen_draw
+};
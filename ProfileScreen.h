@@ -0,0 +1,24 @@
+#ifndef HEADER_ProfileScreen
+#define HEADER_ProfileScreen
+/*
+htop - ProfileScreen.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "InfoScreen.h"
+#include "Object.h"
+
+
+typedef struct ProfileScreen_ {
+   InfoScreen super;
+} ProfileScreen;
+
+extern const InfoScreenClass ProfileScreen_class;
+
+ProfileScreen* ProfileScreen_new(void);
+
+void ProfileScreen_delete(Object* this);
+
+#endif
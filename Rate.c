@@ -0,0 +1,102 @@
+/*
+htop - Rate.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "Rate.h"
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+
+void Rate_reset(Rate* this) {
+   this->last = 0;
+   this->lastMs = 0;
+   this->value = NAN;
+}
+
+/* Change of the counter since the last read, false if there is none to compare with */
+static bool Rate_delta(const Rate* this, unsigned long long counter, unsigned long long range, unsigned long long* delta) {
+   if (counter >= this->last) {
+      *delta = counter - this->last;
+      return true;
+   }
+
+   /* counters with a known range wrap around past it */
+   if (range && this->last <= range) {
+      *delta = (range - this->last) + counter + 1;
+      return true;
+   }
+
+   /* 32 bit counters (e.g. of some network drivers) wrap around, 64 bit ones do not in practice */
+   if (this->last <= UINT32_MAX && this->last - counter > UINT32_MAX / 2) {
+      *delta = (UINT32_MAX - this->last) + counter + 1;
+      return true;
+   }
+
+   return false;
+}
+
+/*
+ * Takes the read, true with the rate since the last one in *instant if it is
+ * a new interval, false if the rate is left as it was or is now unknown.
+ */
+static bool Rate_sample(Rate* this, unsigned long long counter, unsigned long long range, uint64_t nowMs, double* instant, uint64_t* elapsedMs) {
+   if (counter == ULLONG_MAX) {
+      Rate_reset(this);
+      return false;
+   }
+
+   if (this->lastMs && nowMs <= this->lastMs)
+      return false;
+
+   unsigned long long delta;
+   const bool known = this->lastMs && Rate_delta(this, counter, range, &delta);
+   if (known) {
+      *elapsedMs = nowMs - this->lastMs;
+      *instant = (double)delta * 1000.0 / (double)*elapsedMs;
+   } else {
+      this->value = NAN;
+   }
+
+   this->last = counter;
+   this->lastMs = nowMs;
+   return known;
+}
+
+double Rate_update(Rate* this, unsigned long long counter, uint64_t nowMs) {
+   double instant;
+   uint64_t elapsedMs;
+   if (Rate_sample(this, counter, 0, nowMs, &instant, &elapsedMs))
+      this->value = instant;
+   return Rate_value(this);
+}
+
+double Rate_updateWrapping(Rate* this, unsigned long long counter, unsigned long long range, uint64_t nowMs) {
+   double instant;
+   uint64_t elapsedMs;
+   if (Rate_sample(this, counter, range, nowMs, &instant, &elapsedMs))
+      this->value = instant;
+   return Rate_value(this);
+}
+
+double Rate_updateSmoothed(Rate* this, unsigned long long counter, uint64_t nowMs, uint64_t halfLifeMs) {
+   double instant;
+   uint64_t elapsedMs;
+   if (!Rate_sample(this, counter, 0, nowMs, &instant, &elapsedMs))
+      return Rate_value(this);
+
+   if (isnan(this->value) || halfLifeMs == 0) {
+      this->value = instant;
+   } else {
+      /* the weight of the old rate halves every halfLifeMs, whatever the interval */
+      const double keep = exp2(-(double)elapsedMs / (double)halfLifeMs);
+      this->value = instant + (this->value - instant) * keep;
+   }
+   return this->value;
+}
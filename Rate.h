@@ -0,0 +1,52 @@
+#ifndef HEADER_Rate
+#define HEADER_Rate
+/*
+htop - Rate.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <math.h>
+#include <stdint.h>
+
+
+/*
+ * Turns a counter read again and again (bytes, events, nanoseconds of some
+ * state) into its change per second. A zeroed Rate is valid: the rate is
+ * unknown until two reads of the counter are known.
+ */
+typedef struct Rate_ {
+   unsigned long long last;     /* counter at the last read */
+   uint64_t lastMs;             /* time of the last read, 0 if none */
+   double value;                /* change per second over the last interval(s) */
+} Rate;
+
+/*
+ * Takes a new read of the counter at `nowMs` (any clock in milliseconds,
+ * as long as it is the same for all reads), returns the rate or NAN.
+ *
+ * ULLONG_MAX, the unknown value of counters, forgets the last read. A
+ * counter going down wrapped around at 32 bits if it was close to that
+ * limit, else it was reset (e.g. a pid reused) and is read anew. Reads
+ * within the same millisecond keep the last rate.
+ */
+double Rate_update(Rate* this, unsigned long long counter, uint64_t nowMs);
+
+/*
+ * As Rate_update(), for a counter known to wrap around after `range`
+ * (like the energy counters of RAPL): a counter going down went past it.
+ */
+double Rate_updateWrapping(Rate* this, unsigned long long counter, unsigned long long range, uint64_t nowMs);
+
+/* As Rate_update(), but averaging the rate exponentially with the given half-life */
+double Rate_updateSmoothed(Rate* this, unsigned long long counter, uint64_t nowMs, uint64_t halfLifeMs);
+
+/* Forgets all reads, the rate is unknown again */
+void Rate_reset(Rate* this);
+
+static inline double Rate_value(const Rate* this) {
+   return this->lastMs ? this->value : NAN;
+}
+
+#endif
@@ -0,0 +1,603 @@
+/*
+htop - Recorder.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "Recorder.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "CRT.h"
+#include "Hashtable.h"
+#include "Macros.h"
+#include "Platform.h"
+#include "Process.h"
+#include "ProcessTable.h"
+#include "RecorderTrigger.h"
+#include "Row.h"
+#include "Settings.h"
+#include "Vector.h"
+#include "XUtils.h"
+
+
+/* Key frames are written after this many frames once their index slot's share of the ring is used up */
+#define RECORDER_KEY_INTERVAL 120
+
+/* and in any case after this many shares, which bounds what seeking decodes */
+#define RECORDER_KEY_MAX_SHARES 16
+
+/* Frames larger than this part of the ring are dropped */
+#define RECORDER_MAX_FRAME_SHARE 4
+
+/* Once a trigger fires, the frames are scanned this often for this long */
+#define RECORDER_BURST_INTERVAL_MS 100
+#define RECORDER_BURST_MS 10000
+
+typedef struct RecorderProcess_ {
+   int64_t values[RECORDER_PROCESS_FIELDS];
+   uint64_t frame;
+} RecorderProcess;
+
+typedef struct RecorderPending_ {
+   uint8_t* data;
+   uint64_t length;
+   bool key;
+   uint64_t realtimeMs;
+   uint64_t monotonicMs;
+} RecorderPending;
+
+typedef struct RecorderString_ {
+   uint32_t id;
+   char str[];
+} RecorderString;
+
+typedef struct Recorder_ {
+   int fd;
+   RecorderHeader* header;
+   uint8_t* ring;
+   size_t mapped;
+
+   /* the frame being encoded */
+   uint8_t* buffer;
+   size_t used;
+   size_t alloc;
+
+   int64_t machine[RECORDER_MACHINE_FIELDS];
+   Hashtable* processes;            /* RecorderProcess by pid */
+   Hashtable* strings;              /* RecorderString by hash of the string */
+   uint32_t nextStringId;
+
+   uint64_t framesSinceKey;
+   uint64_t bytesSinceKey;
+
+   /* pids that exited, collected while going through the processes */
+   pid_t* gone;
+   size_t goneCount;
+   size_t goneAlloc;
+
+   /* with triggers, the frames outside of a burst are held back, starting with a key frame */
+   RecorderPending* pending;
+   size_t pendingCount;
+   size_t pendingAlloc;
+   uint64_t pendingBytes;
+   uint64_t pendingKeyMs;
+   uint64_t burstUntilMs;
+} Recorder;
+
+static volatile sig_atomic_t Recorder_stop = 0;
+
+static void Recorder_reserve(Recorder* this, size_t len) {
+   if (this->used + len <= this->alloc)
+      return;
+
+   this->alloc = MAXIMUM(2 * this->alloc, this->used + len);
+   this->buffer = xRealloc(this->buffer, this->alloc);
+}
+
+static void Recorder_putBytes(Recorder* this, const void* data, size_t len) {
+   Recorder_reserve(this, len);
+   memcpy(this->buffer + this->used, data, len);
+   this->used += len;
+}
+
+static void Recorder_putVarint(Recorder* this, uint64_t v) {
+   Recorder_reserve(this, 10);
+   do {
+      uint8_t byte = v & 0x7f;
+      v >>= 7;
+      this->buffer[this->used++] = v ? (byte | 0x80) : byte;
+   } while (v);
+}
+
+static void Recorder_putDelta(Recorder* this, int64_t value, int64_t previous) {
+   int64_t d = (int64_t)((uint64_t)value - (uint64_t)previous);
+   Recorder_putVarint(this, ((uint64_t)d << 1) ^ (uint64_t)(d >> 63));
+}
+
+static ht_key_t Recorder_hash(const char* str) {
+   /* FNV-1a */
+   ht_key_t h = 2166136261U;
+   for (const char* c = str; *c; c++) {
+      h ^= (unsigned char)*c;
+      h *= 16777619U;
+   }
+   return h;
+}
+
+/* Id of a string, defined in the frame with its first use since the key frame */
+static uint32_t Recorder_intern(Recorder* this, const char* str) {
+   if (!str || !str[0])
+      return 0;
+
+   ht_key_t hash = Recorder_hash(str);
+   const RecorderString* known = Hashtable_get(this->strings, hash);
+   if (known && String_eq(known->str, str))
+      return known->id;
+
+   /* a colliding string just takes over the hash */
+   size_t len = strlen(str);
+   RecorderString* interned = xMalloc(sizeof(RecorderString) + len + 1);
+   interned->id = this->nextStringId++;
+   memcpy(interned->str, str, len + 1);
+   Hashtable_put(this->strings, hash, interned);
+
+   Recorder_putVarint(this, RECORDER_RECORD_STRING);
+   Recorder_putVarint(this, interned->id);
+   Recorder_putVarint(this, len);
+   Recorder_putBytes(this, str, len);
+   return interned->id;
+}
+
+static void Recorder_machineValues(const Machine* host, int64_t* values) {
+   const ProcessTable* pt = (const ProcessTable*) host->processTable;
+
+   values[RECORDER_MACHINE_TOTAL_MEM] = (int64_t)host->totalMem;
+   values[RECORDER_MACHINE_USED_MEM] = (int64_t)host->usedMem;
+   values[RECORDER_MACHINE_BUFFERS_MEM] = (int64_t)host->buffersMem;
+   values[RECORDER_MACHINE_CACHED_MEM] = (int64_t)host->cachedMem;
+   values[RECORDER_MACHINE_SHARED_MEM] = (int64_t)host->sharedMem;
+   values[RECORDER_MACHINE_AVAILABLE_MEM] = (int64_t)host->availableMem;
+   values[RECORDER_MACHINE_TOTAL_SWAP] = (int64_t)host->totalSwap;
+   values[RECORDER_MACHINE_USED_SWAP] = (int64_t)host->usedSwap;
+   values[RECORDER_MACHINE_CACHED_SWAP] = (int64_t)host->cachedSwap;
+   values[RECORDER_MACHINE_ACTIVE_CPUS] = host->activeCPUs;
+   values[RECORDER_MACHINE_TOTAL_TASKS] = pt->totalTasks;
+   values[RECORDER_MACHINE_RUNNING_TASKS] = pt->runningTasks;
+   values[RECORDER_MACHINE_USERLAND_THREADS] = pt->userlandThreads;
+   values[RECORDER_MACHINE_KERNEL_THREADS] = pt->kernelThreads;
+
+   double load1, load5, load15;
+   Platform_getLoadAverage(&load1, &load5, &load15);
+   values[RECORDER_MACHINE_LOAD1] = (int64_t)(load1 * 100.0 + 0.5);
+   values[RECORDER_MACHINE_LOAD5] = (int64_t)(load5 * 100.0 + 0.5);
+   values[RECORDER_MACHINE_LOAD15] = (int64_t)(load15 * 100.0 + 0.5);
+   values[RECORDER_MACHINE_EXISTING_CPUS] = host->existingCPUs;
+}
+
+static void Recorder_processValues(Recorder* this, const Process* proc, int64_t* values) {
+   values[RECORDER_PROCESS_PPID] = Process_getParent(proc);
+   values[RECORDER_PROCESS_TGID] = Process_getThreadGroup(proc);
+   values[RECORDER_PROCESS_UID] = proc->st_uid;
+   values[RECORDER_PROCESS_STATE] = proc->state;
+   values[RECORDER_PROCESS_KIND] = (Process_isKernelThread(proc) ? 1 : 0) | (Process_isUserlandThread(proc) ? 2 : 0);
+   values[RECORDER_PROCESS_CPU] = isNonnegative(proc->percent_cpu) ? (int64_t)(proc->percent_cpu * 10.0F + 0.5F) : -1;
+   values[RECORDER_PROCESS_MEM] = isNonnegative(proc->percent_mem) ? (int64_t)(proc->percent_mem * 10.0F + 0.5F) : -1;
+   values[RECORDER_PROCESS_VIRT] = proc->m_virt;
+   values[RECORDER_PROCESS_RES] = proc->m_resident;
+   values[RECORDER_PROCESS_TIME] = (int64_t)proc->time;
+   values[RECORDER_PROCESS_NLWP] = proc->nlwp;
+   values[RECORDER_PROCESS_PRIORITY] = proc->priority;
+   values[RECORDER_PROCESS_NICE] = proc->nice;
+   values[RECORDER_PROCESS_PROCESSOR] = proc->processor;
+   values[RECORDER_PROCESS_STARTTIME] = proc->starttime_ctime;
+   values[RECORDER_PROCESS_COMM] = Recorder_intern(this, proc->procComm);
+   values[RECORDER_PROCESS_CMDLINE] = Recorder_intern(this, proc->cmdline);
+}
+
+static void Recorder_encodeProcess(Recorder* this, const Process* proc, uint64_t frame) {
+   const pid_t pid = Process_getPid(proc);
+   RecorderProcess* known = Hashtable_get(this->processes, (ht_key_t)pid);
+   if (!known) {
+      known = xCalloc(1, sizeof(RecorderProcess));
+      Hashtable_put(this->processes, (ht_key_t)pid, known);
+   }
+   known->frame = frame;
+
+   /* the string records go before the process record using them */
+   int64_t values[RECORDER_PROCESS_FIELDS];
+   Recorder_processValues(this, proc, values);
+
+   uint32_t mask = 0;
+   for (int i = 0; i < RECORDER_PROCESS_FIELDS; i++) {
+      if (values[i] != known->values[i])
+         mask |= 1U << i;
+   }
+   if (!mask)
+      return;
+
+   Recorder_putVarint(this, RECORDER_RECORD_PROCESS);
+   Recorder_putVarint(this, (uint64_t)pid);
+   Recorder_putVarint(this, mask);
+   for (int i = 0; i < RECORDER_PROCESS_FIELDS; i++) {
+      if (mask & (1U << i)) {
+         Recorder_putDelta(this, values[i], known->values[i]);
+         known->values[i] = values[i];
+      }
+   }
+}
+
+static void Recorder_collectGone(ht_key_t key, void* value, void* data) {
+   Recorder* this = data;
+   const RecorderProcess* known = value;
+
+   if (known->frame == this->header->frames)
+      return;
+
+   if (this->goneCount == this->goneAlloc) {
+      this->goneAlloc = this->goneAlloc ? 2 * this->goneAlloc : 64;
+      this->gone = xReallocArray(this->gone, this->goneAlloc, sizeof(pid_t));
+   }
+   this->gone[this->goneCount++] = (pid_t)key;
+}
+
+static void Recorder_encodeFrame(Recorder* this, const Machine* host, bool key, const char* trigger) {
+   if (key) {
+      /* a key frame is readable without anything before it */
+      Hashtable_clear(this->processes);
+      Hashtable_clear(this->strings);
+      this->nextStringId = 1;
+      memset(this->machine, 0, sizeof(this->machine));
+   }
+
+   this->used = 0;
+   const RecorderFrameHeader header = { .kind = key ? RECORDER_FRAME_KEY : RECORDER_FRAME_DELTA };
+   Recorder_putBytes(this, &header, sizeof(header));
+
+   Recorder_putVarint(this, host->realtimeMs);
+
+   int64_t machine[RECORDER_MACHINE_FIELDS];
+   Recorder_machineValues(host, machine);
+   Recorder_putVarint(this, RECORDER_MACHINE_FIELDS);
+   for (int i = 0; i < RECORDER_MACHINE_FIELDS; i++) {
+      Recorder_putDelta(this, machine[i], this->machine[i]);
+      this->machine[i] = machine[i];
+   }
+
+   if (host->pressureEvents) {
+      Recorder_putVarint(this, RECORDER_RECORD_PRESSURE);
+      Recorder_putVarint(this, host->pressureEvents);
+   }
+
+   if (trigger) {
+      size_t len = strlen(trigger);
+      Recorder_putVarint(this, RECORDER_RECORD_TRIGGER);
+      Recorder_putVarint(this, len);
+      Recorder_putBytes(this, trigger, len);
+   }
+
+   const uint64_t frame = this->header->frames;
+   const Vector* rows = host->processTable->rows;
+   for (int i = 0; i < Vector_size(rows); i++) {
+      const Row* row = (const Row*) Vector_get(rows, i);
+      if (row->tombStampMs > 0)
+         continue;
+      Recorder_encodeProcess(this, (const Process*) row, frame);
+   }
+
+   this->goneCount = 0;
+   Hashtable_foreach(this->processes, Recorder_collectGone, this);
+   for (size_t i = 0; i < this->goneCount; i++) {
+      Recorder_putVarint(this, RECORDER_RECORD_EXIT);
+      Recorder_putVarint(this, (uint64_t)this->gone[i]);
+      free(Hashtable_remove(this->processes, (ht_key_t)this->gone[i]));
+   }
+
+   Recorder_putVarint(this, RECORDER_RECORD_END);
+
+   /* pad to keep the frame lengths aligned */
+   static const uint8_t zeroes[8];
+   Recorder_putBytes(this, zeroes, (8 - this->used % 8) % 8);
+
+   const uint32_t length = (uint32_t)this->used;
+   const uint32_t checksum = Recorder_checksum(this->buffer + sizeof(header), this->used - sizeof(header));
+   memcpy(this->buffer + offsetof(RecorderFrameHeader, length), &length, sizeof(length));
+   memcpy(this->buffer + offsetof(RecorderFrameHeader, checksum), &checksum, sizeof(checksum));
+}
+
+/* Forgets the key frames in the part of the ring about to be overwritten */
+static void Recorder_overwrite(Recorder* this, uint64_t from, uint64_t to) {
+   RecorderHeader* header = this->header;
+
+   while (header->indexCount > 0) {
+      const RecorderIndexEntry* k = Recorder_indexEntry(header, 0);
+      if (k->offset >= to || k->offset + k->length <= from)
+         break;
+      header->indexFirst = (header->indexFirst + 1) % header->indexCapacity;
+      header->indexCount--;
+   }
+}
+
+static bool Recorder_append(Recorder* this, const uint8_t* data, uint64_t length, bool key, uint64_t realtimeMs) {
+   RecorderHeader* header = this->header;
+   uint64_t offset = header->head;
+
+   if (offset + length > header->ringSize) {
+      if (offset + 8 <= header->ringSize)
+         memset(this->ring + offset, 0, sizeof(uint32_t));
+      Recorder_overwrite(this, offset, header->ringSize);
+      offset = 0;
+   }
+   Recorder_overwrite(this, offset, offset + length);
+
+   if (!key && header->indexCount == 0) {
+      /* the frames of this epoch are no use without its key frame */
+      return false;
+   }
+
+   memcpy(this->ring + offset, data, length);
+
+   if (key) {
+      /* the oldest epoch is given up if there are more key frames than expected */
+      if (header->indexCount == header->indexCapacity) {
+         header->indexFirst = (header->indexFirst + 1) % header->indexCapacity;
+         header->indexCount--;
+      }
+      header->index[(header->indexFirst + header->indexCount) % header->indexCapacity] = (RecorderIndexEntry) {
+         .offset = offset,
+         .length = length,
+         .realtimeMs = realtimeMs,
+      };
+      header->indexCount++;
+   }
+
+   header->head = offset + length;
+   header->tail = Recorder_indexEntry(header, 0)->offset;
+   header->frames++;
+   header->lastRealtimeMs = realtimeMs;
+   return true;
+}
+
+static bool Recorder_open(Recorder* this, const char* path) {
+   this->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+   if (this->fd < 0)
+      return false;
+
+   struct stat st;
+   if (fstat(this->fd, &st) < 0)
+      return false;
+
+   size_t size = (size_t)st.st_size;
+   if (size < 2 * RECORDER_INDEX_SPAN) {
+      size = RECORDER_DEFAULT_SIZE;
+      if (ftruncate(this->fd, (off_t)size) < 0)
+         return false;
+   }
+
+   const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+   const uint32_t capacity = (uint32_t)MAXIMUM(size / RECORDER_INDEX_SPAN, 64);
+   const size_t headerSize = (sizeof(RecorderHeader) + capacity * sizeof(RecorderIndexEntry) + pageSize - 1) / pageSize * pageSize;
+
+   void* addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+   if (addr == MAP_FAILED)
+      return false;
+
+   this->mapped = size;
+   this->header = addr;
+   this->ring = (uint8_t*)addr + headerSize;
+
+   /* an earlier recording in the file is started over */
+   RecorderHeader* header = this->header;
+   memset(header, 0, headerSize);
+   memcpy(header->magic, RECORDER_MAGIC, sizeof(header->magic));
+   header->version = RECORDER_VERSION;
+   header->headerSize = (uint32_t)headerSize;
+   header->ringSize = (size - headerSize) & ~(uint64_t)7;
+   header->indexCapacity = capacity;
+   return true;
+}
+
+static void Recorder_close(Recorder* this) {
+   if (this->header)
+      munmap(this->header, this->mapped);
+   if (this->fd >= 0)
+      close(this->fd);
+
+   Hashtable_delete(this->processes);
+   Hashtable_delete(this->strings);
+   free(this->buffer);
+   free(this->gone);
+
+   for (size_t i = 0; i < this->pendingCount; i++)
+      free(this->pending[i].data);
+   free(this->pending);
+   RecorderTrigger_done();
+}
+
+/* Drops the oldest frames held back */
+static void Recorder_dropPending(Recorder* this, size_t count) {
+   for (size_t i = 0; i < count; i++) {
+      this->pendingBytes -= this->pending[i].length;
+      free(this->pending[i].data);
+   }
+   this->pendingCount -= count;
+   memmove(this->pending, this->pending + count, this->pendingCount * sizeof(RecorderPending));
+}
+
+/* Holds back the frame just encoded, keeping the epochs that cover the window before a trigger */
+static void Recorder_hold(Recorder* this, bool key, const Machine* host) {
+   if (this->pendingCount == this->pendingAlloc) {
+      this->pendingAlloc = this->pendingAlloc ? 2 * this->pendingAlloc : 64;
+      this->pending = xReallocArray(this->pending, this->pendingAlloc, sizeof(RecorderPending));
+   }
+   uint8_t* data = xMalloc(this->used);
+   memcpy(data, this->buffer, this->used);
+   this->pending[this->pendingCount++] = (RecorderPending) {
+      .data = data,
+      .length = this->used,
+      .key = key,
+      .realtimeMs = host->realtimeMs,
+      .monotonicMs = host->monotonicMs,
+   };
+   this->pendingBytes += this->used;
+   if (key)
+      this->pendingKeyMs = host->monotonicMs;
+
+   /* the oldest epoch goes once the next one covers the window, or to keep them within half the ring */
+   for (;;) {
+      size_t next = 1;
+      while (next < this->pendingCount && !this->pending[next].key)
+         next++;
+      if (next == this->pendingCount)
+         break;
+      if (this->pending[next].monotonicMs + RecorderTrigger_beforeMs > host->monotonicMs && this->pendingBytes <= this->header->ringSize / 2)
+         break;
+      Recorder_dropPending(this, next);
+   }
+}
+
+/* Writes the frames held back, false if one of them could not be */
+static bool Recorder_flush(Recorder* this) {
+   bool ok = true;
+   for (size_t i = 0; ok && i < this->pendingCount; i++) {
+      const RecorderPending* frame = &this->pending[i];
+      ok = Recorder_append(this, frame->data, frame->length, frame->key, frame->realtimeMs);
+   }
+   Recorder_dropPending(this, this->pendingCount);
+   return ok;
+}
+
+static void Recorder_record(Recorder* this, Machine* host) {
+   const RecorderHeader* header = this->header;
+   const uint64_t share = header->ringSize / header->indexCapacity;
+
+   const char* trigger = RecorderTrigger_check(host);
+   if (trigger)
+      this->burstUntilMs = host->monotonicMs + RECORDER_BURST_MS;
+   const bool holding = RecorderTrigger_count() > 0 && host->monotonicMs >= this->burstUntilMs;
+
+   /* while held back, key frames also split the window before a trigger, so that it can be kept on its own */
+   bool key = (holding ? this->pendingCount == 0 : header->indexCount == 0 && this->pendingCount == 0) ||
+              (holding && host->monotonicMs - this->pendingKeyMs >= RecorderTrigger_beforeMs / 2) ||
+              (this->framesSinceKey >= RECORDER_KEY_INTERVAL && this->bytesSinceKey >= share) ||
+              this->bytesSinceKey >= RECORDER_KEY_MAX_SHARES * share;
+
+   Recorder_encodeFrame(this, host, key, trigger);
+
+   bool ok = this->used <= header->ringSize / RECORDER_MAX_FRAME_SHARE;
+   if (ok && holding)
+      Recorder_hold(this, key, host);
+   else if (ok)
+      ok = (this->pendingCount == 0 || Recorder_flush(this)) && Recorder_append(this, this->buffer, this->used, key, host->realtimeMs);
+
+   if (!ok) {
+      /* start over with a key frame, the state of the dropped frames is lost */
+      Recorder_dropPending(this, this->pendingCount);
+      this->framesSinceKey = 0;
+      this->bytesSinceKey = RECORDER_KEY_MAX_SHARES * share;
+      return;
+   }
+
+   this->framesSinceKey = key ? 1 : this->framesSinceKey + 1;
+   this->bytesSinceKey = key ? this->used : this->bytesSinceKey + this->used;
+   host->pressureEvents = 0;
+}
+
+static void Recorder_handleSignal(ATTR_UNUSED int sgn) {
+   Recorder_stop = 1;
+}
+
+bool Recorder_run(Machine* host, const char* path) {
+   Settings* settings = host->settings;
+
+   Recorder recorder = {
+      .fd = -1,
+      .processes = Hashtable_new(512, true),
+      .strings = Hashtable_new(512, true),
+      .nextStringId = 1,
+   };
+
+   if (!Recorder_open(&recorder, path)) {
+      fprintf(stderr, "Error: can not record to %s: %s\n", path, strerror(errno));
+      Recorder_close(&recorder);
+      return false;
+   }
+
+   /* only the basic values of each process are recorded */
+   settings->highlightChanges = false;
+   settings->ss->flags = 0;
+   CRT_initHeadless();
+
+   struct sigaction act;
+   memset(&act, 0, sizeof(act));
+   act.sa_handler = Recorder_handleSignal;
+   sigemptyset(&act.sa_mask);
+   sigaction(SIGINT, &act, NULL);
+   sigaction(SIGTERM, &act, NULL);
+   sigaction(SIGHUP, &act, NULL);
+
+   /* the first scan gives no CPU usage yet */
+   Machine_scan(host);
+   Machine_scanTables(host);
+
+   uint64_t next;
+   Platform_gettime_monotonic(&next);
+
+   while (!Recorder_stop && host->iterationsRemaining != 0) {
+      if (host->monotonicMs < recorder.burstUntilMs)
+         next += RECORDER_BURST_INTERVAL_MS;
+      else
+         next += MAXIMUM(100 * (uint64_t)Machine_delay(host, settings->delay), 100);
+
+      uint64_t now;
+      Platform_gettime_monotonic(&now);
+      if (next > now) {
+         /* waits on the pressure triggers, a scan follows at once if one fires */
+         struct pollfd fds[MACHINE_PRESSURE_KINDS];
+         for (size_t i = 0; i < MACHINE_PRESSURE_KINDS; i++)
+            fds[i] = (struct pollfd) { .fd = host->pressureFds[i], .events = POLLPRI };
+
+         int r = poll(fds, MACHINE_PRESSURE_KINDS, (int)MINIMUM(next - now, (uint64_t)INT_MAX));
+         if (r < 0 && Recorder_stop)
+            break;
+
+         unsigned int events = 0;
+         for (size_t i = 0; r > 0 && i < MACHINE_PRESSURE_KINDS; i++) {
+            if (fds[i].revents & POLLPRI)
+               events |= 1U << i;
+         }
+         if (events) {
+            Machine_notePressure(host, events);
+            Platform_gettime_monotonic(&next);
+         }
+      } else {
+         /* behind after a stall, do not catch up with a burst of scans */
+         next = now;
+      }
+
+      Platform_gettime_realtime(&host->realtime, &host->realtimeMs);
+      Machine_scan(host);
+      Machine_scanTables(host);
+      Recorder_record(&recorder, host);
+
+      if (host->iterationsRemaining > 0)
+         host->iterationsRemaining--;
+   }
+
+   Recorder_close(&recorder);
+   return true;
+}
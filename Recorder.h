@@ -0,0 +1,180 @@
+#ifndef HEADER_Recorder
+#define HEADER_Recorder
+/*
+htop - Recorder.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Machine.h"
+
+
+/*
+ * Layout of a recording, all integers in host byte order:
+ *
+ * The first `headerSize` bytes hold a RecorderHeader and the index of the
+ * key frames, the rest of the file is a ring of frames. A frame starts with
+ * a RecorderFrameHeader: its length (a multiple of 8, including the header),
+ * its kind and the Recorder_checksum of its body; a length of 0, or less
+ * than 8 bytes left before the end of the ring, means the next frame is at
+ * the start of the ring. The frames from `tail` up to `head` are complete
+ * and `tail` is always a key frame, the oldest in the index. A frame read
+ * while it is overwritten fails its checksum.
+ *
+ * The index lists the key frames in the ring, oldest first, in a ring of
+ * `indexCapacity` slots. Key frames are written often enough that seeking
+ * only has to decode from the key frame before, and rarely enough that the
+ * index does not fill up.
+ *
+ * The body of a frame is a stream of LEB128 varints: the time in
+ * milliseconds since the epoch, the number of machine counters followed by
+ * each counter, then records up to RECORDER_RECORD_END. Counters and
+ * process fields are zigzag encoded differences to the previous frame; a
+ * key frame is relative to zeroes, so it is complete on its own.
+ *
+ * RECORDER_RECORD_STRING: id, length, bytes
+ *    Defines a string for the process fields COMM and CMDLINE of this and
+ *    the following frames up to the next key frame, which starts over.
+ * RECORDER_RECORD_PROCESS: pid, bit mask of the fields that follow
+ *    Only changed fields, in the order of RecorderProcessField; a pid
+ *    without a record since the key frame starts from zeroes.
+ * RECORDER_RECORD_EXIT: pid
+ * RECORDER_RECORD_PRESSURE: bit mask of MachinePressure
+ *    Pressure triggers that fired since the frame before, which was
+ *    scanned at once for.
+ * RECORDER_RECORD_TRIGGER: length, bytes
+ *    The --record-trigger rule that fired with this frame. The frames
+ *    before it were held back and written only then, the ones after it
+ *    follow at the burst rate.
+ */
+
+#define RECORDER_MAGIC "htoprec"
+#define RECORDER_VERSION 5
+
+/* File size of new recordings; the size of an existing file is kept */
+#define RECORDER_DEFAULT_SIZE (16 * 1024 * 1024)
+
+/* The index has a slot for every this many bytes of the ring */
+#define RECORDER_INDEX_SPAN (64 * 1024)
+
+typedef enum RecorderFrameKind_ {
+   RECORDER_FRAME_KEY = 1,
+   RECORDER_FRAME_DELTA = 2,
+} RecorderFrameKind;
+
+typedef enum RecorderRecord_ {
+   RECORDER_RECORD_END = 0,
+   RECORDER_RECORD_STRING = 1,
+   RECORDER_RECORD_PROCESS = 2,
+   RECORDER_RECORD_EXIT = 3,
+   RECORDER_RECORD_PRESSURE = 4,
+   RECORDER_RECORD_TRIGGER = 5,
+} RecorderRecord;
+
+typedef enum RecorderMachineField_ {
+   RECORDER_MACHINE_TOTAL_MEM,
+   RECORDER_MACHINE_USED_MEM,
+   RECORDER_MACHINE_BUFFERS_MEM,
+   RECORDER_MACHINE_CACHED_MEM,
+   RECORDER_MACHINE_SHARED_MEM,
+   RECORDER_MACHINE_AVAILABLE_MEM,
+   RECORDER_MACHINE_TOTAL_SWAP,
+   RECORDER_MACHINE_USED_SWAP,
+   RECORDER_MACHINE_CACHED_SWAP,
+   RECORDER_MACHINE_ACTIVE_CPUS,
+   RECORDER_MACHINE_TOTAL_TASKS,
+   RECORDER_MACHINE_RUNNING_TASKS,
+   RECORDER_MACHINE_USERLAND_THREADS,
+   RECORDER_MACHINE_KERNEL_THREADS,
+   RECORDER_MACHINE_LOAD1,                /* hundredths */
+   RECORDER_MACHINE_LOAD5,
+   RECORDER_MACHINE_LOAD15,
+   RECORDER_MACHINE_EXISTING_CPUS,
+   RECORDER_MACHINE_FIELDS
+} RecorderMachineField;
+
+typedef enum RecorderProcessField_ {
+   RECORDER_PROCESS_PPID,
+   RECORDER_PROCESS_TGID,
+   RECORDER_PROCESS_UID,
+   RECORDER_PROCESS_STATE,                /* ProcessState */
+   RECORDER_PROCESS_KIND,                 /* 1 kernel thread, 2 userland thread */
+   RECORDER_PROCESS_CPU,                  /* tenths of a percent, -1 if unknown */
+   RECORDER_PROCESS_MEM,                  /* tenths of a percent */
+   RECORDER_PROCESS_VIRT,                 /* KiB */
+   RECORDER_PROCESS_RES,                  /* KiB */
+   RECORDER_PROCESS_TIME,                 /* hundredths of seconds */
+   RECORDER_PROCESS_NLWP,
+   RECORDER_PROCESS_PRIORITY,
+   RECORDER_PROCESS_NICE,
+   RECORDER_PROCESS_PROCESSOR,
+   RECORDER_PROCESS_STARTTIME,            /* seconds since the epoch */
+   RECORDER_PROCESS_COMM,                 /* string id, 0 for none */
+   RECORDER_PROCESS_CMDLINE,              /* string id, 0 for none */
+   RECORDER_PROCESS_FIELDS
+} RecorderProcessField;
+
+typedef struct RecorderFrameHeader_ {
+   uint32_t length;
+   uint32_t kind;             /* RecorderFrameKind */
+   uint32_t checksum;
+   uint32_t reserved;
+} RecorderFrameHeader;
+
+typedef struct RecorderIndexEntry_ {
+   uint64_t offset;           /* in the ring */
+   uint64_t length;
+   uint64_t realtimeMs;
+} RecorderIndexEntry;
+
+typedef struct RecorderHeader_ {
+   char magic[8];
+   uint32_t version;
+   uint32_t headerSize;       /* of this header and the index, a multiple of the page size */
+   uint64_t ringSize;
+   uint64_t head;             /* ring offset of the next frame */
+   uint64_t tail;             /* ring offset of the oldest complete key frame */
+   uint64_t frames;           /* written since the recording started */
+   uint64_t lastRealtimeMs;
+   uint32_t indexCapacity;
+   uint32_t indexFirst;       /* slot of the oldest key frame */
+   uint32_t indexCount;
+   uint32_t reserved;
+   RecorderIndexEntry index[];
+} RecorderHeader;
+
+/* FNV-1a of the body of a frame, the bytes after its header */
+static inline uint32_t Recorder_checksum(const uint8_t* body, size_t length) {
+   uint32_t h = 2166136261U;
+   for (size_t i = 0; i < length; i++) {
+      h ^= body[i];
+      h *= 16777619U;
+   }
+   return h;
+}
+
+/* The i-th oldest key frame */
+static inline const RecorderIndexEntry* Recorder_indexEntry(const RecorderHeader* header, uint32_t i) {
+   return &header->index[(header->indexFirst + i) % header->indexCapacity];
+}
+
+/* The frame at offset, or the one at the start of the ring if it is marked to wrap */
+static inline uint64_t Recorder_frameAt(const RecorderHeader* header, const uint8_t* ring, uint64_t offset) {
+   if (offset + 8 > header->ringSize)
+      return 0;
+
+   uint32_t length;
+   memcpy(&length, ring + offset, sizeof(length));
+   return length ? offset : 0;
+}
+
+/* Scans at the configured delay and records every scan to path, or only those around the --record-trigger incidents, until the iterations are done or SIGINT or SIGTERM; false if path can not be recorded to */
+bool Recorder_run(Machine* host, const char* path);
+
+#endif
@@ -0,0 +1,287 @@
+/*
+htop - RecorderTrigger.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "RecorderTrigger.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CPUMeter.h"
+#include "Hashtable.h"
+#include "Macros.h"
+#include "Meter.h"
+#include "Platform.h"
+#include "ProcessSnapshot.h"
+#include "ProcessTable.h"
+#include "XUtils.h"
+
+
+/* Samples of the resident memory kept for each process, spread over the window of the rules */
+#define RECORDER_TRIGGER_SAMPLES 16
+
+#define RECORDER_TRIGGER_DEFAULT_RSS_WINDOW 10
+
+typedef enum RecorderTriggerKind_ {
+   RECORDER_TRIGGER_CPU,
+   RECORDER_TRIGGER_MEMORY,
+   RECORDER_TRIGGER_RSS,
+} RecorderTriggerKind;
+
+typedef struct RecorderTrigger_ {
+   const char* rule;
+   RecorderTriggerKind kind;
+   double threshold;                   /* percent, or KiB for RSS */
+   uint64_t windowMs;
+   uint64_t sinceMs;                   /* when the condition started to hold, 0 while it does not */
+   bool fired;                         /* and has not stopped holding since */
+} RecorderTrigger;
+
+typedef struct RecorderTriggerSample_ {
+   uint64_t monotonicMs;
+   long int resident;
+} RecorderTriggerSample;
+
+typedef struct RecorderTriggerProcess_ {
+   time_t starttime;
+   uint64_t scan;
+   RecorderTriggerSample samples[RECORDER_TRIGGER_SAMPLES];
+   unsigned int first;
+   unsigned int count;
+} RecorderTriggerProcess;
+
+uint64_t RecorderTrigger_beforeMs = RECORDER_TRIGGER_DEFAULT_BEFORE * 1000;
+
+static RecorderTrigger RecorderTrigger_rules[RECORDER_TRIGGER_MAX];
+static size_t RecorderTrigger_ruleCount;
+
+static Meter* RecorderTrigger_cpuMeter;
+static Hashtable* RecorderTrigger_processes;   /* RecorderTriggerProcess by pid, for the RSS rules */
+static uint64_t RecorderTrigger_scans;
+static uint64_t RecorderTrigger_rssWindowMs;   /* the longest of the RSS rules */
+
+/* Bytes with an optional binary suffix, in KiB */
+static bool RecorderTrigger_parseSize(const char* str, char** end, double* kib) {
+   double value = strtod(str, end);
+   if (*end == str || value <= 0)
+      return false;
+
+   switch (**end) {
+      case 'K': case 'k': value *= ONE_K; (*end)++; break;
+      case 'M': case 'm': value *= ONE_M; (*end)++; break;
+      case 'G': case 'g': value *= ONE_G; (*end)++; break;
+      case 'T': case 't': value *= ONE_T; (*end)++; break;
+      default: break;
+   }
+
+   *kib = value / ONE_K;
+   return true;
+}
+
+bool RecorderTrigger_add(const char* rule) {
+   if (RecorderTrigger_ruleCount == RECORDER_TRIGGER_MAX) {
+      fprintf(stderr, "Error: at most %d --record-trigger rules are supported.\n", RECORDER_TRIGGER_MAX);
+      return false;
+   }
+
+   RecorderTrigger trigger = { .rule = rule };
+   char* end;
+   bool ok;
+   unsigned int windowSecs = 0;
+
+   if (String_startsWith(rule, "cpu>") || String_startsWith(rule, "mem>")) {
+      trigger.kind = rule[0] == 'c' ? RECORDER_TRIGGER_CPU : RECORDER_TRIGGER_MEMORY;
+      trigger.threshold = strtod(rule + 4, &end);
+      ok = end != rule + 4 && trigger.threshold >= 0 && trigger.threshold < 100;
+   } else if (String_startsWith(rule, "rss+")) {
+      trigger.kind = RECORDER_TRIGGER_RSS;
+      ok = RecorderTrigger_parseSize(rule + 4, &end, &trigger.threshold);
+      windowSecs = RECORDER_TRIGGER_DEFAULT_RSS_WINDOW;
+   } else {
+      ok = false;
+      end = NULL;
+   }
+
+   if (ok && *end == '/') {
+      char* secsEnd;
+      long secs = strtol(end + 1, &secsEnd, 10);
+      ok = secsEnd != end + 1 && secs >= 0 && secs <= 3600;
+      windowSecs = (unsigned int)secs;
+      end = secsEnd;
+   }
+
+   if (!ok || *end || (trigger.kind == RECORDER_TRIGGER_RSS && windowSecs == 0)) {
+      fprintf(stderr, "Error: invalid trigger \"%s\", try cpu>95/3, mem>90 or rss+1G/10.\n", rule);
+      return false;
+   }
+
+   trigger.windowMs = 1000 * (uint64_t)windowSecs;
+   if (trigger.kind == RECORDER_TRIGGER_RSS)
+      RecorderTrigger_rssWindowMs = MAXIMUM(RecorderTrigger_rssWindowMs, trigger.windowMs);
+
+   RecorderTrigger_rules[RecorderTrigger_ruleCount++] = trigger;
+   return true;
+}
+
+size_t RecorderTrigger_count(void) {
+   return RecorderTrigger_ruleCount;
+}
+
+/* Records the resident memory of a process among the samples of the latest windows */
+static const RecorderTriggerProcess* RecorderTrigger_sampleProcess(pid_t pid, time_t starttime, long int resident, uint64_t now) {
+   RecorderTriggerProcess* known = Hashtable_get(RecorderTrigger_processes, (ht_key_t)pid);
+   if (!known || known->starttime != starttime) {
+      known = xCalloc(1, sizeof(RecorderTriggerProcess));
+      known->starttime = starttime;
+      Hashtable_put(RecorderTrigger_processes, (ht_key_t)pid, known);
+   }
+   known->scan = RecorderTrigger_scans;
+
+   /* samples are kept at most this often, so that the ones kept span the longest window */
+   const uint64_t spacing = RecorderTrigger_rssWindowMs / RECORDER_TRIGGER_SAMPLES;
+   const RecorderTriggerSample* last = known->count ? &known->samples[(known->first + known->count - 1) % RECORDER_TRIGGER_SAMPLES] : NULL;
+   if (!last || last->monotonicMs + spacing <= now) {
+      const RecorderTriggerSample sample = { .monotonicMs = now, .resident = resident };
+      if (known->count == RECORDER_TRIGGER_SAMPLES) {
+         known->samples[known->first] = sample;
+         known->first = (known->first + 1) % RECORDER_TRIGGER_SAMPLES;
+      } else {
+         known->samples[(known->first + known->count++) % RECORDER_TRIGGER_SAMPLES] = sample;
+      }
+   }
+
+   return known;
+}
+
+/* By how much the resident memory grew since its lowest sample within windowMs */
+static long int RecorderTrigger_growth(const RecorderTriggerProcess* known, long int resident, uint64_t now, uint64_t windowMs) {
+   long int lowest = resident;
+   for (unsigned int i = 0; i < known->count; i++) {
+      const RecorderTriggerSample* sample = &known->samples[(known->first + i) % RECORDER_TRIGGER_SAMPLES];
+      if (sample->monotonicMs + windowMs >= now)
+         lowest = MINIMUM(lowest, sample->resident);
+   }
+   return resident - lowest;
+}
+
+typedef struct RecorderTriggerSweep_ {
+   pid_t* gone;
+   size_t count;
+   size_t alloc;
+} RecorderTriggerSweep;
+
+static void RecorderTrigger_collectGone(ht_key_t key, void* value, void* data) {
+   RecorderTriggerSweep* sweep = data;
+   const RecorderTriggerProcess* known = value;
+
+   if (known->scan == RecorderTrigger_scans)
+      return;
+
+   if (sweep->count == sweep->alloc) {
+      sweep->alloc = sweep->alloc ? 2 * sweep->alloc : 64;
+      sweep->gone = xReallocArray(sweep->gone, sweep->alloc, sizeof(pid_t));
+   }
+   sweep->gone[sweep->count++] = (pid_t)key;
+}
+
+/* The largest growth of the resident memory of a process within the window of each RSS rule */
+static void RecorderTrigger_sampleProcesses(const Machine* host, double* growth) {
+   if (!RecorderTrigger_processes)
+      RecorderTrigger_processes = Hashtable_new(512, true);
+   RecorderTrigger_scans++;
+
+   const ProcessSnapshot* snapshot = &((const ProcessTable*) host->processTable)->snapshot;
+   for (size_t i = 0; i < snapshot->count; i++) {
+      /* threads share the memory of their process */
+      if (snapshot->kind[i])
+         continue;
+
+      const long int resident = (long int)snapshot->residentKB[i];
+      const RecorderTriggerProcess* known = RecorderTrigger_sampleProcess(snapshot->pid[i], snapshot->startTime[i], resident, host->monotonicMs);
+      for (size_t r = 0; r < RecorderTrigger_ruleCount; r++) {
+         const RecorderTrigger* trigger = &RecorderTrigger_rules[r];
+         if (trigger->kind == RECORDER_TRIGGER_RSS) {
+            long int grown = RecorderTrigger_growth(known, resident, host->monotonicMs, trigger->windowMs);
+            growth[r] = MAXIMUM(growth[r], (double)grown);
+         }
+      }
+   }
+
+   RecorderTriggerSweep sweep = { 0 };
+   Hashtable_foreach(RecorderTrigger_processes, RecorderTrigger_collectGone, &sweep);
+   for (size_t i = 0; i < sweep.count; i++)
+      free(Hashtable_remove(RecorderTrigger_processes, (ht_key_t)sweep.gone[i]));
+   free(sweep.gone);
+}
+
+const char* RecorderTrigger_check(const Machine* host) {
+   if (RecorderTrigger_ruleCount == 0)
+      return NULL;
+
+   double growth[RECORDER_TRIGGER_MAX] = { 0 };
+   if (RecorderTrigger_rssWindowMs)
+      RecorderTrigger_sampleProcesses(host, growth);
+
+   const char* fired = NULL;
+   const uint64_t now = host->monotonicMs;
+
+   for (size_t r = 0; r < RecorderTrigger_ruleCount; r++) {
+      RecorderTrigger* trigger = &RecorderTrigger_rules[r];
+      bool holds;
+
+      switch (trigger->kind) {
+         case RECORDER_TRIGGER_CPU: {
+            if (!RecorderTrigger_cpuMeter)
+               RecorderTrigger_cpuMeter = Meter_new(host, 0, (const MeterClass*) Class(CPUMeter));
+            /* CPU 0 is the average of all */
+            const double percent = Platform_setCPUValues(RecorderTrigger_cpuMeter, 0);
+            holds = isNonnegative(percent) && percent > trigger->threshold;
+            break;
+         }
+         case RECORDER_TRIGGER_MEMORY:
+            holds = host->totalMem > 0 && 100.0 * (double)host->usedMem / (double)host->totalMem > trigger->threshold;
+            break;
+         case RECORDER_TRIGGER_RSS:
+            holds = growth[r] > trigger->threshold;
+            break;
+         default:
+            holds = false;
+            break;
+      }
+
+      if (!holds) {
+         trigger->sinceMs = 0;
+         trigger->fired = false;
+         continue;
+      }
+
+      /* the RSS rules look back over their window themselves */
+      if (trigger->sinceMs == 0)
+         trigger->sinceMs = now;
+      if (trigger->fired || (trigger->kind != RECORDER_TRIGGER_RSS && now - trigger->sinceMs < trigger->windowMs))
+         continue;
+
+      trigger->fired = true;
+      if (!fired)
+         fired = trigger->rule;
+   }
+
+   return fired;
+}
+
+void RecorderTrigger_done(void) {
+   if (RecorderTrigger_cpuMeter)
+      Meter_delete((Object*) RecorderTrigger_cpuMeter);
+   if (RecorderTrigger_processes)
+      Hashtable_delete(RecorderTrigger_processes);
+
+   RecorderTrigger_cpuMeter = NULL;
+   RecorderTrigger_processes = NULL;
+   RecorderTrigger_ruleCount = 0;
+}
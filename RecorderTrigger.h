@@ -0,0 +1,47 @@
+#ifndef HEADER_RecorderTrigger
+#define HEADER_RecorderTrigger
+/*
+htop - RecorderTrigger.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Machine.h"
+
+
+/*
+ * Rules of --record-trigger that make the recorder capture at a high rate:
+ *
+ *    cpu>PERCENT[/SECONDS]   the average usage of all CPUs is above PERCENT
+ *    mem>PERCENT[/SECONDS]   the memory used is above PERCENT of the total
+ *    rss+SIZE[/SECONDS]      a process grew its resident memory by more than
+ *                            SIZE (bytes, or with K, M, G or T) within
+ *                            SECONDS, 10 if not given
+ *
+ * The first two fire once the condition held for SECONDS, at once without.
+ * A rule fires again only after its condition stopped holding.
+ */
+
+#define RECORDER_TRIGGER_MAX 8
+
+/* Pre-trigger window of frames held in memory, in seconds, unless --record-before sets it */
+#define RECORDER_TRIGGER_DEFAULT_BEFORE 30
+
+extern uint64_t RecorderTrigger_beforeMs;
+
+/* Adds a rule; false with an error printed if it is not one */
+bool RecorderTrigger_add(const char* rule);
+
+size_t RecorderTrigger_count(void);
+
+/* Checks the rules against the latest scan, returning the rule that fired or NULL */
+const char* RecorderTrigger_check(const Machine* host);
+
+void RecorderTrigger_done(void);
+
+#endif
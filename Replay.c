@@ -0,0 +1,540 @@
+/*
+htop - Replay.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "Replay.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Hashtable.h"
+#include "Macros.h"
+#include "Process.h"
+#include "XUtils.h"
+
+
+/* Frame number for the last frame of an epoch */
+#define REPLAY_LAST_FRAME SIZE_MAX
+
+typedef struct ReplayCursor_ {
+   const uint8_t* p;
+   const uint8_t* end;
+   bool ok;
+} ReplayCursor;
+
+typedef struct ReplayState_ {
+   int fd;
+   const RecorderHeader* header;
+   const uint8_t* ring;
+   size_t mapped;
+
+   /* the frame shown: the key frame of its epoch and how many frames after it */
+   size_t key;
+   size_t frame;
+   uint64_t offset;
+   bool atEnd;
+
+   /* a step or jump to show at the next scan instead of advancing */
+   bool pending;
+
+   /* a frame of the epoch shown was damaged, the ones after it up to the next key frame are skipped too */
+   bool damaged;
+
+   uint64_t realtimeMs;
+   unsigned int pressure;     /* MachinePressure bits of the triggers fired for the frame */
+   char trigger[64];          /* the --record-trigger rule that fired with the frame */
+   int64_t machine[RECORDER_MACHINE_FIELDS];
+   Hashtable* processes;      /* ReplayProcess by pid */
+   Hashtable* strings;        /* char* by id */
+
+   /* pids and string ids met while checking a frame, not owned */
+   Hashtable* framePids;
+   Hashtable* frameStrings;
+} ReplayState;
+
+static ReplayState Replay_state = { .fd = -1 };
+
+static uint64_t Replay_getVarint(ReplayCursor* c) {
+   uint64_t v = 0;
+   for (unsigned int shift = 0; shift < 64; shift += 7) {
+      if (c->p >= c->end) {
+         c->ok = false;
+         return 0;
+      }
+      uint8_t byte = *c->p++;
+      v |= (uint64_t)(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+         return v;
+   }
+
+   c->ok = false;
+   return 0;
+}
+
+static int64_t Replay_getDelta(ReplayCursor* c) {
+   uint64_t v = Replay_getVarint(c);
+   return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static void Replay_reset(ReplayState* this) {
+   Hashtable_clear(this->processes);
+   Hashtable_clear(this->strings);
+   memset(this->machine, 0, sizeof(this->machine));
+}
+
+/* Length and kind of the frame at offset, false if it does not fit the ring */
+static bool Replay_frameHeader(const ReplayState* this, uint64_t offset, uint32_t* length, uint32_t* kind) {
+   const RecorderHeader* header = this->header;
+   if (offset + 8 > header->ringSize)
+      return false;
+
+   memcpy(length, this->ring + offset + offsetof(RecorderFrameHeader, length), sizeof(*length));
+   memcpy(kind, this->ring + offset + offsetof(RecorderFrameHeader, kind), sizeof(*kind));
+   return *length >= sizeof(RecorderFrameHeader) && offset + *length <= header->ringSize;
+}
+
+/* Whether a process would be shown with a field of this value */
+static bool Replay_validField(ReplayState* this, int field, int64_t value, int64_t cpus, bool key) {
+   switch (field) {
+      case RECORDER_PROCESS_STATE:
+         return value >= UNKNOWN && value <= SLEEPING;
+      case RECORDER_PROCESS_KIND:
+         return value >= 0 && value <= 3;
+      case RECORDER_PROCESS_PROCESSOR:
+         return value >= 0 && value < MAXIMUM(cpus, 1);
+      case RECORDER_PROCESS_COMM:
+      case RECORDER_PROCESS_CMDLINE:
+         return value == 0 ||
+                (value > 0 && value <= UINT32_MAX &&
+                 (Hashtable_get(this->frameStrings, (ht_key_t)value) || (!key && Hashtable_get(this->strings, (ht_key_t)value))));
+      default:
+         return true;
+   }
+}
+
+/*
+ * Walks the records of a frame without applying them, false if they are
+ * cut short or would give a process a state, processor or string the rest
+ * of htop can not show. Strings and processes before a key frame do not
+ * count for it.
+ */
+static bool Replay_check(ReplayState* this, ReplayCursor c, bool key) {
+   Hashtable_clear(this->framePids);
+   Hashtable_clear(this->frameStrings);
+
+   Replay_getVarint(&c);
+
+   int64_t cpus = key ? 0 : this->machine[RECORDER_MACHINE_EXISTING_CPUS];
+   uint64_t fields = Replay_getVarint(&c);
+   for (uint64_t i = 0; i < fields && c.ok; i++) {
+      int64_t d = Replay_getDelta(&c);
+      if (i == RECORDER_MACHINE_EXISTING_CPUS)
+         cpus = (int64_t)((uint64_t)cpus + (uint64_t)d);
+   }
+
+   while (c.ok) {
+      uint64_t record = Replay_getVarint(&c);
+      if (!c.ok || record == RECORDER_RECORD_END)
+         return c.ok;
+
+      switch (record) {
+         case RECORDER_RECORD_STRING: {
+            uint64_t id = Replay_getVarint(&c);
+            uint64_t len = Replay_getVarint(&c);
+            if (!c.ok || id == 0 || id > UINT32_MAX || len > (uint64_t)(c.end - c.p))
+               return false;
+            Hashtable_put(this->frameStrings, (ht_key_t)id, this);
+            c.p += len;
+            break;
+         }
+         case RECORDER_RECORD_PROCESS: {
+            uint64_t pid = Replay_getVarint(&c);
+            uint64_t mask = Replay_getVarint(&c);
+            /* a pid recorded twice in a frame would be applied to values not checked here */
+            if (!c.ok || pid == 0 || pid > INT_MAX || mask >> RECORDER_PROCESS_FIELDS ||
+                Hashtable_get(this->framePids, (ht_key_t)pid))
+               return false;
+            Hashtable_put(this->framePids, (ht_key_t)pid, this);
+
+            const ReplayProcess* proc = key ? NULL : Hashtable_get(this->processes, (ht_key_t)pid);
+            for (int i = 0; i < RECORDER_PROCESS_FIELDS; i++) {
+               int64_t value = proc ? proc->values[i] : 0;
+               if (mask & (1U << i))
+                  value = (int64_t)((uint64_t)value + (uint64_t)Replay_getDelta(&c));
+               if (!Replay_validField(this, i, value, cpus, key))
+                  return false;
+            }
+            break;
+         }
+         case RECORDER_RECORD_EXIT:
+         case RECORDER_RECORD_PRESSURE:
+            Replay_getVarint(&c);
+            break;
+         case RECORDER_RECORD_TRIGGER: {
+            uint64_t len = Replay_getVarint(&c);
+            if (!c.ok || len > (uint64_t)(c.end - c.p))
+               return false;
+            c.p += len;
+            break;
+         }
+         default:
+            return false;
+      }
+   }
+
+   return false;
+}
+
+/*
+ * Applies the frame at offset to the state, after clearing it for a key
+ * frame. A frame that fails its checksum, as when it was overwritten while
+ * being read, or does not check out is skipped, and so are the delta
+ * frames up to the next key frame, which build on it; the state of the
+ * last good frame stays shown.
+ */
+static bool Replay_decode(ReplayState* this, uint64_t offset) {
+   uint32_t length, kind;
+   if (!Replay_frameHeader(this, offset, &length, &kind))
+      return false;
+
+   this->offset = offset;
+
+   const uint8_t* frame = this->ring + offset;
+   uint32_t checksum;
+   memcpy(&checksum, frame + offsetof(RecorderFrameHeader, checksum), sizeof(checksum));
+
+   const bool key = kind == RECORDER_FRAME_KEY;
+   ReplayCursor c = { .p = frame + sizeof(RecorderFrameHeader), .end = frame + length, .ok = true };
+
+   if ((!key && (kind != RECORDER_FRAME_DELTA || this->damaged)) ||
+       checksum != Recorder_checksum(c.p, (size_t)(c.end - c.p)) ||
+       !Replay_check(this, c, key)) {
+      this->damaged = true;
+      return false;
+   }
+   this->damaged = false;
+
+   if (key)
+      Replay_reset(this);
+
+   this->realtimeMs = Replay_getVarint(&c);
+   this->pressure = 0;
+   this->trigger[0] = '\0';
+
+   uint64_t fields = Replay_getVarint(&c);
+   for (uint64_t i = 0; i < fields && c.ok; i++) {
+      int64_t d = Replay_getDelta(&c);
+      if (i < RECORDER_MACHINE_FIELDS)
+         this->machine[i] = (int64_t)((uint64_t)this->machine[i] + (uint64_t)d);
+   }
+
+   while (c.ok) {
+      uint64_t record = Replay_getVarint(&c);
+      if (!c.ok || record == RECORDER_RECORD_END)
+         break;
+
+      switch (record) {
+         case RECORDER_RECORD_STRING: {
+            ht_key_t id = (ht_key_t)Replay_getVarint(&c);
+            uint64_t len = Replay_getVarint(&c);
+            if (!c.ok || len > (uint64_t)(c.end - c.p)) {
+               c.ok = false;
+               break;
+            }
+            Hashtable_put(this->strings, id, xStrndup((const char*)c.p, (size_t)len));
+            c.p += len;
+            break;
+         }
+         case RECORDER_RECORD_PROCESS: {
+            pid_t pid = (pid_t)Replay_getVarint(&c);
+            uint64_t mask = Replay_getVarint(&c);
+            ReplayProcess* proc = Hashtable_get(this->processes, (ht_key_t)pid);
+            if (!proc) {
+               proc = xCalloc(1, sizeof(ReplayProcess));
+               proc->pid = pid;
+               Hashtable_put(this->processes, (ht_key_t)pid, proc);
+            }
+            for (int i = 0; i < RECORDER_PROCESS_FIELDS; i++) {
+               if (mask & (1U << i))
+                  proc->values[i] = (int64_t)((uint64_t)proc->values[i] + (uint64_t)Replay_getDelta(&c));
+            }
+            break;
+         }
+         case RECORDER_RECORD_EXIT:
+            free(Hashtable_remove(this->processes, (ht_key_t)Replay_getVarint(&c)));
+            break;
+         case RECORDER_RECORD_PRESSURE:
+            this->pressure = (unsigned int)Replay_getVarint(&c);
+            break;
+         case RECORDER_RECORD_TRIGGER: {
+            uint64_t len = Replay_getVarint(&c);
+            if (!c.ok || len > (uint64_t)(c.end - c.p)) {
+               c.ok = false;
+               break;
+            }
+            String_safeStrncpy(this->trigger, (const char*)c.p, MINIMUM((size_t)len + 1, sizeof(this->trigger)));
+            c.p += len;
+            break;
+         }
+         default:
+            c.ok = false;
+            break;
+      }
+   }
+
+   return c.ok;
+}
+
+/* Offset of the frame after the one at offset, false at the end of the recording */
+static bool Replay_next(const ReplayState* this, uint64_t offset, uint64_t* next) {
+   uint32_t length, kind;
+   if (!Replay_frameHeader(this, offset, &length, &kind))
+      return false;
+
+   /* the space at the head is not written yet, so it is not a wrap marker */
+   if (offset + length == this->header->head)
+      return false;
+
+   *next = Recorder_frameAt(this->header, this->ring, offset + length);
+   return *next != this->header->head;
+}
+
+static bool Replay_isKeyFrame(const ReplayState* this, uint64_t offset) {
+   uint32_t length, kind;
+   return Replay_frameHeader(this, offset, &length, &kind) && kind == RECORDER_FRAME_KEY;
+}
+
+/* Shows frame n after key frame k, only decoding from that key frame */
+static void Replay_seek(ReplayState* this, size_t key, size_t frame) {
+   const RecorderHeader* header = this->header;
+
+   key = MINIMUM(key, (size_t)header->indexCount - 1);
+   uint64_t offset = Recorder_indexEntry(header, (uint32_t)key)->offset;
+   Replay_decode(this, offset);
+
+   size_t n = 0;
+   uint64_t next;
+   bool more = Replay_next(this, offset, &next);
+   while (n < frame && more && !Replay_isKeyFrame(this, next)) {
+      Replay_decode(this, next);
+      n++;
+      more = Replay_next(this, next, &next);
+   }
+
+   this->key = key;
+   this->frame = n;
+   this->atEnd = !more;
+   this->pending = true;
+}
+
+bool Replay_open(const char* path) {
+   ReplayState* this = &Replay_state;
+
+   this->fd = open(path, O_RDONLY | O_CLOEXEC);
+   if (this->fd < 0) {
+      fprintf(stderr, "Error: can not open %s: %s\n", path, strerror(errno));
+      return false;
+   }
+
+   struct stat st;
+   const RecorderHeader* header = NULL;
+   if (fstat(this->fd, &st) == 0 && (size_t)st.st_size >= sizeof(RecorderHeader)) {
+      void* addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+      if (addr != MAP_FAILED) {
+         this->mapped = (size_t)st.st_size;
+         header = addr;
+      }
+   }
+
+   if (!header ||
+       memcmp(header->magic, RECORDER_MAGIC, sizeof(header->magic)) != 0 ||
+       header->version != RECORDER_VERSION ||
+       header->indexCapacity == 0 ||
+       sizeof(RecorderHeader) + header->indexCapacity * sizeof(RecorderIndexEntry) > header->headerSize ||
+       (uint64_t)header->headerSize + header->ringSize > this->mapped) {
+      fprintf(stderr, "Error: %s is not a recording of this version of htop --record.\n", path);
+      this->header = header;
+      Replay_close();
+      return false;
+   }
+
+   this->header = header;
+   this->ring = (const uint8_t*)header + header->headerSize;
+
+   if (header->indexCount == 0 || header->indexCount > header->indexCapacity) {
+      fprintf(stderr, "Error: %s holds no complete frames yet.\n", path);
+      Replay_close();
+      return false;
+   }
+
+   this->processes = Hashtable_new(512, true);
+   this->strings = Hashtable_new(512, true);
+   this->framePids = Hashtable_new(512, false);
+   this->frameStrings = Hashtable_new(512, false);
+
+   Replay_seek(this, 0, 0);
+   return true;
+}
+
+void Replay_close(void) {
+   ReplayState* this = &Replay_state;
+
+   if (this->header)
+      munmap((void*)(uintptr_t)this->header, this->mapped);
+   if (this->fd >= 0)
+      close(this->fd);
+   if (this->processes)
+      Hashtable_delete(this->processes);
+   if (this->strings)
+      Hashtable_delete(this->strings);
+   if (this->framePids)
+      Hashtable_delete(this->framePids);
+   if (this->frameStrings)
+      Hashtable_delete(this->frameStrings);
+
+   *this = (ReplayState) { .fd = -1 };
+}
+
+bool Replay_isOpen(void) {
+   return Replay_state.header != NULL;
+}
+
+bool Replay_advance(void) {
+   ReplayState* this = &Replay_state;
+
+   if (this->pending) {
+      this->pending = false;
+      return !this->atEnd;
+   }
+
+   if (this->atEnd)
+      return false;
+
+   Replay_step(1);
+   this->pending = false;
+   return !this->atEnd;
+}
+
+bool Replay_atEnd(void) {
+   return Replay_state.atEnd;
+}
+
+void Replay_step(int frames) {
+   ReplayState* this = &Replay_state;
+
+   for (; frames > 0; frames--) {
+      uint64_t next;
+      if (!Replay_next(this, this->offset, &next)) {
+         this->atEnd = true;
+         break;
+      }
+
+      bool key = Replay_isKeyFrame(this, next);
+      Replay_decode(this, next);
+      if (key) {
+         this->key = MINIMUM(this->key + 1, (size_t)this->header->indexCount - 1);
+         this->frame = 0;
+      } else {
+         this->frame++;
+      }
+      this->atEnd = !Replay_next(this, next, &next);
+   }
+
+   if (frames < 0) {
+      size_t back = (size_t)-(int64_t)frames;
+      size_t key = this->key;
+      size_t frame = this->frame;
+
+      while (back > frame && key > 0) {
+         /* to the last frame of the epoch before */
+         back -= frame + 1;
+         key--;
+         Replay_seek(this, key, REPLAY_LAST_FRAME);
+         frame = this->frame;
+      }
+      Replay_seek(this, key, back > frame ? 0 : frame - back);
+   }
+
+   this->pending = true;
+}
+
+void Replay_jump(size_t key) {
+   Replay_seek(&Replay_state, key, 0);
+}
+
+size_t Replay_keyCount(void) {
+   return Replay_state.header ? Replay_state.header->indexCount : 0;
+}
+
+uint64_t Replay_keyTime(size_t key) {
+   return Recorder_indexEntry(Replay_state.header, (uint32_t)key)->realtimeMs;
+}
+
+uint64_t Replay_time(void) {
+   return Replay_state.realtimeMs;
+}
+
+int64_t Replay_machineValue(RecorderMachineField field) {
+   return Replay_state.machine[field];
+}
+
+typedef struct ReplayForeachData_ {
+   Replay_ProcessFunction f;
+   void* data;
+} ReplayForeachData;
+
+static void Replay_foreachHelper(ATTR_UNUSED ht_key_t key, void* value, void* data) {
+   const ReplayForeachData* fd = data;
+   const ReplayProcess* proc = value;
+
+   const char* comm = Hashtable_get(Replay_state.strings, (ht_key_t)proc->values[RECORDER_PROCESS_COMM]);
+   const char* cmdline = Hashtable_get(Replay_state.strings, (ht_key_t)proc->values[RECORDER_PROCESS_CMDLINE]);
+   fd->f(proc, comm, cmdline, fd->data);
+}
+
+void Replay_foreachProcess(Replay_ProcessFunction f, void* data) {
+   ReplayForeachData fd = { .f = f, .data = data };
+   Hashtable_foreach(Replay_state.processes, Replay_foreachHelper, &fd);
+}
+
+void Replay_describe(char* buffer, size_t size) {
+   const ReplayState* this = &Replay_state;
+
+   char when[32] = "";
+   time_t t = (time_t)(this->realtimeMs / 1000);
+   struct tm tm;
+   if (localtime_r(&t, &tm)) {
+      size_t len = strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &tm);
+      /* the frames of a trigger's burst are apart by a tenth of a second */
+      xSnprintf(when + len, sizeof(when) - len, ".%u", (unsigned int)(this->realtimeMs % 1000 / 100));
+   }
+
+   /* the frame scanned at once for a pressure trigger */
+   char pressure[32] = "";
+   if (this->pressure) {
+      xSnprintf(pressure, sizeof(pressure), " [pressure:%s%s%s]",
+                (this->pressure & (1U << MACHINE_PRESSURE_CPU)) ? " cpu" : "",
+                (this->pressure & (1U << MACHINE_PRESSURE_MEMORY)) ? " memory" : "",
+                (this->pressure & (1U << MACHINE_PRESSURE_IO)) ? " io" : "");
+   }
+
+   char trigger[80] = "";
+   if (this->trigger[0])
+      xSnprintf(trigger, sizeof(trigger), " [trigger: %s]", this->trigger);
+
+   xSnprintf(buffer, size, "REPLAY %s%s%s%s%s", when, pressure, trigger, this->damaged ? " (damaged frames skipped)" : "", this->atEnd ? " (end)" : "");
+}
@@ -0,0 +1,61 @@
+#ifndef HEADER_Replay
+#define HEADER_Replay
+/*
+htop - Replay.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "Recorder.h"
+
+
+/* One process of the frame shown, with the fields of RecorderProcessField */
+typedef struct ReplayProcess_ {
+   pid_t pid;
+   int64_t values[RECORDER_PROCESS_FIELDS];
+} ReplayProcess;
+
+typedef void (*Replay_ProcessFunction)(const ReplayProcess* proc, const char* comm, const char* cmdline, void* data);
+
+/* Maps a recording of `htop --record`; false with a message on stderr if it is not one */
+bool Replay_open(const char* path);
+
+void Replay_close(void);
+
+bool Replay_isOpen(void);
+
+/* Moves on to the next frame for the next scan, unless a step or jump is pending; false at the end of the recording */
+bool Replay_advance(void);
+
+/* Whether the frame shown is the last one recorded so far */
+bool Replay_atEnd(void);
+
+/* Steps the given number of frames back or forth, shown at the next scan */
+void Replay_step(int frames);
+
+/* Goes to key frame `key`, only decoding that frame */
+void Replay_jump(size_t key);
+
+/* Key frames, oldest first, to jump to */
+size_t Replay_keyCount(void);
+
+uint64_t Replay_keyTime(size_t key);
+
+/* Time of the frame shown, in milliseconds since the epoch */
+uint64_t Replay_time(void);
+
+/* Counter of RecorderMachineField in the frame shown */
+int64_t Replay_machineValue(RecorderMachineField field);
+
+void Replay_foreachProcess(Replay_ProcessFunction f, void* data);
+
+/* Position in the recording for the function bar */
+void Replay_describe(char* buffer, size_t size);
+
+#endif
@@ -10,6 +10,7 @@ in the source distribution for its full text.
 #include "RichString.h"
 
 #include <ctype.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -19,6 +20,8 @@ in the source distribution for its full text.
 
 #define charBytes(n) (sizeof(CharType) * (n))
 
+bool RichString_rawBytes = false;
+
 static void RichString_extendLen(RichString* this, int len) {
    if (this->chlen <= RICHSTRING_MAXLEN) {
       if (len > RICHSTRING_MAXLEN) {
@@ -54,7 +57,60 @@ void RichString_rewind(RichString* this, int count) {
 
 #ifdef HAVE_LIBNCURSESW
 
+/* Length of the text up to its terminator or `len`, if all of it is ASCII; -1 otherwise */
+static int RichString_asciiLength(const char* data, int len) {
+   const size_t n = strnlen(data, len);
+   const uint64_t highBits = UINT64_C(0x8080808080808080);
+
+   size_t i = 0;
+   uint64_t seen = 0;
+   for (; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, data + i, sizeof(word));
+      seen |= word;
+   }
+   for (; i < n; i++)
+      seen |= (unsigned char)data[i];
+
+   return (seen & highBits) ? -1 : (int)n;
+}
+
+/* Each ASCII byte is one cell of one column; control characters show as the replacement character */
+static inline void RichString_writeAsciiCells(RichString* this, int attrs, const char* data, int from, int len) {
+   for (int i = from, j = 0; j < len; i++, j++) {
+      const unsigned char c = (unsigned char)data[j];
+      this->chptr[i] = (CharType) { .attr = attrs & 0xffffff, .chars = { (c >= 0x20 && c < 0x7f) ? (wchar_t)c : L'\xFFFD' } };
+   }
+}
+
+/* The bytes up to the terminator or `len` as RichString_rawBytes keeps them, one cell each */
+static inline int RichString_writeRawCells(RichString* this, int attrs, const char* data, int from, int len) {
+   const int n = (int)strnlen(data, len);
+   if (n == 0)
+      return 0;
+
+   RichString_setLen(this, from + n);
+   for (int i = from, j = 0; j < n; i++, j++) {
+      const unsigned char c = (unsigned char)data[j];
+      this->chptr[i] = (CharType) { .attr = attrs & 0xffffff, .chars = { c < 0x80 ? (wchar_t)c : RICHSTRING_RAW_BYTE(c) } };
+   }
+   return n;
+}
+
 static inline int RichString_writeFromWide(RichString* this, int attrs, const char* data_c, int from, int len) {
+   if (RichString_rawBytes)
+      return RichString_writeRawCells(this, attrs, data_c, from, len);
+
+   const int asciiLen = RichString_asciiLength(data_c, len);
+   if (asciiLen >= 0) {
+      if (asciiLen == 0)
+         return 0;
+
+      RichString_setLen(this, from + asciiLen);
+      RichString_writeAsciiCells(this, attrs, data_c, from, asciiLen);
+      return asciiLen;
+   }
+
    wchar_t data[len + 1];
    len = mbstowcs(data, data_c, len);
    if (len <= 0)
@@ -70,6 +126,23 @@ static inline int RichString_writeFromWide(RichString* this, int attrs, const ch
 }
 
 int RichString_appendnWideColumns(RichString* this, int attrs, const char* data_c, int len, int* columns) {
+   if (RichString_rawBytes) {
+      *columns = RichString_writeRawCells(this, attrs, data_c, this->chlen, MINIMUM(len, MAXIMUM(*columns, 0)));
+      return *columns;
+   }
+
+   const int asciiLen = RichString_asciiLength(data_c, len);
+   if (asciiLen >= 0) {
+      const int fit = MINIMUM(asciiLen, MAXIMUM(*columns, 0));
+      if (fit > 0) {
+         const int from = this->chlen;
+         RichString_setLen(this, from + fit);
+         RichString_writeAsciiCells(this, attrs, data_c, from, fit);
+      }
+      *columns = fit;
+      return fit;
+   }
+
    wchar_t data[len + 1];
    len = mbstowcs(data, data_c, len);
    if (len <= 0)
@@ -142,7 +215,7 @@ static inline int RichString_writeFromWide(RichString* this, int attrs, const ch
    int newLen = from + len;
    RichString_setLen(this, newLen);
    for (int i = from, j = 0; i < newLen; i++, j++) {
-      this->chptr[i] = (((unsigned char)data_c[j]) >= 32 ? ((unsigned char)data_c[j]) : '?') | attrs;
+      this->chptr[i] = ((((unsigned char)data_c[j]) >= 32 || RichString_rawBytes) ? ((unsigned char)data_c[j]) : '?') | attrs;
    }
    this->chptr[newLen] = 0;
 
@@ -221,3 +294,9 @@ int RichString_appendnAscii(RichString* this, int attrs, const char* data, int l
 int RichString_writeAscii(RichString* this, int attrs, const char* data) {
    return RichString_writeFromAscii(this, attrs, data, 0, strlen(data));
 }
+
+void RichString_appendCells(RichString* this, const CharType* cells, int len) {
+   int from = this->chlen;
+   RichString_setLen(this, from + len);
+   memcpy(this->chptr + from, cells, charBytes(len));
+}
@@ -7,6 +7,8 @@ Released under the GNU GPLv2+, see the COPYING file
 in the source distribution for its full text.
 */
 
+#include <stdbool.h>
+
 #include "ProvideCurses.h"
 
 
@@ -38,6 +40,20 @@ in the source distribution for its full text.
 
 #define RICHSTRING_MAXLEN 350
 
+/*
+ * While set, text is kept byte for byte instead of being decoded per the
+ * locale, for --batch to write fields as they are: ASCII bytes, control
+ * characters included, are cells of their own value, other bytes are the
+ * cells RICHSTRING_RAW_BYTE of them.
+ */
+extern bool RichString_rawBytes;
+
+#ifdef HAVE_LIBNCURSESW
+/* Lone low surrogates never come out of decoding, so they can not be mistaken for text */
+#define RICHSTRING_RAW_BYTE(b) ((wchar_t)(0xDC00 + (unsigned char)(b)))
+#define RichString_isRawByte(wc) ((wc) >= RICHSTRING_RAW_BYTE(0x80) && (wc) <= RICHSTRING_RAW_BYTE(0xFF))
+#endif
+
 typedef struct RichString_ {
    int chlen;
    CharType* chptr;
@@ -74,4 +90,7 @@ int RichString_appendnAscii(RichString* this, int attrs, const char* data, int l
 
 int RichString_writeAscii(RichString* this, int attrs, const char* data);
 
+/* Appends cells copied from another RichString, used to replay rendered lines */
+void RichString_appendCells(RichString* this, const CharType* cells, int len);
+
 #endif
@@ -8,6 +8,8 @@ in the source distribution for its full text.
 
 #include "config.h" // IWYU pragma: keep
 
+#define HEAP_CLASS HEAP_PROCESSES
+
 #include "Row.h"
 
 #include <assert.h>
@@ -23,6 +25,7 @@ in the source distribution for its full text.
 #include "Hashtable.h"
 #include "Machine.h"
 #include "Macros.h"
+#include "Panel.h"
 #include "Process.h"
 #include "RichString.h"
 #include "Settings.h"
@@ -31,19 +34,26 @@ in the source distribution for its full text.
 
 int Row_pidDigits = ROW_MIN_PID_DIGITS;
 int Row_uidDigits = ROW_MIN_UID_DIGITS;
+bool Row_plainNumbers = false;
 
 void Row_init(Row* this, const Machine* host) {
    this->host = host;
    this->tag = false;
    this->showChildren = true;
    this->show = true;
-   this->wasShown = false;
-   this->updated = false;
+   this->updatedGeneration = 0;
+   this->panelBuild = 0;
+   this->displayCache = xCalloc(1, sizeof(RowDisplayCache));
 }
 
 void Row_done(Row* this) {
    assert(this != NULL);
-   (void) this;
+
+   if (this->displayCache) {
+      free(this->displayCache->cells);
+      free(this->displayCache);
+      this->displayCache = NULL;
+   }
 }
 
 static inline bool Row_isNew(const Row* this) {
@@ -62,10 +72,24 @@ static inline bool Row_isTomb(const Row* this) {
 void Row_display(const Object* cast, RichString* out) {
    const Row* this = (const Row*) cast;
    const Settings* settings = this->host->settings;
-   const RowField* fields = settings->ss->fields;
 
-   for (int i = 0; fields[i]; i++)
-      As_Row(this)->writeField(this, out, fields[i]);
+   /* Anything changing how rows display bumps the change generation of the table */
+   RowDisplayCache* cache = this->displayCache;
+   const Table* table = this->host->activeTable;
+   const int limit = Row_displayLimit(this);
+   if (cache && table && cache->generation == table->changeGeneration && cache->layout == settings->ss && cache->limit >= limit) {
+      RichString_appendCells(out, cache->cells, cache->len);
+      out->highlightAttr = cache->highlightAttr;
+      return;
+   }
+
+   int start = RichString_size(out);
+
+   int count;
+   const ScreenColumn* columns = ScreenSettings_getColumns(settings->ss, settings->dynamicColumns, &count);
+   const Row_WriteField writeField = As_Row(this)->writeField;
+   for (int i = 0; i < count; i++)
+      writeField(this, out, columns[i].field);
 
    if (Row_isHighlighted(this))
       RichString_setAttr(out, CRT_colors[PROCESS_SHADOW]);
@@ -81,6 +105,29 @@ void Row_display(const Object* cast, RichString* out) {
    }
 
    assert(RichString_size(out) > 0);
+
+   if (cache && table) {
+      int len = RichString_size(out) - start;
+      if (len > cache->size) {
+         cache->size = len;
+         cache->cells = xReallocArray(cache->cells, len, sizeof(CharType));
+      }
+      memcpy(cache->cells, out->chptr + start, len * sizeof(CharType));
+      cache->len = len;
+      cache->highlightAttr = out->highlightAttr;
+      cache->generation = table->changeGeneration;
+      cache->layout = settings->ss;
+      cache->limit = limit;
+   }
+}
+
+int Row_displayLimit(const Row* this) {
+   const Table* table = this->host->activeTable;
+   Panel* panel = table ? table->panel : NULL;
+   if (!panel || Panel_getSelected(panel) == (const Object*) this)
+      return INT_MAX;
+
+   return panel->scrollH + panel->w;
 }
 
 void Row_setPidColumnWidth(pid_t maxPid) {
@@ -124,8 +171,7 @@ void Row_updateFieldWidth(RowField key, size_t width) {
 }
 
 // helper function to fill an aligned title string for a dynamic column
-static const char* alignedTitleDynamicColumn(const Settings* settings, int key, char* titleBuffer, size_t titleBufferSize) {
-   const DynamicColumn* column = Hashtable_get(settings->dynamicColumns, key);
+static const char* alignedTitleDynamicColumn(const DynamicColumn* column, char* titleBuffer, size_t titleBufferSize) {
    if (column == NULL)
       return "- ";
 
@@ -166,34 +212,61 @@ static const char* alignedTitleProcessField(ProcessField field, char* titleBuffe
 
 // helper function to create an aligned title string for a given field
 const char* RowField_alignedTitle(const Settings* settings, RowField field) {
+   const ScreenColumn column = {
+      .field = field,
+      .dynamic = field >= LAST_PROCESSFIELD ? Hashtable_get(settings->dynamicColumns, field) : NULL,
+   };
+   return RowField_columnTitle(&column);
+}
+
+const char* RowField_columnTitle(const ScreenColumn* column) {
    static char titleBuffer[UINT8_MAX + sizeof(" ")];
    assert(sizeof(titleBuffer) >= DYNAMIC_MAX_COLUMN_WIDTH + sizeof(" "));
    assert(sizeof(titleBuffer) >= ROW_MAX_PID_DIGITS + sizeof(" "));
    assert(sizeof(titleBuffer) >= ROW_MAX_UID_DIGITS + sizeof(" "));
 
-   if (field < LAST_PROCESSFIELD)
-      return alignedTitleProcessField((ProcessField)field, titleBuffer, sizeof(titleBuffer));
-   return alignedTitleDynamicColumn(settings, field, titleBuffer, sizeof(titleBuffer));
+   if (column->field < LAST_PROCESSFIELD)
+      return alignedTitleProcessField((ProcessField)column->field, titleBuffer, sizeof(titleBuffer));
+   return alignedTitleDynamicColumn(column->dynamic, titleBuffer, sizeof(titleBuffer));
 }
 
 RowField RowField_keyAt(const Settings* settings, int at) {
-   const RowField* fields = (const RowField*) settings->ss->fields;
-   RowField field;
+   int count;
+   const ScreenColumn* columns = ScreenSettings_getColumns(settings->ss, settings->dynamicColumns, &count);
    int x = 0;
-   for (int i = 0; (field = fields[i]); i++) {
-      int len = strlen(RowField_alignedTitle(settings, field));
+   for (int i = 0; i < count; i++) {
+      int len = strlen(RowField_columnTitle(&columns[i]));
       if (at >= x && at <= x + len) {
-         return field;
+         return columns[i].field;
       }
       x += len;
    }
    return COMM;
 }
 
-void Row_printBytes(RichString* str, unsigned long long number, bool coloring) {
-   char buffer[16];
-   int len;
+/* Appends `value` like "%*llu" (or "%0*llu" with a '0' pad) followed by `suffix` */
+static void Row_appendUnsigned(RichString* str, int attr, unsigned long long value, int width, char pad, const char* suffix) {
+   char buffer[40];
+   int len = String_formatUnsigned(buffer, sizeof(buffer) - 8, value, width, pad);
+   len += (int)String_safeStrncpy(buffer + len, suffix, sizeof(buffer) - len);
+   RichString_appendnAscii(str, attr, buffer, len);
+}
 
+/* Appends `value` like "%*.*f" followed by `suffix` */
+static void Row_appendDouble(RichString* str, int attr, double value, int decimals, int width, const char* suffix) {
+   char buffer[64];
+   int len = String_formatDouble(buffer, sizeof(buffer) - 8, value, decimals, width);
+   len += (int)String_safeStrncpy(buffer + len, suffix, sizeof(buffer) - len);
+   RichString_appendnAscii(str, attr, buffer, len);
+}
+
+/* Appends ".D" for the single fraction digit `digit` */
+static void Row_appendTenths(RichString* str, int attr, unsigned long long digit) {
+   const char tenths[2] = { '.', (char)('0' + digit % 10) };
+   RichString_appendnAscii(str, attr, tenths, 2);
+}
+
+void Row_printBytes(RichString* str, unsigned long long number, bool coloring) {
    int largeNumberColor = coloring ? CRT_colors[LARGE_NUMBER] : CRT_colors[PROCESS];
    int megabytesColor = coloring ? CRT_colors[PROCESS_MEGABYTES] : CRT_colors[PROCESS];
    int gigabytesColor = coloring ? CRT_colors[PROCESS_GIGABYTES] : CRT_colors[PROCESS];
@@ -206,70 +279,60 @@ void Row_printBytes(RichString* str, unsigned long long number, bool coloring) {
       return;
    }
 
+   if (Row_plainNumbers) {
+      Row_appendUnsigned(str, baseColor, number, 0, ' ', " ");
+      return;
+   }
+
    number /= ONE_K;
 
    if (number < 1000) {
       //Plain number, no markings
-      len = xSnprintf(buffer, sizeof(buffer), "%5llu ", number);
-      RichString_appendnAscii(str, baseColor, buffer, len);
+      Row_appendUnsigned(str, baseColor, number, 5, ' ', " ");
    } else if (number < 100000) {
       //2 digit MB, 3 digit KB
-      len = xSnprintf(buffer, sizeof(buffer), "%2llu", number / 1000);
-      RichString_appendnAscii(str, megabytesColor, buffer, len);
+      Row_appendUnsigned(str, megabytesColor, number / 1000, 2, ' ', "");
       number %= 1000;
-      len = xSnprintf(buffer, sizeof(buffer), "%03llu ", number);
-      RichString_appendnAscii(str, baseColor, buffer, len);
+      Row_appendUnsigned(str, baseColor, number, 3, '0', " ");
    } else if (number < 1000 * ONE_K) {
       //3 digit MB
       number /= ONE_K;
-      len = xSnprintf(buffer, sizeof(buffer), "%4lluM ", number);
-      RichString_appendnAscii(str, megabytesColor, buffer, len);
+      Row_appendUnsigned(str, megabytesColor, number, 4, ' ', "M ");
    } else if (number < 10000 * ONE_K) {
       //1 digit GB, 3 digit MB
       number /= ONE_K;
-      len = xSnprintf(buffer, sizeof(buffer), "%1llu", number / 1000);
-      RichString_appendnAscii(str, gigabytesColor, buffer, len);
+      Row_appendUnsigned(str, gigabytesColor, number / 1000, 1, ' ', "");
       number %= 1000;
-      len = xSnprintf(buffer, sizeof(buffer), "%03lluM ", number);
-      RichString_appendnAscii(str, megabytesColor, buffer, len);
+      Row_appendUnsigned(str, megabytesColor, number, 3, '0', "M ");
    } else if (number < 100 * ONE_M) {
       //2 digit GB, 1 digit MB
-      len = xSnprintf(buffer, sizeof(buffer), "%2llu", number / ONE_M);
-      RichString_appendnAscii(str, gigabytesColor, buffer, len);
+      Row_appendUnsigned(str, gigabytesColor, number / ONE_M, 2, ' ', "");
       number = (number % ONE_M) * 10 / ONE_M;
-      len = xSnprintf(buffer, sizeof(buffer), ".%1llu", number);
-      RichString_appendnAscii(str, megabytesColor, buffer, len);
+      Row_appendTenths(str, megabytesColor, number);
       RichString_appendAscii(str, gigabytesColor, "G ");
    } else if (number < 1000 * ONE_M) {
       //3 digit GB
       number /= ONE_M;
-      len = xSnprintf(buffer, sizeof(buffer), "%4lluG ", number);
-      RichString_appendnAscii(str, gigabytesColor, buffer, len);
+      Row_appendUnsigned(str, gigabytesColor, number, 4, ' ', "G ");
    } else if (number < 10000ULL * ONE_M) {
       //1 digit TB, 3 digit GB
       number /= ONE_M;
-      len = xSnprintf(buffer, sizeof(buffer), "%1llu", number / 1000);
-      RichString_appendnAscii(str, largeNumberColor, buffer, len);
+      Row_appendUnsigned(str, largeNumberColor, number / 1000, 1, ' ', "");
       number %= 1000;
-      len = xSnprintf(buffer, sizeof(buffer), "%03lluG ", number);
-      RichString_appendnAscii(str, gigabytesColor, buffer, len);
+      Row_appendUnsigned(str, gigabytesColor, number, 3, '0', "G ");
    } else if (number < 100ULL * ONE_G) {
       //2 digit TB, 1 digit GB
-      len = xSnprintf(buffer, sizeof(buffer), "%2llu", number / ONE_G);
-      RichString_appendnAscii(str, largeNumberColor, buffer, len);
+      Row_appendUnsigned(str, largeNumberColor, number / ONE_G, 2, ' ', "");
       number = (number % ONE_G) * 10 / ONE_G;
-      len = xSnprintf(buffer, sizeof(buffer), ".%1llu", number);
-      RichString_appendnAscii(str, gigabytesColor, buffer, len);
+      Row_appendTenths(str, gigabytesColor, number);
       RichString_appendAscii(str, largeNumberColor, "T ");
    } else if (number < 10000ULL * ONE_G) {
       //3 digit TB or 1 digit PB, 3 digit TB
       number /= ONE_G;
-      len = xSnprintf(buffer, sizeof(buffer), "%4lluT ", number);
-      RichString_appendnAscii(str, largeNumberColor, buffer, len);
+      Row_appendUnsigned(str, largeNumberColor, number, 4, ' ', "T ");
    } else {
       //2 digit PB and above
-      len = xSnprintf(buffer, sizeof(buffer), "%4.1lfP ", (double)number / ONE_T);
-      RichString_appendnAscii(str, largeNumberColor, buffer, len);
+      Row_appendDouble(str, largeNumberColor, (double)number / ONE_T, 1, 4, "P ");
    }
 }
 
@@ -281,7 +344,7 @@ void Row_printKBytes(RichString* str, unsigned long long number, bool coloring)
 }
 
 void Row_printCount(RichString* str, unsigned long long number, bool coloring) {
-   char buffer[13];
+   char buffer[24];
 
    int largeNumberColor = coloring ? CRT_colors[LARGE_NUMBER] : CRT_colors[PROCESS];
    int megabytesColor = coloring ? CRT_colors[PROCESS_MEGABYTES] : CRT_colors[PROCESS];
@@ -290,20 +353,35 @@ void Row_printCount(RichString* str, unsigned long long number, bool coloring) {
 
    if (number == ULLONG_MAX) {
       RichString_appendAscii(str, CRT_colors[PROCESS_SHADOW], "        N/A ");
-   } else if (number >= 100000LL * ONE_DECIMAL_T) {
-      xSnprintf(buffer, sizeof(buffer), "%11llu ", number / ONE_DECIMAL_G);
+      return;
+   }
+   if (Row_plainNumbers) {
+      Row_appendUnsigned(str, baseColor, number, 0, ' ', " ");
+      return;
+   }
+
+   /* the eleven columns are split into colored groups of digits */
+   unsigned long long shown = number;
+   if (number >= 100000LL * ONE_DECIMAL_T)
+      shown = number / ONE_DECIMAL_G;
+   else if (number >= 100LL * ONE_DECIMAL_T)
+      shown = number / ONE_DECIMAL_M;
+   else if (number >= 10LL * ONE_DECIMAL_G)
+      shown = number / ONE_DECIMAL_K;
+
+   int len = String_formatUnsigned(buffer, sizeof(buffer) - 1, shown, 11, ' ');
+   buffer[len++] = ' ';
+
+   if (number >= 100000LL * ONE_DECIMAL_T) {
       RichString_appendnAscii(str, largeNumberColor, buffer, 12);
    } else if (number >= 100LL * ONE_DECIMAL_T) {
-      xSnprintf(buffer, sizeof(buffer), "%11llu ", number / ONE_DECIMAL_M);
       RichString_appendnAscii(str, largeNumberColor, buffer, 8);
       RichString_appendnAscii(str, megabytesColor, buffer + 8, 4);
    } else if (number >= 10LL * ONE_DECIMAL_G) {
-      xSnprintf(buffer, sizeof(buffer), "%11llu ", number / ONE_DECIMAL_K);
       RichString_appendnAscii(str, largeNumberColor, buffer, 5);
       RichString_appendnAscii(str, megabytesColor, buffer + 5, 3);
       RichString_appendnAscii(str, baseColor, buffer + 8, 4);
    } else {
-      xSnprintf(buffer, sizeof(buffer), "%11llu ", number);
       RichString_appendnAscii(str, largeNumberColor, buffer, 2);
       RichString_appendnAscii(str, megabytesColor, buffer + 2, 3);
       RichString_appendnAscii(str, baseColor, buffer + 5, 3);
@@ -312,9 +390,6 @@ void Row_printCount(RichString* str, unsigned long long number, bool coloring) {
 }
 
 void Row_printTime(RichString* str, unsigned long long totalHundredths, bool coloring) {
-   char buffer[10];
-   int len;
-
    int yearColor = coloring ? CRT_colors[LARGE_NUMBER]      : CRT_colors[PROCESS];
    int dayColor  = coloring ? CRT_colors[PROCESS_GIGABYTES] : CRT_colors[PROCESS];
    int hourColor = coloring ? CRT_colors[PROCESS_MEGABYTES] : CRT_colors[PROCESS];
@@ -328,55 +403,50 @@ void Row_printTime(RichString* str, unsigned long long totalHundredths, bool col
 
    if (totalMinutes < 60) {
       unsigned int hundredths = totalHundredths % 100;
-      len = xSnprintf(buffer, sizeof(buffer), "%2llu:%02u.%02u ", totalMinutes, seconds, hundredths);
+      char buffer[16];
+      int len = String_formatUnsigned(buffer, sizeof(buffer), totalMinutes, 2, ' ');
+      buffer[len++] = ':';
+      len += String_formatUnsigned(buffer + len, sizeof(buffer) - len, seconds, 2, '0');
+      buffer[len++] = '.';
+      len += String_formatUnsigned(buffer + len, sizeof(buffer) - len, hundredths, 2, '0');
+      buffer[len++] = ' ';
       RichString_appendnAscii(str, baseColor, buffer, len);
       return;
    }
    if (totalHours < 24) {
-      len = xSnprintf(buffer, sizeof(buffer), "%2lluh", totalHours);
-      RichString_appendnAscii(str, hourColor, buffer, len);
-      len = xSnprintf(buffer, sizeof(buffer), "%02u:%02u ", minutes, seconds);
-      RichString_appendnAscii(str, baseColor, buffer, len);
+      Row_appendUnsigned(str, hourColor, totalHours, 2, ' ', "h");
+      Row_appendUnsigned(str, baseColor, minutes, 2, '0', ":");
+      Row_appendUnsigned(str, baseColor, seconds, 2, '0', " ");
       return;
    }
 
    unsigned long long totalDays = totalHours / 24;
    unsigned int hours = totalHours % 24;
    if (totalDays < 10) {
-      len = xSnprintf(buffer, sizeof(buffer), "%1llud", totalDays);
-      RichString_appendnAscii(str, dayColor, buffer, len);
-      len = xSnprintf(buffer, sizeof(buffer), "%02uh", hours);
-      RichString_appendnAscii(str, hourColor, buffer, len);
-      len = xSnprintf(buffer, sizeof(buffer), "%02um ", minutes);
-      RichString_appendnAscii(str, baseColor, buffer, len);
+      Row_appendUnsigned(str, dayColor, totalDays, 1, ' ', "d");
+      Row_appendUnsigned(str, hourColor, hours, 2, '0', "h");
+      Row_appendUnsigned(str, baseColor, minutes, 2, '0', "m ");
       return;
    }
    if (totalDays < /* Ignore leap years */365) {
-      len = xSnprintf(buffer, sizeof(buffer), "%4llud", totalDays);
-      RichString_appendnAscii(str, dayColor, buffer, len);
-      len = xSnprintf(buffer, sizeof(buffer), "%02uh ", hours);
-      RichString_appendnAscii(str, hourColor, buffer, len);
+      Row_appendUnsigned(str, dayColor, totalDays, 4, ' ', "d");
+      Row_appendUnsigned(str, hourColor, hours, 2, '0', "h ");
       return;
    }
 
    unsigned long long years = totalDays / 365;
    unsigned int days = totalDays % 365;
    if (years < 1000) {
-      len = xSnprintf(buffer, sizeof(buffer), "%3lluy", years);
-      RichString_appendnAscii(str, yearColor, buffer, len);
-      len = xSnprintf(buffer, sizeof(buffer), "%03ud ", days);
-      RichString_appendnAscii(str, dayColor, buffer, len);
+      Row_appendUnsigned(str, yearColor, years, 3, ' ', "y");
+      Row_appendUnsigned(str, dayColor, days, 3, '0', "d ");
    } else if (years < 10000000) {
-      len = xSnprintf(buffer, sizeof(buffer), "%7lluy ", years);
-      RichString_appendnAscii(str, yearColor, buffer, len);
+      Row_appendUnsigned(str, yearColor, years, 7, ' ', "y ");
    } else {
       RichString_appendnAscii(str, yearColor, "eternity ", 9);
    }
 }
 
 void Row_printRate(RichString* str, double rate, bool coloring) {
-   char buffer[16];
-
    int largeNumberColor = CRT_colors[LARGE_NUMBER];
    int megabytesColor = CRT_colors[PROCESS_MEGABYTES];
    int shadowColor = CRT_colors[PROCESS_SHADOW];
@@ -390,27 +460,84 @@ void Row_printRate(RichString* str, double rate, bool coloring) {
    if (!isNonnegative(rate)) {
       RichString_appendAscii(str, shadowColor, "        N/A ");
    } else if (rate < 0.005) {
-      int len = snprintf(buffer, sizeof(buffer), "%7.2f B/s ", rate);
-      RichString_appendnAscii(str, shadowColor, buffer, len);
+      Row_appendDouble(str, shadowColor, rate, 2, 7, " B/s ");
    } else if (rate < ONE_K) {
-      int len = snprintf(buffer, sizeof(buffer), "%7.2f B/s ", rate);
-      RichString_appendnAscii(str, baseColor, buffer, len);
+      Row_appendDouble(str, baseColor, rate, 2, 7, " B/s ");
    } else if (rate < ONE_M) {
-      int len = snprintf(buffer, sizeof(buffer), "%7.2f K/s ", rate / ONE_K);
-      RichString_appendnAscii(str, baseColor, buffer, len);
+      Row_appendDouble(str, baseColor, rate / ONE_K, 2, 7, " K/s ");
    } else if (rate < ONE_G) {
-      int len = snprintf(buffer, sizeof(buffer), "%7.2f M/s ", rate / ONE_M);
-      RichString_appendnAscii(str, megabytesColor, buffer, len);
+      Row_appendDouble(str, megabytesColor, rate / ONE_M, 2, 7, " M/s ");
    } else if (rate < ONE_T) {
-      int len = snprintf(buffer, sizeof(buffer), "%7.2f G/s ", rate / ONE_G);
-      RichString_appendnAscii(str, largeNumberColor, buffer, len);
+      Row_appendDouble(str, largeNumberColor, rate / ONE_G, 2, 7, " G/s ");
    } else if (rate < ONE_P) {
-      int len = snprintf(buffer, sizeof(buffer), "%7.2f T/s ", rate / ONE_T);
-      RichString_appendnAscii(str, largeNumberColor, buffer, len);
+      Row_appendDouble(str, largeNumberColor, rate / ONE_T, 2, 7, " T/s ");
    } else {
-      int len = snprintf(buffer, sizeof(buffer), "%7.2f P/s ", rate / ONE_P);
-      RichString_appendnAscii(str, largeNumberColor, buffer, len);
+      Row_appendDouble(str, largeNumberColor, rate / ONE_P, 2, 7, " P/s ");
+   }
+}
+
+/* Deeper trees only draw the lines of the innermost levels; fits the buffer below */
+#define ROW_TREE_MAX_DRAWN_LEVELS 30
+
+void Row_printTreeBranch(const Row* this, RichString* str) {
+   char buffer[256]; buffer[255] = '\0';
+   size_t n = sizeof(buffer) - 1;
+
+   /* Collapsed rows tell how many rows they hide, roots draw nothing else */
+   const bool collapsed = !this->showChildren && this->treeDescendants > 0;
+   if (this->tree_depth == 0) {
+      if (collapsed) {
+         xSnprintf(buffer, n, "%s%d ", CRT_treeStr[TREE_STR_OPEN], this->treeDescendants);
+         RichString_appendWide(str, CRT_colors[PROCESS_TREE], buffer);
+      }
+      return;
+   }
+
+   // Only the innermost levels of very deep trees are drawn, introduced by the number of omitted ones
+   unsigned int levels = this->tree_depth - 1;
+   unsigned int omitted = 0;
+   if (levels > ROW_TREE_MAX_DRAWN_LEVELS) {
+      omitted = levels - ROW_TREE_MAX_DRAWN_LEVELS;
+      levels = ROW_TREE_MAX_DRAWN_LEVELS;
+   }
+
+   // The ancestors tell whether their branch continues below this row
+   bool vertical[ROW_TREE_MAX_DRAWN_LEVELS];
+   const Row* ancestor = this->treeParent;
+   for (unsigned int i = levels; i-- > 0; ancestor = ancestor ? ancestor->treeParent : NULL)
+      vertical[i] = ancestor && !ancestor->treeLast;
+
+   char* buf = buffer;
+   const bool lastItem = this->treeLast;
+
+   if (omitted) {
+      int ret = xSnprintf(buf, n, "+%u ", omitted);
+      buf += ret;
+      n -= ret;
+   }
+
+   for (unsigned int i = 0; i < levels; i++) {
+      int written, ret;
+      if (vertical[i]) {
+         ret = xSnprintf(buf, n, "%s  ", CRT_treeStr[TREE_STR_VERT]);
+      } else {
+         ret = xSnprintf(buf, n, "   ");
+      }
+      if (ret < 0 || (size_t)ret >= n) {
+         written = n;
+      } else {
+         written = ret;
+      }
+      buf += written;
+      n -= written;
    }
+
+   const char* draw = CRT_treeStr[lastItem ? TREE_STR_BEND : TREE_STR_RTEE];
+   if (collapsed)
+      xSnprintf(buf, n, "%s%s%d ", draw, CRT_treeStr[TREE_STR_OPEN], this->treeDescendants);
+   else
+      xSnprintf(buf, n, "%s%s ", draw, this->showChildren ? CRT_treeStr[TREE_STR_SHUT] : CRT_treeStr[TREE_STR_OPEN] );
+   RichString_appendWide(str, CRT_colors[PROCESS_TREE], buffer);
 }
 
 void Row_printLeftAlignedField(RichString* str, int attr, const char* content, unsigned int width) {
@@ -434,7 +561,10 @@ int Row_printPercentage(float val, char* buffer, size_t n, uint8_t width, int* a
          val = 100.0F;
       }
 
-      return xSnprintf(buffer, n, "%*.*f ", width, precision, val);
+      int len = String_formatDouble(buffer, n - 1, val, precision, width);
+      buffer[len++] = ' ';
+      buffer[len] = '\0';
+      return len;
    }
 
    *attr = CRT_colors[PROCESS_SHADOW];
@@ -452,6 +582,32 @@ int Row_compare(const void* v1, const void* v2) {
    return SPACESHIP_NUMBER(r1->id, r2->id);
 }
 
+uint64_t Row_sortKeyFromDouble(double value) {
+   if (isNaN(value))
+      return 0;
+
+   uint64_t bits;
+   memcpy(&bits, &value, sizeof(bits));
+
+   /* -0.0 */
+   if (bits == (UINT64_C(1) << 63))
+      bits = 0;
+
+   return (bits & (UINT64_C(1) << 63)) ? ~bits : bits | (UINT64_C(1) << 63);
+}
+
+uint64_t Row_sortKeyFromString(const char* str) {
+   uint64_t key = 0;
+
+   for (size_t i = 0; i < sizeof(key); i++) {
+      key <<= 8;
+      if (str && *str)
+         key |= (unsigned char)*str++;
+   }
+
+   return key;
+}
+
 int Row_compareByParent_Base(const void* v1, const void* v2) {
    const Row* r1 = (const Row*)v1;
    const Row* r2 = (const Row*)v2;
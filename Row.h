@@ -26,14 +26,31 @@ extern uint8_t Row_fieldWidths[LAST_RESERVED_FIELD];
 extern int Row_pidDigits;
 extern int Row_uidDigits;
 
+/* Sizes and counts are printed as exact numbers without units, for output read by programs */
+extern bool Row_plainNumbers;
+
 struct Machine_;     // IWYU pragma: keep
+struct ScreenColumn_;    // IWYU pragma: keep
+struct ScreenSettings_;  // IWYU pragma: keep
 struct Settings_;    // IWYU pragma: keep
 struct Table_;       // IWYU pragma: keep
+struct Vector_;      // IWYU pragma: keep
 
 /* Class representing entities (such as processes) that can be
  * represented in a tabular form in the lower half of the htop
  * display. */
 
+/* Last line rendered by Row_display, replayed while it is still valid */
+typedef struct RowDisplayCache_ {
+   CharType* cells;
+   int len;
+   int size;
+   int highlightAttr;
+   unsigned int generation;                  /* change generation of the table, 0 if empty */
+   const struct ScreenSettings_* layout;     /* screen whose columns were rendered */
+   int limit;                                /* Row_displayLimit() the row was rendered with */
+} RowDisplayCache;
+
 typedef struct Row_ {
    /* Super object for emulated OOP */
    Object super;
@@ -54,20 +71,36 @@ typedef struct Row_ {
    /* Whether to display this row */
    bool show;
 
-   /* Whether this row was shown last cycle */
-   bool wasShown;
-
    /* Whether to show children of this row in tree-mode */
    bool showChildren;
 
-   /* Whether the row was updated during the last scan */
-   bool updated;
+   /* Scan generation of the table that last found the row, see Table_markUpdated */
+   unsigned int updatedGeneration;
+
+   /* Panel generation of the table in which this row was inside the visible window */
+   unsigned int panelGeneration;
+
+   /* Position of this row in the panel as of the table's panel build panelBuild */
+   int panelIndex;
+   unsigned int panelBuild;
+
+   /* Allocated in Row_init, filled by Row_display */
+   RowDisplayCache* displayCache;
 
    /*
     * Internal state for tree-mode.
     */
-   int32_t indent;
    unsigned int tree_depth;
+   bool treeLast;                   /* no further siblings are shown below */
+
+   /*
+    * Tree links kept up to date by the table across scans, see Table_buildTree.
+    */
+   struct Row_* treeParent;         /* NULL for roots */
+   struct Vector_* treeChildren;    /* borrowed, allocated with the first child */
+   int treeIndex;                   /* position among the siblings */
+   int treeDescendants;             /* rows below, all of them hidden when collapsed */
+   unsigned int treeMatch;          /* the table's treeMatch while the filter leaves it or a row below it */
 
    /*
     * Internal time counts for showing new and exited processes.
@@ -80,10 +113,23 @@ typedef Row* (*Row_New)(const struct Machine_*);
 typedef void (*Row_WriteField)(const Row*, RichString*, RowField);
 typedef bool (*Row_IsHighlighted)(const Row*);
 typedef bool (*Row_IsVisible)(const Row*, const struct Table_*);
-typedef bool (*Row_MatchesFilter)(const Row*, const struct Table_*);
+typedef bool (*Row_MatchesFilter)(Row*, const struct Table_*);
 typedef const char* (*Row_SortKeyString)(Row*);
 typedef int (*Row_CompareByParent)(const Row*, const Row*);
 
+/* How Row_sortKey encoded the active sort key of a row */
+typedef enum RowSortKeyKind_ {
+   ROW_SORTKEY_NONE,    /* no encoding for this key, sort with the comparator */
+   ROW_SORTKEY_EXACT,   /* rows order by the value, then by ascending id */
+   ROW_SORTKEY_PREFIX,  /* smaller values sort first, equal ones need the comparator */
+} RowSortKeyKind;
+
+/* Encodes the active sort key of a row, including its direction, as an unsigned number */
+typedef RowSortKeyKind (*Row_SortKey)(const Row*, uint64_t*);
+
+/* Encodes a field of a row like Row_SortKey, in ascending order */
+typedef RowSortKeyKind (*Row_SortKeyByField)(const Row*, RowField, uint64_t*);
+
 int Row_compare(const void* v1, const void* v2);
 
 typedef struct RowClass_ {
@@ -94,6 +140,8 @@ typedef struct RowClass_ {
    const Row_MatchesFilter matchesFilter;
    const Row_SortKeyString sortKeyString;
    const Row_CompareByParent compareByParent;
+   const Row_SortKey sortKey;
+   const Row_SortKeyByField sortKeyByField;
 } RowClass;
 
 #define As_Row(this_)  ((const RowClass*)((this_)->super.klass))
@@ -103,6 +151,8 @@ typedef struct RowClass_ {
 #define Row_matchesFilter(r_, t_)  (As_Row(r_)->matchesFilter ? (As_Row(r_)->matchesFilter(r_, t_)) : false)
 #define Row_sortKeyString(r_)  (As_Row(r_)->sortKeyString ? (As_Row(r_)->sortKeyString(r_)) : "")
 #define Row_compareByParent(r1_, r2_)  (As_Row(r1_)->compareByParent ? (As_Row(r1_)->compareByParent(r1_, r2_)) : Row_compareByParent_Base(r1_, r2_))
+#define Row_sortKey(r_, v_)  (As_Row(r_)->sortKey ? (As_Row(r_)->sortKey(r_, v_)) : ROW_SORTKEY_NONE)
+#define Row_sortKeyByField(r_, f_, v_)  (As_Row(r_)->sortKeyByField ? (As_Row(r_)->sortKeyByField(r_, f_, v_)) : ROW_SORTKEY_NONE)
 
 #define ONE_K 1024UL
 #define ONE_M (ONE_K * ONE_K)
@@ -124,6 +174,13 @@ void Row_done(Row* this);
 
 void Row_display(const Object* cast, RichString* out);
 
+/*
+ * Cells of the row up to the right edge of the panel, scrolled or not; long
+ * columns need not be written past it. INT_MAX for the selected row, so it
+ * can be scrolled to its end, and outside of a panel.
+ */
+int Row_displayLimit(const Row* this);
+
 void Row_toggleTag(Row* this);
 
 void Row_resetFieldWidths(void);
@@ -132,8 +189,14 @@ void Row_updateFieldWidth(RowField key, size_t width);
 
 void Row_printLeftAlignedField(RichString* str, int attr, const char* content, unsigned int width);
 
+/* Appends the tree lines leading to a row, and how many rows it hides when collapsed */
+void Row_printTreeBranch(const Row* this, RichString* str);
+
 const char* RowField_alignedTitle(const struct Settings_* settings, RowField field);
 
+/* Like RowField_alignedTitle, with the column metadata already resolved */
+const char* RowField_columnTitle(const struct ScreenColumn_* column);
+
 RowField RowField_keyAt(const struct Settings_* settings, int at);
 
 /* Sets the size of the PID column based on the passed PID */
@@ -178,4 +241,15 @@ static inline bool Row_isChildOf(const Row* this, int id) {
 
 int Row_compareByParent_Base(const void* v1, const void* v2);
 
+/* Order preserving encodings for Row_SortKey implementations */
+static inline uint64_t Row_sortKeyFromSigned(long long int value) {
+   return (uint64_t)value ^ (UINT64_C(1) << 63);
+}
+
+/* Orders like compareRealNumbers: NaN first, -0.0 equal to 0.0 */
+uint64_t Row_sortKeyFromDouble(double value);
+
+/* The first eight bytes in strcmp order, NULL as the empty string */
+uint64_t Row_sortKeyFromString(const char* str);
+
 #endif
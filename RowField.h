@@ -38,6 +38,9 @@ typedef enum ReservedFields_ {
    PERCENT_NORM_CPU = 53,
    ELAPSED = 54,
    SCHEDULERPOLICY = 55,
+   CPU_HISTORY = 56,
+   MEM_HISTORY = 57,
+   MEM_GROWTH = 58,
    PROC_COMM = 124,
    PROC_EXE = 125,
    CWD = 126,
@@ -11,10 +11,14 @@ in the source distribution for its full text.
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <sys/time.h>
 
+#include "Batch.h"
+#include "Budget.h"
 #include "CRT.h"
 #include "FunctionBar.h"
 #include "Machine.h"
@@ -22,6 +26,8 @@ in the source distribution for its full text.
 #include "Object.h"
 #include "Platform.h"
 #include "Process.h"
+#include "ProcessTable.h"
+#include "Profile.h"
 #include "ProvideCurses.h"
 #include "Settings.h"
 #include "Table.h"
@@ -119,33 +125,85 @@ void ScreenManager_resize(ScreenManager* this) {
    Panel_move(panel, lastX, y1_header);
 }
 
-static void checkRecalculation(ScreenManager* this, double* oldTime, int* sortTimeout, bool* redraw, bool* rescan, bool* timedOut, bool* force_redraw) {
-   Machine* host = this->host;
+/* Update interval in tenths of a second, longer while over the CPU budget or the terminal is not focused */
+static int ScreenManager_delay(const ScreenManager* this) {
+   const Settings* settings = this->host->settings;
+   int delay = Budget_delay(settings);
+
+   if (this->state->unfocused && settings->unfocusedDelay)
+      delay = MAXIMUM(delay, settings->unfocusedDelay);
+
+   return Machine_delay(this->host, delay);
+}
 
+/* Wall clock time in tenths of a second, taken for the host as well */
+static double ScreenManager_now(Machine* host) {
    Platform_gettime_realtime(&host->realtime, &host->realtimeMs);
-   double newTime = ((double)host->realtime.tv_sec * 10) + ((double)host->realtime.tv_usec / 100000);
+   return ((double)host->realtime.tv_sec * 10) + ((double)host->realtime.tv_usec / 100000);
+}
+
+static void checkRecalculation(ScreenManager* this, double* oldTime, int* sortTimeout, bool* redraw, bool* rescan, bool* timedOut, bool* prefetching, bool* force_redraw) {
+   Machine* host = this->host;
+
+   double newTime = ScreenManager_now(host);
 
-   *timedOut = (newTime - *oldTime > host->settings->delay);
+   bool requested = *rescan;
+   *timedOut = (newTime - *oldTime > ScreenManager_delay(this));
    *rescan |= *timedOut;
 
    if (newTime < *oldTime) {
       *rescan = true; // clock was adjusted?
    }
 
-   if (*rescan) {
+   // the interval counts from when the background reading was started
+   bool keepTime = false;
+   if (*prefetching) {
+      if (*rescan || Machine_tablesPrefetched(host)) {
+         *prefetching = false;
+         *rescan = true;
+         keepTime = !requested;
+      }
+   } else if (*timedOut && !requested && *oldTime > 0.0 && !this->state->pauseUpdate && Machine_prefetchTables(host)) {
+      // keep handling keys while the next scan is read, merge it once it is complete
       *oldTime = newTime;
+      *prefetching = true;
+      *rescan = false;
+   }
+
+   if (*rescan) {
+      if (!keepTime)
+         *oldTime = newTime;
       int oldUidDigits = Process_uidDigits;
-      if (!this->state->pauseUpdate && (*sortTimeout == 0 || host->settings->ss->treeView)) {
+      // sample current values for system metrics and processes if not paused,
+      // the latter only once their own interval is over unless asked for
+      ProfileMark mark = Profile_begin();
+      Machine_scan(host);
+      Profile_end(PROFILE_MACHINE_SCAN, mark);
+
+      bool scanned = false;
+      if (!this->state->pauseUpdate) {
+         const bool firstScan = !host->activeTable->scanTime;
+         scanned = Machine_scanShownTables(host, !requested);
+         if (scanned && firstScan) {
+            if (host->settings->ss->allBranchesCollapsed)
+               Table_collapseAllBranches(host->activeTable);
+            if (!Profile_stats[PROFILE_FIRST_TABLE].count)
+               Profile_end(PROFILE_FIRST_TABLE, Profile_startup);
+         }
+      }
+      if (scanned && (*sortTimeout == 0 || host->settings->ss->treeView)) {
          host->activeTable->needsSort = true;
          *sortTimeout = 1;
       }
-      // sample current values for system metrics and processes if not paused
-      Machine_scan(host);
-      if (!this->state->pauseUpdate)
-         Machine_scanTables(host);
+
+      // the rows of an export are taken as of this scan, the disk is left to a thread
+      Batch_exportScan(host);
+      if (Batch_exportChanged() && host->activeTable->panel)
+         host->activeTable->panel->needsRedraw = true;
 
       // always update header, especially to avoid gaps in graph meters
       Header_updateData(this->header);
+      Budget_update(host->settings);
       // force redraw if the number of UID digits was changed
       if (Process_uidDigits != oldUidDigits) {
          *force_redraw = true;
@@ -154,8 +212,11 @@ static void checkRecalculation(ScreenManager* this, double* oldTime, int* sortTi
    }
    if (*redraw) {
       Table_rebuildPanel(host->activeTable);
-      if (!this->state->hideMeters)
-         Header_draw(this->header);
+      if (!this->state->hideMeters) {
+         ProfileMark mark = Profile_begin();
+         Header_draw(this->header, *force_redraw);
+         Profile_end(PROFILE_HEADER_DRAW, mark);
+      }
    }
    *rescan = false;
 }
@@ -196,7 +257,20 @@ static void ScreenManager_drawScreenTabs(ScreenManager* this) {
    }
 
    for (int s = 0; screens[s]; s++) {
-      bool ok = drawTab(&y, &x, l, screens[s]->heading, s == cur);
+      const char* name = screens[s]->heading;
+
+      // screens not scanned in the background tell how old their data is
+      char label[256];
+      const Table* table = screens[s]->table;
+      if (table && !Machine_isTableShown(this->host, table) && table->scanTime) {
+         struct tm scanTm;
+         char when[16];
+         strftime(when, sizeof(when), "%H:%M:%S", localtime_r(&table->scanTime, &scanTm));
+         xSnprintf(label, sizeof(label), "%s %s", name, when);
+         name = label;
+      }
+
+      bool ok = drawTab(&y, &x, l, name, s == cur);
       if (!ok) {
          break;
       }
@@ -209,6 +283,7 @@ static void ScreenManager_drawPanels(ScreenManager* this, int focus, bool force_
    if (settings->screenTabs) {
       ScreenManager_drawScreenTabs(this);
    }
+   const ProfileMark mark = Profile_begin();
    const int nPanels = this->panelCount;
    for (int i = 0; i < nPanels; i++) {
       Panel* panel = (Panel*) Vector_get(this->panels, i);
@@ -219,6 +294,78 @@ static void ScreenManager_drawPanels(ScreenManager* this, int focus, bool force_
                  State_hideFunctionBar(this->state));
       mvvline(panel->y, panel->x + panel->w, ' ', panel->h + (State_hideFunctionBar(this->state) ? 1 : 0));
    }
+   Profile_end(PROFILE_PANEL_DRAW, mark);
+}
+
+/* Milliseconds until checkRecalculation() finds the update interval over, to wait for keys no longer than that */
+static int ScreenManager_timeout(const ScreenManager* this, double oldTime) {
+   if (!this->header)
+      return CRT_UPDATE_TIMEOUT;
+
+   struct timeval tv;
+   uint64_t ms;
+   Platform_gettime_realtime(&tv, &ms);
+   double now = ((double)tv.tv_sec * 10) + ((double)tv.tv_usec / 100000);
+
+   /* past the interval by a millisecond, it has to be exceeded */
+   const int delay = ScreenManager_delay(this);
+   double remaining = (oldTime + delay - now) * 100.0;
+   if (remaining < 0.0 || remaining > 100.0 * delay)
+      return 1;
+
+   /* on battery, updates move to whole seconds of the clock, where other programs wake up as well */
+   int timeout = (int)remaining + 1;
+   if (Budget_onBattery)
+      timeout += (int)((1000 - (ms + (uint64_t)timeout) % 1000) % 1000);
+
+   return timeout;
+}
+
+/* Longest a frame is held back while keys are pending, and how long a resize waits for the next one */
+#define SCREENMANAGER_HOLD_MS 50
+#define SCREENMANAGER_RESIZE_SETTLE_MS 30
+
+/*
+ * Whether to read the keys already typed before drawing, so a held key or a
+ * storm of resizes draws only where they end up. A frame is held back for at
+ * most SCREENMANAGER_HOLD_MS, so the display keeps up while keys repeat.
+ */
+static bool ScreenManager_holdFrame(uint64_t* heldSinceMs, uint64_t resizedMs) {
+   uint64_t now;
+   Platform_gettime_monotonic(&now);
+   if (!*heldSinceMs)
+      *heldSinceMs = now;
+
+   int wait = 0;
+   if (now - resizedMs < SCREENMANAGER_RESIZE_SETTLE_MS)
+      wait = (int)(SCREENMANAGER_RESIZE_SETTLE_MS - (now - resizedMs));
+
+   if (now - *heldSinceMs < SCREENMANAGER_HOLD_MS && CRT_inputPending(wait))
+      return true;
+
+   *heldSinceMs = 0;
+   return false;
+}
+
+/*
+ * Draws a frame from a sample of the machine alone, before the first scan of
+ * the table, which can take seconds on large hosts. Returns whether that scan
+ * was started in the background, to be merged once read like any other.
+ */
+static bool ScreenManager_drawFirstFrame(ScreenManager* this) {
+   Machine* host = this->host;
+
+   Machine_scan(host);
+   Header_updateData(this->header);
+
+   Table_rebuildPanel(host->activeTable);
+   if (!this->state->hideMeters)
+      Header_draw(this->header, true);
+   ScreenManager_drawPanels(this, 0, true);
+   refresh();
+   Profile_end(PROFILE_FIRST_FRAME, Profile_startup);
+
+   return Machine_prefetchTables(host);
 }
 
 void ScreenManager_run(ScreenManager* this, Panel** lastFocus, int* lastKey, const char* name) {
@@ -237,29 +384,56 @@ void ScreenManager_run(ScreenManager* this, Panel** lastFocus, int* lastKey, con
    bool redraw = true;
    bool force_redraw = true;
    bool rescan = false;
+   bool prefetching = false;
+   bool framePending = false;
+   uint64_t heldSinceMs = 0;
+   uint64_t resizedMs = 0;
    int sortTimeout = 0;
    int resetSortTimeout = 5;
 
    this->name = name;
 
+   if (this->header && !this->host->activeTable->scanTime) {
+      prefetching = ScreenManager_drawFirstFrame(this);
+      if (prefetching)
+         oldTime = ScreenManager_now(this->host);
+   }
+
    while (!quit) {
-      if (this->header) {
-         checkRecalculation(this, &oldTime, &sortTimeout, &redraw, &rescan, &timedOut, &force_redraw);
-      }
+      if ((redraw || force_redraw || framePending) && ScreenManager_holdFrame(&heldSinceMs, resizedMs)) {
+         framePending = true;
+      } else {
+         if (framePending) {
+            redraw = true;
+            framePending = false;
+         }
+
+         if (this->header) {
+            checkRecalculation(this, &oldTime, &sortTimeout, &redraw, &rescan, &timedOut, &prefetching, &force_redraw);
+         }
 
-      if (redraw || force_redraw) {
-         ScreenManager_drawPanels(this, focus, force_redraw);
-         force_redraw = false;
-         if (this->host->iterationsRemaining != -1) {
-            if (!--this->host->iterationsRemaining) {
-               quit = true;
-               continue;
+         if (redraw || force_redraw) {
+            ScreenManager_drawPanels(this, focus, force_redraw);
+            force_redraw = false;
+            if (this->host->iterationsRemaining != -1) {
+               if (!--this->host->iterationsRemaining) {
+                  quit = true;
+                  continue;
+               }
             }
          }
       }
 
+      /* tagged and followed processes are scanned again as soon as they exit, unless updates are paused */
+      const ProcessTable* pt = (const ProcessTable*) this->host->processTable;
+      const bool watching = this->header && !this->state->pauseUpdate && pt->exitFdCount > 0;
+      CRT_watchFds(watching ? pt->exitFds : NULL, watching ? pt->exitFdCount : 0);
+
+      /* pressure on the system is scanned at once, and faster for a while */
+      CRT_watchTriggers(this->header ? this->host->pressureFds : NULL, this->header ? MACHINE_PRESSURE_KINDS : 0);
+
       int prevCh = ch;
-      ch = Panel_getCh(panelFocus);
+      ch = Panel_getCh(panelFocus, ScreenManager_timeout(this, oldTime));
 
       HandlerResult result = IGNORED;
 #ifdef HAVE_GETMOUSE
@@ -307,7 +481,22 @@ void ScreenManager_run(ScreenManager* this, Panel** lastFocus, int* lastKey, con
          }
       }
 #endif
+      if (ch == ERR && watching && CRT_watchedReady())
+         rescan = true;
+
+      const unsigned int pressure = this->header ? CRT_takeTriggered() : 0;
+      if (pressure) {
+         Machine_notePressure(this->host, pressure);
+         rescan = true;
+      }
+
       if (ch == ERR) {
+         // waiting for a background scan polls faster than the update interval
+         if (prefetching) {
+            redraw = false;
+            continue;
+         }
+
          if (sortTimeout > 0)
             sortTimeout--;
          if (prevCh == ch && !timedOut) {
@@ -322,6 +511,16 @@ void ScreenManager_run(ScreenManager* this, Panel** lastFocus, int* lastKey, con
          continue;
       }
 
+      // slow down in the background, catch up at once when back
+      if (ch == KEY_FOCUS_IN || ch == KEY_FOCUS_OUT) {
+         bool wasUnfocused = this->state->unfocused;
+         this->state->unfocused = ch == KEY_FOCUS_OUT && settings->unfocusedDelay;
+         if (wasUnfocused && !this->state->unfocused)
+            rescan = true;
+         redraw = false;
+         continue;
+      }
+
       switch (ch) {
          case KEY_ALT('H'): ch = KEY_LEFT; break;
          case KEY_ALT('J'): ch = KEY_DOWN; break;
@@ -361,6 +560,7 @@ void ScreenManager_run(ScreenManager* this, Panel** lastFocus, int* lastKey, con
       case KEY_RESIZE:
       {
          ScreenManager_resize(this);
+         Platform_gettime_monotonic(&resizedMs);
          continue;
       }
       case KEY_LEFT:
@@ -0,0 +1,114 @@
+/*
+htop - SelfMeter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "SelfMeter.h"
+
+#include "Budget.h"
+#include "CRT.h"
+#include "Machine.h"
+#include "Macros.h"
+#include "Object.h"
+#include "Profile.h"
+#include "Settings.h"
+#include "XUtils.h"
+
+
+static const int SelfMeter_attributes[] = {
+   CPU_NORMAL,
+   CPU_SYSTEM,
+   CPU_IOWAIT
+};
+
+static double SelfMeter_lastMs(ProfilePhase phase) {
+   return (double)Profile_stats[phase].lastNs / 1e6;
+}
+
+static void SelfMeter_updateValues(Meter* this) {
+   this->values[0] = SelfMeter_lastMs(PROFILE_MACHINE_SCAN) + SelfMeter_lastMs(PROFILE_TABLE_SCAN);
+   this->values[1] = SelfMeter_lastMs(PROFILE_DISPLAY_LIST) + SelfMeter_lastMs(PROFILE_REBUILD_PANEL);
+   this->values[2] = SelfMeter_lastMs(PROFILE_HEADER_DRAW) + SelfMeter_lastMs(PROFILE_PANEL_DRAW);
+
+   const Settings* settings = this->host->settings;
+
+   /* one update interval, in milliseconds */
+   this->total = 100.0 * Budget_delay(settings);
+
+   int len = xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "scan %.1f ms, sort %.1f ms, draw %.1f ms",
+                       this->values[0], this->values[1], this->values[2]);
+   if (settings->cpuBudget && !isNaN(Budget_usage)) {
+      len += xSnprintf(this->txtBuffer + len, sizeof(this->txtBuffer) - len, ", CPU %.1f%% of %.1f%%",
+                       Budget_usage, settings->cpuBudget / 10.0);
+   }
+   if (Budget_level > 0) {
+      len += xSnprintf(this->txtBuffer + len, sizeof(this->txtBuffer) - len, ", interval x%d%s",
+                       1 << Budget_level, Budget_isThrifty() ? ", no CPU freq/temp" : "");
+   }
+   if (Budget_onBattery)
+      xSnprintf(this->txtBuffer + len, sizeof(this->txtBuffer) - len, ", saving power on battery");
+}
+
+static void SelfMeter_displayBudget(const Settings* settings, RichString* out) {
+   char buffer[64];
+   int len;
+
+   if (!settings->cpuBudget || isNaN(Budget_usage))
+      return;
+
+   len = xSnprintf(buffer, sizeof(buffer), "%.1f%%", Budget_usage);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], ", CPU ");
+   RichString_appendnAscii(out, CRT_colors[Budget_level > 0 ? METER_VALUE_WARN : METER_VALUE], buffer, len);
+   len = xSnprintf(buffer, sizeof(buffer), " of %.1f%%", settings->cpuBudget / 10.0);
+   RichString_appendnAscii(out, CRT_colors[METER_TEXT], buffer, len);
+
+   if (Budget_level == 0)
+      return;
+
+   len = xSnprintf(buffer, sizeof(buffer), "interval x%d%s", 1 << Budget_level, Budget_isThrifty() ? ", no CPU freq/temp" : "");
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], ", ");
+   RichString_appendnAscii(out, CRT_colors[METER_VALUE_WARN], buffer, len);
+}
+
+static void SelfMeter_display(const Object* cast, RichString* out) {
+   const Meter* this = (const Meter*)cast;
+   char buffer[32];
+   int len;
+
+   len = xSnprintf(buffer, sizeof(buffer), "%.1f", this->values[0]);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], "scan ");
+   RichString_appendnAscii(out, CRT_colors[CPU_NORMAL], buffer, len);
+   len = xSnprintf(buffer, sizeof(buffer), "%.1f", this->values[1]);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " ms, sort ");
+   RichString_appendnAscii(out, CRT_colors[CPU_SYSTEM], buffer, len);
+   len = xSnprintf(buffer, sizeof(buffer), "%.1f", this->values[2]);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " ms, draw ");
+   RichString_appendnAscii(out, CRT_colors[CPU_IOWAIT], buffer, len);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " ms");
+   SelfMeter_displayBudget(this->host->settings, out);
+   if (Budget_onBattery) {
+      RichString_appendAscii(out, CRT_colors[METER_TEXT], ", ");
+      RichString_appendAscii(out, CRT_colors[METER_VALUE_WARN], "saving power on battery");
+   }
+}
+
+const MeterClass SelfMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = SelfMeter_display
+   },
+   .updateValues = SelfMeter_updateValues,
+   .defaultMode = TEXT_METERMODE,
+   .maxItems = 3,
+   .total = 100.0,
+   .attributes = SelfMeter_attributes,
+   .name = "Self",
+   .uiName = "Htop self",
+   .description = "Time htop spent on its last update, and its CPU usage against the budget",
+   .caption = "htop: "
+};
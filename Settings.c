@@ -74,6 +74,10 @@ static void writeQuotedList(FILE* fd, char** list) {
 
 void Settings_delete(Settings* this) {
    free(this->filename);
+   free(this->diskIODevices);
+   free(this->diskIOExclude);
+   free(this->networkIODevices);
+   free(this->networkIOExclude);
    for (unsigned int i = 0; i < HeaderLayout_getColumns(this->hLayout); i++) {
       String_freeArray(this->hColumns[i].names);
       free(this->hColumns[i].modes);
@@ -88,6 +92,18 @@ void Settings_delete(Settings* this) {
    free(this);
 }
 
+/* An empty pattern is none */
+static void Settings_readPattern(char** pattern, const char* line) {
+   char* trim = String_trim(line);
+   if (!trim[0]) {
+      free(trim);
+      trim = NULL;
+   }
+
+   free(*pattern);
+   *pattern = trim;
+}
+
 static void Settings_readMeters(Settings* this, const char* line, unsigned int column) {
    char* trim = String_trim(line);
    char** ids = String_split(trim, ' ', NULL);
@@ -269,6 +285,7 @@ static void ScreenSettings_readFields(ScreenSettings* ss, Hashtable* columns, co
 
    /* reset default fields */
    memset(ss->fields, '\0', LAST_PROCESSFIELD * sizeof(ProcessField));
+   ScreenSettings_fieldsChanged(ss);
 
    for (size_t j = 0, i = 0; ids[i]; i++) {
       if (j >= UINT_MAX / sizeof(ProcessField))
@@ -286,6 +303,26 @@ static void ScreenSettings_readFields(ScreenSettings* ss, Hashtable* columns, co
    String_freeArray(ids);
 }
 
+static void ScreenSettings_readThenSortKeys(ScreenSettings* ss, Hashtable* columns, const char* line) {
+   char* trim = String_trim(line);
+   char** ids = String_split(trim, ' ', NULL);
+   free(trim);
+
+   size_t j = 0;
+   for (size_t i = 0; ids[i] && j < SCREEN_THEN_SORT_KEYS; i++) {
+      int id = toFieldIndex(columns, ids[i]);
+      if (id <= 0)
+         continue;
+
+      ss->thenSortKeys[j++] = id;
+      /* the data of a key not shown is read all the same */
+      if (id < LAST_PROCESSFIELD)
+         ss->flags |= Process_fields[id].flags;
+   }
+   ss->thenSortKeys[j] = 0;
+   String_freeArray(ids);
+}
+
 static ScreenSettings* Settings_initScreenSettings(ScreenSettings* ss, Settings* this, const char* columns) {
    ScreenSettings_readFields(ss, this->dynamicColumns, columns);
    this->screens[this->nScreens] = ss;
@@ -319,7 +356,10 @@ ScreenSettings* Settings_newScreen(Settings* this, const ScreenDefaults* default
 }
 
 ScreenSettings* Settings_newDynamicScreen(Settings* this, const char* tab, const DynamicScreen* screen, Table* table) {
-   int sortKey = toFieldIndex(this->dynamicColumns, screen->columnKeys);
+   /* sorted by the first column unless the screen names another one */
+   int sortKey = screen->sortKey ? toFieldIndex(this->dynamicColumns, screen->sortKey) : -1;
+   if (sortKey < 0)
+      sortKey = toFieldIndex(this->dynamicColumns, screen->columnKeys);
 
    ScreenSettings* ss = xMalloc(sizeof(ScreenSettings));
    *ss = (ScreenSettings) {
@@ -331,6 +371,9 @@ ScreenSettings* Settings_newDynamicScreen(Settings* this, const char* tab, const
       .treeDirection = 1,
       .sortKey = sortKey,
    };
+   /* screens added in the setup get the table of the platform */
+   if (!table)
+      Platform_addDynamicScreen(ss);
    return Settings_initScreenSettings(ss, this, screen->columnKeys);
 }
 
@@ -338,9 +381,36 @@ void ScreenSettings_delete(ScreenSettings* this) {
    free(this->heading);
    free(this->dynamic);
    free(this->fields);
+   free(this->columns);
    free(this);
 }
 
+void ScreenSettings_fieldsChanged(ScreenSettings* this) {
+   free(this->columns);
+   this->columns = NULL;
+   this->nColumns = 0;
+}
+
+const ScreenColumn* ScreenSettings_getColumns(ScreenSettings* this, Hashtable* dynamicColumns, int* count) {
+   if (!this->columns) {
+      int n = 0;
+      while (this->fields[n])
+         n++;
+
+      this->columns = xCalloc(n + 1, sizeof(ScreenColumn));
+      for (int i = 0; i < n; i++) {
+         const RowField field = this->fields[i];
+         this->columns[i].field = field;
+         if (field >= LAST_PROCESSFIELD && dynamicColumns)
+            this->columns[i].dynamic = DynamicColumn_lookup(dynamicColumns, field);
+      }
+      this->nColumns = n;
+   }
+
+   *count = this->nColumns;
+   return this->columns;
+}
+
 static ScreenSettings* Settings_defaultScreens(Settings* this) {
    if (this->nScreens)
       return this->screens[0];
@@ -424,6 +494,16 @@ static bool Settings_read(Settings* this, const char* fileName, unsigned int ini
          this->hideUserlandThreads = atoi(option[1]);
       } else if (String_eq(option[0], "hide_running_in_container")) {
          this->hideRunningInContainer = atoi(option[1]);
+      } else if (String_eq(option[0], "lazy_collection")) {
+         this->lazyCollection = atoi(option[1]);
+      } else if (String_eq(option[0], "warm_screens")) {
+         this->warmScreens = atoi(option[1]);
+      } else if (String_eq(option[0], "preload_users")) {
+         this->preloadUsers = atoi(option[1]);
+      } else if (String_eq(option[0], "container_names")) {
+         this->containerNames = atoi(option[1]);
+      } else if (String_eq(option[0], "precise_cpu")) {
+         this->preciseCpu = atoi(option[1]);
       } else if (String_eq(option[0], "shadow_other_users")) {
          this->shadowOtherUsers = atoi(option[1]);
       } else if (String_eq(option[0], "show_thread_names")) {
@@ -480,6 +560,24 @@ static bool Settings_read(Settings* this, const char* fileName, unsigned int ini
          this->accountGuestInCPUMeter = atoi(option[1]);
       } else if (String_eq(option[0], "delay")) {
          this->delay = CLAMP(atoi(option[1]), 1, 255);
+      } else if (String_eq(option[0], "table_delay")) {
+         this->tableDelay = CLAMP(atoi(option[1]), 0, 255);
+      } else if (String_eq(option[0], "unfocused_delay")) {
+         this->unfocusedDelay = CLAMP(atoi(option[1]), 0, 3000);
+      } else if (String_eq(option[0], "cpu_budget")) {
+         this->cpuBudget = CLAMP(atoi(option[1]), 0, 1000);
+      } else if (String_eq(option[0], "trace_lines")) {
+         this->traceLines = CLAMP(atoi(option[1]), 1, 10000);
+      } else if (String_eq(option[0], "mem_growth_window")) {
+         this->memGrowthWindow = CLAMP(atoi(option[1]), 1, 24 * 60);
+      } else if (String_eq(option[0], "disk_io_devices")) {
+         Settings_readPattern(&this->diskIODevices, option[1]);
+      } else if (String_eq(option[0], "disk_io_exclude")) {
+         Settings_readPattern(&this->diskIOExclude, option[1]);
+      } else if (String_eq(option[0], "network_io_devices")) {
+         Settings_readPattern(&this->networkIODevices, option[1]);
+      } else if (String_eq(option[0], "network_io_exclude")) {
+         Settings_readPattern(&this->networkIOExclude, option[1]);
       } else if (String_eq(option[0], "color_scheme")) {
          this->colorScheme = atoi(option[1]);
          if (this->colorScheme < 0 || this->colorScheme >= LAST_COLORSCHEME) {
@@ -515,10 +613,24 @@ static bool Settings_read(Settings* this, const char* fileName, unsigned int ini
          didReadMeters = true;
       } else if (String_eq(option[0], "hide_function_bar")) {
          this->hideFunctionBar = atoi(option[1]);
+      } else if (String_eq(option[0], "low_bandwidth")) {
+         this->lowBandwidth = atoi(option[1]);
+      } else if (String_eq(option[0], "battery_saver")) {
+         this->batterySaver = atoi(option[1]);
       #ifdef HAVE_LIBHWLOC
       } else if (String_eq(option[0], "topology_affinity")) {
          this->topologyAffinity = !!atoi(option[1]);
       #endif
+      #ifdef HAVE_PROC_CONNECTOR
+      } else if (String_eq(option[0], "proc_connector")) {
+         this->procConnector = !!atoi(option[1]);
+      #endif
+      #ifdef HAVE_PTHREAD
+      } else if (String_eq(option[0], "scan_threads")) {
+         this->scanThreads = CLAMP(atoi(option[1]), 0, 64);
+      #endif
+      } else if (String_eq(option[0], "pressure_trigger")) {
+         this->pressureTrigger = CLAMP(atoi(option[1]), 0, 100);
       } else if (strncmp(option[0], "screen:", 7) == 0) {
          screen = Settings_newScreen(this, &(const ScreenDefaults) { .name = option[0] + 7, .columns = option[1] });
       } else if (String_eq(option[0], ".sort_key")) {
@@ -531,6 +643,9 @@ static bool Settings_read(Settings* this, const char* fileName, unsigned int ini
             int key = toFieldIndex(this->dynamicColumns, option[1]);
             screen->treeSortKey = key > 0 ? key : PID;
          }
+      } else if (String_eq(option[0], ".then_sort_keys")) {
+         if (screen)
+            ScreenSettings_readThenSortKeys(screen, this->dynamicColumns, option[1]);
       } else if (String_eq(option[0], ".sort_direction")) {
          if (screen)
             screen->direction = atoi(option[1]);
@@ -637,6 +752,11 @@ int Settings_write(const Settings* this, bool onCrash) {
    printSettingInteger("hide_kernel_threads", this->hideKernelThreads);
    printSettingInteger("hide_userland_threads", this->hideUserlandThreads);
    printSettingInteger("hide_running_in_container", this->hideRunningInContainer);
+   printSettingInteger("lazy_collection", this->lazyCollection);
+   printSettingInteger("warm_screens", this->warmScreens);
+   printSettingInteger("preload_users", this->preloadUsers);
+   printSettingInteger("container_names", this->containerNames);
+   printSettingInteger("precise_cpu", this->preciseCpu);
    printSettingInteger("shadow_other_users", this->shadowOtherUsers);
    printSettingInteger("show_thread_names", this->showThreadNames);
    printSettingInteger("show_program_path", this->showProgramPath);
@@ -667,10 +787,28 @@ int Settings_write(const Settings* this, bool onCrash) {
    printSettingInteger("enable_mouse", this->enableMouse);
    #endif
    printSettingInteger("delay", (int) this->delay);
+   printSettingInteger("table_delay", this->tableDelay);
+   printSettingInteger("unfocused_delay", this->unfocusedDelay);
+   printSettingInteger("cpu_budget", this->cpuBudget);
+   printSettingInteger("trace_lines", this->traceLines);
+   printSettingInteger("mem_growth_window", this->memGrowthWindow);
+   printSettingString("disk_io_devices", this->diskIODevices ? this->diskIODevices : "");
+   printSettingString("disk_io_exclude", this->diskIOExclude ? this->diskIOExclude : "");
+   printSettingString("network_io_devices", this->networkIODevices ? this->networkIODevices : "");
+   printSettingString("network_io_exclude", this->networkIOExclude ? this->networkIOExclude : "");
    printSettingInteger("hide_function_bar", (int) this->hideFunctionBar);
+   printSettingInteger("low_bandwidth", this->lowBandwidth);
+   printSettingInteger("battery_saver", this->batterySaver);
    #ifdef HAVE_LIBHWLOC
    printSettingInteger("topology_affinity", this->topologyAffinity);
    #endif
+   #ifdef HAVE_PROC_CONNECTOR
+   printSettingInteger("proc_connector", this->procConnector);
+   #endif
+   #ifdef HAVE_PTHREAD
+   printSettingInteger("scan_threads", this->scanThreads);
+   #endif
+   printSettingInteger("pressure_trigger", this->pressureTrigger);
 
    printSettingString("header_layout", HeaderLayout_getName(this->hLayout));
    for (unsigned int i = 0; i < HeaderLayout_getColumns(this->hLayout); i++) {
@@ -708,6 +846,10 @@ int Settings_write(const Settings* this, bool onCrash) {
          printSettingString(".tree_sort_key", treeSortKey);
          printSettingInteger(".tree_view_always_by_pid", ss->treeViewAlwaysByPID);
       }
+      if (ss->thenSortKeys[0]) {
+         fprintf(fd, ".then_sort_keys=");
+         writeFields(fd, ss->thenSortKeys, this->dynamicColumns, true, separator);
+      }
       printSettingInteger(".tree_view", ss->treeView);
       printSettingInteger(".sort_direction", ss->direction);
       printSettingInteger(".tree_sort_direction", ss->treeDirection);
@@ -736,7 +878,8 @@ int Settings_write(const Settings* this, bool onCrash) {
    return r;
 }
 
-Settings* Settings_new(unsigned int initialCpuCount, Hashtable* dynamicMeters, Hashtable* dynamicColumns, Hashtable* dynamicScreens) {
+/* The built-in values of the settings, without meters and screens */
+static Settings* Settings_alloc(Hashtable* dynamicMeters, Hashtable* dynamicColumns, Hashtable* dynamicScreens) {
    Settings* this = xCalloc(1, sizeof(Settings));
 
    this->dynamicScreens = dynamicScreens;
@@ -750,6 +893,11 @@ Settings* Settings_new(unsigned int initialCpuCount, Hashtable* dynamicMeters, H
    this->hideKernelThreads = true;
    this->hideUserlandThreads = false;
    this->hideRunningInContainer = false;
+   this->lazyCollection = false;
+   this->warmScreens = false;
+   this->preloadUsers = false;
+   this->containerNames = false;
+   this->preciseCpu = false;
    this->highlightBaseName = false;
    this->highlightDeletedExe = true;
    this->shadowDistPathPrefix = false;
@@ -771,14 +919,38 @@ Settings* Settings_new(unsigned int initialCpuCount, Hashtable* dynamicMeters, H
    this->stripExeFromCmdline = true;
    this->showMergedCommand = false;
    this->hideFunctionBar = 0;
+   this->lowBandwidth = false;
+   this->batterySaver = false;
    this->headerMargin = true;
    #ifdef HAVE_LIBHWLOC
    this->topologyAffinity = false;
    #endif
+   #ifdef HAVE_PROC_CONNECTOR
+   this->procConnector = false;
+   #endif
+   #ifdef HAVE_PTHREAD
+   this->scanThreads = 0;
+   #endif
+   this->pressureTrigger = 0;
 
    this->screens = xCalloc(Platform_numberOfDefaultScreens * sizeof(ScreenSettings*), 1);
    this->nScreens = 0;
 
+   this->colorScheme = 0;
+#ifdef HAVE_GETMOUSE
+   this->enableMouse = true;
+#endif
+   this->changed = false;
+   this->delay = DEFAULT_DELAY;
+   this->traceLines = 100;
+   this->memGrowthWindow = 60;
+
+   return this;
+}
+
+Settings* Settings_new(unsigned int initialCpuCount, Hashtable* dynamicMeters, Hashtable* dynamicColumns, Hashtable* dynamicScreens) {
+   Settings* this = Settings_alloc(dynamicMeters, dynamicColumns, dynamicScreens);
+
    char* legacyDotfile = NULL;
    const char* rcfile = getenv("HTOPRC");
    if (rcfile) {
@@ -813,12 +985,6 @@ Settings* Settings_new(unsigned int initialCpuCount, Hashtable* dynamicMeters, H
          legacyDotfile = NULL;
       }
    }
-   this->colorScheme = 0;
-#ifdef HAVE_GETMOUSE
-   this->enableMouse = true;
-#endif
-   this->changed = false;
-   this->delay = DEFAULT_DELAY;
    bool ok = false;
    if (legacyDotfile) {
       ok = Settings_read(this, legacyDotfile, initialCpuCount);
@@ -851,19 +1017,67 @@ Settings* Settings_new(unsigned int initialCpuCount, Hashtable* dynamicMeters, H
    return this;
 }
 
+Settings* Settings_newDefault(unsigned int initialCpuCount, Hashtable* dynamicMeters, Hashtable* dynamicColumns, Hashtable* dynamicScreens) {
+   Settings* this = Settings_alloc(dynamicMeters, dynamicColumns, dynamicScreens);
+
+   Settings_defaultMeters(this, initialCpuCount);
+   Settings_defaultScreens(this);
+
+   this->ssIndex = 0;
+   this->ss = this->screens[this->ssIndex];
+
+   this->lastUpdate = 1;
+
+   return this;
+}
+
 void ScreenSettings_invertSortOrder(ScreenSettings* this) {
    int* attr = (this->treeView) ? &(this->treeDirection) : &(this->direction);
    *attr = (*attr == 1) ? -1 : 1;
 }
 
+bool ScreenSettings_isSortDescByDefault(RowField key) {
+   /* dynamic columns hold mostly numbers, largest first */
+   return key >= LAST_PROCESSFIELD || Process_fields[key].defaultSortDesc;
+}
+
+static void ScreenSettings_removeThenSortKey(ScreenSettings* this, RowField key) {
+   size_t j = 0;
+   for (size_t i = 0; this->thenSortKeys[i]; i++) {
+      if (this->thenSortKeys[i] != key)
+         this->thenSortKeys[j++] = this->thenSortKeys[i];
+   }
+   this->thenSortKeys[j] = 0;
+}
+
+bool ScreenSettings_toggleThenSortKey(ScreenSettings* this, RowField key) {
+   size_t count = 0;
+   while (this->thenSortKeys[count]) {
+      if (this->thenSortKeys[count] == key) {
+         ScreenSettings_removeThenSortKey(this, key);
+         return true;
+      }
+      count++;
+   }
+
+   if (count >= SCREEN_THEN_SORT_KEYS || key == ScreenSettings_getActiveSortKey(this))
+      return false;
+
+   this->thenSortKeys[count] = key;
+   this->thenSortKeys[count + 1] = 0;
+   return true;
+}
+
 void ScreenSettings_setSortKey(ScreenSettings* this, ProcessField sortKey) {
+   const bool sortDesc = ScreenSettings_isSortDescByDefault(sortKey);
+   ScreenSettings_removeThenSortKey(this, sortKey);
    if (this->treeViewAlwaysByPID || !this->treeView) {
       this->sortKey = sortKey;
-      this->direction = (Process_fields[sortKey].defaultSortDesc) ? -1 : 1;
+      this->direction = sortDesc ? -1 : 1;
       this->treeView = false;
    } else {
       this->treeSortKey = sortKey;
-      this->treeDirection = (Process_fields[sortKey].defaultSortDesc) ? -1 : 1;
+      this->treeDirection = sortDesc ? -1 : 1;
    }
 }
 
@@ -21,6 +21,7 @@ in the source distribution for its full text.
 
 #define CONFIG_READER_MIN_VERSION 3
 
+struct DynamicColumn_;  // IWYU pragma: keep
 struct DynamicScreen_;  // IWYU pragma: keep
 struct Table_;          // IWYU pragma: keep
 
@@ -37,16 +38,28 @@ typedef struct {
    int* modes;
 } MeterColumnSetting;
 
+/* A column of a screen with its metadata resolved, so drawing needs no lookups */
+typedef struct ScreenColumn_ {
+   RowField field;
+   const struct DynamicColumn_* dynamic;  /* NULL for process fields and unknown dynamic ones */
+} ScreenColumn;
+
+/* Sort keys breaking the ties of the active one, before the id does */
+#define SCREEN_THEN_SORT_KEYS 2
+
 typedef struct ScreenSettings_ {
    char* heading;  /* user-editable screen name (pretty) */
    char* dynamic;  /* from DynamicScreen config (fixed) */
    struct Table_* table;
    RowField* fields;
-   uint32_t flags;
+   ScreenColumn* columns;  /* compiled from fields on first use, NULL after they changed */
+   int nColumns;
+   uint64_t flags;
    int direction;
    int treeDirection;
    RowField sortKey;
    RowField treeSortKey;
+   RowField thenSortKeys[SCREEN_THEN_SORT_KEYS + 1];  /* 0 terminated, each in its default direction */
    bool treeView;
    bool treeViewAlwaysByPID;
    bool allBranchesCollapsed;
@@ -68,6 +81,17 @@ typedef struct Settings_ {
 
    int colorScheme;
    int delay;
+   int tableDelay;               /* between scans of the process list, 0 - every update */
+   int cpuBudget;                /* tenths of a percent of one CPU htop may use, 0 - unlimited */
+   int unfocusedDelay;           /* while the terminal is not focused, 0 - same as delay */
+   int traceLines;               /* thousands of lines the trace screen keeps, older ones are dropped */
+   int memGrowthWindow;          /* minutes the memory growth column fits its slope over */
+
+   /* `|` separated parts of the names of the devices the IO meters count or leave out, NULL for the default ones */
+   char* diskIODevices;
+   char* diskIOExclude;
+   char* networkIODevices;
+   char* networkIOExclude;
 
    bool countCPUsFromOne;
    bool detailedCPUTime;
@@ -82,6 +106,11 @@ typedef struct Settings_ {
    bool showThreadNames;
    bool hideKernelThreads;
    bool hideRunningInContainer;
+   bool lazyCollection;  // read expensive columns only for rows on screen
+   bool warmScreens;     // read the columns of the other screens too, less often
+   bool preloadUsers;    // read the whole user database at startup
+   bool containerNames;  // name containers after the metadata of their runtime
+   bool preciseCpu;      // CPU% from the nanoseconds tasks ran (schedstat) rather than clock ticks
    bool hideUserlandThreads;
    bool highlightBaseName;
    bool highlightDeletedExe;
@@ -101,9 +130,18 @@ typedef struct Settings_ {
    bool enableMouse;
    #endif
    int hideFunctionBar;  // 0 - off, 1 - on ESC until next input, 2 - permanently
+   bool lowBandwidth;    // fewer graph meter updates, synchronized terminal updates
+   bool batterySaver;    // longer interval and fewer collectors while on battery
    #ifdef HAVE_LIBHWLOC
    bool topologyAffinity;
    #endif
+   #ifdef HAVE_PROC_CONNECTOR
+   bool procConnector;   // discover processes through kernel process events
+   #endif
+   #ifdef HAVE_PTHREAD
+   int scanThreads;      // 0/1 - scan /proc serially, >1 - number of worker threads
+   #endif
+   int pressureTrigger;  // percent of a second stalled on CPU, memory or I/O that updates faster, 0 - off
 
    bool changed;
    uint64_t lastUpdate;
@@ -127,16 +165,31 @@ int Settings_write(const Settings* this, bool onCrash);
 
 Settings* Settings_new(unsigned int initialCpuCount, Hashtable* dynamicMeters, Hashtable* dynamicColumns, Hashtable* dynamicScreens);
 
+/* The defaults, without reading or creating a configuration file; Settings_write must not be used on them */
+Settings* Settings_newDefault(unsigned int initialCpuCount, Hashtable* dynamicMeters, Hashtable* dynamicColumns, Hashtable* dynamicScreens);
+
 ScreenSettings* Settings_newScreen(Settings* this, const ScreenDefaults* defaults);
 
 ScreenSettings* Settings_newDynamicScreen(Settings* this, const char* tab, const struct DynamicScreen_* screen, struct Table_* table);
 
 void ScreenSettings_delete(ScreenSettings* this);
 
+/* To be called whenever `fields` changed */
+void ScreenSettings_fieldsChanged(ScreenSettings* this);
+
+/* The columns of `fields`, compiled again after they changed; `count` receives their number */
+const ScreenColumn* ScreenSettings_getColumns(ScreenSettings* this, Hashtable* dynamicColumns, int* count);
+
 void ScreenSettings_invertSortOrder(ScreenSettings* this);
 
 void ScreenSettings_setSortKey(ScreenSettings* this, RowField sortKey);
 
+/* Whether the field sorts largest first unless inverted */
+bool ScreenSettings_isSortDescByDefault(RowField key);
+
+/* Appends the key to the ones breaking ties, or removes it if it is one; false if there is no room left */
+bool ScreenSettings_toggleThenSortKey(ScreenSettings* this, RowField key);
+
 void Settings_enableReadonly(void);
 
 bool Settings_isReadonly(void);
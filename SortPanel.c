@@ -0,0 +1,117 @@
+/*
+htop - SortPanel.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "SortPanel.h"
+
+#include <stdlib.h>
+
+#include "DynamicColumn.h"
+#include "FunctionBar.h"
+#include "ListItem.h"
+#include "Object.h"
+#include "Process.h"
+#include "ProvideCurses.h"
+#include "RowField.h"
+#include "XUtils.h"
+
+
+static const char* const SortPanelFunctions[] = {"Sort   ", "Cancel ", "Then by", NULL};
+static const char* const SortPanelKeys[] = {"Enter", "Esc", "F2"};
+static const int SortPanelEvents[] = {13, 27, KEY_F(2)};
+
+/* The name of the column, followed by its place among the sort keys if it breaks ties */
+static char* SortPanel_itemName(const SortPanel* this, RowField field) {
+   char* name;
+   if (field >= ROW_DYNAMIC_FIELDS) {
+      const DynamicColumn* column = Hashtable_get(this->dynamicColumns, field);
+      if (!column)
+         return NULL;
+      name = xStrdup(column->caption ? column->caption : column->name);
+   } else {
+      name = String_trim(Process_fields[field].name);
+   }
+
+   for (int i = 0; this->ss->thenSortKeys[i]; i++) {
+      if (this->ss->thenSortKeys[i] == field) {
+         char* marked;
+         xAsprintf(&marked, "%s (%d)", name, i + 2);
+         free(name);
+         return marked;
+      }
+   }
+   return name;
+}
+
+static void SortPanel_update(SortPanel* this) {
+   Panel* super = &this->super;
+   for (int i = 0; i < Panel_size(super); i++) {
+      ListItem* item = (ListItem*) Panel_get(super, i);
+      char* name = SortPanel_itemName(this, item->key);
+      if (name) {
+         free(item->value);
+         item->value = name;
+      }
+   }
+   super->needsRedraw = true;
+}
+
+static void SortPanel_delete(Object* object) {
+   Panel* super = (Panel*) object;
+   SortPanel* this = (SortPanel*) object;
+   Panel_done(super);
+   free(this);
+}
+
+static HandlerResult SortPanel_eventHandler(Panel* super, int ch) {
+   SortPanel* this = (SortPanel*) super;
+
+   if (ch != KEY_F(2) || !this->thenKeys)
+      return Panel_selectByTyping(super, ch);
+
+   const ListItem* selected = (const ListItem*) Panel_getSelected(super);
+   if (selected && !ScreenSettings_toggleThenSortKey(this->ss, selected->key))
+      beep();
+
+   SortPanel_update(this);
+   return HANDLED;
+}
+
+const PanelClass SortPanel_class = {
+   .super = {
+      .extends = Class(Panel),
+      .delete = SortPanel_delete
+   },
+   .eventHandler = SortPanel_eventHandler
+};
+
+SortPanel* SortPanel_new(ScreenSettings* ss, Hashtable* dynamicColumns, bool thenKeys) {
+   SortPanel* this = AllocThis(SortPanel);
+   Panel* super = (Panel*) this;
+   FunctionBar* fuBar = thenKeys ? FunctionBar_new(SortPanelFunctions, SortPanelKeys, SortPanelEvents) : FunctionBar_newEnterEsc("Sort   ", "Cancel ");
+   Panel_init(super, 0, 0, 0, 0, Class(ListItem), true, fuBar);
+
+   this->ss = ss;
+   this->dynamicColumns = dynamicColumns;
+   this->thenKeys = thenKeys;
+
+   Panel_setHeader(super, "Sort by");
+
+   const RowField active = ScreenSettings_getActiveSortKey(ss);
+   for (int i = 0; ss->fields[i]; i++) {
+      char* name = SortPanel_itemName(this, ss->fields[i]);
+      if (!name)
+         continue;
+
+      Panel_add(super, (Object*) ListItem_new(name, ss->fields[i]));
+      if (ss->fields[i] == active)
+         Panel_setSelected(super, Panel_size(super) - 1);
+      free(name);
+   }
+   return this;
+}
@@ -0,0 +1,30 @@
+#ifndef HEADER_SortPanel
+#define HEADER_SortPanel
+/*
+htop - SortPanel.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+
+#include "Hashtable.h"
+#include "Panel.h"
+#include "Settings.h"
+
+
+/* The columns of a screen to pick the sort key from; F2 picks the keys breaking its ties, if `thenKeys` */
+typedef struct SortPanel_ {
+   Panel super;
+
+   ScreenSettings* ss;
+   Hashtable* dynamicColumns;
+   bool thenKeys;
+} SortPanel;
+
+extern const PanelClass SortPanel_class;
+
+SortPanel* SortPanel_new(ScreenSettings* ss, Hashtable* dynamicColumns, bool thenKeys);
+
+#endif
@@ -0,0 +1,82 @@
+/*
+htop - SparseArray.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "SparseArray.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "XUtils.h"
+
+
+SparseArray* SparseArray_new(void) {
+   SparseArray* this = xCalloc(1, sizeof(SparseArray));
+   return this;
+}
+
+void SparseArray_delete(SparseArray* this) {
+   if (!this)
+      return;
+
+   for (size_t i = 0; i < this->leafCount; i++)
+      free(this->leaves[i]);
+
+   free(this->leaves);
+   free(this);
+}
+
+void SparseArray_put(SparseArray* this, ht_key_t key, void* value) {
+   assert(value);
+
+   size_t leaf = key >> SPARSEARRAY_LEAF_BITS;
+   if (leaf >= this->leafCount) {
+      size_t leafCount = this->leafCount ? this->leafCount : 16;
+      while (leafCount <= leaf)
+         leafCount *= 2;
+
+      this->leaves = xReallocArray(this->leaves, leafCount, sizeof(SparseArrayLeaf*));
+      memset(this->leaves + this->leafCount, 0, (leafCount - this->leafCount) * sizeof(SparseArrayLeaf*));
+      this->leafCount = leafCount;
+   }
+
+   if (!this->leaves[leaf])
+      this->leaves[leaf] = xCalloc(1, sizeof(SparseArrayLeaf));
+
+   SparseArrayLeaf* l = this->leaves[leaf];
+   void** slot = &l->values[key & (SPARSEARRAY_LEAF_SIZE - 1)];
+   if (!*slot) {
+      l->count++;
+      this->count++;
+   }
+   *slot = value;
+}
+
+void* SparseArray_remove(SparseArray* this, ht_key_t key) {
+   size_t leaf = key >> SPARSEARRAY_LEAF_BITS;
+   if (leaf >= this->leafCount || !this->leaves[leaf])
+      return NULL;
+
+   SparseArrayLeaf* l = this->leaves[leaf];
+   void** slot = &l->values[key & (SPARSEARRAY_LEAF_SIZE - 1)];
+   void* value = *slot;
+   if (!value)
+      return NULL;
+
+   *slot = NULL;
+   this->count--;
+
+   /* PIDs wrap around, so drop leaves that went out of use */
+   if (--l->count == 0) {
+      free(l);
+      this->leaves[leaf] = NULL;
+   }
+
+   return value;
+}
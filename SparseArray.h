@@ -0,0 +1,54 @@
+#ifndef HEADER_SparseArray
+#define HEADER_SparseArray
+/*
+htop - SparseArray.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stddef.h>
+
+#include "Hashtable.h"
+
+
+/* Keys sharing all but the low SPARSEARRAY_LEAF_BITS bits live in one leaf */
+#define SPARSEARRAY_LEAF_BITS 10
+#define SPARSEARRAY_LEAF_SIZE (1U << SPARSEARRAY_LEAF_BITS)
+
+typedef struct SparseArrayLeaf_ {
+   void* values[SPARSEARRAY_LEAF_SIZE];
+   unsigned int count;
+} SparseArrayLeaf;
+
+/*
+ * Two level array indexed directly by key, meant for small dense keys such
+ * as PIDs. Leaves are allocated on demand and freed once empty again.
+ */
+typedef struct SparseArray_ {
+   SparseArrayLeaf** leaves;
+   size_t leafCount;
+   size_t count;
+} SparseArray;
+
+SparseArray* SparseArray_new(void);
+
+void SparseArray_delete(SparseArray* this);
+
+void SparseArray_put(SparseArray* this, ht_key_t key, void* value);
+
+void* SparseArray_remove(SparseArray* this, ht_key_t key);
+
+static inline void* SparseArray_get(const SparseArray* this, ht_key_t key) {
+   size_t leaf = key >> SPARSEARRAY_LEAF_BITS;
+   if (leaf >= this->leafCount || !this->leaves[leaf])
+      return NULL;
+
+   return this->leaves[leaf]->values[key & (SPARSEARRAY_LEAF_SIZE - 1)];
+}
+
+static inline size_t SparseArray_count(const SparseArray* this) {
+   return this->count;
+}
+
+#endif
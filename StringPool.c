@@ -0,0 +1,138 @@
+/*
+htop - StringPool.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "StringPool.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "XUtils.h"
+
+
+#define STRINGPOOL_INITIAL_BUCKETS 1024
+
+typedef struct StringPoolEntry_ {
+   struct StringPoolEntry_* next;
+   size_t size;
+   unsigned int refCount;
+   uint32_t hash;
+   /* keeps data aligned for anything stored behind the string */
+   union {
+      long double ld;
+      void* p;
+      long long ll;
+   } data[];
+} StringPoolEntry;
+
+typedef struct StringPool_ {
+   StringPoolEntry** buckets;
+   size_t bucketCount;        /* always a power of two */
+   size_t count;
+} StringPool;
+
+static StringPool StringPool_pool;
+
+/* FNV-1a */
+static uint32_t StringPool_hash(const void* data, size_t size) {
+   uint32_t hash = 2166136261U;
+   const unsigned char* p = data;
+   for (size_t i = 0; i < size; i++) {
+      hash ^= p[i];
+      hash *= 16777619U;
+   }
+   return hash;
+}
+
+static StringPoolEntry* StringPool_entry(const void* interned) {
+   return (StringPoolEntry*)(void*)((char*)(uintptr_t)interned - offsetof(StringPoolEntry, data));
+}
+
+static void StringPool_grow(StringPool* this) {
+   size_t newCount = this->bucketCount ? this->bucketCount * 2 : STRINGPOOL_INITIAL_BUCKETS;
+   StringPoolEntry** newBuckets = xCalloc(newCount, sizeof(StringPoolEntry*));
+
+   for (size_t i = 0; i < this->bucketCount; i++) {
+      StringPoolEntry* entry = this->buckets[i];
+      while (entry) {
+         StringPoolEntry* next = entry->next;
+         size_t idx = entry->hash & (newCount - 1);
+         entry->next = newBuckets[idx];
+         newBuckets[idx] = entry;
+         entry = next;
+      }
+   }
+
+   free(this->buckets);
+   this->buckets = newBuckets;
+   this->bucketCount = newCount;
+}
+
+const void* StringPool_intern(const void* data, size_t size) {
+   StringPool* this = &StringPool_pool;
+   const uint32_t hash = StringPool_hash(data, size);
+
+   if (this->bucketCount) {
+      for (StringPoolEntry* entry = this->buckets[hash & (this->bucketCount - 1)]; entry; entry = entry->next) {
+         if (entry->hash == hash && entry->size == size && memcmp(entry->data, data, size) == 0) {
+            entry->refCount++;
+            return entry->data;
+         }
+      }
+   }
+
+   if (this->count >= this->bucketCount)
+      StringPool_grow(this);
+
+   StringPoolEntry* entry = xMalloc(offsetof(StringPoolEntry, data) + size);
+   memcpy(entry->data, data, size);
+   entry->size = size;
+   entry->refCount = 1;
+   entry->hash = hash;
+
+   size_t idx = hash & (this->bucketCount - 1);
+   entry->next = this->buckets[idx];
+   this->buckets[idx] = entry;
+   this->count++;
+
+   return entry->data;
+}
+
+const char* StringPool_get(const char* str) {
+   if (!str)
+      return NULL;
+
+   return StringPool_intern(str, strlen(str) + 1);
+}
+
+const void* StringPool_ref(const void* interned) {
+   if (interned)
+      StringPool_entry(interned)->refCount++;
+   return interned;
+}
+
+void StringPool_release(const void* interned) {
+   if (!interned)
+      return;
+
+   StringPool* this = &StringPool_pool;
+   StringPoolEntry* entry = StringPool_entry(interned);
+   assert(entry->refCount > 0);
+   if (--entry->refCount > 0)
+      return;
+
+   StringPoolEntry** link = &this->buckets[entry->hash & (this->bucketCount - 1)];
+   while (*link != entry)
+      link = &(*link)->next;
+   *link = entry->next;
+   this->count--;
+
+   free(entry);
+}
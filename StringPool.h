@@ -0,0 +1,36 @@
+#ifndef HEADER_StringPool
+#define HEADER_StringPool
+/*
+htop - StringPool.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stddef.h>
+
+
+/*
+ * Reference counted copies of strings, shared by everyone holding the same
+ * content. Hosts running thousands of workers of one pool (php-fpm,
+ * postgres, ...) keep one copy of their command line instead of one per
+ * process, and equal contents have equal pointers.
+ *
+ * Entries hold size bytes of any content, aligned for any type, so that
+ * a string may carry data after its terminating NUL. The pool is meant to
+ * be used from the main thread only.
+ */
+
+/* Returns a new reference to the interned copy of the size bytes at data */
+const void* StringPool_intern(const void* data, size_t size);
+
+/* Like StringPool_intern, for a NUL terminated string; NULL stays NULL */
+const char* StringPool_get(const char* str);
+
+/* Returns a new reference to an interned entry, NULL is passed through */
+const void* StringPool_ref(const void* interned);
+
+/* Drops a reference of an interned entry, NULL is ignored */
+void StringPool_release(const void* interned);
+
+#endif
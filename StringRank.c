@@ -0,0 +1,148 @@
+/*
+htop - StringRank.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "StringRank.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "XUtils.h"
+
+
+/* Strings interned at most, all are forgotten when more come in */
+#define STRINGRANK_MAX 65536
+
+typedef struct StringRankEntry_ {
+   uint64_t rank;
+   uint32_t hash;
+   char str[];
+} StringRankEntry;
+
+/* the entries in strcmp() order, and an open addressed index of them by hash */
+static StringRankEntry** sorted;
+static size_t count;
+static size_t sortedAlloc;
+static StringRankEntry** slots;
+static size_t slotCount;
+static unsigned int generation;
+
+static uint32_t StringRank_hash(const char* str) {
+   /* FNV-1a */
+   uint32_t hash = 2166136261U;
+   for (; *str; str++) {
+      hash ^= (unsigned char)*str;
+      hash *= 16777619U;
+   }
+   return hash;
+}
+
+static StringRankEntry* StringRank_find(const char* str, uint32_t hash) {
+   if (!slotCount)
+      return NULL;
+
+   for (size_t i = hash & (slotCount - 1); slots[i]; i = (i + 1) & (slotCount - 1)) {
+      if (slots[i]->hash == hash && String_eq(slots[i]->str, str))
+         return slots[i];
+   }
+   return NULL;
+}
+
+static void StringRank_place(StringRankEntry* entry) {
+   size_t i = entry->hash & (slotCount - 1);
+   while (slots[i])
+      i = (i + 1) & (slotCount - 1);
+   slots[i] = entry;
+}
+
+/* Keeps the index at most half full */
+static void StringRank_index(StringRankEntry* entry) {
+   if (2 * count <= slotCount) {
+      StringRank_place(entry);
+      return;
+   }
+
+   free(slots);
+   slotCount = slotCount ? 2 * slotCount : 64;
+   slots = xCalloc(slotCount, sizeof(StringRankEntry*));
+   for (size_t i = 0; i < count; i++)
+      StringRank_place(sorted[i]);
+}
+
+/* Spreads the ranks evenly, leaving gaps for the strings to come */
+static void StringRank_renumber(void) {
+   const uint64_t step = UINT64_MAX / (count + 1);
+   for (size_t i = 0; i < count; i++)
+      sorted[i]->rank = step * (i + 1);
+   generation++;
+}
+
+uint64_t StringRank_of(const char* str) {
+   if (!str)
+      str = "";
+
+   const uint32_t hash = StringRank_hash(str);
+   const StringRankEntry* found = StringRank_find(str, hash);
+   if (found)
+      return found->rank;
+
+   if (count >= STRINGRANK_MAX)
+      StringRank_clear();
+
+   size_t lo = 0;
+   size_t hi = count;
+   while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (strcmp(sorted[mid]->str, str) < 0) {
+         lo = mid + 1;
+      } else {
+         hi = mid;
+      }
+   }
+
+   const size_t len = strlen(str);
+   StringRankEntry* entry = xMalloc(sizeof(StringRankEntry) + len + 1);
+   memcpy(entry->str, str, len + 1);
+   entry->hash = hash;
+
+   if (count == sortedAlloc) {
+      sortedAlloc = sortedAlloc ? 2 * sortedAlloc : 64;
+      sorted = xReallocArray(sorted, sortedAlloc, sizeof(StringRankEntry*));
+   }
+   memmove(&sorted[lo + 1], &sorted[lo], (count - lo) * sizeof(StringRankEntry*));
+   sorted[lo] = entry;
+   count++;
+   StringRank_index(entry);
+
+   const uint64_t lower = lo > 0 ? sorted[lo - 1]->rank : 0;
+   const uint64_t upper = lo + 1 < count ? sorted[lo + 1]->rank : UINT64_MAX;
+   if (upper - lower >= 2) {
+      entry->rank = lower + (upper - lower) / 2;
+   } else {
+      StringRank_renumber();
+   }
+
+   return entry->rank;
+}
+
+unsigned int StringRank_generation(void) {
+   return generation;
+}
+
+void StringRank_clear(void) {
+   for (size_t i = 0; i < count; i++)
+      free(sorted[i]);
+   free(sorted);
+   free(slots);
+   sorted = NULL;
+   slots = NULL;
+   count = 0;
+   sortedAlloc = 0;
+   slotCount = 0;
+   generation++;
+}
@@ -0,0 +1,32 @@
+#ifndef HEADER_StringRank
+#define HEADER_StringRank
+/*
+htop - StringRank.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdint.h>
+
+
+/*
+ * Strings of few distinct values (users, ttys, cgroups) are interned and
+ * ranked in the order strcmp() gives them, the collation htop sorts in, so
+ * a sort by them compares integers instead of strings.
+ *
+ * New strings get a rank in the gap between their neighbours; only when
+ * there is none left are all of them renumbered, which changes the
+ * generation. Ranks of different generations must not be compared.
+ */
+
+/* The rank of a string, NULL ranking as "" */
+uint64_t StringRank_of(const char* str);
+
+/* Changes whenever ranks taken before are no longer valid */
+unsigned int StringRank_generation(void);
+
+/* Forgets all strings */
+void StringRank_clear(void);
+
+#endif
@@ -11,34 +11,78 @@ in the source distribution for its full text.
 #include "Table.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "CRT.h"
 #include "Hashtable.h"
 #include "Machine.h"
 #include "Macros.h"
 #include "Panel.h"
+#include "Profile.h"
 #include "RowField.h"
+#include "StringRank.h"
 #include "Vector.h"
 
 
 Table* Table_init(Table* this, const ObjectClass* klass, Machine* host) {
    this->rows = Vector_new(klass, true, DEFAULT_SIZE);
    this->displayList = Vector_new(klass, false, DEFAULT_SIZE);
+   this->panelRows = Vector_new(klass, false, DEFAULT_SIZE);
+   this->treeRoots = Vector_new(klass, false, DEFAULT_SIZE);
    this->table = Hashtable_new(200, false);
    this->needsSort = true;
    this->following = -1;
+   this->changeGeneration = 1;
    this->host = host;
    return this;
 }
 
 void Table_done(Table* this) {
-   Hashtable_delete(this->table);
+   for (int i = 0; i < Vector_size(this->rows); i++) {
+      Row* row = (Row*) Vector_get(this->rows, i);
+      if (row->treeChildren)
+         Vector_delete(row->treeChildren);
+   }
+
+   FilterMatcher_done(&this->filter);
+   for (size_t i = 0; i < this->treeStackAlloc; i++) {
+      if (this->treeMatched[i])
+         Vector_delete(this->treeMatched[i]);
+   }
+   free(this->treeMatched);
+   free(this->treeStack);
+   free(this->sortKeys);
+   free(this->sortValues);
+   if (this->index)
+      SparseArray_delete(this->index);
+   else
+      Hashtable_delete(this->table);
+   Vector_delete(this->treeRoots);
+   Vector_delete(this->panelRows);
    Vector_delete(this->displayList);
    Vector_delete(this->rows);
 }
 
+void Table_useDirectIndex(Table* this) {
+   assert(Vector_size(this->rows) == 0);
+
+   if (this->index)
+      return;
+
+   Hashtable_delete(this->table);
+   this->table = NULL;
+   this->index = SparseArray_new();
+}
+
+#ifndef NDEBUG
+static size_t Table_countIndexed(const Table* this) {
+   return this->index ? SparseArray_count(this->index) : Hashtable_count(this->table);
+}
+#endif
+
 static void Table_delete(Object* cast) {
    Table* this = (Table*) cast;
    Table_done(this);
@@ -49,19 +93,63 @@ void Table_setPanel(Table* this, Panel* panel) {
    this->panel = panel;
 }
 
+// Appends row to the children of parent, or to the roots if parent is NULL
+/* Adds delta to the descendants counted by row and its ancestors; a parent loop ends the walk */
+static void Table_countDescendants(const Table* this, Row* row, int delta) {
+   /* rows are soft removed while the table is cleaned up, count them all the same */
+   for (int steps = this->rows->items; row && steps > 0; row = row->treeParent, steps--)
+      row->treeDescendants += delta;
+}
+
+static void Table_linkRow(Table* this, Row* row, Row* parent) {
+   Vector* siblings = this->treeRoots;
+   if (parent) {
+      if (!parent->treeChildren)
+         parent->treeChildren = Vector_new(Vector_type(this->rows), false, DEFAULT_SIZE);
+      siblings = parent->treeChildren;
+   }
+
+   row->treeParent = parent;
+   row->treeIndex = Vector_size(siblings);
+   Vector_add(siblings, row);
+   Table_countDescendants(this, parent, 1 + row->treeDescendants);
+}
+
+// Detaches row from its siblings; their order is restored by the next Table_buildTree
+static void Table_unlinkRow(Table* this, Row* row) {
+   Vector* siblings = row->treeParent ? row->treeParent->treeChildren : this->treeRoots;
+   int last = Vector_size(siblings) - 1;
+
+   assert((Row*)Vector_get(siblings, row->treeIndex) == row);
+
+   if (row->treeIndex != last) {
+      Row* moved = (Row*)Vector_get(siblings, last);
+      Vector_set(siblings, row->treeIndex, moved);
+      moved->treeIndex = row->treeIndex;
+   }
+   Vector_take(siblings, last);
+
+   Table_countDescendants(this, row->treeParent, -(1 + row->treeDescendants));
+   row->treeParent = NULL;
+}
+
 void Table_add(Table* this, Row* row) {
    assert(Vector_indexOf(this->rows, row, Row_idEqualCompare) == -1);
-   assert(Hashtable_get(this->table, row->id) == NULL);
+   assert(Table_findRow(this, row->id) == NULL);
 
    // highlighting row found in first scan by first scan marked "far in the past"
    row->seenStampMs = this->host->monotonicMs;
 
    Vector_add(this->rows, row);
-   Hashtable_put(this->table, row->id, row);
+   Table_linkRow(this, row, NULL);
+   if (this->index)
+      SparseArray_put(this->index, row->id, row);
+   else
+      Hashtable_put(this->table, row->id, row);
 
    assert(Vector_indexOf(this->rows, row, Row_idEqualCompare) != -1);
-   assert(Hashtable_get(this->table, row->id) != NULL);
-   assert(Vector_countEquals(this->rows, Hashtable_count(this->table)));
+   assert(Table_findRow(this, row->id) != NULL);
+   assert(Vector_countEquals(this->rows, Table_countIndexed(this)));
 }
 
 // Table_removeIndex removes a given row from the lists map and soft deletes
@@ -73,9 +161,22 @@ void Table_removeIndex(Table* this, const Row* row, int idx) {
    int rowid = row->id;
 
    assert(row == (Row*)Vector_get(this->rows, idx));
-   assert(Hashtable_get(this->table, rowid) != NULL);
+   assert(Table_findRow(this, rowid) != NULL);
+
+   // Orphaned children stay roots until their parent is known again
+   Row* removed = (Row*)Vector_get(this->rows, idx);
+   Table_unlinkRow(this, removed);
+   if (removed->treeChildren) {
+      for (int i = 0; i < Vector_size(removed->treeChildren); i++)
+         Table_linkRow(this, (Row*)Vector_get(removed->treeChildren, i), NULL);
+      Vector_delete(removed->treeChildren);
+      removed->treeChildren = NULL;
+   }
 
-   Hashtable_remove(this->table, rowid);
+   if (this->index)
+      SparseArray_remove(this->index, rowid);
+   else
+      Hashtable_remove(this->table, rowid);
    Vector_softRemove(this->rows, idx);
 
    if (this->following != -1 && this->following == rowid) {
@@ -83,129 +184,472 @@ void Table_removeIndex(Table* this, const Row* row, int idx) {
       Panel_setSelectionColor(this->panel, PANEL_SELECTION_FOCUS);
    }
 
-   assert(Hashtable_get(this->table, rowid) == NULL);
-   assert(Vector_countEquals(this->rows, Hashtable_count(this->table)));
+   assert(Table_findRow(this, rowid) == NULL);
+   assert(Vector_countEquals(this->rows, Table_countIndexed(this)));
 }
 
-static void Table_buildTreeBranch(Table* this, int rowid, unsigned int level, int32_t indent, bool show) {
-   // Do not treat zero as root of any tree.
-   // (e.g. on OpenBSD the kernel thread 'swapper' has pid 0.)
-   if (rowid == 0)
-      return;
+static int compareRowByKnownParentThenNatural(const void* v1, const void* v2) {
+   return Row_compareByParent((const Row*) v1, (const Row*) v2);
+}
 
-   // The vector is sorted by parent, find the start of the range by bisection
-   int vsize = Vector_size(this->rows);
-   int l = 0;
-   int r = vsize;
-   while (l < r) {
-      int c = (l + r) / 2;
-      Row* row = (Row*)Vector_get(this->rows, c);
-      int parent = row->isRoot ? 0 : Row_getGroupOrParent(row);
-      if (parent < rowid) {
-         l = c + 1;
-      } else {
-         r = c;
-      }
+/* One level of the tree walk in Table_buildTree */
+typedef struct TableTreeFrame_ {
+   Vector* children;
+   int next;
+   int lastShown;
+   unsigned int level;
+} TableTreeFrame;
+
+// Sorts siblings, which mostly are in order from the previous cycle already
+static void Table_sortSiblings(Vector* siblings) {
+   Vector_sortCustomCompare(siblings, compareRowByKnownParentThenNatural);
+
+   for (int i = 0; i < Vector_size(siblings); i++)
+      ((Row*)Vector_get(siblings, i))->treeIndex = i;
+}
+
+/* The children of a filtered tree that were stamped by Table_markMatches, in order */
+static Vector* Table_matchedChildren(Table* this, size_t depth, const Vector* children) {
+   if (!this->treeMatched[depth])
+      this->treeMatched[depth] = Vector_new(Vector_type(children), false, DEFAULT_SIZE);
+
+   Vector* matched = this->treeMatched[depth];
+   Vector_prune(matched);
+   for (int i = 0; i < Vector_size(children); i++) {
+      Row* row = (Row*)Vector_get(children, i);
+      if (row->treeMatch == this->treeMatch)
+         Vector_add(matched, row);
    }
-   // Find the end to know the last line for indent handling purposes
-   int lastShown = r;
-   while (r < vsize) {
-      Row* row = (Row*)Vector_get(this->rows, r);
-      if (!Row_isChildOf(row, rowid))
-         break;
-      if (row->show)
-         lastShown = r;
-      r++;
+
+   // The siblings themselves keep their order, which Table_unlinkRow relies on
+   Vector_sortCustomCompare(matched, compareRowByKnownParentThenNatural);
+   return matched;
+}
+
+static void Table_pushTreeFrame(Table* this, size_t depth, Vector* children, unsigned int level) {
+   if (depth == this->treeStackAlloc) {
+      size_t alloc = this->treeStackAlloc ? this->treeStackAlloc * 2 : 32;
+      this->treeStack = xReallocArray(this->treeStack, alloc, sizeof(TableTreeFrame));
+      this->treeMatched = xReallocArray(this->treeMatched, alloc, sizeof(Vector*));
+      memset(this->treeMatched + this->treeStackAlloc, 0, (alloc - this->treeStackAlloc) * sizeof(Vector*));
+      this->treeStackAlloc = alloc;
    }
 
-   for (int i = l; i < r; i++) {
-      Row* row = (Row*)Vector_get(this->rows, i);
+   if (this->treeFiltered)
+      children = Table_matchedChildren(this, depth, children);
+   else
+      Table_sortSiblings(children);
+
+   // Find the last line for drawing the tree lines
+   int lastShown = 0;
+   for (int i = 0; i < Vector_size(children); i++) {
+      if (((const Row*)Vector_get(children, i))->show)
+         lastShown = i;
+   }
 
-      if (!show)
-         row->show = false;
+   this->treeStack[depth] = (TableTreeFrame) {
+      .children = children,
+      .next = 0,
+      .lastShown = lastShown,
+      .level = level,
+   };
+}
+
+/*
+ * Emits the descendants of a root in display order. Collapsed branches and
+ * the ones below hidden rows are not descended into at all; returns the
+ * number of rows left out that way.
+ */
+static int Table_buildTreeBranch(Table* this, Row* root) {
+   // Do not treat zero as root of any tree.
+   // (e.g. on OpenBSD the kernel thread 'swapper' has pid 0.)
+   if (root->id == 0 || !root->treeChildren || Vector_size(root->treeChildren) == 0)
+      return 0;
+
+   if (!root->showChildren)
+      return root->treeDescendants;
+
+   int skipped = 0;
+   size_t depth = 0;
+   Table_pushTreeFrame(this, depth++, root->treeChildren, 0);
+
+   while (depth > 0) {
+      TableTreeFrame* frame = &this->treeStack[depth - 1];
+      if (frame->next == Vector_size(frame->children)) {
+         depth--;
+         continue;
+      }
+
+      int i = frame->next++;
+      Row* row = (Row*)Vector_get(frame->children, i);
 
       Vector_add(this->displayList, row);
 
-      int32_t nextIndent = indent | ((int32_t)1 << MINIMUM(level, sizeof(row->indent) * 8 - 2));
-      Table_buildTreeBranch(this, row->id, level + 1, (i < lastShown) ? nextIndent : indent, row->show && row->showChildren);
-      if (i == lastShown)
-         row->indent = -nextIndent;
-      else
-         row->indent = nextIndent;
+      // Rows after the last shown one are hidden and draw no line to their descendants
+      row->treeLast = i >= frame->lastShown;
+      row->tree_depth = frame->level + 1;
 
-      row->tree_depth = level + 1;
+      if (row->id == 0 || !row->treeChildren || Vector_size(row->treeChildren) == 0)
+         continue;
+
+      if (row->show && row->showChildren)
+         Table_pushTreeFrame(this, depth++, row->treeChildren, frame->level + 1);
+      else
+         skipped += row->treeDescendants;
    }
+
+   return skipped;
 }
 
-static int compareRowByKnownParentThenNatural(const void* v1, const void* v2) {
-   return Row_compareByParent((const Row*) v1, (const Row*) v2);
+/*
+ * Stamps the rows the filter leaves and their ancestors, walking up from
+ * each of them only until a row stamped already.
+ */
+static void Table_markMatches(Table* this) {
+   if (++this->treeMatch == 0)
+      this->treeMatch = 1;
+
+   int vsize = Vector_size(this->rows);
+   for (int i = 0; i < vsize; i++) {
+      Row* row = (Row*) Vector_get(this->rows, i);
+      if (!row->show || Row_matchesFilter(row, this))
+         continue;
+
+      for (Row* up = row; up && up->treeMatch != this->treeMatch; up = up->treeParent)
+         up->treeMatch = this->treeMatch;
+   }
 }
 
-// Builds a sorted tree from scratch, without relying on previously gathered information
+/*
+ * The parent links survive between cycles, so only rows that appeared or
+ * changed their parent are moved before the tree is walked. Siblings keep
+ * their order from the previous cycle, which makes sorting them cheap.
+ *
+ * While a filter leaves rows out, the walk only descends to the rows it
+ * leaves and their ancestors, so its cost follows the number of matches
+ * rather than the size of the tree.
+ */
 static void Table_buildTree(Table* this) {
    Vector_prune(this->displayList);
 
-   // Mark root processes
+   // Relink rows whose known parent changed
    int vsize = Vector_size(this->rows);
    for (int i = 0; i < vsize; i++) {
       Row* row = (Row*) Vector_get(this->rows, i);
-      int parent = Row_getGroupOrParent(row);
-      row->isRoot = false;
+      int parentId = Row_getGroupOrParent(row);
 
-      if (row->id == parent) {
-         row->isRoot = true;
-         continue;
+      // We don't know about its parent for whatever reason
+      Row* parent = NULL;
+      if (parentId && parentId != row->id)
+         parent = Table_findRow(this, parentId);
+
+      if (parent != row->treeParent) {
+         Table_unlinkRow(this, row);
+         Table_linkRow(this, row, parent);
       }
 
-      if (!parent) {
-         row->isRoot = true;
+      row->isRoot = !parent;
+   }
+
+   this->treeFiltered = !FilterMatcher_matchesAny(&this->filter);
+   if (this->treeFiltered)
+      Table_markMatches(this);
+
+   Table_sortSiblings(this->treeRoots);
+
+   int skipped = 0;
+   int rootCount = Vector_size(this->treeRoots);
+   for (int i = 0; i < rootCount; i++) {
+      Row* row = (Row*)Vector_get(this->treeRoots, i);
+      if (this->treeFiltered && row->treeMatch != this->treeMatch)
          continue;
+
+      row->treeLast = false;
+      row->tree_depth = 0;
+      Vector_add(this->displayList, row);
+      skipped += Table_buildTreeBranch(this, row);
+   }
+
+   this->needsSort = false;
+
+   // Check consistency of the built structures
+   assert(this->treeFiltered || Vector_size(this->displayList) + skipped == vsize); (void)vsize; (void)skipped;
+}
+
+/* Below this many rows extracting keys does not pay off */
+#define TABLE_RADIX_SORT_MIN_ROWS 256
+
+/* Below this many rows the flat view is always sorted completely */
+#define TABLE_PARTIAL_SORT_MIN_ROWS 2048
+
+/* Rows sorted past the end of the screen, to scroll a bit without sorting again */
+#define TABLE_PARTIAL_SORT_MARGIN 128
+
+/* Below this many rows the keys are sorted on the calling thread only */
+#define TABLE_PARALLEL_SORT_MIN_ROWS 32768
+
+/* The active sort key and those breaking its ties */
+#define TABLE_SORT_KEYS (1 + SCREEN_THEN_SORT_KEYS)
+
+/* Room for the keys of n rows and as many for the radix sort to move them to */
+static void Table_reserveSortKeys(Table* this, int n) {
+   if (this->sortKeysAlloc < 2 * (size_t)n) {
+      this->sortKeysAlloc = 2 * (size_t)n + 2 * TABLE_RADIX_SORT_MIN_ROWS;
+      free(this->sortKeys);
+      this->sortKeys = xMallocArray(this->sortKeysAlloc, sizeof(VectorSortKey));
+   }
+}
+
+static inline void Table_setSortKey(VectorSortKey* key, Row* row, uint64_t value, uint32_t tieBreak) {
+   key->value = value;
+   key->tieBreak = tieBreak;
+   key->item = &row->super;
+}
+
+static inline bool Table_sortsInParallel(const Table* this, int n) {
+   return this->sortRunner && n >= TABLE_PARALLEL_SORT_MIN_ROWS;
+}
+
+/* Sorts the rows by their n keys, returns where the sorted keys are */
+static const VectorSortKey* Table_radixSort(Table* this, VectorSortKey* keys, int n) {
+   if (Table_sortsInParallel(this, n))
+      return Vector_parallelRadixSort(this->rows, keys, keys + n, this->sortRunner);
+
+   return Vector_radixSort(this->rows, keys, keys + n);
+}
+
+/* flipping the sign bit keeps negative ids in order */
+static inline uint32_t Table_idTieBreak(const Row* row) {
+   return (uint32_t)row->id ^ UINT32_C(0x80000000);
+}
+
+/*
+ * Sorts by several keys, all of them encoded exactly. Each is extracted
+ * once per row; when their values, less the smallest of each, fit into 64
+ * bits together they are packed into one composite key, sorted like a
+ * single one. Otherwise the rows are radix sorted once per key, the least
+ * significant first, each pass keeping the order of the previous one among
+ * equal values. False if a key has no exact encoding.
+ */
+static bool Table_sortRowsByKeys(Table* this, const RowField* fields, const bool* desc, int count, int limit, bool partial) {
+   Vector* rows = this->rows;
+   const int n = Vector_size(rows);
+
+   uint64_t value;
+   for (int j = 0; j < count; j++) {
+      if (Row_sortKeyByField((const Row*)Vector_get(rows, 0), fields[j], &value) != ROW_SORTKEY_EXACT)
+         return false;
+   }
+
+   Table_reserveSortKeys(this, n);
+   if (this->sortValuesAlloc < (size_t)count * n) {
+      this->sortValuesAlloc = (size_t)count * n + TABLE_SORT_KEYS * TABLE_RADIX_SORT_MIN_ROWS;
+      free(this->sortValues);
+      this->sortValues = xMallocArray(this->sortValuesAlloc, sizeof(uint64_t));
+   }
+
+   uint64_t* values = this->sortValues;
+   uint64_t minimum[TABLE_SORT_KEYS];
+   unsigned int bits[TABLE_SORT_KEYS];
+   unsigned int totalBits = 0;
+   for (int attempt = 0; ; attempt++) {
+      const unsigned int generation = StringRank_generation();
+      totalBits = 0;
+      for (int j = 0; j < count; j++) {
+         uint64_t* column = &values[(size_t)j * n];
+         uint64_t low = UINT64_MAX;
+         uint64_t high = 0;
+         for (int i = 0; i < n; i++) {
+            RowSortKeyKind kind = Row_sortKeyByField((const Row*)Vector_get(rows, i), fields[j], &value);
+            assert(kind == ROW_SORTKEY_EXACT); (void)kind;
+
+            value = desc[j] ? ~value : value;
+            column[i] = value;
+            low = MINIMUM(low, value);
+            high = MAXIMUM(high, value);
+         }
+
+         minimum[j] = low;
+         bits[j] = 0;
+         for (uint64_t span = high - low; span; span >>= 1)
+            bits[j]++;
+         totalBits += bits[j];
       }
 
-      // We don't know about its parent for whatever reason
-      if (Table_findRow(this, parent) == NULL)
-         row->isRoot = true;
+      if (generation == StringRank_generation())
+         break;
+
+      if (attempt > 0)
+         return false;
    }
 
-   // Sort by known parent (roots first), then row ID
-   Vector_quickSortCustomCompare(this->rows, compareRowByKnownParentThenNatural);
+   VectorSortKey* keys = this->sortKeys;
+   if (totalBits <= 64) {
+      for (int i = 0; i < n; i++) {
+         Row* row = (Row*)Vector_get(rows, i);
+         uint64_t composite = 0;
+         for (int j = 0; j < count; j++) {
+            const uint64_t offset = values[(size_t)j * n + i] - minimum[j];
+            composite = bits[j] < 64 ? (composite << bits[j]) | offset : offset;
+         }
+         Table_setSortKey(&keys[i], row, composite, Table_idTieBreak(row));
+      }
 
-   // Find all processes whose parent is not visible
-   for (int i = 0; i < vsize; i++) {
-      Row* row = (Row*)Vector_get(this->rows, i);
-
-      // If parent not found, then construct the tree with this node as root
-      if (row->isRoot) {
-         row = (Row*)Vector_get(this->rows, i);
-         row->indent = 0;
-         row->tree_depth = 0;
-         Vector_add(this->displayList, row);
-         Table_buildTreeBranch(this, row->id, 0, 0, row->showChildren);
+      if (partial)
+         Vector_partialKeySort(rows, keys, limit);
+      else
+         Table_radixSort(this, keys, n);
+      return true;
+   }
+
+   /* the passes reorder the rows, so the keys are taken again in the current order; no new strings turn up */
+   this->sortedRows = n;
+   for (int j = count - 1; j >= 0; j--) {
+      for (int i = 0; i < n; i++) {
+         Row* row = (Row*)Vector_get(rows, i);
+         Row_sortKeyByField(row, fields[j], &value);
+         Table_setSortKey(&keys[i], row, desc[j] ? ~value : value, j == count - 1 ? Table_idTieBreak(row) : (uint32_t)i);
+      }
+      Table_radixSort(this, keys, n);
+   }
+
+   return true;
+}
+
+/*
+ * Rows whose class can encode the sort key get it extracted once into a
+ * contiguous array, which is radix sorted instead of calling the comparator
+ * O(n log n) times on scattered rows. Keys encoding only a prefix, like
+ * strings, are radix sorted by the prefix and compared fully only within
+ * runs of equal prefixes.
+ *
+ * When no more than `limit` rows are looked at, only the smallest ones are
+ * selected and sorted, leaving the rest in no particular order behind them.
+ */
+static void Table_sortRows(Table* this, int limit) {
+   Vector* rows = this->rows;
+   const int n = Vector_size(rows);
+   const bool partial = n >= TABLE_PARTIAL_SORT_MIN_ROWS && limit < n / 4;
+   this->sortedRows = partial ? limit : n;
+
+   /* the keys breaking ties, in their default directions */
+   const ScreenSettings* ss = this->host->settings->ss;
+   const RowField active = ScreenSettings_getActiveSortKey(ss);
+   RowField fields[TABLE_SORT_KEYS] = { active };
+   bool desc[TABLE_SORT_KEYS] = { ScreenSettings_getActiveDirection(ss) != 1 };
+   int count = 1;
+   for (const RowField* then = ss->thenSortKeys; *then; then++) {
+      if (*then == active)
          continue;
+
+      fields[count] = *then;
+      desc[count] = ScreenSettings_isSortDescByDefault(*then);
+      count++;
+   }
+
+   uint64_t value;
+   RowSortKeyKind kind = n >= TABLE_RADIX_SORT_MIN_ROWS ? Row_sortKey((const Row*)Vector_get(rows, 0), &value) : ROW_SORTKEY_NONE;
+   if (count > 1 && kind != ROW_SORTKEY_NONE && Table_sortRowsByKeys(this, fields, desc, count, limit, partial))
+      return;
+
+   if (kind == ROW_SORTKEY_NONE || count > 1 || (partial && kind == ROW_SORTKEY_PREFIX)) {
+      if (partial)
+         Vector_partialSortCustomCompare(rows, limit, Vector_type(rows)->compare);
+      else
+         Vector_sort(rows);
+      return;
+   }
+
+   Table_reserveSortKeys(this, n);
+
+   /* ties of prefixes are left to the comparator, but split evenly across the jobs of a parallel sort by id */
+   const bool idTieBreak = kind == ROW_SORTKEY_EXACT || (!partial && Table_sortsInParallel(this, n));
+
+   /* string ranks taken early in the pass are stale if later strings renumbered them */
+   VectorSortKey* keys = this->sortKeys;
+   for (int attempt = 0; ; attempt++) {
+      const unsigned int generation = StringRank_generation();
+      for (int i = 0; i < n; i++) {
+         Row* row = (Row*)Vector_get(rows, i);
+         RowSortKeyKind rowKind = Row_sortKey(row, &value);
+         assert(rowKind == kind); (void)rowKind;
+
+         Table_setSortKey(&keys[i], row, value, idTieBreak ? Table_idTieBreak(row) : 0);
+      }
+
+      if (generation == StringRank_generation())
+         break;
+
+      /* more distinct strings than are interned at once */
+      if (attempt > 0) {
+         if (partial)
+            Vector_partialSortCustomCompare(rows, limit, Vector_type(rows)->compare);
+         else
+            Vector_sort(rows);
+         return;
       }
    }
 
-   this->needsSort = false;
+   if (partial) {
+      Vector_partialKeySort(rows, keys, limit);
+      return;
+   }
 
-   // Check consistency of the built structures
-   assert(Vector_size(this->displayList) == vsize); (void)vsize;
+   const VectorSortKey* sorted = Table_radixSort(this, keys, n);
+
+   if (kind != ROW_SORTKEY_PREFIX)
+      return;
+
+   for (int start = 0; start < n; ) {
+      int end = start + 1;
+      while (end < n && sorted[end].value == sorted[start].value)
+         end++;
+
+      if (end - start > 1)
+         Vector_sortRangeCustomCompare(rows, start, end, Vector_type(rows)->compare);
+
+      start = end;
+   }
 }
 
-void Table_updateDisplayList(Table* this) {
+/* The display list with at least the first `sortLimit` rows of a flat view in order */
+static void Table_updateDisplayListUpTo(Table* this, int sortLimit) {
    const Settings* settings = this->host->settings;
+   const ProfileMark mark = Profile_begin();
+
+   /* the filter text is edited in place, recompile it when it changed */
+   FilterMatcher_update(&this->filter, this->incFilter);
 
    if (settings->ss->treeView) {
-      if (this->needsSort)
+      /* a filtered tree holds the rows of the filter when it was built, which changes as the rows do */
+      if (this->needsSort || this->treeFiltered || !FilterMatcher_matchesAny(&this->filter))
          Table_buildTree(this);
+      this->sortedRows = Vector_size(this->rows);
    } else {
       if (this->needsSort)
-         Vector_insertionSort(this->rows);
+         Table_sortRows(this, sortLimit);
       Vector_prune(this->displayList);
       int size = Vector_size(this->rows);
       for (int i = 0; i < size; i++)
          Vector_add(this->displayList, Vector_get(this->rows, i));
    }
    this->needsSort = false;
+
+   Profile_end(PROFILE_DISPLAY_LIST, mark);
+}
+
+void Table_updateDisplayList(Table* this) {
+   Table_updateDisplayListUpTo(this, INT_MAX);
+}
+
+/* Panel items up to the end of the screen or the selection, whichever is further down */
+static int Table_panelItemsNeeded(const Panel* panel) {
+   return MAXIMUM(panel->scrollV, Panel_getSelectedIndex(panel)) + panel->h + 1;
+}
+
+/* Whether the items the panel shows are all from the part of the rows sorted last */
+static bool Table_panelSorted(const Table* this) {
+   return this->sortedRows >= Vector_size(this->rows) || this->sortedItems >= Table_panelItemsNeeded(this->panel);
 }
 
 void Table_expandTree(Table* this) {
@@ -218,94 +662,206 @@ void Table_expandTree(Table* this) {
 
 // Called on collapse-all toggle and on startup, possibly in non-tree mode
 void Table_collapseAllBranches(Table* this) {
-   Table_buildTree(this); // Update `tree_depth` fields of the rows
-   this->needsSort = true; // Table is sorted by parent now, force new sort
+   Table_buildTree(this); // Update the parent links of the rows
+   this->needsSort = true; // Display list is in tree order now, force new sort
    int size = Vector_size(this->rows);
    for (int i = 0; i < size; i++) {
       Row* row = (Row*) Vector_get(this->rows, i);
-      // FreeBSD has pid 0 = kernel and pid 1 = init, so init has tree_depth = 1
-      if (row->tree_depth > 0 && row->id > 1)
+      // FreeBSD has pid 0 = kernel and pid 1 = init, so init has a parent
+      if (row->treeParent && row->id > 1)
          row->showChildren = false;
    }
 }
 
-void Table_rebuildPanel(Table* this) {
-   Table_updateDisplayList(this);
+void Table_markRowsChanged(Table* this) {
+   if (++this->changeGeneration == 0)
+      this->changeGeneration = 1;
+}
 
-   const int currPos = Panel_getSelectedIndex(this->panel);
-   const int currScrollV = this->panel->scrollV;
-   const int currSize = Panel_size(this->panel);
+/* The panel reads the shown rows straight from the table, see Table_rebuildPanel */
+static int Table_panelCount(const void* data) {
+   const Table* this = data;
+   return Vector_size(this->panelFiltered ? this->panelRows : this->displayList);
+}
 
-   Panel_prune(this->panel);
+static Object* Table_panelGet(const void* data, int i) {
+   const Table* this = data;
+   return Vector_get(this->panelFiltered ? this->panelRows : this->displayList, i);
+}
 
-   /* Follow main group row instead if following a row that is occluded (hidden) */
-   if (this->following != -1) {
-      const Row* followed = (const Row*) Hashtable_get(this->table, this->following);
-      if (followed != NULL
-         && Hashtable_get(this->table, followed->group)
-         && Row_isVisible(followed, this) == false ) {
-         this->following = followed->group;
+/*
+ * Brings the panel in line with the display list. The panel is not given a
+ * copy of the rows: it shows the display list itself, or the rows of it that
+ * are shown when some are hidden or filtered out. Only the items on screen
+ * that moved since the last rebuild are repainted, all of them when the rows
+ * changed. When neither the rows nor their order changed, the panel is left
+ * alone without filtering again.
+ */
+void Table_rebuildPanel(Table* this) {
+   const ProfileMark mark = Profile_begin();
+   Panel* panel = this->panel;
+   /* the screens share the panel, it may have shown the rows of another table */
+   Panel_setSource(panel, Table_panelCount, Table_panelGet, this);
+   /* scrolled past the rows sorted last */
+   if (!Table_panelSorted(this))
+      this->needsSort = true;
+
+   const bool unchanged = !this->needsSort && this->panelChangeGeneration == this->changeGeneration;
+
+   const int currPos = Panel_getSelectedIndex(panel);
+   const int currScrollV = panel->scrollV;
+   const int currSize = Panel_size(panel);
+   const unsigned int lastBuild = this->panelBuild;
+
+   /* rows to sort for the items on screen, from the share of rows the panel showed last time */
+   const int rowCount = Vector_size(this->rows);
+   long long sortLimit = (long long)(Table_panelItemsNeeded(panel) + TABLE_PARTIAL_SORT_MARGIN) * rowCount / MAXIMUM(currSize, 1);
+
+   if (!unchanged) {
+rebuild:
+      Table_updateDisplayListUpTo(this, (int)MINIMUM(sortLimit, (long long)INT_MAX));
+
+      /* Follow main group row instead if following a row that is occluded (hidden) */
+      if (this->following != -1) {
+         const Row* followed = Table_findRow(this, this->following);
+         if (followed != NULL
+            && Table_findRow(this, followed->group)
+            && Row_isVisible(followed, this) == false ) {
+            this->following = followed->group;
+         }
       }
-   }
 
-   const int rowCount = Vector_size(this->displayList);
-   bool foundFollowed = false;
-   int idx = 0;
+      const int displayCount = Vector_size(this->displayList);
+      bool foundFollowed = false;
+      int idx = 0;
+
+      if (this->panelChangeGeneration != this->changeGeneration)
+         panel->needsRedraw = true;
+
+      if (++this->panelBuild == 0)
+         this->panelBuild = 1;
+
+      this->panelFiltered = false;
+      this->sortedItems = 0;
+      for (int i = 0; i < displayCount; i++) {
+         Row* row = (Row*) Vector_get(this->displayList, i);
+
+         if ( !row->show || (Row_matchesFilter(row, this) == true) ) {
+            /* the rows up to here are shown as they are, list them from now on */
+            if (!this->panelFiltered) {
+               Vector_prune(this->panelRows);
+               for (int j = 0; j < idx; j++)
+                  Vector_add(this->panelRows, Vector_get(this->displayList, j));
+               this->panelFiltered = true;
+            }
+            continue;
+         }
+
+         if (this->panelFiltered)
+            Vector_add(this->panelRows, row);
+
+         if (i < this->sortedRows)
+            this->sortedItems = idx + 1;
+
+         /* lines on screen showing another row than before */
+         if ((row->panelBuild != lastBuild || row->panelIndex != idx) && idx >= currScrollV && idx < currScrollV + panel->h)
+            Panel_markDirty(panel, idx);
+         row->panelBuild = this->panelBuild;
+         row->panelIndex = idx;
+
+         if (this->following != -1 && row->id == this->following) {
+            foundFollowed = true;
+            Panel_setSelected(panel, idx);
+            /* Keep scroll position relative to followed row */
+            panel->scrollV = idx - (currPos - currScrollV);
+         }
+         idx++;
+      }
 
-   for (int i = 0; i < rowCount; i++) {
-      Row* row = (Row*) Vector_get(this->displayList, i);
+      /* lines below the last item are cleared by a full redraw */
+      if (idx < currSize)
+         panel->needsRedraw = true;
 
-      if ( !row->show || (Row_matchesFilter(row, this) == true) )
-         continue;
+      /* too many rows were hidden, or the followed row is further down: sort all of them */
+      if (!Table_panelSorted(this)) {
+         this->needsSort = true;
+         sortLimit = INT_MAX;
+         goto rebuild;
+      }
 
-      Panel_set(this->panel, idx, (Object*)row);
+      this->panelChangeGeneration = this->changeGeneration;
 
-      if (this->following != -1 && row->id == this->following) {
-         foundFollowed = true;
-         Panel_setSelected(this->panel, idx);
-         /* Keep scroll position relative to followed row */
-         this->panel->scrollV = idx - (currPos - currScrollV);
+      if (this->following != -1 && !foundFollowed) {
+         /* Reset if current followed row not found */
+         this->following = -1;
+         Panel_setSelectionColor(panel, PANEL_SELECTION_FOCUS);
       }
-      idx++;
-   }
-
-   if (this->following != -1 && !foundFollowed) {
-      /* Reset if current followed row not found */
-      this->following = -1;
-      Panel_setSelectionColor(this->panel, PANEL_SELECTION_FOCUS);
    }
 
    if (this->following == -1) {
       /* If the last item was selected, keep the new last item selected */
       if (currPos > 0 && currPos == currSize - 1)
-         Panel_setSelected(this->panel, Panel_size(this->panel) - 1);
+         Panel_setSelected(panel, Panel_size(panel) - 1);
       else
-         Panel_setSelected(this->panel, currPos);
+         Panel_setSelected(panel, currPos);
+
+      panel->scrollV = currScrollV;
+   }
+
+   /* Replaced items are repainted on their own, a different scroll position needs all of them */
+   if (panel->scrollV != currScrollV)
+      panel->needsRedraw = true;
+
+   /* Remember the rows inside the scroll window for collectors that only care about those */
+   if (++this->panelGeneration == 0)
+      this->panelGeneration = 1;
+
+   const int first = MAXIMUM(panel->scrollV, 0);
+   const int last = MINIMUM(Panel_size(panel), first + panel->h);
+   for (int i = first; i < last; i++) {
+      Row* row = (Row*) Panel_get(panel, i);
+      row->panelGeneration = this->panelGeneration;
+   }
+
+   Row* selected = (Row*) Panel_getSelected(panel);
+   if (selected)
+      selected->panelGeneration = this->panelGeneration;
 
-      this->panel->scrollV = currScrollV;
+   if (this->following != -1) {
+      Row* followed = Table_findRow(this, this->following);
+      if (followed)
+         followed->panelGeneration = this->panelGeneration;
    }
+
+   Profile_end(PROFILE_REBUILD_PANEL, mark);
+}
+
+bool Table_isRowOnScreen(const Table* this, const Row* row) {
+   return this->panelGeneration != 0 && row->panelGeneration == this->panelGeneration;
 }
 
 void Table_printHeader(const Settings* settings, RichString* header) {
    RichString_rewind(header, RichString_size(header));
 
-   const ScreenSettings* ss = settings->ss;
-   const RowField* fields = ss->fields;
+   ScreenSettings* ss = settings->ss;
+   int count;
+   const ScreenColumn* columns = ScreenSettings_getColumns(ss, settings->dynamicColumns, &count);
 
    RowField key = ScreenSettings_getActiveSortKey(ss);
 
-   for (int i = 0; fields[i]; i++) {
+   for (int i = 0; i < count; i++) {
+      const RowField field = columns[i].field;
       int color;
       if (ss->treeView && ss->treeViewAlwaysByPID) {
          color = CRT_colors[PANEL_HEADER_FOCUS];
-      } else if (key == fields[i]) {
+      } else if (key == field) {
          color = CRT_colors[PANEL_SELECTION_FOCUS];
       } else {
          color = CRT_colors[PANEL_HEADER_FOCUS];
       }
 
-      RichString_appendWide(header, color, RowField_alignedTitle(settings, fields[i]));
-      if (key == fields[i] && RichString_getCharVal(*header, RichString_size(header) - 1) == ' ') {
+      RichString_appendWide(header, color, RowField_columnTitle(&columns[i]));
+      if (key == field && RichString_getCharVal(*header, RichString_size(header) - 1) == ' ') {
          bool ascending = ScreenSettings_getActiveDirection(ss) == 1;
          RichString_rewind(header, 1);  // rewind to override space
          RichString_appendnWide(header,
@@ -313,20 +869,23 @@ void Table_printHeader(const Settings* settings, RichString* header) {
                                 CRT_treeStr[ascending ? TREE_STR_ASC : TREE_STR_DESC],
                                 1);
       }
-      if (COMM == fields[i] && settings->showMergedCommand) {
+      if (COMM == field && settings->showMergedCommand) {
          RichString_appendAscii(header, color, "(merged)");
       }
    }
 }
 
 // set flags on an existing rows before refreshing table
+/*
+ * Rows are not visited: the ones the scan does not stamp went away. Each
+ * scan sets whether the rows it finds are shown, until then the rows keep
+ * the state they were last displayed with.
+ */
 void Table_prepareEntries(Table* this) {
-   for (int i = 0; i < Vector_size(this->rows); i++) {
-      Row* row = (struct Row_*) Vector_get(this->rows, i);
-      row->updated = false;
-      row->wasShown = row->show;
-      row->show = true;
-   }
+   this->scanGeneration++;
+   if (this->scanGeneration == 0)
+      this->scanGeneration = 1;
+   this->updatedRows = 0;
 }
 
 // tidy up Row state after refreshing the table
@@ -338,12 +897,15 @@ void Table_cleanupRow(Table* table, Row* row, int idx) {
       // remove tombed process
       if (host->monotonicMs >= row->tombStampMs) {
          Table_removeIndex(table, row, idx);
+      } else {
+         table->tombRows++;
       }
-   } else if (row->updated == false) {
-      // process no longer exists
-      if (settings->highlightChanges && row->wasShown) {
+   } else if (!Table_isUpdated(table, row)) {
+      // process no longer exists, show is still as it was displayed
+      if (settings->highlightChanges && row->show) {
          // mark tombed
          row->tombStampMs = host->monotonicMs + 1000 * settings->highlightDelaySecs;
+         table->tombRows++;
       } else {
          // immediately remove
          Table_removeIndex(table, row, idx);
@@ -352,7 +914,11 @@ void Table_cleanupRow(Table* table, Row* row, int idx) {
 }
 
 void Table_cleanupEntries(Table* this) {
+   if (!Table_needsCulling(this))
+      return;
+
    // Finish process table update, culling any removed rows
+   this->tombRows = 0;
    for (int i = Vector_size(this->rows) - 1; i >= 0; i--) {
       Row* row = (Row*) Vector_get(this->rows, i);
       Table_cleanupRow(this, row, i);
@@ -9,11 +9,15 @@ in the source distribution for its full text.
 */
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
 
+#include "FilterMatcher.h"
 #include "Hashtable.h"
 #include "Object.h"
 #include "RichString.h"
 #include "Settings.h"
+#include "SparseArray.h"
 #include "Vector.h"
 
 
@@ -28,26 +32,60 @@ typedef struct Table_ {
    Vector* rows;          /* all known; sort order can vary and differ from display order */
    Vector* displayList;   /* row tree flattened in display order (borrowed);
                              updated in Table_updateDisplayList when rebuilding panel */
+   Vector* panelRows;     /* shown rows of the display list (borrowed), only while some are left out */
+   bool panelFiltered;    /* the panel shows panelRows rather than the whole display list */
    Hashtable* table;      /* fast known row lookup by identifier */
+   SparseArray* index;    /* replaces table when identifiers are bounded, see Table_useDirectIndex */
+
+   Vector* treeRoots;     /* rows without a known parent (borrowed), see Table_buildTree */
+   struct TableTreeFrame_* treeStack;  /* traversal stack of Table_buildTree */
+   Vector** treeMatched;  /* per level of treeStack, the children it walks while the tree is filtered */
+   size_t treeStackAlloc;
+   bool treeFiltered;     /* the display list holds only the rows the filter leaves and their ancestors */
+   unsigned int treeMatch;  /* stamped on those rows by the last filtered Table_buildTree */
+
+   VectorSortKey* sortKeys;  /* extracted sort keys and radix scratch space, see Table_sortRows */
+   size_t sortKeysAlloc;
+   uint64_t* sortValues;     /* the keys of a sort by several of them, one run of rows per key */
+   size_t sortValuesAlloc;
+   const VectorRunner* sortRunner;  /* runs the jobs of sorts of many rows, NULL to sort them on the main thread */
+   int sortedRows;        /* leading rows in display order after the last sort, the rest follow unordered */
+   int sortedItems;       /* leading panel items taken from those rows */
 
    struct Machine_* host;
    const char* incFilter;
+   FilterMatcher filter;  /* incFilter compiled, brought up to date in Table_updateDisplayList */
    bool needsSort;
    int following;         /* -1 or row being visually tracked in the user interface */
 
    struct Panel_* panel;
+   unsigned int panelGeneration;  /* incremented whenever the panel is rebuilt */
+   unsigned int changeGeneration;       /* incremented whenever rows may display differently */
+   unsigned int panelChangeGeneration;  /* changeGeneration the panel was last rebuilt with */
+   unsigned int panelBuild;             /* incremented whenever the panel items are rebuilt */
+
+   unsigned int scanGeneration;   /* incremented by every scan, rows it finds are stamped with it */
+   int updatedRows;               /* rows stamped by the scan in progress */
+   int tombRows;                  /* rows kept after they went away, as of the last cleanup */
+
+   uint64_t nextScanMs;   /* monotonic time the rows are due to be scanned again, 0 - right away */
+   time_t scanTime;       /* wall clock time of the last scan, shown on the tabs of screens not scanned */
 } Table;
 
 typedef Table* (*Table_New)(const struct Machine_*);
 typedef void (*Table_ScanPrepare)(Table* this);
 typedef void (*Table_ScanIterate)(Table* this);
 typedef void (*Table_ScanCleanup)(Table* this);
+typedef bool (*Table_ScanPrefetch)(Table* this);
+typedef bool (*Table_ScanPrefetched)(const Table* this);
 
 typedef struct TableClass_ {
    const ObjectClass super;
    const Table_ScanPrepare prepare;
    const Table_ScanIterate iterate;
    const Table_ScanCleanup cleanup;
+   const Table_ScanPrefetch prefetch;      /* optional; starts reading the next scan in the background */
+   const Table_ScanPrefetched prefetched;  /* optional; whether the background reading is done */
 } TableClass;
 
 #define As_Table(this_)  ((const TableClass*)((this_)->super.klass))
@@ -55,11 +93,16 @@ typedef struct TableClass_ {
 #define Table_scanPrepare(t_)  (As_Table(t_)->prepare ? (As_Table(t_)->prepare(t_)) : Table_prepareEntries(t_))
 #define Table_scanIterate(t_)  (As_Table(t_)->iterate(t_))  /* mandatory; must have a custom iterate method */
 #define Table_scanCleanup(t_)  (As_Table(t_)->cleanup ? (As_Table(t_)->cleanup(t_)) : Table_cleanupEntries(t_))
+#define Table_scanPrefetch(t_)  (As_Table(t_)->prefetch ? (As_Table(t_)->prefetch(t_)) : false)
+#define Table_scanPrefetched(t_)  (As_Table(t_)->prefetched ? (As_Table(t_)->prefetched(t_)) : true)
 
 Table* Table_init(Table* this, const ObjectClass* klass, struct Machine_* host);
 
 void Table_done(Table* this);
 
+/* Look rows up by indexing with their identifier instead of hashing it; call before adding rows */
+void Table_useDirectIndex(Table* this);
+
 extern const TableClass Table_class;
 
 void Table_setPanel(Table* this, struct Panel_* panel);
@@ -76,14 +119,40 @@ void Table_expandTree(Table* this);
 
 void Table_collapseAllBranches(Table* this);
 
+/* Rows changed their contents or how they display, Table_rebuildPanel has to re-evaluate them */
+void Table_markRowsChanged(Table* this);
+
 void Table_rebuildPanel(Table* this);
 
-static inline struct Row_* Table_findRow(Table* this, int id) {
+/* Whether the row was inside the scroll window (or selected) when the panel was last rebuilt */
+bool Table_isRowOnScreen(const Table* this, const struct Row_* row);
+
+static inline struct Row_* Table_findRow(const Table* this, int id) {
+   if (this->index)
+      return (struct Row_*) SparseArray_get(this->index, id);
+
    return (struct Row_*) Hashtable_get(this->table, id);
 }
 
 void Table_prepareEntries(Table* this);
 
+/* Marks the row as found by the scan in progress; it must be in the table */
+static inline void Table_markUpdated(Table* this, struct Row_* row) {
+   if (row->updatedGeneration != this->scanGeneration) {
+      row->updatedGeneration = this->scanGeneration;
+      this->updatedRows++;
+   }
+}
+
+static inline bool Table_isUpdated(const Table* this, const struct Row_* row) {
+   return row->updatedGeneration == this->scanGeneration;
+}
+
+/* Whether rows went away or tombs are due: else cleaning up the rows has nothing to remove */
+static inline bool Table_needsCulling(const Table* this) {
+   return this->updatedRows != Vector_size(this->rows) || this->tombRows > 0;
+}
+
 void Table_cleanupEntries(Table* this);
 
 void Table_cleanupRow(Table* this, Row* row, int idx);
@@ -23,16 +23,27 @@ in the source distribution for its full text.
 
 #include "CRT.h"
 #include "FunctionBar.h"
+#include "IncSet.h"
+#include "LineStore.h"
+#include "Machine.h"
+#include "Macros.h"
 #include "Panel.h"
+#include "Platform.h"
 #include "ProvideCurses.h"
+#include "Settings.h"
 #include "XUtils.h"
 
 
-static const char* const TraceScreenFunctions[] = {"Search ", "Filter ", "AutoScroll ", "Stop Tracing   ", "Done   ", NULL};
+static const char* const TraceScreenFunctions[] = {"Search ", "Filter ", "Summary ", "AutoScroll ", "Stop Tracing   ", "Done   ", NULL};
 
-static const char* const TraceScreenKeys[] = {"F3", "F4", "F8", "F9", "Esc"};
+static const char* const TraceScreenKeys[] = {"F3", "F4", "F6", "F8", "F9", "Esc"};
 
-static const int TraceScreenEvents[] = {KEY_F(3), KEY_F(4), KEY_F(8), KEY_F(9), 27};
+static const int TraceScreenEvents[] = {KEY_F(3), KEY_F(4), KEY_F(6), KEY_F(8), KEY_F(9), 27};
+
+/* Output of strace is taken for this long before the screen is drawn again */
+#define TRACESCREEN_DRAW_INTERVAL_MS 100
+
+#define TRACESCREEN_SUMMARY_HEADER "% TIME     SECONDS  USECS/CALL     CALLS    ERRORS SYSCALL"
 
 TraceScreen* TraceScreen_new(const Process* process) {
    // This initializes all TraceScreen variables to "false" so only default = true ones need to be set below
@@ -57,6 +68,11 @@ void TraceScreen_delete(Object* cast) {
       fclose(this->strace);
    }
 
+   if (this->trace) {
+      LineStore_delete(this->trace);
+   }
+   free(this->syscalls);
+
    CRT_enableDelay();
    free(InfoScreen_done((InfoScreen*)this));
 }
@@ -82,6 +98,7 @@ bool TraceScreen_forkTracer(TraceScreen* this) {
       goto err;
 
    if (child == 0) {
+      restoreFileLimit();
       close(fdpair[0]);
 
       dup2(fdpair[1], STDOUT_FILENO);
@@ -117,48 +134,250 @@ err:
    return false;
 }
 
+/* Adds a line of the trace, or with cont the rest of the last one; returns the line as it is now */
+static const char* TraceScreen_addLine(TraceScreen* this, const char* line, bool cont) {
+   InfoScreen* super = &this->super;
+
+   if (!this->summary) {
+      if (cont) {
+         InfoScreen_appendLine(super, line);
+      } else {
+         InfoScreen_addLine(super, line);
+      }
+      return LineStore_get(super->lines, LineStore_size(super->lines) - 1);
+   }
+
+   /* kept aside while the summary is shown */
+   if (cont) {
+      LineStore_appendToLast(this->trace, line);
+   } else {
+      LineStore_add(this->trace, line);
+   }
+   return LineStore_get(this->trace, LineStore_size(this->trace) - 1);
+}
+
+/* Counts a complete line as strace -tt -T prints it: "time name(args) = result <seconds>" */
+static void TraceScreen_count(TraceScreen* this, const char* line) {
+   static const char identifier[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+
+   const char* name = strchr(line, ' ');
+   if (!name)
+      return;
+
+   name++;
+   bool resumed = String_startsWith(name, "<... ");
+   if (resumed)
+      name += strlen("<... ");
+
+   size_t len = strspn(name, identifier);
+   if (len == 0 || len >= sizeof(this->syscalls[0].name) || (!resumed && name[len] != '('))
+      return;
+
+   /* calls still unfinished end in "<unfinished ...>" and are counted when resumed */
+   const char* duration = strrchr(line, '<');
+   double seconds;
+   if (!duration || sscanf(duration, "<%lf>", &seconds) != 1)
+      return;
+
+   const char* result = duration;
+   while (result > name && !String_startsWith(result, " = "))
+      result--;
+
+   TraceSyscall* syscall = NULL;
+   for (size_t i = 0; i < this->nSyscalls; i++) {
+      if (strncmp(this->syscalls[i].name, name, len) == 0 && this->syscalls[i].name[len] == '\0') {
+         syscall = &this->syscalls[i];
+         break;
+      }
+   }
+
+   if (!syscall) {
+      if (this->nSyscalls == this->syscallsSize) {
+         this->syscallsSize = this->syscallsSize ? this->syscallsSize * 2 : 32;
+         this->syscalls = xReallocArray(this->syscalls, this->syscallsSize, sizeof(TraceSyscall));
+      }
+      syscall = &this->syscalls[this->nSyscalls++];
+      *syscall = (TraceSyscall) { .calls = 0 };
+      memcpy(syscall->name, name, len);
+      syscall->name[len] = '\0';
+   }
+
+   syscall->calls++;
+   syscall->seconds += seconds;
+   if (String_startsWith(result, " = -1 "))
+      syscall->errors++;
+
+   this->summaryChanged = true;
+}
+
+static void TraceScreen_addOutput(TraceScreen* this, char* buffer, size_t nread) {
+   buffer[nread] = '\0';
+
+   char* line = buffer;
+   for (size_t i = 0; i < nread; i++) {
+      if (buffer[i] != '\n')
+         continue;
+
+      buffer[i] = '\0';
+      const char* complete = TraceScreen_addLine(this, line, this->contLine);
+      this->contLine = false;
+      TraceScreen_count(this, complete);
+      line = buffer + i + 1;
+   }
+
+   if (line < buffer + nread) {
+      TraceScreen_addLine(this, line, this->contLine);
+      this->contLine = true;
+   }
+}
+
+/*
+ * Drops the oldest lines once there are more than the configured number.
+ * They are dropped in batches, each line is so moved only a few times.
+ */
+static void TraceScreen_trim(TraceScreen* this) {
+   InfoScreen* super = &this->super;
+   LineStore* lines = this->summary ? this->trace : super->lines;
+
+   const Settings* settings = super->process->super.host->settings;
+   int keep = settings->traceLines * 1000;
+   int size = LineStore_size(lines);
+   if (size <= keep + keep / 8)
+      return;
+
+   int shown = LineStore_dropFirst(lines, size - keep);
+
+   if (!this->summary) {
+      Panel* panel = super->display;
+      panel->scrollV = MAXIMUM(panel->scrollV - shown, 0);
+      Panel_setSelected(panel, MAXIMUM(panel->selected - shown, 0));
+      panel->needsRedraw = true;
+   }
+}
+
+static int TraceScreen_compareSyscalls(const void* v1, const void* v2) {
+   const TraceSyscall* s1 = v1;
+   const TraceSyscall* s2 = v2;
+
+   int r = SPACESHIP_NUMBER(s2->seconds, s1->seconds);
+   return r ? r : SPACESHIP_NUMBER(s2->calls, s1->calls);
+}
+
+/* Like strace -c, but for the calls seen so far */
+static void TraceScreen_showSummary(TraceScreen* this) {
+   InfoScreen* super = &this->super;
+   Panel* panel = super->display;
+   int selected = Panel_getSelectedIndex(panel);
+
+   Panel_prune(panel);
+   LineStore_clear(super->lines);
+
+   qsort(this->syscalls, this->nSyscalls, sizeof(TraceSyscall), TraceScreen_compareSyscalls);
+
+   TraceSyscall total = { .calls = 0 };
+   for (size_t i = 0; i < this->nSyscalls; i++) {
+      total.calls += this->syscalls[i].calls;
+      total.errors += this->syscalls[i].errors;
+      total.seconds += this->syscalls[i].seconds;
+   }
+
+   char line[128];
+   for (size_t i = 0; i <= this->nSyscalls; i++) {
+      const TraceSyscall* syscall = i < this->nSyscalls ? &this->syscalls[i] : &total;
+      double percent = total.seconds > 0.0 ? 100.0 * syscall->seconds / total.seconds : 0.0;
+      double usecs = syscall->calls ? 1e6 * syscall->seconds / (double)syscall->calls : 0.0;
+      xSnprintf(line, sizeof(line), "%6.2f %11.6f %11.0f %9llu %9llu %s",
+                percent, syscall->seconds, usecs, syscall->calls, syscall->errors,
+                i < this->nSyscalls ? syscall->name : "total");
+      InfoScreen_addLine(super, line);
+   }
+
+   Panel_setSelected(panel, selected);
+   this->summaryChanged = false;
+}
+
+static void TraceScreen_toggleSummary(TraceScreen* this) {
+   InfoScreen* super = &this->super;
+   Panel* panel = super->display;
+
+   this->summary = !this->summary;
+   if (this->summary) {
+      this->trace = super->lines;
+      super->lines = LineStore_new();
+      LineStore_filter(super->lines, IncSet_filterMatcher(super->inc));
+      Panel_setHeader(panel, TRACESCREEN_SUMMARY_HEADER);
+      Panel_setSelected(panel, 0);
+      TraceScreen_showSummary(this);
+   } else {
+      LineStore_delete(super->lines);
+      super->lines = this->trace;
+      this->trace = NULL;
+      Panel_setHeader(panel, " ");
+      Panel_prune(panel);
+      /* the filter may have changed meanwhile */
+      LineStore_filter(super->lines, IncSet_filterMatcher(super->inc));
+      Panel_setSelected(panel, this->follow ? Panel_size(panel) - 1 : 0);
+   }
+
+   FunctionBar_setLabel(panel->defaultBar, KEY_F(6), this->summary ? "Trace   " : "Summary ");
+   InfoScreen_draw(this);
+}
+
 static void TraceScreen_updateTrace(InfoScreen* super) {
    TraceScreen* this = (TraceScreen*) super;
-   char buffer[1025];
+   char buffer[16385];
 
    int fd_strace = fileno(this->strace);
    assert(fd_strace != -1);
 
-   fd_set fds;
-   FD_ZERO(&fds);
-// FD_SET(STDIN_FILENO, &fds);
-   FD_SET(fd_strace, &fds);
-
-   struct timeval tv = { .tv_sec = 0, .tv_usec = 500 };
-   int ready = select(fd_strace + 1, &fds, NULL, NULL, &tv);
-
-   size_t nread = 0;
-   if (ready > 0 && FD_ISSET(fd_strace, &fds))
-      nread = fread(buffer, 1, sizeof(buffer) - 1, this->strace);
-
-   if (nread && this->tracing) {
-      const char* line = buffer;
-      buffer[nread] = '\0';
-      for (size_t i = 0; i < nread; i++) {
-         if (buffer[i] == '\n') {
-            buffer[i] = '\0';
-            if (this->contLine) {
-               InfoScreen_appendLine(&this->super, line);
-               this->contLine = false;
-            } else {
-               InfoScreen_addLine(&this->super, line);
-            }
-            line = buffer + i + 1;
-         }
+   /* take what strace writes until the next draw is due, or a key is pressed */
+   uint64_t start;
+   Platform_gettime_monotonic(&start);
+   bool added = false;
+
+   for (;;) {
+      uint64_t now;
+      Platform_gettime_monotonic(&now);
+      if (now - start >= TRACESCREEN_DRAW_INTERVAL_MS)
+         break;
+
+      fd_set fds;
+      FD_ZERO(&fds);
+      FD_SET(STDIN_FILENO, &fds);
+      if (!this->ended)
+         FD_SET(fd_strace, &fds);
+
+      struct timeval tv = { .tv_sec = 0, .tv_usec = (suseconds_t)((TRACESCREEN_DRAW_INTERVAL_MS - (now - start)) * 1000) };
+      int ready = select(MAXIMUM(fd_strace, STDIN_FILENO) + 1, &fds, NULL, NULL, &tv);
+      if (ready <= 0 || FD_ISSET(STDIN_FILENO, &fds))
+         break;
+
+      ssize_t nread = read(fd_strace, buffer, sizeof(buffer) - 1);
+      if (nread < 0 && (errno == EINTR || errno == EAGAIN))
+         continue;
+
+      if (nread <= 0) {
+         this->ended = true;
+         continue;
       }
-      if (line < buffer + nread) {
-         InfoScreen_addLine(&this->super, line);
-         buffer[nread] = '\0';
-         this->contLine = true;
+
+      if (this->tracing) {
+         TraceScreen_addOutput(this, buffer, (size_t)nread);
+         added = true;
       }
-      if (this->follow) {
-         Panel_setSelected(this->super.display, Panel_size(this->super.display) - 1);
+   }
+
+   if (!added)
+      return;
+
+   TraceScreen_trim(this);
+
+   if (this->summary) {
+      if (this->summaryChanged) {
+         TraceScreen_showSummary(this);
       }
+   } else if (this->follow) {
+      Panel_setSelected(this->super.display, Panel_size(this->super.display) - 1);
    }
 }
 
@@ -166,10 +385,14 @@ static bool TraceScreen_onKey(InfoScreen* super, int ch) {
    TraceScreen* this = (TraceScreen*) super;
 
    switch (ch) {
+      case 'c':
+      case KEY_F(6):
+         TraceScreen_toggleSummary(this);
+         return true;
       case 'f':
       case KEY_F(8):
          this->follow = !(this->follow);
-         if (this->follow)
+         if (this->follow && !this->summary)
             Panel_setSelected(super->display, Panel_size(super->display) - 1);
          return true;
       case 't':
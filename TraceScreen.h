@@ -12,10 +12,19 @@ in the source distribution for its full text.
 #include <sys/types.h>
 
 #include "InfoScreen.h"
+#include "LineStore.h"
 #include "Object.h"
 #include "Process.h"
 
 
+/* Calls of one system call seen in the trace */
+typedef struct TraceSyscall_ {
+   char name[32];
+   unsigned long long calls;
+   unsigned long long errors;
+   double seconds;
+} TraceSyscall;
+
 typedef struct TraceScreen_ {
    InfoScreen super;
    bool tracing;
@@ -23,6 +32,14 @@ typedef struct TraceScreen_ {
    FILE* strace;
    bool contLine;
    bool follow;
+   bool ended;               /* strace closed its output */
+
+   bool summary;             /* the syscall summary is shown instead of the trace */
+   bool summaryChanged;
+   LineStore* trace;         /* lines of the trace while the summary is shown */
+   TraceSyscall* syscalls;
+   size_t nSyscalls;
+   size_t syscallsSize;
 } TraceScreen;
 
 
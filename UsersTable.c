@@ -9,38 +9,412 @@ in the source distribution for its full text.
 
 #include "UsersTable.h"
 
+#include <errno.h>
 #include <pwd.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+#include "Platform.h"
 #include "XUtils.h"
 
 
+/* Upper bound for the getpwuid_r() scratch buffer */
+#define USERSTABLE_PWBUF_MAX (1024 * 1024)
+
+typedef enum UsersTableLookup_ {
+   USERSTABLE_FOUND,
+   USERSTABLE_MISSING,  // no such user
+   USERSTABLE_FAILED,   // the user database could not be queried
+} UsersTableLookup;
+
+static UsersTableLookup UsersTable_lookup(unsigned int uid, char* name, size_t size) {
+   long int initial = sysconf(_SC_GETPW_R_SIZE_MAX);
+   size_t bufferSize = initial > 0 ? (size_t)initial : 4096;
+   char* buffer = NULL;
+   UsersTableLookup lookup;
+
+   for (;;) {
+      buffer = xRealloc(buffer, bufferSize);
+
+      struct passwd pwd;
+      struct passwd* result = NULL;
+      int err = getpwuid_r((uid_t)uid, &pwd, buffer, bufferSize, &result);
+      if (err == ERANGE && bufferSize < USERSTABLE_PWBUF_MAX) {
+         bufferSize *= 2;
+         continue;
+      }
+
+      if (result) {
+         String_safeStrncpy(name, result->pw_name, size);
+         lookup = USERSTABLE_FOUND;
+      } else if (err == 0 || err == ENOENT || err == ESRCH || err == EBADF || err == EPERM) {
+         /* POSIX allows all of these for an unknown UID */
+         lookup = USERSTABLE_MISSING;
+      } else {
+         lookup = USERSTABLE_FAILED;
+      }
+      break;
+   }
+
+   free(buffer);
+   return lookup;
+}
+
+#ifdef HAVE_PTHREAD
+
+typedef struct UsersTableResult_ {
+   unsigned int uid;
+   UsersTableLookup lookup;
+   char name[USERSTABLE_NAME_MAX];
+} UsersTableResult;
+
+/*
+ * Runs the lookups on a detached helper thread, so a slow NSS backend
+ * (LDAP, SSSD, ...) never stalls the UI. Only the main thread touches
+ * the table itself; the helper just trades UIDs for names.
+ */
+typedef struct UsersTableResolver_ {
+   pthread_mutex_t lock;
+   pthread_cond_t cond;
+
+   unsigned int refs;  // the table and the helper, the last one frees
+   bool quit;
+   bool preload;
+
+   unsigned int* requests;
+   size_t requestCount;
+   size_t requestAlloc;
+
+   UsersTableResult* results;
+   size_t resultCount;
+   size_t resultAlloc;
+} UsersTableResolver;
+
+/* Called with the lock held, drops it */
+static void UsersTableResolver_release(UsersTableResolver* this) {
+   bool last = --this->refs == 0;
+   pthread_mutex_unlock(&this->lock);
+
+   if (!last)
+      return;
+
+   pthread_cond_destroy(&this->cond);
+   pthread_mutex_destroy(&this->lock);
+   free(this->requests);
+   free(this->results);
+   free(this);
+}
+
+/* Called with the lock held */
+static void UsersTableResolver_pushResult(UsersTableResolver* this, unsigned int uid, UsersTableLookup lookup, const char* name) {
+   if (this->resultCount == this->resultAlloc) {
+      this->resultAlloc = this->resultAlloc ? this->resultAlloc * 2 : 16;
+      this->results = xReallocArray(this->results, this->resultAlloc, sizeof(UsersTableResult));
+   }
+
+   UsersTableResult* result = &this->results[this->resultCount++];
+   result->uid = uid;
+   result->lookup = lookup;
+   String_safeStrncpy(result->name, name, sizeof(result->name));
+}
+
+static void UsersTableResolver_preload(UsersTableResolver* this) {
+   /* getpwent() is not reentrant, but this thread is its only user */
+   setpwent();
+
+   const struct passwd* userData;
+   while ((userData = getpwent()) != NULL) {
+      pthread_mutex_lock(&this->lock);
+      bool quit = this->quit;
+      if (!quit)
+         UsersTableResolver_pushResult(this, userData->pw_uid, USERSTABLE_FOUND, userData->pw_name);
+      pthread_mutex_unlock(&this->lock);
+
+      if (quit)
+         break;
+   }
+
+   endpwent();
+}
+
+static void* UsersTableResolver_run(void* data) {
+   UsersTableResolver* this = data;
+
+   pthread_mutex_lock(&this->lock);
+   for (;;) {
+      while (!this->quit && !this->preload && this->requestCount == 0)
+         pthread_cond_wait(&this->cond, &this->lock);
+
+      if (this->quit)
+         break;
+
+      if (this->preload) {
+         this->preload = false;
+         pthread_mutex_unlock(&this->lock);
+         UsersTableResolver_preload(this);
+         pthread_mutex_lock(&this->lock);
+         continue;
+      }
+
+      unsigned int uid = this->requests[--this->requestCount];
+      pthread_mutex_unlock(&this->lock);
+
+      char name[USERSTABLE_NAME_MAX] = "";
+      UsersTableLookup lookup = UsersTable_lookup(uid, name, sizeof(name));
+
+      pthread_mutex_lock(&this->lock);
+      UsersTableResolver_pushResult(this, uid, lookup, name);
+   }
+
+   UsersTableResolver_release(this);
+   return NULL;
+}
+
+static UsersTableResolver* UsersTableResolver_new(void) {
+   UsersTableResolver* this = xCalloc(1, sizeof(UsersTableResolver));
+   pthread_mutex_init(&this->lock, NULL);
+   pthread_cond_init(&this->cond, NULL);
+   this->refs = 2;
+
+   /* signals are to be handled by the main thread only */
+   sigset_t all, old;
+   sigfillset(&all);
+   pthread_sigmask(SIG_BLOCK, &all, &old);
+
+   pthread_t thread;
+   int err = pthread_create(&thread, NULL, UsersTableResolver_run, this);
+
+   pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+   if (err != 0) {
+      pthread_cond_destroy(&this->cond);
+      pthread_mutex_destroy(&this->lock);
+      free(this);
+      return NULL;
+   }
+
+   /* never joined: a lookup stuck in an NSS timeout must not delay exiting */
+   pthread_detach(thread);
+   return this;
+}
+
+static void UsersTableResolver_delete(UsersTableResolver* this) {
+   pthread_mutex_lock(&this->lock);
+   this->quit = true;
+   pthread_cond_signal(&this->cond);
+   UsersTableResolver_release(this);
+}
+
+static bool UsersTable_startResolver(UsersTable* this) {
+   static bool failed = false;
+
+   if (!this->resolver && !failed) {
+      this->resolver = UsersTableResolver_new();
+      failed = !this->resolver;
+   }
+
+   return this->resolver != NULL;
+}
+
+#endif /* HAVE_PTHREAD */
+
+static UsersTableEntry* UsersTable_newEntry(UsersTable* this, unsigned int uid) {
+   UsersTableEntry* entry = xCalloc(1, sizeof(UsersTableEntry));
+   xSnprintf(entry->name, sizeof(entry->name), "%u", uid);
+   Hashtable_put(this->users, uid, entry);
+   return entry;
+}
+
+static void UsersTable_apply(UsersTable* this, unsigned int uid, UsersTableLookup lookup, const char* name) {
+   UsersTableEntry* entry = Hashtable_get(this->users, uid);
+   if (!entry) {
+      if (lookup != USERSTABLE_FOUND)
+         return;
+
+      entry = UsersTable_newEntry(this, uid);
+   }
+
+   entry->pending = false;
+
+   if (lookup == USERSTABLE_FOUND) {
+      String_safeStrncpy(entry->name, name, sizeof(entry->name));
+      entry->known = true;
+      entry->expiresMs = this->monotonicMs + USERSTABLE_TTL_MS;
+   } else {
+      /* a failed query keeps the old name, the backend may just be unreachable */
+      if (lookup == USERSTABLE_MISSING) {
+         xSnprintf(entry->name, sizeof(entry->name), "%u", uid);
+         entry->known = false;
+      }
+      entry->expiresMs = this->monotonicMs + USERSTABLE_NEGATIVE_TTL_MS;
+   }
+
+   if (entry->expiresMs < this->nextExpiryMs)
+      this->nextExpiryMs = entry->expiresMs;
+}
+
+static void UsersTable_resolve(UsersTable* this, unsigned int uid, UsersTableEntry* entry) {
+#ifdef HAVE_PTHREAD
+   if (UsersTable_startResolver(this)) {
+      UsersTableResolver* resolver = this->resolver;
+
+      pthread_mutex_lock(&resolver->lock);
+      if (resolver->requestCount == resolver->requestAlloc) {
+         resolver->requestAlloc = resolver->requestAlloc ? resolver->requestAlloc * 2 : 16;
+         resolver->requests = xReallocArray(resolver->requests, resolver->requestAlloc, sizeof(unsigned int));
+      }
+      resolver->requests[resolver->requestCount++] = uid;
+      pthread_cond_signal(&resolver->cond);
+      pthread_mutex_unlock(&resolver->lock);
+
+      entry->pending = true;
+      return;
+   }
+#endif
+
+   (void) entry;
+
+   char name[USERSTABLE_NAME_MAX] = "";
+   UsersTableLookup lookup = UsersTable_lookup(uid, name, sizeof(name));
+   UsersTable_apply(this, uid, lookup, name);
+}
+
 UsersTable* UsersTable_new(void) {
    UsersTable* this;
    this = xMalloc(sizeof(UsersTable));
    this->users = Hashtable_new(10, true);
+   this->monotonicMs = 0;
+   this->nextExpiryMs = UINT64_MAX;
+   this->resolver = NULL;
    return this;
 }
 
 void UsersTable_delete(UsersTable* this) {
+#ifdef HAVE_PTHREAD
+   if (this->resolver)
+      UsersTableResolver_delete(this->resolver);
+#endif
    Hashtable_delete(this->users);
    free(this);
 }
 
 char* UsersTable_getRef(UsersTable* this, unsigned int uid) {
-   char* name = Hashtable_get(this->users, uid);
-   if (name == NULL) {
-      const struct passwd* userData = getpwuid(uid);
-      if (userData != NULL) {
-         name = xStrdup(userData->pw_name);
-         Hashtable_put(this->users, uid, name);
-      }
+   UsersTableEntry* entry = Hashtable_get(this->users, uid);
+   if (entry == NULL) {
+      entry = UsersTable_newEntry(this, uid);
+      UsersTable_resolve(this, uid, entry);
+   }
+   return entry->name;
+}
+
+typedef struct UsersTableExpiry_ {
+   UsersTable* table;
+   unsigned int* uids;
+   size_t count;
+   size_t alloc;
+} UsersTableExpiry;
+
+static void UsersTable_collectExpired(ht_key_t key, void* value, void* userData) {
+   UsersTableEntry* entry = value;
+   UsersTableExpiry* expiry = userData;
+   UsersTable* this = expiry->table;
+
+   if (entry->pending)
+      return;
+
+   if (entry->expiresMs > this->monotonicMs) {
+      if (entry->expiresMs < this->nextExpiryMs)
+         this->nextExpiryMs = entry->expiresMs;
+      return;
+   }
+
+   if (expiry->count == expiry->alloc) {
+      expiry->alloc = expiry->alloc ? expiry->alloc * 2 : 16;
+      expiry->uids = xReallocArray(expiry->uids, expiry->alloc, sizeof(unsigned int));
+   }
+   expiry->uids[expiry->count++] = key;
+}
+
+void UsersTable_update(UsersTable* this) {
+   Platform_gettime_monotonic(&this->monotonicMs);
+
+#ifdef HAVE_PTHREAD
+   UsersTableResolver* resolver = this->resolver;
+   if (resolver) {
+      pthread_mutex_lock(&resolver->lock);
+      UsersTableResult* results = resolver->results;
+      size_t resultCount = resolver->resultCount;
+      resolver->results = NULL;
+      resolver->resultCount = 0;
+      resolver->resultAlloc = 0;
+      pthread_mutex_unlock(&resolver->lock);
+
+      for (size_t i = 0; i < resultCount; i++)
+         UsersTable_apply(this, results[i].uid, results[i].lookup, results[i].name);
+
+      free(results);
+   }
+#endif
+
+   if (this->monotonicMs < this->nextExpiryMs)
+      return;
+
+   /* collect first, the synchronous fallback modifies the table while resolving */
+   UsersTableExpiry expiry = { .table = this };
+   this->nextExpiryMs = UINT64_MAX;
+   Hashtable_foreach(this->users, UsersTable_collectExpired, &expiry);
+
+   for (size_t i = 0; i < expiry.count; i++) {
+      UsersTableEntry* entry = Hashtable_get(this->users, expiry.uids[i]);
+      UsersTable_resolve(this, expiry.uids[i], entry);
    }
-   return name;
+
+   free(expiry.uids);
+}
+
+void UsersTable_preload(UsersTable* this) {
+#ifdef HAVE_PTHREAD
+   if (UsersTable_startResolver(this)) {
+      pthread_mutex_lock(&this->resolver->lock);
+      this->resolver->preload = true;
+      pthread_cond_signal(&this->resolver->cond);
+      pthread_mutex_unlock(&this->resolver->lock);
+      return;
+   }
+#endif
+
+   Platform_gettime_monotonic(&this->monotonicMs);
+
+   setpwent();
+
+   const struct passwd* userData;
+   while ((userData = getpwent()) != NULL)
+      UsersTable_apply(this, userData->pw_uid, USERSTABLE_FOUND, userData->pw_name);
+
+   endpwent();
+}
+
+typedef struct UsersTableForeach_ {
+   Hashtable_PairFunction f;
+   void* userData;
+} UsersTableForeach;
+
+static void UsersTable_foreachKnown(ht_key_t key, void* value, void* userData) {
+   UsersTableEntry* entry = value;
+   const UsersTableForeach* context = userData;
+
+   if (entry->known)
+      context->f(key, entry->name, context->userData);
 }
 
-inline void UsersTable_foreach(UsersTable* this, Hashtable_PairFunction f, void* userData) {
-   Hashtable_foreach(this->users, f, userData);
+void UsersTable_foreach(UsersTable* this, Hashtable_PairFunction f, void* userData) {
+   UsersTableForeach context = { .f = f, .userData = userData };
+   Hashtable_foreach(this->users, UsersTable_foreachKnown, &context);
 }
@@ -7,19 +7,50 @@ Released under the GNU GPLv2+, see the COPYING file
 in the source distribution for its full text.
 */
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "Hashtable.h"
 
 
+/* Room for the longest user name kept; names are updated in place */
+#define USERSTABLE_NAME_MAX 256
+
+/* How long resolved names and failed lookups are trusted */
+#define USERSTABLE_TTL_MS (10 * 60 * 1000)
+#define USERSTABLE_NEGATIVE_TTL_MS (60 * 1000)
+
+typedef struct UsersTableEntry_ {
+   char name[USERSTABLE_NAME_MAX];  // the numeric UID until the name is known
+   bool known;                      // name came from the user database
+   bool pending;                    // lookup in flight
+   uint64_t expiresMs;
+} UsersTableEntry;
+
+struct UsersTableResolver_;
+
 typedef struct UsersTable_ {
    Hashtable* users;
+   uint64_t monotonicMs;
+   uint64_t nextExpiryMs;
+   struct UsersTableResolver_* resolver;
 } UsersTable;
 
 UsersTable* UsersTable_new(void);
 
 void UsersTable_delete(UsersTable* this);
 
+/* The returned buffer stays valid for the lifetime of the table and
+   shows the numeric UID until the name has been looked up */
 char* UsersTable_getRef(UsersTable* this, unsigned int uid);
 
+/* Picks up finished lookups and refreshes expired entries; call once per scan */
+void UsersTable_update(UsersTable* this);
+
+/* Fills the table from getpwent(), in the background where possible */
+void UsersTable_preload(UsersTable* this);
+
+/* Iterates over the UIDs with a known name, passing the name as value */
 void UsersTable_foreach(UsersTable* this, Hashtable_PairFunction f, void* userData);
 
 #endif
@@ -7,12 +7,15 @@ in the source distribution for its full text.
 
 #include "config.h" // IWYU pragma: keep
 
+#define HEAP_CLASS HEAP_VECTORS
+
 #include "Vector.h"
 
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "Macros.h"
 #include "XUtils.h"
 
 
@@ -180,6 +183,534 @@ static void insertionSort(Object** array, int left, int right, Object_Compare co
    }
 }
 
+/*
+ * Natural merge sort in the style of timsort: the input is cut into
+ * ascending runs (strictly descending ones are reversed), short runs are
+ * extended with binary insertion sort, and runs are merged while keeping
+ * their lengths balanced. An already sorted array costs n - 1 comparisons,
+ * a few displaced rows little more, and equal keys cannot degrade it. The
+ * sort is stable, so rows comparing equal keep their previous order.
+ */
+
+#define VECTOR_SORT_MIN_MERGE 32
+#define VECTOR_SORT_MAX_RUNS 85
+
+typedef struct VectorSortState_ {
+   Object** array;
+   Object_Compare compare;
+
+   Object** tmp;
+   int tmpSize;
+
+   int runBase[VECTOR_SORT_MAX_RUNS];
+   int runLen[VECTOR_SORT_MAX_RUNS];
+   int runCount;
+} VectorSortState;
+
+static void reverseRange(Object** array, int lo, int hi) {
+   for (hi--; lo < hi; lo++, hi--)
+      swap(array, lo, hi);
+}
+
+/* Length of the run starting at lo, made ascending */
+static int countRun(Object** array, int lo, int hi, Object_Compare compare) {
+   int runHi = lo + 1;
+   if (runHi == hi)
+      return 1;
+
+   if (compare(array[runHi++], array[lo]) < 0) {
+      while (runHi < hi && compare(array[runHi], array[runHi - 1]) < 0)
+         runHi++;
+      reverseRange(array, lo, runHi);
+   } else {
+      while (runHi < hi && compare(array[runHi], array[runHi - 1]) >= 0)
+         runHi++;
+   }
+
+   return runHi - lo;
+}
+
+/* Sorts [lo, hi) given that [lo, start) is sorted already */
+static void binaryInsertionSort(Object** array, int lo, int hi, int start, Object_Compare compare) {
+   for (int i = start; i < hi; i++) {
+      Object* pivot = array[i];
+
+      int left = lo;
+      int right = i;
+      while (left < right) {
+         int mid = left + (right - left) / 2;
+         if (compare(pivot, array[mid]) < 0)
+            right = mid;
+         else
+            left = mid + 1;
+      }
+
+      memmove(&array[left + 1], &array[left], (size_t)(i - left) * sizeof(Object*));
+      array[left] = pivot;
+   }
+}
+
+static int minRunLength(int n) {
+   int r = 0;
+   while (n >= VECTOR_SORT_MIN_MERGE) {
+      r |= n & 1;
+      n >>= 1;
+   }
+   return n + r;
+}
+
+/* First index in [lo, hi) whose element sorts after key */
+static int upperBound(Object** array, int lo, int hi, const Object* key, Object_Compare compare) {
+   while (lo < hi) {
+      int mid = lo + (hi - lo) / 2;
+      if (compare(key, array[mid]) < 0)
+         hi = mid;
+      else
+         lo = mid + 1;
+   }
+   return lo;
+}
+
+/* First index in [lo, hi) whose element does not sort before key */
+static int lowerBound(Object** array, int lo, int hi, const Object* key, Object_Compare compare) {
+   while (lo < hi) {
+      int mid = lo + (hi - lo) / 2;
+      if (compare(array[mid], key) < 0)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   return lo;
+}
+
+static Object** VectorSortState_tmp(VectorSortState* state, int size) {
+   if (state->tmpSize < size) {
+      state->tmp = xReallocArray(state->tmp, (size_t)size, sizeof(Object*));
+      state->tmpSize = size;
+   }
+   return state->tmp;
+}
+
+static void mergeAt(VectorSortState* state, int i) {
+   Object** array = state->array;
+   Object_Compare compare = state->compare;
+
+   int baseA = state->runBase[i];
+   int lenA = state->runLen[i];
+   int baseB = state->runBase[i + 1];
+   int lenB = state->runLen[i + 1];
+
+   state->runLen[i] = lenA + lenB;
+   if (i == state->runCount - 3) {
+      state->runBase[i + 1] = state->runBase[i + 2];
+      state->runLen[i + 1] = state->runLen[i + 2];
+   }
+   state->runCount--;
+
+   /* Elements of A before the first of B, and of B after the last of A, are in place */
+   int skip = upperBound(array, baseA, baseA + lenA, array[baseB], compare) - baseA;
+   baseA += skip;
+   lenA -= skip;
+   if (lenA == 0)
+      return;
+
+   lenB = lowerBound(array, baseB, baseB + lenB, array[baseA + lenA - 1], compare) - baseB;
+   if (lenB == 0)
+      return;
+
+   if (lenA <= lenB) {
+      Object** tmp = VectorSortState_tmp(state, lenA);
+      memcpy(tmp, &array[baseA], (size_t)lenA * sizeof(Object*));
+
+      int a = 0, b = baseB, dest = baseA;
+      const int endB = baseB + lenB;
+      while (a < lenA && b < endB) {
+         if (compare(array[b], tmp[a]) < 0)
+            array[dest++] = array[b++];
+         else
+            array[dest++] = tmp[a++];
+      }
+      memcpy(&array[dest], &tmp[a], (size_t)(lenA - a) * sizeof(Object*));
+   } else {
+      Object** tmp = VectorSortState_tmp(state, lenB);
+      memcpy(tmp, &array[baseB], (size_t)lenB * sizeof(Object*));
+
+      int a = baseA + lenA - 1, b = lenB - 1, dest = baseB + lenB - 1;
+      while (a >= baseA && b >= 0) {
+         if (compare(tmp[b], array[a]) < 0)
+            array[dest--] = array[a--];
+         else
+            array[dest--] = tmp[b--];
+      }
+      memcpy(&array[baseA], tmp, (size_t)(b + 1) * sizeof(Object*));
+   }
+}
+
+static void mergeCollapse(VectorSortState* state) {
+   const int* len = state->runLen;
+
+   while (state->runCount > 1) {
+      int n = state->runCount - 2;
+      if ((n > 0 && len[n - 1] <= len[n] + len[n + 1]) || (n > 1 && len[n - 2] <= len[n - 1] + len[n])) {
+         if (len[n - 1] < len[n + 1])
+            n--;
+      } else if (len[n] > len[n + 1]) {
+         break;
+      }
+      mergeAt(state, n);
+   }
+}
+
+static void mergeForceCollapse(VectorSortState* state) {
+   while (state->runCount > 1) {
+      int n = state->runCount - 2;
+      if (n > 0 && state->runLen[n - 1] < state->runLen[n + 1])
+         n--;
+      mergeAt(state, n);
+   }
+}
+
+static void adaptiveSort(Object** array, int n, Object_Compare compare) {
+   if (n < 2)
+      return;
+
+   if (n < VECTOR_SORT_MIN_MERGE) {
+      int run = countRun(array, 0, n, compare);
+      binaryInsertionSort(array, 0, n, run, compare);
+      return;
+   }
+
+   VectorSortState state = {
+      .array = array,
+      .compare = compare,
+   };
+
+   const int minRun = minRunLength(n);
+   int lo = 0;
+   while (lo < n) {
+      int run = countRun(array, lo, n, compare);
+      if (run < minRun) {
+         int forced = MINIMUM(minRun, n - lo);
+         binaryInsertionSort(array, lo, lo + forced, lo + run, compare);
+         run = forced;
+      }
+
+      assert(state.runCount < VECTOR_SORT_MAX_RUNS);
+      state.runBase[state.runCount] = lo;
+      state.runLen[state.runCount] = run;
+      state.runCount++;
+      mergeCollapse(&state);
+
+      lo += run;
+   }
+
+   mergeForceCollapse(&state);
+   assert(state.runCount == 1 && state.runLen[0] == n);
+
+   free(state.tmp);
+}
+
+void Vector_sortCustomCompare(Vector* this, Object_Compare compare) {
+   assert(compare);
+   assert(Vector_isConsistent(this));
+   adaptiveSort(this->array, this->items, compare);
+   assert(Vector_isConsistent(this));
+}
+
+void Vector_sortRangeCustomCompare(Vector* this, int start, int end, Object_Compare compare) {
+   assert(compare);
+   assert(start >= 0 && start <= end && end <= this->items);
+   adaptiveSort(this->array + start, end - start, compare);
+}
+
+/* Bytes 0 to 3 are the tie breaker, 4 to 11 the value, least significant first */
+#define VECTOR_RADIX_DIGITS 12
+
+static inline unsigned int radixDigit(const VectorSortKey* key, int digit) {
+   if (digit < 4)
+      return (key->tieBreak >> (8 * digit)) & 0xFF;
+
+   return (key->value >> (8 * (digit - 4))) & 0xFF;
+}
+
+/* Sorts the n keys, returns whichever of keys and scratch ends up holding them */
+static VectorSortKey* radixSortKeys(VectorSortKey* keys, VectorSortKey* scratch, size_t n) {
+   if (n < 2)
+      return keys;
+
+   /* all histograms in one pass over the keys */
+   size_t count[VECTOR_RADIX_DIGITS][256] = {{0}};
+   for (size_t i = 0; i < n; i++) {
+      for (int d = 0; d < VECTOR_RADIX_DIGITS; d++)
+         count[d][radixDigit(&keys[i], d)]++;
+   }
+
+   VectorSortKey* src = keys;
+   VectorSortKey* dst = scratch;
+   for (int d = 0; d < VECTOR_RADIX_DIGITS; d++) {
+      /* a digit shared by all keys does not reorder anything */
+      if (count[d][radixDigit(&src[0], d)] == (size_t)n)
+         continue;
+
+      size_t offset[256];
+      size_t sum = 0;
+      for (int b = 0; b < 256; b++) {
+         offset[b] = sum;
+         sum += count[d][b];
+      }
+
+      for (size_t i = 0; i < n; i++)
+         dst[offset[radixDigit(&src[i], d)]++] = src[i];
+
+      VectorSortKey* tmp = src;
+      src = dst;
+      dst = tmp;
+   }
+
+   return src;
+}
+
+const VectorSortKey* Vector_radixSort(Vector* this, VectorSortKey* keys, VectorSortKey* scratch) {
+   assert(Vector_isConsistent(this));
+
+   const int n = this->items;
+   const VectorSortKey* sorted = radixSortKeys(keys, scratch, (size_t)n);
+
+   for (int i = 0; i < n; i++)
+      this->array[i] = sorted[i].item;
+
+   assert(Vector_isConsistent(this));
+   return sorted;
+}
+
+static inline bool keyGreater(const VectorSortKey* a, const VectorSortKey* b) {
+   return a->value != b->value ? a->value > b->value : a->tieBreak > b->tieBreak;
+}
+
+/* Buckets per thread of a parallel sort; more than one evens out their sizes */
+#define VECTOR_SAMPLE_BUCKETS_PER_THREAD 4
+#define VECTOR_SAMPLE_MAX_BUCKETS 256  /* bucket numbers fit into a byte */
+
+/* Keys sampled per bucket to choose the bounds of the buckets from */
+#define VECTOR_SAMPLES_PER_BUCKET 16
+
+typedef struct SampleSort_ {
+   Vector* vector;
+   VectorSortKey* keys;
+   VectorSortKey* scratch;
+   size_t n;
+   size_t buckets;                 /* also the number of slices the keys are counted in */
+   VectorSortKey bounds[VECTOR_SAMPLE_MAX_BUCKETS - 1];  /* smallest key of each bucket but the first */
+   size_t* slots;                  /* [slice][bucket] number of keys, then where the next of them goes */
+   size_t* bucketStart;            /* buckets + 1 entries */
+   uint8_t* bucketOf;              /* of each key, found while counting */
+} SampleSort;
+
+static inline size_t SampleSort_slice(const SampleSort* this, size_t slice) {
+   return this->n * slice / this->buckets;
+}
+
+static size_t SampleSort_bucket(const SampleSort* this, const VectorSortKey* key) {
+   size_t lo = 0;
+   size_t hi = this->buckets - 1;
+   while (lo < hi) {
+      const size_t mid = lo + (hi - lo) / 2;
+      if (keyGreater(&this->bounds[mid], key))
+         hi = mid;
+      else
+         lo = mid + 1;
+   }
+   return lo;
+}
+
+static void SampleSort_count(void* data, size_t slice) {
+   SampleSort* this = data;
+   size_t* slots = &this->slots[slice * this->buckets];
+   for (size_t i = SampleSort_slice(this, slice); i < SampleSort_slice(this, slice + 1); i++) {
+      const size_t bucket = SampleSort_bucket(this, &this->keys[i]);
+      this->bucketOf[i] = (uint8_t)bucket;
+      slots[bucket]++;
+   }
+}
+
+static void SampleSort_scatter(void* data, size_t slice) {
+   SampleSort* this = data;
+   size_t* slots = &this->slots[slice * this->buckets];
+   for (size_t i = SampleSort_slice(this, slice); i < SampleSort_slice(this, slice + 1); i++)
+      this->scratch[slots[this->bucketOf[i]]++] = this->keys[i];
+}
+
+static void SampleSort_sortBucket(void* data, size_t bucket) {
+   SampleSort* this = data;
+   const size_t start = this->bucketStart[bucket];
+   const size_t size = this->bucketStart[bucket + 1] - start;
+
+   const VectorSortKey* sorted = radixSortKeys(this->scratch + start, this->keys + start, size);
+   if (sorted != this->keys + start)
+      memcpy(this->keys + start, sorted, size * sizeof(VectorSortKey));
+
+   for (size_t i = 0; i < size; i++)
+      this->vector->array[start + i] = this->keys[start + i].item;
+}
+
+/*
+ * A sample sort: the bounds of the buckets are taken from keys sampled at
+ * fixed positions, each slice of the keys is counted and then moved into
+ * the buckets, in its own job, and each bucket is radix sorted by a job.
+ * Every step depends on the keys and their order alone, so the result is
+ * the same as that of Vector_radixSort, however the jobs are run.
+ */
+const VectorSortKey* Vector_parallelRadixSort(Vector* this, VectorSortKey* keys, VectorSortKey* scratch, const VectorRunner* runner) {
+   assert(Vector_isConsistent(this));
+
+   const size_t n = (size_t)this->items;
+   size_t buckets = ((size_t)runner->workers + 1) * VECTOR_SAMPLE_BUCKETS_PER_THREAD;
+   buckets = MINIMUM(buckets, (size_t)VECTOR_SAMPLE_MAX_BUCKETS);
+   const size_t samples = buckets * VECTOR_SAMPLES_PER_BUCKET;
+   if (n < 2 * samples)
+      return Vector_radixSort(this, keys, scratch);
+
+   SampleSort sort = {
+      .vector = this,
+      .keys = keys,
+      .scratch = scratch,
+      .n = n,
+      .buckets = buckets,
+   };
+
+   /* the scratch space is not needed before the keys are moved into the buckets */
+   for (size_t i = 0; i < samples; i++)
+      scratch[i] = keys[n * i / samples];
+   const VectorSortKey* sorted = radixSortKeys(scratch, scratch + samples, samples);
+   for (size_t b = 1; b < buckets; b++)
+      sort.bounds[b - 1] = sorted[b * VECTOR_SAMPLES_PER_BUCKET];
+
+   sort.slots = xCalloc(buckets * buckets, sizeof(size_t));
+   sort.bucketStart = xMallocArray(buckets + 1, sizeof(size_t));
+   sort.bucketOf = xMalloc(n);
+
+   runner->run(runner->context, SampleSort_count, &sort, buckets);
+
+   /* within a bucket the keys of each slice follow those of the slices before it */
+   size_t offset = 0;
+   for (size_t b = 0; b < buckets; b++) {
+      sort.bucketStart[b] = offset;
+      for (size_t slice = 0; slice < buckets; slice++) {
+         const size_t count = sort.slots[slice * buckets + b];
+         sort.slots[slice * buckets + b] = offset;
+         offset += count;
+      }
+   }
+   sort.bucketStart[buckets] = offset;
+   assert(offset == n);
+
+   runner->run(runner->context, SampleSort_scatter, &sort, buckets);
+   runner->run(runner->context, SampleSort_sortBucket, &sort, buckets);
+
+   free(sort.slots);
+   free(sort.bucketStart);
+   free(sort.bucketOf);
+
+   assert(Vector_isConsistent(this));
+   return keys;
+}
+
+static void heapSiftDown(Object** heap, int i, int size, Object_Compare compare) {
+   for (;;) {
+      int largest = i;
+      const int left = 2 * i + 1;
+      const int right = left + 1;
+      if (left < size && compare(heap[left], heap[largest]) > 0)
+         largest = left;
+      if (right < size && compare(heap[right], heap[largest]) > 0)
+         largest = right;
+      if (largest == i)
+         return;
+
+      swap(heap, i, largest);
+      i = largest;
+   }
+}
+
+void Vector_partialSortCustomCompare(Vector* this, int k, Object_Compare compare) {
+   assert(compare);
+   assert(Vector_isConsistent(this));
+
+   Object** array = this->array;
+   const int n = this->items;
+   if (k >= n) {
+      adaptiveSort(array, n, compare);
+      return;
+   }
+   if (k <= 0)
+      return;
+
+   /* a max-heap of the k smallest items seen so far, its root is the one to beat */
+   for (int i = k / 2 - 1; i >= 0; i--)
+      heapSiftDown(array, i, k, compare);
+
+   for (int i = k; i < n; i++) {
+      if (compare(array[i], array[0]) < 0) {
+         swap(array, 0, i);
+         heapSiftDown(array, 0, k, compare);
+      }
+   }
+
+   adaptiveSort(array, k, compare);
+   assert(Vector_isConsistent(this));
+}
+
+static void keyHeapSiftDown(VectorSortKey* heap, int i, int size) {
+   for (;;) {
+      int largest = i;
+      const int left = 2 * i + 1;
+      const int right = left + 1;
+      if (left < size && keyGreater(&heap[left], &heap[largest]))
+         largest = left;
+      if (right < size && keyGreater(&heap[right], &heap[largest]))
+         largest = right;
+      if (largest == i)
+         return;
+
+      VectorSortKey tmp = heap[i];
+      heap[i] = heap[largest];
+      heap[largest] = tmp;
+      i = largest;
+   }
+}
+
+void Vector_partialKeySort(Vector* this, VectorSortKey* keys, int k) {
+   assert(Vector_isConsistent(this));
+
+   const int n = this->items;
+   assert(k > 0 && k < n);
+
+   for (int i = k / 2 - 1; i >= 0; i--)
+      keyHeapSiftDown(keys, i, k);
+
+   for (int i = k; i < n; i++) {
+      if (keyGreater(&keys[0], &keys[i])) {
+         VectorSortKey tmp = keys[0];
+         keys[0] = keys[i];
+         keys[i] = tmp;
+         keyHeapSiftDown(keys, 0, k);
+      }
+   }
+
+   /* heap sort of the k smallest, taking the largest off the heap to its end */
+   for (int end = k - 1; end > 0; end--) {
+      VectorSortKey tmp = keys[0];
+      keys[0] = keys[end];
+      keys[end] = tmp;
+      keyHeapSiftDown(keys, 0, end);
+   }
+
+   for (int i = 0; i < n; i++)
+      this->array[i] = keys[i].item;
+
+   assert(Vector_isConsistent(this));
+}
+
 void Vector_quickSortCustomCompare(Vector* this, Object_Compare compare) {
    assert(compare);
    assert(Vector_isConsistent(this));
@@ -10,6 +10,8 @@ in the source distribution for its full text.
 #include "Object.h"
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 
 #ifndef DEFAULT_SIZE
@@ -36,6 +38,49 @@ void Vector_delete(Vector* this);
 
 void Vector_prune(Vector* this);
 
+/* Stable and adaptive, close to linear on nearly sorted input */
+void Vector_sortCustomCompare(Vector* this, Object_Compare compare);
+static inline void Vector_sort(Vector* this) {
+   Vector_sortCustomCompare(this, this->type->compare);
+}
+
+/* Sorts the items in [start, end) only */
+void Vector_sortRangeCustomCompare(Vector* this, int start, int end, Object_Compare compare);
+
+/* Precomputed key of one item for Vector_radixSort */
+typedef struct VectorSortKey_ {
+   uint64_t value;
+   uint32_t tieBreak;
+   Object* item;
+} VectorSortKey;
+
+/* Stores the items of keys[], one per item of the vector, ordered by value and
+   then tieBreak. keys and scratch (of the same length) are clobbered; returns
+   whichever of them ends up holding the sorted keys */
+const VectorSortKey* Vector_radixSort(Vector* this, VectorSortKey* keys, VectorSortKey* scratch);
+
+/* Runs job(data, 0) to job(data, count - 1), possibly at the same time on
+   several threads, and returns once all of them are done */
+typedef void (*Vector_Job)(void* data, size_t index);
+typedef void (*Vector_RunJobs)(void* context, Vector_Job job, void* data, size_t count);
+
+typedef struct VectorRunner_ {
+   Vector_RunJobs run;
+   void* context;
+   unsigned int workers;    /* threads running jobs besides the calling one */
+} VectorRunner;
+
+/* Like Vector_radixSort, with the work split into jobs for the runner;
+   returns keys, holding the sorted keys */
+const VectorSortKey* Vector_parallelRadixSort(Vector* this, VectorSortKey* keys, VectorSortKey* scratch, const VectorRunner* runner);
+
+/* Moves the k smallest items, sorted, to the front; the others follow in no particular order */
+void Vector_partialSortCustomCompare(Vector* this, int k, Object_Compare compare);
+
+/* Like Vector_radixSort for the k smallest of the keys only (0 < k < size),
+   the other items follow in no particular order */
+void Vector_partialKeySort(Vector* this, VectorSortKey* keys, int k);
+
 void Vector_quickSortCustomCompare(Vector* this, Object_Compare compare);
 static inline void Vector_quickSort(Vector* this) {
    Vector_quickSortCustomCompare(this, this->type->compare);
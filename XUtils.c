@@ -7,6 +7,9 @@ in the source distribution for its full text.
 
 #include "config.h" // IWYU pragma: keep
 
+/* the allocations of the string functions, the others pass on their caller's class */
+#define HEAP_CLASS HEAP_STRINGS
+
 #include "XUtils.h"
 
 #include <assert.h>
@@ -18,6 +21,7 @@ in the source distribution for its full text.
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/resource.h>
 
 #include "CRT.h"
 #include "Macros.h"
@@ -30,25 +34,47 @@ void fail(void) {
    _exit(1); // Should never reach here
 }
 
-void* xMalloc(size_t size) {
+#ifdef HEAP_ACCOUNTING
+
+#define HEAP_CLASS_ARG , heapClass
+#define HEAP_TRACK(ptr, size, heapClass) Heap_track(ptr, size, heapClass)
+#define HEAP_FORGET(ptr) Heap_forget(ptr)
+
+void xFree(void* ptr) {
+   Heap_forget(ptr);
+   (free)(ptr);
+}
+
+#else
+
+#define HEAP_CLASS_ARG
+#define HEAP_TRACK(ptr, size, heapClass) ((void)0)
+#define HEAP_FORGET(ptr) ((void)0)
+
+#endif
+
+/* The names are parenthesized against the macros passing the class of the call site */
+
+void* (xMalloc)(size_t size HEAP_CLASS_PARAM) {
    assert(size > 0);
    void* data = malloc(size);
    if (!data) {
       fail();
    }
+   HEAP_TRACK(data, size, heapClass);
    return data;
 }
 
-void* xMallocArray(size_t nmemb, size_t size) {
+void* (xMallocArray)(size_t nmemb, size_t size HEAP_CLASS_PARAM) {
    assert(nmemb > 0);
    assert(size > 0);
    if (SIZE_MAX / nmemb < size) {
       fail();
    }
-   return xMalloc(nmemb * size);
+   return (xMalloc)(nmemb * size HEAP_CLASS_ARG);
 }
 
-void* xCalloc(size_t nmemb, size_t size) {
+void* (xCalloc)(size_t nmemb, size_t size HEAP_CLASS_PARAM) {
    assert(nmemb > 0);
    assert(size > 0);
    if (SIZE_MAX / nmemb < size) {
@@ -58,36 +84,39 @@ void* xCalloc(size_t nmemb, size_t size) {
    if (!data) {
       fail();
    }
+   HEAP_TRACK(data, nmemb * size, heapClass);
    return data;
 }
 
-void* xRealloc(void* ptr, size_t size) {
+void* (xRealloc)(void* ptr, size_t size HEAP_CLASS_PARAM) {
    assert(size > 0);
+   HEAP_FORGET(ptr);
    void* data = realloc(ptr, size); // deepcode ignore MemoryLeakOnRealloc: this goes to fail()
    if (!data) {
       free(ptr);
       fail();
    }
+   HEAP_TRACK(data, size, heapClass);
    return data;
 }
 
-void* xReallocArray(void* ptr, size_t nmemb, size_t size) {
+void* (xReallocArray)(void* ptr, size_t nmemb, size_t size HEAP_CLASS_PARAM) {
    assert(nmemb > 0);
    assert(size > 0);
    if (SIZE_MAX / nmemb < size) {
       fail();
    }
-   return xRealloc(ptr, nmemb * size);
+   return (xRealloc)(ptr, nmemb * size HEAP_CLASS_ARG);
 }
 
-void* xReallocArrayZero(void* ptr, size_t prevmemb, size_t newmemb, size_t size) {
+void* (xReallocArrayZero)(void* ptr, size_t prevmemb, size_t newmemb, size_t size HEAP_CLASS_PARAM) {
    assert((ptr == NULL) == (prevmemb == 0));
 
    if (prevmemb == newmemb) {
       return ptr;
    }
 
-   void* ret = xReallocArray(ptr, newmemb, size);
+   void* ret = (xReallocArray)(ptr, newmemb, size HEAP_CLASS_ARG);
 
    if (newmemb > prevmemb) {
       memset((unsigned char*)ret + prevmemb * size, '\0', (newmemb - prevmemb) * size);
@@ -226,10 +255,94 @@ int xAsprintf(char** strp, const char* fmt, ...) {
    if (r < 0 || !*strp) {
       fail();
    }
+   HEAP_TRACK(*strp, (size_t)r + 1, HEAP_CLASS);
 
    return r;
 }
 
+static const char String_digitPairs[] =
+   "00010203040506070809"
+   "10111213141516171819"
+   "20212223242526272829"
+   "30313233343536373839"
+   "40414243444546474849"
+   "50515253545556575859"
+   "60616263646566676869"
+   "70717273747576777879"
+   "80818283848586878889"
+   "90919293949596979899";
+
+/* Writes the decimal digits of `value` backwards from `end`, two at a time; returns where they start */
+static char* String_writeDigits(char* end, unsigned long long value) {
+   char* p = end;
+   while (value >= 100) {
+      const unsigned int pair = (unsigned int)(value % 100) * 2;
+      value /= 100;
+      p -= 2;
+      memcpy(p, &String_digitPairs[pair], 2);
+   }
+
+   if (value >= 10) {
+      p -= 2;
+      memcpy(p, &String_digitPairs[value * 2], 2);
+   } else {
+      *--p = (char)('0' + value);
+   }
+   return p;
+}
+
+static int String_writePadded(char* buf, size_t len, const char* digits, size_t n, int width, char pad) {
+   const size_t padding = width > 0 && (size_t)width > n ? (size_t)width - n : 0;
+   if (padding + n >= len) {
+      fail();
+   }
+
+   memset(buf, pad, padding);
+   memcpy(buf + padding, digits, n);
+   buf[padding + n] = '\0';
+   return (int)(padding + n);
+}
+
+int String_formatUnsigned(char* buf, size_t len, unsigned long long value, int width, char pad) {
+   char digits[20];
+   char* end = digits + sizeof(digits);
+   const char* start = String_writeDigits(end, value);
+   return String_writePadded(buf, len, start, (size_t)(end - start), width, pad);
+}
+
+int String_formatDouble(char* buf, size_t len, double value, int decimals, int width) {
+   static const unsigned int scales[] = { 1, 10, 100, 1000 };
+   assert(decimals >= 0 && (size_t)decimals < ARRAYSIZE(scales));
+
+   /* negative, non-finite and values beyond the exact integers of a double are rare enough for printf */
+   const double scaled = value * scales[decimals];
+   if (!(scaled >= 0.0 && scaled < 4503599627370496.0))
+      return xSnprintf(buf, len, "%*.*f", width, decimals, value);
+
+   /* rint rounds exact halves to even like printf; when only the product landed on a half, its error decides */
+   double rounded = rint(scaled);
+   if (isgreaterequal(fabs(scaled - rounded), 0.5)) {
+      const double error = fma(value, scales[decimals], -scaled);
+      if (error > 0.0)
+         rounded = ceil(scaled);
+      else if (error < 0.0)
+         rounded = floor(scaled);
+   }
+   unsigned long long number = (unsigned long long)rounded;
+   char digits[24];
+   char* end = digits + sizeof(digits);
+   char* start = end;
+   if (decimals > 0) {
+      for (int i = 0; i < decimals; i++) {
+         *--start = (char)('0' + number % 10);
+         number /= 10;
+      }
+      *--start = '.';
+   }
+   start = String_writeDigits(start, number);
+   return String_writePadded(buf, len, start, (size_t)(end - start), width, ' ');
+}
+
 int xSnprintf(char* buf, size_t len, const char* fmt, ...) {
    va_list vl;
    va_start(vl, fmt);
@@ -248,6 +361,7 @@ char* xStrdup(const char* str) {
    if (!data) {
       fail();
    }
+   HEAP_TRACK(data, strlen(data) + 1, HEAP_CLASS);
    return data;
 }
 
@@ -264,6 +378,7 @@ char* xStrndup(const char* str, size_t len) {
    if (!data) {
       fail();
    }
+   HEAP_TRACK(data, strlen(data) + 1, HEAP_CLASS);
    return data;
 }
 
@@ -343,6 +458,35 @@ ssize_t full_write(int fd, const void* buf, size_t count) {
    return written;
 }
 
+/* The limit of open files before it was raised, valid when raised */
+static struct rlimit fileLimit;
+static bool fileLimitRaised;
+
+rlim_t raiseFileLimit(rlim_t wanted) {
+   struct rlimit rl;
+   if (getrlimit(RLIMIT_NOFILE, &rl) != 0)
+      return 0;
+
+   /* The hard limit may be RLIM_INFINITY, which the kernel refuses for RLIMIT_NOFILE */
+   wanted = MINIMUM(wanted, rl.rlim_max);
+   if (rl.rlim_cur < wanted) {
+      const struct rlimit raised = { .rlim_cur = wanted, .rlim_max = rl.rlim_max };
+      if (setrlimit(RLIMIT_NOFILE, &raised) == 0) {
+         if (!fileLimitRaised)
+            fileLimit = rl;
+         fileLimitRaised = true;
+         rl.rlim_cur = wanted;
+      }
+   }
+
+   return rl.rlim_cur;
+}
+
+void restoreFileLimit(void) {
+   if (fileLimitRaised)
+      (void) setrlimit(RLIMIT_NOFILE, &fileLimit);
+}
+
 /* Compares floating point values for ordering data entries. In this function,
    NaN is considered "less than" any other floating point value (regardless of
    sign), and two NaNs are considered "equal" regardless of payload. */
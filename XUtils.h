@@ -16,27 +16,60 @@ in the source distribution for its full text.
 
 #include <stdbool.h>
 #include <stddef.h> // IWYU pragma: keep
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h> // IWYU pragma: keep
 #include <string.h> // IWYU pragma: keep
+#include <sys/resource.h>
 
 #include "Compat.h"
+#include "Heap.h"
 #include "Macros.h"
 
 
+#ifdef HEAP_ACCOUNTING
+
+/* The class the allocations of a file are accounted to, see Heap.h */
+#ifndef HEAP_CLASS
+#define HEAP_CLASS HEAP_OTHER
+#endif
+
+#define HEAP_CLASS_PARAM , HeapClass heapClass
+
+#else
+
+#define HEAP_CLASS_PARAM
+
+#endif
+
 void fail(void) ATTR_NORETURN;
 
-void* xMalloc(size_t size) ATTR_ALLOC_SIZE1(1) ATTR_MALLOC;
+void* xMalloc(size_t size HEAP_CLASS_PARAM) ATTR_ALLOC_SIZE1(1) ATTR_MALLOC;
+
+void* xMallocArray(size_t nmemb, size_t size HEAP_CLASS_PARAM) ATTR_ALLOC_SIZE2(1, 2) ATTR_MALLOC;
+
+void* xCalloc(size_t nmemb, size_t size HEAP_CLASS_PARAM) ATTR_ALLOC_SIZE2(1, 2) ATTR_MALLOC;
 
-void* xMallocArray(size_t nmemb, size_t size) ATTR_ALLOC_SIZE2(1, 2) ATTR_MALLOC;
+void* xRealloc(void* ptr, size_t size HEAP_CLASS_PARAM) ATTR_ALLOC_SIZE1(2);
 
-void* xCalloc(size_t nmemb, size_t size) ATTR_ALLOC_SIZE2(1, 2) ATTR_MALLOC;
+void* xReallocArray(void* ptr, size_t nmemb, size_t size HEAP_CLASS_PARAM) ATTR_ALLOC_SIZE2(2, 3);
 
-void* xRealloc(void* ptr, size_t size) ATTR_ALLOC_SIZE1(2);
+void* xReallocArrayZero(void* ptr, size_t prevmemb, size_t newmemb, size_t size HEAP_CLASS_PARAM) ATTR_ALLOC_SIZE2(3, 4);
 
-void* xReallocArray(void* ptr, size_t nmemb, size_t size) ATTR_ALLOC_SIZE2(2, 3);
+#ifdef HEAP_ACCOUNTING
 
-void* xReallocArrayZero(void* ptr, size_t prevmemb, size_t newmemb, size_t size) ATTR_ALLOC_SIZE2(3, 4);
+/* free() of the blocks accounted */
+void xFree(void* ptr);
+
+#define xMalloc(size) xMalloc(size, HEAP_CLASS)
+#define xMallocArray(nmemb, size) xMallocArray(nmemb, size, HEAP_CLASS)
+#define xCalloc(nmemb, size) xCalloc(nmemb, size, HEAP_CLASS)
+#define xRealloc(ptr, size) xRealloc(ptr, size, HEAP_CLASS)
+#define xReallocArray(ptr, nmemb, size) xReallocArray(ptr, nmemb, size, HEAP_CLASS)
+#define xReallocArrayZero(ptr, prevmemb, newmemb, size) xReallocArrayZero(ptr, prevmemb, newmemb, size, HEAP_CLASS)
+#define free(ptr) xFree(ptr)
+
+#endif
 
 /*
  * String_startsWith gives better performance if strlen(match) can be computed
@@ -80,11 +113,62 @@ static inline char* String_strchrnul(const char* s, int c) {
 #endif
 }
 
+/* Parse unsigned numbers without locale or overflow checks, advancing *str; maxlen 0 means unlimited */
+static inline uint64_t fast_strtoull_dec(char** str, int maxlen) {
+   register uint64_t result = 0;
+
+   if (!maxlen)
+      --maxlen;
+
+   while (maxlen-- && **str >= '0' && **str <= '9') {
+      result *= 10;
+      result += **str - '0';
+      (*str)++;
+   }
+
+   return result;
+}
+
+static inline uint64_t fast_strtoull_hex(char** str, int maxlen) {
+   register uint64_t result = 0;
+   register int nibble, letter;
+   const long valid_mask = 0x03FF007E;
+
+   if (!maxlen)
+      --maxlen;
+
+   while (maxlen--) {
+      nibble = (unsigned char)**str;
+      if (!(valid_mask & (1 << (nibble & 0x1F))))
+         break;
+      if ((nibble < '0') || (nibble & ~0x20) > 'F')
+         break;
+      letter = (nibble & 0x40) ? 'A' - '9' - 1 : 0;
+      nibble &=~0x20; // to upper
+      nibble ^= 0x10; // switch letters and digits
+      nibble -= letter;
+      nibble &= 0x0f;
+      result <<= 4;
+      result += (uint64_t)nibble;
+      (*str)++;
+   }
+
+   return result;
+}
+
 /* Always null-terminates dest. Caller must pass a strictly positive size. */
 ATTR_ACCESS3_W(1, 3)
 ATTR_ACCESS3_R(2, 3)
 size_t String_safeStrncpy(char* restrict dest, const char* restrict src, size_t size);
 
+/* Like xSnprintf(buf, len, "%*llu", width, value), or "%0*llu" if `pad` is '0', without going through the locale */
+ATTR_ACCESS3_W(1, 2)
+int String_formatUnsigned(char* buf, size_t len, unsigned long long value, int width, char pad);
+
+/* Like xSnprintf(buf, len, "%*.*f", width, decimals, value) for 0 to 3 decimals, rounding the scaled value to even */
+ATTR_ACCESS3_W(1, 2)
+int String_formatDouble(char* buf, size_t len, double value, int decimals, int width);
+
 ATTR_FORMAT(printf, 2, 3)
 ATTR_NONNULL_N(1, 2)
 int xAsprintf(char** strp, const char* fmt, ...);
@@ -107,6 +191,14 @@ ssize_t xReadfileat(openat_arg_t dirfd, const char* pathname, void* buffer, size
 ATTR_ACCESS3_R(2, 3)
 ssize_t full_write(int fd, const void* buf, size_t count);
 
+/* Raises the soft limit of open files towards `wanted`, as far as the hard
+   limit allows. Returns the soft limit in effect, 0 if it is not known. */
+rlim_t raiseFileLimit(rlim_t wanted);
+
+/* Puts back the soft limit of open files found before raiseFileLimit(), for
+   a child about to exec a program not expecting that many. */
+void restoreFileLimit(void);
+
 /* Compares floating point values for ordering data entries. In this function,
    NaN is considered "less than" any other floating point value (regardless of
    sign), and two NaNs are considered "equal" regardless of payload. */
@@ -0,0 +1,222 @@
+/*
+htop - darwin/CPUClusterMeter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "darwin/CPUClusterMeter.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "CPUMeter.h"
+#include "CRT.h"
+#include "Macros.h"
+#include "Object.h"
+#include "Platform.h"
+#include "ProvideCurses.h"
+#include "XUtils.h"
+
+#include "darwin/DarwinMachine.h"
+
+
+/* The clusters of Apple Silicon: the use of each, or of the CPUs of one kind */
+
+typedef struct CPUClusterMeterData_ {
+   Meter** meters;             /* one per cluster, or one per CPU of the kind */
+   unsigned int count;
+} CPUClusterMeterData;
+
+/* 'P' or 'E' for the meters of the CPUs of one kind, 0 for the one of all clusters */
+static char CPUClusterMeter_kind(const Meter* this) {
+   const MeterClass* type = As_Meter(this);
+   if (type == &PerformanceCPUsMeter_class)
+      return 'P';
+   if (type == &EfficiencyCPUsMeter_class)
+      return 'E';
+   return 0;
+}
+
+static int CPUClusterMeter_columns(unsigned int count) {
+   return count <= 4 ? 1 : count <= 16 ? 2 : 4;
+}
+
+static void CPUClusterMeter_init(Meter* this) {
+   const DarwinMachine* dhost = (const DarwinMachine*) this->host;
+   CPUClusterMeterData* data = this->meterData;
+   if (!data) {
+      const char kind = CPUClusterMeter_kind(this);
+      data = this->meterData = xCalloc(1, sizeof(CPUClusterMeterData));
+
+      for (unsigned int c = 0; c < dhost->clusterCount; c++) {
+         if (!kind)
+            data->count++;
+         else if (dhost->clusters[c].kind == kind)
+            data->count += dhost->clusters[c].cpus;
+      }
+
+      data->meters = xCalloc(MAXIMUM(data->count, 1), sizeof(Meter*));
+      unsigned int n = 0;
+      unsigned int perKind[2] = { 0, 0 };
+      for (unsigned int c = 0; c < dhost->clusterCount; c++) {
+         const DarwinCPUCluster* cluster = &dhost->clusters[c];
+         if (!kind) {
+            /* the values are set here, the CPU meter only draws them */
+            Meter* meter = Meter_new(this->host, 0, (const MeterClass*) Class(CPUMeter));
+            char caption[10];
+            xSnprintf(caption, sizeof(caption), "%c%-2u", cluster->kind, perKind[cluster->kind == 'E']++);
+            Meter_setCaption(meter, caption);
+            data->meters[n++] = meter;
+         } else if (cluster->kind == kind) {
+            for (unsigned int i = 0; i < cluster->cpus; i++)
+               data->meters[n++] = Meter_new(this->host, cluster->firstCPU + i + 1, (const MeterClass*) Class(CPUMeter));
+         }
+      }
+   }
+
+   if (this->mode == 0)
+      this->mode = BAR_METERMODE;
+
+   /* without clusters the meter keeps one row, telling so */
+   int ncol = CPUClusterMeter_columns(data->count);
+   this->h = Meter_modes[this->mode]->h * MAXIMUM(((int)data->count + ncol - 1) / ncol, 1);
+}
+
+static void CPUClusterMeter_updateMode(Meter* this, int mode) {
+   CPUClusterMeterData* data = this->meterData;
+   this->mode = mode;
+   for (unsigned int i = 0; i < data->count; i++)
+      Meter_setMode(data->meters[i], mode);
+
+   int ncol = CPUClusterMeter_columns(data->count);
+   this->h = Meter_modes[mode]->h * MAXIMUM(((int)data->count + ncol - 1) / ncol, 1);
+}
+
+/* Averages the values of the CPUs of a cluster into its meter */
+static void CPUClusterMeter_setClusterValues(Meter* meter, const DarwinCPUCluster* cluster) {
+   double sums[CPU_METER_ITEMCOUNT] = { 0 };
+   double percent = 0.0;
+
+   for (unsigned int i = 0; i < cluster->cpus; i++) {
+      percent += Platform_setCPUValues(meter, cluster->firstCPU + i + 1);
+      sums[CPU_METER_NICE]   += meter->values[CPU_METER_NICE];
+      sums[CPU_METER_NORMAL] += meter->values[CPU_METER_NORMAL];
+      sums[CPU_METER_KERNEL] += meter->values[CPU_METER_KERNEL];
+   }
+
+   meter->values[CPU_METER_NICE]   = sums[CPU_METER_NICE]   / cluster->cpus;
+   meter->values[CPU_METER_NORMAL] = sums[CPU_METER_NORMAL] / cluster->cpus;
+   meter->values[CPU_METER_KERNEL] = sums[CPU_METER_KERNEL] / cluster->cpus;
+   meter->values[CPU_METER_FREQUENCY] = NAN;
+   meter->values[CPU_METER_TEMPERATURE] = NAN;
+   meter->curItems = 3;
+
+   xSnprintf(meter->txtBuffer, sizeof(meter->txtBuffer), "%.1f%%", percent / cluster->cpus);
+}
+
+static void CPUClusterMeter_updateValues(Meter* this) {
+   const DarwinMachine* dhost = (const DarwinMachine*) this->host;
+   CPUClusterMeterData* data = this->meterData;
+
+   if (data->count == 0) {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "no CPU clusters");
+      return;
+   }
+
+   if (CPUClusterMeter_kind(this)) {
+      for (unsigned int i = 0; i < data->count; i++)
+         Meter_updateValues(data->meters[i]);
+      return;
+   }
+
+   for (unsigned int c = 0; c < data->count; c++)
+      CPUClusterMeter_setClusterValues(data->meters[c], &dhost->clusters[c]);
+}
+
+static void CPUClusterMeter_draw(Meter* this, int x, int y, int w) {
+   const CPUClusterMeterData* data = this->meterData;
+   if (data->count == 0) {
+      attrset(CRT_colors[METER_SHADOW]);
+      mvaddnstr(y, x, this->txtBuffer, w);
+      attrset(CRT_colors[RESET_COLOR]);
+      return;
+   }
+
+   int ncol = CPUClusterMeter_columns(data->count);
+   int colwidth = (w - ncol) / ncol + 1;
+   int diff = w - colwidth * ncol;
+   int nrows = ((int)data->count + ncol - 1) / ncol;
+   for (int i = 0; i < (int)data->count; i++) {
+      Meter* meter = data->meters[i];
+      int d = MINIMUM(i / nrows, diff); // dynamic spacer, as for the other CPU meters
+      meter->draw(meter, x + (i / nrows) * colwidth + d, y + (i % nrows) * meter->h, colwidth);
+   }
+}
+
+static void CPUClusterMeter_done(Meter* this) {
+   CPUClusterMeterData* data = this->meterData;
+   for (unsigned int i = 0; i < data->count; i++)
+      Meter_delete((Object*)data->meters[i]);
+   free(data->meters);
+   free(data);
+}
+
+const MeterClass CPUClustersMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+   },
+   .updateValues = CPUClusterMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .isMultiColumn = true,
+   .total = 100.0,
+   .name = "CPUClusters",
+   .uiName = "CPU clusters",
+   .description = "CPU clusters: average use of the CPUs of each P- and E-core cluster (Apple Silicon)",
+   .caption = "CPU",
+   .draw = CPUClusterMeter_draw,
+   .init = CPUClusterMeter_init,
+   .updateMode = CPUClusterMeter_updateMode,
+   .done = CPUClusterMeter_done
+};
+
+const MeterClass PerformanceCPUsMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+   },
+   .updateValues = CPUClusterMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .isMultiColumn = true,
+   .total = 100.0,
+   .name = "PerformanceCPUs",
+   .uiName = "CPUs (P-cores)",
+   .description = "CPUs (P-cores): the CPUs of the performance clusters (Apple Silicon)",
+   .caption = "CPU",
+   .draw = CPUClusterMeter_draw,
+   .init = CPUClusterMeter_init,
+   .updateMode = CPUClusterMeter_updateMode,
+   .done = CPUClusterMeter_done
+};
+
+const MeterClass EfficiencyCPUsMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+   },
+   .updateValues = CPUClusterMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .isMultiColumn = true,
+   .total = 100.0,
+   .name = "EfficiencyCPUs",
+   .uiName = "CPUs (E-cores)",
+   .description = "CPUs (E-cores): the CPUs of the efficiency clusters (Apple Silicon)",
+   .caption = "CPU",
+   .draw = CPUClusterMeter_draw,
+   .init = CPUClusterMeter_init,
+   .updateMode = CPUClusterMeter_updateMode,
+   .done = CPUClusterMeter_done
+};
@@ -0,0 +1,19 @@
+#ifndef HEADER_CPUClusterMeter
+#define HEADER_CPUClusterMeter
+/*
+htop - darwin/CPUClusterMeter.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "Meter.h"
+
+
+extern const MeterClass CPUClustersMeter_class;
+
+extern const MeterClass PerformanceCPUsMeter_class;
+
+extern const MeterClass EfficiencyCPUsMeter_class;
+
+#endif
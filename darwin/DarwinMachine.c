@@ -19,6 +19,8 @@ in the source distribution for its full text.
 
 #include "CRT.h"
 #include "Machine.h"
+#include "Macros.h"
+#include "XUtils.h"
 #include "darwin/Platform.h"
 #include "darwin/PlatformHelpers.h"
 #include "generic/openzfs_sysctl.h"
@@ -59,6 +61,68 @@ static unsigned DarwinMachine_allocateCPULoadInfo(processor_cpu_load_info_t* p)
    return cpu_count;
 }
 
+static int DarwinMachine_perfLevelValue(int level, const char* key) {
+   char name[64];
+   xSnprintf(name, sizeof(name), "hw.perflevel%d.%s", level, key);
+
+   int value;
+   size_t size = sizeof(value);
+   if (sysctlbyname(name, &value, &size, NULL, 0) != 0)
+      return -1;
+
+   return value;
+}
+
+/*
+ * Groups the CPUs by their performance level and L2 cache. The kernel
+ * numbers the CPUs of the slowest level first, so the clusters are laid
+ * out from the last level to the first.
+ */
+static void DarwinMachine_readCPUClusters(DarwinMachine* this) {
+   int levels;
+   size_t size = sizeof(levels);
+   if (sysctlbyname("hw.nperflevels", &levels, &size, NULL, 0) != 0 || levels < 1)
+      return;
+
+   unsigned int cpu = 0;
+   unsigned int count = 0;
+   for (int level = levels - 1; level >= 0; level--) {
+      int logical = DarwinMachine_perfLevelValue(level, "logicalcpu");
+      int perL2 = DarwinMachine_perfLevelValue(level, "cpusperl2");
+      if (logical <= 0)
+         return;
+      if (perL2 <= 0 || perL2 > logical)
+         perL2 = logical;
+
+      char name[32] = "";
+      char key[64];
+      size = sizeof(name) - 1;
+      xSnprintf(key, sizeof(key), "hw.perflevel%d.name", level);
+      if (sysctlbyname(key, name, &size, NULL, 0) != 0)
+         name[0] = '\0';
+
+      /* "Performance" and "Efficiency" on all chips so far */
+      char kind = (name[0] == 'P' || name[0] == 'E') ? name[0] : level == 0 ? 'P' : 'E';
+
+      for (int first = 0; first < logical; first += perL2) {
+         if (count == DARWIN_MAX_CPU_CLUSTERS)
+            return;
+
+         this->clusters[count++] = (DarwinCPUCluster) {
+            .kind = kind,
+            .perfLevel = (unsigned int)level,
+            .firstCPU = cpu,
+            .cpus = (unsigned int)MINIMUM(perL2, logical - first),
+         };
+         cpu += (unsigned int)MINIMUM(perL2, logical - first);
+      }
+   }
+
+   /* the levels must account for the CPUs of the load info */
+   if (cpu == this->super.existingCPUs)
+      this->clusterCount = count;
+}
+
 static void DarwinMachine_getVMStats(vm_statistics_t p) {
    mach_msg_type_number_t info_size = HOST_VM_INFO_COUNT;
 
@@ -89,6 +153,7 @@ Machine* Machine_new(UsersTable* usersTable, uid_t userId) {
    super->existingCPUs = super->activeCPUs;
    DarwinMachine_getHostInfo(&this->host_info);
    DarwinMachine_allocateCPULoadInfo(&this->curr_load);
+   DarwinMachine_readCPUClusters(this);
 
    /* Initialize the VM statistics */
    DarwinMachine_getVMStats(&this->vm_stats);
@@ -14,6 +14,20 @@ in the source distribution for its full text.
 #include "zfs/ZfsArcStats.h"
 
 
+/* Most CPU clusters looked at */
+#define DARWIN_MAX_CPU_CLUSTERS 16
+
+/*
+ * CPUs sharing an L2 cache in one performance level (hw.perflevel<N>), the
+ * P- and E-core clusters of Apple Silicon. Level 0 is the fastest.
+ */
+typedef struct DarwinCPUCluster_ {
+   char kind;                      /* 'P' or 'E' */
+   unsigned int perfLevel;
+   unsigned int firstCPU;          /* index into the CPU load info */
+   unsigned int cpus;
+} DarwinCPUCluster;
+
 typedef struct DarwinMachine_ {
    Machine super;
 
@@ -22,6 +36,9 @@ typedef struct DarwinMachine_ {
    processor_cpu_load_info_t prev_load;
    processor_cpu_load_info_t curr_load;
 
+   DarwinCPUCluster clusters[DARWIN_MAX_CPU_CLUSTERS];
+   unsigned int clusterCount;      /* 0 if the CPUs are not told apart (Intel) */
+
    ZfsArcStats zfs;
 } DarwinMachine;
 
@@ -5,14 +5,18 @@ Released under the GNU GPLv2+, see the COPYING file
 in the source distribution for its full text.
 */
 
+#define HEAP_CLASS HEAP_PROCESSES
+
 #include "darwin/DarwinProcess.h"
 
 #include <libproc.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <mach/mach.h>
 #include <sys/dirent.h>
+#include <sys/resource.h>
 
 #include "CRT.h"
 #include "Process.h"
@@ -49,18 +53,27 @@ const ProcessFieldData Process_fields[LAST_PROCESSFIELD] = {
    [TGID] = { .name = "TGID", .title = "TGID", .description = "Thread group ID (i.e. process ID)", .flags = 0, .pidColumn = true, },
    [PROC_EXE] = { .name = "EXE", .title = "EXE             ", .description = "Basename of exe of the process from /proc/[pid]/exe", .flags = 0, },
    [CWD] = { .name = "CWD", .title = "CWD                       ", .description = "The current working directory of the process", .flags = PROCESS_FLAG_CWD, },
+   [CPU_HISTORY] = { .name = "CPU_HISTORY", .title = "CPU HISTORY                    ", .description = "Sparkline of the CPU usage over the last updates, full height being one CPU busy", .flags = PROCESS_FLAG_HISTORY, .defaultSortDesc = true, },
+   [MEM_HISTORY] = { .name = "MEM_HISTORY", .title = "RES HISTORY                    ", .description = "Sparkline of the resident memory over the last updates, against its peak", .flags = PROCESS_FLAG_HISTORY, .defaultSortDesc = true, },
+   [MEM_GROWTH] = { .name = "MEM_GROWTH", .title = "  RES/h ", .description = "Growth of the resident memory per hour, fitted over the memory growth window (leak suspects)", .flags = PROCESS_FLAG_MEM_GROWTH, .defaultSortDesc = true, },
    [TRANSLATED] = { .name = "TRANSLATED", .title = "T ", .description = "Translation info (T translated, N native)", .flags = 0, },
+   [POWER] = { .name = "POWER", .title = "  POWER ", .description = "Power of the process: the energy billed to it by the kernel per second (macOS 10.14+)", .flags = 0, .defaultSortDesc = true, },
+   [CYCLE_RATE] = { .name = "CYCLE_RATE", .title = "  GHz ", .description = "CPU cycles of the process per second in billions, summed over its threads (macOS 10.14+)", .flags = 0, .defaultSortDesc = true, },
 };
 
 Process* DarwinProcess_new(const Machine* host) {
-   DarwinProcess* this = xCalloc(1, sizeof(DarwinProcess));
+   DarwinProcess* this = Process_allocate(sizeof(DarwinProcess));
    Object_setClass(this, Class(DarwinProcess));
    Process_init(&this->super, host);
 
    this->utime = 0;
    this->stime = 0;
+   this->rusageTime = 0;
+   this->taskInfoMs = 0;
    this->taskAccess = true;
    this->translated = false;
+   Rate_reset(&this->energy);
+   Rate_reset(&this->cycles);
 
    return &this->super;
 }
@@ -69,7 +82,7 @@ void Process_delete(Object* cast) {
    DarwinProcess* this = (DarwinProcess*) cast;
    Process_done(&this->super);
    // free platform-specific fields here
-   free(this);
+   Process_release(this, sizeof(DarwinProcess));
 }
 
 static void DarwinProcess_rowWriteField(const Row* super, RichString* str, ProcessField field) {
@@ -82,6 +95,33 @@ static void DarwinProcess_rowWriteField(const Row* super, RichString* str, Proce
    switch (field) {
    // add Platform-specific fields here
    case TRANSLATED: xSnprintf(buffer, n, "%c ", dp->translated ? 'T' : 'N'); break;
+   case POWER: {
+      /* nanojoules per second */
+      const double watts = Rate_value(&dp->energy) / 1e9;
+      if (isnan(watts)) {
+         attr = CRT_colors[PROCESS_SHADOW];
+         xSnprintf(buffer, n, "    N/A ");
+         break;
+      }
+
+      if (watts < 0.05)
+         attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, watts < 1000.0 ? "%6.1fW " : "%6.0fW ", watts);
+      break;
+   }
+   case CYCLE_RATE: {
+      const double ghz = Rate_value(&dp->cycles) / 1e9;
+      if (isnan(ghz)) {
+         attr = CRT_colors[PROCESS_SHADOW];
+         xSnprintf(buffer, n, "  N/A ");
+         break;
+      }
+
+      if (ghz < 0.005)
+         attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, ghz < 100.0 ? "%5.2f " : "%5.0f ", ghz);
+      break;
+   }
    default:
       Process_writeField(&dp->super, str, field);
       return;
@@ -98,6 +138,10 @@ static int DarwinProcess_compareByKey(const Process* v1, const Process* v2, Proc
    // add Platform-specific fields here
    case TRANSLATED:
       return SPACESHIP_NUMBER(p1->translated, p2->translated);
+   case POWER:
+      return compareRealNumbers(Rate_value(&p1->energy), Rate_value(&p2->energy));
+   case CYCLE_RATE:
+      return compareRealNumbers(Rate_value(&p1->cycles), Rate_value(&p2->cycles));
    default:
       return Process_compareByKey_Base(v1, v2, key);
    }
@@ -360,16 +404,60 @@ void DarwinProcess_setFromKInfoProc(Process* proc, const struct kinfo_proc* ps,
    proc->priority = ep->p_priority;
 
    proc->state = (ep->p_stat == SZOMB) ? ZOMBIE : UNKNOWN;
+}
+
+/*
+ * Takes the cheaper resource usage totals of a process that did not run
+ * since its task info was read. The energy and cycles billed to it are
+ * read along, for every process.
+ */
+static bool DarwinProcess_setFromRusage(DarwinProcess* proc, DarwinProcessTable* dpt) {
+   const DarwinMachine* dhost = (const DarwinMachine*) proc->super.super.host;
+   const uint64_t now = dhost->super.monotonicMs;
+
+#ifdef RUSAGE_INFO_V4
+   struct rusage_info_v4 ri;
+   if (proc_pid_rusage(Process_getPid(&proc->super), RUSAGE_INFO_V4, (rusage_info_t*) &ri) != 0) {
+      Rate_reset(&proc->energy);
+      Rate_reset(&proc->cycles);
+      return false;
+   }
 
-   /* Make sure the updated flag is set */
-   proc->super.updated = true;
+   Rate_update(&proc->energy, ri.ri_billed_energy, now);
+   Rate_update(&proc->cycles, ri.ri_cycles, now);
+#else
+   struct rusage_info_v2 ri;
+   if (proc_pid_rusage(Process_getPid(&proc->super), RUSAGE_INFO_V2, (rusage_info_t*) &ri) != 0)
+      return false;
+#endif
+
+   const uint64_t total = ri.ri_user_time + ri.ri_system_time;
+   const bool ran = total != proc->rusageTime;
+   proc->rusageTime = total;
+
+   if (ran || !proc->taskInfoMs || now - proc->taskInfoMs >= DARWIN_IDLE_REFRESH_MS)
+      return false;
+
+   proc->super.percent_cpu = 0.0;
+   proc->super.m_resident = ri.ri_resident_size / ONE_K;
+   proc->super.percent_mem = (double)ri.ri_resident_size * 100.0
+                           / (double)dhost->host_info.max_mem;
+
+   /* none of its threads ran, so none is counted as running */
+   dpt->super.userlandThreads += proc->super.nlwp;
+   dpt->super.totalTasks += proc->super.nlwp;
+   return true;
 }
 
 void DarwinProcess_setFromLibprocPidinfo(DarwinProcess* proc, DarwinProcessTable* dpt, double timeIntervalNS) {
    struct proc_taskinfo pti;
 
+   if (DarwinProcess_setFromRusage(proc, dpt))
+      return;
+
    if (sizeof(pti) == proc_pidinfo(Process_getPid(&proc->super), PROC_PIDTASKINFO, 0, &pti, sizeof(pti))) {
       const DarwinMachine* dhost = (const DarwinMachine*) proc->super.super.host;
+      proc->taskInfoMs = dhost->super.monotonicMs;
 
       uint64_t total_existing_time_ns = proc->stime + proc->utime;
 
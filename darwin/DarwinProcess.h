@@ -10,16 +10,24 @@ in the source distribution for its full text.
 #include <sys/sysctl.h>
 
 #include "Machine.h"
+#include "Rate.h"
 #include "darwin/DarwinProcessTable.h"
 
 
 #define PROCESS_FLAG_TTY 0x00000100
 
+/* Task info of processes that did not run is read again after this long */
+#define DARWIN_IDLE_REFRESH_MS 30000
+
 typedef struct DarwinProcess_ {
    Process super;
 
    uint64_t utime;
    uint64_t stime;
+   uint64_t rusageTime;       /* user and system time of the last proc_pid_rusage(), in mach ticks */
+   uint64_t taskInfoMs;       /* monotonic time the task info was last read at */
+   Rate energy;               /* billed energy of proc_pid_rusage(), in nanojoules */
+   Rate cycles;               /* CPU cycles of proc_pid_rusage() */
    bool taskAccess;
    bool translated;
 } DarwinProcess;
@@ -34,6 +42,11 @@ void Process_delete(Object* cast);
 
 void DarwinProcess_setFromKInfoProc(Process* proc, const struct kinfo_proc* ps, bool exists);
 
+/*
+ * Reads the task info of the process, unless its resource usage shows it
+ * did not run since then: its CPU time stands, only its resident memory
+ * is taken anew, and the rest is kept for up to DARWIN_IDLE_REFRESH_MS.
+ */
 void DarwinProcess_setFromLibprocPidinfo(DarwinProcess* proc, DarwinProcessTable* dpt, double timeIntervalNS);
 
 /*
@@ -19,7 +19,10 @@ in the source distribution for its full text.
 #include <sys/sysctl.h>
 
 #include "CRT.h"
+#include "Macros.h"
 #include "ProcessTable.h"
+#include "Settings.h"
+#include "Table.h"
 #include "darwin/DarwinMachine.h"
 #include "darwin/DarwinProcess.h"
 #include "darwin/Platform.h"
@@ -28,26 +31,29 @@ in the source distribution for its full text.
 #include "zfs/ZfsArcStats.h"
 
 
-static struct kinfo_proc* ProcessTable_getKInfoProcs(size_t* count) {
+/* Fills the kinfo_proc buffer kept by the table, sizing it anew only when it is too small */
+static const struct kinfo_proc* DarwinProcessTable_getKInfoProcs(DarwinProcessTable* this, size_t* count) {
    int mib[4] = { CTL_KERN, KERN_PROC, KERN_PROC_ALL, 0 };
-   struct kinfo_proc* processes = NULL;
 
    for (unsigned int retry = 0; retry < 4; retry++) {
-      size_t size = 0;
-      if (sysctl(mib, 4, NULL, &size, NULL, 0) < 0 || size == 0) {
-         CRT_fatalError("Unable to get size of kproc_infos");
+      size_t size = this->kprocsSize;
+      if (size && sysctl(mib, 4, this->kprocs, &size, NULL, 0) == 0) {
+         *count = size / sizeof(struct kinfo_proc);
+         return this->kprocs;
       }
 
-      size += 16 * retry * retry * sizeof(struct kinfo_proc);
-      processes = xRealloc(processes, size);
+      if (size && errno != ENOMEM)
+         break;
 
-      if (sysctl(mib, 4, processes, &size, NULL, 0) == 0) {
-         *count = size / sizeof(struct kinfo_proc);
-         return processes;
+      size = 0;
+      if (sysctl(mib, 4, NULL, &size, NULL, 0) < 0 || size == 0) {
+         CRT_fatalError("Unable to get size of kproc_infos");
       }
 
-      if (errno != ENOMEM)
-         break;
+      /* headroom for the processes started meanwhile, and for the next scans */
+      size += size / 4 + 16 * (retry + 1) * (retry + 1) * sizeof(struct kinfo_proc);
+      this->kprocs = xRealloc(this->kprocs, size);
+      this->kprocsSize = size;
    }
 
    CRT_fatalError("Unable to get kinfo_procs");
@@ -66,6 +72,7 @@ ProcessTable* ProcessTable_new(Machine* host, Hashtable* pidMatchList) {
 void ProcessTable_delete(Object* cast) {
    DarwinProcessTable* this = (DarwinProcessTable*) cast;
    ProcessTable_done(&this->super);
+   free(this->kprocs);
    free(this);
 }
 
@@ -74,17 +81,19 @@ void ProcessTable_goThroughEntries(ProcessTable* super) {
    const DarwinMachine* dhost = (const DarwinMachine*) host;
    DarwinProcessTable* dpt = (DarwinProcessTable*) super;
    bool preExisting = true;
-   struct kinfo_proc* ps;
+   const struct kinfo_proc* ps;
    size_t count;
    DarwinProcess* proc;
 
-   /* Get the time difference */
-   dpt->global_diff = 0;
+   /* Get the time difference; the CPU load may be sampled more often than this table is scanned */
+   uint64_t totalTicks = 0;
    for (unsigned int i = 0; i < host->existingCPUs; ++i) {
       for (size_t j = 0; j < CPU_STATE_MAX; ++j) {
-         dpt->global_diff += dhost->curr_load[i].cpu_ticks[j] - dhost->prev_load[i].cpu_ticks[j];
+         totalTicks += dhost->curr_load[i].cpu_ticks[j];
       }
    }
+   dpt->global_diff = saturatingSub(totalTicks, dpt->lastTotalTicks);
+   dpt->lastTotalTicks = totalTicks;
 
    const double time_interval_ns = Platform_schedulerTicksToNanoseconds(dpt->global_diff) / (double) host->activeCPUs;
 
@@ -95,7 +104,14 @@ void ProcessTable_goThroughEntries(ProcessTable* super) {
     *
     * We attempt to fill-in additional information with libproc.
     */
-   ps = ProcessTable_getKInfoProcs(&count);
+   ps = DarwinProcessTable_getKInfoProcs(dpt, &count);
+
+   // Disabled for High Sierra due to bug in macOS High Sierra
+   const bool isScanThreadSupported = !Platform_KernelVersionIsBetween((KernelVersion) {17, 0, 0}, (KernelVersion) {17, 5, 0});
+
+   /* the thread scan only gives the state, with lazy collection it is taken for rows on screen */
+   const Settings* settings = host->settings;
+   const bool scanAllThreads = !settings->lazyCollection || ScreenSettings_getActiveSortKey(settings->ss) == STATE;
 
    for (size_t i = 0; i < count; ++i) {
       proc = (DarwinProcess*)ProcessTable_getProcess(super, ps[i].kp_proc.p_pid, &preExisting, DarwinProcess_new);
@@ -108,10 +124,7 @@ void ProcessTable_goThroughEntries(ProcessTable* super) {
          proc->super.user = UsersTable_getRef(host->usersTable, proc->super.st_uid);
       }
 
-      // Disabled for High Sierra due to bug in macOS High Sierra
-      bool isScanThreadSupported = !Platform_KernelVersionIsBetween((KernelVersion) {17, 0, 0}, (KernelVersion) {17, 5, 0});
-
-      if (isScanThreadSupported) {
+      if (isScanThreadSupported && (scanAllThreads || !preExisting || Table_isRowOnScreen(&super->super, &proc->super.super))) {
          DarwinProcess_scanThreads(proc);
       }
 
@@ -120,7 +133,8 @@ void ProcessTable_goThroughEntries(ProcessTable* super) {
       if (!preExisting) {
          ProcessTable_add(super, &proc->super);
       }
-   }
 
-   free(ps);
+      proc->super.super.show = true;
+      Table_markUpdated(&super->super, &proc->super.super);
+   }
 }
@@ -17,6 +17,10 @@ typedef struct DarwinProcessTable_ {
    ProcessTable super;
 
    uint64_t global_diff;
+   uint64_t lastTotalTicks;   /* CPU ticks when this table was last scanned */
+
+   struct kinfo_proc* kprocs; /* kept across scans, grown when the processes do not fit */
+   size_t kprocsSize;         /* in bytes */
 } DarwinProcessTable;
 
 #endif
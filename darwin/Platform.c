@@ -40,10 +40,12 @@ in the source distribution for its full text.
 #include "MemoryMeter.h"
 #include "MemorySwapMeter.h"
 #include "ProcessLocksScreen.h"
+#include "SelfMeter.h"
 #include "SwapMeter.h"
 #include "SysArchMeter.h"
 #include "TasksMeter.h"
 #include "UptimeMeter.h"
+#include "darwin/CPUClusterMeter.h"
 #include "darwin/DarwinMachine.h"
 #include "darwin/PlatformHelpers.h"
 #include "generic/fdstat_sysctl.h"
@@ -123,6 +125,7 @@ const MeterClass* const Platform_meterTypes[] = {
    &HostnameMeter_class,
    &SysArchMeter_class,
    &UptimeMeter_class,
+   &SelfMeter_class,
    &AllCPUsMeter_class,
    &AllCPUs2Meter_class,
    &AllCPUs4Meter_class,
@@ -135,6 +138,19 @@ const MeterClass* const Platform_meterTypes[] = {
    &RightCPUs4Meter_class,
    &LeftCPUs8Meter_class,
    &RightCPUs8Meter_class,
+   &CPUClustersMeter_class,
+   &PerformanceCPUsMeter_class,
+   &EfficiencyCPUsMeter_class,
+#ifdef HAVE_LIBHWLOC
+   &CPUNodesMeter_class,
+   &CPUSocketsMeter_class,
+   &CPUCachesMeter_class,
+   &CPUCoresMeter_class,
+   &BusiestCPUNodeMeter_class,
+   &BusiestCPUSocketMeter_class,
+   &BusiestCPUCacheMeter_class,
+   &BusiestCPUCoreMeter_class,
+#endif
    &ZfsArcMeter_class,
    &ZfsCompressedArcMeter_class,
    &DiskIOMeter_class,
@@ -379,6 +395,13 @@ FileLocks_ProcessData* Platform_getProcessLocks(pid_t pid) {
    return NULL;
 }
 
+bool Platform_getProcessOpenFiles(pid_t pid, OpenFiles_AddFile addFile, void* context) {
+   (void)pid;
+   (void)addFile;
+   (void)context;
+   return false;
+}
+
 void Platform_getFileDescriptors(double* used, double* max) {
    Generic_getFileDescriptors_sysctl(used, max);
 }
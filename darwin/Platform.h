@@ -17,6 +17,7 @@ in the source distribution for its full text.
 #include "DiskIOMeter.h"
 #include "Hashtable.h"
 #include "NetworkIOMeter.h"
+#include "OpenFilesScreen.h"
 #include "ProcessLocksScreen.h"
 #include "SignalsPanel.h"
 #include "CommandLine.h"
@@ -70,6 +71,8 @@ char* Platform_getProcessEnv(pid_t pid);
 
 FileLocks_ProcessData* Platform_getProcessLocks(pid_t pid);
 
+bool Platform_getProcessOpenFiles(pid_t pid, OpenFiles_AddFile addFile, void* context);
+
 void Platform_getFileDescriptors(double* used, double* max);
 
 bool Platform_getDiskIO(DiskIOData* data);
@@ -6,6 +6,8 @@ Released under the GNU GPLv2+, see the COPYING file
 in the source distribution for its full text.
 */
 
+#define HEAP_CLASS HEAP_PROCESSES
+
 #include "dragonflybsd/DragonFlyBSDProcess.h"
 
 #include <stdlib.h>
@@ -48,12 +50,15 @@ const ProcessFieldData Process_fields[LAST_PROCESSFIELD] = {
    [PROC_COMM] = { .name = "COMM", .title = "COMM            ", .description = "comm string of the process", .flags = 0, },
    [PROC_EXE] = { .name = "EXE", .title = "EXE             ", .description = "Basename of exe of the process", .flags = 0, },
    [CWD] = { .name = "CWD", .title = "CWD                       ", .description = "The current working directory of the process", .flags = PROCESS_FLAG_CWD, },
+   [CPU_HISTORY] = { .name = "CPU_HISTORY", .title = "CPU HISTORY                    ", .description = "Sparkline of the CPU usage over the last updates, full height being one CPU busy", .flags = PROCESS_FLAG_HISTORY, .defaultSortDesc = true, },
+   [MEM_HISTORY] = { .name = "MEM_HISTORY", .title = "RES HISTORY                    ", .description = "Sparkline of the resident memory over the last updates, against its peak", .flags = PROCESS_FLAG_HISTORY, .defaultSortDesc = true, },
+   [MEM_GROWTH] = { .name = "MEM_GROWTH", .title = "  RES/h ", .description = "Growth of the resident memory per hour, fitted over the memory growth window (leak suspects)", .flags = PROCESS_FLAG_MEM_GROWTH, .defaultSortDesc = true, },
    [JID] = { .name = "JID", .title = "JID", .description = "Jail prison ID", .flags = 0, .pidColumn = true, },
    [JAIL] = { .name = "JAIL", .title = "JAIL        ", .description = "Jail prison name", .flags = 0, },
 };
 
 Process* DragonFlyBSDProcess_new(const Machine* host) {
-   DragonFlyBSDProcess* this = xCalloc(1, sizeof(DragonFlyBSDProcess));
+   DragonFlyBSDProcess* this = Process_allocate(sizeof(DragonFlyBSDProcess));
    Object_setClass(this, Class(DragonFlyBSDProcess));
    Process_init(&this->super, host);
    return &this->super;
@@ -63,7 +68,7 @@ void Process_delete(Object* cast) {
    DragonFlyBSDProcess* this = (DragonFlyBSDProcess*) cast;
    Process_done((Process*)cast);
    free(this->jname);
-   free(this);
+   Process_release(this, sizeof(DragonFlyBSDProcess));
 }
 
 static void DragonFlyBSDProcess_rowWriteField(const Row* super, RichString* str, ProcessField field) {
@@ -317,6 +317,6 @@ void ProcessTable_goThroughEntries(ProcessTable* super) {
          super->runningTasks++;
 
       proc->super.show = ! ((hideKernelThreads && Process_isKernelThread(proc)) || (hideUserlandThreads && Process_isUserlandThread(proc)));
-      proc->super.updated = true;
+      Table_markUpdated(&super->super, &proc->super);
    }
 }
@@ -29,6 +29,7 @@ in the source distribution for its full text.
 #include "MemoryMeter.h"
 #include "MemorySwapMeter.h"
 #include "ProcessTable.h"
+#include "SelfMeter.h"
 #include "SwapMeter.h"
 #include "SysArchMeter.h"
 #include "TasksMeter.h"
@@ -100,6 +101,7 @@ const MeterClass* const Platform_meterTypes[] = {
    &SwapMeter_class,
    &TasksMeter_class,
    &UptimeMeter_class,
+   &SelfMeter_class,
    &BatteryMeter_class,
    &HostnameMeter_class,
    &SysArchMeter_class,
@@ -115,6 +117,16 @@ const MeterClass* const Platform_meterTypes[] = {
    &RightCPUs4Meter_class,
    &LeftCPUs8Meter_class,
    &RightCPUs8Meter_class,
+#ifdef HAVE_LIBHWLOC
+   &CPUNodesMeter_class,
+   &CPUSocketsMeter_class,
+   &CPUCachesMeter_class,
+   &CPUCoresMeter_class,
+   &BusiestCPUNodeMeter_class,
+   &BusiestCPUSocketMeter_class,
+   &BusiestCPUCacheMeter_class,
+   &BusiestCPUCoreMeter_class,
+#endif
    &FileDescriptorMeter_class,
    &BlankMeter_class,
    NULL
@@ -242,6 +254,13 @@ FileLocks_ProcessData* Platform_getProcessLocks(pid_t pid) {
    return NULL;
 }
 
+bool Platform_getProcessOpenFiles(pid_t pid, OpenFiles_AddFile addFile, void* context) {
+   (void)pid;
+   (void)addFile;
+   (void)context;
+   return false;
+}
+
 void Platform_getFileDescriptors(double* used, double* max) {
    Generic_getFileDescriptors_sysctl(used, max);
 }
@@ -20,6 +20,7 @@ in the source distribution for its full text.
 #include "Macros.h"
 #include "Meter.h"
 #include "NetworkIOMeter.h"
+#include "OpenFilesScreen.h"
 #include "Process.h"
 #include "ProcessLocksScreen.h"
 #include "SignalsPanel.h"
@@ -61,6 +62,8 @@ char* Platform_getProcessEnv(pid_t pid);
 
 FileLocks_ProcessData* Platform_getProcessLocks(pid_t pid);
 
+bool Platform_getProcessOpenFiles(pid_t pid, OpenFiles_AddFile addFile, void* context);
+
 void Platform_getFileDescriptors(double* used, double* max);
 
 bool Platform_getDiskIO(DiskIOData* data);
@@ -7,6 +7,8 @@ in the source distribution for its full text.
 
 #include "config.h" // IWYU pragma: keep
 
+#define HEAP_CLASS HEAP_PROCESSES
+
 #include "freebsd/FreeBSDProcess.h"
 
 #include <stdlib.h>
@@ -50,6 +52,9 @@ const ProcessFieldData Process_fields[LAST_PROCESSFIELD] = {
    [PROC_COMM] = { .name = "COMM", .title = "COMM            ", .description = "comm string of the process", .flags = 0, },
    [PROC_EXE] = { .name = "EXE", .title = "EXE             ", .description = "Basename of exe of the process", .flags = 0, },
    [CWD] = { .name = "CWD", .title = "CWD                       ", .description = "The current working directory of the process", .flags = PROCESS_FLAG_CWD, },
+   [CPU_HISTORY] = { .name = "CPU_HISTORY", .title = "CPU HISTORY                    ", .description = "Sparkline of the CPU usage over the last updates, full height being one CPU busy", .flags = PROCESS_FLAG_HISTORY, .defaultSortDesc = true, },
+   [MEM_HISTORY] = { .name = "MEM_HISTORY", .title = "RES HISTORY                    ", .description = "Sparkline of the resident memory over the last updates, against its peak", .flags = PROCESS_FLAG_HISTORY, .defaultSortDesc = true, },
+   [MEM_GROWTH] = { .name = "MEM_GROWTH", .title = "  RES/h ", .description = "Growth of the resident memory per hour, fitted over the memory growth window (leak suspects)", .flags = PROCESS_FLAG_MEM_GROWTH, .defaultSortDesc = true, },
 #ifdef SCHEDULER_SUPPORT
    [SCHEDULERPOLICY] = { .name = "SCHEDULERPOLICY", .title = "SCHED ", .description = "Current scheduling policy of the process", .flags = PROCESS_FLAG_SCHEDPOL, },
 #endif
@@ -59,7 +64,7 @@ const ProcessFieldData Process_fields[LAST_PROCESSFIELD] = {
 };
 
 Process* FreeBSDProcess_new(const Machine* machine) {
-   FreeBSDProcess* this = xCalloc(1, sizeof(FreeBSDProcess));
+   FreeBSDProcess* this = Process_allocate(sizeof(FreeBSDProcess));
    Object_setClass(this, Class(FreeBSDProcess));
    Process_init(&this->super, machine);
    return &this->super;
@@ -70,7 +75,7 @@ void Process_delete(Object* cast) {
    Process_done((Process*)cast);
    free(this->emul);
    free(this->jname);
-   free(this);
+   Process_release(this, sizeof(FreeBSDProcess));
 }
 
 static void FreeBSDProcess_rowWriteField(const Row* super, RichString* str, ProcessField field) {
@@ -29,12 +29,15 @@ in the source distribution for its full text.
 
 #include "CRT.h"
 #include "Compat.h"
+#include "Hashtable.h"
 #include "Macros.h"
 #include "Object.h"
 #include "Process.h"
 #include "ProcessTable.h"
 #include "Scheduling.h"
 #include "Settings.h"
+#include "Table.h"
+#include "Vector.h"
 #include "XUtils.h"
 
 #include "freebsd/FreeBSDMachine.h"
@@ -48,11 +51,14 @@ ProcessTable* ProcessTable_new(Machine* host, Hashtable* pidMatchList) {
    ProcessTable* super = &this->super;
    ProcessTable_init(super, Class(FreeBSDProcess), host, pidMatchList);
 
+   this->jailNames = Hashtable_new(16, true);
+
    return super;
 }
 
 void ProcessTable_delete(Object* cast) {
    FreeBSDProcessTable* this = (FreeBSDProcessTable*) cast;
+   Hashtable_delete(this->jailNames);
    ProcessTable_done(&this->super);
    free(this);
 }
@@ -130,10 +136,15 @@ static void FreeBSDProcessTable_updateProcessName(kvm_t* kd, const struct kinfo_
    free(cmdline);
 }
 
-static char* FreeBSDProcessTable_readJailName(const struct kinfo_proc* kproc) {
+static char* FreeBSDProcessTable_readJailName(FreeBSDProcessTable* this, const struct kinfo_proc* kproc) {
    if (kproc->ki_jid == 0)
       return xStrdup("-");
 
+   /* the processes of a jail share its name, the kernel is asked once per scan */
+   const char* cached = Hashtable_get(this->jailNames, (ht_key_t)kproc->ki_jid);
+   if (cached)
+      return xStrdup(cached);
+
    char jnamebuf[MAXHOSTNAMELEN] = {0};
    struct iovec jiov[4];
 
@@ -149,24 +160,206 @@ IGNORE_WCASTQUAL_BEGIN
 IGNORE_WCASTQUAL_END
 
    int jid = jail_get(jiov, 4, 0);
-   if (jid == kproc->ki_jid)
-      return xStrdup(jnamebuf);
+   if (jid != kproc->ki_jid)
+      return NULL;
+
+   Hashtable_put(this->jailNames, (ht_key_t)jid, xStrdup(jnamebuf));
+   return xStrdup(jnamebuf);
+}
+
+/*
+ * Whether the arguments of a known process are read again in this scan:
+ * once it ran another program, else with lazy collection only while on
+ * screen, unless all of them are filtered or sorted by their command.
+ */
+static bool FreeBSDProcessTable_wantsProcessName(const ProcessTable* super, const struct kinfo_proc* kproc, const Process* proc) {
+   if (!proc->procComm || !String_eq(proc->procComm, kproc->ki_comm))
+      return true;
+
+   const Settings* settings = super->super.host->settings;
+   if (!settings->lazyCollection || super->super.incFilter || ScreenSettings_getActiveSortKey(settings->ss) == COMM)
+      return true;
+
+   return Table_isRowOnScreen(&super->super, &proc->super);
+}
+
+/* Values shared by process and thread rows, of the thread or of the whole process */
+static void FreeBSDProcessTable_updateStats(const Machine* host, const struct kinfo_proc* kproc, Process* proc) {
+   const FreeBSDMachine* fhost = (const FreeBSDMachine*) host;
+
+   // from FreeBSD source /src/usr.bin/top/machine.c
+   proc->m_virt = kproc->ki_size / ONE_K;
+   proc->m_resident = kproc->ki_rssize * fhost->pageSizeKb;
+   proc->nlwp = kproc->ki_numthreads;
+   proc->time = (kproc->ki_runtime + 5000) / 10000;
+
+   proc->percent_cpu = 100.0 * ((double)kproc->ki_pctcpu / (double)fhost->kernelFScale);
+   proc->percent_mem = 100.0 * proc->m_resident / (double)(host->totalMem);
+   Process_updateCPUFieldWidths(proc->percent_cpu);
+
+   if (kproc->ki_stat == SRUN && kproc->ki_oncpu != NOCPU) {
+      proc->processor = kproc->ki_oncpu;
+   } else {
+      proc->processor = kproc->ki_lastcpu;
+   }
+
+   proc->majflt = kproc->ki_cow;
+
+   proc->priority = kproc->ki_pri.pri_level - PZERO;
+
+   if (String_eq("intr", kproc->ki_comm) && (kproc->ki_flag & P_SYSTEM)) {
+      proc->nice = 0; //@etosan: intr kernel process (not thread) has weird nice value
+   } else if (kproc->ki_pri.pri_class == PRI_TIMESHARE) {
+      proc->nice = kproc->ki_nice - NZERO;
+   } else if (PRI_IS_REALTIME(kproc->ki_pri.pri_class)) {
+      proc->nice = PRIO_MIN - 1 - (PRI_MAX_REALTIME - kproc->ki_pri.pri_level);
+   } else {
+      proc->nice = PRIO_MAX + 1 + kproc->ki_pri.pri_level - PRI_MIN_IDLE;
+   }
+
+   /* Taken from: https://github.com/freebsd/freebsd-src/blob/1ad2d87778970582854082bcedd2df0394fd4933/sys/sys/proc.h#L851 */
+   switch (kproc->ki_stat) {
+      case SIDL:   proc->state = IDLE; break;
+      case SRUN:   proc->state = RUNNING; break;
+      case SSLEEP: proc->state = SLEEPING; break;
+      case SSTOP:  proc->state = STOPPED; break;
+      case SZOMB:  proc->state = ZOMBIE; break;
+      case SWAIT:  proc->state = WAITING; break;
+      case SLOCK:  proc->state = BLOCKED; break;
+      default:     proc->state = UNKNOWN;
+   }
+
+#ifdef SCHEDULER_SUPPORT
+   if (host->settings->ss->flags & PROCESS_FLAG_SCHEDPOL)
+      Scheduling_readProcessPolicy(proc);
+#endif
+}
+
+/* Whether thread rows can be seen: only then is the larger snapshot with a row per thread taken */
+static bool FreeBSDProcessTable_wantsThreads(const ProcessTable* super) {
+   const Table* table = &super->super;
+   const Settings* settings = table->host->settings;
+   if (settings->hideUserlandThreads)
+      return false;
+
+   if (!settings->ss->treeView)
+      return true;
+
+   /* in the tree threads are below their process, seen once its branch is expanded */
+   for (int i = 0; i < Vector_size(table->rows); i++) {
+      const Process* proc = (const Process*) Vector_get(table->rows, i);
+      if (!Process_isThread(proc) && proc->nlwp > 1 && proc->super.showChildren)
+         return true;
+   }
+   return false;
+}
+
+/* Sums up the threads of a process from a snapshot with a row per thread */
+static void FreeBSDProcessTable_mergeThreads(struct kinfo_proc* merged, const struct kinfo_proc* threads, int count) {
+   for (int i = 1; i < count; i++) {
+      const struct kinfo_proc* thread = &threads[i];
+      merged->ki_pctcpu += thread->ki_pctcpu;
+      merged->ki_runtime += thread->ki_runtime;
+      if (thread->ki_stat == SRUN && merged->ki_stat != SRUN) {
+         merged->ki_stat = SRUN;
+         merged->ki_oncpu = thread->ki_oncpu;
+         merged->ki_lastcpu = thread->ki_lastcpu;
+      }
+   }
+}
+
+static void FreeBSDProcessTable_updateThread(ProcessTable* super, const struct kinfo_proc* kthread, const Process* proc) {
+   const Machine* host = super->super.host;
+   const Settings* settings = host->settings;
+
+   bool preExisting = false;
+   Process* thread = ProcessTable_getProcess(super, kthread->ki_tid, &preExisting, FreeBSDProcess_new);
+   const FreeBSDProcess* fp = (const FreeBSDProcess*) proc;
+   FreeBSDProcess* ft = (FreeBSDProcess*) thread;
+
+   if (!preExisting) {
+      Process_setPid(thread, kthread->ki_tid);
+      Process_setThreadGroup(thread, kthread->ki_pid);
+      thread->isKernelThread = Process_isKernelThread(proc);
+      thread->isUserlandThread = !thread->isKernelThread;
+      thread->tpgid = proc->tpgid;
+      thread->session = proc->session;
+      thread->pgrp = proc->pgrp;
+      thread->starttime_ctime = proc->starttime_ctime;
+      Process_fillStarttimeBuffer(thread);
+      thread->tty_nr = proc->tty_nr;
+      if (proc->tty_name)
+         free_and_xStrdup(&thread->tty_name, proc->tty_name);
+      ProcessTable_add(super, thread);
+   }
+
+   Process_setParent(thread, proc->super.parent);
+   thread->st_uid = proc->st_uid;
+   thread->user = proc->user;
+   ft->jid = fp->jid;
+   if (fp->jname && (!ft->jname || !String_eq(ft->jname, fp->jname)))
+      free_and_xStrdup(&ft->jname, fp->jname);
+   if (fp->emul && (!ft->emul || !String_eq(ft->emul, fp->emul)))
+      free_and_xStrdup(&ft->emul, fp->emul);
+
+   const char* name = kthread->ki_tdname[0] ? kthread->ki_tdname : kthread->ki_comm;
+   Process_updateComm(thread, name);
+   if (settings->showThreadNames || !proc->cmdline) {
+      Process_updateCmdline(thread, name, 0, strlen(name));
+   } else {
+      Process_updateCmdline(thread, proc->cmdline, proc->cmdlineBasenameStart, proc->cmdlineBasenameEnd);
+   }
+   Process_updateExe(thread, proc->procExe);
+
+   FreeBSDProcessTable_updateStats(host, kthread, thread);
+   thread->nlwp = proc->nlwp;
+
+   if (Process_isKernelThread(thread)) {
+      super->kernelThreads++;
+   } else {
+      super->userlandThreads++;
+   }
+
+   thread->super.show = ! ((settings->hideKernelThreads && Process_isKernelThread(thread)) || (settings->hideUserlandThreads && Process_isUserlandThread(thread)));
 
-   return NULL;
+   super->totalTasks++;
+   if (thread->state == RUNNING)
+      super->runningTasks++;
+   Table_markUpdated(&super->super, &thread->super);
 }
 
 void ProcessTable_goThroughEntries(ProcessTable* super) {
+   FreeBSDProcessTable* this = (FreeBSDProcessTable*) super;
    const Machine* host = super->super.host;
    const FreeBSDMachine* fhost = (const FreeBSDMachine*) host;
    const Settings* settings = host->settings;
    bool hideKernelThreads = settings->hideKernelThreads;
    bool hideUserlandThreads = settings->hideUserlandThreads;
 
+   /* jails may have been renamed or their ids reused since the last scan */
+   Hashtable_clear(this->jailNames);
+
+   const bool wantThreads = FreeBSDProcessTable_wantsThreads(super);
+   const int op = wantThreads ? KERN_PROC_PROC | KERN_PROC_INC_THREAD : KERN_PROC_PROC;
+
    int count = 0;
-   const struct kinfo_proc* kprocs = kvm_getprocs(fhost->kd, KERN_PROC_PROC, 0, &count);
+   const struct kinfo_proc* kprocs = kvm_getprocs(fhost->kd, op, 0, &count);
 
-   for (int i = 0; i < count; i++) {
+   for (int i = 0, threads = 1; i < count; i += threads) {
       const struct kinfo_proc* kproc = &kprocs[i];
+
+      /* with threads the snapshot has a row for each of them, one after the other */
+      threads = 1;
+      while (wantThreads && i + threads < count && kprocs[i + threads].ki_pid == kproc->ki_pid)
+         threads++;
+
+      struct kinfo_proc merged;
+      if (threads > 1) {
+         merged = *kproc;
+         FreeBSDProcessTable_mergeThreads(&merged, kproc, threads);
+         kproc = &merged;
+      }
+
       bool preExisting = false;
       Process* proc = ProcessTable_getProcess(super, kproc->ki_pid, &preExisting, FreeBSDProcess_new);
       FreeBSDProcess* fp = (FreeBSDProcess*) proc;
@@ -197,7 +390,7 @@ void ProcessTable_goThroughEntries(ProcessTable* super) {
             FreeBSDProcessTable_updateCwd(kproc, proc);
          }
 
-         fp->jname = FreeBSDProcessTable_readJailName(kproc);
+         fp->jname = FreeBSDProcessTable_readJailName(this, kproc);
 
          proc->tty_nr = kproc->ki_tdev;
          const char* name = (kproc->ki_tdev != NODEV) ? devname(kproc->ki_tdev, S_IFCHR) : NULL;
@@ -212,7 +405,7 @@ void ProcessTable_goThroughEntries(ProcessTable* super) {
             // process can enter jail anytime
             fp->jid = kproc->ki_jid;
             free(fp->jname);
-            fp->jname = FreeBSDProcessTable_readJailName(kproc);
+            fp->jname = FreeBSDProcessTable_readJailName(this, kproc);
          }
          // if there are reapers in the system, process can get reparented anytime
          Process_setParent(proc, kproc->ki_ppid);
@@ -221,7 +414,7 @@ void ProcessTable_goThroughEntries(ProcessTable* super) {
             proc->st_uid = kproc->ki_uid;
             proc->user = UsersTable_getRef(host->usersTable, proc->st_uid);
          }
-         if (settings->updateProcessNames) {
+         if (settings->updateProcessNames && FreeBSDProcessTable_wantsProcessName(super, kproc, proc)) {
             FreeBSDProcessTable_updateProcessName(fhost->kd, kproc, proc);
          }
       }
@@ -283,6 +476,9 @@ void ProcessTable_goThroughEntries(ProcessTable* super) {
       super->totalTasks++;
       if (proc->state == RUNNING)
          super->runningTasks++;
-      proc->super.updated = true;
+      Table_markUpdated(&super->super, &proc->super);
+
+      for (int t = 0; threads > 1 && t < threads; t++)
+         FreeBSDProcessTable_updateThread(super, &kprocs[i + t], proc);
    }
 }
@@ -16,6 +16,8 @@ in the source distribution for its full text.
 
 typedef struct FreeBSDProcessTable_ {
    ProcessTable super;
+
+   Hashtable* jailNames;  /* jid to name, looked up at most once per scan */
 } FreeBSDProcessTable;
 
 #endif
@@ -10,12 +10,35 @@ in the source distribution for its full text.
 #include "generic/fdstat_sysctl.h"
 
 #include <math.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #include <sys/types.h> // Shitty FreeBSD upstream headers
 #include <sys/sysctl.h>
 
+#include "Macros.h"
+
+
+/* A sysctl resolved to its MIB on first use, its name is not looked up again */
+typedef struct CachedSysctl_ {
+   int mib[CTL_MAXNAME];
+   u_int mibLen;        /* 0 if the sysctl does not exist */
+   bool resolved;
+} CachedSysctl;
+
+static bool CachedSysctl_read(CachedSysctl* this, const char* name, void* value, size_t* len) {
+   if (!name)
+      return false;
+
+   if (!this->resolved) {
+      this->resolved = true;
+      size_t mibLen = ARRAYSIZE(this->mib);
+      this->mibLen = sysctlnametomib(name, this->mib, &mibLen) == 0 ? (u_int)mibLen : 0;
+   }
+
+   return this->mibLen && sysctl(this->mib, this->mibLen, value, len, NULL, 0) == 0;
+}
 
 static void Generic_getFileDescriptors_sysctl_internal(
    const char* sysctlname_maxfiles,
@@ -25,6 +48,10 @@ static void Generic_getFileDescriptors_sysctl_internal(
    double* used,
    double* max
 ) {
+   static CachedSysctl maxFiles;
+   static CachedSysctl numFiles;
+   static CachedSysctl fileTable;
+
    *used = NAN;
    *max = 65536;
 
@@ -32,7 +59,7 @@ static void Generic_getFileDescriptors_sysctl_internal(
    size_t len;
 
    len = sizeof(max_fd);
-   if (sysctlname_maxfiles && sysctlbyname(sysctlname_maxfiles, &max_fd, &len, NULL, 0) == 0) {
+   if (CachedSysctl_read(&maxFiles, sysctlname_maxfiles, &max_fd, &len)) {
       if (max_fd) {
          *max = max_fd;
       } else {
@@ -41,7 +68,7 @@ static void Generic_getFileDescriptors_sysctl_internal(
    }
 
    len = sizeof(open_fd);
-   if (sysctlname_numfiles && sysctlbyname(sysctlname_numfiles, &open_fd, &len, NULL, 0) == 0) {
+   if (CachedSysctl_read(&numFiles, sysctlname_numfiles, &open_fd, &len)) {
       *used = open_fd;
       return;
    }
@@ -52,7 +79,7 @@ static void Generic_getFileDescriptors_sysctl_internal(
       return;
 
    len = 0;
-   if (sysctlbyname("kern.file", NULL, &len, NULL, 0) < 0)
+   if (!CachedSysctl_read(&fileTable, "kern.file", NULL, &len))
       return;
 
    if (len < size_header)
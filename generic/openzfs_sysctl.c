@@ -7,98 +7,79 @@ in the source distribution for its full text.
 
 #include "generic/openzfs_sysctl.h"
 
+#include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h> // IWYU pragma: keep
 #include <sys/sysctl.h> // needs <sys/types.h> for u_int with gcc
 
+#include "Macros.h"
 #include "zfs/ZfsArcStats.h"
 
 
-static int MIB_kstat_zfs_misc_arcstats_size[5];
-static int MIB_kstat_zfs_misc_arcstats_c_min[5];
-static int MIB_kstat_zfs_misc_arcstats_c_max[5];
-static int MIB_kstat_zfs_misc_arcstats_mfu_size[5];
-static int MIB_kstat_zfs_misc_arcstats_mru_size[5];
-static int MIB_kstat_zfs_misc_arcstats_anon_size[5];
-static int MIB_kstat_zfs_misc_arcstats_hdr_size[5];
-static int MIB_kstat_zfs_misc_arcstats_other_size[5];
-static int MIB_kstat_zfs_misc_arcstats_compressed_size[5];
-static int MIB_kstat_zfs_misc_arcstats_uncompressed_size[5];
+/* The ARC statistics read on every update, resolved to their MIB once */
+typedef struct OpenzfsSysctl_ {
+   const char* name;
+   size_t offset;       /* of the value in ZfsArcStats */
+   int mib[CTL_MAXNAME];
+   u_int mibLen;        /* 0 if the statistic does not exist */
+} OpenzfsSysctl;
+
+#define OPENZFS_SYSCTL(name_, field_) { .name = "kstat.zfs.misc.arcstats." name_, .offset = offsetof(ZfsArcStats, field_) }
+
+static OpenzfsSysctl openzfs_sysctls[] = {
+   OPENZFS_SYSCTL("size", size),
+   OPENZFS_SYSCTL("c_min", min),
+   OPENZFS_SYSCTL("c_max", max),
+   OPENZFS_SYSCTL("mfu_size", MFU),
+   OPENZFS_SYSCTL("mru_size", MRU),
+   OPENZFS_SYSCTL("anon_size", anon),
+   OPENZFS_SYSCTL("hdr_size", header),
+   OPENZFS_SYSCTL("other_size", other),
+   OPENZFS_SYSCTL("compressed_size", compressed),
+   OPENZFS_SYSCTL("uncompressed_size", uncompressed),
+};
 
 void openzfs_sysctl_init(ZfsArcStats* stats) {
    size_t len;
    unsigned long long int arcSize;
 
-   len = sizeof(arcSize);
-   if (sysctlbyname("kstat.zfs.misc.arcstats.size", &arcSize, &len, NULL, 0) == 0 && arcSize != 0) {
-      stats->enabled = 1;
-
-      len = 5;
-      sysctlnametomib("kstat.zfs.misc.arcstats.size", MIB_kstat_zfs_misc_arcstats_size, &len);
-
-      sysctlnametomib("kstat.zfs.misc.arcstats.c_min", MIB_kstat_zfs_misc_arcstats_c_min, &len);
-      sysctlnametomib("kstat.zfs.misc.arcstats.c_max", MIB_kstat_zfs_misc_arcstats_c_max, &len);
-      sysctlnametomib("kstat.zfs.misc.arcstats.mfu_size", MIB_kstat_zfs_misc_arcstats_mfu_size, &len);
-      sysctlnametomib("kstat.zfs.misc.arcstats.mru_size", MIB_kstat_zfs_misc_arcstats_mru_size, &len);
-      sysctlnametomib("kstat.zfs.misc.arcstats.anon_size", MIB_kstat_zfs_misc_arcstats_anon_size, &len);
-      sysctlnametomib("kstat.zfs.misc.arcstats.hdr_size", MIB_kstat_zfs_misc_arcstats_hdr_size, &len);
-      sysctlnametomib("kstat.zfs.misc.arcstats.other_size", MIB_kstat_zfs_misc_arcstats_other_size, &len);
-
-      if (sysctlnametomib("kstat.zfs.misc.arcstats.compressed_size", MIB_kstat_zfs_misc_arcstats_compressed_size, &len) == 0) {
-         stats->isCompressed = 1;
-         sysctlnametomib("kstat.zfs.misc.arcstats.uncompressed_size", MIB_kstat_zfs_misc_arcstats_uncompressed_size, &len);
-      } else {
-         stats->isCompressed = 0;
-      }
-   } else {
-      stats->enabled = 0;
-   }
-}
-
-void openzfs_sysctl_updateArcStats(ZfsArcStats* stats) {
-   size_t len;
-
-   if (stats->enabled) {
-      len = sizeof(stats->size);
-      sysctl(MIB_kstat_zfs_misc_arcstats_size, 5, &(stats->size), &len, NULL, 0);
-      stats->size /= 1024;
-
-      len = sizeof(stats->min);
-      sysctl(MIB_kstat_zfs_misc_arcstats_c_min, 5, &(stats->min), &len, NULL, 0);
-      stats->min /= 1024;
+   stats->enabled = 0;
+   stats->isCompressed = 0;
 
-      len = sizeof(stats->max);
-      sysctl(MIB_kstat_zfs_misc_arcstats_c_max, 5, &(stats->max), &len, NULL, 0);
-      stats->max /= 1024;
-
-      len = sizeof(stats->MFU);
-      sysctl(MIB_kstat_zfs_misc_arcstats_mfu_size, 5, &(stats->MFU), &len, NULL, 0);
-      stats->MFU /= 1024;
-
-      len = sizeof(stats->MRU);
-      sysctl(MIB_kstat_zfs_misc_arcstats_mru_size, 5, &(stats->MRU), &len, NULL, 0);
-      stats->MRU /= 1024;
-
-      len = sizeof(stats->anon);
-      sysctl(MIB_kstat_zfs_misc_arcstats_anon_size, 5, &(stats->anon), &len, NULL, 0);
-      stats->anon /= 1024;
+   len = sizeof(arcSize);
+   if (sysctlbyname("kstat.zfs.misc.arcstats.size", &arcSize, &len, NULL, 0) != 0 || arcSize == 0)
+      return;
 
-      len = sizeof(stats->header);
-      sysctl(MIB_kstat_zfs_misc_arcstats_hdr_size, 5, &(stats->header), &len, NULL, 0);
-      stats->header /= 1024;
+   stats->enabled = 1;
 
-      len = sizeof(stats->other);
-      sysctl(MIB_kstat_zfs_misc_arcstats_other_size, 5, &(stats->other), &len, NULL, 0);
-      stats->other /= 1024;
+   for (size_t i = 0; i < ARRAYSIZE(openzfs_sysctls); i++) {
+      OpenzfsSysctl* entry = &openzfs_sysctls[i];
+      size_t mibLen = ARRAYSIZE(entry->mib);
+      entry->mibLen = sysctlnametomib(entry->name, entry->mib, &mibLen) == 0 ? (u_int)mibLen : 0;
 
-      if (stats->isCompressed) {
-         len = sizeof(stats->compressed);
-         sysctl(MIB_kstat_zfs_misc_arcstats_compressed_size, 5, &(stats->compressed), &len, NULL, 0);
-         stats->compressed /= 1024;
+      /* older ARCs keep no compressed sizes */
+      if (entry->offset == offsetof(ZfsArcStats, compressed))
+         stats->isCompressed = entry->mibLen > 0;
+   }
+}
 
-         len = sizeof(stats->uncompressed);
-         sysctl(MIB_kstat_zfs_misc_arcstats_uncompressed_size, 5, &(stats->uncompressed), &len, NULL, 0);
-         stats->uncompressed /= 1024;
-      }
+void openzfs_sysctl_updateArcStats(ZfsArcStats* stats) {
+   if (!stats->enabled)
+      return;
+
+   /* one sysctl(3) per value: the kstat nodes cannot be read together */
+   for (size_t i = 0; i < ARRAYSIZE(openzfs_sysctls); i++) {
+      OpenzfsSysctl* entry = &openzfs_sysctls[i];
+      if (!entry->mibLen)
+         continue;
+
+      unsigned long long int value;
+      size_t len = sizeof(value);
+      if (sysctl(entry->mib, entry->mibLen, &value, &len, NULL, 0) != 0)
+         continue;
+
+      value /= 1024;
+      memcpy((char*)stats + entry->offset, &value, sizeof(value));
    }
 }
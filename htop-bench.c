@@ -0,0 +1,511 @@
+/*
+htop - htop-bench.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+/*
+ * Benchmark of the Linux process scanner, built by "make bench".
+ *
+ * It fills a scratch directory (preferably on tmpfs) with a synthetic proc
+ * tree, reads it as the proc root and times scanning it, building the
+ * process tree and sorting the process list.
+ */
+
+#include "config.h" // IWYU pragma: keep
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "CRT.h"
+#include "DynamicColumn.h"
+#include "DynamicMeter.h"
+#include "DynamicScreen.h"
+#include "Hashtable.h"
+#include "Machine.h"
+#include "Macros.h"
+#include "Platform.h"
+#include "Process.h"
+#include "ProcessTable.h"
+#include "Profile.h"
+#include "Settings.h"
+#include "Table.h"
+#include "UsersTable.h"
+#include "Vector.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+#include "linux/LinuxProcess.h"
+
+
+const char* program = "htop-bench";
+
+/* Marks a directory as generated by this program, so it may be removed again */
+#define BENCH_MARKER ".htop-bench"
+
+static const char* Bench_root = "/dev/shm/htop-bench";
+
+/* Children of each process in the generated tree */
+#define BENCH_FANOUT 8
+
+typedef struct BenchOptions_ {
+   unsigned int processes;
+   unsigned int threads;      /* per process, besides the main thread */
+   unsigned int cmdlineLen;
+   unsigned int cgroupDepth;
+   unsigned int maps;         /* lines in the maps file of each process */
+   unsigned int iterations;
+   int scanThreads;
+   bool keep;
+} BenchOptions;
+
+static void Bench_usage(void) {
+   printf("Usage: %s [options]\n"
+          "Generate a synthetic proc tree in %s and time the process scanner on it.\n"
+          "\n"
+          "-p NUMBER   processes (default 1000)\n"
+          "-t NUMBER   threads of each process besides the main one (default 2)\n"
+          "-c NUMBER   length of each command line in bytes (default 128)\n"
+          "-g NUMBER   depth of the cgroup of each process, 0 - skip reading cgroups (default 3)\n"
+          "-m NUMBER   lines of each maps file, 0 - skip reading maps (default 32)\n"
+          "-n NUMBER   iterations (default 50)\n"
+#ifdef HAVE_PTHREAD
+          "-j NUMBER   scan worker threads, 0 - serial scan (default 0)\n"
+#endif
+          "-r DIR      directory of the generated tree (default %s)\n"
+          "-k          keep the generated tree\n"
+          "-h          print this help\n", program, Bench_root, Bench_root);
+}
+
+static bool Bench_parseCount(const char* arg, unsigned int max, unsigned int* out) {
+   char* end;
+   errno = 0;
+   unsigned long value = strtoul(arg, &end, 10);
+   if (errno || end == arg || *end || value > max)
+      return false;
+
+   *out = (unsigned int)value;
+   return true;
+}
+
+static bool Bench_parseOptions(int argc, char** argv, BenchOptions* opts) {
+   *opts = (BenchOptions) {
+      .processes = 1000,
+      .threads = 2,
+      .cmdlineLen = 128,
+      .cgroupDepth = 3,
+      .maps = 32,
+      .iterations = 50,
+      .scanThreads = 0,
+      .keep = false,
+   };
+
+   int opt;
+   while ((opt = getopt(argc, argv, "p:t:c:g:m:n:j:r:kh")) != -1) {
+      unsigned int value;
+      bool ok = true;
+      switch (opt) {
+         case 'p':
+            ok = Bench_parseCount(optarg, 1000000, &opts->processes) && opts->processes > 0;
+            break;
+         case 't':
+            ok = Bench_parseCount(optarg, 1000, &opts->threads);
+            break;
+         case 'c':
+            ok = Bench_parseCount(optarg, 4000, &opts->cmdlineLen);
+            break;
+         case 'g':
+            ok = Bench_parseCount(optarg, 32, &opts->cgroupDepth);
+            break;
+         case 'm':
+            ok = Bench_parseCount(optarg, 100000, &opts->maps);
+            break;
+         case 'n':
+            ok = Bench_parseCount(optarg, 1000000, &opts->iterations) && opts->iterations > 0;
+            break;
+         case 'j':
+            ok = Bench_parseCount(optarg, 64, &value);
+            opts->scanThreads = (int)value;
+            break;
+         case 'r':
+            ok = optarg[0] != '\0';
+            Bench_root = optarg;
+            break;
+         case 'k':
+            opts->keep = true;
+            break;
+         case 'h':
+            Bench_usage();
+            exit(0);
+         default:
+            Bench_usage();
+            return false;
+      }
+
+      if (!ok) {
+         fprintf(stderr, "Error: invalid value \"%s\" for -%c.\n", optarg, opt);
+         return false;
+      }
+   }
+
+   return true;
+}
+
+/* ---------------------------------------------------------------------- */
+
+static void Bench_writeFile(const char* dir, const char* name, const char* content, size_t len) {
+   char path[4096];
+   xSnprintf(path, sizeof(path), "%s/%s", dir, name);
+
+   int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+   if (fd < 0 || full_write(fd, content, len) != (ssize_t)len) {
+      fprintf(stderr, "Error: cannot write %s: %s\n", path, strerror(errno));
+      exit(1);
+   }
+   close(fd);
+}
+
+static void Bench_writeString(const char* dir, const char* name, const char* content) {
+   Bench_writeFile(dir, name, content, strlen(content));
+}
+
+static void Bench_makeDir(const char* path) {
+   if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+      fprintf(stderr, "Error: cannot create %s: %s\n", path, strerror(errno));
+      exit(1);
+   }
+}
+
+static int Bench_removeEntry(const char* path, ATTR_UNUSED const struct stat* sb, ATTR_UNUSED int type, ATTR_UNUSED struct FTW* ftw) {
+   return remove(path);
+}
+
+static bool Bench_isGenerated(void) {
+   char path[4096];
+   xSnprintf(path, sizeof(path), "%s/" BENCH_MARKER, Bench_root);
+   return access(path, F_OK) == 0;
+}
+
+static void Bench_removeTree(void) {
+   if (!Bench_isGenerated())
+      return;
+
+   if (nftw(Bench_root, Bench_removeEntry, 64, FTW_DEPTH | FTW_PHYS) != 0)
+      fprintf(stderr, "Warning: cannot remove %s: %s\n", Bench_root, strerror(errno));
+}
+
+static void Bench_writeMachineFiles(const BenchOptions* opts) {
+   char buffer[8192];
+   size_t len = 0;
+
+   /* the CPUs themselves are still looked up in /sys */
+   long cpus = sysconf(_SC_NPROCESSORS_CONF);
+   if (cpus < 1)
+      cpus = 1;
+
+   len += xSnprintf(buffer + len, sizeof(buffer) - len, "cpu  %ld 0 %ld %ld 0 0 0 0 0 0\n", 1000 * cpus, 500 * cpus, 100000 * cpus);
+   for (long i = 0; i < cpus && len < sizeof(buffer) - 256; i++)
+      len += xSnprintf(buffer + len, sizeof(buffer) - len, "cpu%ld 1000 0 500 100000 0 0 0 0 0 0\n", i);
+   len += xSnprintf(buffer + len, sizeof(buffer) - len,
+                    "intr 0\nctxt 0\nbtime %lld\nprocesses %u\nprocs_running 1\nprocs_blocked 0\n",
+                    (long long)time(NULL) - 100000, opts->processes);
+   Bench_writeFile(Bench_root, "stat", buffer, len);
+
+   Bench_writeString(Bench_root, "meminfo",
+                     "MemTotal:       16000000 kB\n"
+                     "MemFree:         8000000 kB\n"
+                     "MemAvailable:   12000000 kB\n"
+                     "Buffers:          200000 kB\n"
+                     "Cached:          3000000 kB\n"
+                     "SwapCached:            0 kB\n"
+                     "Shmem:            100000 kB\n"
+                     "SReclaimable:     200000 kB\n"
+                     "SwapTotal:       4000000 kB\n"
+                     "SwapFree:        4000000 kB\n");
+   Bench_writeString(Bench_root, "uptime", "100000.00 200000.00\n");
+   Bench_writeString(Bench_root, "loadavg", "1.00 1.00 1.00 1/100 1000\n");
+
+   char path[4096];
+   xSnprintf(path, sizeof(path), "%s/sys", Bench_root);
+   Bench_makeDir(path);
+   xSnprintf(path, sizeof(path), "%s/sys/kernel", Bench_root);
+   Bench_makeDir(path);
+   Bench_writeString(path, "pid_max", "4194304\n");
+
+   /* for the smaps_rollup check */
+   xSnprintf(path, sizeof(path), "%s/self", Bench_root);
+   if (symlink("1", path) != 0 && errno != EEXIST) {
+      fprintf(stderr, "Error: cannot create %s: %s\n", path, strerror(errno));
+      exit(1);
+   }
+}
+
+/* Files present both in the directory of a process and in those of its tasks */
+static void Bench_writeTaskFiles(const char* dir, const BenchOptions* opts, int pid, int tid, int ppid, const char* comm) {
+   char buffer[4096];
+   int len;
+
+   const unsigned int nlwp = opts->threads + 1;
+   const unsigned long vsize = 4096UL * (1000 + (unsigned long)pid % 5000);
+   const unsigned long rss = 100 + (unsigned long)pid % 3000;
+
+   len = xSnprintf(buffer, sizeof(buffer),
+                   "%d (%s) S %d %d %d 0 -1 4194560 %d 0 %d 0 %d %d 0 0 20 0 %u 0 %d %lu %lu "
+                   "18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 %d 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+                   tid, comm, ppid, pid, pid, tid % 1000, tid % 10, tid % 5000, tid % 700,
+                   nlwp, 1000 + pid, vsize, rss, tid % 4);
+   Bench_writeFile(dir, "stat", buffer, (size_t)len);
+
+   len = xSnprintf(buffer, sizeof(buffer), "%lu %lu %lu 10 0 %lu 0\n", vsize / 4096, rss, rss / 4, rss / 2);
+   Bench_writeFile(dir, "statm", buffer, (size_t)len);
+
+   len = xSnprintf(buffer, sizeof(buffer),
+                   "Name:\t%s\nUmask:\t0022\nState:\tS (sleeping)\nTgid:\t%d\nNgid:\t0\nPid:\t%d\nPPid:\t%d\n"
+                   "TracerPid:\t0\nUid:\t0\t0\t0\t0\nGid:\t0\t0\t0\t0\nFDSize:\t64\nGroups:\t\n"
+                   "NStgid:\t%d\nNSpid:\t%d\nNSpgid:\t%d\nNSsid:\t%d\n"
+                   "VmPeak:\t%8lu kB\nVmSize:\t%8lu kB\nVmRSS:\t%8lu kB\nThreads:\t%u\n"
+                   "SigQ:\t0/62811\nSigPnd:\t0000000000000000\nShdPnd:\t0000000000000000\n"
+                   "CapInh:\t0000000000000000\nCapPrm:\t000001ffffffffff\nCapEff:\t000001ffffffffff\n"
+                   "CapBnd:\t000001ffffffffff\nCapAmb:\t0000000000000000\nNoNewPrivs:\t0\nSeccomp:\t0\n"
+                   "Cpus_allowed_list:\t0-%ld\nvoluntary_ctxt_switches:\t%d\nnonvoluntary_ctxt_switches:\t%d\n",
+                   comm, pid, tid, ppid, pid, tid, pid, pid,
+                   vsize / 1024, vsize / 1024, rss * 4, nlwp, 0L, tid % 9000, tid % 90);
+   Bench_writeFile(dir, "status", buffer, (size_t)len);
+
+   len = xSnprintf(buffer, sizeof(buffer),
+                   "rchar: %d\nwchar: %d\nsyscr: %d\nsyscw: %d\nread_bytes: %d\nwrite_bytes: %d\ncancelled_write_bytes: 0\n",
+                   tid * 100, tid * 50, tid, tid / 2, tid * 16, tid * 8);
+   Bench_writeFile(dir, "io", buffer, (size_t)len);
+
+   len = xSnprintf(buffer, sizeof(buffer), "%s\n", comm);
+   Bench_writeFile(dir, "comm", buffer, (size_t)len);
+}
+
+static void Bench_writeProcess(const BenchOptions* opts, int pid, int ppid, int* nextTid) {
+   char dir[4096];
+   xSnprintf(dir, sizeof(dir), "%s/%d", Bench_root, pid);
+   Bench_makeDir(dir);
+
+   char comm[16];
+   xSnprintf(comm, sizeof(comm), "bench%d", pid % 100);
+   Bench_writeTaskFiles(dir, opts, pid, pid, ppid, comm);
+
+   /* arguments separated by NUL bytes like the kernel has them */
+   char cmdline[4096];
+   int len = xSnprintf(cmdline, sizeof(cmdline), "/usr/bin/%s", comm);
+   for (unsigned int arg = 0; (unsigned int)len + 1 < opts->cmdlineLen && (size_t)len + 32 < sizeof(cmdline); arg++)
+      len += 1 + xSnprintf(cmdline + len + 1, sizeof(cmdline) - (size_t)len - 1, "--option-%u=%d", arg, pid);
+   Bench_writeFile(dir, "cmdline", cmdline, (size_t)len + 1);
+
+   char buffer[8192];
+   if (opts->cgroupDepth) {
+      len = xSnprintf(buffer, sizeof(buffer), "0::");
+      for (unsigned int level = 0; level + 1 < opts->cgroupDepth; level++)
+         len += xSnprintf(buffer + len, sizeof(buffer) - (size_t)len, "/level%u-%d.slice", level, (pid >> (2 * level)) % 4);
+      len += xSnprintf(buffer + len, sizeof(buffer) - (size_t)len, "/bench-%d.scope\n", pid % 64);
+      Bench_writeFile(dir, "cgroup", buffer, (size_t)len);
+   }
+
+   if (opts->maps) {
+      char path[4096];
+      xSnprintf(path, sizeof(path), "%s/maps", dir);
+      FILE* maps = fopen(path, "w");
+      if (!maps) {
+         fprintf(stderr, "Error: cannot write %s: %s\n", path, strerror(errno));
+         exit(1);
+      }
+      unsigned long start = 0x400000;
+      for (unsigned int i = 0; i < opts->maps; i++) {
+         const unsigned long size = 4096UL * (1 + i % 16);
+         fprintf(maps, "%012lx-%012lx %s %08x 08:01 %u                    /usr/lib/libbench%u.so\n",
+                 start, start + size, i % 2 ? "rw-p" : "r-xp", i * 4096, 1000 + i, i / 2);
+         start += size;
+      }
+      fclose(maps);
+
+      len = xSnprintf(buffer, sizeof(buffer),
+                      "%012lx-%012lx ---p 00000000 00:00 0                          [rollup]\n"
+                      "Rss:                1000 kB\nPss:                 %d kB\nShared_Clean:         400 kB\n"
+                      "Private_Dirty:      200 kB\nAnonymous:          300 kB\nSwap:                 0 kB\nSwapPss:              0 kB\n",
+                      0x400000UL, start, 100 + pid % 800);
+      Bench_writeFile(dir, "smaps_rollup", buffer, (size_t)len);
+   }
+
+   char taskDir[4096];
+   xSnprintf(taskDir, sizeof(taskDir), "%s/task", dir);
+   Bench_makeDir(taskDir);
+
+   for (unsigned int i = 0; i <= opts->threads; i++) {
+      const int tid = i == 0 ? pid : (*nextTid)++;
+      char threadDir[4096];
+      xSnprintf(threadDir, sizeof(threadDir), "%s/%d", taskDir, tid);
+      Bench_makeDir(threadDir);
+      Bench_writeTaskFiles(threadDir, opts, pid, tid, ppid, comm);
+      Bench_writeFile(threadDir, "cmdline", cmdline, strlen(cmdline) + 1);
+   }
+}
+
+static void Bench_generate(const BenchOptions* opts) {
+   struct stat st;
+   if (stat(Bench_root, &st) == 0 && !Bench_isGenerated()) {
+      fprintf(stderr, "Error: %s already exists and was not created by %s.\n", Bench_root, program);
+      exit(1);
+   }
+
+   Bench_removeTree();
+
+   Bench_makeDir(Bench_root);
+   Bench_writeString(Bench_root, BENCH_MARKER, "");
+   Bench_writeMachineFiles(opts);
+
+   /* threads get the IDs following those of the processes */
+   int nextTid = (int)opts->processes + 1;
+   for (unsigned int i = 0; i < opts->processes; i++) {
+      const int pid = (int)i + 1;
+      const int ppid = pid == 1 ? 0 : 1 + (pid - 2) / BENCH_FANOUT;
+      Bench_writeProcess(opts, pid, ppid, &nextTid);
+   }
+}
+
+/* ---------------------------------------------------------------------- */
+
+static void Bench_sort(Table* table, ScreenSettings* ss, ProcessField key, int phase) {
+   ss->treeView = false;
+   ScreenSettings_setSortKey(ss, key);
+   table->needsSort = true;
+
+   const ProfileMark mark = Profile_begin();
+   Table_updateDisplayList(table);
+   Profile_end(phase, mark);
+}
+
+static void Bench_report(const BenchOptions* opts, const Table* table) {
+   printf("%u processes with %u threads each, %d rows, %u iterations\n",
+          opts->processes, opts->threads, Vector_size(table->rows), opts->iterations);
+   printf("%-16s %9s %12s %12s %12s %12s\n", "phase", "count", "ns/op", "p50 ns/op", "p99 ns/op", "max ns/op");
+
+   for (size_t i = 0; i < Profile_phaseCount; i++) {
+      const ProfileStats* stats = &Profile_stats[i];
+      if (!stats->count)
+         continue;
+
+      printf("%-16s %9llu %12llu %12llu %12llu %12llu\n",
+             stats->name,
+             (unsigned long long)stats->count,
+             (unsigned long long)(stats->totalNs / stats->count),
+             (unsigned long long)Profile_percentile(stats, 0.5),
+             (unsigned long long)Profile_percentile(stats, 0.99),
+             (unsigned long long)stats->maxNs);
+   }
+}
+
+int main(int argc, char** argv) {
+   BenchOptions opts;
+   if (!Bench_parseOptions(argc, argv, &opts))
+      return 1;
+
+   Bench_generate(&opts);
+
+   FsRoot_setPath(&FsRoot_proc, Bench_root);
+   if (!Platform_init())
+      return 1;
+
+   UsersTable* ut = UsersTable_new();
+   Hashtable* dm = DynamicMeters_new();
+   Hashtable* dc = DynamicColumns_new();
+   Hashtable* ds = DynamicScreens_new();
+
+   Machine* host = Machine_new(ut, (uid_t)-1);
+   ProcessTable* pt = ProcessTable_new(host, NULL);
+   /* defaults only, no configuration file is read or written */
+   Settings* settings = Settings_newDefault(host->activeCPUs, dm, dc, ds);
+   Machine_populateTablesFromSettings(host, settings, &pt->super);
+
+   /* the terminal is left alone, rows still need attributes for their command */
+   CRT_setColors(COLORSCHEME_MONOCHROME);
+
+   settings->hideUserlandThreads = false;
+   settings->lazyCollection = false;
+#ifdef HAVE_PROC_CONNECTOR
+   settings->procConnector = false;
+#endif
+#ifdef HAVE_PTHREAD
+   settings->scanThreads = opts.scanThreads;
+#endif
+
+   ScreenSettings* ss = settings->ss;
+   ss->flags |= PROCESS_FLAG_IO;
+   if (opts.cgroupDepth)
+      ss->flags |= PROCESS_FLAG_LINUX_CGROUP;
+   if (opts.maps)
+      ss->flags |= PROCESS_FLAG_LINUX_SMAPS | PROCESS_FLAG_LINUX_LRS_FIX;
+
+   const int firstScanPhase = Profile_addPhase("first scan");
+   const int treePhase = Profile_addPhase("tree build");
+   const int sortPidPhase = Profile_addPhase("sort by PID");
+   const int sortMemPhase = Profile_addPhase("sort by RES");
+   const int sortCommPhase = Profile_addPhase("sort by Command");
+
+   /* the first scan adds all processes, the timed ones update them */
+   ProfileMark mark = Profile_begin();
+   Machine_scan(host);
+   Machine_scanTables(host);
+   Profile_end(firstScanPhase, mark);
+
+   /* only what the timed iterations did */
+   for (size_t i = 0; i < Profile_phaseCount; i++) {
+      if ((int)i == firstScanPhase)
+         continue;
+
+      const char* name = Profile_stats[i].name;
+      memset(&Profile_stats[i], 0, sizeof(Profile_stats[i]));
+      Profile_stats[i].name = name;
+   }
+
+   Table* table = &pt->super;
+   for (unsigned int i = 0; i < opts.iterations; i++) {
+      mark = Profile_begin();
+      Machine_scan(host);
+      Profile_end(PROFILE_MACHINE_SCAN, mark);
+
+      Machine_scanTables(host);
+
+      ss->treeView = true;
+      table->needsSort = true;
+      mark = Profile_begin();
+      Table_updateDisplayList(table);
+      Profile_end(treePhase, mark);
+
+      Bench_sort(table, ss, PID, sortPidPhase);
+      Bench_sort(table, ss, M_RESIDENT, sortMemPhase);
+      Bench_sort(table, ss, COMM, sortCommPhase);
+   }
+
+   /* also counted within the phases above */
+   Profile_stats[PROFILE_DISPLAY_LIST].count = 0;
+
+   Bench_report(&opts, table);
+
+   Machine_delete(host);
+   UsersTable_delete(ut);
+   Settings_delete(settings);
+   DynamicColumns_delete(dc);
+   DynamicMeters_delete(dm);
+   DynamicScreens_delete(ds);
+
+   Platform_done();
+
+   if (!opts.keep)
+      Bench_removeTree();
+
+   return 0;
+}
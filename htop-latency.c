@@ -0,0 +1,403 @@
+/*
+htop - htop-latency.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+/*
+ * Interactive latency harness, run by "make latency".
+ *
+ * It starts htop on a pseudo-terminal, reading the synthetic proc tree of
+ * htop-bench, and presses keys: scrolling, typing a search, toggling the
+ * tree view, changing the sort order and switching screens. Each key is
+ * timed from being written until the terminal output settles, that is
+ * nothing more was written for a while, and the bytes of the frame are
+ * counted.
+ */
+
+#include "config.h" // IWYU pragma: keep
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+
+
+static const char* program = "htop-latency";
+
+typedef struct LatencyOptions_ {
+   const char* htop;
+   const char* procRoot;
+   unsigned int rounds;
+   unsigned int columns;
+   unsigned int rows;
+   unsigned int settleMs;     /* output quiet this long ends a frame */
+   unsigned int timeoutMs;    /* a key without a frame by then counts as missed */
+} LatencyOptions;
+
+/* One key and what it does, keys of an action share their statistics */
+typedef struct LatencyKey_ {
+   const char* action;
+   const char* sequence;      /* as the xterm terminfo entry has it, the keypad in application mode */
+} LatencyKey;
+
+/* One round; it leaves htop as it found it, so the rounds time the same work */
+static const LatencyKey Latency_round[] = {
+   { "scroll-down", "\033OB" },
+   { "scroll-down", "\033OB" },
+   { "scroll-down", "\033OB" },
+   { "scroll-down", "\033OB" },
+   { "page-down", "\033[6~" },
+   { "page-up", "\033[5~" },
+   { "scroll-up", "\033OA" },
+   { "scroll-up", "\033OA" },
+   { "scroll-up", "\033OA" },
+   { "scroll-up", "\033OA" },
+   { "search-open", "/" },
+   { "search-type", "b" },
+   { "search-type", "e" },
+   { "search-type", "n" },
+   { "search-type", "c" },
+   { "search-type", "h" },
+   /* a lone escape is only taken after the escape delay of curses (ESCDELAY) */
+   { "search-close", "\033" },
+   { "tree-toggle", "\033[15~" },
+   { "tree-toggle", "\033[15~" },
+   { "sort-change", "M" },
+   { "sort-change", "P" },
+   { "screen-switch", "\t" },
+   { "screen-switch", "\033[Z" },
+};
+
+#define LATENCY_KEYS (sizeof(Latency_round) / sizeof(Latency_round[0]))
+
+typedef struct LatencyStats_ {
+   const char* action;
+   double* ms;
+   size_t count;
+   size_t alloc;
+   unsigned long long bytes;
+   unsigned int missed;
+} LatencyStats;
+
+static void Latency_usage(void) {
+   printf("Usage: %s [options] [HTOP]\n"
+          "Run HTOP (default ./htop) on a pseudo-terminal and time how long it takes to\n"
+          "draw the frame answering each of a round of keys.\n"
+          "\n"
+          "-r DIR      proc tree to read, as generated by htop-bench -k (default /dev/shm/htop-bench)\n"
+          "-n NUMBER   rounds of keys (default 20)\n"
+          "-s COLSxROWS  size of the terminal (default 160x50)\n"
+          "-q MS       output quiet this long ends a frame (default 30)\n"
+          "-t MS       a key without output by then is counted as missed (default 2000)\n"
+          "-h          print this help\n", program);
+}
+
+static bool Latency_parseNumber(const char* arg, unsigned int min, unsigned int max, unsigned int* out) {
+   char* end;
+   errno = 0;
+   unsigned long value = strtoul(arg, &end, 10);
+   if (errno || end == arg || *end || value < min || value > max)
+      return false;
+
+   *out = (unsigned int)value;
+   return true;
+}
+
+static bool Latency_parseOptions(int argc, char** argv, LatencyOptions* opts) {
+   *opts = (LatencyOptions) {
+      .htop = "./htop",
+      .procRoot = "/dev/shm/htop-bench",
+      .rounds = 20,
+      .columns = 160,
+      .rows = 50,
+      .settleMs = 30,
+      .timeoutMs = 2000,
+   };
+
+   int opt;
+   while ((opt = getopt(argc, argv, "r:n:s:q:t:h")) != -1) {
+      bool ok = true;
+      switch (opt) {
+         case 'r':
+            ok = optarg[0] != '\0';
+            opts->procRoot = optarg;
+            break;
+         case 'n':
+            ok = Latency_parseNumber(optarg, 1, 100000, &opts->rounds);
+            break;
+         case 's': {
+            char columns[16];
+            const char* x = strchr(optarg, 'x');
+            ok = x && (size_t)(x - optarg) < sizeof(columns);
+            if (ok) {
+               memcpy(columns, optarg, (size_t)(x - optarg));
+               columns[x - optarg] = '\0';
+               ok = Latency_parseNumber(columns, 20, 1000, &opts->columns) && Latency_parseNumber(x + 1, 10, 1000, &opts->rows);
+            }
+            break;
+         }
+         case 'q':
+            ok = Latency_parseNumber(optarg, 1, 10000, &opts->settleMs);
+            break;
+         case 't':
+            ok = Latency_parseNumber(optarg, 10, 600000, &opts->timeoutMs);
+            break;
+         case 'h':
+            Latency_usage();
+            exit(0);
+         default:
+            Latency_usage();
+            return false;
+      }
+
+      if (!ok) {
+         fprintf(stderr, "Error: invalid value \"%s\" for -%c.\n", optarg, opt);
+         return false;
+      }
+   }
+
+   if (optind < argc)
+      opts->htop = argv[optind];
+
+   return true;
+}
+
+/* ---------------------------------------------------------------------- */
+
+static uint64_t Latency_nowNs(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Starts htop with the pseudo-terminal as its controlling terminal; returns its pid */
+static pid_t Latency_spawn(const LatencyOptions* opts, int* masterFd) {
+   int master = posix_openpt(O_RDWR | O_NOCTTY);
+   if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+      fprintf(stderr, "Error: cannot open a pseudo-terminal: %s\n", strerror(errno));
+      exit(1);
+   }
+
+   const char* slaveName = ptsname(master);
+   if (!slaveName) {
+      fprintf(stderr, "Error: cannot name the pseudo-terminal: %s\n", strerror(errno));
+      exit(1);
+   }
+
+   char procRoot[4096];
+   snprintf(procRoot, sizeof(procRoot), "--proc-root=%s", opts->procRoot);
+   char htoprc[4096];
+   snprintf(htoprc, sizeof(htoprc), "%s/htoprc", opts->procRoot);
+
+   pid_t pid = fork();
+   if (pid < 0) {
+      fprintf(stderr, "Error: cannot fork: %s\n", strerror(errno));
+      exit(1);
+   }
+
+   if (pid == 0) {
+      setsid();
+      int slave = open(slaveName, O_RDWR);
+      if (slave < 0)
+         _exit(127);
+
+      ioctl(slave, TIOCSCTTY, 0);
+      struct winsize size = { .ws_row = (unsigned short)opts->rows, .ws_col = (unsigned short)opts->columns };
+      ioctl(slave, TIOCSWINSZ, &size);
+
+      /* stderr stays with the harness, for messages of sanitizers */
+      dup2(slave, STDIN_FILENO);
+      dup2(slave, STDOUT_FILENO);
+      close(slave);
+      close(master);
+
+      /* the settings of the benchmark tree; a long delay keeps the refreshes out of the frames timed */
+      setenv("TERM", "xterm", 1);
+      setenv("HTOPRC", htoprc, 1);
+      execl(opts->htop, opts->htop, procRoot, "--delay=100", (char*)NULL);
+      _exit(127);
+   }
+
+   fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+   *masterFd = master;
+   return pid;
+}
+
+/*
+ * Reads the output until it was quiet for `settleMs`, or until `timeoutMs`
+ * passed without any. Returns the bytes read; `lastNs` is when the last of
+ * them came in.
+ */
+static size_t Latency_settle(int fd, unsigned int settleMs, unsigned int timeoutMs, uint64_t* lastNs) {
+   char buffer[65536];
+   size_t bytes = 0;
+   const uint64_t startNs = Latency_nowNs();
+
+   for (;;) {
+      const uint64_t now = Latency_nowNs();
+      const uint64_t deadline = bytes ? *lastNs + settleMs * 1000000ULL : startNs + timeoutMs * 1000000ULL;
+      if (now >= deadline)
+         break;
+
+      struct pollfd pfd = { .fd = fd, .events = POLLIN };
+      int ready = poll(&pfd, 1, (int)((deadline - now + 999999) / 1000000));
+      if (ready < 0 && errno != EINTR)
+         break;
+      if (ready <= 0)
+         continue;
+
+      ssize_t r = read(fd, buffer, sizeof(buffer));
+      if (r > 0) {
+         bytes += (size_t)r;
+         *lastNs = Latency_nowNs();
+      } else if (r == 0 || (errno != EAGAIN && errno != EINTR)) {
+         /* htop is gone */
+         break;
+      }
+   }
+
+   return bytes;
+}
+
+static void Latency_write(int fd, const char* sequence) {
+   size_t len = strlen(sequence);
+   while (len > 0) {
+      ssize_t w = write(fd, sequence, len);
+      if (w < 0) {
+         if (errno == EINTR || errno == EAGAIN)
+            continue;
+         fprintf(stderr, "Error: cannot write to the pseudo-terminal: %s\n", strerror(errno));
+         exit(1);
+      }
+      sequence += w;
+      len -= (size_t)w;
+   }
+}
+
+static LatencyStats* Latency_statsOf(LatencyStats* stats, size_t* count, const char* action) {
+   for (size_t i = 0; i < *count; i++) {
+      if (strcmp(stats[i].action, action) == 0)
+         return &stats[i];
+   }
+
+   stats[*count] = (LatencyStats) { .action = action };
+   return &stats[(*count)++];
+}
+
+static void Latency_record(LatencyStats* stats, double ms, size_t bytes) {
+   if (stats->count == stats->alloc) {
+      stats->alloc = stats->alloc ? 2 * stats->alloc : 64;
+      stats->ms = realloc(stats->ms, stats->alloc * sizeof(double));
+      if (!stats->ms) {
+         fprintf(stderr, "Error: out of memory\n");
+         exit(1);
+      }
+   }
+   stats->ms[stats->count++] = ms;
+   stats->bytes += bytes;
+}
+
+static int Latency_compareMs(const void* v1, const void* v2) {
+   const double d1 = *(const double*)v1;
+   const double d2 = *(const double*)v2;
+   return (d1 > d2) - (d1 < d2);
+}
+
+static double Latency_percentile(const LatencyStats* stats, double p) {
+   size_t index = (size_t)(p * (double)(stats->count - 1) + 0.5);
+   return stats->ms[index];
+}
+
+static void Latency_report(const LatencyOptions* opts, LatencyStats* stats, size_t count) {
+   printf("%u rounds on a %ux%u terminal, frames end after %u ms without output\n",
+          opts->rounds, opts->columns, opts->rows, opts->settleMs);
+   printf("%-16s %8s %10s %10s %10s %12s %8s\n", "action", "frames", "p50 ms", "p99 ms", "max ms", "bytes/frame", "missed");
+
+   for (size_t i = 0; i < count; i++) {
+      LatencyStats* s = &stats[i];
+      if (s->count == 0) {
+         printf("%-16s %8d %10s %10s %10s %12s %8u\n", s->action, 0, "-", "-", "-", "-", s->missed);
+         continue;
+      }
+
+      qsort(s->ms, s->count, sizeof(double), Latency_compareMs);
+      printf("%-16s %8zu %10.2f %10.2f %10.2f %12llu %8u\n",
+             s->action, s->count, Latency_percentile(s, 0.5), Latency_percentile(s, 0.99), s->ms[s->count - 1],
+             s->bytes / s->count, s->missed);
+   }
+}
+
+int main(int argc, char** argv) {
+   LatencyOptions opts;
+   if (!Latency_parseOptions(argc, argv, &opts))
+      return 1;
+
+   if (access(opts.htop, X_OK) != 0) {
+      fprintf(stderr, "Error: cannot run %s: %s\n", opts.htop, strerror(errno));
+      return 1;
+   }
+
+   signal(SIGPIPE, SIG_IGN);
+
+   int fd;
+   pid_t pid = Latency_spawn(&opts, &fd);
+
+   /* the first frame, after the first scans */
+   uint64_t lastNs = 0;
+   if (Latency_settle(fd, 500, 10000, &lastNs) == 0) {
+      fprintf(stderr, "Error: %s drew nothing.\n", opts.htop);
+      kill(pid, SIGTERM);
+      waitpid(pid, NULL, 0);
+      return 1;
+   }
+
+   LatencyStats stats[LATENCY_KEYS];
+   size_t statsCount = 0;
+
+   for (unsigned int round = 0; round < opts.rounds; round++) {
+      for (size_t k = 0; k < LATENCY_KEYS; k++) {
+         LatencyStats* s = Latency_statsOf(stats, &statsCount, Latency_round[k].action);
+
+         /* whatever was still coming in does not count for this key */
+         Latency_settle(fd, opts.settleMs, opts.settleMs, &lastNs);
+
+         const uint64_t startNs = Latency_nowNs();
+         Latency_write(fd, Latency_round[k].sequence);
+         const size_t bytes = Latency_settle(fd, opts.settleMs, opts.timeoutMs, &lastNs);
+         if (bytes == 0) {
+            s->missed++;
+            continue;
+         }
+
+         Latency_record(s, (double)(lastNs - startNs) / 1e6, bytes);
+      }
+   }
+
+   Latency_write(fd, "q");
+   Latency_settle(fd, opts.settleMs, 1000, &lastNs);
+   int status = 0;
+   if (waitpid(pid, &status, WNOHANG) == 0) {
+      kill(pid, SIGTERM);
+      waitpid(pid, &status, 0);
+   }
+   close(fd);
+
+   Latency_report(&opts, stats, statsCount);
+
+   for (size_t i = 0; i < statsCount; i++)
+      free(stats[i].ms);
+
+   return 0;
+}
@@ -0,0 +1,585 @@
+/*
+htop - htop-microbench.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+/*
+ * Microbenchmarks of the containers and formatting primitives the display
+ * path is built on, run by "make microbench".
+ *
+ * The inputs are generated from a fixed seed, so runs on one machine are
+ * comparable. Each case is run a number of times and the median and the
+ * fastest time per operation go out as JSON on stdout.
+ */
+
+#include "config.h" // IWYU pragma: keep
+
+#include <errno.h>
+#include <getopt.h>
+#include <locale.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "CRT.h"
+#include "DynamicColumn.h"
+#include "DynamicMeter.h"
+#include "DynamicScreen.h"
+#include "Hashtable.h"
+#include "Machine.h"
+#include "Macros.h"
+#include "Object.h"
+#include "Platform.h"
+#include "Process.h"
+#include "ProcessTable.h"
+#include "RichString.h"
+#include "Row.h"
+#include "Settings.h"
+#include "UsersTable.h"
+#include "Vector.h"
+#include "XUtils.h"
+
+#include "linux/CGroupUtils.h"
+#include "linux/LinuxProcess.h"
+
+
+const char* program = "htop-microbench";
+
+/* Runs of each case when not given */
+#define MICROBENCH_RUNS 7
+
+/* Runs of a case at most */
+#define MICROBENCH_MAX_RUNS 101
+
+typedef struct MicrobenchOptions_ {
+   unsigned int runs;
+   const char* filter;        /* only the benchmarks whose name contains it, NULL for all */
+} MicrobenchOptions;
+
+static MicrobenchOptions Microbench_options = { .runs = MICROBENCH_RUNS, .filter = NULL };
+
+static bool Microbench_firstResult = true;
+
+static void Microbench_usage(void) {
+   printf("Usage: %s [options]\n"
+          "Time the containers and formatting primitives of htop, results as JSON on stdout.\n"
+          "\n"
+          "-n NUMBER   runs of each case, the median and fastest are reported (default %d)\n"
+          "-f TEXT     only the benchmarks whose name contains TEXT\n"
+          "-h          print this help\n", program, MICROBENCH_RUNS);
+}
+
+static bool Microbench_parseOptions(int argc, char** argv) {
+   int opt;
+   while ((opt = getopt(argc, argv, "n:f:h")) != -1) {
+      switch (opt) {
+         case 'n': {
+            char* end;
+            errno = 0;
+            unsigned long value = strtoul(optarg, &end, 10);
+            if (errno || end == optarg || *end || value < 1 || value > MICROBENCH_MAX_RUNS) {
+               fprintf(stderr, "Error: invalid value \"%s\" for -n, 1 to %d runs.\n", optarg, MICROBENCH_MAX_RUNS);
+               return false;
+            }
+            Microbench_options.runs = (unsigned int)value;
+            break;
+         }
+         case 'f':
+            Microbench_options.filter = optarg;
+            break;
+         case 'h':
+            Microbench_usage();
+            exit(0);
+         default:
+            Microbench_usage();
+            return false;
+      }
+   }
+
+   return true;
+}
+
+/* ---------------------------------------------------------------------- */
+
+/* xorshift64*, seeded anew for every case so the inputs do not depend on which cases ran */
+static uint64_t Microbench_state;
+
+static void Microbench_seed(uint64_t seed) {
+   Microbench_state = seed ? seed : UINT64_C(0x9E3779B97F4A7C15);
+}
+
+static uint64_t Microbench_random(void) {
+   Microbench_state ^= Microbench_state >> 12;
+   Microbench_state ^= Microbench_state << 25;
+   Microbench_state ^= Microbench_state >> 27;
+   return Microbench_state * UINT64_C(0x2545F4914F6CDD1D);
+}
+
+/* Uniform in [0, bound) */
+static uint64_t Microbench_below(uint64_t bound) {
+   return Microbench_random() % bound;
+}
+
+static uint64_t Microbench_now(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static bool Microbench_selected(const char* name) {
+   return !Microbench_options.filter || strstr(name, Microbench_options.filter);
+}
+
+static int Microbench_compareDouble(const void* v1, const void* v2) {
+   const double d1 = *(const double*)v1;
+   const double d2 = *(const double*)v2;
+   return SPACESHIP_NUMBER(d1, d2);
+}
+
+/* Writes one result, from the nanoseconds per operation of each run */
+static void Microbench_report(const char* name, const char* variant, size_t size, size_t ops, double* nsPerOp, unsigned int runs) {
+   qsort(nsPerOp, runs, sizeof(double), Microbench_compareDouble);
+
+   printf("%s\n    {\"name\": \"%s\", \"case\": \"%s\", \"size\": %zu, \"ops\": %zu, \"runs\": %u, \"ns_per_op\": {\"median\": %.2f, \"min\": %.2f}}",
+          Microbench_firstResult ? "" : ",", name, variant, size, ops, runs, nsPerOp[runs / 2], nsPerOp[0]);
+   Microbench_firstResult = false;
+   fflush(stdout);
+}
+
+/* ---------------------------------------------------------------------- */
+
+/* A row reduced to its sort key, compared like Process_compare() with the id breaking ties */
+typedef struct MicrobenchItem_ {
+   Object super;
+   uint64_t key;
+   int id;
+} MicrobenchItem;
+
+static int MicrobenchItem_compare(const void* v1, const void* v2) {
+   const MicrobenchItem* i1 = v1;
+   const MicrobenchItem* i2 = v2;
+   int result = SPACESHIP_NUMBER(i1->key, i2->key);
+   return result ? result : SPACESHIP_NUMBER(i1->id, i2->id);
+}
+
+static const ObjectClass MicrobenchItem_class = {
+   .extends = Class(Object),
+   .compare = MicrobenchItem_compare,
+};
+
+typedef enum MicrobenchKeys_ {
+   KEYS_PID,                  /* sorted, a few new processes out of place */
+   KEYS_CPU,                  /* most idle, ties everywhere */
+   KEYS_RES,                  /* spread over orders of magnitude */
+   KEYS_USER,                 /* few distinct values, some far more common */
+} MicrobenchKeys;
+
+static const char* const Microbench_keyNames[] = { "pid", "cpu", "res", "user" };
+
+static uint64_t Microbench_key(MicrobenchKeys keys, int i, int n) {
+   switch (keys) {
+      case KEYS_PID:
+         return Microbench_below(50) == 0 ? Microbench_below((uint64_t)n * 16) : (uint64_t)i * 16;
+      case KEYS_CPU:
+         return Microbench_below(10) == 0 ? Microbench_below(1000) : 0;
+      case KEYS_RES:
+         /* 100 KiB to about 10 GiB, uniform in the logarithm */
+         return (100ULL << Microbench_below(17)) | Microbench_below(100);
+      case KEYS_USER: {
+         /* user 0 for half of them, user 1 for a quarter, ... */
+         uint64_t user = 0;
+         while (user < 7 && Microbench_below(2) == 0)
+            user++;
+         return user;
+      }
+   }
+   return 0;
+}
+
+/* Items with keys of the distribution, in a vector and in the order they were made */
+static Vector* Microbench_makeItems(MicrobenchKeys keys, int n, Object*** order) {
+   Vector* items = Vector_new(&MicrobenchItem_class, false, n);
+   *order = xMallocArray((size_t)n, sizeof(Object*));
+   for (int i = 0; i < n; i++) {
+      MicrobenchItem* item = xCalloc(1, sizeof(MicrobenchItem));
+      Object_setClass(item, &MicrobenchItem_class);
+      item->key = Microbench_key(keys, i, n);
+      item->id = i;
+      Vector_add(items, item);
+      (*order)[i] = &item->super;
+   }
+   return items;
+}
+
+static void Microbench_sortCase(const char* name, MicrobenchKeys keys, int n, bool insertion) {
+   if (!Microbench_selected(name))
+      return;
+
+   Microbench_seed((uint64_t)n * 31 + keys);
+   Object** order;
+   Vector* items = Microbench_makeItems(keys, n, &order);
+
+   /* insertion sort is meant for lists that are nearly in order already:
+      the items are sorted, then a few percent of the keys change */
+   if (insertion) {
+      Vector_quickSortCustomCompare(items, MicrobenchItem_compare);
+      for (int i = 0; i < n; i++) {
+         MicrobenchItem* item = (MicrobenchItem*)Vector_get(items, i);
+         if (Microbench_below(25) == 0)
+            item->key = Microbench_key(keys, item->id, n);
+         order[i] = &item->super;
+      }
+   }
+
+   const unsigned int runs = Microbench_options.runs;
+   double nsPerOp[MICROBENCH_MAX_RUNS];
+   /* enough sorts per run for the clock not to matter */
+   const int sorts = MAXIMUM(1, 200000 / n);
+   for (unsigned int r = 0; r < runs; r++) {
+      uint64_t total = 0;
+      for (int s = 0; s < sorts; s++) {
+         memcpy(items->array, order, (size_t)n * sizeof(Object*));
+         const uint64_t start = Microbench_now();
+         if (insertion) {
+            Vector_insertionSort(items);
+         } else {
+            Vector_quickSortCustomCompare(items, MicrobenchItem_compare);
+         }
+         total += Microbench_now() - start;
+      }
+      nsPerOp[r] = (double)total / sorts;
+   }
+
+   Microbench_report(name, Microbench_keyNames[keys], (size_t)n, (size_t)sorts, nsPerOp, runs);
+
+   for (int i = 0; i < n; i++)
+      free(order[i]);
+   free(order);
+   Vector_delete(items);
+}
+
+static void Microbench_sorting(void) {
+   static const int sizes[] = { 1000, 30000 };
+
+   for (size_t s = 0; s < ARRAYSIZE(sizes); s++) {
+      for (int keys = KEYS_PID; keys <= KEYS_USER; keys++) {
+         Microbench_sortCase("Vector_quickSortCustomCompare", (MicrobenchKeys)keys, sizes[s], false);
+         Microbench_sortCase("Vector_insertionSort", (MicrobenchKeys)keys, sizes[s], true);
+      }
+   }
+}
+
+/* ---------------------------------------------------------------------- */
+
+/* Dense keys are PIDs in a row; sparse ones are spread over 32 bits, colliding and displacing each other */
+static void Microbench_hashtableCase(size_t n, bool sparse) {
+   static const char* const names[] = { "Hashtable_put", "Hashtable_get", "Hashtable_get_miss", "Hashtable_remove" };
+   bool any = false;
+   for (size_t i = 0; i < ARRAYSIZE(names); i++)
+      any |= Microbench_selected(names[i]);
+   if (!any)
+      return;
+
+   Microbench_seed(n * 2 + sparse);
+   ht_key_t* keys = xMallocArray(n, sizeof(ht_key_t));
+   ht_key_t* misses = xMallocArray(n, sizeof(ht_key_t));
+   for (size_t i = 0; i < n; i++) {
+      keys[i] = sparse ? (ht_key_t)Microbench_random() : (ht_key_t)(i + 1);
+      misses[i] = sparse ? (ht_key_t)Microbench_random() : (ht_key_t)(n + 1 + i);
+   }
+   /* the lookups come in another order than the inserts */
+   ht_key_t* shuffled = xMallocArray(n, sizeof(ht_key_t));
+   memcpy(shuffled, keys, n * sizeof(ht_key_t));
+   for (size_t i = n - 1; i > 0; i--) {
+      size_t j = (size_t)Microbench_below(i + 1);
+      ht_key_t tmp = shuffled[i];
+      shuffled[i] = shuffled[j];
+      shuffled[j] = tmp;
+   }
+
+   const unsigned int runs = Microbench_options.runs;
+   double nsPerOp[ARRAYSIZE(names)][MICROBENCH_MAX_RUNS];
+   static char value;
+   size_t found = 0;
+   for (unsigned int r = 0; r < runs; r++) {
+      Hashtable* table = Hashtable_new(64, false);
+
+      uint64_t start = Microbench_now();
+      for (size_t i = 0; i < n; i++)
+         Hashtable_put(table, keys[i], &value);
+      nsPerOp[0][r] = (double)(Microbench_now() - start) / n;
+
+      start = Microbench_now();
+      for (size_t i = 0; i < n; i++)
+         found += Hashtable_get(table, shuffled[i]) != NULL;
+      nsPerOp[1][r] = (double)(Microbench_now() - start) / n;
+
+      start = Microbench_now();
+      for (size_t i = 0; i < n; i++)
+         found += Hashtable_get(table, misses[i]) != NULL;
+      nsPerOp[2][r] = (double)(Microbench_now() - start) / n;
+
+      start = Microbench_now();
+      for (size_t i = 0; i < n; i++)
+         found += Hashtable_remove(table, shuffled[i]) != NULL;
+      nsPerOp[3][r] = (double)(Microbench_now() - start) / n;
+
+      Hashtable_delete(table);
+   }
+
+   /* keeps the lookups from being optimized away */
+   if (found == 0)
+      fprintf(stderr, "Warning: no keys were found.\n");
+
+   for (size_t i = 0; i < ARRAYSIZE(names); i++) {
+      if (Microbench_selected(names[i]))
+         Microbench_report(names[i], sparse ? "sparse" : "dense", n, n, nsPerOp[i], runs);
+   }
+
+   free(shuffled);
+   free(misses);
+   free(keys);
+}
+
+static void Microbench_hashtable(void) {
+   for (size_t n = 1000; n <= 1000000; n *= 10) {
+      Microbench_hashtableCase(n, false);
+      Microbench_hashtableCase(n, true);
+   }
+}
+
+/* ---------------------------------------------------------------------- */
+
+/* Appends of one text, the string rewound after each */
+static void Microbench_appendCase(const char* variant, const char* text) {
+   const char* name = "RichString_appendnWideColumns";
+   if (!Microbench_selected(name))
+      return;
+
+   const int len = (int)strlen(text);
+   const size_t ops = 100000;
+   const unsigned int runs = Microbench_options.runs;
+   double nsPerOp[MICROBENCH_MAX_RUNS];
+
+   RichString_begin(str);
+   for (unsigned int r = 0; r < runs; r++) {
+      const uint64_t start = Microbench_now();
+      for (size_t i = 0; i < ops; i++) {
+         int columns = 80;
+         RichString_appendnWideColumns(&str, CRT_colors[DEFAULT_COLOR], text, len, &columns);
+         RichString_rewind(&str, RichString_size(&str));
+      }
+      nsPerOp[r] = (double)(Microbench_now() - start) / ops;
+   }
+   RichString_delete(&str);
+
+   Microbench_report(name, variant, (size_t)len, ops, nsPerOp, runs);
+}
+
+static void Microbench_richString(bool utf8) {
+   Microbench_appendCase("ascii", "/usr/lib/firefox/firefox -contentproc -childID 12 -isForBrowser -prefsLen 31022 tab");
+   if (utf8) {
+      Microbench_appendCase("utf8", "/home/jürgen/Téléchargements/视频播放器 --titre «Première» -v tab");
+   } else {
+      fprintf(stderr, "Warning: no UTF-8 locale, the utf8 case of RichString_appendnWideColumns is skipped.\n");
+   }
+}
+
+/* Values spread over the orders of magnitude the columns show */
+static void Microbench_printCase(const char* name, bool time) {
+   if (!Microbench_selected(name))
+      return;
+
+   Microbench_seed(time ? 7 : 5);
+   enum { VALUES = 4096 };
+   unsigned long long values[VALUES];
+   for (size_t i = 0; i < VALUES; i++)
+      values[i] = (1ULL << Microbench_below(time ? 40 : 50)) + Microbench_below(1000);
+
+   const size_t ops = 100000;
+   const unsigned int runs = Microbench_options.runs;
+   double nsPerOp[MICROBENCH_MAX_RUNS];
+
+   RichString_begin(str);
+   for (unsigned int r = 0; r < runs; r++) {
+      const uint64_t start = Microbench_now();
+      for (size_t i = 0; i < ops; i++) {
+         if (time) {
+            Row_printTime(&str, values[i % VALUES], true);
+         } else {
+            Row_printBytes(&str, values[i % VALUES], true);
+         }
+         RichString_rewind(&str, RichString_size(&str));
+      }
+      nsPerOp[r] = (double)(Microbench_now() - start) / ops;
+   }
+   RichString_delete(&str);
+
+   Microbench_report(name, "log-spread", VALUES, ops, nsPerOp, runs);
+}
+
+/* ---------------------------------------------------------------------- */
+
+typedef struct MicrobenchCommand_ {
+   const char* variant;
+   const char* cmdline;       /* arguments separated by newlines, like they are read */
+   const char* comm;
+   const char* exe;
+} MicrobenchCommand;
+
+static void Microbench_commandCase(const Machine* host, const Settings* settings, const MicrobenchCommand* command) {
+   const char* name = "Process_makeCommandStr";
+   Process* proc = LinuxProcess_new(host);
+   proc->state = SLEEPING;
+
+   const char* cmdline = command->cmdline;
+   char longCmdline[4096];
+   if (!cmdline) {
+      /* a command line as long as the kernel hands out */
+      size_t len = (size_t)xSnprintf(longCmdline, sizeof(longCmdline), "/usr/lib/jvm/java-17/bin/java");
+      for (unsigned int arg = 0; len + 40 < sizeof(longCmdline); arg++)
+         len += (size_t)xSnprintf(longCmdline + len, sizeof(longCmdline) - len, "\n-Dproperty.number%u=value", arg);
+      cmdline = longCmdline;
+   }
+
+   const char* basename = strrchr(cmdline, '/');
+   const char* firstEnd = strchr(cmdline, '\n');
+   const int basenameEnd = firstEnd ? (int)(firstEnd - cmdline) : (int)strlen(cmdline);
+   Process_updateCmdline(proc, cmdline, basename && basename < cmdline + basenameEnd ? (int)(basename + 1 - cmdline) : 0, basenameEnd);
+   Process_updateComm(proc, command->comm);
+   Process_updateExe(proc, command->exe);
+
+   const size_t ops = 100000;
+   const unsigned int runs = Microbench_options.runs;
+   double nsPerOp[MICROBENCH_MAX_RUNS];
+   for (unsigned int r = 0; r < runs; r++) {
+      const uint64_t start = Microbench_now();
+      for (size_t i = 0; i < ops; i++) {
+         /* built again as after a change of the command line */
+         proc->mergedCommand.lastUpdate = 0;
+         Process_makeCommandStr(proc, settings);
+      }
+      nsPerOp[r] = (double)(Microbench_now() - start) / ops;
+   }
+
+   Microbench_report(name, command->variant, strlen(cmdline), ops, nsPerOp, runs);
+   Object_delete(proc);
+}
+
+static void Microbench_commands(const Machine* host, Settings* settings) {
+   static const MicrobenchCommand commands[] = {
+      { "plain", "/usr/sbin/sshd\n-D\n-o\nAuthorizedKeysCommand=/usr/bin/sss_ssh_authorizedkeys", "sshd", "/usr/sbin/sshd" },
+      { "script", "/usr/bin/python3\n/usr/lib/ubuntu-release-upgrader/check-new-release-gtk", "check-new-relea", "/usr/bin/python3.12" },
+      { "renamed", "postgres: 16/main: checkpointer", "postgres", "/usr/lib/postgresql/16/bin/postgres" },
+      { "long", NULL, "java", "/usr/lib/jvm/java-17/bin/java" },
+   };
+
+   if (!Microbench_selected("Process_makeCommandStr"))
+      return;
+
+   settings->showMergedCommand = true;
+   settings->showProgramPath = true;
+   settings->findCommInCmdline = true;
+   settings->stripExeFromCmdline = true;
+   settings->shadowDistPathPrefix = true;
+
+   for (size_t i = 0; i < ARRAYSIZE(commands); i++)
+      Microbench_commandCase(host, settings, &commands[i]);
+}
+
+static void Microbench_cgroups(void) {
+   static const char* const cgroups[] = {
+      "/",
+      "/init.scope",
+      "/system.slice/systemd-journald.service",
+      "/system.slice/docker-4a7b1c2d3e4f5a6b7c8d9e0f1a2b3c4d5e6f7a8b9c0d1e2f3a4b5c6d7e8f9a0b.scope",
+      "/user.slice/user-1000.slice/session-3.scope",
+      "/user.slice/user-1000.slice/user@1000.service/app.slice/app-gnome-firefox-4211.scope",
+      "/user.slice/user-1000.slice/user@1000.service/app.slice/app-org.gnome.Terminal.slice/vte-spawn-0f3e9a.scope",
+      "/machine.slice/libpod-8c2e1f4a6b3d5c7e9f1a2b4c6d8e0f2a4b6c8d0e2f4a6b8c0d2e4f6a8b0c2d4e.scope/container",
+      "/machine.slice/machine-qemu\\x2d1\\x2dwin11.scope/libvirt/emulator",
+      "/kubepods.slice/kubepods-burstable.slice/kubepods-burstable-pod3f2a1b4c_5d6e_7f80_9a1b_2c3d4e5f6a7b.slice/"
+      "cri-containerd-6b1f0e2d3c4b5a69788796a5b4c3d2e1f0a9b8c7d6e5f4a3b2c1d0e9f8a7b6c5.scope",
+      "/lxc.payload.builder/system.slice/sshd.service",
+      "/lxc.monitor.builder",
+   };
+   const char* name = "CGroup_filterName";
+   if (!Microbench_selected(name))
+      return;
+
+   const size_t ops = 100000;
+   const unsigned int runs = Microbench_options.runs;
+   double nsPerOp[MICROBENCH_MAX_RUNS];
+   size_t shortened = 0;
+   for (unsigned int r = 0; r < runs; r++) {
+      const uint64_t start = Microbench_now();
+      for (size_t i = 0; i < ops; i++) {
+         char* filtered = CGroup_filterName(cgroups[i % ARRAYSIZE(cgroups)]);
+         shortened += filtered != NULL;
+         free(filtered);
+      }
+      nsPerOp[r] = (double)(Microbench_now() - start) / ops;
+   }
+
+   /* keeps the calls from being optimized away */
+   if (shortened == 0)
+      fprintf(stderr, "Warning: no cgroup name was shortened.\n");
+
+   Microbench_report(name, "systemd-docker-k8s-lxc", ARRAYSIZE(cgroups), ops, nsPerOp, runs);
+}
+
+/* ---------------------------------------------------------------------- */
+
+int main(int argc, char** argv) {
+   if (!Microbench_parseOptions(argc, argv))
+      return 1;
+
+   const bool utf8 = setlocale(LC_CTYPE, "C.UTF-8") || setlocale(LC_CTYPE, "en_US.UTF-8");
+
+   /* defaults only, no configuration file is read or written */
+   setenv("HTOPRC", "/dev/null/htoprc", 1);
+
+   if (!Platform_init())
+      return 1;
+
+   UsersTable* ut = UsersTable_new();
+   Hashtable* dm = DynamicMeters_new();
+   Hashtable* dc = DynamicColumns_new();
+   Hashtable* ds = DynamicScreens_new();
+
+   Machine* host = Machine_new(ut, (uid_t)-1);
+   ProcessTable* pt = ProcessTable_new(host, NULL);
+   Settings* settings = Settings_new(host->activeCPUs, dm, dc, ds);
+   Machine_populateTablesFromSettings(host, settings, &pt->super);
+
+   /* the terminal is left alone, the primitives still need attributes */
+   CRT_setColors(COLORSCHEME_MONOCHROME);
+
+   printf("{\n  \"program\": \"%s\",\n  \"version\": \"%s\",\n  \"runs\": %u,\n  \"results\": [",
+          program, VERSION, Microbench_options.runs);
+
+   Microbench_sorting();
+   Microbench_hashtable();
+   Microbench_richString(utf8);
+   Microbench_printCase("Row_printBytes", false);
+   Microbench_printCase("Row_printTime", true);
+   Microbench_commands(host, settings);
+   Microbench_cgroups();
+
+   printf("\n  ]\n}\n");
+
+   Machine_delete(host);
+   UsersTable_delete(ut);
+   Settings_delete(settings);
+   DynamicColumns_delete(dc);
+   DynamicMeters_delete(dm);
+   DynamicScreens_delete(ds);
+
+   Platform_done();
+
+   return 0;
+}
@@ -0,0 +1,313 @@
+/*
+htop - linux/Bpf.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/Bpf.h"
+
+#ifdef HAVE_BPF_COLUMNS
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/bpf.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+#ifdef HAVE_LIBCAP
+#include <sys/capability.h>
+#endif
+
+#include "Macros.h"
+#include "XUtils.h"
+
+#include "linux/BpfFutex.h"
+#include "linux/BpfNet.h"
+#include "linux/BpfSyscalls.h"
+
+
+/* Attaching programs that are not pinned (yet) is tried again this often */
+#define BPF_ATTACH_RETRY_MS 10000
+
+#define BPF_MAX_PROGRAMS 6
+
+typedef enum BpfAttach_ {
+   BPF_ATTACH_TRACING,        /* fentry and fexit, to the function the program was loaded for */
+   BPF_ATTACH_TRACEPOINT,
+   BPF_ATTACH_KRETPROBE,
+} BpfAttach;
+
+typedef struct BpfProgram_ {
+   const char* name;          /* pinned by bpftool under the name of its function */
+   BpfAttach attach;
+   const char* target;        /* tracepoint or kernel function, for those attached through a perf event */
+} BpfProgram;
+
+typedef struct BpfSourceState_ {
+   const char* programsPath;
+   const BpfProgram* programs;
+   size_t programCount;
+   bool (*refresh)(uint64_t monotonicMs);
+   int fds[BPF_MAX_PROGRAMS]; /* links or perf events keeping the programs attached by htop, -1 if none */
+   bool attached;             /* all programs attached, by htop or pinned as links */
+   uint64_t triedMs;          /* time of the last attempt to attach, 0 if none */
+} BpfSourceState;
+
+static const BpfProgram Bpf_netPrograms[] = {
+   { "htop_tcp_sendmsg", BPF_ATTACH_TRACING, NULL },
+   { "htop_tcp_cleanup_rbuf", BPF_ATTACH_TRACING, NULL },
+   { "htop_udp_sendmsg", BPF_ATTACH_TRACING, NULL },
+   { "htop_udp_recvmsg", BPF_ATTACH_KRETPROBE, "udp_recvmsg" },
+   { "htop_udpv6_sendmsg", BPF_ATTACH_TRACING, NULL },
+   { "htop_udpv6_recvmsg", BPF_ATTACH_KRETPROBE, "udpv6_recvmsg" },
+};
+
+static const BpfProgram Bpf_futexPrograms[] = {
+   { "htop_futex_enter", BPF_ATTACH_TRACEPOINT, "syscalls/sys_enter_futex" },
+   { "htop_futex_exit", BPF_ATTACH_TRACEPOINT, "syscalls/sys_exit_futex" },
+};
+
+static const BpfProgram Bpf_syscallsPrograms[] = {
+   { "htop_syscalls_enter", BPF_ATTACH_TRACEPOINT, "raw_syscalls/sys_enter" },
+};
+
+static BpfSourceState Bpf_sources[BPF_SOURCE_COUNT] = {
+   [BPF_SOURCE_NET] = {
+      .programsPath = BPF_NET_PROGRAMS_PATH,
+      .programs = Bpf_netPrograms,
+      .programCount = ARRAYSIZE(Bpf_netPrograms),
+      .refresh = BpfNet_refresh,
+   },
+   [BPF_SOURCE_FUTEX] = {
+      .programsPath = BPF_FUTEX_PROGRAMS_PATH,
+      .programs = Bpf_futexPrograms,
+      .programCount = ARRAYSIZE(Bpf_futexPrograms),
+      .refresh = BpfFutex_refresh,
+   },
+   [BPF_SOURCE_SYSCALLS] = {
+      .programsPath = BPF_SYSCALLS_PROGRAMS_PATH,
+      .programs = Bpf_syscallsPrograms,
+      .programCount = ARRAYSIZE(Bpf_syscallsPrograms),
+      .refresh = BpfSyscalls_refresh,
+   },
+};
+
+static bool Bpf_initialized;
+static bool Bpf_canAttach;
+
+static int Bpf_syscall(enum bpf_cmd cmd, union bpf_attr* attr) {
+   return (int)syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+void Bpf_init(void) {
+   if (!Bpf_initialized) {
+      for (size_t s = 0; s < BPF_SOURCE_COUNT; s++) {
+         for (size_t i = 0; i < BPF_MAX_PROGRAMS; i++)
+            Bpf_sources[s].fds[i] = -1;
+      }
+   }
+
+   /* maps may be readable through the permissions of bpffs, attaching always needs privileges */
+#ifdef HAVE_LIBCAP
+   Bpf_canAttach = false;
+   cap_t caps = cap_get_proc();
+   if (caps) {
+      cap_flag_value_t admin = CAP_CLEAR;
+      cap_flag_value_t bpf = CAP_CLEAR;
+      cap_flag_value_t perfmon = CAP_CLEAR;
+      (void) cap_get_flag(caps, CAP_SYS_ADMIN, CAP_EFFECTIVE, &admin);
+#if defined(CAP_BPF) && defined(CAP_PERFMON)
+      (void) cap_get_flag(caps, CAP_BPF, CAP_EFFECTIVE, &bpf);
+      (void) cap_get_flag(caps, CAP_PERFMON, CAP_EFFECTIVE, &perfmon);
+#endif
+      cap_free(caps);
+      Bpf_canAttach = admin == CAP_SET || (bpf == CAP_SET && perfmon == CAP_SET);
+   }
+#else
+   Bpf_canAttach = geteuid() == 0;
+#endif
+
+   Bpf_initialized = true;
+}
+
+/* Whether the pinned object is a link, which bpftool pins for programs it attached */
+static bool Bpf_isLink(int fd) {
+   char path[64];
+   char target[64];
+   xSnprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+   ssize_t len = readlink(path, target, sizeof(target) - 1);
+   if (len < 0)
+      return false;
+
+   target[len] = '\0';
+   return String_eq(target, "anon_inode:bpf-link");
+}
+
+static int Bpf_attachTracing(int programFd) {
+   union bpf_attr attr;
+   memset(&attr, 0, sizeof(attr));
+   attr.raw_tracepoint.prog_fd = (uint32_t)programFd;
+   return Bpf_syscall(BPF_RAW_TRACEPOINT_OPEN, &attr);
+}
+
+/* Opened on one CPU, like libbpf does: the program runs for the event on all of them */
+static int Bpf_attachPerfEvent(int programFd, struct perf_event_attr* attr) {
+   attr->size = sizeof(*attr);
+   attr->sample_period = 1;
+   attr->wakeup_events = 1;
+
+   int fd = (int)syscall(SYS_perf_event_open, attr, -1, 0, -1, PERF_FLAG_FD_CLOEXEC);
+   if (fd < 0)
+      return -1;
+
+   if (ioctl(fd, PERF_EVENT_IOC_SET_BPF, programFd) < 0 || ioctl(fd, PERF_EVENT_IOC_ENABLE, 0) < 0) {
+      close(fd);
+      return -1;
+   }
+
+   return fd;
+}
+
+static int Bpf_attachTracepoint(int programFd, const char* target) {
+   static const char* const tracefs[] = { "/sys/kernel/tracing", "/sys/kernel/debug/tracing" };
+
+   char path[256];
+   char buffer[32];
+   ssize_t len = -1;
+   for (size_t i = 0; i < ARRAYSIZE(tracefs) && len <= 0; i++) {
+      xSnprintf(path, sizeof(path), "%s/events/%s/id", tracefs[i], target);
+      len = xReadfile(path, buffer, sizeof(buffer));
+   }
+   if (len <= 0)
+      return -1;
+
+   struct perf_event_attr attr;
+   memset(&attr, 0, sizeof(attr));
+   attr.type = PERF_TYPE_TRACEPOINT;
+   attr.config = strtoull(buffer, NULL, 10);
+   return Bpf_attachPerfEvent(programFd, &attr);
+}
+
+static int Bpf_attachKretprobe(int programFd, const char* target) {
+   char buffer[32];
+   if (xReadfile("/sys/bus/event_source/devices/kprobe/type", buffer, sizeof(buffer)) <= 0)
+      return -1;
+
+   struct perf_event_attr attr;
+   memset(&attr, 0, sizeof(attr));
+   attr.type = (uint32_t)strtoul(buffer, NULL, 10);
+
+   /* the bit of the configuration that makes it a return probe, as "config:0" */
+   unsigned long bit = 0;
+   if (xReadfile("/sys/bus/event_source/devices/kprobe/format/retprobe", buffer, sizeof(buffer)) > 0 && String_startsWith(buffer, "config:"))
+      bit = strtoul(buffer + strlen("config:"), NULL, 10);
+   if (bit >= 64)
+      return -1;
+
+   attr.config = 1ULL << bit;
+   attr.config1 = (uint64_t)(uintptr_t)target;
+   return Bpf_attachPerfEvent(programFd, &attr);
+}
+
+/* True if the program counts now, attached by htop or pinned as a link */
+static bool Bpf_attachProgram(BpfSourceState* source, size_t i) {
+   const BpfProgram* program = &source->programs[i];
+
+   char path[256];
+   xSnprintf(path, sizeof(path), "%s/%s", source->programsPath, program->name);
+
+   union bpf_attr attr;
+   memset(&attr, 0, sizeof(attr));
+   attr.pathname = (uint64_t)(uintptr_t)path;
+   int fd = Bpf_syscall(BPF_OBJ_GET, &attr);
+   if (fd < 0)
+      return false;
+
+   if (Bpf_isLink(fd)) {
+      close(fd);
+      return true;
+   }
+
+   int attached = -1;
+   if (Bpf_canAttach) {
+      switch (program->attach) {
+         case BPF_ATTACH_TRACING:
+            attached = Bpf_attachTracing(fd);
+            break;
+         case BPF_ATTACH_TRACEPOINT:
+            attached = Bpf_attachTracepoint(fd, program->target);
+            break;
+         case BPF_ATTACH_KRETPROBE:
+            attached = Bpf_attachKretprobe(fd, program->target);
+            break;
+      }
+   }
+
+   /* the link or perf event holds on to the program */
+   close(fd);
+   source->fds[i] = attached;
+   return attached >= 0;
+}
+
+static void Bpf_attachSource(BpfSourceState* source, uint64_t monotonicMs) {
+   if (source->attached)
+      return;
+   if (source->triedMs && monotonicMs - source->triedMs < BPF_ATTACH_RETRY_MS)
+      return;
+   source->triedMs = monotonicMs ? monotonicMs : 1;
+
+   bool all = true;
+   for (size_t i = 0; i < source->programCount; i++) {
+      if (source->fds[i] < 0 && !Bpf_attachProgram(source, i))
+         all = false;
+   }
+   source->attached = all;
+}
+
+static void Bpf_detachSource(BpfSourceState* source) {
+   for (size_t i = 0; i < source->programCount; i++) {
+      if (source->fds[i] >= 0)
+         close(source->fds[i]);
+      source->fds[i] = -1;
+   }
+   source->attached = false;
+   source->triedMs = 0;
+}
+
+void Bpf_refresh(unsigned int sources, uint64_t monotonicMs) {
+   if (!Bpf_initialized)
+      Bpf_init();
+
+   for (size_t s = 0; s < BPF_SOURCE_COUNT; s++) {
+      BpfSourceState* source = &Bpf_sources[s];
+      if (!(sources & BPF_SOURCE_BIT(s))) {
+         Bpf_detachSource(source);
+         continue;
+      }
+
+      Bpf_attachSource(source, monotonicMs);
+      if (source->refresh)
+         source->refresh(monotonicMs);
+   }
+}
+
+void Bpf_done(void) {
+   if (!Bpf_initialized)
+      return;
+
+   for (size_t s = 0; s < BPF_SOURCE_COUNT; s++)
+      Bpf_detachSource(&Bpf_sources[s]);
+
+   BpfNet_cleanup();
+   BpfFutex_cleanup();
+   BpfSyscalls_cleanup();
+}
+
+#endif /* HAVE_BPF_COLUMNS */
@@ -0,0 +1,42 @@
+#ifndef HEADER_Bpf
+#define HEADER_Bpf
+/*
+htop - linux/Bpf.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdint.h>
+
+
+/*
+ * The programs of linux/bpf whose maps feed columns, managed together.
+ * Each is expected pinned by bpftool: its maps, and its programs either
+ * as links (loaded with autoattach, always counting) or as programs only,
+ * which htop attaches itself while a column reading them is shown and
+ * detaches again when none is. The maps of the sources needed are read
+ * once per scan with batched lookups.
+ */
+typedef enum BpfSource_ {
+   BPF_SOURCE_NET,
+   BPF_SOURCE_FUTEX,
+   BPF_SOURCE_SYSCALLS,
+   BPF_SOURCE_COUNT
+} BpfSource;
+
+#define BPF_SOURCE_BIT(s_) (1U << (s_))
+
+/* Tells whether programs can be attached, with the capabilities left after dropping the others */
+void Bpf_init(void);
+
+/*
+ * Brings the attached programs in line with `sources`, a set of
+ * BPF_SOURCE_BIT(), and reads the maps of those sources.
+ */
+void Bpf_refresh(unsigned int sources, uint64_t monotonicMs);
+
+/* Detaches the programs attached by htop and closes the maps */
+void Bpf_done(void);
+
+#endif
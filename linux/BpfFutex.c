@@ -0,0 +1,87 @@
+/*
+htop - linux/BpfFutex.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/BpfFutex.h"
+
+#ifdef HAVE_BPF_COLUMNS
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Macros.h"
+#include "XUtils.h"
+
+#include "linux/BpfMap.h"
+
+
+typedef struct BpfFutexEntry_ {
+   uint32_t tgid;
+   uint64_t ns;
+} BpfFutexEntry;
+
+static BpfMap BpfFutex_map = BpfMap_initializer(BPF_FUTEX_MAP_PATH, sizeof(uint64_t));
+static bool BpfFutex_valid;
+
+/* the last read, sorted by tgid */
+static BpfFutexEntry* BpfFutex_entries;
+static size_t BpfFutex_count;
+static size_t BpfFutex_alloc;
+
+static int BpfFutex_compare(const void* v1, const void* v2) {
+   const BpfFutexEntry* e1 = v1;
+   const BpfFutexEntry* e2 = v2;
+   return SPACESHIP_NUMBER(e1->tgid, e2->tgid);
+}
+
+bool BpfFutex_refresh(uint64_t monotonicMs) {
+   BpfFutex_count = 0;
+   BpfFutex_valid = BpfMap_read(&BpfFutex_map, monotonicMs);
+   if (!BpfFutex_valid)
+      return false;
+
+   const size_t count = BpfFutex_map.count;
+   if (count > BpfFutex_alloc) {
+      BpfFutex_alloc = count;
+      BpfFutex_entries = xReallocArray(BpfFutex_entries, BpfFutex_alloc, sizeof(BpfFutexEntry));
+   }
+
+   for (size_t i = 0; i < count; i++) {
+      BpfFutex_entries[i].tgid = BpfFutex_map.keys[i];
+      memcpy(&BpfFutex_entries[i].ns, BpfMap_value(&BpfFutex_map, i), sizeof(uint64_t));
+   }
+   if (count > 0)
+      qsort(BpfFutex_entries, count, sizeof(BpfFutexEntry), BpfFutex_compare);
+
+   BpfFutex_count = count;
+   return true;
+}
+
+bool BpfFutex_waitNs(pid_t tgid, unsigned long long* ns) {
+   if (!BpfFutex_valid)
+      return false;
+
+   const BpfFutexEntry key = { .tgid = (uint32_t)tgid };
+   const BpfFutexEntry* found = BpfFutex_count ? bsearch(&key, BpfFutex_entries, BpfFutex_count, sizeof(BpfFutexEntry), BpfFutex_compare) : NULL;
+
+   /* not in the map: no waits since the program was loaded, or evicted */
+   *ns = found ? found->ns : 0;
+   return true;
+}
+
+void BpfFutex_cleanup(void) {
+   BpfMap_done(&BpfFutex_map);
+   BpfFutex_valid = false;
+
+   free(BpfFutex_entries);
+   BpfFutex_entries = NULL;
+   BpfFutex_count = 0;
+   BpfFutex_alloc = 0;
+}
+
+#endif /* HAVE_BPF_COLUMNS */
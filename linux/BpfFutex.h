@@ -0,0 +1,38 @@
+#ifndef HEADER_BpfFutex
+#define HEADER_BpfFutex
+/*
+htop - linux/BpfFutex.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+
+/* Where the map of linux/bpf/htop_futex.bpf.c is expected to be pinned */
+#ifndef BPF_FUTEX_MAP_PATH
+#define BPF_FUTEX_MAP_PATH "/sys/fs/bpf/htop_futex/htop_futex_wait"
+#endif
+
+/* Where its programs are expected to be pinned, see linux/Bpf.h */
+#ifndef BPF_FUTEX_PROGRAMS_PATH
+#define BPF_FUTEX_PROGRAMS_PATH "/sys/fs/bpf/htop_futex_progs"
+#endif
+
+/*
+ * Reads the whole map pinned at BPF_FUTEX_MAP_PATH, whose value for each
+ * thread group (keyed by its tgid as a __u32) is the nanoseconds its threads
+ * waited in futex(2) for a lock or a condition. Returns false if it could
+ * not be opened or read; opening is tried again after a while.
+ */
+bool BpfFutex_refresh(uint64_t monotonicMs);
+
+/* Nanoseconds the thread group waited as of the last read, false if the map could not be read */
+bool BpfFutex_waitNs(pid_t tgid, unsigned long long* ns);
+
+void BpfFutex_cleanup(void);
+
+#endif
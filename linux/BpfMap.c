@@ -0,0 +1,191 @@
+/*
+htop - linux/BpfMap.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/BpfMap.h"
+
+#ifdef HAVE_BPF_COLUMNS
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/bpf.h>
+#include <sys/syscall.h>
+
+#include "Macros.h"
+#include "XUtils.h"
+
+
+/* Opening a map that is not pinned (yet) is tried again this often */
+#define BPF_MAP_RETRY_MS 10000
+
+/* ENOTSUPP of the kernel, which map types without batched lookups return as it is */
+#define BPF_MAP_ENOTSUPP 524
+
+/* Entries asked for by the first batch; the buffers grow to the size of the map */
+#define BPF_MAP_INITIAL_ENTRIES 1024
+
+static int BpfMap_syscall(enum bpf_cmd cmd, union bpf_attr* attr) {
+   return (int)syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+static void BpfMap_reserve(BpfMap* this, size_t count) {
+   if (count <= this->alloc)
+      return;
+
+   this->alloc = MAXIMUM(count, 2 * this->alloc);
+   this->keys = xReallocArray(this->keys, this->alloc, sizeof(uint32_t));
+   this->values = xReallocArray(this->values, this->alloc, this->valueSize);
+}
+
+static bool BpfMap_open(BpfMap* this, uint64_t monotonicMs) {
+   if (this->fd >= 0)
+      return true;
+   if (this->openedMs && monotonicMs - this->openedMs < BPF_MAP_RETRY_MS)
+      return false;
+   this->openedMs = monotonicMs ? monotonicMs : 1;
+
+   union bpf_attr attr;
+   memset(&attr, 0, sizeof(attr));
+   attr.pathname = (uint64_t)(uintptr_t)this->path;
+   attr.file_flags = BPF_F_RDONLY;
+   this->fd = BpfMap_syscall(BPF_OBJ_GET, &attr);
+   if (this->fd < 0)
+      return false;
+
+   /* keys and values are copied as they are, so they have to be what the program defines */
+   struct bpf_map_info info;
+   memset(&info, 0, sizeof(info));
+   memset(&attr, 0, sizeof(attr));
+   attr.info.bpf_fd = (uint32_t)this->fd;
+   attr.info.info_len = sizeof(info);
+   attr.info.info = (uint64_t)(uintptr_t)&info;
+   if (BpfMap_syscall(BPF_OBJ_GET_INFO_BY_FD, &attr) < 0 || info.key_size != sizeof(uint32_t) || info.value_size != this->valueSize) {
+      close(this->fd);
+      this->fd = -1;
+      return false;
+   }
+
+   BpfMap_reserve(this, MAXIMUM(info.max_entries, BPF_MAP_INITIAL_ENTRIES));
+   return true;
+}
+
+/* Reads the map in batches of as many entries as the buffers hold */
+static bool BpfMap_readBatches(BpfMap* this) {
+   uint32_t token = 0;
+   bool first = true;
+
+   for (;;) {
+      if (this->alloc - this->count < BPF_MAP_INITIAL_ENTRIES)
+         BpfMap_reserve(this, this->alloc + BPF_MAP_INITIAL_ENTRIES);
+
+      uint32_t next = 0;
+      union bpf_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.batch.in_batch = first ? 0 : (uint64_t)(uintptr_t)&token;
+      attr.batch.out_batch = (uint64_t)(uintptr_t)&next;
+      attr.batch.keys = (uint64_t)(uintptr_t)(this->keys + this->count);
+      attr.batch.values = (uint64_t)(uintptr_t)(this->values + this->count * this->valueSize);
+      attr.batch.count = (uint32_t)(this->alloc - this->count);
+      attr.batch.map_fd = (uint32_t)this->fd;
+
+      int r = BpfMap_syscall(BPF_MAP_LOOKUP_BATCH, &attr);
+      if (r < 0 && errno == ENOSPC && attr.batch.count == 0) {
+         /* a bucket has more entries than there is room for */
+         BpfMap_reserve(this, 2 * this->alloc);
+         continue;
+      }
+      if (r < 0 && errno != ENOENT)
+         return false;
+
+      this->count += attr.batch.count;
+      if (r < 0)
+         return true;
+
+      token = next;
+      first = false;
+   }
+}
+
+/* Reads the map one entry at a time, on kernels without batches */
+static bool BpfMap_readEach(BpfMap* this) {
+   uint32_t key = 0;
+   bool first = true;
+
+   for (;;) {
+      uint32_t next;
+      union bpf_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.map_fd = (uint32_t)this->fd;
+      attr.key = first ? 0 : (uint64_t)(uintptr_t)&key;
+      attr.next_key = (uint64_t)(uintptr_t)&next;
+      if (BpfMap_syscall(BPF_MAP_GET_NEXT_KEY, &attr) < 0)
+         return errno == ENOENT;
+
+      BpfMap_reserve(this, this->count + 1);
+      memset(&attr, 0, sizeof(attr));
+      attr.map_fd = (uint32_t)this->fd;
+      attr.key = (uint64_t)(uintptr_t)&next;
+      attr.value = (uint64_t)(uintptr_t)(this->values + this->count * this->valueSize);
+      if (BpfMap_syscall(BPF_MAP_LOOKUP_ELEM, &attr) == 0) {
+         this->keys[this->count++] = next;
+      } else if (errno != ENOENT) {
+         /* ENOENT: evicted since it was listed */
+         return false;
+      }
+
+      key = next;
+      first = false;
+   }
+}
+
+bool BpfMap_read(BpfMap* this, uint64_t monotonicMs) {
+   this->count = 0;
+
+   if (!BpfMap_open(this, monotonicMs))
+      return false;
+
+   bool ok = false;
+   if (!this->noBatch) {
+      ok = BpfMap_readBatches(this);
+      if (!ok && (errno == EINVAL || errno == BPF_MAP_ENOTSUPP)) {
+         this->noBatch = true;
+         this->count = 0;
+      }
+   }
+   if (this->noBatch)
+      ok = BpfMap_readEach(this);
+
+   if (!ok) {
+      close(this->fd);
+      this->fd = -1;
+      this->openedMs = 0;
+      this->count = 0;
+      return false;
+   }
+
+   return true;
+}
+
+void BpfMap_done(BpfMap* this) {
+   if (this->fd >= 0)
+      close(this->fd);
+   this->fd = -1;
+   this->openedMs = 0;
+   this->noBatch = false;
+
+   free(this->keys);
+   free(this->values);
+   this->keys = NULL;
+   this->values = NULL;
+   this->count = 0;
+   this->alloc = 0;
+}
+
+#endif /* HAVE_BPF_COLUMNS */
@@ -0,0 +1,51 @@
+#ifndef HEADER_BpfMap
+#define HEADER_BpfMap
+/*
+htop - linux/BpfMap.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*
+ * A map keyed by __u32 that a BPF program of linux/bpf pinned to bpffs,
+ * read whole once per scan. The map is opened read-only on the first read
+ * and only if its keys and values are of the sizes expected.
+ */
+typedef struct BpfMap_ {
+   const char* path;
+   size_t valueSize;
+   int fd;
+   uint64_t openedMs;          /* time of the last attempt to open, 0 if none */
+   bool noBatch;               /* the kernel has no batched lookups, before Linux 5.6 */
+
+   /* the entries of the last read, in the order of the map */
+   uint32_t* keys;
+   unsigned char* values;      /* valueSize bytes each */
+   size_t count;
+   size_t alloc;
+} BpfMap;
+
+#define BpfMap_initializer(path_, valueSize_) { .path = (path_), .valueSize = (valueSize_), .fd = -1 }
+
+/*
+ * Reads all entries with as few system calls as the kernel allows. Returns
+ * false if the map could not be opened or read; opening is tried again
+ * after a while, and at once after a failed read, as the map may have been
+ * unpinned and replaced.
+ */
+bool BpfMap_read(BpfMap* this, uint64_t monotonicMs);
+
+static inline const void* BpfMap_value(const BpfMap* this, size_t index) {
+   return this->values + index * this->valueSize;
+}
+
+/* Closes the map and frees the entries, the map may be read again after */
+void BpfMap_done(BpfMap* this);
+
+#endif
@@ -0,0 +1,88 @@
+/*
+htop - linux/BpfNet.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/BpfNet.h"
+
+#ifdef HAVE_BPF_COLUMNS
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Macros.h"
+#include "XUtils.h"
+
+#include "linux/BpfMap.h"
+
+
+typedef struct BpfNetEntry_ {
+   uint32_t tgid;
+   BpfNetBytes bytes;
+} BpfNetEntry;
+
+static BpfMap BpfNet_map = BpfMap_initializer(BPF_NET_MAP_PATH, sizeof(BpfNetBytes));
+static bool BpfNet_valid;
+
+/* the last read, sorted by tgid */
+static BpfNetEntry* BpfNet_entries;
+static size_t BpfNet_count;
+static size_t BpfNet_alloc;
+
+static int BpfNet_compare(const void* v1, const void* v2) {
+   const BpfNetEntry* e1 = v1;
+   const BpfNetEntry* e2 = v2;
+   return SPACESHIP_NUMBER(e1->tgid, e2->tgid);
+}
+
+bool BpfNet_refresh(uint64_t monotonicMs) {
+   BpfNet_count = 0;
+   BpfNet_valid = BpfMap_read(&BpfNet_map, monotonicMs);
+   if (!BpfNet_valid)
+      return false;
+
+   const size_t count = BpfNet_map.count;
+   if (count > BpfNet_alloc) {
+      BpfNet_alloc = count;
+      BpfNet_entries = xReallocArray(BpfNet_entries, BpfNet_alloc, sizeof(BpfNetEntry));
+   }
+
+   for (size_t i = 0; i < count; i++) {
+      BpfNet_entries[i].tgid = BpfNet_map.keys[i];
+      memcpy(&BpfNet_entries[i].bytes, BpfMap_value(&BpfNet_map, i), sizeof(BpfNetBytes));
+   }
+   if (count > 0)
+      qsort(BpfNet_entries, count, sizeof(BpfNetEntry), BpfNet_compare);
+
+   BpfNet_count = count;
+   return true;
+}
+
+bool BpfNet_bytes(pid_t tgid, unsigned long long* rx, unsigned long long* tx) {
+   if (!BpfNet_valid)
+      return false;
+
+   const BpfNetEntry key = { .tgid = (uint32_t)tgid };
+   const BpfNetEntry* found = BpfNet_count ? bsearch(&key, BpfNet_entries, BpfNet_count, sizeof(BpfNetEntry), BpfNet_compare) : NULL;
+
+   /* not in the map: no bytes since the program was loaded, or evicted */
+   *rx = found ? found->bytes.rx : 0;
+   *tx = found ? found->bytes.tx : 0;
+   return true;
+}
+
+void BpfNet_cleanup(void) {
+   BpfMap_done(&BpfNet_map);
+   BpfNet_valid = false;
+
+   free(BpfNet_entries);
+   BpfNet_entries = NULL;
+   BpfNet_count = 0;
+   BpfNet_alloc = 0;
+}
+
+#endif /* HAVE_BPF_COLUMNS */
@@ -0,0 +1,43 @@
+#ifndef HEADER_BpfNet
+#define HEADER_BpfNet
+/*
+htop - linux/BpfNet.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+
+/* Where the map of linux/bpf/htop_net.bpf.c is expected to be pinned */
+#ifndef BPF_NET_MAP_PATH
+#define BPF_NET_MAP_PATH "/sys/fs/bpf/htop_net/htop_net_bytes"
+#endif
+
+/* Where its programs are expected to be pinned, see linux/Bpf.h */
+#ifndef BPF_NET_PROGRAMS_PATH
+#define BPF_NET_PROGRAMS_PATH "/sys/fs/bpf/htop_net_progs"
+#endif
+
+/* Value of the map for each thread group, keyed by its tgid as a __u32 */
+typedef struct BpfNetBytes_ {
+   uint64_t rx;
+   uint64_t tx;
+} BpfNetBytes;
+
+/*
+ * Reads the whole map pinned at BPF_NET_MAP_PATH with as few system calls
+ * as the kernel allows, opening it first if needed. Returns false if it
+ * could not be opened or read; opening is tried again after a while.
+ */
+bool BpfNet_refresh(uint64_t monotonicMs);
+
+/* Bytes received and sent by the thread group as of the last read, false if the map could not be read */
+bool BpfNet_bytes(pid_t tgid, unsigned long long* rx, unsigned long long* tx);
+
+void BpfNet_cleanup(void);
+
+#endif
@@ -0,0 +1,426 @@
+/*
+htop - linux/BpfSyscalls.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/BpfSyscalls.h"
+
+#ifdef HAVE_BPF_COLUMNS
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+
+#include "Macros.h"
+#include "XUtils.h"
+
+#include "linux/BpfMap.h"
+
+
+typedef struct BpfSyscallsEntry_ {
+   uint32_t tgid;
+   BpfSyscallsCounts counts;
+} BpfSyscallsEntry;
+
+typedef struct BpfSyscallName_ {
+   long nr;
+   const char* name;
+} BpfSyscallName;
+
+#define BPF_SYSCALL(name_) { SYS_##name_, #name_ }
+
+/* The calls programs loop on, and other common ones; the numbers differ between architectures */
+static const BpfSyscallName BpfSyscalls_names[] = {
+#ifdef SYS_accept
+   BPF_SYSCALL(accept),
+#endif
+#ifdef SYS_accept4
+   BPF_SYSCALL(accept4),
+#endif
+#ifdef SYS_bind
+   BPF_SYSCALL(bind),
+#endif
+#ifdef SYS_brk
+   BPF_SYSCALL(brk),
+#endif
+#ifdef SYS_chdir
+   BPF_SYSCALL(chdir),
+#endif
+#ifdef SYS_clock_gettime
+   BPF_SYSCALL(clock_gettime),
+#endif
+#ifdef SYS_clock_nanosleep
+   BPF_SYSCALL(clock_nanosleep),
+#endif
+#ifdef SYS_clone
+   BPF_SYSCALL(clone),
+#endif
+#ifdef SYS_clone3
+   BPF_SYSCALL(clone3),
+#endif
+#ifdef SYS_close
+   BPF_SYSCALL(close),
+#endif
+#ifdef SYS_connect
+   BPF_SYSCALL(connect),
+#endif
+#ifdef SYS_dup
+   BPF_SYSCALL(dup),
+#endif
+#ifdef SYS_dup2
+   BPF_SYSCALL(dup2),
+#endif
+#ifdef SYS_dup3
+   BPF_SYSCALL(dup3),
+#endif
+#ifdef SYS_epoll_ctl
+   BPF_SYSCALL(epoll_ctl),
+#endif
+#ifdef SYS_epoll_pwait
+   BPF_SYSCALL(epoll_pwait),
+#endif
+#ifdef SYS_epoll_pwait2
+   BPF_SYSCALL(epoll_pwait2),
+#endif
+#ifdef SYS_epoll_wait
+   BPF_SYSCALL(epoll_wait),
+#endif
+#ifdef SYS_eventfd2
+   BPF_SYSCALL(eventfd2),
+#endif
+#ifdef SYS_execve
+   BPF_SYSCALL(execve),
+#endif
+#ifdef SYS_exit
+   BPF_SYSCALL(exit),
+#endif
+#ifdef SYS_exit_group
+   BPF_SYSCALL(exit_group),
+#endif
+#ifdef SYS_faccessat
+   BPF_SYSCALL(faccessat),
+#endif
+#ifdef SYS_fadvise64
+   BPF_SYSCALL(fadvise64),
+#endif
+#ifdef SYS_fcntl
+   BPF_SYSCALL(fcntl),
+#endif
+#ifdef SYS_fdatasync
+   BPF_SYSCALL(fdatasync),
+#endif
+#ifdef SYS_flock
+   BPF_SYSCALL(flock),
+#endif
+#ifdef SYS_fstat
+   BPF_SYSCALL(fstat),
+#endif
+#ifdef SYS_fstatfs
+   BPF_SYSCALL(fstatfs),
+#endif
+#ifdef SYS_fsync
+   BPF_SYSCALL(fsync),
+#endif
+#ifdef SYS_ftruncate
+   BPF_SYSCALL(ftruncate),
+#endif
+#ifdef SYS_futex
+   BPF_SYSCALL(futex),
+#endif
+#ifdef SYS_getcwd
+   BPF_SYSCALL(getcwd),
+#endif
+#ifdef SYS_getdents64
+   BPF_SYSCALL(getdents64),
+#endif
+#ifdef SYS_getpid
+   BPF_SYSCALL(getpid),
+#endif
+#ifdef SYS_getppid
+   BPF_SYSCALL(getppid),
+#endif
+#ifdef SYS_getrandom
+   BPF_SYSCALL(getrandom),
+#endif
+#ifdef SYS_getrusage
+   BPF_SYSCALL(getrusage),
+#endif
+#ifdef SYS_getsockname
+   BPF_SYSCALL(getsockname),
+#endif
+#ifdef SYS_getsockopt
+   BPF_SYSCALL(getsockopt),
+#endif
+#ifdef SYS_gettid
+   BPF_SYSCALL(gettid),
+#endif
+#ifdef SYS_gettimeofday
+   BPF_SYSCALL(gettimeofday),
+#endif
+#ifdef SYS_io_getevents
+   BPF_SYSCALL(io_getevents),
+#endif
+#ifdef SYS_io_submit
+   BPF_SYSCALL(io_submit),
+#endif
+#ifdef SYS_io_uring_enter
+   BPF_SYSCALL(io_uring_enter),
+#endif
+#ifdef SYS_ioctl
+   BPF_SYSCALL(ioctl),
+#endif
+#ifdef SYS_kill
+   BPF_SYSCALL(kill),
+#endif
+#ifdef SYS_lseek
+   BPF_SYSCALL(lseek),
+#endif
+#ifdef SYS_madvise
+   BPF_SYSCALL(madvise),
+#endif
+#ifdef SYS_membarrier
+   BPF_SYSCALL(membarrier),
+#endif
+#ifdef SYS_mmap
+   BPF_SYSCALL(mmap),
+#endif
+#ifdef SYS_mprotect
+   BPF_SYSCALL(mprotect),
+#endif
+#ifdef SYS_mremap
+   BPF_SYSCALL(mremap),
+#endif
+#ifdef SYS_munmap
+   BPF_SYSCALL(munmap),
+#endif
+#ifdef SYS_nanosleep
+   BPF_SYSCALL(nanosleep),
+#endif
+#ifdef SYS_newfstatat
+   BPF_SYSCALL(newfstatat),
+#endif
+#ifdef SYS_open
+   BPF_SYSCALL(open),
+#endif
+#ifdef SYS_openat
+   BPF_SYSCALL(openat),
+#endif
+#ifdef SYS_pause
+   BPF_SYSCALL(pause),
+#endif
+#ifdef SYS_pipe2
+   BPF_SYSCALL(pipe2),
+#endif
+#ifdef SYS_poll
+   BPF_SYSCALL(poll),
+#endif
+#ifdef SYS_ppoll
+   BPF_SYSCALL(ppoll),
+#endif
+#ifdef SYS_prctl
+   BPF_SYSCALL(prctl),
+#endif
+#ifdef SYS_pread64
+   BPF_SYSCALL(pread64),
+#endif
+#ifdef SYS_preadv
+   BPF_SYSCALL(preadv),
+#endif
+#ifdef SYS_prlimit64
+   BPF_SYSCALL(prlimit64),
+#endif
+#ifdef SYS_pselect6
+   BPF_SYSCALL(pselect6),
+#endif
+#ifdef SYS_pwrite64
+   BPF_SYSCALL(pwrite64),
+#endif
+#ifdef SYS_pwritev
+   BPF_SYSCALL(pwritev),
+#endif
+#ifdef SYS_read
+   BPF_SYSCALL(read),
+#endif
+#ifdef SYS_readlink
+   BPF_SYSCALL(readlink),
+#endif
+#ifdef SYS_readlinkat
+   BPF_SYSCALL(readlinkat),
+#endif
+#ifdef SYS_readv
+   BPF_SYSCALL(readv),
+#endif
+#ifdef SYS_recvfrom
+   BPF_SYSCALL(recvfrom),
+#endif
+#ifdef SYS_recvmmsg
+   BPF_SYSCALL(recvmmsg),
+#endif
+#ifdef SYS_recvmsg
+   BPF_SYSCALL(recvmsg),
+#endif
+#ifdef SYS_rseq
+   BPF_SYSCALL(rseq),
+#endif
+#ifdef SYS_rt_sigaction
+   BPF_SYSCALL(rt_sigaction),
+#endif
+#ifdef SYS_rt_sigprocmask
+   BPF_SYSCALL(rt_sigprocmask),
+#endif
+#ifdef SYS_rt_sigreturn
+   BPF_SYSCALL(rt_sigreturn),
+#endif
+#ifdef SYS_rt_sigtimedwait
+   BPF_SYSCALL(rt_sigtimedwait),
+#endif
+#ifdef SYS_sched_getaffinity
+   BPF_SYSCALL(sched_getaffinity),
+#endif
+#ifdef SYS_sched_yield
+   BPF_SYSCALL(sched_yield),
+#endif
+#ifdef SYS_select
+   BPF_SYSCALL(select),
+#endif
+#ifdef SYS_sendfile
+   BPF_SYSCALL(sendfile),
+#endif
+#ifdef SYS_sendmmsg
+   BPF_SYSCALL(sendmmsg),
+#endif
+#ifdef SYS_sendmsg
+   BPF_SYSCALL(sendmsg),
+#endif
+#ifdef SYS_sendto
+   BPF_SYSCALL(sendto),
+#endif
+#ifdef SYS_set_robust_list
+   BPF_SYSCALL(set_robust_list),
+#endif
+#ifdef SYS_setsockopt
+   BPF_SYSCALL(setsockopt),
+#endif
+#ifdef SYS_shutdown
+   BPF_SYSCALL(shutdown),
+#endif
+#ifdef SYS_socket
+   BPF_SYSCALL(socket),
+#endif
+#ifdef SYS_splice
+   BPF_SYSCALL(splice),
+#endif
+#ifdef SYS_stat
+   BPF_SYSCALL(stat),
+#endif
+#ifdef SYS_statfs
+   BPF_SYSCALL(statfs),
+#endif
+#ifdef SYS_statx
+   BPF_SYSCALL(statx),
+#endif
+#ifdef SYS_sync_file_range
+   BPF_SYSCALL(sync_file_range),
+#endif
+#ifdef SYS_tgkill
+   BPF_SYSCALL(tgkill),
+#endif
+#ifdef SYS_timerfd_settime
+   BPF_SYSCALL(timerfd_settime),
+#endif
+#ifdef SYS_unlink
+   BPF_SYSCALL(unlink),
+#endif
+#ifdef SYS_unlinkat
+   BPF_SYSCALL(unlinkat),
+#endif
+#ifdef SYS_wait4
+   BPF_SYSCALL(wait4),
+#endif
+#ifdef SYS_waitid
+   BPF_SYSCALL(waitid),
+#endif
+#ifdef SYS_write
+   BPF_SYSCALL(write),
+#endif
+#ifdef SYS_writev
+   BPF_SYSCALL(writev),
+#endif
+};
+
+static BpfMap BpfSyscalls_map = BpfMap_initializer(BPF_SYSCALLS_MAP_PATH, sizeof(BpfSyscallsCounts));
+static bool BpfSyscalls_valid;
+
+/* the last read, sorted by tgid */
+static BpfSyscallsEntry* BpfSyscalls_entries;
+static size_t BpfSyscalls_count;
+static size_t BpfSyscalls_alloc;
+
+static int BpfSyscalls_compare(const void* v1, const void* v2) {
+   const BpfSyscallsEntry* e1 = v1;
+   const BpfSyscallsEntry* e2 = v2;
+   return SPACESHIP_NUMBER(e1->tgid, e2->tgid);
+}
+
+bool BpfSyscalls_refresh(uint64_t monotonicMs) {
+   BpfSyscalls_count = 0;
+   BpfSyscalls_valid = BpfMap_read(&BpfSyscalls_map, monotonicMs);
+   if (!BpfSyscalls_valid)
+      return false;
+
+   const size_t count = BpfSyscalls_map.count;
+   if (count > BpfSyscalls_alloc) {
+      BpfSyscalls_alloc = count;
+      BpfSyscalls_entries = xReallocArray(BpfSyscalls_entries, BpfSyscalls_alloc, sizeof(BpfSyscallsEntry));
+   }
+
+   for (size_t i = 0; i < count; i++) {
+      BpfSyscalls_entries[i].tgid = BpfSyscalls_map.keys[i];
+      memcpy(&BpfSyscalls_entries[i].counts, BpfMap_value(&BpfSyscalls_map, i), sizeof(BpfSyscallsCounts));
+   }
+   if (count > 0)
+      qsort(BpfSyscalls_entries, count, sizeof(BpfSyscallsEntry), BpfSyscalls_compare);
+
+   BpfSyscalls_count = count;
+   return true;
+}
+
+bool BpfSyscalls_counts(pid_t tgid, BpfSyscallsCounts* counts) {
+   if (!BpfSyscalls_valid)
+      return false;
+
+   const BpfSyscallsEntry key = { .tgid = (uint32_t)tgid };
+   const BpfSyscallsEntry* found = BpfSyscalls_count ? bsearch(&key, BpfSyscalls_entries, BpfSyscalls_count, sizeof(BpfSyscallsEntry), BpfSyscalls_compare) : NULL;
+
+   /* not in the map: no system calls since the program was loaded, or evicted */
+   if (found)
+      *counts = found->counts;
+   else
+      memset(counts, 0, sizeof(*counts));
+   return true;
+}
+
+const char* BpfSyscalls_name(uint32_t nr) {
+   for (size_t i = 0; i < ARRAYSIZE(BpfSyscalls_names); i++) {
+      if (BpfSyscalls_names[i].nr == (long)nr)
+         return BpfSyscalls_names[i].name;
+   }
+   return NULL;
+}
+
+void BpfSyscalls_cleanup(void) {
+   BpfMap_done(&BpfSyscalls_map);
+   BpfSyscalls_valid = false;
+
+   free(BpfSyscalls_entries);
+   BpfSyscalls_entries = NULL;
+   BpfSyscalls_count = 0;
+   BpfSyscalls_alloc = 0;
+}
+
+#endif /* HAVE_BPF_COLUMNS */
@@ -0,0 +1,56 @@
+#ifndef HEADER_BpfSyscalls
+#define HEADER_BpfSyscalls
+/*
+htop - linux/BpfSyscalls.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+
+/* Where the map of linux/bpf/htop_syscalls.bpf.c is expected to be pinned */
+#ifndef BPF_SYSCALLS_MAP_PATH
+#define BPF_SYSCALLS_MAP_PATH "/sys/fs/bpf/htop_syscalls/htop_syscalls"
+#endif
+
+/* Where its program is expected to be pinned, see linux/Bpf.h */
+#ifndef BPF_SYSCALLS_PROGRAMS_PATH
+#define BPF_SYSCALLS_PROGRAMS_PATH "/sys/fs/bpf/htop_syscalls_progs"
+#endif
+
+/* Slots of the histogram of the most frequent system calls of each thread group */
+#define BPF_SYSCALLS_TOP 4
+
+/*
+ * Same layout as struct htop_syscalls of the BPF program. A slot is free
+ * while its count is 0; when none is free, the one counted least is taken
+ * over by the next system call not in the histogram and keeps its count,
+ * so the frequent ones stay in and rare ones are overcounted a little.
+ */
+typedef struct BpfSyscallsCounts_ {
+   uint64_t total;
+   uint32_t nr[BPF_SYSCALLS_TOP];
+   uint64_t count[BPF_SYSCALLS_TOP];
+} BpfSyscallsCounts;
+
+/*
+ * Reads the whole map pinned at BPF_SYSCALLS_MAP_PATH, whose value for each
+ * thread group (keyed by its tgid as a __u32) counts the system calls its
+ * threads entered. Returns false if it could not be opened or read; opening
+ * is tried again after a while.
+ */
+bool BpfSyscalls_refresh(uint64_t monotonicMs);
+
+/* Counts of the thread group as of the last read, false if the map could not be read */
+bool BpfSyscalls_counts(pid_t tgid, BpfSyscallsCounts* counts);
+
+/* Name of a system call of the native ABI of htop, NULL if it is not known */
+const char* BpfSyscalls_name(uint32_t nr);
+
+void BpfSyscalls_cleanup(void);
+
+#endif
@@ -0,0 +1,175 @@
+/*
+htop - linux/BpfTaskIter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/BpfTaskIter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Macros.h"
+#include "XUtils.h"
+
+
+#define BPFTASKITER_INITIAL_BUFSIZE (1024 * 1024)
+
+/* Number of numeric fields before the command name */
+#define BPFTASKITER_NUMERIC_FIELDS 22
+
+static bool BpfTaskIter_slurp(BpfTaskList* this, int fd) {
+   if (!this->buffer) {
+      this->bufferSize = BPFTASKITER_INITIAL_BUFSIZE;
+      this->buffer = xMalloc(this->bufferSize);
+   }
+
+   size_t used = 0;
+   for (;;) {
+      /* keep room for the terminating NUL */
+      if (this->bufferSize - used < 4096) {
+         this->bufferSize *= 2;
+         this->buffer = xRealloc(this->buffer, this->bufferSize);
+      }
+
+      ssize_t r = read(fd, this->buffer + used, this->bufferSize - used - 1);
+      if (r < 0) {
+         if (errno == EINTR)
+            continue;
+         return false;
+      }
+      if (r == 0)
+         break;
+
+      used += (size_t)r;
+   }
+
+   this->buffer[used] = '\0';
+   return true;
+}
+
+static bool BpfTaskIter_parseLine(BpfTask* task, char* line) {
+   unsigned long long int v[BPFTASKITER_NUMERIC_FIELDS];
+   char state = '\0';
+   char* p = line;
+
+   for (size_t i = 0; i < BPFTASKITER_NUMERIC_FIELDS; i++) {
+      /* the state letter is the fourth field */
+      if (i == 3) {
+         state = *p;
+         if (!state || p[1] != ' ')
+            return false;
+         p += 2;
+      }
+
+      char* end;
+      errno = 0;
+      if (*p == '-') {
+         v[i] = (unsigned long long int)strtoll(p, &end, 10);
+      } else {
+         v[i] = strtoull(p, &end, 10);
+      }
+      if (end == p || *end != ' ' || errno)
+         return false;
+      p = end + 1;
+   }
+
+   task->tid = (pid_t)v[0];
+   task->tgid = (pid_t)v[1];
+   task->ppid = (pid_t)v[2];
+   task->state = state;
+   task->euid = (uid_t)v[3];
+   task->pgrp = (pid_t)v[4];
+   task->session = (pid_t)v[5];
+   task->ttyNr = (unsigned long int)v[6];
+   task->flags = (unsigned long int)v[7];
+   task->minflt = v[8];
+   task->majflt = v[9];
+   task->utimeNs = v[10];
+   task->stimeNs = v[11];
+   task->exitedUtimeNs = v[12];
+   task->exitedStimeNs = v[13];
+   task->priority = (long int)v[14];
+   task->nice = (long int)v[15];
+   task->nlwp = (long int)v[16];
+   task->startNs = v[17];
+   task->processor = (int)v[18];
+   task->vsize = (unsigned long int)v[19];
+   task->rss = (unsigned long int)v[20];
+   task->shared = (unsigned long int)v[21];
+
+   String_safeStrncpy(task->comm, p, sizeof(task->comm));
+
+   return task->tid > 0 && task->tgid > 0;
+}
+
+static int BpfTaskIter_compare(const void* v1, const void* v2) {
+   const BpfTask* t1 = v1;
+   const BpfTask* t2 = v2;
+
+   if (t1->tgid != t2->tgid)
+      return t1->tgid < t2->tgid ? -1 : 1;
+
+   /* the group leader goes first */
+   const bool leader1 = t1->tid == t1->tgid;
+   const bool leader2 = t2->tid == t2->tgid;
+   if (leader1 != leader2)
+      return leader1 ? -1 : 1;
+
+   return SPACESHIP_NUMBER(t1->tid, t2->tid);
+}
+
+bool BpfTaskIter_read(BpfTaskList* this, const char* path) {
+   this->count = 0;
+
+   int fd = open(path, O_RDONLY | O_CLOEXEC);
+   if (fd < 0)
+      return false;
+
+   bool ok = BpfTaskIter_slurp(this, fd);
+   close(fd);
+   if (!ok)
+      return false;
+
+   char* buf = this->buffer;
+   char* line = strsep(&buf, "\n");
+   if (!line || !String_eq(line, BPF_TASK_ITER_HEADER))
+      return false;
+
+   bool sorted = true;
+   while ((line = strsep(&buf, "\n")) != NULL) {
+      if (!*line)
+         continue;
+
+      if (this->count == this->alloc) {
+         this->alloc = this->alloc ? this->alloc * 2 : 1024;
+         this->tasks = xReallocArray(this->tasks, this->alloc, sizeof(BpfTask));
+      }
+
+      BpfTask* task = &this->tasks[this->count];
+      if (!BpfTaskIter_parseLine(task, line))
+         return false;
+
+      if (this->count > 0 && BpfTaskIter_compare(&this->tasks[this->count - 1], task) > 0)
+         sorted = false;
+      this->count++;
+   }
+
+   /* The iterator walks tasks by TID, so threads have to be grouped with their process */
+   if (!sorted)
+      qsort(this->tasks, this->count, sizeof(BpfTask), BpfTaskIter_compare);
+
+   return true;
+}
+
+void BpfTaskIter_done(BpfTaskList* this) {
+   free(this->tasks);
+   free(this->buffer);
+   memset(this, 0, sizeof(*this));
+}
@@ -0,0 +1,65 @@
+#ifndef HEADER_BpfTaskIter
+#define HEADER_BpfTaskIter
+/*
+htop - linux/BpfTaskIter.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+
+/* Where linux/bpf/htop_tasks.bpf.c is expected to be pinned */
+#ifndef BPF_TASK_ITER_PATH
+#define BPF_TASK_ITER_PATH "/sys/fs/bpf/htop_tasks"
+#endif
+
+/* First line of the iterator output, bumped with every format change */
+#define BPF_TASK_ITER_HEADER "htop-tasks 1"
+
+/* One task as dumped by the iterator, times in nanoseconds, memory in pages */
+typedef struct BpfTask_ {
+   pid_t tid;
+   pid_t tgid;
+   pid_t ppid;
+   char state;
+   uid_t euid;
+   pid_t pgrp;
+   pid_t session;
+   unsigned long int ttyNr;
+   unsigned long int flags;
+   unsigned long long int minflt;
+   unsigned long long int majflt;
+   unsigned long long int utimeNs;
+   unsigned long long int stimeNs;
+   unsigned long long int exitedUtimeNs;   /* of already exited threads, group leaders only */
+   unsigned long long int exitedStimeNs;
+   long int priority;
+   long int nice;
+   long int nlwp;
+   unsigned long long int startNs;         /* since boot */
+   int processor;
+   unsigned long int vsize;
+   unsigned long int rss;
+   unsigned long int shared;
+   char comm[16];
+} BpfTask;
+
+typedef struct BpfTaskList_ {
+   BpfTask* tasks;
+   size_t count;
+   size_t alloc;
+
+   char* buffer;
+   size_t bufferSize;
+} BpfTaskList;
+
+/* Reads a full snapshot from the pinned iterator at path; the tasks are grouped by thread group, leaders first */
+bool BpfTaskIter_read(BpfTaskList* list, const char* path);
+
+void BpfTaskIter_done(BpfTaskList* list);
+
+#endif
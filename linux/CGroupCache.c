@@ -0,0 +1,132 @@
+/*
+htop - linux/CGroupCache.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/CGroupCache.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "XUtils.h"
+#include "linux/CGroupUtils.h"
+
+
+#define CGROUPCACHE_INITIAL_BUCKETS 256
+
+struct CGroupCache_ {
+   CGroupName** buckets;
+   size_t bucketCount;        /* always a power of two */
+   size_t count;
+};
+
+/* FNV-1a */
+static uint32_t CGroupCache_hash(const char* str) {
+   uint32_t hash = 2166136261U;
+   for (const unsigned char* p = (const unsigned char*)str; *p; p++) {
+      hash ^= *p;
+      hash *= 16777619U;
+   }
+   return hash;
+}
+
+CGroupCache* CGroupCache_new(void) {
+   CGroupCache* this = xMalloc(sizeof(CGroupCache));
+   this->bucketCount = CGROUPCACHE_INITIAL_BUCKETS;
+   this->buckets = xCalloc(this->bucketCount, sizeof(CGroupName*));
+   this->count = 0;
+   return this;
+}
+
+void CGroupCache_delete(CGroupCache* this) {
+   if (!this)
+      return;
+
+   assert(this->count == 0);
+   free(this->buckets);
+   free(this);
+}
+
+static void CGroupCache_grow(CGroupCache* this) {
+   size_t newCount = this->bucketCount * 2;
+   CGroupName** newBuckets = xCalloc(newCount, sizeof(CGroupName*));
+
+   for (size_t i = 0; i < this->bucketCount; i++) {
+      CGroupName* name = this->buckets[i];
+      while (name) {
+         CGroupName* next = name->next;
+         size_t idx = name->hash & (newCount - 1);
+         name->next = newBuckets[idx];
+         newBuckets[idx] = name;
+         name = next;
+      }
+   }
+
+   free(this->buckets);
+   this->buckets = newBuckets;
+   this->bucketCount = newCount;
+}
+
+CGroupName* CGroupCache_get(CGroupCache* this, const char* raw, const char* unified) {
+   const uint32_t hash = CGroupCache_hash(raw);
+
+   for (CGroupName* name = this->buckets[hash & (this->bucketCount - 1)]; name; name = name->next) {
+      if (name->hash == hash && String_eq(name->raw, raw))
+         return CGroupName_ref(name);
+   }
+
+   CGroupName* name = xCalloc(1, sizeof(CGroupName));
+   name->raw = xStrdup(raw);
+   name->rawLen = strlen(raw);
+   name->compressed = CGroup_filterName(raw);
+   name->compressedLen = name->compressed ? strlen(name->compressed) : 0;
+   name->container = CGroup_filterContainer(raw);
+   name->containerLen = name->container ? strlen(name->container) : 0;
+   name->unified = unified ? xStrdup(unified) : NULL;
+   name->refCount = 1;
+   name->hash = hash;
+   name->cache = this;
+
+   if (this->count >= this->bucketCount)
+      CGroupCache_grow(this);
+
+   size_t idx = hash & (this->bucketCount - 1);
+   name->next = this->buckets[idx];
+   this->buckets[idx] = name;
+   this->count++;
+
+   return name;
+}
+
+CGroupName* CGroupName_ref(CGroupName* name) {
+   if (name)
+      name->refCount++;
+   return name;
+}
+
+void CGroupName_release(CGroupName* name) {
+   if (!name)
+      return;
+
+   assert(name->refCount > 0);
+   if (--name->refCount > 0)
+      return;
+
+   CGroupCache* cache = name->cache;
+   CGroupName** link = &cache->buckets[name->hash & (cache->bucketCount - 1)];
+   while (*link != name)
+      link = &(*link)->next;
+   *link = name->next;
+   cache->count--;
+
+   free(name->unified);
+   free(name->container);
+   free(name->compressed);
+   free(name->raw);
+   free(name);
+}
@@ -0,0 +1,60 @@
+#ifndef HEADER_CGroupCache
+#define HEADER_CGroupCache
+/*
+htop - linux/CGroupCache.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "linux/CGroupLimits.h"
+#include "linux/CGroupMemoryStat.h"
+#include "linux/CGroupPressure.h"
+#include "linux/CGroupThrottle.h"
+#include "linux/ContainerNames.h"
+
+
+/* An interned cgroup path shared by all processes in that cgroup */
+typedef struct CGroupName_ {
+   char* raw;                 /* as built from /proc/<pid>/cgroup */
+   char* compressed;          /* CGroup_filterName() of raw, NULL if it can not be shortened */
+   char* container;           /* CGroup_filterContainer() of raw, NULL if not in a container */
+   char* unified;             /* path in the v2 hierarchy, NULL if not in one */
+   size_t rawLen;
+   size_t compressedLen;
+   size_t containerLen;
+   ContainerName* containerName; /* of its runtime, looked up once while names are shown */
+   bool containerNameLooked;
+
+   CGroupThrottle throttle;   /* read on demand, once per scan for all processes in the cgroup */
+   CGroupPressure pressure;   /* likewise */
+   CGroupMemoryStat memoryStat; /* likewise */
+   CGroupLimits limits;       /* likewise */
+
+   unsigned int refCount;
+   uint32_t hash;
+   struct CGroupName_* next;
+   struct CGroupCache_* cache;
+} CGroupName;
+
+typedef struct CGroupCache_ CGroupCache;
+
+CGroupCache* CGroupCache_new(void);
+
+/* All names must have been released before */
+void CGroupCache_delete(CGroupCache* this);
+
+/*
+ * Returns a new reference to the interned name for raw, filtering it on
+ * first use; unified is the path of the "0::" line, NULL if there is none.
+ */
+CGroupName* CGroupCache_get(CGroupCache* this, const char* raw, const char* unified);
+
+CGroupName* CGroupName_ref(CGroupName* name);
+
+void CGroupName_release(CGroupName* name);
+
+#endif
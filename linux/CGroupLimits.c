@@ -0,0 +1,80 @@
+/*
+htop - linux/CGroupLimits.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/CGroupLimits.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Macros.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+#include "linux/Platform.h" // needed for GNU/hurd to get PATH_MAX  // IWYU pragma: keep
+
+
+double CGroupLimits_parseCpuMax(const char* text) {
+   if (!text || String_startsWith(text, "max"))
+      return NAN;
+
+   char* end;
+   const double quota = strtod(text, &end);
+   if (end == text || quota <= 0.0)
+      return NAN;
+
+   /* the period defaults to 100ms */
+   const double period = *end == ' ' ? strtod(end + 1, NULL) : 100000.0;
+   return period > 0.0 ? quota / period : NAN;
+}
+
+unsigned long long CGroupLimits_parseMemoryMax(const char* text) {
+   if (!text || !(*text >= '0' && *text <= '9'))
+      return ULLONG_MAX;
+   return strtoull(text, NULL, 10);
+}
+
+static const char* CGroupLimits_read(const char* root, const char* path, size_t pathLen, const char* name, char* text, size_t size) {
+   char relative[PATH_MAX];
+   xSnprintf(relative, sizeof(relative), "%s/%.*s/%s", root, (int)pathLen, path, name);
+   return FsRoot_readFile(&FsRoot_sys, relative, text, size) > 0 ? text : NULL;
+}
+
+void CGroupLimits_update(CGroupLimits* this, const char* root, const char* path, uint64_t nowMs) {
+   if (this->readMs == nowMs)
+      return;
+
+   this->readMs = nowMs;
+   this->cpuQuota = NAN;
+   this->memoryHeadroom = ULLONG_MAX;
+
+   while (*path == '/')
+      path++;
+
+   /* the root cgroup has no limits of its own */
+   size_t len = strlen(path);
+   while (len > 0) {
+      char text[64];
+
+      const double quota = CGroupLimits_parseCpuMax(CGroupLimits_read(root, path, len, "cpu.max", text, sizeof(text)));
+      if (!isnan(quota) && (isnan(this->cpuQuota) || quota < this->cpuQuota))
+         this->cpuQuota = quota;
+
+      const unsigned long long max = CGroupLimits_parseMemoryMax(CGroupLimits_read(root, path, len, "memory.max", text, sizeof(text)));
+      if (max != ULLONG_MAX) {
+         const char* current = CGroupLimits_read(root, path, len, "memory.current", text, sizeof(text));
+         const unsigned long long headroom = CGroupLimits_headroom(max, current ? strtoull(current, NULL, 10) : ULLONG_MAX);
+         this->memoryHeadroom = MINIMUM(this->memoryHeadroom, headroom);
+      }
+
+      while (len > 0 && path[len - 1] != '/')
+         len--;
+      while (len > 0 && path[len - 1] == '/')
+         len--;
+   }
+}
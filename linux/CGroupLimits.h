@@ -0,0 +1,52 @@
+#ifndef HEADER_CGroupLimits
+#define HEADER_CGroupLimits
+/*
+htop - linux/CGroupLimits.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+
+
+/*
+ * The CPU and memory limits a cgroup of the v2 hierarchy runs under: the
+ * lowest cpu.max quota and the least headroom below memory.max of the
+ * cgroup and its ancestors, as a limit of any of them holds for all below.
+ */
+typedef struct CGroupLimits_ {
+   uint64_t readMs;                      /* when the files were read last, 0 before */
+   double cpuQuota;                      /* in CPUs, NAN without a quota */
+   unsigned long long memoryHeadroom;    /* memory.max - memory.current in bytes, ULLONG_MAX without a limit */
+} CGroupLimits;
+
+/* CPUs of the text of a cpu.max file, 0.5 for "50000 100000"; NAN for "max" or without one */
+double CGroupLimits_parseCpuMax(const char* text);
+
+/* Bytes of the text of a memory.max file, ULLONG_MAX for "max" or without one */
+unsigned long long CGroupLimits_parseMemoryMax(const char* text);
+
+/* Bytes left below a memory limit, 0 when over it; ULLONG_MAX without a limit or usage */
+static inline unsigned long long CGroupLimits_headroom(unsigned long long max, unsigned long long current) {
+   if (max == ULLONG_MAX || current == ULLONG_MAX)
+      return ULLONG_MAX;
+   return max > current ? max - current : 0;
+}
+
+/* CPU percent of one CPU as a percent of the quota, NAN without one */
+static inline float CGroupLimits_quotaPercent(double cpuQuota, float cpuPercent) {
+   return isnan(cpuQuota) || cpuQuota <= 0.0 ? NAN : (float)(cpuPercent / cpuQuota);
+}
+
+/*
+ * Reads cpu.max, memory.max and memory.current of the cgroup at `path` of
+ * the hierarchy mounted at `root` below FsRoot_sys and of its ancestors,
+ * unless they were already read at `nowMs`: all processes of a cgroup
+ * share its limits and read them once per scan.
+ */
+void CGroupLimits_update(CGroupLimits* this, const char* root, const char* path, uint64_t nowMs);
+
+#endif
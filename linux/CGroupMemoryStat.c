@@ -0,0 +1,62 @@
+/*
+htop - linux/CGroupMemoryStat.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/CGroupMemoryStat.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+#include "linux/Platform.h" // needed for GNU/hurd to get PATH_MAX  // IWYU pragma: keep
+
+
+/* Value of a key of a flat keyed file, ULLONG_MAX if there is none */
+static unsigned long long CGroupMemoryStat_keyedValue(const char* text, const char* key) {
+   const size_t len = strlen(key);
+   for (const char* line = text; line; line = strchr(line, '\n')) {
+      if (*line == '\n')
+         line++;
+      if (String_startsWith(line, key) && line[len] == ' ')
+         return strtoull(line + len + 1, NULL, 10);
+   }
+   return ULLONG_MAX;
+}
+
+void CGroupMemoryStat_update(CGroupMemoryStat* this, const char* root, const char* path, uint64_t nowMs) {
+   if (this->readMs == nowMs)
+      return;
+
+   this->readMs = nowMs;
+
+   unsigned long long refaults = ULLONG_MAX;
+   unsigned long long swapins = ULLONG_MAX;
+
+   while (*path == '/')
+      path++;
+
+   char relative[PATH_MAX];
+   char text[8192];
+   xSnprintf(relative, sizeof(relative), *path ? "%s/%s/memory.stat" : "%s/memory.stat", root, path);
+   if (FsRoot_readFile(&FsRoot_sys, relative, text, sizeof(text)) > 0) {
+      const unsigned long long anon = CGroupMemoryStat_keyedValue(text, "workingset_refault_anon");
+      const unsigned long long file = CGroupMemoryStat_keyedValue(text, "workingset_refault_file");
+      if (anon != ULLONG_MAX && file != ULLONG_MAX)
+         refaults = anon + file;
+      else
+         refaults = CGroupMemoryStat_keyedValue(text, "workingset_refault");
+
+      swapins = CGroupMemoryStat_keyedValue(text, "pswpin");
+   }
+
+   Rate_update(&this->refaults, refaults, nowMs);
+   Rate_update(&this->swapins, swapins, nowMs);
+}
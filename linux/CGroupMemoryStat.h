@@ -0,0 +1,35 @@
+#ifndef HEADER_CGroupMemoryStat
+#define HEADER_CGroupMemoryStat
+/*
+htop - linux/CGroupMemoryStat.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdint.h>
+
+#include "Rate.h"
+
+
+/*
+ * Thrashing of a cgroup of the v2 hierarchy, from its memory.stat: the
+ * evicted pages faulted back in (the workingset_refault_anon and _file keys,
+ * workingset_refault before Linux 5.9) and the pages read from swap (pswpin,
+ * only in recent kernels). Unknown without the memory controller enabled for
+ * the cgroup.
+ */
+typedef struct CGroupMemoryStat_ {
+   uint64_t readMs;           /* when memory.stat was read last */
+   Rate refaults;             /* pages per second */
+   Rate swapins;              /* likewise */
+} CGroupMemoryStat;
+
+/*
+ * Reads memory.stat of the cgroup at `path` of the hierarchy mounted at
+ * `root` below FsRoot_sys, unless it was already read at `nowMs`: all
+ * processes of a cgroup share it and read it once per scan.
+ */
+void CGroupMemoryStat_update(CGroupMemoryStat* this, const char* root, const char* path, uint64_t nowMs);
+
+#endif
@@ -0,0 +1,52 @@
+/*
+htop - linux/CGroupPressure.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/CGroupPressure.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+#include "linux/Platform.h" // needed for GNU/hurd to get PATH_MAX  // IWYU pragma: keep
+
+
+float CGroupPressure_parse(const char* text) {
+   if (!text || !String_startsWith(text, "some avg10="))
+      return NAN;
+   return strtof(text + strlen("some avg10="), NULL);
+}
+
+static float CGroupPressure_read(const char* root, const char* path, const char* name) {
+   char relative[PATH_MAX];
+   char text[256];
+   if (*path) {
+      xSnprintf(relative, sizeof(relative), "%s/%s/%s", root, path, name);
+   } else {
+      xSnprintf(relative, sizeof(relative), "%s/%s", root, name);
+   }
+   if (FsRoot_readFile(&FsRoot_sys, relative, text, sizeof(text)) <= 0)
+      return NAN;
+   return CGroupPressure_parse(text);
+}
+
+void CGroupPressure_update(CGroupPressure* this, const char* root, const char* path, uint64_t nowMs) {
+   if (this->readMs == nowMs)
+      return;
+
+   this->readMs = nowMs;
+
+   while (*path == '/')
+      path++;
+
+   this->cpu = CGroupPressure_read(root, path, "cpu.pressure");
+   this->memory = CGroupPressure_read(root, path, "memory.pressure");
+   this->io = CGroupPressure_read(root, path, "io.pressure");
+}
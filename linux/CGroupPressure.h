@@ -0,0 +1,37 @@
+#ifndef HEADER_CGroupPressure
+#define HEADER_CGroupPressure
+/*
+htop - linux/CGroupPressure.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <math.h>
+#include <stdint.h>
+
+
+/*
+ * Pressure stall information of a cgroup of the v2 hierarchy: the share of
+ * the last 10 seconds some of its tasks waited for a CPU, for memory and for
+ * I/O, from the "some avg10" of its cpu.pressure, memory.pressure and
+ * io.pressure. NAN without PSI (kernels before 4.20, or psi=0).
+ */
+typedef struct CGroupPressure_ {
+   uint64_t readMs;           /* when the files were read last, 0 before */
+   float cpu;
+   float memory;
+   float io;
+} CGroupPressure;
+
+/* The "some" avg10 of the text of a *.pressure file, NAN if there is none */
+float CGroupPressure_parse(const char* text);
+
+/*
+ * Reads the pressure files of the cgroup at `path` of the hierarchy mounted
+ * at `root` below FsRoot_sys, unless they were already read at `nowMs`: all
+ * processes of a cgroup share its pressure and read it once per scan.
+ */
+void CGroupPressure_update(CGroupPressure* this, const char* root, const char* path, uint64_t nowMs);
+
+#endif
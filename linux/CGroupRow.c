@@ -0,0 +1,237 @@
+/*
+htop - linux/CGroupRow.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/CGroupRow.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CRT.h"
+#include "DynamicColumn.h"
+#include "Macros.h"
+#include "RichString.h"
+#include "Settings.h"
+#include "Table.h"
+#include "XUtils.h"
+
+#include "linux/CGroupLimits.h"
+
+
+typedef struct CGroupFieldData_ {
+   const char* name;          /* stored in htoprc as Dynamic(name) */
+   const char* heading;
+   const char* description;
+   int width;                 /* as in DynamicColumn, without the trailing space */
+} CGroupFieldData;
+
+static const CGroupFieldData CGroupRow_fields[LAST_CGROUP_FIELD] = {
+   [CGROUP_FIELD_CPU_PERCENT] = { .name = "cgroup_cpu_percent", .heading = "CPU%", .description = "Percentage of the CPU time of one CPU used by the cgroup", .width = 5, },
+   [CGROUP_FIELD_CPU_TIME] = { .name = "cgroup_cpu_time", .heading = "TIME+", .description = "Total CPU time used by the cgroup (cpu.stat)", .width = 8, },
+   [CGROUP_FIELD_MEMORY] = { .name = "cgroup_memory", .heading = "MEM", .description = "Memory charged to the cgroup (memory.current)", .width = 5, },
+   [CGROUP_FIELD_MEMORY_ANON] = { .name = "cgroup_memory_anon", .heading = "ANON", .description = "Anonymous memory of the cgroup (memory.stat)", .width = 5, },
+   [CGROUP_FIELD_MEMORY_FILE] = { .name = "cgroup_memory_file", .heading = "FILE", .description = "Page cache of the cgroup (memory.stat)", .width = 5, },
+   [CGROUP_FIELD_IO_READ_RATE] = { .name = "cgroup_io_read_rate", .heading = "DISK READ", .description = "Bytes per second read by the cgroup from block devices (io.stat)", .width = 11, },
+   [CGROUP_FIELD_IO_WRITE_RATE] = { .name = "cgroup_io_write_rate", .heading = "DISK WRITE", .description = "Bytes per second written by the cgroup to block devices (io.stat)", .width = 11, },
+   [CGROUP_FIELD_CPU_PRESSURE] = { .name = "cgroup_cpu_pressure", .heading = "PSI CPU", .description = "Share of the last 10 seconds some tasks of the cgroup waited for a CPU (cpu.pressure)", .width = 7, },
+   [CGROUP_FIELD_MEMORY_PRESSURE] = { .name = "cgroup_memory_pressure", .heading = "PSI MEM", .description = "Share of the last 10 seconds some tasks of the cgroup waited for memory (memory.pressure)", .width = 7, },
+   [CGROUP_FIELD_IO_PRESSURE] = { .name = "cgroup_io_pressure", .heading = "PSI IO", .description = "Share of the last 10 seconds some tasks of the cgroup waited for I/O (io.pressure)", .width = 7, },
+   [CGROUP_FIELD_MEMORY_BANDWIDTH] = { .name = "cgroup_memory_bandwidth", .heading = "MEM BW", .description = "Memory bandwidth of the resctrl monitoring groups of the cgroup (mbm_total_bytes)", .width = 11, },
+   [CGROUP_FIELD_LLC_OCCUPANCY] = { .name = "cgroup_llc_occupancy", .heading = "LLC", .description = "Last level cache occupancy of the resctrl monitoring groups of the cgroup (llc_occupancy)", .width = 5, },
+   [CGROUP_FIELD_CPU_QUOTA_PERCENT] = { .name = "cgroup_cpu_quota_percent", .heading = "QCPU%", .description = "CPU usage of the cgroup in percent of its CPU quota or the one of an ancestor (cpu.max)", .width = 5, },
+   [CGROUP_FIELD_MEMORY_HEADROOM] = { .name = "cgroup_memory_headroom", .heading = "MEMROOM", .description = "Memory the cgroup can still be charged before it or an ancestor reaches its limit (memory.max - memory.current)", .width = 7, },
+   [CGROUP_FIELD_NAME] = { .name = "cgroup_name", .heading = "CGROUP", .description = "Path of the cgroup, as a tree in tree view", .width = -6, },
+};
+
+CGroupRow* CGroupRow_new(const Machine* host) {
+   CGroupRow* this = xCalloc(1, sizeof(CGroupRow));
+   Object_setClass(this, Class(CGroupRow));
+   Row_init(&this->super, host);
+
+   this->memoryCurrent = ULLONG_MAX;
+   this->memoryAnon = ULLONG_MAX;
+   this->memoryFile = ULLONG_MAX;
+   this->cpuPressure = NAN;
+   this->memoryPressure = NAN;
+   this->ioPressure = NAN;
+   this->llcOccupancy = ULLONG_MAX;
+   this->cpuQuota = NAN;
+   this->memoryHeadroom = ULLONG_MAX;
+   return this;
+}
+
+static void CGroupRow_delete(Object* cast) {
+   CGroupRow* this = (CGroupRow*) cast;
+   free(this->path);
+   Row_done(&this->super);
+   free(this);
+}
+
+void CGroupRow_setPath(CGroupRow* this, const char* path) {
+   if (this->path && String_eq(this->path, path))
+      return;
+
+   free_and_xStrdup(&this->path, path);
+   const char* slash = strrchr(this->path, '/');
+   this->name = (slash && slash[1]) ? slash + 1 : this->path;
+}
+
+/* Microseconds of CPU time per second, in percent of one CPU */
+static inline float CGroupRow_cpuPercent(const CGroupRow* this) {
+   return (float)(Rate_value(&this->cpuRate) / 1e4);
+}
+
+static void CGroupRow_writeField(const Row* super, RichString* str, RowField field) {
+   const CGroupRow* this = (const CGroupRow*) super;
+   const Settings* settings = super->host->settings;
+   bool coloring = settings->highlightMegabytes;
+   char buffer[256];
+   size_t n = sizeof(buffer);
+   int attr = CRT_colors[DEFAULT_COLOR];
+
+   switch ((int)field - ROW_DYNAMIC_FIELDS) {
+   case CGROUP_FIELD_CPU_PERCENT: Row_printPercentage(CGroupRow_cpuPercent(this), buffer, n, 5, &attr); break;
+   case CGROUP_FIELD_CPU_TIME: Row_printTime(str, this->cpuUsage / 10000, coloring); return;
+   case CGROUP_FIELD_MEMORY: Row_printBytes(str, this->memoryCurrent, coloring); return;
+   case CGROUP_FIELD_MEMORY_ANON: Row_printBytes(str, this->memoryAnon, coloring); return;
+   case CGROUP_FIELD_MEMORY_FILE: Row_printBytes(str, this->memoryFile, coloring); return;
+   case CGROUP_FIELD_IO_READ_RATE: Row_printRate(str, Rate_value(&this->ioReadRate), coloring); return;
+   case CGROUP_FIELD_IO_WRITE_RATE: Row_printRate(str, Rate_value(&this->ioWriteRate), coloring); return;
+   case CGROUP_FIELD_CPU_PRESSURE: Row_printPercentage(this->cpuPressure, buffer, n, 7, &attr); break;
+   case CGROUP_FIELD_MEMORY_PRESSURE: Row_printPercentage(this->memoryPressure, buffer, n, 7, &attr); break;
+   case CGROUP_FIELD_IO_PRESSURE: Row_printPercentage(this->ioPressure, buffer, n, 7, &attr); break;
+   case CGROUP_FIELD_MEMORY_BANDWIDTH: Row_printRate(str, Rate_value(&this->memoryBandwidth), coloring); return;
+   case CGROUP_FIELD_LLC_OCCUPANCY: Row_printBytes(str, this->llcOccupancy, coloring); return;
+   case CGROUP_FIELD_CPU_QUOTA_PERCENT: Row_printPercentage(CGroupLimits_quotaPercent(this->cpuQuota, CGroupRow_cpuPercent(this)), buffer, n, 5, &attr); break;
+   case CGROUP_FIELD_MEMORY_HEADROOM: Row_printBytes(str, this->memoryHeadroom, coloring); return;
+   case CGROUP_FIELD_NAME: {
+      const int baseattr = CRT_colors[PROCESS_BASENAME];
+      if (settings->ss->treeView) {
+         Row_printTreeBranch(super, str);
+         RichString_appendWide(str, baseattr, this->name);
+         return;
+      }
+
+      RichString_appendnWide(str, attr, this->path, (int)(this->name - this->path));
+      RichString_appendWide(str, baseattr, this->name);
+      return;
+   }
+   default:
+      assert(0 && "CGroupRow_writeField: default key reached"); /* should never be reached */
+      xSnprintf(buffer, n, "- ");
+      break;
+   }
+
+   RichString_appendAscii(str, attr, buffer);
+}
+
+/* Unknown sizes compare as zero rather than as the largest */
+static inline unsigned long long CGroupRow_knownOrZero(unsigned long long value) {
+   return value == ULLONG_MAX ? 0 : value;
+}
+
+static int CGroupRow_compareByKey(const CGroupRow* c1, const CGroupRow* c2, RowField key) {
+   switch ((int)key - ROW_DYNAMIC_FIELDS) {
+   case CGROUP_FIELD_CPU_PERCENT:
+      return compareRealNumbers(CGroupRow_cpuPercent(c1), CGroupRow_cpuPercent(c2));
+   case CGROUP_FIELD_CPU_TIME:
+      return SPACESHIP_NUMBER(c1->cpuUsage, c2->cpuUsage);
+   case CGROUP_FIELD_MEMORY:
+      return SPACESHIP_NUMBER(CGroupRow_knownOrZero(c1->memoryCurrent), CGroupRow_knownOrZero(c2->memoryCurrent));
+   case CGROUP_FIELD_MEMORY_ANON:
+      return SPACESHIP_NUMBER(CGroupRow_knownOrZero(c1->memoryAnon), CGroupRow_knownOrZero(c2->memoryAnon));
+   case CGROUP_FIELD_MEMORY_FILE:
+      return SPACESHIP_NUMBER(CGroupRow_knownOrZero(c1->memoryFile), CGroupRow_knownOrZero(c2->memoryFile));
+   case CGROUP_FIELD_IO_READ_RATE:
+      return compareRealNumbers(Rate_value(&c1->ioReadRate), Rate_value(&c2->ioReadRate));
+   case CGROUP_FIELD_IO_WRITE_RATE:
+      return compareRealNumbers(Rate_value(&c1->ioWriteRate), Rate_value(&c2->ioWriteRate));
+   case CGROUP_FIELD_CPU_PRESSURE:
+      return compareRealNumbers(c1->cpuPressure, c2->cpuPressure);
+   case CGROUP_FIELD_MEMORY_PRESSURE:
+      return compareRealNumbers(c1->memoryPressure, c2->memoryPressure);
+   case CGROUP_FIELD_IO_PRESSURE:
+      return compareRealNumbers(c1->ioPressure, c2->ioPressure);
+   case CGROUP_FIELD_MEMORY_BANDWIDTH:
+      return compareRealNumbers(Rate_value(&c1->memoryBandwidth), Rate_value(&c2->memoryBandwidth));
+   case CGROUP_FIELD_LLC_OCCUPANCY:
+      return SPACESHIP_NUMBER(CGroupRow_knownOrZero(c1->llcOccupancy), CGroupRow_knownOrZero(c2->llcOccupancy));
+   case CGROUP_FIELD_CPU_QUOTA_PERCENT:
+      return compareRealNumbers(CGroupLimits_quotaPercent(c1->cpuQuota, CGroupRow_cpuPercent(c1)), CGroupLimits_quotaPercent(c2->cpuQuota, CGroupRow_cpuPercent(c2)));
+   case CGROUP_FIELD_MEMORY_HEADROOM:
+      /* no limit is the most headroom */
+      return SPACESHIP_NUMBER(c1->memoryHeadroom, c2->memoryHeadroom);
+   case CGROUP_FIELD_NAME:
+      return SPACESHIP_NULLSTR(c1->path, c2->path);
+   default:
+      return 0;
+   }
+}
+
+static int CGroupRow_compare(const void* v1, const void* v2) {
+   const CGroupRow* c1 = (const CGroupRow*)v1;
+   const CGroupRow* c2 = (const CGroupRow*)v2;
+   const ScreenSettings* ss = c1->super.host->settings->ss;
+   RowField key = ScreenSettings_getActiveSortKey(ss);
+   int result = CGroupRow_compareByKey(c1, c2, key);
+
+   // Implement tie-breaker (needed to make tree mode more stable)
+   if (!result)
+      return SPACESHIP_NULLSTR(c1->path, c2->path);
+
+   return (ScreenSettings_getActiveDirection(ss) == 1) ? result : -result;
+}
+
+static int CGroupRow_compareByParent(const Row* r1, const Row* r2) {
+   int result = Row_compareByParent_Base(r1, r2);
+
+   if (result != 0)
+      return result;
+
+   return CGroupRow_compare(r1, r2);
+}
+
+static const char* CGroupRow_sortKeyString(Row* super) {
+   const CGroupRow* this = (const CGroupRow*) super;
+   return this->name;
+}
+
+static bool CGroupRow_matchesFilter(Row* super, const Table* table) {
+   const CGroupRow* this = (const CGroupRow*) super;
+   return !FilterMatcher_matches(&table->filter, this->path);
+}
+
+void CGroupRow_addColumns(Hashtable* columns) {
+   for (int i = 0; i < LAST_CGROUP_FIELD; i++) {
+      const CGroupFieldData* data = &CGroupRow_fields[i];
+      DynamicColumn* column = xCalloc(1, sizeof(DynamicColumn));
+      String_safeStrncpy(column->name, data->name, sizeof(column->name));
+      column->heading = xStrdup(data->heading);
+      column->caption = xStrdup(data->heading);
+      column->description = xStrdup(data->description);
+      column->width = data->width;
+      column->enabled = true;
+      Hashtable_put(columns, CGroupField_key(i), column);
+   }
+}
+
+const RowClass CGroupRow_class = {
+   .super = {
+      .extends = Class(Row),
+      .display = Row_display,
+      .delete = CGroupRow_delete,
+      .compare = CGroupRow_compare,
+   },
+   .writeField = CGroupRow_writeField,
+   .matchesFilter = CGroupRow_matchesFilter,
+   .sortKeyString = CGroupRow_sortKeyString,
+   .compareByParent = CGroupRow_compareByParent,
+};
@@ -0,0 +1,80 @@
+#ifndef HEADER_CGroupRow
+#define HEADER_CGroupRow
+/*
+htop - linux/CGroupRow.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Hashtable.h"
+#include "Machine.h"
+#include "Object.h"
+#include "Rate.h"
+#include "Row.h"
+#include "RowField.h"
+
+
+/* Columns of the cgroup screen, keyed from ROW_DYNAMIC_FIELDS on */
+typedef enum CGroupField_ {
+   CGROUP_FIELD_CPU_PERCENT,
+   CGROUP_FIELD_CPU_TIME,
+   CGROUP_FIELD_MEMORY,
+   CGROUP_FIELD_MEMORY_ANON,
+   CGROUP_FIELD_MEMORY_FILE,
+   CGROUP_FIELD_IO_READ_RATE,
+   CGROUP_FIELD_IO_WRITE_RATE,
+   CGROUP_FIELD_CPU_PRESSURE,
+   CGROUP_FIELD_MEMORY_PRESSURE,
+   CGROUP_FIELD_IO_PRESSURE,
+   CGROUP_FIELD_MEMORY_BANDWIDTH,
+   CGROUP_FIELD_LLC_OCCUPANCY,
+   CGROUP_FIELD_CPU_QUOTA_PERCENT,
+   CGROUP_FIELD_MEMORY_HEADROOM,
+   CGROUP_FIELD_NAME,
+   LAST_CGROUP_FIELD
+} CGroupField;
+
+#define CGroupField_key(f_)  ((RowField)(ROW_DYNAMIC_FIELDS + (f_)))
+
+/* One cgroup of the v2 hierarchy; values a cgroup does not provide are ULLONG_MAX or NAN */
+typedef struct CGroupRow_ {
+   Row super;
+
+   char* path;                           /* relative to the root of the hierarchy, "/" for the root */
+   const char* name;                     /* last component of path */
+
+   unsigned long long cpuUsage;          /* usage_usec of cpu.stat */
+   Rate cpuRate;                         /* of cpuUsage, 10^6 being one CPU busy */
+
+   unsigned long long memoryCurrent;     /* memory.current, in bytes */
+   unsigned long long memoryAnon;        /* anon of memory.stat */
+   unsigned long long memoryFile;        /* file of memory.stat */
+
+   Rate ioReadRate;                      /* of rbytes in io.stat, over all devices */
+   Rate ioWriteRate;                     /* of wbytes in io.stat, over all devices */
+
+   float cpuPressure;                    /* "some" avg10 of the *.pressure files */
+   float memoryPressure;
+   float ioPressure;
+
+   Rate memoryBandwidth;                 /* of mbm_total_bytes of the resctrl groups of its tasks */
+   unsigned long long llcOccupancy;      /* llc_occupancy of those groups, in bytes */
+
+   double cpuQuota;                      /* in CPUs, the lowest cpu.max of the cgroup and its ancestors */
+   unsigned long long memoryHeadroom;    /* the least memory.max - memory.current of those, in bytes */
+} CGroupRow;
+
+extern const RowClass CGroupRow_class;
+
+CGroupRow* CGroupRow_new(const Machine* host);
+
+void CGroupRow_setPath(CGroupRow* this, const char* path);
+
+/* Adds the dynamic columns of the cgroup screen to `columns` */
+void CGroupRow_addColumns(Hashtable* columns);
+
+#endif
@@ -0,0 +1,125 @@
+/*
+htop - linux/CGroupScope.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/CGroupScope.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Compat.h"
+#include "Macros.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+
+
+const char* CGroupScope_path;
+
+/* Directory of the cgroup, kept open so it is found again wherever it is moved */
+static int CGroupScope_fd = -1;
+
+bool CGroupScope_open(const char* root) {
+   if (!root || !CGroupScope_path)
+      return false;
+
+   const char* path = CGroupScope_path;
+   while (*path == '/')
+      path++;
+
+   char* full;
+   xAsprintf(&full, "%s/%s", root, path);
+
+   CGroupScope_close();
+   CGroupScope_fd = Compat_openat(FsRoot_dir(&FsRoot_sys), full, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   free(full);
+
+   return CGroupScope_fd >= 0;
+}
+
+void CGroupScope_close(void) {
+   if (CGroupScope_fd >= 0)
+      close(CGroupScope_fd);
+   CGroupScope_fd = -1;
+}
+
+static void CGroupScope_readProcs(ProcDirList* list, int dirFd) {
+   int fd = openat(dirFd, "cgroup.procs", O_RDONLY | O_CLOEXEC);
+   if (fd < 0)
+      return;
+
+   FILE* fp = fdopen(fd, "r");
+   if (!fp) {
+      close(fd);
+      return;
+   }
+
+   int pid;
+   while (fscanf(fp, "%d", &pid) == 1) {
+      if (pid > 0) {
+         ProcDirList_addPid(list, pid);
+      }
+   }
+
+   fclose(fp);
+}
+
+/* Lists the processes of the cgroup of the directory and all below it; takes over the descriptor */
+static void CGroupScope_scanCGroup(ProcDirList* list, int dirFd) {
+   CGroupScope_readProcs(list, dirFd);
+
+   DIR* dir = fdopendir(dirFd);
+   if (!dir) {
+      close(dirFd);
+      return;
+   }
+
+   const struct dirent* entry;
+   while ((entry = readdir(dir)) != NULL) {
+      if (entry->d_name[0] == '.' || (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN))
+         continue;
+
+      int childFd = openat(dirfd(dir), entry->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+      if (childFd >= 0)
+         CGroupScope_scanCGroup(list, childFd);
+   }
+
+   closedir(dir);
+}
+
+static int CGroupScope_comparePids(const void* v1, const void* v2) {
+   const ProcDirEntry* e1 = v1;
+   const ProcDirEntry* e2 = v2;
+   return SPACESHIP_NUMBER(e1->pid, e2->pid);
+}
+
+bool CGroupScope_list(ProcDirList* list) {
+   list->count = 0;
+
+   /* a descriptor of its own, the directory is read from its start */
+   int fd = openat(CGroupScope_fd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   if (fd < 0)
+      return false;
+
+   CGroupScope_scanCGroup(list, fd);
+
+   /* a process with threads in several cgroups of a threaded subtree is listed by each */
+   if (list->count > 1)
+      qsort(list->entries, list->count, sizeof(ProcDirEntry), CGroupScope_comparePids);
+   size_t n = 0;
+   for (size_t i = 0; i < list->count; i++) {
+      if (n == 0 || list->entries[n - 1].pid != list->entries[i].pid) {
+         list->entries[n++] = list->entries[i];
+      }
+   }
+   list->count = n;
+   return true;
+}
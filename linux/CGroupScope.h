@@ -0,0 +1,26 @@
+#ifndef HEADER_CGroupScope
+#define HEADER_CGroupScope
+/*
+htop - linux/CGroupScope.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+
+#include "linux/ProcDirList.h"
+
+
+/* The cgroup given with --cgroup, relative to the root of the v2 hierarchy; NULL to scan all processes */
+extern const char* CGroupScope_path;
+
+/* Opens the cgroup of CGroupScope_path below the hierarchy at `root` (below FsRoot_sys) */
+bool CGroupScope_open(const char* root);
+
+void CGroupScope_close(void);
+
+/* Lists the processes of the cgroup and of all cgroups below it, ordered by PID */
+bool CGroupScope_list(ProcDirList* list);
+
+#endif
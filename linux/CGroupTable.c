@@ -0,0 +1,242 @@
+/*
+htop - linux/CGroupTable.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/CGroupTable.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "Compat.h"
+#include "Macros.h"
+#include "Rate.h"
+#include "Row.h"
+#include "XUtils.h"
+
+#include "linux/CGroupLimits.h"
+#include "linux/CGroupPressure.h"
+#include "linux/CGroupRow.h"
+#include "linux/FsRoot.h"
+#include "linux/Resctrl.h"
+
+
+/* Enough for memory.stat, and io.stat of a few dozen devices */
+#define CGROUPTABLE_BUFFER_SIZE 8192
+
+const char* CGroupTable_findRoot(void) {
+   /* unified mode, or the hybrid mode of older systemd */
+   if (FsRoot_access(&FsRoot_sys, "fs/cgroup/cgroup.controllers", R_OK))
+      return "fs/cgroup";
+   if (FsRoot_access(&FsRoot_sys, "fs/cgroup/unified/cgroup.controllers", R_OK))
+      return "fs/cgroup/unified";
+   return NULL;
+}
+
+CGroupTable* CGroupTable_new(Machine* host, const char* root) {
+   CGroupTable* this = xCalloc(1, sizeof(CGroupTable));
+   Object_setClass(this, Class(CGroupTable));
+   Table_init(&this->super, Class(CGroupRow), host);
+
+   this->root = root;
+   this->pathSize = 256;
+   this->path = xMalloc(this->pathSize);
+   this->buffer = xMalloc(CGROUPTABLE_BUFFER_SIZE);
+   return this;
+}
+
+static void CGroupTable_delete(Object* cast) {
+   CGroupTable* this = (CGroupTable*) cast;
+   Table_done(&this->super);
+   free(this->path);
+   free(this->buffer);
+   free(this);
+}
+
+static const char* CGroupTable_readFile(CGroupTable* this, int dirFd, const char* name) {
+   return xReadfileat(dirFd, name, this->buffer, CGROUPTABLE_BUFFER_SIZE) >= 0 ? this->buffer : NULL;
+}
+
+/* Value of a "key value" line of a flat keyed file like cpu.stat, ULLONG_MAX if there is none */
+static unsigned long long CGroupTable_keyedValue(const char* text, const char* key) {
+   const size_t len = strlen(key);
+   for (const char* line = text; line; line = strchr(line, '\n')) {
+      if (*line == '\n')
+         line++;
+      if (String_startsWith(line, key) && line[len] == ' ')
+         return strtoull(line + len + 1, NULL, 10);
+   }
+   return ULLONG_MAX;
+}
+
+/* Sum of the "key=value" pairs of a nested keyed file like io.stat, over all its lines */
+static unsigned long long CGroupTable_nestedSum(const char* text, const char* key) {
+   const size_t len = strlen(key);
+   unsigned long long sum = 0;
+   for (const char* pair = strstr(text, key); pair; pair = strstr(pair + len, key))
+      sum += strtoull(pair + len, NULL, 10);
+   return sum;
+}
+
+/* The "some" avg10 of a *.pressure file, NAN without pressure stall information */
+static float CGroupTable_readPressure(CGroupTable* this, int dirFd, const char* name) {
+   return CGroupPressure_parse(CGroupTable_readFile(this, dirFd, name));
+}
+
+/* The limits of the cgroup, or of its parent where they are lower */
+static void CGroupTable_readLimits(CGroupTable* this, CGroupRow* cg, const CGroupRow* parent, int dirFd) {
+   double cpuQuota = parent ? parent->cpuQuota : NAN;
+   const double quota = CGroupLimits_parseCpuMax(CGroupTable_readFile(this, dirFd, "cpu.max"));
+   if (!isnan(quota) && (isnan(cpuQuota) || quota < cpuQuota))
+      cpuQuota = quota;
+   cg->cpuQuota = cpuQuota;
+
+   const unsigned long long headroom = CGroupLimits_headroom(CGroupLimits_parseMemoryMax(CGroupTable_readFile(this, dirFd, "memory.max")), cg->memoryCurrent);
+   cg->memoryHeadroom = MINIMUM(parent ? parent->memoryHeadroom : ULLONG_MAX, headroom);
+}
+
+static void CGroupTable_readValues(CGroupTable* this, CGroupRow* cg, const CGroupRow* parent, int dirFd) {
+   const uint64_t now = this->super.host->monotonicMs;
+   const char* text;
+
+   unsigned long long cpuUsage = (text = CGroupTable_readFile(this, dirFd, "cpu.stat")) ? CGroupTable_keyedValue(text, "usage_usec") : ULLONG_MAX;
+   Rate_update(&cg->cpuRate, cpuUsage, now);
+   cg->cpuUsage = cpuUsage == ULLONG_MAX ? 0 : cpuUsage;
+
+   cg->memoryCurrent = (text = CGroupTable_readFile(this, dirFd, "memory.current")) ? strtoull(text, NULL, 10) : ULLONG_MAX;
+
+   if ((text = CGroupTable_readFile(this, dirFd, "memory.stat"))) {
+      cg->memoryAnon = CGroupTable_keyedValue(text, "anon");
+      cg->memoryFile = CGroupTable_keyedValue(text, "file");
+   } else {
+      cg->memoryAnon = ULLONG_MAX;
+      cg->memoryFile = ULLONG_MAX;
+   }
+
+   unsigned long long ioReadBytes = ULLONG_MAX;
+   unsigned long long ioWriteBytes = ULLONG_MAX;
+   if ((text = CGroupTable_readFile(this, dirFd, "io.stat"))) {
+      ioReadBytes = CGroupTable_nestedSum(text, "rbytes=");
+      ioWriteBytes = CGroupTable_nestedSum(text, "wbytes=");
+   }
+   Rate_update(&cg->ioReadRate, ioReadBytes, now);
+   Rate_update(&cg->ioWriteRate, ioWriteBytes, now);
+
+   cg->cpuPressure = CGroupTable_readPressure(this, dirFd, "cpu.pressure");
+   cg->memoryPressure = CGroupTable_readPressure(this, dirFd, "memory.pressure");
+   cg->ioPressure = CGroupTable_readPressure(this, dirFd, "io.pressure");
+
+   ResctrlCounters resctrl;
+   if (!this->resctrl->valid || !Resctrl_sumCGroup(this->resctrl, cg->path, &resctrl))
+      resctrl = (ResctrlCounters) { ULLONG_MAX, ULLONG_MAX, ULLONG_MAX };
+   Rate_update(&cg->memoryBandwidth, resctrl.totalBytes, now);
+   cg->llcOccupancy = resctrl.occupancy;
+
+   CGroupTable_readLimits(this, cg, parent, dirFd);
+}
+
+static CGroupRow* CGroupTable_getRow(CGroupTable* this, int id) {
+   Table* super = &this->super;
+   CGroupRow* cg = (CGroupRow*) Table_findRow(super, id);
+   if (cg) {
+      /* a cgroup created again right after it was removed */
+      cg->super.tombStampMs = 0;
+      return cg;
+   }
+
+   cg = CGroupRow_new(super->host);
+   cg->super.id = id;
+   cg->super.group = id;
+   Table_add(super, &cg->super);
+   return cg;
+}
+
+static void CGroupTable_appendPath(CGroupTable* this, const char* name) {
+   const size_t len = strlen(name);
+   if (this->pathLen + len + 2 > this->pathSize) {
+      this->pathSize = 2 * (this->pathLen + len + 2);
+      this->path = xRealloc(this->path, this->pathSize);
+   }
+
+   this->path[this->pathLen++] = '/';
+   memcpy(this->path + this->pathLen, name, len + 1);
+   this->pathLen += len;
+}
+
+/* Reads the cgroup of the directory and all below it; takes over the descriptor */
+static void CGroupTable_scanCGroup(CGroupTable* this, int dirFd, int parentId) {
+   struct stat sb;
+   if (fstat(dirFd, &sb) != 0) {
+      close(dirFd);
+      return;
+   }
+
+   /* the inode of a cgroup directory is its cgroup id, unique while it exists */
+   const int id = (int)(sb.st_ino & INT_MAX);
+   CGroupRow* cg = CGroupTable_getRow(this, id);
+   cg->super.parent = parentId;
+   Table_markUpdated(&this->super, &cg->super);
+   cg->super.show = true;
+   CGroupRow_setPath(cg, this->pathLen ? this->path : "/");
+   CGroupTable_readValues(this, cg, (const CGroupRow*) Table_findRow(&this->super, parentId), dirFd);
+
+   DIR* dir = fdopendir(dirFd);
+   if (!dir) {
+      close(dirFd);
+      return;
+   }
+
+   const size_t pathLen = this->pathLen;
+   const struct dirent* entry;
+   while ((entry = readdir(dir)) != NULL) {
+      if (entry->d_name[0] == '.' || (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN))
+         continue;
+
+      int childFd = openat(dirfd(dir), entry->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+      if (childFd < 0)
+         continue;
+
+      CGroupTable_appendPath(this, entry->d_name);
+      CGroupTable_scanCGroup(this, childFd, id);
+      this->pathLen = pathLen;
+      this->path[pathLen] = '\0';
+   }
+
+   closedir(dir);
+}
+
+static void CGroupTable_iterateEntries(Table* super) {
+   CGroupTable* this = (CGroupTable*) super;
+
+   int fd = Compat_openat(FsRoot_dir(&FsRoot_sys), this->root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   if (fd < 0)
+      return;
+
+   /* the resctrl groups are mapped to the cgroups of their tasks */
+   this->resctrl = Resctrl_get(super->host, true);
+
+   this->pathLen = 0;
+   this->path[0] = '\0';
+   CGroupTable_scanCGroup(this, fd, 0);
+}
+
+const TableClass CGroupTable_class = {
+   .super = {
+      .extends = Class(Table),
+      .delete = CGroupTable_delete,
+   },
+   .prepare = Table_prepareEntries,
+   .iterate = CGroupTable_iterateEntries,
+   .cleanup = Table_cleanupEntries,
+};
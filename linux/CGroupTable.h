@@ -0,0 +1,40 @@
+#ifndef HEADER_CGroupTable
+#define HEADER_CGroupTable
+/*
+htop - linux/CGroupTable.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stddef.h>
+
+#include "Machine.h"
+#include "Table.h"
+
+#include "linux/Resctrl.h"
+
+
+/*
+ * The cgroups of the v2 hierarchy as rows, one per directory, read straight
+ * from their interface files instead of summed up over their processes.
+ */
+typedef struct CGroupTable_ {
+   Table super;
+
+   const char* root;          /* directory of the hierarchy below FsRoot_sys */
+   char* path;                /* of the cgroup being read, relative to root */
+   size_t pathLen;
+   size_t pathSize;
+   char* buffer;              /* contents of the interface file being read */
+   const Resctrl* resctrl;    /* for the memory bandwidth of the cgroups */
+} CGroupTable;
+
+extern const TableClass CGroupTable_class;
+
+/* Where the v2 hierarchy is mounted below FsRoot_sys, NULL if it is not */
+const char* CGroupTable_findRoot(void);
+
+CGroupTable* CGroupTable_new(Machine* host, const char* root);
+
+#endif
@@ -0,0 +1,56 @@
+/*
+htop - linux/CGroupThrottle.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/CGroupThrottle.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+#include "linux/Platform.h" // needed for GNU/hurd to get PATH_MAX  // IWYU pragma: keep
+
+
+/* Value of a key of a flat keyed file, ULLONG_MAX if there is none */
+static unsigned long long CGroupThrottle_keyedValue(const char* text, const char* key) {
+   const size_t len = strlen(key);
+   for (const char* line = text; line; line = strchr(line, '\n')) {
+      if (*line == '\n')
+         line++;
+      if (String_startsWith(line, key) && line[len] == ' ')
+         return strtoull(line + len + 1, NULL, 10);
+   }
+   return ULLONG_MAX;
+}
+
+void CGroupThrottle_update(CGroupThrottle* this, const char* root, const char* path, uint64_t nowMs) {
+   if (this->readMs == nowMs)
+      return;
+
+   this->readMs = nowMs;
+
+   unsigned long long periods = ULLONG_MAX;
+   unsigned long long usec = ULLONG_MAX;
+
+   while (*path == '/')
+      path++;
+
+   char relative[PATH_MAX];
+   char text[1024];
+   xSnprintf(relative, sizeof(relative), *path ? "%s/%s/cpu.stat" : "%s/cpu.stat", root, path);
+   if (FsRoot_readFile(&FsRoot_sys, relative, text, sizeof(text)) > 0) {
+      periods = CGroupThrottle_keyedValue(text, "nr_throttled");
+      usec = CGroupThrottle_keyedValue(text, "throttled_usec");
+   }
+
+   Rate_update(&this->periods, periods, nowMs);
+   Rate_update(&this->usec, usec, nowMs);
+}
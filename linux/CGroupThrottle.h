@@ -0,0 +1,47 @@
+#ifndef HEADER_CGroupThrottle
+#define HEADER_CGroupThrottle
+/*
+htop - linux/CGroupThrottle.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <math.h>
+#include <stdint.h>
+
+#include "Macros.h"
+#include "Rate.h"
+
+
+/*
+ * CPU bandwidth throttling of a cgroup of the v2 hierarchy: how often and
+ * how long its tasks were held back for having used up their cpu.max
+ * quota, from the nr_throttled and throttled_usec keys of its cpu.stat.
+ * Both are unknown without the cpu controller enabled for the cgroup.
+ */
+typedef struct CGroupThrottle_ {
+   uint64_t readMs;           /* when cpu.stat was read last */
+   Rate periods;              /* nr_throttled */
+   Rate usec;                 /* throttled_usec */
+} CGroupThrottle;
+
+/*
+ * Reads cpu.stat of the cgroup at `path` of the hierarchy mounted at
+ * `root` below FsRoot_sys, unless it was already read at `nowMs`: all
+ * processes of a cgroup share its throttle and read it once per scan.
+ */
+void CGroupThrottle_update(CGroupThrottle* this, const char* root, const char* path, uint64_t nowMs);
+
+/* Share of the wall clock time the cgroup was throttled, NAN while unknown */
+static inline float CGroupThrottle_percent(const CGroupThrottle* this) {
+   const double percent = Rate_value(&this->usec) / 1e4;
+   return isnan(percent) ? NAN : (float)MINIMUM(percent, 100.0);
+}
+
+/* Periods the cgroup was throttled in, per second */
+static inline double CGroupThrottle_periodRate(const CGroupThrottle* this) {
+   return Rate_value(&this->periods);
+}
+
+#endif
@@ -36,10 +36,21 @@ static const char* str_nspawn_payload_label = "/payload";
 
 static const char* str_snap_scope_prefix = "snap.";
 static const char* str_pod_scope_prefix = "libpod-";
+static const char* str_crio_conmon_scope_prefix = "crio-conmon-";
 
 static const char* str_service_suffix = ".service";
 static const char* str_scope_suffix = ".scope";
 
+/* Scopes systemd creates for the containers of a runtime, named after their ID */
+static const struct {
+   const char* prefix;
+   const char* runtime;
+} CGroup_containerScopes[] = {
+   { "docker-", "docker" },
+   { "cri-containerd-", "containerd" },
+   { "crio-", "crio" },
+};
+
 typedef struct StrBuf_state {
    char* buf;
    size_t size;
@@ -90,6 +101,28 @@ static bool Label_checkSuffix(const char* labelStart, size_t labelLen, const cha
    return labelLen > strlen(expected) && String_startsWith(labelStart + labelLen - strlen(expected), expected);
 }
 
+/* The runtime of a container scope without its ".scope" suffix, NULL if it is none */
+static const char* Label_containerScope(const char* scopeStart, size_t scopeNameLen, const char** id, size_t* idLen) {
+   /* the monitor of a CRI-O container, not the container itself */
+   if (Label_checkPrefix(scopeStart, scopeNameLen, str_crio_conmon_scope_prefix))
+      return NULL;
+
+   for (size_t i = 0; i < ARRAYSIZE(CGroup_containerScopes); i++) {
+      const char* prefix = CGroup_containerScopes[i].prefix;
+      if (Label_checkPrefix(scopeStart, scopeNameLen, prefix)) {
+         *id = scopeStart + strlen(prefix);
+         *idLen = scopeNameLen - strlen(prefix);
+         return CGroup_containerScopes[i].runtime;
+      }
+   }
+
+   return NULL;
+}
+
+static const char* Label_end(const char* labelStart) {
+   return labelStart + strcspn(labelStart, "/;");
+}
+
 static bool CGroup_filterName_internal(const char* cgroup, StrBuf_state* s, StrBuf_putc_t w) {
    while (*cgroup) {
       if ('/' == *cgroup) {
@@ -367,7 +400,8 @@ char* CGroup_filterName(const char* cgroup) {
 }
 
 static bool CGroup_filterContainer_internal(const char* cgroup, StrBuf_state* s, StrBuf_putc_t w) {
-   while (*cgroup) {
+   /* one hierarchy of a path joined from several ones by ';' */
+   while (*cgroup && ';' != *cgroup) {
       if ('/' == *cgroup) {
          while ('/' == *cgroup)
             cgroup++;
@@ -376,7 +410,7 @@ static bool CGroup_filterContainer_internal(const char* cgroup, StrBuf_state* s,
       }
 
       const char* labelStart = cgroup;
-      const char* nextSlash = String_strchrnul(labelStart, '/');
+      const char* nextSlash = Label_end(labelStart);
       const size_t labelLen = nextSlash - labelStart;
 
       if (Label_checkPrefix(labelStart, labelLen, str_lxc_payload_prefix)) {
@@ -399,7 +433,7 @@ static bool CGroup_filterContainer_internal(const char* cgroup, StrBuf_state* s,
          while (*labelStart == '/')
             labelStart++;
 
-         nextSlash = String_strchrnul(labelStart, '/');
+         nextSlash = Label_end(labelStart);
          if (nextSlash - labelStart > 0) {
             if (!StrBuf_putsz(s, w, "/lxc:"))
                return false;
@@ -457,6 +491,17 @@ static bool CGroup_filterContainer_internal(const char* cgroup, StrBuf_state* s,
             continue;
          }
 
+         const char* id;
+         size_t idLen;
+         const char* runtime = Label_containerScope(labelStart, scopeNameLen, &id, &idLen);
+         if (runtime) {
+            if (!w(s, '/') || !StrBuf_putsz(s, w, runtime) || !w(s, ':'))
+               return false;
+
+            if (!StrBuf_putsn(s, w, id, MINIMUM(idLen, 12)))
+               return false;
+         }
+
          cgroup = nextSlash;
 
          continue;
@@ -468,6 +513,28 @@ static bool CGroup_filterContainer_internal(const char* cgroup, StrBuf_state* s,
    return true;
 }
 
+const char* CGroup_findContainerId(const char* cgroup, const char** id, size_t* idLen) {
+   while (*cgroup) {
+      if ('/' == *cgroup || ';' == *cgroup) {
+         cgroup++;
+         continue;
+      }
+
+      const char* labelEnd = Label_end(cgroup);
+      const size_t labelLen = labelEnd - cgroup;
+
+      if (Label_checkSuffix(cgroup, labelLen, str_scope_suffix)) {
+         const char* runtime = Label_containerScope(cgroup, labelLen - strlen(str_scope_suffix), id, idLen);
+         if (runtime)
+            return runtime;
+      }
+
+      cgroup = labelEnd;
+   }
+
+   return NULL;
+}
+
 char* CGroup_filterContainer(const char* cgroup) {
    StrBuf_state s = {
       .buf = NULL,
@@ -475,8 +542,17 @@ char* CGroup_filterContainer(const char* cgroup) {
       .pos = 0,
    };
 
-   if (!CGroup_filterContainer_internal(cgroup, &s, StrBuf_putc_count)) {
-      return NULL;
+   /* the first of the hierarchies in a container */
+   for (;;) {
+      if (!CGroup_filterContainer_internal(cgroup, &s, StrBuf_putc_count)) {
+         return NULL;
+      }
+
+      const char* next = strchr(cgroup, ';');
+      if (s.pos || !next)
+         break;
+
+      cgroup = next + 1;
    }
 
    if (!s.pos) {
@@ -7,8 +7,17 @@ Released under the GNU GPLv2+, see the COPYING file
 in the source distribution for its full text.
 */
 
+#include <stddef.h>
+
 
 char* CGroup_filterName(const char* cgroup);
 char* CGroup_filterContainer(const char* cgroup);
 
+/*
+ * The runtime ("docker", "containerd" or "crio") of the first container
+ * scope in the path and the full ID of that container, NULL if the path
+ * has none.
+ */
+const char* CGroup_findContainerId(const char* cgroup, const char** id, size_t* idLen);
+
 #endif /* HEADER_CGroupUtils */
@@ -0,0 +1,323 @@
+/*
+htop - linux/CPUFreqCounters.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/CPUFreqCounters.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+
+#ifdef HAVE_PERF_EVENTS
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include "Macros.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+
+
+#define CPUFREQ_MSR_TSC   0x10
+#define CPUFREQ_MSR_MPERF 0xE7
+#define CPUFREQ_MSR_APERF 0xE8
+
+#define CPUFREQ_PMU_DIR "bus/event_source/devices/msr"
+
+typedef enum CPUFreqBackend_ {
+   CPUFREQ_UNKNOWN,                /* not tried yet */
+   CPUFREQ_PERF,
+   CPUFREQ_MSR,
+   CPUFREQ_NONE                    /* neither is available */
+} CPUFreqBackend;
+
+typedef enum CPUFreqCounter_ {
+   CPUFREQ_TSC,                    /* the perf group leader */
+   CPUFREQ_APERF,
+   CPUFREQ_MPERF,
+   CPUFREQ_COUNTERS
+} CPUFreqCounter;
+
+typedef struct CPUFreqCPU_ {
+   int fds[CPUFREQ_COUNTERS];      /* perf events, or /dev/cpu/<N>/msr in the first; -1 if not open */
+   bool tried;                     /* opening failed while online, not tried again until offline */
+   bool haveLast;
+   uint64_t last[CPUFREQ_COUNTERS];
+   uint64_t lastUs;
+   double mhz;
+} CPUFreqCPU;
+
+static CPUFreqBackend CPUFreqCounters_backend;
+static CPUFreqCPU* CPUFreqCounters_cpus;
+static unsigned int CPUFreqCounters_count;
+
+#ifdef HAVE_PERF_EVENTS
+static uint32_t CPUFreqCounters_pmuType;
+static uint64_t CPUFreqCounters_configs[CPUFREQ_COUNTERS];
+#endif
+
+static uint64_t CPUFreqCounters_nowUs(void) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+/* Whether `fds` more fds leave most of them to the process scan */
+static bool CPUFreqCounters_fdsAvailable(unsigned int fds) {
+   struct rlimit rl;
+   return getrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur == RLIM_INFINITY || fds <= rl.rlim_cur / 4;
+}
+
+/* keep the low fds free, see LinuxProcessTable_getProcFd() */
+static int CPUFreqCounters_highFd(int fd) {
+   if (fd >= 0 && fd < FD_SETSIZE) {
+      int highFd = fcntl(fd, F_DUPFD_CLOEXEC, FD_SETSIZE);
+      if (highFd >= 0) {
+         close(fd);
+         fd = highFd;
+      }
+   }
+   return fd;
+}
+
+#ifdef HAVE_PERF_EVENTS
+
+/* The config of an event of the msr PMU, from its "event=0x01" file */
+static bool CPUFreqCounters_pmuEvent(const char* name, uint64_t* config) {
+   char relative[128];
+   char text[64];
+   xSnprintf(relative, sizeof(relative), CPUFREQ_PMU_DIR "/events/%s", name);
+   if (FsRoot_readFile(&FsRoot_sys, relative, text, sizeof(text)) <= 0 || !String_startsWith(text, "event="))
+      return false;
+
+   char* end;
+   *config = strtoull(text + strlen("event="), &end, 0);
+   return end != text + strlen("event=");
+}
+
+static bool CPUFreqCounters_findPmu(void) {
+   char text[32];
+   if (FsRoot_readFile(&FsRoot_sys, CPUFREQ_PMU_DIR "/type", text, sizeof(text)) <= 0)
+      return false;
+
+   CPUFreqCounters_pmuType = (uint32_t)strtoul(text, NULL, 10);
+   return CPUFreqCounters_pmuEvent("tsc", &CPUFreqCounters_configs[CPUFREQ_TSC]) &&
+          CPUFreqCounters_pmuEvent("aperf", &CPUFreqCounters_configs[CPUFREQ_APERF]) &&
+          CPUFreqCounters_pmuEvent("mperf", &CPUFreqCounters_configs[CPUFREQ_MPERF]);
+}
+
+static int CPUFreqCounters_openEvent(unsigned int cpu, CPUFreqCounter counter, int groupFd) {
+   struct perf_event_attr attr;
+   memset(&attr, 0, sizeof(attr));
+   attr.size = sizeof(attr);
+   attr.type = CPUFreqCounters_pmuType;
+   attr.config = CPUFreqCounters_configs[counter];
+   attr.read_format = PERF_FORMAT_GROUP;
+
+   int fd = (int)syscall(SYS_perf_event_open, &attr, -1, (int)cpu, groupFd, PERF_FLAG_FD_CLOEXEC);
+   return CPUFreqCounters_highFd(fd);
+}
+
+static bool CPUFreqCounters_openPerf(CPUFreqCPU* c, unsigned int cpu) {
+   c->fds[CPUFREQ_TSC] = CPUFreqCounters_openEvent(cpu, CPUFREQ_TSC, -1);
+   if (c->fds[CPUFREQ_TSC] < 0)
+      return false;
+
+   c->fds[CPUFREQ_APERF] = CPUFreqCounters_openEvent(cpu, CPUFREQ_APERF, c->fds[CPUFREQ_TSC]);
+   c->fds[CPUFREQ_MPERF] = CPUFreqCounters_openEvent(cpu, CPUFREQ_MPERF, c->fds[CPUFREQ_TSC]);
+   return c->fds[CPUFREQ_APERF] >= 0 && c->fds[CPUFREQ_MPERF] >= 0;
+}
+
+static bool CPUFreqCounters_readPerf(const CPUFreqCPU* c, uint64_t* values) {
+   /* nr, then one value per member */
+   uint64_t buffer[1 + CPUFREQ_COUNTERS];
+   if (read(c->fds[CPUFREQ_TSC], buffer, sizeof(buffer)) != (ssize_t)sizeof(buffer) || buffer[0] != CPUFREQ_COUNTERS)
+      return false;
+
+   for (int i = 0; i < CPUFREQ_COUNTERS; i++)
+      values[i] = buffer[1 + i];
+   return true;
+}
+
+#endif /* HAVE_PERF_EVENTS */
+
+static bool CPUFreqCounters_openMsr(CPUFreqCPU* c, unsigned int cpu) {
+   char path[64];
+   xSnprintf(path, sizeof(path), "/dev/cpu/%u/msr", cpu);
+   c->fds[0] = CPUFreqCounters_highFd(open(path, O_RDONLY | O_CLOEXEC));
+   return c->fds[0] >= 0;
+}
+
+static bool CPUFreqCounters_readMsr(const CPUFreqCPU* c, uint64_t* values) {
+   static const off_t registers[CPUFREQ_COUNTERS] = {
+      [CPUFREQ_TSC] = CPUFREQ_MSR_TSC,
+      [CPUFREQ_APERF] = CPUFREQ_MSR_APERF,
+      [CPUFREQ_MPERF] = CPUFREQ_MSR_MPERF,
+   };
+
+   for (int i = 0; i < CPUFREQ_COUNTERS; i++) {
+      if (pread(c->fds[0], &values[i], sizeof(values[i]), registers[i]) != (ssize_t)sizeof(values[i]))
+         return false;
+   }
+   return true;
+}
+
+static void CPUFreqCounters_closeCPU(CPUFreqCPU* c) {
+   /* members first, the leader holds the group together */
+   for (int i = CPUFREQ_COUNTERS - 1; i >= 0; i--) {
+      if (c->fds[i] >= 0)
+         close(c->fds[i]);
+      c->fds[i] = -1;
+   }
+   c->haveLast = false;
+   c->mhz = NAN;
+}
+
+static bool CPUFreqCounters_openCPU(CPUFreqCPU* c, unsigned int cpu) {
+   bool ok = false;
+   #ifdef HAVE_PERF_EVENTS
+   if (CPUFreqCounters_backend == CPUFREQ_PERF)
+      ok = CPUFreqCounters_openPerf(c, cpu);
+   #endif
+   if (CPUFreqCounters_backend == CPUFREQ_MSR)
+      ok = CPUFreqCounters_openMsr(c, cpu);
+
+   if (!ok)
+      CPUFreqCounters_closeCPU(c);
+   return ok;
+}
+
+static bool CPUFreqCounters_readCPU(const CPUFreqCPU* c, uint64_t* values) {
+   #ifdef HAVE_PERF_EVENTS
+   if (CPUFreqCounters_backend == CPUFREQ_PERF)
+      return CPUFreqCounters_readPerf(c, values);
+   #endif
+   return CPUFreqCounters_readMsr(c, values);
+}
+
+static void CPUFreqCounters_allocate(unsigned int count) {
+   CPUFreqCounters_cpus = xReallocArray(CPUFreqCounters_cpus, count, sizeof(CPUFreqCPU));
+   for (unsigned int i = CPUFreqCounters_count; i < count; i++) {
+      CPUFreqCPU* c = &CPUFreqCounters_cpus[i];
+      *c = (CPUFreqCPU) { .mhz = NAN };
+      for (int j = 0; j < CPUFREQ_COUNTERS; j++)
+         c->fds[j] = -1;
+   }
+   CPUFreqCounters_count = count;
+}
+
+/* The first online CPU that opens tells which way works; none if neither does */
+static void CPUFreqCounters_chooseBackend(const Machine* host) {
+   unsigned int first = 0;
+   while (first < host->existingCPUs && !Machine_isCPUonline(host, first))
+      first++;
+
+   CPUFreqCounters_backend = CPUFREQ_NONE;
+   if (first == host->existingCPUs)
+      return;
+
+   #ifdef HAVE_PERF_EVENTS
+   if (CPUFreqCounters_fdsAvailable(CPUFREQ_COUNTERS * host->existingCPUs) && CPUFreqCounters_findPmu()) {
+      CPUFreqCounters_backend = CPUFREQ_PERF;
+      if (CPUFreqCounters_openCPU(&CPUFreqCounters_cpus[first], first))
+         return;
+   }
+   #endif
+
+   if (CPUFreqCounters_fdsAvailable(host->existingCPUs)) {
+      CPUFreqCounters_backend = CPUFREQ_MSR;
+      if (CPUFreqCounters_openCPU(&CPUFreqCounters_cpus[first], first))
+         return;
+   }
+
+   CPUFreqCounters_backend = CPUFREQ_NONE;
+}
+
+bool CPUFreqCounters_refresh(const Machine* host) {
+   if (CPUFreqCounters_backend == CPUFREQ_NONE)
+      return false;
+
+   if (CPUFreqCounters_count < host->existingCPUs)
+      CPUFreqCounters_allocate(host->existingCPUs);
+
+   if (CPUFreqCounters_backend == CPUFREQ_UNKNOWN) {
+      CPUFreqCounters_chooseBackend(host);
+      if (CPUFreqCounters_backend == CPUFREQ_NONE)
+         return false;
+   }
+
+   bool known = false;
+   for (unsigned int i = 0; i < host->existingCPUs; i++) {
+      CPUFreqCPU* c = &CPUFreqCounters_cpus[i];
+      c->mhz = NAN;
+
+      if (!Machine_isCPUonline(host, i)) {
+         if (c->fds[0] >= 0)
+            CPUFreqCounters_closeCPU(c);
+         c->tried = false;
+         continue;
+      }
+
+      if (c->fds[0] < 0) {
+         if (c->tried)
+            continue;
+         c->tried = true;
+         if (!CPUFreqCounters_openCPU(c, i))
+            continue;
+      }
+
+      uint64_t values[CPUFREQ_COUNTERS];
+      if (!CPUFreqCounters_readCPU(c, values)) {
+         CPUFreqCounters_closeCPU(c);
+         continue;
+      }
+
+      const uint64_t nowUs = CPUFreqCounters_nowUs();
+      if (c->haveLast && nowUs > c->lastUs) {
+         const uint64_t tsc = values[CPUFREQ_TSC] - c->last[CPUFREQ_TSC];
+         const uint64_t aperf = values[CPUFREQ_APERF] - c->last[CPUFREQ_APERF];
+         const uint64_t mperf = values[CPUFREQ_MPERF] - c->last[CPUFREQ_MPERF];
+
+         /* MPERF ticks at the rate of the TSC, in MHz the TSC ticks per microsecond */
+         if (mperf > 0) {
+            c->mhz = (double)tsc / (double)(nowUs - c->lastUs) * ((double)aperf / (double)mperf);
+            known = true;
+         }
+      }
+
+      memcpy(c->last, values, sizeof(c->last));
+      c->lastUs = nowUs;
+      c->haveLast = true;
+   }
+
+   return known;
+}
+
+double CPUFreqCounters_mhz(unsigned int cpu) {
+   return cpu < CPUFreqCounters_count ? CPUFreqCounters_cpus[cpu].mhz : NAN;
+}
+
+void CPUFreqCounters_close(void) {
+   for (unsigned int i = 0; i < CPUFreqCounters_count; i++)
+      CPUFreqCounters_closeCPU(&CPUFreqCounters_cpus[i]);
+
+   free(CPUFreqCounters_cpus);
+   CPUFreqCounters_cpus = NULL;
+   CPUFreqCounters_count = 0;
+
+   /* a backend known not to work stays so */
+   if (CPUFreqCounters_backend != CPUFREQ_NONE)
+      CPUFreqCounters_backend = CPUFREQ_UNKNOWN;
+}
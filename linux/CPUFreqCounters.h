@@ -0,0 +1,38 @@
+#ifndef HEADER_CPUFreqCounters
+#define HEADER_CPUFreqCounters
+/*
+htop - linux/CPUFreqCounters.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+
+#include "Machine.h"
+
+
+/*
+ * The frequency the CPUs delivered while busy, averaged over the interval,
+ * from their APERF and MPERF counters: APERF counts at the frequency the
+ * CPU runs at, MPERF at the constant one of the TSC, both only while the CPU
+ * is not idle. cpufreq's scaling_cur_freq and /proc/cpuinfo tell what was
+ * asked for at one moment instead. The counters are read through the msr
+ * PMU of perf (CAP_PERFMON or perf_event_paranoid 0 or less) or else
+ * /dev/cpu/<N>/msr (root and the msr module); x86 only.
+ */
+
+/*
+ * Reads the counters of the online CPUs, opening them on the first call.
+ * False while no frequency is known: before the second read, or without
+ * access to the counters, which is not tried again then.
+ */
+bool CPUFreqCounters_refresh(const Machine* host);
+
+/* MHz of the CPU (from 0) over the last interval, NAN if unknown or it was idle all along */
+double CPUFreqCounters_mhz(unsigned int cpu);
+
+/* Closes the counters while no frequency is shown */
+void CPUFreqCounters_close(void);
+
+#endif
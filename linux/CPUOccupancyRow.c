@@ -0,0 +1,218 @@
+/*
+htop - linux/CPUOccupancyRow.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/CPUOccupancyRow.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "CRT.h"
+#include "DynamicColumn.h"
+#include "Macros.h"
+#include "RichString.h"
+#include "Settings.h"
+#include "Table.h"
+#include "XUtils.h"
+
+
+typedef struct CPUOccupancyFieldData_ {
+   const char* name;          /* stored in htoprc as Dynamic(name) */
+   const char* heading;
+   const char* description;
+   int width;                 /* as in DynamicColumn, without the trailing space */
+} CPUOccupancyFieldData;
+
+static const CPUOccupancyFieldData CPUOccupancyRow_fields[LAST_CPUOCCUPANCY_FIELD] = {
+   [CPUOCCUPANCY_FIELD_TID] = { .name = "occupancy_tid", .heading = "TID", .description = "Thread ID of the task", .width = 7, },
+   [CPUOCCUPANCY_FIELD_COMMAND] = { .name = "occupancy_command", .heading = "COMMAND", .description = "Name of the task", .width = -16, },
+   [CPUOCCUPANCY_FIELD_CPU] = { .name = "occupancy_cpu", .heading = "CPU%", .description = "CPU usage of the task averaged over the scans of the grid", .width = 5, },
+   [CPUOCCUPANCY_FIELD_MIGRATIONS] = { .name = "occupancy_migrations", .heading = "MIGR/s", .description = "Changes of the CPU the task runs on per second, as seen between scans", .width = 6, },
+   [CPUOCCUPANCY_FIELD_NVCSW] = { .name = "occupancy_nvcsw", .heading = "NVCSW/s", .description = "Involuntary context switches of the task per second", .width = 7, },
+   [CPUOCCUPANCY_FIELD_GRID] = { .name = "occupancy_grid", .heading = "CPUS", .description = "CPUs the task ran on in the last scans, darker for more usage", .width = -8, },
+};
+
+/* From least to most usage of the CPUs of a cell */
+static const char CPUOccupancyRow_levels[] = ".:-=+*#%@";
+
+CPUOccupancyRow* CPUOccupancyRow_new(const Machine* host) {
+   CPUOccupancyRow* this = xCalloc(1, sizeof(CPUOccupancyRow));
+   Object_setClass(this, Class(CPUOccupancyRow));
+   Row_init(&this->super, host);
+   this->migrationRate = NAN;
+   this->nvcswRate = NAN;
+   return this;
+}
+
+static void CPUOccupancyRow_delete(Object* cast) {
+   CPUOccupancyRow* this = (CPUOccupancyRow*) cast;
+   Row_done(&this->super);
+   free(this);
+}
+
+void CPUOccupancyRow_addSample(CPUOccupancyRow* this, int cpu) {
+   const float percent = isNonnegative(this->percent) ? MINIMUM(this->percent, 100.0F) : 0.0F;
+
+   this->cpu[this->next] = (uint16_t)MAXIMUM(cpu, 0);
+   this->usage[this->next] = (uint8_t)lroundf(percent);
+   this->next = (this->next + 1) % CPU_OCCUPANCY_SAMPLES;
+   if (this->samples < CPU_OCCUPANCY_SAMPLES)
+      this->samples++;
+
+   unsigned int total = 0;
+   for (unsigned int i = 0; i < this->samples; i++)
+      total += this->usage[i];
+   this->average = (float)total / (float)this->samples;
+}
+
+unsigned int CPUOccupancyRow_cells(const Machine* host) {
+   return CLAMP(host->existingCPUs, 1, CPU_OCCUPANCY_MAX_CELLS);
+}
+
+static void CPUOccupancyRow_writeGrid(const CPUOccupancyRow* this, RichString* str) {
+   const Machine* host = this->super.host;
+   const unsigned int cells = CPUOccupancyRow_cells(host);
+   const unsigned int cpus = MAXIMUM(host->existingCPUs, 1);
+
+   unsigned int usage[CPU_OCCUPANCY_MAX_CELLS] = { 0 };
+   for (unsigned int i = 0; i < this->samples; i++) {
+      const unsigned int cell = MINIMUM(this->cpu[i], cpus - 1) * cells / cpus;
+      usage[cell] += this->usage[i];
+   }
+
+   for (unsigned int cell = 0; cell < cells; cell++) {
+      /* percent of one CPU over the samples */
+      const unsigned int percent = usage[cell] / this->samples;
+      if (usage[cell] == 0) {
+         RichString_appendChr(str, CRT_colors[PROCESS_SHADOW], ' ', 1);
+         continue;
+      }
+
+      const size_t level = MINIMUM(percent * (sizeof(CPUOccupancyRow_levels) - 1) / 100, sizeof(CPUOccupancyRow_levels) - 2);
+      const int attr = percent >= 50 ? CRT_colors[LARGE_NUMBER] : percent >= 10 ? CRT_colors[DEFAULT_COLOR] : CRT_colors[PROCESS_SHADOW];
+      RichString_appendChr(str, attr, CPUOccupancyRow_levels[level], 1);
+   }
+
+   for (unsigned int i = cells; i < 8; i++)
+      RichString_appendChr(str, CRT_colors[DEFAULT_COLOR], ' ', 1);
+   RichString_appendChr(str, CRT_colors[DEFAULT_COLOR], ' ', 1);
+}
+
+static void CPUOccupancyRow_printRate(double rate, char* buffer, size_t n, int width, int* attr) {
+   if (isnan(rate)) {
+      *attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, "%*s ", width, "N/A");
+      return;
+   }
+
+   if (rate < 0.05)
+      *attr = CRT_colors[PROCESS_SHADOW];
+   xSnprintf(buffer, n, rate < 1000.0 ? "%*.1f " : "%*.0f ", width, rate);
+}
+
+static void CPUOccupancyRow_writeField(const Row* super, RichString* str, RowField field) {
+   const CPUOccupancyRow* this = (const CPUOccupancyRow*) super;
+   char buffer[256];
+   size_t n = sizeof(buffer);
+   int attr = CRT_colors[DEFAULT_COLOR];
+
+   switch ((int)field - CPUOccupancyField_key(0)) {
+   case CPUOCCUPANCY_FIELD_TID: xSnprintf(buffer, n, "%7d ", super->id); break;
+   case CPUOCCUPANCY_FIELD_COMMAND:
+      Row_printLeftAlignedField(str, attr, this->command, 16);
+      return;
+   case CPUOCCUPANCY_FIELD_CPU:
+      Row_printPercentage(this->average, buffer, n, 5, &attr);
+      break;
+   case CPUOCCUPANCY_FIELD_MIGRATIONS: CPUOccupancyRow_printRate(this->migrationRate, buffer, n, 6, &attr); break;
+   case CPUOCCUPANCY_FIELD_NVCSW: CPUOccupancyRow_printRate(this->nvcswRate, buffer, n, 7, &attr); break;
+   case CPUOCCUPANCY_FIELD_GRID:
+      CPUOccupancyRow_writeGrid(this, str);
+      return;
+   default:
+      assert(0 && "CPUOccupancyRow_writeField: default key reached"); /* should never be reached */
+      xSnprintf(buffer, n, "- ");
+      break;
+   }
+
+   RichString_appendAscii(str, attr, buffer);
+}
+
+static int CPUOccupancyRow_compareByKey(const CPUOccupancyRow* r1, const CPUOccupancyRow* r2, RowField key) {
+   switch ((int)key - CPUOccupancyField_key(0)) {
+   case CPUOCCUPANCY_FIELD_TID:
+      return SPACESHIP_NUMBER(r1->super.id, r2->super.id);
+   case CPUOCCUPANCY_FIELD_COMMAND:
+      return SPACESHIP_NULLSTR(r1->command, r2->command);
+   case CPUOCCUPANCY_FIELD_CPU:
+      return SPACESHIP_NUMBER(r1->average, r2->average);
+   case CPUOCCUPANCY_FIELD_MIGRATIONS:
+      return compareRealNumbers(r1->migrationRate, r2->migrationRate);
+   case CPUOCCUPANCY_FIELD_NVCSW:
+      return compareRealNumbers(r1->nvcswRate, r2->nvcswRate);
+   case CPUOCCUPANCY_FIELD_GRID: {
+      /* by the CPU last run on */
+      const unsigned int last1 = r1->samples ? r1->cpu[(r1->next + CPU_OCCUPANCY_SAMPLES - 1) % CPU_OCCUPANCY_SAMPLES] : 0;
+      const unsigned int last2 = r2->samples ? r2->cpu[(r2->next + CPU_OCCUPANCY_SAMPLES - 1) % CPU_OCCUPANCY_SAMPLES] : 0;
+      return SPACESHIP_NUMBER(last1, last2);
+   }
+   default:
+      return 0;
+   }
+}
+
+static int CPUOccupancyRow_compare(const void* v1, const void* v2) {
+   const CPUOccupancyRow* r1 = (const CPUOccupancyRow*)v1;
+   const CPUOccupancyRow* r2 = (const CPUOccupancyRow*)v2;
+   const ScreenSettings* ss = r1->super.host->settings->ss;
+   RowField key = ScreenSettings_getActiveSortKey(ss);
+   int result = CPUOccupancyRow_compareByKey(r1, r2, key);
+
+   // Implement tie-breaker (keeps the order of equal tasks across updates)
+   if (!result)
+      return SPACESHIP_NUMBER(r1->super.id, r2->super.id);
+
+   return (ScreenSettings_getActiveDirection(ss) == 1) ? result : -result;
+}
+
+static const char* CPUOccupancyRow_sortKeyString(Row* super) {
+   const CPUOccupancyRow* this = (const CPUOccupancyRow*) super;
+   return this->command;
+}
+
+static bool CPUOccupancyRow_matchesFilter(Row* super, const Table* table) {
+   const CPUOccupancyRow* this = (const CPUOccupancyRow*) super;
+   return !FilterMatcher_matches(&table->filter, this->command);
+}
+
+void CPUOccupancyRow_addColumns(Hashtable* columns) {
+   for (int i = 0; i < LAST_CPUOCCUPANCY_FIELD; i++) {
+      const CPUOccupancyFieldData* data = &CPUOccupancyRow_fields[i];
+      DynamicColumn* column = xCalloc(1, sizeof(DynamicColumn));
+      String_safeStrncpy(column->name, data->name, sizeof(column->name));
+      column->heading = xStrdup(data->heading);
+      column->caption = xStrdup(data->heading);
+      column->description = xStrdup(data->description);
+      column->width = data->width;
+      column->enabled = true;
+      Hashtable_put(columns, CPUOccupancyField_key(i), column);
+   }
+}
+
+const RowClass CPUOccupancyRow_class = {
+   .super = {
+      .extends = Class(Row),
+      .display = Row_display,
+      .delete = CPUOccupancyRow_delete,
+      .compare = CPUOccupancyRow_compare,
+   },
+   .writeField = CPUOccupancyRow_writeField,
+   .matchesFilter = CPUOccupancyRow_matchesFilter,
+   .sortKeyString = CPUOccupancyRow_sortKeyString,
+};
@@ -0,0 +1,71 @@
+#ifndef HEADER_CPUOccupancyRow
+#define HEADER_CPUOccupancyRow
+/*
+htop - linux/CPUOccupancyRow.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "Hashtable.h"
+#include "Machine.h"
+#include "Object.h"
+#include "Row.h"
+#include "RowField.h"
+#include "linux/WaitChannelRow.h"
+
+
+/* Columns of the CPU occupancy screen, keyed after the ones of the wait channel screen */
+typedef enum CPUOccupancyField_ {
+   CPUOCCUPANCY_FIELD_TID,
+   CPUOCCUPANCY_FIELD_COMMAND,
+   CPUOCCUPANCY_FIELD_CPU,
+   CPUOCCUPANCY_FIELD_MIGRATIONS,
+   CPUOCCUPANCY_FIELD_NVCSW,
+   CPUOCCUPANCY_FIELD_GRID,
+   LAST_CPUOCCUPANCY_FIELD
+} CPUOccupancyField;
+
+#define CPUOccupancyField_key(f_)  ((RowField)(WaitChannelField_key(LAST_WAITCHANNEL_FIELD) + (f_)))
+
+/* Scans remembered for each task, the grid shows where it ran over them */
+#define CPU_OCCUPANCY_SAMPLES 16
+
+/* Most cells of the grid, CPUs are binned together beyond it */
+#define CPU_OCCUPANCY_MAX_CELLS 64
+
+/* One task with the CPUs it was last seen on */
+typedef struct CPUOccupancyRow_ {
+   Row super;
+
+   char command[32];
+   double migrationRate;
+   double nvcswRate;
+
+   float percent;                  /* CPU usage in the scan being read, of the main thread for processes */
+   float average;                  /* CPU usage over the samples */
+
+   uint16_t cpu[CPU_OCCUPANCY_SAMPLES];
+   uint8_t usage[CPU_OCCUPANCY_SAMPLES];
+   unsigned int samples;
+   unsigned int next;
+} CPUOccupancyRow;
+
+extern const RowClass CPUOccupancyRow_class;
+
+CPUOccupancyRow* CPUOccupancyRow_new(const Machine* host);
+
+/* Remembers the CPU the task ran on in the latest scan, with its usage */
+void CPUOccupancyRow_addSample(CPUOccupancyRow* this, int cpu);
+
+/* Cells of the grid for the CPUs of the machine */
+unsigned int CPUOccupancyRow_cells(const Machine* host);
+
+/* Adds the dynamic columns of the CPU occupancy screen to `columns` */
+void CPUOccupancyRow_addColumns(Hashtable* columns);
+
+#endif
@@ -0,0 +1,112 @@
+/*
+htop - linux/CPUOccupancyTable.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/CPUOccupancyTable.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "Macros.h"
+#include "Object.h"
+#include "Process.h"
+#include "Rate.h"
+#include "Row.h"
+#include "Vector.h"
+#include "XUtils.h"
+
+#include "linux/CPUOccupancyRow.h"
+#include "linux/LinuxProcess.h"
+
+
+/* Tasks whose CPU usage averages less than this over the samples are not listed */
+#define CPU_OCCUPANCY_MIN_PERCENT 0.5F
+
+CPUOccupancyTable* CPUOccupancyTable_new(Machine* host) {
+   CPUOccupancyTable* this = xCalloc(1, sizeof(CPUOccupancyTable));
+   Object_setClass(this, Class(CPUOccupancyTable));
+   Table_init(&this->super, Class(CPUOccupancyRow), host);
+   return this;
+}
+
+static void CPUOccupancyTable_delete(Object* cast) {
+   CPUOccupancyTable* this = (CPUOccupancyTable*) cast;
+   Table_done(&this->super);
+   free(this);
+}
+
+static void CPUOccupancyTable_iterateEntries(Table* super) {
+   Machine* host = super->host;
+   const Table* processTable = host->processTable;
+   if (!processTable)
+      return;
+
+   const Vector* processes = processTable->rows;
+
+   /* the tasks of the latest scan, the row of a process stands for its main thread */
+   for (int i = 0; i < Vector_size(processes); i++) {
+      const Process* proc = (const Process*) Vector_get(processes, i);
+      if (proc->super.tombStampMs > 0 || !Table_isUpdated(processTable, &proc->super))
+         continue;
+
+      const int id = Process_getPid(proc);
+      CPUOccupancyRow* row = (CPUOccupancyRow*) Table_findRow(super, id);
+      if (row) {
+         row->super.tombStampMs = 0;
+      } else {
+         row = CPUOccupancyRow_new(host);
+         row->super.id = id;
+         row->super.group = id;
+         Table_add(super, &row->super);
+      }
+
+      /* neither is known for a process recorded without a command */
+      const char* command = proc->procComm ? proc->procComm : Process_getCommand(proc);
+      if (command)
+         String_safeStrncpy(row->command, command, sizeof(row->command));
+      else
+         row->command[0] = '\0';
+      row->percent = proc->percent_cpu;
+
+      const LinuxProcessDetails* details = LinuxProcess_getDetails((const LinuxProcess*) proc);
+      row->migrationRate = details ? Rate_value(&details->migration_rate) : NAN;
+      row->nvcswRate = details ? Rate_value(&details->nvcsw_rate) : NAN;
+      Table_markUpdated(super, &row->super);
+   }
+
+   /* the usage of a process includes the one of its other threads */
+   for (int i = 0; i < Vector_size(processes); i++) {
+      const Process* proc = (const Process*) Vector_get(processes, i);
+      if (!Process_isUserlandThread(proc) || proc->super.tombStampMs > 0 || !Table_isUpdated(processTable, &proc->super) || !isNonnegative(proc->percent_cpu))
+         continue;
+
+      CPUOccupancyRow* main = (CPUOccupancyRow*) Table_findRow(super, Process_getThreadGroup(proc));
+      if (main && Table_isUpdated(super, &main->super) && isNonnegative(main->percent))
+         main->percent = MAXIMUM(main->percent - proc->percent_cpu, 0.0F);
+   }
+
+   for (int i = 0; i < Vector_size(processes); i++) {
+      const Process* proc = (const Process*) Vector_get(processes, i);
+      CPUOccupancyRow* row = (CPUOccupancyRow*) Table_findRow(super, Process_getPid(proc));
+      if (!row || !Table_isUpdated(super, &row->super) || !Table_isUpdated(processTable, &proc->super))
+         continue;
+
+      CPUOccupancyRow_addSample(row, proc->processor);
+      row->super.show = row->average >= CPU_OCCUPANCY_MIN_PERCENT;
+   }
+}
+
+const TableClass CPUOccupancyTable_class = {
+   .super = {
+      .extends = Class(Table),
+      .delete = CPUOccupancyTable_delete,
+   },
+   .prepare = Table_prepareEntries,
+   .iterate = CPUOccupancyTable_iterateEntries,
+   .cleanup = Table_cleanupEntries,
+};
@@ -0,0 +1,23 @@
+#ifndef HEADER_CPUOccupancyTable
+#define HEADER_CPUOccupancyTable
+/*
+htop - linux/CPUOccupancyTable.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "Machine.h"
+#include "Table.h"
+
+
+/* One row per task of the process table that used the CPU lately, with the CPUs it ran on */
+typedef struct CPUOccupancyTable_ {
+   Table super;
+} CPUOccupancyTable;
+
+extern const TableClass CPUOccupancyTable_class;
+
+CPUOccupancyTable* CPUOccupancyTable_new(Machine* host);
+
+#endif
@@ -0,0 +1,134 @@
+/*
+htop - linux/CPUThrottleMeter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/CPUThrottleMeter.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CRT.h"
+#include "Machine.h"
+#include "Macros.h"
+#include "Object.h"
+#include "RichString.h"
+#include "XUtils.h"
+
+#include "linux/CGroupScope.h"
+#include "linux/CGroupTable.h"
+#include "linux/CGroupThrottle.h"
+#include "linux/FsRoot.h"
+
+
+typedef struct CPUThrottleMeterData_ {
+   const char* root;          /* of the v2 hierarchy, NULL if it is not mounted */
+   char* path;                /* of the cgroup shown, NULL if unknown */
+   CGroupThrottle throttle;
+} CPUThrottleMeterData;
+
+static const int CPUThrottleMeter_attributes[] = {
+   METER_VALUE_WARN,
+};
+
+/* The cgroup given with --cgroup, else the one of htop itself from the "0::" line of /proc/self/cgroup */
+static char* CPUThrottleMeter_findPath(void) {
+   if (CGroupScope_path)
+      return xStrdup(CGroupScope_path);
+
+   char buffer[4096];
+   if (FsRoot_readFile(&FsRoot_proc, "self/cgroup", buffer, sizeof(buffer)) <= 0)
+      return NULL;
+
+   for (const char* line = buffer; line; line = strchr(line, '\n')) {
+      if (*line == '\n')
+         line++;
+      if (String_startsWith(line, "0::")) {
+         line += strlen("0::");
+         return xStrndup(line, (size_t)(String_strchrnul(line, '\n') - line));
+      }
+   }
+   return NULL;
+}
+
+static void CPUThrottleMeter_init(Meter* this) {
+   if (this->meterData)
+      return;
+
+   CPUThrottleMeterData* data = this->meterData = xCalloc(1, sizeof(CPUThrottleMeterData));
+   data->root = CGroupTable_findRoot();
+   data->path = data->root ? CPUThrottleMeter_findPath() : NULL;
+}
+
+static void CPUThrottleMeter_updateValues(Meter* this) {
+   CPUThrottleMeterData* data = this->meterData;
+
+   this->curItems = 1;
+   this->values[0] = NAN;
+
+   if (!data->path) {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "no cgroup");
+      return;
+   }
+
+   CGroupThrottle_update(&data->throttle, data->root, data->path, this->host->monotonicMs);
+
+   const float percent = CGroupThrottle_percent(&data->throttle);
+   const double periods = CGroupThrottle_periodRate(&data->throttle);
+   if (isnan(percent) || isnan(periods)) {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "N/A");
+      return;
+   }
+
+   this->values[0] = percent;
+   xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "%.1f%% %.1f/s", percent, periods);
+}
+
+static void CPUThrottleMeter_display(const Object* cast, RichString* out) {
+   const Meter* this = (const Meter*)cast;
+   const CPUThrottleMeterData* data = this->meterData;
+
+   if (isnan(this->values[0])) {
+      RichString_appendAscii(out, CRT_colors[METER_VALUE_NOTICE], this->txtBuffer);
+      return;
+   }
+
+   const double periods = CGroupThrottle_periodRate(&data->throttle);
+   char buffer[32];
+   int len = xSnprintf(buffer, sizeof(buffer), "%.1f%%", this->values[0]);
+   RichString_appendnAscii(out, CRT_colors[this->values[0] > 0.0 ? METER_VALUE_WARN : METER_VALUE], buffer, len);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " time, ");
+   len = xSnprintf(buffer, sizeof(buffer), "%.1f", periods);
+   RichString_appendnAscii(out, CRT_colors[periods > 0.0 ? METER_VALUE_WARN : METER_VALUE], buffer, len);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " periods/s");
+}
+
+static void CPUThrottleMeter_done(Meter* this) {
+   CPUThrottleMeterData* data = this->meterData;
+   free(data->path);
+   free(data);
+}
+
+const MeterClass CPUThrottleMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = CPUThrottleMeter_display,
+   },
+   .updateValues = CPUThrottleMeter_updateValues,
+   .defaultMode = TEXT_METERMODE,
+   .maxItems = 1,
+   .total = 100.0,
+   .attributes = CPUThrottleMeter_attributes,
+   .name = "CPUThrottle",
+   .uiName = "CPU throttling",
+   .caption = "Throttled: ",
+   .description = "CPU throttling: time and periods the cgroup of htop (or the one of --cgroup) was held back by its cpu.max quota",
+   .init = CPUThrottleMeter_init,
+   .done = CPUThrottleMeter_done,
+};
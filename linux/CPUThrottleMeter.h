@@ -0,0 +1,15 @@
+#ifndef HEADER_CPUThrottleMeter
+#define HEADER_CPUThrottleMeter
+/*
+htop - linux/CPUThrottleMeter.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "Meter.h"
+
+
+extern const MeterClass CPUThrottleMeter_class;
+
+#endif
@@ -0,0 +1,135 @@
+/*
+htop - linux/ChurnScreen.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/ChurnScreen.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "LineStore.h"
+#include "Macros.h"
+#include "Panel.h"
+#include "ProvideCurses.h"
+#include "XUtils.h"
+
+#include "linux/ProcessChurn.h"
+
+
+#define CHURNSCREEN_HEADER "  EXEC/s  COUNT    PPID PARENT          COMMAND"
+
+/* Execs of one command under one parent */
+typedef struct ChurnPair_ {
+   const ChurnExec* exec;
+   unsigned int count;
+} ChurnPair;
+
+ChurnScreen* ChurnScreen_new(void) {
+   ChurnScreen* this = xMalloc(sizeof(ChurnScreen));
+   Object_setClass(this, Class(ChurnScreen));
+   return (ChurnScreen*) InfoScreen_init(&this->super, NULL, NULL, LINES - 2, CHURNSCREEN_HEADER);
+}
+
+void ChurnScreen_delete(Object* this) {
+   free(InfoScreen_done((InfoScreen*)this));
+}
+
+static void ChurnScreen_draw(InfoScreen* this) {
+   const ChurnRates* rates = ProcessChurn_rates();
+   InfoScreen_drawTitled(this, "Commands exec'd most in the last minute, by parent (%s)",
+                         rates->fromEvents ? "from process events" : "from scans, execs of new processes only");
+}
+
+static int ChurnScreen_comparePair(const ChurnExec* a, const ChurnExec* b) {
+   if (a->ppid != b->ppid)
+      return a->ppid < b->ppid ? -1 : 1;
+
+   int result = strcmp(a->comm, b->comm);
+   return result ? result : strcmp(a->parentComm, b->parentComm);
+}
+
+static int ChurnScreen_compareExecs(const void* v1, const void* v2) {
+   return ChurnScreen_comparePair(*(const ChurnExec* const*)v1, *(const ChurnExec* const*)v2);
+}
+
+static int ChurnScreen_compareCounts(const void* v1, const void* v2) {
+   const ChurnPair* a = v1;
+   const ChurnPair* b = v2;
+   if (a->count != b->count)
+      return a->count > b->count ? -1 : 1;
+
+   return ChurnScreen_comparePair(a->exec, b->exec);
+}
+
+static void ChurnScreen_scan(InfoScreen* this) {
+   Panel* panel = this->display;
+   int idx = MAXIMUM(Panel_getSelectedIndex(panel), 0);
+
+   Panel_prune(panel);
+
+   const uint64_t nowMs = ProcessChurn_lastMs();
+   const size_t count = ProcessChurn_execCount();
+   if (count == 0) {
+      InfoScreen_addLine(this, "No exec seen in the last minute.");
+      Panel_setSelected(panel, idx);
+      return;
+   }
+
+   const ChurnExec** execs = xMallocArray(count, sizeof(const ChurnExec*));
+   for (size_t i = 0; i < count; i++)
+      execs[i] = ProcessChurn_exec(i);
+
+   /* the rates are over the time the kept execs span, less than a minute while they fill the ring */
+   uint64_t startMs = nowMs > CHURN_WINDOW_MS ? nowMs - CHURN_WINDOW_MS : 0;
+   startMs = MAXIMUM(startMs, ProcessChurn_sinceMs());
+   if (count == CHURN_RING_SIZE)
+      startMs = MAXIMUM(startMs, execs[0]->ms);
+   const double seconds = MAXIMUM((double)(nowMs - startMs) / 1000.0, 1.0);
+
+   qsort(execs, count, sizeof(const ChurnExec*), ChurnScreen_compareExecs);
+
+   ChurnPair* pairs = xMallocArray(count, sizeof(ChurnPair));
+   size_t pairCount = 0;
+   for (size_t i = 0; i < count; i++) {
+      if (pairCount > 0 && ChurnScreen_comparePair(pairs[pairCount - 1].exec, execs[i]) == 0) {
+         pairs[pairCount - 1].count++;
+         continue;
+      }
+      pairs[pairCount++] = (ChurnPair) { .exec = execs[i], .count = 1 };
+   }
+
+   qsort(pairs, pairCount, sizeof(ChurnPair), ChurnScreen_compareCounts);
+
+   for (size_t i = 0; i < pairCount; i++) {
+      const ChurnExec* exec = pairs[i].exec;
+      char line[128];
+      if (exec->ppid) {
+         xSnprintf(line, sizeof(line), "%8.2f %6u %7d %-15s %s",
+                   pairs[i].count / seconds, pairs[i].count, (int)exec->ppid, exec->parentComm, exec->comm);
+      } else {
+         xSnprintf(line, sizeof(line), "%8.2f %6u %7s %-15s %s",
+                   pairs[i].count / seconds, pairs[i].count, "-", "-", "(ended before it was read)");
+      }
+      InfoScreen_addLine(this, line);
+   }
+
+   free(pairs);
+   free(execs);
+
+   Panel_setSelected(panel, idx);
+}
+
+const InfoScreenClass ChurnScreen_class = {
+   .super = {
+      .extends = Class(Object),
+      .delete = ChurnScreen_delete
+   },
+   .scan = ChurnScreen_scan,
+   .draw = ChurnScreen_draw
+};
@@ -0,0 +1,25 @@
+#ifndef HEADER_ChurnScreen
+#define HEADER_ChurnScreen
+/*
+htop - linux/ChurnScreen.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "InfoScreen.h"
+#include "Object.h"
+
+
+/* The commands exec'd most over the last minute, by the parent they ran under */
+typedef struct ChurnScreen_ {
+   InfoScreen super;
+} ChurnScreen;
+
+extern const InfoScreenClass ChurnScreen_class;
+
+ChurnScreen* ChurnScreen_new(void);
+
+void ChurnScreen_delete(Object* this);
+
+#endif
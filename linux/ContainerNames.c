@@ -0,0 +1,529 @@
+/*
+htop - linux/ContainerNames.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/ContainerNames.h"
+
+#include <pwd.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+#include "Macros.h"
+#include "XUtils.h"
+#include "linux/CGroupUtils.h"
+
+
+/* The full IDs are 64 hex digits */
+#define CONTAINERNAMES_ID_MAX 64
+#define CONTAINERNAMES_NAME_MAX 256
+
+/* Metadata files larger than this are not read to their end */
+#define CONTAINERNAMES_METADATA_MAX (1024 * 1024)
+
+struct ContainerName_ {
+   char runtime[16];
+   char id[CONTAINERNAMES_ID_MAX + 1];
+   uint32_t hash;
+   char* label;               /* NULL until known */
+   size_t labelLen;
+   bool seen;                 /* a cgroup of this run is in it */
+};
+
+static ContainerName** ContainerNames_entries;
+static size_t ContainerNames_count;
+static size_t ContainerNames_alloc;
+
+static bool ContainerNames_enabled;
+static bool ContainerNames_loaded;
+static bool ContainerNames_changed;
+static char* ContainerNames_file;
+
+static uint32_t ContainerNames_hash(const char* runtime, const char* id) {
+   /* FNV-1a */
+   uint32_t hash = 2166136261U;
+   for (const char* c = runtime; *c; c++)
+      hash = (hash ^ (unsigned char)*c) * 16777619U;
+   for (const char* c = id; *c; c++)
+      hash = (hash ^ (unsigned char)*c) * 16777619U;
+   return hash;
+}
+
+static ContainerName* ContainerNames_find(const char* runtime, const char* id, uint32_t hash) {
+   for (size_t i = 0; i < ContainerNames_count; i++) {
+      ContainerName* entry = ContainerNames_entries[i];
+      if (entry->hash == hash && String_eq(entry->id, id) && String_eq(entry->runtime, runtime))
+         return entry;
+   }
+   return NULL;
+}
+
+static ContainerName* ContainerNames_add(const char* runtime, const char* id, uint32_t hash) {
+   if (ContainerNames_count == ContainerNames_alloc) {
+      ContainerNames_alloc = ContainerNames_alloc ? ContainerNames_alloc * 2 : 16;
+      ContainerNames_entries = xReallocArray(ContainerNames_entries, ContainerNames_alloc, sizeof(ContainerName*));
+   }
+
+   ContainerName* entry = xCalloc(1, sizeof(ContainerName));
+   String_safeStrncpy(entry->runtime, runtime, sizeof(entry->runtime));
+   String_safeStrncpy(entry->id, id, sizeof(entry->id));
+   entry->hash = hash;
+   ContainerNames_entries[ContainerNames_count++] = entry;
+   return entry;
+}
+
+static void ContainerNames_setName(ContainerName* entry, const char* name) {
+   free(entry->label);
+   entry->labelLen = (size_t)xAsprintf(&entry->label, "/%s:%s", entry->runtime, name);
+
+   /* names come from files of others: nothing for the terminal or the lines of the cache file */
+   for (char* c = entry->label; *c; c++)
+      if ((unsigned char)*c < 0x20 || *c == 0x7f)
+         *c = '?';
+}
+
+/*
+ * The string value of the first member named `key`, with the escapes of
+ * quotes and backslashes undone. Enough for the flat string members the
+ * names are in; the structure around them is not checked.
+ */
+static bool ContainerNames_jsonString(const char* json, const char* key, char* value, size_t size) {
+   const size_t keyLen = strlen(key);
+
+   for (const char* at = json; (at = strchr(at, '"')) != NULL; at++) {
+      if (strncmp(at + 1, key, keyLen) != 0 || at[keyLen + 1] != '"')
+         continue;
+
+      const char* c = at + keyLen + 2;
+      while (*c == ' ' || *c == '\t' || *c == '\n' || *c == '\r')
+         c++;
+      if (*c != ':')
+         continue;
+      c++;
+      while (*c == ' ' || *c == '\t' || *c == '\n' || *c == '\r')
+         c++;
+      if (*c != '"')
+         continue;
+      c++;
+
+      size_t len = 0;
+      for (; *c && *c != '"'; c++) {
+         if (*c == '\\' && c[1])
+            c++;
+         if (len + 1 < size)
+            value[len++] = *c;
+      }
+      if (!*c)
+         return false;
+
+      value[len] = '\0';
+      return len > 0;
+   }
+
+   return false;
+}
+
+/* Names of Kubernetes containers, from the annotations of their OCI spec */
+static bool ContainerNames_kubernetes(const char* json, const char* namespaceKey, const char* podKey, const char* containerKey, char* name, size_t size) {
+   char ns[CONTAINERNAMES_NAME_MAX];
+   char pod[CONTAINERNAMES_NAME_MAX];
+   char container[CONTAINERNAMES_NAME_MAX];
+
+   if (!ContainerNames_jsonString(json, podKey, pod, sizeof(pod)))
+      return false;
+
+   const char* namespace = ContainerNames_jsonString(json, namespaceKey, ns, sizeof(ns)) ? ns : "?";
+
+   /* the sandbox of a pod has no container name */
+   if (ContainerNames_jsonString(json, containerKey, container, sizeof(container)))
+      xSnprintf(name, size, "%s/%s/%s", namespace, pod, container);
+   else
+      xSnprintf(name, size, "%s/%s", namespace, pod);
+
+   return true;
+}
+
+/* Reads the metadata of a container, on the helper thread if there is one */
+static bool ContainerNames_read(const char* runtime, const char* id, char* name, size_t size) {
+   char* json = xMalloc(CONTAINERNAMES_METADATA_MAX);
+   char path[512];
+   bool found = false;
+
+   if (String_eq(runtime, "docker")) {
+      xSnprintf(path, sizeof(path), "/var/lib/docker/containers/%s/config.v2.json", id);
+      if (xReadfile(path, json, CONTAINERNAMES_METADATA_MAX) > 0 && ContainerNames_jsonString(json, "Name", name, size)) {
+         /* docker keeps the names with a leading slash */
+         if (name[0] == '/')
+            memmove(name, name + 1, strlen(name));
+         found = name[0] != '\0';
+      }
+   } else if (String_eq(runtime, "containerd")) {
+      xSnprintf(path, sizeof(path), "/run/containerd/io.containerd.runtime.v2.task/k8s.io/%s/config.json", id);
+      if (xReadfile(path, json, CONTAINERNAMES_METADATA_MAX) > 0)
+         found = ContainerNames_kubernetes(json, "io.kubernetes.cri.sandbox-namespace", "io.kubernetes.cri.sandbox-name", "io.kubernetes.cri.container-name", name, size);
+   } else if (String_eq(runtime, "crio")) {
+      static const char* const storage[] = { "/var/lib/containers/storage", "/run/containers/storage" };
+      for (size_t i = 0; i < ARRAYSIZE(storage) && !found; i++) {
+         xSnprintf(path, sizeof(path), "%s/overlay-containers/%s/userdata/config.json", storage[i], id);
+         if (xReadfile(path, json, CONTAINERNAMES_METADATA_MAX) > 0)
+            found = ContainerNames_kubernetes(json, "io.kubernetes.pod.namespace", "io.kubernetes.pod.name", "io.kubernetes.container.name", name, size);
+      }
+   }
+
+   free(json);
+   return found;
+}
+
+#ifdef HAVE_PTHREAD
+
+typedef struct ContainerNamesRequest_ {
+   size_t index;
+   char runtime[16];
+   char id[CONTAINERNAMES_ID_MAX + 1];
+} ContainerNamesRequest;
+
+typedef struct ContainerNamesResult_ {
+   size_t index;
+   bool found;
+   char name[CONTAINERNAMES_NAME_MAX];
+} ContainerNamesResult;
+
+/*
+ * Reads the metadata on a detached helper thread, like the user names of
+ * UsersTable: a runtime directory on slow storage never stalls the UI.
+ * Only the main thread touches the entries; the helper gets copies.
+ */
+typedef struct ContainerNamesResolver_ {
+   pthread_mutex_t lock;
+   pthread_cond_t cond;
+
+   unsigned int refs;  // the module and the helper, the last one frees
+   bool quit;
+
+   ContainerNamesRequest* requests;
+   size_t requestCount;
+   size_t requestAlloc;
+
+   ContainerNamesResult* results;
+   size_t resultCount;
+   size_t resultAlloc;
+} ContainerNamesResolver;
+
+static ContainerNamesResolver* ContainerNames_resolver;
+
+/* Called with the lock held, drops it */
+static void ContainerNamesResolver_release(ContainerNamesResolver* this) {
+   bool last = --this->refs == 0;
+   pthread_mutex_unlock(&this->lock);
+
+   if (!last)
+      return;
+
+   pthread_cond_destroy(&this->cond);
+   pthread_mutex_destroy(&this->lock);
+   free(this->requests);
+   free(this->results);
+   free(this);
+}
+
+static void* ContainerNamesResolver_run(void* data) {
+   ContainerNamesResolver* this = data;
+
+   pthread_mutex_lock(&this->lock);
+   for (;;) {
+      while (!this->quit && this->requestCount == 0)
+         pthread_cond_wait(&this->cond, &this->lock);
+
+      if (this->quit)
+         break;
+
+      ContainerNamesRequest request = this->requests[--this->requestCount];
+      pthread_mutex_unlock(&this->lock);
+
+      ContainerNamesResult result = { .index = request.index };
+      result.found = ContainerNames_read(request.runtime, request.id, result.name, sizeof(result.name));
+
+      pthread_mutex_lock(&this->lock);
+      if (this->resultCount == this->resultAlloc) {
+         this->resultAlloc = this->resultAlloc ? this->resultAlloc * 2 : 16;
+         this->results = xReallocArray(this->results, this->resultAlloc, sizeof(ContainerNamesResult));
+      }
+      this->results[this->resultCount++] = result;
+   }
+
+   ContainerNamesResolver_release(this);
+   return NULL;
+}
+
+static ContainerNamesResolver* ContainerNamesResolver_new(void) {
+   ContainerNamesResolver* this = xCalloc(1, sizeof(ContainerNamesResolver));
+   pthread_mutex_init(&this->lock, NULL);
+   pthread_cond_init(&this->cond, NULL);
+   this->refs = 2;
+
+   /* signals are to be handled by the main thread only */
+   sigset_t all, old;
+   sigfillset(&all);
+   pthread_sigmask(SIG_BLOCK, &all, &old);
+
+   pthread_t thread;
+   int err = pthread_create(&thread, NULL, ContainerNamesResolver_run, this);
+
+   pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+   if (err != 0) {
+      pthread_cond_destroy(&this->cond);
+      pthread_mutex_destroy(&this->lock);
+      free(this);
+      return NULL;
+   }
+
+   pthread_detach(thread);
+   return this;
+}
+
+static bool ContainerNames_startResolver(void) {
+   static bool failed = false;
+
+   if (!ContainerNames_resolver && !failed) {
+      ContainerNames_resolver = ContainerNamesResolver_new();
+      failed = !ContainerNames_resolver;
+   }
+
+   return ContainerNames_resolver != NULL;
+}
+
+#endif /* HAVE_PTHREAD */
+
+static void ContainerNames_resolve(ContainerName* entry, size_t index) {
+#ifdef HAVE_PTHREAD
+   if (ContainerNames_startResolver()) {
+      ContainerNamesResolver* resolver = ContainerNames_resolver;
+
+      pthread_mutex_lock(&resolver->lock);
+      if (resolver->requestCount == resolver->requestAlloc) {
+         resolver->requestAlloc = resolver->requestAlloc ? resolver->requestAlloc * 2 : 16;
+         resolver->requests = xReallocArray(resolver->requests, resolver->requestAlloc, sizeof(ContainerNamesRequest));
+      }
+      ContainerNamesRequest* request = &resolver->requests[resolver->requestCount++];
+      request->index = index;
+      String_safeStrncpy(request->runtime, entry->runtime, sizeof(request->runtime));
+      String_safeStrncpy(request->id, entry->id, sizeof(request->id));
+      pthread_cond_signal(&resolver->cond);
+      pthread_mutex_unlock(&resolver->lock);
+      return;
+   }
+#endif
+
+   (void) index;
+
+   char name[CONTAINERNAMES_NAME_MAX];
+   if (ContainerNames_read(entry->runtime, entry->id, name, sizeof(name))) {
+      ContainerNames_setName(entry, name);
+      ContainerNames_changed = true;
+   }
+}
+
+static char* ContainerNames_cacheFile(void) {
+   const char* xdgCacheHome = getenv("XDG_CACHE_HOME");
+   if (xdgCacheHome && xdgCacheHome[0] == '/')
+      return String_cat(xdgCacheHome, "/htop/container-names");
+
+   const char* home = getenv("HOME");
+   if (!home) {
+      const struct passwd* pw = getpwuid(getuid());
+      home = pw ? pw->pw_dir : NULL;
+   }
+   return home && home[0] ? String_cat(home, "/.cache/htop/container-names") : NULL;
+}
+
+/* Lines of "runtime:id", a tab and the name */
+static void ContainerNames_load(void) {
+   ContainerNames_file = ContainerNames_cacheFile();
+   if (!ContainerNames_file)
+      return;
+
+   FILE* fd = fopen(ContainerNames_file, "r");
+   if (!fd)
+      return;
+
+   char* line;
+   while ((line = String_readLine(fd)) != NULL) {
+      char* colon = strchr(line, ':');
+      char* tab = colon ? strchr(colon, '\t') : NULL;
+      if (tab && tab[1] && colon - line < 16 && tab - colon - 1 <= CONTAINERNAMES_ID_MAX) {
+         *colon = '\0';
+         *tab = '\0';
+         const uint32_t hash = ContainerNames_hash(line, colon + 1);
+         if (!ContainerNames_find(line, colon + 1, hash))
+            ContainerNames_setName(ContainerNames_add(line, colon + 1, hash), tab + 1);
+      }
+      free(line);
+   }
+
+   fclose(fd);
+}
+
+static void ContainerNames_write(void) {
+   char* slash = strrchr(ContainerNames_file, '/');
+   if (!slash)
+      return;
+
+   /* the cache directory and the one of htop in it */
+   *slash = '\0';
+   char* parent = strrchr(ContainerNames_file, '/');
+   if (parent) {
+      *parent = '\0';
+      (void) mkdir(ContainerNames_file, 0700);
+      *parent = '/';
+   }
+   (void) mkdir(ContainerNames_file, 0700);
+   *slash = '/';
+
+   char* tmpFile = NULL;
+   xAsprintf(&tmpFile, "%s.tmp.XXXXXX", ContainerNames_file);
+   int fdtmp = mkstemp(tmpFile);
+   FILE* fd = fdtmp != -1 ? fdopen(fdtmp, "w") : NULL;
+   if (!fd) {
+      if (fdtmp != -1) {
+         close(fdtmp);
+         unlink(tmpFile);
+      }
+      free(tmpFile);
+      return;
+   }
+
+   /* containers of this run first, older ones fill up what is left */
+   size_t written = 0;
+   for (int pass = 0; pass < 2; pass++) {
+      for (size_t i = 0; i < ContainerNames_count && written < CONTAINERNAMES_FILE_MAX; i++) {
+         const ContainerName* entry = ContainerNames_entries[i];
+         if (!entry->label || entry->seen != (pass == 0))
+            continue;
+
+         /* the label is "/runtime:name" */
+         fprintf(fd, "%s:%s\t%s\n", entry->runtime, entry->id, entry->label + strlen(entry->runtime) + 2);
+         written++;
+      }
+   }
+
+   bool ok = !ferror(fd);
+   ok &= fclose(fd) == 0;
+   if (!ok || rename(tmpFile, ContainerNames_file) != 0)
+      unlink(tmpFile);
+
+   free(tmpFile);
+}
+
+void ContainerNames_update(bool enabled) {
+   ContainerNames_enabled = enabled;
+   if (!enabled)
+      return;
+
+   if (!ContainerNames_loaded) {
+      ContainerNames_loaded = true;
+      ContainerNames_load();
+   }
+
+#ifdef HAVE_PTHREAD
+   ContainerNamesResolver* resolver = ContainerNames_resolver;
+   if (!resolver)
+      return;
+
+   pthread_mutex_lock(&resolver->lock);
+   ContainerNamesResult* results = resolver->results;
+   size_t resultCount = resolver->resultCount;
+   resolver->results = NULL;
+   resolver->resultCount = 0;
+   resolver->resultAlloc = 0;
+   pthread_mutex_unlock(&resolver->lock);
+
+   for (size_t i = 0; i < resultCount; i++) {
+      if (results[i].found) {
+         ContainerNames_setName(ContainerNames_entries[results[i].index], results[i].name);
+         ContainerNames_changed = true;
+      }
+   }
+
+   free(results);
+#endif
+}
+
+ContainerName* ContainerNames_get(const char* cgroup) {
+   const char* id;
+   size_t idLen;
+   const char* runtime = CGroup_findContainerId(cgroup, &id, &idLen);
+   if (!runtime || idLen > CONTAINERNAMES_ID_MAX)
+      return NULL;
+
+   char fullId[CONTAINERNAMES_ID_MAX + 1];
+   memcpy(fullId, id, idLen);
+   fullId[idLen] = '\0';
+
+   /* only the hex digits of an ID, it becomes part of a path */
+   if (strspn(fullId, "0123456789abcdef") != idLen)
+      return NULL;
+
+   const uint32_t hash = ContainerNames_hash(runtime, fullId);
+   ContainerName* entry = ContainerNames_find(runtime, fullId, hash);
+   if (!entry) {
+      /* a container without metadata is not looked for again in this run */
+      entry = ContainerNames_add(runtime, fullId, hash);
+      ContainerNames_resolve(entry, ContainerNames_count - 1);
+   }
+
+   entry->seen = true;
+   return entry;
+}
+
+const char* ContainerNames_label(const ContainerName* entry, size_t* length) {
+   if (!ContainerNames_enabled || !entry || !entry->label)
+      return NULL;
+
+   if (length)
+      *length = entry->labelLen;
+   return entry->label;
+}
+
+void ContainerNames_cleanup(void) {
+#ifdef HAVE_PTHREAD
+   if (ContainerNames_resolver) {
+      pthread_mutex_lock(&ContainerNames_resolver->lock);
+      ContainerNames_resolver->quit = true;
+      pthread_cond_signal(&ContainerNames_resolver->cond);
+      ContainerNamesResolver_release(ContainerNames_resolver);
+      ContainerNames_resolver = NULL;
+   }
+#endif
+
+   if (ContainerNames_changed && ContainerNames_file)
+      ContainerNames_write();
+
+   for (size_t i = 0; i < ContainerNames_count; i++) {
+      free(ContainerNames_entries[i]->label);
+      free(ContainerNames_entries[i]);
+   }
+   free(ContainerNames_entries);
+   free(ContainerNames_file);
+
+   ContainerNames_entries = NULL;
+   ContainerNames_count = 0;
+   ContainerNames_alloc = 0;
+   ContainerNames_file = NULL;
+   ContainerNames_enabled = false;
+   ContainerNames_loaded = false;
+   ContainerNames_changed = false;
+}
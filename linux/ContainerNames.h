@@ -0,0 +1,45 @@
+#ifndef HEADER_ContainerNames
+#define HEADER_ContainerNames
+/*
+htop - linux/ContainerNames.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/*
+ * Names of docker, containerd and CRI-O containers, from the metadata
+ * their runtime keeps on disk; Kubernetes containers are named after
+ * their namespace, pod and container. The metadata is read on a helper
+ * thread, once per container: names are kept for the run and in a file
+ * of the cache directory for the next ones.
+ */
+
+/* Entries kept in the file, the ones seen in this run first */
+#define CONTAINERNAMES_FILE_MAX 4096
+
+typedef struct ContainerName_ ContainerName;
+
+/*
+ * Whether names are shown, from the setting; read at the start of each
+ * scan, which also takes the names the helper found since the last one.
+ */
+void ContainerNames_update(bool enabled);
+
+/*
+ * The entry of the container the cgroup path is in, NULL if it is in none
+ * of a known runtime. Valid until ContainerNames_cleanup().
+ */
+ContainerName* ContainerNames_get(const char* cgroup);
+
+/* Like "/docker:web", NULL until the name is known or while not shown */
+const char* ContainerNames_label(const ContainerName* entry, size_t* length);
+
+/* Writes the file if names were found in this run */
+void ContainerNames_cleanup(void);
+
+#endif
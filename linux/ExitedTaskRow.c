@@ -0,0 +1,179 @@
+/*
+htop - linux/ExitedTaskRow.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/ExitedTaskRow.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "CRT.h"
+#include "DynamicColumn.h"
+#include "Macros.h"
+#include "RichString.h"
+#include "Settings.h"
+#include "Table.h"
+#include "XUtils.h"
+
+
+typedef struct ExitedTaskFieldData_ {
+   const char* name;          /* stored in htoprc as Dynamic(name) */
+   const char* heading;
+   const char* description;
+   int width;                 /* as in DynamicColumn, without the trailing space */
+} ExitedTaskFieldData;
+
+static const ExitedTaskFieldData ExitedTaskRow_fields[LAST_EXITEDTASK_FIELD] = {
+   [EXITEDTASK_FIELD_PID] = { .name = "exited_ppid", .heading = "PPID", .description = "Process ID of the parent the processes exited under", .width = 7, },
+   [EXITEDTASK_FIELD_TASKS] = { .name = "exited_tasks", .heading = "EXITED", .description = "Number of processes that exited in the last interval", .width = 6, },
+   [EXITEDTASK_FIELD_TOTAL] = { .name = "exited_total", .heading = "TOTAL", .description = "Number of processes that exited since the row appeared", .width = 11, },
+   [EXITEDTASK_FIELD_CPU_PERCENT] = { .name = "exited_cpu_percent", .heading = "CPU%", .description = "CPU time the processes that exited in the last interval used in it, not seen by the scans", .width = 5, },
+   [EXITEDTASK_FIELD_CPU_TIME] = { .name = "exited_cpu_time", .heading = "TIME+", .description = "CPU time of the processes that exited since the row appeared, not seen by the scans", .width = 9, },
+   [EXITEDTASK_FIELD_IO_RATE] = { .name = "exited_io_rate", .heading = "DISK R/W", .description = "Storage I/O of the processes that exited in the last interval, per second", .width = 9, },
+   [EXITEDTASK_FIELD_PEAK_RSS] = { .name = "exited_peak_rss", .heading = "PEAK", .description = "Largest peak resident set size of one of the processes that exited in the last interval", .width = 5, },
+   [EXITEDTASK_FIELD_COMMAND] = { .name = "exited_command", .heading = "Command", .description = "Command of the processes, or of their parent", .width = -32, },
+};
+
+ExitedTaskRow* ExitedTaskRow_new(const Machine* host) {
+   ExitedTaskRow* this = xCalloc(1, sizeof(ExitedTaskRow));
+   Object_setClass(this, Class(ExitedTaskRow));
+   Row_init(&this->super, host);
+   this->cpuPercent = NAN;
+   this->ioRate = NAN;
+   return this;
+}
+
+static void ExitedTaskRow_delete(Object* cast) {
+   ExitedTaskRow* this = (ExitedTaskRow*) cast;
+   Row_done(&this->super);
+   free(this);
+}
+
+static void ExitedTaskRow_writeField(const Row* super, RichString* str, RowField field) {
+   const ExitedTaskRow* this = (const ExitedTaskRow*) super;
+   const Settings* settings = super->host->settings;
+   bool coloring = settings->highlightMegabytes;
+   char buffer[256];
+   size_t n = sizeof(buffer);
+   int attr = CRT_colors[DEFAULT_COLOR];
+
+   switch ((int)field - ExitedTaskField_key(0)) {
+   case EXITEDTASK_FIELD_PID:
+      xSnprintf(buffer, n, "%*d ", Row_pidDigits, (int)this->ppid);
+      break;
+   case EXITEDTASK_FIELD_TASKS:
+      if (!this->tasks)
+         attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, "%6u ", this->tasks);
+      break;
+   case EXITEDTASK_FIELD_TOTAL: Row_printCount(str, this->totalTasks, coloring); return;
+   case EXITEDTASK_FIELD_CPU_PERCENT: Row_printPercentage(this->cpuPercent, buffer, n, 5, &attr); break;
+   case EXITEDTASK_FIELD_CPU_TIME: Row_printTime(str, this->totalCpuUs / 10000, coloring); return;
+   case EXITEDTASK_FIELD_IO_RATE: Row_printRate(str, this->ioRate, coloring); return;
+   case EXITEDTASK_FIELD_PEAK_RSS: Row_printKBytes(str, this->peakRssKB, coloring); return;
+   case EXITEDTASK_FIELD_COMMAND:
+      if (settings->ss->treeView)
+         Row_printTreeBranch(super, str);
+      RichString_appendWide(str, this->isParent ? CRT_colors[PROCESS_SHADOW] : CRT_colors[PROCESS_BASENAME], this->command);
+      return;
+   default:
+      assert(0 && "ExitedTaskRow_writeField: default key reached"); /* should never be reached */
+      xSnprintf(buffer, n, "- ");
+      break;
+   }
+
+   RichString_appendAscii(str, attr, buffer);
+}
+
+static int ExitedTaskRow_compareByKey(const ExitedTaskRow* e1, const ExitedTaskRow* e2, RowField key) {
+   switch ((int)key - ExitedTaskField_key(0)) {
+   case EXITEDTASK_FIELD_PID:
+      return SPACESHIP_NUMBER(e1->ppid, e2->ppid);
+   case EXITEDTASK_FIELD_TASKS:
+      return SPACESHIP_NUMBER(e1->tasks, e2->tasks);
+   case EXITEDTASK_FIELD_TOTAL:
+      return SPACESHIP_NUMBER(e1->totalTasks, e2->totalTasks);
+   case EXITEDTASK_FIELD_CPU_PERCENT:
+      return compareRealNumbers(e1->cpuPercent, e2->cpuPercent);
+   case EXITEDTASK_FIELD_CPU_TIME:
+      return SPACESHIP_NUMBER(e1->totalCpuUs, e2->totalCpuUs);
+   case EXITEDTASK_FIELD_IO_RATE:
+      return compareRealNumbers(e1->ioRate, e2->ioRate);
+   case EXITEDTASK_FIELD_PEAK_RSS:
+      return SPACESHIP_NUMBER(e1->peakRssKB, e2->peakRssKB);
+   case EXITEDTASK_FIELD_COMMAND:
+      return SPACESHIP_NULLSTR(e1->command, e2->command);
+   default:
+      return 0;
+   }
+}
+
+static int ExitedTaskRow_compare(const void* v1, const void* v2) {
+   const ExitedTaskRow* e1 = (const ExitedTaskRow*)v1;
+   const ExitedTaskRow* e2 = (const ExitedTaskRow*)v2;
+   const ScreenSettings* ss = e1->super.host->settings->ss;
+   RowField key = ScreenSettings_getActiveSortKey(ss);
+   int result = ExitedTaskRow_compareByKey(e1, e2, key);
+
+   // Implement tie-breaker (needed to make tree mode more stable)
+   if (!result)
+      return SPACESHIP_NUMBER(e1->super.id, e2->super.id);
+
+   return (ScreenSettings_getActiveDirection(ss) == 1) ? result : -result;
+}
+
+/* Siblings by the sort key, as Row_compareByParent_Base would order them by id */
+static int ExitedTaskRow_compareByParent(const Row* r1, const Row* r2) {
+   int result = SPACESHIP_NUMBER(
+      r1->isRoot ? 0 : Row_getGroupOrParent(r1),
+      r2->isRoot ? 0 : Row_getGroupOrParent(r2)
+   );
+
+   if (result != 0)
+      return result;
+
+   return ExitedTaskRow_compare(r1, r2);
+}
+
+static const char* ExitedTaskRow_sortKeyString(Row* super) {
+   const ExitedTaskRow* this = (const ExitedTaskRow*) super;
+   return this->command;
+}
+
+static bool ExitedTaskRow_matchesFilter(Row* super, const Table* table) {
+   const ExitedTaskRow* this = (const ExitedTaskRow*) super;
+   return !FilterMatcher_matches(&table->filter, this->command);
+}
+
+void ExitedTaskRow_addColumns(Hashtable* columns) {
+   for (int i = 0; i < LAST_EXITEDTASK_FIELD; i++) {
+      const ExitedTaskFieldData* data = &ExitedTaskRow_fields[i];
+      DynamicColumn* column = xCalloc(1, sizeof(DynamicColumn));
+      String_safeStrncpy(column->name, data->name, sizeof(column->name));
+      column->heading = xStrdup(data->heading);
+      column->caption = xStrdup(data->heading);
+      column->description = xStrdup(data->description);
+      column->width = data->width;
+      column->enabled = true;
+      Hashtable_put(columns, ExitedTaskField_key(i), column);
+   }
+}
+
+const RowClass ExitedTaskRow_class = {
+   .super = {
+      .extends = Class(Row),
+      .display = Row_display,
+      .delete = ExitedTaskRow_delete,
+      .compare = ExitedTaskRow_compare,
+   },
+   .writeField = ExitedTaskRow_writeField,
+   .matchesFilter = ExitedTaskRow_matchesFilter,
+   .sortKeyString = ExitedTaskRow_sortKeyString,
+   .compareByParent = ExitedTaskRow_compareByParent,
+};
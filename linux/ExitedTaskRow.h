@@ -0,0 +1,62 @@
+#ifndef HEADER_ExitedTaskRow
+#define HEADER_ExitedTaskRow
+/*
+htop - linux/ExitedTaskRow.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "Hashtable.h"
+#include "Machine.h"
+#include "Object.h"
+#include "Row.h"
+#include "RowField.h"
+#include "linux/CPUOccupancyRow.h"
+
+
+/* Columns of the exited processes screen, keyed after the ones of the CPU occupancy screen */
+typedef enum ExitedTaskField_ {
+   EXITEDTASK_FIELD_PID,
+   EXITEDTASK_FIELD_TASKS,
+   EXITEDTASK_FIELD_TOTAL,
+   EXITEDTASK_FIELD_CPU_PERCENT,
+   EXITEDTASK_FIELD_CPU_TIME,
+   EXITEDTASK_FIELD_IO_RATE,
+   EXITEDTASK_FIELD_PEAK_RSS,
+   EXITEDTASK_FIELD_COMMAND,
+   LAST_EXITEDTASK_FIELD
+} ExitedTaskField;
+
+#define ExitedTaskField_key(f_)  ((RowField)(CPUOccupancyField_key(LAST_CPUOCCUPANCY_FIELD) + (f_)))
+
+/* Ids of the rows of the groups, above the largest PID of the parents */
+#define EXITED_GROUP_ID_BASE (1 << 22)
+
+/* A parent with the processes that exited under it, or one command of them */
+typedef struct ExitedTaskRow_ {
+   Row super;
+
+   bool isParent;
+   pid_t ppid;
+   char command[32];
+
+   unsigned int tasks;             /* in the last interval */
+   unsigned long long totalTasks;
+   float cpuPercent;
+   unsigned long long totalCpuUs;
+   double ioRate;
+   unsigned long long peakRssKB;
+} ExitedTaskRow;
+
+extern const RowClass ExitedTaskRow_class;
+
+ExitedTaskRow* ExitedTaskRow_new(const Machine* host);
+
+/* Adds the dynamic columns of the exited processes screen to `columns` */
+void ExitedTaskRow_addColumns(Hashtable* columns);
+
+#endif
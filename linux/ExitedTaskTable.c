@@ -0,0 +1,123 @@
+/*
+htop - linux/ExitedTaskTable.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/ExitedTaskTable.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "Macros.h"
+#include "Object.h"
+#include "Process.h"
+#include "Row.h"
+#include "XUtils.h"
+
+#include "linux/ExitedTaskRow.h"
+#include "linux/ExitedTasks.h"
+
+
+ExitedTaskTable* ExitedTaskTable_new(Machine* host) {
+   ExitedTaskTable* this = xCalloc(1, sizeof(ExitedTaskTable));
+   Object_setClass(this, Class(ExitedTaskTable));
+   Table_init(&this->super, Class(ExitedTaskRow), host);
+   return this;
+}
+
+static void ExitedTaskTable_delete(Object* cast) {
+   ExitedTaskTable* this = (ExitedTaskTable*) cast;
+   Table_done(&this->super);
+   free(this);
+}
+
+static ExitedTaskRow* ExitedTaskTable_getRow(Table* super, int id, int parent) {
+   ExitedTaskRow* row = (ExitedTaskRow*) Table_findRow(super, id);
+   if (row) {
+      row->super.tombStampMs = 0;
+   } else {
+      row = ExitedTaskRow_new(super->host);
+      row->super.id = id;
+      row->super.group = id;
+      Table_add(super, &row->super);
+   }
+
+   row->super.parent = parent;
+   Table_markUpdated(super, &row->super);
+   row->super.show = true;
+   return row;
+}
+
+/* The row of the parent sums up its groups; its command is from the process table while it lives */
+static ExitedTaskRow* ExitedTaskTable_getParent(Table* super, pid_t ppid) {
+   ExitedTaskRow* row = (ExitedTaskRow*) Table_findRow(super, (int)ppid);
+   if (row && Table_isUpdated(super, &row->super))
+      return row;
+
+   row = ExitedTaskTable_getRow(super, (int)ppid, 0);
+   row->isParent = true;
+   row->ppid = ppid;
+   row->tasks = 0;
+   row->totalTasks = 0;
+   row->totalCpuUs = 0;
+   row->peakRssKB = 0;
+
+   const uint64_t intervalMs = ExitedTasks_interval();
+   row->cpuPercent = intervalMs ? 0.0F : NAN;
+   row->ioRate = intervalMs ? 0.0 : NAN;
+
+   const Table* processTable = super->host->processTable;
+   const Process* proc = processTable ? (const Process*) Table_findRow(processTable, (int)ppid) : NULL;
+   if (proc) {
+      String_safeStrncpy(row->command, proc->procComm ? proc->procComm : Process_getCommand(proc), sizeof(row->command));
+   } else {
+      xSnprintf(row->command, sizeof(row->command), "(exited)");
+   }
+
+   return row;
+}
+
+static void ExitedTaskTable_iterateEntries(Table* super) {
+   const uint64_t intervalMs = ExitedTasks_interval();
+
+   for (size_t i = 0; i < ExitedTasks_groupCount(); i++) {
+      const ExitedGroup* group = ExitedTasks_group(i);
+      ExitedTaskRow* parent = group->ppid > 0 ? ExitedTaskTable_getParent(super, group->ppid) : NULL;
+
+      ExitedTaskRow* row = ExitedTaskTable_getRow(super, EXITED_GROUP_ID_BASE + (int)group->id, parent ? (int)group->ppid : 0);
+      row->ppid = group->ppid;
+      xSnprintf(row->command, sizeof(row->command), "%s", group->comm);
+      row->tasks = group->tasks;
+      row->totalTasks = group->totalTasks;
+      row->totalCpuUs = group->totalCpuUs;
+      row->peakRssKB = group->peakRssKB;
+      row->cpuPercent = intervalMs ? (float)((double)group->cpuUs / (double)intervalMs / 10.0) : NAN;
+      row->ioRate = intervalMs ? (double)group->ioBytes * 1000.0 / (double)intervalMs : NAN;
+
+      if (!parent)
+         continue;
+
+      parent->tasks += row->tasks;
+      parent->totalTasks += row->totalTasks;
+      parent->totalCpuUs += row->totalCpuUs;
+      parent->peakRssKB = MAXIMUM(parent->peakRssKB, row->peakRssKB);
+      if (intervalMs) {
+         parent->cpuPercent += row->cpuPercent;
+         parent->ioRate += row->ioRate;
+      }
+   }
+}
+
+const TableClass ExitedTaskTable_class = {
+   .super = {
+      .extends = Class(Table),
+      .delete = ExitedTaskTable_delete,
+   },
+   .prepare = Table_prepareEntries,
+   .iterate = ExitedTaskTable_iterateEntries,
+   .cleanup = Table_cleanupEntries,
+};
@@ -0,0 +1,23 @@
+#ifndef HEADER_ExitedTaskTable
+#define HEADER_ExitedTaskTable
+/*
+htop - linux/ExitedTaskTable.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "Machine.h"
+#include "Table.h"
+
+
+/* The processes that exited lately, by command under a row of their parent */
+typedef struct ExitedTaskTable_ {
+   Table super;
+} ExitedTaskTable;
+
+extern const TableClass ExitedTaskTable_class;
+
+ExitedTaskTable* ExitedTaskTable_new(Machine* host);
+
+#endif
@@ -0,0 +1,493 @@
+/*
+htop - linux/ExitedTasks.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/ExitedTasks.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Macros.h"
+#include "Process.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+#include "linux/LinuxProcess.h"
+
+#ifdef HAVE_TASKSTATS
+#include <errno.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <linux/acct.h>
+#include <linux/genetlink.h>
+#include <linux/netlink.h>
+#include <linux/taskstats.h>
+#include <sys/socket.h>
+#endif
+
+
+unsigned int ExitedTasks_meters;
+
+static ExitedGroup* ExitedTasks_groups;
+static size_t ExitedTasks_count;
+static size_t ExitedTasks_size;
+static size_t ExitedTasks_last;
+static unsigned int ExitedTasks_nextId = 1;
+
+static ExitedTotals ExitedTasks_sum = { .cpuPercent = NAN, .ioRate = NAN };
+static uint64_t ExitedTasks_lastMs;
+static uint64_t ExitedTasks_intervalMs;
+
+size_t ExitedTasks_groupCount(void) {
+   return ExitedTasks_count;
+}
+
+const ExitedGroup* ExitedTasks_group(size_t index) {
+   return index < ExitedTasks_count ? &ExitedTasks_groups[index] : NULL;
+}
+
+uint64_t ExitedTasks_interval(void) {
+   return ExitedTasks_intervalMs;
+}
+
+const ExitedTotals* ExitedTasks_totals(void) {
+   return &ExitedTasks_sum;
+}
+
+#ifdef HAVE_TASKSTATS
+
+/* The exit records of a busy machine come in bursts */
+#define EXITED_RCVBUF (1 << 20)
+#define EXITED_BUFSIZE 16384
+
+static int ExitedTasks_fd = -1;
+static uint16_t ExitedTasks_family;
+static bool ExitedTasks_failed;
+static uint32_t ExitedTasks_seq;
+
+/* Threads that exited ahead of the last one of their process, by thread group */
+typedef struct ExitedThreads_ {
+   pid_t tgid;
+   unsigned long long cpuUs;
+   unsigned long long ioBytes;
+} ExitedThreads;
+
+static ExitedThreads* ExitedTasks_threads;
+static size_t ExitedTasks_threadCount;
+static size_t ExitedTasks_threadSize;
+
+/* Sends a generic netlink request with one attribute */
+static bool ExitedTasks_send(uint16_t type, uint8_t cmd, uint16_t attrType, const void* data, size_t len) {
+   union {
+      struct nlmsghdr hdr;
+      char raw[NLMSG_SPACE(GENL_HDRLEN + NLA_HDRLEN + 256)];
+   } buf;
+
+   if (len > 256)
+      return false;
+
+   memset(&buf, 0, sizeof(buf));
+
+   struct nlmsghdr* hdr = &buf.hdr;
+   hdr->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN + NLA_ALIGN(NLA_HDRLEN + len));
+   hdr->nlmsg_type = type;
+   hdr->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+   hdr->nlmsg_seq = ++ExitedTasks_seq;
+
+   struct genlmsghdr* genl = NLMSG_DATA(hdr);
+   genl->cmd = cmd;
+   genl->version = 1;
+
+   struct nlattr* attr = (struct nlattr*)(void*)((char*)genl + GENL_HDRLEN);
+   attr->nla_type = attrType;
+   attr->nla_len = (uint16_t)(NLA_HDRLEN + len);
+   memcpy((char*)attr + NLA_HDRLEN, data, len);
+
+   struct sockaddr_nl addr = { .nl_family = AF_NETLINK };
+   return sendto(ExitedTasks_fd, hdr, hdr->nlmsg_len, 0, (struct sockaddr*)&addr, sizeof(addr)) == (ssize_t)hdr->nlmsg_len;
+}
+
+/* Payload of the attribute of that type among the ones in data, NULL if none */
+static const void* ExitedTasks_findAttr(const void* data, size_t len, uint16_t type, size_t* attrLen) {
+   const char* at = data;
+   while (len >= NLA_HDRLEN) {
+      const struct nlattr* attr = (const struct nlattr*)(const void*)at;
+      if (attr->nla_len < NLA_HDRLEN || attr->nla_len > len)
+         break;
+
+      if ((attr->nla_type & NLA_TYPE_MASK) == type) {
+         *attrLen = attr->nla_len - NLA_HDRLEN;
+         return at + NLA_HDRLEN;
+      }
+
+      const size_t step = NLA_ALIGN(attr->nla_len);
+      if (step >= len)
+         break;
+      at += step;
+      len -= step;
+   }
+
+   return NULL;
+}
+
+/*
+ * The reply to the last request sent: the generic netlink message of the
+ * type, or the ack. False on an error or if nothing came; the kernel
+ * answers a request before the send returns.
+ */
+static bool ExitedTasks_reply(uint16_t type, void* buf, size_t size, const struct genlmsghdr** genl, size_t* len) {
+   for (;;) {
+      ssize_t r = recv(ExitedTasks_fd, buf, size, 0);
+      if (r < 0 && errno == EINTR)
+         continue;
+      if (r < (ssize_t)sizeof(struct nlmsghdr))
+         return false;
+
+      const struct nlmsghdr* hdr = buf;
+      if (hdr->nlmsg_len > (size_t)r || hdr->nlmsg_seq != ExitedTasks_seq)
+         continue;
+
+      if (hdr->nlmsg_type == NLMSG_ERROR) {
+         const struct nlmsgerr* err = NLMSG_DATA(hdr);
+         return hdr->nlmsg_len >= NLMSG_LENGTH(sizeof(*err)) && err->error == 0 && !genl;
+      }
+
+      if (hdr->nlmsg_type != type || !genl || hdr->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN))
+         continue;
+
+      *genl = NLMSG_DATA(hdr);
+      *len = hdr->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+      return true;
+   }
+}
+
+static bool ExitedTasks_open(void) {
+   ExitedTasks_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_GENERIC);
+   if (ExitedTasks_fd < 0)
+      return false;
+
+   int rcvbuf = EXITED_RCVBUF;
+   setsockopt(ExitedTasks_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+   struct sockaddr_nl addr = { .nl_family = AF_NETLINK };
+   if (bind(ExitedTasks_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+      goto fail;
+
+   union {
+      struct nlmsghdr hdr;
+      char raw[4096];
+   } buf;
+
+   /* the id of the taskstats family */
+   const struct genlmsghdr* genl;
+   size_t len;
+   if (!ExitedTasks_send(GENL_ID_CTRL, CTRL_CMD_GETFAMILY, CTRL_ATTR_FAMILY_NAME, TASKSTATS_GENL_NAME, sizeof(TASKSTATS_GENL_NAME)) ||
+       !ExitedTasks_reply(GENL_ID_CTRL, &buf, sizeof(buf), &genl, &len))
+      goto fail;
+
+   size_t idLen;
+   const void* id = ExitedTasks_findAttr((const char*)genl + GENL_HDRLEN, len, CTRL_ATTR_FAMILY_ID, &idLen);
+   if (!id || idLen < sizeof(uint16_t))
+      goto fail;
+   memcpy(&ExitedTasks_family, id, sizeof(uint16_t));
+
+   /* the exit records of the tasks on all CPUs, as listed by the kernel */
+   char cpus[256];
+   ssize_t r = FsRoot_readFile(&FsRoot_sys, "devices/system/cpu/possible", cpus, sizeof(cpus));
+   if (r <= 0)
+      goto fail;
+   cpus[strcspn(cpus, "\n")] = '\0';
+
+   /* the ack tells whether it was permitted */
+   if (!ExitedTasks_send(ExitedTasks_family, TASKSTATS_CMD_GET, TASKSTATS_CMD_ATTR_REGISTER_CPUMASK, cpus, strlen(cpus) + 1) ||
+       !ExitedTasks_reply(ExitedTasks_family, &buf, sizeof(buf), NULL, NULL))
+      goto fail;
+
+   return true;
+
+fail:
+   close(ExitedTasks_fd);
+   ExitedTasks_fd = -1;
+   return false;
+}
+
+static void ExitedTasks_addThread(pid_t tgid, unsigned long long cpuUs, unsigned long long ioBytes) {
+   for (size_t i = 0; i < ExitedTasks_threadCount; i++) {
+      if (ExitedTasks_threads[i].tgid == tgid) {
+         ExitedTasks_threads[i].cpuUs += cpuUs;
+         ExitedTasks_threads[i].ioBytes += ioBytes;
+         return;
+      }
+   }
+
+   if (ExitedTasks_threadCount == ExitedTasks_threadSize) {
+      ExitedTasks_threadSize = ExitedTasks_threadSize ? 2 * ExitedTasks_threadSize : 32;
+      ExitedTasks_threads = xReallocArray(ExitedTasks_threads, ExitedTasks_threadSize, sizeof(ExitedThreads));
+   }
+   ExitedTasks_threads[ExitedTasks_threadCount++] = (ExitedThreads) { .tgid = tgid, .cpuUs = cpuUs, .ioBytes = ioBytes };
+}
+
+/* Takes the usage of the threads of the group that exited before, in this interval */
+static void ExitedTasks_takeThreads(pid_t tgid, unsigned long long* cpuUs, unsigned long long* ioBytes) {
+   for (size_t i = 0; i < ExitedTasks_threadCount; i++) {
+      if (ExitedTasks_threads[i].tgid == tgid) {
+         *cpuUs += ExitedTasks_threads[i].cpuUs;
+         *ioBytes += ExitedTasks_threads[i].ioBytes;
+         ExitedTasks_threads[i] = ExitedTasks_threads[--ExitedTasks_threadCount];
+         return;
+      }
+   }
+}
+
+static ExitedGroup* ExitedTasks_getGroup(pid_t ppid, const char* comm) {
+   /* the tasks of a build come in runs of the same command */
+   if (ExitedTasks_last < ExitedTasks_count) {
+      ExitedGroup* group = &ExitedTasks_groups[ExitedTasks_last];
+      if (group->ppid == ppid && String_eq(group->comm, comm))
+         return group;
+   }
+
+   for (size_t i = 0; i < ExitedTasks_count; i++) {
+      ExitedGroup* group = &ExitedTasks_groups[i];
+      if (group->ppid == ppid && String_eq(group->comm, comm)) {
+         ExitedTasks_last = i;
+         return group;
+      }
+   }
+
+   if (ExitedTasks_count == ExitedTasks_size) {
+      ExitedTasks_size = ExitedTasks_size ? 2 * ExitedTasks_size : 32;
+      ExitedTasks_groups = xReallocArray(ExitedTasks_groups, ExitedTasks_size, sizeof(ExitedGroup));
+   }
+
+   ExitedGroup* group = &ExitedTasks_groups[ExitedTasks_count];
+   *group = (ExitedGroup) { .id = ExitedTasks_nextId++, .ppid = ppid };
+   String_safeStrncpy(group->comm, comm, sizeof(group->comm));
+   ExitedTasks_last = ExitedTasks_count++;
+   return group;
+}
+
+/*
+ * Sums up the record of an exited task. A thread is kept until the last one
+ * of its process exits, threads of processes living on are counted with
+ * them. Kernels before 5.19 do not tell the thread group of a record: only
+ * the last thread of a process counts then.
+ */
+static void ExitedTasks_account(const struct taskstats* ts, size_t len, const Table* processTable, uint64_t nowMs) {
+   unsigned long long cpuUs = ts->ac_utime + ts->ac_stime;
+   unsigned long long ioBytes = ts->read_bytes + ts->write_bytes;
+
+   pid_t tgid = 0;
+#if TASKSTATS_VERSION >= 13
+   if (ts->version >= 13 && len >= offsetof(struct taskstats, ac_tgid) + sizeof(ts->ac_tgid))
+      tgid = (pid_t)ts->ac_tgid;
+#else
+   (void)len;
+#endif
+
+   if (!(ts->ac_flag & AGROUP)) {
+      if (tgid > 0)
+         ExitedTasks_addThread(tgid, cpuUs, ioBytes);
+      return;
+   }
+
+   const pid_t pid = (pid_t)ts->ac_pid;
+   if (tgid <= 0)
+      tgid = pid;
+   ExitedTasks_takeThreads(tgid, &cpuUs, &ioBytes);
+
+   /* what the scans saw of the process was shown with it */
+   const Process* proc = (const Process*) Table_findRow(processTable, tgid);
+   if (proc && !Process_isThread(proc) && (pid != tgid || llabs((long long)proc->starttime_ctime - (long long)ts->ac_btime) <= 1)) {
+      cpuUs = saturatingSub(cpuUs, proc->time * 10000ULL);
+
+      const LinuxProcessDetails* details = LinuxProcess_getDetails((const LinuxProcess*) proc);
+      if (details && details->io_read_bytes != ULLONG_MAX && details->io_write_bytes != ULLONG_MAX)
+         ioBytes = saturatingSub(ioBytes, details->io_read_bytes + details->io_write_bytes);
+   }
+
+   char comm[sizeof(ts->ac_comm) + 1];
+   memcpy(comm, ts->ac_comm, sizeof(ts->ac_comm));
+   comm[sizeof(ts->ac_comm)] = '\0';
+
+   ExitedGroup* group = ExitedTasks_getGroup((pid_t)ts->ac_ppid, comm);
+   group->lastExitMs = nowMs;
+   group->tasks++;
+   group->cpuUs += cpuUs;
+   group->ioBytes += ioBytes;
+   group->peakRssKB = MAXIMUM(group->peakRssKB, (unsigned long long)ts->hiwater_rss);
+   group->totalTasks++;
+   group->totalCpuUs += cpuUs;
+}
+
+static void ExitedTasks_dispatch(const struct nlmsghdr* hdr, const Table* processTable, uint64_t nowMs) {
+   if (hdr->nlmsg_type != ExitedTasks_family || hdr->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN))
+      return;
+
+   const char* attrs = (const char*)NLMSG_DATA(hdr) + GENL_HDRLEN;
+   const size_t len = hdr->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+
+   /* the one of the thread group that comes along has no CPU times */
+   size_t aggrLen;
+   const void* aggr = ExitedTasks_findAttr(attrs, len, TASKSTATS_TYPE_AGGR_PID, &aggrLen);
+   if (!aggr)
+      return;
+
+   size_t statsLen;
+   const void* data = ExitedTasks_findAttr(aggr, aggrLen, TASKSTATS_TYPE_STATS, &statsLen);
+   if (!data)
+      return;
+
+   /* older kernels send less, newer ones more */
+   struct taskstats ts;
+   memset(&ts, 0, sizeof(ts));
+   memcpy(&ts, data, MINIMUM(statsLen, sizeof(ts)));
+   ExitedTasks_account(&ts, statsLen, processTable, nowMs);
+}
+
+/* Hands all pending exit records to ExitedTasks_account(); false if some got lost */
+static bool ExitedTasks_drain(const Table* processTable, uint64_t nowMs) {
+   union {
+      struct nlmsghdr hdr;
+      char raw[EXITED_BUFSIZE];
+   } buf;
+   bool complete = true;
+
+   for (;;) {
+      ssize_t r = recv(ExitedTasks_fd, &buf, sizeof(buf), 0);
+      if (r < 0) {
+         if (errno == EINTR)
+            continue;
+         if (errno == ENOBUFS) {
+            complete = false;
+            continue;
+         }
+         break;
+      }
+      if (r == 0)
+         break;
+
+      size_t len = (size_t)r;
+      for (const struct nlmsghdr* hdr = &buf.hdr; len >= sizeof(*hdr) && hdr->nlmsg_len >= sizeof(*hdr) && hdr->nlmsg_len <= len; ) {
+         ExitedTasks_dispatch(hdr, processTable, nowMs);
+
+         const size_t step = NLMSG_ALIGN(hdr->nlmsg_len);
+         if (step >= len)
+            break;
+         len -= step;
+         hdr = (const struct nlmsghdr*)(const void*)((const char*)hdr + step);
+      }
+   }
+
+   return complete;
+}
+
+#endif /* HAVE_TASKSTATS */
+
+/* Drops the groups nothing exited in for EXITED_KEEP_MS, and sums up the others */
+static void ExitedTasks_sumUp(uint64_t nowMs) {
+   unsigned int tasks = 0;
+   unsigned long long cpuUs = 0;
+   unsigned long long ioBytes = 0;
+
+   for (size_t i = 0; i < ExitedTasks_count; ) {
+      const ExitedGroup* group = &ExitedTasks_groups[i];
+      if (nowMs - group->lastExitMs > EXITED_KEEP_MS) {
+         ExitedTasks_groups[i] = ExitedTasks_groups[--ExitedTasks_count];
+         continue;
+      }
+
+      tasks += group->tasks;
+      cpuUs += group->cpuUs;
+      ioBytes += group->ioBytes;
+      i++;
+   }
+
+   ExitedTasks_sum.tasks = tasks;
+   if (ExitedTasks_intervalMs > 0) {
+      /* microseconds per millisecond are a tenth of a percent */
+      ExitedTasks_sum.cpuPercent = (float)((double)cpuUs / (double)ExitedTasks_intervalMs / 10.0);
+      ExitedTasks_sum.ioRate = (double)ioBytes * 1000.0 / (double)ExitedTasks_intervalMs;
+   } else {
+      ExitedTasks_sum.cpuPercent = NAN;
+      ExitedTasks_sum.ioRate = NAN;
+   }
+}
+
+bool ExitedTasks_refresh(const Table* processTable, uint64_t monotonicMs) {
+#ifdef HAVE_TASKSTATS
+   /* the records are about the running kernel, not about another proc root */
+   if (!FsRoot_isDefault(&FsRoot_proc)) {
+      ExitedTasks_stop();
+      return false;
+   }
+
+   for (size_t i = 0; i < ExitedTasks_count; i++) {
+      ExitedGroup* group = &ExitedTasks_groups[i];
+      group->tasks = 0;
+      group->cpuUs = 0;
+      group->ioBytes = 0;
+      group->peakRssKB = 0;
+   }
+
+   if (ExitedTasks_fd < 0) {
+      if (ExitedTasks_failed)
+         return false;
+
+      /* exits are seen from now on */
+      ExitedTasks_failed = !ExitedTasks_open();
+      ExitedTasks_intervalMs = 0;
+      ExitedTasks_sum.lost = false;
+   } else {
+      ExitedTasks_intervalMs = monotonicMs - ExitedTasks_lastMs;
+      ExitedTasks_sum.lost = !ExitedTasks_drain(processTable, monotonicMs);
+
+      /* the others belong to processes living on */
+      ExitedTasks_threadCount = 0;
+   }
+
+   ExitedTasks_sum.listening = ExitedTasks_fd >= 0;
+   ExitedTasks_lastMs = monotonicMs;
+   ExitedTasks_sumUp(monotonicMs);
+   return !ExitedTasks_failed;
+#else
+   (void)processTable;
+   (void)monotonicMs;
+   (void)ExitedTasks_lastMs;
+   return false;
+#endif
+}
+
+void ExitedTasks_stop(void) {
+#ifdef HAVE_TASKSTATS
+   if (ExitedTasks_fd < 0)
+      return;
+
+   /* the kernel forgets a listener whose socket is gone on the next exit */
+   close(ExitedTasks_fd);
+   ExitedTasks_fd = -1;
+   ExitedTasks_threadCount = 0;
+#endif
+   ExitedTasks_count = 0;
+   ExitedTasks_intervalMs = 0;
+   ExitedTasks_sum = (ExitedTotals) { .cpuPercent = NAN, .ioRate = NAN };
+}
+
+void ExitedTasks_cleanup(void) {
+   ExitedTasks_stop();
+#ifdef HAVE_TASKSTATS
+   free(ExitedTasks_threads);
+   ExitedTasks_threads = NULL;
+   ExitedTasks_threadSize = 0;
+   ExitedTasks_failed = false;
+#endif
+   free(ExitedTasks_groups);
+   ExitedTasks_groups = NULL;
+   ExitedTasks_size = 0;
+}
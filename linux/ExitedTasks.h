@@ -0,0 +1,79 @@
+#ifndef HEADER_ExitedTasks
+#define HEADER_ExitedTasks
+/*
+htop - linux/ExitedTasks.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "Table.h"
+
+
+/*
+ * Processes that exited between two scans, from the exit records taskstats
+ * sends to a listener registered for all CPUs (needs CAP_NET_ADMIN). Their
+ * usage is summed up by parent and command; for the processes a scan saw,
+ * only the usage since then counts.
+ */
+
+/* Rows not added to for this long are dropped */
+#define EXITED_KEEP_MS 60000
+
+/* The processes of one command that exited under one parent */
+typedef struct ExitedGroup_ {
+   unsigned int id;                /* unique over the run, from 1 on */
+   pid_t ppid;
+   char comm[16];
+   uint64_t lastExitMs;            /* monotonic */
+
+   /* in the last interval */
+   unsigned int tasks;
+   unsigned long long cpuUs;       /* user and system time */
+   unsigned long long ioBytes;     /* read from and written to storage */
+   unsigned long long peakRssKB;   /* the largest of one of them */
+
+   /* since the group was first seen */
+   unsigned long long totalTasks;
+   unsigned long long totalCpuUs;
+} ExitedGroup;
+
+/* All groups in the last interval */
+typedef struct ExitedTotals_ {
+   unsigned int tasks;
+   float cpuPercent;               /* of one CPU, NAN before the second read */
+   double ioRate;                  /* bytes per second */
+   bool listening;                 /* registered for the exit records */
+   bool lost;                      /* exit records were dropped */
+} ExitedTotals;
+
+/* Number of Exited meters in the header: while any, the exit records are read every scan */
+extern unsigned int ExitedTasks_meters;
+
+/*
+ * Reads the exit records that came in since the last call, listening from
+ * the first one on. `processTable` tells the usage already seen. False if
+ * taskstats is not available; listening is not tried again then.
+ */
+bool ExitedTasks_refresh(const Table* processTable, uint64_t monotonicMs);
+
+/* Stops listening while nothing shows the exited processes */
+void ExitedTasks_stop(void);
+
+size_t ExitedTasks_groupCount(void);
+
+const ExitedGroup* ExitedTasks_group(size_t index);
+
+/* Milliseconds of the last interval, 0 before the second read */
+uint64_t ExitedTasks_interval(void);
+
+const ExitedTotals* ExitedTasks_totals(void);
+
+void ExitedTasks_cleanup(void);
+
+#endif
@@ -0,0 +1,91 @@
+/*
+htop - linux/ExitedTasksMeter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/ExitedTasksMeter.h"
+
+#include <math.h>
+
+#include "CRT.h"
+#include "Macros.h"
+#include "Object.h"
+#include "RichString.h"
+#include "XUtils.h"
+
+#include "linux/ExitedTasks.h"
+
+
+static const int ExitedTasksMeter_attributes[] = {
+   CPU_NORMAL,
+};
+
+static void ExitedTasksMeter_init(ATTR_UNUSED Meter* this) {
+   ExitedTasks_meters++;
+}
+
+static void ExitedTasksMeter_done(ATTR_UNUSED Meter* this) {
+   ExitedTasks_meters--;
+}
+
+static void ExitedTasksMeter_updateValues(Meter* this) {
+   const ExitedTotals* totals = ExitedTasks_totals();
+
+   /* the bar is full when the exited processes kept all CPUs busy */
+   this->total = 100.0 * MAXIMUM(this->host->activeCPUs, 1);
+
+   if (isnan(totals->cpuPercent)) {
+      this->values[0] = NAN;
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "N/A");
+      return;
+   }
+
+   this->values[0] = totals->cpuPercent;
+   xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "%.1f%%/%u", totals->cpuPercent, totals->tasks);
+}
+
+static void ExitedTasksMeter_display(ATTR_UNUSED const Object* cast, RichString* out) {
+   const ExitedTotals* totals = ExitedTasks_totals();
+   char buffer[32];
+
+   RichString_writeAscii(out, CRT_colors[METER_TEXT], ": ");
+
+   if (isnan(totals->cpuPercent)) {
+      RichString_appendAscii(out, CRT_colors[METER_SHADOW], totals->listening ? "N/A" : "no exit records (needs CAP_NET_ADMIN)");
+      return;
+   }
+
+   xSnprintf(buffer, sizeof(buffer), "%.1f%%", totals->cpuPercent);
+   RichString_appendAscii(out, CRT_colors[CPU_NORMAL], buffer);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " CPU, ");
+
+   xSnprintf(buffer, sizeof(buffer), "%u", totals->tasks);
+   RichString_appendAscii(out, CRT_colors[METER_VALUE], buffer);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], totals->tasks == 1 ? " task" : " tasks");
+
+   if (totals->lost)
+      RichString_appendAscii(out, CRT_colors[METER_VALUE_WARN], " (some lost)");
+}
+
+const MeterClass ExitedTasksMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = ExitedTasksMeter_display,
+   },
+   .init = ExitedTasksMeter_init,
+   .done = ExitedTasksMeter_done,
+   .updateValues = ExitedTasksMeter_updateValues,
+   .defaultMode = TEXT_METERMODE,
+   .maxItems = 1,
+   .total = 100.0,
+   .attributes = ExitedTasksMeter_attributes,
+   .name = "ExitedTasks",
+   .uiName = "Exited processes",
+   .description = "CPU time used by the processes that exited between two scans, and their number",
+   .caption = "Exited"
+};
@@ -0,0 +1,15 @@
+#ifndef HEADER_ExitedTasksMeter
+#define HEADER_ExitedTasksMeter
+/*
+htop - linux/ExitedTasksMeter.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "Meter.h"
+
+
+extern const MeterClass ExitedTasksMeter_class;
+
+#endif
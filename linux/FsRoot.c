@@ -0,0 +1,245 @@
+/*
+htop - linux/FsRoot.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/FsRoot.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "Macros.h"
+#include "XUtils.h"
+
+
+FsRoot FsRoot_proc = {
+   .defaultPath = PROCDIR,
+   .path = NULL,
+#ifdef HAVE_OPENAT
+   .fd = -1,
+#endif
+   .kept = NULL,
+};
+
+FsRoot FsRoot_sys = {
+   .defaultPath = SYSDIR,
+   .path = NULL,
+#ifdef HAVE_OPENAT
+   .fd = -1,
+#endif
+   .kept = NULL,
+};
+
+/* Descriptors held by kept files of all roots, and how many may be */
+static size_t FsRoot_keptOpen;
+static size_t FsRoot_keptLimit;
+
+bool FsRoot_setPath(FsRoot* this, const char* path) {
+   size_t len = strlen(path);
+   while (len > 1 && path[len - 1] == '/')
+      len--;
+
+   if (len == 0)
+      return false;
+
+   free(this->path);
+   this->path = xStrndup(path, len);
+   return true;
+}
+
+bool FsRoot_open(FsRoot* this) {
+   if (!this->path)
+      this->path = xStrdup(this->defaultPath);
+
+#ifdef HAVE_OPENAT
+   if (this->fd < 0)
+      this->fd = open(this->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   return this->fd >= 0;
+#else
+   return access(this->path, R_OK) == 0;
+#endif
+}
+
+void FsRoot_close(FsRoot* this) {
+   while (this->kept) {
+      FsRootFile* file = this->kept;
+      this->kept = file->next;
+      if (file->fd >= 0) {
+         close(file->fd);
+         FsRoot_keptOpen--;
+      }
+      free(file->buffer);
+      free(file->name);
+      free(file);
+   }
+
+#ifdef HAVE_OPENAT
+   if (this->fd >= 0)
+      close(this->fd);
+   this->fd = -1;
+#endif
+   free(this->path);
+   this->path = NULL;
+}
+
+bool FsRoot_isDefault(const FsRoot* this) {
+   return !this->path || String_eq(this->path, this->defaultPath);
+}
+
+const char* FsRoot_path(const FsRoot* this, const char* relative, char* buffer, size_t size) {
+   xSnprintf(buffer, size, "%s/%s", this->path ? this->path : this->defaultPath, relative);
+   return buffer;
+}
+
+ssize_t FsRoot_readFile(const FsRoot* this, const char* relative, void* buffer, size_t count) {
+   return xReadfileat(FsRoot_dir(this), relative, buffer, count);
+}
+
+FILE* FsRoot_fopen(const FsRoot* this, const char* relative, const char* mode) {
+   assert(String_eq(mode, "r") || String_eq(mode, "r+"));
+
+   int fd = Compat_openat(FsRoot_dir(this), relative, (String_eq(mode, "r") ? O_RDONLY : O_RDWR) | O_CLOEXEC);
+   if (fd < 0)
+      return NULL;
+
+   FILE* stream = fdopen(fd, mode);
+   if (!stream)
+      close(fd);
+
+   return stream;
+}
+
+DIR* FsRoot_opendir(const FsRoot* this, const char* relative) {
+   int fd = Compat_openat(FsRoot_dir(this), relative, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   if (fd < 0)
+      return NULL;
+
+   DIR* dir = fdopendir(fd);
+   if (!dir)
+      close(fd);
+
+   return dir;
+}
+
+bool FsRoot_access(const FsRoot* this, const char* relative, int mode) {
+#ifdef HAVE_OPENAT
+   return faccessat(this->fd, relative, mode, 0) == 0;
+#else
+   char path[4096];
+   return access(FsRoot_path(this, relative, path, sizeof(path)), mode) == 0;
+#endif
+}
+
+ssize_t FsRoot_readlink(const FsRoot* this, const char* relative, char* buffer, size_t size) {
+#ifdef HAVE_OPENAT
+   return readlinkat(this->fd, relative, buffer, size);
+#else
+   char path[4096];
+   return readlink(FsRoot_path(this, relative, path, sizeof(path)), buffer, size);
+#endif
+}
+
+FsRootFile* FsRoot_keep(FsRoot* this, const char* relative) {
+   for (FsRootFile* file = this->kept; file; file = file->next) {
+      if (String_eq(file->name, relative))
+         return file;
+   }
+
+   FsRootFile* file = xCalloc(1, sizeof(FsRootFile));
+   file->root = this;
+   file->name = xStrdup(relative);
+   file->fd = -1;
+   file->next = this->kept;
+   this->kept = file;
+   return file;
+}
+
+static bool FsRootFile_open(FsRootFile* this) {
+   if (this->fd >= 0)
+      return true;
+
+   this->fd = Compat_openat(FsRoot_dir(this->root), this->name, O_RDONLY | O_CLOEXEC);
+   if (this->fd < 0)
+      return false;
+
+   FsRoot_keptOpen++;
+   return true;
+}
+
+static void FsRootFile_close(FsRootFile* this) {
+   if (this->fd < 0)
+      return;
+
+   close(this->fd);
+   this->fd = -1;
+   FsRoot_keptOpen--;
+}
+
+static ssize_t FsRootFile_readOnce(FsRootFile* this) {
+   size_t length = 0;
+
+   for (;;) {
+      if (length + 1 >= this->size) {
+         this->size = this->size ? this->size * 2 : 4096;
+         this->buffer = xRealloc(this->buffer, this->size);
+      }
+
+      ssize_t res = pread(this->fd, this->buffer + length, this->size - length - 1, (off_t)length);
+      if (res < 0) {
+         if (errno == EINTR)
+            continue;
+
+         return -1;
+      }
+      if (res == 0)
+         break;
+
+      length += (size_t)res;
+   }
+
+   this->buffer[length] = '\0';
+   return (ssize_t)length;
+}
+
+char* FsRootFile_read(FsRootFile* this, size_t* length) {
+   /* stay well below the descriptor limit, the process scan needs some too */
+   if (!FsRoot_keptLimit) {
+      struct rlimit limit;
+      FsRoot_keptLimit = 512;
+      if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+         FsRoot_keptLimit = MAXIMUM((size_t)limit.rlim_cur / 2, 1);
+   }
+
+   ssize_t res = -1;
+   for (int attempt = 0; attempt < 2 && res < 0; attempt++) {
+      /* the previous descriptor went stale, like after a sysfs entry was removed and added again */
+      if (attempt)
+         FsRootFile_close(this);
+
+      if (!FsRootFile_open(this))
+         return NULL;
+
+      res = FsRootFile_readOnce(this);
+   }
+
+   const int err = errno;
+   if (res < 0 || FsRoot_keptOpen > FsRoot_keptLimit)
+      FsRootFile_close(this);
+   errno = err;
+
+   if (res < 0)
+      return NULL;
+
+   if (length)
+      *length = (size_t)res;
+   return this->buffer;
+}
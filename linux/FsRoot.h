@@ -0,0 +1,109 @@
+#ifndef HEADER_FsRoot
+#define HEADER_FsRoot
+/*
+htop - linux/FsRoot.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <dirent.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+#include "Compat.h"
+
+
+#ifndef PROCDIR
+#define PROCDIR "/proc"
+#endif
+
+#ifndef SYSDIR
+#define SYSDIR "/sys"
+#endif
+
+struct FsRoot_;
+
+/*
+ * File read on every update, like /proc/stat: it stays open and is read
+ * again from the start with pread(), into a buffer kept with it.
+ */
+typedef struct FsRootFile_ {
+   const struct FsRoot_* root;
+   char* name;
+   int fd;                  /* -1 while closed */
+   char* buffer;
+   size_t size;
+   struct FsRootFile_* next;
+} FsRootFile;
+
+/*
+ * Where a pseudo filesystem is read from: usually where the kernel mounts
+ * it, or a bind mount of the one of another host or container, or a copy.
+ * Files are opened relative to the directory of the root.
+ */
+typedef struct FsRoot_ {
+   const char* defaultPath;
+   char* path;              /* without trailing slash, NULL until set or opened */
+#ifdef HAVE_OPENAT
+   int fd;
+#endif
+   FsRootFile* kept;        /* files registered with FsRoot_keep() */
+} FsRoot;
+
+extern FsRoot FsRoot_proc;
+extern FsRoot FsRoot_sys;
+
+/* Before FsRoot_open(), returns false on an empty path */
+bool FsRoot_setPath(FsRoot* this, const char* path);
+
+bool FsRoot_open(FsRoot* this);
+
+void FsRoot_close(FsRoot* this);
+
+/* Whether this is the filesystem of the kernel htop runs on, which live interfaces keyed by PID refer to */
+bool FsRoot_isDefault(const FsRoot* this);
+
+/* Directory argument for the *at() helpers */
+static inline openat_arg_t FsRoot_dir(const FsRoot* this) {
+#ifdef HAVE_OPENAT
+   return this->fd;
+#else
+   return this->path;
+#endif
+}
+
+/* Full path of a file below the root, for messages and interfaces without an *at() variant */
+const char* FsRoot_path(const FsRoot* this, const char* relative, char* buffer, size_t size);
+
+ssize_t FsRoot_readFile(const FsRoot* this, const char* relative, void* buffer, size_t count);
+
+/* mode is "r" or "r+" */
+FILE* FsRoot_fopen(const FsRoot* this, const char* relative, const char* mode);
+
+DIR* FsRoot_opendir(const FsRoot* this, const char* relative);
+
+bool FsRoot_access(const FsRoot* this, const char* relative, int mode);
+
+ssize_t FsRoot_readlink(const FsRoot* this, const char* relative, char* buffer, size_t size);
+
+/* Registers a file to keep open, or returns the one already registered; valid until FsRoot_close() */
+FsRootFile* FsRoot_keep(FsRoot* this, const char* relative);
+
+/*
+ * Reads the whole file into its buffer and returns it NUL terminated, or
+ * NULL with errno set. The file is reopened once if reading it fails. The
+ * contents are valid (and may be modified) until the next read.
+ */
+char* FsRootFile_read(FsRootFile* this, size_t* length);
+
+/* FsRoot_keep() and FsRootFile_read() through a handle cached by the caller */
+static inline char* FsRoot_readKept(FsRoot* this, FsRootFile** file, const char* relative, size_t* length) {
+   if (!*file)
+      *file = FsRoot_keep(this, relative);
+   return FsRootFile_read(*file, length);
+}
+
+#endif
@@ -0,0 +1,354 @@
+/*
+htop - linux/GPU.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/GPU.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Macros.h"
+#include "Row.h"
+#include "XUtils.h"
+
+
+#define GPU_ENGINE_NAME_MAX 16
+
+/* Engine names seen so far, an engine keeps its index for the whole run */
+static char GPU_engineNames[GPU_MAX_ENGINES][GPU_ENGINE_NAME_MAX];
+static unsigned int GPU_engineCapacity[GPU_MAX_ENGINES];
+static bool GPU_engineCycles[GPU_MAX_ENGINES];
+static unsigned int GPU_engines;
+
+unsigned int GPU_meters;
+
+unsigned int GPU_engineCount(void) {
+   return GPU_engines;
+}
+
+const char* GPU_engineName(unsigned int engine) {
+   return engine < GPU_engines ? GPU_engineNames[engine] : "";
+}
+
+/* Index of the engine `name`, registering it if new; -1 once all slots are taken */
+static int GPU_engineIndex(const char* name, size_t len) {
+   len = MINIMUM(len, (size_t)GPU_ENGINE_NAME_MAX - 1);
+
+   for (unsigned int i = 0; i < GPU_engines; i++) {
+      if (strncmp(GPU_engineNames[i], name, len) == 0 && GPU_engineNames[i][len] == '\0')
+         return (int)i;
+   }
+
+   if (GPU_engines >= GPU_MAX_ENGINES)
+      return -1;
+
+   memcpy(GPU_engineNames[GPU_engines], name, len);
+   GPU_engineNames[GPU_engines][len] = '\0';
+   GPU_engineCapacity[GPU_engines] = 1;
+   return (int)GPU_engines++;
+}
+
+/* What one read of the fdinfo of a DRM client gave */
+typedef struct GPUSample_ {
+   bool isClient;
+   unsigned long long id;
+   unsigned long long busy[GPU_MAX_ENGINES];
+   unsigned long long totalCycles[GPU_MAX_ENGINES];
+   unsigned long long residentKB;
+   unsigned long long memoryKB;
+   bool haveResident;
+} GPUSample;
+
+/* Memory sizes come in bytes unless a unit follows */
+static unsigned long long GPU_parseKB(const char* value) {
+   char* end;
+   unsigned long long number = strtoull(value, &end, 10);
+   while (*end == ' ' || *end == '\t')
+      end++;
+
+   if (String_startsWith(end, "KiB"))
+      return number;
+   if (String_startsWith(end, "MiB"))
+      return number * ONE_K;
+   if (String_startsWith(end, "GiB"))
+      return number * ONE_M;
+   return number / ONE_K;
+}
+
+static bool GPU_keyHasPrefix(const char* key, size_t keyLen, const char* prefix, size_t prefixLen) {
+   return keyLen > prefixLen && strncmp(key, prefix, prefixLen) == 0;
+}
+
+static void GPU_parseFdinfo(char* buffer, GPUSample* sample) {
+   memset(sample, 0, sizeof(*sample));
+
+   char* next;
+   for (char* line = buffer; line && *line; line = next) {
+      next = strchr(line, '\n');
+      if (next)
+         *next++ = '\0';
+
+      if (!String_startsWith(line, "drm-"))
+         continue;
+
+      const char* colon = strchr(line, ':');
+      if (!colon)
+         continue;
+
+      const char* key = line;
+      const size_t keyLen = (size_t)(colon - line);
+      const char* value = colon + 1;
+
+      #define GPU_PREFIX(p_) GPU_keyHasPrefix(key, keyLen, p_, strlen(p_))
+      #define GPU_ENGINE(p_) GPU_engineIndex(key + strlen(p_), keyLen - strlen(p_))
+
+      if (keyLen == strlen("drm-client-id") && String_startsWith(key, "drm-client-id")) {
+         sample->isClient = true;
+         sample->id = strtoull(value, NULL, 10);
+      } else if (GPU_PREFIX("drm-engine-capacity-")) {
+         int engine = GPU_ENGINE("drm-engine-capacity-");
+         unsigned long capacity = strtoul(value, NULL, 10);
+         if (engine >= 0 && capacity > 0)
+            GPU_engineCapacity[engine] = (unsigned int)MINIMUM(capacity, 256UL);
+      } else if (GPU_PREFIX("drm-engine-")) {
+         int engine = GPU_ENGINE("drm-engine-");
+         if (engine >= 0)
+            sample->busy[engine] = strtoull(value, NULL, 10);
+      } else if (GPU_PREFIX("drm-total-cycles-")) {
+         int engine = GPU_ENGINE("drm-total-cycles-");
+         if (engine >= 0)
+            sample->totalCycles[engine] = strtoull(value, NULL, 10);
+      } else if (GPU_PREFIX("drm-cycles-")) {
+         int engine = GPU_ENGINE("drm-cycles-");
+         if (engine >= 0) {
+            GPU_engineCycles[engine] = true;
+            sample->busy[engine] = strtoull(value, NULL, 10);
+         }
+      } else if (GPU_PREFIX("drm-resident-")) {
+         sample->haveResident = true;
+         sample->residentKB += GPU_parseKB(value);
+      } else if (GPU_PREFIX("drm-memory-")) {
+         /* older name of the resident memory */
+         sample->memoryKB += GPU_parseKB(value);
+      }
+
+      #undef GPU_ENGINE
+      #undef GPU_PREFIX
+   }
+}
+
+static bool GPU_readClient(openat_arg_t procFd, int fd, GPUSample* sample) {
+   char path[32];
+   char buffer[4096];
+   xSnprintf(path, sizeof(path), "fdinfo/%d", fd);
+
+   if (xReadfileat(procFd, path, buffer, sizeof(buffer)) <= 0)
+      return false;
+
+   GPU_parseFdinfo(buffer, sample);
+   return sample->isClient;
+}
+
+/* Whether the fd is an open DRM render or card node */
+static bool GPU_isDrmFd(openat_arg_t procFd, const char* name) {
+   char path[32];
+   char target[64];
+   xSnprintf(path, sizeof(path), "fd/%s", name);
+
+   ssize_t r = Compat_readlink(procFd, path, target, sizeof(target) - 1);
+   if (r <= 0)
+      return false;
+
+   target[r] = '\0';
+   return String_startsWith(target, "/dev/dri/");
+}
+
+/* Lists the DRM clients of the process, keeping the last reads of those already known */
+static size_t GPU_discoverClients(openat_arg_t procFd, const GPUClient* known, size_t knownCount, GPUClient** clients) {
+   *clients = NULL;
+
+   int dirFd = Compat_openat(procFd, "fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   if (dirFd < 0)
+      return 0;
+
+   DIR* dir = fdopendir(dirFd);
+   if (!dir) {
+      close(dirFd);
+      return 0;
+   }
+
+   size_t count = 0;
+   size_t size = 0;
+   const struct dirent* entry;
+   while ((entry = readdir(dir)) != NULL) {
+      char* end;
+      long fd = strtol(entry->d_name, &end, 10);
+      if (end == entry->d_name || *end != '\0' || fd < 0 || fd > INT_MAX)
+         continue;
+
+      if (!GPU_isDrmFd(procFd, entry->d_name))
+         continue;
+
+      GPUSample sample;
+      if (!GPU_readClient(procFd, (int)fd, &sample))
+         continue;
+
+      /* dup'ed fds and shared contexts show up with the same client id */
+      bool seen = false;
+      for (size_t i = 0; i < count && !seen; i++)
+         seen = (*clients)[i].id == sample.id;
+      if (seen)
+         continue;
+
+      if (count == size) {
+         size = size ? size * 2 : 4;
+         *clients = xReallocArray(*clients, size, sizeof(GPUClient));
+      }
+
+      GPUClient* client = &(*clients)[count++];
+      memset(client, 0, sizeof(*client));
+      client->fd = (int)fd;
+      client->id = sample.id;
+      for (size_t i = 0; i < knownCount; i++) {
+         if (known[i].fd == client->fd && known[i].id == client->id) {
+            *client = known[i];
+            break;
+         }
+      }
+   }
+
+   closedir(dir);
+   return count;
+}
+
+void GPUProcessData_delete(GPUProcessData* this) {
+   if (!this)
+      return;
+
+   free(this->clients);
+   free(this);
+}
+
+void GPUProcessData_update(GPUProcessData** data, openat_arg_t procFd, bool discover, uint64_t monotonicMs) {
+   GPUProcessData* this = *data;
+
+   if (discover) {
+      GPUClient* clients;
+      size_t count = GPU_discoverClients(procFd, this ? this->clients : NULL, this ? this->clientCount : 0, &clients);
+      if (count == 0) {
+         free(clients);
+         GPUProcessData_delete(this);
+         *data = NULL;
+         return;
+      }
+
+      if (!this)
+         this = *data = xCalloc(1, sizeof(GPUProcessData));
+
+      free(this->clients);
+      this->clients = clients;
+      this->clientCount = count;
+   }
+
+   if (!this)
+      return;
+
+   unsigned long long busyDelta[GPU_MAX_ENGINES] = { 0 };
+   unsigned long long cyclesDelta[GPU_MAX_ENGINES] = { 0 };
+   bool haveDelta = false;
+
+   this->timeNs = 0;
+   this->memoryKB = 0;
+
+   size_t kept = 0;
+   for (size_t i = 0; i < this->clientCount; i++) {
+      GPUClient* client = &this->clients[i];
+      GPUSample sample;
+
+      /* closed, or the fd number now refers to something else */
+      if (!GPU_readClient(procFd, client->fd, &sample) || sample.id != client->id)
+         continue;
+
+      for (unsigned int e = 0; e < GPU_engines; e++) {
+         if (client->haveLast) {
+            busyDelta[e] += saturatingSub(sample.busy[e], client->busy[e]);
+            cyclesDelta[e] = MAXIMUM(cyclesDelta[e], saturatingSub(sample.totalCycles[e], client->totalCycles[e]));
+            haveDelta = true;
+         }
+         if (!GPU_engineCycles[e])
+            this->timeNs += sample.busy[e];
+      }
+      this->memoryKB += sample.haveResident ? sample.residentKB : sample.memoryKB;
+
+      memcpy(client->busy, sample.busy, sizeof(client->busy));
+      memcpy(client->totalCycles, sample.totalCycles, sizeof(client->totalCycles));
+      client->haveLast = true;
+      this->clients[kept++] = *client;
+   }
+   this->clientCount = kept;
+
+   const uint64_t elapsedMs = this->lastMs ? monotonicMs - this->lastMs : 0;
+   this->lastMs = monotonicMs;
+   this->percent = 0.0F;
+
+   for (unsigned int e = 0; e < GPU_MAX_ENGINES; e++) {
+      double percent = 0.0;
+      if (!haveDelta) {
+         percent = 0.0;
+      } else if (GPU_engineCycles[e]) {
+         if (cyclesDelta[e] > 0)
+            percent = (double)busyDelta[e] / (double)cyclesDelta[e] * 100.0;
+      } else if (elapsedMs > 0) {
+         /* ns per ms of wall time, spread over the instances of the engine */
+         percent = (double)busyDelta[e] / ((double)elapsedMs * 10000.0) / GPU_engineCapacity[e];
+      }
+
+      this->enginePercent[e] = (float)CLAMP(percent, 0.0, 100.0);
+      this->percent = MAXIMUM(this->percent, this->enginePercent[e]);
+   }
+}
+
+int GPUProcessData_formatEngines(const GPUProcessData* this, char* buffer, size_t size) {
+   size_t len = 0;
+   buffer[0] = '\0';
+
+   for (unsigned int e = 0; this && e < GPU_engines; e++) {
+      if (this->enginePercent[e] < 0.5F)
+         continue;
+
+      int written = snprintf(buffer + len, size - len, "%s%s:%.0f%%", len ? " " : "", GPU_engineNames[e], (double)this->enginePercent[e]);
+      /* engines not fitting any more are left out */
+      if (written < 0 || (size_t)written >= size - len) {
+         buffer[len] = '\0';
+         break;
+      }
+      len += (size_t)written;
+   }
+
+   return (int)len;
+}
+
+void GPUTotals_clear(GPUTotals* this) {
+   memset(this, 0, sizeof(*this));
+}
+
+void GPUTotals_add(GPUTotals* this, const GPUProcessData* data) {
+   if (!data)
+      return;
+
+   for (unsigned int e = 0; e < GPU_MAX_ENGINES; e++)
+      this->enginePercent[e] = MINIMUM(this->enginePercent[e] + data->enginePercent[e], 100.0F);
+
+   this->memoryKB += data->memoryKB;
+   this->processes++;
+}
@@ -0,0 +1,71 @@
+#ifndef HEADER_GPU
+#define HEADER_GPU
+/*
+htop - linux/GPU.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Compat.h"
+
+
+/* Engines are told apart by their name in fdinfo, over all DRM drivers */
+#define GPU_MAX_ENGINES 16
+
+/* A DRM client (an open render or card node) of a process, see drm-usage-stats in the kernel docs */
+typedef struct GPUClient_ {
+   int fd;
+   unsigned long long id;                              /* drm-client-id, the same for dup'ed fds */
+   bool haveLast;
+   unsigned long long busy[GPU_MAX_ENGINES];           /* engine time in ns, or in cycles (xe) */
+   unsigned long long totalCycles[GPU_MAX_ENGINES];    /* GPU timestamp of cycle counting engines */
+} GPUClient;
+
+/* GPU usage of a process, from the fdinfo of its DRM clients */
+typedef struct GPUProcessData_ {
+   GPUClient* clients;          /* found by the last discovery, dropped once their fd is closed */
+   size_t clientCount;
+
+   float enginePercent[GPU_MAX_ENGINES];
+   float percent;               /* of the busiest engine */
+   unsigned long long timeNs;   /* engine time of the clients open */
+   unsigned long long memoryKB; /* resident in GPU memory regions */
+   uint64_t lastMs;
+} GPUProcessData;
+
+/* Sums over the processes read in the last scan, for the GPU meter */
+typedef struct GPUTotals_ {
+   float enginePercent[GPU_MAX_ENGINES];
+   unsigned long long memoryKB;
+   unsigned int processes;
+} GPUTotals;
+
+/* Number of GPU meters in the header: while any, all processes are looked at */
+extern unsigned int GPU_meters;
+
+unsigned int GPU_engineCount(void);
+
+const char* GPU_engineName(unsigned int engine);
+
+/*
+ * Reads the fdinfo of the DRM clients of a process again. Listing all fds
+ * of the process to find new clients costs a readlink(2) per fd, thus is
+ * only done if `discover` is set; *data is NULL for processes without any.
+ */
+void GPUProcessData_update(GPUProcessData** data, openat_arg_t procFd, bool discover, uint64_t monotonicMs);
+
+void GPUProcessData_delete(GPUProcessData* this);
+
+/* Writes the busy engines, e.g. "gfx:45% dec:3%", returns the length */
+int GPUProcessData_formatEngines(const GPUProcessData* this, char* buffer, size_t size);
+
+void GPUTotals_clear(GPUTotals* this);
+
+void GPUTotals_add(GPUTotals* this, const GPUProcessData* data);
+
+#endif
@@ -0,0 +1,101 @@
+/*
+htop - linux/GPUMeter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/GPUMeter.h"
+
+#include "CRT.h"
+#include "Machine.h"
+#include "Macros.h"
+#include "Object.h"
+#include "RichString.h"
+#include "XUtils.h"
+
+#include "linux/GPU.h"
+#include "linux/LinuxProcessTable.h"
+
+
+static const int GPUMeter_attributes[] = {
+   CPU_NORMAL
+};
+
+static void GPUMeter_init(ATTR_UNUSED Meter* this) {
+   GPU_meters++;
+}
+
+static void GPUMeter_done(ATTR_UNUSED Meter* this) {
+   GPU_meters--;
+}
+
+static const GPUTotals* GPUMeter_totals(const Meter* this) {
+   return &((const LinuxProcessTable*) this->host->processTable)->gpuTotals;
+}
+
+static void GPUMeter_updateValues(Meter* this) {
+   const GPUTotals* totals = GPUMeter_totals(this);
+
+   /* like the busiest CPU, the busiest engine tells how loaded the GPU is */
+   double busiest = 0.0;
+   for (unsigned int e = 0; e < GPU_engineCount(); e++)
+      busiest = MAXIMUM(busiest, (double)totals->enginePercent[e]);
+
+   this->values[0] = busiest;
+
+   if (GPU_engineCount() == 0) {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "N/A");
+   } else {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "%.1f%%", busiest);
+   }
+}
+
+static void GPUMeter_display(const Object* cast, RichString* out) {
+   const Meter* this = (const Meter*)cast;
+   const GPUTotals* totals = GPUMeter_totals(this);
+   char buffer[32];
+
+   RichString_writeAscii(out, CRT_colors[METER_TEXT], ": ");
+
+   if (GPU_engineCount() == 0) {
+      RichString_appendAscii(out, CRT_colors[METER_SHADOW], "no DRM clients found");
+      return;
+   }
+
+   xSnprintf(buffer, sizeof(buffer), "%.1f%%", this->values[0]);
+   RichString_appendAscii(out, CRT_colors[METER_VALUE], buffer);
+
+   for (unsigned int e = 0; e < GPU_engineCount(); e++) {
+      RichString_appendAscii(out, CRT_colors[METER_TEXT], " ");
+      RichString_appendAscii(out, CRT_colors[METER_TEXT], GPU_engineName(e));
+      RichString_appendAscii(out, CRT_colors[METER_TEXT], ":");
+      xSnprintf(buffer, sizeof(buffer), "%.1f%%", (double)totals->enginePercent[e]);
+      RichString_appendAscii(out, totals->enginePercent[e] < 0.05F ? CRT_colors[METER_SHADOW] : CRT_colors[METER_VALUE], buffer);
+   }
+
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " mem:");
+   Meter_humanUnit(buffer, (double)totals->memoryKB, sizeof(buffer));
+   RichString_appendAscii(out, CRT_colors[METER_VALUE], buffer);
+}
+
+const MeterClass GPUMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = GPUMeter_display,
+   },
+   .init = GPUMeter_init,
+   .done = GPUMeter_done,
+   .updateValues = GPUMeter_updateValues,
+   .defaultMode = BAR_METERMODE,
+   .maxItems = 1,
+   .total = 100.0,
+   .attributes = GPUMeter_attributes,
+   .name = "GPU",
+   .uiName = "GPU",
+   .description = "GPU engine usage of the processes, from the fdinfo of their DRM clients",
+   .caption = "GPU"
+};
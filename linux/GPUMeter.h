@@ -0,0 +1,15 @@
+#ifndef HEADER_GPUMeter
+#define HEADER_GPUMeter
+/*
+htop - linux/GPUMeter.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "Meter.h"
+
+
+extern const MeterClass GPUMeter_class;
+
+#endif
@@ -0,0 +1,247 @@
+/*
+htop - linux/GuestRow.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/GuestRow.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CRT.h"
+#include "DynamicColumn.h"
+#include "Macros.h"
+#include "RichString.h"
+#include "Settings.h"
+#include "Table.h"
+#include "XUtils.h"
+
+
+typedef struct GuestFieldData_ {
+   const char* name;          /* stored in htoprc as Dynamic(name) */
+   const char* heading;
+   const char* description;
+   int width;                 /* as in DynamicColumn, without the trailing space */
+} GuestFieldData;
+
+static const GuestFieldData GuestRow_fields[LAST_GUEST_FIELD] = {
+   [GUEST_FIELD_PID] = { .name = "guest_pid", .heading = "PID", .description = "Process ID of QEMU, or thread ID of the vCPU", .width = 7, },
+   [GUEST_FIELD_VCPUS] = { .name = "guest_vcpus", .heading = "VCPUS", .description = "Number of vCPU threads of the guest", .width = 5, },
+   [GUEST_FIELD_CPU_PERCENT] = { .name = "guest_cpu_percent", .heading = "VCPU%", .description = "CPU usage of the vCPU threads, summed up for the guest", .width = 5, },
+   [GUEST_FIELD_CPU_TIME] = { .name = "guest_cpu_time", .heading = "VCPU TIME", .description = "User CPU time of the vCPU threads, the time the guest ran", .width = 9, },
+   [GUEST_FIELD_RUNQ_PERCENT] = { .name = "guest_runq_percent", .heading = "RUNQ%", .description = "Share of the time a vCPU waited on a host run queue, averaged over the vCPUs for the guest; the steal the guest sees", .width = 5, },
+   [GUEST_FIELD_RSS] = { .name = "guest_rss", .heading = "RES", .description = "Resident set size of the QEMU process", .width = 5, },
+   [GUEST_FIELD_NAME] = { .name = "guest_name", .heading = "Guest", .description = "Name of the guest from the QEMU command line, or name of the vCPU thread", .width = -32, },
+};
+
+GuestRow* GuestRow_new(const Machine* host) {
+   GuestRow* this = xCalloc(1, sizeof(GuestRow));
+   Object_setClass(this, Class(GuestRow));
+   Row_init(&this->super, host);
+   this->cpuPercent = NAN;
+   this->runqPercent = NAN;
+   return this;
+}
+
+static void GuestRow_delete(Object* cast) {
+   GuestRow* this = (GuestRow*) cast;
+   Row_done(&this->super);
+   free(this);
+}
+
+/* Copies one option of a QEMU option list, ",," standing for a comma, and returns where the next one starts */
+static const char* GuestRow_copyOption(const char* option, const char* end, char* out, size_t size) {
+   size_t n = 0;
+   const char* at = option;
+   while (at < end) {
+      if (*at == ',') {
+         if (at + 1 < end && at[1] == ',') {
+            at++;
+         } else {
+            break;
+         }
+      }
+      if (n + 1 < size)
+         out[n++] = *at;
+      at++;
+   }
+   out[n] = '\0';
+   return at < end ? at + 1 : end;
+}
+
+bool GuestRow_parseName(const char* cmdline, char* name, size_t size) {
+   if (!cmdline || size == 0)
+      return false;
+
+   /* -name [guest=]name[,process=...][,debug-threads=on] */
+   const char* arg = cmdline;
+   while (arg && *arg) {
+      const char* next = strchr(arg, '\n');
+      const size_t length = next ? (size_t)(next - arg) : strlen(arg);
+      const bool found = (length == 5 && String_startsWith(arg, "-name")) || (length == 6 && String_startsWith(arg, "--name"));
+      arg = next ? next + 1 : NULL;
+      if (!found || !arg)
+         continue;
+
+      const char* value = arg;
+      const char* end = strchr(value, '\n');
+      if (!end)
+         end = value + strlen(value);
+
+      char option[64];
+      for (bool first = true; value < end; first = false) {
+         value = GuestRow_copyOption(value, end, option, sizeof(option));
+         if (String_startsWith(option, "guest=")) {
+            String_safeStrncpy(name, option + strlen("guest="), size);
+            return name[0] != '\0';
+         }
+         if (first && !strchr(option, '=')) {
+            String_safeStrncpy(name, option, size);
+            return name[0] != '\0';
+         }
+      }
+      return false;
+   }
+
+   return false;
+}
+
+static void GuestRow_writeField(const Row* super, RichString* str, RowField field) {
+   const GuestRow* this = (const GuestRow*) super;
+   const Settings* settings = super->host->settings;
+   bool coloring = settings->highlightMegabytes;
+   char buffer[256];
+   size_t n = sizeof(buffer);
+   int attr = CRT_colors[DEFAULT_COLOR];
+
+   switch ((int)field - GuestField_key(0)) {
+   case GUEST_FIELD_PID:
+      xSnprintf(buffer, n, "%*d ", Row_pidDigits, super->id);
+      break;
+   case GUEST_FIELD_VCPUS:
+      if (!this->isGuest) {
+         xSnprintf(buffer, n, "%5s ", "");
+         break;
+      }
+      if (!this->vcpus)
+         attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, "%5u ", this->vcpus);
+      break;
+   case GUEST_FIELD_CPU_PERCENT: Row_printPercentage(this->cpuPercent, buffer, n, 5, &attr); break;
+   case GUEST_FIELD_CPU_TIME: Row_printTime(str, this->cpuTime, coloring); return;
+   case GUEST_FIELD_RUNQ_PERCENT:
+      Row_printPercentage(this->runqPercent, buffer, n, 5, &attr);
+      if (isgreater(this->runqPercent, 10.0F))
+         attr = CRT_colors[LARGE_NUMBER];
+      break;
+   case GUEST_FIELD_RSS:
+      if (!this->isGuest) {
+         xSnprintf(buffer, n, "%5s ", "");
+         break;
+      }
+      Row_printKBytes(str, this->rssKB, coloring);
+      return;
+   case GUEST_FIELD_NAME:
+      if (settings->ss->treeView)
+         Row_printTreeBranch(super, str);
+      RichString_appendWide(str, this->isGuest ? CRT_colors[PROCESS_BASENAME] : CRT_colors[PROCESS_THREAD], this->name);
+      return;
+   default:
+      assert(0 && "GuestRow_writeField: default key reached"); /* should never be reached */
+      xSnprintf(buffer, n, "- ");
+      break;
+   }
+
+   RichString_appendAscii(str, attr, buffer);
+}
+
+static int GuestRow_compareByKey(const GuestRow* g1, const GuestRow* g2, RowField key) {
+   switch ((int)key - GuestField_key(0)) {
+   case GUEST_FIELD_PID:
+      return SPACESHIP_NUMBER(g1->super.id, g2->super.id);
+   case GUEST_FIELD_VCPUS:
+      return SPACESHIP_NUMBER(g1->vcpus, g2->vcpus);
+   case GUEST_FIELD_CPU_PERCENT:
+      return compareRealNumbers(g1->cpuPercent, g2->cpuPercent);
+   case GUEST_FIELD_CPU_TIME:
+      return SPACESHIP_NUMBER(g1->cpuTime, g2->cpuTime);
+   case GUEST_FIELD_RUNQ_PERCENT:
+      return compareRealNumbers(g1->runqPercent, g2->runqPercent);
+   case GUEST_FIELD_RSS:
+      return SPACESHIP_NUMBER(g1->rssKB, g2->rssKB);
+   case GUEST_FIELD_NAME:
+      return SPACESHIP_NULLSTR(g1->name, g2->name);
+   default:
+      return 0;
+   }
+}
+
+static int GuestRow_compare(const void* v1, const void* v2) {
+   const GuestRow* g1 = (const GuestRow*)v1;
+   const GuestRow* g2 = (const GuestRow*)v2;
+   const ScreenSettings* ss = g1->super.host->settings->ss;
+   RowField key = ScreenSettings_getActiveSortKey(ss);
+   int result = GuestRow_compareByKey(g1, g2, key);
+
+   // Implement tie-breaker (needed to make tree mode more stable)
+   if (!result)
+      return SPACESHIP_NUMBER(g1->super.id, g2->super.id);
+
+   return (ScreenSettings_getActiveDirection(ss) == 1) ? result : -result;
+}
+
+/* Siblings by the sort key, as Row_compareByParent_Base would order them by id */
+static int GuestRow_compareByParent(const Row* r1, const Row* r2) {
+   int result = SPACESHIP_NUMBER(
+      r1->isRoot ? 0 : Row_getGroupOrParent(r1),
+      r2->isRoot ? 0 : Row_getGroupOrParent(r2)
+   );
+
+   if (result != 0)
+      return result;
+
+   return GuestRow_compare(r1, r2);
+}
+
+static const char* GuestRow_sortKeyString(Row* super) {
+   const GuestRow* this = (const GuestRow*) super;
+   return this->name;
+}
+
+static bool GuestRow_matchesFilter(Row* super, const Table* table) {
+   const GuestRow* this = (const GuestRow*) super;
+   return !FilterMatcher_matches(&table->filter, this->name);
+}
+
+void GuestRow_addColumns(Hashtable* columns) {
+   for (int i = 0; i < LAST_GUEST_FIELD; i++) {
+      const GuestFieldData* data = &GuestRow_fields[i];
+      DynamicColumn* column = xCalloc(1, sizeof(DynamicColumn));
+      String_safeStrncpy(column->name, data->name, sizeof(column->name));
+      column->heading = xStrdup(data->heading);
+      column->caption = xStrdup(data->heading);
+      column->description = xStrdup(data->description);
+      column->width = data->width;
+      column->enabled = true;
+      Hashtable_put(columns, GuestField_key(i), column);
+   }
+}
+
+const RowClass GuestRow_class = {
+   .super = {
+      .extends = Class(Row),
+      .display = Row_display,
+      .delete = GuestRow_delete,
+      .compare = GuestRow_compare,
+   },
+   .writeField = GuestRow_writeField,
+   .matchesFilter = GuestRow_matchesFilter,
+   .sortKeyString = GuestRow_sortKeyString,
+   .compareByParent = GuestRow_compareByParent,
+};
@@ -0,0 +1,64 @@
+#ifndef HEADER_GuestRow
+#define HEADER_GuestRow
+/*
+htop - linux/GuestRow.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "Hashtable.h"
+#include "Machine.h"
+#include "Object.h"
+#include "Row.h"
+#include "RowField.h"
+#include "linux/ExitedTaskRow.h"
+
+
+/* Columns of the virtual machine screen, keyed after the ones of the exited processes screen */
+typedef enum GuestField_ {
+   GUEST_FIELD_PID,
+   GUEST_FIELD_VCPUS,
+   GUEST_FIELD_CPU_PERCENT,
+   GUEST_FIELD_CPU_TIME,
+   GUEST_FIELD_RUNQ_PERCENT,
+   GUEST_FIELD_RSS,
+   GUEST_FIELD_NAME,
+   LAST_GUEST_FIELD
+} GuestField;
+
+#define GuestField_key(f_)  ((RowField)(ExitedTaskField_key(LAST_EXITEDTASK_FIELD) + (f_)))
+
+/* A QEMU process with the sums of its vCPU threads, or one of the threads */
+typedef struct GuestRow_ {
+   Row super;
+
+   bool isGuest;
+   bool named;                     /* the name was parsed from the command line */
+   char name[64];
+
+   unsigned int vcpus;
+   float cpuPercent;
+   unsigned long long cpuTime;     /* user time of the vCPU threads, in hundredths of a second */
+   float runqPercent;              /* of the guest, averaged over its vCPUs */
+   unsigned int runqVcpus;         /* vCPUs whose wait is known yet */
+   unsigned long long rssKB;
+} GuestRow;
+
+extern const RowClass GuestRow_class;
+
+GuestRow* GuestRow_new(const Machine* host);
+
+/*
+ * Takes the name of the guest from the "-name" argument of the QEMU command
+ * line, `cmdline` having its arguments separated by newlines; false without one.
+ */
+bool GuestRow_parseName(const char* cmdline, char* name, size_t size);
+
+/* Adds the dynamic columns of the virtual machine screen to `columns` */
+void GuestRow_addColumns(Hashtable* columns);
+
+#endif
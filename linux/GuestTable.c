@@ -0,0 +1,161 @@
+/*
+htop - linux/GuestTable.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/GuestTable.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Macros.h"
+#include "Object.h"
+#include "Row.h"
+#include "Settings.h"
+#include "Vector.h"
+#include "XUtils.h"
+
+#include "linux/GuestRow.h"
+#include "linux/LinuxProcess.h"
+
+
+GuestTable* GuestTable_new(Machine* host) {
+   GuestTable* this = xCalloc(1, sizeof(GuestTable));
+   Object_setClass(this, Class(GuestTable));
+   Table_init(&this->super, Class(GuestRow), host);
+   return this;
+}
+
+static void GuestTable_delete(Object* cast) {
+   GuestTable* this = (GuestTable*) cast;
+   Table_done(&this->super);
+   free(this);
+}
+
+bool GuestTable_isGuest(const Process* proc) {
+   /* qemu-kvm, qemu-system-x86_64 (truncated by the kernel) and the like */
+   return proc->procComm && String_startsWith(proc->procComm, "qemu");
+}
+
+bool GuestTable_isVcpu(const Process* main, const Process* thread) {
+   /* "CPU 0/KVM", "CPU 12/TCG" */
+   const char* comm = thread->procComm;
+   if (!comm || !String_startsWith(comm, "CPU ") || !GuestTable_isGuest(main))
+      return false;
+
+   const char* at = comm + strlen("CPU ");
+   if (!isdigit((unsigned char)*at))
+      return false;
+
+   while (isdigit((unsigned char)*at))
+      at++;
+
+   return *at == '/';
+}
+
+static GuestRow* GuestTable_getRow(Table* super, int id, int parent) {
+   GuestRow* row = (GuestRow*) Table_findRow(super, id);
+   if (row) {
+      row->super.tombStampMs = 0;
+   } else {
+      row = GuestRow_new(super->host);
+      row->super.id = id;
+      row->super.group = id;
+      Table_add(super, &row->super);
+   }
+
+   row->super.parent = parent;
+   Table_markUpdated(super, &row->super);
+   row->super.show = true;
+   return row;
+}
+
+static void GuestTable_iterateEntries(Table* super) {
+   const Machine* host = super->host;
+   const Table* processTable = host->processTable;
+   if (!processTable)
+      return;
+
+   const Vector* processes = processTable->rows;
+   const bool threadsListed = !host->settings->hideUserlandThreads;
+
+   for (int i = 0; i < Vector_size(processes); i++) {
+      const Process* proc = (const Process*) Vector_get(processes, i);
+      if (Process_isThread(proc) || proc->super.tombStampMs > 0 || !Table_isUpdated(processTable, &proc->super) || !GuestTable_isGuest(proc))
+         continue;
+
+      GuestRow* row = GuestTable_getRow(super, Process_getPid(proc), 0);
+      row->isGuest = true;
+
+      /* the command line of QEMU does not change, it is parsed until a name is found in it */
+      if (!row->named) {
+         row->named = GuestRow_parseName(proc->cmdline, row->name, sizeof(row->name));
+         if (!row->named)
+            String_safeStrncpy(row->name, proc->procComm, sizeof(row->name));
+      }
+
+      row->vcpus = 0;
+      row->cpuPercent = threadsListed ? 0.0F : NAN;
+      row->cpuTime = 0;
+      row->runqPercent = NAN;
+      row->runqVcpus = 0;
+      row->rssKB = proc->m_resident > 0 ? (unsigned long long)proc->m_resident : 0;
+   }
+
+   if (!threadsListed)
+      return;
+
+   /* the vCPU threads, from what the scan read of them */
+   for (int i = 0; i < Vector_size(processes); i++) {
+      const Process* proc = (const Process*) Vector_get(processes, i);
+      if (!Process_isUserlandThread(proc) || proc->super.tombStampMs > 0 || !Table_isUpdated(processTable, &proc->super))
+         continue;
+
+      const pid_t tgid = Process_getThreadGroup(proc);
+      GuestRow* guest = (GuestRow*) Table_findRow(super, tgid);
+      if (!guest || !guest->isGuest || !Table_isUpdated(super, &guest->super))
+         continue;
+
+      const Process* main = (const Process*) Table_findRow(processTable, tgid);
+      if (!main || !GuestTable_isVcpu(main, proc))
+         continue;
+
+      const LinuxProcess* lp = (const LinuxProcess*) proc;
+      GuestRow* row = GuestTable_getRow(super, Process_getPid(proc), tgid);
+      String_safeStrncpy(row->name, proc->procComm, sizeof(row->name));
+      row->cpuPercent = proc->percent_cpu;
+      row->cpuTime = lp->utime;
+      row->runqPercent = LinuxProcess_runqWaitPercent(LinuxProcess_getDetails(lp));
+
+      guest->vcpus++;
+      if (isNonnegative(row->cpuPercent))
+         guest->cpuPercent += row->cpuPercent;
+      guest->cpuTime += row->cpuTime;
+      if (!isnan(row->runqPercent)) {
+         guest->runqPercent = guest->runqVcpus ? guest->runqPercent + row->runqPercent : row->runqPercent;
+         guest->runqVcpus++;
+      }
+   }
+
+   for (int i = 0; i < Vector_size(super->rows); i++) {
+      GuestRow* row = (GuestRow*) Vector_get(super->rows, i);
+      if (row->isGuest && row->runqVcpus > 1 && Table_isUpdated(super, &row->super))
+         row->runqPercent /= (float)row->runqVcpus;
+   }
+}
+
+const TableClass GuestTable_class = {
+   .super = {
+      .extends = Class(Table),
+      .delete = GuestTable_delete,
+   },
+   .prepare = Table_prepareEntries,
+   .iterate = GuestTable_iterateEntries,
+   .cleanup = Table_cleanupEntries,
+};
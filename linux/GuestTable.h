@@ -0,0 +1,37 @@
+#ifndef HEADER_GuestTable
+#define HEADER_GuestTable
+/*
+htop - linux/GuestTable.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+
+#include "Machine.h"
+#include "Process.h"
+#include "Table.h"
+
+
+/*
+ * One row per QEMU process of the process table, named after its guest,
+ * with one below it per vCPU thread. vCPU threads are the ones QEMU names
+ * "CPU n/KVM", which it does with -name debug-threads=on (as libvirt runs
+ * it); they are only listed while userland threads are not hidden.
+ */
+typedef struct GuestTable_ {
+   Table super;
+} GuestTable;
+
+extern const TableClass GuestTable_class;
+
+GuestTable* GuestTable_new(Machine* host);
+
+/* Whether the process is QEMU, from its name */
+bool GuestTable_isGuest(const Process* proc);
+
+/* Whether the thread of `main` is one of its vCPUs, from their names */
+bool GuestTable_isVcpu(const Process* main, const Process* thread);
+
+#endif
@@ -0,0 +1,209 @@
+/*
+htop - linux/IODevices.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/IODevices.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Macros.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+#include "linux/SourceCache.h"
+
+
+static IODeviceList IODevices_lists[IODEVICE_KINDS];
+static FsRootFile* IODevices_files[IODEVICE_KINDS];
+
+static const char* const IODevices_fileNames[IODEVICE_KINDS] = {
+   [IODEVICE_DISK] = "diskstats",
+   [IODEVICE_NETWORK] = "net/dev",
+};
+
+static const SourceCacheKey IODevices_sources[IODEVICE_KINDS] = {
+   [IODEVICE_DISK] = SOURCE_DISKSTATS,
+   [IODEVICE_NETWORK] = SOURCE_NET_DEV,
+};
+
+/* Which of the numbers after the name are the counters, in increasing order */
+static const unsigned int IODevices_diskPositions[IODEVICE_DISK_COUNTERS] = {
+   [IODEVICE_DISK_READ] = 2,        /* sectors read */
+   [IODEVICE_DISK_WRITTEN] = 6,     /* sectors written */
+   [IODEVICE_DISK_BUSY_MS] = 9,     /* milliseconds doing I/O */
+};
+
+static const unsigned int IODevices_networkPositions[IODEVICE_NETWORK_COUNTERS] = {
+   [IODEVICE_NETWORK_RX_BYTES] = 0,
+   [IODEVICE_NETWORK_RX_PACKETS] = 1,
+   [IODEVICE_NETWORK_TX_BYTES] = 8,
+   [IODEVICE_NETWORK_TX_PACKETS] = 9,
+};
+
+static inline char* IODevices_skipSpaces(char* p) {
+   while (*p == ' ' || *p == '\t')
+      p++;
+   return p;
+}
+
+static inline char* IODevices_skipNumber(char* p) {
+   p = IODevices_skipSpaces(p);
+   while (*p >= '0' && *p <= '9')
+      p++;
+   return p;
+}
+
+/* Reads the counters at the given positions among the numbers in `p`, false if the line ends before */
+static bool IODevices_readCounters(char* p, const unsigned int* positions, size_t count, unsigned long long* counters) {
+   unsigned int position = 0;
+   for (size_t i = 0; i < count; position++) {
+      p = IODevices_skipSpaces(p);
+      if (*p < '0' || *p > '9')
+         return false;
+
+      if (position == positions[i]) {
+         counters[i++] = strtoull(p, &p, 10);
+      } else {
+         p = IODevices_skipNumber(p);
+      }
+   }
+   return true;
+}
+
+static bool IODevices_isCounted(const IODeviceList* this, IODeviceKind kind, const char* name, const char* lastDisk) {
+   if (this->exclude.pattern && FilterMatcher_matches(&this->exclude, name))
+      return false;
+
+   if (kind == IODEVICE_DISK) {
+      /* only count whole disks, e.g. do not count IO from sda and sda1 twice; this assumes disks are listed directly before their partitions */
+      if (lastDisk[0] && String_startsWith(name, lastDisk))
+         return false;
+
+      if (this->include.pattern)
+         return FilterMatcher_matches(&this->include, name);
+
+      return !String_startsWith(name, "dm-") && !String_startsWith(name, "zram");
+   }
+
+   if (this->include.pattern)
+      return FilterMatcher_matches(&this->include, name);
+
+   return !String_eq(name, "lo");
+}
+
+static IODevice* IODevices_add(IODeviceList* this) {
+   if (this->count == this->alloc) {
+      this->alloc = this->alloc ? this->alloc * 2 : 8;
+      this->devices = xReallocArray(this->devices, this->alloc, sizeof(IODevice));
+   }
+
+   return &this->devices[this->count++];
+}
+
+static void IODevices_read(IODeviceList* this, IODeviceKind kind) {
+   this->count = 0;
+
+   char* content = FsRoot_readKept(&FsRoot_proc, &IODevices_files[kind], IODevices_fileNames[kind], NULL);
+   this->valid = content != NULL;
+   if (!content)
+      return;
+
+   const unsigned int* positions = kind == IODEVICE_DISK ? IODevices_diskPositions : IODevices_networkPositions;
+   const size_t counters = kind == IODEVICE_DISK ? IODEVICE_DISK_COUNTERS : IODEVICE_NETWORK_COUNTERS;
+
+   char lastDisk[IODEVICE_NAME_LEN] = { '\0' };
+
+   for (char* line = content; line && *line; ) {
+      char* next = strchr(line, '\n');
+      if (next)
+         *next++ = '\0';
+
+      /* disks follow their major and minor numbers, interfaces end with a colon */
+      char* name;
+      char* end;
+      if (kind == IODEVICE_DISK) {
+         name = IODevices_skipSpaces(IODevices_skipNumber(IODevices_skipNumber(line)));
+         end = name;
+         while (*end && *end != ' ' && *end != '\t')
+            end++;
+      } else {
+         name = IODevices_skipSpaces(line);
+         end = strchr(name, ':');
+      }
+
+      if (!end || end == name || (size_t)(end - name) >= IODEVICE_NAME_LEN) {
+         line = next;
+         continue;
+      }
+
+      char* rest = *end ? end + 1 : end;
+      *end = '\0';
+
+      if (IODevices_isCounted(this, kind, name, lastDisk)) {
+         IODevice* device = IODevices_add(this);
+         if (IODevices_readCounters(rest, positions, counters, device->counters)) {
+            memcpy(device->name, name, (size_t)(end - name) + 1);
+            if (kind == IODEVICE_DISK)
+               String_safeStrncpy(lastDisk, name, sizeof(lastDisk));
+         } else {
+            this->count--;
+         }
+      }
+
+      line = next;
+   }
+}
+
+void IODevices_setPatterns(const Settings* settings) {
+   IODeviceList* disks = &IODevices_lists[IODEVICE_DISK];
+   FilterMatcher_update(&disks->include, settings->diskIODevices);
+   FilterMatcher_update(&disks->exclude, settings->diskIOExclude);
+
+   IODeviceList* interfaces = &IODevices_lists[IODEVICE_NETWORK];
+   FilterMatcher_update(&interfaces->include, settings->networkIODevices);
+   FilterMatcher_update(&interfaces->exclude, settings->networkIOExclude);
+}
+
+const IODeviceList* IODevices_get(IODeviceKind kind) {
+   assert(kind < IODEVICE_KINDS);
+
+   IODeviceList* this = &IODevices_lists[kind];
+   if (SourceCache_isStale(IODevices_sources[kind]))
+      IODevices_read(this, kind);
+
+   return this;
+}
+
+const IODevice* IODevices_find(const IODeviceList* this, const char* name, size_t* hint) {
+   if (*hint < this->count && String_eq(this->devices[*hint].name, name))
+      return &this->devices[*hint];
+
+   for (size_t i = 0; i < this->count; i++) {
+      if (String_eq(this->devices[i].name, name)) {
+         *hint = i;
+         return &this->devices[i];
+      }
+   }
+
+   return NULL;
+}
+
+void IODevices_done(void) {
+   for (size_t kind = 0; kind < IODEVICE_KINDS; kind++) {
+      IODeviceList* this = &IODevices_lists[kind];
+      free(this->devices);
+      FilterMatcher_done(&this->include);
+      FilterMatcher_done(&this->exclude);
+      *this = (IODeviceList) { .valid = false };
+
+      /* freed by FsRoot_close() */
+      IODevices_files[kind] = NULL;
+   }
+}
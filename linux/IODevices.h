@@ -0,0 +1,79 @@
+#ifndef HEADER_IODevices
+#define HEADER_IODevices
+/*
+htop - linux/IODevices.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "FilterMatcher.h"
+#include "Settings.h"
+
+
+typedef enum IODeviceKind_ {
+   IODEVICE_DISK,       /* from /proc/diskstats */
+   IODEVICE_NETWORK,    /* from /proc/net/dev */
+   IODEVICE_KINDS
+} IODeviceKind;
+
+/* Counters of a disk, in sectors of 512 bytes and milliseconds busy */
+enum {
+   IODEVICE_DISK_READ,
+   IODEVICE_DISK_WRITTEN,
+   IODEVICE_DISK_BUSY_MS,
+   IODEVICE_DISK_COUNTERS
+};
+
+/* Counters of a network interface */
+enum {
+   IODEVICE_NETWORK_RX_BYTES,
+   IODEVICE_NETWORK_RX_PACKETS,
+   IODEVICE_NETWORK_TX_BYTES,
+   IODEVICE_NETWORK_TX_PACKETS,
+   IODEVICE_NETWORK_COUNTERS
+};
+
+#define IODEVICE_COUNTERS IODEVICE_NETWORK_COUNTERS
+#define IODEVICE_NAME_LEN 32
+
+typedef struct IODevice_ {
+   char name[IODEVICE_NAME_LEN];
+   unsigned long long counters[IODEVICE_COUNTERS];   /* IODEVICE_DISK_COUNTERS of them for disks */
+} IODevice;
+
+/*
+ * The devices counted by the disk and network IO meters, in the order the
+ * kernel lists them. Without an include pattern these are the whole disks
+ * but device mapper and zram ones, respectively all interfaces but the
+ * loopback one; an include pattern picks the devices instead. Lines of
+ * devices left out are skipped without parsing their counters.
+ */
+typedef struct IODeviceList_ {
+   IODevice* devices;
+   size_t count;
+   size_t alloc;
+   bool valid;                /* false if the file could not be read */
+   FilterMatcher include;     /* devices counted, no pattern for the default ones */
+   FilterMatcher exclude;     /* devices left out, no pattern for none */
+} IODeviceList;
+
+/* Takes the patterns of the devices counted and left out from the settings, compiled only when changed */
+void IODevices_setPatterns(const Settings* settings);
+
+/* The devices as read for the current Machine_scan(), the file is read on the first call of a cycle */
+const IODeviceList* IODevices_get(IODeviceKind kind);
+
+/*
+ * Finds a device by name; `hint` is where it was found before and is
+ * updated, so a device not moving in the list is found at once. NULL if
+ * the device is gone or no longer counted.
+ */
+const IODevice* IODevices_find(const IODeviceList* this, const char* name, size_t* hint);
+
+void IODevices_done(void);
+
+#endif
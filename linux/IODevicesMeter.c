@@ -0,0 +1,360 @@
+/*
+htop - linux/IODevicesMeter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/IODevicesMeter.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CRT.h"
+#include "Machine.h"
+#include "Macros.h"
+#include "Object.h"
+#include "Rate.h"
+#include "RichString.h"
+#include "XUtils.h"
+
+#include "linux/IODevices.h"
+
+
+/* Devices shown at most, pick them with disk_io_devices or network_io_devices */
+#define IODEVICES_METER_MAX 32
+
+/* State of the line of one device */
+typedef struct IODeviceMeterData_ {
+   IODeviceKind kind;
+   char name[IODEVICE_NAME_LEN];
+   char caption[IODEVICE_NAME_LEN + 2];   /* the name, followed by ": " in text mode */
+   char shortCaption[4];                  /* last characters of the name, for the modes with a short caption */
+   size_t hint;                           /* where the device was found in the list last time */
+   Rate rates[IODEVICE_COUNTERS];
+   double values[IODEVICE_COUNTERS];      /* change per second of each counter */
+   MeterRateStatus status;
+} IODeviceMeterData;
+
+/* One line per device counted when the meter was set up */
+typedef struct IODevicesMeterData_ {
+   IODeviceMeterData* devices;
+   Meter** meters;
+   size_t count;
+   uint64_t lastUpdateMs;
+} IODevicesMeterData;
+
+static const int DiskIODeviceMeter_attributes[] = {
+   METER_VALUE_NOTICE,
+};
+
+static const int NetworkIODeviceMeter_attributes[] = {
+   METER_VALUE_IOREAD,
+   METER_VALUE_IOWRITE,
+};
+
+static const char* IODeviceMeter_getCaption(const Meter* this) {
+   const IODeviceMeterData* data = this->meterData;
+   return this->mode == TEXT_METERMODE ? data->caption : data->shortCaption;
+}
+
+static bool IODeviceMeter_displayStatus(const IODeviceMeterData* data, RichString* out) {
+   switch (data->status) {
+      case RATESTATUS_NODATA:
+         RichString_writeAscii(out, CRT_colors[METER_VALUE_ERROR], "gone");
+         return true;
+      case RATESTATUS_INIT:
+         RichString_writeAscii(out, CRT_colors[METER_VALUE], "initializing...");
+         return true;
+      case RATESTATUS_STALE:
+         RichString_writeAscii(out, CRT_colors[METER_VALUE_WARN], "stale data");
+         return true;
+      case RATESTATUS_DATA:
+         break;
+   }
+   return false;
+}
+
+static void DiskIODeviceMeter_display(const Object* cast, RichString* out) {
+   const Meter* this = (const Meter*)cast;
+   const IODeviceMeterData* data = this->meterData;
+   if (IODeviceMeter_displayStatus(data, out))
+      return;
+
+   char buffer[16];
+   const double busy = this->values[0];
+   int color = busy > 40.0 ? METER_VALUE_NOTICE : METER_VALUE;
+   int len = xSnprintf(buffer, sizeof(buffer), "%.1f%%", busy);
+   RichString_appendnAscii(out, CRT_colors[color], buffer, len);
+
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " read: ");
+   Meter_humanUnit(buffer, data->values[IODEVICE_DISK_READ] / ONE_K, sizeof(buffer));
+   RichString_appendAscii(out, CRT_colors[METER_VALUE_IOREAD], buffer);
+   RichString_appendAscii(out, CRT_colors[METER_VALUE_IOREAD], "iB/s");
+
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " write: ");
+   Meter_humanUnit(buffer, data->values[IODEVICE_DISK_WRITTEN] / ONE_K, sizeof(buffer));
+   RichString_appendAscii(out, CRT_colors[METER_VALUE_IOWRITE], buffer);
+   RichString_appendAscii(out, CRT_colors[METER_VALUE_IOWRITE], "iB/s");
+}
+
+static void NetworkIODeviceMeter_display(const Object* cast, RichString* out) {
+   const Meter* this = (const Meter*)cast;
+   const IODeviceMeterData* data = this->meterData;
+   if (IODeviceMeter_displayStatus(data, out))
+      return;
+
+   char buffer[64];
+
+   RichString_writeAscii(out, CRT_colors[METER_TEXT], "rx: ");
+   Meter_humanUnit(buffer, data->values[IODEVICE_NETWORK_RX_BYTES] / ONE_K, sizeof(buffer));
+   RichString_appendAscii(out, CRT_colors[METER_VALUE_IOREAD], buffer);
+   RichString_appendAscii(out, CRT_colors[METER_VALUE_IOREAD], "iB/s");
+
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " tx: ");
+   Meter_humanUnit(buffer, data->values[IODEVICE_NETWORK_TX_BYTES] / ONE_K, sizeof(buffer));
+   RichString_appendAscii(out, CRT_colors[METER_VALUE_IOWRITE], buffer);
+   RichString_appendAscii(out, CRT_colors[METER_VALUE_IOWRITE], "iB/s");
+
+   int len = xSnprintf(buffer, sizeof(buffer), " (%u/%u pkts/s)",
+      (unsigned int)data->values[IODEVICE_NETWORK_RX_PACKETS], (unsigned int)data->values[IODEVICE_NETWORK_TX_PACKETS]);
+   RichString_appendnAscii(out, CRT_colors[METER_TEXT], buffer, len);
+}
+
+static void IODeviceMeter_noUpdate(ATTR_UNUSED Meter* this) {
+   /* updated by the meter of all devices, which reads the list once for them */
+}
+
+static const MeterClass DiskIODeviceMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = DiskIODeviceMeter_display
+   },
+   .updateValues = IODeviceMeter_noUpdate,
+   .defaultMode = TEXT_METERMODE,
+   .maxItems = 1,
+   .total = 100.0,
+   .attributes = DiskIODeviceMeter_attributes,
+   .name = "DiskIODevice",
+   .uiName = "Disk IO of a device",
+   .caption = "",
+   .getCaption = IODeviceMeter_getCaption
+};
+
+static const MeterClass NetworkIODeviceMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = NetworkIODeviceMeter_display
+   },
+   .updateValues = IODeviceMeter_noUpdate,
+   .defaultMode = TEXT_METERMODE,
+   .maxItems = 2,
+   .total = 100.0,
+   .attributes = NetworkIODeviceMeter_attributes,
+   .name = "NetworkIODevice",
+   .uiName = "Network IO of an interface",
+   .caption = "",
+   .getCaption = IODeviceMeter_getCaption
+};
+
+static IODeviceKind IODevicesMeter_kind(const Meter* this) {
+   return As_Meter(this) == &DiskIODevicesMeter_class ? IODEVICE_DISK : IODEVICE_NETWORK;
+}
+
+static void IODevicesMeter_setHeight(Meter* this) {
+   const IODevicesMeterData* data = this->meterData;
+   this->h = Meter_modes[this->mode]->h * MAXIMUM((int)data->count, 1);
+}
+
+/* Takes the devices counted now, they stay the same until the meter is set up again */
+static void IODevicesMeter_init(Meter* this) {
+   IODevicesMeterData* data = this->meterData;
+   if (!data) {
+      const IODeviceKind kind = IODevicesMeter_kind(this);
+      /* the header is set up before the first scan sets them */
+      IODevices_setPatterns(this->host->settings);
+      const IODeviceList* list = IODevices_get(kind);
+
+      data = this->meterData = xCalloc(1, sizeof(IODevicesMeterData));
+      data->count = MINIMUM(list->count, IODEVICES_METER_MAX);
+      data->devices = xCalloc(MAXIMUM(data->count, 1), sizeof(IODeviceMeterData));
+      data->meters = xCalloc(MAXIMUM(data->count, 1), sizeof(Meter*));
+
+      const MeterClass* type = kind == IODEVICE_DISK ? &DiskIODeviceMeter_class : &NetworkIODeviceMeter_class;
+      for (size_t i = 0; i < data->count; i++) {
+         IODeviceMeterData* device = &data->devices[i];
+         const char* name = list->devices[i].name;
+         const size_t len = strlen(name);
+         device->kind = kind;
+         String_safeStrncpy(device->name, name, sizeof(device->name));
+         device->hint = i;
+         device->status = RATESTATUS_INIT;
+         xSnprintf(device->caption, sizeof(device->caption), "%s: ", name);
+         String_safeStrncpy(device->shortCaption, name + (len > 3 ? len - 3 : 0), sizeof(device->shortCaption));
+
+         data->meters[i] = Meter_new(this->host, 0, type);
+         data->meters[i]->meterData = device;
+      }
+   }
+
+   if (this->mode == 0)
+      this->mode = BAR_METERMODE;
+
+   for (size_t i = 0; i < data->count; i++)
+      Meter_setMode(data->meters[i], this->mode);
+
+   IODevicesMeter_setHeight(this);
+}
+
+static void IODevicesMeter_updateMode(Meter* this, int mode) {
+   IODevicesMeterData* data = this->meterData;
+   this->mode = mode;
+   for (size_t i = 0; i < data->count; i++)
+      Meter_setMode(data->meters[i], mode);
+
+   IODevicesMeter_setHeight(this);
+}
+
+static void IODevicesMeter_updateDevice(Meter* meter, const IODeviceList* list, uint64_t nowMs, uint64_t passedMs) {
+   IODeviceMeterData* data = meter->meterData;
+   const IODevice* device = IODevices_find(list, data->name, &data->hint);
+   if (!device) {
+      data->status = RATESTATUS_NODATA;
+      for (size_t i = 0; i < IODEVICE_COUNTERS; i++)
+         Rate_reset(&data->rates[i]);
+      meter->values[0] = 0.0;
+      if (data->kind == IODEVICE_NETWORK)
+         meter->values[1] = 0.0;
+      xSnprintf(meter->txtBuffer, sizeof(meter->txtBuffer), "gone");
+      return;
+   }
+
+   bool known = true;
+   const size_t counters = data->kind == IODEVICE_DISK ? IODEVICE_DISK_COUNTERS : IODEVICE_NETWORK_COUNTERS;
+   for (size_t i = 0; i < counters; i++) {
+      /* disks count sectors of 512 bytes but for the time busy */
+      unsigned long long counter = device->counters[i];
+      if (data->kind == IODEVICE_DISK && i != IODEVICE_DISK_BUSY_MS)
+         counter *= 512;
+
+      data->values[i] = Rate_update(&data->rates[i], counter, nowMs);
+      if (isnan(data->values[i]))
+         known = false;
+   }
+
+   data->status = !known ? RATESTATUS_INIT : passedMs > 30000 ? RATESTATUS_STALE : RATESTATUS_DATA;
+   if (data->status != RATESTATUS_DATA) {
+      meter->values[0] = 0.0;
+      if (data->kind == IODEVICE_NETWORK)
+         meter->values[1] = 0.0;
+      xSnprintf(meter->txtBuffer, sizeof(meter->txtBuffer), data->status == RATESTATUS_INIT ? "init" : "stale");
+      return;
+   }
+
+   char read[6];
+   char written[6];
+   if (data->kind == IODEVICE_DISK) {
+      /* milliseconds busy per second */
+      meter->values[0] = MINIMUM(data->values[IODEVICE_DISK_BUSY_MS] / 10.0, 100.0);
+      Meter_humanUnit(read, data->values[IODEVICE_DISK_READ] / ONE_K, sizeof(read));
+      Meter_humanUnit(written, data->values[IODEVICE_DISK_WRITTEN] / ONE_K, sizeof(written));
+      xSnprintf(meter->txtBuffer, sizeof(meter->txtBuffer), "r:%siB/s w:%siB/s %.1f%%", read, written, meter->values[0]);
+   } else {
+      meter->values[0] = data->values[IODEVICE_NETWORK_RX_BYTES];
+      meter->values[1] = data->values[IODEVICE_NETWORK_TX_BYTES];
+      if (meter->values[0] + meter->values[1] > meter->total)
+         meter->total = meter->values[0] + meter->values[1];
+
+      Meter_humanUnit(read, meter->values[0] / ONE_K, sizeof(read));
+      Meter_humanUnit(written, meter->values[1] / ONE_K, sizeof(written));
+      xSnprintf(meter->txtBuffer, sizeof(meter->txtBuffer), "rx:%siB/s tx:%siB/s", read, written);
+   }
+}
+
+static void IODevicesMeter_updateValues(Meter* this) {
+   IODevicesMeterData* data = this->meterData;
+   const Machine* host = this->host;
+
+   /* update only every 500ms to have a sane span for rate calculation */
+   uint64_t passedMs = host->realtimeMs - data->lastUpdateMs;
+   if (passedMs <= 500)
+      return;
+
+   data->lastUpdateMs = host->realtimeMs;
+
+   const IODeviceList* list = IODevices_get(IODevicesMeter_kind(this));
+   for (size_t i = 0; i < data->count; i++)
+      IODevicesMeter_updateDevice(data->meters[i], list, host->realtimeMs, passedMs);
+}
+
+static void IODevicesMeter_display(ATTR_UNUSED const Object* cast, RichString* out) {
+   RichString_writeAscii(out, CRT_colors[METER_VALUE_ERROR], "no devices");
+}
+
+static void IODevicesMeter_draw(Meter* this, int x, int y, int w) {
+   const IODevicesMeterData* data = this->meterData;
+   if (data->count == 0) {
+      Meter_modes[TEXT_METERMODE]->draw(this, x, y, w);
+      return;
+   }
+
+   for (size_t i = 0; i < data->count; i++) {
+      Meter* meter = data->meters[i];
+      meter->draw(meter, x, y, w);
+      y += meter->h;
+   }
+}
+
+static void IODevicesMeter_done(Meter* this) {
+   IODevicesMeterData* data = this->meterData;
+   for (size_t i = 0; i < data->count; i++)
+      Meter_delete((Object*)data->meters[i]);
+   free(data->meters);
+   free(data->devices);
+   free(data);
+}
+
+const MeterClass DiskIODevicesMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = IODevicesMeter_display
+   },
+   .updateValues = IODevicesMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .total = 100.0,
+   .attributes = DiskIODeviceMeter_attributes,
+   .name = "DiskIODevices",
+   .uiName = "Disk IO per device",
+   .description = "Disk IO per device: a line for each disk counted by the Disk IO meter",
+   .caption = "Disk IO: ",
+   .draw = IODevicesMeter_draw,
+   .init = IODevicesMeter_init,
+   .updateMode = IODevicesMeter_updateMode,
+   .done = IODevicesMeter_done
+};
+
+const MeterClass NetworkIODevicesMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = IODevicesMeter_display
+   },
+   .updateValues = IODevicesMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .total = 100.0,
+   .attributes = NetworkIODeviceMeter_attributes,
+   .name = "NetworkIODevices",
+   .uiName = "Network IO per interface",
+   .description = "Network IO per interface: a line for each interface counted by the Network IO meter",
+   .caption = "Network: ",
+   .draw = IODevicesMeter_draw,
+   .init = IODevicesMeter_init,
+   .updateMode = IODevicesMeter_updateMode,
+   .done = IODevicesMeter_done
+};
@@ -0,0 +1,17 @@
+#ifndef HEADER_IODevicesMeter
+#define HEADER_IODevicesMeter
+/*
+htop - linux/IODevicesMeter.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "Meter.h"
+
+
+extern const MeterClass DiskIODevicesMeter_class;
+
+extern const MeterClass NetworkIODevicesMeter_class;
+
+#endif
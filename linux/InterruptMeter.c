@@ -0,0 +1,419 @@
+/*
+htop - linux/InterruptMeter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/InterruptMeter.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CRT.h"
+#include "Machine.h"
+#include "Macros.h"
+#include "Object.h"
+#include "Rate.h"
+#include "RichString.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+#include "linux/LinuxMachine.h"
+#include "linux/SourceCache.h"
+
+
+/* Softirqs shown by the SoftIRQs meter, a row each */
+static const char* const InterruptMeter_softirqs[] = { "NET_RX", "NET_TX", "BLOCK", "TIMER" };
+
+/* The hardware interrupts are summed into a single row */
+static const char* const InterruptMeter_irqs[] = { "IRQ" };
+
+#define INTERRUPT_LABEL_WIDTH 7
+#define INTERRUPT_RATE_WIDTH 9
+
+/*
+ * Counters per CPU as read from a file like /proc/softirqs or
+ * /proc/interrupts: a header naming the CPU of each column, then a line
+ * for each source. Read once per update for all meters showing it.
+ */
+typedef struct InterruptTable_ {
+   const char* file;
+   SourceCacheKey source;
+   const char* const* rowNames;   /* NULL to sum all lines into one row */
+   unsigned int rows;
+   FsRootFile* kept;
+   unsigned int* columnCpu;       /* CPU of each column; /proc/interrupts only has the online ones */
+   unsigned int columns;
+   unsigned int columnsAlloc;
+   unsigned int cpus;             /* one more than the highest CPU of a column */
+   unsigned long long* counts;    /* rows x cpus */
+   bool valid;
+   unsigned int meters;           /* meters showing the table, it is freed with the last one */
+} InterruptTable;
+
+static InterruptTable InterruptMeter_softirqTable = {
+   .file = "softirqs",
+   .source = SOURCE_SOFTIRQS,
+   .rowNames = InterruptMeter_softirqs,
+   .rows = ARRAYSIZE(InterruptMeter_softirqs),
+};
+
+static InterruptTable InterruptMeter_irqTable = {
+   .file = "interrupts",
+   .source = SOURCE_INTERRUPTS,
+   .rowNames = NULL,
+   .rows = ARRAYSIZE(InterruptMeter_irqs),
+};
+
+static void InterruptTable_parseHeader(InterruptTable* this, const char* line) {
+   unsigned int cpus = 0;
+
+   this->columns = 0;
+   for (const char* p = line; (p = strstr(p, "CPU")) != NULL; ) {
+      p += 3;
+
+      unsigned int cpu = 0;
+      const char* digits = p;
+      while (*p >= '0' && *p <= '9' && cpu < UINT_MAX / 10)
+         cpu = cpu * 10 + (unsigned int)(*p++ - '0');
+      if (p == digits)
+         continue;
+
+      if (this->columns == this->columnsAlloc) {
+         this->columnsAlloc = this->columnsAlloc ? this->columnsAlloc * 2 : 64;
+         this->columnCpu = xReallocArray(this->columnCpu, this->columnsAlloc, sizeof(unsigned int));
+      }
+      this->columnCpu[this->columns++] = cpu;
+      cpus = MAXIMUM(cpus, cpu + 1);
+   }
+
+   if (cpus > this->cpus) {
+      this->cpus = cpus;
+      this->counts = xReallocArray(this->counts, (size_t)this->rows * cpus, sizeof(unsigned long long));
+   }
+}
+
+/* Adds the numbers of the columns to the counters of their CPUs, up to the description that may follow */
+static void InterruptTable_addCounts(const InterruptTable* this, const char* p, unsigned long long* counts) {
+   for (unsigned int column = 0; column < this->columns; column++) {
+      while (*p == ' ')
+         p++;
+      if (*p < '0' || *p > '9')
+         return;
+
+      unsigned long long value = 0;
+      while (*p >= '0' && *p <= '9')
+         value = value * 10 + (unsigned long long)(*p++ - '0');
+
+      counts[this->columnCpu[column]] += value;
+   }
+}
+
+static int InterruptTable_row(const InterruptTable* this, const char* name) {
+   if (!this->rowNames) {
+      /* errors and missed interrupts are system wide counters, not per CPU */
+      return String_eq(name, "ERR") || String_eq(name, "MIS") ? -1 : 0;
+   }
+
+   for (unsigned int row = 0; row < this->rows; row++) {
+      if (String_eq(name, this->rowNames[row])) {
+         return (int)row;
+      }
+   }
+   return -1;
+}
+
+static void InterruptTable_read(InterruptTable* this) {
+   this->valid = false;
+
+   char* content = FsRoot_readKept(&FsRoot_proc, &this->kept, this->file, NULL);
+   if (!content)
+      return;
+
+   char* next = strchr(content, '\n');
+   if (!next)
+      return;
+
+   *next++ = '\0';
+   InterruptTable_parseHeader(this, content);
+   if (this->columns == 0)
+      return;
+
+   memset(this->counts, 0, (size_t)this->rows * this->cpus * sizeof(unsigned long long));
+
+   for (char* line = next; line && *line; line = next) {
+      next = strchr(line, '\n');
+      if (next)
+         *next++ = '\0';
+
+      char* colon = strchr(line, ':');
+      if (!colon)
+         continue;
+
+      *colon = '\0';
+      while (*line == ' ')
+         line++;
+
+      /* lines of sources not shown are left without reading their numbers */
+      int row = InterruptTable_row(this, line);
+      if (row < 0)
+         continue;
+
+      InterruptTable_addCounts(this, colon + 1, &this->counts[(size_t)row * this->cpus]);
+   }
+
+   this->valid = true;
+}
+
+static void InterruptTable_release(InterruptTable* this) {
+   if (--this->meters > 0)
+      return;
+
+   free(this->columnCpu);
+   free(this->counts);
+   this->columnCpu = NULL;
+   this->counts = NULL;
+   this->columns = 0;
+   this->columnsAlloc = 0;
+   this->cpus = 0;
+   this->valid = false;
+   /* the file stays registered with the proc root */
+   this->kept = NULL;
+}
+
+typedef struct InterruptMeterData_ {
+   InterruptTable* table;
+   unsigned int cpus;             /* CPUs when the meter was set up */
+   unsigned int* order;           /* the CPUs grouped by their NUMA node */
+   bool* groupStart;              /* whether the CPU at a position is the first of its node */
+   unsigned int groups;
+   Rate* rates;                   /* rows x cpus */
+   double* values;                /* per second, rows x cpus, 0 while unknown */
+   double* rowTotal;
+   double* rowMax;
+   unsigned int* rowBusiest;
+   uint64_t lastUpdateMs;
+} InterruptMeterData;
+
+static const int InterruptMeter_attributes[] = {
+   METER_VALUE,
+};
+
+static const char* const* InterruptMeter_rowNames(const InterruptMeterData* data) {
+   return data->table == &InterruptMeter_softirqTable ? InterruptMeter_softirqs : InterruptMeter_irqs;
+}
+
+/* Event rates, like "950", "12.3k" or "4.5M" */
+static int InterruptMeter_formatRate(char* buffer, size_t size, double rate) {
+   if (rate < 1000.0)
+      return xSnprintf(buffer, size, "%.0f/s", rate);
+   if (rate < 1000000.0)
+      return xSnprintf(buffer, size, "%.1fk/s", rate / 1000.0);
+   return xSnprintf(buffer, size, "%.1fM/s", rate / 1000000.0);
+}
+
+static void InterruptMeter_setHeight(Meter* this) {
+   const InterruptMeterData* data = this->meterData;
+   this->h = this->mode == TEXT_METERMODE ? 1 : (int)data->table->rows;
+}
+
+static void InterruptMeter_init(Meter* this) {
+   InterruptMeterData* data = this->meterData;
+   if (!data) {
+      const LinuxMachine* lhost = (const LinuxMachine*) this->host;
+      data = this->meterData = xCalloc(1, sizeof(InterruptMeterData));
+      data->table = As_Meter(this) == &SoftIRQMeter_class ? &InterruptMeter_softirqTable : &InterruptMeter_irqTable;
+      data->table->meters++;
+
+      const size_t rows = data->table->rows;
+      data->cpus = MAXIMUM(this->host->existingCPUs, 1);
+      data->order = xCalloc(data->cpus, sizeof(unsigned int));
+      data->groupStart = xCalloc(data->cpus, sizeof(bool));
+      data->rates = xCalloc(rows * data->cpus, sizeof(Rate));
+      data->values = xCalloc(rows * data->cpus, sizeof(double));
+      data->rowTotal = xCalloc(rows, sizeof(double));
+      data->rowMax = xCalloc(rows, sizeof(double));
+      data->rowBusiest = xCalloc(rows, sizeof(unsigned int));
+      data->groups = LinuxMachine_groupCPUsByNode(lhost, data->cpus, data->order, data->groupStart);
+   }
+
+   if (this->mode == 0)
+      this->mode = BAR_METERMODE;
+
+   InterruptMeter_setHeight(this);
+}
+
+static void InterruptMeter_updateMode(Meter* this, int mode) {
+   this->mode = mode;
+   InterruptMeter_setHeight(this);
+}
+
+static void InterruptMeter_updateValues(Meter* this) {
+   InterruptMeterData* data = this->meterData;
+   InterruptTable* table = data->table;
+   const Machine* host = this->host;
+
+   /* update only every 500ms to have a sane span for rate calculation */
+   if (host->realtimeMs - data->lastUpdateMs <= 500)
+      return;
+
+   data->lastUpdateMs = host->realtimeMs;
+
+   if (SourceCache_isStale(table->source))
+      InterruptTable_read(table);
+
+   if (!table->valid) {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "no data");
+      return;
+   }
+
+   const char* const* names = InterruptMeter_rowNames(data);
+   char* text = this->txtBuffer;
+   size_t size = sizeof(this->txtBuffer);
+   text[0] = '\0';
+
+   for (unsigned int row = 0; row < table->rows; row++) {
+      double total = 0.0;
+      double max = 0.0;
+      unsigned int busiest = 0;
+
+      for (unsigned int cpu = 0; cpu < data->cpus; cpu++) {
+         const size_t i = (size_t)row * data->cpus + cpu;
+         unsigned long long counter = cpu < table->cpus ? table->counts[(size_t)row * table->cpus + cpu] : ULLONG_MAX;
+         double rate = Rate_update(&data->rates[i], counter, host->realtimeMs);
+         data->values[i] = isNonnegative(rate) ? rate : 0.0;
+
+         total += data->values[i];
+         if (data->values[i] > max) {
+            max = data->values[i];
+            busiest = cpu;
+         }
+      }
+
+      data->rowTotal[row] = total;
+      data->rowMax[row] = max;
+      data->rowBusiest[row] = busiest;
+
+      char rate[16];
+      InterruptMeter_formatRate(rate, sizeof(rate), total);
+      int written = xSnprintf(text, size, "%s%s %s", row ? " " : "", names[row], rate);
+      if (max > 0.0)
+         written += xSnprintf(text + written, size - (size_t)written, " (CPU %u)", busiest + (host->settings->countCPUsFromOne ? 1 : 0));
+      text += written;
+      size -= (size_t)written;
+   }
+}
+
+static void InterruptMeter_appendCell(RichString* out, double value, double max) {
+   if (!(value > 0.0)) {
+      Meter_appendHeatCell(out, -1);
+      return;
+   }
+
+   /* relative to the busiest CPU, as long as that does at least one per second */
+   int level = (int)(value / MAXIMUM(max, 1.0) * 4.0);
+   Meter_appendHeatCell(out, CLAMP(level, 0, 3));
+}
+
+/* A row per source: the rate of each CPU as a heat cell, nodes apart, CPUs merged into cells if they do not fit */
+static void InterruptMeter_draw(Meter* this, int x, int y, int w) {
+   const InterruptMeterData* data = this->meterData;
+   if (this->mode == TEXT_METERMODE || !data->table->valid) {
+      Meter_modes[TEXT_METERMODE]->draw(this, x, y, w);
+      return;
+   }
+
+   const int cells = w - INTERRUPT_LABEL_WIDTH - INTERRUPT_RATE_WIDTH;
+   if (cells < 1)
+      return;
+
+   const bool gaps = data->cpus + data->groups - 1 <= (unsigned int)cells;
+   const unsigned int perCell = gaps ? 1 : (data->cpus + (unsigned int)cells - 1) / (unsigned int)cells;
+   const char* const* names = InterruptMeter_rowNames(data);
+
+   for (unsigned int row = 0; row < data->table->rows; row++) {
+      const double* values = &data->values[(size_t)row * data->cpus];
+
+      RichString_begin(out);
+      char label[INTERRUPT_LABEL_WIDTH + 1];
+      xSnprintf(label, sizeof(label), "%-*s", INTERRUPT_LABEL_WIDTH, names[row]);
+      RichString_appendAscii(&out, CRT_colors[METER_TEXT], label);
+
+      for (unsigned int i = 0; i < data->cpus; i += perCell) {
+         if (gaps && i > 0 && data->groupStart[i])
+            RichString_appendChr(&out, CRT_colors[METER_TEXT], ' ', 1);
+
+         double value = 0.0;
+         for (unsigned int j = i; j < i + perCell && j < data->cpus; j++)
+            value = MAXIMUM(value, values[data->order[j]]);
+
+         InterruptMeter_appendCell(&out, value, data->rowMax[row]);
+      }
+
+      char rate[INTERRUPT_RATE_WIDTH + 1];
+      char text[INTERRUPT_RATE_WIDTH + 2];
+      InterruptMeter_formatRate(rate, sizeof(rate), data->rowMax[row]);
+      int len = xSnprintf(text, sizeof(text), " %s", rate);
+      RichString_appendnAscii(&out, CRT_colors[METER_VALUE], text, len);
+
+      RichString_printoffnVal(out, y + (int)row, x, 0, w);
+      RichString_delete(&out);
+   }
+}
+
+static void InterruptMeter_done(Meter* this) {
+   InterruptMeterData* data = this->meterData;
+   InterruptTable_release(data->table);
+   free(data->order);
+   free(data->groupStart);
+   free(data->rates);
+   free(data->values);
+   free(data->rowTotal);
+   free(data->rowMax);
+   free(data->rowBusiest);
+   free(data);
+}
+
+const MeterClass SoftIRQMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+   },
+   .updateValues = InterruptMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .total = 100.0,
+   .attributes = InterruptMeter_attributes,
+   .name = "SoftIRQs",
+   .uiName = "Softirqs per CPU",
+   .description = "Softirqs per CPU: network receive and transmit, block and timer softirqs of each CPU as a heatmap",
+   .caption = "Softirqs: ",
+   .draw = InterruptMeter_draw,
+   .init = InterruptMeter_init,
+   .updateMode = InterruptMeter_updateMode,
+   .done = InterruptMeter_done
+};
+
+const MeterClass IRQMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+   },
+   .updateValues = InterruptMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .total = 100.0,
+   .attributes = InterruptMeter_attributes,
+   .name = "IRQs",
+   .uiName = "Interrupts per CPU",
+   .description = "Interrupts per CPU: hardware interrupts of each CPU as a heatmap, from the large /proc/interrupts",
+   .caption = "IRQs: ",
+   .draw = InterruptMeter_draw,
+   .init = InterruptMeter_init,
+   .updateMode = InterruptMeter_updateMode,
+   .done = InterruptMeter_done
+};
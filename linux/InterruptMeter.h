@@ -0,0 +1,17 @@
+#ifndef HEADER_InterruptMeter
+#define HEADER_InterruptMeter
+/*
+htop - linux/InterruptMeter.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "Meter.h"
+
+
+extern const MeterClass SoftIRQMeter_class;
+
+extern const MeterClass IRQMeter_class;
+
+#endif
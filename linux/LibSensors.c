@@ -14,11 +14,14 @@ in the source distribution for its full text.
 #include <assert.h>
 #include <dlfcn.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <math.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <sensors/sensors.h>
 
@@ -49,7 +52,35 @@ static void* dlopenHandle = NULL;
 
 #endif /* BUILD_STATIC */
 
+/* A CPU temperature input of the highest priority driver, resolved once per sensors configuration */
+typedef struct LibSensorsTemp_ {
+   unsigned int tempID;              /* feature index, 0 based */
+   const sensors_chip_name* chip;
+   int number;                       /* of the input subfeature */
+   int fd;                           /* sysfs input read directly, -1 to use libsensors */
+} LibSensorsTemp;
+
+static LibSensorsTemp* temps;
+static size_t nTemps;
+static bool tempsResolved;
+
+/* libsensors is loaded on the first temperature read, parsing its configuration takes a while */
+static bool initialized;
+
+static void LibSensors_forgetTemps(void) {
+   for (size_t i = 0; i < nTemps; i++)
+      if (temps[i].fd >= 0)
+         close(temps[i].fd);
+
+   free(temps);
+   temps = NULL;
+   nTemps = 0;
+   tempsResolved = false;
+}
+
 int LibSensors_init(void) {
+   initialized = true;
+
 #ifdef BUILD_STATIC
 
    return sym_sensors_init(NULL);
@@ -100,6 +131,12 @@ dlfailure:
 }
 
 void LibSensors_cleanup(void) {
+   if (!initialized)
+      return;
+
+   initialized = false;
+   LibSensors_forgetTemps();
+
 #ifdef BUILD_STATIC
 
    sym_sensors_cleanup();
@@ -117,6 +154,10 @@ void LibSensors_cleanup(void) {
 }
 
 int LibSensors_reload(void) {
+   /* the CPUs present are seen when it is loaded */
+   if (!initialized)
+      return 0;
+
 #ifndef BUILD_STATIC
    if (!dlopenHandle) {
       errno = ENOTSUP;
@@ -124,6 +165,9 @@ int LibSensors_reload(void) {
    }
 #endif /* !BUILD_STATIC */
 
+   /* chip names are owned by libsensors */
+   LibSensors_forgetTemps();
+
    sym_sensors_cleanup();
    return sym_sensors_init(NULL);
 }
@@ -149,21 +193,24 @@ static int tempDriverPriority(const sensors_chip_name* chip) {
    return -1;
 }
 
-void LibSensors_getCPUTemperatures(CPUData* cpus, unsigned int existingCPUs, unsigned int activeCPUs) {
-   assert(existingCPUs > 0 && existingCPUs < 16384);
+/* Opens the sysfs file behind an input subfeature; libsensors itself reads <chip path>/<subfeature name> */
+static int LibSensors_openInput(const sensors_chip_name* chip, const sensors_subfeature* subFeature) {
+   if (!chip->path || !subFeature->name)
+      return -1;
 
-   double* data = xMallocArray(existingCPUs + 1, sizeof(double));
-   for (size_t i = 0; i < existingCPUs + 1; i++)
-      data[i] = NAN;
+   char path[PATH_MAX];
+   if (snprintf(path, sizeof(path), "%s/%s", chip->path, subFeature->name) >= (int)sizeof(path))
+      return -1;
 
-#ifndef BUILD_STATIC
-   if (!dlopenHandle)
-      goto out;
-#endif /* !BUILD_STATIC */
+   return open(path, O_RDONLY | O_CLOEXEC);
+}
 
-   unsigned int coreTempCount = 0;
+static void LibSensors_resolveTemps(void) {
+   size_t capacity = 0;
    int topPriority = 99;
 
+   tempsResolved = true;
+
    int n = 0;
    for (const sensors_chip_name* chip = sym_sensors_get_detected_chips(NULL, &n); chip; chip = sym_sensors_get_detected_chips(NULL, &n)) {
       const int priority = tempDriverPriority(chip);
@@ -174,9 +221,11 @@ void LibSensors_getCPUTemperatures(CPUData* cpus, unsigned int existingCPUs, uns
          continue;
 
       if (priority < topPriority) {
-         /* Clear data from lower priority sensor */
-         for (size_t i = 0; i < existingCPUs + 1; i++)
-            data[i] = NAN;
+         /* Drop inputs of lower priority sensor */
+         for (size_t i = 0; i < nTemps; i++)
+            if (temps[i].fd >= 0)
+               close(temps[i].fd);
+         nTemps = 0;
       }
 
       topPriority = priority;
@@ -190,33 +239,90 @@ void LibSensors_getCPUTemperatures(CPUData* cpus, unsigned int existingCPUs, uns
             continue;
 
          unsigned long int tempID = strtoul(feature->name + strlen("temp"), NULL, 10);
-         if (tempID == 0 || tempID == ULONG_MAX)
-            continue;
-
-         /* Feature name IDs start at 1, adjust to start at 0 to match data indices */
-         tempID--;
-
-         if (tempID > existingCPUs)
+         if (tempID == 0 || tempID > UINT_MAX)
             continue;
 
          const sensors_subfeature* subFeature = sym_sensors_get_subfeature(chip, feature, SENSORS_SUBFEATURE_TEMP_INPUT);
          if (!subFeature)
             continue;
 
-         double temp;
-         int r = sym_sensors_get_value(chip, subFeature->number, &temp);
-         if (r != 0)
-            continue;
+         if (nTemps == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            temps = xReallocArray(temps, capacity, sizeof(*temps));
+         }
+
+         temps[nTemps++] = (LibSensorsTemp) {
+            /* Feature name IDs start at 1, adjust to start at 0 to match data indices */
+            .tempID = (unsigned int)(tempID - 1),
+            .chip = chip,
+            .number = subFeature->number,
+            .fd = LibSensors_openInput(chip, subFeature),
+         };
+      }
+   }
+}
 
-         /* If already set, e.g. Ryzen reporting platform temperature for each die, use the bigger one */
-         if (isNaN(data[tempID])) {
-            data[tempID] = temp;
-            if (tempID > 0)
-               coreTempCount++;
-         } else {
-            data[tempID] = MAXIMUM(data[tempID], temp);
+static bool LibSensors_readTemp(LibSensorsTemp* temp, double* value) {
+   if (temp->fd >= 0) {
+      char buffer[32];
+      ssize_t r = pread(temp->fd, buffer, sizeof(buffer) - 1, 0);
+      if (r > 0) {
+         buffer[r] = '\0';
+
+         char* end;
+         errno = 0;
+         long milli = strtol(buffer, &end, 10);
+         if (errno == 0 && end != buffer) {
+            *value = milli / 1000.0;
+            return true;
          }
       }
+
+      /* e.g. the device went away, leave it to libsensors from now on */
+      close(temp->fd);
+      temp->fd = -1;
+   }
+
+   return sym_sensors_get_value(temp->chip, temp->number, value) == 0;
+}
+
+void LibSensors_getCPUTemperatures(CPUData* cpus, unsigned int existingCPUs, unsigned int activeCPUs) {
+   assert(existingCPUs > 0 && existingCPUs < 16384);
+
+   double* data = xMallocArray(existingCPUs + 1, sizeof(double));
+   for (size_t i = 0; i < existingCPUs + 1; i++)
+      data[i] = NAN;
+
+   if (!initialized)
+      LibSensors_init();
+
+#ifndef BUILD_STATIC
+   if (!dlopenHandle)
+      goto out;
+#endif /* !BUILD_STATIC */
+
+   if (!tempsResolved)
+      LibSensors_resolveTemps();
+
+   unsigned int coreTempCount = 0;
+
+   for (size_t i = 0; i < nTemps; i++) {
+      const unsigned int tempID = temps[i].tempID;
+      if (tempID > existingCPUs)
+         continue;
+
+      double temp;
+      if (!LibSensors_readTemp(&temps[i], &temp))
+         continue;
+
+      /* If already set, e.g. Ryzen reporting platform temperature for each die, use the bigger one */
+      if (isNaN(data[tempID])) {
+         data[tempID] = temp;
+         if (tempID > 0)
+            coreTempCount++;
+      } else {
+         data[tempID] = MAXIMUM(data[tempID], temp);
+      }
    }
 
    /* Adjust data for chips not providing a platform temperature */
@@ -0,0 +1,143 @@
+/*
+htop - linux/LibraryCache.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/LibraryCache.h"
+
+#include <stdlib.h>
+
+#include "XUtils.h"
+
+
+#define LIBRARYCACHE_INITIAL_BUCKETS 256
+
+/* Cycles a file is kept for after it was last found mapped; maps are not read every scan */
+#define LIBRARYCACHE_KEEP_CYCLES 64
+
+static size_t LibraryCache_bucket(const LibraryCache* this, uint64_t dev, uint64_t inode) {
+   uint64_t hash = (inode ^ (dev << 32) ^ (dev >> 32)) * 0x9E3779B97F4A7C15ULL;
+   return (size_t)(hash >> 32) & (this->bucketCount - 1);
+}
+
+LibraryCache* LibraryCache_new(void) {
+   LibraryCache* this = xCalloc(1, sizeof(LibraryCache));
+   this->bucketCount = LIBRARYCACHE_INITIAL_BUCKETS;
+   this->buckets = xCalloc(this->bucketCount, sizeof(LibraryEntry*));
+   this->cycle = 1;
+   return this;
+}
+
+void LibraryCache_delete(LibraryCache* this) {
+   if (!this)
+      return;
+
+   for (size_t i = 0; i < this->bucketCount; i++) {
+      LibraryEntry* entry = this->buckets[i];
+      while (entry) {
+         LibraryEntry* next = entry->next;
+         free(entry);
+         entry = next;
+      }
+   }
+   free(this->buckets);
+   free(this);
+}
+
+void LibraryCache_beginCycle(LibraryCache* this) {
+   this->cycle++;
+   if (this->cycle == 0)
+      this->cycle = 1;
+
+   for (size_t i = 0; i < this->bucketCount; i++) {
+      LibraryEntry** link = &this->buckets[i];
+      while (*link) {
+         LibraryEntry* entry = *link;
+         if (this->cycle - entry->seen > LIBRARYCACHE_KEEP_CYCLES) {
+            *link = entry->next;
+            free(entry);
+            this->count--;
+         } else {
+            link = &entry->next;
+         }
+      }
+   }
+}
+
+void LibraryCache_beginProcess(LibraryCache* this) {
+   this->mark++;
+   if (this->mark == 0)
+      this->mark = 1;
+   this->touched = NULL;
+}
+
+static void LibraryCache_grow(LibraryCache* this) {
+   size_t oldCount = this->bucketCount;
+   LibraryEntry** oldBuckets = this->buckets;
+
+   this->bucketCount *= 2;
+   this->buckets = xCalloc(this->bucketCount, sizeof(LibraryEntry*));
+
+   for (size_t i = 0; i < oldCount; i++) {
+      LibraryEntry* entry = oldBuckets[i];
+      while (entry) {
+         LibraryEntry* next = entry->next;
+         size_t idx = LibraryCache_bucket(this, entry->dev, entry->inode);
+         entry->next = this->buckets[idx];
+         this->buckets[idx] = entry;
+         entry = next;
+      }
+   }
+
+   free(oldBuckets);
+}
+
+LibraryEntry* LibraryCache_add(LibraryCache* this, uint64_t dev, uint64_t inode, uint64_t size, bool exec) {
+   size_t idx = LibraryCache_bucket(this, dev, inode);
+   LibraryEntry* entry = this->buckets[idx];
+   while (entry && (entry->inode != inode || entry->dev != dev))
+      entry = entry->next;
+
+   if (!entry) {
+      if (this->count >= this->bucketCount) {
+         LibraryCache_grow(this);
+         idx = LibraryCache_bucket(this, dev, inode);
+      }
+
+      entry = xCalloc(1, sizeof(LibraryEntry));
+      entry->dev = dev;
+      entry->inode = inode;
+      entry->next = this->buckets[idx];
+      this->buckets[idx] = entry;
+      this->count++;
+   }
+
+   entry->seen = this->cycle;
+
+   /* the mark is never 0, so a new entry is always touched */
+   if (entry->mark != this->mark) {
+      entry->mark = this->mark;
+      entry->size = 0;
+      entry->exec = false;
+      entry->nextTouched = this->touched;
+      this->touched = entry;
+   }
+
+   entry->size += size;
+   entry->exec |= exec;
+   return entry;
+}
+
+uint64_t LibraryCache_endProcess(LibraryCache* this) {
+   uint64_t total = 0;
+   for (const LibraryEntry* entry = this->touched; entry; entry = entry->nextTouched) {
+      if (entry->exec)
+         total += entry->size;
+   }
+   this->touched = NULL;
+   return total;
+}
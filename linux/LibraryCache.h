@@ -0,0 +1,72 @@
+#ifndef HEADER_LibraryCache
+#define HEADER_LibraryCache
+/*
+htop - linux/LibraryCache.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* A file mapped by processes, found by its device and inode */
+typedef struct LibraryEntry_ {
+   uint64_t dev;
+   uint64_t inode;
+   bool deleted;              /* unlinked since it was mapped, as of the cycle `checked` */
+   unsigned int checked;      /* cycle the deleted state was taken in, 0 if never */
+   unsigned int seen;         /* cycle the file was last found mapped in */
+
+   /* The mappings of the process being read */
+   unsigned int mark;
+   uint64_t size;
+   bool exec;
+   struct LibraryEntry_* nextTouched;
+
+   struct LibraryEntry_* next;
+} LibraryEntry;
+
+/*
+ * The files mapped by all processes, shared across the maps reads of a scan
+ * so that the libraries most processes map are looked into once per cycle.
+ */
+typedef struct LibraryCache_ {
+   LibraryEntry** buckets;
+   size_t bucketCount;        /* always a power of two */
+   size_t count;
+
+   unsigned int cycle;
+   unsigned int mark;
+   LibraryEntry* touched;     /* entries of the process being read */
+} LibraryCache;
+
+LibraryCache* LibraryCache_new(void);
+
+void LibraryCache_delete(LibraryCache* this);
+
+/* Starts a scan: deleted states are to be taken anew, files not mapped for a while are dropped */
+void LibraryCache_beginCycle(LibraryCache* this);
+
+/* Starts summing the mappings of one process */
+void LibraryCache_beginProcess(LibraryCache* this);
+
+/* Adds a mapping of the process being read */
+LibraryEntry* LibraryCache_add(LibraryCache* this, uint64_t dev, uint64_t inode, uint64_t size, bool exec);
+
+/* Whether the deleted state of the entry is still to be taken from its name in this cycle */
+static inline bool LibraryCache_needsName(const LibraryCache* this, const LibraryEntry* entry) {
+   return entry->checked != this->cycle;
+}
+
+static inline void LibraryCache_setDeleted(const LibraryCache* this, LibraryEntry* entry, bool deleted) {
+   entry->deleted = deleted;
+   entry->checked = this->cycle;
+}
+
+/* Bytes of the executable files mapped by the process being read, each file counted once */
+uint64_t LibraryCache_endProcess(LibraryCache* this);
+
+#endif
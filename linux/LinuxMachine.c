@@ -23,16 +23,33 @@ in the source distribution for its full text.
 #include <unistd.h>
 #include <time.h>
 
+#include "Budget.h"
 #include "Compat.h"
+#include "CPUMeter.h"
 #include "CRT.h"
 #include "Macros.h"
+#include "MemoryMeter.h"
 #include "ProcessTable.h"
+#include "Replay.h"
 #include "Row.h"
 #include "Settings.h"
 #include "UsersTable.h"
 #include "XUtils.h"
 
+#include "linux/CPUFreqCounters.h"
+#include "linux/FsRoot.h"
+#include "linux/HugePageMeter.h"
+#include "linux/IODevices.h"
+#include "linux/LinuxProcess.h"
+#include "linux/NumaMemory.h"
+#include "linux/NumaMemoryMeter.h"
 #include "linux/Platform.h" // needed for GNU/hurd to get PATH_MAX  // IWYU pragma: keep
+#include "linux/RAPL.h"
+#include "linux/RAPLMeter.h"
+#include "linux/SourceCache.h"
+#include "linux/ZramMeter.h"
+#include "zfs/ZfsArcMeter.h"
+#include "zfs/ZfsCompressedArcMeter.h"
 
 #ifdef HAVE_SENSORS_SENSORS_H
 #include "LibSensors.h"
@@ -42,6 +59,74 @@ in the source distribution for its full text.
 #define O_PATH         010000000 // declare for ancient glibc versions
 #endif
 
+/* The parts of Machine_scan() skipped while no meter or column reads them */
+typedef enum LinuxMachineCollector_ {
+   LINUX_MACHINE_HUGEPAGES,
+   LINUX_MACHINE_ZFS,
+   LINUX_MACHINE_ZRAM,
+   LINUX_MACHINE_NUMA,
+   LINUX_MACHINE_POWER,
+   LINUX_MACHINE_CPU_SENSORS,
+} LinuxMachineCollector;
+
+static const MeterClass* const LinuxMachine_hugePageMeters[] = { &HugePageMeter_class, NULL };
+
+/* the memory meter counts the shrinkable part of the ARC as cache */
+static const MeterClass* const LinuxMachine_zfsMeters[] = { &ZfsArcMeter_class, &ZfsCompressedArcMeter_class, &MemoryMeter_class, NULL };
+
+static const MeterClass* const LinuxMachine_zramMeters[] = { &ZramMeter_class, NULL };
+
+static const MeterClass* const LinuxMachine_numaMeters[] = { &NumaMemoryMeter_class, NULL };
+
+static const MeterClass* const LinuxMachine_powerMeters[] = { &RAPLMeter_class, NULL };
+
+/* frequency and temperature, as far as the settings show them */
+static const MeterClass* const LinuxMachine_cpuMeters[] = {
+   &CPUMeter_class,
+   &AllCPUsMeter_class, &AllCPUs2Meter_class, &AllCPUs4Meter_class, &AllCPUs8Meter_class,
+   &LeftCPUsMeter_class, &LeftCPUs2Meter_class, &LeftCPUs4Meter_class, &LeftCPUs8Meter_class,
+   &RightCPUsMeter_class, &RightCPUs2Meter_class, &RightCPUs4Meter_class, &RightCPUs8Meter_class,
+   #ifdef HAVE_LIBHWLOC
+   &CPUNodesMeter_class, &CPUSocketsMeter_class, &CPUCachesMeter_class, &CPUCoresMeter_class,
+   &BusiestCPUNodeMeter_class, &BusiestCPUSocketMeter_class, &BusiestCPUCacheMeter_class, &BusiestCPUCoreMeter_class,
+   #endif
+   NULL
+};
+
+static const MachineCollector LinuxMachine_collectors[] = {
+   [LINUX_MACHINE_HUGEPAGES] = { .name = "hugepages", .meters = LinuxMachine_hugePageMeters },
+   [LINUX_MACHINE_ZFS] = { .name = "zfs", .meters = LinuxMachine_zfsMeters },
+   [LINUX_MACHINE_ZRAM] = { .name = "zram", .meters = LinuxMachine_zramMeters },
+   [LINUX_MACHINE_NUMA] = { .name = "numa", .meters = LinuxMachine_numaMeters },
+   [LINUX_MACHINE_POWER] = { .name = "power", .meters = LinuxMachine_powerMeters, .processFlags = PROCESS_FLAG_LINUX_POWER },
+   [LINUX_MACHINE_CPU_SENSORS] = { .name = "cpu sensors", .meters = LinuxMachine_cpuMeters },
+   { .name = NULL }
+};
+
+ATTR_NORETURN
+static void LinuxMachine_procFileError(const char* what, const char* name) {
+   char path[4096];
+   char note[4200];
+   xSnprintf(note, sizeof(note), "%s %s", what, FsRoot_path(&FsRoot_proc, name, path, sizeof(path)));
+   CRT_fatalError(note);
+}
+
+static FILE* LinuxMachine_openProcFile(const char* name) {
+   FILE* file = FsRoot_fopen(&FsRoot_proc, name, "r");
+   if (!file)
+      LinuxMachine_procFileError("Cannot open", name);
+
+   return file;
+}
+
+static char* LinuxMachine_readProcFile(FsRootFile** file, const char* name, size_t* length) {
+   char* data = FsRoot_readKept(&FsRoot_proc, file, name, length);
+   if (!data)
+      LinuxMachine_procFileError("Cannot read", name);
+
+   return data;
+}
+
 /* Similar to get_nprocs_conf(3) / _SC_NPROCESSORS_CONF
  * https://sourceware.org/git/?p=glibc.git;a=blob;f=sysdeps/unix/sysv/linux/getsysstats.c;hb=HEAD
  */
@@ -58,7 +143,7 @@ static void LinuxMachine_updateCPUcount(LinuxMachine* this) {
       super->existingCPUs = 1;
    }
 
-   DIR* dir = opendir("/sys/devices/system/cpu");
+   DIR* dir = FsRoot_opendir(&FsRoot_sys, "devices/system/cpu");
    if (!dir)
       return;
 
@@ -83,7 +168,7 @@ static void LinuxMachine_updateCPUcount(LinuxMachine* this) {
          continue;
 #else
       char cpuDirFd[4096];
-      xSnprintf(cpuDirFd, sizeof(cpuDirFd), "/sys/devices/system/cpu/%s", entry->d_name);
+      xSnprintf(cpuDirFd, sizeof(cpuDirFd), "%s/devices/system/cpu/%s", FsRoot_sys.path, entry->d_name);
 #endif
 
       existing++;
@@ -139,15 +224,13 @@ static void LinuxMachine_scanMemoryInfo(LinuxMachine* this) {
    memory_t swapCacheMem = 0;
    memory_t swapFreeMem = 0;
    memory_t sreclaimableMem = 0;
+   memory_t sunreclaimMem = 0;
    memory_t zswapCompMem = 0;
    memory_t zswapOrigMem = 0;
 
-   FILE* file = fopen(PROCMEMINFOFILE, "r");
-   if (!file)
-      CRT_fatalError("Cannot open " PROCMEMINFOFILE);
+   char* data = LinuxMachine_readProcFile(&this->meminfoFile, PROCMEMINFOFILE, NULL);
 
-   char buffer[128];
-   while (fgets(buffer, sizeof(buffer), file)) {
+   for (const char* buffer; (buffer = strsep(&data, "\n")) != NULL; ) {
 
       #define tryRead(label, variable)                                       \
          if (String_startsWith(buffer, label)) {                             \
@@ -183,6 +266,9 @@ static void LinuxMachine_scanMemoryInfo(LinuxMachine* this) {
                case 'R':
                   tryRead("SReclaimable:", sreclaimableMem);
                   break;
+               case 'U':
+                  tryRead("SUnreclaim:", sunreclaimMem);
+                  break;
             }
             break;
          case 'Z':
@@ -194,8 +280,6 @@ static void LinuxMachine_scanMemoryInfo(LinuxMachine* this) {
       #undef tryRead
    }
 
-   fclose(file);
-
    /*
     * Compute memory partition like procps(free)
     *  https://gitlab.com/procps-ng/procps/-/blob/master/proc/sysinfo.c
@@ -210,6 +294,7 @@ static void LinuxMachine_scanMemoryInfo(LinuxMachine* this) {
    const memory_t usedDiff = freeMem + cachedMem + sreclaimableMem + buffersMem;
    host->usedMem = (totalMem >= usedDiff) ? totalMem - usedDiff : totalMem - freeMem;
    host->buffersMem = buffersMem;
+   this->unreclaimableSlabMem = MINIMUM(sunreclaimMem, host->usedMem);
    host->availableMem = availableMem != 0 ? MINIMUM(availableMem, totalMem) : freeMem;
    host->totalSwap = swapTotalMem;
    host->usedSwap = swapTotalMem - swapFreeMem - swapCacheMem;
@@ -218,16 +303,28 @@ static void LinuxMachine_scanMemoryInfo(LinuxMachine* this) {
    this->zswap.usedZswapOrig = zswapOrigMem;
 }
 
-static void LinuxMachine_scanHugePages(LinuxMachine* this) {
-   this->totalHugePageMem = 0;
-   for (unsigned i = 0; i < HTOP_HUGEPAGE_COUNT; i++) {
-      this->usedHugePageMem[i] = MEMORY_MAX;
-   }
+/* Meter only data found again at this interval, for devices added or removed while running */
+#define LINUX_DISCOVERY_INTERVAL_MS 30000
+
+/* Whether the devices or sizes behind a meter are due to be looked for again */
+static bool LinuxMachine_discoveryDue(uint64_t* nextMs) {
+   uint64_t now;
+   Platform_gettime_monotonic(&now);
+   if (*nextMs && now < *nextMs)
+      return false;
 
-   DIR* dir = opendir("/sys/kernel/mm/hugepages");
+   *nextMs = now + LINUX_DISCOVERY_INTERVAL_MS;
+   return true;
+}
+
+static void LinuxMachine_discoverHugePages(LinuxMachine* this) {
+   this->hugePageSizeCount = 0;
+
+   DIR* dir = FsRoot_opendir(&FsRoot_sys, "kernel/mm/hugepages");
    if (!dir)
       return;
 
+   size_t alloc = 0;
    const struct dirent* entry;
    while ((entry = readdir(dir)) != NULL) {
       const char* name = entry->d_name;
@@ -244,31 +341,94 @@ static void LinuxMachine_scanHugePages(LinuxMachine* this) {
       if (!endptr || *endptr != 'k')
          continue;
 
-      char content[64];
+      int shift = ffsl(hugePageSize) - 1 - (HTOP_HUGEPAGE_BASE_SHIFT - 10);
+      if (shift < 0 || shift >= HTOP_HUGEPAGE_COUNT)
+         continue;
+
+      if (this->hugePageSizeCount == alloc) {
+         alloc = alloc ? alloc * 2 : 4;
+         this->hugePageSizes = xReallocArray(this->hugePageSizes, alloc, sizeof(LinuxHugePageSize));
+      }
+
       char hugePagePath[128];
-      ssize_t r;
+      LinuxHugePageSize* size = &this->hugePageSizes[this->hugePageSizeCount++];
+      size->sizeKB = hugePageSize;
+      xSnprintf(hugePagePath, sizeof(hugePagePath), "kernel/mm/hugepages/%s/nr_hugepages", name);
+      size->totalFile = FsRoot_keep(&FsRoot_sys, hugePagePath);
+      xSnprintf(hugePagePath, sizeof(hugePagePath), "kernel/mm/hugepages/%s/free_hugepages", name);
+      size->freeFile = FsRoot_keep(&FsRoot_sys, hugePagePath);
+   }
+
+   closedir(dir);
+}
 
-      xSnprintf(hugePagePath, sizeof(hugePagePath), "/sys/kernel/mm/hugepages/%s/nr_hugepages", name);
-      r = xReadfile(hugePagePath, content, sizeof(content));
-      if (r <= 0)
+static void LinuxMachine_scanHugePages(LinuxMachine* this) {
+   this->totalHugePageMem = 0;
+   for (unsigned i = 0; i < HTOP_HUGEPAGE_COUNT; i++) {
+      this->usedHugePageMem[i] = MEMORY_MAX;
+   }
+
+   if (!Machine_collects(&this->super, LINUX_MACHINE_HUGEPAGES)) {
+      this->nextHugePageDiscoveryMs = 0;
+      return;
+   }
+
+   if (LinuxMachine_discoveryDue(&this->nextHugePageDiscoveryMs))
+      LinuxMachine_discoverHugePages(this);
+
+   for (size_t i = 0; i < this->hugePageSizeCount; i++) {
+      const LinuxHugePageSize* size = &this->hugePageSizes[i];
+
+      const char* content = FsRootFile_read(size->totalFile, NULL);
+      if (!content)
          continue;
 
       memory_t total = strtoull(content, NULL, 10);
       if (total == 0)
          continue;
 
-      xSnprintf(hugePagePath, sizeof(hugePagePath), "/sys/kernel/mm/hugepages/%s/free_hugepages", name);
-      r = xReadfile(hugePagePath, content, sizeof(content));
-      if (r <= 0)
+      content = FsRootFile_read(size->freeFile, NULL);
+      if (!content)
          continue;
 
       memory_t free = strtoull(content, NULL, 10);
 
-      int shift = ffsl(hugePageSize) - 1 - (HTOP_HUGEPAGE_BASE_SHIFT - 10);
-      assert(shift >= 0 && shift < HTOP_HUGEPAGE_COUNT);
+      int shift = ffsl(size->sizeKB) - 1 - (HTOP_HUGEPAGE_BASE_SHIFT - 10);
+      this->totalHugePageMem += total * size->sizeKB;
+      this->usedHugePageMem[shift] = (total - free) * size->sizeKB;
+   }
+}
+
+static void LinuxMachine_discoverZram(LinuxMachine* this) {
+   this->zramDeviceCount = 0;
 
-      this->totalHugePageMem += total * hugePageSize;
-      this->usedHugePageMem[shift] = (total - free) * hugePageSize;
+   DIR* dir = FsRoot_opendir(&FsRoot_sys, "block");
+   if (!dir)
+      return;
+
+   size_t alloc = 0;
+   const struct dirent* entry;
+   while ((entry = readdir(dir)) != NULL) {
+      const char* name = entry->d_name;
+      if (!String_startsWith(name, "zram"))
+         continue;
+
+      char* endptr;
+      unsigned long int id = strtoul(name + strlen("zram"), &endptr, 10);
+      if (endptr == name + strlen("zram") || *endptr != '\0' || id >= UINT_MAX)
+         continue;
+
+      if (this->zramDeviceCount == alloc) {
+         alloc = alloc ? alloc * 2 : 4;
+         this->zramDevices = xReallocArray(this->zramDevices, alloc, sizeof(LinuxZramDevice));
+      }
+
+      char path[64];
+      LinuxZramDevice* device = &this->zramDevices[this->zramDeviceCount++];
+      xSnprintf(path, sizeof(path), "block/zram%lu/disksize", id);
+      device->disksizeFile = FsRoot_keep(&FsRoot_sys, path);
+      xSnprintf(path, sizeof(path), "block/zram%lu/mm_stat", id);
+      device->mmStatFile = FsRoot_keep(&FsRoot_sys, path);
    }
 
    closedir(dir);
@@ -279,42 +439,36 @@ static void LinuxMachine_scanZramInfo(LinuxMachine* this) {
    memory_t usedZramComp = 0;
    memory_t usedZramOrig = 0;
 
-   char mm_stat[34];
-   char disksize[34];
-
-   unsigned int i = 0;
-   for (;;) {
-      xSnprintf(mm_stat, sizeof(mm_stat), "/sys/block/zram%u/mm_stat", i);
-      xSnprintf(disksize, sizeof(disksize), "/sys/block/zram%u/disksize", i);
-      i++;
-      FILE* disksize_file = fopen(disksize, "r");
-      FILE* mm_stat_file = fopen(mm_stat, "r");
-      if (disksize_file == NULL || mm_stat_file == NULL) {
-         if (disksize_file) {
-            fclose(disksize_file);
-         }
-         if (mm_stat_file) {
-            fclose(mm_stat_file);
-         }
-         break;
-      }
-      memory_t size = 0;
+   if (!Machine_collects(&this->super, LINUX_MACHINE_ZRAM)) {
+      this->nextZramDiscoveryMs = 0;
+      return;
+   }
+
+   if (LinuxMachine_discoveryDue(&this->nextZramDiscoveryMs))
+      LinuxMachine_discoverZram(this);
+
+   for (size_t i = 0; i < this->zramDeviceCount; i++) {
+      const LinuxZramDevice* device = &this->zramDevices[i];
+
+      /* an uninitialized device reads as zero */
+      const char* content = FsRootFile_read(device->disksizeFile, NULL);
+      if (!content)
+         continue;
+
+      memory_t size = strtoull(content, NULL, 10);
+
+      content = FsRootFile_read(device->mmStatFile, NULL);
+      if (!content)
+         continue;
+
       memory_t orig_data_size = 0;
       memory_t compr_data_size = 0;
-
-      if (!fscanf(disksize_file, "%llu\n", &size) ||
-          !fscanf(mm_stat_file, "    %llu       %llu", &orig_data_size, &compr_data_size)) {
-         fclose(disksize_file);
-         fclose(mm_stat_file);
-         break;
-      }
+      if (sscanf(content, "%llu %llu", &orig_data_size, &compr_data_size) != 2)
+         continue;
 
       totalZram += size;
       usedZramComp += compr_data_size;
       usedZramOrig += orig_data_size;
-
-      fclose(disksize_file);
-      fclose(mm_stat_file);
    }
 
    this->zram.totalZram = totalZram / 1024;
@@ -330,7 +484,7 @@ static void LinuxMachine_scanZfsArcstats(LinuxMachine* this) {
    memory_t dnodeSize = 0;
    memory_t bonusSize = 0;
 
-   FILE* file = fopen(PROCARCSTATSFILE, "r");
+   FILE* file = FsRoot_fopen(&FsRoot_proc, PROCARCSTATSFILE, "r");
    if (file == NULL) {
       this->zfs.enabled = 0;
       return;
@@ -399,49 +553,101 @@ static void LinuxMachine_scanZfsArcstats(LinuxMachine* this) {
    }
 }
 
+enum {
+   CPU_TIME_USER,
+   CPU_TIME_NICE,
+   CPU_TIME_SYSTEM,
+   CPU_TIME_IDLE,
+   CPU_TIME_IOWAIT,
+   CPU_TIME_IRQ,
+   CPU_TIME_SOFTIRQ,
+   CPU_TIME_STEAL,
+   CPU_TIME_GUEST,
+   CPU_TIME_GUESTNICE,
+   CPU_TIME_FIELDS
+};
+
+/*
+ * Reads the counters following the name of a cpu line of /proc/stat up to
+ * the end of the line; counters missing on older kernels stay zero.
+ */
+static void LinuxMachine_readCPUTimes(char** line, unsigned long long int times[CPU_TIME_FIELDS]) {
+   char* p = *line;
+
+   for (size_t i = 0; i < CPU_TIME_FIELDS; i++) {
+      while (*p == ' ')
+         p++;
+
+      if (*p < '0' || *p > '9') {
+         memset(&times[i], 0, (CPU_TIME_FIELDS - i) * sizeof(times[0]));
+         break;
+      }
+
+      times[i] = fast_strtoull_dec(&p, 20);
+   }
+
+   *line = p;
+}
+
+/* Start of the line after the one p is in, or end */
+static char* LinuxMachine_nextLine(char* p, char* end) {
+   char* newline = memchr(p, '\n', (size_t)(end - p));
+   return newline ? newline + 1 : end;
+}
+
 static void LinuxMachine_scanCPUTime(LinuxMachine* this) {
    const Machine* super = &this->super;
 
    LinuxMachine_updateCPUcount(this);
 
-   FILE* file = fopen(PROCSTATFILE, "r");
-   if (!file)
-      CRT_fatalError("Cannot open " PROCSTATFILE);
+   size_t length;
+   char* line = LinuxMachine_readProcFile(&this->statFile, PROCSTATFILE, &length);
+   char* const end = line + length;
 
    unsigned int lastAdjCpuId = 0;
 
-   for (unsigned int i = 0; i <= super->existingCPUs; i++) {
-      char buffer[PROC_LINE_LENGTH + 1];
-      unsigned long long int usertime, nicetime, systemtime, idletime;
-      unsigned long long int ioWait = 0, irq = 0, softIrq = 0, steal = 0, guest = 0, guestnice = 0;
-
-      const char* ok = fgets(buffer, sizeof(buffer), file);
-      if (!ok)
-         break;
-
+   for (unsigned int i = 0; i <= super->existingCPUs && line < end; i++) {
       // cpu fields are sorted first
-      if (!String_startsWith(buffer, "cpu"))
+      if (!String_startsWith(line, "cpu"))
          break;
 
-      // Depending on your kernel version,
-      // 5, 7, 8 or 9 of these fields will be set.
-      // The rest will remain at zero.
+      char* p = line + strlen("cpu");
       unsigned int adjCpuId;
       if (i == 0) {
-         (void) sscanf(buffer, "cpu  %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu", &usertime, &nicetime, &systemtime, &idletime, &ioWait, &irq, &softIrq, &steal, &guest, &guestnice);
          adjCpuId = 0;
       } else {
-         unsigned int cpuid;
-         (void) sscanf(buffer, "cpu%4u %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu", &cpuid, &usertime, &nicetime, &systemtime, &idletime, &ioWait, &irq, &softIrq, &steal, &guest, &guestnice);
-         adjCpuId = cpuid + 1;
+         if (*p < '0' || *p > '9')
+            break;
+
+         adjCpuId = (unsigned int)fast_strtoull_dec(&p, 4) + 1;
       }
 
+      // Depending on your kernel version,
+      // 5, 7, 8 or 9 of these fields will be set.
+      // The rest will remain at zero.
+      unsigned long long int times[CPU_TIME_FIELDS];
+      LinuxMachine_readCPUTimes(&p, times);
+      line = LinuxMachine_nextLine(p, end);
+
+      unsigned long long int usertime = times[CPU_TIME_USER];
+      unsigned long long int nicetime = times[CPU_TIME_NICE];
+      unsigned long long int systemtime = times[CPU_TIME_SYSTEM];
+      unsigned long long int idletime = times[CPU_TIME_IDLE];
+      unsigned long long int ioWait = times[CPU_TIME_IOWAIT];
+      unsigned long long int irq = times[CPU_TIME_IRQ];
+      unsigned long long int softIrq = times[CPU_TIME_SOFTIRQ];
+      unsigned long long int steal = times[CPU_TIME_STEAL];
+      unsigned long long int guest = times[CPU_TIME_GUEST];
+      unsigned long long int guestnice = times[CPU_TIME_GUESTNICE];
+
       if (adjCpuId > super->existingCPUs)
          break;
 
       for (unsigned int j = lastAdjCpuId + 1; j < adjCpuId; j++) {
          // Skipped an ID, but /proc/stat is ordered => got offline CPU
+         FsRootFile* frequencyFile = this->cpuData[j].frequencyFile;
          memset(&(this->cpuData[j]), '\0', sizeof(CPUData));
+         this->cpuData[j].frequencyFile = frequencyFile;
       }
       lastAdjCpuId = adjCpuId;
 
@@ -486,16 +692,14 @@ static void LinuxMachine_scanCPUTime(LinuxMachine* this) {
 
    this->period = (double)this->cpuData[0].totalPeriod / super->activeCPUs;
 
-   char buffer[PROC_LINE_LENGTH + 1];
-   while (fgets(buffer, sizeof(buffer), file)) {
-      if (String_startsWith(buffer, "procs_running")) {
-         ProcessTable* pt = (ProcessTable*) super->processTable;
-         pt->runningTasks = strtoul(buffer + strlen("procs_running"), NULL, 10);
+   /* the intr and softirq lines make up most of the rest, memchr() gets past them quickly */
+   for (; line < end; line = LinuxMachine_nextLine(line, end)) {
+      if (String_startsWith(line, "procs_running")) {
+         /* copied into the process table by its scan */
+         this->runningTasks = (unsigned int)strtoul(line + strlen("procs_running"), NULL, 10);
          break;
       }
    }
-
-   fclose(file);
 }
 
 static int scanCPUFrequencyFromSysCPUFreq(LinuxMachine* this) {
@@ -522,18 +726,18 @@ static int scanCPUFrequencyFromSysCPUFreq(LinuxMachine* this) {
          continue;
 
       char pathBuffer[64];
-      xSnprintf(pathBuffer, sizeof(pathBuffer), "/sys/devices/system/cpu/cpu%u/cpufreq/scaling_cur_freq", i);
+      xSnprintf(pathBuffer, sizeof(pathBuffer), "devices/system/cpu/cpu%u/cpufreq/scaling_cur_freq", i);
 
       struct timespec start;
       if (i == 0)
          clock_gettime(CLOCK_MONOTONIC, &start);
 
-      FILE* file = fopen(pathBuffer, "r");
-      if (!file)
+      const char* content = FsRoot_readKept(&FsRoot_sys, &this->cpuData[i + 1].frequencyFile, pathBuffer, NULL);
+      if (!content)
          return -errno;
 
       unsigned long frequency;
-      if (fscanf(file, "%lu", &frequency) == 1) {
+      if (sscanf(content, "%lu", &frequency) == 1) {
          /* convert kHz to MHz */
          frequency = frequency / 1000;
          this->cpuData[i + 1].frequency = frequency;
@@ -541,8 +745,6 @@ static int scanCPUFrequencyFromSysCPUFreq(LinuxMachine* this) {
          totalFrequency += frequency;
       }
 
-      fclose(file);
-
       if (i == 0) {
          struct timespec end;
          clock_gettime(CLOCK_MONOTONIC, &end);
@@ -563,7 +765,7 @@ static int scanCPUFrequencyFromSysCPUFreq(LinuxMachine* this) {
 static void scanCPUFrequencyFromCPUinfo(LinuxMachine* this) {
    const Machine* super = &this->super;
 
-   FILE* file = fopen(PROCCPUINFOFILE, "r");
+   FILE* file = FsRoot_fopen(&FsRoot_proc, PROCCPUINFOFILE, "r");
    if (file == NULL)
       return;
 
@@ -606,42 +808,275 @@ static void scanCPUFrequencyFromCPUinfo(LinuxMachine* this) {
    }
 }
 
+/* The frequency delivered over the interval where APERF and MPERF can be read, else the one asked for */
+static bool scanCPUFrequencyFromCounters(LinuxMachine* this) {
+   const Machine* super = &this->super;
+   if (!CPUFreqCounters_refresh(super))
+      return false;
+
+   int numCPUsWithFrequency = 0;
+   double totalFrequency = 0;
+
+   for (unsigned int i = 0; i < super->existingCPUs; i++) {
+      const double frequency = CPUFreqCounters_mhz(i);
+      this->cpuData[i + 1].frequency = frequency;
+      if (!isnan(frequency)) {
+         numCPUsWithFrequency++;
+         totalFrequency += frequency;
+      }
+   }
+
+   if (numCPUsWithFrequency > 0)
+      this->cpuData[0].frequency = totalFrequency / numCPUsWithFrequency;
+
+   return true;
+}
+
 static void LinuxMachine_scanCPUFrequency(LinuxMachine* this) {
    const Machine* super = &this->super;
 
    for (unsigned int i = 0; i <= super->existingCPUs; i++)
       this->cpuData[i].frequency = NAN;
 
+   if (scanCPUFrequencyFromCounters(this))
+      return;
+
    if (scanCPUFrequencyFromSysCPUFreq(this) == 0)
       return;
 
    scanCPUFrequencyFromCPUinfo(this);
 }
 
+/*
+ * Registers PSI triggers on some pressure over the percent of a window the
+ * setting pressure_trigger asks for, or closes them once it is 0. A window
+ * of one second needs CAP_SYS_RESOURCE, without it recent kernels allow
+ * multiples of two seconds, which is tried next.
+ */
+static void LinuxMachine_updatePressureTriggers(LinuxMachine* this) {
+   static const char* const files[MACHINE_PRESSURE_KINDS] = {
+      [MACHINE_PRESSURE_CPU] = "pressure/cpu",
+      [MACHINE_PRESSURE_MEMORY] = "pressure/memory",
+      [MACHINE_PRESSURE_IO] = "pressure/io",
+   };
+   static const unsigned int windowsUs[] = { 1000000, 2000000 };
+
+   Machine* super = &this->super;
+   const int percent = super->settings->pressureTrigger;
+   if (percent == this->pressureTrigger)
+      return;
+
+   this->pressureTrigger = percent;
+
+   for (size_t i = 0; i < MACHINE_PRESSURE_KINDS; i++) {
+      if (super->pressureFds[i] >= 0)
+         close(super->pressureFds[i]);
+      super->pressureFds[i] = -1;
+
+      if (!percent)
+         continue;
+
+      int fd = Compat_openat(FsRoot_dir(&FsRoot_proc), files[i], O_RDWR | O_NONBLOCK | O_CLOEXEC);
+      if (fd < 0)
+         continue;
+
+      for (size_t w = 0; w < ARRAYSIZE(windowsUs); w++) {
+         char trigger[64];
+         const unsigned int stallUs = windowsUs[w] / 100 * (unsigned int)percent;
+         int len = xSnprintf(trigger, sizeof(trigger), "some %u %u", stallUs, windowsUs[w]);
+         if (write(fd, trigger, (size_t)len + 1) > 0) {
+            super->pressureFds[i] = fd;
+            break;
+         }
+      }
+
+      if (super->pressureFds[i] < 0)
+         close(fd);
+   }
+}
+
+/* Reads RAPL while a meter or the POWER column shows it, apportioning the package power by CPU time */
+static void LinuxMachine_scanPower(LinuxMachine* this) {
+   const Machine* super = &this->super;
+   this->wattsPerCPUPercent = NAN;
+
+   if (!Machine_collects(super, LINUX_MACHINE_POWER))
+      return;
+
+   RAPL_refresh(super->monotonicMs);
+
+   const double package = RAPL_power(RAPL_PACKAGE);
+   const CPUData* all = &this->cpuData[0];
+   const unsigned long long busy = saturatingSub(all->totalPeriod, all->idleAllPeriod);
+   if (isnan(package) || busy == 0 || super->activeCPUs == 0)
+      return;
+
+   /* a task's percent is of the time of one CPU, the share is of the time all CPUs were busy */
+   const double perCPU = (double)all->totalPeriod / super->activeCPUs;
+   this->wattsPerCPUPercent = package * perCPU / (100.0 * (double)busy);
+}
+
 void Machine_scan(Machine* super) {
    LinuxMachine* this = (LinuxMachine*) super;
 
+   /* the memory comes with the processes of the frame replayed */
+   if (Replay_isOpen())
+      return;
+
+   SourceCache_newCycle();
+   IODevices_setPatterns(super->settings);
+
    LinuxMachine_scanMemoryInfo(this);
    LinuxMachine_scanHugePages(this);
-   LinuxMachine_scanZfsArcstats(this);
+   if (Machine_collects(super, LINUX_MACHINE_ZFS))
+      LinuxMachine_scanZfsArcstats(this);
    LinuxMachine_scanZramInfo(this);
+   if (Machine_collects(super, LINUX_MACHINE_NUMA))
+      NumaMemory_refresh(super);
    LinuxMachine_scanCPUTime(this);
+   LinuxMachine_scanPower(this);
+   LinuxMachine_updatePressureTriggers(this);
 
    const Settings* settings = super->settings;
-   if (settings->showCPUFrequency)
+
+   /* shown as N/A while htop is over its CPU budget */
+   if (Budget_isThrifty()) {
+      for (unsigned int i = 0; i <= super->existingCPUs; i++) {
+         this->cpuData[i].frequency = NAN;
+         #ifdef HAVE_SENSORS_SENSORS_H
+         this->cpuData[i].temperature = NAN;
+         #endif
+      }
+      return;
+   }
+
+   const bool cpuMeters = Machine_collects(super, LINUX_MACHINE_CPU_SENSORS);
+
+   if (settings->showCPUFrequency && cpuMeters)
       LinuxMachine_scanCPUFrequency(this);
+   else
+      CPUFreqCounters_close();
 
    #ifdef HAVE_SENSORS_SENSORS_H
-   if (settings->showCPUTemperature)
+   if (settings->showCPUTemperature && cpuMeters)
       LibSensors_getCPUTemperatures(this->cpuData, super->existingCPUs, super->activeCPUs);
    #endif
 }
 
+static void LinuxMachine_setCpuNumaNode(LinuxMachine* this, unsigned int cpu, unsigned int node) {
+   if (cpu >= this->cpuNumaNodeCount)
+      return;
+
+   this->cpuNumaNode[cpu] = (int)node;
+   this->numaNodes = MAXIMUM(this->numaNodes, node + 1);
+}
+
+/* Parses a sysfs CPU list like "0-3,8-11" into the CPUs of `node` */
+static void LinuxMachine_parseNumaCpuList(LinuxMachine* this, const char* list, unsigned int node) {
+   const char* p = list;
+   while (*p >= '0' && *p <= '9') {
+      char* end;
+      unsigned long first = strtoul(p, &end, 10);
+      unsigned long last = first;
+      if (*end == '-')
+         last = strtoul(end + 1, &end, 10);
+
+      for (unsigned long cpu = first; cpu <= last && cpu < this->cpuNumaNodeCount; cpu++)
+         LinuxMachine_setCpuNumaNode(this, (unsigned int)cpu, node);
+
+      p = *end == ',' ? end + 1 : end;
+   }
+}
+
+/* Maps the CPUs to their NUMA nodes from sysfs, true if it lists any */
+static bool LinuxMachine_readNumaNodes(LinuxMachine* this) {
+   DIR* dir = FsRoot_opendir(&FsRoot_sys, "devices/system/node");
+   if (!dir)
+      return false;
+
+   const struct dirent* entry;
+   while ((entry = readdir(dir)) != NULL) {
+      if (!String_startsWith(entry->d_name, "node"))
+         continue;
+
+      char* endp;
+      unsigned long int node = strtoul(entry->d_name + 4, &endp, 10);
+      if (endp == entry->d_name + 4 || *endp != '\0' || node >= UINT_MAX)
+         continue;
+
+      char path[64];
+      char buffer[1024];
+      xSnprintf(path, sizeof(path), "devices/system/node/%s/cpulist", entry->d_name);
+      if (FsRoot_readFile(&FsRoot_sys, path, buffer, sizeof(buffer)) > 0)
+         LinuxMachine_parseNumaCpuList(this, buffer, (unsigned int)node);
+   }
+
+   closedir(dir);
+   return this->numaNodes > 0;
+}
+
+/*
+ * Maps the CPUs to their NUMA nodes, from sysfs or else from the hwloc
+ * topology: sysfs is read at once, while waiting for the topology would
+ * hold up startup. The nodes are not expected to change while running.
+ */
+static void LinuxMachine_scanNumaTopology(LinuxMachine* this) {
+   const Machine* super = &this->super;
+
+   this->cpuNumaNodeCount = super->existingCPUs;
+   this->cpuNumaNode = xMallocArray(this->cpuNumaNodeCount, sizeof(int));
+   for (unsigned int i = 0; i < this->cpuNumaNodeCount; i++)
+      this->cpuNumaNode[i] = -1;
+
+   if (LinuxMachine_readNumaNodes(this))
+      return;
+
+#ifdef HAVE_LIBHWLOC
+   if (Machine_loadTopology(super)) {
+      int count = hwloc_get_nbobjs_by_type(super->topology, HWLOC_OBJ_NUMANODE);
+      for (int i = 0; i < count; i++) {
+         hwloc_obj_t node = hwloc_get_obj_by_type(super->topology, HWLOC_OBJ_NUMANODE, (unsigned int)i);
+         if (!node || !node->cpuset)
+            continue;
+
+         unsigned int cpu;
+         hwloc_bitmap_foreach_begin(cpu, node->cpuset)
+            LinuxMachine_setCpuNumaNode(this, cpu, node->os_index);
+         hwloc_bitmap_foreach_end();
+      }
+   }
+#endif
+}
+
+unsigned int LinuxMachine_groupCPUsByNode(const LinuxMachine* this, unsigned int cpus, unsigned int* order, bool* groupStart) {
+   unsigned int n = 0;
+   unsigned int groups = 0;
+   int lastNode = INT_MIN;
+
+   /* by node, then those of no known node */
+   for (int node = 0; node <= (int)this->numaNodes; node++) {
+      int wanted = node < (int)this->numaNodes ? node : -1;
+      for (unsigned int cpu = 0; cpu < cpus; cpu++) {
+         if (LinuxMachine_cpuNumaNode(this, (int)cpu) != wanted)
+            continue;
+
+         groupStart[n] = wanted != lastNode;
+         if (groupStart[n])
+            groups++;
+         lastNode = wanted;
+         order[n++] = cpu;
+      }
+   }
+
+   return groups;
+}
+
 Machine* Machine_new(UsersTable* usersTable, uid_t userId) {
    LinuxMachine* this = xCalloc(1, sizeof(LinuxMachine));
    Machine* super = &this->super;
 
    Machine_init(super, usersTable, userId);
+   super->collectors = LinuxMachine_collectors;
 
    // Initialize page size
    if ((this->pageSize = sysconf(_SC_PAGESIZE)) == -1)
@@ -653,11 +1088,10 @@ Machine* Machine_new(UsersTable* usersTable, uid_t userId) {
       CRT_fatalError("Cannot get clock ticks by sysconf(_SC_CLK_TCK)");
 
    // Read btime (the kernel boot time, as number of seconds since the epoch)
-   FILE* statfile = fopen(PROCSTATFILE, "r");
-   if (statfile == NULL)
-      CRT_fatalError("Cannot open " PROCSTATFILE);
+   FILE* statfile = LinuxMachine_openProcFile(PROCSTATFILE);
 
    this->boottime = -1;
+   this->wattsPerCPUPercent = NAN;
 
    while (true) {
       char buffer[PROC_LINE_LENGTH + 1];
@@ -667,16 +1101,20 @@ Machine* Machine_new(UsersTable* usersTable, uid_t userId) {
          continue;
       if (sscanf(buffer, "btime %lld\n", &this->boottime) == 1)
          break;
-      CRT_fatalError("Failed to parse btime from " PROCSTATFILE);
+      LinuxMachine_procFileError("Failed to parse btime from", PROCSTATFILE);
    }
    fclose(statfile);
 
    if (this->boottime == -1)
-      CRT_fatalError("No btime in " PROCSTATFILE);
+      LinuxMachine_procFileError("No btime in", PROCSTATFILE);
 
    // Initialize CPU count
    LinuxMachine_updateCPUcount(this);
 
+   LinuxMachine_scanNumaTopology(this);
+
+   Platform_updateTables(super);
+
    return super;
 }
 
@@ -684,6 +1122,9 @@ void Machine_delete(Machine* super) {
    LinuxMachine* this = (LinuxMachine*) super;
    Machine_done(super);
    free(this->cpuData);
+   free(this->cpuNumaNode);
+   free(this->hugePageSizes);
+   free(this->zramDevices);
    free(this);
 }
 
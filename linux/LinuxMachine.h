@@ -8,8 +8,11 @@ in the source distribution for its full text.
 */
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "Machine.h"
+#include "linux/FsRoot.h"
 #include "linux/ZramStats.h"
 #include "linux/ZswapStats.h"
 #include "zfs/ZfsArcStats.h"
@@ -51,8 +54,23 @@ typedef struct CPUData_ {
    #endif
 
    bool online;
+
+   FsRootFile* frequencyFile;   /* scaling_cur_freq, registered when first read */
 } CPUData;
 
+/* A zram device found in /sys/block */
+typedef struct LinuxZramDevice_ {
+   FsRootFile* disksizeFile;
+   FsRootFile* mmStatFile;
+} LinuxZramDevice;
+
+/* A huge page size found in /sys/kernel/mm/hugepages */
+typedef struct LinuxHugePageSize_ {
+   unsigned long int sizeKB;
+   FsRootFile* totalFile;   /* nr_hugepages */
+   FsRootFile* freeFile;    /* free_hugepages */
+} LinuxHugePageSize;
+
 typedef struct LinuxMachine_ {
    Machine super;
 
@@ -68,38 +86,73 @@ typedef struct LinuxMachine_ {
 
    CPUData* cpuData;
 
+   /* NUMA node of each CPU as found at startup, -1 if unknown */
+   int* cpuNumaNode;
+   unsigned int cpuNumaNodeCount;
+   /* Highest NUMA node id plus one, 0 without NUMA information */
+   unsigned int numaNodes;
+
+   /* read on every update, kept open */
+   FsRootFile* statFile;
+   FsRootFile* meminfoFile;
+
    memory_t totalHugePageMem;
    memory_t usedHugePageMem[HTOP_HUGEPAGE_COUNT];
 
+   /* only read while a meter shows them, looked for again every LINUX_DISCOVERY_INTERVAL_MS */
+   LinuxHugePageSize* hugePageSizes;
+   size_t hugePageSizeCount;
+   uint64_t nextHugePageDiscoveryMs;   /* 0 to look for them on the next scan */
+   LinuxZramDevice* zramDevices;
+   size_t zramDeviceCount;
+   uint64_t nextZramDiscoveryMs;
+
    memory_t availableMem;
+   /* SUnreclaim from /proc/meminfo, part of super.usedMem */
+   memory_t unreclaimableSlabMem;
+
+   /* setting pressure_trigger the triggers of super.pressureFds were opened for */
+   int pressureTrigger;
 
    ZfsArcStats zfs;
    ZramStats zram;
    ZswapStats zswap;
+
+   /* Package power (from RAPL) per percent of CPU usage of a task in the last interval, NAN if unknown */
+   double wattsPerCPUPercent;
 } LinuxMachine;
 
-#ifndef PROCDIR
-#define PROCDIR "/proc"
-#endif
+static inline int LinuxMachine_cpuNumaNode(const LinuxMachine* this, int cpu) {
+   return cpu >= 0 && (unsigned int)cpu < this->cpuNumaNodeCount ? this->cpuNumaNode[cpu] : -1;
+}
+
+/*
+ * Lists the first `cpus` CPUs grouped by their NUMA node, those of no known
+ * node last, into `order`; `groupStart` tells whether the CPU at a position
+ * is the first of its group. Returns the number of groups.
+ */
+unsigned int LinuxMachine_groupCPUsByNode(const LinuxMachine* this, unsigned int cpus, unsigned int* order, bool* groupStart);
+
+/* Files below the proc root, see FsRoot_proc */
 
 #ifndef PROCCPUINFOFILE
-#define PROCCPUINFOFILE PROCDIR "/cpuinfo"
+#define PROCCPUINFOFILE "cpuinfo"
 #endif
 
 #ifndef PROCSTATFILE
-#define PROCSTATFILE PROCDIR "/stat"
+#define PROCSTATFILE "stat"
 #endif
 
 #ifndef PROCMEMINFOFILE
-#define PROCMEMINFOFILE PROCDIR "/meminfo"
+#define PROCMEMINFOFILE "meminfo"
 #endif
 
 #ifndef PROCARCSTATSFILE
-#define PROCARCSTATSFILE PROCDIR "/spl/kstat/zfs/arcstats"
+#define PROCARCSTATSFILE "spl/kstat/zfs/arcstats"
 #endif
 
 #ifndef PROCTTYDRIVERSFILE
-#define PROCTTYDRIVERSFILE PROCDIR "/tty/drivers"
+#define PROCTTYDRIVERSFILE "tty/drivers"
 #endif
 
 #ifndef PROC_LINE_LENGTH
@@ -8,9 +8,15 @@ in the source distribution for its full text.
 
 #include "config.h" // IWYU pragma: keep
 
+#define HEAP_CLASS HEAP_PROCESSES
+
 #include "linux/LinuxProcess.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
 #include <math.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -20,15 +26,22 @@ in the source distribution for its full text.
 
 #include "CRT.h"
 #include "Macros.h"
+#include "Meter.h"
 #include "Process.h"
+#include "Profile.h"
 #include "ProvideCurses.h"
 #include "RichString.h"
+#include "Replay.h"
 #include "RowField.h"
 #include "Scheduling.h"
 #include "Settings.h"
+#include "StringRank.h"
 #include "XUtils.h"
+#include "linux/ContainerNames.h"
+#include "linux/FsRoot.h"
 #include "linux/IOPriority.h"
 #include "linux/LinuxMachine.h"
+#include "linux/NVML.h"
 
 
 const ProcessFieldData Process_fields[LAST_PROCESSFIELD] = {
@@ -104,32 +117,119 @@ const ProcessFieldData Process_fields[LAST_PROCESSFIELD] = {
    [PROC_COMM] = { .name = "COMM", .title = "COMM            ", .description = "comm string of the process from /proc/[pid]/comm", .flags = 0, },
    [PROC_EXE] = { .name = "EXE", .title = "EXE             ", .description = "Basename of exe of the process from /proc/[pid]/exe", .flags = 0, },
    [CWD] = { .name = "CWD", .title = "CWD                       ", .description = "The current working directory of the process", .flags = PROCESS_FLAG_CWD, },
+   [CPU_HISTORY] = { .name = "CPU_HISTORY", .title = "CPU HISTORY                    ", .description = "Sparkline of the CPU usage over the last updates, full height being one CPU busy", .flags = PROCESS_FLAG_HISTORY, .defaultSortDesc = true, },
+   [MEM_HISTORY] = { .name = "MEM_HISTORY", .title = "RES HISTORY                    ", .description = "Sparkline of the resident memory over the last updates, against its peak", .flags = PROCESS_FLAG_HISTORY, .defaultSortDesc = true, },
+   [MEM_GROWTH] = { .name = "MEM_GROWTH", .title = "  RES/h ", .description = "Growth of the resident memory per hour, fitted over the memory growth window (leak suspects)", .flags = PROCESS_FLAG_MEM_GROWTH, .defaultSortDesc = true, },
    [AUTOGROUP_ID] = { .name = "AUTOGROUP_ID", .title = "AGRP", .description = "The autogroup identifier of the process", .flags = PROCESS_FLAG_LINUX_AUTOGROUP, },
    [AUTOGROUP_NICE] = { .name = "AUTOGROUP_NICE", .title = " ANI", .description = "Nice value (the higher the value, the more other processes take priority) associated with the process autogroup", .flags = PROCESS_FLAG_LINUX_AUTOGROUP, },
+#ifdef HAVE_PERF_EVENTS
+   [PERF_IPC] = { .name = "PERF_IPC", .title = "  IPC ", .description = "Instructions per cycle in user space (hardware counters, rows on screen only)", .flags = PROCESS_FLAG_LINUX_PERF, .defaultSortDesc = true, },
+   [PERF_LLC_MISSES] = { .name = "PERF_LLC_MISSES", .title = "  LLCMISS/s ", .description = "Last level cache misses per second (hardware counters, rows on screen only)", .flags = PROCESS_FLAG_LINUX_PERF, .defaultSortDesc = true, },
+   [PERF_BRANCH_MISS] = { .name = "PERF_BRANCH_MISS", .title = "BMIS% ", .description = "Share of branches mispredicted (hardware counters, rows on screen only)", .flags = PROCESS_FLAG_LINUX_PERF, .defaultSortDesc = true, },
+   [PERF_STALLED] = { .name = "PERF_STALLED", .title = "STAL% ", .description = "Share of cycles the CPU backend stalled (hardware counters, rows on screen only)", .flags = PROCESS_FLAG_LINUX_PERF, .defaultSortDesc = true, },
+#endif
+   [NUMA_REMOTE] = { .name = "NUMA_REMOTE", .title = "RMEM% ", .description = "Share of the resident memory on other NUMA nodes than the one of the CPU last run on (from numa_maps)", .flags = PROCESS_FLAG_LINUX_NUMA, .defaultSortDesc = true, },
+   [NUMA_NODES] = { .name = "NUMA_NODES", .title = "NUMA RES", .description = "Resident memory on each NUMA node (from numa_maps)", .flags = PROCESS_FLAG_LINUX_NUMA, .defaultSortDesc = true, .autoWidth = true, },
+   [GPU_PERCENT] = { .name = "GPU_PERCENT", .title = " GPU% ", .description = "Usage of the busiest GPU engine by the process (from the fdinfo of its DRM clients)", .flags = PROCESS_FLAG_LINUX_GPU, .defaultSortDesc = true, },
+   [NV_SM_PERCENT] = { .name = "NV_SM_PERCENT", .title = "  SM% ", .description = "Usage of the streaming multiprocessors of NVIDIA GPUs by the process (from NVML)", .flags = PROCESS_FLAG_LINUX_NVML, .defaultSortDesc = true, },
+   [NV_MEMORY] = { .name = "NV_MEMORY", .title = " NVMEM ", .description = "Memory of NVIDIA GPUs used by the process (from NVML)", .flags = PROCESS_FLAG_LINUX_NVML, .defaultSortDesc = true, },
+   [EST_POWER] = { .name = "EST_POWER", .title = "  POWER ", .description = "Estimated power of the process: its share of the CPU time used in the interval times the package power from RAPL", .flags = PROCESS_FLAG_LINUX_POWER, .defaultSortDesc = true, },
+   [GPU_MEMORY] = { .name = "GPU_MEMORY", .title = "GPUMEM ", .description = "GPU memory resident for the DRM clients of the process", .flags = PROCESS_FLAG_LINUX_GPU, .defaultSortDesc = true, },
+   [GPU_TIME] = { .name = "GPU_TIME", .title = " GPU_TIME+ ", .description = "GPU engine time used by the open DRM clients of the process", .flags = PROCESS_FLAG_LINUX_GPU, .defaultSortDesc = true, },
+   [GPU_ENGINES] = { .name = "GPU_ENGINES", .title = "GPU ENGINES", .description = "Busy GPU engines of the process", .flags = PROCESS_FLAG_LINUX_GPU, .autoWidth = true, },
+   [FD_COUNT] = { .name = "FD_COUNT", .title = "    FDS ", .description = "Number of open file descriptors (counted in /proc/<pid>/fd)", .flags = PROCESS_FLAG_LINUX_FDS, .defaultSortDesc = true, },
+   [FD_RATE] = { .name = "FD_RATE", .title = " FDS/s ", .description = "Change of the number of open file descriptors per second, to spot fd leaks", .flags = PROCESS_FLAG_LINUX_FDS, .defaultSortDesc = true, },
+   [FILE_LOCKS] = { .name = "FILE_LOCKS", .title = "LOCKS ", .description = "Number of file locks held by the process (POSIX, flock and leases)", .flags = PROCESS_FLAG_LINUX_LOCKS, .defaultSortDesc = true, },
+   [PERCENT_RUNQ_WAIT] = { .name = "PERCENT_RUNQ_WAIT", .title = "RUNQ% ", .description = "Share of time the task waited on a CPU run queue (from /proc/<pid>/schedstat)", .flags = PROCESS_FLAG_LINUX_SCHEDSTAT, .defaultSortDesc = true, },
+   [RUNQ_WAIT_AVG] = { .name = "RUNQ_WAIT_AVG", .title = "RUNQ_MS ", .description = "Average run queue wait per timeslice in milliseconds (from /proc/<pid>/schedstat)", .flags = PROCESS_FLAG_LINUX_SCHEDSTAT, .defaultSortDesc = true, },
+   [PERCENT_THROTTLED] = { .name = "PERCENT_THROTTLED", .title = "THRT% ", .description = "Share of time the cgroup of the process was throttled by its CPU quota (from cpu.stat)", .flags = PROCESS_FLAG_LINUX_CGROUP | PROCESS_FLAG_LINUX_THROTTLE, .defaultSortDesc = true, },
+   [THROTTLE_RATE] = { .name = "THROTTLE_RATE", .title = "THRT/s ", .description = "Periods per second the cgroup of the process was throttled in by its CPU quota (from cpu.stat)", .flags = PROCESS_FLAG_LINUX_CGROUP | PROCESS_FLAG_LINUX_THROTTLE, .defaultSortDesc = true, },
+   [PERCENT_CPU_QUOTA] = { .name = "PERCENT_CPU_QUOTA", .title = "QCPU% ", .description = "CPU% of the process in percent of the CPU quota of its cgroup (from cpu.max)", .flags = PROCESS_FLAG_LINUX_CGROUP | PROCESS_FLAG_LINUX_LIMITS, .defaultSortDesc = true, },
+   [CGROUP_MEMORY_HEADROOM] = { .name = "CGROUP_MEMORY_HEADROOM", .title = "MEMROOM ", .description = "Memory the cgroup of the process can still be charged before reaching its limit (memory.max - memory.current)", .flags = PROCESS_FLAG_LINUX_CGROUP | PROCESS_FLAG_LINUX_LIMITS, },
+   [PERCENT_THP] = { .name = "PERCENT_THP", .title = " THP% ", .description = "Share of the resident memory mapped by transparent huge pages (from smaps_rollup)", .flags = PROCESS_FLAG_LINUX_THP, .defaultSortDesc = true, },
+   [M_HUGETLB] = { .name = "M_HUGETLB", .title = "HUGETLB ", .description = "Memory of hugetlbfs huge pages mapped by the process, not counted as resident (from smaps_rollup)", .flags = PROCESS_FLAG_LINUX_THP, .defaultSortDesc = true, },
+   [CGROUP_CPU_PRESSURE] = { .name = "CGROUP_CPU_PRESSURE", .title = "PSI CPU ", .description = "Share of the last 10 seconds some tasks of the cgroup of the process waited for a CPU (from cpu.pressure)", .flags = PROCESS_FLAG_LINUX_CGROUP | PROCESS_FLAG_LINUX_PRESSURE, .defaultSortDesc = true, },
+   [CGROUP_MEMORY_PRESSURE] = { .name = "CGROUP_MEMORY_PRESSURE", .title = "PSI MEM ", .description = "Share of the last 10 seconds some tasks of the cgroup of the process waited for memory (from memory.pressure)", .flags = PROCESS_FLAG_LINUX_CGROUP | PROCESS_FLAG_LINUX_PRESSURE, .defaultSortDesc = true, },
+   [CGROUP_IO_PRESSURE] = { .name = "CGROUP_IO_PRESSURE", .title = " PSI IO ", .description = "Share of the last 10 seconds some tasks of the cgroup of the process waited for I/O (from io.pressure)", .flags = PROCESS_FLAG_LINUX_CGROUP | PROCESS_FLAG_LINUX_PRESSURE, .defaultSortDesc = true, },
+   [MAJFLT_RATE] = { .name = "MAJFLT_RATE", .title = "MAJF/s ", .description = "Major page faults per second, pages read from storage or swap (from stat)", .flags = PROCESS_FLAG_LINUX_FAULTS, .defaultSortDesc = true, },
+   [MINFLT_RATE] = { .name = "MINFLT_RATE", .title = "MINF/s ", .description = "Minor page faults per second, pages mapped without reading them (from stat)", .flags = PROCESS_FLAG_LINUX_FAULTS, .defaultSortDesc = true, },
+   [CGROUP_REFAULT_RATE] = { .name = "CGROUP_REFAULT_RATE", .title = "REFLT/s ", .description = "Pages per second the cgroup of the process faulted back in soon after evicting them (from memory.stat)", .flags = PROCESS_FLAG_LINUX_CGROUP | PROCESS_FLAG_LINUX_MEMSTAT, .defaultSortDesc = true, },
+   [CGROUP_SWAPIN_RATE] = { .name = "CGROUP_SWAPIN_RATE", .title = "SWPIN/s ", .description = "Pages per second the cgroup of the process read from swap (from memory.stat)", .flags = PROCESS_FLAG_LINUX_CGROUP | PROCESS_FLAG_LINUX_MEMSTAT, .defaultSortDesc = true, },
+   [WCHAN] = { .name = "WCHAN", .title = "WCHAN", .description = "Kernel function the task is sleeping in (from /proc/<pid>/wchan)", .flags = PROCESS_FLAG_LINUX_WCHAN, .autoWidth = true, },
+   [MIGRATE_RATE] = { .name = "MIGRATE_RATE", .title = "MIGR/s ", .description = "Changes per second of the CPU the task runs on, as seen between updates (the main thread for processes)", .flags = PROCESS_FLAG_LINUX_MIGRATE, .defaultSortDesc = true, },
+   [NVCSW_RATE] = { .name = "NVCSW_RATE", .title = "NVCSW/s ", .description = "Involuntary context switches per second, the task being preempted (the main thread for processes)", .flags = PROCESS_FLAG_LINUX_MIGRATE, .defaultSortDesc = true, },
+#ifdef HAVE_BPF_COLUMNS
+   [NET_RX] = { .name = "NET_RX", .title = "     NET RX ", .description = "Bytes per second received over TCP and UDP sockets by the process (from a pinned BPF map)", .flags = PROCESS_FLAG_LINUX_BPF_NET, .defaultSortDesc = true, },
+   [NET_TX] = { .name = "NET_TX", .title = "     NET TX ", .description = "Bytes per second sent over TCP and UDP sockets by the process (from a pinned BPF map)", .flags = PROCESS_FLAG_LINUX_BPF_NET, .defaultSortDesc = true, },
+   [FUTEX_WAIT_PERCENT] = { .name = "FUTEX_WAIT_PERCENT", .title = "FUTEX% ", .description = "Time the threads of the process waited on locks in futex(2), in percent of one CPU (from a pinned BPF map)", .flags = PROCESS_FLAG_LINUX_BPF_FUTEX, .defaultSortDesc = true, },
+   [SYSCALL_RATE] = { .name = "SYSCALL_RATE", .title = "SYSCALLS/s ", .description = "System calls per second made by the threads of the process (from a pinned BPF map)", .flags = PROCESS_FLAG_LINUX_BPF_SYSCALLS, .defaultSortDesc = true, },
+   [TOP_SYSCALL] = { .name = "TOP_SYSCALL", .title = "TOP SYSCALL          ", .description = "Most frequent system call of the process since the last update, with its share of all its calls (from a pinned BPF map)", .flags = PROCESS_FLAG_LINUX_BPF_SYSCALLS, },
+#endif
 #ifdef SCHEDULER_SUPPORT
    [SCHEDULERPOLICY] = { .name = "SCHEDULERPOLICY", .title = "SCHED ", .description = "Current scheduling policy of the process", .flags = PROCESS_FLAG_SCHEDPOL, },
 #endif
 };
 
 Process* LinuxProcess_new(const Machine* host) {
-   LinuxProcess* this = xCalloc(1, sizeof(LinuxProcess));
+   LinuxProcess* this = Process_allocate(sizeof(LinuxProcess));
    Object_setClass(this, Class(LinuxProcess));
    Process_init(&this->super, host);
+#ifdef HAVE_OPENAT
+   this->procFd = -1;
+#endif
+   this->pidfd = -1;
+   Profile_rowMemory.rowSize = sizeof(LinuxProcess);
+   Profile_rowMemory.detailsSize = sizeof(LinuxProcessDetails);
+   Profile_rowMemory.rows++;
    return &this->super;
 }
 
 void Process_delete(Object* cast) {
    LinuxProcess* this = (LinuxProcess*) cast;
    Process_done((Process*)cast);
-   free(this->container_short);
-   free(this->cgroup_short);
-   free(this->cgroup);
+#ifdef HAVE_OPENAT
+   if (this->procFd >= 0)
+      close(this->procFd);
+#endif
+   if (this->pidfd >= 0)
+      close(this->pidfd);
+   CGroupName_release(this->cgroup);
+   if (this->details) {
 #ifdef HAVE_OPENVZ
-   free(this->ctid);
+      free(this->details->ctid);
+#endif
+#ifdef HAVE_PERF_EVENTS
+      PerfCounters_close(this->details->perf);
 #endif
-   free(this->secattr);
-   free(this);
+      free(this->details->secattr);
+      free(this->details->wchan);
+      free(this->details->numaKB);
+      GPUProcessData_delete(this->details->gpu);
+      free(this->details);
+      Profile_rowMemory.details--;
+   }
+   Profile_rowMemory.rows--;
+   Process_release(this, sizeof(LinuxProcess));
+}
+
+const LinuxProcessDetails LinuxProcess_noDetails;
+
+LinuxProcessDetails* LinuxProcess_details(LinuxProcess* this) {
+   if (!this->details) {
+      this->details = xCalloc(1, sizeof(LinuxProcessDetails));
+      Profile_rowMemory.details++;
+   }
+   return this->details;
+}
+
+#ifdef HAVE_PERF_EVENTS
+static const PerfCounterRates LinuxProcess_noPerfRates = { NAN, NAN, NAN, NAN };
+
+/* Rates of a task without open counters are unknown, not zero */
+static inline const PerfCounterRates* LinuxProcess_perfRates(const LinuxProcessDetails* d) {
+   return d->perf ? &d->perfRates : &LinuxProcess_noPerfRates;
 }
+#endif
 
 /*
 [1] Note that before kernel 2.6.26 a process that has not asked for
@@ -179,7 +279,7 @@ bool LinuxProcess_rowSetIOPriority(Row* super, Arg ioprio) {
 
 bool LinuxProcess_isAutogroupEnabled(void) {
    char buf[16];
-   if (xReadfile(PROCDIR "/sys/kernel/sched_autogroup_enabled", buf, sizeof(buf)) < 0)
+   if (FsRoot_readFile(&FsRoot_proc, "sys/kernel/sched_autogroup_enabled", buf, sizeof(buf)) < 0)
       return false;
    return buf[0] == '1';
 }
@@ -187,9 +287,9 @@ bool LinuxProcess_isAutogroupEnabled(void) {
 static bool LinuxProcess_changeAutogroupPriorityBy(Process* p, Arg delta) {
    char buffer[256];
    pid_t pid = Process_getPid(p);
-   xSnprintf(buffer, sizeof(buffer), PROCDIR "/%d/autogroup", pid);
+   xSnprintf(buffer, sizeof(buffer), "%d/autogroup", pid);
 
-   FILE* file = fopen(buffer, "r+");
+   FILE* file = FsRoot_fopen(&FsRoot_proc, buffer, "r+");
    if (!file)
       return false;
 
@@ -216,21 +316,170 @@ bool LinuxProcess_rowChangeAutogroupPriorityBy(Row* super, Arg delta) {
 }
 
 static double LinuxProcess_totalIORate(const LinuxProcess* lp) {
+   const LinuxProcessDetails* d = LinuxProcess_getDetails(lp);
+   const double readRate = Rate_value(&d->io_read_rate);
+   const double writeRate = Rate_value(&d->io_write_rate);
    double totalRate = NAN;
-   if (isNonnegative(lp->io_rate_read_bps)) {
-      totalRate = lp->io_rate_read_bps;
-      if (isNonnegative(lp->io_rate_write_bps)) {
-         totalRate += lp->io_rate_write_bps;
+   if (isNonnegative(readRate)) {
+      totalRate = readRate;
+      if (isNonnegative(writeRate)) {
+         totalRate += writeRate;
       }
-   } else if (isNonnegative(lp->io_rate_write_bps)) {
-      totalRate = lp->io_rate_write_bps;
+   } else if (isNonnegative(writeRate)) {
+      totalRate = writeRate;
    }
    return totalRate;
 }
 
+/* Whether a value read by a budgeted collector was not refreshed recently */
+static bool LinuxProcess_isStale(const LinuxProcess* lp, LinuxCollector which) {
+   const uint64_t last = lp->collectedMs[which];
+   return last && lp->super.super.host->monotonicMs - last >= LINUX_COLLECTOR_STALE_MS;
+}
+
+static void LinuxProcess_staleAttr(const LinuxProcess* lp, LinuxCollector which, int* attr) {
+   if (LinuxProcess_isStale(lp, which))
+      *attr = CRT_colors[PROCESS_SHADOW];
+}
+
+static void LinuxProcess_printStaleKBytes(const LinuxProcess* lp, RichString* str, unsigned long long number, bool coloring) {
+   int start = RichString_size(str);
+   Row_printKBytes(str, number, coloring);
+   if (LinuxProcess_isStale(lp, LINUX_COLLECTOR_SMAPS))
+      RichString_setAttrn(str, CRT_colors[PROCESS_SHADOW], start, RichString_size(str) - start);
+}
+
+/* Share of the resident memory in transparent huge pages, NAN until smaps was read */
+static float LinuxProcess_thpPercent(const LinuxProcess* this) {
+   if (!this->collectedMs[LINUX_COLLECTOR_SMAPS])
+      return NAN;
+
+   return LinuxProcess_getDetails(this)->thp_percent;
+}
+
+/* Resident memory on all NUMA nodes (in kB), 0 if numa_maps was not read */
+static unsigned long long LinuxProcess_numaTotalKB(const LinuxProcess* this) {
+   const LinuxProcessDetails* d = LinuxProcess_getDetails(this);
+   if (!d->numaKB)
+      return 0;
+
+   const LinuxMachine* lhost = (const LinuxMachine*) this->super.super.host;
+   unsigned long long total = 0;
+   for (unsigned int i = 0; i < lhost->numaNodes; i++)
+      total += d->numaKB[i];
+   return total;
+}
+
+/* Share of the resident memory away from the node of the CPU the process last ran on */
+static double LinuxProcess_numaRemotePercent(const LinuxProcess* this) {
+   const LinuxProcessDetails* d = LinuxProcess_getDetails(this);
+   const LinuxMachine* lhost = (const LinuxMachine*) this->super.super.host;
+   const int node = LinuxMachine_cpuNumaNode(lhost, this->super.processor);
+   const unsigned long long total = LinuxProcess_numaTotalKB(this);
+   if (node < 0 || total == 0)
+      return NAN;
+
+   return (double)(total - d->numaKB[node]) / (double)total * 100.0;
+}
+
+int LinuxProcess_formatNumaNodes(const LinuxProcess* this, char* buffer, size_t size) {
+   const LinuxProcessDetails* d = LinuxProcess_getDetails(this);
+   if (!d->numaKB)
+      return xSnprintf(buffer, size, "N/A");
+
+   const LinuxMachine* lhost = (const LinuxMachine*) this->super.super.host;
+   size_t len = 0;
+   buffer[0] = '\0';
+   for (unsigned int i = 0; i < lhost->numaNodes; i++) {
+      char amount[16];
+      Meter_humanUnit(amount, (double)d->numaKB[i], sizeof(amount));
+      int written = snprintf(buffer + len, size - len, "%sN%u:%s", len ? " " : "", i, amount);
+      /* nodes not fitting any more are left out */
+      if (written < 0 || (size_t)written >= size - len) {
+         buffer[len] = '\0';
+         break;
+      }
+      len += (size_t)written;
+   }
+   return (int)len;
+}
+
+/* Open fds, -1 if they were never counted */
+static long LinuxProcess_fdCount(const LinuxProcessDetails* d) {
+   return d->fdCountMs ? (long)d->fdCount : -1;
+}
+
+static double LinuxProcess_fdRate(const LinuxProcessDetails* d) {
+   return d->fdCountMs ? d->fdRate : NAN;
+}
+
+#ifdef HAVE_BPF_COLUMNS
+/* Summed over the threads, so more than 100 when several of them wait */
+static float LinuxProcess_futexWaitPercent(const LinuxProcessDetails* d) {
+   const double rate = Rate_value(&d->futex_wait_rate);
+   return isnan(rate) ? NAN : (float)(rate / 1e7);
+}
+
+/* NULL when there was none, or its number is not known */
+static const char* LinuxProcess_topSyscallName(const LinuxProcessDetails* d) {
+   return d->top_syscall_percent > 0.0F ? BpfSyscalls_name(d->top_syscall) : NULL;
+}
+
+static void LinuxProcess_printTopSyscall(const LinuxProcessDetails* d, char* buffer, size_t n, int* attr) {
+   if (!(d->top_syscall_percent > 0.0F)) {
+      *attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, "%-20s ", isnan(Rate_value(&d->syscall_rate)) ? "N/A" : "-");
+      return;
+   }
+
+   char number[16];
+   const char* name = LinuxProcess_topSyscallName(d);
+   if (!name) {
+      xSnprintf(number, sizeof(number), "#%u", d->top_syscall);
+      name = number;
+   }
+   xSnprintf(buffer, n, "%-15.15s %3.0f%% ", name, (double)d->top_syscall_percent);
+}
+#endif
+
+/* Share of the package power for the CPU time the task used in the last interval */
+static double LinuxProcess_estimatedPower(const Process* this, const LinuxMachine* lhost) {
+   return isNonnegative(this->percent_cpu) ? this->percent_cpu * lhost->wattsPerCPUPercent : NAN;
+}
+
+/* Events per second, dimmed when there are (next to) none */
+static void LinuxProcess_printEventRate(double rate, char* buffer, size_t n, int width, int* attr) {
+   if (isnan(rate)) {
+      *attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, "%*s ", width, "N/A");
+      return;
+   }
+
+   if (rate < 0.05)
+      *attr = CRT_colors[PROCESS_SHADOW];
+   xSnprintf(buffer, n, rate < 1000.0 ? "%*.1f " : "%*.0f ", width, rate);
+}
+
+static const char* LinuxProcess_cgroupString(const CGroupName* cgroup, ProcessField key) {
+   if (!cgroup)
+      return NULL;
+
+   switch (key) {
+   case CGROUP:
+      return cgroup->raw;
+   case CCGROUP:
+      return cgroup->compressed;
+   default: {
+      const char* name = ContainerNames_label(cgroup->containerName, NULL);
+      return name ? name : cgroup->container;
+   }
+   }
+}
+
 static void LinuxProcess_rowWriteField(const Row* super, RichString* str, ProcessField field) {
    const Process* this = (const Process*) super;
    const LinuxProcess* lp = (const LinuxProcess*) super;
+   const LinuxProcessDetails* d = LinuxProcess_getDetails(lp);
    const Machine* host = (const Machine*) super->host;
    const LinuxMachine* lhost = (const LinuxMachine*) super->host;
 
@@ -245,7 +494,10 @@ static void LinuxProcess_rowWriteField(const Row* super, RichString* str, Proces
    case M_DRS: Row_printBytes(str, lp->m_drs * lhost->pageSize, coloring); return;
    case M_LRS:
       if (lp->m_lrs) {
+         int start = RichString_size(str);
          Row_printBytes(str, lp->m_lrs * lhost->pageSize, coloring);
+         if (LinuxProcess_isStale(lp, LINUX_COLLECTOR_MAPS))
+            RichString_setAttrn(str, CRT_colors[PROCESS_SHADOW], start, RichString_size(str) - start);
          return;
       }
 
@@ -255,33 +507,47 @@ static void LinuxProcess_rowWriteField(const Row* super, RichString* str, Proces
    case M_TRS: Row_printBytes(str, lp->m_trs * lhost->pageSize, coloring); return;
    case M_SHARE: Row_printBytes(str, lp->m_share * lhost->pageSize, coloring); return;
    case M_PRIV: Row_printKBytes(str, lp->m_priv, coloring); return;
-   case M_PSS: Row_printKBytes(str, lp->m_pss, coloring); return;
-   case M_SWAP: Row_printKBytes(str, lp->m_swap, coloring); return;
-   case M_PSSWP: Row_printKBytes(str, lp->m_psswp, coloring); return;
+   case M_PSS: LinuxProcess_printStaleKBytes(lp, str, d->m_pss, coloring); return;
+   case M_SWAP: LinuxProcess_printStaleKBytes(lp, str, d->m_swap, coloring); return;
+   case M_PSSWP: LinuxProcess_printStaleKBytes(lp, str, d->m_psswp, coloring); return;
+   case M_HUGETLB: LinuxProcess_printStaleKBytes(lp, str, d->m_hugetlb, coloring); return;
+   case PERCENT_THP: Row_printPercentage(LinuxProcess_thpPercent(lp), buffer, n, 5, &attr); LinuxProcess_staleAttr(lp, LINUX_COLLECTOR_SMAPS, &attr); break;
    case UTIME: Row_printTime(str, lp->utime, coloring); return;
    case STIME: Row_printTime(str, lp->stime, coloring); return;
    case CUTIME: Row_printTime(str, lp->cutime, coloring); return;
    case CSTIME: Row_printTime(str, lp->cstime, coloring); return;
-   case RCHAR:  Row_printBytes(str, lp->io_rchar, coloring); return;
-   case WCHAR:  Row_printBytes(str, lp->io_wchar, coloring); return;
-   case SYSCR:  Row_printCount(str, lp->io_syscr, coloring); return;
-   case SYSCW:  Row_printCount(str, lp->io_syscw, coloring); return;
-   case RBYTES: Row_printBytes(str, lp->io_read_bytes, coloring); return;
-   case WBYTES: Row_printBytes(str, lp->io_write_bytes, coloring); return;
-   case CNCLWB: Row_printBytes(str, lp->io_cancelled_write_bytes, coloring); return;
-   case IO_READ_RATE:  Row_printRate(str, lp->io_rate_read_bps, coloring); return;
-   case IO_WRITE_RATE: Row_printRate(str, lp->io_rate_write_bps, coloring); return;
+   case RCHAR:  Row_printBytes(str, d->io_rchar, coloring); return;
+   case WCHAR:  Row_printBytes(str, d->io_wchar, coloring); return;
+   case SYSCR:  Row_printCount(str, d->io_syscr, coloring); return;
+   case SYSCW:  Row_printCount(str, d->io_syscw, coloring); return;
+   case RBYTES: Row_printBytes(str, d->io_read_bytes, coloring); return;
+   case WBYTES: Row_printBytes(str, d->io_write_bytes, coloring); return;
+   case CNCLWB: Row_printBytes(str, d->io_cancelled_write_bytes, coloring); return;
+   case IO_READ_RATE:  Row_printRate(str, Rate_value(&d->io_read_rate), coloring); return;
+   case IO_WRITE_RATE: Row_printRate(str, Rate_value(&d->io_write_rate), coloring); return;
    case IO_RATE: Row_printRate(str, LinuxProcess_totalIORate(lp), coloring); return;
+   #ifdef HAVE_BPF_COLUMNS
+   case NET_RX: Row_printRate(str, Rate_value(&d->net_rx_rate), coloring); return;
+   case NET_TX: Row_printRate(str, Rate_value(&d->net_tx_rate), coloring); return;
+   case FUTEX_WAIT_PERCENT: Row_printPercentage(LinuxProcess_futexWaitPercent(d), buffer, n, 6, &attr); break;
+   case SYSCALL_RATE: LinuxProcess_printEventRate(Rate_value(&d->syscall_rate), buffer, n, 10, &attr); break;
+   case TOP_SYSCALL: LinuxProcess_printTopSyscall(d, buffer, n, &attr); break;
+   #endif
    #ifdef HAVE_OPENVZ
-   case CTID: xSnprintf(buffer, n, "%-8s ", lp->ctid ? lp->ctid : ""); break;
-   case VPID: xSnprintf(buffer, n, "%*d ", Process_pidDigits, lp->vpid); break;
+   case CTID: xSnprintf(buffer, n, "%-8s ", d->ctid ? d->ctid : ""); break;
+   case VPID: xSnprintf(buffer, n, "%*d ", Process_pidDigits, d->vpid); break;
    #endif
    #ifdef HAVE_VSERVER
-   case VXID: xSnprintf(buffer, n, "%5u ", lp->vxid); break;
+   case VXID: xSnprintf(buffer, n, "%5u ", d->vxid); break;
    #endif
-   case CGROUP: xSnprintf(buffer, n, "%-*.*s ", Row_fieldWidths[CGROUP], Row_fieldWidths[CGROUP], lp->cgroup ? lp->cgroup : "N/A"); break;
-   case CCGROUP: xSnprintf(buffer, n, "%-*.*s ", Row_fieldWidths[CCGROUP], Row_fieldWidths[CCGROUP], lp->cgroup_short ? lp->cgroup_short : (lp->cgroup ? lp->cgroup : "N/A")); break;
-   case CONTAINER: xSnprintf(buffer, n, "%-*.*s ", Row_fieldWidths[CONTAINER], Row_fieldWidths[CONTAINER], lp->container_short ? lp->container_short : "N/A"); break;
+   case CGROUP: LinuxProcess_staleAttr(lp, LINUX_COLLECTOR_CGROUP, &attr); xSnprintf(buffer, n, "%-*.*s ", Row_fieldWidths[CGROUP], Row_fieldWidths[CGROUP], lp->cgroup ? lp->cgroup->raw : "N/A"); break;
+   case CCGROUP: LinuxProcess_staleAttr(lp, LINUX_COLLECTOR_CGROUP, &attr); xSnprintf(buffer, n, "%-*.*s ", Row_fieldWidths[CCGROUP], Row_fieldWidths[CCGROUP], lp->cgroup ? (lp->cgroup->compressed ? lp->cgroup->compressed : lp->cgroup->raw) : "N/A"); break;
+   case CONTAINER: {
+      LinuxProcess_staleAttr(lp, LINUX_COLLECTOR_CGROUP, &attr);
+      const char* container = LinuxProcess_cgroupString(lp->cgroup, CONTAINER);
+      xSnprintf(buffer, n, "%-*.*s ", Row_fieldWidths[CONTAINER], Row_fieldWidths[CONTAINER], container ? container : "N/A");
+      break;
+   }
    case OOM: xSnprintf(buffer, n, "%4u ", lp->oom); break;
    case IO_PRIORITY: {
       int klass = IOPriority_class(lp->ioPriority);
@@ -302,30 +568,180 @@ static void LinuxProcess_rowWriteField(const Row* super, RichString* str, Proces
       break;
    }
    #ifdef HAVE_DELAYACCT
-   case PERCENT_CPU_DELAY: Row_printPercentage(lp->cpu_delay_percent, buffer, n, 5, &attr); break;
-   case PERCENT_IO_DELAY: Row_printPercentage(lp->blkio_delay_percent, buffer, n, 5, &attr); break;
-   case PERCENT_SWAP_DELAY: Row_printPercentage(lp->swapin_delay_percent, buffer, n, 5, &attr); break;
+   case PERCENT_CPU_DELAY: Row_printPercentage(d->cpu_delay_percent, buffer, n, 5, &attr); LinuxProcess_staleAttr(lp, LINUX_COLLECTOR_DELAYACCT, &attr); break;
+   case PERCENT_IO_DELAY: Row_printPercentage(d->blkio_delay_percent, buffer, n, 5, &attr); LinuxProcess_staleAttr(lp, LINUX_COLLECTOR_DELAYACCT, &attr); break;
+   case PERCENT_SWAP_DELAY: Row_printPercentage(d->swapin_delay_percent, buffer, n, 5, &attr); LinuxProcess_staleAttr(lp, LINUX_COLLECTOR_DELAYACCT, &attr); break;
    #endif
+   #ifdef HAVE_PERF_EVENTS
+   case PERF_IPC: {
+      const double ipc = LinuxProcess_perfRates(d)->ipc;
+      if (isNonnegative(ipc)) {
+         xSnprintf(buffer, n, "%5.2f ", ipc);
+      } else {
+         attr = CRT_colors[PROCESS_SHADOW];
+         xSnprintf(buffer, n, "  N/A ");
+      }
+      break;
+   }
+   case PERF_LLC_MISSES: {
+      const double rate = LinuxProcess_perfRates(d)->llcMissRate;
+      Row_printCount(str, isNonnegative(rate) ? (unsigned long long)rate : ULLONG_MAX, coloring);
+      return;
+   }
+   case PERF_BRANCH_MISS: Row_printPercentage(LinuxProcess_perfRates(d)->branchMissPercent, buffer, n, 5, &attr); break;
+   case PERF_STALLED: Row_printPercentage(LinuxProcess_perfRates(d)->stalledPercent, buffer, n, 5, &attr); break;
+   #endif
+   case NUMA_REMOTE: Row_printPercentage(LinuxProcess_numaRemotePercent(lp), buffer, n, 5, &attr); LinuxProcess_staleAttr(lp, LINUX_COLLECTOR_NUMA, &attr); break;
+   case NUMA_NODES: {
+      char nodes[128];
+      LinuxProcess_formatNumaNodes(lp, nodes, sizeof(nodes));
+      LinuxProcess_staleAttr(lp, LINUX_COLLECTOR_NUMA, &attr);
+      if (!d->numaKB)
+         attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, "%-*.*s ", Row_fieldWidths[NUMA_NODES], Row_fieldWidths[NUMA_NODES], nodes);
+      break;
+   }
+   case GPU_PERCENT: Row_printPercentage(d->gpu ? d->gpu->percent : NAN, buffer, n, 5, &attr); break;
+   case GPU_MEMORY:
+      if (d->gpu) {
+         Row_printKBytes(str, d->gpu->memoryKB, coloring);
+         return;
+      }
+
+      attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, "   N/A ");
+      break;
+   case NV_SM_PERCENT: Row_printPercentage(NVML_deviceCount() ? d->nvml_smPercent : NAN, buffer, n, 5, &attr); break;
+   case NV_MEMORY:
+      if (NVML_deviceCount()) {
+         Row_printKBytes(str, d->nvml_memoryKB, coloring);
+         return;
+      }
+
+      attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, "   N/A ");
+      break;
+   case EST_POWER: {
+      const double watts = LinuxProcess_estimatedPower(this, lhost);
+      if (isnan(watts)) {
+         attr = CRT_colors[PROCESS_SHADOW];
+         xSnprintf(buffer, n, "    N/A ");
+         break;
+      }
+
+      if (watts < 0.05)
+         attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, watts < 1000.0 ? "%6.1fW " : "%6.0fW ", watts);
+      break;
+   }
+   case GPU_TIME:
+      if (d->gpu) {
+         Row_printTime(str, d->gpu->timeNs / 10000000ULL, coloring);
+         return;
+      }
+
+      attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, "       N/A ");
+      break;
+   case GPU_ENGINES: {
+      char engines[128];
+      GPUProcessData_formatEngines(d->gpu, engines, sizeof(engines));
+      xSnprintf(buffer, n, "%-*.*s ", Row_fieldWidths[GPU_ENGINES], Row_fieldWidths[GPU_ENGINES], engines);
+      break;
+   }
+   case FD_COUNT:
+      if (d->fdCountMs) {
+         xSnprintf(buffer, n, "%7lu ", d->fdCount);
+         LinuxProcess_staleAttr(lp, LINUX_COLLECTOR_FDS, &attr);
+      } else {
+         attr = CRT_colors[PROCESS_SHADOW];
+         xSnprintf(buffer, n, "    N/A ");
+      }
+      break;
+   case FD_RATE: {
+      const double rate = LinuxProcess_fdRate(d);
+      if (isnan(rate)) {
+         attr = CRT_colors[PROCESS_SHADOW];
+         xSnprintf(buffer, n, "   N/A ");
+         break;
+      }
+
+      /* growing, possibly leaking */
+      if (rate > 0.0)
+         attr |= A_BOLD;
+      xSnprintf(buffer, n, fabs(rate) < 1000.0 ? "%6.1f " : "%6.0f ", rate);
+      LinuxProcess_staleAttr(lp, LINUX_COLLECTOR_FDS, &attr);
+      break;
+   }
+   case FILE_LOCKS:
+      if (d->locksHeld == 0)
+         attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, "%5u ", d->locksHeld);
+      break;
+   case PERCENT_RUNQ_WAIT: Row_printPercentage(LinuxProcess_runqWaitPercent(d), buffer, n, 5, &attr); break;
+   case RUNQ_WAIT_AVG: {
+      const double ms = LinuxProcess_runqWaitAvgMs(d);
+      if (isnan(ms)) {
+         attr = CRT_colors[PROCESS_SHADOW];
+         xSnprintf(buffer, n, "    N/A ");
+         break;
+      }
+
+      if (ms < 0.001)
+         attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, ms < 1000.0 ? "%7.3f " : "%7.0f ", ms);
+      break;
+   }
+   case PERCENT_THROTTLED: Row_printPercentage(LinuxProcess_throttledPercent(lp), buffer, n, 5, &attr); break;
+   case PERCENT_CPU_QUOTA: Row_printPercentage(LinuxProcess_quotaCPUPercent(lp), buffer, n, 5, &attr); break;
+   case CGROUP_MEMORY_HEADROOM: Row_printBytes(str, LinuxProcess_cgroupMemoryHeadroom(lp), coloring); return;
+   case CGROUP_CPU_PRESSURE:
+   case CGROUP_MEMORY_PRESSURE:
+   case CGROUP_IO_PRESSURE: Row_printPercentage(LinuxProcess_cgroupPressure(lp, field), buffer, n, 7, &attr); break;
+   case MIGRATE_RATE: LinuxProcess_printEventRate(Rate_value(&d->migration_rate), buffer, n, 6, &attr); break;
+   case NVCSW_RATE: LinuxProcess_printEventRate(Rate_value(&d->nvcsw_rate), buffer, n, 7, &attr); break;
+   case MAJFLT_RATE: LinuxProcess_printEventRate(Rate_value(&d->majflt_rate), buffer, n, 6, &attr); break;
+   case MINFLT_RATE: LinuxProcess_printEventRate(Rate_value(&d->minflt_rate), buffer, n, 6, &attr); break;
+   case CGROUP_REFAULT_RATE: LinuxProcess_printEventRate(LinuxProcess_cgroupRefaultRate(lp), buffer, n, 7, &attr); break;
+   case CGROUP_SWAPIN_RATE: LinuxProcess_printEventRate(LinuxProcess_cgroupSwapinRate(lp), buffer, n, 7, &attr); break;
+   case THROTTLE_RATE: {
+      const double rate = LinuxProcess_throttleRate(lp);
+      if (isnan(rate)) {
+         attr = CRT_colors[PROCESS_SHADOW];
+         xSnprintf(buffer, n, "   N/A ");
+         break;
+      }
+
+      if (rate < 0.05)
+         attr = CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, rate < 1000.0 ? "%6.1f " : "%6.0f ", rate);
+      break;
+   }
    case CTXT:
       if (lp->ctxt_diff > 1000) {
          attr |= A_BOLD;
       }
       xSnprintf(buffer, n, "%5lu ", lp->ctxt_diff);
       break;
-   case SECATTR: snprintf(buffer, n, "%-*.*s ", Row_fieldWidths[SECATTR], Row_fieldWidths[SECATTR], lp->secattr ? lp->secattr : "N/A"); break;
+   case SECATTR: snprintf(buffer, n, "%-*.*s ", Row_fieldWidths[SECATTR], Row_fieldWidths[SECATTR], d->secattr ? d->secattr : "N/A"); break;
+   case WCHAN:
+      if (!d->wchan)
+         attr = CRT_colors[PROCESS_SHADOW];
+      snprintf(buffer, n, "%-*.*s ", Row_fieldWidths[WCHAN], Row_fieldWidths[WCHAN], d->wchan ? d->wchan : "-");
+      break;
    case AUTOGROUP_ID:
-      if (lp->autogroup_id != -1) {
-         xSnprintf(buffer, n, "%4ld ", lp->autogroup_id);
+      if (d->autogroup_id != -1) {
+         xSnprintf(buffer, n, "%4ld ", d->autogroup_id);
       } else {
          attr = CRT_colors[PROCESS_SHADOW];
          xSnprintf(buffer, n, " N/A ");
       }
       break;
    case AUTOGROUP_NICE:
-      if (lp->autogroup_id != -1) {
-         xSnprintf(buffer, n, "%3d ", lp->autogroup_nice);
-         attr = lp->autogroup_nice < 0 ? CRT_colors[PROCESS_HIGH_PRIORITY]
-            : lp->autogroup_nice > 0 ? CRT_colors[PROCESS_LOW_PRIORITY]
+      if (d->autogroup_id != -1) {
+         xSnprintf(buffer, n, "%3d ", d->autogroup_nice);
+         attr = d->autogroup_nice < 0 ? CRT_colors[PROCESS_HIGH_PRIORITY]
+            : d->autogroup_nice > 0 ? CRT_colors[PROCESS_LOW_PRIORITY]
             : CRT_colors[PROCESS_SHADOW];
       } else {
          attr = CRT_colors[PROCESS_SHADOW];
@@ -340,9 +756,18 @@ static void LinuxProcess_rowWriteField(const Row* super, RichString* str, Proces
    RichString_appendAscii(str, attr, buffer);
 }
 
+static int LinuxProcess_compareCGroup(const CGroupName* c1, const CGroupName* c2, ProcessField key) {
+   if (c1 == c2)
+      return 0;
+
+   return SPACESHIP_NULLSTR(LinuxProcess_cgroupString(c1, key), LinuxProcess_cgroupString(c2, key));
+}
+
 static int LinuxProcess_compareByKey(const Process* v1, const Process* v2, ProcessField key) {
    const LinuxProcess* p1 = (const LinuxProcess*)v1;
    const LinuxProcess* p2 = (const LinuxProcess*)v2;
+   const LinuxProcessDetails* d1 = LinuxProcess_getDetails(p1);
+   const LinuxProcessDetails* d2 = LinuxProcess_getDetails(p2);
 
    switch (key) {
    case M_DRS:
@@ -356,11 +781,15 @@ static int LinuxProcess_compareByKey(const Process* v1, const Process* v2, Proce
    case M_PRIV:
       return SPACESHIP_NUMBER(p1->m_priv, p2->m_priv);
    case M_PSS:
-      return SPACESHIP_NUMBER(p1->m_pss, p2->m_pss);
+      return SPACESHIP_NUMBER(d1->m_pss, d2->m_pss);
    case M_SWAP:
-      return SPACESHIP_NUMBER(p1->m_swap, p2->m_swap);
+      return SPACESHIP_NUMBER(d1->m_swap, d2->m_swap);
    case M_PSSWP:
-      return SPACESHIP_NUMBER(p1->m_psswp, p2->m_psswp);
+      return SPACESHIP_NUMBER(d1->m_psswp, d2->m_psswp);
+   case M_HUGETLB:
+      return SPACESHIP_NUMBER(d1->m_hugetlb, d2->m_hugetlb);
+   case PERCENT_THP:
+      return compareRealNumbers(LinuxProcess_thpPercent(p1), LinuxProcess_thpPercent(p2));
    case UTIME:
       return SPACESHIP_NUMBER(p1->utime, p2->utime);
    case CUTIME:
@@ -370,66 +799,439 @@ static int LinuxProcess_compareByKey(const Process* v1, const Process* v2, Proce
    case CSTIME:
       return SPACESHIP_NUMBER(p1->cstime, p2->cstime);
    case RCHAR:
-      return SPACESHIP_NUMBER(p1->io_rchar, p2->io_rchar);
+      return SPACESHIP_NUMBER(d1->io_rchar, d2->io_rchar);
    case WCHAR:
-      return SPACESHIP_NUMBER(p1->io_wchar, p2->io_wchar);
+      return SPACESHIP_NUMBER(d1->io_wchar, d2->io_wchar);
    case SYSCR:
-      return SPACESHIP_NUMBER(p1->io_syscr, p2->io_syscr);
+      return SPACESHIP_NUMBER(d1->io_syscr, d2->io_syscr);
    case SYSCW:
-      return SPACESHIP_NUMBER(p1->io_syscw, p2->io_syscw);
+      return SPACESHIP_NUMBER(d1->io_syscw, d2->io_syscw);
    case RBYTES:
-      return SPACESHIP_NUMBER(p1->io_read_bytes, p2->io_read_bytes);
+      return SPACESHIP_NUMBER(d1->io_read_bytes, d2->io_read_bytes);
    case WBYTES:
-      return SPACESHIP_NUMBER(p1->io_write_bytes, p2->io_write_bytes);
+      return SPACESHIP_NUMBER(d1->io_write_bytes, d2->io_write_bytes);
    case CNCLWB:
-      return SPACESHIP_NUMBER(p1->io_cancelled_write_bytes, p2->io_cancelled_write_bytes);
+      return SPACESHIP_NUMBER(d1->io_cancelled_write_bytes, d2->io_cancelled_write_bytes);
    case IO_READ_RATE:
-      return compareRealNumbers(p1->io_rate_read_bps, p2->io_rate_read_bps);
+      return compareRealNumbers(Rate_value(&d1->io_read_rate), Rate_value(&d2->io_read_rate));
    case IO_WRITE_RATE:
-      return compareRealNumbers(p1->io_rate_write_bps, p2->io_rate_write_bps);
+      return compareRealNumbers(Rate_value(&d1->io_write_rate), Rate_value(&d2->io_write_rate));
    case IO_RATE:
       return compareRealNumbers(LinuxProcess_totalIORate(p1), LinuxProcess_totalIORate(p2));
+   #ifdef HAVE_BPF_COLUMNS
+   case NET_RX:
+      return compareRealNumbers(Rate_value(&d1->net_rx_rate), Rate_value(&d2->net_rx_rate));
+   case NET_TX:
+      return compareRealNumbers(Rate_value(&d1->net_tx_rate), Rate_value(&d2->net_tx_rate));
+   case FUTEX_WAIT_PERCENT:
+      return compareRealNumbers(LinuxProcess_futexWaitPercent(d1), LinuxProcess_futexWaitPercent(d2));
+   case SYSCALL_RATE:
+      return compareRealNumbers(Rate_value(&d1->syscall_rate), Rate_value(&d2->syscall_rate));
+   case TOP_SYSCALL: {
+      int r = SPACESHIP_NULLSTR(LinuxProcess_topSyscallName(d1), LinuxProcess_topSyscallName(d2));
+      return r ? r : compareRealNumbers(d1->top_syscall_percent, d2->top_syscall_percent);
+   }
+   #endif
    #ifdef HAVE_OPENVZ
    case CTID:
-      return SPACESHIP_NULLSTR(p1->ctid, p2->ctid);
+      return SPACESHIP_NULLSTR(d1->ctid, d2->ctid);
    case VPID:
-      return SPACESHIP_NUMBER(p1->vpid, p2->vpid);
+      return SPACESHIP_NUMBER(d1->vpid, d2->vpid);
    #endif
    #ifdef HAVE_VSERVER
    case VXID:
-      return SPACESHIP_NUMBER(p1->vxid, p2->vxid);
+      return SPACESHIP_NUMBER(d1->vxid, d2->vxid);
    #endif
    case CGROUP:
-      return SPACESHIP_NULLSTR(p1->cgroup, p2->cgroup);
    case CCGROUP:
-      return SPACESHIP_NULLSTR(p1->cgroup_short, p2->cgroup_short);
    case CONTAINER:
-      return SPACESHIP_NULLSTR(p1->container_short, p2->container_short);
+      return LinuxProcess_compareCGroup(p1->cgroup, p2->cgroup, key);
    case OOM:
       return SPACESHIP_NUMBER(p1->oom, p2->oom);
    #ifdef HAVE_DELAYACCT
    case PERCENT_CPU_DELAY:
-      return compareRealNumbers(p1->cpu_delay_percent, p2->cpu_delay_percent);
+      return compareRealNumbers(d1->cpu_delay_percent, d2->cpu_delay_percent);
    case PERCENT_IO_DELAY:
-      return compareRealNumbers(p1->blkio_delay_percent, p2->blkio_delay_percent);
+      return compareRealNumbers(d1->blkio_delay_percent, d2->blkio_delay_percent);
    case PERCENT_SWAP_DELAY:
-      return compareRealNumbers(p1->swapin_delay_percent, p2->swapin_delay_percent);
+      return compareRealNumbers(d1->swapin_delay_percent, d2->swapin_delay_percent);
+   #endif
+   #ifdef HAVE_PERF_EVENTS
+   case PERF_IPC:
+      return compareRealNumbers(LinuxProcess_perfRates(d1)->ipc, LinuxProcess_perfRates(d2)->ipc);
+   case PERF_LLC_MISSES:
+      return compareRealNumbers(LinuxProcess_perfRates(d1)->llcMissRate, LinuxProcess_perfRates(d2)->llcMissRate);
+   case PERF_BRANCH_MISS:
+      return compareRealNumbers(LinuxProcess_perfRates(d1)->branchMissPercent, LinuxProcess_perfRates(d2)->branchMissPercent);
+   case PERF_STALLED:
+      return compareRealNumbers(LinuxProcess_perfRates(d1)->stalledPercent, LinuxProcess_perfRates(d2)->stalledPercent);
    #endif
+   case NUMA_REMOTE:
+      return compareRealNumbers(LinuxProcess_numaRemotePercent(p1), LinuxProcess_numaRemotePercent(p2));
+   case NUMA_NODES:
+      return SPACESHIP_NUMBER(LinuxProcess_numaTotalKB(p1), LinuxProcess_numaTotalKB(p2));
+   case GPU_PERCENT:
+      return compareRealNumbers(d1->gpu ? d1->gpu->percent : NAN, d2->gpu ? d2->gpu->percent : NAN);
+   case NV_SM_PERCENT:
+      return SPACESHIP_NUMBER(d1->nvml_smPercent, d2->nvml_smPercent);
+   case EST_POWER:
+      return compareRealNumbers(LinuxProcess_estimatedPower(v1, (const LinuxMachine*) v1->super.host), LinuxProcess_estimatedPower(v2, (const LinuxMachine*) v2->super.host));
+   case NV_MEMORY:
+      return SPACESHIP_NUMBER(d1->nvml_memoryKB, d2->nvml_memoryKB);
+   case GPU_MEMORY:
+      return SPACESHIP_NUMBER(d1->gpu ? d1->gpu->memoryKB : 0, d2->gpu ? d2->gpu->memoryKB : 0);
+   case GPU_TIME:
+      return SPACESHIP_NUMBER(d1->gpu ? d1->gpu->timeNs : 0, d2->gpu ? d2->gpu->timeNs : 0);
+   case GPU_ENGINES:
+      return compareRealNumbers(d1->gpu ? d1->gpu->percent : NAN, d2->gpu ? d2->gpu->percent : NAN);
+   case FD_COUNT:
+      return SPACESHIP_NUMBER(LinuxProcess_fdCount(d1), LinuxProcess_fdCount(d2));
+   case FD_RATE:
+      return compareRealNumbers(LinuxProcess_fdRate(d1), LinuxProcess_fdRate(d2));
+   case FILE_LOCKS:
+      return SPACESHIP_NUMBER(d1->locksHeld, d2->locksHeld);
+   case PERCENT_RUNQ_WAIT:
+      return compareRealNumbers(LinuxProcess_runqWaitPercent(d1), LinuxProcess_runqWaitPercent(d2));
+   case RUNQ_WAIT_AVG:
+      return compareRealNumbers(LinuxProcess_runqWaitAvgMs(d1), LinuxProcess_runqWaitAvgMs(d2));
+   case PERCENT_THROTTLED:
+      return compareRealNumbers(LinuxProcess_throttledPercent(p1), LinuxProcess_throttledPercent(p2));
+   case THROTTLE_RATE:
+      return compareRealNumbers(LinuxProcess_throttleRate(p1), LinuxProcess_throttleRate(p2));
+   case PERCENT_CPU_QUOTA:
+      return compareRealNumbers(LinuxProcess_quotaCPUPercent(p1), LinuxProcess_quotaCPUPercent(p2));
+   case CGROUP_MEMORY_HEADROOM:
+      return SPACESHIP_NUMBER(LinuxProcess_cgroupMemoryHeadroom(p1), LinuxProcess_cgroupMemoryHeadroom(p2));
+   case CGROUP_CPU_PRESSURE:
+   case CGROUP_MEMORY_PRESSURE:
+   case CGROUP_IO_PRESSURE:
+      return compareRealNumbers(LinuxProcess_cgroupPressure(p1, key), LinuxProcess_cgroupPressure(p2, key));
    case IO_PRIORITY:
       return SPACESHIP_NUMBER(LinuxProcess_effectiveIOPriority(p1), LinuxProcess_effectiveIOPriority(p2));
+   case MIGRATE_RATE:
+      return compareRealNumbers(Rate_value(&d1->migration_rate), Rate_value(&d2->migration_rate));
+   case NVCSW_RATE:
+      return compareRealNumbers(Rate_value(&d1->nvcsw_rate), Rate_value(&d2->nvcsw_rate));
+   case MAJFLT_RATE:
+      return compareRealNumbers(Rate_value(&d1->majflt_rate), Rate_value(&d2->majflt_rate));
+   case MINFLT_RATE:
+      return compareRealNumbers(Rate_value(&d1->minflt_rate), Rate_value(&d2->minflt_rate));
+   case CGROUP_REFAULT_RATE:
+      return compareRealNumbers(LinuxProcess_cgroupRefaultRate(p1), LinuxProcess_cgroupRefaultRate(p2));
+   case CGROUP_SWAPIN_RATE:
+      return compareRealNumbers(LinuxProcess_cgroupSwapinRate(p1), LinuxProcess_cgroupSwapinRate(p2));
    case CTXT:
       return SPACESHIP_NUMBER(p1->ctxt_diff, p2->ctxt_diff);
    case SECATTR:
-      return SPACESHIP_NULLSTR(p1->secattr, p2->secattr);
+      return SPACESHIP_NULLSTR(d1->secattr, d2->secattr);
+   case WCHAN:
+      return SPACESHIP_NULLSTR(d1->wchan, d2->wchan);
    case AUTOGROUP_ID:
-      return SPACESHIP_NUMBER(p1->autogroup_id, p2->autogroup_id);
+      return SPACESHIP_NUMBER(d1->autogroup_id, d2->autogroup_id);
    case AUTOGROUP_NICE:
-      return SPACESHIP_NUMBER(p1->autogroup_nice, p2->autogroup_nice);
+      return SPACESHIP_NUMBER(d1->autogroup_nice, d2->autogroup_nice);
    default:
       return Process_compareByKey_Base(v1, v2, key);
    }
 }
 
+static RowSortKeyKind LinuxProcess_sortKeyByKey(const Process* super, ProcessField key, uint64_t* value) {
+   const LinuxProcess* this = (const LinuxProcess*)super;
+   const LinuxProcessDetails* d = LinuxProcess_getDetails(this);
+
+   switch (key) {
+   case M_DRS:
+      *value = Row_sortKeyFromSigned(this->m_drs);
+      return ROW_SORTKEY_EXACT;
+   case M_LRS:
+      *value = Row_sortKeyFromSigned(this->m_lrs);
+      return ROW_SORTKEY_EXACT;
+   case M_TRS:
+      *value = Row_sortKeyFromSigned(this->m_trs);
+      return ROW_SORTKEY_EXACT;
+   case M_SHARE:
+      *value = Row_sortKeyFromSigned(this->m_share);
+      return ROW_SORTKEY_EXACT;
+   case M_PRIV:
+      *value = Row_sortKeyFromSigned(this->m_priv);
+      return ROW_SORTKEY_EXACT;
+   case M_PSS:
+      *value = Row_sortKeyFromSigned(d->m_pss);
+      return ROW_SORTKEY_EXACT;
+   case M_SWAP:
+      *value = Row_sortKeyFromSigned(d->m_swap);
+      return ROW_SORTKEY_EXACT;
+   case M_PSSWP:
+      *value = Row_sortKeyFromSigned(d->m_psswp);
+      return ROW_SORTKEY_EXACT;
+   case M_HUGETLB:
+      *value = Row_sortKeyFromSigned(d->m_hugetlb);
+      return ROW_SORTKEY_EXACT;
+   case PERCENT_THP:
+      *value = Row_sortKeyFromDouble(LinuxProcess_thpPercent(this));
+      return ROW_SORTKEY_EXACT;
+   case UTIME:
+      *value = this->utime;
+      return ROW_SORTKEY_EXACT;
+   case CUTIME:
+      *value = this->cutime;
+      return ROW_SORTKEY_EXACT;
+   case STIME:
+      *value = this->stime;
+      return ROW_SORTKEY_EXACT;
+   case CSTIME:
+      *value = this->cstime;
+      return ROW_SORTKEY_EXACT;
+   case RCHAR:
+      *value = d->io_rchar;
+      return ROW_SORTKEY_EXACT;
+   case WCHAR:
+      *value = d->io_wchar;
+      return ROW_SORTKEY_EXACT;
+   case SYSCR:
+      *value = d->io_syscr;
+      return ROW_SORTKEY_EXACT;
+   case SYSCW:
+      *value = d->io_syscw;
+      return ROW_SORTKEY_EXACT;
+   case RBYTES:
+      *value = d->io_read_bytes;
+      return ROW_SORTKEY_EXACT;
+   case WBYTES:
+      *value = d->io_write_bytes;
+      return ROW_SORTKEY_EXACT;
+   case CNCLWB:
+      *value = d->io_cancelled_write_bytes;
+      return ROW_SORTKEY_EXACT;
+   case IO_READ_RATE:
+      *value = Row_sortKeyFromDouble(Rate_value(&d->io_read_rate));
+      return ROW_SORTKEY_EXACT;
+   case IO_WRITE_RATE:
+      *value = Row_sortKeyFromDouble(Rate_value(&d->io_write_rate));
+      return ROW_SORTKEY_EXACT;
+   case IO_RATE:
+      *value = Row_sortKeyFromDouble(LinuxProcess_totalIORate(this));
+      return ROW_SORTKEY_EXACT;
+   #ifdef HAVE_BPF_COLUMNS
+   case NET_RX:
+      *value = Row_sortKeyFromDouble(Rate_value(&d->net_rx_rate));
+      return ROW_SORTKEY_EXACT;
+   case NET_TX:
+      *value = Row_sortKeyFromDouble(Rate_value(&d->net_tx_rate));
+      return ROW_SORTKEY_EXACT;
+   case FUTEX_WAIT_PERCENT:
+      *value = Row_sortKeyFromDouble(LinuxProcess_futexWaitPercent(d));
+      return ROW_SORTKEY_EXACT;
+   case SYSCALL_RATE:
+      *value = Row_sortKeyFromDouble(Rate_value(&d->syscall_rate));
+      return ROW_SORTKEY_EXACT;
+   case TOP_SYSCALL:
+      *value = Row_sortKeyFromString(LinuxProcess_topSyscallName(d));
+      return ROW_SORTKEY_PREFIX;
+   #endif
+   #ifdef HAVE_OPENVZ
+   case CTID:
+      *value = Row_sortKeyFromString(d->ctid);
+      return ROW_SORTKEY_PREFIX;
+   case VPID:
+      *value = Row_sortKeyFromSigned(d->vpid);
+      return ROW_SORTKEY_EXACT;
+   #endif
+   #ifdef HAVE_VSERVER
+   case VXID:
+      *value = d->vxid;
+      return ROW_SORTKEY_EXACT;
+   #endif
+   case CGROUP:
+   case CCGROUP:
+   case CONTAINER:
+      *value = StringRank_of(LinuxProcess_cgroupString(this->cgroup, key));
+      return ROW_SORTKEY_EXACT;
+   case OOM:
+      *value = this->oom;
+      return ROW_SORTKEY_EXACT;
+   #ifdef HAVE_DELAYACCT
+   case PERCENT_CPU_DELAY:
+      *value = Row_sortKeyFromDouble(d->cpu_delay_percent);
+      return ROW_SORTKEY_EXACT;
+   case PERCENT_IO_DELAY:
+      *value = Row_sortKeyFromDouble(d->blkio_delay_percent);
+      return ROW_SORTKEY_EXACT;
+   case PERCENT_SWAP_DELAY:
+      *value = Row_sortKeyFromDouble(d->swapin_delay_percent);
+      return ROW_SORTKEY_EXACT;
+   #endif
+   #ifdef HAVE_PERF_EVENTS
+   case PERF_IPC:
+      *value = Row_sortKeyFromDouble(LinuxProcess_perfRates(d)->ipc);
+      return ROW_SORTKEY_EXACT;
+   case PERF_LLC_MISSES:
+      *value = Row_sortKeyFromDouble(LinuxProcess_perfRates(d)->llcMissRate);
+      return ROW_SORTKEY_EXACT;
+   case PERF_BRANCH_MISS:
+      *value = Row_sortKeyFromDouble(LinuxProcess_perfRates(d)->branchMissPercent);
+      return ROW_SORTKEY_EXACT;
+   case PERF_STALLED:
+      *value = Row_sortKeyFromDouble(LinuxProcess_perfRates(d)->stalledPercent);
+      return ROW_SORTKEY_EXACT;
+   #endif
+   case NUMA_REMOTE:
+      *value = Row_sortKeyFromDouble(LinuxProcess_numaRemotePercent(this));
+      return ROW_SORTKEY_EXACT;
+   case NUMA_NODES:
+      *value = LinuxProcess_numaTotalKB(this);
+      return ROW_SORTKEY_EXACT;
+   case GPU_PERCENT:
+   case GPU_ENGINES:
+      *value = Row_sortKeyFromDouble(d->gpu ? d->gpu->percent : NAN);
+      return ROW_SORTKEY_EXACT;
+   case NV_SM_PERCENT:
+      *value = Row_sortKeyFromDouble(d->nvml_smPercent);
+      return ROW_SORTKEY_EXACT;
+   case EST_POWER:
+      *value = Row_sortKeyFromDouble(LinuxProcess_estimatedPower(super, (const LinuxMachine*) super->super.host));
+      return ROW_SORTKEY_EXACT;
+   case NV_MEMORY:
+      *value = d->nvml_memoryKB;
+      return ROW_SORTKEY_EXACT;
+   case GPU_MEMORY:
+      *value = d->gpu ? d->gpu->memoryKB : 0;
+      return ROW_SORTKEY_EXACT;
+   case GPU_TIME:
+      *value = d->gpu ? d->gpu->timeNs : 0;
+      return ROW_SORTKEY_EXACT;
+   case FD_COUNT:
+      *value = Row_sortKeyFromSigned(LinuxProcess_fdCount(d));
+      return ROW_SORTKEY_EXACT;
+   case FD_RATE:
+      *value = Row_sortKeyFromDouble(LinuxProcess_fdRate(d));
+      return ROW_SORTKEY_EXACT;
+   case FILE_LOCKS:
+      *value = d->locksHeld;
+      return ROW_SORTKEY_EXACT;
+   case PERCENT_RUNQ_WAIT:
+      *value = Row_sortKeyFromDouble(LinuxProcess_runqWaitPercent(d));
+      return ROW_SORTKEY_EXACT;
+   case RUNQ_WAIT_AVG:
+      *value = Row_sortKeyFromDouble(LinuxProcess_runqWaitAvgMs(d));
+      return ROW_SORTKEY_EXACT;
+   case PERCENT_THROTTLED:
+      *value = Row_sortKeyFromDouble(LinuxProcess_throttledPercent(this));
+      return ROW_SORTKEY_EXACT;
+   case THROTTLE_RATE:
+      *value = Row_sortKeyFromDouble(LinuxProcess_throttleRate(this));
+      return ROW_SORTKEY_EXACT;
+   case PERCENT_CPU_QUOTA:
+      *value = Row_sortKeyFromDouble(LinuxProcess_quotaCPUPercent(this));
+      return ROW_SORTKEY_EXACT;
+   case CGROUP_MEMORY_HEADROOM:
+      *value = LinuxProcess_cgroupMemoryHeadroom(this);
+      return ROW_SORTKEY_EXACT;
+   case CGROUP_CPU_PRESSURE:
+   case CGROUP_MEMORY_PRESSURE:
+   case CGROUP_IO_PRESSURE:
+      *value = Row_sortKeyFromDouble(LinuxProcess_cgroupPressure(this, key));
+      return ROW_SORTKEY_EXACT;
+   case IO_PRIORITY:
+      *value = Row_sortKeyFromSigned(LinuxProcess_effectiveIOPriority(this));
+      return ROW_SORTKEY_EXACT;
+   case MIGRATE_RATE:
+      *value = Row_sortKeyFromDouble(Rate_value(&d->migration_rate));
+      return ROW_SORTKEY_EXACT;
+   case NVCSW_RATE:
+      *value = Row_sortKeyFromDouble(Rate_value(&d->nvcsw_rate));
+      return ROW_SORTKEY_EXACT;
+   case MAJFLT_RATE:
+      *value = Row_sortKeyFromDouble(Rate_value(&d->majflt_rate));
+      return ROW_SORTKEY_EXACT;
+   case MINFLT_RATE:
+      *value = Row_sortKeyFromDouble(Rate_value(&d->minflt_rate));
+      return ROW_SORTKEY_EXACT;
+   case CGROUP_REFAULT_RATE:
+      *value = Row_sortKeyFromDouble(LinuxProcess_cgroupRefaultRate(this));
+      return ROW_SORTKEY_EXACT;
+   case CGROUP_SWAPIN_RATE:
+      *value = Row_sortKeyFromDouble(LinuxProcess_cgroupSwapinRate(this));
+      return ROW_SORTKEY_EXACT;
+   case CTXT:
+      *value = this->ctxt_diff;
+      return ROW_SORTKEY_EXACT;
+   case SECATTR:
+      *value = Row_sortKeyFromString(d->secattr);
+      return ROW_SORTKEY_PREFIX;
+   case WCHAN:
+      *value = Row_sortKeyFromString(d->wchan);
+      return ROW_SORTKEY_PREFIX;
+   case AUTOGROUP_ID:
+      *value = Row_sortKeyFromSigned(d->autogroup_id);
+      return ROW_SORTKEY_EXACT;
+   case AUTOGROUP_NICE:
+      *value = Row_sortKeyFromSigned(d->autogroup_nice);
+      return ROW_SORTKEY_EXACT;
+   default:
+      return Process_sortKeyByKey_Base(super, key, value);
+   }
+}
+
+int LinuxProcess_openPidfd(const Process* super) {
+#ifdef SYS_pidfd_open
+   const LinuxProcess* this = (const LinuxProcess*) super;
+
+   /* only the main thread has one, and the PIDs of another /proc may be of another namespace */
+   if (Process_isThread(super) || !FsRoot_isDefault(&FsRoot_proc) || Replay_isOpen())
+      return -1;
+
+   int fd = (int)syscall(SYS_pidfd_open, Process_getPid(super), 0);
+   if (fd < 0)
+      return -1;
+
+#ifdef HAVE_OPENAT
+   /* the directory read by the scan still being there tells the PID was not reused meanwhile */
+   if (this->procFd >= 0 && faccessat(this->procFd, "stat", F_OK, 0) != 0) {
+      close(fd);
+      return -1;
+   }
+#else
+   (void) this;
+#endif
+
+   return fd;
+#else
+   (void) super;
+   return -1;
+#endif
+}
+
+/* Through a pidfd or the directory in /proc if there is one, so that a reused PID is never hit */
+static bool LinuxProcess_sendSignal(const Process* super, int sgn) {
+#ifdef SYS_pidfd_send_signal
+   const LinuxProcess* this = (const LinuxProcess*) super;
+   int fd = this->pidfd;
+#ifdef HAVE_OPENAT
+   if (fd < 0 && !Process_isThread(super))
+      fd = this->procFd;
+#endif
+
+   if (fd >= 0) {
+      if (syscall(SYS_pidfd_send_signal, fd, sgn, NULL, 0) == 0)
+         return true;
+
+      /* an older kernel, or a directory of a /proc it does not take */
+      if (errno != ENOSYS && errno != EINVAL && errno != EBADF)
+         return false;
+   }
+#endif
+
+   return kill(Process_getPid(super), sgn) == 0;
+}
+
+/* The cgroup names are shared by their processes, which makes them an identifier for the scan */
+static void LinuxProcess_snapshotValues(const Process* super, float* ioRate, uint64_t* group) {
+   const LinuxProcess* this = (const LinuxProcess*) super;
+   *ioRate = (float)LinuxProcess_totalIORate(this);
+   *group = (uint64_t)(uintptr_t)this->cgroup;
+}
+
 const ProcessClass LinuxProcess_class = {
    .super = {
       .super = {
@@ -443,7 +1245,13 @@ const ProcessClass LinuxProcess_class = {
       .matchesFilter = Process_rowMatchesFilter,
       .compareByParent = Process_compareByParent,
       .sortKeyString = Process_rowGetSortKey,
+      .sortKey = Process_rowSortKey,
+      .sortKeyByField = Process_rowSortKeyByField,
       .writeField = LinuxProcess_rowWriteField
    },
-   .compareByKey = LinuxProcess_compareByKey
+   .compareByKey = LinuxProcess_compareByKey,
+   .sortKeyByKey = LinuxProcess_sortKeyByKey,
+   .sendSignal = LinuxProcess_sendSignal,
+   .openExitFd = LinuxProcess_openPidfd,
+   .snapshotValues = LinuxProcess_snapshotValues
 };
@@ -8,14 +8,22 @@ Released under the GNU GPLv2+, see the COPYING file
 in the source distribution for its full text.
 */
 
+#include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "Machine.h"
+#include "Macros.h"
 #include "Object.h"
 #include "Process.h"
+#include "Rate.h"
 #include "Row.h"
 
+#include "linux/BpfSyscalls.h"
+#include "linux/CGroupCache.h"
+#include "linux/GPU.h"
 #include "linux/IOPriority.h"
+#include "linux/PerfCounters.h"
 
 
 #define PROCESS_FLAG_LINUX_IOPRIO    0x00000100
@@ -27,29 +35,68 @@ in the source distribution for its full text.
 #define PROCESS_FLAG_LINUX_CTXT      0x00004000
 #define PROCESS_FLAG_LINUX_SECATTR   0x00008000
 #define PROCESS_FLAG_LINUX_LRS_FIX   0x00010000
+#define PROCESS_FLAG_LINUX_PRESSURE  0x00020000
 #define PROCESS_FLAG_LINUX_DELAYACCT 0x00040000
 #define PROCESS_FLAG_LINUX_AUTOGROUP 0x00080000
+#define PROCESS_FLAG_LINUX_PERF      0x00100000
+#define PROCESS_FLAG_LINUX_NUMA      0x00200000
+#define PROCESS_FLAG_LINUX_GPU       0x00400000
+#define PROCESS_FLAG_LINUX_FDS       0x00800000
+#define PROCESS_FLAG_LINUX_LOCKS     0x01000000
+#define PROCESS_FLAG_LINUX_SCHEDSTAT 0x02000000
+#define PROCESS_FLAG_LINUX_THROTTLE  0x04000000
+#define PROCESS_FLAG_LINUX_WCHAN     0x08000000
+#define PROCESS_FLAG_LINUX_BPF_NET   0x10000000
+#define PROCESS_FLAG_LINUX_MIGRATE   0x20000000
+#define PROCESS_FLAG_LINUX_NVML      0x40000000
+#define PROCESS_FLAG_LINUX_POWER     0x80000000
+#define PROCESS_FLAG_LINUX_FAULTS       UINT64_C(0x0000000100000000)
+#define PROCESS_FLAG_LINUX_MEMSTAT      UINT64_C(0x0000000200000000)
+#define PROCESS_FLAG_LINUX_LIMITS       UINT64_C(0x0000000400000000)
+#define PROCESS_FLAG_LINUX_THP          UINT64_C(0x0000000800000000)
+#define PROCESS_FLAG_LINUX_BPF_FUTEX    UINT64_C(0x0000001000000000)
+#define PROCESS_FLAG_LINUX_BPF_SYSCALLS UINT64_C(0x0000002000000000)
 
-typedef struct LinuxProcess_ {
-   Process super;
-   IOPriority ioPriority;
-   unsigned long int cminflt;
-   unsigned long int cmajflt;
-   unsigned long long int utime;
-   unsigned long long int stime;
-   unsigned long long int cutime;
-   unsigned long long int cstime;
-   long m_share;
-   long m_priv;
+/* Expensive per-process reads scheduled with a per-scan budget */
+typedef enum LinuxCollector_ {
+   LINUX_COLLECTOR_SMAPS,
+   LINUX_COLLECTOR_MAPS,
+   LINUX_COLLECTOR_CGROUP,
+   LINUX_COLLECTOR_DELAYACCT,
+   LINUX_COLLECTOR_NUMA,
+   LINUX_COLLECTOR_GPU,
+   LINUX_COLLECTOR_FDS,
+   LINUX_COLLECTOR_IDLE,       /* the files besides stat of processes that did not run */
+   LINUX_COLLECTOR_COUNT
+} LinuxCollector;
+
+/* Values not refreshed for this long are shown dimmed */
+#define LINUX_COLLECTOR_STALE_MS 10000
+
+/* Files of /proc/<pid> whose reads were refused, in LinuxProcess.denied */
+#define LINUX_DENIED_IO        0x01
+#define LINUX_DENIED_MAPS      0x02
+#define LINUX_DENIED_SMAPS     0x04
+#define LINUX_DENIED_NUMA_MAPS 0x08
+#define LINUX_DENIED_FDS       0x10
+#define LINUX_DENIED_EXE       0x20
+#define LINUX_DENIED_CWD       0x40
+
+/*
+ * Values only read for optional columns, kept out of LinuxProcess so that
+ * the rows the scan, sort and tree walk through stay small. Allocated by
+ * LinuxProcess_details() when a collector first stores one of them.
+ */
+typedef struct LinuxProcessDetails_ {
    long m_pss;
    long m_swap;
    long m_psswp;
-   long m_trs;
-   long m_drs;
-   long m_lrs;
-
-   /* Process flags */
-   unsigned long int flags;
+   /* Resident memory mapped by transparent huge pages (anonymous, shmem and file PMDs), in kB */
+   long m_thp;
+   /* Share of the resident memory in transparent huge pages, NAN without any resident */
+   float thp_percent;
+   /* hugetlbfs pages mapped, shared and private, in kB; not part of the resident memory */
+   long m_hugetlb;
 
    /* Data read (in bytes) */
    unsigned long long io_rchar;
@@ -72,14 +119,9 @@ typedef struct LinuxProcess_ {
    /* Storage data cancelled (in bytes) */
    unsigned long long io_cancelled_write_bytes;
 
-   /* Point in time of last io scan (in milliseconds elapsed since the Epoch) */
-   unsigned long long io_last_scan_time_ms;
-
-   /* Storage data read (in bytes per second) */
-   double io_rate_read_bps;
-
-   /* Storage data written (in bytes per second) */
-   double io_rate_write_bps;
+   /* Storage data read and written (in bytes per second) */
+   Rate io_read_rate;
+   Rate io_write_rate;
 
    #ifdef HAVE_OPENVZ
    char* ctid;
@@ -88,29 +130,202 @@ typedef struct LinuxProcess_ {
    #ifdef HAVE_VSERVER
    unsigned int vxid;
    #endif
-   char* cgroup;
-   char* cgroup_short;
-   char* container_short;
-   unsigned int oom;
+   /* Nanoseconds waited on a run queue and timeslices run, per second (from schedstat) */
+   Rate runq_wait_rate;
+   Rate runq_slice_rate;
    #ifdef HAVE_DELAYACCT
-   unsigned long long int delay_read_time;
-   unsigned long long cpu_delay_total;
-   unsigned long long blkio_delay_total;
-   unsigned long long swapin_delay_total;
+   Rate cpu_delay_rate;
+   Rate blkio_delay_rate;
+   Rate swapin_delay_rate;
    float cpu_delay_percent;
    float blkio_delay_percent;
    float swapin_delay_percent;
    #endif
-   unsigned long ctxt_total;
-   unsigned long ctxt_diff;
+   #ifdef HAVE_PERF_EVENTS
+   /* Hardware counters of the task, only kept open while its row is on screen */
+   PerfCounters* perf;
+   PerfCounterRates perfRates;
+   /* Opening the counters was refused, they are not tried again */
+   bool perfDenied;
+   #endif
    char* secattr;
-   unsigned long long int last_mlrs_calctime;
+   /* Kernel function the task sleeps in (from wchan), NULL while it runs */
+   char* wchan;
+
+   /* Resident memory (in kB) on each NUMA node, one entry per node of the LinuxMachine */
+   unsigned long long* numaKB;
+
+   /* NULL unless DRM clients were found among the fds of the process */
+   GPUProcessData* gpu;
+
+   /* Open fds when last counted, at fdCountMs (0 if never) */
+   unsigned long fdCount;
+   uint64_t fdCountMs;
+   /* Change of fdCount per second between its last two counts, NAN after the first */
+   double fdRate;
+
+   /* File locks held, as listed by /proc/locks */
+   unsigned int locksHeld;
+
+   /* Changes of the CPU the task was last seen on (from stat) between scans, per second */
+   unsigned long long migrations;
+   int lastProcessor;
+   Rate migration_rate;
+
+   /* Involuntary context switches per second (from status) */
+   Rate nvcsw_rate;
+
+   /* Major and minor page faults per second (from stat) */
+   Rate majflt_rate;
+   Rate minflt_rate;
+
+   /* Usage of NVIDIA GPUs (from NVML), only stored for processes seen using one */
+   unsigned long long nvml_memoryKB;
+   float nvml_smPercent;
+
+   #ifdef HAVE_BPF_COLUMNS
+   /* Bytes per second received and sent over sockets by the thread group (from the pinned BPF map) */
+   Rate net_rx_rate;
+   Rate net_tx_rate;
+   /* Nanoseconds per second the threads of the thread group waited in futex(2) (from the pinned BPF map) */
+   Rate futex_wait_rate;
+   /* System calls per second of the thread group (from the pinned BPF map) */
+   Rate syscall_rate;
+   /* The most frequent one since the last read, and its share of them in percent, 0 if unknown */
+   uint32_t top_syscall;
+   float top_syscall_percent;
+   BpfSyscallsCounts syscall_counts;   /* of the last read, to tell the calls in between */
+   #endif
 
    /* Autogroup scheduling (CFS) information */
    long int autogroup_id;
    int autogroup_nice;
+} LinuxProcessDetails;
+
+typedef struct LinuxProcess_ {
+   Process super;
+   IOPriority ioPriority;
+   unsigned long int cminflt;
+   unsigned long int cmajflt;
+   unsigned long long int utime;
+   unsigned long long int stime;
+   unsigned long long int cutime;
+   unsigned long long int cstime;
+   long m_share;
+   long m_priv;
+   long m_trs;
+   long m_drs;
+   long m_lrs;
+   long m_stat_rss;           /* resident pages as counted by stat, apart from statm */
+
+   /* Nanoseconds the task ran as of the monotonic time runtimeAtNs, from schedstat; 0 if not read */
+   unsigned long long int runtimeNs;
+   uint64_t runtimeAtNs;
+
+   /* Process flags */
+   unsigned long int flags;
+
+   CGroupName* cgroup;        /* shared with all processes in the same cgroup */
+   unsigned int oom;
+   unsigned long ctxt_total;
+   unsigned long ctxt_diff;
+   unsigned long nvcsw_total;
+
+   /* NULL until an optional collector stores a value, read through LinuxProcess_getDetails() */
+   LinuxProcessDetails* details;
+
+   /* Monotonic time of the last read of each expensive collector, 0 if never */
+   uint64_t collectedMs[LINUX_COLLECTOR_COUNT];
+
+   /* LINUX_DENIED_* files not read again while the process is owned by deniedUid and runs the same program */
+   uint8_t denied;
+   uid_t deniedUid;
+
+   #ifdef HAVE_PROC_CONNECTOR
+   /* Set by exec and comm events: the command line needs to be read again */
+   bool execEvent;
+   /* Set by the exit event, the task is gone or a zombie */
+   bool exitEvent;
+   #endif
+
+   #ifdef HAVE_OPENAT
+   /* Directory fd of /proc/<pid> (or task/<tid>) kept open across scans, -1 if none */
+   int procFd;
+   #endif
+
+   /* pidfd held while the process is tagged or followed, -1 if none */
+   int pidfd;
 } LinuxProcess;
 
+/* All zero, what a process without details reads */
+extern const LinuxProcessDetails LinuxProcess_noDetails;
+
+static inline const LinuxProcessDetails* LinuxProcess_getDetails(const LinuxProcess* this) {
+   return this->details ? this->details : &LinuxProcess_noDetails;
+}
+
+/* Share of the time the task waited on a run queue, NAN until schedstat was read twice */
+static inline float LinuxProcess_runqWaitPercent(const LinuxProcessDetails* d) {
+   const double percent = Rate_value(&d->runq_wait_rate) / 1e7;
+   return isnan(percent) ? NAN : (float)MINIMUM(percent, 100.0);
+}
+
+/* Milliseconds waited on a run queue per timeslice the task ran */
+static inline double LinuxProcess_runqWaitAvgMs(const LinuxProcessDetails* d) {
+   const double waitNs = Rate_value(&d->runq_wait_rate);
+   const double slices = Rate_value(&d->runq_slice_rate);
+   if (isnan(waitNs) || isnan(slices))
+      return NAN;
+
+   return slices > 0.0 ? waitNs / slices / 1e6 : 0.0;
+}
+
+/* Share of the time the cgroup of the process was throttled, NAN while unknown */
+static inline float LinuxProcess_throttledPercent(const LinuxProcess* this) {
+   return this->cgroup ? CGroupThrottle_percent(&this->cgroup->throttle) : NAN;
+}
+
+/* Periods the cgroup of the process was throttled in, per second */
+static inline double LinuxProcess_throttleRate(const LinuxProcess* this) {
+   return this->cgroup ? CGroupThrottle_periodRate(&this->cgroup->throttle) : NAN;
+}
+
+/* The avg10 of one of the pressure files of the cgroup of the process, NAN while unknown */
+static inline float LinuxProcess_cgroupPressure(const LinuxProcess* this, ProcessField field) {
+   if (!this->cgroup || !this->cgroup->pressure.readMs)
+      return NAN;
+
+   const CGroupPressure* pressure = &this->cgroup->pressure;
+   return field == CGROUP_CPU_PRESSURE ? pressure->cpu : field == CGROUP_MEMORY_PRESSURE ? pressure->memory : pressure->io;
+}
+
+/* Pages per second the cgroup of the process faulted back in after evicting them, NAN while unknown */
+static inline double LinuxProcess_cgroupRefaultRate(const LinuxProcess* this) {
+   return this->cgroup ? Rate_value(&this->cgroup->memoryStat.refaults) : NAN;
+}
+
+/* Pages per second the cgroup of the process read from swap, NAN while unknown */
+static inline double LinuxProcess_cgroupSwapinRate(const LinuxProcess* this) {
+   return this->cgroup ? Rate_value(&this->cgroup->memoryStat.swapins) : NAN;
+}
+
+/* CPU% of the process in percent of the cpu.max quota of its cgroup, NAN without one */
+static inline float LinuxProcess_quotaCPUPercent(const LinuxProcess* this) {
+   if (!this->cgroup || !this->cgroup->limits.readMs)
+      return NAN;
+   return CGroupLimits_quotaPercent(this->cgroup->limits.cpuQuota, this->super.percent_cpu);
+}
+
+/* Bytes the cgroup of the process can grow by before reaching its memory.max, ULLONG_MAX without a limit */
+static inline unsigned long long LinuxProcess_cgroupMemoryHeadroom(const LinuxProcess* this) {
+   if (!this->cgroup || !this->cgroup->limits.readMs)
+      return ULLONG_MAX;
+   return this->cgroup->limits.memoryHeadroom;
+}
+
+/* The details of the process to store into, allocating them on first use */
+LinuxProcessDetails* LinuxProcess_details(LinuxProcess* this);
+
 extern int pageSize;
 
 extern int pageSizeKB;
@@ -123,6 +338,9 @@ Process* LinuxProcess_new(const Machine* host);
 
 void Process_delete(Object* cast);
 
+/* A new pidfd of the process, -1 if it exited or has none (threads, other PID namespaces) */
+int LinuxProcess_openPidfd(const Process* super);
+
 IOPriority LinuxProcess_updateIOPriority(Process* proc);
 
 bool LinuxProcess_rowSetIOPriority(Row* super, Arg ioprio);
@@ -133,4 +351,7 @@ bool LinuxProcess_rowChangeAutogroupPriorityBy(Row* super, Arg delta);
 
 bool Process_isThread(const Process* this);
 
+/* Writes the resident memory per NUMA node, e.g. "N0:1.21G N1:310M", returns the length */
+int LinuxProcess_formatNumaNodes(const LinuxProcess* this, char* buffer, size_t size);
+
 #endif
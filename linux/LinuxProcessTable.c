@@ -7,20 +7,27 @@ in the source distribution for its full text.
 
 #include "config.h" // IWYU pragma: keep
 
+#define HEAP_CLASS HEAP_PROCESSES
+
 #include "linux/LinuxProcessTable.h"
 
 #include <assert.h>
 #include <ctype.h>
 #include <dirent.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <limits.h>
 #include <math.h>
+#include <poll.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/select.h>
 #include <sys/stat.h>
 
 #ifdef HAVE_DELAYACCT
@@ -35,22 +42,44 @@ in the source distribution for its full text.
 #include <netlink/genl/ctrl.h>
 #endif
 
+#include "Budget.h"
 #include "Compat.h"
 #include "Hashtable.h"
 #include "Machine.h"
 #include "Macros.h"
 #include "Object.h"
 #include "Process.h"
+#include "Profile.h"
+#include "Replay.h"
 #include "Row.h"
 #include "RowField.h"
 #include "Scheduling.h"
 #include "Settings.h"
 #include "Table.h"
 #include "UsersTable.h"
+#include "Vector.h"
 #include "XUtils.h"
-#include "linux/CGroupUtils.h"
+#include "linux/Bpf.h"
+#include "linux/BpfFutex.h"
+#include "linux/BpfNet.h"
+#include "linux/BpfSyscalls.h"
+#include "linux/BpfTaskIter.h"
+#include "linux/CGroupCache.h"
+#include "linux/CGroupScope.h"
+#include "linux/CGroupTable.h"
+#include "linux/ContainerNames.h"
+#include "linux/CPUOccupancyTable.h"
+#include "linux/ExitedTaskTable.h"
+#include "linux/ExitedTasks.h"
+#include "linux/GuestTable.h"
+#include "linux/FsRoot.h"
 #include "linux/LinuxMachine.h"
 #include "linux/LinuxProcess.h"
+#include "linux/LockIndex.h"
+#include "linux/NVML.h"
+#include "linux/ProcConnector.h"
+#include "linux/ProcessChurn.h"
+#include "linux/SharedScan.h"
 #include "linux/Platform.h" // needed for GNU/hurd to get PATH_MAX  // IWYU pragma: keep
 
 #if defined(MAJOR_IN_MKDEV)
@@ -78,48 +107,6 @@ static FILE* fopenat(openat_arg_t openatArg, const char* pathname, const char* m
    return stream;
 }
 
-static inline uint64_t fast_strtoull_dec(char** str, int maxlen) {
-   register uint64_t result = 0;
-
-   if (!maxlen)
-      --maxlen;
-
-   while (maxlen-- && **str >= '0' && **str <= '9') {
-      result *= 10;
-      result += **str - '0';
-      (*str)++;
-   }
-
-   return result;
-}
-
-static inline uint64_t fast_strtoull_hex(char** str, int maxlen) {
-   register uint64_t result = 0;
-   register int nibble, letter;
-   const long valid_mask = 0x03FF007E;
-
-   if (!maxlen)
-      --maxlen;
-
-   while (maxlen--) {
-      nibble = (unsigned char)**str;
-      if (!(valid_mask & (1 << (nibble & 0x1F))))
-         break;
-      if ((nibble < '0') || (nibble & ~0x20) > 'F')
-         break;
-      letter = (nibble & 0x40) ? 'A' - '9' - 1 : 0;
-      nibble &=~0x20; // to upper
-      nibble ^= 0x10; // switch letters and digits
-      nibble -= letter;
-      nibble &= 0x0f;
-      result <<= 4;
-      result += (uint64_t)nibble;
-      (*str)++;
-   }
-
-   return result;
-}
-
 static int sortTtyDrivers(const void* va, const void* vb) {
    const TtyDriver* a = (const TtyDriver*) va;
    const TtyDriver* b = (const TtyDriver*) vb;
@@ -135,7 +122,7 @@ static void LinuxProcessTable_initTtyDrivers(LinuxProcessTable* this) {
    TtyDriver* ttyDrivers;
 
    char buf[16384];
-   ssize_t r = xReadfile(PROCTTYDRIVERSFILE, buf, sizeof(buf));
+   ssize_t r = FsRoot_readFile(&FsRoot_proc, PROCTTYDRIVERSFILE, buf, sizeof(buf));
    if (r < 0)
       return;
 
@@ -185,6 +172,15 @@ static void LinuxProcessTable_initTtyDrivers(LinuxProcessTable* this) {
    this->ttyDrivers = ttyDrivers;
 }
 
+/* Read once the first process with a terminal turns up, not at startup */
+static TtyDriver* LinuxProcessTable_getTtyDrivers(LinuxProcessTable* this) {
+   if (!this->ttyDriversRead) {
+      this->ttyDriversRead = true;
+      LinuxProcessTable_initTtyDrivers(this);
+   }
+   return this->ttyDrivers;
+}
+
 #ifdef HAVE_DELAYACCT
 
 static void LinuxProcessTable_initNetlinkSocket(LinuxProcessTable* this) {
@@ -196,10 +192,129 @@ static void LinuxProcessTable_initNetlinkSocket(LinuxProcessTable* this) {
       return;
    }
    this->netlink_family = genl_ctrl_resolve(this->netlink_socket, TASKSTATS_GENL_NAME);
+
+   /* Requests are sent in windows and their replies read afterwards, in any
+      order: no acks, no sequence check and no waiting once all are read */
+   nl_socket_disable_seq_check(this->netlink_socket);
+   nl_socket_disable_auto_ack(this->netlink_socket);
+   nl_socket_set_nonblocking(this->netlink_socket);
 }
 
 #endif
 
+#ifdef HAVE_OPENAT
+
+/* Number of fds left for everything else when sizing the directory fd cache */
+#define PROC_FD_RESERVE 256
+
+static void LinuxProcessTable_initProcFdCache(LinuxProcessTable* this) {
+   this->procFdLimit = 0;
+   this->procFdMin = 0;
+   this->procFdCount = 0;
+
+   /* the children started, like lsof or strace, get the limit back */
+   rlim_t limit = MINIMUM(raiseFileLimit((rlim_t)1 << 20), (rlim_t)1 << 20);
+   if (!limit)
+      return;
+
+   if (limit > FD_SETSIZE + PROC_FD_RESERVE) {
+      /* Keep the low fds free, so e.g. TraceScreen can still select(2) on its pipe */
+      this->procFdMin = FD_SETSIZE;
+      this->procFdLimit = limit - FD_SETSIZE - PROC_FD_RESERVE;
+   } else {
+      this->procFdLimit = limit / 2;
+   }
+}
+
+static void LinuxProcessTable_dropProcFd(LinuxProcessTable* this, LinuxProcess* lp) {
+   if (lp->procFd >= 0) {
+      close(lp->procFd);
+      lp->procFd = -1;
+      this->procFdCount--;
+   }
+}
+
+/* The fds of the rows removed since the last scan were closed along with them */
+static void LinuxProcessTable_countProcFds(LinuxProcessTable* this) {
+   const Vector* rows = this->super.super.rows;
+   this->procFdCount = 0;
+   for (int i = 0; i < Vector_size(rows); i++) {
+      const LinuxProcess* lp = (const LinuxProcess*) Vector_get(rows, i);
+      if (lp->procFd >= 0)
+         this->procFdCount++;
+   }
+}
+
+/* Called when running out of fds: close all cached fds and cache fewer from now on */
+static void LinuxProcessTable_flushProcFds(LinuxProcessTable* this) {
+   this->procFdLimit = this->procFdCount / 2;
+
+   const Vector* rows = this->super.super.rows;
+   for (int i = 0; i < Vector_size(rows); i++) {
+      LinuxProcess* lp = (LinuxProcess*) Vector_get(rows, i);
+      LinuxProcessTable_dropProcFd(this, lp);
+   }
+}
+
+/*
+ * Returns an fd for the directory `name` in `dirFd` of the given process,
+ * re-using the one cached from an earlier scan. Every process holds at most
+ * one cached fd, and no more are cached than procFdLimit.
+ */
+static int LinuxProcessTable_getProcFd(LinuxProcessTable* this, LinuxProcess* lp, int dirFd, const char* name) {
+   if (lp->procFd >= 0)
+      return lp->procFd;
+
+   int fd = openat(dirFd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+   if (fd < 0 && (errno == EMFILE || errno == ENFILE)) {
+      LinuxProcessTable_flushProcFds(this);
+      fd = openat(dirFd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+   }
+   if (fd < 0)
+      return -1;
+
+   if (this->procFdCount >= this->procFdLimit)
+      return fd;
+
+   if (fd < this->procFdMin) {
+      int highFd = fcntl(fd, F_DUPFD_CLOEXEC, this->procFdMin);
+      if (highFd < 0)
+         return fd;
+
+      close(fd);
+      fd = highFd;
+   }
+
+   lp->procFd = fd;
+   this->procFdCount++;
+   return fd;
+}
+
+static void LinuxProcessTable_putProcFd(const LinuxProcess* lp, int procFd) {
+   if (procFd != lp->procFd)
+      close(procFd);
+}
+
+#else
+
+static void LinuxProcessTable_putProcFd(ATTR_UNUSED const LinuxProcess* lp, ATTR_UNUSED openat_arg_t procFd) {
+   /* nothing to release for paths */
+}
+
+#endif /* HAVE_OPENAT */
+
+/* Profile phases timing the reads of each LinuxCollector */
+static const char* const LinuxProcessTable_collectorNames[LINUX_COLLECTOR_COUNT] = {
+   [LINUX_COLLECTOR_SMAPS]     = "smaps read",
+   [LINUX_COLLECTOR_MAPS]      = "maps read",
+   [LINUX_COLLECTOR_CGROUP]    = "cgroup read",
+   [LINUX_COLLECTOR_DELAYACCT] = "delayacct read",
+   [LINUX_COLLECTOR_NUMA]      = "numa_maps read",
+   [LINUX_COLLECTOR_GPU]       = "DRM client discovery",
+   [LINUX_COLLECTOR_FDS]       = "fd count",
+   [LINUX_COLLECTOR_IDLE]      = "idle refresh",
+};
+
 ProcessTable* ProcessTable_new(Machine* host, Hashtable* pidMatchList) {
    LinuxProcessTable* this = xCalloc(1, sizeof(LinuxProcessTable));
    Object_setClass(this, Class(ProcessTable));
@@ -207,10 +322,31 @@ ProcessTable* ProcessTable_new(Machine* host, Hashtable* pidMatchList) {
    ProcessTable* super = &this->super;
    ProcessTable_init(super, Class(LinuxProcess), host, pidMatchList);
 
-   LinuxProcessTable_initTtyDrivers(this);
-
    // Test /proc/PID/smaps_rollup availability (faster to parse, Linux 4.14+)
-   this->haveSmapsRollup = (access(PROCDIR "/self/smaps_rollup", R_OK) == 0);
+   this->haveSmapsRollup = FsRoot_access(&FsRoot_proc, "self/smaps_rollup", R_OK);
+
+   this->cgroupCache = CGroupCache_new();
+   this->cgroupRoot = CGroupTable_findRoot();
+   this->libraryCache = LibraryCache_new();
+
+   for (size_t i = 0; i < LINUX_COLLECTOR_COUNT; i++)
+      this->collectorPhase[i] = Profile_addPhase(LinuxProcessTable_collectorNames[i]);
+
+   // cleared on the first PROCMAP_QUERY failing with ENOTTY
+   this->haveProcmapQuery = true;
+
+#ifdef HAVE_OPENAT
+   LinuxProcessTable_initProcFdCache(this);
+#endif
+
+#ifdef HAVE_PROC_CONNECTOR
+   this->procConnectorFd = -1;
+   this->forkedIndex = Hashtable_new(64, false);
+#endif
+
+#ifdef HAVE_PTHREAD
+   this->scanDirFd = -1;
+#endif
 
    return super;
 }
@@ -218,6 +354,9 @@ ProcessTable* ProcessTable_new(Machine* host, Hashtable* pidMatchList) {
 void ProcessTable_delete(Object* cast) {
    LinuxProcessTable* this = (LinuxProcessTable*) cast;
    ProcessTable_done(&this->super);
+   /* after the processes holding references into it */
+   CGroupCache_delete(this->cgroupCache);
+   LibraryCache_delete(this->libraryCache);
    if (this->ttyDrivers) {
       for (int i = 0; this->ttyDrivers[i].path; i++) {
          free(this->ttyDrivers[i].path);
@@ -230,6 +369,25 @@ void ProcessTable_delete(Object* cast) {
       nl_socket_free(this->netlink_socket);
    }
    #endif
+   ProcDirList_done(&this->procList);
+   ProcDirList_done(&this->taskList);
+   SharedScan_done();
+   #ifdef HAVE_PROC_CONNECTOR
+   ProcConnector_close(this->procConnectorFd);
+   free(this->forked);
+   Hashtable_delete(this->forkedIndex);
+   #endif
+   #ifdef HAVE_BPF_ITER
+   BpfTaskIter_done(&this->bpfTasks);
+   #endif
+   #ifdef HAVE_PTHREAD
+   ProcScanPool_delete(this->scanPool);
+   if (this->scanDirFd >= 0)
+      close(this->scanDirFd);
+   free(this->scanTasks);
+   #endif
+   UserTotalsList_done(&this->userTotals);
+   WaitChannelList_done(&this->waitChannels);
    free(this);
 }
 
@@ -253,18 +411,9 @@ static inline ProcessState LinuxProcessTable_getProcessState(char state) {
    }
 }
 
-static bool LinuxProcessTable_readStatFile(LinuxProcess* lp, openat_arg_t procFd, const LinuxMachine* lhost, bool scanMainThread, char* command, size_t commLen) {
+static bool LinuxProcessTable_parseStatFile(LinuxProcess* lp, char* buf, const LinuxMachine* lhost, char* command, size_t commLen) {
    Process* process = &lp->super;
 
-   char buf[MAX_READ + 1];
-   char path[22] = "stat";
-   if (scanMainThread) {
-      xSnprintf(path, sizeof(path), "task/%"PRIi32"/stat", (int32_t)Process_getPid(process));
-   }
-   ssize_t r = xReadfileat(procFd, path, buf, sizeof(buf));
-   if (r < 0)
-      return false;
-
    /* (1) pid   -  %d */
    assert(Process_getPid(process) == atoi(buf));
    char* location = strchr(buf, ' ');
@@ -364,8 +513,15 @@ static bool LinuxProcessTable_readStatFile(LinuxProcess* lp, openat_arg_t procFd
    }
    location += 1;
 
-   /* Skip (23) - (38) */
-   for (int i = 0; i < 16; i++) {
+   /* Skip (23) vsize */
+   location = strchr(location, ' ') + 1;
+
+   /* (24) rss  -  %ld */
+   lp->m_stat_rss = strtol(location, &location, 10);
+   location += 1;
+
+   /* Skip (25) - (38) */
+   for (int i = 0; i < 14; i++) {
       location = strchr(location, ' ') + 1;
    }
 
@@ -381,86 +537,178 @@ static bool LinuxProcessTable_readStatFile(LinuxProcess* lp, openat_arg_t procFd
    return true;
 }
 
-static bool LinuxProcessTable_readStatusFile(Process* process, openat_arg_t procFd) {
-   LinuxProcess* lp = (LinuxProcess*) process;
-
-   unsigned long ctxt = 0;
-#ifdef HAVE_VSERVER
-   lp->vxid = 0;
-#endif
-
-   FILE* statusfile = fopenat(procFd, "status", "r");
-   if (!statusfile)
+static bool LinuxProcessTable_readStatFile(LinuxProcess* lp, openat_arg_t procFd, const LinuxMachine* lhost, bool scanMainThread, char* command, size_t commLen) {
+   char buf[PROC_PID_STAT_BUFSIZE];
+   char path[22] = "stat";
+   if (scanMainThread) {
+      xSnprintf(path, sizeof(path), "task/%"PRIi32"/stat", (int32_t)Process_getPid(&lp->super));
+   }
+   ssize_t r = xReadfileat(procFd, path, buf, sizeof(buf));
+   if (r < 0)
       return false;
 
-   char buffer[PROC_LINE_LENGTH + 1];
+   return LinuxProcessTable_parseStatFile(lp, buf, lhost, command, commLen);
+}
 
-   while (fgets(buffer, sizeof(buffer), statusfile)) {
+/* Values from /proc/<pid>/status needed by later collectors */
+typedef struct LinuxProcessStatus_ {
+   bool valid;
+#ifdef HAVE_OPENVZ
+   char envID[32];        /* empty if not present */
+   bool foundVPid;
+   pid_t vpid;
+#endif
+} LinuxProcessStatus;
+
+typedef enum LinuxStatusKey_ {
+   STATUS_KEY_UNKNOWN,
+   STATUS_KEY_NSPID,
+   STATUS_KEY_CAPPRM,
+   STATUS_KEY_VOLUNTARY_CTXT,
+   STATUS_KEY_NONVOLUNTARY_CTXT,
+   STATUS_KEY_VXID,
+   STATUS_KEY_S_CONTEXT,
+   STATUS_KEY_ENVID,
+   STATUS_KEY_VPID,
+} LinuxStatusKey;
+
+static LinuxStatusKey LinuxProcessTable_statusKey(const char* key, size_t len) {
+#define STATUS_KEY_IS(name_) (len == sizeof(name_) - 1 && memcmp(key, name_, sizeof(name_) - 1) == 0)
+   switch (key[0]) {
+      case 'C':
+         if (STATUS_KEY_IS("CapPrm"))
+            return STATUS_KEY_CAPPRM;
+         break;
+      case 'N':
+         if (STATUS_KEY_IS("NSpid"))
+            return STATUS_KEY_NSPID;
+         break;
+      case 'V':
+         if (STATUS_KEY_IS("VxID"))
+            return STATUS_KEY_VXID;
+         if (STATUS_KEY_IS("VPid"))
+            return STATUS_KEY_VPID;
+         break;
+      case 'e':
+         if (STATUS_KEY_IS("envID"))
+            return STATUS_KEY_ENVID;
+         break;
+      case 'n':
+         if (STATUS_KEY_IS("nonvoluntary_ctxt_switches"))
+            return STATUS_KEY_NONVOLUNTARY_CTXT;
+         break;
+      case 's':
+         if (STATUS_KEY_IS("s_context"))
+            return STATUS_KEY_S_CONTEXT;
+         break;
+      case 'v':
+         if (STATUS_KEY_IS("voluntary_ctxt_switches"))
+            return STATUS_KEY_VOLUNTARY_CTXT;
+         break;
+      default:
+         break;
+   }
+#undef STATUS_KEY_IS
+   return STATUS_KEY_UNKNOWN;
+}
 
-      if (String_startsWith(buffer, "NSpid:")) {
-         const char* ptr = buffer;
-         int pid_ns_count = 0;
-         while (*ptr && *ptr != '\n' && !isdigit((unsigned char)*ptr))
-            ++ptr;
+static void LinuxProcessTable_parseStatusFile(Process* process, char* buf, LinuxProcessStatus* status) {
+   LinuxProcess* lp = (LinuxProcess*) process;
 
-         while (*ptr && *ptr != '\n') {
-            if (isdigit(*ptr))
-               pid_ns_count++;
-            while (isdigit((unsigned char)*ptr))
-               ++ptr;
-            while (*ptr && *ptr != '\n' && !isdigit((unsigned char)*ptr))
-               ++ptr;
-         }
+   unsigned long ctxt = 0;
+#ifdef HAVE_VSERVER
+   unsigned int vxid = 0;
+#endif
+   memset(status, 0, sizeof(*status));
+   status->valid = true;
 
-         if (pid_ns_count > 1)
-            process->isRunningInContainer = true;
+   char* line;
+   while ((line = strsep(&buf, "\n")) != NULL) {
+      char* value = strchr(line, ':');
+      if (!value || value == line)
+         continue;
 
-      } else if (String_startsWith(buffer, "CapPrm:")) {
-         char* ptr = buffer + strlen("CapPrm:");
-         while (*ptr == ' ' || *ptr == '\t')
-            ptr++;
+      LinuxStatusKey key = LinuxProcessTable_statusKey(line, (size_t)(value - line));
+      if (key == STATUS_KEY_UNKNOWN)
+         continue;
 
-         uint64_t cap_permitted = fast_strtoull_hex(&ptr, 16);
-         process->elevated_priv = cap_permitted != 0 && process->st_uid != 0;
+      value++;
+      while (*value == ' ' || *value == '\t')
+         value++;
+
+      switch (key) {
+         case STATUS_KEY_NSPID: {
+            int pid_ns_count = 0;
+            for (const char* ptr = value; *ptr; ) {
+               if (isdigit((unsigned char)*ptr)) {
+                  pid_ns_count++;
+                  while (isdigit((unsigned char)*ptr))
+                     ++ptr;
+               } else {
+                  ++ptr;
+               }
+            }
 
-      } else if (String_startsWith(buffer, "voluntary_ctxt_switches:")) {
-         unsigned long vctxt;
-         int ok = sscanf(buffer, "voluntary_ctxt_switches:\t%lu", &vctxt);
-         if (ok >= 1) {
-            ctxt += vctxt;
+            if (pid_ns_count > 1)
+               process->isRunningInContainer = true;
+            break;
          }
-
-      } else if (String_startsWith(buffer, "nonvoluntary_ctxt_switches:")) {
-         unsigned long nvctxt;
-         int ok = sscanf(buffer, "nonvoluntary_ctxt_switches:\t%lu", &nvctxt);
-         if (ok >= 1) {
-            ctxt += nvctxt;
+         case STATUS_KEY_CAPPRM: {
+            uint64_t cap_permitted = fast_strtoull_hex(&value, 16);
+            process->elevated_priv = cap_permitted != 0 && process->st_uid != 0;
+            break;
          }
-
+         case STATUS_KEY_VOLUNTARY_CTXT:
+            ctxt += fast_strtoull_dec(&value, 20);
+            break;
+         case STATUS_KEY_NONVOLUNTARY_CTXT:
+            lp->nvcsw_total = fast_strtoull_dec(&value, 20);
+            ctxt += lp->nvcsw_total;
+            break;
 #ifdef HAVE_VSERVER
-      } else if (String_startsWith(buffer, "VxID:")) {
-         int vxid;
-         int ok = sscanf(buffer, "VxID:\t%32d", &vxid);
-         if (ok >= 1) {
-            lp->vxid = vxid;
-         }
+         case STATUS_KEY_VXID:
 #ifdef HAVE_ANCIENT_VSERVER
-      } else if (String_startsWith(buffer, "s_context:")) {
-         int vxid;
-         int ok = sscanf(buffer, "s_context:\t%32d", &vxid);
-         if (ok >= 1) {
-            lp->vxid = vxid;
-         }
-#endif /* HAVE_ANCIENT_VSERVER */
+         case STATUS_KEY_S_CONTEXT:
+#endif
+            vxid = (unsigned int)strtoul(value, NULL, 10);
+            break;
 #endif /* HAVE_VSERVER */
+#ifdef HAVE_OPENVZ
+         case STATUS_KEY_ENVID: {
+            size_t len = strcspn(value, " \t");
+            if (len > 0 && len < sizeof(status->envID)) {
+               memcpy(status->envID, value, len);
+               status->envID[len] = '\0';
+            }
+            break;
+         }
+         case STATUS_KEY_VPID:
+            if (isdigit((unsigned char)*value)) {
+               status->foundVPid = true;
+               status->vpid = (pid_t)strtoul(value, NULL, 0);
+            }
+            break;
+#endif /* HAVE_OPENVZ */
+         default:
+            break;
       }
    }
 
-   fclose(statusfile);
-
    lp->ctxt_diff = (ctxt > lp->ctxt_total) ? (ctxt - lp->ctxt_total) : 0;
    lp->ctxt_total = ctxt;
+#ifdef HAVE_VSERVER
+   if (vxid || lp->details)
+      LinuxProcess_details(lp)->vxid = vxid;
+#endif
+}
 
+static bool LinuxProcessTable_readStatusFile(Process* process, openat_arg_t procFd, LinuxProcessStatus* status) {
+   char buffer[PROC_PID_STATUS_BUFSIZE];
+   ssize_t r = xReadfileat(procFd, "status", buffer, sizeof(buffer));
+   if (r < 0)
+      return false;
+
+   LinuxProcessTable_parseStatusFile(process, buffer, status);
    return true;
 }
 
@@ -482,33 +730,24 @@ static bool LinuxProcessTable_updateUser(const Machine* host, Process* process,
    return true;
 }
 
-static void LinuxProcessTable_readIoFile(LinuxProcess* lp, openat_arg_t procFd, bool scanMainThread) {
+static void LinuxProcessTable_parseIoFile(LinuxProcess* lp, char* buffer) {
    Process* process = &lp->super;
    const Machine* host = process->super.host;
-   char path[20] = "io";
-   char buffer[1024];
-   if (scanMainThread) {
-      xSnprintf(path, sizeof(path), "task/%"PRIi32"/io", (int32_t)Process_getPid(process));
-   }
-   ssize_t r = xReadfileat(procFd, path, buffer, sizeof(buffer));
-   if (r < 0) {
-      lp->io_rate_read_bps = NAN;
-      lp->io_rate_write_bps = NAN;
-      lp->io_rchar = ULLONG_MAX;
-      lp->io_wchar = ULLONG_MAX;
-      lp->io_syscr = ULLONG_MAX;
-      lp->io_syscw = ULLONG_MAX;
-      lp->io_read_bytes = ULLONG_MAX;
-      lp->io_write_bytes = ULLONG_MAX;
-      lp->io_cancelled_write_bytes = ULLONG_MAX;
-      lp->io_last_scan_time_ms = host->realtimeMs;
+   LinuxProcessDetails* d = LinuxProcess_details(lp);
+
+   if (!buffer) {
+      Rate_reset(&d->io_read_rate);
+      Rate_reset(&d->io_write_rate);
+      d->io_rchar = ULLONG_MAX;
+      d->io_wchar = ULLONG_MAX;
+      d->io_syscr = ULLONG_MAX;
+      d->io_syscw = ULLONG_MAX;
+      d->io_read_bytes = ULLONG_MAX;
+      d->io_write_bytes = ULLONG_MAX;
+      d->io_cancelled_write_bytes = ULLONG_MAX;
       return;
    }
 
-   unsigned long long last_read = lp->io_read_bytes;
-   unsigned long long last_write = lp->io_write_bytes;
-   unsigned long long time_delta = saturatingSub(host->realtimeMs, lp->io_last_scan_time_ms);
-
    // Note: Linux Kernel documentation states that /proc/<pid>/io may be racy
    // on 32-bit machines. (Documentation/filesystems/proc.rst)
 
@@ -518,69 +757,231 @@ static void LinuxProcessTable_readIoFile(LinuxProcess* lp, openat_arg_t procFd,
       switch (line[0]) {
          case 'r':
             if (line[1] == 'c' && String_startsWith(line + 2, "har: ")) {
-               lp->io_rchar = strtoull(line + 7, NULL, 10);
+               d->io_rchar = strtoull(line + 7, NULL, 10);
             } else if (String_startsWith(line + 1, "ead_bytes: ")) {
-               lp->io_read_bytes = strtoull(line + 12, NULL, 10);
-               lp->io_rate_read_bps = time_delta ? saturatingSub(lp->io_read_bytes, last_read) * /*ms to s*/1000. / time_delta : NAN;
+               d->io_read_bytes = strtoull(line + 12, NULL, 10);
+               Rate_update(&d->io_read_rate, d->io_read_bytes, host->monotonicMs);
             }
             break;
          case 'w':
             if (line[1] == 'c' && String_startsWith(line + 2, "har: ")) {
-               lp->io_wchar = strtoull(line + 7, NULL, 10);
+               d->io_wchar = strtoull(line + 7, NULL, 10);
             } else if (String_startsWith(line + 1, "rite_bytes: ")) {
-               lp->io_write_bytes = strtoull(line + 13, NULL, 10);
-               lp->io_rate_write_bps = time_delta ? saturatingSub(lp->io_write_bytes, last_write) * /*ms to s*/1000. / time_delta : NAN;
+               d->io_write_bytes = strtoull(line + 13, NULL, 10);
+               Rate_update(&d->io_write_rate, d->io_write_bytes, host->monotonicMs);
             }
             break;
          case 's':
             if (line[4] == 'r' && String_startsWith(line + 1, "yscr: ")) {
-               lp->io_syscr = strtoull(line + 7, NULL, 10);
+               d->io_syscr = strtoull(line + 7, NULL, 10);
             } else if (String_startsWith(line + 1, "yscw: ")) {
-               lp->io_syscw = strtoull(line + 7, NULL, 10);
+               d->io_syscw = strtoull(line + 7, NULL, 10);
             }
             break;
          case 'c':
             if (String_startsWith(line + 1, "ancelled_write_bytes: ")) {
-               lp->io_cancelled_write_bytes = strtoull(line + 23, NULL, 10);
+               d->io_cancelled_write_bytes = strtoull(line + 23, NULL, 10);
             }
       }
    }
+}
 
-   lp->io_last_scan_time_ms = host->realtimeMs;
+/*
+ * The files of the processes of other users an unprivileged htop may not
+ * read fail the same way on every scan. They are left alone until the
+ * process changes its owner, as setuid programs do and as /proc shows for
+ * processes that made themselves non-dumpable, or executes another program.
+ */
+static inline bool LinuxProcessTable_isDenied(const LinuxProcess* lp, uint8_t file) {
+   return (lp->denied & file) && lp->deniedUid == lp->super.st_uid;
 }
 
-typedef struct LibraryData_ {
-   uint64_t size;
-   bool exec;
-} LibraryData;
+static void LinuxProcessTable_noteDenied(LinuxProcess* lp, uint8_t file, int error) {
+   if (error != EACCES && error != EPERM)
+      return;
+
+   if (lp->deniedUid != lp->super.st_uid) {
+      lp->denied = 0;
+      lp->deniedUid = lp->super.st_uid;
+   }
+   lp->denied |= file;
+}
 
-static void LinuxProcessTable_calcLibSize_helper(ATTR_UNUSED ht_key_t key, void* value, void* data) {
-   if (!data)
+static void LinuxProcessTable_readIoFile(LinuxProcess* lp, openat_arg_t procFd, bool scanMainThread) {
+   if (LinuxProcessTable_isDenied(lp, LINUX_DENIED_IO)) {
+      LinuxProcessTable_parseIoFile(lp, NULL);
       return;
+   }
+
+   char path[20] = "io";
+   char buffer[PROC_PID_IO_BUFSIZE];
+   if (scanMainThread) {
+      xSnprintf(path, sizeof(path), "task/%"PRIi32"/io", (int32_t)Process_getPid(&lp->super));
+   }
+   ssize_t r = xReadfileat(procFd, path, buffer, sizeof(buffer));
+   if (r < 0)
+      LinuxProcessTable_noteDenied(lp, LINUX_DENIED_IO, (int)-r);
+
+   LinuxProcessTable_parseIoFile(lp, r < 0 ? NULL : buffer);
+}
 
-   if (!value)
+static void LinuxProcessTable_parsePrefetchedIo(LinuxProcess* lp, const ProcScanItem* prefetch) {
+   if (!prefetch->io)
+      LinuxProcessTable_noteDenied(lp, LINUX_DENIED_IO, prefetch->ioError);
+   LinuxProcessTable_parseIoFile(lp, prefetch->io);
+}
+
+/* A process that did not run did no I/O either: its counters stand, its rates drop to zero */
+static void LinuxProcessTable_idleIo(LinuxProcess* lp) {
+   if (!lp->details)
       return;
 
-   const LibraryData* v = (const LibraryData*)value;
-   uint64_t* d = (uint64_t*)data;
-   if (!v->exec)
+   const uint64_t now = lp->super.super.host->monotonicMs;
+   LinuxProcessDetails* d = lp->details;
+   Rate_update(&d->io_read_rate, d->io_read_bytes, now);
+   Rate_update(&d->io_write_rate, d->io_write_bytes, now);
+}
+
+static bool LinuxProcessTable_isDeletedLibrary(const char* name) {
+   if (*name != '/')
+      return false;
+
+   if (String_startsWith(name, "/memfd:"))
+      return false;
+
+   /* Virtualbox maps /dev/zero for memory allocation. That results in
+    * false positive, so ignore. */
+   if (String_eq(name, "/dev/zero (deleted)"))
+      return false;
+
+   const char* deletedMarker = " (deleted)";
+   const size_t markerLen = strlen(deletedMarker);
+   const size_t nameLen = strlen(name);
+   return nameLen > markerLen && String_eq(name + nameLen - markerLen, deletedMarker);
+}
+
+/* PROCMAP_QUERY ioctl on /proc/<pid>/maps (Linux 6.11), see include/uapi/linux/fs.h */
+struct LinuxProcessTable_procmapQuery {
+   uint64_t size;
+   uint64_t query_flags;
+   uint64_t query_addr;
+   uint64_t vma_start;
+   uint64_t vma_end;
+   uint64_t vma_flags;
+   uint64_t vma_page_size;
+   uint64_t vma_offset;
+   uint64_t inode;
+   uint32_t dev_major;
+   uint32_t dev_minor;
+   uint32_t vma_name_size;
+   uint32_t build_id_size;
+   uint64_t vma_name_addr;
+   uint64_t build_id_addr;
+};
+
+#define LINUX_PROCMAP_QUERY                     _IOWR('f', 17, struct LinuxProcessTable_procmapQuery)
+#define LINUX_PROCMAP_QUERY_VMA_EXECUTABLE      0x04
+#define LINUX_PROCMAP_QUERY_COVERING_OR_NEXT_VMA 0x10
+#define LINUX_PROCMAP_QUERY_FILE_BACKED_VMA     0x20
+
+/* Takes the deleted state of the file of the mapping found by a query without its name */
+static void LinuxProcessTable_queryMapName(int fd, const struct LinuxProcessTable_procmapQuery* found, LibraryCache* cache, LibraryEntry* entry) {
+   char name[PATH_MAX];
+   struct LinuxProcessTable_procmapQuery query;
+   memset(&query, 0, sizeof(query));
+   query.size = sizeof(query);
+   query.query_flags = LINUX_PROCMAP_QUERY_COVERING_OR_NEXT_VMA | LINUX_PROCMAP_QUERY_FILE_BACKED_VMA;
+   query.query_addr = found->vma_start;
+   query.vma_name_addr = (uint64_t)(uintptr_t)name;
+   query.vma_name_size = sizeof(name);
+
+   if (ioctl(fd, LINUX_PROCMAP_QUERY, &query) < 0 || query.inode != found->inode)
       return;
 
-   *d += v->size;
+   LibraryCache_setDeleted(cache, entry, query.vma_name_size > 0 && LinuxProcessTable_isDeletedLibrary(name));
+}
+
+/*
+ * Walks the file backed mappings with PROCMAP_QUERY instead of formatting
+ * and parsing the maps text. The names are only asked for files whose
+ * deleted state is not known yet in this cycle. Returns false if the ioctl
+ * is not supported, leaving the process untouched.
+ */
+static bool LinuxProcessTable_queryMaps(LibraryCache* cache, Process* proc, openat_arg_t procFd, bool calcSize, bool checkDeletedLib) {
+   int fd = Compat_openat(procFd, "maps", O_RDONLY | O_CLOEXEC);
+   if (fd < 0) {
+      LinuxProcessTable_noteDenied((LinuxProcess*)proc, LINUX_DENIED_MAPS, errno);
+      return true;
+   }
+
+   struct LinuxProcessTable_procmapQuery query;
+   uint64_t addr = 0;
+   bool supported = true;
+
+   for (;;) {
+      memset(&query, 0, sizeof(query));
+      query.size = sizeof(query);
+      query.query_flags = LINUX_PROCMAP_QUERY_COVERING_OR_NEXT_VMA | LINUX_PROCMAP_QUERY_FILE_BACKED_VMA;
+      /* without the library sizes only executable mappings are of interest */
+      if (!calcSize)
+         query.query_flags |= LINUX_PROCMAP_QUERY_VMA_EXECUTABLE;
+      query.query_addr = addr;
+
+      if (ioctl(fd, LINUX_PROCMAP_QUERY, &query) < 0) {
+         /* ENOENT: no mapping above addr, ENOTTY: ioctl not known */
+         supported = errno != ENOTTY;
+         break;
+      }
+
+      const bool exec = query.vma_flags & LINUX_PROCMAP_QUERY_VMA_EXECUTABLE;
+
+      if (query.inode && (query.dev_major || query.dev_minor)) {
+         const uint64_t dev = ((uint64_t)query.dev_major << 32) | query.dev_minor;
+         LibraryEntry* entry = LibraryCache_add(cache, dev, query.inode, query.vma_end - query.vma_start, exec);
+
+         if (checkDeletedLib && exec && !proc->usesDeletedLib) {
+            if (LibraryCache_needsName(cache, entry))
+               LinuxProcessTable_queryMapName(fd, &query, cache, entry);
+
+            if (entry->deleted) {
+               proc->usesDeletedLib = true;
+               if (!calcSize)
+                  break;
+            }
+         }
+      }
+
+      if (query.vma_end <= addr)
+         break;
+      addr = query.vma_end;
+   }
+
+   close(fd);
+   return supported;
 }
 
-static void LinuxProcessTable_readMaps(LinuxProcess* process, openat_arg_t procFd, const LinuxMachine* host, bool calcSize, bool checkDeletedLib) {
+static void LinuxProcessTable_readMaps(LinuxProcessTable* this, LinuxProcess* process, openat_arg_t procFd, const LinuxMachine* host, bool calcSize, bool checkDeletedLib) {
    Process* proc = (Process*)process;
+   LibraryCache* cache = this->libraryCache;
 
    proc->usesDeletedLib = false;
+   LibraryCache_beginProcess(cache);
+
+   if (this->haveProcmapQuery) {
+      if (LinuxProcessTable_queryMaps(cache, proc, procFd, calcSize, checkDeletedLib))
+         goto done;
+
+      /* older kernel: use the text interface from now on */
+      this->haveProcmapQuery = true;
+      LibraryCache_beginProcess(cache);
+      proc->usesDeletedLib = false;
+   }
 
    FILE* mapsfile = fopenat(procFd, "maps", "r");
-   if (!mapsfile)
+   if (!mapsfile) {
+      LinuxProcessTable_noteDenied(process, LINUX_DENIED_MAPS, errno);
       return;
-
-   Hashtable* ht = NULL;
-   if (calcSize)
-      ht = Hashtable_new(64, true);
+   }
 
    char buffer[1024];
    while (fgets(buffer, sizeof(buffer), mapsfile)) {
@@ -635,33 +1036,22 @@ static void LinuxProcessTable_readMaps(LinuxProcess* process, openat_arg_t procF
       if (!map_inode)
          continue;
 
-      if (calcSize) {
-         LibraryData* libdata = Hashtable_get(ht, map_inode);
-         if (!libdata) {
-            libdata = xCalloc(1, sizeof(LibraryData));
-            Hashtable_put(ht, map_inode, libdata);
-         }
-
-         libdata->size += map_end - map_start;
-         libdata->exec |= map_execute;
-      }
+      const uint64_t map_dev = ((uint64_t)map_devmaj << 32) | map_devmin;
+      LibraryEntry* entry = LibraryCache_add(cache, map_dev, map_inode, map_end - map_start, map_execute);
 
       if (checkDeletedLib && map_execute && !proc->usesDeletedLib) {
-         while (*readptr == ' ')
-            readptr++;
-
-         if (*readptr != '/')
-            continue;
+         if (LibraryCache_needsName(cache, entry)) {
+            while (*readptr == ' ')
+               readptr++;
 
-         if (String_startsWith(readptr, "/memfd:"))
-            continue;
+            char* newline = strchr(readptr, '\n');
+            if (newline)
+               *newline = '\0';
 
-         /* Virtualbox maps /dev/zero for memory allocation. That results in
-          * false positive, so ignore. */
-         if (String_eq(readptr, "/dev/zero (deleted)\n"))
-            continue;
+            LibraryCache_setDeleted(cache, entry, LinuxProcessTable_isDeletedLibrary(readptr));
+         }
 
-         if (strstr(readptr, " (deleted)\n")) {
+         if (entry->deleted) {
             proc->usesDeletedLib = true;
             if (!calcSize)
                break;
@@ -671,24 +1061,15 @@ static void LinuxProcessTable_readMaps(LinuxProcess* process, openat_arg_t procF
 
    fclose(mapsfile);
 
-   if (calcSize) {
-      uint64_t total_size = 0;
-      Hashtable_foreach(ht, LinuxProcessTable_calcLibSize_helper, &total_size);
-
-      Hashtable_delete(ht);
-
-      process->m_lrs = total_size / host->pageSize;
-   }
+done:
+   if (calcSize)
+      process->m_lrs = LibraryCache_endProcess(cache) / host->pageSize;
 }
 
-static bool LinuxProcessTable_readStatmFile(LinuxProcess* process, openat_arg_t procFd, const LinuxMachine* host) {
-   FILE* statmfile = fopenat(procFd, "statm", "r");
-   if (!statmfile)
-      return false;
-
+static bool LinuxProcessTable_parseStatmFile(LinuxProcess* process, const char* buffer, const LinuxMachine* host) {
    long int dummy, dummy2;
 
-   int r = fscanf(statmfile, "%ld %ld %ld %ld %ld %ld %ld",
+   int r = sscanf(buffer, "%ld %ld %ld %ld %ld %ld %ld",
                   &process->super.m_virt,
                   &process->super.m_resident,
                   &process->m_share,
@@ -696,7 +1077,6 @@ static bool LinuxProcessTable_readStatmFile(LinuxProcess* process, openat_arg_t
                   &dummy, /* unused since Linux 2.6; always 0 */
                   &process->m_drs,
                   &dummy2); /* unused since Linux 2.6; always 0 */
-   fclose(statmfile);
 
    if (r == 7) {
       process->super.m_virt *= host->pageSizeKB;
@@ -708,16 +1088,31 @@ static bool LinuxProcessTable_readStatmFile(LinuxProcess* process, openat_arg_t
    return r == 7;
 }
 
+static bool LinuxProcessTable_readStatmFile(LinuxProcess* process, openat_arg_t procFd, const LinuxMachine* host) {
+   char buffer[PROC_PID_STATM_BUFSIZE];
+   ssize_t r = xReadfileat(procFd, "statm", buffer, sizeof(buffer));
+   if (r < 0)
+      return false;
+
+   return LinuxProcessTable_parseStatmFile(process, buffer, host);
+}
+
 static bool LinuxProcessTable_readSmapsFile(LinuxProcess* process, openat_arg_t procFd, bool haveSmapsRollup) {
    //http://elixir.free-electrons.com/linux/v4.10/source/fs/proc/task_mmu.c#L719
    //kernel will return data in chunks of size PAGE_SIZE or less.
    FILE* f = fopenat(procFd, haveSmapsRollup ? "smaps_rollup" : "smaps", "r");
-   if (!f)
+   if (!f) {
+      LinuxProcessTable_noteDenied(process, LINUX_DENIED_SMAPS, errno);
       return false;
+   }
 
-   process->m_pss   = 0;
-   process->m_swap  = 0;
-   process->m_psswp = 0;
+   LinuxProcessDetails* d = LinuxProcess_details(process);
+   d->m_pss   = 0;
+   d->m_swap  = 0;
+   d->m_psswp = 0;
+   d->m_thp   = 0;
+   d->m_hugetlb = 0;
+   long rss = 0;
 
    char buffer[256];
    while (fgets(buffer, sizeof(buffer), f)) {
@@ -732,138 +1127,189 @@ static bool LinuxProcessTable_readSmapsFile(LinuxProcess* process, openat_arg_t
       }
 
       if (String_startsWith(buffer, "Pss:")) {
-         process->m_pss += strtol(buffer + 4, NULL, 10);
+         d->m_pss += strtol(buffer + 4, NULL, 10);
       } else if (String_startsWith(buffer, "Swap:")) {
-         process->m_swap += strtol(buffer + 5, NULL, 10);
+         d->m_swap += strtol(buffer + 5, NULL, 10);
       } else if (String_startsWith(buffer, "SwapPss:")) {
-         process->m_psswp += strtol(buffer + 8, NULL, 10);
+         d->m_psswp += strtol(buffer + 8, NULL, 10);
+      } else if (String_startsWith(buffer, "Rss:")) {
+         rss += strtol(buffer + 4, NULL, 10);
+      } else if (String_startsWith(buffer, "AnonHugePages:")) {
+         d->m_thp += strtol(buffer + 14, NULL, 10);
+      } else if (String_startsWith(buffer, "ShmemPmdMapped:")) {
+         d->m_thp += strtol(buffer + 15, NULL, 10);
+      } else if (String_startsWith(buffer, "FilePmdMapped:")) {
+         d->m_thp += strtol(buffer + 14, NULL, 10);
+      } else if (String_startsWith(buffer, "Shared_Hugetlb:")) {
+         d->m_hugetlb += strtol(buffer + 15, NULL, 10);
+      } else if (String_startsWith(buffer, "Private_Hugetlb:")) {
+         d->m_hugetlb += strtol(buffer + 16, NULL, 10);
       }
    }
 
+   d->thp_percent = rss > 0 ? (float)(100.0 * (double)MINIMUM(d->m_thp, rss) / (double)rss) : NAN;
+
    fclose(f);
    return true;
 }
 
-#ifdef HAVE_OPENVZ
-
-static void LinuxProcessTable_readOpenVZData(LinuxProcess* process, openat_arg_t procFd) {
-   if (access(PROCDIR "/vz", R_OK) != 0) {
-      free(process->ctid);
-      process->ctid = NULL;
-      process->vpid = Process_getPid(&process->super);
+/*
+ * Sums up the pages of each NUMA node over the mappings in numa_maps. Like
+ * smaps, reading it makes the kernel walk the page tables of the process.
+ */
+static void LinuxProcessTable_readNumaMaps(LinuxProcess* process, openat_arg_t procFd, const LinuxMachine* host) {
+   FILE* f = fopenat(procFd, "numa_maps", "r");
+   if (!f) {
+      LinuxProcessTable_noteDenied(process, LINUX_DENIED_NUMA_MAPS, errno);
       return;
    }
 
-   FILE* file = fopenat(procFd, "status", "r");
-   if (!file) {
-      free(process->ctid);
-      process->ctid = NULL;
-      process->vpid = Process_getPid(&process->super);
-      return;
-   }
+   const unsigned int nodes = host->numaNodes;
+   LinuxProcessDetails* d = LinuxProcess_details(process);
+   if (!d->numaKB)
+      d->numaKB = xCalloc(nodes, sizeof(*d->numaKB));
+   else
+      memset(d->numaKB, 0, nodes * sizeof(*d->numaKB));
 
-   bool foundEnvID = false;
-   bool foundVPid = false;
-   char linebuf[256];
-   while (fgets(linebuf, sizeof(linebuf), file) != NULL) {
-      if (strchr(linebuf, '\n') == NULL) {
-         // Partial line, skip to end of this line
-         while (fgets(linebuf, sizeof(linebuf), file) != NULL) {
-            if (strchr(linebuf, '\n') != NULL) {
+   char buffer[PROC_LINE_LENGTH + 1];
+   while (fgets(buffer, sizeof(buffer), f)) {
+      if (!strchr(buffer, '\n')) {
+         // Partial line (a long file name), skip to end of this line
+         while (fgets(buffer, sizeof(buffer), f)) {
+            if (strchr(buffer, '\n')) {
                break;
             }
          }
          continue;
       }
 
-      char* name_value_sep = strchr(linebuf, ':');
-      if (name_value_sep == NULL) {
-         continue;
-      }
-
-      int field;
-      if (0 == strncasecmp(linebuf, "envID", name_value_sep - linebuf)) {
-         field = 1;
-      } else if (0 == strncasecmp(linebuf, "VPid", name_value_sep - linebuf)) {
-         field = 2;
-      } else {
-         continue;
-      }
-
-      do {
-         name_value_sep++;
-      } while (*name_value_sep != '\0' && *name_value_sep <= 32);
+      /* the page size comes last, after the page counts per node */
+      const char* pageSizeField = strstr(buffer, " kernelpagesize_kB=");
+      unsigned long long pageKB = pageSizeField ? strtoull(pageSizeField + 19, NULL, 10) : (unsigned long long)host->pageSizeKB;
 
-      char* value_end = name_value_sep;
+      for (const char* p = strstr(buffer, " N"); p; p = strstr(p + 1, " N")) {
+         char* end;
+         unsigned long node = strtoul(p + 2, &end, 10);
+         if (end == p + 2 || *end != '=' || node >= nodes)
+            continue;
 
-      while (*value_end > 32) {
-         value_end++;
+         d->numaKB[node] += strtoull(end + 1, NULL, 10) * pageKB;
       }
+   }
 
-      if (name_value_sep == value_end) {
-         continue;
-      }
+   fclose(f);
+}
 
-      *value_end = '\0';
+/*
+ * Counts the open fds of a process. Since Linux 6.2 the size of its fd
+ * directory is their number, else the directory entries are counted; no
+ * link is resolved either way. The fds of other users are not readable.
+ */
+static void LinuxProcessTable_readFdCount(LinuxProcess* process, openat_arg_t procFd, uint64_t monotonicMs) {
+   int dirFd = Compat_openat(procFd, "fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   if (dirFd < 0) {
+      LinuxProcessTable_noteDenied(process, LINUX_DENIED_FDS, errno);
+      return;
+   }
 
-      switch (field) {
-         case 1:
-            foundEnvID = true;
-            if (!String_eq(name_value_sep, process->ctid ? process->ctid : ""))
-               free_and_xStrdup(&process->ctid, name_value_sep);
-            break;
-         case 2:
-            foundVPid = true;
-            process->vpid = strtoul(name_value_sep, NULL, 0);
-            break;
-         default:
-            //Sanity Check: Should never reach here, or the implementation is missing something!
-            assert(false && "OpenVZ handling: Unimplemented case for field handling reached.");
+   unsigned long count = 0;
+   struct stat st;
+   if (fstat(dirFd, &st) == 0 && st.st_size > 0) {
+      count = (unsigned long)st.st_size;
+      close(dirFd);
+   } else {
+      DIR* dir = fdopendir(dirFd);
+      if (!dir) {
+         close(dirFd);
+         return;
+      }
+
+      const struct dirent* entry;
+      while ((entry = readdir(dir)) != NULL) {
+         if (entry->d_name[0] != '.')
+            count++;
       }
+      closedir(dir);
+   }
+
+   LinuxProcessDetails* d = LinuxProcess_details(process);
+   if (d->fdCountMs && monotonicMs > d->fdCountMs) {
+      d->fdRate = ((double)count - (double)d->fdCount) * 1000.0 / (double)(monotonicMs - d->fdCountMs);
+   } else if (!d->fdCountMs) {
+      d->fdRate = NAN;
    }
+   d->fdCount = count;
+   d->fdCountMs = monotonicMs;
+}
+
+#ifdef HAVE_OPENVZ
 
-   fclose(file);
+static void LinuxProcessTable_readOpenVZData(LinuxProcess* process, const LinuxProcessStatus* status) {
+   LinuxProcessDetails* d = LinuxProcess_details(process);
 
-   if (!foundEnvID) {
-      free(process->ctid);
-      process->ctid = NULL;
+   if (!status->valid || !FsRoot_access(&FsRoot_proc, "vz", R_OK)) {
+      free(d->ctid);
+      d->ctid = NULL;
+      d->vpid = Process_getPid(&process->super);
+      return;
    }
 
-   if (!foundVPid) {
-      process->vpid = Process_getPid(&process->super);
+   if (status->envID[0]) {
+      if (!String_eq(status->envID, d->ctid ? d->ctid : ""))
+         free_and_xStrdup(&d->ctid, status->envID);
+   } else {
+      free(d->ctid);
+      d->ctid = NULL;
    }
+
+   d->vpid = status->foundVPid ? status->vpid : Process_getPid(&process->super);
 }
 
 #endif
 
-static void LinuxProcessTable_readCGroupFile(LinuxProcess* process, openat_arg_t procFd) {
-   FILE* file = fopenat(procFd, "cgroup", "r");
-   if (!file) {
-      if (process->cgroup) {
-         free(process->cgroup);
-         process->cgroup = NULL;
-      }
-      if (process->cgroup_short) {
-         free(process->cgroup_short);
-         process->cgroup_short = NULL;
-      }
-      if (process->container_short) {
-         free(process->container_short);
-         process->container_short = NULL;
-      }
+static void LinuxProcessTable_updateCGroupWidths(const LinuxProcess* process) {
+   const CGroupName* cgroup = process->cgroup;
+   if (!cgroup)
+      return;
+
+   Row_updateFieldWidth(CGROUP, cgroup->rawLen);
+   //CCGROUP is alias to normal CGROUP if shortening fails
+   Row_updateFieldWidth(CCGROUP, cgroup->compressed ? cgroup->compressedLen : cgroup->rawLen);
+   //CONTAINER is just "N/A" if shortening fails
+   size_t nameLen;
+   if (ContainerNames_label(cgroup->containerName, &nameLen))
+      Row_updateFieldWidth(CONTAINER, nameLen);
+   else
+      Row_updateFieldWidth(CONTAINER, cgroup->container ? cgroup->containerLen : strlen("N/A"));
+}
+
+/*
+ * Processes in the same cgroup share one interned name, so the filters
+ * run once per distinct cgroup instead of once per process.
+ */
+static void LinuxProcessTable_readCGroupFile(LinuxProcessTable* this, LinuxProcess* process, openat_arg_t procFd) {
+   char buffer[PROC_PID_CGROUP_BUFSIZE];
+   ssize_t r = xReadfileat(procFd, "cgroup", buffer, sizeof(buffer));
+   if (r < 0) {
+      CGroupName_release(process->cgroup);
+      process->cgroup = NULL;
       return;
    }
    char output[PROC_LINE_LENGTH + 1];
    output[0] = '\0';
    char* at = output;
    int left = PROC_LINE_LENGTH;
-   while (!feof(file) && left > 0) {
-      char buffer[PROC_LINE_LENGTH + 1];
-      const char* ok = fgets(buffer, PROC_LINE_LENGTH, file);
-      if (!ok)
-         break;
+   char* buf = buffer;
+   char* line;
+   const char* unified = NULL;
+   while (left > 0 && (line = strsep(&buf, "\n")) != NULL) {
+      if (!line[0])
+         continue;
+
+      if (String_startsWith(line, "0::"))
+         unified = line + strlen("0::");
 
-      char* group = buffer;
+      char* group = line;
       for (size_t i = 0; i < 2; i++) {
          group = String_strchrnul(group, ':');
          if (!*group)
@@ -871,82 +1317,47 @@ static void LinuxProcessTable_readCGroupFile(LinuxProcess* process, openat_arg_t
          group++;
       }
 
-      char* eol = String_strchrnul(group, '\n');
-      *eol = '\0';
-
       if (at != output) {
          *at = ';';
          at++;
          left--;
       }
       int wrote = snprintf(at, left, "%s", group);
+      if (wrote >= left)
+         break;
+      at += wrote;
       left -= wrote;
    }
-   fclose(file);
-
-   bool changed = !process->cgroup || !String_eq(process->cgroup, output);
-
-   Row_updateFieldWidth(CGROUP, strlen(output));
-   free_and_xStrdup(&process->cgroup, output);
 
-   if (!changed) {
-      if (process->cgroup_short) {
-         Row_updateFieldWidth(CCGROUP, strlen(process->cgroup_short));
-      } else {
-         //CCGROUP is alias to normal CGROUP if shortening fails
-         Row_updateFieldWidth(CCGROUP, strlen(process->cgroup));
-      }
-      if (process->container_short) {
-         Row_updateFieldWidth(CONTAINER, strlen(process->container_short));
-      } else {
-         Row_updateFieldWidth(CONTAINER, strlen("N/A"));
-      }
-      return;
+   if (!process->cgroup || !String_eq(process->cgroup->raw, output)) {
+      CGroupName* cgroup = CGroupCache_get(this->cgroupCache, output, unified);
+      CGroupName_release(process->cgroup);
+      process->cgroup = cgroup;
    }
 
-   char* cgroup_short = CGroup_filterName(process->cgroup);
-   if (cgroup_short) {
-      Row_updateFieldWidth(CCGROUP, strlen(cgroup_short));
-      free_and_xStrdup(&process->cgroup_short, cgroup_short);
-      free(cgroup_short);
-   } else {
-      //CCGROUP is alias to normal CGROUP if shortening fails
-      Row_updateFieldWidth(CCGROUP, strlen(process->cgroup));
-      free(process->cgroup_short);
-      process->cgroup_short = NULL;
+   /* once per cgroup, the runtime metadata is read once per container */
+   CGroupName* cgroup = process->cgroup;
+   if (this->super.super.host->settings->containerNames && cgroup->container && !cgroup->containerNameLooked) {
+      cgroup->containerName = ContainerNames_get(cgroup->raw);
+      cgroup->containerNameLooked = true;
    }
 
-   char* container_short = CGroup_filterContainer(process->cgroup);
-   if (container_short) {
-      Row_updateFieldWidth(CONTAINER, strlen(container_short));
-      free_and_xStrdup(&process->container_short, container_short);
-      free(container_short);
-   } else {
-      //CONTAINER is just "N/A" if shortening fails
-      Row_updateFieldWidth(CONTAINER, strlen("N/A"));
-      free(process->container_short);
-      process->container_short = NULL;
-   }
+   LinuxProcessTable_updateCGroupWidths(process);
 }
 
 static void LinuxProcessTable_readOomData(LinuxProcess* process, openat_arg_t procFd) {
-   FILE* file = fopenat(procFd, "oom_score", "r");
-   if (!file)
+   char buffer[16];
+   ssize_t r = xReadfileat(procFd, "oom_score", buffer, sizeof(buffer));
+   if (r <= 0 || !isdigit((unsigned char)buffer[0]))
       return;
 
-   char buffer[PROC_LINE_LENGTH + 1];
-   if (fgets(buffer, PROC_LINE_LENGTH, file)) {
-      unsigned int oom;
-      int ok = sscanf(buffer, "%u", &oom);
-      if (ok >= 1) {
-         process->oom = oom;
-      }
-   }
-   fclose(file);
+   char* ptr = buffer;
+   process->oom = (unsigned int)fast_strtoull_dec(&ptr, 10);
 }
 
 static void LinuxProcessTable_readAutogroup(LinuxProcess* process, openat_arg_t procFd) {
-   process->autogroup_id = -1;
+   LinuxProcessDetails* d = LinuxProcess_details(process);
+   d->autogroup_id = -1;
 
    char autogroup[64]; // space for two numeric values and fixed length strings
    ssize_t amtRead = xReadfileat(procFd, "autogroup", autogroup, sizeof(autogroup));
@@ -957,25 +1368,62 @@ static void LinuxProcessTable_readAutogroup(LinuxProcess* process, openat_arg_t
    int nice;
    int ok = sscanf(autogroup, "/autogroup-%ld nice %d", &identity, &nice);
    if (ok == 2) {
-      process->autogroup_id = identity;
-      process->autogroup_nice = nice;
+      d->autogroup_id = identity;
+      d->autogroup_nice = nice;
    }
 }
 
-static void LinuxProcessTable_readSecattrData(LinuxProcess* process, openat_arg_t procFd) {
-   FILE* file = fopenat(procFd, "attr/current", "r");
-   if (!file) {
-      free(process->secattr);
-      process->secattr = NULL;
+/* Run queue wait in nanoseconds and timeslices run, the second and third value (CONFIG_SCHED_INFO) */
+static void LinuxProcessTable_parseSchedstatFile(LinuxProcess* process, const char* buffer, uint64_t monotonicMs) {
+   unsigned long long onCpuNs;
+   unsigned long long waitNs;
+   unsigned long long slices;
+   if (sscanf(buffer, "%llu %llu %llu", &onCpuNs, &waitNs, &slices) != 3)
       return;
+
+   LinuxProcessDetails* d = LinuxProcess_details(process);
+   Rate_update(&d->runq_wait_rate, waitNs, monotonicMs);
+   Rate_update(&d->runq_slice_rate, slices, monotonicMs);
+}
+
+static void LinuxProcessTable_readSchedstat(LinuxProcess* process, openat_arg_t procFd, uint64_t monotonicMs) {
+   char buffer[PROC_PID_SCHEDSTAT_BUFSIZE];
+   ssize_t r = xReadfileat(procFd, "schedstat", buffer, sizeof(buffer));
+   if (r <= 0)
+      return;
+
+   LinuxProcessTable_parseSchedstatFile(process, buffer, monotonicMs);
+}
+
+/*
+ * CPU% from the nanoseconds the task ran by the time `atNs` schedstat was
+ * read, its first value; NAN on the first reading. Unlike the clock ticks
+ * of stat it does not jump in steps at short intervals.
+ */
+static float LinuxProcessTable_runtimePercent(LinuxProcess* lp, const char* schedstat, uint64_t atNs) {
+   unsigned long long runtimeNs;
+   if (!schedstat || sscanf(schedstat, "%llu", &runtimeNs) != 1) {
+      lp->runtimeAtNs = 0;
+      return NAN;
    }
 
+   float percent = NAN;
+   if (lp->runtimeAtNs && atNs > lp->runtimeAtNs)
+      percent = saturatingSub(runtimeNs, lp->runtimeNs) * 100.0 / (double)(atNs - lp->runtimeAtNs);
+
+   lp->runtimeNs = runtimeNs;
+   lp->runtimeAtNs = atNs;
+   return percent;
+}
+
+static void LinuxProcessTable_readSecattrData(LinuxProcess* process, openat_arg_t procFd) {
    char buffer[PROC_LINE_LENGTH + 1];
-   const char* res = fgets(buffer, sizeof(buffer), file);
-   fclose(file);
-   if (!res) {
-      free(process->secattr);
-      process->secattr = NULL;
+   ssize_t r = xReadfileat(procFd, "attr/current", buffer, sizeof(buffer));
+   if (r <= 0) {
+      if (process->details) {
+         free(process->details->secattr);
+         process->details->secattr = NULL;
+      }
       return;
    }
    char* newline = strchr(buffer, '\n');
@@ -985,13 +1433,47 @@ static void LinuxProcessTable_readSecattrData(LinuxProcess* process, openat_arg_
 
    Row_updateFieldWidth(SECATTR, strlen(buffer));
 
-   if (process->secattr && String_eq(process->secattr, buffer)) {
+   LinuxProcessDetails* d = LinuxProcess_details(process);
+   if (d->secattr && String_eq(d->secattr, buffer)) {
+      return;
+   }
+   free_and_xStrdup(&d->secattr, buffer);
+}
+
+static void LinuxProcessTable_clearWchan(LinuxProcess* process) {
+   if (process->details) {
+      free(process->details->wchan);
+      process->details->wchan = NULL;
+   }
+}
+
+/* The kernel prints "0" for tasks running, or if the address may not be named to us */
+static void LinuxProcessTable_readWchan(LinuxProcess* process, openat_arg_t procFd) {
+   char buffer[128];
+   ssize_t r = xReadfileat(procFd, "wchan", buffer, sizeof(buffer));
+   if (r <= 0) {
+      LinuxProcessTable_clearWchan(process);
+      return;
+   }
+   buffer[strcspn(buffer, "\n")] = '\0';
+   if (!buffer[0] || String_eq(buffer, "0")) {
+      LinuxProcessTable_clearWchan(process);
+      return;
+   }
+
+   Row_updateFieldWidth(WCHAN, strlen(buffer));
+
+   LinuxProcessDetails* d = LinuxProcess_details(process);
+   if (d->wchan && String_eq(d->wchan, buffer)) {
       return;
    }
-   free_and_xStrdup(&process->secattr, buffer);
+   free_and_xStrdup(&d->wchan, buffer);
 }
 
 static void LinuxProcessTable_readCwd(LinuxProcess* process, openat_arg_t procFd) {
+   if (LinuxProcessTable_isDenied(process, LINUX_DENIED_CWD))
+      return;
+
    char pathBuffer[PATH_MAX + 1] = {0};
 
 #if defined(HAVE_READLINKAT) && defined(HAVE_OPENAT)
@@ -1001,6 +1483,7 @@ static void LinuxProcessTable_readCwd(LinuxProcess* process, openat_arg_t procFd
 #endif
 
    if (r < 0) {
+      LinuxProcessTable_noteDenied(process, LINUX_DENIED_CWD, errno);
       free(process->super.procCwd);
       process->super.procCwd = NULL;
       return;
@@ -1016,13 +1499,19 @@ static void LinuxProcessTable_readCwd(LinuxProcess* process, openat_arg_t procFd
 
 #ifdef HAVE_DELAYACCT
 
-static int handleNetlinkMsg(struct nl_msg* nlmsg, void* linuxProcess) {
+/* Share of the time spent waiting, from a total of nanoseconds delayed */
+static float LinuxProcessTable_delayPercent(Rate* rate, unsigned long long totalNs, uint64_t nowMs) {
+   const double percent = Rate_update(rate, totalNs, nowMs) / 1e7;
+   return isnan(percent) ? NAN : (float)MINIMUM(percent, 100.0);
+}
+
+static int handleNetlinkMsg(struct nl_msg* nlmsg, void* linuxProcessTable) {
    struct nlmsghdr* nlhdr;
    struct nlattr* nlattrs[TASKSTATS_TYPE_MAX + 1];
    const struct nlattr* nlattr;
    struct taskstats stats;
    int rem;
-   LinuxProcess* lp = (LinuxProcess*) linuxProcess;
+   const LinuxProcessTable* this = (const LinuxProcessTable*) linuxProcessTable;
 
    nlhdr = nlmsg_hdr(nlmsg);
 
@@ -1032,65 +1521,90 @@ static int handleNetlinkMsg(struct nl_msg* nlmsg, void* linuxProcess) {
 
    if ((nlattr = nlattrs[TASKSTATS_TYPE_AGGR_PID]) || (nlattr = nlattrs[TASKSTATS_TYPE_NULL])) {
       memcpy(&stats, nla_data(nla_next(nla_data(nlattr), &rem)), sizeof(stats));
-      assert(Process_getPid(&lp->super) == (pid_t)stats.ac_pid);
-
-      // The xxx_delay_total values wrap around on overflow.
-      // (Linux Kernel "Documentation/accounting/taskstats-struct.rst")
-      unsigned long long int timeDelta = stats.ac_etime * 1000 - lp->delay_read_time;
-      #define DELTAPERC(x, y) (timeDelta ? MINIMUM((float)((x) - (y)) / timeDelta * 100.0f, 100.0f) : NAN)
-      lp->cpu_delay_percent = DELTAPERC(stats.cpu_delay_total, lp->cpu_delay_total);
-      lp->blkio_delay_percent = DELTAPERC(stats.blkio_delay_total, lp->blkio_delay_total);
-      lp->swapin_delay_percent = DELTAPERC(stats.swapin_delay_total, lp->swapin_delay_total);
-      #undef DELTAPERC
-
-      lp->swapin_delay_total = stats.swapin_delay_total;
-      lp->blkio_delay_total = stats.blkio_delay_total;
-      lp->cpu_delay_total = stats.cpu_delay_total;
-      lp->delay_read_time = stats.ac_etime * 1000;
+      LinuxProcess* lp = (LinuxProcess*) Hashtable_get(this->super.super.table, (ht_key_t)stats.ac_pid);
+      if (!lp)
+         return NL_OK;
+
+      // Timed by the elapsed time of the task (ac_etime, in microseconds)
+      LinuxProcessDetails* d = LinuxProcess_details(lp);
+      const uint64_t nowMs = stats.ac_etime / 1000;
+      d->cpu_delay_percent = LinuxProcessTable_delayPercent(&d->cpu_delay_rate, stats.cpu_delay_total, nowMs);
+      d->blkio_delay_percent = LinuxProcessTable_delayPercent(&d->blkio_delay_rate, stats.blkio_delay_total, nowMs);
+      d->swapin_delay_percent = LinuxProcessTable_delayPercent(&d->swapin_delay_rate, stats.swapin_delay_total, nowMs);
    }
    return NL_OK;
 }
 
-static void LinuxProcessTable_readDelayAcctData(LinuxProcessTable* this, LinuxProcess* process) {
-   struct nl_msg* msg;
+/* Sends the queued taskstats requests, then reads the replies the kernel queued while answering them */
+static void LinuxProcessTable_flushDelayAcct(LinuxProcessTable* this) {
+   const size_t queued = this->delayAcctQueued;
+   if (!queued)
+      return;
 
-   if (!this->netlink_socket) {
-      LinuxProcessTable_initNetlinkSocket(this);
-      if (!this->netlink_socket) {
-         goto delayacct_failure;
-      }
-   }
+   this->delayAcctQueued = 0;
 
-   if (nl_socket_modify_cb(this->netlink_socket, NL_CB_VALID, NL_CB_CUSTOM, handleNetlinkMsg, process) < 0) {
-      goto delayacct_failure;
-   }
+   const ProfileMark mark = Profile_begin();
+   struct nl_sock* sock = this->netlink_socket;
 
-   if (! (msg = nlmsg_alloc())) {
-      goto delayacct_failure;
-   }
+   size_t sent = 0;
+   for (size_t i = 0; i < queued; i++) {
+      struct nl_msg* msg = nlmsg_alloc();
+      if (!msg)
+         break;
 
-   if (! genlmsg_put(msg, NL_AUTO_PID, NL_AUTO_SEQ, this->netlink_family, 0, NLM_F_REQUEST, TASKSTATS_CMD_GET, TASKSTATS_VERSION)) {
-      nlmsg_free(msg);
-   }
+      if (genlmsg_put(msg, NL_AUTO_PID, NL_AUTO_SEQ, this->netlink_family, 0, NLM_F_REQUEST, TASKSTATS_CMD_GET, TASKSTATS_VERSION) &&
+          nla_put_u32(msg, TASKSTATS_CMD_ATTR_PID, (uint32_t)this->delayAcctQueue[i]) == 0 &&
+          nl_send_auto(sock, msg) >= 0)
+         sent++;
 
-   if (nla_put_u32(msg, TASKSTATS_CMD_ATTR_PID, Process_getPid(&process->super)) < 0) {
       nlmsg_free(msg);
    }
 
-   if (nl_send_sync(this->netlink_socket, msg) < 0) {
-      goto delayacct_failure;
-   }
+   /* One reply or error per request; a reply dropped for lack of buffer space ends the reading */
+   struct nl_cb* cb = nl_socket_get_cb(sock);
+   for (size_t replies = 0, reads = 0; replies < sent && reads < 2 * sent; reads++) {
+      int r = nl_recvmsgs_report(sock, cb);
+      if (r == 0 || r == -NLE_AGAIN)
+         break;
+      if (r == -NLE_PERM)
+         this->delayAcctDenied = true;
 
-   if (nl_recvmsgs_default(this->netlink_socket) < 0) {
-      goto delayacct_failure;
+      replies += r > 0 ? (size_t)r : 1;
    }
+   nl_cb_put(cb);
 
-   return;
+   Profile_end(this->collectorPhase[LINUX_COLLECTOR_DELAYACCT], mark);
+}
+
+/*
+ * Queues the request for the taskstats of the process, its values are N/A
+ * until the reply is read. Returns false if taskstats cannot be asked for.
+ */
+static bool LinuxProcessTable_readDelayAcctData(LinuxProcessTable* this, LinuxProcess* process) {
+   LinuxProcessDetails* d = LinuxProcess_details(process);
+   d->swapin_delay_percent = NAN;
+   d->blkio_delay_percent = NAN;
+   d->cpu_delay_percent = NAN;
+
+   if (this->delayAcctDenied)
+      return false;
+
+   if (!this->netlink_socket) {
+      LinuxProcessTable_initNetlinkSocket(this);
+      if (!this->netlink_socket)
+         return false;
+
+      if (nl_socket_modify_cb(this->netlink_socket, NL_CB_VALID, NL_CB_CUSTOM, handleNetlinkMsg, this) < 0) {
+         nl_socket_free(this->netlink_socket);
+         this->netlink_socket = NULL;
+         return false;
+      }
+   }
 
-delayacct_failure:
-   process->swapin_delay_percent = NAN;
-   process->blkio_delay_percent = NAN;
-   process->cpu_delay_percent = NAN;
+   this->delayAcctQueue[this->delayAcctQueued++] = Process_getPid(&process->super);
+   if (this->delayAcctQueued == LINUX_DELAYACCT_WINDOW)
+      LinuxProcessTable_flushDelayAcct(this);
+   return true;
 }
 
 #endif
@@ -1101,37 +1615,49 @@ static bool LinuxProcessTable_readCmdlineFile(Process* process, openat_arg_t pro
    if (amtRead <= 0)
       return false;
 
+   /* The first argument ends at the first NUL or newline after its first character */
    int tokenEnd = 0;
-   int tokenStart = 0;
-   int lastChar = 0;
+   if (amtRead > 1) {
+      const char* nul = memchr(command + 1, '\0', (size_t)amtRead - 1);
+      const char* newline = memchr(command + 1, '\n', nul ? (size_t)(nul - command - 1) : (size_t)amtRead - 1);
+      const char* end = newline ? newline : nul;
+      tokenEnd = end ? (int)(end - command) : 0;
+   }
+
+   /* Record some information for the argument parsing heuristic below:
+    * whether anything but NULs follows the first argument, and if not,
+    * whether there are control characters or spaces instead. The NULs
+    * are found with memchr() rather than looking at every character. */
    bool argSepNUL = false;
+   if (tokenEnd) {
+      const char* end = command + amtRead;
+      int nulsAfterToken = 0;
+      for (const char* nul = memchr(command + tokenEnd + 1, '\0', (size_t)(end - command - tokenEnd - 1)); nul; nul = memchr(nul + 1, '\0', (size_t)(end - nul - 1)))
+         nulsAfterToken++;
+      argSepNUL = nulsAfterToken < amtRead - tokenEnd - 1;
+   }
+
    bool argSepSpace = false;
+   for (int i = 0; !argSepNUL && !argSepSpace && i < amtRead; i++)
+      argSepSpace = command[i] != '\0' && command[i] <= ' ';
 
-   for (int i = 0; i < amtRead; i++) {
-      /* newline used as delimiter - when forming the mergedCommand, newline is
-       * converted to space by Process_makeCommandStr */
-      if (command[i] == '\0') {
-         command[i] = '\n';
-      } else {
-         /* Record some information for the argument parsing heuristic below. */
-         if (tokenEnd)
-            argSepNUL = true;
-         if (command[i] <= ' ')
-            argSepSpace = true;
-      }
+   /* newline used as delimiter - when forming the mergedCommand, newline is
+    * converted to space by Process_makeCommandStr */
+   for (char* nul = memchr(command, '\0', (size_t)amtRead); nul; nul = memchr(nul + 1, '\0', (size_t)(command + amtRead - nul - 1)))
+      *nul = '\n';
 
-      if (command[i] == '\n') {
-         if (tokenEnd == 0) {
-            tokenEnd = i;
-         }
-      } else {
-         /* htop considers the next character after the last / that is before
-          * basenameOffset, as the start of the basename in cmdline - see
-          * Process_writeCommand */
-         if (!tokenEnd && command[i] == '/') {
-            tokenStart = i + 1;
-         }
-         lastChar = i;
+   int lastChar = amtRead - 1;
+   while (lastChar > 0 && command[lastChar] == '\n')
+      lastChar--;
+
+   /* htop considers the next character after the last / that is before
+    * basenameOffset, as the start of the basename in cmdline - see
+    * Process_writeCommand */
+   int tokenStart = 0;
+   for (int i = (tokenEnd ? tokenEnd : lastChar + 1) - 1; i >= 0; i--) {
+      if (command[i] == '/') {
+         tokenStart = i + 1;
+         break;
       }
    }
 
@@ -1231,11 +1757,18 @@ static bool LinuxProcessTable_readCmdlineFile(Process* process, openat_arg_t pro
    char filename[MAX_NAME + 1];
 
    /* execve could change /proc/[pid]/exe, so procExe should be updated */
+   LinuxProcess* lp = (LinuxProcess*) process;
+   if (LinuxProcessTable_isDenied(lp, LINUX_DENIED_EXE)) {
+      amtRead = -1;
+   } else {
 #if defined(HAVE_READLINKAT) && defined(HAVE_OPENAT)
-   amtRead = readlinkat(procFd, "exe", filename, sizeof(filename) - 1);
+      amtRead = readlinkat(procFd, "exe", filename, sizeof(filename) - 1);
 #else
-   amtRead = Compat_readlink(procFd, "exe", filename, sizeof(filename) - 1);
+      amtRead = Compat_readlink(procFd, "exe", filename, sizeof(filename) - 1);
 #endif
+      if (amtRead < 0)
+         LinuxProcessTable_noteDenied(lp, LINUX_DENIED_EXE, errno);
+   }
    if (amtRead > 0) {
       filename[amtRead] = 0;
       if (!process->procExe ||
@@ -1268,6 +1801,67 @@ static bool LinuxProcessTable_readCmdlineFile(Process* process, openat_arg_t pro
    return true;
 }
 
+static void LinuxProcessTable_copyString(char** dest, const char* src) {
+   if (src) {
+      free_and_xStrdup(dest, src);
+   } else {
+      free(*dest);
+      *dest = NULL;
+   }
+}
+
+/* Threads share the address space, so statm of the process applies to them */
+static void LinuxProcessTable_inheritMemory(LinuxProcess* lp, const LinuxProcess* parent) {
+   lp->super.m_virt = parent->super.m_virt;
+   lp->super.m_resident = parent->super.m_resident;
+   lp->m_share = parent->m_share;
+   lp->m_trs = parent->m_trs;
+   lp->m_drs = parent->m_drs;
+   lp->m_priv = parent->m_priv;
+}
+
+/* Takes over the values of the process that are the same for all of its threads */
+static void LinuxProcessTable_inheritFromProcess(LinuxProcess* lp, const LinuxProcess* parent, uint64_t flags, const char* statCommand) {
+   Process* proc = &lp->super;
+   const Process* pproc = &parent->super;
+
+   if (proc->st_uid != pproc->st_uid || !proc->user) {
+      proc->st_uid = pproc->st_uid;
+      proc->user = pproc->user;
+   }
+   proc->isRunningInContainer = pproc->isRunningInContainer;
+   proc->elevated_priv = pproc->elevated_priv;
+
+   if (!proc->isKernelThread) {
+      Process_updateCmdline(proc, pproc->cmdline, pproc->cmdlineBasenameStart, pproc->cmdlineBasenameEnd);
+      Process_updateComm(proc, statCommand[0] ? statCommand : pproc->procComm);
+      if (proc->procExeDeleted != pproc->procExeDeleted) {
+         proc->procExeDeleted = pproc->procExeDeleted;
+         proc->mergedCommand.lastUpdate = 0;
+      }
+      Process_updateExe(proc, pproc->procExe);
+   }
+
+   if (flags & PROCESS_FLAG_LINUX_CGROUP) {
+      if (lp->cgroup != parent->cgroup) {
+         CGroupName_release(lp->cgroup);
+         lp->cgroup = CGroupName_ref(parent->cgroup);
+      }
+      lp->collectedMs[LINUX_COLLECTOR_CGROUP] = parent->collectedMs[LINUX_COLLECTOR_CGROUP];
+   }
+   if ((flags & PROCESS_FLAG_LINUX_SECATTR) && (lp->details || parent->details))
+      LinuxProcessTable_copyString(&LinuxProcess_details(lp)->secattr, LinuxProcess_getDetails(parent)->secattr);
+   if (flags & PROCESS_FLAG_CWD)
+      LinuxProcessTable_copyString(&proc->procCwd, pproc->procCwd);
+   if (flags & PROCESS_FLAG_LINUX_OOM)
+      lp->oom = parent->oom;
+   if ((flags & PROCESS_FLAG_LINUX_AUTOGROUP) && (lp->details || parent->details)) {
+      LinuxProcessDetails* d = LinuxProcess_details(lp);
+      d->autogroup_id = LinuxProcess_getDetails(parent)->autogroup_id;
+      d->autogroup_nice = LinuxProcess_getDetails(parent)->autogroup_nice;
+   }
+}
+
 static char* LinuxProcessTable_updateTtyDevice(TtyDriver* ttyDrivers, unsigned long int tty_nr) {
    unsigned int maj = major(tty_nr);
    unsigned int min = minor(tty_nr);
@@ -1338,306 +1932,1934 @@ static bool isOlderThan(const Process* proc, unsigned int seconds) {
    return realtime - proc->starttime_ctime > seconds;
 }
 
-static bool LinuxProcessTable_recurseProcTree(LinuxProcessTable* this, openat_arg_t parentFd, const LinuxMachine* lhost, const char* dirname, const Process* parent) {
-   ProcessTable* pt = (ProcessTable*) this;
-   const Machine* host = &lhost->super;
-   const Settings* settings = host->settings;
-   const ScreenSettings* ss = settings->ss;
-   const struct dirent* entry;
+typedef struct LinuxCollectorPolicy_ {
+   unsigned int budget;       /* reads per scan, rows on screen do not count against it */
+   uint64_t minAgeMs;         /* never refresh more often than this */
+   uint64_t maxAgeMs;         /* refresh unchanged processes once the value is this old */
+} LinuxCollectorPolicy;
 
-   /* set runningTasks from /proc/stat (from Machine_scanCPUTime) */
-   pt->runningTasks = lhost->runningTasks;
+static const LinuxCollectorPolicy LinuxProcessTable_collectorPolicies[LINUX_COLLECTOR_COUNT] = {
+   [LINUX_COLLECTOR_SMAPS]     = { .budget = 256,  .minAgeMs = 2000, .maxAgeMs = 10000, },
+   [LINUX_COLLECTOR_MAPS]      = { .budget = 256,  .minAgeMs = 2000, .maxAgeMs = 10000, },
+   [LINUX_COLLECTOR_CGROUP]    = { .budget = 1024, .minAgeMs = 1000, .maxAgeMs = 5000, },
+   [LINUX_COLLECTOR_DELAYACCT] = { .budget = 1024, .minAgeMs = 0,    .maxAgeMs = 5000, },
+   [LINUX_COLLECTOR_NUMA]      = { .budget = 64,   .minAgeMs = 2000, .maxAgeMs = 10000, },
+   [LINUX_COLLECTOR_GPU]       = { .budget = 128,  .minAgeMs = 2000, .maxAgeMs = 10000, },
+   [LINUX_COLLECTOR_FDS]       = { .budget = 256,  .minAgeMs = 1000, .maxAgeMs = 10000, },
+   [LINUX_COLLECTOR_IDLE]      = { .budget = 512,  .minAgeMs = 0,    .maxAgeMs = 30000, },
+};
 
-#ifdef HAVE_OPENAT
-   int dirFd = openat(parentFd, dirname, O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
-   if (dirFd < 0)
-      return false;
-   DIR* dir = fdopendir(dirFd);
-#else
-   char dirFd[4096];
-   xSnprintf(dirFd, sizeof(dirFd), "%s/%s", parentFd, dirname);
-   DIR* dir = opendir(dirFd);
-#endif
-   if (!dir) {
-      Compat_openatArgClose(dirFd);
-      return false;
-   }
+/* Collectors costing at least one syscall per process that only feed display columns */
+#define LINUX_LAZY_FLAGS (PROCESS_FLAG_IO | PROCESS_FLAG_CWD | PROCESS_FLAG_SCHEDPOL | PROCESS_FLAG_LINUX_IOPRIO | PROCESS_FLAG_LINUX_OOM | PROCESS_FLAG_LINUX_SECATTR | PROCESS_FLAG_LINUX_AUTOGROUP | PROCESS_FLAG_LINUX_DELAYACCT | PROCESS_FLAG_LINUX_SCHEDSTAT | PROCESS_FLAG_LINUX_WCHAN)
 
-   const bool hideKernelThreads = settings->hideKernelThreads;
-   const bool hideUserlandThreads = settings->hideUserlandThreads;
-   const bool hideRunningInContainer = settings->hideRunningInContainer;
-   while ((entry = readdir(dir)) != NULL) {
-      const char* name = entry->d_name;
+/* Columns read from the same smaps_rollup (or smaps) file */
+#define LINUX_SMAPS_FLAGS (PROCESS_FLAG_LINUX_SMAPS | PROCESS_FLAG_LINUX_THP)
 
-      // Ignore all non-directories
-      if (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) {
-         continue;
-      }
+/* Collectors skipped while saving power on battery, their columns keep the last values read */
+#define LINUX_BATTERY_FLAGS (LINUX_SMAPS_FLAGS | PROCESS_FLAG_LINUX_LRS_FIX | PROCESS_FLAG_LINUX_DELAYACCT)
 
-      // The RedHat kernel hides threads with a dot.
-      // I believe this is non-standard.
-      if (name[0] == '.') {
-         name++;
-      }
+/* Collectors whose values differ between the threads of a process */
+#define LINUX_THREAD_FLAGS (PROCESS_FLAG_IO | PROCESS_FLAG_SCHEDPOL | PROCESS_FLAG_LINUX_IOPRIO | PROCESS_FLAG_LINUX_CTXT | PROCESS_FLAG_LINUX_DELAYACCT | PROCESS_FLAG_LINUX_SCHEDSTAT | PROCESS_FLAG_LINUX_WCHAN | PROCESS_FLAG_LINUX_MIGRATE)
 
-      // Just skip all non-number directories.
-      if (name[0] < '0' || name[0] > '9') {
-         continue;
-      }
+/*
+ * With lazy collection the display-only collectors run just for rows on
+ * screen; whatever the table is sorted by is still read for all processes.
+ */
+static void LinuxProcessTable_updateLazyFlags(LinuxProcessTable* this, const Settings* settings) {
+   const RowField sortKey = ScreenSettings_getActiveSortKey(settings->ss);
+   this->sortFlags = (sortKey > 0 && sortKey < LAST_PROCESSFIELD) ? Process_fields[sortKey].flags : 0;
+
+   this->lazyFlags = 0;
+   if (!settings->lazyCollection)
+      return;
 
-      // filename is a number: process directory
-      int pid;
-      {
-         char* endptr;
-         unsigned long parsedPid = strtoul(name, &endptr, 10);
-         if (parsedPid == 0 || parsedPid == ULONG_MAX || *endptr != '\0')
-            continue;
-         pid = parsedPid;
-      }
+   this->lazyFlags = LINUX_LAZY_FLAGS & ~this->sortFlags;
+}
 
-      // Skip task directory of main thread
-      if (parent && pid == Process_getPid(parent))
-         continue;
+/* Interval at which the columns of the other process screens are read */
+#define LINUX_WARM_INTERVAL_MS 5000
 
-#ifdef HAVE_OPENAT
-      int procFd = openat(dirFd, entry->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
-      if (procFd < 0)
-         continue;
-#else
-      char procFd[4096];
-      xSnprintf(procFd, sizeof(procFd), "%s/%s", dirFd, entry->d_name);
-#endif
+/* Scans between rereads of the command line of a process whose comm did not change, a power of two */
+#define LINUX_CMDLINE_ROUNDS 4
 
-      bool preExisting;
-      Process* proc = ProcessTable_getProcess(pt, pid, &preExisting, LinuxProcess_new);
-      LinuxProcess* lp = (LinuxProcess*) proc;
+static uint64_t LinuxProcessTable_otherScreensFlags(const Settings* settings, const Table* processTable) {
+   uint64_t flags = 0;
+   for (unsigned int i = 0; i < settings->nScreens; i++) {
+      const ScreenSettings* ss = settings->screens[i];
+      if (ss != settings->ss && (!ss->table || ss->table == processTable))
+         flags |= ss->flags;
+   }
+   return flags;
+}
 
-      Process_setThreadGroup(proc, parent ? Process_getPid(parent) : pid);
-      proc->isUserlandThread = Process_getPid(proc) != Process_getThreadGroup(proc);
+#ifdef HAVE_BPF_COLUMNS
+/* The BPF sources read by the columns, each with a flag of its own */
+static unsigned int LinuxProcessTable_bpfSources(uint64_t flags) {
+   unsigned int sources = 0;
+   if (flags & PROCESS_FLAG_LINUX_BPF_NET)
+      sources |= BPF_SOURCE_BIT(BPF_SOURCE_NET);
+   if (flags & PROCESS_FLAG_LINUX_BPF_FUTEX)
+      sources |= BPF_SOURCE_BIT(BPF_SOURCE_FUTEX);
+   if (flags & PROCESS_FLAG_LINUX_BPF_SYSCALLS)
+      sources |= BPF_SOURCE_BIT(BPF_SOURCE_SYSCALLS);
+   return sources;
+}
+#endif
 
-      LinuxProcessTable_recurseProcTree(this, procFd, lhost, "task", proc);
+static void LinuxProcessTable_resetCollectorBudgets(LinuxProcessTable* this) {
+   for (size_t i = 0; i < LINUX_COLLECTOR_COUNT; i++)
+      this->collectorBudget[i] = LinuxProcessTable_collectorPolicies[i].budget;
+}
 
-      /*
-       * These conditions will not trigger on first occurrence, cause we need to
-       * add the process to the ProcessTable and do all one time scans
-       * (e.g. parsing the cmdline to detect a kernel thread)
-       * But it will short-circuit subsequent scans.
-       */
-      if (preExisting && hideKernelThreads && Process_isKernelThread(proc)) {
-         proc->super.updated = true;
-         proc->super.show = false;
-         pt->kernelThreads++;
-         pt->totalTasks++;
-         Compat_openatArgClose(procFd);
-         continue;
-      }
-      if (preExisting && hideUserlandThreads && Process_isUserlandThread(proc)) {
-         proc->super.updated = true;
-         proc->super.show = false;
-         pt->userlandThreads++;
-         pt->totalTasks++;
-         Compat_openatArgClose(procFd);
-         continue;
-      }
-      if (preExisting && hideRunningInContainer && proc->isRunningInContainer) {
-         proc->super.updated = true;
-         proc->super.show = false;
-         Compat_openatArgClose(procFd);
-         continue;
-      }
+/*
+ * Decides whether an expensive value of the process is read in this scan.
+ * Rows on screen are always refreshed, other processes only while budget
+ * is left: first the ones that changed since the last scan, unchanged ones
+ * once their value got older than maxAgeMs. As processes refreshed in this
+ * scan wait at least minAgeMs, the budget rotates through all processes.
+ */
+static bool LinuxProcessTable_shouldCollect(LinuxProcessTable* this, const LinuxProcess* lp, LinuxCollector which, bool changed) {
+   const Machine* host = this->super.super.host;
+   const LinuxCollectorPolicy* policy = &LinuxProcessTable_collectorPolicies[which];
+   const uint64_t last = lp->collectedMs[which];
+   const uint64_t age = last ? host->monotonicMs - last : UINT64_MAX;
+
+   if (age < policy->minAgeMs)
+      return false;
 
-      bool scanMainThread = !hideUserlandThreads && !Process_isKernelThread(proc) && !parent;
-      if (ss->flags & PROCESS_FLAG_IO)
-         LinuxProcessTable_readIoFile(lp, procFd, scanMainThread);
+   if (Table_isRowOnScreen(&this->super.super, &lp->super.super))
+      return true;
 
-      if (!LinuxProcessTable_readStatmFile(lp, procFd, lhost))
-         goto errorReadingProcess;
+   if (!changed && age < policy->maxAgeMs)
+      return false;
 
-      {
-         bool prev = proc->usesDeletedLib;
+   if (this->collectorBudget[which] == 0)
+      return false;
 
-         if (!proc->isKernelThread && !proc->isUserlandThread &&
-             ((ss->flags & PROCESS_FLAG_LINUX_LRS_FIX) || (settings->highlightDeletedExe && !proc->procExeDeleted && isOlderThan(proc, 10)))) {
+   this->collectorBudget[which]--;
+   return true;
+}
 
-            // Check if we really should recalculate the M_LRS value for this process
-            uint64_t passedTimeInMs = host->realtimeMs - lp->last_mlrs_calctime;
+static inline void LinuxProcessTable_collected(LinuxProcess* lp, LinuxCollector which) {
+   lp->collectedMs[which] = lp->super.super.host->monotonicMs;
+}
 
-            uint64_t recheck = ((uint64_t)rand()) % 2048;
+static bool LinuxProcessTable_recurseProcTree(LinuxProcessTable* this, openat_arg_t parentFd, const LinuxMachine* lhost, const char* dirname, const Process* parent);
 
-            if (passedTimeInMs > recheck) {
-               lp->last_mlrs_calctime = host->realtimeMs;
-               LinuxProcessTable_readMaps(lp, procFd, lhost, ss->flags & PROCESS_FLAG_LINUX_LRS_FIX, settings->highlightDeletedExe);
-            }
-         } else {
-            /* Copy from process structure in threads and reset if setting got disabled */
-            proc->usesDeletedLib = (proc->isUserlandThread && parent) ? parent->usesDeletedLib : false;
-            lp->m_lrs = (proc->isUserlandThread && parent) ? ((const LinuxProcess*)parent)->m_lrs : 0;
-         }
+/* Whether the process in directory entry `entryName` belongs to another user than the only one shown */
+static bool LinuxProcessTable_isOtherUser(const Machine* host, openat_arg_t dirFd, const char* entryName) {
+   if (host->userId == (uid_t)-1)
+      return false;
 
-         if (prev != proc->usesDeletedLib)
-            proc->mergedCommand.lastUpdate = 0;
-      }
+   struct stat sstat;
+#ifdef HAVE_OPENAT
+   int statok = fstatat(dirFd, entryName, &sstat, 0);
+#else
+   char path[4096];
+   xSnprintf(path, sizeof(path), "%s/%s", dirFd, entryName);
+   int statok = stat(path, &sstat);
+#endif
+   if (statok == -1 || sstat.st_uid == host->userId)
+      return false;
 
-      if ((ss->flags & PROCESS_FLAG_LINUX_SMAPS) && !Process_isKernelThread(proc)) {
-         if (!parent) {
-            // Read smaps file of each process only every second pass to improve performance
-            static int smaps_flag = 0;
-            if ((pid & 1) == smaps_flag) {
-               LinuxProcessTable_readSmapsFile(lp, procFd, this->haveSmapsRollup);
-            }
-            if (pid == 1) {
-               smaps_flag = !smaps_flag;
-            }
-         } else {
-            lp->m_pss = ((const LinuxProcess*)parent)->m_pss;
-         }
-      }
+   /* the user can still be picked to show instead */
+   UsersTable_getRef(host->usersTable, sstat.st_uid);
+   return true;
+}
 
-      char statCommand[MAX_NAME + 1];
-      unsigned long long int lasttimes = (lp->utime + lp->stime);
-      unsigned long int tty_nr = proc->tty_nr;
-      if (!LinuxProcessTable_readStatFile(lp, procFd, lhost, scanMainThread, statCommand, sizeof(statCommand)))
-         goto errorReadingProcess;
+/* Adds a process read in this scan to the totals of its user, threads are counted by their process */
+static void LinuxProcessTable_addUserTotals(LinuxProcessTable* this, const LinuxProcess* lp) {
+   const Process* proc = &lp->super;
+   if (Process_isKernelThread(proc) || Process_isUserlandThread(proc))
+      return;
 
-      if (lp->flags & PF_KTHREAD) {
-         proc->isKernelThread = true;
-      }
+   UserTotals* totals = UserTotalsList_get(&this->userTotals, proc->st_uid);
+   const LinuxProcessDetails* d = LinuxProcess_getDetails(lp);
+
+   totals->processes++;
+   totals->tasks += proc->nlwp > 0 ? (unsigned int)proc->nlwp : 1;
+   if (isNonnegative(proc->percent_cpu))
+      totals->percentCpu += proc->percent_cpu;
+   totals->resident += (unsigned long long)MAXIMUM(proc->m_resident, 0L);
+   totals->pss += (unsigned long long)MAXIMUM(d->m_pss, 0L);
+   const double readRate = Rate_value(&d->io_read_rate);
+   const double writeRate = Rate_value(&d->io_write_rate);
+   if (isNonnegative(readRate))
+      totals->ioReadRate += readRate;
+   if (isNonnegative(writeRate))
+      totals->ioWriteRate += writeRate;
+}
 
-      if (tty_nr != proc->tty_nr && this->ttyDrivers) {
-         free(proc->tty_name);
-         proc->tty_name = LinuxProcessTable_updateTtyDevice(this->ttyDrivers, proc->tty_nr);
+/*
+ * Counts the CPU changes of the task between scans: a sample, as the stat
+ * file only has the CPU last run on, so at most one per update is seen.
+ * The involuntary context switches only change when status was read, and
+ * not for idle tasks, which were not preempted either.
+ */
+#ifdef HAVE_BPF_COLUMNS
+/*
+ * Takes the call of the histogram that grew the most since the last read as
+ * the top one. A slot taken over by another call in between keeps counting
+ * from where the one before left it, so its growth still counts that call.
+ */
+static void LinuxProcessTable_updateSyscalls(LinuxProcessDetails* d, const BpfSyscallsCounts* counts, uint64_t monotonicMs) {
+   const BpfSyscallsCounts* last = &d->syscall_counts;
+   const bool known = d->syscall_rate.lastMs && counts->total > last->total;
+
+   d->top_syscall_percent = 0.0F;
+   if (known) {
+      uint64_t most = 0;
+      for (size_t i = 0; i < BPF_SYSCALLS_TOP; i++) {
+         const uint64_t calls = counts->count[i] >= last->count[i] ? counts->count[i] - last->count[i] : counts->count[i];
+         if (calls > most) {
+            most = calls;
+            d->top_syscall = counts->nr[i];
+         }
       }
 
-      if (ss->flags & PROCESS_FLAG_LINUX_IOPRIO) {
-         LinuxProcess_updateIOPriority(proc);
-      }
+      const uint64_t total = counts->total - last->total;
+      if (most > 0)
+         d->top_syscall_percent = (float)(100.0 * (double)MINIMUM(most, total) / (double)total);
+   }
 
-      proc->percent_cpu = NAN;
-      /* lhost->period might be 0 after system sleep */
-      if (lhost->period > 0.0) {
-         float percent_cpu = saturatingSub(lp->utime + lp->stime, lasttimes) / lhost->period * 100.0;
-         proc->percent_cpu = MINIMUM(percent_cpu, host->activeCPUs * 100.0F);
-      }
-      proc->percent_mem = proc->m_resident / (double)(host->totalMem) * 100.0;
-      Process_updateCPUFieldWidths(proc->percent_cpu);
+   Rate_update(&d->syscall_rate, counts->total, monotonicMs);
+   d->syscall_counts = *counts;
+}
+#endif
 
-      if (!LinuxProcessTable_updateUser(host, proc, procFd))
-         goto errorReadingProcess;
+static void LinuxProcessTable_updateMigrations(LinuxProcess* lp, bool statusRead, uint64_t monotonicMs) {
+   const Process* proc = &lp->super;
+   LinuxProcessDetails* d = LinuxProcess_details(lp);
 
-      if (!LinuxProcessTable_readStatusFile(proc, procFd))
-         goto errorReadingProcess;
+   if (d->migration_rate.lastMs && proc->processor != d->lastProcessor)
+      d->migrations++;
+   d->lastProcessor = proc->processor;
+   Rate_update(&d->migration_rate, d->migrations, monotonicMs);
 
-      if (!preExisting) {
+   if (statusRead || d->nvcsw_rate.lastMs)
+      Rate_update(&d->nvcsw_rate, lp->nvcsw_total, monotonicMs);
+}
 
-         #ifdef HAVE_OPENVZ
-         if (ss->flags & PROCESS_FLAG_LINUX_OPENVZ) {
-            LinuxProcessTable_readOpenVZData(lp, procFd);
-         }
-         #endif
+/* Counts a task sleeping in this scan under its wait channel, threads on their own */
+static void LinuxProcessTable_addWaitChannel(LinuxProcessTable* this, const LinuxProcess* lp) {
+   const Process* proc = &lp->super;
+   const char* wchan = LinuxProcess_getDetails(lp)->wchan;
+   if (!this->waitChannelsShown || !wchan || (proc->state != UNINTERRUPTIBLE_WAIT && proc->state != SLEEPING))
+      return;
 
-         if (proc->isKernelThread) {
-            Process_updateCmdline(proc, NULL, 0, 0);
-         } else if (!LinuxProcessTable_readCmdlineFile(proc, procFd)) {
-            Process_updateCmdline(proc, statCommand, 0, strlen(statCommand));
-         }
+   const char* command = proc->procComm ? proc->procComm : Process_getCommand(proc);
+   WaitChannelList_add(&this->waitChannels, wchan, proc->state == UNINTERRUPTIBLE_WAIT, Process_getPid(proc), command);
+}
 
-         Process_fillStarttimeBuffer(proc);
+/* Whether only the processes given with --pid or --cgroup or those of one user are scanned */
+static inline bool LinuxProcessTable_isFiltered(const ProcessTable* pt) {
+   return pt->pidMatchList || CGroupScope_path || pt->super.host->userId != (uid_t)-1;
+}
 
-         ProcessTable_add(pt, proc);
-      } else {
-         if (settings->updateProcessNames && proc->state != ZOMBIE) {
-            if (proc->isKernelThread) {
-               Process_updateCmdline(proc, NULL, 0, 0);
-            } else if (!LinuxProcessTable_readCmdlineFile(proc, procFd)) {
-               Process_updateCmdline(proc, statCommand, 0, strlen(statCommand));
-            }
-         }
+#ifdef HAVE_PERF_EVENTS
+/*
+ * Hardware counters are opened for rows on screen (or every process of a
+ * filtered view) and closed as soon as the row scrolls away, so the groups
+ * the budget of PerfCounters_open() allows follow what is looked at.
+ */
+static void LinuxProcessTable_updatePerfCounters(LinuxProcess* lp, bool wanted) {
+   if (!wanted) {
+      if (lp->details && lp->details->perf) {
+         PerfCounters_close(lp->details->perf);
+         lp->details->perf = NULL;
       }
+      return;
+   }
 
-      if (ss->flags & PROCESS_FLAG_LINUX_CGROUP)
-         LinuxProcessTable_readCGroupFile(lp, procFd);
-
-      #ifdef HAVE_DELAYACCT
-      if (ss->flags & PROCESS_FLAG_LINUX_DELAYACCT) {
-         LinuxProcessTable_readDelayAcctData(this, lp);
-      }
-      #endif
+   if (!PerfCounters_isSupported())
+      return;
 
-      if (ss->flags & PROCESS_FLAG_LINUX_OOM) {
-         LinuxProcessTable_readOomData(lp, procFd);
-      }
+   LinuxProcessDetails* d = LinuxProcess_details(lp);
+   if (!d->perf && !d->perfDenied) {
+      d->perf = PerfCounters_open(Process_getPid(&lp->super));
+      /* the task may not be watched, unlike a full budget this does not go away */
+      if (!d->perf && (errno == EACCES || errno == EPERM))
+         d->perfDenied = true;
+   }
 
-      if (ss->flags & PROCESS_FLAG_LINUX_SECATTR) {
-         LinuxProcessTable_readSecattrData(lp, procFd);
+   if (d->perf && !PerfCounters_read(d->perf, lp->super.super.host->monotonicMs, &d->perfRates)) {
+      PerfCounters_close(d->perf);
+      d->perf = NULL;
+   }
+}
+#endif
+
+/*
+ * Updates the process or thread in directory entry `entryName` of `dirFd`.
+ * If `prefetch` is given, its (already read) thread list and file contents
+ * are used instead of reading them from /proc again.
+ */
+static void LinuxProcessTable_updateProcess(LinuxProcessTable* this, openat_arg_t dirFd, const LinuxMachine* lhost, const char* entryName, int pid, const Process* parent, const ProcScanItem* prefetch) {
+   ProcessTable* pt = (ProcessTable*) this;
+   const Machine* host = &lhost->super;
+   const Settings* settings = host->settings;
+   const uint64_t screenFlags = (settings->ss->flags | this->tableFlags | this->warmFlags) & ~(Budget_onBattery ? LINUX_BATTERY_FLAGS : 0);
+
+   const bool hideKernelThreads = settings->hideKernelThreads;
+   const bool hideUserlandThreads = settings->hideUserlandThreads;
+   const bool hideRunningInContainer = settings->hideRunningInContainer;
+
+   /* Processes filtered out by user are not read at all, their rows go away */
+   if (!parent && LinuxProcessTable_isOtherUser(host, dirFd, entryName)) {
+      pt->totalTasks++;
+      return;
+   }
+
+   bool preExisting;
+   Process* proc = ProcessTable_getProcess(pt, pid, &preExisting, LinuxProcess_new);
+   LinuxProcess* lp = (LinuxProcess*) proc;
+
+   /* Rows get on screen only after the scan, new processes are filled in by the next one */
+   const bool onScreen = Table_isRowOnScreen(&pt->super, &proc->super);
+   uint64_t flags = screenFlags;
+   if (!onScreen)
+      flags &= ~(this->lazyFlags & ~this->warmFlags);
+
+   /*
+    * Threads read their stat file, per-thread columns only if on screen (or
+    * on the CPU occupancy screen), the rest comes from the process. The sort
+    * column is read for all of them, for threads off screen to be sorted in.
+    */
+   if (parent)
+      flags &= (onScreen ? LINUX_THREAD_FLAGS : (this->tableFlags & PROCESS_FLAG_LINUX_MIGRATE)) | this->sortFlags;
+
+#ifdef HAVE_OPENAT
+   bool cachedFd = lp->procFd >= 0;
+   bool pidReused = false;
+   int procFd = LinuxProcessTable_getProcFd(this, lp, dirFd, entryName);
+   if (procFd < 0) {
+      if (!preExisting)
+         Process_delete((Object*)proc);
+      return;
+   }
+#else
+   const bool pidReused = false;
+   char procFd[4096];
+   xSnprintf(procFd, sizeof(procFd), "%s/%s", dirFd, entryName);
+#endif
+
+   Process_setThreadGroup(proc, parent ? Process_getPid(parent) : pid);
+   proc->isUserlandThread = Process_getPid(proc) != Process_getThreadGroup(proc);
+
+   /*
+    * These conditions will not trigger on first occurrence, cause we need to
+    * add the process to the ProcessTable and do all one time scans
+    * (e.g. parsing the cmdline to detect a kernel thread)
+    * But it will short-circuit subsequent scans.
+    */
+   if (preExisting && hideKernelThreads && Process_isKernelThread(proc)) {
+      Table_markUpdated(&pt->super, &proc->super);
+      proc->super.show = false;
+      pt->kernelThreads++;
+      pt->totalTasks++;
+      LinuxProcessTable_putProcFd(lp, procFd);
+      return;
+   }
+   if (preExisting && hideRunningInContainer && proc->isRunningInContainer) {
+      Table_markUpdated(&pt->super, &proc->super);
+      proc->super.show = false;
+      /* task/ is not walked, its threads are counted from the last stat */
+      if (!parent && proc->nlwp > 1) {
+         pt->userlandThreads += proc->nlwp - 1;
+         pt->totalTasks += proc->nlwp - 1;
       }
+      pt->totalTasks++;
+      LinuxProcessTable_putProcFd(lp, procFd);
+      return;
+   }
+
+   bool scanMainThread = !hideUserlandThreads && !Process_isKernelThread(proc) && !parent;
+   bool usePrefetch = prefetch && prefetch->prefetched;
+
+   /* The values of the last scan, before any file is read again */
+   const unsigned long long int lasttimes = lp->utime + lp->stime;
+   const unsigned long long int lastMajflt = proc->majflt;
+   const ProcessState lastState = proc->state;
+   const long prevResident = proc->m_resident;
+   const long prevVirt = proc->m_virt;
+   const long prevStatRss = lp->m_stat_rss;
+#ifdef HAVE_OPENAT
+   const time_t lastStarttime = proc->starttime_ctime;
+#endif
+   const unsigned long int tty_nr = proc->tty_nr;
+
+   char statCommand[MAX_NAME + 1];
+
+   /* A new kernel thread that is hidden is told apart by the flags of its stat file, nothing else is read */
+   if (!preExisting && hideKernelThreads && !parent && !usePrefetch) {
+      char comm[MAX_NAME + 1];
+      if (!LinuxProcessTable_readStatFile(lp, procFd, lhost, false, comm, sizeof(comm)))
+         goto errorReadingProcess;
+
+      if (lp->flags & PF_KTHREAD) {
+         proc->isKernelThread = true;
+         Process_updateCmdline(proc, comm[0] ? comm : NULL, 0, comm[0] ? (int)strlen(comm) : 0);
+         Process_fillStarttimeBuffer(proc);
+         ProcessTable_add(pt, proc);
+
+         Table_markUpdated(&pt->super, &proc->super);
+         proc->super.show = false;
+         pt->kernelThreads++;
+         pt->totalTasks++;
+         LinuxProcessTable_putProcFd(lp, procFd);
+         return;
+      }
+   }
+
+#ifdef HAVE_OPENAT
+retry:
+#endif
+   if (usePrefetch) {
+      if (!prefetch->stat || !LinuxProcessTable_parseStatFile(lp, prefetch->stat, lhost, statCommand, sizeof(statCommand)))
+         goto errorReadingProcess;
+   } else if (!LinuxProcessTable_readStatFile(lp, procFd, lhost, scanMainThread, statCommand, sizeof(statCommand))) {
+      goto errorReadingProcess;
+   }
+
+   if (lp->flags & PF_KTHREAD) {
+      proc->isKernelThread = true;
+   }
+
+#ifdef HAVE_OPENAT
+   /* A different task behind the same PID: refresh the one time data as well */
+   if (pidReused && lastStarttime != proc->starttime_ctime) {
+      proc->mergedCommand.lastUpdate = 0;
+      memset(lp->collectedMs, 0, sizeof(lp->collectedMs));
+      lp->runtimeAtNs = 0;
+      lp->denied = 0;
+   } else {
+      pidReused = false;
+   }
+#endif
+
+   /* schedstat of a process covers its main thread only, as does its stat while threads are listed */
+   const char* schedstat = NULL;
+   char schedstatBuffer[PROC_PID_SCHEDSTAT_BUFSIZE];
+   float runtimePercent = NAN;
+   if (settings->preciseCpu && (parent || scanMainThread || proc->nlwp <= 1)) {
+      uint64_t atNs;
+      if (usePrefetch) {
+         schedstat = prefetch->schedstat;
+         atNs = prefetch->readNs;
+      } else {
+         if (xReadfileat(procFd, "schedstat", schedstatBuffer, sizeof(schedstatBuffer)) > 0)
+            schedstat = schedstatBuffer;
+         atNs = LinuxProcessTable_monotonicNs();
+      }
+      runtimePercent = LinuxProcessTable_runtimePercent(lp, schedstat, atNs);
+   }
+
+   /*
+    * A process that did not run since the last scan keeps the values of the
+    * files besides stat; they are read again on a slow rotation, and always
+    * for rows on screen.
+    */
+   const bool statChanged = !preExisting || pidReused ||
+                            lp->utime + lp->stime != lasttimes ||
+                            proc->majflt != lastMajflt ||
+                            proc->state != lastState ||
+                            lp->m_stat_rss != prevStatRss;
+   const bool idle = !statChanged && !LinuxProcessTable_shouldCollect(this, lp, LINUX_COLLECTOR_IDLE, false);
+   if (!idle)
+      LinuxProcessTable_collected(lp, LINUX_COLLECTOR_IDLE);
+
+   /* Workers read just the stat file of threads */
+   bool prefetchedIo = usePrefetch && !parent && (screenFlags & PROCESS_FLAG_IO);
+   if ((flags & PROCESS_FLAG_IO) || prefetchedIo) {
+      if (idle)
+         LinuxProcessTable_idleIo(lp);
+      else if (prefetchedIo)
+         LinuxProcessTable_parsePrefetchedIo(lp, prefetch);
+      else
+         LinuxProcessTable_readIoFile(lp, procFd, scanMainThread);
+   }
+
+   if (parent) {
+      LinuxProcessTable_inheritMemory(lp, (const LinuxProcess*) parent);
+   } else if (idle) {
+      /* the memory use is left as it was */
+   } else if (usePrefetch) {
+      if (!prefetch->statm || !LinuxProcessTable_parseStatmFile(lp, prefetch->statm, lhost))
+         goto errorReadingProcess;
+   } else if (!LinuxProcessTable_readStatmFile(lp, procFd, lhost)) {
+      goto errorReadingProcess;
+   }
+
+   const bool memChanged = !preExisting || proc->m_resident != prevResident || proc->m_virt != prevVirt;
+
+   {
+      bool prev = proc->usesDeletedLib;
+
+      if (!proc->isKernelThread && !proc->isUserlandThread &&
+          ((screenFlags & PROCESS_FLAG_LINUX_LRS_FIX) || (settings->highlightDeletedExe && !proc->procExeDeleted && isOlderThan(proc, 10)))) {
+
+         if (!LinuxProcessTable_isDenied(lp, LINUX_DENIED_MAPS) && LinuxProcessTable_shouldCollect(this, lp, LINUX_COLLECTOR_MAPS, memChanged)) {
+            const ProfileMark mark = Profile_begin();
+            LinuxProcessTable_collected(lp, LINUX_COLLECTOR_MAPS);
+            LinuxProcessTable_readMaps(this, lp, procFd, lhost, screenFlags & PROCESS_FLAG_LINUX_LRS_FIX, settings->highlightDeletedExe);
+            Profile_end(this->collectorPhase[LINUX_COLLECTOR_MAPS], mark);
+         }
+      } else {
+         /* Copy from process structure in threads and reset if setting got disabled */
+         proc->usesDeletedLib = (proc->isUserlandThread && parent) ? parent->usesDeletedLib : false;
+         lp->m_lrs = (proc->isUserlandThread && parent) ? ((const LinuxProcess*)parent)->m_lrs : 0;
+      }
+
+      if (prev != proc->usesDeletedLib)
+         proc->mergedCommand.lastUpdate = 0;
+   }
+
+   if ((screenFlags & LINUX_SMAPS_FLAGS) && !Process_isKernelThread(proc)) {
+      if (!parent) {
+         if (!LinuxProcessTable_isDenied(lp, LINUX_DENIED_SMAPS) && LinuxProcessTable_shouldCollect(this, lp, LINUX_COLLECTOR_SMAPS, memChanged)) {
+            const ProfileMark mark = Profile_begin();
+            LinuxProcessTable_collected(lp, LINUX_COLLECTOR_SMAPS);
+            LinuxProcessTable_readSmapsFile(lp, procFd, this->haveSmapsRollup);
+            Profile_end(this->collectorPhase[LINUX_COLLECTOR_SMAPS], mark);
+         }
+      } else {
+         const LinuxProcess* lparent = (const LinuxProcess*)parent;
+         if (lp->details || lparent->details) {
+            LinuxProcessDetails* d = LinuxProcess_details(lp);
+            const LinuxProcessDetails* pd = LinuxProcess_getDetails(lparent);
+            d->m_pss = pd->m_pss;
+            d->m_thp = pd->m_thp;
+            d->thp_percent = pd->thp_percent;
+            d->m_hugetlb = pd->m_hugetlb;
+         }
+         lp->collectedMs[LINUX_COLLECTOR_SMAPS] = lparent->collectedMs[LINUX_COLLECTOR_SMAPS];
+      }
+   }
+
+   if (tty_nr != proc->tty_nr && LinuxProcessTable_getTtyDrivers(this)) {
+      free(proc->tty_name);
+      proc->tty_name = LinuxProcessTable_updateTtyDevice(this->ttyDrivers, proc->tty_nr);
+   }
+
+   if ((flags & PROCESS_FLAG_LINUX_IOPRIO) && !idle) {
+      LinuxProcess_updateIOPriority(proc);
+   }
+
+   proc->percent_cpu = NAN;
+   if (!isnan(runtimePercent)) {
+      proc->percent_cpu = MINIMUM(runtimePercent, host->activeCPUs * 100.0F);
+   } else if (this->period > 0.0) {
+      /* this->period might be 0 after system sleep */
+      float percent_cpu = saturatingSub(lp->utime + lp->stime, lasttimes) / this->period * 100.0;
+      proc->percent_cpu = MINIMUM(percent_cpu, host->activeCPUs * 100.0F);
+   }
+   proc->percent_mem = proc->m_resident / (double)(host->totalMem) * 100.0;
+   Process_updateCPUFieldWidths(proc->percent_cpu);
+
+   LinuxProcessStatus status = { .valid = false };
+   if (parent) {
+      LinuxProcessTable_inheritFromProcess(lp, (const LinuxProcess*) parent, screenFlags, statCommand);
+
+      bool needStatus = (flags & (PROCESS_FLAG_LINUX_CTXT | PROCESS_FLAG_LINUX_MIGRATE)) && !idle;
+      #ifdef HAVE_OPENVZ
+      needStatus |= !preExisting && (screenFlags & PROCESS_FLAG_LINUX_OPENVZ);
+      #endif
+      if (needStatus && !LinuxProcessTable_readStatusFile(proc, procFd, &status))
+         goto errorReadingProcess;
+   } else if (!idle) {
+      if (!LinuxProcessTable_updateUser(host, proc, procFd))
+         goto errorReadingProcess;
+
+      /* the reads of a new process were refused before its owner was known */
+      if (!preExisting || pidReused)
+         lp->deniedUid = proc->st_uid;
+
+      if (usePrefetch) {
+         if (!prefetch->status)
+            goto errorReadingProcess;
+         LinuxProcessTable_parseStatusFile(proc, prefetch->status, &status);
+      } else if (!LinuxProcessTable_readStatusFile(proc, procFd, &status)) {
+         goto errorReadingProcess;
+      }
+   }
+
+   if (!preExisting) {
+
+      #ifdef HAVE_OPENVZ
+      if (screenFlags & PROCESS_FLAG_LINUX_OPENVZ) {
+         LinuxProcessTable_readOpenVZData(lp, &status);
+      }
+      #endif
+
+      if (proc->isKernelThread) {
+         Process_updateCmdline(proc, NULL, 0, 0);
+      } else if (parent) {
+         /* command line and executable were copied from the process */
+      } else if (!LinuxProcessTable_readCmdlineFile(proc, procFd)) {
+         Process_updateCmdline(proc, statCommand, 0, strlen(statCommand));
+      }
+
+      Process_fillStarttimeBuffer(proc);
+
+      ProcessTable_add(pt, proc);
+   } else {
+      /* A process renaming itself changes comm, which stat tells for free;
+         argv rewritten in place is only noticed by the rounds of rereads,
+         spread over the processes by their PID */
+      const bool renamed = settings->updateProcessNames && !idle &&
+         statCommand[0] && proc->procComm && !String_eq(statCommand, proc->procComm);
+      bool refreshCmdline = renamed || (settings->updateProcessNames && !idle &&
+         ((unsigned int)Process_getPid(proc) + this->cmdlineRound) % LINUX_CMDLINE_ROUNDS == 0);
+#ifdef HAVE_PROC_CONNECTOR
+      /* exec (and comm changes) replace the command line right away */
+      if (this->procEventsComplete)
+         refreshCmdline |= lp->execEvent;
+      if (lp->execEvent)
+         lp->denied = 0;
+      lp->execEvent = false;
+#endif
+      /* another program, as exec usually renames the process, may let more be read */
+      if (renamed)
+         lp->denied = 0;
+      if ((refreshCmdline || pidReused) && proc->state != ZOMBIE && !parent) {
+         if (proc->isKernelThread) {
+            Process_updateCmdline(proc, NULL, 0, 0);
+         } else if (!LinuxProcessTable_readCmdlineFile(proc, procFd)) {
+            Process_updateCmdline(proc, statCommand, 0, strlen(statCommand));
+         }
+      }
+   }
+
+   if ((screenFlags & PROCESS_FLAG_LINUX_CGROUP) && !parent) {
+      if (LinuxProcessTable_shouldCollect(this, lp, LINUX_COLLECTOR_CGROUP, !preExisting)) {
+         const ProfileMark mark = Profile_begin();
+         LinuxProcessTable_collected(lp, LINUX_COLLECTOR_CGROUP);
+         LinuxProcessTable_readCGroupFile(this, lp, procFd);
+         Profile_end(this->collectorPhase[LINUX_COLLECTOR_CGROUP], mark);
+      } else {
+         LinuxProcessTable_updateCGroupWidths(lp);
+      }
+   }
+
+   if ((screenFlags & PROCESS_FLAG_LINUX_THROTTLE) && lp->cgroup && lp->cgroup->unified && this->cgroupRoot)
+      CGroupThrottle_update(&lp->cgroup->throttle, this->cgroupRoot, lp->cgroup->unified, host->monotonicMs);
+
+   if ((screenFlags & PROCESS_FLAG_LINUX_LIMITS) && lp->cgroup && lp->cgroup->unified && this->cgroupRoot)
+      CGroupLimits_update(&lp->cgroup->limits, this->cgroupRoot, lp->cgroup->unified, host->monotonicMs);
+
+   if ((screenFlags & PROCESS_FLAG_LINUX_PRESSURE) && lp->cgroup && lp->cgroup->unified && this->cgroupRoot)
+      CGroupPressure_update(&lp->cgroup->pressure, this->cgroupRoot, lp->cgroup->unified, host->monotonicMs);
+
+   if ((screenFlags & PROCESS_FLAG_LINUX_MEMSTAT) && lp->cgroup && lp->cgroup->unified && this->cgroupRoot)
+      CGroupMemoryStat_update(&lp->cgroup->memoryStat, this->cgroupRoot, lp->cgroup->unified, host->monotonicMs);
+
+   if (screenFlags & PROCESS_FLAG_LINUX_FAULTS) {
+      LinuxProcessDetails* d = LinuxProcess_details(lp);
+      Rate_update(&d->majflt_rate, proc->majflt, host->monotonicMs);
+      Rate_update(&d->minflt_rate, proc->minflt, host->monotonicMs);
+   }
+
+   #ifdef HAVE_DELAYACCT
+   if (flags & PROCESS_FLAG_LINUX_DELAYACCT) {
+      const bool cpuChanged = lp->utime + lp->stime != lasttimes;
+      if (LinuxProcessTable_shouldCollect(this, lp, LINUX_COLLECTOR_DELAYACCT, cpuChanged)) {
+         const ProfileMark mark = Profile_begin();
+         LinuxProcessTable_collected(lp, LINUX_COLLECTOR_DELAYACCT);
+         if (!LinuxProcessTable_readDelayAcctData(this, lp)) {
+            /* without taskstats, schedstat has the same run queue delay */
+            LinuxProcessTable_readSchedstat(lp, procFd, host->monotonicMs);
+            LinuxProcessDetails* d = LinuxProcess_details(lp);
+            d->cpu_delay_percent = LinuxProcess_runqWaitPercent(d);
+         }
+         Profile_end(this->collectorPhase[LINUX_COLLECTOR_DELAYACCT], mark);
+      }
+   }
+   #endif
+
+   /* read whether the task ran or not, one starved on a run queue looks idle by its CPU time;
+      for the vCPUs of a guest, that is the time it had stolen */
+   if ((flags & PROCESS_FLAG_LINUX_SCHEDSTAT) || (this->guestsShown && parent && GuestTable_isVcpu(parent, proc))) {
+      if (schedstat)
+         LinuxProcessTable_parseSchedstatFile(lp, schedstat, host->monotonicMs);
+      else
+         LinuxProcessTable_readSchedstat(lp, procFd, host->monotonicMs);
+   }
+
+   if ((screenFlags & PROCESS_FLAG_LINUX_NUMA) && lhost->numaNodes > 0 && !Process_isKernelThread(proc)) {
+      if (!parent) {
+         if (!LinuxProcessTable_isDenied(lp, LINUX_DENIED_NUMA_MAPS) && LinuxProcessTable_shouldCollect(this, lp, LINUX_COLLECTOR_NUMA, memChanged)) {
+            const ProfileMark mark = Profile_begin();
+            LinuxProcessTable_collected(lp, LINUX_COLLECTOR_NUMA);
+            LinuxProcessTable_readNumaMaps(lp, procFd, lhost);
+            Profile_end(this->collectorPhase[LINUX_COLLECTOR_NUMA], mark);
+         }
+      } else {
+         /* threads share the memory of their process */
+         const LinuxProcessDetails* pd = LinuxProcess_getDetails((const LinuxProcess*)parent);
+         if (pd->numaKB) {
+            LinuxProcessDetails* d = LinuxProcess_details(lp);
+            if (!d->numaKB)
+               d->numaKB = xMallocArray(lhost->numaNodes, sizeof(*d->numaKB));
+            memcpy(d->numaKB, pd->numaKB, lhost->numaNodes * sizeof(*d->numaKB));
+         }
+         lp->collectedMs[LINUX_COLLECTOR_NUMA] = ((const LinuxProcess*)parent)->collectedMs[LINUX_COLLECTOR_NUMA];
+      }
+
+      if (lp->details && lp->details->numaKB) {
+         char nodes[128];
+         Row_updateFieldWidth(NUMA_NODES, (size_t)LinuxProcess_formatNumaNodes(lp, nodes, sizeof(nodes)));
+      }
+   }
+
+   /* Only the DRM clients already known are read each scan, finding new ones is budgeted */
+   if ((screenFlags & PROCESS_FLAG_LINUX_GPU) && !parent && !Process_isKernelThread(proc)) {
+      const bool discover = LinuxProcessTable_shouldCollect(this, lp, LINUX_COLLECTOR_GPU, memChanged);
+      if (discover || LinuxProcess_getDetails(lp)->gpu) {
+         const ProfileMark mark = Profile_begin();
+         if (discover)
+            LinuxProcessTable_collected(lp, LINUX_COLLECTOR_GPU);
+         LinuxProcessDetails* d = LinuxProcess_details(lp);
+         GPUProcessData_update(&d->gpu, procFd, discover, host->monotonicMs);
+         GPUTotals_add(&this->gpuTotals, d->gpu);
+         Profile_end(this->collectorPhase[LINUX_COLLECTOR_GPU], mark);
+      }
+
+      const GPUProcessData* gpu = LinuxProcess_getDetails(lp)->gpu;
+      if (gpu) {
+         char engines[128];
+         Row_updateFieldWidth(GPU_ENGINES, (size_t)GPUProcessData_formatEngines(gpu, engines, sizeof(engines)));
+      }
+   }
+
+   /* fds growing get counted first, so leaks show up soon even off screen */
+   if ((screenFlags & PROCESS_FLAG_LINUX_FDS) && !Process_isKernelThread(proc)) {
+      if (!parent) {
+         const LinuxProcessDetails* d = LinuxProcess_getDetails(lp);
+         const bool growing = !d->fdCountMs || d->fdRate > 0.0;
+         if (!LinuxProcessTable_isDenied(lp, LINUX_DENIED_FDS) && LinuxProcessTable_shouldCollect(this, lp, LINUX_COLLECTOR_FDS, growing)) {
+            const ProfileMark mark = Profile_begin();
+            LinuxProcessTable_collected(lp, LINUX_COLLECTOR_FDS);
+            LinuxProcessTable_readFdCount(lp, procFd, host->monotonicMs);
+            Profile_end(this->collectorPhase[LINUX_COLLECTOR_FDS], mark);
+         }
+      } else {
+         /* threads share the fd table of their process */
+         const LinuxProcessDetails* pd = LinuxProcess_getDetails((const LinuxProcess*)parent);
+         if (pd->fdCountMs) {
+            LinuxProcessDetails* d = LinuxProcess_details(lp);
+            d->fdCount = pd->fdCount;
+            d->fdCountMs = pd->fdCountMs;
+            d->fdRate = pd->fdRate;
+         }
+         lp->collectedMs[LINUX_COLLECTOR_FDS] = ((const LinuxProcess*)parent)->collectedMs[LINUX_COLLECTOR_FDS];
+      }
+   }
+
+   /* POSIX locks are owned by the process, flock ones by whichever task took them */
+   if (screenFlags & PROCESS_FLAG_LINUX_LOCKS) {
+      unsigned int held = LockIndex_held(Process_getThreadGroup(proc));
+      if (held || lp->details)
+         LinuxProcess_details(lp)->locksHeld = held;
+   }
+
+   if (screenFlags & PROCESS_FLAG_LINUX_MIGRATE) {
+      LinuxProcessTable_updateMigrations(lp, status.valid, host->monotonicMs);
+   }
+
+   #ifdef HAVE_BPF_COLUMNS
+   /* the BPF program counts the bytes of the whole thread group */
+   if ((screenFlags & PROCESS_FLAG_LINUX_BPF_NET) && !Process_isThread(proc)) {
+      unsigned long long rx, tx;
+      if (BpfNet_bytes(Process_getPid(proc), &rx, &tx)) {
+         LinuxProcessDetails* d = LinuxProcess_details(lp);
+         Rate_update(&d->net_rx_rate, rx, host->monotonicMs);
+         Rate_update(&d->net_tx_rate, tx, host->monotonicMs);
+      }
+   }
+
+   /* likewise the futex waits of all threads */
+   if ((screenFlags & PROCESS_FLAG_LINUX_BPF_FUTEX) && !Process_isThread(proc)) {
+      unsigned long long ns;
+      if (BpfFutex_waitNs(Process_getPid(proc), &ns))
+         Rate_update(&LinuxProcess_details(lp)->futex_wait_rate, ns, host->monotonicMs);
+   }
+
+   /* and the system calls of all threads */
+   if ((screenFlags & PROCESS_FLAG_LINUX_BPF_SYSCALLS) && !Process_isThread(proc)) {
+      BpfSyscallsCounts counts;
+      if (BpfSyscalls_counts(Process_getPid(proc), &counts))
+         LinuxProcessTable_updateSyscalls(LinuxProcess_details(lp), &counts, host->monotonicMs);
+   }
+   #endif
+
+   /* NVML tells the processes using a GPU, only those get details for it */
+   if ((screenFlags & PROCESS_FLAG_LINUX_NVML) && !Process_isThread(proc)) {
+      unsigned long long memoryKB = 0;
+      float smPercent = 0.0F;
+      if (NVML_process(Process_getPid(proc), &memoryKB, &smPercent) || lp->details) {
+         LinuxProcessDetails* d = LinuxProcess_details(lp);
+         d->nvml_memoryKB = memoryKB;
+         d->nvml_smPercent = smPercent;
+      }
+   }
+
+   #ifdef HAVE_PERF_EVENTS
+   LinuxProcessTable_updatePerfCounters(lp, (screenFlags & PROCESS_FLAG_LINUX_PERF) && (onScreen || LinuxProcessTable_isFiltered(pt)));
+   #endif
+
+   if ((flags & PROCESS_FLAG_LINUX_OOM) && !idle) {
+      LinuxProcessTable_readOomData(lp, procFd);
+   }
+
+   if ((flags & PROCESS_FLAG_LINUX_SECATTR) && !idle) {
+      LinuxProcessTable_readSecattrData(lp, procFd);
+   } else if ((screenFlags & PROCESS_FLAG_LINUX_SECATTR) && LinuxProcess_getDetails(lp)->secattr && !parent) {
+      Row_updateFieldWidth(SECATTR, strlen(LinuxProcess_getDetails(lp)->secattr));
+   }
+
+   if ((flags & PROCESS_FLAG_CWD) && !idle) {
+      LinuxProcessTable_readCwd(lp, procFd);
+   }
+
+   /* the wait channel screen counts every task sleeping, the column only needs the rows on screen */
+   if ((flags & PROCESS_FLAG_LINUX_WCHAN) || this->waitChannelsShown) {
+      if (proc->state == UNINTERRUPTIBLE_WAIT || proc->state == SLEEPING) {
+         LinuxProcessTable_readWchan(lp, procFd);
+      } else {
+         LinuxProcessTable_clearWchan(lp);
+      }
+   }
+
+   if ((flags & PROCESS_FLAG_LINUX_AUTOGROUP) && this->haveAutogroup && !idle) {
+      LinuxProcessTable_readAutogroup(lp, procFd);
+   }
+
+   #ifdef SCHEDULER_SUPPORT
+   if ((flags & PROCESS_FLAG_SCHEDPOL) && !idle) {
+      Scheduling_readProcessPolicy(proc);
+   }
+   #endif
+
+   if (!proc->cmdline && statCommand[0] &&
+       (proc->state == ZOMBIE || Process_isKernelThread(proc) || settings->showThreadNames)) {
+      Process_updateCmdline(proc, statCommand, 0, strlen(statCommand));
+   }
+
+   /* Threads come after their process so they can take over its values */
+   if (!parent && !hideUserlandThreads) {
+#ifdef HAVE_OPENAT
+      if (prefetch) {
+         /* thread entries were already listed by the worker that prefetched the process */
+         if (prefetch->threadCount > 0) {
+            int taskFd = openat(procFd, "task", O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+            if (taskFd >= 0) {
+               for (size_t i = 0; i < prefetch->threadCount; i++) {
+                  const ProcScanItem* thread = &prefetch->threads[i];
+                  LinuxProcessTable_updateProcess(this, taskFd, lhost, thread->name, thread->pid, proc, thread);
+               }
+               close(taskFd);
+            }
+         }
+      } else
+#endif
+      {
+         LinuxProcessTable_recurseProcTree(this, procFd, lhost, "task", proc);
+      }
+   }
+
+   /*
+    * Final section after all data has been gathered
+    */
+
+   Table_markUpdated(&pt->super, &proc->super);
+   LinuxProcessTable_putProcFd(lp, procFd);
+
+   if (Process_isKernelThread(proc)) {
+      pt->kernelThreads++;
+   } else if (Process_isUserlandThread(proc)) {
+      pt->userlandThreads++;
+   } else if (hideUserlandThreads && proc->nlwp > 1) {
+      /* task/ was not walked, count the threads of the process from its stat */
+      pt->userlandThreads += proc->nlwp - 1;
+      pt->totalTasks += proc->nlwp - 1;
+   }
+
+   /* hidden, but its tasks still counted */
+   if (hideRunningInContainer && proc->isRunningInContainer) {
+      proc->super.show = false;
+      pt->totalTasks++;
+      return;
+   }
+
+   /* Set at the end when we know if a new entry is a thread */
+   proc->super.show = ! ((hideKernelThreads && Process_isKernelThread(proc)) || (hideUserlandThreads && Process_isUserlandThread(proc)));
+
+   LinuxProcessTable_addUserTotals(this, lp);
+   LinuxProcessTable_addWaitChannel(this, lp);
+
+   pt->totalTasks++;
+   /* runningTasks is set in Machine_scanCPUTime() from /proc/stat */
+   return;
+
+   // Exception handler.
+
+errorReadingProcess:
+   {
+#ifdef HAVE_OPENAT
+      LinuxProcessTable_putProcFd(lp, procFd);
+      LinuxProcessTable_dropProcFd(this, lp);
+
+      /*
+       * The directory of an exited task stays valid but its files fail
+       * with ESRCH, so after a failure on a cached fd look the PID up again:
+       * it might have been reused by a new task in the meantime.
+       */
+#ifdef HAVE_PROC_CONNECTOR
+      /* An exited task with a reused PID would have been reported by a fork event */
+      if (this->procEventsComplete && lp->exitEvent)
+         cachedFd = false;
+#endif
+      if (cachedFd) {
+         cachedFd = false;
+         pidReused = preExisting;
+         usePrefetch = false;
+         procFd = LinuxProcessTable_getProcFd(this, lp, dirFd, entryName);
+         if (procFd >= 0)
+            goto retry;
+      }
+#endif
+
+      if (preExisting) {
+         /*
+          * The only real reason for coming here (apart from Linux violating the /proc API)
+          * would be the process going away with its /proc files disappearing (!HAVE_OPENAT).
+          * However, we want to keep in the process list for now for the "highlight dying" mode.
+          */
+      } else {
+         /* A really short-lived process that we don't have full info about */
+         Process_delete((Object*)proc);
+      }
+   }
+}
+
+#ifdef HAVE_PROC_CONNECTOR
+
+/* Number of scans relying on process events before /proc is listed again as a consistency check */
+#define PROC_EVENTS_FULL_SCAN_INTERVAL 10
+
+/* Forgets the processes forked since the last scan */
+static void LinuxProcessTable_clearForked(LinuxProcessTable* this) {
+   this->forkedCount = 0;
+   Hashtable_clear(this->forkedIndex);
+}
+
+static LinuxForkedProcess* LinuxProcessTable_findForked(LinuxProcessTable* this, pid_t pid) {
+   uintptr_t index = (uintptr_t) Hashtable_get(this->forkedIndex, (ht_key_t)pid);
+   return index ? &this->forked[index - 1] : NULL;
+}
+
+static void LinuxProcessTable_handleProcEvent(void* context, ProcConnectorEvent event, pid_t pid, pid_t tgid, const ProcConnectorDetails* details) {
+   LinuxProcessTable* this = context;
+   LinuxProcess* lp = (LinuxProcess*) Table_findRow(&this->super.super, pid);
+
+   ProcessChurn_event(event, pid, tgid);
+
+   /* only processes are kept track of, not their threads */
+   LinuxForkedProcess* forked = pid == tgid ? LinuxProcessTable_findForked(this, pid) : NULL;
+
+   switch (event) {
+      case PROCCONNECTOR_FORK:
+         if (lp) {
+            /* The PID got reused before the old entry was cleaned up */
+            lp->execEvent = true;
+            lp->exitEvent = false;
+#ifdef HAVE_OPENAT
+            LinuxProcessTable_dropProcFd(this, lp);
+#endif
+         }
+         if (pid == tgid) {
+            if (!forked) {
+               if (this->forkedCount == this->forkedAlloc) {
+                  this->forkedAlloc = this->forkedAlloc ? this->forkedAlloc * 2 : 64;
+                  this->forked = xReallocArray(this->forked, this->forkedAlloc, sizeof(LinuxForkedProcess));
+               }
+               forked = &this->forked[this->forkedCount++];
+               Hashtable_put(this->forkedIndex, (ht_key_t)pid, (void*)(uintptr_t)this->forkedCount);
+            }
+
+            const Process* parent = (const Process*) Table_findRow(&this->super.super, details->parentTgid);
+            *forked = (LinuxForkedProcess) {
+               .pid = pid,
+               .ppid = details->parentTgid,
+               .startNs = details->timestampNs,
+            };
+            if (parent && parent->procComm)
+               String_safeStrncpy(forked->comm, parent->procComm, sizeof(forked->comm));
+         }
+         break;
+      case PROCCONNECTOR_EXEC:
+         if (lp)
+            lp->execEvent = true;
+         /* the event does not tell the new name, and exec sends no comm event */
+         if (forked)
+            forked->comm[0] = '\0';
+         break;
+      case PROCCONNECTOR_COMM:
+         if (lp)
+            lp->execEvent = true;
+         if (forked)
+            memcpy(forked->comm, details->comm, sizeof(forked->comm));
+         break;
+      case PROCCONNECTOR_EXIT:
+         if (lp)
+            lp->exitEvent = true;
+         if (forked)
+            forked->exited = true;
+         break;
+   }
+}
+
+/* Builds procList from the known processes and the forked ones, without listing /proc */
+static void LinuxProcessTable_listFromEvents(LinuxProcessTable* this) {
+   ProcDirList* list = &this->procList;
+   const Table* table = &this->super.super;
+
+   list->count = 0;
+   for (int i = 0; i < Vector_size(table->rows); i++) {
+      const Process* proc = (const Process*) Vector_get(table->rows, i);
+      if (Process_getPid(proc) == Process_getThreadGroup(proc))
+         ProcDirList_addPid(list, Process_getPid(proc));
+   }
+
+   /* the ones that exited may still be zombies to read */
+   for (size_t i = 0; i < this->forkedCount; i++) {
+      if (!Table_findRow(table, this->forked[i].pid))
+         ProcDirList_addPid(list, this->forked[i].pid);
+   }
+}
+
+/* Rows given to short-lived processes in one scan at most, a fork storm is left to the churn meter */
+#define LINUX_SHORT_LIVED_MAX 512
+
+/*
+ * Gives a row to the processes that were forked and exited since the last
+ * scan, which did not read them; they are shown as dead for one scan, or
+ * as long as exited processes are highlighted. Only what the events tell
+ * is known of them: the parent, the start and the command name while it
+ * is the parent's, as exec does not tell the new one. The rows of known
+ * processes that exited are left to the scan, which still shows them as
+ * long as they are zombies.
+ */
+static void LinuxProcessTable_addShortLived(LinuxProcessTable* this, const LinuxMachine* lhost) {
+   ProcessTable* pt = &this->super;
+   Table* table = &pt->super;
+   const Machine* host = &lhost->super;
+   const Settings* settings = host->settings;
+
+   if (!this->procEventsComplete || LinuxProcessTable_isFiltered(pt)) {
+      LinuxProcessTable_clearForked(this);
+      return;
+   }
+
+   unsigned int added = 0;
+   for (size_t i = 0; i < this->forkedCount && added < LINUX_SHORT_LIVED_MAX; i++) {
+      const LinuxForkedProcess* forked = &this->forked[i];
+      if (!forked->exited || Table_findRow(table, forked->pid))
+         continue;
+
+      bool preExisting;
+      Process* proc = ProcessTable_getProcess(pt, forked->pid, &preExisting, LinuxProcess_new);
+      Process_setThreadGroup(proc, forked->pid);
+      Process_setParent(proc, forked->ppid);
+      proc->state = DEFUNCT;
+      proc->starttime_ctime = lhost->boottime + (time_t)(forked->startNs / 1000000000ULL);
+      proc->percent_cpu = NAN;
+      proc->percent_mem = 0.0;
+
+      const Process* parent = (const Process*) Table_findRow(table, forked->ppid);
+      if (parent) {
+         proc->st_uid = parent->st_uid;
+         proc->user = parent->user;
+         proc->isRunningInContainer = parent->isRunningInContainer;
+      } else {
+         proc->st_uid = (uid_t)-1;
+         proc->user = NULL;
+      }
+
+      if (forked->comm[0]) {
+         Process_updateComm(proc, forked->comm);
+         Process_updateCmdline(proc, forked->comm, 0, (int)strlen(forked->comm));
+      }
+
+      Process_fillStarttimeBuffer(proc);
+      ProcessTable_add(pt, proc);
+      Table_markUpdated(table, &proc->super);
+
+      proc->super.show = !(settings->hideRunningInContainer && proc->isRunningInContainer);
+      added++;
+   }
+
+   LinuxProcessTable_clearForked(this);
+}
+
+static void LinuxProcessTable_readProcEvents(LinuxProcessTable* this, const Settings* settings) {
+   this->procEventsComplete = false;
+   this->procListFromEvents = false;
+
+   /* events are about the running kernel, not about another proc root */
+   if (!settings->procConnector || !FsRoot_isDefault(&FsRoot_proc)) {
+      ProcConnector_close(this->procConnectorFd);
+      this->procConnectorFd = -1;
+      this->procConnectorFailed = false;
+      return;
+   }
+
+   if (this->procConnectorFd < 0) {
+      if (this->procConnectorFailed)
+         return;
+
+      /* Events are seen from now on; this scan still lists /proc */
+      this->procConnectorFd = ProcConnector_open();
+      this->procConnectorFailed = this->procConnectorFd < 0;
+      this->procEventScans = 0;
+      LinuxProcessTable_clearForked(this);
+      return;
+   }
+
+   this->procEventsComplete = ProcConnector_drain(this->procConnectorFd, LinuxProcessTable_handleProcEvent, this);
+   ProcessChurn_eventsRead(this->procEventsComplete);
+
+   /* a full scan lists the forked processes from /proc, those that exited still get a row */
+   if (!this->procEventsComplete || ++this->procEventScans >= PROC_EVENTS_FULL_SCAN_INTERVAL) {
+      this->procEventScans = 0;
+      return;
+   }
+
+   LinuxProcessTable_listFromEvents(this);
+   this->procListFromEvents = true;
+}
+
+#endif /* HAVE_PROC_CONNECTOR */
+
+static bool LinuxProcessTable_listDir(LinuxProcessTable* this, ProcDirList* list, int dirFd) {
+#ifdef HAVE_PROC_CONNECTOR
+   if (list == &this->procList && this->procListFromEvents)
+      return true;
+#else
+   (void)this;
+#endif
+
+   return ProcDirList_read(list, dirFd);
+}
+
+static void LinuxProcessTable_addMatchedPid(ht_key_t key, ATTR_UNUSED void* value, void* data) {
+   ProcDirList_addPid((ProcDirList*) data, (pid_t) key);
+}
+
+static bool LinuxProcessTable_recurseProcTree(LinuxProcessTable* this, openat_arg_t parentFd, const LinuxMachine* lhost, const char* dirname, const Process* parent) {
+   ProcessTable* pt = (ProcessTable*) this;
+
+   /* set runningTasks from /proc/stat (from Machine_scanCPUTime) */
+   pt->runningTasks = lhost->runningTasks;
+
+#ifdef HAVE_OPENAT
+   int dirFd = openat(parentFd, dirname, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+   if (dirFd < 0)
+      return false;
+   int listFd = dirFd;
+#else
+   char dirFd[4096];
+   xSnprintf(dirFd, sizeof(dirFd), "%s/%s", parentFd, dirname);
+   int listFd = open(dirFd, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   if (listFd < 0)
+      return false;
+#endif
+
+   /* Only processes have a task directory, so two lists cover all levels */
+   ProcDirList* list = parent ? &this->taskList : &this->procList;
+   bool ok;
+   if (!parent && CGroupScope_path) {
+      /* only the processes in the cgroup given with --cgroup are looked at */
+      ok = CGroupScope_list(list);
+   } else if (!parent && pt->pidMatchList) {
+      /* only the directories of the processes given with --pid are looked at */
+      list->count = 0;
+      Hashtable_foreach(pt->pidMatchList, LinuxProcessTable_addMatchedPid, list);
+      ok = true;
+   } else {
+      ok = LinuxProcessTable_listDir(this, list, listFd);
+   }
+
+#ifndef HAVE_OPENAT
+   close(listFd);
+#endif
+
+   if (ok) {
+      for (size_t i = 0; i < list->count; i++) {
+         const ProcDirEntry* entry = &list->entries[i];
+
+         // Skip task directory of main thread
+         if (parent && entry->pid == Process_getPid(parent))
+            continue;
+
+         if (!parent && CGroupScope_path && pt->pidMatchList && !Hashtable_get(pt->pidMatchList, (ht_key_t)entry->pid))
+            continue;
+
+         LinuxProcessTable_updateProcess(this, dirFd, lhost, entry->name, entry->pid, parent, NULL);
+      }
+   }
+
+   Compat_openatArgClose(dirFd);
+   return ok;
+}
+
+#if defined(HAVE_PTHREAD) && defined(HAVE_OPENAT)
+
+/* A scan started ahead is merged if it is younger than this or two update intervals */
+#define LINUX_PREFETCH_MAX_AGE_MS 2000
+
+static ProcScanOptions LinuxProcessTable_scanOptions(const LinuxProcessTable* this, const Settings* settings) {
+   return (ProcScanOptions) {
+      .readIo = (settings->ss->flags | this->tableFlags | this->warmFlags) & PROCESS_FLAG_IO,
+      .readThreads = !settings->hideUserlandThreads,
+      .readSchedstat = settings->preciseCpu,
+   };
+}
+
+/* Workers of the pool, none for the serial scan; --low-impact reads even that on one at idle priority */
+static unsigned int LinuxProcessTable_scanThreads(const Settings* settings) {
+   if (settings->scanThreads > 1)
+      return (unsigned int)settings->scanThreads;
 
-      if (ss->flags & PROCESS_FLAG_CWD) {
-         LinuxProcessTable_readCwd(lp, procFd);
+   return Platform_lowImpact ? 1 : 0;
+}
+
+static void LinuxProcessTable_runJobs(void* context, Vector_Job job, void* data, size_t count) {
+   ProcScanPool_run(context, job, data, count);
+}
+
+/*
+ * Lists the top-level /proc entries and hands them to the worker pool,
+ * which lists the threads and reads the raw stat, statm, status and io
+ * files ahead. Returns false if the serial scan should be used instead.
+ */
+static bool LinuxProcessTable_beginParallel(LinuxProcessTable* this, const Settings* settings, bool ahead) {
+   ProcessTable* pt = (ProcessTable*) this;
+   const unsigned int threads = LinuxProcessTable_scanThreads(settings);
+
+   assert(this->scanDirFd < 0);
+
+   if (this->scanPoolThreads != threads) {
+      pt->super.sortRunner = NULL;
+      ProcScanPool_delete(this->scanPool);
+      this->scanPool = ProcScanPool_new(threads);
+      this->scanPoolThreads = threads;
+
+      /* --low-impact keeps its single idle worker to the scan */
+      if (this->scanPool && !Platform_lowImpact) {
+         this->sortRunner = (VectorRunner) {
+            .run = LinuxProcessTable_runJobs,
+            .context = this->scanPool,
+            .workers = ProcScanPool_workerCount(this->scanPool),
+         };
+         pt->super.sortRunner = &this->sortRunner;
       }
+   }
+   if (!this->scanPool)
+      return false;
+
+   int dirFd = openat(FsRoot_proc.fd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   if (dirFd < 0)
+      return false;
+
+   ProcDirList* list = &this->procList;
+   if (!LinuxProcessTable_listDir(this, list, dirFd)) {
+      close(dirFd);
+      return false;
+   }
+
+   const bool hideKernelThreads = settings->hideKernelThreads;
+   const bool hideUserlandThreads = settings->hideUserlandThreads;
+   const bool hideRunningInContainer = settings->hideRunningInContainer;
+
+   const size_t count = list->count;
+   if (count > this->scanTasksAlloc) {
+      this->scanTasksAlloc = MAXIMUM(count, 2 * this->scanTasksAlloc);
+      this->scanTasks = xReallocArray(this->scanTasks, this->scanTasksAlloc, sizeof(ProcScanTask));
+   }
+
+   for (size_t i = 0; i < count; i++) {
+      const ProcDirEntry* entry = &list->entries[i];
+
+      /* Decide up front what updateProcess() is going to read for this entry */
+      const Process* proc = (const Process*) Table_findRow(&pt->super, entry->pid);
+      const bool kernelThread = proc && Process_isKernelThread(proc);
+
+      ProcScanTask* task = &this->scanTasks[i];
+      task->pid = entry->pid;
+      memcpy(task->name, entry->name, sizeof(task->name));
+      task->readFiles = !(proc && ((hideKernelThreads && kernelThread) || (hideRunningInContainer && proc->isRunningInContainer)));
+      task->mainThread = !hideUserlandThreads && !kernelThread;
+      task->skipIo = proc && LinuxProcessTable_isDenied((const LinuxProcess*) proc, LINUX_DENIED_IO);
+   }
+
+   if (count < PROCSCANPOOL_MIN_TASKS && !Platform_lowImpact) {
+      close(dirFd);
+      return false;
+   }
+
+   if (ahead)
+      ProcScanPool_reserve(this->scanPool, count);
+
+   this->scanDirFd = dirFd;
+   this->scanOptions = LinuxProcessTable_scanOptions(this, settings);
+   this->scanOptions.wakeWhenFilled = ahead;
+   Platform_gettime_monotonic(&this->scanStartMs);
+
+   ProcScanPool_begin(this->scanPool, dirFd, this->scanTasks, count, this->scanOptions);
+   return true;
+}
 
-      if ((ss->flags & PROCESS_FLAG_LINUX_AUTOGROUP) && this->haveAutogroup) {
-         LinuxProcessTable_readAutogroup(lp, procFd);
+/* Parses and merges the prefetched processes on this thread, in /proc order */
+static void LinuxProcessTable_finishParallel(LinuxProcessTable* this, const LinuxMachine* lhost) {
+   ProcessTable* pt = (ProcessTable*) this;
+   ProcScanPool* pool = this->scanPool;
+   const int dirFd = this->scanDirFd;
+
+   /* set runningTasks from /proc/stat (from Machine_scanCPUTime) */
+   pt->runningTasks = lhost->runningTasks;
+
+   for (size_t i = 0; i < ProcScanPool_chunkCount(pool); i++) {
+      const ProcScanChunk* chunk = ProcScanPool_waitChunk(pool, i);
+
+      for (size_t j = 0; j < ProcScanChunk_size(chunk); j++) {
+         const ProcScanItem* item = ProcScanChunk_get(chunk, j);
+         LinuxProcessTable_updateProcess(this, dirFd, lhost, item->name, item->pid, NULL, item);
       }
 
-      #ifdef SCHEDULER_SUPPORT
-      if (ss->flags & PROCESS_FLAG_SCHEDPOL) {
-         Scheduling_readProcessPolicy(proc);
+      ProcScanPool_releaseChunk(pool, chunk);
+   }
+
+   close(dirFd);
+   this->scanDirFd = -1;
+}
+
+/* Throws away a scan started ahead */
+static void LinuxProcessTable_dropParallel(LinuxProcessTable* this) {
+   ProcScanPool* pool = this->scanPool;
+
+   for (size_t i = 0; i < ProcScanPool_chunkCount(pool); i++)
+      ProcScanPool_releaseChunk(pool, ProcScanPool_waitChunk(pool, i));
+
+   close(this->scanDirFd);
+   this->scanDirFd = -1;
+}
+
+static bool LinuxProcessTable_scanParallel(LinuxProcessTable* this, const LinuxMachine* lhost) {
+   if (!LinuxProcessTable_beginParallel(this, lhost->super.settings, false))
+      return false;
+
+   LinuxProcessTable_finishParallel(this, lhost);
+   return true;
+}
+
+/*
+ * Merges a scan started ahead by ProcessTable_prefetchEntries(), unless
+ * the settings changed what it has to read or it is too old to tell CPU
+ * usage from; in that case it is dropped and false returned.
+ */
+static bool LinuxProcessTable_finishPrefetch(LinuxProcessTable* this, const LinuxMachine* lhost) {
+   if (this->scanDirFd < 0)
+      return false;
+
+   const Machine* host = &lhost->super;
+   const Settings* settings = host->settings;
+   const ProcScanOptions options = LinuxProcessTable_scanOptions(this, settings);
+   const uint64_t maxAgeMs = MAXIMUM(2 * 100 * (uint64_t)settings->delay, LINUX_PREFETCH_MAX_AGE_MS);
+
+   if (options.readIo != this->scanOptions.readIo ||
+       options.readThreads != this->scanOptions.readThreads ||
+       options.readSchedstat != this->scanOptions.readSchedstat ||
+       LinuxProcessTable_scanThreads(settings) != this->scanPoolThreads ||
+       host->monotonicMs - this->scanStartMs > maxAgeMs) {
+      LinuxProcessTable_dropParallel(this);
+      return false;
+   }
+
+   LinuxProcessTable_finishParallel(this, lhost);
+   return true;
+}
+
+bool ProcessTable_prefetchEntries(ProcessTable* super) {
+   LinuxProcessTable* this = (LinuxProcessTable*) super;
+   const Settings* settings = super->super.host->settings;
+
+   if (this->scanDirFd >= 0)
+      return true;
+
+   if (!LinuxProcessTable_scanThreads(settings))
+      return false;
+
+   /* a filtered scan only looks at a few processes, see ProcessTable_goThroughEntries */
+   if (LinuxProcessTable_isFiltered(super))
+      return false;
+
+   /* the collector already scanned ahead, or nothing is scanned while replaying */
+   if (SharedScan_mode == SHARED_SCAN_ATTACH || Replay_isOpen())
+      return false;
+
+#ifdef HAVE_BPF_ITER
+   /* the task iterator is read in one go, there is nothing to do ahead */
+   if (FsRoot_isDefault(&FsRoot_proc) && access(BPF_TASK_ITER_PATH, R_OK) == 0)
+      return false;
+#endif
+
+#ifdef HAVE_PROC_CONNECTOR
+   LinuxProcessTable_readProcEvents(this, settings);
+#endif
+
+   return LinuxProcessTable_beginParallel(this, settings, true);
+}
+
+bool ProcessTable_entriesPrefetched(const ProcessTable* super) {
+   const LinuxProcessTable* this = (const LinuxProcessTable*) super;
+
+   return this->scanDirFd < 0 || ProcScanPool_isFilled(this->scanPool);
+}
+
+#endif /* HAVE_PTHREAD && HAVE_OPENAT */
+
+#if defined(HAVE_BPF_ITER) && defined(HAVE_OPENAT)
+
+/* Nanoseconds to the hundredths of seconds used for process times */
+#define NS_TO_CENTISECONDS(ns) ((ns) / 10000000ULL)
+
+/*
+ * Whether the process lives in a PID namespace below the one of /proc, as
+ * told by the NSpid line of its status file, like the procfs path sets
+ * isRunningInContainer.
+ */
+static bool LinuxProcessTable_readNestedPidNs(openat_arg_t procFd) {
+   char buffer[PROC_PID_STATUS_BUFSIZE];
+   ssize_t r = xReadfileat(procFd, "status", buffer, sizeof(buffer));
+   if (r < 0)
+      return false;
+
+   const char* line = strstr(buffer, "\nNSpid:");
+   if (!line)
+      return false;
+
+   int count = 0;
+   for (const char* ptr = line + strlen("\nNSpid:"); *ptr && *ptr != '\n'; ) {
+      if (isdigit((unsigned char)*ptr)) {
+         count++;
+         while (isdigit((unsigned char)*ptr))
+            ++ptr;
+      } else {
+         ++ptr;
       }
-      #endif
+   }
+   return count > 1;
+}
 
-      if (!proc->cmdline && statCommand[0] &&
-          (proc->state == ZOMBIE || Process_isKernelThread(proc) || settings->showThreadNames)) {
-         Process_updateCmdline(proc, statCommand, 0, strlen(statCommand));
+/*
+ * Updates a process or thread from the task iterator snapshot only; the
+ * command line of new, reused and renamed (usually exec'd) processes and
+ * the PID namespace of new ones are the only files read from /proc.
+ * Times of a process are the given totals over all of its tasks.
+ */
+static void LinuxProcessTable_updateTask(LinuxProcessTable* this, const LinuxMachine* lhost, const BpfTask* task, unsigned long long int utimeNs, unsigned long long int stimeNs, const Process* parent) {
+   ProcessTable* pt = (ProcessTable*) this;
+   const Machine* host = &lhost->super;
+   const Settings* settings = host->settings;
+
+   bool preExisting;
+   Process* proc = ProcessTable_getProcess(pt, task->tid, &preExisting, LinuxProcess_new);
+   LinuxProcess* lp = (LinuxProcess*) proc;
+
+   Process_setThreadGroup(proc, task->tgid);
+   proc->isUserlandThread = task->tid != task->tgid;
+
+   const unsigned long long int lasttimes = lp->utime + lp->stime;
+   const time_t starttime = lhost->boottime + (time_t)(task->startNs / 1000000000ULL);
+   const bool pidReused = preExisting && proc->starttime_ctime != starttime;
+
+   proc->state = LinuxProcessTable_getProcessState(task->state);
+   Process_setParent(proc, task->ppid);
+   proc->pgrp = task->pgrp;
+   proc->session = task->session;
+   lp->flags = task->flags;
+   proc->minflt = task->minflt;
+   proc->majflt = task->majflt;
+   lp->utime = NS_TO_CENTISECONDS(utimeNs);
+   lp->stime = NS_TO_CENTISECONDS(stimeNs);
+   proc->priority = task->priority;
+   proc->nice = task->nice;
+   proc->nlwp = task->nlwp;
+   proc->processor = task->processor;
+   proc->starttime_ctime = starttime;
+   proc->time = lp->utime + lp->stime;
+
+   proc->m_virt = task->vsize * lhost->pageSizeKB;
+   proc->m_resident = task->rss * lhost->pageSizeKB;
+   lp->m_share = task->shared;
+   lp->m_priv = proc->m_resident - (lp->m_share * lhost->pageSizeKB);
+
+   if (lp->flags & PF_KTHREAD)
+      proc->isKernelThread = true;
+
+   if (task->ttyNr != proc->tty_nr || !preExisting) {
+      proc->tty_nr = task->ttyNr;
+      free(proc->tty_name);
+      proc->tty_name = LinuxProcessTable_getTtyDrivers(this) ? LinuxProcessTable_updateTtyDevice(this->ttyDrivers, proc->tty_nr) : NULL;
+   }
+
+   if (proc->st_uid != task->euid || !proc->user) {
+      proc->st_uid = task->euid;
+      proc->user = UsersTable_getRef(host->usersTable, task->euid);
+   }
+
+   proc->percent_cpu = NAN;
+   /* this->period might be 0 after system sleep */
+   if (this->period > 0.0 && preExisting && !pidReused) {
+      float percent_cpu = saturatingSub(lp->utime + lp->stime, lasttimes) / this->period * 100.0;
+      proc->percent_cpu = MINIMUM(percent_cpu, host->activeCPUs * 100.0F);
+   }
+   proc->percent_mem = proc->m_resident / (double)(host->totalMem) * 100.0;
+   Process_updateCPUFieldWidths(proc->percent_cpu);
+
+   if (parent) {
+      LinuxProcessTable_inheritFromProcess(lp, (const LinuxProcess*) parent, 0, task->comm);
+   } else if (!preExisting || pidReused ||
+              (task->comm[0] && proc->procComm && !String_eq(task->comm, proc->procComm) && proc->state != ZOMBIE)) {
+      /* exec renames the process, as the procfs path notices from stat */
+      Process_updateComm(proc, task->comm);
+      if (proc->isKernelThread) {
+         Process_updateCmdline(proc, NULL, 0, 0);
+         proc->isRunningInContainer = false;
+      } else {
+         char name[16];
+         xSnprintf(name, sizeof(name), "%d", (int)task->tid);
+         int pidFd = openat(FsRoot_proc.fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+         if (!preExisting || pidReused)
+            proc->isRunningInContainer = pidFd >= 0 && LinuxProcessTable_readNestedPidNs(pidFd);
+         if (pidFd < 0 || !LinuxProcessTable_readCmdlineFile(proc, pidFd))
+            Process_updateCmdline(proc, task->comm, 0, strlen(task->comm));
+         if (pidFd >= 0)
+            close(pidFd);
       }
+      proc->mergedCommand.lastUpdate = 0;
+   } else {
+      Process_updateComm(proc, task->comm);
+   }
 
-      /*
-       * Final section after all data has been gathered
-       */
+   if (!preExisting) {
+      Process_fillStarttimeBuffer(proc);
+      ProcessTable_add(pt, proc);
+   } else if (pidReused) {
+      Process_fillStarttimeBuffer(proc);
+   }
 
-      proc->super.updated = true;
-      Compat_openatArgClose(procFd);
+   if (!proc->cmdline && task->comm[0] &&
+       (proc->state == ZOMBIE || Process_isKernelThread(proc) || settings->showThreadNames)) {
+      Process_updateCmdline(proc, task->comm, 0, strlen(task->comm));
+   }
 
-      if (hideRunningInContainer && proc->isRunningInContainer) {
-         proc->super.show = false;
+   Table_markUpdated(&pt->super, &proc->super);
+
+   if (Process_isKernelThread(proc)) {
+      pt->kernelThreads++;
+   } else if (Process_isUserlandThread(proc)) {
+      pt->userlandThreads++;
+   }
+
+   proc->super.show = ! ((settings->hideKernelThreads && Process_isKernelThread(proc)) || (settings->hideUserlandThreads && Process_isUserlandThread(proc)) || (settings->hideRunningInContainer && proc->isRunningInContainer));
+
+   LinuxProcessTable_addUserTotals(this, lp);
+
+   pt->totalTasks++;
+}
+
+/*
+ * Takes the whole process list from one read of the pinned BPF task
+ * iterator instead of walking /proc. Only the values dumped by the
+ * iterator are available in this mode. Returns false if the iterator is
+ * not pinned or not readable, so /proc is scanned instead.
+ */
+static bool LinuxProcessTable_scanBpfIter(LinuxProcessTable* this, const LinuxMachine* lhost) {
+   ProcessTable* pt = (ProcessTable*) this;
+   const Settings* settings = lhost->super.settings;
+   BpfTaskList* list = &this->bpfTasks;
+
+   /* the iterator lists the tasks of the running kernel */
+   if (!FsRoot_isDefault(&FsRoot_proc))
+      return false;
+
+   if (!BpfTaskIter_read(list, BPF_TASK_ITER_PATH))
+      return false;
+
+   /* set runningTasks from /proc/stat (from Machine_scanCPUTime) */
+   pt->runningTasks = lhost->runningTasks;
+
+   for (size_t i = 0; i < list->count; ) {
+      const BpfTask* leader = &list->tasks[i];
+      size_t end = i + 1;
+      while (end < list->count && list->tasks[end].tgid == leader->tgid)
+         end++;
+
+      /* threads without their leader are racing with an exec or exit */
+      if (leader->tid != leader->tgid) {
+         i = end;
          continue;
       }
 
-      if (Process_isKernelThread(proc)) {
-         pt->kernelThreads++;
-      } else if (Process_isUserlandThread(proc)) {
+      unsigned long long int utimeNs = leader->exitedUtimeNs;
+      unsigned long long int stimeNs = leader->exitedStimeNs;
+      for (size_t j = i; j < end; j++) {
+         utimeNs += list->tasks[j].utimeNs;
+         stimeNs += list->tasks[j].stimeNs;
+      }
+
+      LinuxProcessTable_updateTask(this, lhost, leader, utimeNs, stimeNs, NULL);
+
+      if (settings->hideUserlandThreads) {
+         pt->userlandThreads += end - i - 1;
+         pt->totalTasks += end - i - 1;
+      } else {
+         const Process* parent = (const Process*) Table_findRow(&pt->super, leader->tid);
+         for (size_t j = i + 1; j < end; j++) {
+            const BpfTask* thread = &list->tasks[j];
+            LinuxProcessTable_updateTask(this, lhost, thread, thread->utimeNs, thread->stimeNs, parent);
+         }
+      }
+
+      i = end;
+   }
+
+   return true;
+}
+
+#endif /* HAVE_BPF_ITER && HAVE_OPENAT */
+
+/* Updates a process or thread from a snapshot of the shared collector, no file is read */
+static void LinuxProcessTable_updateShared(LinuxProcessTable* this, const LinuxMachine* lhost, const SharedScanTask* task, memory_t totalMem) {
+   ProcessTable* pt = (ProcessTable*) this;
+   const Machine* host = &lhost->super;
+   const Settings* settings = host->settings;
+
+   bool preExisting;
+   Process* proc = ProcessTable_getProcess(pt, task->pid, &preExisting, LinuxProcess_new);
+   LinuxProcess* lp = (LinuxProcess*) proc;
+
+   const bool pidReused = preExisting && proc->starttime_ctime != task->starttime;
+
+   Process_setThreadGroup(proc, task->tgid);
+   Process_setParent(proc, task->ppid);
+   proc->isKernelThread = task->kind & SHARED_SCAN_KERNEL_THREAD;
+   proc->isUserlandThread = task->kind & SHARED_SCAN_USERLAND_THREAD;
+   proc->isRunningInContainer = task->kind & SHARED_SCAN_CONTAINER;
+
+   proc->state = (ProcessState) task->state;
+   proc->pgrp = task->pgrp;
+   proc->session = task->session;
+   proc->tpgid = task->tpgid;
+   lp->flags = task->flags;
+   proc->minflt = task->minflt;
+   proc->majflt = task->majflt;
+   lp->utime = task->utime;
+   lp->stime = task->stime;
+   proc->time = lp->utime + lp->stime;
+   proc->priority = task->priority;
+   proc->nice = task->nice;
+   proc->nlwp = task->nlwp;
+   proc->processor = task->processor;
+   proc->starttime_ctime = task->starttime;
+
+   proc->m_virt = task->mVirt;
+   proc->m_resident = task->mResident;
+   lp->m_share = task->mShare;
+   lp->m_priv = task->mPriv;
+
+   if (task->ttyNr != proc->tty_nr || !preExisting) {
+      proc->tty_nr = task->ttyNr;
+      free(proc->tty_name);
+      proc->tty_name = LinuxProcessTable_getTtyDrivers(this) ? LinuxProcessTable_updateTtyDevice(this->ttyDrivers, proc->tty_nr) : NULL;
+   }
+
+   if (proc->st_uid != task->uid || !proc->user) {
+      proc->st_uid = task->uid;
+      proc->user = UsersTable_getRef(host->usersTable, task->uid);
+   }
+
+   proc->percent_cpu = isNonnegative(task->percentCpu) ? MINIMUM(task->percentCpu, host->activeCPUs * 100.0F) : NAN;
+   proc->percent_mem = proc->m_resident / (double)totalMem * 100.0;
+   Process_updateCPUFieldWidths(proc->percent_cpu);
+
+   Process_updateComm(proc, task->comm[0] ? task->comm : NULL);
+   if (task->cmdline[0])
+      Process_updateCmdline(proc, task->cmdline, task->cmdlineBasenameStart, task->cmdlineBasenameEnd);
+   else if (proc->state == ZOMBIE || Process_isKernelThread(proc) || settings->showThreadNames)
+      Process_updateCmdline(proc, task->comm[0] ? task->comm : NULL, 0, (int)strlen(task->comm));
+   else
+      Process_updateCmdline(proc, NULL, 0, 0);
+
+   if (!preExisting) {
+      Process_fillStarttimeBuffer(proc);
+      ProcessTable_add(pt, proc);
+   } else if (pidReused) {
+      Process_fillStarttimeBuffer(proc);
+      proc->mergedCommand.lastUpdate = 0;
+   }
+
+   Table_markUpdated(&pt->super, &proc->super);
+
+   if (Process_isKernelThread(proc)) {
+      pt->kernelThreads++;
+   } else if (Process_isUserlandThread(proc)) {
+      pt->userlandThreads++;
+   }
+
+   proc->super.show = ! ((settings->hideKernelThreads && Process_isKernelThread(proc)) || (settings->hideUserlandThreads && Process_isUserlandThread(proc)) || (settings->hideRunningInContainer && proc->isRunningInContainer));
+
+   pt->totalTasks++;
+}
+
+/*
+ * Takes the whole process list from the latest scan of `htop --serve`
+ * instead of walking /proc. Only the values in the snapshot are
+ * available in this mode. Returns false without a live collector, so
+ * /proc is scanned instead; a collector streaming from another machine
+ * only leaves the list empty while it can not be reached.
+ */
+static bool LinuxProcessTable_scanShared(LinuxProcessTable* this, const LinuxMachine* lhost) {
+   ProcessTable* pt = (ProcessTable*) this;
+   const Settings* settings = lhost->super.settings;
+
+   if (SharedScan_mode != SHARED_SCAN_ATTACH)
+      return false;
+
+   const SharedScanSnapshot* snap = SharedScan_read();
+   if (!snap)
+      return false;
+
+   pt->runningTasks = snap->runningTasks;
+
+   /* streamed from another machine, the memory of that one */
+   const memory_t totalMem = snap->totalMem ? snap->totalMem : lhost->super.totalMem;
+
+   for (size_t i = 0; i < snap->count; i++) {
+      const SharedScanTask* task = &snap->tasks[i];
+
+      if (settings->hideUserlandThreads && (task->kind & SHARED_SCAN_USERLAND_THREAD)) {
          pt->userlandThreads++;
+         pt->totalTasks++;
+         continue;
       }
 
-      /* Set at the end when we know if a new entry is a thread */
-      proc->super.show = ! ((hideKernelThreads && Process_isKernelThread(proc)) || (hideUserlandThreads && Process_isUserlandThread(proc)));
+      LinuxProcessTable_updateShared(this, lhost, task, totalMem);
+   }
+
+   return true;
+}
+
+typedef struct LinuxProcessTableReplayData_ {
+   LinuxProcessTable* this;
+   const Machine* host;
+} LinuxProcessTableReplayData;
+
+/* Updates a process or thread from the frame of a recording shown */
+static void LinuxProcessTable_updateReplay(const ReplayProcess* rp, const char* comm, const char* cmdline, void* data) {
+   const LinuxProcessTableReplayData* rd = data;
+   ProcessTable* pt = (ProcessTable*) rd->this;
+   const Machine* host = rd->host;
+   const Settings* settings = host->settings;
+   const int64_t* values = rp->values;
 
+   const bool isUserlandThread = values[RECORDER_PROCESS_KIND] & 2;
+   if (settings->hideUserlandThreads && isUserlandThread) {
+      pt->userlandThreads++;
       pt->totalTasks++;
-      /* runningTasks is set in Machine_scanCPUTime() from /proc/stat */
-      continue;
+      return;
+   }
+
+   bool preExisting;
+   Process* proc = ProcessTable_getProcess(pt, rp->pid, &preExisting, LinuxProcess_new);
+   LinuxProcess* lp = (LinuxProcess*) proc;
+
+   const bool pidReused = preExisting && proc->starttime_ctime != values[RECORDER_PROCESS_STARTTIME];
+
+   Process_setThreadGroup(proc, (pid_t) values[RECORDER_PROCESS_TGID]);
+   Process_setParent(proc, (pid_t) values[RECORDER_PROCESS_PPID]);
+   proc->isKernelThread = values[RECORDER_PROCESS_KIND] & 1;
+   proc->isUserlandThread = isUserlandThread;
+
+   proc->state = (ProcessState) values[RECORDER_PROCESS_STATE];
+   lp->utime = (unsigned long long int) values[RECORDER_PROCESS_TIME];
+   lp->stime = 0;
+   proc->time = lp->utime;
+   proc->priority = (long int) values[RECORDER_PROCESS_PRIORITY];
+   proc->nice = (long int) values[RECORDER_PROCESS_NICE];
+   proc->nlwp = (long int) values[RECORDER_PROCESS_NLWP];
+   proc->processor = (int) values[RECORDER_PROCESS_PROCESSOR];
+   proc->starttime_ctime = (time_t) values[RECORDER_PROCESS_STARTTIME];
+   proc->m_virt = (long) values[RECORDER_PROCESS_VIRT];
+   proc->m_resident = (long) values[RECORDER_PROCESS_RES];
+
+   if (proc->st_uid != (uid_t) values[RECORDER_PROCESS_UID] || !proc->user) {
+      proc->st_uid = (uid_t) values[RECORDER_PROCESS_UID];
+      proc->user = UsersTable_getRef(host->usersTable, proc->st_uid);
+   }
 
-      // Exception handler.
+   proc->percent_cpu = values[RECORDER_PROCESS_CPU] >= 0 ? (float) values[RECORDER_PROCESS_CPU] / 10.0F : NAN;
+   proc->percent_mem = values[RECORDER_PROCESS_MEM] >= 0 ? (float) values[RECORDER_PROCESS_MEM] / 10.0F : NAN;
+   Process_updateCPUFieldWidths(proc->percent_cpu);
+
+   Process_updateComm(proc, comm);
+   if (cmdline && cmdline[0]) {
+      const char* basenameEnd = strchr(cmdline, '\n');
+      int end = basenameEnd ? (int)(basenameEnd - cmdline) : (int)strlen(cmdline);
+      int start = 0;
+      for (int i = 0; i < end; i++) {
+         if (cmdline[i] == '/')
+            start = i + 1;
+      }
+      if (start == end)
+         start = 0;
+      Process_updateCmdline(proc, cmdline, start, end);
+   } else {
+      Process_updateCmdline(proc, NULL, 0, 0);
+   }
 
-errorReadingProcess:
-      {
-#ifdef HAVE_OPENAT
-         if (procFd >= 0)
-            close(procFd);
+   if (!preExisting) {
+      Process_fillStarttimeBuffer(proc);
+      ProcessTable_add(pt, proc);
+   } else if (pidReused) {
+      Process_fillStarttimeBuffer(proc);
+      proc->mergedCommand.lastUpdate = 0;
+   }
+
+   Table_markUpdated(&pt->super, &proc->super);
+
+   if (Process_isKernelThread(proc)) {
+      pt->kernelThreads++;
+   } else if (Process_isUserlandThread(proc)) {
+      pt->userlandThreads++;
+   }
+
+   proc->super.show = ! ((settings->hideKernelThreads && Process_isKernelThread(proc)) || (settings->hideUserlandThreads && Process_isUserlandThread(proc)));
+
+   pt->totalTasks++;
+}
+
+/*
+ * Shows the next frame of the recording given to --replay, or the one
+ * stepped or jumped to, instead of walking /proc. The memory of the
+ * machine is taken from the same frame, so the meters match the rows.
+ */
+static bool LinuxProcessTable_scanReplay(LinuxProcessTable* this) {
+   ProcessTable* pt = (ProcessTable*) this;
+   Machine* host = pt->super.host;
+
+   if (!Replay_isOpen())
+      return false;
+
+   Replay_advance();
+
+   host->totalMem = (memory_t) Replay_machineValue(RECORDER_MACHINE_TOTAL_MEM);
+   host->usedMem = (memory_t) Replay_machineValue(RECORDER_MACHINE_USED_MEM);
+   host->buffersMem = (memory_t) Replay_machineValue(RECORDER_MACHINE_BUFFERS_MEM);
+   host->cachedMem = (memory_t) Replay_machineValue(RECORDER_MACHINE_CACHED_MEM);
+   host->sharedMem = (memory_t) Replay_machineValue(RECORDER_MACHINE_SHARED_MEM);
+   host->availableMem = (memory_t) Replay_machineValue(RECORDER_MACHINE_AVAILABLE_MEM);
+   host->totalSwap = (memory_t) Replay_machineValue(RECORDER_MACHINE_TOTAL_SWAP);
+   host->usedSwap = (memory_t) Replay_machineValue(RECORDER_MACHINE_USED_SWAP);
+   host->cachedSwap = (memory_t) Replay_machineValue(RECORDER_MACHINE_CACHED_SWAP);
+   pt->runningTasks = (unsigned int) Replay_machineValue(RECORDER_MACHINE_RUNNING_TASKS);
+
+   LinuxProcessTableReplayData rd = { .this = this, .host = host };
+   Replay_foreachProcess(LinuxProcessTable_updateReplay, &rd);
+
+   return true;
+}
+
+/* Reads the processes in whichever way this scan can: replayed, shared, prefetched, or from /proc */
+static void LinuxProcessTable_scanProcesses(LinuxProcessTable* this, const LinuxMachine* lhost, const Settings* settings) {
+   ProcessTable* super = &this->super;
+
+   if (LinuxProcessTable_scanReplay(this))
+      return;
+
+   if (LinuxProcessTable_scanShared(this, lhost))
+      return;
+
+#if defined(HAVE_PTHREAD) && defined(HAVE_OPENAT)
+   /* the process events were already read when the scan was started ahead */
+   if (LinuxProcessTable_finishPrefetch(this, lhost))
+      return;
 #endif
 
-         if (preExisting) {
-            /*
-             * The only real reason for coming here (apart from Linux violating the /proc API)
-             * would be the process going away with its /proc files disappearing (!HAVE_OPENAT).
-             * However, we want to keep in the process list for now for the "highlight dying" mode.
-             */
-         } else {
-            /* A really short-lived process that we don't have full info about */
-            Process_delete((Object*)proc);
-         }
+#ifdef HAVE_PROC_CONNECTOR
+   LinuxProcessTable_readProcEvents(this, settings);
+#endif
+
+   /* The serial scan skips filtered out processes before reading them, the others read all */
+   if (!LinuxProcessTable_isFiltered(super)) {
+#if defined(HAVE_BPF_ITER) && defined(HAVE_OPENAT)
+      if (LinuxProcessTable_scanBpfIter(this, lhost))
+         return;
+#endif
+
+#if defined(HAVE_PTHREAD) && defined(HAVE_OPENAT)
+      if (LinuxProcessTable_scanThreads(settings) && LinuxProcessTable_scanParallel(this, lhost))
+         return;
+#endif
+   }
+
+   LinuxProcessTable_recurseProcTree(this, FsRoot_dir(&FsRoot_proc), lhost, ".", NULL);
+}
+
+/* pidfds held at most, the exit of further tagged processes is noticed by the scans */
+#define LINUX_MAX_PIDFDS 256
+
+/*
+ * Holds a pidfd of each tagged process and of the followed one, polled
+ * with the terminal so that their exit is shown right away and signals
+ * cannot hit a reused PID. The pidfds of processes that exited or are no
+ * longer watched are closed.
+ */
+static void LinuxProcessTable_updateExitFds(LinuxProcessTable* this) {
+   ProcessTable* pt = &this->super;
+   const Table* table = &pt->super;
+   pt->exitFdCount = 0;
+
+   const Vector* rows = table->rows;
+   for (int i = 0; i < Vector_size(rows); i++) {
+      LinuxProcess* lp = (LinuxProcess*) Vector_get(rows, i);
+      const Row* row = &lp->super.super;
+
+      bool watched = (row->tag || row->id == table->following) &&
+                     Table_isUpdated(table, row) &&
+                     lp->super.state != ZOMBIE &&
+                     pt->exitFdCount < LINUX_MAX_PIDFDS;
+      if (watched && lp->pidfd < 0)
+         lp->pidfd = LinuxProcess_openPidfd(&lp->super);
+      if (lp->pidfd < 0)
+         continue;
+
+      /* exited since it was read */
+      if (watched) {
+         struct pollfd pfd = { .fd = lp->pidfd, .events = POLLIN };
+         watched = poll(&pfd, 1, 0) == 0;
       }
+
+      if (!watched) {
+         close(lp->pidfd);
+         lp->pidfd = -1;
+         continue;
+      }
+
+      ProcessTable_addExitFd(pt, lp->pidfd);
    }
-   closedir(dir);
-   return true;
 }
 
 void ProcessTable_goThroughEntries(ProcessTable* super) {
@@ -1656,13 +3878,86 @@ void ProcessTable_goThroughEntries(ProcessTable* super) {
       this->haveAutogroup = false;
    }
 
-   /* PROCDIR is an absolute path */
-   assert(PROCDIR[0] == '/');
+   /* The CPU times may be sampled more often than this table is scanned;
+      on the first scan there is nothing to compare with, CPU% shows as N/A */
+   const unsigned long long int totalTime = lhost->cpuData[0].totalTime;
+   this->period = this->lastTotalTime ? (double)saturatingSub(totalTime, this->lastTotalTime) / host->activeCPUs : 0.0;
+   this->lastTotalTime = totalTime;
+
+   LinuxProcessTable_resetCollectorBudgets(this);
+   LinuxProcessTable_updateLazyFlags(this, settings);
 #ifdef HAVE_OPENAT
-   openat_arg_t rootFd = AT_FDCWD;
-#else
-   openat_arg_t rootFd = "";
+   LinuxProcessTable_countProcFds(this);
+#endif
+   ContainerNames_update(settings->containerNames);
+   this->cmdlineRound++;
+   LibraryCache_beginCycle(this->libraryCache);
+   UserTotalsList_clear(&this->userTotals);
+   WaitChannelList_clear(&this->waitChannels);
+   GPUTotals_clear(&this->gpuTotals);
+
+   /* the user screen sums up values only read for the columns of process screens */
+   const bool userTotalsShown = host->activeTable && Object_isA((const Object*) host->activeTable, (const ObjectClass*) &UserTotalsTable_class);
+   this->tableFlags = userTotalsShown ? USERTOTALS_PROCESS_FLAGS : 0;
+   this->waitChannelsShown = host->activeTable && Object_isA((const Object*) host->activeTable, (const ObjectClass*) &WaitChannelTable_class);
+   this->occupancyShown = host->activeTable && Object_isA((const Object*) host->activeTable, (const ObjectClass*) &CPUOccupancyTable_class);
+   if (this->occupancyShown)
+      this->tableFlags |= PROCESS_FLAG_LINUX_MIGRATE;
+   this->exitedShown = host->activeTable && Object_isA((const Object*) host->activeTable, (const ObjectClass*) &ExitedTaskTable_class);
+   this->guestsShown = host->activeTable && Object_isA((const Object*) host->activeTable, (const ObjectClass*) &GuestTable_class);
+   if (GPU_meters > 0)
+      this->tableFlags |= PROCESS_FLAG_LINUX_GPU;
+
+   /* the other process screens have their values read now and then, so
+      their rates are known right away when switching to them */
+   this->warmFlags = 0;
+   if (settings->warmScreens && !Budget_onBattery && host->monotonicMs >= this->nextWarmMs) {
+      this->warmFlags = LinuxProcessTable_otherScreensFlags(settings, host->processTable) & ~(settings->ss->flags | this->tableFlags);
+      this->nextWarmMs = host->monotonicMs + LINUX_WARM_INTERVAL_MS;
+   }
+
+   if ((settings->ss->flags | this->tableFlags | this->warmFlags) & PROCESS_FLAG_LINUX_LOCKS)
+      LockIndex_refresh(host->monotonicMs);
+
+   /* the processes of all GPUs in a few calls, once per scan */
+   if ((settings->ss->flags | this->tableFlags | this->warmFlags) & PROCESS_FLAG_LINUX_NVML) {
+      NVML_refresh(true);
+   } else if (NVML_meters > 0) {
+      NVML_refresh(false);
+   }
+
+   /* the programs of the columns shown attached, their whole maps in a few batched reads, once per scan */
+   #ifdef HAVE_BPF_COLUMNS
+   Bpf_refresh(LinuxProcessTable_bpfSources(settings->ss->flags | this->tableFlags | this->warmFlags), host->monotonicMs);
+   #endif
+
+   /* before the scan: the rows still tell what was seen of the processes that exited since */
+   if (ExitedTasks_meters > 0 || this->exitedShown) {
+      ExitedTasks_refresh(host->processTable, host->monotonicMs);
+   } else {
+      ExitedTasks_stop();
+   }
+
+   /* Hidden threads are not scanned at all: drop the rows instead of showing them as exited */
+   if (settings->hideUserlandThreads && this->threadsListed) {
+      const Vector* rows = super->super.rows;
+      for (int i = 0; i < Vector_size(rows); i++) {
+         Row* row = (Row*) Vector_get(rows, i);
+         if (Process_isUserlandThread((const Process*) row))
+            row->show = false;
+      }
+   }
+   this->threadsListed = !settings->hideUserlandThreads;
+
+   LinuxProcessTable_scanProcesses(this, lhost, settings);
+#ifdef HAVE_PROC_CONNECTOR
+   LinuxProcessTable_addShortLived(this, lhost);
 #endif
+   LinuxProcessTable_updateExitFds(this);
+   ProcessChurn_update(&super->super, host->monotonicMs);
 
-   LinuxProcessTable_recurseProcTree(this, rootFd, lhost, PROCDIR, NULL);
+#ifdef HAVE_DELAYACCT
+   LinuxProcessTable_flushDelayAcct(this);
+#endif
 }
+
@@ -8,10 +8,33 @@ in the source distribution for its full text.
 */
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
 
+#include "Hashtable.h"
+#include "Machine.h"
 #include "ProcessTable.h"
+#include "Vector.h"
+#include "linux/BpfTaskIter.h"
+#include "linux/CGroupCache.h"
+#include "linux/GPU.h"
+#include "linux/LibraryCache.h"
+#include "linux/LinuxProcess.h"
+#include "linux/ProcDirList.h"
+#include "linux/ProcScanPool.h"
+#include "linux/UserTotalsTable.h"
+#include "linux/WaitChannelTable.h"
 
 
+/* Buffer sizes for reading the per-task files in /proc/<pid> */
+#define PROC_PID_STAT_BUFSIZE   (MAX_READ + 1)
+#define PROC_PID_STATM_BUFSIZE  256
+#define PROC_PID_STATUS_BUFSIZE 16384
+#define PROC_PID_IO_BUFSIZE     1024
+#define PROC_PID_SCHEDSTAT_BUFSIZE 96
+#define PROC_PID_CGROUP_BUFSIZE 8192
+
 typedef struct TtyDriver_ {
    char* path;
    unsigned int major;
@@ -19,17 +42,138 @@ typedef struct TtyDriver_ {
    unsigned int minorTo;
 } TtyDriver;
 
+#ifdef HAVE_DELAYACCT
+/* Taskstats requests sent before their replies are read */
+#define LINUX_DELAYACCT_WINDOW 64
+#endif
+
+#ifdef HAVE_PROC_CONNECTOR
+/* A process the events reported to be forked since the last scan */
+typedef struct LinuxForkedProcess_ {
+   pid_t pid;
+   pid_t ppid;
+   unsigned long long int startNs;  /* since boot */
+   char comm[16];                   /* the parent's or of a comm event, empty after exec */
+   bool exited;
+} LinuxForkedProcess;
+#endif
+
 typedef struct LinuxProcessTable_ {
    ProcessTable super;
 
    TtyDriver* ttyDrivers;
+   bool ttyDriversRead;
+   CGroupCache* cgroupCache;
+   const char* cgroupRoot;       /* of the v2 hierarchy below FsRoot_sys, NULL if it is not mounted */
+   LibraryCache* libraryCache;   /* files mapped, shared by the maps reads of all processes */
    bool haveSmapsRollup;
+   bool haveProcmapQuery;
    bool haveAutogroup;
 
    #ifdef HAVE_DELAYACCT
    struct nl_sock* netlink_socket;
    int netlink_family;
+   /* Tasks whose taskstats are requested together, replies are matched by pid */
+   pid_t delayAcctQueue[LINUX_DELAYACCT_WINDOW];
+   size_t delayAcctQueued;
+   /* The kernel refused the requests (no CAP_NET_ADMIN), schedstat is read instead */
+   bool delayAcctDenied;
+   #endif
+
+   /* CPU time passed since the last scan of this table, per CPU */
+   double period;
+   unsigned long long int lastTotalTime;
+
+   /* Reads left in this scan for each LinuxCollector */
+   unsigned int collectorBudget[LINUX_COLLECTOR_COUNT];
+
+   /* Profile phases timing the reads of each LinuxCollector */
+   int collectorPhase[LINUX_COLLECTOR_COUNT];
+
+   /* PROCESS_FLAG_* collectors skipped for rows not on screen in this scan */
+   uint64_t lazyFlags;
+
+   /* PROCESS_FLAG_* collectors of the column the active screen is sorted by, read for all rows */
+   uint64_t sortFlags;
+
+   /* PROCESS_FLAG_* collectors the table shown needs on top of the ones of the screen */
+   uint64_t tableFlags;
+
+   /* PROCESS_FLAG_* collectors of the other process screens read in this scan, see Settings.warmScreens */
+   uint64_t warmFlags;
+   uint64_t nextWarmMs;
+
+   /* Scans so far, a process has its command line reread every LINUX_CMDLINE_ROUNDS of them */
+   unsigned int cmdlineRound;
+
+   /* Per UID totals of the processes read in this scan, for the UserTotalsTable */
+   UserTotalsList userTotals;
+
+   /* Tasks sleeping per kernel function, read in this scan only while the WaitChannelTable is shown */
+   WaitChannelList waitChannels;
+   bool waitChannelsShown;
+
+   /* The CPUOccupancyTable is shown, which needs the migrations of all tasks */
+   bool occupancyShown;
+
+   /* The ExitedTaskTable is shown, which needs the exit records of taskstats */
+   bool exitedShown;
+
+   /* The GuestTable is shown, which needs the run queue wait of the vCPU threads */
+   bool guestsShown;
+
+   /* GPU usage summed over the processes read in this scan, for the GPUMeter */
+   GPUTotals gpuTotals;
+
+   /* Whether the last scan walked the task directories */
+   bool threadsListed;
+
+   /* Entries of /proc and of the task directory currently scanned */
+   ProcDirList procList;
+   ProcDirList taskList;
+
+   #ifdef HAVE_OPENAT
+   /* Maximum number of /proc/<pid> directory fds cached on the processes */
+   size_t procFdLimit;
+   /* Number of those fds cached, recounted at the start of each scan as rows go */
+   size_t procFdCount;
+   /* Lowest fd number used for cached fds (keeps select(2) users below FD_SETSIZE) */
+   int procFdMin;
+   #endif
+
+   #ifdef HAVE_PROC_CONNECTOR
+   int procConnectorFd;           /* -1 if not subscribed to process events */
+   bool procConnectorFailed;      /* subscribing failed, do not retry */
+   bool procEventsComplete;       /* no events were lost since the last scan */
+   bool procListFromEvents;       /* procList was built from events instead of reading /proc */
+   unsigned int procEventScans;   /* scans since /proc was last listed */
+   LinuxForkedProcess* forked;    /* new processes reported since the last scan */
+   size_t forkedCount;
+   size_t forkedAlloc;
+   Hashtable* forkedIndex;        /* index + 1 in forked by pid */
+   #endif
+
+   #ifdef HAVE_BPF_ITER
+   BpfTaskList bpfTasks;          /* last snapshot read from the pinned task iterator */
+   #endif
+
+   #ifdef HAVE_PTHREAD
+   ProcScanPool* scanPool;
+   unsigned int scanPoolThreads;
+   VectorRunner sortRunner;       /* the scan pool, for sorts of many processes */
+   ProcScanTask* scanTasks;
+   size_t scanTasksAlloc;
+   int scanDirFd;                 /* /proc of the scan handed to the pool, -1 if none is pending */
+   ProcScanOptions scanOptions;
+   uint64_t scanStartMs;
    #endif
 } LinuxProcessTable;
 
+/* Monotonic time in nanoseconds, what the run times of schedstat are compared with */
+static inline uint64_t LinuxProcessTable_monotonicNs(void) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
 #endif
@@ -0,0 +1,114 @@
+/*
+htop - linux/LockIndex.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/LockIndex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Hashtable.h"
+#include "XUtils.h"
+#include "linux/FsRoot.h"
+
+
+static Hashtable* LockIndex_byPid;     /* pid to the unsigned int count of locks it holds */
+static size_t LockIndex_lines;
+static uint64_t LockIndex_readMs;      /* 0 if never read */
+static bool LockIndex_valid;
+
+/* Skips a word and the blanks after it */
+static const char* LockIndex_skipWord(const char* s) {
+   while (*s && *s != ' ')
+      s++;
+   while (*s == ' ')
+      s++;
+   return s;
+}
+
+/*
+ * Parses a line like "1: POSIX  ADVISORY  WRITE 1234 08:02:131074 0 EOF",
+ * or "1: -> FLOCK  ADVISORY  WRITE 5678 ..." for a waiter, without scanf
+ * as there can be very many of them. OFD locks have no owner, -1.
+ */
+static void LockIndex_parseLine(const char* line) {
+   LockIndex_lines++;
+
+   const char* s = LockIndex_skipWord(line);
+   if (String_startsWith(s, "->"))
+      return;
+
+   /* type, exclusion and access */
+   for (int i = 0; i < 3; i++)
+      s = LockIndex_skipWord(s);
+
+   char* end;
+   long pid = strtol(s, &end, 10);
+   if (end == s || *end != ' ' || pid <= 0)
+      return;
+
+   unsigned int* held = Hashtable_get(LockIndex_byPid, (ht_key_t)pid);
+   if (!held) {
+      held = xCalloc(1, sizeof(unsigned int));
+      Hashtable_put(LockIndex_byPid, (ht_key_t)pid, held);
+   }
+   (*held)++;
+}
+
+bool LockIndex_refresh(uint64_t monotonicMs) {
+   if (LockIndex_readMs && monotonicMs - LockIndex_readMs < LOCKINDEX_TTL_MS)
+      return LockIndex_valid;
+
+   LockIndex_readMs = monotonicMs ? monotonicMs : 1;
+   LockIndex_lines = 0;
+   if (LockIndex_byPid)
+      Hashtable_clear(LockIndex_byPid);
+   else
+      LockIndex_byPid = Hashtable_new(64, true);
+
+   FILE* f = FsRoot_fopen(&FsRoot_proc, "locks", "r");
+   LockIndex_valid = f != NULL;
+   if (!f)
+      return false;
+
+   char line[256];
+   bool lineStart = true;
+   while (fgets(line, sizeof(line), f)) {
+      /* the rest of an overlong line */
+      bool complete = strchr(line, '\n') != NULL;
+      if (lineStart)
+         LockIndex_parseLine(line);
+      lineStart = complete;
+   }
+   fclose(f);
+
+   return true;
+}
+
+unsigned int LockIndex_held(pid_t pid) {
+   if (!LockIndex_byPid || pid <= 0)
+      return 0;
+
+   const unsigned int* held = Hashtable_get(LockIndex_byPid, (ht_key_t)pid);
+   return held ? *held : 0;
+}
+
+size_t LockIndex_total(void) {
+   return LockIndex_lines;
+}
+
+void LockIndex_cleanup(void) {
+   if (LockIndex_byPid) {
+      Hashtable_delete(LockIndex_byPid);
+      LockIndex_byPid = NULL;
+   }
+   LockIndex_readMs = 0;
+   LockIndex_lines = 0;
+   LockIndex_valid = false;
+}
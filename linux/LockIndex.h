@@ -0,0 +1,34 @@
+#ifndef HEADER_LockIndex
+#define HEADER_LockIndex
+/*
+htop - linux/LockIndex.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+
+/* /proc/locks is read again at most this often, whoever asks */
+#define LOCKINDEX_TTL_MS 1000
+
+/*
+ * Reads /proc/locks in one pass into the number of locks held by each
+ * process, unless it was read less than LOCKINDEX_TTL_MS before.
+ * Returns false if it could not be read.
+ */
+bool LockIndex_refresh(uint64_t monotonicMs);
+
+/* Locks held by the process as of the last read; waiting for one does not count */
+unsigned int LockIndex_held(pid_t pid);
+
+/* Locks listed by the last read, held or waited for by any process */
+size_t LockIndex_total(void);
+
+void LockIndex_cleanup(void);
+
+#endif
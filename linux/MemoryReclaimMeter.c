@@ -0,0 +1,243 @@
+/*
+htop - linux/MemoryReclaimMeter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/MemoryReclaimMeter.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CRT.h"
+#include "Machine.h"
+#include "Macros.h"
+#include "Object.h"
+#include "Rate.h"
+#include "RichString.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+#include "linux/SourceCache.h"
+
+
+/* Free memory is fragmented as far as it is not in blocks of this order, huge pages on x86 */
+#define RECLAIM_FRAGMENTATION_ORDER 9
+
+/* Orders of free blocks /proc/buddyinfo may list */
+#define RECLAIM_MAX_ORDERS 16
+
+typedef enum ReclaimCounter_ {
+   RECLAIM_SCAN_BACKGROUND,   /* by kswapd, khugepaged and proactive reclaim */
+   RECLAIM_SCAN_DIRECT,       /* by allocations waiting for the pages */
+   RECLAIM_STEAL,
+   RECLAIM_ALLOC_STALL,       /* allocations entering direct reclaim */
+   RECLAIM_COMPACT_STALL,     /* allocations entering direct compaction */
+   RECLAIM_THP_FALLBACK,      /* huge page faults served with small pages */
+   RECLAIM_COUNTERS
+} ReclaimCounter;
+
+/* The lines of /proc/vmstat summed up into each counter */
+static const struct {
+   const char* name;
+   ReclaimCounter counter;
+} MemoryReclaimMeter_fields[] = {
+   { "pgscan_kswapd", RECLAIM_SCAN_BACKGROUND },
+   { "pgscan_khugepaged", RECLAIM_SCAN_BACKGROUND },
+   { "pgscan_proactive", RECLAIM_SCAN_BACKGROUND },
+   { "pgscan_direct", RECLAIM_SCAN_DIRECT },
+   { "pgsteal_kswapd", RECLAIM_STEAL },
+   { "pgsteal_khugepaged", RECLAIM_STEAL },
+   { "pgsteal_proactive", RECLAIM_STEAL },
+   { "pgsteal_direct", RECLAIM_STEAL },
+   { "allocstall_dma", RECLAIM_ALLOC_STALL },
+   { "allocstall_dma32", RECLAIM_ALLOC_STALL },
+   { "allocstall_normal", RECLAIM_ALLOC_STALL },
+   { "allocstall_movable", RECLAIM_ALLOC_STALL },
+   { "allocstall_device", RECLAIM_ALLOC_STALL },
+   { "compact_stall", RECLAIM_COMPACT_STALL },
+   { "thp_fault_fallback", RECLAIM_THP_FALLBACK },
+};
+
+/* Read once per update for all meters, the files kept open */
+typedef struct ReclaimState_ {
+   FsRootFile* vmstat;
+   FsRootFile* buddyinfo;
+   Rate rates[RECLAIM_COUNTERS];
+   double values[RECLAIM_COUNTERS]; /* per second, NAN while unknown */
+   double fragmentation;            /* percent of the free memory, NAN if unknown */
+} ReclaimState;
+
+static ReclaimState MemoryReclaimMeter_state;
+
+static const int MemoryReclaimMeter_attributes[] = {
+   METER_VALUE,
+};
+
+static void MemoryReclaimMeter_readVmstat(ReclaimState* this, uint64_t monotonicMs) {
+   unsigned long long counters[RECLAIM_COUNTERS] = { 0 };
+   bool found[RECLAIM_COUNTERS] = { false };
+
+   char* content = FsRoot_readKept(&FsRoot_proc, &this->vmstat, "vmstat", NULL);
+   for (char* line = content, *next; line && *line; line = next) {
+      next = strchr(line, '\n');
+      if (next)
+         *next++ = '\0';
+
+      char* value = strchr(line, ' ');
+      if (!value)
+         continue;
+      *value++ = '\0';
+
+      for (size_t i = 0; i < ARRAYSIZE(MemoryReclaimMeter_fields); i++) {
+         if (String_eq(line, MemoryReclaimMeter_fields[i].name)) {
+            ReclaimCounter counter = MemoryReclaimMeter_fields[i].counter;
+            counters[counter] += strtoull(value, NULL, 10);
+            found[counter] = true;
+            break;
+         }
+      }
+   }
+
+   /* counters the kernel does not have stay unknown */
+   for (size_t i = 0; i < RECLAIM_COUNTERS; i++)
+      this->values[i] = Rate_update(&this->rates[i], found[i] ? counters[i] : ULLONG_MAX, monotonicMs);
+}
+
+/*
+ * The share of the free memory not in blocks of RECLAIM_FRAGMENTATION_ORDER
+ * or more, over all zones: what an allocation of that order cannot use
+ * without compaction.
+ */
+static void MemoryReclaimMeter_readBuddyinfo(ReclaimState* this) {
+   this->fragmentation = NAN;
+
+   char* content = FsRoot_readKept(&FsRoot_proc, &this->buddyinfo, "buddyinfo", NULL);
+   if (!content)
+      return;
+
+   double freePages = 0.0;
+   double usable = 0.0;
+   for (char* line = content, *next; line && *line; line = next) {
+      next = strchr(line, '\n');
+      if (next)
+         *next++ = '\0';
+
+      /* "Node 0, zone   Normal   9928   2800 ..." */
+      char* counts = strstr(line, "zone");
+      if (!counts)
+         continue;
+      counts += strlen("zone");
+      while (*counts == ' ')
+         counts++;
+      counts = strchr(counts, ' ');
+      if (!counts)
+         continue;
+
+      unsigned long long blocks[RECLAIM_MAX_ORDERS];
+      unsigned int orders = 0;
+      for (char* end; orders < RECLAIM_MAX_ORDERS; counts = end) {
+         blocks[orders] = strtoull(counts, &end, 10);
+         if (end == counts)
+            break;
+         orders++;
+      }
+      if (orders == 0)
+         continue;
+
+      const unsigned int wanted = MINIMUM(RECLAIM_FRAGMENTATION_ORDER, orders - 1);
+      for (unsigned int order = 0; order < orders; order++) {
+         const double pages = (double)blocks[order] * (double)(1ULL << order);
+         freePages += pages;
+         if (order >= wanted)
+            usable += pages;
+      }
+   }
+
+   if (freePages > 0.0)
+      this->fragmentation = 100.0 * (1.0 - usable / freePages);
+}
+
+/* Event rates, like "950", "12.3k" or "4.5M" */
+static int MemoryReclaimMeter_formatRate(char* buffer, size_t size, double rate) {
+   if (isnan(rate))
+      return xSnprintf(buffer, size, "N/A");
+   if (rate < 1000.0)
+      return xSnprintf(buffer, size, "%.0f/s", rate);
+   if (rate < 1000000.0)
+      return xSnprintf(buffer, size, "%.1fk/s", rate / 1000.0);
+   return xSnprintf(buffer, size, "%.1fM/s", rate / 1000000.0);
+}
+
+static double MemoryReclaimMeter_scanned(const ReclaimState* this) {
+   return this->values[RECLAIM_SCAN_BACKGROUND] + this->values[RECLAIM_SCAN_DIRECT];
+}
+
+static void MemoryReclaimMeter_updateValues(Meter* this) {
+   ReclaimState* state = &MemoryReclaimMeter_state;
+
+   if (SourceCache_isStale(SOURCE_VMSTAT))
+      MemoryReclaimMeter_readVmstat(state, this->host->monotonicMs);
+   if (SourceCache_isStale(SOURCE_BUDDYINFO))
+      MemoryReclaimMeter_readBuddyinfo(state);
+
+   this->curItems = 1;
+   this->values[0] = state->fragmentation;
+
+   char stalls[24];
+   MemoryReclaimMeter_formatRate(stalls, sizeof(stalls), state->values[RECLAIM_ALLOC_STALL] + state->values[RECLAIM_COMPACT_STALL]);
+   if (isnan(state->fragmentation)) {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "%s stalls", stalls);
+   } else {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "%.0f%% frag, %s stalls", state->fragmentation, stalls);
+   }
+}
+
+static void MemoryReclaimMeter_appendRate(RichString* out, double rate, bool warn, const char* label) {
+   char buffer[24];
+   int len = MemoryReclaimMeter_formatRate(buffer, sizeof(buffer), rate);
+   RichString_appendnAscii(out, CRT_colors[warn && rate > 0.0 ? METER_VALUE_WARN : METER_VALUE], buffer, len);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], label);
+}
+
+static void MemoryReclaimMeter_display(ATTR_UNUSED const Object* cast, RichString* out) {
+   const ReclaimState* state = &MemoryReclaimMeter_state;
+
+   MemoryReclaimMeter_appendRate(out, MemoryReclaimMeter_scanned(state), false, " scanned (");
+   MemoryReclaimMeter_appendRate(out, state->values[RECLAIM_SCAN_DIRECT], true, " direct), ");
+   MemoryReclaimMeter_appendRate(out, state->values[RECLAIM_STEAL], false, " reclaimed, stalls: ");
+   MemoryReclaimMeter_appendRate(out, state->values[RECLAIM_ALLOC_STALL], true, " reclaim ");
+   MemoryReclaimMeter_appendRate(out, state->values[RECLAIM_COMPACT_STALL], true, " compaction, THP fallbacks: ");
+   MemoryReclaimMeter_appendRate(out, state->values[RECLAIM_THP_FALLBACK], true, "");
+
+   if (!isnan(state->fragmentation)) {
+      char buffer[16];
+      int len = xSnprintf(buffer, sizeof(buffer), "%.0f%%", state->fragmentation);
+      RichString_appendAscii(out, CRT_colors[METER_TEXT], ", ");
+      RichString_appendnAscii(out, CRT_colors[METER_VALUE], buffer, len);
+      RichString_appendAscii(out, CRT_colors[METER_TEXT], " fragmented");
+   }
+}
+
+const MeterClass MemoryReclaimMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = MemoryReclaimMeter_display,
+   },
+   .updateValues = MemoryReclaimMeter_updateValues,
+   .defaultMode = TEXT_METERMODE,
+   .maxItems = 1,
+   .total = 100.0,
+   .attributes = MemoryReclaimMeter_attributes,
+   .name = "MemoryReclaim",
+   .uiName = "Memory reclaim",
+   .caption = "Reclaim: ",
+   .description = "Pages scanned and reclaimed, reclaim and compaction stalls and THP fallbacks per second, and fragmentation of the free memory",
+};
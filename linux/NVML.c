@@ -0,0 +1,388 @@
+/*
+htop - linux/NVML.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/NVML.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef BUILD_STATIC
+#include <dlfcn.h>
+#endif
+
+#include "Macros.h"
+#include "Row.h"
+#include "XUtils.h"
+
+
+unsigned int NVML_meters;
+
+#ifdef BUILD_STATIC
+
+/* libnvidia-ml comes with the driver and is never linked in */
+
+bool NVML_refresh(ATTR_UNUSED bool processes) {
+   return false;
+}
+
+unsigned int NVML_deviceCount(void) {
+   return 0;
+}
+
+const NVMLDevice* NVML_device(ATTR_UNUSED unsigned int index) {
+   return NULL;
+}
+
+bool NVML_process(ATTR_UNUSED pid_t pid, ATTR_UNUSED unsigned long long* memoryKB, ATTR_UNUSED float* smPercent) {
+   return false;
+}
+
+void NVML_cleanup(void) {
+}
+
+#else
+
+/* The parts of nvml.h used, which is not needed to build */
+typedef int nvmlReturn_t;
+typedef struct nvmlDevice_st* nvmlDevice_t;
+
+#define NVML_SUCCESS 0
+#define NVML_ERROR_INSUFFICIENT_SIZE 7
+#define NVML_VALUE_NOT_AVAILABLE (~0ULL)
+
+typedef struct nvmlUtilization_st {
+   unsigned int gpu;
+   unsigned int memory;
+} nvmlUtilization_t;
+
+typedef struct nvmlMemory_st {
+   unsigned long long total;
+   unsigned long long free;
+   unsigned long long used;
+} nvmlMemory_t;
+
+/* nvmlProcessInfo_v2_t, also what the _v3 calls fill in */
+typedef struct nvmlProcessInfo_st {
+   unsigned int pid;
+   unsigned long long usedGpuMemory;
+   unsigned int gpuInstanceId;
+   unsigned int computeInstanceId;
+} nvmlProcessInfo_t;
+
+typedef struct nvmlProcessUtilizationSample_st {
+   unsigned int pid;
+   unsigned long long timeStamp;   /* CPU timestamp in microseconds */
+   unsigned int smUtil;
+   unsigned int memUtil;
+   unsigned int encUtil;
+   unsigned int decUtil;
+} nvmlProcessUtilizationSample_t;
+
+typedef nvmlReturn_t (*nvmlProcessList_t)(nvmlDevice_t, unsigned int*, nvmlProcessInfo_t*);
+
+static nvmlReturn_t (*sym_nvmlInit_v2)(void);
+static nvmlReturn_t (*sym_nvmlShutdown)(void);
+static nvmlReturn_t (*sym_nvmlDeviceGetCount_v2)(unsigned int*);
+static nvmlReturn_t (*sym_nvmlDeviceGetHandleByIndex_v2)(unsigned int, nvmlDevice_t*);
+static nvmlReturn_t (*sym_nvmlDeviceGetName)(nvmlDevice_t, char*, unsigned int);
+static nvmlReturn_t (*sym_nvmlDeviceGetUtilizationRates)(nvmlDevice_t, nvmlUtilization_t*);
+static nvmlReturn_t (*sym_nvmlDeviceGetMemoryInfo)(nvmlDevice_t, nvmlMemory_t*);
+static nvmlReturn_t (*sym_nvmlDeviceGetPowerUsage)(nvmlDevice_t, unsigned int*);
+static nvmlReturn_t (*sym_nvmlDeviceGetEnforcedPowerLimit)(nvmlDevice_t, unsigned int*);
+/* optional: the process calls are missing from old drivers */
+static nvmlReturn_t (*sym_nvmlDeviceGetProcessUtilization)(nvmlDevice_t, nvmlProcessUtilizationSample_t*, unsigned int*, unsigned long long);
+static nvmlProcessList_t sym_computeProcesses;
+static nvmlProcessList_t sym_graphicsProcesses;
+
+static void* dlopenHandle = NULL;
+
+/* Usage of one GPU by one process, merged over the process lists and samples */
+typedef struct NVMLProcess_ {
+   pid_t pid;
+   unsigned int device;
+   unsigned long long memoryKB;
+   unsigned long long smSum;
+   unsigned int smSamples;
+   float smPercent;                /* once merged, averaged over the samples of each GPU */
+} NVMLProcess;
+
+static bool NVML_failed;
+static bool NVML_loaded;
+
+static nvmlDevice_t NVML_handles[NVML_MAX_DEVICES];
+static NVMLDevice NVML_devices[NVML_MAX_DEVICES];
+static unsigned int NVML_count;
+
+/* newest sample seen of each device, only later ones are asked for */
+static unsigned long long NVML_lastSeen[NVML_MAX_DEVICES];
+
+/* by pid and device while merged, then one per pid */
+static NVMLProcess* NVML_processes;
+static size_t NVML_processCount;
+static size_t NVML_processAlloc;
+
+static nvmlProcessInfo_t* NVML_infos;
+static unsigned int NVML_infoAlloc;
+static nvmlProcessUtilizationSample_t* NVML_samples;
+static unsigned int NVML_sampleAlloc;
+
+static bool NVML_load(void) {
+   dlopenHandle = dlopen("libnvidia-ml.so.1", RTLD_LAZY);
+   if (!dlopenHandle)
+      dlopenHandle = dlopen("libnvidia-ml.so", RTLD_LAZY);
+   if (!dlopenHandle)
+      return false;
+
+   /* Clear any errors */
+   dlerror();
+
+   #define resolve(symbolname) do {                                      \
+      *(void **)(&sym_##symbolname) = dlsym(dlopenHandle, #symbolname);  \
+      if (!sym_##symbolname || dlerror() != NULL)                        \
+         goto dlfailure;                                                 \
+   } while(0)
+
+   resolve(nvmlInit_v2);
+   resolve(nvmlShutdown);
+   resolve(nvmlDeviceGetCount_v2);
+   resolve(nvmlDeviceGetHandleByIndex_v2);
+   resolve(nvmlDeviceGetName);
+   resolve(nvmlDeviceGetUtilizationRates);
+   resolve(nvmlDeviceGetMemoryInfo);
+   resolve(nvmlDeviceGetPowerUsage);
+   resolve(nvmlDeviceGetEnforcedPowerLimit);
+
+   #undef resolve
+
+   *(void **)(&sym_nvmlDeviceGetProcessUtilization) = dlsym(dlopenHandle, "nvmlDeviceGetProcessUtilization");
+   *(void **)(&sym_computeProcesses) = dlsym(dlopenHandle, "nvmlDeviceGetComputeRunningProcesses_v3");
+   if (!sym_computeProcesses)
+      *(void **)(&sym_computeProcesses) = dlsym(dlopenHandle, "nvmlDeviceGetComputeRunningProcesses_v2");
+   *(void **)(&sym_graphicsProcesses) = dlsym(dlopenHandle, "nvmlDeviceGetGraphicsRunningProcesses_v3");
+   if (!sym_graphicsProcesses)
+      *(void **)(&sym_graphicsProcesses) = dlsym(dlopenHandle, "nvmlDeviceGetGraphicsRunningProcesses_v2");
+   dlerror();
+
+   if (sym_nvmlInit_v2() != NVML_SUCCESS)
+      goto dlfailure;
+
+   unsigned int count = 0;
+   if (sym_nvmlDeviceGetCount_v2(&count) != NVML_SUCCESS)
+      count = 0;
+
+   for (unsigned int i = 0; i < count && NVML_count < NVML_MAX_DEVICES; i++) {
+      nvmlDevice_t handle;
+      if (sym_nvmlDeviceGetHandleByIndex_v2(i, &handle) != NVML_SUCCESS)
+         continue;
+
+      NVMLDevice* device = &NVML_devices[NVML_count];
+      memset(device, 0, sizeof(NVMLDevice));
+      if (sym_nvmlDeviceGetName(handle, device->name, sizeof(device->name)) != NVML_SUCCESS)
+         xSnprintf(device->name, sizeof(device->name), "GPU %u", i);
+      NVML_handles[NVML_count++] = handle;
+   }
+
+   return true;
+
+dlfailure:
+   dlclose(dlopenHandle);
+   dlopenHandle = NULL;
+   return false;
+}
+
+static void NVML_readDevice(unsigned int index) {
+   nvmlDevice_t handle = NVML_handles[index];
+   NVMLDevice* device = &NVML_devices[index];
+
+   nvmlUtilization_t utilization;
+   device->percent = sym_nvmlDeviceGetUtilizationRates(handle, &utilization) == NVML_SUCCESS ? (float)utilization.gpu : NAN;
+
+   nvmlMemory_t memory;
+   if (sym_nvmlDeviceGetMemoryInfo(handle, &memory) == NVML_SUCCESS) {
+      device->memoryUsedKB = memory.used / ONE_K;
+      device->memoryTotalKB = memory.total / ONE_K;
+   }
+
+   unsigned int milliwatts;
+   device->powerW = sym_nvmlDeviceGetPowerUsage(handle, &milliwatts) == NVML_SUCCESS ? milliwatts / 1000.0 : NAN;
+   device->powerLimitW = sym_nvmlDeviceGetEnforcedPowerLimit(handle, &milliwatts) == NVML_SUCCESS ? milliwatts / 1000.0 : NAN;
+}
+
+static NVMLProcess* NVML_addProcess(pid_t pid, unsigned int device) {
+   if (NVML_processCount == NVML_processAlloc) {
+      NVML_processAlloc = NVML_processAlloc ? 2 * NVML_processAlloc : 64;
+      NVML_processes = xReallocArray(NVML_processes, NVML_processAlloc, sizeof(NVMLProcess));
+   }
+
+   NVMLProcess* process = &NVML_processes[NVML_processCount++];
+   *process = (NVMLProcess) { .pid = pid, .device = device };
+   return process;
+}
+
+/* A list call asked for its size first, since the processes come and go */
+static void NVML_readProcessList(nvmlProcessList_t list, unsigned int index) {
+   if (!list)
+      return;
+
+   unsigned int count = NVML_infoAlloc;
+   nvmlReturn_t ret = list(NVML_handles[index], &count, NVML_infos);
+   if (ret == NVML_ERROR_INSUFFICIENT_SIZE) {
+      NVML_infoAlloc = count + 16;
+      NVML_infos = xReallocArray(NVML_infos, NVML_infoAlloc, sizeof(nvmlProcessInfo_t));
+      count = NVML_infoAlloc;
+      ret = list(NVML_handles[index], &count, NVML_infos);
+   }
+   if (ret != NVML_SUCCESS)
+      return;
+
+   for (unsigned int i = 0; i < count; i++) {
+      const nvmlProcessInfo_t* info = &NVML_infos[i];
+      NVMLProcess* process = NVML_addProcess((pid_t)info->pid, index);
+      process->memoryKB = info->usedGpuMemory == NVML_VALUE_NOT_AVAILABLE ? 0 : info->usedGpuMemory / ONE_K;
+   }
+}
+
+/* Only the samples newer than the ones of the last read are returned */
+static void NVML_readSamples(unsigned int index) {
+   if (!sym_nvmlDeviceGetProcessUtilization)
+      return;
+
+   unsigned int count = 0;
+   nvmlReturn_t ret = sym_nvmlDeviceGetProcessUtilization(NVML_handles[index], NULL, &count, NVML_lastSeen[index]);
+   if (ret != NVML_ERROR_INSUFFICIENT_SIZE || count == 0)
+      return;
+
+   if (count > NVML_sampleAlloc) {
+      NVML_sampleAlloc = count;
+      NVML_samples = xReallocArray(NVML_samples, NVML_sampleAlloc, sizeof(nvmlProcessUtilizationSample_t));
+   }
+   if (sym_nvmlDeviceGetProcessUtilization(NVML_handles[index], NVML_samples, &count, NVML_lastSeen[index]) != NVML_SUCCESS)
+      return;
+
+   for (unsigned int i = 0; i < count; i++) {
+      const nvmlProcessUtilizationSample_t* sample = &NVML_samples[i];
+      NVMLProcess* process = NVML_addProcess((pid_t)sample->pid, index);
+      process->smSum = sample->smUtil;
+      process->smSamples = 1;
+      NVML_lastSeen[index] = MAXIMUM(NVML_lastSeen[index], sample->timeStamp);
+   }
+}
+
+static int NVML_compareProcesses(const void* v1, const void* v2) {
+   const NVMLProcess* p1 = v1;
+   const NVMLProcess* p2 = v2;
+   int result = SPACESHIP_NUMBER(p1->pid, p2->pid);
+   return result ? result : SPACESHIP_NUMBER(p1->device, p2->device);
+}
+
+/* Merges the entries of a process on one GPU, then sums over its GPUs */
+static void NVML_mergeProcesses(void) {
+   qsort(NVML_processes, NVML_processCount, sizeof(NVMLProcess), NVML_compareProcesses);
+
+   size_t merged = 0;
+   for (size_t i = 0; i < NVML_processCount;) {
+      const pid_t pid = NVML_processes[i].pid;
+      unsigned long long memoryKB = 0;
+      double smPercent = 0.0;
+
+      while (i < NVML_processCount && NVML_processes[i].pid == pid) {
+         const unsigned int device = NVML_processes[i].device;
+         unsigned long long deviceKB = 0;
+         unsigned long long smSum = 0;
+         unsigned int smSamples = 0;
+
+         /* a process in both the compute and the graphics list has the same memory in each */
+         for (; i < NVML_processCount && NVML_processes[i].pid == pid && NVML_processes[i].device == device; i++) {
+            deviceKB = MAXIMUM(deviceKB, NVML_processes[i].memoryKB);
+            smSum += NVML_processes[i].smSum;
+            smSamples += NVML_processes[i].smSamples;
+         }
+
+         memoryKB += deviceKB;
+         if (smSamples)
+            smPercent += (double)smSum / smSamples;
+      }
+
+      NVML_processes[merged++] = (NVMLProcess) { .pid = pid, .memoryKB = memoryKB, .smPercent = (float)smPercent };
+   }
+
+   NVML_processCount = merged;
+}
+
+bool NVML_refresh(bool processes) {
+   if (NVML_failed)
+      return false;
+
+   if (!NVML_loaded) {
+      if (!NVML_load()) {
+         NVML_failed = true;
+         return false;
+      }
+      NVML_loaded = true;
+   }
+
+   for (unsigned int i = 0; i < NVML_count; i++)
+      NVML_readDevice(i);
+
+   if (!processes)
+      return true;
+
+   NVML_processCount = 0;
+   for (unsigned int i = 0; i < NVML_count; i++) {
+      NVML_readProcessList(sym_computeProcesses, i);
+      NVML_readProcessList(sym_graphicsProcesses, i);
+      NVML_readSamples(i);
+   }
+   NVML_mergeProcesses();
+
+   return true;
+}
+
+unsigned int NVML_deviceCount(void) {
+   return NVML_count;
+}
+
+const NVMLDevice* NVML_device(unsigned int index) {
+   return index < NVML_count ? &NVML_devices[index] : NULL;
+}
+
+bool NVML_process(pid_t pid, unsigned long long* memoryKB, float* smPercent) {
+   const NVMLProcess key = { .pid = pid };
+   const NVMLProcess* found = NVML_processCount ? bsearch(&key, NVML_processes, NVML_processCount, sizeof(NVMLProcess), NVML_compareProcesses) : NULL;
+   if (!found)
+      return false;
+
+   *memoryKB = found->memoryKB;
+   *smPercent = found->smPercent;
+   return true;
+}
+
+void NVML_cleanup(void) {
+   if (dlopenHandle) {
+      sym_nvmlShutdown();
+      dlclose(dlopenHandle);
+      dlopenHandle = NULL;
+   }
+
+   free(NVML_processes);
+   free(NVML_infos);
+   free(NVML_samples);
+   NVML_processes = NULL;
+   NVML_infos = NULL;
+   NVML_samples = NULL;
+   NVML_processCount = NVML_processAlloc = 0;
+   NVML_infoAlloc = NVML_sampleAlloc = 0;
+   NVML_count = 0;
+   NVML_loaded = false;
+   NVML_failed = false;
+   memset(NVML_lastSeen, 0, sizeof(NVML_lastSeen));
+}
+
+#endif /* BUILD_STATIC */
@@ -0,0 +1,56 @@
+#ifndef HEADER_NVML
+#define HEADER_NVML
+/*
+htop - linux/NVML.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+
+/*
+ * NVIDIA GPUs as told by the NVML library of the proprietary driver, which
+ * is loaded via dlopen on first use: the driver has no DRM fdinfo to read.
+ * Not available in static builds.
+ */
+
+/* Most GPUs looked at */
+#define NVML_MAX_DEVICES 16
+
+typedef struct NVMLDevice_ {
+   char name[64];
+   float percent;                  /* of the time a kernel ran on the GPU, NAN if unknown */
+   unsigned long long memoryUsedKB;
+   unsigned long long memoryTotalKB;
+   double powerW;                  /* NAN if unknown */
+   double powerLimitW;             /* NAN if unknown */
+} NVMLDevice;
+
+/* Number of NVML meters in the header: while any, the devices are read every scan */
+extern unsigned int NVML_meters;
+
+/*
+ * Reads the devices, and with `processes` the samples of the processes
+ * using them taken since the last read. False if NVML could not be loaded
+ * or initialized; loading is not tried again then.
+ */
+bool NVML_refresh(bool processes);
+
+/* GPUs found, 0 without NVML */
+unsigned int NVML_deviceCount(void);
+
+const NVMLDevice* NVML_device(unsigned int index);
+
+/*
+ * GPU memory and streaming multiprocessor usage of a process over all
+ * GPUs, as of the last read with processes. False if it uses none.
+ */
+bool NVML_process(pid_t pid, unsigned long long* memoryKB, float* smPercent);
+
+void NVML_cleanup(void);
+
+#endif
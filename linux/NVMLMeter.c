@@ -0,0 +1,243 @@
+/*
+htop - linux/NVMLMeter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/NVMLMeter.h"
+
+#include <math.h>
+
+#include "CRT.h"
+#include "Macros.h"
+#include "Object.h"
+#include "RichString.h"
+#include "XUtils.h"
+
+#include "linux/NVML.h"
+
+
+static const int NVMLMeter_attributes[] = {
+   CPU_NORMAL
+};
+
+static const int NVMLMemoryMeter_attributes[] = {
+   MEMORY_USED
+};
+
+static const int NVMLPowerMeter_attributes[] = {
+   CPU_SYSTEM
+};
+
+static void NVMLMeter_init(ATTR_UNUSED Meter* this) {
+   NVML_meters++;
+}
+
+static void NVMLMeter_done(ATTR_UNUSED Meter* this) {
+   NVML_meters--;
+}
+
+static void NVMLMeter_updateValues(Meter* this) {
+   double sum = 0.0;
+   unsigned int known = 0;
+   for (unsigned int i = 0; i < NVML_deviceCount(); i++) {
+      const NVMLDevice* device = NVML_device(i);
+      if (!isnan(device->percent)) {
+         sum += device->percent;
+         known++;
+      }
+   }
+
+   this->values[0] = known ? sum / known : NAN;
+   if (known) {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "%.1f%%", this->values[0]);
+   } else {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "N/A");
+   }
+}
+
+static void NVMLMeter_display(const Object* cast, RichString* out) {
+   const Meter* this = (const Meter*)cast;
+   char buffer[32];
+
+   RichString_writeAscii(out, CRT_colors[METER_TEXT], ": ");
+
+   if (NVML_deviceCount() == 0) {
+      RichString_appendAscii(out, CRT_colors[METER_SHADOW], "no NVIDIA GPU found");
+      return;
+   }
+
+   RichString_appendAscii(out, CRT_colors[METER_VALUE], this->txtBuffer);
+
+   /* each GPU by its index, as nvidia-smi numbers them */
+   for (unsigned int i = 0; NVML_deviceCount() > 1 && i < NVML_deviceCount(); i++) {
+      const NVMLDevice* device = NVML_device(i);
+      xSnprintf(buffer, sizeof(buffer), " %u:", i);
+      RichString_appendAscii(out, CRT_colors[METER_TEXT], buffer);
+      if (isnan(device->percent)) {
+         RichString_appendAscii(out, CRT_colors[METER_SHADOW], "N/A");
+         continue;
+      }
+      xSnprintf(buffer, sizeof(buffer), "%.0f%%", (double)device->percent);
+      RichString_appendAscii(out, device->percent < 0.5F ? CRT_colors[METER_SHADOW] : CRT_colors[METER_VALUE], buffer);
+   }
+}
+
+static void NVMLMemoryMeter_updateValues(Meter* this) {
+   unsigned long long used = 0;
+   unsigned long long total = 0;
+   for (unsigned int i = 0; i < NVML_deviceCount(); i++) {
+      used += NVML_device(i)->memoryUsedKB;
+      total += NVML_device(i)->memoryTotalKB;
+   }
+
+   this->values[0] = (double)used;
+   this->total = MAXIMUM((double)total, 1.0);
+
+   char* buffer = this->txtBuffer;
+   size_t size = sizeof(this->txtBuffer);
+   int written = Meter_humanUnit(buffer, (double)used, size);
+   METER_BUFFER_CHECK(buffer, size, written);
+   METER_BUFFER_APPEND_CHR(buffer, size, '/');
+   Meter_humanUnit(buffer, (double)total, size);
+}
+
+static void NVMLMemoryMeter_display(const Object* cast, RichString* out) {
+   const Meter* this = (const Meter*)cast;
+   char buffer[32];
+
+   RichString_writeAscii(out, CRT_colors[METER_TEXT], ": ");
+
+   if (NVML_deviceCount() == 0) {
+      RichString_appendAscii(out, CRT_colors[METER_SHADOW], "no NVIDIA GPU found");
+      return;
+   }
+
+   Meter_humanUnit(buffer, this->values[0], sizeof(buffer));
+   RichString_appendAscii(out, CRT_colors[MEMORY_USED], buffer);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " of ");
+   Meter_humanUnit(buffer, this->total, sizeof(buffer));
+   RichString_appendAscii(out, CRT_colors[METER_VALUE], buffer);
+
+   for (unsigned int i = 0; NVML_deviceCount() > 1 && i < NVML_deviceCount(); i++) {
+      const NVMLDevice* device = NVML_device(i);
+      xSnprintf(buffer, sizeof(buffer), " %u:", i);
+      RichString_appendAscii(out, CRT_colors[METER_TEXT], buffer);
+      Meter_humanUnit(buffer, (double)device->memoryUsedKB, sizeof(buffer));
+      RichString_appendAscii(out, CRT_colors[MEMORY_USED], buffer);
+   }
+}
+
+static void NVMLPowerMeter_updateValues(Meter* this) {
+   double watts = 0.0;
+   double limit = 0.0;
+   unsigned int known = 0;
+   for (unsigned int i = 0; i < NVML_deviceCount(); i++) {
+      const NVMLDevice* device = NVML_device(i);
+      if (isnan(device->powerW))
+         continue;
+
+      watts += device->powerW;
+      if (!isnan(device->powerLimitW))
+         limit += device->powerLimitW;
+      known++;
+   }
+
+   this->values[0] = known ? watts : NAN;
+   this->total = limit > 0.0 ? limit : MAXIMUM(watts, 1.0);
+   if (known) {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "%.1fW", watts);
+   } else {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "N/A");
+   }
+}
+
+static void NVMLPowerMeter_display(const Object* cast, RichString* out) {
+   const Meter* this = (const Meter*)cast;
+   char buffer[32];
+
+   RichString_writeAscii(out, CRT_colors[METER_TEXT], ": ");
+
+   if (NVML_deviceCount() == 0) {
+      RichString_appendAscii(out, CRT_colors[METER_SHADOW], "no NVIDIA GPU found");
+      return;
+   }
+
+   RichString_appendAscii(out, CRT_colors[METER_VALUE], this->txtBuffer);
+   if (!isnan(this->values[0])) {
+      xSnprintf(buffer, sizeof(buffer), " of %.0fW", this->total);
+      RichString_appendAscii(out, CRT_colors[METER_TEXT], buffer);
+   }
+
+   for (unsigned int i = 0; NVML_deviceCount() > 1 && i < NVML_deviceCount(); i++) {
+      const NVMLDevice* device = NVML_device(i);
+      xSnprintf(buffer, sizeof(buffer), " %u:", i);
+      RichString_appendAscii(out, CRT_colors[METER_TEXT], buffer);
+      if (isnan(device->powerW)) {
+         RichString_appendAscii(out, CRT_colors[METER_SHADOW], "N/A");
+         continue;
+      }
+      xSnprintf(buffer, sizeof(buffer), "%.0fW", device->powerW);
+      RichString_appendAscii(out, CRT_colors[METER_VALUE], buffer);
+   }
+}
+
+const MeterClass NVMLMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = NVMLMeter_display,
+   },
+   .init = NVMLMeter_init,
+   .done = NVMLMeter_done,
+   .updateValues = NVMLMeter_updateValues,
+   .defaultMode = BAR_METERMODE,
+   .maxItems = 1,
+   .total = 100.0,
+   .attributes = NVMLMeter_attributes,
+   .name = "NvidiaGPU",
+   .uiName = "NVIDIA GPU",
+   .description = "Utilization of the NVIDIA GPUs, from NVML",
+   .caption = "NV"
+};
+
+const MeterClass NVMLMemoryMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = NVMLMemoryMeter_display,
+   },
+   .init = NVMLMeter_init,
+   .done = NVMLMeter_done,
+   .updateValues = NVMLMemoryMeter_updateValues,
+   .defaultMode = BAR_METERMODE,
+   .maxItems = 1,
+   .total = 1.0,
+   .attributes = NVMLMemoryMeter_attributes,
+   .name = "NvidiaGPUMemory",
+   .uiName = "NVIDIA GPU memory",
+   .description = "Memory used on the NVIDIA GPUs, from NVML",
+   .caption = "NVm"
+};
+
+const MeterClass NVMLPowerMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = NVMLPowerMeter_display,
+   },
+   .init = NVMLMeter_init,
+   .done = NVMLMeter_done,
+   .updateValues = NVMLPowerMeter_updateValues,
+   .defaultMode = BAR_METERMODE,
+   .maxItems = 1,
+   .total = 1.0,
+   .attributes = NVMLPowerMeter_attributes,
+   .name = "NvidiaGPUPower",
+   .uiName = "NVIDIA GPU power",
+   .description = "Power drawn by the NVIDIA GPUs against their limit, from NVML",
+   .caption = "NVp"
+};
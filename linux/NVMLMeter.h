@@ -0,0 +1,19 @@
+#ifndef HEADER_NVMLMeter
+#define HEADER_NVMLMeter
+/*
+htop - linux/NVMLMeter.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "Meter.h"
+
+
+extern const MeterClass NVMLMeter_class;
+
+extern const MeterClass NVMLMemoryMeter_class;
+
+extern const MeterClass NVMLPowerMeter_class;
+
+#endif
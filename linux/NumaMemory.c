@@ -0,0 +1,236 @@
+/*
+htop - linux/NumaMemory.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/NumaMemory.h"
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Macros.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+
+
+#define NUMA_NODE_DIR "devices/system/node"
+#define NUMA_TIERING_DIR "devices/virtual/memory_tiering"
+
+typedef struct NumaMemorySource_ {
+   NumaMemoryNode node;
+   FsRootFile* meminfo;
+} NumaMemorySource;
+
+static NumaMemorySource* NumaMemory_sources;
+static size_t NumaMemory_count;
+static size_t NumaMemory_tiers;
+static bool NumaMemory_discovered;
+static unsigned int NumaMemory_refreshes;
+
+/* Calls `found` for each entry of a sysfs list like "0-3,8" */
+static void NumaMemory_parseList(const char* list, void (*found)(unsigned long id, int arg), int arg) {
+   const char* p = list;
+   while (*p >= '0' && *p <= '9') {
+      char* end;
+      unsigned long first = strtoul(p, &end, 10);
+      unsigned long last = first;
+      if (*end == '-')
+         last = strtoul(end + 1, &end, 10);
+
+      for (unsigned long id = first; id <= last && id < UINT_MAX; id++)
+         found(id, arg);
+
+      p = *end == ',' ? end + 1 : end;
+   }
+}
+
+static void NumaMemory_addNode(unsigned long id, ATTR_UNUSED int arg) {
+   for (size_t i = 0; i < NumaMemory_count; i++)
+      if (NumaMemory_sources[i].node.id == id)
+         return;
+
+   char relative[64];
+   xSnprintf(relative, sizeof(relative), NUMA_NODE_DIR "/node%lu/meminfo", id);
+   if (!FsRoot_access(&FsRoot_sys, relative, R_OK))
+      return;
+
+   NumaMemory_sources = xReallocArray(NumaMemory_sources, NumaMemory_count + 1, sizeof(NumaMemorySource));
+   NumaMemory_sources[NumaMemory_count++] = (NumaMemorySource) {
+      .node = { .id = (unsigned int)id, .tier = -1 },
+      .meminfo = FsRoot_keep(&FsRoot_sys, relative),
+   };
+}
+
+static void NumaMemory_setTier(unsigned long id, int tier) {
+   for (size_t i = 0; i < NumaMemory_count; i++)
+      if (NumaMemory_sources[i].node.id == id)
+         NumaMemory_sources[i].node.tier = tier;
+}
+
+/* Without has_memory (before Linux 2.6.35 or without CONFIG_NUMA) every node directory counts */
+static void NumaMemory_discoverNodes(void) {
+   char list[1024];
+   if (FsRoot_readFile(&FsRoot_sys, NUMA_NODE_DIR "/has_memory", list, sizeof(list)) > 0) {
+      NumaMemory_parseList(list, NumaMemory_addNode, 0);
+      return;
+   }
+
+   DIR* dir = FsRoot_opendir(&FsRoot_sys, NUMA_NODE_DIR);
+   if (!dir)
+      return;
+
+   const struct dirent* entry;
+   while ((entry = readdir(dir))) {
+      if (!String_startsWith(entry->d_name, "node"))
+         continue;
+
+      char* end;
+      unsigned long id = strtoul(entry->d_name + 4, &end, 10);
+      if (end != entry->d_name + 4 && *end == '\0' && id < UINT_MAX)
+         NumaMemory_addNode(id, 0);
+   }
+
+   closedir(dir);
+}
+
+static void NumaMemory_discoverTiers(void) {
+   DIR* dir = FsRoot_opendir(&FsRoot_sys, NUMA_TIERING_DIR);
+   if (!dir)
+      return;
+
+   const struct dirent* entry;
+   while ((entry = readdir(dir))) {
+      if (!String_startsWith(entry->d_name, "memory_tier"))
+         continue;
+
+      char* end;
+      long tier = strtol(entry->d_name + 11, &end, 10);
+      if (end == entry->d_name + 11 || *end != '\0' || tier < 0 || tier > INT_MAX)
+         continue;
+
+      char relative[256];
+      char list[1024];
+      xSnprintf(relative, sizeof(relative), NUMA_TIERING_DIR "/%s/nodelist", entry->d_name);
+      if (FsRoot_readFile(&FsRoot_sys, relative, list, sizeof(list)) > 0)
+         NumaMemory_parseList(list, NumaMemory_setTier, (int)tier);
+   }
+
+   closedir(dir);
+}
+
+/* Nodes without a tier come last */
+static int NumaMemory_compare(const void* v1, const void* v2) {
+   const NumaMemoryNode* n1 = &((const NumaMemorySource*) v1)->node;
+   const NumaMemoryNode* n2 = &((const NumaMemorySource*) v2)->node;
+   const unsigned int t1 = (unsigned int) n1->tier;
+   const unsigned int t2 = (unsigned int) n2->tier;
+   return t1 != t2 ? SPACESHIP_NUMBER(t1, t2) : SPACESHIP_NUMBER(n1->id, n2->id);
+}
+
+void NumaMemory_discover(void) {
+   if (NumaMemory_discovered)
+      return;
+
+   NumaMemory_discovered = true;
+   NumaMemory_discoverNodes();
+   NumaMemory_discoverTiers();
+
+   if (NumaMemory_count > 0)
+      qsort(NumaMemory_sources, NumaMemory_count, sizeof(NumaMemorySource), NumaMemory_compare);
+
+   for (size_t i = 0; i < NumaMemory_count; i++) {
+      const int tier = NumaMemory_sources[i].node.tier;
+      if (tier >= 0 && (i == 0 || NumaMemory_sources[i - 1].node.tier != tier))
+         NumaMemory_tiers++;
+   }
+}
+
+/* hwloc tells the kind of memory of the nodes that are not plain DRAM, as "HBM" or "CXL-DRAM" */
+static void NumaMemory_setLabels(ATTR_UNUSED const Machine* host) {
+#ifdef HAVE_LIBHWLOC
+   if (!Machine_loadTopology(host))
+      return;
+
+   int count = hwloc_get_nbobjs_by_type(host->topology, HWLOC_OBJ_NUMANODE);
+   for (int i = 0; i < count; i++) {
+      hwloc_obj_t obj = hwloc_get_obj_by_type(host->topology, HWLOC_OBJ_NUMANODE, (unsigned int)i);
+      if (!obj || !obj->subtype)
+         continue;
+
+      for (size_t n = 0; n < NumaMemory_count; n++) {
+         NumaMemoryNode* node = &NumaMemory_sources[n].node;
+         if (node->id == obj->os_index)
+            xSnprintf(node->label, sizeof(node->label), "%.*s", (int)sizeof(node->label) - 1, obj->subtype);
+      }
+   }
+#endif
+}
+
+/* Lines as "Node 0 MemTotal:        6158152 kB" */
+static void NumaMemory_parse(NumaMemoryNode* node, const char* text) {
+   node->totalKB = node->freeKB = node->fileKB = 0;
+
+   for (const char* line = text; *line; ) {
+      char key[32];
+      memory_t value;
+      if (sscanf(line, "Node %*u %31[^:]: %llu", key, &value) == 2) {
+         if (String_eq(key, "MemTotal"))
+            node->totalKB = value;
+         else if (String_eq(key, "MemFree"))
+            node->freeKB = value;
+         else if (String_eq(key, "FilePages"))
+            node->fileKB = value;
+      }
+
+      const char* next = strchr(line, '\n');
+      if (!next)
+         break;
+      line = next + 1;
+   }
+}
+
+void NumaMemory_refresh(const Machine* host) {
+   NumaMemory_discover();
+
+   /* the topology is waited for on the second read, not to hold up the first frame */
+   if (++NumaMemory_refreshes == 2)
+      NumaMemory_setLabels(host);
+
+   for (size_t i = 0; i < NumaMemory_count; i++) {
+      NumaMemorySource* source = &NumaMemory_sources[i];
+      const char* text = FsRootFile_read(source->meminfo, NULL);
+      NumaMemory_parse(&source->node, text ? text : "");
+   }
+}
+
+size_t NumaMemory_nodeCount(void) {
+   return NumaMemory_count;
+}
+
+const NumaMemoryNode* NumaMemory_node(size_t index) {
+   return index < NumaMemory_count ? &NumaMemory_sources[index].node : NULL;
+}
+
+size_t NumaMemory_tierCount(void) {
+   return NumaMemory_tiers;
+}
+
+void NumaMemory_cleanup(void) {
+   /* the files kept open are closed with FsRoot_sys */
+   free(NumaMemory_sources);
+   NumaMemory_sources = NULL;
+   NumaMemory_count = 0;
+   NumaMemory_tiers = 0;
+   NumaMemory_discovered = false;
+   NumaMemory_refreshes = 0;
+}
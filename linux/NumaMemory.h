@@ -0,0 +1,45 @@
+#ifndef HEADER_NumaMemory
+#define HEADER_NumaMemory
+/*
+htop - linux/NumaMemory.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stddef.h>
+
+#include "Machine.h"
+
+
+/*
+ * The memory of each NUMA node, from /sys/devices/system/node/node<N>/meminfo,
+ * grouped by the memory tiers of /sys/devices/virtual/memory_tiering where
+ * the kernel has them (Linux 6.1, for CXL and other slower memory).
+ */
+
+typedef struct NumaMemoryNode_ {
+   unsigned int id;
+   int tier;                       /* the memory_tier<N> the node is in, -1 if none */
+   char label[16];                 /* the kind of memory told by hwloc, as "HBM", else empty */
+   memory_t totalKB;
+   memory_t freeKB;
+   memory_t fileKB;                /* page cache */
+} NumaMemoryNode;
+
+/* Looks for the nodes with memory, once; their order is by tier, then by id */
+void NumaMemory_discover(void);
+
+/* Reads the memory of the nodes */
+void NumaMemory_refresh(const Machine* host);
+
+size_t NumaMemory_nodeCount(void);
+
+const NumaMemoryNode* NumaMemory_node(size_t index);
+
+/* Number of distinct tiers of the nodes, 0 without memory tiering */
+size_t NumaMemory_tierCount(void);
+
+void NumaMemory_cleanup(void);
+
+#endif
@@ -0,0 +1,183 @@
+/*
+htop - linux/NumaMemoryMeter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/NumaMemoryMeter.h"
+
+#include <stdlib.h>
+
+#include "CRT.h"
+#include "Macros.h"
+#include "Object.h"
+#include "ProvideCurses.h"
+#include "XUtils.h"
+
+#include "linux/NumaMemory.h"
+
+
+/* The memory of each NUMA node in a row of its own, in the order of the memory tiers */
+
+enum {
+   NUMA_MEMORY_METER_USED,
+   NUMA_MEMORY_METER_CACHE,
+   NUMA_MEMORY_METER_ITEMS
+};
+
+static const int NumaNodeMeter_attributes[NUMA_MEMORY_METER_ITEMS] = {
+   [NUMA_MEMORY_METER_USED] = MEMORY_USED,
+   [NUMA_MEMORY_METER_CACHE] = MEMORY_CACHE,
+};
+
+/* The row of one node: its values are set by the meter of all nodes */
+static void NumaNodeMeter_updateValues(ATTR_UNUSED Meter* this) {
+}
+
+static const MeterClass NumaNodeMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+   },
+   .updateValues = NumaNodeMeter_updateValues,
+   .defaultMode = BAR_METERMODE,
+   .maxItems = NUMA_MEMORY_METER_ITEMS,
+   .total = 1.0,
+   .attributes = NumaNodeMeter_attributes,
+   .name = "NumaNode",
+   .uiName = "NUMA node memory",
+   .caption = "N"
+};
+
+typedef struct NumaMemoryMeterData_ {
+   Meter** meters;             /* one per node, in the order of NumaMemory_node() */
+   unsigned int count;
+} NumaMemoryMeterData;
+
+static int NumaMemoryMeter_columns(unsigned int count) {
+   return count <= 4 ? 1 : count <= 16 ? 2 : 4;
+}
+
+static void NumaMemoryMeter_setHeight(Meter* this) {
+   const NumaMemoryMeterData* data = this->meterData;
+   int ncol = NumaMemoryMeter_columns(data->count);
+   this->h = Meter_modes[this->mode]->h * MAXIMUM(((int)data->count + ncol - 1) / ncol, 1);
+}
+
+static void NumaMemoryMeter_init(Meter* this) {
+   NumaMemoryMeterData* data = this->meterData;
+   if (!data) {
+      NumaMemory_discover();
+
+      data = this->meterData = xCalloc(1, sizeof(NumaMemoryMeterData));
+      data->count = (unsigned int) NumaMemory_nodeCount();
+      data->meters = xCalloc(MAXIMUM(data->count, 1), sizeof(Meter*));
+      for (unsigned int i = 0; i < data->count; i++) {
+         Meter* meter = Meter_new(this->host, i, &NumaNodeMeter_class);
+         char caption[10];
+         xSnprintf(caption, sizeof(caption), "N%-2u", NumaMemory_node(i)->id);
+         Meter_setCaption(meter, caption);
+         data->meters[i] = meter;
+      }
+   }
+
+   if (this->mode == 0)
+      this->mode = BAR_METERMODE;
+
+   /* without nodes the meter keeps one row, telling so */
+   NumaMemoryMeter_setHeight(this);
+}
+
+static void NumaMemoryMeter_updateMode(Meter* this, int mode) {
+   NumaMemoryMeterData* data = this->meterData;
+   this->mode = mode;
+   for (unsigned int i = 0; i < data->count; i++)
+      Meter_setMode(data->meters[i], mode);
+
+   NumaMemoryMeter_setHeight(this);
+}
+
+static void NumaMemoryMeter_updateValues(Meter* this) {
+   const NumaMemoryMeterData* data = this->meterData;
+
+   if (data->count == 0) {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "no NUMA nodes");
+      return;
+   }
+
+   /* the tier is told only where there is more than one */
+   const bool showTier = NumaMemory_tierCount() > 1;
+
+   for (unsigned int i = 0; i < data->count; i++) {
+      Meter* meter = data->meters[i];
+      const NumaMemoryNode* node = NumaMemory_node(i);
+
+      const memory_t freeKB = MINIMUM(node->freeKB, node->totalKB);
+      const memory_t cache = MINIMUM(node->fileKB, node->totalKB - freeKB);
+      meter->total = MAXIMUM((double) node->totalKB, 1.0);
+      meter->values[NUMA_MEMORY_METER_USED] = (double) (node->totalKB - freeKB - cache);
+      meter->values[NUMA_MEMORY_METER_CACHE] = (double) cache;
+
+      char used[16];
+      char total[16];
+      Meter_humanUnit(used, meter->values[NUMA_MEMORY_METER_USED], sizeof(used));
+      Meter_humanUnit(total, (double) node->totalKB, sizeof(total));
+
+      char tier[16] = "";
+      if (showTier && node->tier >= 0)
+         xSnprintf(tier, sizeof(tier), "t%d ", node->tier);
+
+      xSnprintf(meter->txtBuffer, sizeof(meter->txtBuffer), "%s%s%s%s/%s",
+         node->label, node->label[0] ? " " : "", tier, used, total);
+   }
+}
+
+static void NumaMemoryMeter_draw(Meter* this, int x, int y, int w) {
+   const NumaMemoryMeterData* data = this->meterData;
+   if (data->count == 0) {
+      attrset(CRT_colors[METER_SHADOW]);
+      mvaddnstr(y, x, this->txtBuffer, w);
+      attrset(CRT_colors[RESET_COLOR]);
+      return;
+   }
+
+   int ncol = NumaMemoryMeter_columns(data->count);
+   int colwidth = (w - ncol) / ncol + 1;
+   int diff = w - colwidth * ncol;
+   int nrows = ((int)data->count + ncol - 1) / ncol;
+   for (int i = 0; i < (int)data->count; i++) {
+      Meter* meter = data->meters[i];
+      int d = MINIMUM(i / nrows, diff); // dynamic spacer, as for the CPU meters
+      meter->draw(meter, x + (i / nrows) * colwidth + d, y + (i % nrows) * meter->h, colwidth);
+   }
+}
+
+static void NumaMemoryMeter_done(Meter* this) {
+   NumaMemoryMeterData* data = this->meterData;
+   for (unsigned int i = 0; i < data->count; i++)
+      Meter_delete((Object*)data->meters[i]);
+   free(data->meters);
+   free(data);
+}
+
+const MeterClass NumaMemoryMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+   },
+   .updateValues = NumaMemoryMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .isMultiColumn = true,
+   .total = 100.0,
+   .name = "NumaMemory",
+   .uiName = "NUMA node memory",
+   .description = "NUMA node memory: used and cached memory of each node, by memory tier",
+   .caption = "Mem",
+   .draw = NumaMemoryMeter_draw,
+   .init = NumaMemoryMeter_init,
+   .updateMode = NumaMemoryMeter_updateMode,
+   .done = NumaMemoryMeter_done
+};
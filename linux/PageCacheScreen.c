@@ -0,0 +1,296 @@
+/*
+htop - linux/PageCacheScreen.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/PageCacheScreen.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "LineStore.h"
+#include "Macros.h"
+#include "Meter.h"
+#include "Panel.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+
+
+/* cachestat(2), Linux 6.5 and later; the number is the same on all architectures but alpha */
+#ifndef __NR_cachestat
+#ifdef __alpha__
+#define __NR_cachestat 561
+#else
+#define __NR_cachestat 451
+#endif
+#endif
+
+struct PageCache_range {
+   uint64_t off;
+   uint64_t len;            /* 0 for up to the end of the file */
+};
+
+struct PageCache_stat {
+   uint64_t nr_cache;
+   uint64_t nr_dirty;
+   uint64_t nr_writeback;
+   uint64_t nr_evicted;
+   uint64_t nr_recently_evicted;
+};
+
+/* Without cachestat(2) the files are mapped this much at a time for mincore(2) */
+#define PAGECACHE_MINCORE_WINDOW (256UL * 1024 * 1024)
+
+#define PAGECACHESCREEN_HEADER "   FD       SIZE     CACHED CACHE%      DIRTY  NAME"
+
+typedef struct PageCacheFile_ {
+   int fd;                  /* the lowest of the descriptors the file is open as */
+   dev_t dev;
+   ino_t ino;
+   uint64_t size;
+   bool measured;
+   bool hasDirty;
+   uint64_t cached;         /* bytes */
+   uint64_t dirty;
+   char* name;
+} PageCacheFile;
+
+/* Set once the kernel turned cachestat(2) down, files are mapped from then on */
+static bool PageCacheScreen_noCachestat;
+
+PageCacheScreen* PageCacheScreen_new(const Process* process) {
+   PageCacheScreen* this = xCalloc(1, sizeof(PageCacheScreen));
+   Object_setClass(this, Class(PageCacheScreen));
+   this->pid = Process_isThread(process) ? Process_getThreadGroup(process) : Process_getPid(process);
+   return (PageCacheScreen*) InfoScreen_init(&this->super, process, NULL, LINES - 2, PAGECACHESCREEN_HEADER);
+}
+
+void PageCacheScreen_delete(Object* this) {
+   free(InfoScreen_done((InfoScreen*)this));
+}
+
+static void PageCacheScreen_draw(InfoScreen* super) {
+   const PageCacheScreen* this = (const PageCacheScreen*) super;
+   char cached[16];
+   char size[16];
+   Meter_humanUnit(cached, (double)this->totalCached / 1024.0, sizeof(cached));
+   Meter_humanUnit(size, (double)this->totalSize / 1024.0, sizeof(size));
+   InfoScreen_drawTitled(super, "Page cache residency of files open in process %d - %s (%s of %s cached, by %s)",
+                         this->pid, Process_getCommand(super->process), cached, size, this->method ? this->method : "-");
+}
+
+static bool PageCacheScreen_cachestat(int fd, PageCacheFile* file, uint64_t pageSize) {
+   if (PageCacheScreen_noCachestat)
+      return false;
+
+   struct PageCache_range range = { .off = 0, .len = 0 };
+   struct PageCache_stat cs;
+   if (syscall(__NR_cachestat, fd, &range, &cs, 0) != 0) {
+      /* kernels before 6.5, or a seccomp filter that does not know it */
+      if (errno == ENOSYS || errno == EPERM)
+         PageCacheScreen_noCachestat = true;
+      return false;
+   }
+
+   file->cached = cs.nr_cache * pageSize;
+   file->dirty = cs.nr_dirty * pageSize;
+   file->hasDirty = true;
+   return true;
+}
+
+/* Maps the file without touching its pages and asks which of them are resident */
+static bool PageCacheScreen_mincore(int fd, PageCacheFile* file, uint64_t pageSize) {
+   unsigned char* vec = xMalloc(PAGECACHE_MINCORE_WINDOW / pageSize);
+   uint64_t pages = 0;
+
+   for (uint64_t offset = 0; offset < file->size; offset += PAGECACHE_MINCORE_WINDOW) {
+      const size_t len = (size_t) MINIMUM(file->size - offset, PAGECACHE_MINCORE_WINDOW);
+      void* addr = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, (off_t) offset);
+      if (addr == MAP_FAILED) {
+         free(vec);
+         return false;
+      }
+
+      if (mincore(addr, len, vec) == 0) {
+         for (size_t i = 0; i < (len + pageSize - 1) / pageSize; i++)
+            pages += vec[i] & 1;
+      }
+      munmap(addr, len);
+   }
+
+   free(vec);
+   file->cached = pages * pageSize;
+   return true;
+}
+
+static void PageCacheScreen_measure(int dfd, PageCacheFile* file, uint64_t pageSize) {
+   if (file->size == 0) {
+      file->measured = true;
+      return;
+   }
+
+   char name[16];
+   xSnprintf(name, sizeof(name), "%d", file->fd);
+   int fd = openat(dfd, name, O_RDONLY | O_CLOEXEC | O_NOCTTY | O_NONBLOCK);
+   if (fd < 0)
+      return;
+
+   file->measured = PageCacheScreen_cachestat(fd, file, pageSize) || PageCacheScreen_mincore(fd, file, pageSize);
+   /* the last page is cached whole */
+   file->cached = MINIMUM(file->cached, file->size);
+   close(fd);
+}
+
+static int PageCacheScreen_compareIdentity(const void* v1, const void* v2) {
+   const PageCacheFile* a = v1;
+   const PageCacheFile* b = v2;
+   if (a->dev != b->dev)
+      return SPACESHIP_NUMBER(a->dev, b->dev);
+   if (a->ino != b->ino)
+      return SPACESHIP_NUMBER(a->ino, b->ino);
+
+   return SPACESHIP_NUMBER(a->fd, b->fd);
+}
+
+static int PageCacheScreen_compareCached(const void* v1, const void* v2) {
+   const PageCacheFile* a = v1;
+   const PageCacheFile* b = v2;
+   if (a->measured != b->measured)
+      return a->measured ? -1 : 1;
+   if (a->cached != b->cached)
+      return SPACESHIP_NUMBER(b->cached, a->cached);
+   if (a->size != b->size)
+      return SPACESHIP_NUMBER(b->size, a->size);
+
+   return SPACESHIP_NUMBER(a->fd, b->fd);
+}
+
+static void PageCacheScreen_addFile(InfoScreen* super, const PageCacheFile* file) {
+   char size[16];
+   char cached[16] = "?";
+   char percent[8] = "?";
+   char dirty[16] = "-";
+   Meter_humanUnit(size, (double)file->size / 1024.0, sizeof(size));
+   if (file->measured) {
+      Meter_humanUnit(cached, (double)file->cached / 1024.0, sizeof(cached));
+      xSnprintf(percent, sizeof(percent), "%.1f", file->size ? 100.0 * (double)file->cached / (double)file->size : 0.0);
+   }
+   if (file->hasDirty)
+      Meter_humanUnit(dirty, (double)file->dirty / 1024.0, sizeof(dirty));
+
+   char* line = NULL;
+   xAsprintf(&line, "%5d %10s %10s %6s %10s  %s", file->fd, size, cached, percent, dirty, file->name);
+   InfoScreen_addLine(super, line);
+   free(line);
+}
+
+static void PageCacheScreen_scan(InfoScreen* super) {
+   PageCacheScreen* this = (PageCacheScreen*) super;
+   Panel* panel = super->display;
+   int idx = MAXIMUM(Panel_getSelectedIndex(panel), 0);
+
+   Panel_prune(panel);
+   this->totalSize = 0;
+   this->totalCached = 0;
+
+   char path[32];
+   xSnprintf(path, sizeof(path), "%d/fd", this->pid);
+   DIR* dirp = FsRoot_opendir(&FsRoot_proc, path);
+   if (!dirp) {
+      char line[128];
+      xSnprintf(line, sizeof(line), "Could not list the files open in the process: %s", strerror(errno));
+      InfoScreen_addLine(super, line);
+      return;
+   }
+   int dfd = dirfd(dirp);
+
+   PageCacheFile* files = NULL;
+   size_t count = 0;
+   size_t alloc = 0;
+   for (const struct dirent* de; (de = readdir(dirp)); ) {
+      errno = 0;
+      char* end;
+      long fdNum = strtol(de->d_name, &end, 10);
+      if (errno || *end || end == de->d_name || fdNum < 0 || fdNum > INT_MAX)
+         continue;
+
+      struct stat st;
+      if (fstatat(dfd, de->d_name, &st, 0) != 0 || !S_ISREG(st.st_mode))
+         continue;
+
+      char link[PATH_MAX];
+      ssize_t linkLen = readlinkat(dfd, de->d_name, link, sizeof(link) - 1);
+      if (linkLen < 0)
+         continue;
+      link[linkLen] = '\0';
+
+      if (count == alloc) {
+         alloc = alloc ? alloc * 2 : 64;
+         files = xReallocArray(files, alloc, sizeof(PageCacheFile));
+      }
+      files[count++] = (PageCacheFile) {
+         .fd = (int) fdNum,
+         .dev = st.st_dev,
+         .ino = st.st_ino,
+         .size = (uint64_t) st.st_size,
+         .name = xStrdup(link),
+      };
+   }
+
+   /* a file open more than once is listed once, as its lowest descriptor */
+   if (count > 0)
+      qsort(files, count, sizeof(PageCacheFile), PageCacheScreen_compareIdentity);
+   size_t unique = 0;
+   for (size_t i = 0; i < count; i++) {
+      if (unique > 0 && files[unique - 1].dev == files[i].dev && files[unique - 1].ino == files[i].ino) {
+         free(files[i].name);
+         continue;
+      }
+      files[unique++] = files[i];
+   }
+
+   const uint64_t pageSize = (uint64_t) sysconf(_SC_PAGESIZE);
+   for (size_t i = 0; i < unique; i++) {
+      PageCacheScreen_measure(dfd, &files[i], pageSize);
+      this->totalSize += files[i].size;
+      this->totalCached += files[i].cached;
+   }
+   closedir(dirp);
+   this->method = PageCacheScreen_noCachestat ? "mincore" : "cachestat";
+
+   if (unique > 0)
+      qsort(files, unique, sizeof(PageCacheFile), PageCacheScreen_compareCached);
+   for (size_t i = 0; i < unique; i++) {
+      PageCacheScreen_addFile(super, &files[i]);
+      free(files[i].name);
+   }
+   free(files);
+
+   if (unique == 0)
+      InfoScreen_addLine(super, "The process has no regular file open.");
+
+   Panel_setSelected(panel, idx);
+}
+
+const InfoScreenClass PageCacheScreen_class = {
+   .super = {
+      .extends = Class(Object),
+      .delete = PageCacheScreen_delete
+   },
+   .scan = PageCacheScreen_scan,
+   .draw = PageCacheScreen_draw
+};
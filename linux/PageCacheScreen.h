@@ -0,0 +1,33 @@
+#ifndef HEADER_PageCacheScreen
+#define HEADER_PageCacheScreen
+/*
+htop - linux/PageCacheScreen.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "InfoScreen.h"
+#include "Object.h"
+#include "Process.h"
+
+
+/* How much of each regular file open in a process is in the page cache */
+typedef struct PageCacheScreen_ {
+   InfoScreen super;
+   pid_t pid;
+   const char* method;      /* "cachestat" or "mincore", of the last scan */
+   uint64_t totalSize;
+   uint64_t totalCached;
+} PageCacheScreen;
+
+extern const InfoScreenClass PageCacheScreen_class;
+
+PageCacheScreen* PageCacheScreen_new(const Process* process);
+
+void PageCacheScreen_delete(Object* this);
+
+#endif
@@ -0,0 +1,218 @@
+/*
+htop - linux/PerfCounters.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/PerfCounters.h"
+
+#ifdef HAVE_PERF_EVENTS
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <sys/syscall.h>
+
+#include "Macros.h"
+#include "XUtils.h"
+
+
+/* Groups open at most, each costs one fd and one counter slot per event */
+#define PERFCOUNTERS_MAX_GROUPS 64
+
+typedef enum PerfCounterEvent_ {
+   PERFCOUNTER_CYCLES,          /* group leader, without it nothing is opened */
+   PERFCOUNTER_INSTRUCTIONS,
+   PERFCOUNTER_LLC_MISSES,
+   PERFCOUNTER_BRANCHES,
+   PERFCOUNTER_BRANCH_MISSES,
+   PERFCOUNTER_STALLED_BACKEND,
+   PERFCOUNTER_COUNT
+} PerfCounterEvent;
+
+static const uint64_t PerfCounters_configs[PERFCOUNTER_COUNT] = {
+   [PERFCOUNTER_CYCLES]          = PERF_COUNT_HW_CPU_CYCLES,
+   [PERFCOUNTER_INSTRUCTIONS]    = PERF_COUNT_HW_INSTRUCTIONS,
+   [PERFCOUNTER_LLC_MISSES]      = PERF_COUNT_HW_CACHE_MISSES,
+   [PERFCOUNTER_BRANCHES]        = PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+   [PERFCOUNTER_BRANCH_MISSES]   = PERF_COUNT_HW_BRANCH_MISSES,
+   [PERFCOUNTER_STALLED_BACKEND] = PERF_COUNT_HW_STALLED_CYCLES_BACKEND,
+};
+
+struct PerfCounters_ {
+   int fds[PERFCOUNTER_COUNT];        /* -1 for events the CPU does not count */
+   int slots[PERFCOUNTER_COUNT];      /* position of the event in a group read, -1 if not open */
+   int members;
+   bool haveLast;
+   uint64_t lastMs;
+   uint64_t lastEnabled;
+   uint64_t lastRunning;
+   uint64_t lastValues[PERFCOUNTER_COUNT];
+};
+
+static bool PerfCounters_unsupported;
+static bool PerfCounters_noInherit;
+static int PerfCounters_groups;
+
+bool PerfCounters_isSupported(void) {
+   return !PerfCounters_unsupported;
+}
+
+static int PerfCounters_maxGroups(void) {
+   static int maxGroups = -1;
+
+   if (maxGroups < 0) {
+      struct rlimit rl;
+      maxGroups = PERFCOUNTERS_MAX_GROUPS;
+      /* leave most fds to the process scan */
+      if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY)
+         maxGroups = (int)MINIMUM((rlim_t)maxGroups, rl.rlim_cur / 8 / PERFCOUNTER_COUNT);
+   }
+
+   return maxGroups;
+}
+
+static int PerfCounters_openEvent(pid_t tid, uint64_t config, int groupFd) {
+   struct perf_event_attr attr;
+   memset(&attr, 0, sizeof(attr));
+   attr.size = sizeof(attr);
+   attr.type = PERF_TYPE_HARDWARE;
+   attr.config = config;
+   attr.exclude_kernel = 1;
+   attr.exclude_hv = 1;
+   /* threads started later are counted with their process */
+   attr.inherit = !PerfCounters_noInherit;
+   attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+   int fd = (int)syscall(SYS_perf_event_open, &attr, tid, -1, groupFd, PERF_FLAG_FD_CLOEXEC);
+   if (fd < 0 && errno == EINVAL && attr.inherit && groupFd < 0) {
+      /* older kernels refuse to inherit counters read as a group */
+      PerfCounters_noInherit = true;
+      attr.inherit = 0;
+      fd = (int)syscall(SYS_perf_event_open, &attr, tid, -1, groupFd, PERF_FLAG_FD_CLOEXEC);
+   }
+   if (fd < 0)
+      return -1;
+
+   /* keep the low fds free, see LinuxProcessTable_getProcFd() */
+   if (fd < FD_SETSIZE) {
+      int highFd = fcntl(fd, F_DUPFD_CLOEXEC, FD_SETSIZE);
+      if (highFd >= 0) {
+         close(fd);
+         fd = highFd;
+      }
+   }
+
+   return fd;
+}
+
+PerfCounters* PerfCounters_open(pid_t tid) {
+   if (PerfCounters_unsupported || PerfCounters_groups >= PerfCounters_maxGroups()) {
+      errno = EBUSY;
+      return NULL;
+   }
+
+   int leader = PerfCounters_openEvent(tid, PerfCounters_configs[PERFCOUNTER_CYCLES], -1);
+   if (leader < 0) {
+      /* no hardware events (e.g. in a VM) or not allowed by perf_event_paranoid */
+      if (errno == ENOENT || errno == ENODEV || errno == EOPNOTSUPP || errno == ENOSYS)
+         PerfCounters_unsupported = true;
+      return NULL;
+   }
+
+   PerfCounters* this = xCalloc(1, sizeof(PerfCounters));
+   this->fds[PERFCOUNTER_CYCLES] = leader;
+   this->slots[PERFCOUNTER_CYCLES] = 0;
+   this->members = 1;
+
+   for (int i = PERFCOUNTER_CYCLES + 1; i < PERFCOUNTER_COUNT; i++) {
+      /* members the CPU does not know stay unset, their values show as unknown */
+      this->fds[i] = PerfCounters_openEvent(tid, PerfCounters_configs[i], leader);
+      this->slots[i] = this->fds[i] >= 0 ? this->members++ : -1;
+   }
+
+   PerfCounters_groups++;
+   return this;
+}
+
+void PerfCounters_close(PerfCounters* this) {
+   if (!this)
+      return;
+
+   /* members first, the leader holds the group together */
+   for (int i = PERFCOUNTER_COUNT - 1; i >= 0; i--) {
+      if (this->fds[i] >= 0)
+         close(this->fds[i]);
+   }
+
+   PerfCounters_groups--;
+   free(this);
+}
+
+/* Ratio of two deltas of the same group, which were counted over the same time */
+static double PerfCounters_ratio(const PerfCounters* this, const uint64_t* deltas, PerfCounterEvent num, PerfCounterEvent den, double scale) {
+   if (this->slots[num] < 0 || this->slots[den] < 0 || deltas[den] == 0)
+      return NAN;
+
+   return (double)deltas[num] / (double)deltas[den] * scale;
+}
+
+bool PerfCounters_read(PerfCounters* this, uint64_t monotonicMs, PerfCounterRates* rates) {
+   /* nr, time_enabled, time_running, then one value per member */
+   uint64_t buffer[3 + PERFCOUNTER_COUNT];
+
+   rates->ipc = NAN;
+   rates->llcMissRate = NAN;
+   rates->branchMissPercent = NAN;
+   rates->stalledPercent = NAN;
+
+   ssize_t len = read(this->fds[PERFCOUNTER_CYCLES], buffer, sizeof(buffer));
+   if (len < (ssize_t)(3 * sizeof(uint64_t)) || buffer[0] != (uint64_t)this->members)
+      return false;
+
+   const uint64_t enabled = buffer[1];
+   const uint64_t running = buffer[2];
+   uint64_t values[PERFCOUNTER_COUNT] = { 0 };
+   for (int i = 0; i < PERFCOUNTER_COUNT; i++) {
+      if (this->slots[i] >= 0)
+         values[i] = buffer[3 + this->slots[i]];
+   }
+
+   if (this->haveLast && running > this->lastRunning) {
+      uint64_t deltas[PERFCOUNTER_COUNT];
+      for (int i = 0; i < PERFCOUNTER_COUNT; i++)
+         deltas[i] = saturatingSub(values[i], this->lastValues[i]);
+
+      rates->ipc = PerfCounters_ratio(this, deltas, PERFCOUNTER_INSTRUCTIONS, PERFCOUNTER_CYCLES, 1.0);
+      rates->branchMissPercent = PerfCounters_ratio(this, deltas, PERFCOUNTER_BRANCH_MISSES, PERFCOUNTER_BRANCHES, 100.0);
+      rates->stalledPercent = PerfCounters_ratio(this, deltas, PERFCOUNTER_STALLED_BACKEND, PERFCOUNTER_CYCLES, 100.0);
+
+      /* with more events than counters the group only ran part of the time, scale up */
+      const uint64_t elapsedMs = monotonicMs - this->lastMs;
+      if (this->slots[PERFCOUNTER_LLC_MISSES] >= 0 && elapsedMs > 0) {
+         const double scale = (double)(enabled - this->lastEnabled) / (double)(running - this->lastRunning);
+         rates->llcMissRate = (double)deltas[PERFCOUNTER_LLC_MISSES] * scale * 1000.0 / (double)elapsedMs;
+      }
+   } else if (this->haveLast) {
+      /* the task was not scheduled since the last read */
+      rates->llcMissRate = 0.0;
+   }
+
+   this->haveLast = true;
+   this->lastMs = monotonicMs;
+   this->lastEnabled = enabled;
+   this->lastRunning = running;
+   memcpy(this->lastValues, values, sizeof(values));
+   return true;
+}
+
+#endif /* HAVE_PERF_EVENTS */
@@ -0,0 +1,41 @@
+#ifndef HEADER_PerfCounters
+#define HEADER_PerfCounters
+/*
+htop - linux/PerfCounters.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+
+/* One perf event group counting the hardware events of a task */
+typedef struct PerfCounters_ PerfCounters;
+
+/* What the counters read over the last interval, NAN where unknown */
+typedef struct PerfCounterRates_ {
+   double ipc;                /* instructions per cycle */
+   double llcMissRate;        /* last level cache misses per second */
+   double branchMissPercent;  /* share of branches mispredicted */
+   double stalledPercent;     /* share of cycles the backend stalled */
+} PerfCounterRates;
+
+/*
+ * Opens a group for the task `tid`. Returns NULL if the CPU or kernel does
+ * not count hardware events for us, if the task may not be watched, or if
+ * all the groups the budget allows are already open.
+ */
+PerfCounters* PerfCounters_open(pid_t tid);
+
+void PerfCounters_close(PerfCounters* this);
+
+/* Reads the group; the rates are known from the second read on. Returns false if the task is gone */
+bool PerfCounters_read(PerfCounters* this, uint64_t monotonicMs, PerfCounterRates* rates);
+
+/* False once opening failed in a way that will not change for other tasks */
+bool PerfCounters_isSupported(void);
+
+#endif
@@ -15,27 +15,41 @@ in the source distribution for its full text.
 #include <fcntl.h>
 #include <inttypes.h>
 #include <math.h>
+#include <sched.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <syscall.h>
 #include <time.h>
 #include <unistd.h>
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/sysmacros.h>
 
 #include "BatteryMeter.h"
 #include "ClockMeter.h"
 #include "Compat.h"
 #include "CPUMeter.h"
+#include "CRT.h"
 #include "DateMeter.h"
 #include "DateTimeMeter.h"
 #include "DiskIOMeter.h"
+#include "DynamicColumn.h"
+#include "DynamicScreen.h"
 #include "FileDescriptorMeter.h"
+#include "Hashtable.h"
 #include "HostnameMeter.h"
 #include "HugePageMeter.h"
+#include "InfoScreen.h"
 #include "LoadAverageMeter.h"
 #include "Machine.h"
 #include "Macros.h"
+#include "ListItem.h"
 #include "MainPanel.h"
 #include "Meter.h"
 #include "MemoryMeter.h"
@@ -45,18 +59,64 @@ in the source distribution for its full text.
 #include "Panel.h"
 #include "PressureStallMeter.h"
 #include "ProvideCurses.h"
+#include "Replay.h"
+#include "SelfMeter.h"
 #include "Settings.h"
 #include "SwapMeter.h"
 #include "SysArchMeter.h"
 #include "TasksMeter.h"
 #include "UptimeMeter.h"
 #include "XUtils.h"
+#include "linux/Bpf.h"
+#include "linux/CGroupRow.h"
+#include "linux/CGroupScope.h"
+#include "linux/CGroupTable.h"
+#include "linux/CPUFreqCounters.h"
+#include "linux/CPUOccupancyRow.h"
+#include "linux/CPUOccupancyTable.h"
+#include "linux/CPUThrottleMeter.h"
+#include "linux/ChurnScreen.h"
+#include "linux/ContainerNames.h"
+#include "linux/ExitedTaskRow.h"
+#include "linux/ExitedTaskTable.h"
+#include "linux/ExitedTasks.h"
+#include "linux/ExitedTasksMeter.h"
+#include "linux/GuestRow.h"
+#include "linux/GuestTable.h"
+#include "linux/FsRoot.h"
+#include "linux/GPUMeter.h"
+#include "linux/IODevices.h"
+#include "linux/IODevicesMeter.h"
 #include "linux/IOPriority.h"
 #include "linux/IOPriorityPanel.h"
+#include "linux/InterruptMeter.h"
 #include "linux/LinuxMachine.h"
 #include "linux/LinuxProcess.h"
+#include "linux/LockIndex.h"
+#include "linux/MemoryReclaimMeter.h"
+#include "linux/NVML.h"
+#include "linux/NVMLMeter.h"
+#include "linux/NumaMemory.h"
+#include "linux/NumaMemoryMeter.h"
+#include "linux/PageCacheScreen.h"
+#include "linux/ProcessChurn.h"
+#include "linux/ProcessChurnMeter.h"
+#include "linux/RAPL.h"
+#include "linux/RAPLMeter.h"
+#include "linux/Resctrl.h"
+#include "linux/ResctrlMeter.h"
+#include "linux/RunQueueMeter.h"
 #include "linux/SELinuxMeter.h"
+#include "linux/ScanStream.h"
+#include "linux/SharedScan.h"
+#include "linux/SlabScreen.h"
+#include "linux/SourceCache.h"
+#include "linux/StackScreen.h"
 #include "linux/SystemdMeter.h"
+#include "linux/UserTotalsRow.h"
+#include "linux/UserTotalsTable.h"
+#include "linux/WaitChannelRow.h"
+#include "linux/WaitChannelTable.h"
 #include "linux/ZramMeter.h"
 #include "linux/ZramStats.h"
 #include "linux/ZswapStats.h"
@@ -76,6 +136,10 @@ in the source distribution for its full text.
 #define O_PATH         010000000 // declare for ancient glibc versions
 #endif
 
+#ifdef __ANDROID__
+#define SYS_ioprio_set __NR_ioprio_set
+#endif
+
 
 #ifdef HAVE_LIBCAP
 enum CapMode {
@@ -87,6 +151,86 @@ enum CapMode {
 
 bool Running_containerized = false;
 
+bool Platform_lowImpact = false;
+
+/* Screens with a table of their own, offered as dynamic screens */
+typedef struct PlatformScreen_ {
+   const char* name;           /* of the DynamicScreen, stored in htoprc */
+   const char* heading;
+   const char* caption;
+   const char* sortKey;
+   RowField firstKey;          /* of the dynamic columns of the screen */
+   int columnCount;
+   bool treeView;
+   Table* table;
+} PlatformScreen;
+
+enum {
+   PLATFORM_SCREEN_CGROUPS,
+   PLATFORM_SCREEN_USERS,
+   PLATFORM_SCREEN_WAITS,
+   PLATFORM_SCREEN_OCCUPANCY,
+   PLATFORM_SCREEN_EXITED,
+   PLATFORM_SCREEN_GUESTS,
+   PLATFORM_SCREEN_COUNT
+};
+
+static PlatformScreen Platform_screens[PLATFORM_SCREEN_COUNT] = {
+   [PLATFORM_SCREEN_CGROUPS] = {
+      .name = "cgroups",
+      .heading = "CGroups",
+      .caption = "Control groups of the cgroup v2 hierarchy",
+      .firstKey = CGroupField_key(0),
+      .columnCount = LAST_CGROUP_FIELD,
+      .treeView = true,
+   },
+   [PLATFORM_SCREEN_USERS] = {
+      .name = "users",
+      .heading = "Users",
+      .caption = "Totals of the processes of each user",
+      .sortKey = "Dynamic(user_cpu_percent)",
+      .firstKey = UserTotalsField_key(0),
+      .columnCount = LAST_USERTOTALS_FIELD,
+   },
+   [PLATFORM_SCREEN_WAITS] = {
+      .name = "waits",
+      .heading = "Waits",
+      .caption = "Tasks sleeping in the kernel by wait channel",
+      .sortKey = "Dynamic(wait_blocked)",
+      .firstKey = WaitChannelField_key(0),
+      .columnCount = LAST_WAITCHANNEL_FIELD,
+   },
+   [PLATFORM_SCREEN_OCCUPANCY] = {
+      .name = "occupancy",
+      .heading = "CPUs",
+      .caption = "Tasks by the CPUs they ran on lately",
+      .sortKey = "Dynamic(occupancy_cpu)",
+      .firstKey = CPUOccupancyField_key(0),
+      .columnCount = LAST_CPUOCCUPANCY_FIELD,
+   },
+   [PLATFORM_SCREEN_EXITED] = {
+      .name = "exited",
+      .heading = "Exited",
+      .caption = "Processes that exited between scans, by parent and command",
+      .sortKey = "Dynamic(exited_cpu_percent)",
+      .firstKey = ExitedTaskField_key(0),
+      .columnCount = LAST_EXITEDTASK_FIELD,
+      .treeView = true,
+   },
+   [PLATFORM_SCREEN_GUESTS] = {
+      .name = "guests",
+      .heading = "Guests",
+      .caption = "QEMU virtual machines by guest name, with their vCPU threads",
+      .sortKey = "Dynamic(guest_cpu_percent)",
+      .firstKey = GuestField_key(0),
+      .columnCount = LAST_GUEST_FIELD,
+      .treeView = true,
+   },
+};
+
+static const char* Platform_cgroupRoot;
+static Hashtable* Platform_columns;
+
 const ScreenDefaults Platform_defaultScreens[] = {
    {
       .name = "Main",
@@ -146,6 +290,17 @@ static time_t Platform_Battery_cacheTime;
 static double Platform_Battery_cachePercent = NAN;
 static ACPresence Platform_Battery_cacheIsOnAC;
 
+/* A power supply found in sysfs, with its uevent (battery) or online (AC) file kept open */
+typedef struct PowerSupply_ {
+   bool battery;
+   int fd;
+} PowerSupply;
+
+static PowerSupply* Platform_Battery_supplies;
+static size_t Platform_Battery_nSupplies;
+static bool Platform_Battery_discovered;
+static int Platform_Battery_ueventSocket = -1;
+
 #ifdef HAVE_LIBCAP
 static enum CapMode Platform_capabilitiesMode = CAP_MODE_BASIC;
 #endif
@@ -200,8 +355,66 @@ static Htop_Reaction Platform_actionLowerAutogroupPriority(State* st) {
    return changed ? HTOP_REFRESH : HTOP_OK;
 }
 
+#ifdef HAVE_PERF_EVENTS
+static Htop_Reaction Platform_actionSampleStacks(State* st) {
+   if (Settings_isReadonly())
+      return HTOP_OK;
+
+   const Process* p = (const Process*) Panel_getSelected((Panel*)st->mainPanel);
+   if (!p)
+      return HTOP_OK;
+
+   StackScreen* ss = StackScreen_new(p);
+   InfoScreen_run((InfoScreen*)ss);
+   StackScreen_delete((Object*)ss);
+   clear();
+   CRT_enableDelay();
+   return HTOP_REFRESH | HTOP_REDRAW_BAR;
+}
+#endif
+
+static Htop_Reaction Platform_actionShowPageCache(State* st) {
+   if (st->host->settings->ss->dynamic)
+      return HTOP_OK;
+
+   const Process* p = (const Process*) Panel_getSelected((Panel*)st->mainPanel);
+   if (!p)
+      return HTOP_OK;
+
+   PageCacheScreen* pcs = PageCacheScreen_new(p);
+   InfoScreen_run((InfoScreen*)pcs);
+   PageCacheScreen_delete((Object*)pcs);
+   clear();
+   CRT_enableDelay();
+   return HTOP_REFRESH | HTOP_REDRAW_BAR;
+}
+
+static Htop_Reaction Platform_actionShowChurn(ATTR_UNUSED State* st) {
+   ChurnScreen* cs = ChurnScreen_new();
+   InfoScreen_run((InfoScreen*)cs);
+   ChurnScreen_delete((Object*)cs);
+   clear();
+   CRT_enableDelay();
+   return HTOP_REFRESH | HTOP_REDRAW_BAR;
+}
+
+static Htop_Reaction Platform_actionShowSlabs(State* st) {
+   SlabScreen* ss = SlabScreen_new(st->host);
+   InfoScreen_run((InfoScreen*)ss);
+   SlabScreen_delete((Object*)ss);
+   clear();
+   CRT_enableDelay();
+   return HTOP_REFRESH | HTOP_REDRAW_BAR;
+}
+
 void Platform_setBindings(Htop_Action* keys) {
    keys['i'] = Platform_actionSetIOPriority;
+#ifdef HAVE_PERF_EVENTS
+   keys['b'] = Platform_actionSampleStacks;
+#endif
+   keys['L'] = Platform_actionShowPageCache;
+   keys['X'] = Platform_actionShowChurn;
+   keys['B'] = Platform_actionShowSlabs;
    keys['{'] = Platform_actionLowerAutogroupPriority;
    keys['}'] = Platform_actionHigherAutogroupPriority;
    keys[KEY_F(19)] = Platform_actionLowerAutogroupPriority;  // Shift-F7
@@ -220,8 +433,10 @@ const MeterClass* const Platform_meterTypes[] = {
    &MemorySwapMeter_class,
    &SysArchMeter_class,
    &HugePageMeter_class,
+   &MemoryReclaimMeter_class,
    &TasksMeter_class,
    &UptimeMeter_class,
+   &SelfMeter_class,
    &BatteryMeter_class,
    &HostnameMeter_class,
    &AllCPUsMeter_class,
@@ -236,6 +451,16 @@ const MeterClass* const Platform_meterTypes[] = {
    &RightCPUs4Meter_class,
    &LeftCPUs8Meter_class,
    &RightCPUs8Meter_class,
+#ifdef HAVE_LIBHWLOC
+   &CPUNodesMeter_class,
+   &CPUSocketsMeter_class,
+   &CPUCachesMeter_class,
+   &CPUCoresMeter_class,
+   &BusiestCPUNodeMeter_class,
+   &BusiestCPUSocketMeter_class,
+   &BusiestCPUCacheMeter_class,
+   &BusiestCPUCoreMeter_class,
+#endif
    &BlankMeter_class,
    &PressureStallCPUSomeMeter_class,
    &PressureStallIOSomeMeter_class,
@@ -243,11 +468,27 @@ const MeterClass* const Platform_meterTypes[] = {
    &PressureStallIRQFullMeter_class,
    &PressureStallMemorySomeMeter_class,
    &PressureStallMemoryFullMeter_class,
+   &CPUThrottleMeter_class,
+   &MemoryBandwidthMeter_class,
+   &LLCOccupancyMeter_class,
    &ZfsArcMeter_class,
    &ZfsCompressedArcMeter_class,
    &ZramMeter_class,
+   &NumaMemoryMeter_class,
+   &GPUMeter_class,
+   &NVMLMeter_class,
+   &NVMLMemoryMeter_class,
+   &NVMLPowerMeter_class,
+   &RAPLMeter_class,
+   &ExitedTasksMeter_class,
+   &ProcessChurnMeter_class,
    &DiskIOMeter_class,
    &NetworkIOMeter_class,
+   &DiskIODevicesMeter_class,
+   &NetworkIODevicesMeter_class,
+   &SoftIRQMeter_class,
+   &IRQMeter_class,
+   &RunQueueMeter_class,
    &SELinuxMeter_class,
    &SystemdMeter_class,
    &SystemdUserMeter_class,
@@ -255,12 +496,15 @@ const MeterClass* const Platform_meterTypes[] = {
    NULL
 };
 
+/* Files read for meters on every update, kept open */
+static FsRootFile* Platform_uptimeFile;
+static FsRootFile* Platform_loadavgFile;
+
 int Platform_getUptime(void) {
    double uptime = 0;
-   FILE* fd = fopen(PROCDIR "/uptime", "r");
-   if (fd) {
-      int n = fscanf(fd, "%64lf", &uptime);
-      fclose(fd);
+   const char* content = FsRoot_readKept(&FsRoot_proc, &Platform_uptimeFile, "uptime", NULL);
+   if (content) {
+      int n = sscanf(content, "%64lf", &uptime);
       if (n <= 0) {
          return 0;
       }
@@ -269,13 +513,19 @@ int Platform_getUptime(void) {
 }
 
 void Platform_getLoadAverage(double* one, double* five, double* fifteen) {
-   FILE* fd = fopen(PROCDIR "/loadavg", "r");
-   if (!fd)
+   if (Replay_isOpen()) {
+      *one = (double)Replay_machineValue(RECORDER_MACHINE_LOAD1) / 100.0;
+      *five = (double)Replay_machineValue(RECORDER_MACHINE_LOAD5) / 100.0;
+      *fifteen = (double)Replay_machineValue(RECORDER_MACHINE_LOAD15) / 100.0;
+      return;
+   }
+
+   const char* content = FsRoot_readKept(&FsRoot_proc, &Platform_loadavgFile, "loadavg", NULL);
+   if (!content)
       goto err;
 
    double scanOne, scanFive, scanFifteen;
-   int r = fscanf(fd, "%lf %lf %lf", &scanOne, &scanFive, &scanFifteen);
-   fclose(fd);
+   int r = sscanf(content, "%lf %lf %lf", &scanOne, &scanFive, &scanFifteen);
    if (r != 3)
       goto err;
 
@@ -292,7 +542,7 @@ err:
 
 pid_t Platform_getMaxPid(void) {
    pid_t maxPid = 4194303;
-   FILE* file = fopen(PROCDIR "/sys/kernel/pid_max", "r");
+   FILE* file = FsRoot_fopen(&FsRoot_proc, "sys/kernel/pid_max", "r");
    if (!file)
       return maxPid;
 
@@ -359,9 +609,10 @@ void Platform_setMemoryValues(Meter* this) {
    const LinuxMachine* lhost = (const LinuxMachine*) host;
 
    this->total = host->totalMem;
-   this->values[MEMORY_METER_USED] = host->usedMem;
+   this->values[MEMORY_METER_USED] = host->usedMem - lhost->unreclaimableSlabMem;
    this->values[MEMORY_METER_SHARED] = host->sharedMem;
    this->values[MEMORY_METER_COMPRESSED] = 0; /* compressed */
+   this->values[MEMORY_METER_SLAB] = lhost->unreclaimableSlabMem;
    this->values[MEMORY_METER_BUFFERS] = host->buffersMem;
    this->values[MEMORY_METER_CACHE] = host->cachedMem;
    this->values[MEMORY_METER_AVAILABLE] = host->availableMem;
@@ -434,8 +685,8 @@ void Platform_setZfsCompressedArcValues(Meter* this) {
 
 char* Platform_getProcessEnv(pid_t pid) {
    char procname[128];
-   xSnprintf(procname, sizeof(procname), PROCDIR "/%d/environ", pid);
-   FILE* fd = fopen(procname, "r");
+   xSnprintf(procname, sizeof(procname), "%d/environ", pid);
+   FILE* fd = FsRoot_fopen(&FsRoot_proc, procname, "r");
    if (!fd)
       return NULL;
 
@@ -473,12 +724,15 @@ FileLocks_ProcessData* Platform_getProcessLocks(pid_t pid) {
    DIR* dirp;
    int dfd;
 
-   char path[PATH_MAX];
-   xSnprintf(path, sizeof(path), PROCDIR "/%d/fdinfo/", pid);
-   if (strlen(path) >= (sizeof(path) - 2))
-      goto err;
+   /* Without any lock in the system no fdinfo needs to be read */
+   uint64_t now;
+   Platform_gettime_monotonic(&now);
+   if (LockIndex_refresh(now) && LockIndex_total() == 0)
+      return pdata;
 
-   if (!(dirp = opendir(path)))
+   char path[PATH_MAX];
+   xSnprintf(path, sizeof(path), "%d/fdinfo", pid);
+   if (!(dirp = FsRoot_opendir(&FsRoot_proc, path)))
       goto err;
 
    if ((dfd = dirfd(dirp)) == -1) {
@@ -506,6 +760,10 @@ FileLocks_ProcessData* Platform_getProcessLocks(pid_t pid) {
          continue;
       }
 
+      /* the file is the same for all locks of the fd */
+      char link[PATH_MAX];
+      ssize_t link_len = -2;
+
       for (char buffer[1024]; fgets(buffer, sizeof(buffer), f); ) {
          if (!strchr(buffer, '\n'))
             continue;
@@ -533,11 +791,12 @@ FileLocks_ProcessData* Platform_getProcessLocks(pid_t pid) {
          else
             data.end = strtoull(lock_end, NULL, 10);
 
-         xSnprintf(path, sizeof(path), PROCDIR "/%d/fd/%s", pid, de->d_name);
-         char link[PATH_MAX];
-         ssize_t link_len;
-         if (strlen(path) < (sizeof(path) - 2) && (link_len = readlink(path, link, sizeof(link))) != -1)
-            data.filename = xStrndup(link, link_len);
+         if (link_len == -2) {
+            xSnprintf(path, sizeof(path), "%d/fd/%s", pid, de->d_name);
+            link_len = FsRoot_readlink(&FsRoot_proc, path, link, sizeof(link));
+         }
+         if (link_len >= 0)
+            data.filename = xStrndup(link, (size_t)link_len);
 
          *data_ref = xCalloc(1, sizeof(FileLocks_LockData));
          (*data_ref)->data = data;
@@ -555,74 +814,361 @@ err:
    return pdata;
 }
 
-void Platform_getPressureStall(const char* file, bool some, double* ten, double* sixty, double* threehundred) {
-   *ten = *sixty = *threehundred = 0;
-   char procname[128];
-   xSnprintf(procname, sizeof(procname), PROCDIR "/pressure/%s", file);
-   FILE* fd = fopen(procname, "r");
-   if (!fd) {
-      *ten = *sixty = *threehundred = NAN;
+/* A socket of the network namespace of a process, as lsof describes it */
+typedef struct Platform_SocketInfo_ {
+   uint64_t inode;
+   const char* type;
+   const char* protocol;    /* NULL to show the inode instead */
+   char name[];
+} Platform_SocketInfo;
+
+static void Platform_addSocket(Hashtable* sockets, uint64_t inode, const char* type, const char* protocol, const char* name) {
+   size_t len = strlen(name) + 1;
+   Platform_SocketInfo* socket = xMalloc(sizeof(Platform_SocketInfo) + len);
+   socket->inode = inode;
+   socket->type = type;
+   socket->protocol = protocol;
+   memcpy(socket->name, name, len);
+   Hashtable_put(sockets, (ht_key_t)inode, socket);
+}
+
+/* Formats an address of /proc/net/{tcp,udp}[6], as the kernel printed it word by word in host order */
+static bool Platform_formatSocketAddress(const char* hex, unsigned int port, bool ipv6, char* buffer, size_t size) {
+   unsigned char addr[16];
+   size_t words = ipv6 ? 4 : 1;
+   bool any = true;
+
+   for (size_t i = 0; i < words; i++) {
+      char word[9];
+      memcpy(word, hex + i * 8, 8);
+      word[8] = '\0';
+
+      char* end;
+      uint32_t value = (uint32_t)strtoul(word, &end, 16);
+      if (*end)
+         return false;
+
+      memcpy(addr + i * 4, &value, sizeof(value));
+      any = any && value == 0;
+   }
+
+   char host[INET6_ADDRSTRLEN] = "*";
+   if (!any && !inet_ntop(ipv6 ? AF_INET6 : AF_INET, addr, host, sizeof(host)))
+      return false;
+
+   if (ipv6 && !any) {
+      xSnprintf(buffer, size, "[%s]:%u", host, port);
+   } else {
+      xSnprintf(buffer, size, "%s:%u", host, port);
+   }
+   return true;
+}
+
+static void Platform_readInetSockets(Hashtable* sockets, pid_t pid, const char* file, const char* protocol, bool ipv6) {
+   static const char* const tcpStates[] = {
+      NULL, "ESTABLISHED", "SYN_SENT", "SYN_RECV", "FIN_WAIT1", "FIN_WAIT2", "TIME_WAIT",
+      "CLOSE", "CLOSE_WAIT", "LAST_ACK", "LISTEN", "CLOSING",
+   };
+
+   char path[64];
+   xSnprintf(path, sizeof(path), "%d/net/%s", pid, file);
+   FILE* f = FsRoot_fopen(&FsRoot_proc, path, "r");
+   if (!f)
+      return;
+
+   bool tcp = String_eq(protocol, "TCP");
+   for (char buffer[512]; fgets(buffer, sizeof(buffer), f); ) {
+      char localHex[33];
+      char remoteHex[33];
+      unsigned int localPort;
+      unsigned int remotePort;
+      unsigned int state;
+      uint64_t inode;
+      if (6 != sscanf(buffer, "%*u: %32[0-9A-Fa-f]:%x %32[0-9A-Fa-f]:%x %x %*s %*s %*s %*u %*u %"SCNu64,
+                      localHex, &localPort, remoteHex, &remotePort, &state, &inode))
+         continue;
+
+      if (strlen(localHex) != (ipv6 ? 32 : 8) || strlen(remoteHex) != strlen(localHex))
+         continue;
+
+      char local[INET6_ADDRSTRLEN + 8];
+      char remote[INET6_ADDRSTRLEN + 8];
+      if (!Platform_formatSocketAddress(localHex, localPort, ipv6, local, sizeof(local)) ||
+          !Platform_formatSocketAddress(remoteHex, remotePort, ipv6, remote, sizeof(remote)))
+         continue;
+
+      char name[2 * sizeof(local) + 20];
+      size_t len = (size_t)xSnprintf(name, sizeof(name), "%s", local);
+      if (remotePort != 0)
+         len += (size_t)xSnprintf(name + len, sizeof(name) - len, "->%s", remote);
+      if (tcp && state < ARRAYSIZE(tcpStates) && tcpStates[state])
+         xSnprintf(name + len, sizeof(name) - len, " (%s)", tcpStates[state]);
+
+      Platform_addSocket(sockets, inode, ipv6 ? "IPv6" : "IPv4", protocol, name);
+   }
+
+   fclose(f);
+}
+
+static void Platform_readUnixSockets(Hashtable* sockets, pid_t pid) {
+   static const char* const unixTypes[] = {
+      NULL, "STREAM", "DGRAM", "RAW", "RDM", "SEQPACKET",
+   };
+
+   char path[64];
+   xSnprintf(path, sizeof(path), "%d/net/unix", pid);
+   FILE* f = FsRoot_fopen(&FsRoot_proc, path, "r");
+   if (!f)
       return;
+
+   for (char buffer[PATH_MAX + 128]; fgets(buffer, sizeof(buffer), f); ) {
+      unsigned int type;
+      uint64_t inode;
+      int offset = 0;
+      if (2 != sscanf(buffer, "%*s %*s %*s %*s %x %*s %"SCNu64" %n", &type, &inode, &offset) || offset == 0)
+         continue;
+
+      char* name = buffer + offset;
+      name[strcspn(name, "\n")] = '\0';
+
+      char typeName[32];
+      if (!*name) {
+         xSnprintf(typeName, sizeof(typeName), "type=%s", type < ARRAYSIZE(unixTypes) && unixTypes[type] ? unixTypes[type] : "?");
+         name = typeName;
+      }
+
+      Platform_addSocket(sockets, inode, "unix", NULL, name);
+   }
+
+   fclose(f);
+}
+
+/* Sockets of the network namespace the process is in, by inode */
+static Hashtable* Platform_readSockets(pid_t pid) {
+   Hashtable* sockets = Hashtable_new(64, true);
+   Platform_readInetSockets(sockets, pid, "tcp", "TCP", false);
+   Platform_readInetSockets(sockets, pid, "tcp6", "TCP", true);
+   Platform_readInetSockets(sockets, pid, "udp", "UDP", false);
+   Platform_readInetSockets(sockets, pid, "udp6", "UDP", true);
+   Platform_readUnixSockets(sockets, pid);
+   return sockets;
+}
+
+/* Offset and access mode from the fdinfo of a descriptor */
+static void Platform_readFdInfo(int dfd, const char* name, OpenFiles_FileInfo* file) {
+   if (dfd == -1)
+      return;
+
+   char buffer[4096];
+   if (xReadfileat(dfd, name, buffer, sizeof(buffer)) <= 0)
+      return;
+
+   for (const char* line = buffer; line; line = strchr(line, '\n')) {
+      if (*line == '\n')
+         line++;
+
+      uint64_t pos;
+      unsigned int flags;
+      if (sscanf(line, "pos:\t%"SCNu64, &pos) == 1) {
+         file->offset = pos;
+         file->hasOffset = true;
+      } else if (sscanf(line, "flags:\t%o", &flags) == 1) {
+         switch (flags & O_ACCMODE) {
+            case O_RDONLY: file->mode = 'r'; break;
+            case O_WRONLY: file->mode = 'w'; break;
+            case O_RDWR: file->mode = 'u'; break;
+         }
+      }
+   }
+}
+
+static const char* Platform_fileType(mode_t mode) {
+   switch (mode & S_IFMT) {
+      case S_IFREG: return "REG";
+      case S_IFDIR: return "DIR";
+      case S_IFCHR: return "CHR";
+      case S_IFBLK: return "BLK";
+      case S_IFIFO: return "FIFO";
+      case S_IFLNK: return "LINK";
+      case S_IFSOCK: return "sock";
+      default: return "unknown";
    }
-   int total = fscanf(fd, "some avg10=%32lf avg60=%32lf avg300=%32lf total=%*f ", ten, sixty, threehundred);
-   if (!some) {
-      total = fscanf(fd, "full avg10=%32lf avg60=%32lf avg300=%32lf total=%*f ", ten, sixty, threehundred);
+}
+
+bool Platform_getProcessOpenFiles(pid_t pid, OpenFiles_AddFile addFile, void* context) {
+   char path[64];
+   xSnprintf(path, sizeof(path), "%d/fd", pid);
+   DIR* dirp = FsRoot_opendir(&FsRoot_proc, path);
+   if (!dirp)
+      return false;
+
+   int dfd = dirfd(dirp);
+   if (dfd == -1) {
+      closedir(dirp);
+      return false;
    }
+
+   xSnprintf(path, sizeof(path), "%d/fdinfo", pid);
+   DIR* infoDirp = FsRoot_opendir(&FsRoot_proc, path);
+   int infoDfd = infoDirp ? dirfd(infoDirp) : -1;
+
+   /* read on the first socket, a process may have none */
+   Hashtable* sockets = NULL;
+
+   for (const struct dirent* de; (de = readdir(dirp)); ) {
+      errno = 0;
+      char* end;
+      long fdNum = strtol(de->d_name, &end, 10);
+      if (errno || *end || end == de->d_name || fdNum < 0 || fdNum > INT_MAX)
+         continue;
+
+      char link[PATH_MAX];
+      ssize_t linkLen = readlinkat(dfd, de->d_name, link, sizeof(link) - 1);
+      if (linkLen < 0)
+         continue;
+      link[linkLen] = '\0';
+
+      OpenFiles_FileInfo file = { .fd = (int)fdNum, .type = "unknown", .name = link };
+      char node[24];
+
+      struct stat st;
+      if (fstatat(dfd, de->d_name, &st, 0) == 0) {
+         file.type = Platform_fileType(st.st_mode);
+
+         dev_t dev = (S_ISCHR(st.st_mode) || S_ISBLK(st.st_mode)) ? st.st_rdev : st.st_dev;
+         file.hasDevice = true;
+         file.devMajor = major(dev);
+         file.devMinor = minor(dev);
+
+         if (S_ISREG(st.st_mode) || S_ISDIR(st.st_mode)) {
+            file.hasSize = true;
+            file.size = (uint64_t)st.st_size;
+         }
+
+         xSnprintf(node, sizeof(node), "%"PRIu64, (uint64_t)st.st_ino);
+         file.node = node;
+
+         if (S_ISSOCK(st.st_mode)) {
+            if (!sockets)
+               sockets = Platform_readSockets(pid);
+
+            const Platform_SocketInfo* socket = Hashtable_get(sockets, (ht_key_t)st.st_ino);
+            if (socket && socket->inode == (uint64_t)st.st_ino) {
+               file.type = socket->type;
+               file.name = socket->name;
+               if (socket->protocol)
+                  file.node = socket->protocol;
+            }
+         } else if (String_startsWith(link, "anon_inode:")) {
+            file.type = "a_inode";
+         }
+      }
+
+      Platform_readFdInfo(infoDfd, de->d_name, &file);
+
+      addFile(context, &file);
+   }
+
+   if (sockets)
+      Hashtable_delete(sockets);
+   if (infoDirp)
+      closedir(infoDirp);
+   closedir(dirp);
+   return true;
+}
+
+typedef struct PressureStallData_ {
+   double some[3];
+   double full[3];
+} PressureStallData;
+
+static void Platform_readPressureStall(const char* file, PressureStallData* data) {
+   for (size_t i = 0; i < 3; i++)
+      data->some[i] = data->full[i] = NAN;
+
+   char procname[128];
+   xSnprintf(procname, sizeof(procname), "pressure/%s", file);
+   FILE* fd = FsRoot_fopen(&FsRoot_proc, procname, "r");
+   if (!fd)
+      return;
+
+   double* some = data->some;
+   double* full = data->full;
+   for (size_t i = 0; i < 3; i++)
+      some[i] = full[i] = 0;
+
+   /* the irq file only has a full line */
+   int total = fscanf(fd, "some avg10=%32lf avg60=%32lf avg300=%32lf total=%*f ", &some[0], &some[1], &some[2]);
+   total = fscanf(fd, "full avg10=%32lf avg60=%32lf avg300=%32lf total=%*f ", &full[0], &full[1], &full[2]);
    (void) total;
-   assert(total == 3);
    fclose(fd);
 }
 
+void Platform_getPressureStall(const char* file, bool some, double* ten, double* sixty, double* threehundred) {
+   static PressureStallData cache[4];
+
+   SourceCacheKey key;
+   if (String_eq(file, "cpu")) {
+      key = SOURCE_PRESSURE_CPU;
+   } else if (String_eq(file, "io")) {
+      key = SOURCE_PRESSURE_IO;
+   } else if (String_eq(file, "irq")) {
+      key = SOURCE_PRESSURE_IRQ;
+   } else {
+      key = SOURCE_PRESSURE_MEMORY;
+   }
+
+   PressureStallData* data = &cache[key - SOURCE_PRESSURE_CPU];
+   if (SourceCache_isStale(key))
+      Platform_readPressureStall(file, data);
+
+   const double* values = some ? data->some : data->full;
+   *ten = values[0];
+   *sixty = values[1];
+   *threehundred = values[2];
+}
+
 void Platform_getFileDescriptors(double* used, double* max) {
-   *used = NAN;
-   *max = 65536;
+   static double cachedUsed = NAN;
+   static double cachedMax = 65536;
+
+   if (!SourceCache_isStale(SOURCE_FILE_NR))
+      goto out;
 
-   FILE* fd = fopen(PROCDIR "/sys/fs/file-nr", "r");
+   cachedUsed = NAN;
+   cachedMax = 65536;
+
+   FILE* fd = FsRoot_fopen(&FsRoot_proc, "sys/fs/file-nr", "r");
    if (!fd)
-      return;
+      goto out;
 
    unsigned long long v1, v2, v3;
    int total = fscanf(fd, "%llu %llu %llu", &v1, &v2, &v3);
    if (total == 3) {
-      *used = v1;
-      *max = v3;
+      cachedUsed = v1;
+      cachedMax = v3;
    }
 
    fclose(fd);
+
+out:
+   *used = cachedUsed;
+   *max = cachedMax;
 }
 
 bool Platform_getDiskIO(DiskIOData* data) {
-   FILE* fd = fopen(PROCDIR "/diskstats", "r");
-   if (!fd)
+   const IODeviceList* disks = IODevices_get(IODEVICE_DISK);
+   if (!disks->valid)
       return false;
 
-   char lastTopDisk[32] = { '\0' };
-
    unsigned long long int read_sum = 0, write_sum = 0, timeSpend_sum = 0;
-   char lineBuffer[256];
-   while (fgets(lineBuffer, sizeof(lineBuffer), fd)) {
-      char diskname[32];
-      unsigned long long int read_tmp, write_tmp, timeSpend_tmp;
-      if (sscanf(lineBuffer, "%*d %*d %31s %*u %*u %llu %*u %*u %*u %llu %*u %*u %llu", diskname, &read_tmp, &write_tmp, &timeSpend_tmp) == 4) {
-         if (String_startsWith(diskname, "dm-"))
-            continue;
-
-         if (String_startsWith(diskname, "zram"))
-            continue;
-
-         /* only count root disks, e.g. do not count IO from sda and sda1 twice */
-         if (lastTopDisk[0] && String_startsWith(diskname, lastTopDisk))
-            continue;
-
-         /* This assumes disks are listed directly before any of their partitions */
-         String_safeStrncpy(lastTopDisk, diskname, sizeof(lastTopDisk));
-
-         read_sum += read_tmp;
-         write_sum += write_tmp;
-         timeSpend_sum += timeSpend_tmp;
-      }
+   for (size_t i = 0; i < disks->count; i++) {
+      const unsigned long long int* counters = disks->devices[i].counters;
+      read_sum += counters[IODEVICE_DISK_READ];
+      write_sum += counters[IODEVICE_DISK_WRITTEN];
+      timeSpend_sum += counters[IODEVICE_DISK_BUSY_MS];
    }
-   fclose(fd);
+
    /* multiply with sector size */
    data->totalBytesRead = 512 * read_sum;
    data->totalBytesWritten = 512 * write_sum;
@@ -631,50 +1177,35 @@ bool Platform_getDiskIO(DiskIOData* data) {
 }
 
 bool Platform_getNetworkIO(NetworkIOData* data) {
-   FILE* fd = fopen(PROCDIR "/net/dev", "r");
-   if (!fd)
+   const IODeviceList* interfaces = IODevices_get(IODEVICE_NETWORK);
+   if (!interfaces->valid)
       return false;
 
    memset(data, 0, sizeof(NetworkIOData));
-   char lineBuffer[512];
-   while (fgets(lineBuffer, sizeof(lineBuffer), fd)) {
-      char interfaceName[32];
-      unsigned long long int bytesReceived, packetsReceived, bytesTransmitted, packetsTransmitted;
-      if (sscanf(lineBuffer, "%31s %llu %llu %*u %*u %*u %*u %*u %*u %llu %llu",
-                             interfaceName,
-                             &bytesReceived,
-                             &packetsReceived,
-                             &bytesTransmitted,
-                             &packetsTransmitted) != 5)
-         continue;
-
-      if (String_eq(interfaceName, "lo:"))
-         continue;
-
-      data->bytesReceived += bytesReceived;
-      data->packetsReceived += packetsReceived;
-      data->bytesTransmitted += bytesTransmitted;
-      data->packetsTransmitted += packetsTransmitted;
+   for (size_t i = 0; i < interfaces->count; i++) {
+      const unsigned long long int* counters = interfaces->devices[i].counters;
+      data->bytesReceived += counters[IODEVICE_NETWORK_RX_BYTES];
+      data->packetsReceived += counters[IODEVICE_NETWORK_RX_PACKETS];
+      data->bytesTransmitted += counters[IODEVICE_NETWORK_TX_BYTES];
+      data->packetsTransmitted += counters[IODEVICE_NETWORK_TX_PACKETS];
    }
 
-   fclose(fd);
-
    return true;
 }
 
 // Linux battery reading by Ian P. Hands (iphands@gmail.com, ihands@redhat.com).
 
-#define PROC_BATTERY_DIR PROCDIR "/acpi/battery"
-#define PROC_POWERSUPPLY_DIR PROCDIR "/acpi/ac_adapter"
+#define PROC_BATTERY_DIR "acpi/battery"
+#define PROC_POWERSUPPLY_DIR "acpi/ac_adapter"
 #define PROC_POWERSUPPLY_ACSTATE_FILE PROC_POWERSUPPLY_DIR "/AC/state"
-#define SYS_POWERSUPPLY_DIR "/sys/class/power_supply"
+#define SYS_POWERSUPPLY_DIR "class/power_supply"
 
 // ----------------------------------------
 // READ FROM /proc
 // ----------------------------------------
 
 static double Platform_Battery_getProcBatInfo(void) {
-   DIR* batteryDir = opendir(PROC_BATTERY_DIR);
+   DIR* batteryDir = FsRoot_opendir(&FsRoot_proc, PROC_BATTERY_DIR);
    if (!batteryDir)
       return NAN;
 
@@ -690,13 +1221,13 @@ static double Platform_Battery_getProcBatInfo(void) {
       char filePath[256];
       char bufInfo[1024] = {0};
       xSnprintf(filePath, sizeof(filePath), "%s/%s/info", PROC_BATTERY_DIR, entryName);
-      ssize_t r = xReadfile(filePath, bufInfo, sizeof(bufInfo));
+      ssize_t r = FsRoot_readFile(&FsRoot_proc, filePath, bufInfo, sizeof(bufInfo));
       if (r < 0)
          continue;
 
       char bufState[1024] = {0};
       xSnprintf(filePath, sizeof(filePath), "%s/%s/state", PROC_BATTERY_DIR, entryName);
-      r = xReadfile(filePath, bufState, sizeof(bufState));
+      r = FsRoot_readFile(&FsRoot_proc, filePath, bufState, sizeof(bufState));
       if (r < 0)
          continue;
 
@@ -738,7 +1269,7 @@ static double Platform_Battery_getProcBatInfo(void) {
 
 static ACPresence procAcpiCheck(void) {
    char buffer[1024] = {0};
-   ssize_t r = xReadfile(PROC_POWERSUPPLY_ACSTATE_FILE, buffer, sizeof(buffer));
+   ssize_t r = FsRoot_readFile(&FsRoot_proc, PROC_POWERSUPPLY_ACSTATE_FILE, buffer, sizeof(buffer));
    if (r < 1)
       return AC_ERROR;
 
@@ -754,16 +1285,82 @@ static void Platform_Battery_getProcData(double* percent, ACPresence* isOnAC) {
 // READ FROM /sys
 // ----------------------------------------
 
-static void Platform_Battery_getSysData(double* percent, ACPresence* isOnAC) {
-   *percent = NAN;
-   *isOnAC = AC_ERROR;
+static void Platform_Battery_forgetSupplies(void) {
+   for (size_t i = 0; i < Platform_Battery_nSupplies; i++)
+      close(Platform_Battery_supplies[i].fd);
+
+   free(Platform_Battery_supplies);
+   Platform_Battery_supplies = NULL;
+   Platform_Battery_nSupplies = 0;
+   Platform_Battery_discovered = false;
+}
+
+/* Listens to kernel uevents, so supplies added or removed are noticed without enumerating sysfs on every update */
+static void Platform_Battery_openUeventSocket(void) {
+   if (Platform_Battery_ueventSocket >= 0)
+      return;
+
+   int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+   if (fd < 0)
+      return;
+
+   struct sockaddr_nl addr = {
+      .nl_family = AF_NETLINK,
+      .nl_groups = 1, /* kernel events */
+   };
+   if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+      close(fd);
+      return;
+   }
+
+   Platform_Battery_ueventSocket = fd;
+}
+
+/* Drains the pending uevents; true if a power supply was added or removed */
+static bool Platform_Battery_suppliesChanged(void) {
+   if (Platform_Battery_ueventSocket < 0)
+      return false;
+
+   bool changed = false;
+   char buffer[4096];
+
+   for (;;) {
+      ssize_t r = recv(Platform_Battery_ueventSocket, buffer, sizeof(buffer) - 1, MSG_DONTWAIT);
+      if (r < 0) {
+         if (errno == EINTR)
+            continue;
 
-   DIR* dir = opendir(SYS_POWERSUPPLY_DIR);
+         /* lost events on overflow, assume the worst */
+         if (errno == ENOBUFS) {
+            changed = true;
+            continue;
+         }
+
+         break;
+      }
+
+      if (r == 0)
+         break;
+
+      buffer[r] = '\0';
+
+      /* first the "<action>@<devpath>" header; "change" is sent on every charge update */
+      if ((String_startsWith(buffer, "add@") || String_startsWith(buffer, "remove@")) && strstr(buffer, "/power_supply/"))
+         changed = true;
+   }
+
+   return changed;
+}
+
+static void Platform_Battery_discoverSupplies(void) {
+   Platform_Battery_openUeventSocket();
+   Platform_Battery_discovered = true;
+
+   DIR* dir = FsRoot_opendir(&FsRoot_sys, SYS_POWERSUPPLY_DIR);
    if (!dir)
       return;
 
-   uint64_t totalFull = 0;
-   uint64_t totalRemain = 0;
+   size_t capacity = 0;
 
    const struct dirent* dirEntry;
    while ((dirEntry = readdir(dir))) {
@@ -775,7 +1372,7 @@ static void Platform_Battery_getSysData(double* percent, ACPresence* isOnAC) {
          continue;
 #else
       char entryFd[4096];
-      xSnprintf(entryFd, sizeof(entryFd), SYS_POWERSUPPLY_DIR "/%s", entryName);
+      xSnprintf(entryFd, sizeof(entryFd), "%s/" SYS_POWERSUPPLY_DIR "/%s", FsRoot_sys.path, entryName);
 #endif
 
       enum { AC, BAT } type;
@@ -801,11 +1398,56 @@ static void Platform_Battery_getSysData(double* percent, ACPresence* isOnAC) {
             goto next;
       }
 
-      if (type == BAT) {
+      int fd = Compat_openat(entryFd, type == BAT ? "uevent" : "online", O_RDONLY | O_CLOEXEC);
+      if (fd < 0)
+         goto next;
+
+      if (Platform_Battery_nSupplies == capacity) {
+         capacity = capacity ? capacity * 2 : 4;
+         Platform_Battery_supplies = xReallocArray(Platform_Battery_supplies, capacity, sizeof(*Platform_Battery_supplies));
+      }
+      Platform_Battery_supplies[Platform_Battery_nSupplies++] = (PowerSupply) { .battery = type == BAT, .fd = fd };
+
+next:
+      Compat_openatArgClose(entryFd);
+   }
+
+   closedir(dir);
+}
+
+/* Re-reads a kept sysfs attribute from its start, null-terminated like xReadfileat() */
+static ssize_t Platform_Battery_readSupply(int fd, char* buffer, size_t count) {
+   for (;;) {
+      ssize_t r = pread(fd, buffer, count - 1, 0);
+      if (r < 0) {
+         if (errno == EINTR)
+            continue;
+
+         buffer[0] = '\0';
+         return -errno;
+      }
+
+      buffer[r] = '\0';
+      return r;
+   }
+}
+
+/* False on a read error, e.g. the supply was removed */
+static bool Platform_Battery_readSupplies(double* percent, ACPresence* isOnAC) {
+   *percent = NAN;
+   *isOnAC = AC_ERROR;
+
+   uint64_t totalFull = 0;
+   uint64_t totalRemain = 0;
+
+   for (size_t i = 0; i < Platform_Battery_nSupplies; i++) {
+      const PowerSupply* supply = &Platform_Battery_supplies[i];
+
+      if (supply->battery) {
          char buffer[1024];
-         ssize_t r = xReadfileat(entryFd, "uevent", buffer, sizeof(buffer));
+         ssize_t r = Platform_Battery_readSupply(supply->fd, buffer, sizeof(buffer));
          if (r < 0)
-            goto next;
+            return false;
 
          bool full = false;
          bool now = false;
@@ -847,30 +1489,43 @@ static void Platform_Battery_getSysData(double* percent, ACPresence* isOnAC) {
          if (!now && full && isNonnegative(capacityLevel))
             totalRemain += capacityLevel * fullCharge;
 
-      } else if (type == AC) {
+      } else {
          if (*isOnAC != AC_ERROR)
-            goto next;
+            continue;
 
          char buffer[2];
-         ssize_t r = xReadfileat(entryFd, "online", buffer, sizeof(buffer));
-         if (r < 1) {
-            *isOnAC = AC_ERROR;
-            goto next;
-         }
+         ssize_t r = Platform_Battery_readSupply(supply->fd, buffer, sizeof(buffer));
+         if (r < 0)
+            return false;
 
          if (buffer[0] == '0')
             *isOnAC = AC_ABSENT;
          else if (buffer[0] == '1')
             *isOnAC = AC_PRESENT;
       }
-
-next:
-      Compat_openatArgClose(entryFd);
    }
 
-   closedir(dir);
-
    *percent = totalFull > 0 ? ((double) totalRemain * 100.0) / (double) totalFull : NAN;
+   return true;
+}
+
+static void Platform_Battery_getSysData(double* percent, ACPresence* isOnAC) {
+   if (Platform_Battery_discovered && Platform_Battery_suppliesChanged())
+      Platform_Battery_forgetSupplies();
+
+   if (!Platform_Battery_discovered)
+      Platform_Battery_discoverSupplies();
+
+   if (Platform_Battery_readSupplies(percent, isOnAC))
+      return;
+
+   /* the set of supplies changed unnoticed, enumerate them again once */
+   Platform_Battery_forgetSupplies();
+   Platform_Battery_discoverSupplies();
+   if (!Platform_Battery_readSupplies(percent, isOnAC)) {
+      *percent = NAN;
+      *isOnAC = AC_ERROR;
+   }
 }
 
 void Platform_getBattery(double* percent, ACPresence* isOnAC) {
@@ -914,6 +1569,31 @@ void Platform_longOptionsUsage(const char* name)
 "                                         core functionality\n", name);
 #else
    (void) name;
+#endif
+   printf(
+"   --proc-root=DIR              Read process and system data from DIR instead of " PROCDIR "\n"
+"   --sys-root=DIR               Read hardware data from DIR instead of " SYSDIR "\n"
+"   --serve[=ADDR]               Scan at the update interval for any number of --attach viewers\n"
+"                                instead of showing the processes, also streaming the scans\n"
+"                                on [HOST:]PORT or unix:PATH\n"
+"   --attach[=ADDR]              Show the processes scanned by a running --serve collector,\n"
+"                                or the ones streamed by the collector at ADDR\n"
+"   --replay=FILE                Show a recording of --record frame by frame instead of the\n"
+"                                processes running now\n"
+"   --cgroup=PATH                Only scan the processes of the cgroup PATH and the ones below it\n"
+"   --low-impact                 Scan at idle CPU and I/O priority, yielding to a busy system\n");
+}
+
+void Platform_lowerThreadPriority(void) {
+   /* on Linux both act on the calling thread for 0, unlike what POSIX says */
+#ifdef SCHED_IDLE
+   const struct sched_param param = { .sched_priority = 0 };
+   if (sched_setscheduler(0, SCHED_IDLE, &param) != 0)
+#endif
+      (void) setpriority(PRIO_PROCESS, 0, 19);
+
+#ifdef SYS_ioprio_set
+   (void) syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPriority_Idle);
 #endif
 }
 
@@ -924,6 +1604,43 @@ CommandLineStatus Platform_getLongOption(int opt, int argc, char** argv) {
 #endif
 
    switch (opt) {
+      case 161:
+      case 162:
+         if (!FsRoot_setPath(opt == 161 ? &FsRoot_proc : &FsRoot_sys, optarg)) {
+            fprintf(stderr, "Error: empty path for --%s.\n", opt == 161 ? "proc-root" : "sys-root");
+            return STATUS_ERROR_EXIT;
+         }
+         return STATUS_OK;
+
+      case 163:
+      case 164:
+         SharedScan_mode = opt == 163 ? SHARED_SCAN_SERVE : SHARED_SCAN_ATTACH;
+         if (optarg) {
+            if (!optarg[0]) {
+               fprintf(stderr, "Error: empty address for --%s.\n", opt == 163 ? "serve" : "attach");
+               return STATUS_ERROR_EXIT;
+            }
+            ScanStream_address = optarg;
+            /* the processes shown are not the ones of this machine */
+            if (opt == 164)
+               Settings_enableReadonly();
+         }
+         return STATUS_OK;
+
+      case 165:
+         if (!Replay_open(optarg))
+            return STATUS_ERROR_EXIT;
+         Settings_enableReadonly();
+         return STATUS_OK;
+
+      case 166:
+         CGroupScope_path = optarg;
+         return STATUS_OK;
+
+      case 167:
+         Platform_lowImpact = true;
+         return STATUS_OK;
+
 #ifdef HAVE_LIBCAP
       case 160: {
          const char* mode = optarg;
@@ -970,6 +1687,10 @@ static int dropCapabilities(enum CapMode mode) {
       CAP_SYS_PTRACE,        /* read /proc/[pid]/exe */
 #ifdef HAVE_DELAYACCT
       CAP_NET_ADMIN,         /* communicate over netlink socket for delay accounting */
+#endif
+#if defined(HAVE_BPF_COLUMNS) && defined(CAP_BPF) && defined(CAP_PERFMON)
+      CAP_BPF,               /* read the maps of linux/bpf and attach its programs, see linux/Bpf.h */
+      CAP_PERFMON,           /* attach those programs to tracepoints and kprobes */
 #endif
    };
    const cap_value_t* const keepcaps = (mode == CAP_MODE_BASIC) ? keepcapsBasic : keepcapsStrict;
@@ -1044,17 +1765,26 @@ bool Platform_init(void) {
       return false;
 #endif
 
-   if (access(PROCDIR, R_OK) != 0) {
-      fprintf(stderr, "Error: could not read procfs (compiled to look in %s).\n", PROCDIR);
+#ifdef HAVE_BPF_COLUMNS
+   Bpf_init();
+#endif
+
+   if (!FsRoot_open(&FsRoot_proc)) {
+      fprintf(stderr, "Error: could not read procfs in %s.\n", FsRoot_proc.path);
       return false;
    }
 
-#ifdef HAVE_SENSORS_SENSORS_H
-   LibSensors_init();
-#endif
+   /* not fatal, sysfs is missing in some containers */
+   if (FsRoot_open(&FsRoot_sys))
+      Platform_cgroupRoot = CGroupTable_findRoot();
+
+   if (CGroupScope_path && !CGroupScope_open(Platform_cgroupRoot)) {
+      fprintf(stderr, "Error: could not open cgroup %s in the cgroup v2 hierarchy.\n", CGroupScope_path);
+      return false;
+   }
 
    char target[PATH_MAX];
-   ssize_t ret = readlink(PROCDIR "/self/ns/pid", target, sizeof(target) - 1);
+   ssize_t ret = FsRoot_readlink(&FsRoot_proc, "self/ns/pid", target, sizeof(target) - 1);
    if (ret > 0) {
       target[ret] = '\0';
 
@@ -1064,7 +1794,7 @@ bool Platform_init(void) {
       }
    }
 
-   FILE* fd = fopen(PROCDIR "/1/mounts", "r");
+   FILE* fd = FsRoot_fopen(&FsRoot_proc, "1/mounts", "r");
    if (fd) {
       char lineBuffer[256];
       while (fgets(lineBuffer, sizeof(lineBuffer), fd)) {
@@ -1084,4 +1814,171 @@ void Platform_done(void) {
 #ifdef HAVE_SENSORS_SENSORS_H
    LibSensors_cleanup();
 #endif
+
+   /* the power supplies are left open: the battery meter may still be updating on the meter worker */
+
+   LockIndex_cleanup();
+   #ifdef HAVE_BPF_COLUMNS
+   Bpf_done();
+   #endif
+   NVML_cleanup();
+   RAPL_cleanup();
+   NumaMemory_cleanup();
+   CPUFreqCounters_close();
+   ContainerNames_cleanup();
+   ExitedTasks_cleanup();
+   ProcessChurn_cleanup();
+   CGroupScope_close();
+   FsRoot_close(&FsRoot_proc);
+   FsRoot_close(&FsRoot_sys);
+   Replay_close();
+   Platform_uptimeFile = NULL;
+   Platform_loadavgFile = NULL;
+   IODevices_done();
+   Resctrl_done();
+}
+
+static void Platform_dynamicColumnDone(ATTR_UNUSED ht_key_t key, void* value, ATTR_UNUSED void* data) {
+   DynamicColumn_done((DynamicColumn*) value);
+}
+
+/* The screens with their columns, the cgroup screen only if the v2 hierarchy is mounted */
+static bool Platform_hasScreen(size_t i) {
+   return i != PLATFORM_SCREEN_CGROUPS || Platform_cgroupRoot;
+}
+
+static PlatformScreen* Platform_findScreen(const char* name) {
+   for (size_t i = 0; i < PLATFORM_SCREEN_COUNT; i++)
+      if (Platform_hasScreen(i) && String_eq(Platform_screens[i].name, name))
+         return &Platform_screens[i];
+   return NULL;
+}
+
+Hashtable* Platform_dynamicColumns(void) {
+   Platform_columns = Hashtable_new(LAST_CGROUP_FIELD + LAST_USERTOTALS_FIELD + LAST_WAITCHANNEL_FIELD + LAST_CPUOCCUPANCY_FIELD + LAST_EXITEDTASK_FIELD + LAST_GUEST_FIELD, true);
+   if (Platform_cgroupRoot)
+      CGroupRow_addColumns(Platform_columns);
+   UserTotalsRow_addColumns(Platform_columns);
+   WaitChannelRow_addColumns(Platform_columns);
+   CPUOccupancyRow_addColumns(Platform_columns);
+   ExitedTaskRow_addColumns(Platform_columns);
+   GuestRow_addColumns(Platform_columns);
+   return Platform_columns;
+}
+
+void Platform_dynamicColumnsDone(Hashtable* table) {
+   Hashtable_foreach(table, Platform_dynamicColumnDone, NULL);
+   if (table == Platform_columns)
+      Platform_columns = NULL;
+}
+
+const char* Platform_dynamicColumnName(unsigned int key) {
+   const DynamicColumn* column = Platform_columns ? Hashtable_get(Platform_columns, key) : NULL;
+   if (!column)
+      return NULL;
+   return column->caption ? column->caption : column->name;
+}
+
+Hashtable* Platform_dynamicScreens(void) {
+   Hashtable* screens = Hashtable_new(PLATFORM_SCREEN_COUNT, true);
+   if (!Platform_columns)
+      return screens;
+
+   for (size_t i = 0; i < PLATFORM_SCREEN_COUNT; i++) {
+      const PlatformScreen* ps = &Platform_screens[i];
+      if (!Platform_hasScreen(i))
+         continue;
+
+      char columnKeys[512] = "";
+      for (int j = 0; j < ps->columnCount; j++) {
+         const DynamicColumn* column = Hashtable_get(Platform_columns, ps->firstKey + j);
+         size_t len = strlen(columnKeys);
+         xSnprintf(columnKeys + len, sizeof(columnKeys) - len, "%sDynamic(%s)", j ? " " : "", column->name);
+      }
+
+      DynamicScreen* screen = xCalloc(1, sizeof(DynamicScreen));
+      String_safeStrncpy(screen->name, ps->name, sizeof(screen->name));
+      screen->heading = xStrdup(ps->heading);
+      screen->caption = xStrdup(ps->caption);
+      screen->sortKey = ps->sortKey ? xStrdup(ps->sortKey) : NULL;
+      screen->columnKeys = xStrdup(columnKeys);
+      screen->direction = -1;
+      Hashtable_put(screens, i, screen);
+   }
+
+   return screens;
+}
+
+/* Screens start in the view of their platform screen, a .tree_view read after .dynamic overrides it */
+void Platform_addDynamicScreen(ScreenSettings* ss) {
+   const PlatformScreen* ps = Platform_findScreen(ss->dynamic);
+   if (!ps)
+      return;
+
+   ss->treeView = ps->treeView;
+   if (ps->table)
+      ss->table = ps->table;
+}
+
+void Platform_addDynamicScreenAvailableColumns(Panel* availableColumns, const char* screen) {
+   const PlatformScreen* ps = Platform_findScreen(screen);
+   if (!Platform_columns || !ps)
+      return;
+
+   for (int i = 0; i < ps->columnCount; i++) {
+      const RowField key = ps->firstKey + i;
+      const DynamicColumn* column = Hashtable_get(Platform_columns, key);
+      char description[256];
+      xSnprintf(description, sizeof(description), "%s - %s", column->heading, column->description);
+      Panel_add(availableColumns, (Object*) ListItem_new(description, key));
+   }
+}
+
+static void Platform_dynamicScreenDone(ATTR_UNUSED ht_key_t key, void* value, ATTR_UNUSED void* data) {
+   DynamicScreen_done((DynamicScreen*) value);
+}
+
+void Platform_dynamicScreensDone(Hashtable* screens) {
+   Hashtable_foreach(screens, Platform_dynamicScreenDone, NULL);
+
+   for (size_t i = 0; i < PLATFORM_SCREEN_COUNT; i++) {
+      PlatformScreen* ps = &Platform_screens[i];
+      if (ps->table) {
+         Object_delete(ps->table);
+         ps->table = NULL;
+      }
+   }
+}
+
+void Platform_updateTables(Machine* host) {
+   if (Platform_cgroupRoot && !Platform_screens[PLATFORM_SCREEN_CGROUPS].table)
+      Platform_screens[PLATFORM_SCREEN_CGROUPS].table = &CGroupTable_new(host, Platform_cgroupRoot)->super;
+   if (!Platform_screens[PLATFORM_SCREEN_USERS].table)
+      Platform_screens[PLATFORM_SCREEN_USERS].table = &UserTotalsTable_new(host)->super;
+   if (!Platform_screens[PLATFORM_SCREEN_WAITS].table)
+      Platform_screens[PLATFORM_SCREEN_WAITS].table = &WaitChannelTable_new(host)->super;
+   if (!Platform_screens[PLATFORM_SCREEN_OCCUPANCY].table)
+      Platform_screens[PLATFORM_SCREEN_OCCUPANCY].table = &CPUOccupancyTable_new(host)->super;
+   if (!Platform_screens[PLATFORM_SCREEN_EXITED].table)
+      Platform_screens[PLATFORM_SCREEN_EXITED].table = &ExitedTaskTable_new(host)->super;
+   if (!Platform_screens[PLATFORM_SCREEN_GUESTS].table)
+      Platform_screens[PLATFORM_SCREEN_GUESTS].table = &GuestTable_new(host)->super;
+
+   /* the columns only belong to the screen of their table */
+   if (!Platform_columns)
+      return;
+
+   for (size_t i = 0; i < PLATFORM_SCREEN_COUNT; i++) {
+      const PlatformScreen* ps = &Platform_screens[i];
+      for (int j = 0; ps->table && j < ps->columnCount; j++) {
+         DynamicColumn* column = Hashtable_get(Platform_columns, ps->firstKey + j);
+         if (column)
+            column->table = ps->table;
+      }
+   }
+
+   /* a cell of the grid per CPU, as far as there is room */
+   DynamicColumn* grid = Hashtable_get(Platform_columns, CPUOccupancyField_key(CPUOCCUPANCY_FIELD_GRID));
+   if (grid)
+      grid->width = -(int)MAXIMUM(CPUOccupancyRow_cells(host), 8);
 }
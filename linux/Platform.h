@@ -21,6 +21,7 @@ in the source distribution for its full text.
 #include "Macros.h"
 #include "Meter.h"
 #include "NetworkIOMeter.h"
+#include "OpenFilesScreen.h"
 #include "Panel.h"
 #include "Process.h"
 #include "ProcessLocksScreen.h"
@@ -54,6 +55,9 @@ void Platform_done(void);
 
 extern bool Running_containerized;
 
+/* Set by --low-impact: the threads scanning the system run at idle CPU and I/O priority */
+extern bool Platform_lowImpact;
+
 void Platform_setBindings(Htop_Action* keys);
 
 int Platform_getUptime(void);
@@ -78,6 +82,8 @@ char* Platform_getProcessEnv(pid_t pid);
 
 FileLocks_ProcessData* Platform_getProcessLocks(pid_t pid);
 
+bool Platform_getProcessOpenFiles(pid_t pid, OpenFiles_AddFile addFile, void* context);
+
 void Platform_getPressureStall(const char* file, bool some, double* ten, double* sixty, double* threehundred);
 
 void Platform_getFileDescriptors(double* used, double* max);
@@ -97,14 +103,27 @@ static inline void Platform_getRelease(char** string) {
 }
 
 #ifdef HAVE_LIBCAP
-   #define PLATFORM_LONG_OPTIONS \
+   #define PLATFORM_LONG_OPTIONS_CAPABILITIES \
       {"drop-capabilities", optional_argument, 0, 160},
 #else
-   #define PLATFORM_LONG_OPTIONS
+   #define PLATFORM_LONG_OPTIONS_CAPABILITIES
 #endif
 
+#define PLATFORM_LONG_OPTIONS \
+   PLATFORM_LONG_OPTIONS_CAPABILITIES \
+   {"proc-root", required_argument, 0, 161}, \
+   {"sys-root", required_argument, 0, 162}, \
+   {"serve", optional_argument, 0, 163}, \
+   {"attach", optional_argument, 0, 164}, \
+   {"replay", required_argument, 0, 165}, \
+   {"cgroup", required_argument, 0, 166}, \
+   {"low-impact", no_argument, 0, 167},
+
 void Platform_longOptionsUsage(const char* name);
 
+/* Moves the calling thread, not the whole process, to idle CPU and I/O priority */
+void Platform_lowerThreadPriority(void);
+
 CommandLineStatus Platform_getLongOption(int opt, int argc, char** argv);
 
 static inline void Platform_gettime_realtime(struct timeval* tv, uint64_t* msec) {
@@ -127,30 +146,27 @@ static inline void Platform_dynamicMeterUpdateValues(ATTR_UNUSED Meter* meter) {
 
 static inline void Platform_dynamicMeterDisplay(ATTR_UNUSED const Meter* meter, ATTR_UNUSED RichString* out) { }
 
-static inline Hashtable* Platform_dynamicColumns(void) {
-   return NULL;
-}
+Hashtable* Platform_dynamicColumns(void);
 
-static inline void Platform_dynamicColumnsDone(ATTR_UNUSED Hashtable* table) { }
+void Platform_dynamicColumnsDone(Hashtable* table);
 
-static inline const char* Platform_dynamicColumnName(ATTR_UNUSED unsigned int key) {
-   return NULL;
-}
+const char* Platform_dynamicColumnName(unsigned int key);
 
 static inline bool Platform_dynamicColumnWriteField(ATTR_UNUSED const Process* proc, ATTR_UNUSED RichString* str, ATTR_UNUSED unsigned int key) {
    return false;
 }
 
-static inline Hashtable* Platform_dynamicScreens(void) {
-   return NULL;
-}
+Hashtable* Platform_dynamicScreens(void);
 
 static inline void Platform_defaultDynamicScreens(ATTR_UNUSED Settings* settings) { }
 
-static inline void Platform_addDynamicScreen(ATTR_UNUSED ScreenSettings* ss) { }
+void Platform_addDynamicScreen(ScreenSettings* ss);
+
+void Platform_addDynamicScreenAvailableColumns(Panel* availableColumns, const char* screen);
 
-static inline void Platform_addDynamicScreenAvailableColumns(ATTR_UNUSED Panel* availableColumns, ATTR_UNUSED const char* screen) { }
+void Platform_dynamicScreensDone(Hashtable* screens);
 
-static inline void Platform_dynamicScreensDone(ATTR_UNUSED Hashtable* screens) { }
+/* Creates the tables of the dynamic screens, once the machine exists */
+void Platform_updateTables(Machine* host);
 
 #endif
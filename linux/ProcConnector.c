@@ -0,0 +1,157 @@
+/*
+htop - linux/ProcConnector.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/ProcConnector.h"
+
+#ifdef HAVE_PROC_CONNECTOR
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+
+
+#define PROCCONNECTOR_BUFSIZE 16384
+
+/* Socket buffer asked for, each event takes up about a kilobyte of it */
+#define PROCCONNECTOR_RCVBUF (4 * 1024 * 1024)
+
+static bool ProcConnector_setListen(int fd, bool listen) {
+   union {
+      struct nlmsghdr hdr;
+      char raw[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op))];
+   } buf;
+   memset(&buf, 0, sizeof(buf));
+
+   struct nlmsghdr* hdr = &buf.hdr;
+   hdr->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+   hdr->nlmsg_type = NLMSG_DONE;
+   hdr->nlmsg_pid = (__u32)getpid();
+
+   struct cn_msg* msg = NLMSG_DATA(hdr);
+   msg->id.idx = CN_IDX_PROC;
+   msg->id.val = CN_VAL_PROC;
+   msg->len = sizeof(enum proc_cn_mcast_op);
+
+   enum proc_cn_mcast_op op = listen ? PROC_CN_MCAST_LISTEN : PROC_CN_MCAST_IGNORE;
+   memcpy(msg->data, &op, sizeof(op));
+
+   return send(fd, hdr, hdr->nlmsg_len, 0) == (ssize_t)hdr->nlmsg_len;
+}
+
+int ProcConnector_open(void) {
+   int fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+   if (fd < 0)
+      return -1;
+
+   /* the events of a scan interval of a busy machine overflow the default buffer, subscribing needs CAP_NET_ADMIN anyway */
+   int size = PROCCONNECTOR_RCVBUF;
+   if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) < 0)
+      (void) setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+   struct sockaddr_nl addr = {
+      .nl_family = AF_NETLINK,
+      .nl_groups = CN_IDX_PROC,
+   };
+   if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0 || !ProcConnector_setListen(fd, true)) {
+      close(fd);
+      return -1;
+   }
+
+   return fd;
+}
+
+void ProcConnector_close(int fd) {
+   if (fd < 0)
+      return;
+
+   ProcConnector_setListen(fd, false);
+   close(fd);
+}
+
+static void ProcConnector_dispatch(const struct proc_event* ev, ProcConnector_EventHandler handler, void* context) {
+   ProcConnectorDetails details = { .timestampNs = ev->timestamp_ns };
+
+   switch (ev->what) {
+      case PROC_EVENT_FORK:
+         details.parentTgid = ev->event_data.fork.parent_tgid;
+         handler(context, PROCCONNECTOR_FORK, ev->event_data.fork.child_pid, ev->event_data.fork.child_tgid, &details);
+         break;
+      case PROC_EVENT_EXEC:
+         handler(context, PROCCONNECTOR_EXEC, ev->event_data.exec.process_pid, ev->event_data.exec.process_tgid, &details);
+         break;
+      case PROC_EVENT_COMM: {
+         /* terminated by the kernel, but do not rely on it */
+         const size_t len = strnlen(ev->event_data.comm.comm, sizeof(details.comm) - 1);
+         memcpy(details.comm, ev->event_data.comm.comm, len);
+         details.comm[len] = '\0';
+         handler(context, PROCCONNECTOR_COMM, ev->event_data.comm.process_pid, ev->event_data.comm.process_tgid, &details);
+         break;
+      }
+      case PROC_EVENT_EXIT:
+         handler(context, PROCCONNECTOR_EXIT, ev->event_data.exit.process_pid, ev->event_data.exit.process_tgid, &details);
+         break;
+      default:
+         break;
+   }
+}
+
+bool ProcConnector_drain(int fd, ProcConnector_EventHandler handler, void* context) {
+   union {
+      struct nlmsghdr hdr;
+      char raw[PROCCONNECTOR_BUFSIZE];
+   } buf;
+   bool complete = true;
+
+   for (;;) {
+      ssize_t r = recv(fd, &buf, sizeof(buf), 0);
+      if (r < 0) {
+         if (errno == EINTR)
+            continue;
+         if (errno == ENOBUFS) {
+            /* the socket buffer overflowed; what is queued now is still valid */
+            complete = false;
+            continue;
+         }
+         if (errno != EAGAIN && errno != EWOULDBLOCK)
+            complete = false;
+         break;
+      }
+      if (r == 0)
+         break;
+
+      size_t len = (size_t)r;
+      for (struct nlmsghdr* hdr = &buf.hdr; len >= sizeof(*hdr) && hdr->nlmsg_len >= sizeof(*hdr) && hdr->nlmsg_len <= len; ) {
+         if (hdr->nlmsg_type == NLMSG_ERROR || hdr->nlmsg_type == NLMSG_OVERRUN) {
+            complete = false;
+         } else if (hdr->nlmsg_type != NLMSG_NOOP && hdr->nlmsg_len >= NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(struct proc_event))) {
+            const struct cn_msg* msg = NLMSG_DATA(hdr);
+            if (msg->id.idx == CN_IDX_PROC && msg->id.val == CN_VAL_PROC) {
+               /* the event follows the 20 byte cn_msg, short of the alignment of its timestamp */
+               struct proc_event ev;
+               memcpy(&ev, msg->data, sizeof(ev));
+               ProcConnector_dispatch(&ev, handler, context);
+            }
+         }
+
+         size_t step = NLMSG_ALIGN(hdr->nlmsg_len);
+         if (step >= len)
+            break;
+         len -= step;
+         hdr = (struct nlmsghdr*)(void*)((char*)hdr + step);
+      }
+   }
+
+   return complete;
+}
+
+#endif /* HAVE_PROC_CONNECTOR */
@@ -0,0 +1,38 @@
+#ifndef HEADER_ProcConnector
+#define HEADER_ProcConnector
+/*
+htop - linux/ProcConnector.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+
+typedef enum ProcConnectorEvent_ {
+   PROCCONNECTOR_FORK,
+   PROCCONNECTOR_EXEC,
+   PROCCONNECTOR_COMM,
+   PROCCONNECTOR_EXIT,
+} ProcConnectorEvent;
+
+/* What an event tells besides the task it is about */
+typedef struct ProcConnectorDetails_ {
+   unsigned long long int timestampNs;  /* since boot */
+   pid_t parentTgid;                    /* PROCCONNECTOR_FORK only */
+   char comm[16];                       /* PROCCONNECTOR_COMM only */
+} ProcConnectorDetails;
+
+typedef void (*ProcConnector_EventHandler)(void* context, ProcConnectorEvent event, pid_t pid, pid_t tgid, const ProcConnectorDetails* details);
+
+/* Subscribes to the kernel's process events (needs CAP_NET_ADMIN); returns the socket or -1 */
+int ProcConnector_open(void);
+
+void ProcConnector_close(int fd);
+
+/* Hands all pending events to the handler; returns false if events got lost */
+bool ProcConnector_drain(int fd, ProcConnector_EventHandler handler, void* context);
+
+#endif
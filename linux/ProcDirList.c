@@ -0,0 +1,125 @@
+/*
+htop - linux/ProcDirList.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/ProcDirList.h"
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "XUtils.h"
+
+
+/* Largest PID the kernel hands out (PID_MAX_LIMIT) */
+#define PROCDIRLIST_MAX_PID (4 * 1024 * 1024)
+
+/* Layout of the records returned by getdents64(2) */
+struct ProcDirList_dirent64 {
+   uint64_t d_ino;
+   int64_t d_off;
+   unsigned short d_reclen;
+   unsigned char d_type;
+   char d_name[];
+};
+
+static ProcDirEntry* ProcDirList_append(ProcDirList* this) {
+   if (this->count == this->alloc) {
+      this->alloc = this->alloc ? this->alloc * 2 : 256;
+      this->entries = xReallocArray(this->entries, this->alloc, sizeof(ProcDirEntry));
+   }
+
+   return &this->entries[this->count++];
+}
+
+static void ProcDirList_add(ProcDirList* this, const char* name, unsigned char type) {
+   // Ignore all non-directories
+   if (type != DT_DIR && type != DT_UNKNOWN)
+      return;
+
+   // The RedHat kernel hides threads with a dot.
+   const char* digits = name[0] == '.' ? name + 1 : name;
+
+   uint32_t pid = 0;
+   const char* p = digits;
+   for (; *p >= '0' && *p <= '9'; p++) {
+      pid = pid * 10 + (uint32_t)(*p - '0');
+      if (pid > PROCDIRLIST_MAX_PID)
+         return;
+   }
+
+   // Just skip all non-number directories.
+   if (p == digits || *p != '\0' || pid == 0)
+      return;
+
+   if ((size_t)(p - name) >= sizeof(this->entries[0].name))
+      return;
+
+   ProcDirEntry* entry = ProcDirList_append(this);
+   entry->pid = (pid_t)pid;
+   memcpy(entry->name, name, (size_t)(p - name) + 1);
+}
+
+void ProcDirList_addPid(ProcDirList* this, pid_t pid) {
+   ProcDirEntry* entry = ProcDirList_append(this);
+   entry->pid = pid;
+   xSnprintf(entry->name, sizeof(entry->name), "%d", (int)pid);
+}
+
+bool ProcDirList_read(ProcDirList* this, int dirFd) {
+   this->count = 0;
+
+#ifdef SYS_getdents64
+   if (!this->buffer)
+      this->buffer = xMalloc(PROCDIRLIST_BUFSIZE);
+
+   for (;;) {
+      long r = syscall(SYS_getdents64, dirFd, this->buffer, PROCDIRLIST_BUFSIZE);
+      if (r < 0)
+         return false;
+      if (r == 0)
+         break;
+
+      for (long pos = 0; pos < r; ) {
+         const struct ProcDirList_dirent64* d = (const struct ProcDirList_dirent64*)(this->buffer + pos);
+         ProcDirList_add(this, d->d_name, d->d_type);
+         pos += d->d_reclen;
+      }
+   }
+#else
+   int fd = dup(dirFd);
+   if (fd < 0)
+      return false;
+
+   DIR* dir = fdopendir(fd);
+   if (!dir) {
+      close(fd);
+      return false;
+   }
+
+   const struct dirent* entry;
+   while ((entry = readdir(dir)) != NULL)
+      ProcDirList_add(this, entry->d_name, entry->d_type);
+
+   closedir(dir);
+#endif
+
+   return true;
+}
+
+void ProcDirList_done(ProcDirList* this) {
+   free(this->entries);
+   free(this->buffer);
+   this->entries = NULL;
+   this->buffer = NULL;
+   this->count = 0;
+   this->alloc = 0;
+}
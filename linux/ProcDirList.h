@@ -0,0 +1,40 @@
+#ifndef HEADER_ProcDirList
+#define HEADER_ProcDirList
+/*
+htop - linux/ProcDirList.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+
+/* Size of the buffer the raw directory entries are read into */
+#define PROCDIRLIST_BUFSIZE (64 * 1024)
+
+typedef struct ProcDirEntry_ {
+   pid_t pid;
+   char name[16];    /* directory entry name (may carry a leading '.') */
+} ProcDirEntry;
+
+/* Numeric entries of a /proc or /proc/<pid>/task directory, re-used across scans */
+typedef struct ProcDirList_ {
+   ProcDirEntry* entries;
+   size_t count;
+   size_t alloc;
+
+   char* buffer;
+} ProcDirList;
+
+/* Reads all numeric subdirectories of dirFd (from its current offset) */
+bool ProcDirList_read(ProcDirList* this, int dirFd);
+
+/* Appends an entry for pid without looking at the directory */
+void ProcDirList_addPid(ProcDirList* this, pid_t pid);
+
+void ProcDirList_done(ProcDirList* this);
+
+#endif
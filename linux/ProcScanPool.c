@@ -0,0 +1,584 @@
+/*
+htop - linux/ProcScanPool.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/ProcScanPool.h"
+
+#ifdef HAVE_PTHREAD
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "CRT.h"
+#include "Macros.h"
+#include "XUtils.h"
+#include "linux/LinuxProcessTable.h"
+#include "linux/Platform.h"
+#include "linux/ProcDirList.h"
+#include "linux/ProcUring.h"
+
+
+/* Text storage is handed out from fixed blocks so that pointers stay valid while a chunk is filled;
+ * a chunk of processes usually fits into one, which bounds what a scan read ahead keeps around */
+#define TEXT_BLOCK_SIZE (64 * 1024)
+
+#define CHUNK_FREE SIZE_MAX
+
+/* stat, statm, status, io and schedstat */
+#define PROCSCANPOOL_FILES_PER_PROCESS 5
+
+typedef struct TextBlock_ {
+   char* data;
+   size_t used;
+} TextBlock;
+
+struct ProcScanChunk_ {
+   size_t index;           /* chunk number held by this slot, CHUNK_FREE if unused */
+   bool ready;
+
+   ProcScanItem items[PROCSCANPOOL_CHUNK_SIZE];
+   size_t itemCount;
+
+   ProcScanItem* threads;
+   size_t threadCount;
+   size_t threadAlloc;
+
+   TextBlock* blocks;
+   size_t blockCount;
+   size_t currentBlock;
+
+   ProcDirList taskList;
+};
+
+struct ProcScanPool_ {
+   pthread_mutex_t lock;
+   pthread_cond_t cond;
+   bool quit;
+
+   pthread_t* workers;
+   unsigned int workerCount;
+
+   /* ring of chunk slots shared between the workers and the main thread */
+   ProcScanChunk* slots;
+   size_t slotCount;
+
+   /* the current scan */
+   int procDirFd;
+   const ProcScanTask* tasks;
+   size_t taskCount;
+   size_t chunkCount;
+   size_t nextChunk;
+   size_t filledChunks;
+   size_t releasedChunks;
+   ProcScanOptions options;
+
+   /* the jobs of ProcScanPool_run */
+   ProcScanJob job;
+   void* jobData;
+   size_t jobCount;
+   size_t nextJob;
+   size_t doneJobs;
+};
+
+static char* ProcScanChunk_reserveText(ProcScanChunk* this, size_t size) {
+   assert(size <= TEXT_BLOCK_SIZE);
+
+   while (this->currentBlock < this->blockCount) {
+      TextBlock* block = &this->blocks[this->currentBlock];
+      if (TEXT_BLOCK_SIZE - block->used >= size)
+         return block->data + block->used;
+
+      this->currentBlock++;
+   }
+
+   this->blocks = xReallocArray(this->blocks, this->blockCount + 1, sizeof(TextBlock));
+   this->blocks[this->blockCount].data = xMalloc(TEXT_BLOCK_SIZE);
+   this->blocks[this->blockCount].used = 0;
+   this->currentBlock = this->blockCount;
+   this->blockCount++;
+
+   return this->blocks[this->currentBlock].data;
+}
+
+static char* ProcScanChunk_readFile(ProcScanChunk* this, int dirFd, const char* path, size_t maxSize, int* error) {
+   char* buffer = ProcScanChunk_reserveText(this, maxSize);
+
+   ssize_t r = xReadfileat(dirFd, path, buffer, maxSize);
+   if (r < 0) {
+      if (error)
+         *error = (int)-r;
+      return NULL;
+   }
+
+   this->blocks[this->currentBlock].used += (size_t)r + 1;
+   return buffer;
+}
+
+/* One file of a process to read, and where its text goes */
+typedef struct ProcScanRead_ {
+   char path[48];
+   char** target;
+   int* error;            /* errno of a failed read goes here, unless NULL */
+   size_t size;
+} ProcScanRead;
+
+/* Lists the files to read for the process, returns their number */
+static size_t ProcScanChunk_listFiles(ProcScanItem* item, const ProcScanTask* task, const ProcScanOptions* options, ProcScanRead* reads) {
+   const char* prefix = task->name;
+   const pid_t mainThread = task->mainThread ? task->pid : 0;
+   size_t n = 0;
+
+   if (mainThread)
+      xSnprintf(reads[n].path, sizeof(reads[n].path), "%s/task/%d/stat", prefix, (int)mainThread);
+   else
+      xSnprintf(reads[n].path, sizeof(reads[n].path), "%s/stat", prefix);
+   reads[n].target = &item->stat;
+   reads[n].error = NULL;
+   reads[n++].size = PROC_PID_STAT_BUFSIZE;
+
+   xSnprintf(reads[n].path, sizeof(reads[n].path), "%s/statm", prefix);
+   reads[n].target = &item->statm;
+   reads[n].error = NULL;
+   reads[n++].size = PROC_PID_STATM_BUFSIZE;
+
+   xSnprintf(reads[n].path, sizeof(reads[n].path), "%s/status", prefix);
+   reads[n].target = &item->status;
+   reads[n].error = NULL;
+   reads[n++].size = PROC_PID_STATUS_BUFSIZE;
+
+   if (options->readIo && !task->skipIo) {
+      if (mainThread)
+         xSnprintf(reads[n].path, sizeof(reads[n].path), "%s/task/%d/io", prefix, (int)mainThread);
+      else
+         xSnprintf(reads[n].path, sizeof(reads[n].path), "%s/io", prefix);
+      reads[n].target = &item->io;
+      reads[n].error = &item->ioError;
+      reads[n++].size = PROC_PID_IO_BUFSIZE;
+   }
+
+   /* that of the process is the one of its main thread anyway */
+   if (options->readSchedstat) {
+      xSnprintf(reads[n].path, sizeof(reads[n].path), "%s/schedstat", prefix);
+      reads[n].target = &item->schedstat;
+      reads[n].error = NULL;
+      reads[n++].size = PROC_PID_SCHEDSTAT_BUFSIZE;
+   }
+
+   assert(n <= PROCSCANPOOL_FILES_PER_PROCESS);
+   return n;
+}
+
+static void ProcScanChunk_readFiles(ProcScanChunk* this, int dirFd, const ProcScanRead* reads, size_t count) {
+   for (size_t i = 0; i < count; i++)
+      *reads[i].target = ProcScanChunk_readFile(this, dirFd, reads[i].path, reads[i].size, reads[i].error);
+}
+
+#ifdef HAVE_IO_URING
+
+/* Room a file gets when read through io_uring; the status files longer than this are rare
+ * enough to be read again */
+#define PROCSCANPOOL_URING_READ_SIZE 4096
+
+/* Files read through the ring at once, as many as its buffer holds at that size */
+#define PROCSCANPOOL_URING_BATCH (PROCURING_BUFFER_SIZE / PROCSCANPOOL_URING_READ_SIZE)
+
+/* Reads the files through io_uring, returns false if the ring failed and nothing was read */
+static bool ProcScanChunk_readFilesBatched(ProcScanChunk* this, ProcUring* uring, int dirFd, const ProcScanRead* reads, size_t count) {
+   ProcUringRead batch[PROCURING_MAX_READS];
+
+   assert(count <= PROCSCANPOOL_URING_BATCH && count <= PROCURING_MAX_READS);
+
+   for (size_t i = 0; i < count; i++) {
+      batch[i].path = reads[i].path;
+      batch[i].size = MINIMUM(reads[i].size, (size_t)PROCSCANPOOL_URING_READ_SIZE);
+   }
+
+   if (!ProcUring_read(uring, dirFd, batch, count))
+      return false;
+
+   for (size_t i = 0; i < count; i++) {
+      const ProcUringRead* read = &batch[i];
+
+      if (read->data && ((size_t)read->result + 1 < read->size || read->size == reads[i].size)) {
+         char* text = ProcScanChunk_reserveText(this, (size_t)read->result + 1);
+         memcpy(text, read->data, (size_t)read->result + 1);
+         this->blocks[this->currentBlock].used += (size_t)read->result + 1;
+         *reads[i].target = text;
+      } else if (read->data || (read->result != -ENOENT && read->result != -ESRCH)) {
+         /* cut short, or failing for other reasons than the process being gone */
+         *reads[i].target = ProcScanChunk_readFile(this, dirFd, reads[i].path, reads[i].size, reads[i].error);
+      } else {
+         *reads[i].target = NULL;
+      }
+   }
+
+   return true;
+}
+
+#endif /* HAVE_IO_URING */
+
+static ProcScanItem* ProcScanChunk_addThread(ProcScanChunk* this) {
+   if (this->threadCount == this->threadAlloc) {
+      this->threadAlloc = this->threadAlloc ? this->threadAlloc * 2 : 256;
+      this->threads = xReallocArray(this->threads, this->threadAlloc, sizeof(ProcScanItem));
+   }
+
+   ProcScanItem* item = &this->threads[this->threadCount++];
+   memset(item, 0, sizeof(ProcScanItem));
+   return item;
+}
+
+static void ProcScanChunk_readThreads(ProcScanChunk* this, ProcScanItem* item, int dirFd, bool readSchedstat) {
+   char path[64];
+   xSnprintf(path, sizeof(path), "%s/task", item->name);
+
+   int taskFd = openat(dirFd, path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+   if (taskFd < 0)
+      return;
+
+   bool ok = ProcDirList_read(&this->taskList, taskFd);
+   close(taskFd);
+   if (!ok)
+      return;
+
+   for (size_t i = 0; i < this->taskList.count; i++) {
+      const ProcDirEntry* entry = &this->taskList.entries[i];
+
+      // The main thread is covered by the process itself
+      if (entry->pid == item->pid)
+         continue;
+
+      ProcScanItem* thread = ProcScanChunk_addThread(this);
+      thread->pid = entry->pid;
+      memcpy(thread->name, entry->name, sizeof(thread->name));
+      thread->prefetched = true;
+
+      /* everything else of a thread is taken over from its process */
+      xSnprintf(path, sizeof(path), "%s/task/%s/stat", item->name, thread->name);
+      thread->stat = ProcScanChunk_readFile(this, dirFd, path, PROC_PID_STAT_BUFSIZE, NULL);
+
+      if (readSchedstat) {
+         xSnprintf(path, sizeof(path), "%s/task/%s/schedstat", item->name, thread->name);
+         thread->schedstat = ProcScanChunk_readFile(this, dirFd, path, PROC_PID_SCHEDSTAT_BUFSIZE, NULL);
+      }
+      thread->readNs = LinuxProcessTable_monotonicNs();
+
+      item->threadCount++;
+   }
+}
+
+static void ProcScanChunk_fill(ProcScanChunk* this, const ProcScanTask* tasks, size_t count, int dirFd, const ProcScanOptions* options, ProcUring* uring) {
+   assert(count <= PROCSCANPOOL_CHUNK_SIZE);
+
+   for (size_t i = 0; i < this->blockCount; i++)
+      this->blocks[i].used = 0;
+   this->currentBlock = 0;
+   this->threadCount = 0;
+   this->itemCount = count;
+
+   ProcScanRead reads[PROCSCANPOOL_CHUNK_SIZE * PROCSCANPOOL_FILES_PER_PROCESS];
+   size_t readCount = 0;
+
+   for (size_t i = 0; i < count; i++) {
+      const ProcScanTask* task = &tasks[i];
+      ProcScanItem* item = &this->items[i];
+
+      memset(item, 0, sizeof(ProcScanItem));
+      item->pid = task->pid;
+      memcpy(item->name, task->name, sizeof(item->name));
+      item->prefetched = task->readFiles;
+
+      if (task->readFiles)
+         readCount += ProcScanChunk_listFiles(item, task, options, &reads[readCount]);
+   }
+
+   /* the files of a chunk take several batches, the rest is read one by one if the ring fails */
+   size_t batched = 0;
+#ifdef HAVE_IO_URING
+   while (uring && batched < readCount) {
+      size_t batch = MINIMUM(readCount - batched, (size_t)PROCSCANPOOL_URING_BATCH);
+      if (!ProcScanChunk_readFilesBatched(this, uring, dirFd, &reads[batched], batch))
+         break;
+      batched += batch;
+   }
+#else
+   (void)uring;
+#endif
+   ProcScanChunk_readFiles(this, dirFd, &reads[batched], readCount - batched);
+
+   const uint64_t readNs = LinuxProcessTable_monotonicNs();
+   for (size_t i = 0; i < count; i++)
+      this->items[i].readNs = readNs;
+
+   if (options->readThreads) {
+      for (size_t i = 0; i < count; i++)
+         ProcScanChunk_readThreads(this, &this->items[i], dirFd, options->readSchedstat);
+   }
+
+   /* the thread array is final now, so its entries can be handed out */
+   size_t first = 0;
+   for (size_t i = 0; i < count; i++) {
+      ProcScanItem* item = &this->items[i];
+      item->threads = item->threadCount ? &this->threads[first] : NULL;
+      first += item->threadCount;
+   }
+   assert(first == this->threadCount);
+}
+
+/* Runs the next job, called and returning with the lock held */
+static void ProcScanPool_runJob(ProcScanPool* this) {
+   const size_t idx = this->nextJob++;
+   ProcScanJob job = this->job;
+   void* data = this->jobData;
+
+   pthread_mutex_unlock(&this->lock);
+   job(data, idx);
+   pthread_mutex_lock(&this->lock);
+
+   if (++this->doneJobs == this->jobCount)
+      pthread_cond_broadcast(&this->cond);
+}
+
+static void* ProcScanPool_worker(void* arg) {
+   ProcScanPool* this = arg;
+
+   if (Platform_lowImpact)
+      Platform_lowerThreadPriority();
+
+   /* each worker has a ring of its own; NULL where io_uring is not available */
+   ProcUring* uring = ProcUring_new();
+
+   pthread_mutex_lock(&this->lock);
+   for (;;) {
+      while (!this->quit && this->nextJob >= this->jobCount &&
+         (this->nextChunk >= this->chunkCount || this->slots[this->nextChunk % this->slotCount].index != CHUNK_FREE)) {
+         pthread_cond_wait(&this->cond, &this->lock);
+      }
+
+      if (this->quit)
+         break;
+
+      if (this->nextJob < this->jobCount) {
+         ProcScanPool_runJob(this);
+         continue;
+      }
+
+      size_t idx = this->nextChunk++;
+      ProcScanChunk* slot = &this->slots[idx % this->slotCount];
+      slot->index = idx;
+      slot->ready = false;
+
+      size_t start = idx * PROCSCANPOOL_CHUNK_SIZE;
+      size_t count = MINIMUM(this->taskCount - start, (size_t)PROCSCANPOOL_CHUNK_SIZE);
+      const ProcScanTask* tasks = this->tasks + start;
+      int dirFd = this->procDirFd;
+      ProcScanOptions options = this->options;
+
+      pthread_mutex_unlock(&this->lock);
+
+      ProcScanChunk_fill(slot, tasks, count, dirFd, &options, uring);
+
+      pthread_mutex_lock(&this->lock);
+      slot->ready = true;
+      this->filledChunks++;
+      pthread_cond_broadcast(&this->cond);
+
+      if (this->options.wakeWhenFilled &&
+          (this->filledChunks == this->chunkCount || this->filledChunks - this->releasedChunks == this->slotCount))
+         CRT_wake();
+   }
+   pthread_mutex_unlock(&this->lock);
+
+   ProcUring_delete(uring);
+   return NULL;
+}
+
+ProcScanPool* ProcScanPool_new(unsigned int workerCount) {
+   workerCount = CLAMP(workerCount, 1, PROCSCANPOOL_MAX_WORKERS);
+
+   ProcScanPool* this = xCalloc(1, sizeof(ProcScanPool));
+   pthread_mutex_init(&this->lock, NULL);
+   pthread_cond_init(&this->cond, NULL);
+
+   /* two slots per worker let the workers run ahead while the main thread merges */
+   this->slotCount = 2 * (size_t)workerCount;
+   this->slots = xCalloc(this->slotCount, sizeof(ProcScanChunk));
+   for (size_t i = 0; i < this->slotCount; i++)
+      this->slots[i].index = CHUNK_FREE;
+
+   this->workers = xCalloc(workerCount, sizeof(pthread_t));
+
+   /* signals are to be handled by the main thread only */
+   sigset_t all, old;
+   sigfillset(&all);
+   pthread_sigmask(SIG_BLOCK, &all, &old);
+
+   for (unsigned int i = 0; i < workerCount; i++) {
+      if (pthread_create(&this->workers[this->workerCount], NULL, ProcScanPool_worker, this) != 0)
+         break;
+
+      this->workerCount++;
+   }
+
+   pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+   if (this->workerCount == 0) {
+      ProcScanPool_delete(this);
+      return NULL;
+   }
+
+   return this;
+}
+
+void ProcScanPool_delete(ProcScanPool* this) {
+   if (!this)
+      return;
+
+   pthread_mutex_lock(&this->lock);
+   this->quit = true;
+   pthread_cond_broadcast(&this->cond);
+   pthread_mutex_unlock(&this->lock);
+
+   for (unsigned int i = 0; i < this->workerCount; i++)
+      pthread_join(this->workers[i], NULL);
+
+   for (size_t i = 0; i < this->slotCount; i++) {
+      ProcScanChunk* chunk = &this->slots[i];
+      for (size_t j = 0; j < chunk->blockCount; j++)
+         free(chunk->blocks[j].data);
+      free(chunk->blocks);
+      free(chunk->threads);
+      ProcDirList_done(&chunk->taskList);
+   }
+
+   pthread_cond_destroy(&this->cond);
+   pthread_mutex_destroy(&this->lock);
+   free(this->slots);
+   free(this->workers);
+   free(this);
+}
+
+unsigned int ProcScanPool_workerCount(const ProcScanPool* this) {
+   return this->workerCount;
+}
+
+void ProcScanPool_begin(ProcScanPool* this, int procDirFd, const ProcScanTask* tasks, size_t taskCount, ProcScanOptions options) {
+   pthread_mutex_lock(&this->lock);
+
+   /* the previous scan must have been consumed completely */
+   assert(this->nextChunk == this->chunkCount);
+
+   this->procDirFd = procDirFd;
+   this->tasks = tasks;
+   this->taskCount = taskCount;
+   this->chunkCount = (taskCount + PROCSCANPOOL_CHUNK_SIZE - 1) / PROCSCANPOOL_CHUNK_SIZE;
+   this->nextChunk = 0;
+   this->filledChunks = 0;
+   this->releasedChunks = 0;
+   this->options = options;
+
+   pthread_cond_broadcast(&this->cond);
+   pthread_mutex_unlock(&this->lock);
+}
+
+void ProcScanPool_reserve(ProcScanPool* this, size_t taskCount) {
+   size_t chunks = (taskCount + PROCSCANPOOL_CHUNK_SIZE - 1) / PROCSCANPOOL_CHUNK_SIZE;
+   chunks = MINIMUM(chunks, (size_t)PROCSCANPOOL_MAX_AHEAD_CHUNKS);
+
+   pthread_mutex_lock(&this->lock);
+
+   /* the workers only touch the slots while a scan is running */
+   assert(this->releasedChunks == this->chunkCount);
+
+   if (chunks > this->slotCount) {
+      this->slots = xReallocArray(this->slots, chunks, sizeof(ProcScanChunk));
+      memset(&this->slots[this->slotCount], 0, (chunks - this->slotCount) * sizeof(ProcScanChunk));
+      for (size_t i = this->slotCount; i < chunks; i++)
+         this->slots[i].index = CHUNK_FREE;
+      this->slotCount = chunks;
+   }
+
+   pthread_mutex_unlock(&this->lock);
+}
+
+bool ProcScanPool_isFilled(ProcScanPool* this) {
+   pthread_mutex_lock(&this->lock);
+   bool filled = this->filledChunks == this->chunkCount || this->filledChunks - this->releasedChunks == this->slotCount;
+   pthread_mutex_unlock(&this->lock);
+
+   return filled;
+}
+
+size_t ProcScanPool_chunkCount(const ProcScanPool* this) {
+   return this->chunkCount;
+}
+
+const ProcScanChunk* ProcScanPool_waitChunk(ProcScanPool* this, size_t idx) {
+   assert(idx < this->chunkCount);
+
+   ProcScanChunk* slot = &this->slots[idx % this->slotCount];
+
+   pthread_mutex_lock(&this->lock);
+   while (slot->index != idx || !slot->ready)
+      pthread_cond_wait(&this->cond, &this->lock);
+   pthread_mutex_unlock(&this->lock);
+
+   return slot;
+}
+
+void ProcScanPool_releaseChunk(ProcScanPool* this, const ProcScanChunk* chunk) {
+   ProcScanChunk* slot = &this->slots[chunk->index % this->slotCount];
+   assert(slot == chunk);
+
+   pthread_mutex_lock(&this->lock);
+   slot->index = CHUNK_FREE;
+   slot->ready = false;
+   this->releasedChunks++;
+   pthread_cond_broadcast(&this->cond);
+   pthread_mutex_unlock(&this->lock);
+}
+
+void ProcScanPool_run(ProcScanPool* this, ProcScanJob job, void* data, size_t count) {
+   pthread_mutex_lock(&this->lock);
+
+   /* one call at a time, from the main thread */
+   assert(this->doneJobs == this->jobCount);
+
+   this->job = job;
+   this->jobData = data;
+   this->jobCount = count;
+   this->nextJob = 0;
+   this->doneJobs = 0;
+   pthread_cond_broadcast(&this->cond);
+
+   while (this->nextJob < this->jobCount)
+      ProcScanPool_runJob(this);
+
+   while (this->doneJobs < this->jobCount)
+      pthread_cond_wait(&this->cond, &this->lock);
+
+   pthread_mutex_unlock(&this->lock);
+}
+
+size_t ProcScanChunk_size(const ProcScanChunk* this) {
+   return this->itemCount;
+}
+
+const ProcScanItem* ProcScanChunk_get(const ProcScanChunk* this, size_t idx) {
+   assert(idx < this->itemCount);
+   return &this->items[idx];
+}
+
+#endif /* HAVE_PTHREAD */
@@ -0,0 +1,101 @@
+#ifndef HEADER_ProcScanPool
+#define HEADER_ProcScanPool
+/*
+htop - linux/ProcScanPool.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+
+/* Minimum number of /proc entries before the worker pool is used at all;
+ * below this the thread synchronization costs more than it saves. */
+#define PROCSCANPOOL_MIN_TASKS 256
+
+/* Number of processes handed to a worker at once */
+#define PROCSCANPOOL_CHUNK_SIZE 32
+
+#define PROCSCANPOOL_MAX_WORKERS 64
+
+/* Upper bound of chunks a scan keeps filled without the main thread consuming them */
+#define PROCSCANPOOL_MAX_AHEAD_CHUNKS 256
+
+/* What the main thread wants prefetched for one /proc/<pid> entry */
+typedef struct ProcScanTask_ {
+   pid_t pid;
+   char name[16];         /* directory entry name (may carry a leading '.') */
+   bool readFiles;        /* false if the process will be short-circuited */
+   bool mainThread;       /* read task/<pid>/{stat,io} instead of {stat,io} */
+   bool skipIo;           /* reading io was refused the last time */
+} ProcScanTask;
+
+/* Prefetched file contents of one process or thread;
+ * pointers are NULL if reading the file failed */
+typedef struct ProcScanItem_ {
+   pid_t pid;
+   char name[16];
+   bool prefetched;       /* false if the files below were not read at all; threads only get stat */
+   char* stat;
+   char* statm;
+   char* status;
+   char* io;
+   int ioError;           /* errno of the failed read of io, 0 otherwise */
+   char* schedstat;
+   uint64_t readNs;       /* monotonic time the files were read at, in nanoseconds */
+
+   /* Threads found in task/ (excluding the main thread), processes only */
+   size_t threadCount;
+   const struct ProcScanItem_* threads;
+} ProcScanItem;
+
+typedef struct ProcScanChunk_ ProcScanChunk;
+
+typedef struct ProcScanPool_ ProcScanPool;
+
+typedef struct ProcScanOptions_ {
+   bool readIo;           /* also read the io files of processes */
+   bool readThreads;      /* list threads and read their stat files */
+   bool readSchedstat;    /* also read the schedstat files of processes and threads */
+   bool wakeWhenFilled;   /* CRT_wake() once filled, for scans read ahead of the main thread */
+} ProcScanOptions;
+
+ProcScanPool* ProcScanPool_new(unsigned int workerCount);
+
+void ProcScanPool_delete(ProcScanPool* this);
+
+unsigned int ProcScanPool_workerCount(const ProcScanPool* this);
+
+/* Hands the tasks to the workers; the array must stay valid until all chunks have been released */
+void ProcScanPool_begin(ProcScanPool* this, int procDirFd, const ProcScanTask* tasks, size_t taskCount, ProcScanOptions options);
+
+/* Lets the workers fill the chunks of up to taskCount tasks ahead; only between scans */
+void ProcScanPool_reserve(ProcScanPool* this, size_t taskCount);
+
+/* Whether the workers cannot get further without chunks being released */
+bool ProcScanPool_isFilled(ProcScanPool* this);
+
+size_t ProcScanPool_chunkCount(const ProcScanPool* this);
+
+/* Blocks until chunk number idx has been filled; chunks must be waited for in order */
+const ProcScanChunk* ProcScanPool_waitChunk(ProcScanPool* this, size_t idx);
+
+void ProcScanPool_releaseChunk(ProcScanPool* this, const ProcScanChunk* chunk);
+
+/* A job run by ProcScanPool_run, index counting the jobs of one call */
+typedef void (*ProcScanJob)(void* data, size_t index);
+
+/* Runs job(data, 0) to job(data, count - 1) on the workers and the calling
+ * thread, returning once all are done; workers take them before any chunk of
+ * a scan read ahead */
+void ProcScanPool_run(ProcScanPool* this, ProcScanJob job, void* data, size_t count);
+
+size_t ProcScanChunk_size(const ProcScanChunk* this);
+
+const ProcScanItem* ProcScanChunk_get(const ProcScanChunk* this, size_t idx);
+
+#endif
@@ -0,0 +1,292 @@
+/*
+htop - linux/ProcUring.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/ProcUring.h"
+
+#include "Macros.h"
+
+#ifdef HAVE_IO_URING
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#include "XUtils.h"
+
+
+/* Three submissions per read, with room to spare */
+#define PROCURING_ENTRIES 512
+
+/* What a completion is for, in the low bits of its user_data */
+enum {
+   PROCURING_OPEN,
+   PROCURING_READ,
+   PROCURING_CLOSE,
+};
+
+#define PROCURING_USER_DATA(read_, op_) (((uint64_t)(read_) << 2) | (op_))
+
+struct ProcUring_ {
+   int fd;
+   bool broken;
+
+   void* sqRing;
+   size_t sqRingSize;
+   void* cqRing;                       /* sqRing itself with IORING_FEAT_SINGLE_MMAP */
+   size_t cqRingSize;
+   struct io_uring_sqe* sqes;
+   size_t sqesSize;
+
+   unsigned int* sqTail;
+   unsigned int sqMask;
+   unsigned int* sqArray;
+   unsigned int* cqHead;
+   const unsigned int* cqTail;
+   unsigned int cqMask;
+   const struct io_uring_cqe* cqes;
+
+   char* buffer;                       /* registered, read into with IORING_OP_READ_FIXED */
+};
+
+/* Set once io_uring turned out not to be usable, so that other threads do not try again */
+static bool ProcUring_disabled;
+
+static void ProcUring_disable(void) {
+   __atomic_store_n(&ProcUring_disabled, true, __ATOMIC_RELAXED);
+}
+
+static void* ProcUring_map(int fd, size_t size, off_t offset) {
+   void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+   return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+void ProcUring_delete(ProcUring* this) {
+   if (!this)
+      return;
+
+   if (this->fd >= 0)
+      close(this->fd);
+   if (this->sqes)
+      munmap(this->sqes, this->sqesSize);
+   if (this->cqRing && this->cqRing != this->sqRing)
+      munmap(this->cqRing, this->cqRingSize);
+   if (this->sqRing)
+      munmap(this->sqRing, this->sqRingSize);
+   if (this->buffer)
+      munmap(this->buffer, PROCURING_BUFFER_SIZE);
+   free(this);
+}
+
+/* Registers a table of empty slots for the files opened, and the buffer read into */
+static bool ProcUring_register(ProcUring* this) {
+   int slots[PROCURING_MAX_READS];
+   for (size_t i = 0; i < PROCURING_MAX_READS; i++)
+      slots[i] = -1;
+
+   if (syscall(SYS_io_uring_register, this->fd, IORING_REGISTER_FILES, slots, PROCURING_MAX_READS) < 0)
+      return false;
+
+   void* buffer = mmap(NULL, PROCURING_BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (buffer == MAP_FAILED)
+      return false;
+   this->buffer = buffer;
+
+   struct iovec iov = { .iov_base = this->buffer, .iov_len = PROCURING_BUFFER_SIZE };
+   return syscall(SYS_io_uring_register, this->fd, IORING_REGISTER_BUFFERS, &iov, 1) == 0;
+}
+
+ProcUring* ProcUring_new(void) {
+   if (__atomic_load_n(&ProcUring_disabled, __ATOMIC_RELAXED))
+      return NULL;
+
+   struct io_uring_params params;
+   memset(&params, 0, sizeof(params));
+
+   int fd = (int)syscall(SYS_io_uring_setup, PROCURING_ENTRIES, &params);
+   if (fd < 0) {
+      /* ENOSYS, or EPERM through kernel.io_uring_disabled or a seccomp filter */
+      ProcUring_disable();
+      return NULL;
+   }
+
+   ProcUring* this = xCalloc(1, sizeof(ProcUring));
+   this->fd = fd;
+
+   this->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+   this->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+   if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      this->sqRingSize = this->cqRingSize = MAXIMUM(this->sqRingSize, this->cqRingSize);
+   }
+
+   this->sqRing = ProcUring_map(fd, this->sqRingSize, IORING_OFF_SQ_RING);
+   if (!this->sqRing)
+      goto fail;
+
+   if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      this->cqRing = this->sqRing;
+   } else {
+      this->cqRing = ProcUring_map(fd, this->cqRingSize, IORING_OFF_CQ_RING);
+      if (!this->cqRing)
+         goto fail;
+   }
+
+   this->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+   this->sqes = ProcUring_map(fd, this->sqesSize, IORING_OFF_SQES);
+   if (!this->sqes)
+      goto fail;
+
+   char* sq = this->sqRing;
+   char* cq = this->cqRing;
+   this->sqTail = (unsigned int*)(sq + params.sq_off.tail);
+   this->sqMask = *(unsigned int*)(sq + params.sq_off.ring_mask);
+   this->sqArray = (unsigned int*)(sq + params.sq_off.array);
+   this->cqHead = (unsigned int*)(cq + params.cq_off.head);
+   this->cqTail = (const unsigned int*)(cq + params.cq_off.tail);
+   this->cqMask = *(unsigned int*)(cq + params.cq_off.ring_mask);
+   this->cqes = (const struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+   if (!ProcUring_register(this))
+      goto fail;
+
+   return this;
+
+fail:
+   ProcUring_disable();
+   ProcUring_delete(this);
+   return NULL;
+}
+
+static struct io_uring_sqe* ProcUring_nextSqe(ProcUring* this, unsigned int* tail, uint8_t opcode, uint64_t userData) {
+   const unsigned int idx = *tail & this->sqMask;
+   struct io_uring_sqe* sqe = &this->sqes[idx];
+   memset(sqe, 0, sizeof(*sqe));
+   sqe->opcode = opcode;
+   sqe->user_data = userData;
+   this->sqArray[idx] = idx;
+   (*tail)++;
+   return sqe;
+}
+
+static void ProcUring_complete(ProcUring* this, ProcUringRead* reads, const struct io_uring_cqe* cqe) {
+   ProcUringRead* read = &reads[cqe->user_data >> 2];
+
+   switch (cqe->user_data & 3) {
+      case PROCURING_OPEN:
+         if (cqe->res >= 0)
+            break;
+
+         /* opening into a file slot needs Linux 5.15 */
+         if (cqe->res == -EINVAL) {
+            this->broken = true;
+            ProcUring_disable();
+         }
+         read->result = cqe->res;
+         read->data = NULL;
+         break;
+      case PROCURING_READ:
+         if (!read->data)
+            break;
+
+         /* before Linux 5.18 the file of a linked read was looked up before its open ran */
+         if (cqe->res == -EBADF) {
+            this->broken = true;
+            ProcUring_disable();
+         }
+         read->result = cqe->res;
+         if (cqe->res >= 0)
+            read->data[cqe->res] = '\0';
+         else
+            read->data = NULL;
+         break;
+      default:
+         break;
+   }
+}
+
+bool ProcUring_read(ProcUring* this, int dirFd, ProcUringRead* reads, size_t count) {
+   assert(count <= PROCURING_MAX_READS);
+
+   if (this->broken)
+      return false;
+
+   /* each file is opened into slot i, read and closed, the links holding even if a step fails */
+   unsigned int tail = *this->sqTail;
+   size_t offset = 0;
+   for (size_t i = 0; i < count; i++) {
+      ProcUringRead* read = &reads[i];
+      assert(read->size > 0 && offset + read->size <= PROCURING_BUFFER_SIZE);
+
+      read->data = this->buffer + offset;
+      read->result = -ECANCELED;
+      offset += read->size;
+
+      struct io_uring_sqe* sqe = ProcUring_nextSqe(this, &tail, IORING_OP_OPENAT, PROCURING_USER_DATA(i, PROCURING_OPEN));
+      sqe->fd = dirFd;
+      sqe->addr = (uint64_t)(uintptr_t)read->path;
+      sqe->open_flags = O_RDONLY;
+      sqe->file_index = (uint32_t)i + 1;
+      sqe->flags = IOSQE_IO_HARDLINK;
+
+      sqe = ProcUring_nextSqe(this, &tail, IORING_OP_READ_FIXED, PROCURING_USER_DATA(i, PROCURING_READ));
+      sqe->fd = (int)i;
+      sqe->addr = (uint64_t)(uintptr_t)read->data;
+      sqe->len = (uint32_t)(read->size - 1);
+      sqe->buf_index = 0;
+      sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+
+      sqe = ProcUring_nextSqe(this, &tail, IORING_OP_CLOSE, PROCURING_USER_DATA(i, PROCURING_CLOSE));
+      sqe->file_index = (uint32_t)i + 1;
+   }
+   __atomic_store_n(this->sqTail, tail, __ATOMIC_RELEASE);
+
+   unsigned int unsubmitted = (unsigned int)count * 3;
+   unsigned int pending = unsubmitted;
+   while (pending > 0) {
+      long submitted = syscall(SYS_io_uring_enter, this->fd, unsubmitted, pending, IORING_ENTER_GETEVENTS, NULL, 0);
+      if (submitted < 0) {
+         if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+            continue;
+
+         this->broken = true;
+         return false;
+      }
+      unsubmitted -= (unsigned int)submitted;
+
+      unsigned int head = *this->cqHead;
+      const unsigned int cqTail = __atomic_load_n(this->cqTail, __ATOMIC_ACQUIRE);
+      for (; head != cqTail; head++, pending--)
+         ProcUring_complete(this, reads, &this->cqes[head & this->cqMask]);
+      __atomic_store_n(this->cqHead, head, __ATOMIC_RELEASE);
+   }
+
+   return !this->broken;
+}
+
+#else /* HAVE_IO_URING */
+
+ProcUring* ProcUring_new(void) {
+   return NULL;
+}
+
+void ProcUring_delete(ATTR_UNUSED ProcUring* this) {
+}
+
+bool ProcUring_read(ATTR_UNUSED ProcUring* this, ATTR_UNUSED int dirFd, ATTR_UNUSED ProcUringRead* reads, ATTR_UNUSED size_t count) {
+   return false;
+}
+
+#endif /* HAVE_IO_URING */
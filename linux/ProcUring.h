@@ -0,0 +1,47 @@
+#ifndef HEADER_ProcUring
+#define HEADER_ProcUring
+/*
+htop - linux/ProcUring.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+
+/* Files read in one submission at most, each an open, a read and a close linked together */
+#define PROCURING_MAX_READS 128
+
+/* Room of the registered buffer the reads of one submission share */
+#define PROCURING_BUFFER_SIZE (256 * 1024)
+
+/* One file to read, relative to the directory given to ProcUring_read() */
+typedef struct ProcUringRead_ {
+   const char* path;
+   size_t size;          /* room for the text and its terminating NUL */
+   char* data;           /* the text, valid until the next ProcUring_read(); NULL if not read */
+   ssize_t result;       /* length of the text, or -errno */
+} ProcUringRead;
+
+/*
+ * An io_uring(7) instance reading small /proc files in batches, for one
+ * thread. Saves the syscalls of opening, reading and closing each file.
+ */
+typedef struct ProcUring_ ProcUring;
+
+/* NULL if io_uring cannot be used: kernel too old, kernel.io_uring_disabled, or a seccomp filter */
+ProcUring* ProcUring_new(void);
+
+void ProcUring_delete(ProcUring* this);
+
+/*
+ * Reads the files, at most PROCURING_MAX_READS with sizes adding up to at
+ * most PROCURING_BUFFER_SIZE. Returns false if the ring failed as a whole;
+ * it is then of no further use and the files are to be read the usual way.
+ */
+bool ProcUring_read(ProcUring* this, int dirFd, ProcUringRead* reads, size_t count);
+
+#endif
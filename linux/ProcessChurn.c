@@ -0,0 +1,206 @@
+/*
+htop - linux/ProcessChurn.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/ProcessChurn.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Macros.h"
+#include "Process.h"
+#include "Row.h"
+#include "Vector.h"
+#include "XUtils.h"
+
+
+/* Execs of one interval named from the scan at most, the others are only counted */
+#define CHURN_PENDING_MAX 1024
+
+typedef struct ProcessChurn_ {
+   ChurnRates rates;
+   uint64_t sinceMs;
+   uint64_t lastMs;
+   size_t processes;               /* seen by the last scan */
+
+   /* since the last update */
+   unsigned int eventForks;
+   unsigned int eventExecs;
+   unsigned int eventExits;
+   bool eventsRead;
+   bool eventsComplete;
+   pid_t pending[CHURN_PENDING_MAX];
+   size_t pendingCount;
+
+   ChurnExec* ring;
+   size_t ringStart;
+   size_t ringCount;
+} ProcessChurn;
+
+static ProcessChurn ProcessChurn_state;
+
+void ProcessChurn_event(ProcConnectorEvent event, pid_t pid, pid_t tgid) {
+   ProcessChurn* this = &ProcessChurn_state;
+
+   switch (event) {
+      case PROCCONNECTOR_FORK:
+         /* new threads are forks sharing the thread group */
+         if (pid == tgid)
+            this->eventForks++;
+         break;
+      case PROCCONNECTOR_EXEC:
+         this->eventExecs++;
+         if (this->pendingCount < CHURN_PENDING_MAX)
+            this->pending[this->pendingCount++] = tgid;
+         break;
+      case PROCCONNECTOR_COMM:
+         break;
+      case PROCCONNECTOR_EXIT:
+         if (pid == tgid)
+            this->eventExits++;
+         break;
+   }
+}
+
+void ProcessChurn_eventsRead(bool complete) {
+   ProcessChurn* this = &ProcessChurn_state;
+
+   this->eventsComplete = this->eventsRead ? this->eventsComplete && complete : complete;
+   this->eventsRead = true;
+}
+
+static void ProcessChurn_copyComm(char* dest, size_t size, const Process* proc) {
+   const char* comm = proc && proc->procComm ? proc->procComm : "?";
+   size_t len = strnlen(comm, size - 1);
+   memcpy(dest, comm, len);
+   dest[len] = '\0';
+}
+
+static void ProcessChurn_record(ProcessChurn* this, const Table* table, const Process* proc, uint64_t monotonicMs) {
+   if (!this->ring)
+      this->ring = xCalloc(CHURN_RING_SIZE, sizeof(ChurnExec));
+
+   ChurnExec* exec;
+   if (this->ringCount < CHURN_RING_SIZE) {
+      exec = &this->ring[(this->ringStart + this->ringCount++) % CHURN_RING_SIZE];
+   } else {
+      exec = &this->ring[this->ringStart];
+      this->ringStart = (this->ringStart + 1) % CHURN_RING_SIZE;
+   }
+
+   const Process* parent = proc ? (const Process*) Table_findRow(table, Process_getParent(proc)) : NULL;
+
+   exec->ms = monotonicMs;
+   exec->ppid = proc ? Process_getParent(proc) : 0;
+   ProcessChurn_copyComm(exec->comm, sizeof(exec->comm), proc);
+   if (proc) {
+      ProcessChurn_copyComm(exec->parentComm, sizeof(exec->parentComm), parent);
+   } else {
+      exec->parentComm[0] = '\0';
+   }
+}
+
+/* Drops the execs that went out of the window */
+static void ProcessChurn_expire(ProcessChurn* this, uint64_t monotonicMs) {
+   while (this->ringCount > 0 && monotonicMs - this->ring[this->ringStart].ms > CHURN_WINDOW_MS) {
+      this->ringStart = (this->ringStart + 1) % CHURN_RING_SIZE;
+      this->ringCount--;
+   }
+}
+
+void ProcessChurn_update(const Table* processTable, uint64_t monotonicMs) {
+   ProcessChurn* this = &ProcessChurn_state;
+   const bool first = this->sinceMs == 0;
+   const bool fromEvents = this->eventsRead && this->eventsComplete && !first;
+
+   /* the processes new since the last scan, of which those named unlike their parent exec'd */
+   size_t processes = 0;
+   unsigned int forks = 0;
+   unsigned int execs = 0;
+   for (int i = 0; i < Vector_size(processTable->rows); i++) {
+      const Row* row = (const Row*) Vector_get(processTable->rows, i);
+      const Process* proc = (const Process*) row;
+      if (!Table_isUpdated(processTable, row) || Process_getPid(proc) != Process_getThreadGroup(proc))
+         continue;
+
+      processes++;
+      if (first || fromEvents || row->seenStampMs <= this->lastMs)
+         continue;
+
+      forks++;
+      const Process* parent = (const Process*) Table_findRow(processTable, Process_getParent(proc));
+      if (!Process_isKernelThread(proc) && (!parent || parent->procComm != proc->procComm)) {
+         execs++;
+         ProcessChurn_record(this, processTable, proc, monotonicMs);
+      }
+   }
+
+   unsigned int exits = (unsigned int) saturatingSub(this->processes + forks, processes);
+
+   if (fromEvents) {
+      forks = this->eventForks;
+      execs = this->eventExecs;
+      exits = this->eventExits;
+
+      /* read by now unless they already ended */
+      for (size_t i = 0; i < this->pendingCount; i++) {
+         const Row* row = Table_findRow(processTable, this->pending[i]);
+         ProcessChurn_record(this, processTable, row && Table_isUpdated(processTable, row) ? (const Process*) row : NULL, monotonicMs);
+      }
+   }
+
+   if (!first && monotonicMs > this->lastMs) {
+      const double seconds = (double)(monotonicMs - this->lastMs) / 1000.0;
+      this->rates.forks = forks / seconds;
+      this->rates.execs = execs / seconds;
+      this->rates.exits = exits / seconds;
+      this->rates.valid = true;
+      this->rates.fromEvents = fromEvents;
+   }
+
+   if (first)
+      this->sinceMs = monotonicMs ? monotonicMs : 1;
+   this->lastMs = monotonicMs;
+   this->processes = processes;
+   this->eventForks = this->eventExecs = this->eventExits = 0;
+   this->eventsRead = false;
+   this->eventsComplete = false;
+   this->pendingCount = 0;
+
+   ProcessChurn_expire(this, monotonicMs);
+}
+
+const ChurnRates* ProcessChurn_rates(void) {
+   return &ProcessChurn_state.rates;
+}
+
+size_t ProcessChurn_execCount(void) {
+   return ProcessChurn_state.ringCount;
+}
+
+const ChurnExec* ProcessChurn_exec(size_t index) {
+   const ProcessChurn* this = &ProcessChurn_state;
+   if (index >= this->ringCount)
+      return NULL;
+
+   return &this->ring[(this->ringStart + index) % CHURN_RING_SIZE];
+}
+
+uint64_t ProcessChurn_lastMs(void) {
+   return ProcessChurn_state.lastMs;
+}
+
+uint64_t ProcessChurn_sinceMs(void) {
+   return ProcessChurn_state.sinceMs;
+}
+
+void ProcessChurn_cleanup(void) {
+   ProcessChurn* this = &ProcessChurn_state;
+   free(this->ring);
+   memset(this, 0, sizeof(*this));
+}
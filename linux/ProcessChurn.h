@@ -0,0 +1,73 @@
+#ifndef HEADER_ProcessChurn
+#define HEADER_ProcessChurn
+/*
+htop - linux/ProcessChurn.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "Table.h"
+
+#include "linux/ProcConnector.h"
+
+
+/*
+ * How many processes are started, replaced by exec and ended per second,
+ * counted from the process events while they are read without losses, or
+ * else by comparing the processes of two scans. Scans only see the exec of
+ * a new process, as a command differing from its parent's, and none of the
+ * processes that ended before they were read.
+ */
+
+/* The execs kept for the screen span at most this long */
+#define CHURN_WINDOW_MS 60000
+
+/* Execs kept at most, the oldest are dropped first */
+#define CHURN_RING_SIZE 4096
+
+typedef struct ChurnRates_ {
+   double forks;                   /* per second, over the last interval */
+   double execs;
+   double exits;
+   bool valid;                     /* false before the second scan */
+   bool fromEvents;                /* counted from the process events */
+} ChurnRates;
+
+/* One exec, named after the command it ran and the parent it ran under */
+typedef struct ChurnExec_ {
+   uint64_t ms;                    /* monotonic, of the scan that saw it */
+   pid_t ppid;                     /* 0 if the process ended before it was read */
+   char comm[16];
+   char parentComm[16];
+} ChurnExec;
+
+/* Counts a process event, to be called while they are read */
+void ProcessChurn_event(ProcConnectorEvent event, pid_t pid, pid_t tgid);
+
+/* Whether the events read since the last update were all of them */
+void ProcessChurn_eventsRead(bool complete);
+
+/* Takes the rates of the interval that ended with the scan of `processTable` */
+void ProcessChurn_update(const Table* processTable, uint64_t monotonicMs);
+
+const ChurnRates* ProcessChurn_rates(void);
+
+/* Execs kept, index 0 is the oldest */
+size_t ProcessChurn_execCount(void);
+
+const ChurnExec* ProcessChurn_exec(size_t index);
+
+/* Monotonic time of the last update, and of the first one */
+uint64_t ProcessChurn_lastMs(void);
+
+uint64_t ProcessChurn_sinceMs(void);
+
+void ProcessChurn_cleanup(void);
+
+#endif
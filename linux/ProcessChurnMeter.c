@@ -0,0 +1,90 @@
+/*
+htop - linux/ProcessChurnMeter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/ProcessChurnMeter.h"
+
+#include <math.h>
+
+#include "CRT.h"
+#include "Macros.h"
+#include "Object.h"
+#include "RichString.h"
+#include "XUtils.h"
+
+#include "linux/ProcessChurn.h"
+
+
+static const int ProcessChurnMeter_attributes[] = {
+   METER_VALUE_OK,
+   METER_VALUE_NOTICE,
+   METER_VALUE_WARN,
+};
+
+static void ProcessChurnMeter_updateValues(Meter* this) {
+   const ChurnRates* rates = ProcessChurn_rates();
+
+   if (!rates->valid) {
+      this->values[0] = this->values[1] = this->values[2] = NAN;
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "N/A");
+      return;
+   }
+
+   this->values[0] = rates->forks;
+   this->values[1] = rates->execs;
+   this->values[2] = rates->exits;
+
+   /* the bar is full at the highest churn seen */
+   const double sum = rates->forks + rates->execs + rates->exits;
+   if (sum > this->total)
+      this->total = sum;
+
+   xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "%.1f/%.1f/%.1f", rates->forks, rates->execs, rates->exits);
+}
+
+static void ProcessChurnMeter_display(ATTR_UNUSED const Object* cast, RichString* out) {
+   const ChurnRates* rates = ProcessChurn_rates();
+   char buffer[32];
+
+   if (!rates->valid) {
+      RichString_writeAscii(out, CRT_colors[METER_VALUE_NOTICE], "N/A");
+      return;
+   }
+
+   xSnprintf(buffer, sizeof(buffer), "%.1f", rates->forks);
+   RichString_writeAscii(out, CRT_colors[METER_VALUE_OK], buffer);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " forks/s, ");
+
+   xSnprintf(buffer, sizeof(buffer), "%.1f", rates->execs);
+   RichString_appendAscii(out, CRT_colors[METER_VALUE_NOTICE], buffer);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " execs/s, ");
+
+   xSnprintf(buffer, sizeof(buffer), "%.1f", rates->exits);
+   RichString_appendAscii(out, CRT_colors[METER_VALUE_WARN], buffer);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " exits/s");
+
+   if (!rates->fromEvents)
+      RichString_appendAscii(out, CRT_colors[METER_SHADOW], " (from scans)");
+}
+
+const MeterClass ProcessChurnMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = ProcessChurnMeter_display,
+   },
+   .updateValues = ProcessChurnMeter_updateValues,
+   .defaultMode = TEXT_METERMODE,
+   .maxItems = 3,
+   .total = 1.0,
+   .attributes = ProcessChurnMeter_attributes,
+   .name = "ProcessChurn",
+   .uiName = "Process churn",
+   .description = "Processes forked, exec'd and exited per second",
+   .caption = "Churn: "
+};
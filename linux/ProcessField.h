@@ -48,6 +48,45 @@ in the source distribution for its full text.
    CCGROUP = 129,                \
    CONTAINER = 130,              \
    M_PRIV = 131,                 \
+   PERF_IPC = 132,               \
+   PERF_LLC_MISSES = 133,        \
+   PERF_BRANCH_MISS = 134,       \
+   PERF_STALLED = 135,           \
+   NUMA_REMOTE = 136,            \
+   NUMA_NODES = 137,             \
+   GPU_PERCENT = 138,            \
+   GPU_MEMORY = 139,             \
+   GPU_TIME = 140,               \
+   GPU_ENGINES = 141,            \
+   FD_COUNT = 142,               \
+   FD_RATE = 143,                \
+   FILE_LOCKS = 144,             \
+   PERCENT_RUNQ_WAIT = 145,      \
+   RUNQ_WAIT_AVG = 146,          \
+   PERCENT_THROTTLED = 147,      \
+   THROTTLE_RATE = 148,          \
+   WCHAN = 149,                  \
+   NET_RX = 150,                 \
+   NET_TX = 151,                 \
+   MIGRATE_RATE = 152,           \
+   NVCSW_RATE = 153,             \
+   NV_SM_PERCENT = 154,          \
+   NV_MEMORY = 155,              \
+   EST_POWER = 156,              \
+   CGROUP_CPU_PRESSURE = 157,    \
+   CGROUP_MEMORY_PRESSURE = 158, \
+   CGROUP_IO_PRESSURE = 159,     \
+   MAJFLT_RATE = 160,            \
+   MINFLT_RATE = 161,            \
+   CGROUP_REFAULT_RATE = 162,    \
+   CGROUP_SWAPIN_RATE = 163,     \
+   FUTEX_WAIT_PERCENT = 164,     \
+   PERCENT_CPU_QUOTA = 165,      \
+   CGROUP_MEMORY_HEADROOM = 166, \
+   PERCENT_THP = 167,            \
+   M_HUGETLB = 168,              \
+   SYSCALL_RATE = 169,           \
+   TOP_SYSCALL = 170,            \
    // End of list
 
 
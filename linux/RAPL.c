@@ -0,0 +1,203 @@
+/*
+htop - linux/RAPL.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/RAPL.h"
+
+#include <dirent.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Macros.h"
+#include "Rate.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+
+
+#define RAPL_POWERCAP_DIR "class/powercap"
+#define RAPL_HWMON_DIR "class/hwmon"
+
+/* Most counters of an amd_energy device, one per core and socket */
+#define RAPL_MAX_HWMON_INPUTS 1024
+
+typedef struct RAPLZone_ {
+   RAPLDomain domain;
+   FsRootFile* energy;             /* in microjoules */
+   unsigned long long range;       /* where the counter wraps around, 0 if it does not */
+   Rate rate;                      /* in microwatts */
+} RAPLZone;
+
+static RAPLZone* RAPL_zones;
+static size_t RAPL_zoneCount;
+static size_t RAPL_zoneSize;
+static bool RAPL_discovered;
+static double RAPL_limitW = NAN;
+
+static void RAPL_addZone(RAPLDomain domain, const char* energy, unsigned long long range) {
+   if (RAPL_zoneCount == RAPL_zoneSize) {
+      RAPL_zoneSize = RAPL_zoneSize ? 2 * RAPL_zoneSize : 8;
+      RAPL_zones = xReallocArray(RAPL_zones, RAPL_zoneSize, sizeof(RAPLZone));
+   }
+
+   RAPLZone* zone = &RAPL_zones[RAPL_zoneCount++];
+   *zone = (RAPLZone) { .domain = domain, .energy = FsRoot_keep(&FsRoot_sys, energy), .range = range };
+   Rate_reset(&zone->rate);
+}
+
+static unsigned long long RAPL_readNumber(const char* relative) {
+   char text[64];
+   if (FsRoot_readFile(&FsRoot_sys, relative, text, sizeof(text)) <= 0)
+      return ULLONG_MAX;
+
+   char* end;
+   unsigned long long value = strtoull(text, &end, 10);
+   return end != text ? value : ULLONG_MAX;
+}
+
+/* intel-rapl:<package> and intel-rapl:<package>:<subzone>, told apart by their name */
+static void RAPL_discoverPowercap(void) {
+   DIR* dir = FsRoot_opendir(&FsRoot_sys, RAPL_POWERCAP_DIR);
+   if (!dir)
+      return;
+
+   const struct dirent* entry;
+   while ((entry = readdir(dir))) {
+      /* intel-rapl-mmio repeats the package of the MSR interface */
+      if (!String_startsWith(entry->d_name, "intel-rapl:"))
+         continue;
+
+      char relative[256];
+      char name[64];
+      xSnprintf(relative, sizeof(relative), RAPL_POWERCAP_DIR "/%s/name", entry->d_name);
+      if (FsRoot_readFile(&FsRoot_sys, relative, name, sizeof(name)) <= 0)
+         continue;
+
+      RAPLDomain domain;
+      if (String_startsWith(name, "package-")) {
+         domain = RAPL_PACKAGE;
+      } else if (String_startsWith(name, "core")) {
+         domain = RAPL_CORE;
+      } else if (String_startsWith(name, "dram")) {
+         domain = RAPL_DRAM;
+      } else {
+         continue;
+      }
+
+      xSnprintf(relative, sizeof(relative), RAPL_POWERCAP_DIR "/%s/max_energy_range_uj", entry->d_name);
+      unsigned long long range = RAPL_readNumber(relative);
+
+      if (domain == RAPL_PACKAGE) {
+         /* constraint 0 is the long term limit */
+         xSnprintf(relative, sizeof(relative), RAPL_POWERCAP_DIR "/%s/constraint_0_power_limit_uw", entry->d_name);
+         unsigned long long limit = RAPL_readNumber(relative);
+         if (limit != ULLONG_MAX && limit > 0)
+            RAPL_limitW = (isnan(RAPL_limitW) ? 0.0 : RAPL_limitW) + (double)limit / 1e6;
+      }
+
+      xSnprintf(relative, sizeof(relative), RAPL_POWERCAP_DIR "/%s/energy_uj", entry->d_name);
+      RAPL_addZone(domain, relative, range == ULLONG_MAX ? 0 : range);
+   }
+
+   closedir(dir);
+}
+
+/* amd_energy has an Esocket<N> and an Ecore<N> counter per socket and core, kept in 64 bits by the driver */
+static void RAPL_discoverHwmon(void) {
+   DIR* dir = FsRoot_opendir(&FsRoot_sys, RAPL_HWMON_DIR);
+   if (!dir)
+      return;
+
+   const struct dirent* entry;
+   while ((entry = readdir(dir))) {
+      if (!String_startsWith(entry->d_name, "hwmon"))
+         continue;
+
+      char relative[256];
+      char text[64];
+      xSnprintf(relative, sizeof(relative), RAPL_HWMON_DIR "/%s/name", entry->d_name);
+      if (FsRoot_readFile(&FsRoot_sys, relative, text, sizeof(text)) <= 0 || !String_startsWith(text, "amd_energy"))
+         continue;
+
+      for (unsigned int i = 1; i <= RAPL_MAX_HWMON_INPUTS; i++) {
+         xSnprintf(relative, sizeof(relative), RAPL_HWMON_DIR "/%s/energy%u_label", entry->d_name, i);
+         if (FsRoot_readFile(&FsRoot_sys, relative, text, sizeof(text)) <= 0)
+            break;
+
+         RAPLDomain domain;
+         if (String_startsWith(text, "Esocket")) {
+            domain = RAPL_PACKAGE;
+         } else if (String_startsWith(text, "Ecore")) {
+            domain = RAPL_CORE;
+         } else {
+            continue;
+         }
+
+         xSnprintf(relative, sizeof(relative), RAPL_HWMON_DIR "/%s/energy%u_input", entry->d_name, i);
+         RAPL_addZone(domain, relative, 0);
+      }
+   }
+
+   closedir(dir);
+}
+
+void RAPL_refresh(uint64_t monotonicMs) {
+   if (!RAPL_discovered) {
+      RAPL_discovered = true;
+      RAPL_discoverPowercap();
+      if (RAPL_zoneCount == 0)
+         RAPL_discoverHwmon();
+   }
+
+   for (size_t i = 0; i < RAPL_zoneCount; i++) {
+      RAPLZone* zone = &RAPL_zones[i];
+      const char* text = FsRootFile_read(zone->energy, NULL);
+
+      char* end = NULL;
+      unsigned long long energy = text ? strtoull(text, &end, 10) : 0;
+      Rate_updateWrapping(&zone->rate, text && end != text ? energy : ULLONG_MAX, zone->range, monotonicMs);
+   }
+}
+
+double RAPL_power(RAPLDomain domain) {
+   double microwatts = 0.0;
+   bool known = false;
+
+   for (size_t i = 0; i < RAPL_zoneCount; i++) {
+      const RAPLZone* zone = &RAPL_zones[i];
+      if (zone->domain != domain)
+         continue;
+
+      /* a socket without a value leaves the sum unknown */
+      const double rate = Rate_value(&zone->rate);
+      if (isnan(rate))
+         return NAN;
+
+      microwatts += rate;
+      known = true;
+   }
+
+   return known ? microwatts / 1e6 : NAN;
+}
+
+double RAPL_packageLimit(void) {
+   return RAPL_limitW;
+}
+
+void RAPL_cleanup(void) {
+   /* the energy files are closed with FsRoot_sys */
+   free(RAPL_zones);
+   RAPL_zones = NULL;
+   RAPL_zoneCount = 0;
+   RAPL_zoneSize = 0;
+   RAPL_discovered = false;
+   RAPL_limitW = NAN;
+}
@@ -0,0 +1,37 @@
+#ifndef HEADER_RAPL
+#define HEADER_RAPL
+/*
+htop - linux/RAPL.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdint.h>
+
+
+/*
+ * Power drawn by the CPUs, from the energy counters of the RAPL zones in
+ * /sys/class/powercap (intel-rapl, which also covers recent AMD CPUs) or
+ * of the amd_energy hwmon driver. Reading them needs root since Linux 5.10.
+ */
+
+typedef enum RAPLDomain_ {
+   RAPL_PACKAGE,
+   RAPL_CORE,
+   RAPL_DRAM,
+   RAPL_DOMAINS
+} RAPLDomain;
+
+/* Reads the counters, looking for the zones on the first call */
+void RAPL_refresh(uint64_t monotonicMs);
+
+/* Watts of the domain summed over the sockets over the last interval, NAN if unknown */
+double RAPL_power(RAPLDomain domain);
+
+/* Sum of the long term power limits of the packages, NAN if unknown */
+double RAPL_packageLimit(void);
+
+void RAPL_cleanup(void);
+
+#endif
@@ -0,0 +1,116 @@
+/*
+htop - linux/RAPLMeter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/RAPLMeter.h"
+
+#include <math.h>
+
+#include "CRT.h"
+#include "Macros.h"
+#include "Object.h"
+#include "RichString.h"
+#include "XUtils.h"
+
+#include "linux/RAPL.h"
+
+
+enum {
+   RAPL_METER_CORE,
+   RAPL_METER_UNCORE,            /* the rest of the packages */
+   RAPL_METER_DRAM,
+   RAPL_METER_ITEMS
+};
+
+static const int RAPLMeter_attributes[RAPL_METER_ITEMS] = {
+   [RAPL_METER_CORE] = CPU_NORMAL,
+   [RAPL_METER_UNCORE] = CPU_SYSTEM,
+   [RAPL_METER_DRAM] = MEMORY_USED,
+};
+
+/* The bar is full at the limits of the packages, else at the highest power seen */
+static double RAPLMeter_highest = 1.0;
+
+static void RAPLMeter_updateValues(Meter* this) {
+   const double package = RAPL_power(RAPL_PACKAGE);
+   const double core = RAPL_power(RAPL_CORE);
+   const double dram = RAPL_power(RAPL_DRAM);
+
+   if (isnan(package)) {
+      this->values[RAPL_METER_CORE] = NAN;
+      this->values[RAPL_METER_UNCORE] = NAN;
+      this->values[RAPL_METER_DRAM] = NAN;
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "N/A");
+      return;
+   }
+
+   this->values[RAPL_METER_CORE] = isnan(core) ? 0.0 : MINIMUM(core, package);
+   this->values[RAPL_METER_UNCORE] = package - this->values[RAPL_METER_CORE];
+   this->values[RAPL_METER_DRAM] = isnan(dram) ? 0.0 : dram;
+
+   const double sum = package + this->values[RAPL_METER_DRAM];
+   RAPLMeter_highest = MAXIMUM(RAPLMeter_highest, sum);
+   const double limit = RAPL_packageLimit();
+   this->total = isnan(limit) ? RAPLMeter_highest : MAXIMUM(limit, sum);
+
+   xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "%.1fW", sum);
+}
+
+static void RAPLMeter_display(const Object* cast, RichString* out) {
+   const Meter* this = (const Meter*)cast;
+   char buffer[32];
+
+   RichString_writeAscii(out, CRT_colors[METER_TEXT], ": ");
+
+   const double package = RAPL_power(RAPL_PACKAGE);
+   if (isnan(package)) {
+      RichString_appendAscii(out, CRT_colors[METER_SHADOW], "no readable RAPL counters");
+      return;
+   }
+
+   xSnprintf(buffer, sizeof(buffer), "%.1fW", package);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], "pkg:");
+   RichString_appendAscii(out, CRT_colors[METER_VALUE], buffer);
+
+   const double core = RAPL_power(RAPL_CORE);
+   if (!isnan(core)) {
+      xSnprintf(buffer, sizeof(buffer), "%.1fW", core);
+      RichString_appendAscii(out, CRT_colors[METER_TEXT], " core:");
+      RichString_appendAscii(out, CRT_colors[CPU_NORMAL], buffer);
+   }
+
+   const double dram = RAPL_power(RAPL_DRAM);
+   if (!isnan(dram)) {
+      xSnprintf(buffer, sizeof(buffer), "%.1fW", dram);
+      RichString_appendAscii(out, CRT_colors[METER_TEXT], " dram:");
+      RichString_appendAscii(out, CRT_colors[MEMORY_USED], buffer);
+   }
+
+   const double limit = RAPL_packageLimit();
+   if (!isnan(limit) && this->total > 0.0) {
+      xSnprintf(buffer, sizeof(buffer), " of %.0fW", limit);
+      RichString_appendAscii(out, CRT_colors[METER_SHADOW], buffer);
+   }
+}
+
+const MeterClass RAPLMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = RAPLMeter_display,
+   },
+   .updateValues = RAPLMeter_updateValues,
+   .defaultMode = TEXT_METERMODE,
+   .maxItems = RAPL_METER_ITEMS,
+   .total = 1.0,
+   .attributes = RAPLMeter_attributes,
+   .name = "RAPL",
+   .uiName = "CPU power (RAPL)",
+   .description = "Power drawn by the CPU packages, their cores and DRAM, from the RAPL energy counters",
+   .caption = "Pwr"
+};
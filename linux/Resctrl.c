@@ -0,0 +1,347 @@
+/*
+htop - linux/Resctrl.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/Resctrl.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Macros.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+#include "linux/SourceCache.h"
+#include "linux/Platform.h" // needed for GNU/hurd to get PATH_MAX  // IWYU pragma: keep
+
+#ifdef HAVE_LIBHWLOC
+#include <hwloc.h>
+#endif
+
+
+#define RESCTRL_ROOT "fs/resctrl"
+#define RESCTRL_DISCOVERY_INTERVAL_MS 30000
+
+static Resctrl Resctrl_state;
+
+/* whether the groups are mapped to cgroups for the current scan */
+static bool Resctrl_cgroupsMapped;
+
+static const ResctrlCounters Resctrl_zero = { 0, 0, 0 };
+
+static void Resctrl_add(unsigned long long* sum, unsigned long long value) {
+   *sum = (*sum == ULLONG_MAX || value == ULLONG_MAX) ? ULLONG_MAX : *sum + value;
+}
+
+/* Occupancy and traffic of monitoring groups may be read a little later than of their control group */
+static void Resctrl_subtract(unsigned long long* sum, unsigned long long value) {
+   if (*sum == ULLONG_MAX || value == ULLONG_MAX) {
+      *sum = ULLONG_MAX;
+      return;
+   }
+   *sum = *sum > value ? *sum - value : 0;
+}
+
+void ResctrlCounters_add(ResctrlCounters* sum, const ResctrlCounters* counters) {
+   Resctrl_add(&sum->totalBytes, counters->totalBytes);
+   Resctrl_add(&sum->localBytes, counters->localBytes);
+   Resctrl_add(&sum->occupancy, counters->occupancy);
+}
+
+static void Resctrl_subtractCounters(ResctrlCounters* sum, const ResctrlCounters* counters) {
+   Resctrl_subtract(&sum->totalBytes, counters->totalBytes);
+   Resctrl_subtract(&sum->localBytes, counters->localBytes);
+   Resctrl_subtract(&sum->occupancy, counters->occupancy);
+}
+
+/* Path of a file of a group below FsRoot_sys */
+static void Resctrl_path(char* buffer, size_t size, const char* group, const char* file) {
+   xSnprintf(buffer, size, *group ? RESCTRL_ROOT "/%s/%s" : RESCTRL_ROOT "%s/%s", group, file);
+}
+
+/* A counter file holds a number, or "Unavailable" and the like without monitoring support */
+static unsigned long long Resctrl_readValue(const char* group, unsigned int domain, const char* name) {
+   char file[64];
+   char path[PATH_MAX];
+   char buffer[32];
+
+   xSnprintf(file, sizeof(file), "mon_data/mon_L3_%02u/%s", domain, name);
+   Resctrl_path(path, sizeof(path), group, file);
+   if (FsRoot_readFile(&FsRoot_sys, path, buffer, sizeof(buffer)) <= 0 || !isdigit((unsigned char)buffer[0]))
+      return ULLONG_MAX;
+
+   return strtoull(buffer, NULL, 10);
+}
+
+static int Resctrl_cpuSocket(const Machine* host, unsigned int cpu) {
+   char path[96];
+   char buffer[32];
+
+   xSnprintf(path, sizeof(path), "devices/system/cpu/cpu%u/topology/physical_package_id", cpu);
+   if (FsRoot_readFile(&FsRoot_sys, path, buffer, sizeof(buffer)) > 0 && isdigit((unsigned char)buffer[0]))
+      return atoi(buffer);
+
+#ifdef HAVE_LIBHWLOC
+   if (Machine_loadTopology(host)) {
+      hwloc_obj_t pu = hwloc_get_pu_obj_by_os_index(host->topology, cpu);
+      hwloc_obj_t package = pu ? hwloc_get_ancestor_obj_by_type(host->topology, HWLOC_OBJ_PACKAGE, pu) : NULL;
+      if (package)
+         return (int)package->os_index;
+   }
+#else
+   (void)host;
+#endif
+
+   return -1;
+}
+
+/* Package of the first CPU sharing the L3 cache with the id, -1 if none is found */
+static int Resctrl_cacheSocket(const Machine* host, unsigned int cacheId) {
+   for (unsigned int cpu = 0; cpu < host->existingCPUs; cpu++) {
+      for (unsigned int index = 0; ; index++) {
+         char path[96];
+         char buffer[32];
+
+         xSnprintf(path, sizeof(path), "devices/system/cpu/cpu%u/cache/index%u/level", cpu, index);
+         if (FsRoot_readFile(&FsRoot_sys, path, buffer, sizeof(buffer)) <= 0)
+            break;
+         if (atoi(buffer) != 3)
+            continue;
+
+         xSnprintf(path, sizeof(path), "devices/system/cpu/cpu%u/cache/index%u/id", cpu, index);
+         if (FsRoot_readFile(&FsRoot_sys, path, buffer, sizeof(buffer)) > 0 && strtoul(buffer, NULL, 10) == cacheId)
+            return Resctrl_cpuSocket(host, cpu);
+         break;
+      }
+   }
+   return -1;
+}
+
+static int Resctrl_compareDomains(const void* v1, const void* v2) {
+   const ResctrlDomain* d1 = (const ResctrlDomain*)v1;
+   const ResctrlDomain* d2 = (const ResctrlDomain*)v2;
+   return SPACESHIP_NUMBER(d1->id, d2->id);
+}
+
+/* The L3 domains do not change while resctrl is mounted, but it may be mounted later */
+static void Resctrl_discoverDomains(Resctrl* this, const Machine* host) {
+   DIR* dir = FsRoot_opendir(&FsRoot_sys, RESCTRL_ROOT "/mon_data");
+   if (!dir)
+      return;
+
+   size_t alloc = 0;
+   const struct dirent* entry;
+   while ((entry = readdir(dir)) != NULL) {
+      if (!String_startsWith(entry->d_name, "mon_L3_"))
+         continue;
+
+      char* end;
+      unsigned long id = strtoul(entry->d_name + strlen("mon_L3_"), &end, 10);
+      if (*end || id > UINT_MAX)
+         continue;
+
+      if (this->domainCount == alloc) {
+         alloc = alloc ? alloc * 2 : 4;
+         this->domains = xReallocArray(this->domains, alloc, sizeof(ResctrlDomain));
+      }
+      this->domains[this->domainCount++] = (ResctrlDomain) { .id = (unsigned int)id };
+   }
+   closedir(dir);
+
+   qsort(this->domains, this->domainCount, sizeof(ResctrlDomain), Resctrl_compareDomains);
+   for (size_t i = 0; i < this->domainCount; i++)
+      this->domains[i].socket = Resctrl_cacheSocket(host, this->domains[i].id);
+}
+
+static size_t Resctrl_group(Resctrl* this, const char* path, bool control) {
+   for (size_t i = 0; i < this->groupCount; i++) {
+      if (String_eq(this->groups[i].path, path)) {
+         this->groups[i].seen = true;
+         return i;
+      }
+   }
+
+   if (this->groupCount == this->groupAlloc) {
+      this->groupAlloc = this->groupAlloc ? this->groupAlloc * 2 : 8;
+      this->groups = xReallocArray(this->groups, this->groupAlloc, sizeof(ResctrlGroup));
+   }
+   this->groups[this->groupCount] = (ResctrlGroup) { .path = xStrdup(path), .control = control, .seen = true };
+   return this->groupCount++;
+}
+
+/* Reads the counters of a group summed over the domains, adding those of control groups to the system */
+static ResctrlCounters Resctrl_readGroup(Resctrl* this, const char* path, bool control) {
+   ResctrlCounters total = Resctrl_zero;
+
+   for (size_t i = 0; i < this->domainCount; i++) {
+      ResctrlDomain* domain = &this->domains[i];
+      const ResctrlCounters counters = {
+         .totalBytes = Resctrl_readValue(path, domain->id, "mbm_total_bytes"),
+         .localBytes = Resctrl_readValue(path, domain->id, "mbm_local_bytes"),
+         .occupancy = Resctrl_readValue(path, domain->id, "llc_occupancy"),
+      };
+
+      ResctrlCounters_add(&total, &counters);
+      if (control)
+         ResctrlCounters_add(&domain->counters, &counters);
+   }
+
+   return total;
+}
+
+/* Reads a control group and its monitoring groups, leaving those out of its own counters */
+static void Resctrl_readControlGroup(Resctrl* this, const char* path) {
+   const size_t control = Resctrl_group(this, path, true);
+   ResctrlCounters own = Resctrl_readGroup(this, path, true);
+
+   char dirPath[PATH_MAX];
+   Resctrl_path(dirPath, sizeof(dirPath), path, "mon_groups");
+   DIR* dir = FsRoot_opendir(&FsRoot_sys, dirPath);
+   if (dir) {
+      const struct dirent* entry;
+      while ((entry = readdir(dir)) != NULL) {
+         if (entry->d_name[0] == '.' || (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN))
+            continue;
+
+         char monitor[PATH_MAX];
+         xSnprintf(monitor, sizeof(monitor), *path ? "%s/mon_groups/%s" : "%smon_groups/%s", path, entry->d_name);
+         const size_t i = Resctrl_group(this, monitor, false);
+         this->groups[i].own = Resctrl_readGroup(this, monitor, false);
+         Resctrl_subtractCounters(&own, &this->groups[i].own);
+      }
+      closedir(dir);
+   }
+
+   this->groups[control].own = own;
+}
+
+static void Resctrl_read(Resctrl* this) {
+   for (size_t i = 0; i < this->domainCount; i++)
+      this->domains[i].counters = Resctrl_zero;
+   for (size_t i = 0; i < this->groupCount; i++)
+      this->groups[i].seen = false;
+
+   /* the default group, then the control groups next to the info and mon_* directories */
+   Resctrl_readControlGroup(this, "");
+
+   DIR* dir = FsRoot_opendir(&FsRoot_sys, RESCTRL_ROOT);
+   if (dir) {
+      const struct dirent* entry;
+      while ((entry = readdir(dir)) != NULL) {
+         if (entry->d_name[0] == '.' || (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN))
+            continue;
+         if (String_eq(entry->d_name, "info") || String_eq(entry->d_name, "mon_data") || String_eq(entry->d_name, "mon_groups"))
+            continue;
+
+         Resctrl_readControlGroup(this, entry->d_name);
+      }
+      closedir(dir);
+   }
+
+   size_t kept = 0;
+   for (size_t i = 0; i < this->groupCount; i++) {
+      if (this->groups[i].seen) {
+         this->groups[kept++] = this->groups[i];
+      } else {
+         free(this->groups[i].path);
+         free(this->groups[i].cgroup);
+      }
+   }
+   this->groupCount = kept;
+}
+
+/* Takes the cgroup of the first task of the group, looked up again only when that task changes */
+static void Resctrl_mapCGroup(ResctrlGroup* group) {
+   char path[PATH_MAX];
+   char buffer[4096];
+
+   pid_t task = 0;
+   Resctrl_path(path, sizeof(path), group->path, "tasks");
+   if (FsRoot_readFile(&FsRoot_sys, path, buffer, 32) > 0)
+      task = (pid_t)atoi(buffer);
+
+   if (task == group->task)
+      return;
+
+   group->task = task;
+   free(group->cgroup);
+   group->cgroup = NULL;
+   if (task <= 0)
+      return;
+
+   xSnprintf(path, sizeof(path), "%d/cgroup", (int)task);
+   if (FsRoot_readFile(&FsRoot_proc, path, buffer, sizeof(buffer)) <= 0)
+      return;
+
+   for (const char* line = buffer; line; line = strchr(line, '\n')) {
+      if (*line == '\n')
+         line++;
+      if (String_startsWith(line, "0::")) {
+         line += strlen("0::");
+         group->cgroup = xStrndup(line, (size_t)(String_strchrnul(line, '\n') - line));
+         return;
+      }
+   }
+}
+
+const Resctrl* Resctrl_get(const Machine* host, bool cgroups) {
+   Resctrl* this = &Resctrl_state;
+
+   if (SourceCache_isStale(SOURCE_RESCTRL)) {
+      if (this->domainCount == 0 && host->monotonicMs >= this->nextDiscoveryMs) {
+         this->nextDiscoveryMs = host->monotonicMs + RESCTRL_DISCOVERY_INTERVAL_MS;
+         Resctrl_discoverDomains(this, host);
+      }
+
+      this->valid = this->domainCount > 0;
+      if (this->valid)
+         Resctrl_read(this);
+      Resctrl_cgroupsMapped = false;
+   }
+
+   /* the default group holds all other tasks and is no cgroup's own */
+   if (cgroups && this->valid && !Resctrl_cgroupsMapped) {
+      for (size_t i = 0; i < this->groupCount; i++) {
+         if (*this->groups[i].path)
+            Resctrl_mapCGroup(&this->groups[i]);
+      }
+      Resctrl_cgroupsMapped = true;
+   }
+
+   return this;
+}
+
+bool Resctrl_sumCGroup(const Resctrl* this, const char* path, ResctrlCounters* sum) {
+   bool found = false;
+   *sum = Resctrl_zero;
+
+   for (size_t i = 0; i < this->groupCount; i++) {
+      const ResctrlGroup* group = &this->groups[i];
+      if (group->cgroup && String_eq(group->cgroup, path)) {
+         ResctrlCounters_add(sum, &group->own);
+         found = true;
+      }
+   }
+
+   return found;
+}
+
+void Resctrl_done(void) {
+   Resctrl* this = &Resctrl_state;
+
+   for (size_t i = 0; i < this->groupCount; i++) {
+      free(this->groups[i].path);
+      free(this->groups[i].cgroup);
+   }
+   free(this->groups);
+   free(this->domains);
+   *this = (Resctrl) { 0 };
+}
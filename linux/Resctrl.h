@@ -0,0 +1,70 @@
+#ifndef HEADER_Resctrl
+#define HEADER_Resctrl
+/*
+htop - linux/Resctrl.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "Machine.h"
+
+
+/* Monitoring counters of the L3 cache domains, ULLONG_MAX where the platform does not support them */
+typedef struct ResctrlCounters_ {
+   unsigned long long totalBytes;     /* mbm_total_bytes, memory traffic */
+   unsigned long long localBytes;     /* mbm_local_bytes, the part to the local NUMA node */
+   unsigned long long occupancy;      /* llc_occupancy, in bytes */
+} ResctrlCounters;
+
+/* Adds counters to a sum, which becomes unknown with any of them unknown */
+void ResctrlCounters_add(ResctrlCounters* sum, const ResctrlCounters* counters);
+
+typedef struct ResctrlDomain_ {
+   unsigned int id;                   /* of mon_data/mon_L3_<id>, the id of the L3 cache */
+   int socket;                        /* package of the CPUs sharing that cache, -1 if unknown */
+   ResctrlCounters counters;          /* of the whole system, summed over the control groups */
+} ResctrlDomain;
+
+/*
+ * A resctrl group: the default group, a control group or a monitoring
+ * group below either. The kernel counts the monitoring groups of a
+ * control group into its own counters, `own` leaves them out again.
+ */
+typedef struct ResctrlGroup_ {
+   char* path;                        /* below the resctrl mount, "" for the default group */
+   bool control;                      /* the default or a control group */
+   ResctrlCounters own;               /* of the tasks of the group itself, summed over the domains */
+   pid_t task;                        /* first of its tasks, 0 if it has none */
+   char* cgroup;                      /* v2 path of the cgroup of that task, NULL if unknown */
+   bool seen;
+} ResctrlGroup;
+
+typedef struct Resctrl_ {
+   bool valid;                        /* resctrl is mounted with L3 monitoring */
+   ResctrlDomain* domains;
+   size_t domainCount;
+   ResctrlGroup* groups;
+   size_t groupCount;
+   size_t groupAlloc;
+   uint64_t nextDiscoveryMs;
+} Resctrl;
+
+/*
+ * The counters of resctrl, read once per Machine_scan() from
+ * /sys/fs/resctrl. With `cgroups` the groups are also mapped to the
+ * cgroup of their first task.
+ */
+const Resctrl* Resctrl_get(const Machine* host, bool cgroups);
+
+/* Adds the counters of the groups whose tasks are in the cgroup at `path`; false if there is none */
+bool Resctrl_sumCGroup(const Resctrl* this, const char* path, ResctrlCounters* sum);
+
+void Resctrl_done(void);
+
+#endif
@@ -0,0 +1,222 @@
+/*
+htop - linux/ResctrlMeter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/ResctrlMeter.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "CRT.h"
+#include "Machine.h"
+#include "Macros.h"
+#include "Object.h"
+#include "Rate.h"
+#include "RichString.h"
+#include "XUtils.h"
+
+#include "linux/Resctrl.h"
+
+
+/* The L3 domains summed up per socket; a domain of unknown socket stands for itself */
+typedef struct ResctrlMeterUnit_ {
+   int socket;
+   unsigned int domain;           /* labels the unit without a socket */
+   ResctrlCounters counters;
+   Rate totalRate;
+   Rate localRate;
+} ResctrlMeterUnit;
+
+typedef struct ResctrlMeterData_ {
+   size_t domainCount;            /* the units are made for */
+   size_t* unitOfDomain;
+   ResctrlMeterUnit* units;
+   size_t unitCount;
+} ResctrlMeterData;
+
+static const int ResctrlMeter_attributes[] = {
+   METER_VALUE,
+};
+
+static void ResctrlMeter_init(Meter* this) {
+   if (!this->meterData)
+      this->meterData = xCalloc(1, sizeof(ResctrlMeterData));
+}
+
+static void ResctrlMeter_makeUnits(ResctrlMeterData* data, const Resctrl* resctrl) {
+   free(data->unitOfDomain);
+   free(data->units);
+   data->domainCount = resctrl->domainCount;
+   data->unitOfDomain = xCalloc(data->domainCount, sizeof(size_t));
+   data->units = xCalloc(data->domainCount, sizeof(ResctrlMeterUnit));
+   data->unitCount = 0;
+
+   for (size_t i = 0; i < resctrl->domainCount; i++) {
+      const ResctrlDomain* domain = &resctrl->domains[i];
+
+      size_t unit = 0;
+      while (unit < data->unitCount && (domain->socket < 0 || data->units[unit].socket != domain->socket))
+         unit++;
+
+      if (unit == data->unitCount) {
+         data->units[unit].socket = domain->socket;
+         data->units[unit].domain = domain->id;
+         data->unitCount++;
+      }
+      data->unitOfDomain[i] = unit;
+   }
+}
+
+/* Sums the counters of the domains per unit, false without resctrl monitoring */
+static bool ResctrlMeter_sumUnits(Meter* this) {
+   ResctrlMeterData* data = this->meterData;
+   const Resctrl* resctrl = Resctrl_get(this->host, false);
+
+   if (!resctrl->valid) {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "no resctrl monitoring");
+      return false;
+   }
+
+   if (data->domainCount != resctrl->domainCount)
+      ResctrlMeter_makeUnits(data, resctrl);
+
+   for (size_t i = 0; i < data->unitCount; i++)
+      data->units[i].counters = (ResctrlCounters) { 0, 0, 0 };
+
+   for (size_t i = 0; i < resctrl->domainCount; i++)
+      ResctrlCounters_add(&data->units[data->unitOfDomain[i]].counters, &resctrl->domains[i].counters);
+
+   return true;
+}
+
+static int ResctrlMeter_label(char* buffer, size_t size, const ResctrlMeterUnit* unit, bool first) {
+   if (unit->socket >= 0)
+      return xSnprintf(buffer, size, "%sS%d: ", first ? "" : " ", unit->socket);
+   return xSnprintf(buffer, size, "%sL3#%u: ", first ? "" : " ", unit->domain);
+}
+
+/* Grows the scale of the bar and graph modes with the largest value seen */
+static void ResctrlMeter_setValue(Meter* this, double value) {
+   this->curItems = 1;
+   this->values[0] = value;
+   if (isNonnegative(value) && value > this->total)
+      this->total = value;
+}
+
+static void MemoryBandwidthMeter_updateValues(Meter* this) {
+   ResctrlMeterData* data = this->meterData;
+   double sum = NAN;
+
+   if (!ResctrlMeter_sumUnits(this)) {
+      ResctrlMeter_setValue(this, sum);
+      return;
+   }
+
+   const uint64_t now = this->host->monotonicMs;
+   char* text = this->txtBuffer;
+   size_t size = sizeof(this->txtBuffer);
+
+   for (size_t i = 0; i < data->unitCount && size > 1; i++) {
+      ResctrlMeterUnit* unit = &data->units[i];
+      const double total = Rate_update(&unit->totalRate, unit->counters.totalBytes, now);
+      const double local = Rate_update(&unit->localRate, unit->counters.localBytes, now);
+
+      int len = ResctrlMeter_label(text, size, unit, i == 0);
+      if (!isNonnegative(total)) {
+         len += xSnprintf(text + len, size - (size_t)len, "N/A");
+      } else {
+         sum = isnan(sum) ? total : sum + total;
+
+         char rate[16];
+         Meter_humanUnit(rate, total / ONE_K, sizeof(rate));
+         len += xSnprintf(text + len, size - (size_t)len, "%s/s", rate);
+         if (isNonnegative(local) && total > 0.0)
+            len += xSnprintf(text + len, size - (size_t)len, " %.0f%% local", MINIMUM(local / total, 1.0) * 100.0);
+      }
+      text += len;
+      size -= (size_t)len;
+   }
+
+   ResctrlMeter_setValue(this, sum);
+}
+
+static void LLCOccupancyMeter_updateValues(Meter* this) {
+   ResctrlMeterData* data = this->meterData;
+   double sum = NAN;
+
+   if (!ResctrlMeter_sumUnits(this)) {
+      ResctrlMeter_setValue(this, sum);
+      return;
+   }
+
+   char* text = this->txtBuffer;
+   size_t size = sizeof(this->txtBuffer);
+
+   for (size_t i = 0; i < data->unitCount && size > 1; i++) {
+      const ResctrlMeterUnit* unit = &data->units[i];
+
+      int len = ResctrlMeter_label(text, size, unit, i == 0);
+      if (unit->counters.occupancy == ULLONG_MAX) {
+         len += xSnprintf(text + len, size - (size_t)len, "N/A");
+      } else {
+         sum = (isnan(sum) ? 0.0 : sum) + (double)unit->counters.occupancy;
+
+         char occupancy[16];
+         Meter_humanUnit(occupancy, (double)unit->counters.occupancy / ONE_K, sizeof(occupancy));
+         len += xSnprintf(text + len, size - (size_t)len, "%s", occupancy);
+      }
+      text += len;
+      size -= (size_t)len;
+   }
+
+   ResctrlMeter_setValue(this, sum);
+}
+
+static void ResctrlMeter_done(Meter* this) {
+   ResctrlMeterData* data = this->meterData;
+   free(data->unitOfDomain);
+   free(data->units);
+   free(data);
+}
+
+const MeterClass MemoryBandwidthMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+   },
+   .updateValues = MemoryBandwidthMeter_updateValues,
+   .defaultMode = TEXT_METERMODE,
+   .maxItems = 1,
+   .total = 1.0,
+   .attributes = ResctrlMeter_attributes,
+   .name = "MemoryBandwidth",
+   .uiName = "Memory bandwidth",
+   .caption = "Mem BW: ",
+   .description = "Memory bandwidth per socket and its share to the local node, from resctrl monitoring (Intel RDT, AMD QoS)",
+   .init = ResctrlMeter_init,
+   .done = ResctrlMeter_done,
+};
+
+const MeterClass LLCOccupancyMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+   },
+   .updateValues = LLCOccupancyMeter_updateValues,
+   .defaultMode = TEXT_METERMODE,
+   .maxItems = 1,
+   .total = 1.0,
+   .attributes = ResctrlMeter_attributes,
+   .name = "LLCOccupancy",
+   .uiName = "LLC occupancy",
+   .caption = "LLC: ",
+   .description = "Last level cache occupancy per socket, from resctrl monitoring (Intel RDT, AMD QoS)",
+   .init = ResctrlMeter_init,
+   .done = ResctrlMeter_done,
+};
@@ -0,0 +1,17 @@
+#ifndef HEADER_ResctrlMeter
+#define HEADER_ResctrlMeter
+/*
+htop - linux/ResctrlMeter.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "Meter.h"
+
+
+extern const MeterClass MemoryBandwidthMeter_class;
+
+extern const MeterClass LLCOccupancyMeter_class;
+
+#endif
@@ -0,0 +1,352 @@
+/*
+htop - linux/RunQueueMeter.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/RunQueueMeter.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CRT.h"
+#include "Machine.h"
+#include "Macros.h"
+#include "Object.h"
+#include "Rate.h"
+#include "RichString.h"
+#include "Settings.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+#include "linux/LinuxMachine.h"
+#include "linux/SourceCache.h"
+
+
+#define RUNQUEUE_LABEL_WIDTH 5
+#define RUNQUEUE_VALUE_WIDTH 6
+
+/*
+ * The per CPU counters of /proc/schedstat (needs CONFIG_SCHEDSTATS): the
+ * nanoseconds tasks ran and waited on the run queue of the CPU, and the
+ * timeslices they got. Read once per update for all meters showing them.
+ */
+typedef struct SchedstatTable_ {
+   FsRootFile* kept;
+   unsigned long long* running;
+   unsigned long long* waiting;
+   unsigned long long* slices;
+   unsigned int cpus;             /* one more than the highest CPU listed */
+   unsigned int alloc;
+   bool valid;
+   unsigned int meters;           /* meters showing the table, it is freed with the last one */
+} SchedstatTable;
+
+static SchedstatTable RunQueueMeter_table;
+
+static void SchedstatTable_read(SchedstatTable* this) {
+   this->valid = false;
+   this->cpus = 0;
+
+   char* content = FsRoot_readKept(&FsRoot_proc, &this->kept, "schedstat", NULL);
+   if (!content)
+      return;
+
+   for (char* line = content, *next; line && *line; line = next) {
+      next = strchr(line, '\n');
+      if (next)
+         *next++ = '\0';
+
+      /* "cpu<N> yld_count legacy schedule_count goidle ttwu ttwu_local running waiting slices" */
+      if (!String_startsWith(line, "cpu"))
+         continue;
+
+      char* end;
+      unsigned long cpu = strtoul(line + strlen("cpu"), &end, 10);
+      if (end == line + strlen("cpu") || cpu >= UINT_MAX - 1)
+         continue;
+
+      unsigned long long fields[9];
+      size_t n = 0;
+      for (char* p = end; n < ARRAYSIZE(fields); p = end, n++) {
+         fields[n] = strtoull(p, &end, 10);
+         if (end == p)
+            break;
+      }
+      if (n < ARRAYSIZE(fields))
+         continue;
+
+      if (cpu >= this->alloc) {
+         unsigned int alloc = MAXIMUM((unsigned int)cpu + 1, this->alloc * 2);
+         this->running = xReallocArray(this->running, alloc, sizeof(unsigned long long));
+         this->waiting = xReallocArray(this->waiting, alloc, sizeof(unsigned long long));
+         this->slices = xReallocArray(this->slices, alloc, sizeof(unsigned long long));
+         this->alloc = alloc;
+      }
+
+      /* CPUs not listed, being offline, have no counters */
+      for (unsigned int i = this->cpus; i < cpu; i++)
+         this->running[i] = this->waiting[i] = this->slices[i] = ULLONG_MAX;
+
+      this->running[cpu] = fields[6];
+      this->waiting[cpu] = fields[7];
+      this->slices[cpu] = fields[8];
+      this->cpus = MAXIMUM(this->cpus, (unsigned int)cpu + 1);
+   }
+
+   this->valid = this->cpus > 0;
+}
+
+static void SchedstatTable_release(SchedstatTable* this) {
+   if (--this->meters > 0)
+      return;
+
+   free(this->running);
+   free(this->waiting);
+   free(this->slices);
+   this->running = this->waiting = this->slices = NULL;
+   this->alloc = 0;
+   this->cpus = 0;
+   this->valid = false;
+   /* the file stays registered with the proc root */
+   this->kept = NULL;
+}
+
+typedef struct RunQueueMeterData_ {
+   unsigned int cpus;             /* CPUs when the meter was set up */
+   unsigned int* order;           /* the CPUs grouped by their NUMA node */
+   bool* groupStart;              /* whether the CPU at a position is the first of its node */
+   unsigned int groups;
+   Rate* running;                 /* per CPU, in ns per second */
+   Rate* waiting;
+   Rate allWaiting;
+   Rate allSlices;
+   double* waitValues;            /* tasks waiting on average per CPU, NAN while unknown */
+   double queued;                 /* tasks running or waiting on average, all CPUs */
+   double waited;
+   double waitMax;
+   unsigned int busiest;
+   double waitPerSlice;           /* ns */
+   uint64_t lastUpdateMs;
+} RunQueueMeterData;
+
+static const int RunQueueMeter_attributes[] = {
+   METER_VALUE,
+};
+
+static void RunQueueMeter_init(Meter* this) {
+   if (this->meterData)
+      return;
+
+   const LinuxMachine* lhost = (const LinuxMachine*) this->host;
+   RunQueueMeterData* data = this->meterData = xCalloc(1, sizeof(RunQueueMeterData));
+   RunQueueMeter_table.meters++;
+
+   data->cpus = MAXIMUM(this->host->existingCPUs, 1);
+   data->order = xCalloc(data->cpus, sizeof(unsigned int));
+   data->groupStart = xCalloc(data->cpus, sizeof(bool));
+   data->running = xCalloc(data->cpus, sizeof(Rate));
+   data->waiting = xCalloc(data->cpus, sizeof(Rate));
+   data->waitValues = xCalloc(data->cpus, sizeof(double));
+   for (unsigned int cpu = 0; cpu < data->cpus; cpu++)
+      data->waitValues[cpu] = NAN;
+   data->queued = data->waited = data->waitPerSlice = NAN;
+   data->groups = LinuxMachine_groupCPUsByNode(lhost, data->cpus, data->order, data->groupStart);
+}
+
+static void RunQueueMeter_updateMode(Meter* this, int mode) {
+   this->mode = mode;
+   this->h = 1;
+}
+
+static void RunQueueMeter_updateValues(Meter* this) {
+   RunQueueMeterData* data = this->meterData;
+   SchedstatTable* table = &RunQueueMeter_table;
+   const Machine* host = this->host;
+
+   /* update only every 500ms to have a sane span for rate calculation */
+   if (host->monotonicMs - data->lastUpdateMs <= 500)
+      return;
+
+   data->lastUpdateMs = host->monotonicMs;
+
+   if (SourceCache_isStale(SOURCE_SCHEDSTAT))
+      SchedstatTable_read(table);
+
+   if (!table->valid) {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "no /proc/schedstat");
+      return;
+   }
+
+   double queued = 0.0;
+   double waited = 0.0;
+   unsigned long long allWaiting = 0;
+   unsigned long long allSlices = 0;
+   bool known = false;
+
+   data->waitMax = 0.0;
+   for (unsigned int cpu = 0; cpu < data->cpus; cpu++) {
+      const bool listed = cpu < table->cpus && table->running[cpu] != ULLONG_MAX;
+      const double running = Rate_update(&data->running[cpu], listed ? table->running[cpu] : ULLONG_MAX, host->monotonicMs);
+      const double waiting = Rate_update(&data->waiting[cpu], listed ? table->waiting[cpu] : ULLONG_MAX, host->monotonicMs);
+      if (listed) {
+         allWaiting += table->waiting[cpu];
+         allSlices += table->slices[cpu];
+      }
+
+      /* nanoseconds per second over one second of a single task */
+      data->waitValues[cpu] = isNonnegative(waiting) ? waiting / 1e9 : NAN;
+      if (!isNonnegative(running) || !isNonnegative(waiting))
+         continue;
+
+      known = true;
+      queued += (running + waiting) / 1e9;
+      waited += waiting / 1e9;
+      if (data->waitValues[cpu] > data->waitMax) {
+         data->waitMax = data->waitValues[cpu];
+         data->busiest = cpu;
+      }
+   }
+
+   /* both over the same interval, the ratio is the one of the changes */
+   const double waitRate = Rate_update(&data->allWaiting, allWaiting, host->monotonicMs);
+   const double sliceRate = Rate_update(&data->allSlices, allSlices, host->monotonicMs);
+   data->waitPerSlice = sliceRate > 0.0 ? waitRate / sliceRate : NAN;
+
+   data->queued = known ? queued : NAN;
+   data->waited = known ? waited : NAN;
+   if (!known) {
+      xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "N/A");
+      return;
+   }
+
+   xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "%.2f queued %.2f waiting", queued, waited);
+}
+
+/* Wait times, like "850ns", "35us" or "1.2ms" */
+static int RunQueueMeter_formatNs(char* buffer, size_t size, double ns) {
+   if (isnan(ns))
+      return xSnprintf(buffer, size, "N/A");
+   if (ns < 1000.0)
+      return xSnprintf(buffer, size, "%.0fns", ns);
+   if (ns < 1000000.0)
+      return xSnprintf(buffer, size, "%.0fus", ns / 1000.0);
+   return xSnprintf(buffer, size, "%.1fms", ns / 1000000.0);
+}
+
+static void RunQueueMeter_display(const Object* cast, RichString* out) {
+   const Meter* this = (const Meter*)cast;
+   const RunQueueMeterData* data = this->meterData;
+
+   if (!RunQueueMeter_table.valid || isnan(data->queued)) {
+      RichString_appendAscii(out, CRT_colors[METER_VALUE_NOTICE], this->txtBuffer);
+      return;
+   }
+
+   char buffer[32];
+   int len = xSnprintf(buffer, sizeof(buffer), "%.2f", data->queued);
+   RichString_appendnAscii(out, CRT_colors[METER_VALUE], buffer, len);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " running or waiting, ");
+   len = xSnprintf(buffer, sizeof(buffer), "%.2f", data->waited);
+   RichString_appendnAscii(out, CRT_colors[data->waited >= 1.0 ? METER_VALUE_WARN : METER_VALUE], buffer, len);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " waiting, ");
+   len = RunQueueMeter_formatNs(buffer, sizeof(buffer), data->waitPerSlice);
+   RichString_appendnAscii(out, CRT_colors[METER_VALUE], buffer, len);
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " wait per timeslice");
+
+   if (data->waitMax > 0.0) {
+      len = xSnprintf(buffer, sizeof(buffer), ", most on CPU %u: ", data->busiest + (this->host->settings->countCPUsFromOne ? 1 : 0));
+      RichString_appendnAscii(out, CRT_colors[METER_TEXT], buffer, len);
+      len = xSnprintf(buffer, sizeof(buffer), "%.2f", data->waitMax);
+      RichString_appendnAscii(out, CRT_colors[data->waitMax >= 1.0 ? METER_VALUE_WARN : METER_VALUE], buffer, len);
+   }
+}
+
+/* Shaded by the tasks waiting on average: a whole one means the CPU is oversubscribed */
+static void RunQueueMeter_appendCell(RichString* out, double value) {
+   if (isnan(value) || value < 0.05) {
+      Meter_appendHeatCell(out, -1);
+      return;
+   }
+
+   Meter_appendHeatCell(out, value < 0.25 ? 0 : value < 0.5 ? 1 : value < 1.0 ? 2 : 3);
+}
+
+/* The tasks waiting on each CPU as a heat cell, nodes apart, CPUs merged into cells if they do not fit */
+static void RunQueueMeter_draw(Meter* this, int x, int y, int w) {
+   const RunQueueMeterData* data = this->meterData;
+   if (this->mode == TEXT_METERMODE || !RunQueueMeter_table.valid) {
+      Meter_modes[TEXT_METERMODE]->draw(this, x, y, w);
+      return;
+   }
+
+   const int cells = w - RUNQUEUE_LABEL_WIDTH - RUNQUEUE_VALUE_WIDTH;
+   if (cells < 1)
+      return;
+
+   const bool gaps = data->cpus + data->groups - 1 <= (unsigned int)cells;
+   const unsigned int perCell = gaps ? 1 : (data->cpus + (unsigned int)cells - 1) / (unsigned int)cells;
+
+   RichString_begin(out);
+   char label[RUNQUEUE_LABEL_WIDTH + 1];
+   xSnprintf(label, sizeof(label), "%-*s", RUNQUEUE_LABEL_WIDTH, "RunQ");
+   RichString_appendAscii(&out, CRT_colors[METER_TEXT], label);
+
+   for (unsigned int i = 0; i < data->cpus; i += perCell) {
+      if (gaps && i > 0 && data->groupStart[i])
+         RichString_appendChr(&out, CRT_colors[METER_TEXT], ' ', 1);
+
+      double value = NAN;
+      for (unsigned int j = i; j < i + perCell && j < data->cpus; j++) {
+         const double v = data->waitValues[data->order[j]];
+         if (isnan(value) || v > value)
+            value = v;
+      }
+
+      RunQueueMeter_appendCell(&out, value);
+   }
+
+   char text[RUNQUEUE_VALUE_WIDTH + 8];
+   int len = xSnprintf(text, sizeof(text), " %*.2f", RUNQUEUE_VALUE_WIDTH - 1, data->waitMax);
+   RichString_appendnAscii(&out, CRT_colors[data->waitMax >= 1.0 ? METER_VALUE_WARN : METER_VALUE], text, len);
+
+   RichString_printoffnVal(out, y, x, 0, w);
+   RichString_delete(&out);
+}
+
+static void RunQueueMeter_done(Meter* this) {
+   RunQueueMeterData* data = this->meterData;
+   SchedstatTable_release(&RunQueueMeter_table);
+   free(data->order);
+   free(data->groupStart);
+   free(data->running);
+   free(data->waiting);
+   free(data->waitValues);
+   free(data);
+}
+
+const MeterClass RunQueueMeter_class = {
+   .super = {
+      .extends = Class(Meter),
+      .delete = Meter_delete,
+      .display = RunQueueMeter_display,
+   },
+   .updateValues = RunQueueMeter_updateValues,
+   .defaultMode = CUSTOM_METERMODE,
+   .total = 100.0,
+   .attributes = RunQueueMeter_attributes,
+   .name = "RunQueue",
+   .uiName = "Run queues per CPU",
+   .description = "Run queues per CPU: tasks waiting for each CPU as a heatmap, and the wait per timeslice, from /proc/schedstat",
+   .caption = "RunQ: ",
+   .draw = RunQueueMeter_draw,
+   .init = RunQueueMeter_init,
+   .updateMode = RunQueueMeter_updateMode,
+   .done = RunQueueMeter_done
+};
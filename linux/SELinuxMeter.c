@@ -20,6 +20,7 @@ in the source distribution for its full text.
 
 #include "Object.h"
 #include "XUtils.h"
+#include "linux/FsRoot.h"
 
 
 static const int SELinuxMeter_attributes[] = {
@@ -30,8 +31,11 @@ static bool enabled = false;
 static bool enforcing = false;
 
 static bool hasSELinuxMount(void) {
+   char path[4096];
+   FsRoot_path(&FsRoot_sys, "fs/selinux", path, sizeof(path));
+
    struct statfs sfbuf;
-   int r = statfs("/sys/fs/selinux", &sfbuf);
+   int r = statfs(path, &sfbuf);
    if (r != 0) {
       return false;
    }
@@ -41,7 +45,7 @@ static bool hasSELinuxMount(void) {
    }
 
    struct statvfs vfsbuf;
-   r = statvfs("/sys/fs/selinux", &vfsbuf);
+   r = statvfs(path, &vfsbuf);
    if (r != 0 || (vfsbuf.f_flag & ST_RDONLY)) {
       return false;
    }
@@ -59,7 +63,7 @@ static bool isSelinuxEnforcing(void) {
    }
 
    char buf[20];
-   ssize_t r = xReadfile("/sys/fs/selinux/enforce", buf, sizeof(buf));
+   ssize_t r = FsRoot_readFile(&FsRoot_sys, "fs/selinux/enforce", buf, sizeof(buf));
    if (r < 0)
       return false;
 
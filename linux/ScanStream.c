@@ -0,0 +1,954 @@
+/*
+htop - linux/ScanStream.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/ScanStream.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "Hashtable.h"
+#include "Macros.h"
+#include "XUtils.h"
+#include "linux/Platform.h"
+
+
+#define SCANSTREAM_MAGIC "htopstrm"
+
+/* Bumped with every change of the encoding */
+#define SCANSTREAM_VERSION 1
+
+/* Key frames are sent after this many frames, which bounds the strings kept */
+#define SCANSTREAM_KEY_INTERVAL 300
+
+#define SCANSTREAM_MAX_VIEWERS 64
+
+/* A viewer this far behind is dropped, to catch up with a key frame once it reconnects */
+#define SCANSTREAM_BACKLOG_MAX (16 * 1024 * 1024)
+
+/* Largest frame a viewer takes */
+#define SCANSTREAM_FRAME_MAX (64 * 1024 * 1024)
+
+/* How long a viewer waits for the collector at startup, and between its attempts to reach it */
+#define SCANSTREAM_TIMEOUT_MS 2000
+#define SCANSTREAM_RETRY_MS 1000
+
+/* The magic, the version and the update interval of the collector, sent on connecting */
+#define SCANSTREAM_GREETING_SIZE 16
+
+enum {
+   SCANSTREAM_FRAME_KEY = 1,
+   SCANSTREAM_FRAME_DELTA = 2,
+};
+
+enum {
+   SCANSTREAM_RECORD_END = 0,
+   SCANSTREAM_RECORD_STRING = 1,
+   SCANSTREAM_RECORD_TASK = 2,
+   SCANSTREAM_RECORD_EXIT = 3,
+};
+
+/* The fields of a task in a frame, by the bit of the mask telling they changed */
+typedef enum ScanStreamField_ {
+   SCANSTREAM_TGID,
+   SCANSTREAM_PPID,
+   SCANSTREAM_PGRP,
+   SCANSTREAM_SESSION,
+   SCANSTREAM_TPGID,
+   SCANSTREAM_UID,
+   SCANSTREAM_PROCESSOR,
+   SCANSTREAM_TTY_NR,
+   SCANSTREAM_FLAGS,
+   SCANSTREAM_MINFLT,
+   SCANSTREAM_MAJFLT,
+   SCANSTREAM_UTIME,
+   SCANSTREAM_STIME,
+   SCANSTREAM_PRIORITY,
+   SCANSTREAM_NICE,
+   SCANSTREAM_NLWP,
+   SCANSTREAM_STARTTIME,
+   SCANSTREAM_M_VIRT,
+   SCANSTREAM_M_RESIDENT,
+   SCANSTREAM_M_SHARE,
+   SCANSTREAM_M_PRIV,
+   SCANSTREAM_PERCENT_CPU,             /* in hundredths, -1 if unknown */
+   SCANSTREAM_STATE,
+   SCANSTREAM_KIND,
+   SCANSTREAM_BASENAME_START,
+   SCANSTREAM_BASENAME_END,
+   SCANSTREAM_COMM,                    /* string id, 0 if empty */
+   SCANSTREAM_CMDLINE,                 /* string id, 0 if empty */
+   SCANSTREAM_FIELDS
+} ScanStreamField;
+
+typedef struct ScanStreamTask_ {
+   int64_t values[SCANSTREAM_FIELDS];
+   uint64_t frame;
+} ScanStreamTask;
+
+typedef struct ScanStreamString_ {
+   uint32_t id;
+   char str[];
+} ScanStreamString;
+
+typedef struct ScanStreamBuffer_ {
+   uint8_t* data;
+   size_t used;
+   size_t done;                        /* sent, or decoded */
+   size_t alloc;
+} ScanStreamBuffer;
+
+typedef struct ScanStreamPeer_ {
+   int fd;
+   bool synced;                        /* was sent a key frame, so deltas can follow */
+   ScanStreamBuffer out;
+} ScanStreamPeer;
+
+/* The collector, sending the same frames to all its viewers */
+typedef struct ScanStreamServer_ {
+   int fd;
+   char* socketPath;
+   uint32_t delayMs;
+   ScanStreamPeer peers[SCANSTREAM_MAX_VIEWERS];
+   size_t peerCount;
+
+   const Machine* host;
+   const SharedScanSnapshot* latest;
+
+   ScanStreamBuffer frame;
+   Hashtable* sent;                    /* ScanStreamTask by pid, as the viewers have it */
+   Hashtable* strings;                 /* ScanStreamString by hash of the string */
+   uint32_t nextStringId;
+   uint64_t frames;
+   uint64_t framesSinceKey;
+
+   /* pids that exited, collected while going through the tasks */
+   pid_t* gone;
+   size_t goneCount;
+   size_t goneAlloc;
+} ScanStreamServer;
+
+/* A viewer, rebuilding the scans of the collector from its frames */
+typedef struct ScanStreamClient_ {
+   int fd;
+   bool connecting;
+   bool greeted;
+   bool synced;
+   bool changed;
+   bool started;
+   uint32_t delayMs;
+   uint64_t attemptMs;
+   uint64_t lastFrameMs;
+
+   ScanStreamBuffer in;
+   Hashtable* tasks;                   /* ScanStreamTask by pid */
+   Hashtable* strings;                 /* char* by id */
+   SharedScanSnapshot snapshot;
+} ScanStreamClient;
+
+typedef struct ScanStreamCursor_ {
+   const uint8_t* p;
+   const uint8_t* end;
+   bool ok;
+} ScanStreamCursor;
+
+const char* ScanStream_address = NULL;
+
+static ScanStreamServer ScanStream_server = { .fd = -1 };
+static ScanStreamClient ScanStream_client = { .fd = -1 };
+
+static void ScanStream_reserve(ScanStreamBuffer* this, size_t len) {
+   if (this->used + len <= this->alloc)
+      return;
+
+   this->alloc = MAXIMUM(2 * this->alloc, this->used + len);
+   this->data = xRealloc(this->data, this->alloc);
+}
+
+static void ScanStream_putBytes(ScanStreamBuffer* this, const void* data, size_t len) {
+   ScanStream_reserve(this, len);
+   memcpy(this->data + this->used, data, len);
+   this->used += len;
+}
+
+static void ScanStream_putVarint(ScanStreamBuffer* this, uint64_t v) {
+   ScanStream_reserve(this, 10);
+   do {
+      uint8_t byte = v & 0x7f;
+      v >>= 7;
+      this->data[this->used++] = v ? (byte | 0x80) : byte;
+   } while (v);
+}
+
+static void ScanStream_putDelta(ScanStreamBuffer* this, int64_t value, int64_t previous) {
+   int64_t d = (int64_t)((uint64_t)value - (uint64_t)previous);
+   ScanStream_putVarint(this, ((uint64_t)d << 1) ^ (uint64_t)(d >> 63));
+}
+
+/* Lengths and the greeting are little endian, whatever the machines at both ends */
+static void ScanStream_storeU32(uint8_t* p, uint32_t v) {
+   for (int i = 0; i < 4; i++)
+      p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t ScanStream_loadU32(const uint8_t* p) {
+   return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t ScanStream_getVarint(ScanStreamCursor* c) {
+   uint64_t v = 0;
+   for (unsigned int shift = 0; shift < 64; shift += 7) {
+      if (c->p >= c->end) {
+         c->ok = false;
+         return 0;
+      }
+      uint8_t byte = *c->p++;
+      v |= (uint64_t)(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+         return v;
+   }
+
+   c->ok = false;
+   return 0;
+}
+
+static int64_t ScanStream_getDelta(ScanStreamCursor* c) {
+   uint64_t v = ScanStream_getVarint(c);
+   return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+/* Creates the listening socket of the collector, or starts connecting a viewer; -1 on errors */
+static int ScanStream_open(const char* addr, bool listening) {
+   if (String_startsWith(addr, "unix:")) {
+      const char* path = addr + strlen("unix:");
+      struct sockaddr_un sa;
+      memset(&sa, 0, sizeof(sa));
+      sa.sun_family = AF_UNIX;
+      if (!path[0] || strlen(path) >= sizeof(sa.sun_path)) {
+         errno = ENAMETOOLONG;
+         goto unixErr;
+      }
+      memcpy(sa.sun_path, path, strlen(path) + 1);
+
+      int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if (fd < 0)
+         goto unixErr;
+
+      if (listening) {
+         /* the socket of a collector that is gone; the shared memory segment tells a running one */
+         struct stat st;
+         if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+            unlink(path);
+
+         if (bind(fd, (const struct sockaddr*)&sa, sizeof(sa)) == 0 && listen(fd, 16) == 0) {
+            /* readable by all users, like the segment */
+            chmod(path, 0666);
+            return fd;
+         }
+      } else if (connect(fd, (const struct sockaddr*)&sa, sizeof(sa)) == 0) {
+         return fd;
+      }
+
+      int saved = errno;
+      close(fd);
+      errno = saved;
+
+unixErr:
+      if (listening)
+         fprintf(stderr, "Error: can not listen on %s: %s\n", addr, strerror(errno));
+      return -1;
+   }
+
+   char host[256] = "";
+   const char* port = addr;
+
+   const char* colon = strrchr(addr, ':');
+   if (colon) {
+      const char* start = addr;
+      size_t len = (size_t)(colon - addr);
+      /* [::1]:9100 */
+      if (len >= 2 && addr[0] == '[' && addr[len - 1] == ']') {
+         start++;
+         len -= 2;
+      }
+      String_safeStrncpy(host, start, MINIMUM(sizeof(host), len + 1));
+      port = colon + 1;
+   }
+
+   struct addrinfo hints;
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+   hints.ai_flags = listening ? AI_PASSIVE : 0;
+
+   struct addrinfo* res;
+   int err = getaddrinfo(host[0] ? host : NULL, port, &hints, &res);
+   if (err != 0) {
+      if (listening)
+         fprintf(stderr, "Error: can not listen on %s: %s\n", addr, gai_strerror(err));
+      errno = EINVAL;
+      return -1;
+   }
+
+   int fd = -1;
+   for (const struct addrinfo* ai = res; ai; ai = ai->ai_next) {
+      fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+      if (fd < 0)
+         continue;
+
+      const int one = 1;
+      if (listening) {
+         setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+         if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 16) == 0)
+            break;
+      } else {
+         /* a collector that went away without a word is noticed in the end */
+         setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+         if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0 || errno == EINPROGRESS)
+            break;
+      }
+
+      int saved = errno;
+      close(fd);
+      errno = saved;
+      fd = -1;
+   }
+   freeaddrinfo(res);
+
+   if (fd < 0 && listening)
+      fprintf(stderr, "Error: can not listen on %s: %s\n", addr, strerror(errno));
+   return fd;
+}
+
+static ht_key_t ScanStream_hash(const char* str) {
+   /* FNV-1a */
+   ht_key_t h = 2166136261U;
+   for (const char* c = str; *c; c++) {
+      h ^= (unsigned char)*c;
+      h *= 16777619U;
+   }
+   return h;
+}
+
+/* Id of a string, defined in the frame with its first use since the key frame */
+static uint32_t ScanStream_intern(ScanStreamServer* this, const char* str) {
+   if (!str[0])
+      return 0;
+
+   ht_key_t hash = ScanStream_hash(str);
+   const ScanStreamString* known = Hashtable_get(this->strings, hash);
+   if (known && String_eq(known->str, str))
+      return known->id;
+
+   /* a colliding string just takes over the hash */
+   size_t len = strlen(str);
+   ScanStreamString* interned = xMalloc(sizeof(ScanStreamString) + len + 1);
+   interned->id = this->nextStringId++;
+   memcpy(interned->str, str, len + 1);
+   Hashtable_put(this->strings, hash, interned);
+
+   ScanStream_putVarint(&this->frame, SCANSTREAM_RECORD_STRING);
+   ScanStream_putVarint(&this->frame, interned->id);
+   ScanStream_putVarint(&this->frame, len);
+   ScanStream_putBytes(&this->frame, str, len);
+   return interned->id;
+}
+
+static void ScanStream_taskValues(ScanStreamServer* this, const SharedScanTask* task, int64_t* values) {
+   values[SCANSTREAM_TGID] = task->tgid;
+   values[SCANSTREAM_PPID] = task->ppid;
+   values[SCANSTREAM_PGRP] = task->pgrp;
+   values[SCANSTREAM_SESSION] = task->session;
+   values[SCANSTREAM_TPGID] = task->tpgid;
+   values[SCANSTREAM_UID] = task->uid;
+   values[SCANSTREAM_PROCESSOR] = task->processor;
+   values[SCANSTREAM_TTY_NR] = (int64_t)task->ttyNr;
+   values[SCANSTREAM_FLAGS] = (int64_t)task->flags;
+   values[SCANSTREAM_MINFLT] = (int64_t)task->minflt;
+   values[SCANSTREAM_MAJFLT] = (int64_t)task->majflt;
+   values[SCANSTREAM_UTIME] = (int64_t)task->utime;
+   values[SCANSTREAM_STIME] = (int64_t)task->stime;
+   values[SCANSTREAM_PRIORITY] = task->priority;
+   values[SCANSTREAM_NICE] = task->nice;
+   values[SCANSTREAM_NLWP] = task->nlwp;
+   values[SCANSTREAM_STARTTIME] = task->starttime;
+   values[SCANSTREAM_M_VIRT] = task->mVirt;
+   values[SCANSTREAM_M_RESIDENT] = task->mResident;
+   values[SCANSTREAM_M_SHARE] = task->mShare;
+   values[SCANSTREAM_M_PRIV] = task->mPriv;
+   values[SCANSTREAM_PERCENT_CPU] = isNonnegative(task->percentCpu) ? (int64_t)(task->percentCpu * 100.0F + 0.5F) : -1;
+   values[SCANSTREAM_STATE] = task->state;
+   values[SCANSTREAM_KIND] = task->kind;
+   values[SCANSTREAM_BASENAME_START] = task->cmdlineBasenameStart;
+   values[SCANSTREAM_BASENAME_END] = task->cmdlineBasenameEnd;
+   values[SCANSTREAM_COMM] = ScanStream_intern(this, task->comm);
+   values[SCANSTREAM_CMDLINE] = ScanStream_intern(this, task->cmdline);
+}
+
+static void ScanStream_encodeTask(ScanStreamServer* this, const SharedScanTask* task) {
+   ScanStreamTask* known = Hashtable_get(this->sent, (ht_key_t)task->pid);
+   if (!known) {
+      known = xCalloc(1, sizeof(ScanStreamTask));
+      Hashtable_put(this->sent, (ht_key_t)task->pid, known);
+   }
+   known->frame = this->frames;
+
+   /* the string records go before the task record using them */
+   int64_t values[SCANSTREAM_FIELDS];
+   ScanStream_taskValues(this, task, values);
+
+   uint32_t mask = 0;
+   for (int i = 0; i < SCANSTREAM_FIELDS; i++) {
+      if (values[i] != known->values[i])
+         mask |= 1U << i;
+   }
+   if (!mask)
+      return;
+
+   ScanStream_putVarint(&this->frame, SCANSTREAM_RECORD_TASK);
+   ScanStream_putVarint(&this->frame, (uint64_t)task->pid);
+   ScanStream_putVarint(&this->frame, mask);
+   for (int i = 0; i < SCANSTREAM_FIELDS; i++) {
+      if (mask & (1U << i)) {
+         ScanStream_putDelta(&this->frame, values[i], known->values[i]);
+         known->values[i] = values[i];
+      }
+   }
+}
+
+static void ScanStream_collectGone(ht_key_t key, void* value, void* data) {
+   ScanStreamServer* this = data;
+   const ScanStreamTask* known = value;
+
+   if (known->frame == this->frames)
+      return;
+
+   if (this->goneCount == this->goneAlloc) {
+      this->goneAlloc = this->goneAlloc ? 2 * this->goneAlloc : 64;
+      this->gone = xReallocArray(this->gone, this->goneAlloc, sizeof(pid_t));
+   }
+   this->gone[this->goneCount++] = (pid_t)key;
+}
+
+/* Encodes the latest scan, as all tasks for a key frame or as what changed since the frame before */
+static void ScanStream_encode(ScanStreamServer* this, bool key) {
+   const SharedScanSnapshot* snap = this->latest;
+
+   if (key) {
+      Hashtable_clear(this->sent);
+      Hashtable_clear(this->strings);
+      this->nextStringId = 1;
+      this->framesSinceKey = 0;
+   } else {
+      this->framesSinceKey++;
+   }
+   this->frames++;
+
+   ScanStreamBuffer* frame = &this->frame;
+   frame->used = 0;
+   ScanStream_reserve(frame, 4);
+   frame->used = 4;
+
+   ScanStream_putVarint(frame, key ? SCANSTREAM_FRAME_KEY : SCANSTREAM_FRAME_DELTA);
+   ScanStream_putVarint(frame, snap->generation);
+   ScanStream_putVarint(frame, this->host->realtimeMs);
+   ScanStream_putVarint(frame, snap->runningTasks);
+   ScanStream_putVarint(frame, this->host->totalMem);
+
+   for (size_t i = 0; i < snap->count; i++)
+      ScanStream_encodeTask(this, &snap->tasks[i]);
+
+   this->goneCount = 0;
+   Hashtable_foreach(this->sent, ScanStream_collectGone, this);
+   for (size_t i = 0; i < this->goneCount; i++) {
+      ScanStream_putVarint(frame, SCANSTREAM_RECORD_EXIT);
+      ScanStream_putVarint(frame, (uint64_t)this->gone[i]);
+      free(Hashtable_remove(this->sent, (ht_key_t)this->gone[i]));
+   }
+
+   ScanStream_putVarint(frame, SCANSTREAM_RECORD_END);
+   ScanStream_storeU32(frame->data, (uint32_t)(frame->used - 4));
+}
+
+/* Queues the frame for the viewers that can decode it, which is all of them after a key frame */
+static void ScanStream_queue(ScanStreamServer* this, bool key) {
+   for (size_t i = 0; i < this->peerCount; i++) {
+      ScanStreamPeer* peer = &this->peers[i];
+      if (!key && !peer->synced)
+         continue;
+      ScanStream_putBytes(&peer->out, this->frame.data, this->frame.used);
+      peer->synced = true;
+   }
+}
+
+/* Sends what the socket takes; false if the viewer is gone or too far behind */
+static bool ScanStream_flush(ScanStreamPeer* peer) {
+   ScanStreamBuffer* out = &peer->out;
+
+   while (out->done < out->used) {
+      ssize_t written = send(peer->fd, out->data + out->done, out->used - out->done, MSG_NOSIGNAL);
+      if (written < 0) {
+         if (errno == EINTR)
+            continue;
+         if (errno != EAGAIN && errno != EWOULDBLOCK)
+            return false;
+         break;
+      }
+      out->done += (size_t)written;
+   }
+
+   if (out->done == out->used) {
+      out->done = 0;
+      out->used = 0;
+   } else if (out->done >= out->used / 2) {
+      memmove(out->data, out->data + out->done, out->used - out->done);
+      out->used -= out->done;
+      out->done = 0;
+   }
+
+   return out->used - out->done <= SCANSTREAM_BACKLOG_MAX;
+}
+
+static void ScanStream_drop(ScanStreamServer* this, size_t i) {
+   ScanStreamPeer* peer = &this->peers[i];
+   close(peer->fd);
+   free(peer->out.data);
+
+   this->peers[i] = this->peers[--this->peerCount];
+}
+
+static void ScanStream_flushAll(ScanStreamServer* this) {
+   for (size_t i = this->peerCount; i-- > 0;) {
+      if (!ScanStream_flush(&this->peers[i]))
+         ScanStream_drop(this, i);
+   }
+}
+
+static void ScanStream_accept(ScanStreamServer* this) {
+   int fd = accept4(this->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+   if (fd < 0)
+      return;
+
+   if (this->peerCount == SCANSTREAM_MAX_VIEWERS) {
+      close(fd);
+      return;
+   }
+
+   ScanStreamPeer* peer = &this->peers[this->peerCount++];
+   memset(peer, 0, sizeof(*peer));
+   peer->fd = fd;
+
+   uint8_t greeting[SCANSTREAM_GREETING_SIZE];
+   memcpy(greeting, SCANSTREAM_MAGIC, 8);
+   ScanStream_storeU32(greeting + 8, SCANSTREAM_VERSION);
+   ScanStream_storeU32(greeting + 12, this->delayMs);
+   ScanStream_putBytes(&peer->out, greeting, sizeof(greeting));
+
+   /* rather than waiting for the next scan, a key frame of the latest; the strings are reset for all */
+   if (this->latest) {
+      ScanStream_encode(this, true);
+      ScanStream_queue(this, true);
+   }
+
+   ScanStream_flushAll(this);
+}
+
+bool ScanStream_listen(unsigned int delayMs) {
+   ScanStreamServer* this = &ScanStream_server;
+
+   this->fd = ScanStream_open(ScanStream_address, true);
+   if (this->fd < 0)
+      return false;
+
+   if (String_startsWith(ScanStream_address, "unix:"))
+      this->socketPath = xStrdup(ScanStream_address + strlen("unix:"));
+
+   this->delayMs = delayMs;
+   this->sent = Hashtable_new(1024, true);
+   this->strings = Hashtable_new(1024, true);
+   return true;
+}
+
+void ScanStream_publish(const Machine* host, const SharedScanSnapshot* snap) {
+   ScanStreamServer* this = &ScanStream_server;
+   if (this->fd < 0)
+      return;
+
+   this->host = host;
+   this->latest = snap;
+   if (this->peerCount == 0)
+      return;
+
+   bool key = this->framesSinceKey >= SCANSTREAM_KEY_INTERVAL;
+   for (size_t i = 0; i < this->peerCount; i++)
+      key |= !this->peers[i].synced;
+
+   ScanStream_encode(this, key);
+   ScanStream_queue(this, key);
+   ScanStream_flushAll(this);
+}
+
+void ScanStream_wait(uint64_t waitMs) {
+   ScanStreamServer* this = &ScanStream_server;
+
+   uint64_t now;
+   Platform_gettime_monotonic(&now);
+   const uint64_t deadline = now + waitMs;
+
+   while (now < deadline) {
+      struct pollfd fds[SCANSTREAM_MAX_VIEWERS + 1];
+      nfds_t nfds = 0;
+      if (this->fd >= 0) {
+         fds[nfds++] = (struct pollfd) { .fd = this->fd, .events = POLLIN };
+         for (size_t i = 0; i < this->peerCount; i++) {
+            const ScanStreamPeer* peer = &this->peers[i];
+            /* viewers send nothing, reading tells when they hang up */
+            short events = POLLIN;
+            if (peer->out.done < peer->out.used)
+               events |= POLLOUT;
+            fds[nfds++] = (struct pollfd) { .fd = peer->fd, .events = events };
+         }
+      }
+
+      int ready = poll(nfds ? fds : NULL, nfds, (int)MINIMUM(deadline - now, (uint64_t)INT_MAX));
+      if (ready < 0)
+         return;
+
+      if (ready > 0) {
+         for (size_t i = this->peerCount; i-- > 0;) {
+            const short revents = fds[i + 1].revents;
+            bool gone = revents & (POLLERR | POLLNVAL);
+            if (!gone && (revents & (POLLIN | POLLHUP))) {
+               char discard[256];
+               ssize_t r = recv(this->peers[i].fd, discard, sizeof(discard), 0);
+               gone = r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+            }
+            if (!gone && (revents & POLLOUT))
+               gone = !ScanStream_flush(&this->peers[i]);
+            if (gone)
+               ScanStream_drop(this, i);
+         }
+
+         if (fds[0].revents & POLLIN)
+            ScanStream_accept(this);
+      }
+
+      Platform_gettime_monotonic(&now);
+   }
+}
+
+static void ScanStream_disconnect(ScanStreamClient* this) {
+   if (this->fd >= 0)
+      close(this->fd);
+   this->fd = -1;
+   this->connecting = false;
+   this->greeted = false;
+   this->synced = false;
+   this->in.used = 0;
+   this->in.done = 0;
+
+   if (this->tasks)
+      Hashtable_clear(this->tasks);
+   if (this->strings)
+      Hashtable_clear(this->strings);
+
+   /* nothing is shown rather than the processes of this machine */
+   this->snapshot.count = 0;
+   this->snapshot.generation = 0;
+   this->snapshot.runningTasks = 0;
+   this->snapshot.totalMem = 0;
+}
+
+/* Applies a frame to the tasks, after clearing them for a key frame; false if it is broken */
+static bool ScanStream_decode(ScanStreamClient* this, const uint8_t* data, size_t len) {
+   ScanStreamCursor c = { .p = data, .end = data + len, .ok = true };
+
+   const uint64_t kind = ScanStream_getVarint(&c);
+   if (kind == SCANSTREAM_FRAME_KEY) {
+      Hashtable_clear(this->tasks);
+      Hashtable_clear(this->strings);
+      this->synced = true;
+   } else if (kind != SCANSTREAM_FRAME_DELTA) {
+      return false;
+   } else if (!this->synced) {
+      return true;
+   }
+
+   SharedScanSnapshot* snap = &this->snapshot;
+   snap->generation = ScanStream_getVarint(&c);
+   (void) ScanStream_getVarint(&c);    /* realtimeMs */
+   snap->runningTasks = (unsigned int)ScanStream_getVarint(&c);
+   snap->totalMem = ScanStream_getVarint(&c);
+
+   for (;;) {
+      const uint64_t record = ScanStream_getVarint(&c);
+      if (!c.ok || record == SCANSTREAM_RECORD_END)
+         break;
+
+      switch (record) {
+         case SCANSTREAM_RECORD_STRING: {
+            ht_key_t id = (ht_key_t)ScanStream_getVarint(&c);
+            uint64_t strLen = ScanStream_getVarint(&c);
+            if (!c.ok || strLen > (uint64_t)(c.end - c.p))
+               return false;
+            Hashtable_put(this->strings, id, xStrndup((const char*)c.p, (size_t)strLen));
+            c.p += strLen;
+            break;
+         }
+         case SCANSTREAM_RECORD_TASK: {
+            pid_t pid = (pid_t)ScanStream_getVarint(&c);
+            uint64_t mask = ScanStream_getVarint(&c);
+            if (mask >> SCANSTREAM_FIELDS)
+               return false;
+            ScanStreamTask* task = Hashtable_get(this->tasks, (ht_key_t)pid);
+            if (!task) {
+               task = xCalloc(1, sizeof(ScanStreamTask));
+               Hashtable_put(this->tasks, (ht_key_t)pid, task);
+            }
+            for (int i = 0; i < SCANSTREAM_FIELDS; i++) {
+               if (mask & (1U << i))
+                  task->values[i] = (int64_t)((uint64_t)task->values[i] + (uint64_t)ScanStream_getDelta(&c));
+            }
+            break;
+         }
+         case SCANSTREAM_RECORD_EXIT:
+            free(Hashtable_remove(this->tasks, (ht_key_t)ScanStream_getVarint(&c)));
+            break;
+         default:
+            return false;
+      }
+   }
+
+   this->changed = true;
+   return c.ok;
+}
+
+/* Decodes the greeting and the frames received completely */
+static bool ScanStream_decodeAll(ScanStreamClient* this) {
+   ScanStreamBuffer* in = &this->in;
+
+   for (;;) {
+      const uint8_t* p = in->data + in->done;
+      const size_t avail = in->used - in->done;
+
+      if (!this->greeted) {
+         if (avail < SCANSTREAM_GREETING_SIZE)
+            break;
+         if (memcmp(p, SCANSTREAM_MAGIC, 8) != 0 || ScanStream_loadU32(p + 8) != SCANSTREAM_VERSION)
+            return false;
+         this->delayMs = ScanStream_loadU32(p + 12);
+         this->greeted = true;
+         in->done += SCANSTREAM_GREETING_SIZE;
+         Platform_gettime_monotonic(&this->lastFrameMs);
+         continue;
+      }
+
+      if (avail < 4)
+         break;
+      const uint32_t len = ScanStream_loadU32(p);
+      if (len > SCANSTREAM_FRAME_MAX)
+         return false;
+      if (avail - 4 < len)
+         break;
+
+      if (!ScanStream_decode(this, p + 4, len))
+         return false;
+      in->done += 4 + (size_t)len;
+      Platform_gettime_monotonic(&this->lastFrameMs);
+   }
+
+   memmove(in->data, in->data + in->done, in->used - in->done);
+   in->used -= in->done;
+   in->done = 0;
+   return true;
+}
+
+/* Reads what arrived, waiting until the deadline for a key frame if there was none yet; false if the connection broke */
+static bool ScanStream_receive(ScanStreamClient* this, uint64_t deadline) {
+   for (;;) {
+      if (this->connecting) {
+         struct pollfd pfd = { .fd = this->fd, .events = POLLOUT };
+         if (poll(&pfd, 1, 0) <= 0)
+            goto wait;
+
+         int err = 0;
+         socklen_t errLen = sizeof(err);
+         if (getsockopt(this->fd, SOL_SOCKET, SO_ERROR, &err, &errLen) < 0 || err != 0)
+            return false;
+         this->connecting = false;
+      }
+
+      ScanStream_reserve(&this->in, 64 * 1024);
+      ssize_t r = recv(this->fd, this->in.data + this->in.used, this->in.alloc - this->in.used, 0);
+      if (r > 0) {
+         this->in.used += (size_t)r;
+         if (!ScanStream_decodeAll(this))
+            return false;
+         continue;
+      }
+      if (r == 0)
+         return false;
+      if (errno == EINTR)
+         continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+         return false;
+
+wait:
+      if (this->synced)
+         return true;
+
+      uint64_t now;
+      Platform_gettime_monotonic(&now);
+      if (now >= deadline)
+         return true;
+
+      struct pollfd pfd = { .fd = this->fd, .events = this->connecting ? POLLOUT : POLLIN };
+      if (poll(&pfd, 1, (int)(deadline - now)) < 0 && errno != EINTR)
+         return false;
+   }
+}
+
+static void ScanStream_collectTask(ht_key_t key, void* value, void* data) {
+   ScanStreamClient* this = data;
+   SharedScanSnapshot* snap = &this->snapshot;
+   const int64_t* values = ((const ScanStreamTask*) value)->values;
+
+   if (snap->count == snap->alloc) {
+      snap->alloc = snap->alloc ? 2 * snap->alloc : 1024;
+      snap->tasks = xReallocArray(snap->tasks, snap->alloc, sizeof(SharedScanTask));
+   }
+   SharedScanTask* task = &snap->tasks[snap->count++];
+   memset(task, 0, sizeof(*task));
+
+   task->pid = (pid_t)key;
+   task->tgid = (pid_t)values[SCANSTREAM_TGID];
+   task->ppid = (pid_t)values[SCANSTREAM_PPID];
+   task->pgrp = (pid_t)values[SCANSTREAM_PGRP];
+   task->session = (pid_t)values[SCANSTREAM_SESSION];
+   task->tpgid = (pid_t)values[SCANSTREAM_TPGID];
+   task->uid = (uid_t)values[SCANSTREAM_UID];
+   task->processor = (int)values[SCANSTREAM_PROCESSOR];
+   task->ttyNr = (unsigned long int)values[SCANSTREAM_TTY_NR];
+   task->flags = (unsigned long int)values[SCANSTREAM_FLAGS];
+   task->minflt = (unsigned long int)values[SCANSTREAM_MINFLT];
+   task->majflt = (unsigned long int)values[SCANSTREAM_MAJFLT];
+   task->utime = (unsigned long long int)values[SCANSTREAM_UTIME];
+   task->stime = (unsigned long long int)values[SCANSTREAM_STIME];
+   task->priority = (long int)values[SCANSTREAM_PRIORITY];
+   task->nice = (long int)values[SCANSTREAM_NICE];
+   task->nlwp = (long int)values[SCANSTREAM_NLWP];
+   task->starttime = (time_t)values[SCANSTREAM_STARTTIME];
+   task->mVirt = (long int)values[SCANSTREAM_M_VIRT];
+   task->mResident = (long int)values[SCANSTREAM_M_RESIDENT];
+   task->mShare = (long int)values[SCANSTREAM_M_SHARE];
+   task->mPriv = (long int)values[SCANSTREAM_M_PRIV];
+   task->percentCpu = values[SCANSTREAM_PERCENT_CPU] >= 0 ? (float)values[SCANSTREAM_PERCENT_CPU] / 100.0F : NAN;
+   task->state = (int)values[SCANSTREAM_STATE];
+   task->kind = (unsigned int)values[SCANSTREAM_KIND];
+   task->cmdlineBasenameStart = (int)values[SCANSTREAM_BASENAME_START];
+   task->cmdlineBasenameEnd = (int)values[SCANSTREAM_BASENAME_END];
+
+   const char* comm = Hashtable_get(this->strings, (ht_key_t)values[SCANSTREAM_COMM]);
+   if (comm)
+      String_safeStrncpy(task->comm, comm, sizeof(task->comm));
+   const char* cmdline = Hashtable_get(this->strings, (ht_key_t)values[SCANSTREAM_CMDLINE]);
+   if (cmdline)
+      String_safeStrncpy(task->cmdline, cmdline, sizeof(task->cmdline));
+}
+
+const SharedScanSnapshot* ScanStream_read(void) {
+   ScanStreamClient* this = &ScanStream_client;
+
+   if (!this->tasks) {
+      this->tasks = Hashtable_new(1024, true);
+      this->strings = Hashtable_new(1024, true);
+   }
+
+   uint64_t now;
+   Platform_gettime_monotonic(&now);
+
+   if (this->fd < 0) {
+      if (this->started && now < this->attemptMs + SCANSTREAM_RETRY_MS)
+         return &this->snapshot;
+
+      this->attemptMs = now;
+      this->fd = ScanStream_open(ScanStream_address, false);
+      if (this->fd < 0) {
+         this->started = true;
+         return &this->snapshot;
+      }
+      this->connecting = true;
+      this->lastFrameMs = now;
+   }
+
+   /* only the first screen waits for the collector, later ones show what arrived */
+   const uint64_t deadline = this->started ? now : now + SCANSTREAM_TIMEOUT_MS;
+   this->started = true;
+
+   if (!ScanStream_receive(this, deadline)) {
+      ScanStream_disconnect(this);
+      return &this->snapshot;
+   }
+
+   /* a collector that exited or hangs is left for a restarted one */
+   const uint64_t maxAgeMs = 3 * (uint64_t)this->delayMs + SCANSTREAM_TIMEOUT_MS;
+   Platform_gettime_monotonic(&now);
+   if (now > this->lastFrameMs + maxAgeMs) {
+      ScanStream_disconnect(this);
+      return &this->snapshot;
+   }
+
+   if (this->changed) {
+      this->snapshot.count = 0;
+      Hashtable_foreach(this->tasks, ScanStream_collectTask, this);
+      this->changed = false;
+   }
+
+   return &this->snapshot;
+}
+
+void ScanStream_done(void) {
+   ScanStreamServer* server = &ScanStream_server;
+   if (server->fd >= 0) {
+      while (server->peerCount > 0)
+         ScanStream_drop(server, server->peerCount - 1);
+      close(server->fd);
+      if (server->socketPath)
+         unlink(server->socketPath);
+   }
+   free(server->socketPath);
+   free(server->frame.data);
+   free(server->gone);
+   if (server->sent)
+      Hashtable_delete(server->sent);
+   if (server->strings)
+      Hashtable_delete(server->strings);
+   memset(server, 0, sizeof(*server));
+   server->fd = -1;
+
+   ScanStreamClient* client = &ScanStream_client;
+   ScanStream_disconnect(client);
+   free(client->in.data);
+   free(client->snapshot.tasks);
+   if (client->tasks)
+      Hashtable_delete(client->tasks);
+   if (client->strings)
+      Hashtable_delete(client->strings);
+   memset(client, 0, sizeof(*client));
+   client->fd = -1;
+}
@@ -0,0 +1,42 @@
+#ifndef HEADER_ScanStream
+#define HEADER_ScanStream
+/*
+htop - linux/ScanStream.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Machine.h"
+#include "linux/SharedScan.h"
+
+
+/*
+ * The scans of `htop --serve=ADDR` streamed over a TCP or Unix socket to
+ * `htop --attach=ADDR` viewers on other machines. ADDR is [HOST:]PORT or
+ * unix:PATH. After a key frame with all tasks, each frame only carries
+ * the changed fields of changed tasks, the tasks started and exited, and
+ * the strings first used since the key frame.
+ */
+
+/* Address of --serve=ADDR or --attach=ADDR, NULL for the shared memory segment only */
+extern const char* ScanStream_address;
+
+/* Listens on ScanStream_address for viewers; false if it can not */
+bool ScanStream_listen(unsigned int delayMs);
+
+/* Sends the scan just published to the viewers connected */
+void ScanStream_publish(const Machine* host, const SharedScanSnapshot* snap);
+
+/* Accepts viewers and sends them what is pending for up to waitMs, or until a signal arrives */
+void ScanStream_wait(uint64_t waitMs);
+
+/* The latest scan received from the collector at ScanStream_address; empty while not connected */
+const SharedScanSnapshot* ScanStream_read(void);
+
+void ScanStream_done(void);
+
+#endif
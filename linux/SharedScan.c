@@ -0,0 +1,452 @@
+/*
+htop - linux/SharedScan.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/SharedScan.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "CRT.h"
+#include "Macros.h"
+#include "Process.h"
+#include "Row.h"
+#include "Settings.h"
+#include "Table.h"
+#include "Vector.h"
+#include "XUtils.h"
+#include "linux/FsRoot.h"
+#include "linux/LinuxMachine.h"
+#include "linux/LinuxProcess.h"
+#include "linux/Platform.h"
+#include "linux/ScanStream.h"
+
+
+#define SHARED_SCAN_MAGIC "htopscan"
+
+/* Bumped with every change of the segment layout */
+#define SHARED_SCAN_VERSION 1
+
+#define SHARED_SCAN_INITIAL_TASKS 1024
+
+/* Tries to copy a snapshot while the collector keeps overwriting it */
+#define SHARED_SCAN_READ_ATTEMPTS 16
+
+/*
+ * Start of the segment, followed by the tasks. The collector writes a
+ * scan between two increments of seq, so it is odd while the snapshot
+ * is inconsistent; readers retry until seq is even and unchanged over
+ * their copy (a seqlock). The segment only ever grows.
+ */
+typedef struct SharedScanHeader_ {
+   char magic[8];
+   uint32_t version;
+   uint32_t taskSize;
+   pid_t collector;
+   uint32_t delayMs;
+   uint64_t size;
+   uint32_t seq;
+   uint32_t runningTasks;
+   uint64_t generation;
+   uint64_t realtimeMs;
+   uint64_t count;
+} SharedScanHeader;
+
+SharedScanMode SharedScan_mode = SHARED_SCAN_OFF;
+
+static int SharedScan_fd = -1;
+static SharedScanHeader* SharedScan_segment = NULL;
+static size_t SharedScan_mapped = 0;
+static SharedScanSnapshot SharedScan_snapshot;
+
+static volatile sig_atomic_t SharedScan_stop = 0;
+
+static void SharedScan_unmap(void) {
+   if (SharedScan_segment)
+      munmap(SharedScan_segment, SharedScan_mapped);
+   if (SharedScan_fd >= 0)
+      close(SharedScan_fd);
+
+   SharedScan_segment = NULL;
+   SharedScan_mapped = 0;
+   SharedScan_fd = -1;
+}
+
+static bool SharedScan_map(size_t size, bool writable) {
+   void* addr = mmap(NULL, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, SharedScan_fd, 0);
+   if (addr == MAP_FAILED)
+      return false;
+
+   if (SharedScan_segment)
+      munmap(SharedScan_segment, SharedScan_mapped);
+
+   SharedScan_segment = addr;
+   SharedScan_mapped = size;
+   return true;
+}
+
+static size_t SharedScan_sizeFor(uint64_t count) {
+   return sizeof(SharedScanHeader) + (size_t)count * sizeof(SharedScanTask);
+}
+
+/* A collector whose process is gone left its segment behind by crashing */
+static bool SharedScan_isAlive(pid_t pid) {
+   return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+/* With hidepid, /proc hides processes of other users; a root collector must not publish them */
+static bool SharedScan_procHidesPids(void) {
+   FILE* fp = FsRoot_fopen(&FsRoot_proc, "self/mounts", "r");
+   if (!fp)
+      return true;
+
+   bool hides = false;
+   char line[1024];
+   while (!hides && fgets(line, sizeof(line), fp)) {
+      char type[32];
+      char options[512];
+      if (sscanf(line, "%*s %*s %31s %511s", type, options) != 2 || !String_eq(type, "proc"))
+         continue;
+
+      const char* hidepid = strstr(options, "hidepid=");
+      if (hidepid) {
+         hidepid += strlen("hidepid=");
+         hides = !(String_startsWith(hidepid, "0") || String_startsWith(hidepid, "off"));
+      }
+   }
+   fclose(fp);
+
+   return hides;
+}
+
+static bool SharedScan_create(const Settings* settings) {
+   for (int attempt = 0; attempt < 2; attempt++) {
+      SharedScan_fd = shm_open(SHARED_SCAN_NAME, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+      if (SharedScan_fd >= 0)
+         break;
+      if (errno != EEXIST)
+         goto err;
+
+      /* take over the segment of a collector that died */
+      int fd = shm_open(SHARED_SCAN_NAME, O_RDONLY | O_CLOEXEC, 0);
+      if (fd >= 0) {
+         SharedScanHeader header;
+         ssize_t r = pread(fd, &header, sizeof(header), 0);
+         close(fd);
+         if (r == (ssize_t)sizeof(header) && SharedScan_isAlive(header.collector)) {
+            fprintf(stderr, "Error: a collector is already running as process %d.\n", (int)header.collector);
+            return false;
+         }
+      }
+      shm_unlink(SHARED_SCAN_NAME);
+   }
+   if (SharedScan_fd < 0)
+      goto err;
+
+   /* the umask could have taken the read permission of other users */
+   fchmod(SharedScan_fd, 0644);
+
+   const size_t size = SharedScan_sizeFor(SHARED_SCAN_INITIAL_TASKS);
+   if (ftruncate(SharedScan_fd, (off_t)size) < 0 || !SharedScan_map(size, true)) {
+      int saved = errno;
+      SharedScan_unmap();
+      shm_unlink(SHARED_SCAN_NAME);
+      errno = saved;
+      goto err;
+   }
+
+   SharedScanHeader* header = SharedScan_segment;
+   memcpy(header->magic, SHARED_SCAN_MAGIC, sizeof(header->magic));
+   header->version = SHARED_SCAN_VERSION;
+   header->taskSize = sizeof(SharedScanTask);
+   header->collector = getpid();
+   header->delayMs = 100 * (uint32_t)settings->delay;
+   header->size = size;
+   return true;
+
+err:
+   fprintf(stderr, "Error: can not create the shared memory segment %s: %s\n", SHARED_SCAN_NAME, strerror(errno));
+   return false;
+}
+
+static bool SharedScan_grow(uint64_t count) {
+   const size_t size = SharedScan_sizeFor(count);
+   if (size <= SharedScan_mapped)
+      return true;
+
+   size_t newSize = SharedScan_mapped;
+   while (newSize < size)
+      newSize = sizeof(SharedScanHeader) + 2 * (newSize - sizeof(SharedScanHeader));
+
+   if (ftruncate(SharedScan_fd, (off_t)newSize) < 0 || !SharedScan_map(newSize, true))
+      return false;
+
+   __atomic_store_n(&SharedScan_segment->size, (uint64_t)newSize, __ATOMIC_RELEASE);
+   return true;
+}
+
+static void SharedScan_fillTask(SharedScanTask* task, const Process* proc) {
+   const LinuxProcess* lp = (const LinuxProcess*) proc;
+
+   memset(task, 0, sizeof(*task));
+   task->pid = Process_getPid(proc);
+   task->tgid = Process_getThreadGroup(proc);
+   task->ppid = Process_getParent(proc);
+   task->pgrp = proc->pgrp;
+   task->session = proc->session;
+   task->tpgid = proc->tpgid;
+   task->uid = proc->st_uid;
+   task->processor = proc->processor;
+   task->ttyNr = proc->tty_nr;
+   task->flags = lp->flags;
+   task->minflt = proc->minflt;
+   task->majflt = proc->majflt;
+   task->utime = lp->utime;
+   task->stime = lp->stime;
+   task->priority = proc->priority;
+   task->nice = proc->nice;
+   task->nlwp = proc->nlwp;
+   task->starttime = proc->starttime_ctime;
+   task->mVirt = proc->m_virt;
+   task->mResident = proc->m_resident;
+   task->mShare = lp->m_share;
+   task->mPriv = lp->m_priv;
+   task->percentCpu = proc->percent_cpu;
+   task->state = proc->state;
+
+   if (proc->isKernelThread)
+      task->kind |= SHARED_SCAN_KERNEL_THREAD;
+   if (proc->isUserlandThread)
+      task->kind |= SHARED_SCAN_USERLAND_THREAD;
+   if (proc->isRunningInContainer)
+      task->kind |= SHARED_SCAN_CONTAINER;
+
+   if (proc->procComm)
+      String_safeStrncpy(task->comm, proc->procComm, sizeof(task->comm));
+
+   if (proc->cmdline && !proc->isKernelThread) {
+      size_t len = String_safeStrncpy(task->cmdline, proc->cmdline, sizeof(task->cmdline));
+      int end = MINIMUM(proc->cmdlineBasenameEnd, (int)len);
+      int start = proc->cmdlineBasenameStart;
+      if (start >= end) {
+         /* the basename was cut off */
+         start = 0;
+         end = (int)len;
+      }
+      task->cmdlineBasenameStart = len ? start : 0;
+      task->cmdlineBasenameEnd = len ? end : 0;
+   }
+}
+
+static void SharedScan_publish(const Machine* host) {
+   const LinuxMachine* lhost = (const LinuxMachine*) host;
+   const Vector* rows = host->processTable->rows;
+   SharedScanSnapshot* snap = &SharedScan_snapshot;
+
+   /* prepared aside, to keep the time readers have to retry short */
+   size_t count = (size_t)Vector_size(rows);
+   if (count > snap->alloc) {
+      snap->alloc = count + count / 4;
+      snap->tasks = xReallocArray(snap->tasks, snap->alloc, sizeof(SharedScanTask));
+   }
+   snap->count = 0;
+   for (int i = 0; i < Vector_size(rows); i++) {
+      const Row* row = (const Row*) Vector_get(rows, i);
+      if (row->tombStampMs > 0)
+         continue;
+      SharedScan_fillTask(&snap->tasks[snap->count++], (const Process*) row);
+   }
+
+   snap->runningTasks = lhost->runningTasks;
+   snap->generation++;
+
+   /* streamed even if the segment can not take it */
+   ScanStream_publish(host, snap);
+
+   if (!SharedScan_grow(snap->count))
+      return;
+
+   SharedScanHeader* header = SharedScan_segment;
+   const uint32_t seq = header->seq;
+
+   __atomic_store_n(&header->seq, seq + 1, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+
+   header->runningTasks = snap->runningTasks;
+   header->generation = snap->generation;
+   header->realtimeMs = host->realtimeMs;
+   header->count = snap->count;
+   memcpy(header + 1, snap->tasks, snap->count * sizeof(SharedScanTask));
+
+   __atomic_store_n(&header->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+static void SharedScan_handleSignal(ATTR_UNUSED int sgn) {
+   SharedScan_stop = 1;
+}
+
+bool SharedScan_serve(Machine* host) {
+   Settings* settings = host->settings;
+
+   if (geteuid() == 0 && SharedScan_procHidesPids()) {
+      fprintf(stderr, "Error: /proc hides the processes of other users, refusing to publish them.\n");
+      return false;
+   }
+
+   if (!SharedScan_create(settings))
+      return false;
+
+   if (ScanStream_address && !ScanStream_listen(100 * (uint32_t)settings->delay)) {
+      SharedScan_unmap();
+      shm_unlink(SHARED_SCAN_NAME);
+      return false;
+   }
+
+   /* viewers filter and display for themselves, so scan everything but the expensive columns */
+   settings->hideKernelThreads = false;
+   settings->hideUserlandThreads = false;
+   settings->showThreadNames = false;
+   settings->highlightChanges = false;
+   settings->lazyCollection = false;
+   settings->ss->flags = 0;
+   CRT_initHeadless();
+
+   struct sigaction act;
+   memset(&act, 0, sizeof(act));
+   act.sa_handler = SharedScan_handleSignal;
+   sigemptyset(&act.sa_mask);
+   sigaction(SIGINT, &act, NULL);
+   sigaction(SIGTERM, &act, NULL);
+   sigaction(SIGHUP, &act, NULL);
+
+   const uint64_t interval = MAXIMUM(100 * (uint64_t)settings->delay, 100);
+
+   while (!SharedScan_stop) {
+      Platform_gettime_realtime(&host->realtime, &host->realtimeMs);
+      Machine_scan(host);
+      Machine_scanTables(host);
+      SharedScan_publish(host);
+
+      uint64_t now;
+      Platform_gettime_monotonic(&now);
+      const uint64_t next = host->monotonicMs + interval;
+      /* viewers on other machines are served in between */
+      if (next > now)
+         ScanStream_wait(next - now);
+   }
+
+   SharedScan_unmap();
+   shm_unlink(SHARED_SCAN_NAME);
+   SharedScan_done();
+   return true;
+}
+
+/* Opens the segment if it was published by root or by this user and is of this build */
+static bool SharedScan_attach(void) {
+   SharedScan_fd = shm_open(SHARED_SCAN_NAME, O_RDONLY | O_CLOEXEC, 0);
+   if (SharedScan_fd < 0)
+      return false;
+
+   struct stat st;
+   if (fstat(SharedScan_fd, &st) < 0 ||
+       (st.st_uid != 0 && st.st_uid != geteuid()) ||
+       (size_t)st.st_size < sizeof(SharedScanHeader) ||
+       !SharedScan_map((size_t)st.st_size, false)) {
+      SharedScan_unmap();
+      return false;
+   }
+
+   const SharedScanHeader* header = SharedScan_segment;
+   if (memcmp(header->magic, SHARED_SCAN_MAGIC, sizeof(header->magic)) != 0 ||
+       header->version != SHARED_SCAN_VERSION ||
+       header->taskSize != sizeof(SharedScanTask)) {
+      SharedScan_unmap();
+      return false;
+   }
+
+   return true;
+}
+
+/* Copies the tasks between two equal, even values of seq */
+static bool SharedScan_copy(SharedScanSnapshot* snap) {
+   for (int attempt = 0; attempt < SHARED_SCAN_READ_ATTEMPTS; attempt++) {
+      const SharedScanHeader* header = SharedScan_segment;
+      const uint32_t seq = __atomic_load_n(&header->seq, __ATOMIC_ACQUIRE);
+      if (seq & 1) {
+         sched_yield();
+         continue;
+      }
+
+      const uint64_t count = __atomic_load_n(&header->count, __ATOMIC_RELAXED);
+      const size_t size = SharedScan_sizeFor(count);
+      if (size > SharedScan_mapped) {
+         /* the collector grew the segment */
+         const uint64_t segmentSize = __atomic_load_n(&header->size, __ATOMIC_ACQUIRE);
+         if (segmentSize < size || !SharedScan_map((size_t)segmentSize, false))
+            return false;
+         continue;
+      }
+
+      if (count > snap->alloc) {
+         snap->alloc = (size_t)count + (size_t)count / 4;
+         snap->tasks = xReallocArray(snap->tasks, snap->alloc, sizeof(SharedScanTask));
+      }
+      memcpy(snap->tasks, header + 1, (size_t)count * sizeof(SharedScanTask));
+      snap->count = (size_t)count;
+      snap->runningTasks = __atomic_load_n(&header->runningTasks, __ATOMIC_RELAXED);
+      snap->generation = __atomic_load_n(&header->generation, __ATOMIC_RELAXED);
+
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&header->seq, __ATOMIC_RELAXED) == seq)
+         return true;
+   }
+
+   return false;
+}
+
+const SharedScanSnapshot* SharedScan_read(void) {
+   if (ScanStream_address)
+      return ScanStream_read();
+
+   if (!SharedScan_segment && !SharedScan_attach())
+      return NULL;
+
+   const SharedScanHeader* header = SharedScan_segment;
+
+   /* a collector that exited or hangs is left for a restarted one */
+   const uint64_t maxAgeMs = 3 * (uint64_t)header->delayMs + 2000;
+   uint64_t realtimeMs;
+   struct timeval tv;
+   Platform_gettime_realtime(&tv, &realtimeMs);
+   const uint64_t publishedMs = __atomic_load_n(&header->realtimeMs, __ATOMIC_RELAXED);
+   if (!SharedScan_isAlive(header->collector) || (publishedMs && realtimeMs > publishedMs + maxAgeMs)) {
+      SharedScan_unmap();
+      return NULL;
+   }
+
+   if (!SharedScan_copy(&SharedScan_snapshot) || SharedScan_snapshot.generation == 0)
+      return NULL;
+
+   return &SharedScan_snapshot;
+}
+
+void SharedScan_done(void) {
+   SharedScan_unmap();
+   ScanStream_done();
+
+   free(SharedScan_snapshot.tasks);
+   memset(&SharedScan_snapshot, 0, sizeof(SharedScan_snapshot));
+}
@@ -0,0 +1,90 @@
+#ifndef HEADER_SharedScan
+#define HEADER_SharedScan
+/*
+htop - linux/SharedScan.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+
+#include "Machine.h"
+
+
+/* Name of the shared memory segment published by `htop --serve` */
+#ifndef SHARED_SCAN_NAME
+#define SHARED_SCAN_NAME "/htop-scan"
+#endif
+
+/* Longest command line carried in a snapshot, longer ones are cut */
+#define SHARED_SCAN_CMDLINE_LEN 512
+
+typedef enum SharedScanMode_ {
+   SHARED_SCAN_OFF,
+   SHARED_SCAN_SERVE,
+   SHARED_SCAN_ATTACH,
+} SharedScanMode;
+
+#define SHARED_SCAN_KERNEL_THREAD   0x01
+#define SHARED_SCAN_USERLAND_THREAD 0x02
+#define SHARED_SCAN_CONTAINER       0x04
+
+/* One process or thread of a snapshot, as scanned by the collector */
+typedef struct SharedScanTask_ {
+   pid_t pid;
+   pid_t tgid;
+   pid_t ppid;
+   pid_t pgrp;
+   pid_t session;
+   pid_t tpgid;
+   uid_t uid;
+   int processor;
+   unsigned long int ttyNr;
+   unsigned long int flags;
+   unsigned long int minflt;
+   unsigned long int majflt;
+   unsigned long long int utime;
+   unsigned long long int stime;
+   long int priority;
+   long int nice;
+   long int nlwp;
+   time_t starttime;
+   long int mVirt;
+   long int mResident;
+   long int mShare;
+   long int mPriv;
+   float percentCpu;
+   int state;                          /* ProcessState */
+   unsigned int kind;                  /* SHARED_SCAN_* bits */
+   int cmdlineBasenameStart;
+   int cmdlineBasenameEnd;
+   char comm[16];
+   char cmdline[SHARED_SCAN_CMDLINE_LEN];   /* empty for kernel threads */
+} SharedScanTask;
+
+/* A private copy of the latest published scan */
+typedef struct SharedScanSnapshot_ {
+   uint64_t generation;
+   unsigned int runningTasks;
+   memory_t totalMem;                  /* of the collector streaming it, 0 for this machine */
+   SharedScanTask* tasks;
+   size_t count;
+   size_t alloc;
+} SharedScanSnapshot;
+
+extern SharedScanMode SharedScan_mode;
+
+/* Scans at the configured delay and publishes every scan until SIGINT or SIGTERM; false if it can not serve */
+bool SharedScan_serve(Machine* host);
+
+/* Copies the latest scan of a live collector; NULL without one, so /proc is scanned locally, unless it is streamed from another machine */
+const SharedScanSnapshot* SharedScan_read(void);
+
+void SharedScan_done(void);
+
+#endif
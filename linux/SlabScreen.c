@@ -0,0 +1,378 @@
+/*
+htop - linux/SlabScreen.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/SlabScreen.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/time.h>
+
+#include "CRT.h"
+#include "FunctionBar.h"
+#include "LineStore.h"
+#include "Macros.h"
+#include "Meter.h"
+#include "Panel.h"
+#include "Platform.h"
+#include "ProvideCurses.h"
+#include "Settings.h"
+#include "XUtils.h"
+
+#include "linux/LinuxMachine.h"
+
+
+static const char* const SlabScreenFunctions[] = {"Search ", "Filter ", "Refresh", "SortBy ", "Done   ", NULL};
+
+static const char* const SlabScreenKeys[] = {"F3", "F4", "F5", "F6", "Esc"};
+
+static const int SlabScreenEvents[] = {KEY_F(3), KEY_F(4), KEY_F(5), KEY_F(6), 27};
+
+#define SLABSCREEN_HEADER "  OBJECTS    ACTIVE  USE  OBJ SIZE      SIZE   GROWTH/s  NAME"
+
+struct SlabCache_ {
+   char name[64];
+   unsigned long long objects;
+   unsigned long long active;
+   unsigned long long objSize;    /* bytes */
+   unsigned long long sizeKB;     /* of the slabs holding the objects */
+   double growth;                 /* KiB per second since the last read, NAN for a cache new to it */
+   unsigned int generation;
+   bool changed;                  /* the line differs from the one last shown */
+   char line[160];
+};
+
+SlabScreen* SlabScreen_new(const Machine* host) {
+   const LinuxMachine* lhost = (const LinuxMachine*) host;
+
+   SlabScreen* this = xCalloc(1, sizeof(SlabScreen));
+   Object_setClass(this, Class(SlabScreen));
+   FunctionBar* fuBar = FunctionBar_new(SlabScreenFunctions, SlabScreenKeys, SlabScreenEvents);
+   CRT_disableDelay();
+   InfoScreen_init(&this->super, NULL, fuBar, LINES - 2, SLABSCREEN_HEADER);
+
+   this->pageSizeKB = (unsigned int) lhost->pageSizeKB;
+   this->intervalMs = (unsigned int) MAXIMUM(host->settings->delay, 1) * 100;
+   return this;
+}
+
+void SlabScreen_delete(Object* cast) {
+   SlabScreen* this = (SlabScreen*) cast;
+   for (size_t i = 0; i < this->count; i++)
+      free(this->byName[i]);
+   free(this->byName);
+   free(this->order);
+   free(this->listed);
+   CRT_enableDelay();
+   free(InfoScreen_done((InfoScreen*)this));
+}
+
+static void SlabScreen_draw(InfoScreen* super) {
+   const SlabScreen* this = (const SlabScreen*) super;
+   InfoScreen_drawTitled(super, "Kernel slab caches, sorted by %s, every %.1fs",
+                         this->sortKey == SLAB_SORT_GROWTH ? "growth" : "size", this->intervalMs / 1000.0);
+}
+
+static int SlabScreen_compareNames(const void* v1, const void* v2) {
+   const SlabCache* a = *(const SlabCache* const*)v1;
+   const SlabCache* b = *(const SlabCache* const*)v2;
+   return strcmp(a->name, b->name);
+}
+
+static int SlabScreen_compare(const SlabScreen* this, const SlabCache* a, const SlabCache* b) {
+   if (this->sortKey == SLAB_SORT_GROWTH) {
+      if (isnan(a->growth) != isnan(b->growth))
+         return isnan(a->growth) ? 1 : -1;
+      if (!isnan(a->growth) && isgreater(a->growth, b->growth))
+         return -1;
+      if (!isnan(a->growth) && isless(a->growth, b->growth))
+         return 1;
+   }
+   if (a->sizeKB != b->sizeKB)
+      return SPACESHIP_NUMBER(b->sizeKB, a->sizeKB);
+
+   return strcmp(a->name, b->name);
+}
+
+/* The order of the last read is mostly still right, so insertion sort moves the few caches that changed */
+static void SlabScreen_sort(SlabScreen* this) {
+   for (size_t i = 1; i < this->count; i++) {
+      SlabCache* cache = this->order[i];
+      size_t j = i;
+      while (j > 0 && SlabScreen_compare(this, this->order[j - 1], cache) > 0) {
+         this->order[j] = this->order[j - 1];
+         j--;
+      }
+      this->order[j] = cache;
+   }
+}
+
+static SlabCache* SlabScreen_find(const SlabScreen* this, size_t sorted, const char* name) {
+   size_t lo = 0;
+   size_t hi = sorted;
+   while (lo < hi) {
+      const size_t mid = lo + (hi - lo) / 2;
+      const int cmp = strcmp(this->byName[mid]->name, name);
+      if (cmp == 0)
+         return this->byName[mid];
+      if (cmp < 0) {
+         lo = mid + 1;
+      } else {
+         hi = mid;
+      }
+   }
+   return NULL;
+}
+
+static SlabCache* SlabScreen_add(SlabScreen* this, const char* name) {
+   if (this->count == this->alloc) {
+      this->alloc = this->alloc ? this->alloc * 2 : 256;
+      this->byName = xReallocArray(this->byName, this->alloc, sizeof(SlabCache*));
+      this->order = xReallocArray(this->order, this->alloc, sizeof(SlabCache*));
+   }
+
+   SlabCache* cache = xCalloc(1, sizeof(SlabCache));
+   size_t len = strnlen(name, sizeof(cache->name) - 1);
+   memcpy(cache->name, name, len);
+   cache->growth = NAN;
+   this->byName[this->count] = cache;
+   this->order[this->count] = cache;
+   this->count++;
+   return cache;
+}
+
+/* Drops the caches the last read did not list, the lines still showing them are repainted */
+static void SlabScreen_dropGone(SlabScreen* this) {
+   size_t kept = 0;
+   for (size_t i = 0; i < this->count; i++) {
+      SlabCache* cache = this->byName[i];
+      if (cache->generation == this->generation) {
+         this->byName[kept++] = cache;
+         continue;
+      }
+
+      for (size_t l = 0; l < this->listedCount; l++) {
+         if (this->listed[l] == cache)
+            this->listed[l] = NULL;
+      }
+      free(cache);
+   }
+
+   size_t ordered = 0;
+   for (size_t i = 0; i < this->count; i++) {
+      if (this->order[i]->generation == this->generation)
+         this->order[ordered++] = this->order[i];
+   }
+
+   assert(ordered == kept);
+   this->count = kept;
+}
+
+static void SlabScreen_format(SlabCache* cache) {
+   char size[16];
+   Meter_humanUnit(size, (double)cache->sizeKB, sizeof(size));
+
+   char growth[16];
+   if (isnan(cache->growth)) {
+      xSnprintf(growth, sizeof(growth), "-");
+   } else if (fabs(cache->growth) < 0.5) {
+      xSnprintf(growth, sizeof(growth), "0");
+   } else {
+      growth[0] = cache->growth > 0.0 ? '+' : '-';
+      Meter_humanUnit(growth + 1, fabs(cache->growth), sizeof(growth) - 1);
+   }
+
+   const double use = cache->objects ? 100.0 * (double)cache->active / (double)cache->objects : 0.0;
+
+   char line[sizeof(cache->line)];
+   xSnprintf(line, sizeof(line), "%9llu %9llu %3.0f%% %8.2fK %9s %10s  %s",
+             cache->objects, cache->active, use, (double)cache->objSize / 1024.0, size, growth, cache->name);
+
+   if (!String_eq(line, cache->line)) {
+      memcpy(cache->line, line, sizeof(line));
+      cache->changed = true;
+   }
+}
+
+static void SlabScreen_read(SlabScreen* this) {
+   char* content = FsRoot_readKept(&FsRoot_proc, &this->file, "slabinfo", NULL);
+   if (!content) {
+      this->error = errno ? errno : EIO;
+      return;
+   }
+   this->error = 0;
+
+   uint64_t now;
+   Platform_gettime_monotonic(&now);
+   const double seconds = this->readMs && now > this->readMs ? (double)(now - this->readMs) / 1000.0 : NAN;
+   this->readMs = now;
+   this->generation++;
+
+   /* caches new to this read are added behind the ones sorted by name */
+   const size_t sorted = this->count;
+
+   for (char* line = content, *next; line && *line; line = next) {
+      next = strchr(line, '\n');
+      if (next)
+         *next++ = '\0';
+
+      /* "dentry  402164 402822  192  21  1 : tunables  0  0  0 : slabdata  19182  19182  0" */
+      char name[64];
+      unsigned long long active, objects, objSize, perSlab, pagesPerSlab, activeSlabs, slabs;
+      if (line[0] == '#' || String_startsWith(line, "slabinfo"))
+         continue;
+      if (sscanf(line, "%63s %llu %llu %llu %llu %llu", name, &active, &objects, &objSize, &perSlab, &pagesPerSlab) != 6)
+         continue;
+      const char* slabdata = strstr(line, ": slabdata");
+      if (!slabdata || sscanf(slabdata, ": slabdata %llu %llu", &activeSlabs, &slabs) != 2)
+         continue;
+
+      SlabCache* cache = SlabScreen_find(this, sorted, name);
+      const unsigned long long sizeKB = slabs * pagesPerSlab * this->pageSizeKB;
+      if (!cache) {
+         cache = SlabScreen_add(this, name);
+      } else {
+         cache->growth = isnan(seconds) ? NAN : ((double)sizeKB - (double)cache->sizeKB) / seconds;
+      }
+
+      cache->objects = objects;
+      cache->active = active;
+      cache->objSize = objSize;
+      cache->sizeKB = sizeKB;
+      cache->generation = this->generation;
+      SlabScreen_format(cache);
+   }
+
+   SlabScreen_dropGone(this);
+   if (this->count > sorted)
+      qsort(this->byName, this->count, sizeof(SlabCache*), SlabScreen_compareNames);
+   SlabScreen_sort(this);
+}
+
+/*
+ * Lists the caches in display order again. Only the lines now showing a
+ * different cache, or one whose numbers changed, are repainted; the
+ * selection and scroll position stay.
+ */
+static void SlabScreen_show(SlabScreen* this) {
+   InfoScreen* super = &this->super;
+   Panel* panel = super->display;
+   LineStore* lines = super->lines;
+
+   /* the caches shown before, through the filter as it is now */
+   const int shownBefore = this->listedCount == (size_t) LineStore_size(lines) ? LineStore_shownCount(lines) : 0;
+   const SlabCache** before = xMallocArray((size_t) MAXIMUM(shownBefore, 1), sizeof(SlabCache*));
+   for (int i = 0; i < shownBefore; i++)
+      before[i] = this->listed[LineStore_shownLine(lines, i)];
+
+   LineStore_clear(lines);
+
+   if (this->error) {
+      char line[256];
+      xSnprintf(line, sizeof(line), "Could not read /proc/slabinfo: %s", strerror(this->error));
+      InfoScreen_addLine(super, line);
+      if (this->error == EACCES || this->error == EPERM)
+         InfoScreen_addLine(super, "It is only readable by root.");
+      this->listedCount = 0;
+      panel->needsRedraw = true;
+      free(before);
+      return;
+   }
+
+   free(this->listed);
+   this->listed = xMallocArray(MAXIMUM(this->count, 1), sizeof(SlabCache*));
+   for (size_t i = 0; i < this->count; i++) {
+      InfoScreen_addLine(super, this->order[i]->line);
+      this->listed[i] = this->order[i];
+   }
+   this->listedCount = this->count;
+
+   const int shown = LineStore_shownCount(lines);
+   if (shown != shownBefore)
+      panel->needsRedraw = true;
+
+   for (int i = 0; i < shown; i++) {
+      const SlabCache* cache = this->listed[LineStore_shownLine(lines, i)];
+      if (i >= shownBefore || before[i] != cache || cache->changed)
+         Panel_markDirty(panel, i);
+   }
+   free(before);
+
+   for (size_t i = 0; i < this->count; i++)
+      this->order[i]->changed = false;
+
+   Panel_setSelected(panel, Panel_getSelectedIndex(panel));
+}
+
+static void SlabScreen_scan(InfoScreen* super) {
+   SlabScreen* this = (SlabScreen*) super;
+   Panel* panel = super->display;
+   int idx = MAXIMUM(Panel_getSelectedIndex(panel), 0);
+
+   SlabScreen_read(this);
+
+   Panel_prune(panel);
+   this->listedCount = 0;
+   SlabScreen_show(this);
+   Panel_setSelected(panel, idx);
+}
+
+static void SlabScreen_update(InfoScreen* super) {
+   SlabScreen* this = (SlabScreen*) super;
+
+   /* wait for a key for a while, the caches are only read in between */
+   fd_set fds;
+   FD_ZERO(&fds);
+   FD_SET(STDIN_FILENO, &fds);
+   struct timeval tv = { .tv_sec = 0, .tv_usec = 100 * 1000 };
+   select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv);
+
+   /* F5 tries again */
+   if (this->error)
+      return;
+
+   uint64_t now;
+   Platform_gettime_monotonic(&now);
+   if (now - this->readMs < this->intervalMs)
+      return;
+
+   SlabScreen_read(this);
+   SlabScreen_show(this);
+}
+
+static bool SlabScreen_onKey(InfoScreen* super, int ch) {
+   SlabScreen* this = (SlabScreen*) super;
+
+   switch (ch) {
+      case KEY_F(6):
+         this->sortKey = this->sortKey == SLAB_SORT_SIZE ? SLAB_SORT_GROWTH : SLAB_SORT_SIZE;
+         SlabScreen_sort(this);
+         SlabScreen_show(this);
+         InfoScreen_draw(this);
+         return true;
+   }
+
+   return false;
+}
+
+const InfoScreenClass SlabScreen_class = {
+   .super = {
+      .extends = Class(Object),
+      .delete = SlabScreen_delete
+   },
+   .scan = SlabScreen_scan,
+   .draw = SlabScreen_draw,
+   .onErr = SlabScreen_update,
+   .onKey = SlabScreen_onKey,
+};
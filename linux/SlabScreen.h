@@ -0,0 +1,56 @@
+#ifndef HEADER_SlabScreen
+#define HEADER_SlabScreen
+/*
+htop - linux/SlabScreen.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "InfoScreen.h"
+#include "Machine.h"
+#include "Object.h"
+
+#include "linux/FsRoot.h"
+
+
+typedef enum SlabSortKey_ {
+   SLAB_SORT_SIZE,
+   SLAB_SORT_GROWTH,
+} SlabSortKey;
+
+typedef struct SlabCache_ SlabCache;
+
+/* The kernel slab caches of /proc/slabinfo, like slabtop, refreshed in place */
+typedef struct SlabScreen_ {
+   InfoScreen super;
+   FsRootFile* file;
+   unsigned int pageSizeKB;
+   unsigned int intervalMs;
+   int error;                /* errno of the last read, 0 if it succeeded */
+
+   SlabCache** byName;       /* sorted by name, to find the cache of a line */
+   SlabCache** order;        /* in display order, sorted again from the last one on every read */
+   size_t count;
+   size_t alloc;
+   SlabSortKey sortKey;
+   unsigned int generation;  /* of the last read, caches not seen by it are gone */
+
+   /* the caches of the lines last listed, to repaint only those that changed */
+   const SlabCache** listed;
+   size_t listedCount;
+
+   uint64_t readMs;
+} SlabScreen;
+
+extern const InfoScreenClass SlabScreen_class;
+
+SlabScreen* SlabScreen_new(const Machine* host);
+
+void SlabScreen_delete(Object* cast);
+
+#endif
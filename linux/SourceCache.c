@@ -0,0 +1,31 @@
+/*
+htop - linux/SourceCache.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/SourceCache.h"
+
+#include <assert.h>
+
+
+/* 0 marks a source as never read, cycles start at 1 */
+static uint64_t SourceCache_cycle = 1;
+static uint64_t SourceCache_stamps[SOURCE_CACHE_KEYS];
+
+void SourceCache_newCycle(void) {
+   SourceCache_cycle++;
+}
+
+bool SourceCache_isStale(SourceCacheKey key) {
+   assert(key < SOURCE_CACHE_KEYS);
+
+   if (SourceCache_stamps[key] == SourceCache_cycle)
+      return false;
+
+   SourceCache_stamps[key] = SourceCache_cycle;
+   return true;
+}
@@ -0,0 +1,42 @@
+#ifndef HEADER_SourceCache
+#define HEADER_SourceCache
+/*
+htop - linux/SourceCache.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/* Kernel interfaces read by meters, each at most once per Machine_scan() */
+typedef enum SourceCacheKey_ {
+   SOURCE_PRESSURE_CPU,
+   SOURCE_PRESSURE_IO,
+   SOURCE_PRESSURE_IRQ,
+   SOURCE_PRESSURE_MEMORY,
+   SOURCE_FILE_NR,
+   SOURCE_DISKSTATS,
+   SOURCE_NET_DEV,
+   SOURCE_SOFTIRQS,
+   SOURCE_INTERRUPTS,
+   SOURCE_RESCTRL,
+   SOURCE_VMSTAT,
+   SOURCE_BUDDYINFO,
+   SOURCE_SCHEDSTAT,
+   SOURCE_CACHE_KEYS
+} SourceCacheKey;
+
+/* Starts a new cycle, after which every source is read again on first use */
+void SourceCache_newCycle(void);
+
+/*
+ * Whether the source has to be read for the current cycle. Returns true
+ * only for the first query of a cycle; the caller then stores what it
+ * read, for the following queries to return.
+ */
+bool SourceCache_isStale(SourceCacheKey key);
+
+#endif
@@ -0,0 +1,348 @@
+/*
+htop - linux/StackSampler.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/StackSampler.h"
+
+#ifdef HAVE_PERF_EVENTS
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <sys/syscall.h>
+
+#include "Macros.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+
+
+/* Threads sampled at most, each costs one fd and one ring */
+#define STACKSAMPLER_MAX_THREADS 256
+
+/* Pages of the ring of a thread after its header page, a power of two */
+#define STACKSAMPLER_RING_PAGES 8
+
+#define STACKSAMPLER_FREQUENCY 99
+
+/* Distinct stacks kept, samples of further ones are counted as lost */
+#define STACKSAMPLER_MAX_STACKS 65536
+
+#define STACKSAMPLER_BUCKETS 4096
+
+typedef struct StackSamplerRing_ {
+   int fd;
+   void* base;                /* the header page followed by the data pages */
+} StackSamplerRing;
+
+struct StackSampler_ {
+   int error;
+   bool withKernel;
+   size_t pageSize;
+
+   StackSamplerRing* rings;
+   size_t ringCount;
+
+   StackTrace* buckets[STACKSAMPLER_BUCKETS];
+   StackTrace** stacks;
+   size_t stackCount;
+   size_t stacksSize;
+   bool sorted;
+
+   unsigned long long samples;
+   unsigned long long lost;
+
+   uint64_t record[8192];     /* a record copied out of the ring, they are at most 64 KiB */
+};
+
+static int StackSampler_openEvent(pid_t tid, bool withKernel) {
+   struct perf_event_attr attr;
+   memset(&attr, 0, sizeof(attr));
+   attr.size = sizeof(attr);
+   attr.type = PERF_TYPE_SOFTWARE;
+   attr.config = PERF_COUNT_SW_CPU_CLOCK;
+   attr.freq = 1;
+   attr.sample_freq = STACKSAMPLER_FREQUENCY;
+   attr.sample_type = PERF_SAMPLE_CALLCHAIN;
+   attr.exclude_kernel = !withKernel;
+   attr.exclude_hv = 1;
+   /* not inherited: a ring of an event of any CPU cannot be shared with the threads started later */
+
+   int fd = (int)syscall(SYS_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+   if (fd < 0)
+      return -1;
+
+   /* keep the low fds free, see LinuxProcessTable_getProcFd() */
+   if (fd < FD_SETSIZE) {
+      int highFd = fcntl(fd, F_DUPFD_CLOEXEC, FD_SETSIZE);
+      if (highFd >= 0) {
+         close(fd);
+         fd = highFd;
+      }
+   }
+
+   return fd;
+}
+
+static bool StackSampler_addThread(StackSampler* this, pid_t tid) {
+   int fd = StackSampler_openEvent(tid, this->withKernel);
+   if (fd < 0 && this->withKernel && (errno == EACCES || errno == EPERM)) {
+      /* unprivileged, user frames may still be allowed */
+      fd = StackSampler_openEvent(tid, false);
+      if (fd >= 0)
+         this->withKernel = false;
+   }
+   if (fd < 0) {
+      this->error = errno;
+      return false;
+   }
+
+   void* base = mmap(NULL, this->pageSize * (1 + STACKSAMPLER_RING_PAGES), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (base == MAP_FAILED) {
+      this->error = errno;
+      close(fd);
+      return false;
+   }
+
+   this->rings[this->ringCount++] = (StackSamplerRing) { .fd = fd, .base = base };
+   return true;
+}
+
+StackSampler* StackSampler_new(pid_t pid) {
+   StackSampler* this = xCalloc(1, sizeof(StackSampler));
+   this->withKernel = true;
+   long pageSize = sysconf(_SC_PAGESIZE);
+   this->pageSize = pageSize > 0 ? (size_t)pageSize : 4096;
+   this->rings = xCalloc(STACKSAMPLER_MAX_THREADS, sizeof(StackSamplerRing));
+
+   char path[32];
+   xSnprintf(path, sizeof(path), "%d/task", (int)pid);
+   DIR* dir = FsRoot_opendir(&FsRoot_proc, path);
+   if (!dir) {
+      this->error = errno ? errno : ESRCH;
+      return this;
+   }
+
+   const struct dirent* entry;
+   while ((entry = readdir(dir)) != NULL && this->ringCount < STACKSAMPLER_MAX_THREADS) {
+      char* end;
+      long tid = strtol(entry->d_name, &end, 10);
+      if (tid <= 0 || *end)
+         continue;
+
+      if (!StackSampler_addThread(this, (pid_t)tid) && (this->error == EMFILE || this->error == ENFILE || this->error == ENOMEM))
+         break;
+   }
+   closedir(dir);
+
+   if (this->ringCount > 0) {
+      this->error = 0;
+   } else if (!this->error) {
+      this->error = ESRCH;
+   }
+
+   return this;
+}
+
+void StackSampler_clear(StackSampler* this) {
+   for (size_t i = 0; i < this->stackCount; i++) {
+      free(this->stacks[i]->ips);
+      free(this->stacks[i]->folded);
+      free(this->stacks[i]);
+   }
+   this->stackCount = 0;
+   memset(this->buckets, 0, sizeof(this->buckets));
+   this->samples = 0;
+   this->lost = 0;
+}
+
+void StackSampler_delete(StackSampler* this) {
+   if (!this)
+      return;
+
+   for (size_t i = 0; i < this->ringCount; i++) {
+      munmap(this->rings[i].base, this->pageSize * (1 + STACKSAMPLER_RING_PAGES));
+      close(this->rings[i].fd);
+   }
+   free(this->rings);
+
+   StackSampler_clear(this);
+   free(this->stacks);
+   free(this);
+}
+
+int StackSampler_error(const StackSampler* this) {
+   return this->error;
+}
+
+bool StackSampler_withKernel(const StackSampler* this) {
+   return this->withKernel;
+}
+
+void StackSampler_setEnabled(StackSampler* this, bool enabled) {
+   for (size_t i = 0; i < this->ringCount; i++)
+      ioctl(this->rings[i].fd, enabled ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+}
+
+unsigned long long StackSampler_samples(const StackSampler* this) {
+   return this->samples;
+}
+
+unsigned long long StackSampler_lost(const StackSampler* this) {
+   return this->lost;
+}
+
+static uint32_t StackSampler_hash(const uint64_t* ips, uint32_t depth) {
+   /* FNV-1a */
+   uint32_t hash = 2166136261U;
+   for (uint32_t i = 0; i < depth; i++) {
+      uint64_t ip = ips[i];
+      for (int b = 0; b < 8; b++) {
+         hash ^= (uint32_t)(ip & 0xff);
+         hash *= 16777619U;
+         ip >>= 8;
+      }
+   }
+   return hash;
+}
+
+static void StackSampler_count(StackSampler* this, const uint64_t* ips, uint32_t depth, uint32_t kernelDepth) {
+   const uint32_t hash = StackSampler_hash(ips, depth);
+   StackTrace** bucket = &this->buckets[hash % STACKSAMPLER_BUCKETS];
+
+   for (StackTrace* stack = *bucket; stack; stack = stack->next) {
+      if (stack->hash == hash && stack->depth == depth && memcmp(stack->ips, ips, depth * sizeof(uint64_t)) == 0) {
+         stack->count++;
+         this->samples++;
+         this->sorted = false;
+         return;
+      }
+   }
+
+   if (this->stackCount >= STACKSAMPLER_MAX_STACKS) {
+      this->lost++;
+      return;
+   }
+
+   StackTrace* stack = xCalloc(1, sizeof(StackTrace));
+   stack->ips = xMallocArray(MAXIMUM(depth, 1), sizeof(uint64_t));
+   memcpy(stack->ips, ips, depth * sizeof(uint64_t));
+   stack->depth = depth;
+   stack->kernelDepth = kernelDepth;
+   stack->hash = hash;
+   stack->count = 1;
+   stack->next = *bucket;
+   *bucket = stack;
+
+   if (this->stackCount == this->stacksSize) {
+      this->stacksSize = this->stacksSize ? this->stacksSize * 2 : 256;
+      this->stacks = xReallocArray(this->stacks, this->stacksSize, sizeof(StackTrace*));
+   }
+   this->stacks[this->stackCount++] = stack;
+   this->samples++;
+   this->sorted = false;
+}
+
+/* A PERF_RECORD_SAMPLE of PERF_SAMPLE_CALLCHAIN: nr, ips[nr] */
+static void StackSampler_sample(StackSampler* this, size_t size) {
+   if (size < 2 * sizeof(uint64_t))
+      return;
+
+   uint64_t nr = this->record[1];
+   if (nr > size / sizeof(uint64_t) - 2)
+      return;
+
+   /* the context markers are dropped in place, in the record copied out of the ring */
+   uint64_t* ips = &this->record[2];
+   uint32_t depth = 0;
+   uint32_t kernelDepth = 0;
+   uint64_t context = PERF_CONTEXT_USER;
+   for (uint64_t i = 0; i < nr; i++) {
+      if (ips[i] >= (uint64_t)PERF_CONTEXT_MAX) {
+         context = ips[i];
+         continue;
+      }
+      if (context == PERF_CONTEXT_KERNEL) {
+         kernelDepth++;
+      } else if (context != PERF_CONTEXT_USER) {
+         continue;
+      }
+      ips[depth++] = ips[i];
+   }
+
+   if (depth > 0)
+      StackSampler_count(this, ips, depth, kernelDepth);
+}
+
+static void StackSampler_copy(void* dest, const char* data, size_t dataSize, uint64_t position, size_t size) {
+   size_t offset = (size_t)(position % dataSize);
+   size_t first = MINIMUM(size, dataSize - offset);
+   memcpy(dest, data + offset, first);
+   memcpy((char*)dest + first, data, size - first);
+}
+
+static bool StackSampler_drainRing(StackSampler* this, const StackSamplerRing* ring) {
+   struct perf_event_mmap_page* header = ring->base;
+   const char* data = (const char*)ring->base + this->pageSize;
+   const size_t dataSize = this->pageSize * STACKSAMPLER_RING_PAGES;
+
+   const uint64_t head = __atomic_load_n(&header->data_head, __ATOMIC_ACQUIRE);
+   uint64_t tail = header->data_tail;
+   bool any = tail != head;
+
+   while (head - tail >= sizeof(struct perf_event_header)) {
+      struct perf_event_header event;
+      StackSampler_copy(&event, data, dataSize, tail, sizeof(event));
+      if (event.size < sizeof(event) || head - tail < event.size) {
+         tail = head;
+         break;
+      }
+
+      StackSampler_copy(this->record, data, dataSize, tail, event.size);
+      if (event.type == PERF_RECORD_SAMPLE) {
+         StackSampler_sample(this, event.size);
+      } else if (event.type == PERF_RECORD_LOST && event.size >= 3 * sizeof(uint64_t)) {
+         this->lost += this->record[2];
+      }
+      tail += event.size;
+   }
+
+   __atomic_store_n(&header->data_tail, tail, __ATOMIC_RELEASE);
+   return any;
+}
+
+bool StackSampler_drain(StackSampler* this) {
+   bool any = false;
+   for (size_t i = 0; i < this->ringCount; i++)
+      any |= StackSampler_drainRing(this, &this->rings[i]);
+   return any;
+}
+
+static int StackSampler_compare(const void* v1, const void* v2) {
+   const StackTrace* s1 = *(const StackTrace* const*)v1;
+   const StackTrace* s2 = *(const StackTrace* const*)v2;
+   return SPACESHIP_NUMBER(s2->count, s1->count);
+}
+
+size_t StackSampler_top(StackSampler* this, StackTrace*** top, size_t max) {
+   if (!this->sorted && this->stackCount > 0) {
+      qsort(this->stacks, this->stackCount, sizeof(StackTrace*), StackSampler_compare);
+      this->sorted = true;
+   }
+   *top = this->stacks;
+   return MINIMUM(max, this->stackCount);
+}
+
+#endif /* HAVE_PERF_EVENTS */
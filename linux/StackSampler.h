@@ -0,0 +1,57 @@
+#ifndef HEADER_StackSampler
+#define HEADER_StackSampler
+/*
+htop - linux/StackSampler.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+
+/* One distinct call chain and how often it was sampled */
+typedef struct StackTrace_ {
+   uint64_t* ips;             /* leaf first */
+   uint32_t depth;
+   uint32_t kernelDepth;      /* the leading frames that are in the kernel */
+   uint32_t hash;
+   unsigned long long count;
+   char* folded;              /* "root;...;leaf", once named */
+   struct StackTrace_* next;  /* in the hash chain */
+} StackTrace;
+
+/* Samples the call chains of the threads a process has when sampling starts, while on CPU, with perf_event_open(2) */
+typedef struct StackSampler_ StackSampler;
+
+/* Starts sampling; without a single event open StackSampler_error() tells why */
+StackSampler* StackSampler_new(pid_t pid);
+
+void StackSampler_delete(StackSampler* this);
+
+/* The errno of opening the events, 0 if some are open */
+int StackSampler_error(const StackSampler* this);
+
+/* Whether kernel frames are sampled too, this needs more privileges than user frames */
+bool StackSampler_withKernel(const StackSampler* this);
+
+void StackSampler_setEnabled(StackSampler* this, bool enabled);
+
+/* Counts the samples written since the last call; returns whether there were any */
+bool StackSampler_drain(StackSampler* this);
+
+/* Forgets all stacks counted */
+void StackSampler_clear(StackSampler* this);
+
+/* Samples counted, and those lost because a ring or the stack table was full */
+unsigned long long StackSampler_samples(const StackSampler* this);
+
+unsigned long long StackSampler_lost(const StackSampler* this);
+
+/* The stacks sampled most, at most `max` of them; valid until the next drain or clear */
+size_t StackSampler_top(StackSampler* this, StackTrace*** top, size_t max);
+
+#endif
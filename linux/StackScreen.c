@@ -0,0 +1,251 @@
+/*
+htop - linux/StackScreen.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/StackScreen.h"
+
+#ifdef HAVE_PERF_EVENTS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/select.h>
+
+#include "CRT.h"
+#include "FunctionBar.h"
+#include "LineStore.h"
+#include "Macros.h"
+#include "Panel.h"
+#include "Platform.h"
+#include "ProvideCurses.h"
+#include "XUtils.h"
+
+
+static const char* const StackScreenFunctions[] = {"Search ", "Filter ", "Clear  ", "Stop   ", "Done   ", NULL};
+
+static const char* const StackScreenKeys[] = {"F3", "F4", "F8", "F9", "Esc"};
+
+static const int StackScreenEvents[] = {KEY_F(3), KEY_F(4), KEY_F(8), KEY_F(9), 27};
+
+/* Sampling stops on its own after this long, F9 samples for this long again */
+#define STACKSCREEN_SAMPLE_SECONDS 10
+
+/* The list is rebuilt this often while samples come in */
+#define STACKSCREEN_SHOW_INTERVAL_MS 500
+
+/* Only the stacks sampled most are named, the ELF files of other frames are never read */
+#define STACKSCREEN_MAX_NAMED 1000
+
+/* Lines listed at most, stacks named alike being merged */
+#define STACKSCREEN_MAX_LINES 100
+
+#define STACKSCREEN_HEADER "    %  SAMPLES  STACK (outermost;...;innermost)"
+
+StackScreen* StackScreen_new(const Process* process) {
+   StackScreen* this = xCalloc(1, sizeof(StackScreen));
+   Object_setClass(this, Class(StackScreen));
+   FunctionBar* fuBar = FunctionBar_new(StackScreenFunctions, StackScreenKeys, StackScreenEvents);
+   CRT_disableDelay();
+   InfoScreen_init(&this->super, process, fuBar, LINES - 2, STACKSCREEN_HEADER);
+
+   this->sampler = StackSampler_new(Process_getPid(process));
+   this->symbols = SymbolResolver_new(Process_getPid(process));
+   this->sampling = StackSampler_error(this->sampler) == 0;
+   Platform_gettime_monotonic(&this->startMs);
+   if (!this->sampling)
+      FunctionBar_setLabel(this->super.display->defaultBar, KEY_F(9), "       ");
+   return this;
+}
+
+void StackScreen_delete(Object* cast) {
+   StackScreen* this = (StackScreen*) cast;
+   StackSampler_delete(this->sampler);
+   SymbolResolver_delete(this->symbols);
+   CRT_enableDelay();
+   free(InfoScreen_done((InfoScreen*)this));
+}
+
+static void StackScreen_draw(InfoScreen* super) {
+   const StackScreen* this = (const StackScreen*) super;
+   const char* frames = StackSampler_withKernel(this->sampler) ? "" : ", user frames only";
+
+   if (this->sampling) {
+      uint64_t now;
+      Platform_gettime_monotonic(&now);
+      InfoScreen_drawTitled(super, "CPU stacks of process %d - %s (%llu samples%s, sampling %llus more)",
+         Process_getPid(super->process), Process_getCommand(super->process), StackSampler_samples(this->sampler), frames,
+         (unsigned long long)(STACKSCREEN_SAMPLE_SECONDS - MINIMUM((now - this->startMs) / 1000, STACKSCREEN_SAMPLE_SECONDS)));
+   } else {
+      InfoScreen_drawTitled(super, "CPU stacks of process %d - %s (%llu samples%s)",
+         Process_getPid(super->process), Process_getCommand(super->process), StackSampler_samples(this->sampler), frames);
+   }
+}
+
+/* Names the frames from the outermost to the innermost, kernel frames marked "_[k]" as in folded perf output */
+static void StackScreen_fold(StackScreen* this, StackTrace* stack) {
+   char folded[4096];
+   size_t len = 0;
+
+   for (uint32_t i = stack->depth; i-- > 0 && len + 1 < sizeof(folded); ) {
+      const bool kernel = i < stack->kernelDepth;
+      /* return addresses point behind the call, only the innermost frame is where the sample was */
+      const uint64_t address = i > 0 ? stack->ips[i] - 1 : stack->ips[i];
+
+      char name[512];
+      SymbolResolver_name(this->symbols, address, kernel, name, sizeof(name));
+      len += (size_t)xSnprintf(folded + len, sizeof(folded) - len, "%s%s%s", len ? ";" : "", name, kernel ? "_[k]" : "");
+   }
+
+   stack->folded = xStrdup(folded);
+}
+
+typedef struct StackScreenLine_ {
+   const char* folded;
+   unsigned long long count;
+} StackScreenLine;
+
+static int StackScreen_compareLines(const void* v1, const void* v2) {
+   const StackScreenLine* l1 = v1;
+   const StackScreenLine* l2 = v2;
+   return SPACESHIP_NUMBER(l2->count, l1->count);
+}
+
+static void StackScreen_show(InfoScreen* super) {
+   StackScreen* this = (StackScreen*) super;
+   Panel* panel = super->display;
+   int selected = Panel_getSelectedIndex(panel);
+
+   Panel_prune(panel);
+   LineStore_clear(super->lines);
+
+   int error = StackSampler_error(this->sampler);
+   if (error) {
+      char line[256];
+      xSnprintf(line, sizeof(line), "Could not sample the process: %s", strerror(error));
+      InfoScreen_addLine(super, line);
+      InfoScreen_addLine(super, "Processes of other users need CAP_PERFMON, or kernel.perf_event_paranoid set to 1 or lower.");
+      return;
+   }
+
+   StackTrace** top;
+   size_t count = StackSampler_top(this->sampler, &top, STACKSCREEN_MAX_NAMED);
+   const unsigned long long samples = StackSampler_samples(this->sampler);
+
+   if (count == 0)
+      InfoScreen_addLine(super, this->sampling ? "No samples yet, the process was not on a CPU." : "No samples, the process was not on a CPU.");
+
+   /* stacks differing only in the instructions within the same functions fold alike */
+   StackScreenLine* lines = xMallocArray(MAXIMUM(count, 1), sizeof(StackScreenLine));
+   size_t lineCount = 0;
+   unsigned long long named = 0;
+   for (size_t i = 0; i < count; i++) {
+      if (!top[i]->folded)
+         StackScreen_fold(this, top[i]);
+
+      size_t l = 0;
+      while (l < lineCount && !String_eq(lines[l].folded, top[i]->folded))
+         l++;
+      if (l == lineCount)
+         lines[lineCount++] = (StackScreenLine) { .folded = top[i]->folded, .count = 0 };
+      lines[l].count += top[i]->count;
+      named += top[i]->count;
+   }
+   qsort(lines, lineCount, sizeof(StackScreenLine), StackScreen_compareLines);
+
+   char line[4200];
+   for (size_t i = 0; i < MINIMUM(lineCount, STACKSCREEN_MAX_LINES); i++) {
+      xSnprintf(line, sizeof(line), "%5.1f %8llu  %s", 100.0 * (double)lines[i].count / (double)samples, lines[i].count, lines[i].folded);
+      InfoScreen_addLine(super, line);
+   }
+   free(lines);
+
+   if (named < samples) {
+      xSnprintf(line, sizeof(line), "%5.1f %8llu  [other stacks]", 100.0 * (double)(samples - named) / (double)samples, samples - named);
+      InfoScreen_addLine(super, line);
+   }
+
+   const unsigned long long lost = StackSampler_lost(this->sampler);
+   if (lost) {
+      xSnprintf(line, sizeof(line), "%llu samples were lost, the process was sampled faster than read.", lost);
+      InfoScreen_addLine(super, line);
+   }
+
+   Panel_setSelected(panel, selected);
+   this->changed = false;
+}
+
+static void StackScreen_update(InfoScreen* super) {
+   StackScreen* this = (StackScreen*) super;
+
+   /* wait for a key for a while, the samples are only read in between */
+   fd_set fds;
+   FD_ZERO(&fds);
+   FD_SET(STDIN_FILENO, &fds);
+   struct timeval tv = { .tv_sec = 0, .tv_usec = 100 * 1000 };
+   select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv);
+
+   uint64_t now;
+   Platform_gettime_monotonic(&now);
+
+   this->changed |= StackSampler_drain(this->sampler);
+   if (this->sampling && now - this->startMs >= STACKSCREEN_SAMPLE_SECONDS * 1000) {
+      StackSampler_setEnabled(this->sampler, false);
+      this->changed |= StackSampler_drain(this->sampler);
+      this->sampling = false;
+      FunctionBar_setLabel(super->display->defaultBar, KEY_F(9), "Resume ");
+      this->shownMs = 0;
+   }
+
+   if (now - this->shownMs < STACKSCREEN_SHOW_INTERVAL_MS)
+      return;
+
+   this->shownMs = now;
+   if (this->changed)
+      StackScreen_show(super);
+   InfoScreen_draw(this);
+}
+
+static bool StackScreen_onKey(InfoScreen* super, int ch) {
+   StackScreen* this = (StackScreen*) super;
+
+   if (StackSampler_error(this->sampler))
+      return false;
+
+   switch (ch) {
+      case KEY_F(8):
+         StackSampler_drain(this->sampler);
+         StackSampler_clear(this->sampler);
+         StackScreen_show(super);
+         InfoScreen_draw(this);
+         return true;
+      case KEY_F(9):
+         this->sampling = !this->sampling;
+         StackSampler_setEnabled(this->sampler, this->sampling);
+         if (this->sampling)
+            Platform_gettime_monotonic(&this->startMs);
+         FunctionBar_setLabel(super->display->defaultBar, KEY_F(9), this->sampling ? "Stop   " : "Resume ");
+         InfoScreen_draw(this);
+         return true;
+   }
+
+   return false;
+}
+
+const InfoScreenClass StackScreen_class = {
+   .super = {
+      .extends = Class(Object),
+      .delete = StackScreen_delete
+   },
+   .scan = StackScreen_show,
+   .draw = StackScreen_draw,
+   .onErr = StackScreen_update,
+   .onKey = StackScreen_onKey,
+};
+
+#endif /* HAVE_PERF_EVENTS */
@@ -0,0 +1,38 @@
+#ifndef HEADER_StackScreen
+#define HEADER_StackScreen
+/*
+htop - linux/StackScreen.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "InfoScreen.h"
+#include "Object.h"
+#include "Process.h"
+
+#include "linux/StackSampler.h"
+#include "linux/SymbolResolver.h"
+
+
+/* The call chains a process is sampled in most while on CPU, as folded stacks */
+typedef struct StackScreen_ {
+   InfoScreen super;
+   StackSampler* sampler;
+   SymbolResolver* symbols;
+   bool sampling;
+   bool changed;             /* samples were counted since the list was shown */
+   uint64_t startMs;         /* sampling stops on its own after STACKSCREEN_SAMPLE_SECONDS */
+   uint64_t shownMs;
+} StackScreen;
+
+extern const InfoScreenClass StackScreen_class;
+
+StackScreen* StackScreen_new(const Process* process);
+
+void StackScreen_delete(Object* cast);
+
+#endif
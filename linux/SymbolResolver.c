@@ -0,0 +1,364 @@
+/*
+htop - linux/SymbolResolver.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/SymbolResolver.h"
+
+#include <elf.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Compat.h"
+#include "Macros.h"
+#include "XUtils.h"
+
+#include "linux/FsRoot.h"
+#include "linux/Platform.h" // needed for GNU/hurd to get PATH_MAX  // IWYU pragma: keep
+
+
+/* Symbol and string tables larger than this are not read */
+#define SYMBOLRESOLVER_MAX_TABLE (256 * 1024 * 1024)
+
+typedef struct Symbol_ {
+   uint64_t address;
+   uint64_t size;             /* 0 if unknown, the symbol then reaches up to the next one */
+   size_t name;               /* offset into the names of its table */
+} Symbol;
+
+typedef struct SymbolTable_ {
+   Symbol* symbols;           /* ordered by address */
+   size_t count;
+   char* names;
+   size_t namesSize;
+} SymbolTable;
+
+/* A loadable segment, mapping file offsets to the addresses the symbols are given in */
+typedef struct SymbolSegment_ {
+   uint64_t offset;
+   uint64_t address;
+   uint64_t size;
+} SymbolSegment;
+
+typedef struct SymbolFile_ {
+   char* path;                /* in the mount namespace of the process */
+   bool loaded;
+   SymbolTable table;
+   SymbolSegment* segments;
+   size_t segmentCount;
+   struct SymbolFile_* next;
+} SymbolFile;
+
+typedef struct SymbolMapping_ {
+   uint64_t start;
+   uint64_t end;
+   uint64_t offset;
+   SymbolFile* file;
+} SymbolMapping;
+
+struct SymbolResolver_ {
+   pid_t pid;
+   bool mapsRead;
+   SymbolMapping* mappings;   /* executable ones, ordered by address as in the maps file */
+   size_t mappingCount;
+   SymbolFile* files;
+   bool kernelRead;
+   SymbolTable kernel;
+};
+
+SymbolResolver* SymbolResolver_new(pid_t pid) {
+   SymbolResolver* this = xCalloc(1, sizeof(SymbolResolver));
+   this->pid = pid;
+   return this;
+}
+
+static void SymbolTable_done(SymbolTable* this) {
+   free(this->symbols);
+   free(this->names);
+}
+
+void SymbolResolver_delete(SymbolResolver* this) {
+   if (!this)
+      return;
+
+   for (SymbolFile* file = this->files; file; ) {
+      SymbolFile* next = file->next;
+      SymbolTable_done(&file->table);
+      free(file->segments);
+      free(file->path);
+      free(file);
+      file = next;
+   }
+   SymbolTable_done(&this->kernel);
+   free(this->mappings);
+   free(this);
+}
+
+static int SymbolTable_compare(const void* v1, const void* v2) {
+   const Symbol* s1 = (const Symbol*)v1;
+   const Symbol* s2 = (const Symbol*)v2;
+   return SPACESHIP_NUMBER(s1->address, s2->address);
+}
+
+static const char* SymbolTable_find(const SymbolTable* this, uint64_t address) {
+   size_t low = 0;
+   size_t high = this->count;
+   while (low < high) {
+      size_t mid = low + (high - low) / 2;
+      if (this->symbols[mid].address <= address) {
+         low = mid + 1;
+      } else {
+         high = mid;
+      }
+   }
+   if (low == 0)
+      return NULL;
+
+   const Symbol* symbol = &this->symbols[low - 1];
+   if (symbol->size && address >= symbol->address + symbol->size)
+      return NULL;
+
+   return this->names + symbol->name;
+}
+
+static bool SymbolResolver_readAt(int fd, void* buffer, size_t size, uint64_t offset) {
+   return pread(fd, buffer, size, (off_t)offset) == (ssize_t)size;
+}
+
+/* The functions of a .symtab or .dynsym section */
+static void SymbolTable_readElf(SymbolTable* this, int fd, const Elf64_Shdr* symtab, const Elf64_Shdr* strtab) {
+   if (symtab->sh_size > SYMBOLRESOLVER_MAX_TABLE || strtab->sh_size > SYMBOLRESOLVER_MAX_TABLE)
+      return;
+
+   const size_t count = symtab->sh_size / sizeof(Elf64_Sym);
+   const size_t namesSize = strtab->sh_size;
+   if (count == 0 || namesSize == 0)
+      return;
+
+   Elf64_Sym* elfSymbols = xMallocArray(count, sizeof(Elf64_Sym));
+   this->names = xMalloc(namesSize + 1);
+   if (!SymbolResolver_readAt(fd, elfSymbols, count * sizeof(Elf64_Sym), symtab->sh_offset) ||
+       !SymbolResolver_readAt(fd, this->names, namesSize, strtab->sh_offset)) {
+      free(elfSymbols);
+      free(this->names);
+      this->names = NULL;
+      return;
+   }
+   this->names[namesSize] = '\0';
+   this->namesSize = namesSize;
+
+   this->symbols = xMallocArray(count, sizeof(Symbol));
+   for (size_t i = 0; i < count; i++) {
+      const Elf64_Sym* sym = &elfSymbols[i];
+      const unsigned char type = ELF64_ST_TYPE(sym->st_info);
+      if ((type != STT_FUNC && type != STT_GNU_IFUNC) || sym->st_value == 0 || sym->st_shndx == SHN_UNDEF || sym->st_name >= namesSize)
+         continue;
+
+      this->symbols[this->count++] = (Symbol) { .address = sym->st_value, .size = sym->st_size, .name = sym->st_name };
+   }
+   free(elfSymbols);
+
+   qsort(this->symbols, this->count, sizeof(Symbol), SymbolTable_compare);
+}
+
+/* Reads the loadable segments and the symbols of a 64-bit ELF file, preferring .symtab over .dynsym */
+static void SymbolFile_load(SymbolFile* this, pid_t pid) {
+   this->loaded = true;
+
+   char path[PATH_MAX];
+   xSnprintf(path, sizeof(path), "%d/root%s", (int)pid, this->path);
+   int fd = Compat_openat(FsRoot_dir(&FsRoot_proc), path, O_RDONLY | O_CLOEXEC);
+   if (fd < 0)
+      return;
+
+   Elf64_Ehdr ehdr;
+   if (!SymbolResolver_readAt(fd, &ehdr, sizeof(ehdr), 0) ||
+       memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 ||
+       ehdr.e_ident[EI_CLASS] != ELFCLASS64 ||
+       ehdr.e_phentsize != sizeof(Elf64_Phdr) ||
+       ehdr.e_shentsize != sizeof(Elf64_Shdr)) {
+      close(fd);
+      return;
+   }
+
+   if (ehdr.e_phnum > 0) {
+      Elf64_Phdr* phdrs = xMallocArray(ehdr.e_phnum, sizeof(Elf64_Phdr));
+      if (SymbolResolver_readAt(fd, phdrs, ehdr.e_phnum * sizeof(Elf64_Phdr), ehdr.e_phoff)) {
+         this->segments = xMallocArray(ehdr.e_phnum, sizeof(SymbolSegment));
+         for (size_t i = 0; i < ehdr.e_phnum; i++) {
+            if (phdrs[i].p_type == PT_LOAD)
+               this->segments[this->segmentCount++] = (SymbolSegment) { .offset = phdrs[i].p_offset, .address = phdrs[i].p_vaddr, .size = phdrs[i].p_filesz };
+         }
+      }
+      free(phdrs);
+   }
+
+   if (ehdr.e_shnum > 0) {
+      Elf64_Shdr* shdrs = xMallocArray(ehdr.e_shnum, sizeof(Elf64_Shdr));
+      if (SymbolResolver_readAt(fd, shdrs, ehdr.e_shnum * sizeof(Elf64_Shdr), ehdr.e_shoff)) {
+         const Elf64_Shdr* symtab = NULL;
+         for (size_t i = 0; i < ehdr.e_shnum; i++) {
+            if (shdrs[i].sh_type == SHT_SYMTAB || (shdrs[i].sh_type == SHT_DYNSYM && !symtab))
+               symtab = &shdrs[i];
+         }
+
+         if (symtab && symtab->sh_link < ehdr.e_shnum && symtab->sh_entsize == sizeof(Elf64_Sym))
+            SymbolTable_readElf(&this->table, fd, symtab, &shdrs[symtab->sh_link]);
+      }
+      free(shdrs);
+   }
+
+   close(fd);
+}
+
+static SymbolFile* SymbolResolver_file(SymbolResolver* this, const char* path) {
+   for (SymbolFile* file = this->files; file; file = file->next) {
+      if (String_eq(file->path, path))
+         return file;
+   }
+
+   SymbolFile* file = xCalloc(1, sizeof(SymbolFile));
+   file->path = xStrdup(path);
+   file->next = this->files;
+   this->files = file;
+   return file;
+}
+
+/* The executable file mappings of the process */
+static void SymbolResolver_readMaps(SymbolResolver* this) {
+   this->mapsRead = true;
+
+   char relative[32];
+   xSnprintf(relative, sizeof(relative), "%d/maps", (int)this->pid);
+   FILE* fp = FsRoot_fopen(&FsRoot_proc, relative, "r");
+   if (!fp)
+      return;
+
+   size_t alloc = 0;
+   char line[PATH_MAX + 128];
+   while (fgets(line, sizeof(line), fp)) {
+      uint64_t start;
+      uint64_t end;
+      uint64_t offset;
+      char perms[5];
+      int pathStart = 0;
+      if (sscanf(line, "%" SCNx64 "-%" SCNx64 " %4s %" SCNx64 " %*s %*s %n", &start, &end, perms, &offset, &pathStart) < 4 || !pathStart)
+         continue;
+      if (perms[2] != 'x' || line[pathStart] != '/')
+         continue;
+
+      char* path = line + pathStart;
+      char* newline = strchr(path, '\n');
+      if (newline)
+         *newline = '\0';
+      char* deleted = strstr(path, " (deleted)");
+      if (deleted && deleted[strlen(" (deleted)")] == '\0')
+         *deleted = '\0';
+
+      if (this->mappingCount == alloc) {
+         alloc = alloc ? alloc * 2 : 32;
+         this->mappings = xReallocArray(this->mappings, alloc, sizeof(SymbolMapping));
+      }
+      this->mappings[this->mappingCount++] = (SymbolMapping) { .start = start, .end = end, .offset = offset, .file = SymbolResolver_file(this, path) };
+   }
+
+   fclose(fp);
+}
+
+/* The text symbols of /proc/kallsyms; without privileges all addresses read as zero and none are kept */
+static void SymbolResolver_readKernel(SymbolResolver* this) {
+   this->kernelRead = true;
+
+   FILE* fp = FsRoot_fopen(&FsRoot_proc, "kallsyms", "r");
+   if (!fp)
+      return;
+
+   SymbolTable* table = &this->kernel;
+   size_t alloc = 0;
+   size_t namesAlloc = 0;
+   char line[512];
+   while (fgets(line, sizeof(line), fp)) {
+      char* end;
+      uint64_t address = strtoull(line, &end, 16);
+      if (address == 0 || end[0] != ' ' || (end[1] != 't' && end[1] != 'T') || end[2] != ' ')
+         continue;
+
+      const char* name = end + 3;
+      size_t len = strcspn(name, " \t\n");
+      if (table->count == alloc) {
+         alloc = alloc ? alloc * 2 : 4096;
+         table->symbols = xReallocArray(table->symbols, alloc, sizeof(Symbol));
+      }
+      if (table->namesSize + len + 1 > namesAlloc) {
+         namesAlloc = MAXIMUM(namesAlloc * 2, 64 * 1024);
+         table->names = xRealloc(table->names, namesAlloc);
+      }
+
+      table->symbols[table->count++] = (Symbol) { .address = address, .size = 0, .name = table->namesSize };
+      memcpy(table->names + table->namesSize, name, len);
+      table->names[table->namesSize + len] = '\0';
+      table->namesSize += len + 1;
+   }
+
+   fclose(fp);
+   qsort(table->symbols, table->count, sizeof(Symbol), SymbolTable_compare);
+}
+
+static const SymbolMapping* SymbolResolver_mapping(const SymbolResolver* this, uint64_t address) {
+   for (size_t i = 0; i < this->mappingCount; i++) {
+      if (address >= this->mappings[i].start && address < this->mappings[i].end)
+         return &this->mappings[i];
+   }
+   return NULL;
+}
+
+void SymbolResolver_name(SymbolResolver* this, uint64_t address, bool kernel, char* buffer, size_t size) {
+   if (kernel) {
+      if (!this->kernelRead)
+         SymbolResolver_readKernel(this);
+
+      const char* name = SymbolTable_find(&this->kernel, address);
+      xSnprintf(buffer, size, "%s", name ? name : "[kernel]");
+      return;
+   }
+
+   if (!this->mapsRead)
+      SymbolResolver_readMaps(this);
+
+   const SymbolMapping* mapping = SymbolResolver_mapping(this, address);
+   if (!mapping) {
+      xSnprintf(buffer, size, "[unknown]");
+      return;
+   }
+
+   SymbolFile* file = mapping->file;
+   if (!file->loaded)
+      SymbolFile_load(file, this->pid);
+
+   const uint64_t offset = address - mapping->start + mapping->offset;
+   uint64_t fileAddress = offset;
+   for (size_t i = 0; i < file->segmentCount; i++) {
+      const SymbolSegment* segment = &file->segments[i];
+      if (offset >= segment->offset && offset < segment->offset + segment->size) {
+         fileAddress = offset - segment->offset + segment->address;
+         break;
+      }
+   }
+
+   const char* name = SymbolTable_find(&file->table, fileAddress);
+   if (name) {
+      xSnprintf(buffer, size, "%s", name);
+      return;
+   }
+
+   const char* base = strrchr(file->path, '/');
+   xSnprintf(buffer, size, "%s+0x%" PRIx64, base ? base + 1 : file->path, offset);
+}
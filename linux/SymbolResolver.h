@@ -0,0 +1,32 @@
+#ifndef HEADER_SymbolResolver
+#define HEADER_SymbolResolver
+/*
+htop - linux/SymbolResolver.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+
+/*
+ * Names the functions at code addresses of a process, from the symbol
+ * tables of the ELF files it maps and from /proc/kallsyms for the kernel.
+ * The mappings are read on the first lookup and the files as their
+ * addresses are first looked up, so that only the files of the frames
+ * shown are ever read.
+ */
+typedef struct SymbolResolver_ SymbolResolver;
+
+SymbolResolver* SymbolResolver_new(pid_t pid);
+
+void SymbolResolver_delete(SymbolResolver* this);
+
+/* Writes the function at the address, else the file and offset or the bare address */
+void SymbolResolver_name(SymbolResolver* this, uint64_t address, bool kernel, char* buffer, size_t size);
+
+#endif
@@ -11,7 +11,9 @@ in the source distribution for its full text.
 
 #include <dlfcn.h>
 #include <fcntl.h>
+#include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -21,6 +23,7 @@ in the source distribution for its full text.
 #include "CRT.h"
 #include "Macros.h"
 #include "Object.h"
+#include "Platform.h"
 #include "RichString.h"
 #include "Settings.h"
 #include "XUtils.h"
@@ -33,18 +36,28 @@ in the source distribution for its full text.
 #ifdef BUILD_STATIC
 
 #define sym_sd_bus_open_system sd_bus_open_system
+#define sym_sd_bus_open_user sd_bus_open_user
 #define sym_sd_bus_get_property_string sd_bus_get_property_string
 #define sym_sd_bus_get_property_trivial sd_bus_get_property_trivial
+#define sym_sd_bus_call_method sd_bus_call_method
+#define sym_sd_bus_add_match sd_bus_add_match
+#define sym_sd_bus_process sd_bus_process
 #define sym_sd_bus_unref sd_bus_unref
 
 #else
 
 typedef void sd_bus;
 typedef void sd_bus_error;
+typedef void sd_bus_message;
+typedef void sd_bus_slot;
+typedef int (*sd_bus_message_handler_t)(sd_bus_message*, void*, sd_bus_error*);
 static int (*sym_sd_bus_open_system)(sd_bus**);
 static int (*sym_sd_bus_open_user)(sd_bus**);
 static int (*sym_sd_bus_get_property_string)(sd_bus*, const char*, const char*, const char*, const char*, sd_bus_error*, char**);
 static int (*sym_sd_bus_get_property_trivial)(sd_bus*, const char*, const char*, const char*, const char*, sd_bus_error*, char, void*);
+static int (*sym_sd_bus_call_method)(sd_bus*, const char*, const char*, const char*, const char*, sd_bus_error*, sd_bus_message**, const char*, ...);
+static int (*sym_sd_bus_add_match)(sd_bus*, sd_bus_slot**, const char*, sd_bus_message_handler_t, void*);
+static int (*sym_sd_bus_process)(sd_bus*, sd_bus_message**);
 static sd_bus* (*sym_sd_bus_unref)(sd_bus*);
 static void* dlopenHandle = NULL;
 
@@ -56,7 +69,10 @@ static void* dlopenHandle = NULL;
 typedef struct SystemdMeterContext {
 #if !defined(BUILD_STATIC) || defined(HAVE_LIBSYSTEMD)
    sd_bus* bus;
+   bool subscribed;           /* changes are signalled on the bus */
+   bool changed;              /* since the properties were last read */
 #endif /* !BUILD_STATIC || HAVE_LIBSYSTEMD */
+   uint64_t execMs;           /* when systemctl was last run */
    char* systemState;
    unsigned int nFailedUnits;
    unsigned int nInstalledJobs;
@@ -64,14 +80,34 @@ typedef struct SystemdMeterContext {
    unsigned int nJobs;
 } SystemdMeterContext_t;
 
-static SystemdMeterContext_t ctx_system;
-static SystemdMeterContext_t ctx_user;
+/* The counts as meter values, for the display not to share the context with the updates on the meter worker */
+enum {
+   SYSTEMD_FAILED_UNITS,
+   SYSTEMD_NAMES,
+   SYSTEMD_JOBS,
+   SYSTEMD_INSTALLED_JOBS,
+   SYSTEMD_VALUES,
+};
 
-static void SystemdMeter_done(ATTR_UNUSED Meter* this) {
-   SystemdMeterContext_t* ctx = String_eq(Meter_name(this), "SystemdUser") ? &ctx_user : &ctx_system;
+/* Without libsystemd, systemctl is run at most this often */
+#define SYSTEMD_EXEC_INTERVAL_MS 10000
+
+#define SYSTEMD_CONTEXT_INIT { .nFailedUnits = INVALID_VALUE, .nInstalledJobs = INVALID_VALUE, .nNames = INVALID_VALUE, .nJobs = INVALID_VALUE }
+
+static SystemdMeterContext_t ctx_system = SYSTEMD_CONTEXT_INIT;
+static SystemdMeterContext_t ctx_user = SYSTEMD_CONTEXT_INIT;
 
+static void SystemdMeter_invalidate(SystemdMeterContext_t* ctx) {
    free(ctx->systemState);
    ctx->systemState = NULL;
+   ctx->nFailedUnits = ctx->nInstalledJobs = ctx->nNames = ctx->nJobs = INVALID_VALUE;
+}
+
+static void SystemdMeter_done(ATTR_UNUSED Meter* this) {
+   SystemdMeterContext_t* ctx = String_eq(Meter_name(this), "SystemdUser") ? &ctx_user : &ctx_system;
+
+   SystemdMeter_invalidate(ctx);
+   ctx->execMs = 0;
 
 #ifdef BUILD_STATIC
 # ifdef HAVE_LIBSYSTEMD
@@ -94,6 +130,39 @@ static void SystemdMeter_done(ATTR_UNUSED Meter* this) {
 }
 
 #if !defined(BUILD_STATIC) || defined(HAVE_LIBSYSTEMD)
+static int SystemdMeter_onChange(ATTR_UNUSED sd_bus_message* message, void* userdata, ATTR_UNUSED sd_bus_error* error) {
+   SystemdMeterContext_t* ctx = userdata;
+   ctx->changed = true;
+   return 0;
+}
+
+/* Has systemd signal changes of the manager, its units and jobs; without, the properties are read on every update */
+static bool SystemdMeter_subscribe(SystemdMeterContext_t* ctx) {
+   /* the unit and job signals are only sent to subscribed connections, until they close */
+   int r = sym_sd_bus_call_method(ctx->bus,
+                                  "org.freedesktop.systemd1",
+                                  "/org/freedesktop/systemd1",
+                                  "org.freedesktop.systemd1.Manager",
+                                  "Subscribe",
+                                  NULL,
+                                  NULL,
+                                  NULL);
+   if (r < 0)
+      return false;
+
+   /* floating matches, released with the bus */
+   r = sym_sd_bus_add_match(ctx->bus, NULL,
+                            "type='signal',sender='org.freedesktop.systemd1',interface='org.freedesktop.systemd1.Manager'",
+                            SystemdMeter_onChange, ctx);
+   if (r < 0)
+      return false;
+
+   r = sym_sd_bus_add_match(ctx->bus, NULL,
+                            "type='signal',sender='org.freedesktop.systemd1',interface='org.freedesktop.DBus.Properties',member='PropertiesChanged'",
+                            SystemdMeter_onChange, ctx);
+   return r >= 0;
+}
+
 static int updateViaLib(bool user) {
    SystemdMeterContext_t* ctx = user ? &ctx_user : &ctx_system;
 #ifndef BUILD_STATIC
@@ -115,6 +184,9 @@ static int updateViaLib(bool user) {
       resolve(sd_bus_open_user);
       resolve(sd_bus_get_property_string);
       resolve(sd_bus_get_property_trivial);
+      resolve(sd_bus_call_method);
+      resolve(sd_bus_add_match);
+      resolve(sd_bus_process);
       resolve(sd_bus_unref);
 
       #undef resolve
@@ -129,10 +201,30 @@ static int updateViaLib(bool user) {
       } else {
          r = sym_sd_bus_open_system(&ctx->bus);
       }
-      if (r < 0)
-         goto busfailure;
+      /* keep what systemctl showed last */
+      if (r < 0) {
+         ctx->bus = NULL;
+         return -2;
+      }
+
+      ctx->subscribed = SystemdMeter_subscribe(ctx);
+      ctx->changed = true;
    }
 
+   /* run the handlers of the signals received meanwhile, without waiting for more */
+   do {
+      r = sym_sd_bus_process(ctx->bus, NULL);
+   } while (r > 0);
+   if (r < 0)
+      goto busfailure;
+
+   if (!ctx->changed)
+      return 0;
+
+   /* signals received while reading mark the values as changed again */
+   ctx->changed = !ctx->subscribed;
+   SystemdMeter_invalidate(ctx);
+
    static const char* const busServiceName = "org.freedesktop.systemd1";
    static const char* const busObjectPath = "/org/freedesktop/systemd1";
    static const char* const busInterfaceName = "org.freedesktop.systemd1.Manager";
@@ -197,6 +289,9 @@ static int updateViaLib(bool user) {
 busfailure:
    sym_sd_bus_unref(ctx->bus);
    ctx->bus = NULL;
+   /* the connection was lost, fall back to systemctl right away */
+   SystemdMeter_invalidate(ctx);
+   ctx->execMs = 0;
    return -2;
 
 #ifndef BUILD_STATIC
@@ -216,6 +311,15 @@ static void updateViaExec(bool user) {
    if (Settings_isReadonly())
       return;
 
+   /* forking systemctl is expensive, keep what it showed last for a while */
+   uint64_t now;
+   Platform_gettime_monotonic(&now);
+   if (ctx->execMs && now - ctx->execMs < SYSTEMD_EXEC_INTERVAL_MS)
+      return;
+
+   ctx->execMs = now;
+   SystemdMeter_invalidate(ctx);
+
    int fdpair[2];
    if (pipe(fdpair) < 0)
       return;
@@ -228,6 +332,7 @@ static void updateViaExec(bool user) {
    }
 
    if (child == 0) {
+      restoreFileLimit();
       close(fdpair[0]);
       dup2(fdpair[1], STDOUT_FILENO);
       close(fdpair[1]);
@@ -287,14 +392,14 @@ static void updateViaExec(bool user) {
    fclose(commandOutput);
 }
 
+static double SystemdMeter_value(unsigned int value) {
+   return value == INVALID_VALUE ? NAN : value;
+}
+
 static void SystemdMeter_updateValues(Meter* this) {
    bool user = String_eq(Meter_name(this), "SystemdUser");
    SystemdMeterContext_t* ctx = user ? &ctx_user : &ctx_system;
 
-   free(ctx->systemState);
-   ctx->systemState = NULL;
-   ctx->nFailedUnits = ctx->nInstalledJobs = ctx->nNames = ctx->nJobs = INVALID_VALUE;
-
 #if !defined(BUILD_STATIC) || defined(HAVE_LIBSYSTEMD)
    if (updateViaLib(user) < 0)
       updateViaExec(user);
@@ -302,98 +407,68 @@ static void SystemdMeter_updateValues(Meter* this) {
    updateViaExec(user);
 #endif /* !BUILD_STATIC || HAVE_LIBSYSTEMD */
 
-   xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "%s", ctx->systemState ? ctx->systemState : "???");
-}
+   this->values[SYSTEMD_FAILED_UNITS] = SystemdMeter_value(ctx->nFailedUnits);
+   this->values[SYSTEMD_NAMES] = SystemdMeter_value(ctx->nNames);
+   this->values[SYSTEMD_JOBS] = SystemdMeter_value(ctx->nJobs);
+   this->values[SYSTEMD_INSTALLED_JOBS] = SystemdMeter_value(ctx->nInstalledJobs);
+   /* counts, not parts of a bar */
+   this->curItems = 0;
 
-static int zeroDigitColor(unsigned int value) {
-   switch (value) {
-      case 0:
-         return CRT_colors[METER_VALUE];
-      case INVALID_VALUE:
-         return CRT_colors[METER_VALUE_ERROR];
-      default:
-         return CRT_colors[METER_VALUE_NOTICE];
-   }
+   /* empty without a state */
+   xSnprintf(this->txtBuffer, sizeof(this->txtBuffer), "%s", ctx->systemState ? ctx->systemState : "");
 }
 
-static int valueDigitColor(unsigned int value) {
-   switch (value) {
-      case 0:
-         return CRT_colors[METER_VALUE_NOTICE];
-      case INVALID_VALUE:
-         return CRT_colors[METER_VALUE_ERROR];
-      default:
-         return CRT_colors[METER_VALUE];
-   }
+static int zeroDigitColor(double value) {
+   if (isNaN(value))
+      return CRT_colors[METER_VALUE_ERROR];
+
+   return isPositive(value) ? CRT_colors[METER_VALUE_NOTICE] : CRT_colors[METER_VALUE];
 }
 
+static int valueDigitColor(double value) {
+   if (isNaN(value))
+      return CRT_colors[METER_VALUE_ERROR];
 
-static void _SystemdMeter_display(ATTR_UNUSED const Object* cast, RichString* out, SystemdMeterContext_t* ctx) {
+   return isPositive(value) ? CRT_colors[METER_VALUE] : CRT_colors[METER_VALUE_NOTICE];
+}
+
+static void SystemdMeter_appendCount(RichString* out, double value, int color) {
    char buffer[16];
    int len;
-   int color = METER_VALUE_ERROR;
 
-   if (ctx->systemState) {
-      color = String_eq(ctx->systemState, "running") ? METER_VALUE_OK :
-              String_eq(ctx->systemState, "degraded") ? METER_VALUE_ERROR : METER_VALUE_WARN;
-   }
-   RichString_writeAscii(out, CRT_colors[color], ctx->systemState ? ctx->systemState : "N/A");
-
-   RichString_appendAscii(out, CRT_colors[METER_TEXT], " (");
-
-   if (ctx->nFailedUnits == INVALID_VALUE) {
+   if (isNaN(value)) {
       buffer[0] = '?';
       buffer[1] = '\0';
       len = 1;
    } else {
-      len = xSnprintf(buffer, sizeof(buffer), "%u", ctx->nFailedUnits);
+      len = xSnprintf(buffer, sizeof(buffer), "%u", (unsigned int)value);
    }
-   RichString_appendnAscii(out, zeroDigitColor(ctx->nFailedUnits), buffer, len);
+   RichString_appendnAscii(out, color, buffer, len);
+}
 
-   RichString_appendAscii(out, CRT_colors[METER_TEXT], "/");
+static void SystemdMeter_display(const Object* cast, RichString* out) {
+   const Meter* this = (const Meter*)cast;
+   const char* systemState = this->txtBuffer[0] ? this->txtBuffer : NULL;
+   const double* values = this->values;
+   int color = METER_VALUE_ERROR;
 
-   if (ctx->nNames == INVALID_VALUE) {
-      buffer[0] = '?';
-      buffer[1] = '\0';
-      len = 1;
-   } else {
-      len = xSnprintf(buffer, sizeof(buffer), "%u", ctx->nNames);
+   if (systemState) {
+      color = String_eq(systemState, "running") ? METER_VALUE_OK :
+              String_eq(systemState, "degraded") ? METER_VALUE_ERROR : METER_VALUE_WARN;
    }
-   RichString_appendnAscii(out, valueDigitColor(ctx->nNames), buffer, len);
+   RichString_writeAscii(out, CRT_colors[color], systemState ? systemState : "N/A");
 
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], " (");
+   SystemdMeter_appendCount(out, values[SYSTEMD_FAILED_UNITS], zeroDigitColor(values[SYSTEMD_FAILED_UNITS]));
+   RichString_appendAscii(out, CRT_colors[METER_TEXT], "/");
+   SystemdMeter_appendCount(out, values[SYSTEMD_NAMES], valueDigitColor(values[SYSTEMD_NAMES]));
    RichString_appendAscii(out, CRT_colors[METER_TEXT], " failed) (");
-
-   if (ctx->nJobs == INVALID_VALUE) {
-      buffer[0] = '?';
-      buffer[1] = '\0';
-      len = 1;
-   } else {
-      len = xSnprintf(buffer, sizeof(buffer), "%u", ctx->nJobs);
-   }
-   RichString_appendnAscii(out, zeroDigitColor(ctx->nJobs), buffer, len);
-
+   SystemdMeter_appendCount(out, values[SYSTEMD_JOBS], zeroDigitColor(values[SYSTEMD_JOBS]));
    RichString_appendAscii(out, CRT_colors[METER_TEXT], "/");
-
-   if (ctx->nInstalledJobs == INVALID_VALUE) {
-      buffer[0] = '?';
-      buffer[1] = '\0';
-      len = 1;
-   } else {
-      len = xSnprintf(buffer, sizeof(buffer), "%u", ctx->nInstalledJobs);
-   }
-   RichString_appendnAscii(out, valueDigitColor(ctx->nInstalledJobs), buffer, len);
-
+   SystemdMeter_appendCount(out, values[SYSTEMD_INSTALLED_JOBS], valueDigitColor(values[SYSTEMD_INSTALLED_JOBS]));
    RichString_appendAscii(out, CRT_colors[METER_TEXT], " jobs)");
 }
 
-static void SystemdMeter_display(ATTR_UNUSED const Object* cast, RichString* out) {
-   _SystemdMeter_display(cast, out, &ctx_system);
-}
-
-static void SystemdUserMeter_display(ATTR_UNUSED const Object* cast, RichString* out) {
-   _SystemdMeter_display(cast, out, &ctx_user);
-}
-
 static const int SystemdMeter_attributes[] = {
    METER_VALUE
 };
@@ -407,9 +482,10 @@ const MeterClass SystemdMeter_class = {
    .updateValues = SystemdMeter_updateValues,
    .done = SystemdMeter_done,
    .defaultMode = TEXT_METERMODE,
-   .maxItems = 0,
+   .maxItems = SYSTEMD_VALUES,
    .total = 100.0,
    .attributes = SystemdMeter_attributes,
+   .slowInterval = 2000,
    .name = "Systemd",
    .uiName = "Systemd state",
    .description = "Systemd system state and unit overview",
@@ -420,14 +496,15 @@ const MeterClass SystemdUserMeter_class = {
    .super = {
       .extends = Class(Meter),
       .delete = Meter_delete,
-      .display = SystemdUserMeter_display
+      .display = SystemdMeter_display
    },
    .updateValues = SystemdMeter_updateValues,
    .done = SystemdMeter_done,
    .defaultMode = TEXT_METERMODE,
-   .maxItems = 0,
+   .maxItems = SYSTEMD_VALUES,
    .total = 100.0,
    .attributes = SystemdMeter_attributes,
+   .slowInterval = 2000,
    .name = "SystemdUser",
    .uiName = "Systemd user state",
    .description = "Systemd user state and unit overview",
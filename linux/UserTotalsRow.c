@@ -0,0 +1,164 @@
+/*
+htop - linux/UserTotalsRow.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/UserTotalsRow.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "CRT.h"
+#include "DynamicColumn.h"
+#include "Macros.h"
+#include "RichString.h"
+#include "Settings.h"
+#include "Table.h"
+#include "XUtils.h"
+
+
+typedef struct UserTotalsFieldData_ {
+   const char* name;          /* stored in htoprc as Dynamic(name) */
+   const char* heading;
+   const char* description;
+   int width;                 /* as in DynamicColumn, without the trailing space */
+} UserTotalsFieldData;
+
+static const UserTotalsFieldData UserTotalsRow_fields[LAST_USERTOTALS_FIELD] = {
+   [USERTOTALS_FIELD_USER] = { .name = "user_name", .heading = "USER", .description = "Name of the user (or user ID if the name cannot be determined)", .width = -10, },
+   [USERTOTALS_FIELD_UID] = { .name = "user_uid", .heading = "UID", .description = "User ID", .width = 5, },
+   [USERTOTALS_FIELD_PROCESSES] = { .name = "user_processes", .heading = "PROCS", .description = "Number of userland processes of the user", .width = 5, },
+   [USERTOTALS_FIELD_TASKS] = { .name = "user_tasks", .heading = "TASKS", .description = "Number of tasks of the user, processes and their threads", .width = 5, },
+   [USERTOTALS_FIELD_CPU_PERCENT] = { .name = "user_cpu_percent", .heading = "CPU%", .description = "Sum of the CPU% of the processes of the user", .width = 5, },
+   [USERTOTALS_FIELD_RESIDENT] = { .name = "user_resident", .heading = "RES", .description = "Sum of the resident set sizes of the processes of the user", .width = 5, },
+   [USERTOTALS_FIELD_PSS] = { .name = "user_pss", .heading = "PSS", .description = "Sum of the proportional set sizes of the processes of the user, shared pages counted once", .width = 5, },
+   [USERTOTALS_FIELD_IO_READ_RATE] = { .name = "user_io_read_rate", .heading = "DISK READ", .description = "Bytes per second read by the processes of the user", .width = 11, },
+   [USERTOTALS_FIELD_IO_WRITE_RATE] = { .name = "user_io_write_rate", .heading = "DISK WRITE", .description = "Bytes per second written by the processes of the user", .width = 11, },
+};
+
+UserTotalsRow* UserTotalsRow_new(const Machine* host) {
+   UserTotalsRow* this = xCalloc(1, sizeof(UserTotalsRow));
+   Object_setClass(this, Class(UserTotalsRow));
+   Row_init(&this->super, host);
+   return this;
+}
+
+static void UserTotalsRow_delete(Object* cast) {
+   UserTotalsRow* this = (UserTotalsRow*) cast;
+   Row_done(&this->super);
+   free(this);
+}
+
+static void UserTotalsRow_writeField(const Row* super, RichString* str, RowField field) {
+   const UserTotalsRow* this = (const UserTotalsRow*) super;
+   const UserTotals* totals = &this->totals;
+   const Machine* host = super->host;
+   bool coloring = host->settings->highlightMegabytes;
+   char buffer[256];
+   size_t n = sizeof(buffer);
+   int attr = CRT_colors[DEFAULT_COLOR];
+
+   switch ((int)field - UserTotalsField_key(0)) {
+   case USERTOTALS_FIELD_USER:
+      if (host->htopUserId != totals->uid)
+         attr = CRT_colors[PROCESS_SHADOW];
+      Row_printLeftAlignedField(str, attr, this->user ? this->user : "?", 10);
+      return;
+   case USERTOTALS_FIELD_UID: xSnprintf(buffer, n, "%5u ", (unsigned int)totals->uid); break;
+   case USERTOTALS_FIELD_PROCESSES: xSnprintf(buffer, n, "%5u ", totals->processes); break;
+   case USERTOTALS_FIELD_TASKS: xSnprintf(buffer, n, "%5u ", totals->tasks); break;
+   case USERTOTALS_FIELD_CPU_PERCENT: Row_printPercentage(totals->percentCpu, buffer, n, 5, &attr); break;
+   case USERTOTALS_FIELD_RESIDENT: Row_printKBytes(str, totals->resident, coloring); return;
+   case USERTOTALS_FIELD_PSS: Row_printKBytes(str, totals->pss, coloring); return;
+   case USERTOTALS_FIELD_IO_READ_RATE: Row_printRate(str, totals->ioReadRate, coloring); return;
+   case USERTOTALS_FIELD_IO_WRITE_RATE: Row_printRate(str, totals->ioWriteRate, coloring); return;
+   default:
+      assert(0 && "UserTotalsRow_writeField: default key reached"); /* should never be reached */
+      xSnprintf(buffer, n, "- ");
+      break;
+   }
+
+   RichString_appendAscii(str, attr, buffer);
+}
+
+static int UserTotalsRow_compareByKey(const UserTotalsRow* u1, const UserTotalsRow* u2, RowField key) {
+   const UserTotals* t1 = &u1->totals;
+   const UserTotals* t2 = &u2->totals;
+
+   switch ((int)key - UserTotalsField_key(0)) {
+   case USERTOTALS_FIELD_USER:
+      return SPACESHIP_NULLSTR(u1->user, u2->user);
+   case USERTOTALS_FIELD_UID:
+      return SPACESHIP_NUMBER(t1->uid, t2->uid);
+   case USERTOTALS_FIELD_PROCESSES:
+      return SPACESHIP_NUMBER(t1->processes, t2->processes);
+   case USERTOTALS_FIELD_TASKS:
+      return SPACESHIP_NUMBER(t1->tasks, t2->tasks);
+   case USERTOTALS_FIELD_CPU_PERCENT:
+      return compareRealNumbers(t1->percentCpu, t2->percentCpu);
+   case USERTOTALS_FIELD_RESIDENT:
+      return SPACESHIP_NUMBER(t1->resident, t2->resident);
+   case USERTOTALS_FIELD_PSS:
+      return SPACESHIP_NUMBER(t1->pss, t2->pss);
+   case USERTOTALS_FIELD_IO_READ_RATE:
+      return compareRealNumbers(t1->ioReadRate, t2->ioReadRate);
+   case USERTOTALS_FIELD_IO_WRITE_RATE:
+      return compareRealNumbers(t1->ioWriteRate, t2->ioWriteRate);
+   default:
+      return 0;
+   }
+}
+
+static int UserTotalsRow_compare(const void* v1, const void* v2) {
+   const UserTotalsRow* u1 = (const UserTotalsRow*)v1;
+   const UserTotalsRow* u2 = (const UserTotalsRow*)v2;
+   const ScreenSettings* ss = u1->super.host->settings->ss;
+   RowField key = ScreenSettings_getActiveSortKey(ss);
+   int result = UserTotalsRow_compareByKey(u1, u2, key);
+
+   // Implement tie-breaker (keeps the order of equal users across updates)
+   if (!result)
+      return SPACESHIP_NUMBER(u1->totals.uid, u2->totals.uid);
+
+   return (ScreenSettings_getActiveDirection(ss) == 1) ? result : -result;
+}
+
+static const char* UserTotalsRow_sortKeyString(Row* super) {
+   const UserTotalsRow* this = (const UserTotalsRow*) super;
+   return this->user;
+}
+
+static bool UserTotalsRow_matchesFilter(Row* super, const Table* table) {
+   const UserTotalsRow* this = (const UserTotalsRow*) super;
+   return !this->user || !FilterMatcher_matches(&table->filter, this->user);
+}
+
+void UserTotalsRow_addColumns(Hashtable* columns) {
+   for (int i = 0; i < LAST_USERTOTALS_FIELD; i++) {
+      const UserTotalsFieldData* data = &UserTotalsRow_fields[i];
+      DynamicColumn* column = xCalloc(1, sizeof(DynamicColumn));
+      String_safeStrncpy(column->name, data->name, sizeof(column->name));
+      column->heading = xStrdup(data->heading);
+      column->caption = xStrdup(data->heading);
+      column->description = xStrdup(data->description);
+      column->width = data->width;
+      column->enabled = true;
+      Hashtable_put(columns, UserTotalsField_key(i), column);
+   }
+}
+
+const RowClass UserTotalsRow_class = {
+   .super = {
+      .extends = Class(Row),
+      .display = Row_display,
+      .delete = UserTotalsRow_delete,
+      .compare = UserTotalsRow_compare,
+   },
+   .writeField = UserTotalsRow_writeField,
+   .matchesFilter = UserTotalsRow_matchesFilter,
+   .sortKeyString = UserTotalsRow_sortKeyString,
+};
@@ -0,0 +1,50 @@
+#ifndef HEADER_UserTotalsRow
+#define HEADER_UserTotalsRow
+/*
+htop - linux/UserTotalsRow.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "Hashtable.h"
+#include "Machine.h"
+#include "Object.h"
+#include "Row.h"
+#include "RowField.h"
+#include "linux/CGroupRow.h"
+#include "linux/UserTotalsTable.h"
+
+
+/* Columns of the user screen, keyed after the ones of the cgroup screen */
+typedef enum UserTotalsField_ {
+   USERTOTALS_FIELD_USER,
+   USERTOTALS_FIELD_UID,
+   USERTOTALS_FIELD_PROCESSES,
+   USERTOTALS_FIELD_TASKS,
+   USERTOTALS_FIELD_CPU_PERCENT,
+   USERTOTALS_FIELD_RESIDENT,
+   USERTOTALS_FIELD_PSS,
+   USERTOTALS_FIELD_IO_READ_RATE,
+   USERTOTALS_FIELD_IO_WRITE_RATE,
+   LAST_USERTOTALS_FIELD
+} UserTotalsField;
+
+#define UserTotalsField_key(f_)  ((RowField)(CGroupField_key(LAST_CGROUP_FIELD) + (f_)))
+
+/* One user of the process table with the totals of their processes */
+typedef struct UserTotalsRow_ {
+   Row super;
+
+   const char* user;                     /* owned by the UsersTable of the host */
+   UserTotals totals;
+} UserTotalsRow;
+
+extern const RowClass UserTotalsRow_class;
+
+UserTotalsRow* UserTotalsRow_new(const Machine* host);
+
+/* Adds the dynamic columns of the user screen to `columns` */
+void UserTotalsRow_addColumns(Hashtable* columns);
+
+#endif
@@ -0,0 +1,99 @@
+/*
+htop - linux/UserTotalsTable.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/UserTotalsTable.h"
+
+#include <limits.h>
+#include <string.h>
+
+#include "Macros.h"
+#include "Object.h"
+#include "ProcessTable.h"
+#include "Row.h"
+#include "UsersTable.h"
+#include "XUtils.h"
+
+#include "linux/LinuxProcessTable.h"
+#include "linux/UserTotalsRow.h"
+
+
+UserTotals* UserTotalsList_get(UserTotalsList* this, uid_t uid) {
+   /* processes of a user tend to come in runs */
+   if (this->last < this->count && this->items[this->last].uid == uid)
+      return &this->items[this->last];
+
+   for (size_t i = 0; i < this->count; i++) {
+      if (this->items[i].uid == uid) {
+         this->last = i;
+         return &this->items[i];
+      }
+   }
+
+   if (this->count == this->size) {
+      this->size = this->size ? 2 * this->size : 16;
+      this->items = xReallocArray(this->items, this->size, sizeof(UserTotals));
+   }
+
+   UserTotals* totals = &this->items[this->count];
+   memset(totals, 0, sizeof(UserTotals));
+   totals->uid = uid;
+   this->last = this->count++;
+   return totals;
+}
+
+UserTotalsTable* UserTotalsTable_new(Machine* host) {
+   UserTotalsTable* this = xCalloc(1, sizeof(UserTotalsTable));
+   Object_setClass(this, Class(UserTotalsTable));
+   Table_init(&this->super, Class(UserTotalsRow), host);
+   return this;
+}
+
+static void UserTotalsTable_delete(Object* cast) {
+   UserTotalsTable* this = (UserTotalsTable*) cast;
+   Table_done(&this->super);
+   free(this);
+}
+
+static void UserTotalsTable_iterateEntries(Table* super) {
+   Machine* host = super->host;
+   const LinuxProcessTable* processTable = (const LinuxProcessTable*) host->processTable;
+   if (!processTable)
+      return;
+
+   const UserTotalsList* list = &processTable->userTotals;
+   for (size_t i = 0; i < list->count; i++) {
+      const UserTotals* totals = &list->items[i];
+      const int id = (int)(totals->uid & INT_MAX);
+
+      UserTotalsRow* row = (UserTotalsRow*) Table_findRow(super, id);
+      if (row) {
+         row->super.tombStampMs = 0;
+      } else {
+         row = UserTotalsRow_new(host);
+         row->super.id = id;
+         row->super.group = id;
+         Table_add(super, &row->super);
+      }
+
+      row->totals = *totals;
+      row->user = UsersTable_getRef(host->usersTable, totals->uid);
+      Table_markUpdated(super, &row->super);
+      row->super.show = true;
+   }
+}
+
+const TableClass UserTotalsTable_class = {
+   .super = {
+      .extends = Class(Table),
+      .delete = UserTotalsTable_delete,
+   },
+   .prepare = Table_prepareEntries,
+   .iterate = UserTotalsTable_iterateEntries,
+   .cleanup = Table_cleanupEntries,
+};
@@ -0,0 +1,62 @@
+#ifndef HEADER_UserTotalsTable
+#define HEADER_UserTotalsTable
+/*
+htop - linux/UserTotalsTable.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdlib.h>
+#include <sys/types.h>
+
+#include "Machine.h"
+#include "Table.h"
+#include "linux/LinuxProcess.h"
+
+
+/* Collectors of the process table the columns of the user screen rely on */
+#define USERTOTALS_PROCESS_FLAGS (PROCESS_FLAG_IO | PROCESS_FLAG_LINUX_SMAPS)
+
+/* What the userland processes of one user add up to in a scan of the process table */
+typedef struct UserTotals_ {
+   uid_t uid;
+   unsigned int processes;
+   unsigned int tasks;             /* processes and their threads */
+   float percentCpu;
+   unsigned long long resident;    /* kB */
+   unsigned long long pss;         /* kB, of the processes whose smaps were read so far */
+   double ioReadRate;              /* bytes per second, of the processes whose rates are known */
+   double ioWriteRate;
+} UserTotals;
+
+/* Totals per UID, filled in by the process table while it reads /proc */
+typedef struct UserTotalsList_ {
+   UserTotals* items;
+   size_t count;
+   size_t size;
+   size_t last;                    /* index of the last user looked up, usually the next one */
+} UserTotalsList;
+
+/* The entry of `uid`, added with zero totals if it is not there yet */
+UserTotals* UserTotalsList_get(UserTotalsList* this, uid_t uid);
+
+static inline void UserTotalsList_clear(UserTotalsList* this) {
+   this->count = 0;
+   this->last = 0;
+}
+
+static inline void UserTotalsList_done(UserTotalsList* this) {
+   free(this->items);
+}
+
+/* One row per user of the totals the process table gathered in its last scan */
+typedef struct UserTotalsTable_ {
+   Table super;
+} UserTotalsTable;
+
+extern const TableClass UserTotalsTable_class;
+
+UserTotalsTable* UserTotalsTable_new(Machine* host);
+
+#endif
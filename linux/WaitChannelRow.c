@@ -0,0 +1,147 @@
+/*
+htop - linux/WaitChannelRow.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/WaitChannelRow.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "CRT.h"
+#include "DynamicColumn.h"
+#include "Macros.h"
+#include "RichString.h"
+#include "Settings.h"
+#include "Table.h"
+#include "XUtils.h"
+
+
+typedef struct WaitChannelFieldData_ {
+   const char* name;          /* stored in htoprc as Dynamic(name) */
+   const char* heading;
+   const char* description;
+   int width;                 /* as in DynamicColumn, without the trailing space */
+} WaitChannelFieldData;
+
+static const WaitChannelFieldData WaitChannelRow_fields[LAST_WAITCHANNEL_FIELD] = {
+   [WAITCHANNEL_FIELD_NAME] = { .name = "wait_channel", .heading = "WCHAN", .description = "Kernel function the tasks sleep in (from /proc/<pid>/wchan)", .width = -32, },
+   [WAITCHANNEL_FIELD_BLOCKED] = { .name = "wait_blocked", .heading = "BLOCKED", .description = "Number of tasks in uninterruptible sleep (D) in the function", .width = 7, },
+   [WAITCHANNEL_FIELD_SLEEPING] = { .name = "wait_sleeping", .heading = "SLEEPING", .description = "Number of tasks in interruptible sleep (S) in the function", .width = 8, },
+   [WAITCHANNEL_FIELD_TASKS] = { .name = "wait_tasks", .heading = "TASKS", .description = "Number of tasks sleeping in the function", .width = 5, },
+   [WAITCHANNEL_FIELD_EXAMPLE] = { .name = "wait_example", .heading = "EXAMPLE", .description = "One of the tasks sleeping in the function, a blocked one if any", .width = -30, },
+};
+
+WaitChannelRow* WaitChannelRow_new(const Machine* host) {
+   WaitChannelRow* this = xCalloc(1, sizeof(WaitChannelRow));
+   Object_setClass(this, Class(WaitChannelRow));
+   Row_init(&this->super, host);
+   return this;
+}
+
+static void WaitChannelRow_delete(Object* cast) {
+   WaitChannelRow* this = (WaitChannelRow*) cast;
+   Row_done(&this->super);
+   free(this);
+}
+
+static void WaitChannelRow_writeField(const Row* super, RichString* str, RowField field) {
+   const WaitChannelRow* this = (const WaitChannelRow*) super;
+   const WaitChannel* channel = &this->channel;
+   char buffer[256];
+   size_t n = sizeof(buffer);
+   int attr = CRT_colors[DEFAULT_COLOR];
+
+   switch ((int)field - WaitChannelField_key(0)) {
+   case WAITCHANNEL_FIELD_NAME:
+      Row_printLeftAlignedField(str, attr, channel->name, 32);
+      return;
+   case WAITCHANNEL_FIELD_BLOCKED:
+      attr = channel->blocked ? CRT_colors[PROCESS_D_STATE] : CRT_colors[PROCESS_SHADOW];
+      xSnprintf(buffer, n, "%7u ", channel->blocked);
+      break;
+   case WAITCHANNEL_FIELD_SLEEPING: xSnprintf(buffer, n, "%8u ", channel->sleeping); break;
+   case WAITCHANNEL_FIELD_TASKS: xSnprintf(buffer, n, "%5u ", channel->blocked + channel->sleeping); break;
+   case WAITCHANNEL_FIELD_EXAMPLE:
+      xSnprintf(buffer, n, "%d %s", (int)channel->pid, channel->command);
+      Row_printLeftAlignedField(str, attr, buffer, 30);
+      return;
+   default:
+      assert(0 && "WaitChannelRow_writeField: default key reached"); /* should never be reached */
+      xSnprintf(buffer, n, "- ");
+      break;
+   }
+
+   RichString_appendAscii(str, attr, buffer);
+}
+
+static int WaitChannelRow_compareByKey(const WaitChannel* c1, const WaitChannel* c2, RowField key) {
+   switch ((int)key - WaitChannelField_key(0)) {
+   case WAITCHANNEL_FIELD_NAME:
+      return SPACESHIP_NULLSTR(c1->name, c2->name);
+   case WAITCHANNEL_FIELD_BLOCKED:
+      return SPACESHIP_NUMBER(c1->blocked, c2->blocked);
+   case WAITCHANNEL_FIELD_SLEEPING:
+      return SPACESHIP_NUMBER(c1->sleeping, c2->sleeping);
+   case WAITCHANNEL_FIELD_TASKS:
+      return SPACESHIP_NUMBER(c1->blocked + c1->sleeping, c2->blocked + c2->sleeping);
+   case WAITCHANNEL_FIELD_EXAMPLE:
+      return SPACESHIP_NUMBER(c1->pid, c2->pid);
+   default:
+      return 0;
+   }
+}
+
+static int WaitChannelRow_compare(const void* v1, const void* v2) {
+   const WaitChannelRow* w1 = (const WaitChannelRow*)v1;
+   const WaitChannelRow* w2 = (const WaitChannelRow*)v2;
+   const ScreenSettings* ss = w1->super.host->settings->ss;
+   RowField key = ScreenSettings_getActiveSortKey(ss);
+   int result = WaitChannelRow_compareByKey(&w1->channel, &w2->channel, key);
+
+   // Implement tie-breaker (keeps the order of equal channels across updates)
+   if (!result)
+      return SPACESHIP_NUMBER(w1->super.id, w2->super.id);
+
+   return (ScreenSettings_getActiveDirection(ss) == 1) ? result : -result;
+}
+
+static const char* WaitChannelRow_sortKeyString(Row* super) {
+   const WaitChannelRow* this = (const WaitChannelRow*) super;
+   return this->channel.name;
+}
+
+static bool WaitChannelRow_matchesFilter(Row* super, const Table* table) {
+   const WaitChannelRow* this = (const WaitChannelRow*) super;
+   return !FilterMatcher_matches(&table->filter, this->channel.name);
+}
+
+void WaitChannelRow_addColumns(Hashtable* columns) {
+   for (int i = 0; i < LAST_WAITCHANNEL_FIELD; i++) {
+      const WaitChannelFieldData* data = &WaitChannelRow_fields[i];
+      DynamicColumn* column = xCalloc(1, sizeof(DynamicColumn));
+      String_safeStrncpy(column->name, data->name, sizeof(column->name));
+      column->heading = xStrdup(data->heading);
+      column->caption = xStrdup(data->heading);
+      column->description = xStrdup(data->description);
+      column->width = data->width;
+      column->enabled = true;
+      Hashtable_put(columns, WaitChannelField_key(i), column);
+   }
+}
+
+const RowClass WaitChannelRow_class = {
+   .super = {
+      .extends = Class(Row),
+      .display = Row_display,
+      .delete = WaitChannelRow_delete,
+      .compare = WaitChannelRow_compare,
+   },
+   .writeField = WaitChannelRow_writeField,
+   .matchesFilter = WaitChannelRow_matchesFilter,
+   .sortKeyString = WaitChannelRow_sortKeyString,
+};
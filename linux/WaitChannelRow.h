@@ -0,0 +1,45 @@
+#ifndef HEADER_WaitChannelRow
+#define HEADER_WaitChannelRow
+/*
+htop - linux/WaitChannelRow.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "Hashtable.h"
+#include "Machine.h"
+#include "Object.h"
+#include "Row.h"
+#include "RowField.h"
+#include "linux/UserTotalsRow.h"
+#include "linux/WaitChannelTable.h"
+
+
+/* Columns of the wait channel screen, keyed after the ones of the user screen */
+typedef enum WaitChannelField_ {
+   WAITCHANNEL_FIELD_NAME,
+   WAITCHANNEL_FIELD_BLOCKED,
+   WAITCHANNEL_FIELD_SLEEPING,
+   WAITCHANNEL_FIELD_TASKS,
+   WAITCHANNEL_FIELD_EXAMPLE,
+   LAST_WAITCHANNEL_FIELD
+} WaitChannelField;
+
+#define WaitChannelField_key(f_)  ((RowField)(UserTotalsField_key(LAST_USERTOTALS_FIELD) + (f_)))
+
+/* One kernel function with the tasks sleeping in it */
+typedef struct WaitChannelRow_ {
+   Row super;
+
+   WaitChannel channel;
+} WaitChannelRow;
+
+extern const RowClass WaitChannelRow_class;
+
+WaitChannelRow* WaitChannelRow_new(const Machine* host);
+
+/* Adds the dynamic columns of the wait channel screen to `columns` */
+void WaitChannelRow_addColumns(Hashtable* columns);
+
+#endif
@@ -0,0 +1,117 @@
+/*
+htop - linux/WaitChannelTable.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "linux/WaitChannelTable.h"
+
+#include <string.h>
+
+#include "Macros.h"
+#include "Object.h"
+#include "ProcessTable.h"
+#include "Row.h"
+#include "XUtils.h"
+
+#include "linux/LinuxProcessTable.h"
+#include "linux/WaitChannelRow.h"
+
+
+void WaitChannelList_add(WaitChannelList* this, const char* name, bool blocked, pid_t pid, const char* command) {
+   WaitChannel* channel = NULL;
+
+   /* threads of a process tend to wait in the same place */
+   if (this->last < this->count && String_eq(this->items[this->last].name, name)) {
+      channel = &this->items[this->last];
+   } else {
+      for (size_t i = 0; i < this->count; i++) {
+         if (String_eq(this->items[i].name, name)) {
+            this->last = i;
+            channel = &this->items[i];
+            break;
+         }
+      }
+   }
+
+   if (!channel) {
+      if (this->count == this->size) {
+         this->size = this->size ? 2 * this->size : 32;
+         this->items = xReallocArray(this->items, this->size, sizeof(WaitChannel));
+      }
+
+      channel = &this->items[this->count];
+      memset(channel, 0, sizeof(WaitChannel));
+      String_safeStrncpy(channel->name, name, sizeof(channel->name));
+      this->last = this->count++;
+   }
+
+   if (blocked ? channel->blocked == 0 : channel->blocked + channel->sleeping == 0) {
+      channel->pid = pid;
+      if (command)
+         String_safeStrncpy(channel->command, command, sizeof(channel->command));
+      else
+         channel->command[0] = '\0';
+   }
+
+   if (blocked) {
+      channel->blocked++;
+   } else {
+      channel->sleeping++;
+   }
+}
+
+WaitChannelTable* WaitChannelTable_new(Machine* host) {
+   WaitChannelTable* this = xCalloc(1, sizeof(WaitChannelTable));
+   Object_setClass(this, Class(WaitChannelTable));
+   Table_init(&this->super, Class(WaitChannelRow), host);
+   return this;
+}
+
+static void WaitChannelTable_delete(Object* cast) {
+   WaitChannelTable* this = (WaitChannelTable*) cast;
+   Table_done(&this->super);
+   free(this);
+}
+
+static void WaitChannelTable_iterateEntries(Table* super) {
+   Machine* host = super->host;
+   const LinuxProcessTable* processTable = (const LinuxProcessTable*) host->processTable;
+   if (!processTable)
+      return;
+
+   const WaitChannelList* list = &processTable->waitChannels;
+   for (size_t i = 0; i < list->count; i++) {
+      const WaitChannel* channel = &list->items[i];
+      if (channel->blocked + channel->sleeping == 0)
+         continue;
+
+      const int id = (int)i + 1;
+      WaitChannelRow* row = (WaitChannelRow*) Table_findRow(super, id);
+      if (row) {
+         row->super.tombStampMs = 0;
+      } else {
+         row = WaitChannelRow_new(host);
+         row->super.id = id;
+         row->super.group = id;
+         Table_add(super, &row->super);
+      }
+
+      row->channel = *channel;
+      Table_markUpdated(super, &row->super);
+      row->super.show = true;
+   }
+}
+
+const TableClass WaitChannelTable_class = {
+   .super = {
+      .extends = Class(Table),
+      .delete = WaitChannelTable_delete,
+   },
+   .prepare = Table_prepareEntries,
+   .iterate = WaitChannelTable_iterateEntries,
+   .cleanup = Table_cleanupEntries,
+};
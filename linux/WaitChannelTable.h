@@ -0,0 +1,58 @@
+#ifndef HEADER_WaitChannelTable
+#define HEADER_WaitChannelTable
+/*
+htop - linux/WaitChannelTable.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/types.h>
+
+#include "Machine.h"
+#include "Table.h"
+
+
+/* The tasks sleeping in one kernel function in a scan of the process table */
+typedef struct WaitChannel_ {
+   char name[64];
+   unsigned int blocked;           /* in uninterruptible sleep (D) */
+   unsigned int sleeping;          /* in interruptible sleep (S) */
+   pid_t pid;                      /* the first task seen waiting in it, blocked ones first */
+   char command[32];
+} WaitChannel;
+
+/* Wait channels by name, filled in by the process table while it reads /proc */
+typedef struct WaitChannelList_ {
+   WaitChannel* items;             /* kept across scans, the index is the id of the row */
+   size_t count;
+   size_t size;
+   size_t last;                    /* index of the last channel looked up */
+} WaitChannelList;
+
+/* Counts a task sleeping in `name`, blocked if uninterruptibly */
+void WaitChannelList_add(WaitChannelList* this, const char* name, bool blocked, pid_t pid, const char* command);
+
+static inline void WaitChannelList_clear(WaitChannelList* this) {
+   for (size_t i = 0; i < this->count; i++) {
+      this->items[i].blocked = 0;
+      this->items[i].sleeping = 0;
+   }
+}
+
+static inline void WaitChannelList_done(WaitChannelList* this) {
+   free(this->items);
+}
+
+/* One row per wait channel with tasks in it in the last scan of the process table */
+typedef struct WaitChannelTable_ {
+   Table super;
+} WaitChannelTable;
+
+extern const TableClass WaitChannelTable_class;
+
+WaitChannelTable* WaitChannelTable_new(Machine* host);
+
+#endif
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+htop - linux/bpf/htop_futex.bpf.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+
+Sums up the time each thread group waits in futex(2), the system call
+behind contended mutexes, condition variables and other locks of user
+space, into the map read by linux/BpfFutex.c. Only the waiting operations
+count, not the wakes. It is not built with htop; compile, load and pin it with
+
+   bpftool btf dump file /sys/kernel/btf/vmlinux format c > vmlinux.h
+   clang -O2 -g -target bpf -c htop_futex.bpf.c -o htop_futex.bpf.o
+   bpftool prog loadall htop_futex.bpf.o /sys/fs/bpf/htop_futex_progs \
+      pinmaps /sys/fs/bpf/htop_futex autoattach
+
+and build htop with --enable-bpf-columns. Reading the pinned map requires
+CAP_BPF (or CAP_SYS_ADMIN), or relaxed permissions on bpffs. Without
+autoattach the programs are only pinned, and htop attaches them itself
+while FUTEX_WAIT_PERCENT is shown (see linux/Bpf.c), which also requires
+CAP_PERFMON.
+*/
+
+#include "vmlinux.h"
+
+#include <bpf/bpf_helpers.h>
+
+
+char LICENSE[] SEC("license") = "GPL";
+
+/* From linux/futex.h, which vmlinux.h does not have as they are macros */
+#define FUTEX_WAIT            0
+#define FUTEX_LOCK_PI         6
+#define FUTEX_WAIT_BITSET     9
+#define FUTEX_WAIT_REQUEUE_PI 11
+#define FUTEX_LOCK_PI2        13
+#define FUTEX_PRIVATE_FLAG    128
+#define FUTEX_CLOCK_REALTIME  256
+
+/* Nanoseconds waited by each thread group, read by htop; least recently used ones give way */
+struct {
+   __uint(type, BPF_MAP_TYPE_LRU_HASH);
+   __uint(max_entries, 32768);
+   __type(key, __u32);
+   __type(value, __u64);
+} htop_futex_wait SEC(".maps");
+
+/* When each thread (by its pid) entered a waiting call */
+struct {
+   __uint(type, BPF_MAP_TYPE_LRU_HASH);
+   __uint(max_entries, 65536);
+   __type(key, __u32);
+   __type(value, __u64);
+} htop_futex_start SEC(".maps");
+
+SEC("tracepoint/syscalls/sys_enter_futex")
+int htop_futex_enter(struct trace_event_raw_sys_enter* ctx) {
+   int op = (int)ctx->args[1] & ~(FUTEX_PRIVATE_FLAG | FUTEX_CLOCK_REALTIME);
+   if (op != FUTEX_WAIT && op != FUTEX_WAIT_BITSET && op != FUTEX_LOCK_PI &&
+       op != FUTEX_LOCK_PI2 && op != FUTEX_WAIT_REQUEUE_PI)
+      return 0;
+
+   __u32 tid = (__u32)bpf_get_current_pid_tgid();
+   __u64 now = bpf_ktime_get_ns();
+   bpf_map_update_elem(&htop_futex_start, &tid, &now, BPF_ANY);
+   return 0;
+}
+
+SEC("tracepoint/syscalls/sys_exit_futex")
+int htop_futex_exit(struct trace_event_raw_sys_exit* ctx) {
+   __u64 pidTgid = bpf_get_current_pid_tgid();
+   __u32 tid = (__u32)pidTgid;
+   __u64* start = bpf_map_lookup_elem(&htop_futex_start, &tid);
+   if (!start)
+      return 0;
+
+   __u64 waited = bpf_ktime_get_ns() - *start;
+   bpf_map_delete_elem(&htop_futex_start, &tid);
+
+   __u32 tgid = pidTgid >> 32;
+   __u64* total = bpf_map_lookup_elem(&htop_futex_wait, &tgid);
+   if (!total) {
+      __u64 zero = 0;
+      bpf_map_update_elem(&htop_futex_wait, &tgid, &zero, BPF_NOEXIST);
+      total = bpf_map_lookup_elem(&htop_futex_wait, &tgid);
+      if (!total)
+         return 0;
+   }
+
+   __sync_fetch_and_add(total, waited);
+   return 0;
+}
@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+htop - linux/bpf/htop_net.bpf.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+
+Counts the bytes each thread group sends and receives over TCP and UDP
+sockets into the map read by linux/BpfNet.c. No packet is looked at: the
+counts come from the socket calls that copy the data to and from the
+process. It is not built with htop; compile, load and pin it with
+
+   bpftool btf dump file /sys/kernel/btf/vmlinux format c > vmlinux.h
+   clang -O2 -g -target bpf -c htop_net.bpf.c -o htop_net.bpf.o
+   bpftool prog loadall htop_net.bpf.o /sys/fs/bpf/htop_net_progs \
+      pinmaps /sys/fs/bpf/htop_net autoattach
+
+and build htop with --enable-bpf-columns. Reading the pinned map requires
+CAP_BPF (or CAP_SYS_ADMIN), or relaxed permissions on bpffs. Without
+autoattach the programs are only pinned, and htop attaches them itself
+while NET_RX or NET_TX is shown (see linux/Bpf.c), which also requires
+CAP_PERFMON.
+*/
+
+#include "vmlinux.h"
+
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_tracing.h>
+
+
+char LICENSE[] SEC("license") = "GPL";
+
+/* Same layout as BpfNetBytes in linux/BpfNet.h */
+struct htop_net_bytes {
+   __u64 rx;
+   __u64 tx;
+};
+
+/* Least recently used thread groups give way, exited ones are not removed */
+struct {
+   __uint(type, BPF_MAP_TYPE_LRU_HASH);
+   __uint(max_entries, 32768);
+   __type(key, __u32);
+   __type(value, struct htop_net_bytes);
+} htop_net_bytes SEC(".maps");
+
+static void htop_net_count(long bytes, bool tx) {
+   if (bytes <= 0)
+      return;
+
+   __u32 tgid = bpf_get_current_pid_tgid() >> 32;
+   struct htop_net_bytes* counts = bpf_map_lookup_elem(&htop_net_bytes, &tgid);
+   if (!counts) {
+      struct htop_net_bytes zero = { 0 };
+      bpf_map_update_elem(&htop_net_bytes, &tgid, &zero, BPF_NOEXIST);
+      counts = bpf_map_lookup_elem(&htop_net_bytes, &tgid);
+      if (!counts)
+         return;
+   }
+
+   if (tx)
+      __sync_fetch_and_add(&counts->tx, bytes);
+   else
+      __sync_fetch_and_add(&counts->rx, bytes);
+}
+
+SEC("fexit/tcp_sendmsg")
+int BPF_PROG(htop_tcp_sendmsg, struct sock* sk, struct msghdr* msg, size_t size, int ret) {
+   htop_net_count(ret, true);
+   return 0;
+}
+
+/* Called with what a read took off the receive queue, also for splice and zero-copy receive */
+SEC("fentry/tcp_cleanup_rbuf")
+int BPF_PROG(htop_tcp_cleanup_rbuf, struct sock* sk, int copied) {
+   htop_net_count(copied, false);
+   return 0;
+}
+
+SEC("fexit/udp_sendmsg")
+int BPF_PROG(htop_udp_sendmsg, struct sock* sk, struct msghdr* msg, size_t len, int ret) {
+   htop_net_count(ret, true);
+   return 0;
+}
+
+/* The arguments of the receive calls changed in Linux 5.19, a kretprobe only needs the result */
+SEC("kretprobe/udp_recvmsg")
+int BPF_KRETPROBE(htop_udp_recvmsg, int ret) {
+   htop_net_count(ret, false);
+   return 0;
+}
+
+SEC("fexit/udpv6_sendmsg")
+int BPF_PROG(htop_udpv6_sendmsg, struct sock* sk, struct msghdr* msg, size_t len, int ret) {
+   htop_net_count(ret, true);
+   return 0;
+}
+
+SEC("kretprobe/udpv6_recvmsg")
+int BPF_KRETPROBE(htop_udpv6_recvmsg, int ret) {
+   htop_net_count(ret, false);
+   return 0;
+}
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+htop - linux/bpf/htop_syscalls.bpf.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+
+Counts the system calls each thread group enters, and which of them are
+the most frequent, into the map read by linux/BpfSyscalls.c. Only a counter
+is incremented per call, from the raw_syscalls:sys_enter tracepoint, so it
+costs much less than tracing the calls. It is not built with htop; compile,
+load and pin it with
+
+   bpftool btf dump file /sys/kernel/btf/vmlinux format c > vmlinux.h
+   clang -O2 -g -target bpf -c htop_syscalls.bpf.c -o htop_syscalls.bpf.o
+   bpftool prog loadall htop_syscalls.bpf.o /sys/fs/bpf/htop_syscalls_progs \
+      pinmaps /sys/fs/bpf/htop_syscalls autoattach
+
+and build htop with --enable-bpf-columns. Reading the pinned map requires
+CAP_BPF (or CAP_SYS_ADMIN), or relaxed permissions on bpffs. Without
+autoattach the program is only pinned, and htop attaches it itself while
+SYSCALL_RATE or TOP_SYSCALL is shown (see linux/Bpf.c), which also requires
+CAP_PERFMON.
+*/
+
+#include "vmlinux.h"
+
+#include <bpf/bpf_helpers.h>
+
+
+char LICENSE[] SEC("license") = "GPL";
+
+/* Same as BPF_SYSCALLS_TOP in linux/BpfSyscalls.h */
+#define HTOP_SYSCALLS_TOP 4
+
+/* Same layout as BpfSyscallsCounts in linux/BpfSyscalls.h */
+struct htop_syscalls {
+   __u64 total;
+   __u32 nr[HTOP_SYSCALLS_TOP];
+   __u64 count[HTOP_SYSCALLS_TOP];
+};
+
+/* Least recently used thread groups give way, exited ones are not removed */
+struct {
+   __uint(type, BPF_MAP_TYPE_LRU_HASH);
+   __uint(max_entries, 32768);
+   __type(key, __u32);
+   __type(value, struct htop_syscalls);
+} htop_syscalls SEC(".maps");
+
+/*
+ * The histogram keeps the most frequent calls like the space-saving
+ * algorithm: a call not in it takes the slot counted least. Threads of a
+ * group racing for a slot may lose a count, the total stays exact.
+ */
+SEC("tracepoint/raw_syscalls/sys_enter")
+int htop_syscalls_enter(struct trace_event_raw_sys_enter* ctx) {
+   __u32 tgid = bpf_get_current_pid_tgid() >> 32;
+   struct htop_syscalls* counts = bpf_map_lookup_elem(&htop_syscalls, &tgid);
+   if (!counts) {
+      struct htop_syscalls zero = { 0 };
+      bpf_map_update_elem(&htop_syscalls, &tgid, &zero, BPF_NOEXIST);
+      counts = bpf_map_lookup_elem(&htop_syscalls, &tgid);
+      if (!counts)
+         return 0;
+   }
+
+   __sync_fetch_and_add(&counts->total, 1);
+
+   /* numbered after the ABI of the call, which is another one for 32 bit programs on 64 bit kernels */
+   __u32 nr = (__u32)ctx->id;
+   int least = 0;
+   for (int i = 0; i < HTOP_SYSCALLS_TOP; i++) {
+      if (counts->count[i] && counts->nr[i] == nr) {
+         __sync_fetch_and_add(&counts->count[i], 1);
+         return 0;
+      }
+      if (counts->count[i] < counts->count[least])
+         least = i;
+   }
+
+   counts->nr[least] = nr;
+   counts->count[least] += 1;
+   return 0;
+}
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+htop - linux/bpf/htop_tasks.bpf.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+
+BPF task iterator dumping one line per task in the format read by
+linux/BpfTaskIter.c. It is not built with htop; compile and pin it with
+
+   bpftool btf dump file /sys/kernel/btf/vmlinux format c > vmlinux.h
+   clang -O2 -g -target bpf -c htop_tasks.bpf.c -o htop_tasks.bpf.o
+   bpftool iter pin htop_tasks.bpf.o /sys/fs/bpf/htop_tasks
+
+and build htop with --enable-bpf-iter. Reading the pinned file requires
+the same privileges as other BPF pseudo files (usually CAP_SYS_ADMIN or
+CAP_BPF and CAP_PERFMON, or relaxed permissions on bpffs).
+*/
+
+#include "vmlinux.h"
+
+#include <bpf/bpf_core_read.h>
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_tracing.h>
+
+
+char LICENSE[] SEC("license") = "GPL";
+
+/* mm_struct before Linux 6.2 kept the RSS counters in an embedded struct */
+struct mm_rss_stat___old {
+   atomic_long_t count[4];
+};
+
+struct mm_struct___old {
+   struct mm_rss_stat___old rss_stat;
+};
+
+static long htop_mm_counter(struct mm_struct* mm, int member) {
+   if (bpf_core_field_exists(((struct mm_struct___old*)0)->rss_stat.count))
+      return BPF_CORE_READ((struct mm_struct___old*)mm, rss_stat.count[member].counter);
+
+   /* percpu_counter: only the global part, good enough for display */
+   return BPF_CORE_READ(mm, rss_stat[member].count);
+}
+
+/* Same letters as fs/proc/array.c */
+static char htop_task_state(struct task_struct* task) {
+   unsigned int state = BPF_CORE_READ(task, __state);
+   unsigned int exit_state = BPF_CORE_READ(task, exit_state);
+
+   if (exit_state & EXIT_ZOMBIE)
+      return 'Z';
+   if (exit_state & EXIT_DEAD)
+      return 'X';
+   if ((state & TASK_IDLE) == TASK_IDLE)
+      return 'I';
+   if (state & TASK_UNINTERRUPTIBLE)
+      return 'D';
+   if (state & TASK_INTERRUPTIBLE)
+      return 'S';
+   if (state & __TASK_STOPPED)
+      return 'T';
+   if (state & __TASK_TRACED)
+      return 't';
+   if (state & TASK_PARKED)
+      return 'P';
+   return 'R';
+}
+
+/* new_encode_dev() of the controlling terminal, as /proc/<pid>/stat shows it */
+static unsigned long htop_tty_nr(struct task_struct* task) {
+   struct tty_struct* tty = BPF_CORE_READ(task, signal, tty);
+   if (!tty)
+      return 0;
+
+   unsigned int major = BPF_CORE_READ(tty, driver, major);
+   unsigned int minor = BPF_CORE_READ(tty, driver, minor_start) + BPF_CORE_READ(tty, index);
+   return (minor & 0xff) | (major << 8) | ((minor & ~0xffu) << 12);
+}
+
+SEC("iter/task")
+int htop_tasks(struct bpf_iter__task* ctx) {
+   struct seq_file* seq = ctx->meta->seq;
+   struct task_struct* task = ctx->task;
+
+   if (ctx->meta->seq_num == 0)
+      BPF_SEQ_PRINTF(seq, "htop-tasks 1\n");
+
+   if (!task)
+      return 0;
+
+   pid_t tid = task->pid;
+   pid_t tgid = task->tgid;
+   bool leader = tid == tgid;
+   struct signal_struct* signal = task->signal;
+   struct mm_struct* mm = task->mm;
+
+   pid_t ppid = BPF_CORE_READ(task, real_parent, tgid);
+   uid_t euid = BPF_CORE_READ(task, cred, euid.val);
+   pid_t pgrp = BPF_CORE_READ(signal, pids[PIDTYPE_PGID], numbers[0].nr);
+   pid_t session = BPF_CORE_READ(signal, pids[PIDTYPE_SID], numbers[0].nr);
+
+   BPF_SEQ_PRINTF(seq, "%d %d %d %c %u %d %d %lu %u ",
+                  tid, tgid, ppid, htop_task_state(task), euid, pgrp, session, htop_tty_nr(task), task->flags);
+
+   BPF_SEQ_PRINTF(seq, "%lu %lu %llu %llu %llu %llu ",
+                  task->min_flt, task->maj_flt, task->utime, task->stime,
+                  leader ? BPF_CORE_READ(signal, utime) : 0ULL,
+                  leader ? BPF_CORE_READ(signal, stime) : 0ULL);
+
+   unsigned long vsize = 0, rss = 0, shared = 0;
+   if (mm) {
+      vsize = BPF_CORE_READ(mm, total_vm);
+      long file = htop_mm_counter(mm, MM_FILEPAGES);
+      long anon = htop_mm_counter(mm, MM_ANONPAGES);
+      long shmem = htop_mm_counter(mm, MM_SHMEMPAGES);
+      rss = file + anon + shmem;
+      shared = file + shmem;
+   }
+
+   BPF_SEQ_PRINTF(seq, "%d %d %d %llu %u %lu %lu %lu %s\n",
+                  task->prio - 100, task->static_prio - 120, BPF_CORE_READ(signal, nr_threads),
+                  task->start_boottime, BPF_CORE_READ(task, thread_info.cpu),
+                  vsize, rss, shared, task->comm);
+
+   return 0;
+}
@@ -88,6 +88,8 @@ static void NetBSDMachine_updateCPUcount(NetBSDMachine* this) {
 
    // Reset CPU stats when number of online/existing CPU cores changed
    if (change) {
+      this->freqMibsResolved = false;
+
       CPUData* dAvg = &this->cpuData[0];
       memset(dAvg, '\0', sizeof(CPUData));
       dAvg->totalTime = 1;
@@ -219,49 +221,75 @@ static void NetBSDMachine_scanCPUTime(NetBSDMachine* this) {
    kernelCPUTimesToHtop(avg, &this->cpuData[0]);
 }
 
+/*
+ * Looking the frequency nodes up by name walks the sysctl tree each time,
+ * so their MIBs are resolved once and again only if the CPUs change.
+ */
+static void NetBSDMachine_resolveFrequencyMibs(NetBSDMachine* this) {
+   const Machine* super = &this->super;
+   bool found = false;
+   char name[64];
+
+   /* newer hardware supports per-core frequency, for e.g. ARM big.LITTLE */
+   for (unsigned int i = 0; i < super->existingCPUs; i++) {
+      CPUData* d = &this->cpuData[i + 1];
+      xSnprintf(name, sizeof(name), "machdep.cpufreq.cpu%u.current", i);
+      d->freqMibLen = ARRAYSIZE(d->freqMib);
+      if (sysctlnametomib(name, d->freqMib, &d->freqMibLen) == -1) {
+         d->freqMibLen = 0;
+      } else {
+         found = true;
+      }
+   }
+
+   /* else the first of the legacy nodes for single-core frequency there is */
+   this->legacyFreqMibLen = 0;
+   for (size_t i = 0; !found && i < ARRAYSIZE(freqSysctls); i++) {
+      size_t len = ARRAYSIZE(this->legacyFreqMib);
+      if (sysctlnametomib(freqSysctls[i].name, this->legacyFreqMib, &len) != -1) {
+         this->legacyFreqMibLen = len;
+         this->legacyFreqScale = freqSysctls[i].scale;
+         found = true;
+      }
+   }
+
+   this->freqMibsResolved = true;
+}
+
 static void NetBSDMachine_scanCPUFrequency(NetBSDMachine* this) {
    const Machine* super = &this->super;
    unsigned int cpus = super->existingCPUs;
    bool match = false;
-   char name[64];
    long int freq = 0;
    size_t freqSize;
 
-   for (unsigned int i = 0; i < cpus; i++) {
-      this->cpuData[i + 1].frequency = NAN;
+   if (!this->freqMibsResolved) {
+      NetBSDMachine_resolveFrequencyMibs(this);
    }
 
-   /* newer hardware supports per-core frequency, for e.g. ARM big.LITTLE */
    for (unsigned int i = 0; i < cpus; i++) {
-      xSnprintf(name, sizeof(name), "machdep.cpufreq.cpu%u.current", i);
+      CPUData* d = &this->cpuData[i + 1];
+      d->frequency = NAN;
+
       freqSize = sizeof(freq);
-      if (sysctlbyname(name, &freq, &freqSize, NULL, 0) != -1) {
-         this->cpuData[i + 1].frequency = freq; /* already in MHz */
+      if (d->freqMibLen && sysctl(d->freqMib, (u_int)d->freqMibLen, &freq, &freqSize, NULL, 0) != -1) {
+         d->frequency = freq; /* already in MHz */
          match = true;
       }
    }
 
-   if (match) {
+   if (match || !this->legacyFreqMibLen) {
       return;
    }
 
-   /*
-    * Iterate through legacy sysctl nodes for single-core frequency until
-    * we find a match...
-    */
-   for (size_t i = 0; i < ARRAYSIZE(freqSysctls); i++) {
-      freqSize = sizeof(freq);
-      if (sysctlbyname(freqSysctls[i].name, &freq, &freqSize, NULL, 0) != -1) {
-         freq /= freqSysctls[i].scale; /* scale to MHz */
-         match = true;
-         break;
-      }
+   freqSize = sizeof(freq);
+   if (sysctl(this->legacyFreqMib, (u_int)this->legacyFreqMibLen, &freq, &freqSize, NULL, 0) == -1) {
+      return;
    }
 
-   if (match) {
-      for (unsigned int i = 0; i < cpus; i++) {
-         this->cpuData[i + 1].frequency = freq;
-      }
+   freq /= this->legacyFreqScale; /* scale to MHz */
+   for (unsigned int i = 0; i < cpus; i++) {
+      this->cpuData[i + 1].frequency = freq;
    }
 }
 
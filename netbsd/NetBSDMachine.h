@@ -12,6 +12,8 @@ in the source distribution for its full text.
 
 #include <kvm.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <sys/sysctl.h>
 #include <sys/types.h>
 
 #include "Machine.h"
@@ -38,6 +40,8 @@ typedef struct CPUData_ {
    unsigned long long int idlePeriod;
 
    double frequency;
+   int freqMib[CTL_MAXNAME];      /* machdep.cpufreq.cpuN.current, resolved once */
+   size_t freqMibLen;             /* 0 if the node does not exist */
 } CPUData;
 
 typedef struct NetBSDMachine_ {
@@ -49,6 +53,11 @@ typedef struct NetBSDMachine_ {
    int pageSizeKB;
 
    CPUData* cpuData;
+
+   bool freqMibsResolved;         /* cleared when the CPU count changes */
+   int legacyFreqMib[CTL_MAXNAME];
+   size_t legacyFreqMibLen;
+   long int legacyFreqScale;
 } NetBSDMachine;
 
 #endif
@@ -32,6 +32,7 @@ in the source distribution for its full text.
 #include "Process.h"
 #include "ProcessTable.h"
 #include "Settings.h"
+#include "Table.h"
 #include "XUtils.h"
 #include "netbsd/NetBSDMachine.h"
 #include "netbsd/NetBSDProcess.h"
@@ -143,6 +144,22 @@ static void NetBSDProcessTable_updateProcessName(kvm_t* kd, const struct kinfo_p
 /*
  * Borrowed with modifications from NetBSD's top(1).
  */
+/*
+ * Whether the arguments of a known process are read again in this scan:
+ * once it ran another program, else with lazy collection only while on
+ * screen, unless all of them are filtered or sorted by their command.
+ */
+static bool NetBSDProcessTable_wantsProcessName(const ProcessTable* super, const struct kinfo_proc2* kproc, const Process* proc) {
+   if (!proc->procComm || !String_eq(proc->procComm, kproc->p_comm))
+      return true;
+
+   const Settings* settings = super->super.host->settings;
+   if (!settings->lazyCollection || super->super.incFilter || ScreenSettings_getActiveSortKey(settings->ss) == COMM)
+      return true;
+
+   return Table_isRowOnScreen(&super->super, &proc->super);
+}
+
 static double getpcpu(const NetBSDMachine* nhost, const struct kinfo_proc2* kp) {
    if (nhost->fscale == 0)
       return 0.0;
@@ -193,7 +210,7 @@ static void NetBSDProcessTable_scanProcs(NetBSDProcessTable* this) {
          NetBSDProcessTable_updateExe(kproc, proc);
          NetBSDProcessTable_updateProcessName(nhost->kd, kproc, proc);
       } else {
-         if (settings->updateProcessNames) {
+         if (settings->updateProcessNames && NetBSDProcessTable_wantsProcessName(&this->super, kproc, proc)) {
             NetBSDProcessTable_updateProcessName(nhost->kd, kproc, proc);
          }
       }
@@ -266,7 +283,7 @@ static void NetBSDProcessTable_scanProcs(NetBSDProcessTable* this) {
       if (proc->state == RUNNING) {
          this->super.runningTasks++;
       }
-      proc->super.updated = true;
+      Table_markUpdated(&this->super.super, &proc->super);
    }
 }
 
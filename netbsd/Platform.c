@@ -47,6 +47,7 @@ in the source distribution for its full text.
 #include "MemoryMeter.h"
 #include "MemorySwapMeter.h"
 #include "Meter.h"
+#include "SelfMeter.h"
 #include "Settings.h"
 #include "SignalsPanel.h"
 #include "SwapMeter.h"
@@ -164,6 +165,7 @@ const MeterClass* const Platform_meterTypes[] = {
    &MemorySwapMeter_class,
    &TasksMeter_class,
    &UptimeMeter_class,
+   &SelfMeter_class,
    &BatteryMeter_class,
    &HostnameMeter_class,
    &SysArchMeter_class,
@@ -179,6 +181,16 @@ const MeterClass* const Platform_meterTypes[] = {
    &RightCPUs4Meter_class,
    &LeftCPUs8Meter_class,
    &RightCPUs8Meter_class,
+#ifdef HAVE_LIBHWLOC
+   &CPUNodesMeter_class,
+   &CPUSocketsMeter_class,
+   &CPUCachesMeter_class,
+   &CPUCoresMeter_class,
+   &BusiestCPUNodeMeter_class,
+   &BusiestCPUSocketMeter_class,
+   &BusiestCPUCacheMeter_class,
+   &BusiestCPUCoreMeter_class,
+#endif
    &BlankMeter_class,
    &DiskIOMeter_class,
    &NetworkIOMeter_class,
@@ -348,6 +360,13 @@ FileLocks_ProcessData* Platform_getProcessLocks(pid_t pid) {
    return NULL;
 }
 
+bool Platform_getProcessOpenFiles(pid_t pid, OpenFiles_AddFile addFile, void* context) {
+   (void)pid;
+   (void)addFile;
+   (void)context;
+   return false;
+}
+
 void Platform_getFileDescriptors(double* used, double* max) {
    Generic_getFileDescriptors_sysctl(used, max);
 }
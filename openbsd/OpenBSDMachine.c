@@ -31,61 +31,68 @@ in the source distribution for its full text.
 #include "XUtils.h"
 
 
-static void OpenBSDMachine_updateCPUcount(OpenBSDMachine* this) {
+/*
+ * The number of CPUs is fixed at boot, only their online state changes
+ * (hw.smt). Per CPU it is looked at lazily, when the CPU is sampled or
+ * asked about next.
+ */
+static void OpenBSDMachine_initCPUcount(OpenBSDMachine* this) {
    Machine* super = &this->super;
    const int nmib[] = { CTL_HW, HW_NCPU };
-   const int mib[] = { CTL_HW, HW_NCPUONLINE };
-   int r;
    unsigned int value;
-   size_t size;
-   bool change = false;
+   size_t size = sizeof(value);
 
-   size = sizeof(value);
-   r = sysctl(mib, 2, &value, &size, NULL, 0);
-   if (r < 0 || value < 1) {
+   if (sysctl(nmib, 2, &value, &size, NULL, 0) < 0 || value < 1) {
       value = 1;
    }
 
-   if (value != super->activeCPUs) {
-      super->activeCPUs = value;
-      change = true;
-   }
+   super->existingCPUs = value;
+   super->activeCPUs = value;
+   this->cpuData = xCalloc(value + 1, sizeof(CPUData));
 
-   size = sizeof(value);
-   r = sysctl(nmib, 2, &value, &size, NULL, 0);
-   if (r < 0 || value < 1) {
-      value = super->activeCPUs;
+   /* taken as online until told otherwise */
+   for (unsigned int i = 0; i <= super->existingCPUs; i++) {
+      CPUData* d = &this->cpuData[i];
+      d->totalTime = 1;
+      d->totalPeriod = 1;
+      d->online = true;
    }
 
-   if (value != super->existingCPUs) {
-      this->cpuData = xReallocArray(this->cpuData, value + 1, sizeof(CPUData));
-      super->existingCPUs = value;
-      change = true;
+   /* the average is over the online CPUs */
+   this->cpuData[0].onlineKnown = true;
+}
+
+static void OpenBSDMachine_updateOnlineCPUs(OpenBSDMachine* this) {
+   Machine* super = &this->super;
+   const int mib[] = { CTL_HW, HW_NCPUONLINE };
+   unsigned int value;
+   size_t size = sizeof(value);
+
+   if (sysctl(mib, 2, &value, &size, NULL, 0) < 0 || value < 1) {
+      value = 1;
    }
 
-   if (change) {
-      CPUData* dAvg = &this->cpuData[0];
-      memset(dAvg, '\0', sizeof(CPUData));
-      dAvg->totalTime = 1;
-      dAvg->totalPeriod = 1;
-      dAvg->online = true;
-
-      for (unsigned int i = 0; i < super->existingCPUs; i++) {
-         CPUData* d = &this->cpuData[i + 1];
-         memset(d, '\0', sizeof(CPUData));
-         d->totalTime = 1;
-         d->totalPeriod = 1;
-
-         const int ncmib[] = { CTL_KERN, KERN_CPUSTATS, i };
-         struct cpustats cpu_stats;
-
-         size = sizeof(cpu_stats);
-         if (sysctl(ncmib, 3, &cpu_stats, &size, NULL, 0) < 0) {
-            CRT_fatalError("ncmib sysctl call failed");
-         }
-         d->online = (cpu_stats.cs_flags & CPUSTATS_ONLINE);
-      }
+   if (value == super->activeCPUs)
+      return;
+
+   super->activeCPUs = value;
+   for (unsigned int i = 1; i <= super->existingCPUs; i++)
+      this->cpuData[i].onlineKnown = false;
+}
+
+/* Times and online state of one CPU, in a single sysctl; false if unknown */
+static bool OpenBSDMachine_readCPUStats(CPUData* cpu, unsigned int cpuId, struct cpustats* stats) {
+   const int mib[] = { CTL_KERN, KERN_CPUSTATS, cpuId };
+   size_t size = sizeof(*stats);
+
+   if (sysctl(mib, 3, stats, &size, NULL, 0) < 0) {
+      cpu->onlineKnown = false;
+      return false;
    }
+
+   cpu->online = stats->cs_flags & CPUSTATS_ONLINE;
+   cpu->onlineKnown = true;
+   return true;
 }
 
 Machine* Machine_new(UsersTable* usersTable, uid_t userId) {
@@ -98,7 +105,8 @@ Machine* Machine_new(UsersTable* usersTable, uid_t userId) {
 
    Machine_init(super, usersTable, userId);
 
-   OpenBSDProcessTable_updateCPUcount(this);
+   OpenBSDMachine_initCPUcount(this);
+   OpenBSDMachine_updateOnlineCPUs(this);
 
    size = sizeof(this->fscale);
    if (sysctl(fmib, 2, &this->fscale, &size, NULL, 0) < 0 || this->fscale <= 0) {
@@ -186,14 +194,6 @@ static void OpenBSDMachine_scanMemoryInfo(OpenBSDMachine* this) {
    }
 }
 
-static void getKernelCPUTimes(unsigned int cpuId, u_int64_t* times) {
-   const int mib[] = { CTL_KERN, KERN_CPTIME2, cpuId };
-   size_t length = sizeof(*times) * CPUSTATES;
-   if (sysctl(mib, 3, times, &length, NULL, 0) == -1 || length != sizeof(*times) * CPUSTATES) {
-      CRT_fatalError("sysctl kern.cp_time2 failed");
-   }
-}
-
 static void kernelCPUTimesToHtop(const u_int64_t* times, CPUData* cpu) {
    unsigned long long totalTime = 0;
    for (int i = 0; i < CPUSTATES; i++) {
@@ -231,37 +231,46 @@ static void kernelCPUTimesToHtop(const u_int64_t* times, CPUData* cpu) {
    cpu->idleTime = times[CP_IDLE];
 }
 
+/*
+ * The average comes from kern.cp_time, one sysctl whatever the number of
+ * CPUs. Only the CPUs whose values were read since the last scan, by per
+ * CPU meters on screen, are sampled one by one.
+ */
 static void OpenBSDMachine_scanCPUTime(OpenBSDMachine* this) {
    Machine* super = &this->super;
-   u_int64_t kernelTimes[CPUSTATES] = {0};
-   u_int64_t avg[CPUSTATES] = {0};
+
+   {
+      /* averaged over the online CPUs by the kernel */
+      const int mib[] = { CTL_KERN, KERN_CPTIME };
+      long cpTime[CPUSTATES];
+      size_t size = sizeof(cpTime);
+      if (sysctl(mib, 2, cpTime, &size, NULL, 0) == -1 || size != sizeof(cpTime)) {
+         CRT_fatalError("sysctl kern.cp_time failed");
+      }
+
+      u_int64_t avg[CPUSTATES];
+      for (int i = 0; i < CPUSTATES; i++) {
+         avg[i] = (u_int64_t)MAXIMUM(cpTime[i], 0L);
+      }
+      kernelCPUTimesToHtop(avg, &this->cpuData[0]);
+   }
 
    for (unsigned int i = 0; i < super->existingCPUs; i++) {
       CPUData* cpu = &this->cpuData[i + 1];
 
-      if (!cpu->online) {
+      if (!cpu->wanted) {
          continue;
       }
+      cpu->wanted = false;
 
-      getKernelCPUTimes(i, kernelTimes);
-      kernelCPUTimesToHtop(kernelTimes, cpu);
-
-      avg[CP_USER] += cpu->userTime;
-      avg[CP_NICE] += cpu->niceTime;
-      avg[CP_SYS] += cpu->sysTime;
-      #ifdef CP_SPIN
-      avg[CP_SPIN] += cpu->spinTime;
-      #endif
-      avg[CP_INTR] += cpu->intrTime;
-      avg[CP_IDLE] += cpu->idleTime;
-   }
+      struct cpustats stats;
+      if (!OpenBSDMachine_readCPUStats(cpu, i, &stats) || !cpu->online) {
+         continue;
+      }
 
-   for (int i = 0; i < CPUSTATES; i++) {
-      avg[i] /= super->activeCPUs;
+      kernelCPUTimesToHtop(stats.cs_time, cpu);
    }
 
-   kernelCPUTimesToHtop(avg, &this->cpuData[0]);
-
    {
       const int mib[] = { CTL_HW, HW_CPUSPEED };
       int cpuSpeed;
@@ -277,7 +286,7 @@ static void OpenBSDMachine_scanCPUTime(OpenBSDMachine* this) {
 void Machine_scan(Machine* super) {
    OpenBSDMachine* this = (OpenBSDMachine*) super;
 
-   OpenBSDMachine_updateCPUcount(this);
+   OpenBSDMachine_updateOnlineCPUs(this);
    OpenBSDMachine_scanMemoryInfo(this);
    OpenBSDMachine_scanCPUTime(this);
 }
@@ -286,5 +295,11 @@ bool Machine_isCPUonline(const Machine* super, unsigned int id) {
    assert(id < super->existingCPUs);
 
    const OpenBSDMachine* this = (const OpenBSDMachine*) super;
-   return this->cpuData[id + 1].online;
+   CPUData* cpu = &this->cpuData[id + 1];
+   if (!cpu->onlineKnown) {
+      struct cpustats stats;
+      OpenBSDMachine_readCPUStats(cpu, id, &stats);
+   }
+
+   return cpu->online;
 }
@@ -35,6 +35,8 @@ typedef struct CPUData_ {
    unsigned long long int idlePeriod;
 
    bool online;
+   bool onlineKnown;          /* cleared when the number of online CPUs changes */
+   bool wanted;               /* read since the last scan, so sampled in the next one */
 } CPUData;
 
 typedef struct OpenBSDMachine_ {
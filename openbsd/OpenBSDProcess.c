@@ -8,6 +8,8 @@ in the source distribution for its full text.
 
 #include "config.h" // IWYU pragma: keep
 
+#define HEAP_CLASS HEAP_PROCESSES
+
 #include "openbsd/OpenBSDProcess.h"
 
 #include <stdlib.h>
@@ -203,11 +205,32 @@ const ProcessFieldData Process_fields[LAST_PROCESSFIELD] = {
       .description = "The current working directory of the process",
       .flags = PROCESS_FLAG_CWD,
    },
+   [CPU_HISTORY] = {
+      .name = "CPU_HISTORY",
+      .title = "CPU HISTORY                    ",
+      .description = "Sparkline of the CPU usage over the last updates, full height being one CPU busy",
+      .flags = PROCESS_FLAG_HISTORY,
+      .defaultSortDesc = true,
+   },
+   [MEM_HISTORY] = {
+      .name = "MEM_HISTORY",
+      .title = "RES HISTORY                    ",
+      .description = "Sparkline of the resident memory over the last updates, against its peak",
+      .flags = PROCESS_FLAG_HISTORY,
+      .defaultSortDesc = true,
+   },
+   [MEM_GROWTH] = {
+      .name = "MEM_GROWTH",
+      .title = "  RES/h ",
+      .description = "Growth of the resident memory per hour, fitted over the memory growth window (leak suspects)",
+      .flags = PROCESS_FLAG_MEM_GROWTH,
+      .defaultSortDesc = true,
+   },
 
 };
 
 Process* OpenBSDProcess_new(const Machine* host) {
-   OpenBSDProcess* this = xCalloc(1, sizeof(OpenBSDProcess));
+   OpenBSDProcess* this = Process_allocate(sizeof(OpenBSDProcess));
    Object_setClass(this, Class(OpenBSDProcess));
    Process_init(&this->super, host);
    return &this->super;
@@ -216,7 +239,7 @@ Process* OpenBSDProcess_new(const Machine* host) {
 void Process_delete(Object* cast) {
    OpenBSDProcess* this = (OpenBSDProcess*) cast;
    Process_done((Process*)cast);
-   free(this);
+   Process_release(this, sizeof(OpenBSDProcess));
 }
 
 static void OpenBSDProcess_rowWriteField(const Row* super, RichString* str, ProcessField field) {
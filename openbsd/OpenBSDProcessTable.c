@@ -29,6 +29,7 @@ in the source distribution for its full text.
 #include "Process.h"
 #include "ProcessTable.h"
 #include "Settings.h"
+#include "Table.h"
 #include "XUtils.h"
 #include "openbsd/OpenBSDMachine.h"
 #include "openbsd/OpenBSDProcess.h"
@@ -119,6 +120,22 @@ static void OpenBSDProcessTable_updateProcessName(kvm_t* kd, const struct kinfo_
    free(s);
 }
 
+/*
+ * Whether the arguments of a known process are read again in this scan:
+ * once it ran another program, else with lazy collection only while on
+ * screen, unless all of them are filtered or sorted by their command.
+ */
+static bool OpenBSDProcessTable_wantsProcessName(const ProcessTable* super, const struct kinfo_proc* kproc, const Process* proc) {
+   if (!proc->procComm || !String_eq(proc->procComm, kproc->p_comm))
+      return true;
+
+   const Settings* settings = super->super.host->settings;
+   if (!settings->lazyCollection || super->super.incFilter || ScreenSettings_getActiveSortKey(settings->ss) == COMM)
+      return true;
+
+   return Table_isRowOnScreen(&super->super, &proc->super);
+}
+
 /*
  * Taken from OpenBSD's ps(1).
  */
@@ -184,7 +201,7 @@ static void OpenBSDProcessTable_scanProcs(OpenBSDProcessTable* this) {
             free_and_xStrdup(&proc->tty_name, name);
          }
       } else {
-         if (settings->updateProcessNames) {
+         if (settings->updateProcessNames && OpenBSDProcessTable_wantsProcessName(&this->super, kproc, proc)) {
             OpenBSDProcessTable_updateProcessName(ohost->kd, kproc, proc);
          }
       }
@@ -234,7 +251,7 @@ static void OpenBSDProcessTable_scanProcs(OpenBSDProcessTable* this) {
       }
 
       proc->super.show = ! ((hideKernelThreads && Process_isKernelThread(proc)) || (hideUserlandThreads && Process_isUserlandThread(proc)));
-      proc->super.updated = true;
+      Table_markUpdated(&this->super.super, &proc->super);
    }
 }
 
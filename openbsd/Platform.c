@@ -37,6 +37,7 @@ in the source distribution for its full text.
 #include "MemoryMeter.h"
 #include "MemorySwapMeter.h"
 #include "Meter.h"
+#include "SelfMeter.h"
 #include "Settings.h"
 #include "SignalsPanel.h"
 #include "SwapMeter.h"
@@ -112,6 +113,7 @@ const MeterClass* const Platform_meterTypes[] = {
    &MemorySwapMeter_class,
    &TasksMeter_class,
    &UptimeMeter_class,
+   &SelfMeter_class,
    &BatteryMeter_class,
    &HostnameMeter_class,
    &SysArchMeter_class,
@@ -127,6 +129,16 @@ const MeterClass* const Platform_meterTypes[] = {
    &RightCPUs4Meter_class,
    &LeftCPUs8Meter_class,
    &RightCPUs8Meter_class,
+#ifdef HAVE_LIBHWLOC
+   &CPUNodesMeter_class,
+   &CPUSocketsMeter_class,
+   &CPUCachesMeter_class,
+   &CPUCoresMeter_class,
+   &BusiestCPUNodeMeter_class,
+   &BusiestCPUSocketMeter_class,
+   &BusiestCPUCacheMeter_class,
+   &BusiestCPUCoreMeter_class,
+#endif
    &FileDescriptorMeter_class,
    &BlankMeter_class,
    NULL
@@ -189,6 +201,10 @@ double Platform_setCPUValues(Meter* this, unsigned int cpu) {
    double totalPercent;
    double* v = this->values;
 
+   /* CPUs are only sampled one by one while their values are read */
+   if (cpu > 0)
+      ohost->cpuData[cpu].wanted = true;
+
    if (!cpuData->online) {
       this->curItems = 0;
       return NAN;
@@ -306,6 +322,13 @@ FileLocks_ProcessData* Platform_getProcessLocks(pid_t pid) {
    return NULL;
 }
 
+bool Platform_getProcessOpenFiles(pid_t pid, OpenFiles_AddFile addFile, void* context) {
+   (void)pid;
+   (void)addFile;
+   (void)context;
+   return false;
+}
+
 void Platform_getFileDescriptors(double* used, double* max) {
    static const int mib_kern_maxfile[] = { CTL_KERN, KERN_MAXFILES };
    int sysctl_maxfile = 0;
@@ -0,0 +1,159 @@
+/*
+htop - pcp/ArchiveCache.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "pcp/ArchiveCache.h"
+
+#include <string.h>
+
+#include "XUtils.h"
+
+
+void ArchiveCache_init(ArchiveCache* this) {
+   memset(this, 0, sizeof(ArchiveCache));
+}
+
+void ArchiveCache_done(ArchiveCache* this) {
+   for (size_t i = 0; i < this->count; i++)
+      pmFreeResult(this->samples[i].result);
+   free(this->samples);
+   ArchiveCache_init(this);
+}
+
+/* Index the sample at time is to be inserted at, after the ones at or before it */
+static size_t ArchiveCache_position(const ArchiveCache* this, double time) {
+   size_t lo = 0;
+   size_t hi = this->count;
+   while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (this->samples[mid].time <= time)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   return lo;
+}
+
+int ArchiveCache_find(const ArchiveCache* this, double time) {
+   return (int)ArchiveCache_position(this, time) - 1;
+}
+
+bool ArchiveCache_isAt(const ArchiveCache* this, int i, double time) {
+   if (i < 0 || (size_t)i >= this->count)
+      return false;
+
+   double slack = this->interval > 0.0 ? this->interval / 2 : 0.0005;
+   double delta = this->samples[i].time - time;
+   return delta < slack && delta > -slack;
+}
+
+static int ArchiveCache_indexOf(const ArchiveCache* this, const pmResult* result) {
+   if (!result)
+      return -1;
+
+   double time = pmtimevalToReal(&result->timestamp);
+   for (int i = ArchiveCache_find(this, time); i >= 0 && this->samples[i].time == time; i--) {
+      if (this->samples[i].result == result)
+         return i;
+   }
+   return -1;
+}
+
+void ArchiveCache_setRole(ArchiveCache* this, const pmResult* result, ArchiveSampleRole role, bool set) {
+   int i = ArchiveCache_indexOf(this, result);
+   if (i < 0)
+      return;
+
+   if (set)
+      this->samples[i].roles |= role;
+   else
+      this->samples[i].roles &= ~(unsigned int)role;
+}
+
+/* Keeps every other key frame once there are too many, older ones are then further apart */
+static void ArchiveCache_thinKeys(ArchiveCache* this) {
+   bool drop = false;
+   for (size_t i = 0; i < this->count; i++) {
+      ArchiveSample* sample = &this->samples[i];
+      if (!(sample->roles & ARCHIVESAMPLE_KEY))
+         continue;
+
+      if (drop) {
+         sample->roles &= ~(unsigned int)ARCHIVESAMPLE_KEY;
+         if (i > 0)
+            this->samples[i - 1].roles &= ~(unsigned int)ARCHIVESAMPLE_KEYPREV;
+         this->keys--;
+      }
+      drop = !drop;
+   }
+}
+
+void ArchiveCache_prune(ArchiveCache* this) {
+   size_t kept = 0;
+   for (size_t i = 0; i < this->count; i++) {
+      if (this->samples[i].roles) {
+         this->samples[kept++] = this->samples[i];
+      } else {
+         pmFreeResult(this->samples[i].result);
+      }
+   }
+   this->count = kept;
+}
+
+pmResult* ArchiveCache_add(ArchiveCache* this, pmResult* result) {
+   double time = pmtimevalToReal(&result->timestamp);
+   int prev = ArchiveCache_find(this, time);
+
+   if (prev >= 0 && this->samples[prev].time == time) {
+      /* read again, the one cached is kept as others may refer to it */
+      pmFreeResult(result);
+   } else {
+      if (this->count == this->size) {
+         this->size = this->size ? this->size * 2 : ARCHIVECACHE_RECENT * 2;
+         this->samples = xReallocArray(this->samples, this->size, sizeof(ArchiveSample));
+      }
+
+      prev++;
+      memmove(&this->samples[prev + 1], &this->samples[prev], (this->count - (size_t)prev) * sizeof(ArchiveSample));
+      this->samples[prev] = (ArchiveSample) { .time = time, .result = result };
+      this->count++;
+
+      if (prev > 0) {
+         double delta = time - this->samples[prev - 1].time;
+         if (delta > 0.0 && (this->interval <= 0.0 || delta < this->interval))
+            this->interval = delta;
+      }
+   }
+
+   ArchiveSample* sample = &this->samples[prev];
+   sample->serial = ++this->serial;
+   sample->roles |= ARCHIVESAMPLE_RECENT;
+
+   if (this->serial % ARCHIVECACHE_KEY_SPACING == 0 && !(sample->roles & ARCHIVESAMPLE_KEY)) {
+      sample->roles |= ARCHIVESAMPLE_KEY;
+      this->keys++;
+      if (ArchiveCache_isAt(this, prev - 1, time - this->interval))
+         this->samples[prev - 1].roles |= ARCHIVESAMPLE_KEYPREV;
+   }
+
+   if (this->serial > ARCHIVECACHE_RECENT) {
+      unsigned long long oldest = this->serial - ARCHIVECACHE_RECENT;
+      for (size_t i = 0; i < this->count; i++) {
+         if (this->samples[i].serial <= oldest)
+            this->samples[i].roles &= ~(unsigned int)ARCHIVESAMPLE_RECENT;
+      }
+   }
+
+   if (this->keys > ARCHIVECACHE_MAX_KEYS)
+      ArchiveCache_thinKeys(this);
+
+   /* the sample is recent, pruning may move but not free it */
+   result = sample->result;
+   ArchiveCache_prune(this);
+   return result;
+}
@@ -0,0 +1,71 @@
+#ifndef HEADER_ArchiveCache
+#define HEADER_ArchiveCache
+/*
+htop - pcp/ArchiveCache.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "pcp/Metric.h"
+
+
+/* The last samples fetched are all kept, for stepping back through them */
+#define ARCHIVECACHE_RECENT 64
+
+/* Every this many samples fetched one is kept as a key frame, with the one before it for rates */
+#define ARCHIVECACHE_KEY_SPACING 64
+
+/* Key frames kept at most; every other one is dropped when there are more */
+#define ARCHIVECACHE_MAX_KEYS 256
+
+typedef enum ArchiveSampleRole_ {
+   ARCHIVESAMPLE_RECENT  = 0x01,
+   ARCHIVESAMPLE_KEY     = 0x02,
+   ARCHIVESAMPLE_KEYPREV = 0x04,
+   ARCHIVESAMPLE_CURRENT = 0x08,   /* pcp->result */
+   ARCHIVESAMPLE_QUEUED  = 0x10,   /* to be made current by the next fetches */
+} ArchiveSampleRole;
+
+typedef struct ArchiveSample_ {
+   double time;
+   pmResult* result;
+   unsigned long long serial;      /* order it was added in */
+   unsigned int roles;             /* ArchiveSampleRole, freed once it has none */
+} ArchiveSample;
+
+/*
+ * Samples of an archive fetched so far, kept decoded in time order so that
+ * seeking back to them does not read the archive again.
+ */
+typedef struct ArchiveCache_ {
+   ArchiveSample* samples;
+   size_t count;
+   size_t size;
+   size_t keys;
+   unsigned long long serial;
+   double interval;                /* between consecutive samples, 0.0 until seen */
+} ArchiveCache;
+
+void ArchiveCache_init(ArchiveCache* this);
+
+void ArchiveCache_done(ArchiveCache* this);
+
+/* Takes a fetched sample, returning the result kept for its time, which may be one taken before */
+pmResult* ArchiveCache_add(ArchiveCache* this, pmResult* result);
+
+/* Index of the latest sample at or before time, -1 if there is none */
+int ArchiveCache_find(const ArchiveCache* this, double time);
+
+/* Whether the sample at index i is the one at time, within half an interval */
+bool ArchiveCache_isAt(const ArchiveCache* this, int i, double time);
+
+void ArchiveCache_setRole(ArchiveCache* this, const pmResult* result, ArchiveSampleRole role, bool set);
+
+/* Frees the samples left without a role */
+void ArchiveCache_prune(ArchiveCache* this);
+
+#endif
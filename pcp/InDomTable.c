@@ -42,6 +42,8 @@ InDomTable* InDomTable_new(Machine* host, pmInDom indom, int metricKey) {
 
 void InDomTable_done(InDomTable* this) {
    Table_done(&this->super);
+   free(this->instances);
+   free(this->fetched);
 }
 
 static void InDomTable_delete(Object* cast) {
@@ -65,20 +67,56 @@ static Instance* InDomTable_getInstance(InDomTable* this, int id, bool* preExist
    return inst;
 }
 
+/* Takes the instances of the key metric fetched, returning whether they are those of the last fetch */
+static bool InDomTable_fetchInstances(InDomTable* this) {
+   int instid = -1, offset = -1;
+   this->fetchedCount = 0;
+   while (Metric_iterate(this->metricKey, &instid, &offset)) {
+      if ((size_t)this->fetchedCount == this->fetchedSize) {
+         this->fetchedSize = this->fetchedSize ? this->fetchedSize * 2 : 64;
+         this->fetched = xReallocArray(this->fetched, this->fetchedSize, sizeof(int));
+      }
+      this->fetched[this->fetchedCount++] = instid;
+   }
+
+   bool unchanged = this->fetchedCount == this->instanceCount &&
+                    (this->fetchedCount == 0 || memcmp(this->fetched, this->instances, (size_t)this->fetchedCount * sizeof(int)) == 0);
+
+   int* instances = this->instances;
+   size_t instancesSize = this->instancesSize;
+   this->instances = this->fetched;
+   this->instancesSize = this->fetchedSize;
+   this->instanceCount = this->fetchedCount;
+   this->fetched = instances;
+   this->fetchedSize = instancesSize;
+
+   return unchanged;
+}
+
 static void InDomTable_goThroughEntries(InDomTable* this) {
    Table* super = &this->super;
 
-   /* for every instance ... */
-   int instid = -1, offset = -1;
-   while (Metric_iterate(this->metricKey, &instid, &offset)) {
+   /* with the same instances at the same offsets the rows only need to be kept */
+   if (InDomTable_fetchInstances(this) && Vector_size(super->rows) == this->instanceCount) {
+      for (int i = 0; i < Vector_size(super->rows); i++) {
+         Row* row = (Row*) Vector_get(super->rows, i);
+         Table_markUpdated(&this->super, row);
+         row->show = true;
+      }
+      return;
+   }
+
+   /* otherwise rows are added for the new instances, those gone are dropped by the cleanup */
+   for (int offset = 0; offset < this->instanceCount; offset++) {
+      int instid = this->instances[offset];
       bool preExisting;
       Instance* inst = InDomTable_getInstance(this, instid, &preExisting);
-      inst->offset = offset >= 0 ? offset : 0;
+      inst->offset = (unsigned int)offset;
 
       Row* row = (Row*) inst;
       if (!preExisting)
          Table_add(super, row);
-      row->updated = true;
+      Table_markUpdated(&this->super, row);
       row->show = true;
    }
 }
@@ -19,6 +19,13 @@ typedef struct InDomTable_ {
    Table super;
    pmInDom id;  /* shared by metrics in the table */
    unsigned int metricKey;  /* representative metric using this indom */
+
+   int* instances;          /* of the key metric in the last fetch, in its order */
+   int* fetched;            /* of the key metric in this fetch */
+   int instanceCount;
+   int fetchedCount;
+   size_t instancesSize;
+   size_t fetchedSize;
 } InDomTable;
 
 extern const TableClass InDomTable_class;
@@ -68,13 +68,16 @@ static void Instance_writeField(const Row* super, RichString* str, RowField fiel
    pmAtomValue atom;
    pmAtomValue* ap = &atom;
    const pmDesc* descp = Metric_desc(cp->id);
-   if (!Metric_instance(cp->id, instid, this->offset, ap, descp->type))
+   if (descp->type == PM_TYPE_STRING) {
+      /* written from the fetched result as is, not copied for every row drawn */
+      atom.cp = (char*) Metric_instanceString(cp->id, instid, this->offset);
+      if (!atom.cp)
+         ap = NULL;
+   } else if (!Metric_instance(cp->id, instid, this->offset, ap, descp->type)) {
       ap = NULL;
+   }
 
    PCPDynamicColumn_writeAtomValue(cp, str, settings, cp->id, instid, descp, ap);
-
-   if (ap && descp->type == PM_TYPE_STRING)
-      free(ap->cp);
 }
 
 static const char* Instance_externalName(Row* super) {
@@ -101,23 +104,20 @@ static int Instance_compareByKey(const Row* v1, const Row* v2, int key) {
    size_t metric = column->id;
    unsigned int type = Metric_type(metric);
 
+   if (type == PM_TYPE_STRING) {
+      const char* string1 = Metric_instanceString(metric, Instance_getId(i1), i1->offset);
+      const char* string2 = Metric_instanceString(metric, Instance_getId(i2), i2->offset);
+      if (!string1 || !string2)
+         return -1;
+      return SPACESHIP_NULLSTR(string2, string1);
+   }
+
    pmAtomValue atom1 = {0}, atom2 = {0};
-   if (!Metric_instance(metric, i1->offset, i1->offset, &atom1, type) ||
-       !Metric_instance(metric, i2->offset, i2->offset, &atom2, type)) {
-      if (type == PM_TYPE_STRING) {
-         free(atom1.cp);
-         free(atom2.cp);
-      }
+   if (!Metric_instance(metric, Instance_getId(i1), i1->offset, &atom1, type) ||
+       !Metric_instance(metric, Instance_getId(i2), i2->offset, &atom2, type))
       return -1;
-   }
 
    switch (type) {
-      case PM_TYPE_STRING: {
-         int cmp = SPACESHIP_NULLSTR(atom2.cp, atom1.cp);
-         free(atom2.cp);
-         free(atom1.cp);
-         return cmp;
-      }
       case PM_TYPE_32:
          return SPACESHIP_NUMBER(atom2.l, atom1.l);
       case PM_TYPE_U32:
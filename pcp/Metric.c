@@ -10,18 +10,53 @@ in the source distribution for its full text.
 
 #include "pcp/Metric.h"
 
+#include <assert.h>
 #include <ctype.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "Macros.h"
 #include "XUtils.h"
 
+#include "pcp/ArchiveCache.h"
 #include "pcp/Platform.h"
 
 
 extern Platform* pcp;
 
+/* Samples of the archive replayed, the current one included */
+static ArchiveCache Metric_archive;
+
+/* Samples a seek left to be made current by the next fetches, oldest first */
+static pmResult* Metric_queued[2];
+static int Metric_queuedCount;
+
+/* Names of Metric_loadSourceDerived(), sorted */
+static char** Metric_sourceDerived;
+static size_t Metric_sourceDerivedCount;
+
+/* Value last stored into proc.control.perclient.threads, -1 if none was */
+static int Metric_threads = -1;
+
+/* Instances left out of the fetches of all instances, see Metric_excludeInstances() */
+static pmInDom Metric_excludedInDom = PM_INDOM_NULL;
+static int* Metric_excluded;
+static int Metric_excludedCount;
+static size_t Metric_excludedSize;
+
+/* Dynamic metrics Metric_resolve() looked up already, found or not, by Metric */
+static bool* Metric_resolved;
+static size_t Metric_resolvedSize;
+
+static void Metric_stopAhead(void);
+
 const pmDesc* Metric_desc(Metric metric) {
    return &pcp->descs[metric];
 }
@@ -30,11 +65,17 @@ int Metric_type(Metric metric) {
    return pcp->descs[metric].type;
 }
 
-pmAtomValue* Metric_values(Metric metric, pmAtomValue* atom, int count, int type) {
-   if (pcp->result == NULL)
-      return NULL;
+/* Values of the metric, from the fetch of the profiled instances if it was moved there */
+static pmValueSet* Metric_valueSet(Metric metric) {
+   const pmResult* result = pcp->result;
+   if (metric < PCP_METRIC_COUNT && pcp->profiledFetch[metric] != PM_ID_NULL)
+      result = pcp->profiledResult;
 
-   pmValueSet* vset = pcp->result->vset[metric];
+   return result ? result->vset[metric] : NULL;
+}
+
+pmAtomValue* Metric_values(Metric metric, pmAtomValue* atom, int count, int type) {
+   pmValueSet* vset = Metric_valueSet(metric);
    if (!vset || vset->numval <= 0)
       return NULL;
 
@@ -56,14 +97,14 @@ pmAtomValue* Metric_values(Metric metric, pmAtomValue* atom, int count, int type
 }
 
 int Metric_instanceCount(Metric metric) {
-   pmValueSet* vset = pcp->result->vset[metric];
+   pmValueSet* vset = Metric_valueSet(metric);
    if (vset)
       return vset->numval;
    return 0;
 }
 
 int Metric_instanceOffset(Metric metric, int inst) {
-   pmValueSet* vset = pcp->result->vset[metric];
+   pmValueSet* vset = Metric_valueSet(metric);
    if (!vset || vset->numval <= 0)
       return 0;
 
@@ -92,7 +133,7 @@ static pmAtomValue* Metric_extract(Metric metric, int inst, int offset, pmValueS
 
 pmAtomValue* Metric_instance(Metric metric, int inst, int offset, pmAtomValue* atom, int type) {
 
-   pmValueSet* vset = pcp->result->vset[metric];
+   pmValueSet* vset = Metric_valueSet(metric);
    if (!vset || vset->numval <= 0)
       return NULL;
 
@@ -108,6 +149,117 @@ pmAtomValue* Metric_instance(Metric metric, int inst, int offset, pmAtomValue* a
    return NULL;
 }
 
+void MetricCursor_init(MetricCursor* this, Metric metric) {
+   this->vset = Metric_valueSet(metric);
+   this->type = pcp->descs[metric].type;
+   this->next = 0;
+   if (this->vset && this->vset->numval <= 0)
+      this->vset = NULL;
+}
+
+const pmValue* MetricCursor_find(MetricCursor* this, int inst) {
+   const pmValueSet* vset = this->vset;
+   if (!vset)
+      return NULL;
+
+   /* the values mostly follow the order they are asked for in, at most with gaps */
+   for (int i = this->next; i < vset->numval; i++) {
+      if (vset->vlist[i].inst == inst) {
+         this->next = i + 1;
+         return &vset->vlist[i];
+      }
+   }
+   for (int i = 0; i < this->next && i < vset->numval; i++) {
+      if (vset->vlist[i].inst == inst)
+         return &vset->vlist[i];
+   }
+   return NULL;
+}
+
+/* Reads a value in the type of its metric, as pmExtractValue() would without converting it */
+static bool MetricCursor_read(const MetricCursor* this, const pmValue* value, pmAtomValue* atom) {
+   if (this->vset->valfmt == PM_VAL_INSITU) {
+      switch (this->type) {
+         case PM_TYPE_32:
+            atom->l = value->value.lval;
+            return true;
+         case PM_TYPE_U32:
+            atom->ul = (uint32_t)value->value.lval;
+            return true;
+      }
+      return pmExtractValue(this->vset->valfmt, value, this->type, atom, this->type) >= 0;
+   }
+
+   const pmValueBlock* block = value->value.pval;
+   switch (this->type) {
+      case PM_TYPE_64:
+      case PM_TYPE_U64:
+      case PM_TYPE_DOUBLE:
+         if (block->vlen < PM_VAL_HDR_SIZE + sizeof(uint64_t))
+            return false;
+         memcpy(atom, block->vbuf, sizeof(uint64_t));
+         return true;
+      case PM_TYPE_STRING:
+         atom->cp = (char*)block->vbuf;
+         return true;
+   }
+   return pmExtractValue(this->vset->valfmt, value, this->type, atom, this->type) >= 0;
+}
+
+static bool MetricCursor_number(MetricCursor* this, int inst, pmAtomValue* atom) {
+   const pmValue* value = MetricCursor_find(this, inst);
+   return value && this->type != PM_TYPE_STRING && MetricCursor_read(this, value, atom);
+}
+
+bool MetricCursor_unsigned(MetricCursor* this, int inst, unsigned long long* result) {
+   pmAtomValue atom;
+   if (!MetricCursor_number(this, inst, &atom))
+      return false;
+
+   switch (this->type) {
+      case PM_TYPE_32:     *result = (unsigned long long)atom.l; break;
+      case PM_TYPE_U32:    *result = atom.ul; break;
+      case PM_TYPE_64:     *result = (unsigned long long)atom.ll; break;
+      case PM_TYPE_U64:    *result = atom.ull; break;
+      case PM_TYPE_FLOAT:  *result = atom.f > 0 ? (unsigned long long)atom.f : 0; break;
+      case PM_TYPE_DOUBLE: *result = atom.d > 0 ? (unsigned long long)atom.d : 0; break;
+      default:             return false;
+   }
+   return true;
+}
+
+bool MetricCursor_signed(MetricCursor* this, int inst, long long* result) {
+   pmAtomValue atom;
+   if (!MetricCursor_number(this, inst, &atom))
+      return false;
+
+   switch (this->type) {
+      case PM_TYPE_32:     *result = atom.l; break;
+      case PM_TYPE_U32:    *result = atom.ul; break;
+      case PM_TYPE_64:     *result = atom.ll; break;
+      case PM_TYPE_U64:    *result = (long long)atom.ull; break;
+      case PM_TYPE_FLOAT:  *result = (long long)atom.f; break;
+      case PM_TYPE_DOUBLE: *result = (long long)atom.d; break;
+      default:             return false;
+   }
+   return true;
+}
+
+const char* MetricCursor_string(MetricCursor* this, int inst) {
+   const pmValue* value = MetricCursor_find(this, inst);
+   pmAtomValue atom;
+   if (!value || this->type != PM_TYPE_STRING || !MetricCursor_read(this, value, &atom))
+      return NULL;
+   return atom.cp;
+}
+
+const char* Metric_instanceString(Metric metric, int inst, int offset) {
+   MetricCursor cursor;
+   MetricCursor_init(&cursor, metric);
+   cursor.next = MAXIMUM(offset, 0);
+   return MetricCursor_string(&cursor, inst);
+}
+
 /*
  * Iterate over a set of instances (incl PM_IN_NULL)
  * returning the next instance identifier and offset.
@@ -115,10 +267,7 @@ pmAtomValue* Metric_instance(Metric metric, int inst, int offset, pmAtomValue* a
  * Start it off by passing offset -1 into the routine.
  */
 bool Metric_iterate(Metric metric, int* instp, int* offsetp) {
-   if (!pcp->result)
-      return false;
-
-   pmValueSet* vset = pcp->result->vset[metric];
+   pmValueSet* vset = Metric_valueSet(metric);
    if (!vset || vset->numval <= 0)
       return false;
 
@@ -135,16 +284,41 @@ bool Metric_iterate(Metric metric, int* instp, int* offsetp) {
 /* Switch on/off a metric for value fetching (sampling) */
 void Metric_enable(Metric metric, bool enable) {
    pcp->fetch[metric] = enable ? pcp->pmids[metric] : PM_ID_NULL;
+   if (metric < PCP_METRIC_COUNT)
+      pcp->profiledFetch[metric] = PM_ID_NULL;
 }
 
 bool Metric_enabled(Metric metric) {
+   if (metric < PCP_METRIC_COUNT && pcp->profiledFetch[metric] != PM_ID_NULL)
+      return true;
    return pcp->fetch[metric] != PM_ID_NULL;
 }
 
-void Metric_enableThreads(void) {
+bool Metric_profiling(void) {
+   return !pcp->archive;
+}
+
+void Metric_enableProfiled(Metric metric) {
+   assert(metric < PCP_METRIC_COUNT);
+   if (pcp->fetch[metric] == PM_ID_NULL)
+      return;
+
+   pcp->profiledFetch[metric] = pcp->fetch[metric];
+   pcp->fetch[metric] = PM_ID_NULL;
+}
+
+bool Metric_enableThreads(bool enable) {
+   if (pcp->archive)
+      return true;
+   if (Metric_threads == (int)enable)
+      return enable;
+
+   /* a fetch running ahead would get either of them */
+   Metric_stopAhead();
+
    pmValueSet* vset = xCalloc(1, sizeof(pmValueSet));
    vset->vlist[0].inst = PM_IN_NULL;
-   vset->vlist[0].value.lval = 1;
+   vset->vlist[0].value.lval = enable;
    vset->valfmt = PM_VAL_INSITU;
    vset->numval = 1;
    vset->pmid = pcp->pmids[PCP_CONTROL_THREADS];
@@ -155,20 +329,100 @@ void Metric_enableThreads(void) {
 
    int sts = pmStore(result);
    if (sts < 0 && pmDebugOptions.appl0)
-      fprintf(stderr, "Error: cannot enable threads: %s\n", pmErrStr(sts));
+      fprintf(stderr, "Error: cannot %s threads: %s\n", enable ? "enable" : "disable", pmErrStr(sts));
+   if (sts >= 0)
+      Metric_threads = enable;
 
    pmFreeResult(result);
+
+   /* the agent lists threads unless told otherwise */
+   return Metric_threads != 0;
 }
 
-bool Metric_fetch(struct timeval* timestamp) {
-   if (pcp->result) {
-      pmFreeResult(pcp->result);
-      pcp->result = NULL;
+void Metric_excludeInstances(pmInDom indom, const int* instances, int count) {
+   if (!Metric_profiling())
+      count = 0;
+
+   if ((size_t)MAXIMUM(count, 0) > Metric_excludedSize) {
+      Metric_excludedSize = (size_t)count;
+      Metric_excluded = xReallocArray(Metric_excluded, Metric_excludedSize, sizeof(int));
    }
-   int sts, count = 0;
+   if (count > 0)
+      memcpy(Metric_excluded, instances, (size_t)count * sizeof(int));
+
+   Metric_excludedInDom = indom;
+   Metric_excludedCount = MAXIMUM(count, 0);
+}
+
+static int Metric_doFetch(int count, pmID* pmids, pmResult** result) {
+   int sts, tries = 0;
    do {
-      sts = pmFetch(pcp->totalMetrics, pcp->fetch, &pcp->result);
-   } while (sts == PM_ERR_IPC && ++count < 3);
+      sts = pmFetch(count, pmids, result);
+   } while (sts == PM_ERR_IPC && ++tries < 3);
+   if (sts < 0)
+      *result = NULL;
+   return sts;
+}
+
+/* Fetches the metrics for all instances, but those excluded from indom */
+static int Metric_doFetchExcluding(int count, pmID* pmids, pmInDom indom, int* excluded, int excludedCount, pmResult** result) {
+   if (indom == PM_INDOM_NULL || excludedCount <= 0)
+      return Metric_doFetch(count, pmids, result);
+
+   /* a failure to narrow the profile leaves the excluded instances in */
+   if (pmAddProfile(indom, 0, NULL) >= 0)
+      (void)pmDelProfile(indom, excludedCount, excluded);
+   int sts = Metric_doFetch(count, pmids, result);
+   (void)pmAddProfile(indom, 0, NULL);
+
+   return sts;
+}
+
+/* Fetches the profiled metrics for the given instances of indom only; no result if there are none */
+static int Metric_doFetchProfiled(pmID* pmids, pmInDom indom, int* instances, int count, pmResult** result) {
+   *result = NULL;
+
+   bool enabled = false;
+   for (unsigned int i = 0; i < PCP_METRIC_COUNT; i++)
+      enabled |= pmids[i] != PM_ID_NULL;
+   if (!enabled || count <= 0)
+      return 0;
+
+   /* the profile holds for all fetches of the context, so it is narrowed for this one only */
+   int sts = pmDelProfile(indom, 0, NULL);
+   if (sts >= 0)
+      sts = pmAddProfile(indom, count, instances);
+   if (sts >= 0)
+      sts = Metric_doFetch(PCP_METRIC_COUNT, pmids, result);
+   (void)pmAddProfile(indom, 0, NULL);
+
+   return sts;
+}
+
+/* Makes a sample of the archive cache current, or none */
+static void Metric_setCurrent(pmResult* result) {
+   ArchiveCache_setRole(&Metric_archive, pcp->result, ARCHIVESAMPLE_CURRENT, false);
+   pcp->result = result;
+   ArchiveCache_setRole(&Metric_archive, result, ARCHIVESAMPLE_CURRENT, true);
+   ArchiveCache_prune(&Metric_archive);
+}
+
+/* Makes a fetched result current; those of an archive are kept by the cache, not freed */
+static void Metric_setResult(pmResult* result) {
+   if (pcp->archive) {
+      Metric_setCurrent(result ? ArchiveCache_add(&Metric_archive, result) : NULL);
+      return;
+   }
+
+   if (pcp->result)
+      pmFreeResult(pcp->result);
+   pcp->result = result;
+}
+
+bool Metric_fetch(struct timeval* timestamp) {
+   pmResult* result;
+   int sts = Metric_doFetchExcluding(pcp->totalMetrics, pcp->fetch, Metric_excludedInDom, Metric_excluded, Metric_excludedCount, &result);
+   Metric_setResult(result);
    if (sts < 0) {
       if (pmDebugOptions.appl0)
          fprintf(stderr, "Error: cannot fetch metric values: %s\n",
@@ -180,6 +434,412 @@ bool Metric_fetch(struct timeval* timestamp) {
    return true;
 }
 
+static bool Metric_fetchProfiled(pmInDom indom, int* instances, int count) {
+   if (pcp->profiledResult) {
+      pmFreeResult(pcp->profiledResult);
+      pcp->profiledResult = NULL;
+   }
+
+   int sts = Metric_doFetchProfiled(pcp->profiledFetch, indom, instances, count, &pcp->profiledResult);
+   if (sts < 0) {
+      if (pmDebugOptions.appl0)
+         fprintf(stderr, "Error: cannot fetch profiled metric values: %s\n",
+                 pmErrStr(sts));
+      return false;
+   }
+   return true;
+}
+
+#ifdef HAVE_PTHREAD
+
+/* What a fetch started ahead was asked for, and what it fetched */
+typedef struct MetricRequest_ {
+   pmID* fetch;               /* copy of pcp->fetch when started */
+   size_t fetchCount;
+   pmID* profiledFetch;       /* copy of pcp->profiledFetch */
+   pmInDom excludedInDom;     /* copy of the instances excluded */
+   int* excluded;
+   int excludedCount;
+   size_t excludedSize;
+   pmInDom indom;
+   int* instances;
+   int count;
+   size_t instancesSize;
+
+   pmResult* result;
+   int sts;
+   pmResult* profiledResult;
+   int profiledSts;
+} MetricRequest;
+
+/* The fetch running on its own thread while the values of the last one are shown */
+static struct {
+   pthread_t thread;
+   bool running;              /* started and not yet joined */
+   bool done;
+   MetricRequest request;
+} Metric_ahead;
+
+static void* Metric_fetchAheadThread(ATTR_UNUSED void* arg) {
+   MetricRequest* req = &Metric_ahead.request;
+
+   req->sts = Metric_doFetchExcluding((int)req->fetchCount, req->fetch, req->excludedInDom, req->excluded, req->excludedCount, &req->result);
+   req->profiledSts = Metric_doFetchProfiled(req->profiledFetch, req->indom, req->instances, req->count, &req->profiledResult);
+
+   __atomic_store_n(&Metric_ahead.done, true, __ATOMIC_RELEASE);
+   return NULL;
+}
+
+static void Metric_joinAhead(void) {
+   if (!Metric_ahead.running)
+      return;
+
+   pthread_join(Metric_ahead.thread, NULL);
+   Metric_ahead.running = false;
+}
+
+static void Metric_freeAhead(void) {
+   MetricRequest* req = &Metric_ahead.request;
+   if (req->result)
+      pmFreeResult(req->result);
+   if (req->profiledResult)
+      pmFreeResult(req->profiledResult);
+   req->result = req->profiledResult = NULL;
+}
+
+bool Metric_fetchAhead(pmInDom indom, const int* instances, int count) {
+   if (Metric_ahead.running)
+      return true;
+
+   MetricRequest* req = &Metric_ahead.request;
+   Metric_freeAhead();
+
+   req->fetchCount = pcp->totalMetrics;
+   req->fetch = xReallocArray(req->fetch, req->fetchCount, sizeof(pmID));
+   memcpy(req->fetch, pcp->fetch, req->fetchCount * sizeof(pmID));
+   req->profiledFetch = xReallocArray(req->profiledFetch, PCP_METRIC_COUNT, sizeof(pmID));
+   memcpy(req->profiledFetch, pcp->profiledFetch, PCP_METRIC_COUNT * sizeof(pmID));
+
+   req->excludedInDom = Metric_excludedInDom;
+   req->excludedCount = Metric_excludedCount;
+   if ((size_t)req->excludedCount > req->excludedSize) {
+      req->excludedSize = (size_t)req->excludedCount;
+      req->excluded = xReallocArray(req->excluded, req->excludedSize, sizeof(int));
+   }
+   if (req->excludedCount > 0)
+      memcpy(req->excluded, Metric_excluded, (size_t)req->excludedCount * sizeof(int));
+
+   req->indom = indom;
+   req->count = MAXIMUM(count, 0);
+   if ((size_t)req->count > req->instancesSize) {
+      req->instancesSize = (size_t)req->count;
+      req->instances = xReallocArray(req->instances, req->instancesSize, sizeof(int));
+   }
+   if (req->count > 0)
+      memcpy(req->instances, instances, (size_t)req->count * sizeof(int));
+
+   Metric_ahead.done = false;
+   Metric_ahead.running = pthread_create(&Metric_ahead.thread, NULL, Metric_fetchAheadThread, NULL) == 0;
+   return Metric_ahead.running;
+}
+
+bool Metric_fetchedAhead(void) {
+   return !Metric_ahead.running || __atomic_load_n(&Metric_ahead.done, __ATOMIC_ACQUIRE);
+}
+
+/* Makes the values fetched ahead current if they were fetched with the metrics enabled now */
+static bool Metric_collectAhead(struct timeval* timestamp, pmInDom indom, int* instances, int count) {
+   if (!Metric_ahead.running)
+      return false;
+
+   Metric_joinAhead();
+
+   MetricRequest* req = &Metric_ahead.request;
+   /* instances excluded since are taken as they come, like the threads of a process folded meanwhile */
+   if (req->sts < 0 || req->fetchCount != pcp->totalMetrics ||
+       memcmp(req->fetch, pcp->fetch, req->fetchCount * sizeof(pmID)) != 0) {
+      Metric_freeAhead();
+      return false;
+   }
+
+   Metric_setResult(req->result);
+   req->result = NULL;
+
+   /* the rows on screen may have changed while it ran, those are fetched again */
+   if (req->profiledSts >= 0 && req->indom == indom && req->count == MAXIMUM(count, 0) &&
+       memcmp(req->profiledFetch, pcp->profiledFetch, PCP_METRIC_COUNT * sizeof(pmID)) == 0 &&
+       (count <= 0 || memcmp(req->instances, instances, (size_t)count * sizeof(int)) == 0)) {
+      if (pcp->profiledResult)
+         pmFreeResult(pcp->profiledResult);
+      pcp->profiledResult = req->profiledResult;
+      req->profiledResult = NULL;
+   } else {
+      Metric_fetchProfiled(indom, instances, count);
+   }
+
+   Metric_freeAhead();
+   if (timestamp)
+      *timestamp = pcp->result->timestamp;
+   return true;
+}
+
+static void Metric_stopAhead(void) {
+   Metric_joinAhead();
+   Metric_freeAhead();
+
+   MetricRequest* req = &Metric_ahead.request;
+   free(req->fetch);
+   free(req->profiledFetch);
+   free(req->excluded);
+   free(req->instances);
+   memset(req, 0, sizeof(*req));
+}
+
+#else /* HAVE_PTHREAD */
+
+bool Metric_fetchAhead(ATTR_UNUSED pmInDom indom, ATTR_UNUSED const int* instances, ATTR_UNUSED int count) {
+   return false;
+}
+
+bool Metric_fetchedAhead(void) {
+   return true;
+}
+
+static bool Metric_collectAhead(ATTR_UNUSED struct timeval* timestamp, ATTR_UNUSED pmInDom indom, ATTR_UNUSED int* instances, ATTR_UNUSED int count) {
+   return false;
+}
+
+static void Metric_stopAhead(void) {
+}
+
+#endif /* HAVE_PTHREAD */
+
+static void Metric_queue(pmResult* result) {
+   assert(Metric_queuedCount < (int)ARRAYSIZE(Metric_queued));
+   ArchiveCache_setRole(&Metric_archive, result, ARCHIVESAMPLE_QUEUED, true);
+   Metric_queued[Metric_queuedCount++] = result;
+}
+
+static void Metric_clearQueue(void) {
+   for (int i = 0; i < Metric_queuedCount; i++)
+      ArchiveCache_setRole(&Metric_archive, Metric_queued[i], ARCHIVESAMPLE_QUEUED, false);
+   Metric_queuedCount = 0;
+   ArchiveCache_prune(&Metric_archive);
+}
+
+/* Whether a result holds values for all the metrics enabled now */
+static bool Metric_covers(const pmResult* result) {
+   for (size_t i = 0; i < pcp->totalMetrics; i++) {
+      if (pcp->fetch[i] == PM_ID_NULL)
+         continue;
+      if (i >= (size_t)result->numpmid || result->vset[i]->pmid != pcp->fetch[i])
+         return false;
+   }
+   return true;
+}
+
+/* Moves the archive so that the next fetch is of the sample at time */
+static void Metric_setArchiveTime(double time) {
+   struct timeval when;
+   pmtimevalFromReal(time, &when);
+   int delta = (int)(Metric_archive.interval * 1000 + 0.5);
+   int sts = pmSetMode(PM_MODE_INTERP, &when, delta);
+   if (sts < 0 && pmDebugOptions.appl0)
+      fprintf(stderr, "Error: cannot set archive position: %s\n", pmErrStr(sts));
+}
+
+int Metric_seek(int samples) {
+   ArchiveCache* cache = &Metric_archive;
+   if (!pcp->archive || !pcp->result || samples == 0 || cache->interval <= 0.0)
+      return 0;
+
+   Metric_stopAhead();
+   Metric_clearQueue();
+
+   const double interval = cache->interval;
+   double time = pmtimevalToReal(&pcp->result->timestamp);
+   double target = time + samples * interval;
+
+   struct timeval bound;
+   pmLogLabel label;
+   if (pmGetArchiveLabel(&label) >= 0)
+      target = MAXIMUM(target, pmtimevalToReal(&label.ll_start));
+   if (pmGetArchiveEnd(&bound) >= 0)
+      target = MINIMUM(target, pmtimevalToReal(&bound));
+
+   int i = ArchiveCache_find(cache, target);
+   if (ArchiveCache_isAt(cache, i, target) && Metric_covers(cache->samples[i].result)) {
+      if (ArchiveCache_isAt(cache, i - 1, target - interval) && Metric_covers(cache->samples[i - 1].result))
+         Metric_queue(cache->samples[i - 1].result);
+      Metric_queue(cache->samples[i].result);
+   } else {
+      /* the sample before is read too, rates are taken against it */
+      Metric_setArchiveTime(target - interval);
+      for (int n = 0; n < 2; n++) {
+         pmResult* result;
+         if (Metric_doFetch(pcp->totalMetrics, pcp->fetch, &result) < 0)
+            break;
+         Metric_queue(ArchiveCache_add(cache, result));
+      }
+   }
+
+   /* replay goes on after the last sample shown, with the clock following */
+   if (Metric_queuedCount > 0)
+      time = pmtimevalToReal(&Metric_queued[Metric_queuedCount - 1]->timestamp);
+   Metric_setArchiveTime(time + interval);
+
+   struct timeval when;
+   pmtimevalFromReal(time, &when);
+   gettimeofday(&pcp->offset, NULL);
+   pmtimevalDec(&pcp->offset, &when);
+
+   return Metric_queuedCount;
+}
+
+bool Metric_fetchCollect(struct timeval* timestamp, pmInDom indom, int* instances, int count) {
+   if (Metric_queuedCount > 0) {
+      pmResult* result = Metric_queued[0];
+      Metric_queuedCount--;
+      memmove(&Metric_queued[0], &Metric_queued[1], (size_t)Metric_queuedCount * sizeof(pmResult*));
+
+      ArchiveCache_setRole(&Metric_archive, result, ARCHIVESAMPLE_QUEUED, false);
+      Metric_setCurrent(result);
+      if (timestamp)
+         *timestamp = result->timestamp;
+      return true;
+   }
+
+   if (Metric_collectAhead(timestamp, indom, instances, count))
+      return true;
+
+   if (!Metric_fetch(timestamp))
+      return false;
+
+   Metric_fetchProfiled(indom, instances, count);
+   return true;
+}
+
+static size_t Metric_bytesOf(const pmResult* result) {
+   if (!result)
+      return 0;
+
+   size_t bytes = 0;
+   for (int i = 0; i < result->numpmid; i++) {
+      const pmValueSet* vset = result->vset[i];
+
+      /* a negative count is the error of the metric */
+      for (int j = 0; j < vset->numval; j++) {
+         const pmValue* value = &vset->vlist[j];
+         bytes += sizeof(value->inst);
+         bytes += vset->valfmt == PM_VAL_INSITU ? sizeof(value->value.lval) : (size_t)value->value.pval->vlen;
+      }
+   }
+   return bytes;
+}
+
+size_t Metric_resultBytes(void) {
+   return Metric_bytesOf(pcp->result) + Metric_bytesOf(pcp->profiledResult);
+}
+
+static void Metric_addSourceDerived(const char* name) {
+   Metric_sourceDerived = xReallocArray(Metric_sourceDerived, Metric_sourceDerivedCount + 1, sizeof(char*));
+   Metric_sourceDerived[Metric_sourceDerivedCount++] = xStrdup(name);
+}
+
+static int Metric_compareNames(const void* v1, const void* v2) {
+   return strcmp(*(char* const*)v1, *(char* const*)v2);
+}
+
+void Metric_loadSourceDerived(void) {
+   /* none at all is the usual case, failing with PM_ERR_NAME */
+   if (pmTraversePMNS("htop", Metric_addSourceDerived) < 0 || !Metric_sourceDerivedCount)
+      return;
+
+   qsort(Metric_sourceDerived, Metric_sourceDerivedCount, sizeof(char*), Metric_compareNames);
+}
+
+int Metric_defineDerived(const char* name, const char* expression, char** error) {
+   if (Metric_sourceDerivedCount &&
+       bsearch(&name, Metric_sourceDerived, Metric_sourceDerivedCount, sizeof(char*), Metric_compareNames))
+      return 0;
+
+   return pmRegisterDerivedMetric(name, expression, error);
+}
+
+void Metric_resolve(const size_t* metrics, size_t count) {
+   if (Metric_resolvedSize < pcp->totalMetrics) {
+      Metric_resolved = xReallocArray(Metric_resolved, pcp->totalMetrics, sizeof(bool));
+      memset(&Metric_resolved[Metric_resolvedSize], 0, (pcp->totalMetrics - Metric_resolvedSize) * sizeof(bool));
+      Metric_resolvedSize = pcp->totalMetrics;
+   }
+
+   size_t* pending = xMallocArray(MAXIMUM(count, 1), sizeof(size_t));
+   const char** names = xMallocArray(MAXIMUM(count, 1), sizeof(char*));
+   int n = 0;
+   for (size_t i = 0; i < count; i++) {
+      const size_t metric = metrics[i];
+      if (metric < PCP_METRIC_COUNT || metric >= pcp->totalMetrics || Metric_resolved[metric])
+         continue;
+      Metric_resolved[metric] = true;
+      pending[n] = metric;
+      names[n] = pcp->names[metric];
+      n++;
+   }
+
+   if (n > 0) {
+      /* the context is not to be shared with a fetch running ahead */
+      Metric_stopAhead();
+
+      pmID* pmids = xMallocArray((size_t)n, sizeof(pmID));
+      pmDesc* descs = xCalloc((size_t)n, sizeof(pmDesc));
+      int sts = pmLookupName(n, names, pmids);
+      if (sts < 0) {
+         for (int i = 0; i < n; i++)
+            pmids[i] = PM_ID_NULL;
+      } else if ((sts = pmLookupDescs(n, pmids, descs)) < 0) {
+         for (int i = 0; i < n; i++)
+            pmids[i] = descs[i].pmid = PM_ID_NULL;
+      }
+      if (sts < 0 && pmDebugOptions.appl0)
+         fprintf(stderr, "Error: cannot lookup dynamic metrics: %s\n", pmErrStr(sts));
+
+      for (int i = 0; i < n; i++) {
+         pcp->pmids[pending[i]] = pmids[i];
+         pcp->descs[pending[i]] = descs[i];
+      }
+      free(descs);
+      free(pmids);
+   }
+
+   free(names);
+   free(pending);
+}
+
+void Metric_done(void) {
+   Metric_stopAhead();
+
+   free(Metric_resolved);
+   Metric_resolved = NULL;
+   Metric_resolvedSize = 0;
+
+   free(Metric_excluded);
+   Metric_excluded = NULL;
+   Metric_excludedCount = 0;
+   Metric_excludedSize = 0;
+
+   for (size_t i = 0; i < Metric_sourceDerivedCount; i++)
+      free(Metric_sourceDerived[i]);
+   free(Metric_sourceDerived);
+   Metric_sourceDerived = NULL;
+   Metric_sourceDerivedCount = 0;
+
+   if (pcp->archive) {
+      Metric_queuedCount = 0;
+      ArchiveCache_done(&Metric_archive);
+      pcp->result = NULL;
+   }
+}
+
 void Metric_externalName(Metric metric, int inst, char** externalName) {
    const pmDesc* desc = &pcp->descs[metric];
    /* ignore a failure here - its safe to do so */
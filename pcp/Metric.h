@@ -10,6 +10,7 @@ in the source distribution for its full text.
 
 #include <ctype.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <pcp/pmapi.h>
 #include <sys/time.h>
 
@@ -164,12 +165,109 @@ void Metric_enable(Metric metric, bool enable);
 
 bool Metric_enabled(Metric metric);
 
-void Metric_enableThreads(void);
+/* Whether fetches can be narrowed to some instances; not when replaying an archive */
+bool Metric_profiling(void);
+
+/* Moves an enabled metric to the fetch of the profiled instances, until it is enabled again */
+void Metric_enableProfiled(Metric metric);
+
+/*
+ * Has the proc PMDA list the threads of processes among the instances of its
+ * indom too, or not (proc.control.perclient.threads), in live contexts.
+ * Returns whether threads are fetched; from an archive, as far as logged.
+ */
+bool Metric_enableThreads(bool enable);
+
+/* Leaves the instances out of the fetches of all instances of indom, until called again; live contexts only */
+void Metric_excludeInstances(pmInDom indom, const int* instances, int count);
 
 bool Metric_fetch(struct timeval* timestamp);
 
+/*
+ * Starts fetching the enabled metrics, and the profiled ones for the given
+ * instances, on a thread of its own. The values shown meanwhile are those
+ * of the last fetch. False if no fetch can be run in the background.
+ */
+bool Metric_fetchAhead(pmInDom indom, const int* instances, int count);
+
+/* Whether the fetch started by Metric_fetchAhead() is complete, or none is running */
+bool Metric_fetchedAhead(void);
+
+/*
+ * Makes the values of the enabled metrics current, the ones moved by
+ * Metric_enableProfiled() for the given instances of their indom only:
+ * a sample left by Metric_seek(), those fetched ahead if they were asked
+ * for with the same metrics and instances, otherwise fetched now. With no
+ * instances the profiled metrics have no values.
+ */
+bool Metric_fetchCollect(struct timeval* timestamp, pmInDom indom, int* instances, int count);
+
+/* Bytes of the instances and values of the current results, as the source sent them */
+size_t Metric_resultBytes(void);
+
+/*
+ * Moves an archive replay by the given number of samples, back if negative.
+ * Returns how many samples the next fetches make current in turn, the last
+ * one the sample sought; the one before it gives the rates. Samples seen
+ * before are taken from memory rather than read from the archive again.
+ */
+int Metric_seek(int samples);
+
+/* Waits for a fetch still running ahead and frees what it fetched, and the archive samples kept */
+void Metric_done(void);
+
+/*
+ * Lists the metrics below "htop" the metric source defines itself, like a
+ * pmcd that was given the expressions of the dynamic meters, columns and
+ * screens as derived metrics of its own, in one traversal of its namespace.
+ */
+void Metric_loadSourceDerived(void);
+
+/*
+ * Defines name as the expression: left to the metric source where it
+ * computes name already, so that only the final values are fetched,
+ * otherwise registered as a derived metric computed here from its
+ * operands. Errors are those of pmRegisterDerivedMetric().
+ */
+int Metric_defineDerived(const char* name, const char* expression, char** error);
+
+/*
+ * Looks up the PMIDs and descriptors of the metrics of the dynamic meters,
+ * columns and screens among `metrics`, in one round trip for those not
+ * looked up before: their definitions are only read at startup, and their
+ * metrics resolved once something uses them. Ones not found keep PM_ID_NULL.
+ */
+void Metric_resolve(const size_t* metrics, size_t count);
+
 bool Metric_iterate(Metric metric, int* instp, int* offsetp);
 
+/*
+ * Reads the values of one metric straight from the fetched result, for
+ * instances asked for in about the order of its value set: each lookup
+ * carries on from the last one instead of searching, and the values are
+ * not converted or copied through a pmAtomValue.
+ */
+typedef struct MetricCursor_ {
+   const pmValueSet* vset;    /* NULL if the metric has no values */
+   int type;                  /* of the metric, as in its pmDesc */
+   int next;                  /* index the next lookup starts at */
+} MetricCursor;
+
+void MetricCursor_init(MetricCursor* this, Metric metric);
+
+/* The value of the instance, NULL if it has none */
+const pmValue* MetricCursor_find(MetricCursor* this, int inst);
+
+bool MetricCursor_unsigned(MetricCursor* this, int inst, unsigned long long* result);
+
+bool MetricCursor_signed(MetricCursor* this, int inst, long long* result);
+
+/* Points into the result fetched, valid until the next fetch */
+const char* MetricCursor_string(MetricCursor* this, int inst);
+
+/* A string value of one instance like Metric_instance(), without copying it: valid until the next fetch */
+const char* Metric_instanceString(Metric metric, int inst, int offset);
+
 pmAtomValue* Metric_values(Metric metric, pmAtomValue* atom, int count, int type);
 
 const pmDesc* Metric_desc(Metric metric);
@@ -0,0 +1,101 @@
+/*
+htop - PCPBench.c
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include "config.h" // IWYU pragma: keep
+
+#include "pcp/PCPBench.h"
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "CRT.h"
+#include "Object.h"
+#include "Profile.h"
+#include "RichString.h"
+#include "Row.h"
+#include "Settings.h"
+#include "Table.h"
+#include "Vector.h"
+
+#include "pcp/Metric.h"
+#include "pcp/PCPMachine.h"
+
+
+bool PCPBench_enabled = false;
+
+/* The rows a terminal would show, into a string that goes nowhere */
+static void PCPBench_draw(const Table* table) {
+   int drawn = 0;
+   for (int i = 0; i < Vector_size(table->displayList) && drawn < PCPBENCH_SCREEN_ROWS; i++) {
+      Row* row = (Row*) Vector_get(table->displayList, i);
+      if (!row->show || Row_matchesFilter(row, table))
+         continue;
+
+      RichString_begin(str);
+      Object_display(row, &str);
+      RichString_delete(&str);
+      drawn++;
+   }
+}
+
+bool PCPBench_run(Machine* host) {
+   PCPMachine* this = (PCPMachine*) host;
+   Settings* settings = host->settings;
+   Table* table = host->activeTable;
+
+   /* as in batch mode: nothing kept for highlighting, every row read in full */
+   settings->highlightChanges = false;
+   settings->lazyCollection = false;
+   CRT_initHeadless();
+
+   const uint64_t startNs = Profile_begin().ns;
+   uint64_t samples = 0;
+   uint64_t payloadBytes = 0;
+   double firstTimestamp = 0.0;
+
+   while (host->iterationsRemaining != 0) {
+      ProfileMark mark = Profile_begin();
+      Machine_scan(host);
+      Profile_end(PROFILE_MACHINE_SCAN, mark);
+
+      /* the end of the archive */
+      if (this->fetchFailed)
+         break;
+
+      if (!samples)
+         firstTimestamp = this->timestamp;
+      samples++;
+      payloadBytes += Metric_resultBytes();
+
+      Machine_scanTables(host);
+
+      table->needsSort = true;
+      Table_updateDisplayList(table);
+
+      mark = Profile_begin();
+      PCPBench_draw(table);
+      Profile_end(PROFILE_PANEL_DRAW, mark);
+
+      if (host->iterationsRemaining > 0)
+         host->iterationsRemaining--;
+   }
+
+   const double seconds = (double)(Profile_begin().ns - startNs) / 1e9;
+   if (!samples) {
+      fprintf(stderr, "Error: no sample could be read from the archive\n");
+      return false;
+   }
+
+   printf("%" PRIu64 " samples over %.0f s of the archive in %.3f s, %.1f samples/s, %d rows\n",
+          samples, this->timestamp - firstTimestamp, seconds, (double)samples / seconds, Vector_size(table->rows));
+   printf("fetched %" PRIu64 " bytes of values, %" PRIu64 " per sample\n\n",
+          payloadBytes, payloadBytes / samples);
+   Profile_dump(stdout);
+
+   return true;
+}
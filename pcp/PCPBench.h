@@ -0,0 +1,31 @@
+#ifndef HEADER_PCPBench
+#define HEADER_PCPBench
+/*
+htop - PCPBench.h
+(C) 2024 htop dev team
+Released under the GNU GPLv2+, see the COPYING file
+in the source distribution for its full text.
+*/
+
+#include <stdbool.h>
+
+#include "Machine.h"
+
+
+/*
+ * pcp-htop --bench=ARCHIVE: replays the archive as fast as it can be read,
+ * through the fetch, the process table, sorting and the rows of a screen
+ * drawn to nowhere, then prints the time of each phase and the bytes of
+ * the values fetched.
+ */
+
+/* Rows of the screen drawn for each sample */
+#define PCPBENCH_SCREEN_ROWS 50
+
+/* Set by the option, before the platform is initialised */
+extern bool PCPBench_enabled;
+
+/* False if no sample could be read */
+bool PCPBench_run(Machine* host);
+
+#endif
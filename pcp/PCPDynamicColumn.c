@@ -32,6 +32,9 @@ in the source distribution for its full text.
 #include "pcp/PCPProcess.h"
 
 
+extern Platform* pcp;
+
+
 static bool PCPDynamicColumn_addMetric(PCPDynamicColumns* columns, PCPDynamicColumn* column) {
    if (!column->super.name[0])
       return false;
@@ -49,17 +52,16 @@ static bool PCPDynamicColumn_addMetric(PCPDynamicColumns* columns, PCPDynamicCol
 }
 
 static void PCPDynamicColumn_parseMetric(PCPDynamicColumns* columns, PCPDynamicColumn* column, const char* path, unsigned int line, char* value) {
-   /* pmLookupText */
-   if (!column->super.description)
-      Metric_lookupText(value, &column->super.description);
-
    /* lookup a dynamic metric with this name, else create */
    if (PCPDynamicColumn_addMetric(columns, column) == false)
       return;
 
+   /* pmLookupText once resolved, as that goes to the metric source */
+   free_and_xStrdup(&column->expression, value);
+
    /* derived metrics in all dynamic columns for simplicity */
    char* error;
-   if (pmRegisterDerivedMetric(column->metricName, value, &error) < 0) {
+   if (Metric_defineDerived(column->metricName, value, &error) < 0) {
       char* note;
       xAsprintf(&note,
                 "%s: failed to parse expression in %s at line %u\n%s\n",
@@ -252,6 +254,7 @@ void PCPDynamicColumns_init(PCPDynamicColumns* columns) {
 void PCPDynamicColumn_done(PCPDynamicColumn* this) {
    DynamicColumn_done(&this->super);
    free(this->metricName);
+   free(this->expression);
    free(this->format);
 }
 
@@ -264,9 +267,7 @@ void PCPDynamicColumns_done(Hashtable* table) {
    Hashtable_foreach(table, PCPDynamicColumns_free, NULL);
 }
 
-static void PCPDynamicColumn_setupWidth(ATTR_UNUSED ht_key_t key, void* value, ATTR_UNUSED void* data) {
-   PCPDynamicColumn* column = (PCPDynamicColumn*) value;
-
+static void PCPDynamicColumn_setupWidth(PCPDynamicColumn* column) {
    /* calculate column size based on config file and metric units */
    const pmDesc* desc = Metric_desc(column->id);
 
@@ -306,8 +307,37 @@ static void PCPDynamicColumn_setupWidth(ATTR_UNUSED ht_key_t key, void* value, A
       column->super.width = 11; // Row_printCount
 }
 
+static void PCPDynamicColumns_setupWidth(ATTR_UNUSED ht_key_t key, void* value, ATTR_UNUSED void* data) {
+   PCPDynamicColumn_setupWidth((PCPDynamicColumn*) value);
+}
+
 void PCPDynamicColumns_setupWidths(PCPDynamicColumns* columns) {
-   Hashtable_foreach(columns->table, PCPDynamicColumn_setupWidth, NULL);
+   Hashtable_foreach(columns->table, PCPDynamicColumns_setupWidth, NULL);
+}
+
+void PCPDynamicColumns_resolve(PCPDynamicColumn* const* columns, size_t count) {
+   size_t* metrics = xMallocArray(MAXIMUM(count, 1), sizeof(size_t));
+   size_t n = 0;
+   for (size_t i = 0; i < count; i++) {
+      if (!columns[i]->resolved)
+         metrics[n++] = columns[i]->id;
+   }
+
+   if (n > 0)
+      Metric_resolve(metrics, n);
+   free(metrics);
+
+   for (size_t i = 0; i < count; i++) {
+      PCPDynamicColumn* column = columns[i];
+      if (column->resolved)
+         continue;
+      column->resolved = true;
+
+      Metric_enable(column->id, true);
+      if (!column->super.description && !column->instances && column->expression)
+         Metric_lookupText(column->expression, &column->super.description);
+      PCPDynamicColumn_setupWidth(column);
+   }
 }
 
 /* normalize output units to bytes and seconds */
@@ -454,18 +484,78 @@ void PCPDynamicColumn_writeAtomValue(PCPDynamicColumn* column, RichString* str,
       Row_printCount(str, value, 0);  /* e.g. PID */
 }
 
+/* The value of a dynamic column for one process, as extracted after the last fetch */
+typedef struct PCPDynamicValue_ {
+   pmAtomValue atom;
+   int type;                  /* of atom, PM_TYPE_UNKNOWN without a value */
+} PCPDynamicValue;
+
+static void PCPDynamicValue_clear(PCPDynamicValue* this) {
+   if (this->type == PM_TYPE_STRING)
+      free(this->atom.cp);
+   memset(&this->atom, 0, sizeof(this->atom));
+   this->type = PM_TYPE_UNKNOWN;
+}
+
+static void PCPDynamicColumns_extract(const PCPDynamicColumns* columns, PCPProcess* pp, const PCPDynamicColumn* column) {
+   if (column->id < columns->offset || column->id - columns->offset >= pp->dynamicValueCount)
+      return;
+
+   PCPDynamicValue* value = &pp->dynamicValues[column->id - columns->offset];
+   if (value->type != PM_TYPE_UNKNOWN)
+      return;
+
+   const int type = Metric_type(column->id);
+   if (Metric_instance(column->id, Process_getPid(&pp->super), pp->offset, &value->atom, type))
+      value->type = type;
+}
+
+void PCPDynamicColumns_updateValues(const PCPDynamicColumns* columns, PCPProcess* pp, const ScreenColumn* shown, int shownCount, const PCPDynamicColumn* sortColumn) {
+   if (pp->dynamicValueCount < columns->count) {
+      pp->dynamicValues = xReallocArray(pp->dynamicValues, columns->count, sizeof(PCPDynamicValue));
+      for (size_t i = pp->dynamicValueCount; i < columns->count; i++)
+         pp->dynamicValues[i].type = PM_TYPE_UNKNOWN;
+      pp->dynamicValueCount = columns->count;
+   }
+
+   for (size_t i = 0; i < pp->dynamicValueCount; i++)
+      PCPDynamicValue_clear(&pp->dynamicValues[i]);
+
+   /* only the ones of the screen, not every column of the configuration files */
+   for (int i = 0; i < shownCount; i++) {
+      if (shown[i].field >= LAST_PROCESSFIELD && shown[i].dynamic)
+         PCPDynamicColumns_extract(columns, pp, (const PCPDynamicColumn*) shown[i].dynamic);
+   }
+
+   if (sortColumn)
+      PCPDynamicColumns_extract(columns, pp, sortColumn);
+}
+
+void PCPDynamicColumns_freeValues(PCPProcess* pp) {
+   for (size_t i = 0; i < pp->dynamicValueCount; i++)
+      PCPDynamicValue_clear(&pp->dynamicValues[i]);
+   free(pp->dynamicValues);
+   pp->dynamicValues = NULL;
+   pp->dynamicValueCount = 0;
+}
+
+/* The value of the column extracted for the process, NULL if there is none */
+static const PCPDynamicValue* PCPDynamicColumn_value(const PCPDynamicColumn* this, const PCPProcess* pp) {
+   const size_t offset = pcp->columns.offset;
+   if (this->id < offset || this->id - offset >= pp->dynamicValueCount)
+      return NULL;
+
+   const PCPDynamicValue* value = &pp->dynamicValues[this->id - offset];
+   return value->type != PM_TYPE_UNKNOWN ? value : NULL;
+}
+
 void PCPDynamicColumn_writeField(PCPDynamicColumn* this, const Process* proc, RichString* str) {
    const Settings* settings = proc->super.host->settings;
    const PCPProcess* pp = (const PCPProcess*) proc;
    const pmDesc* desc = Metric_desc(this->id);
-   pid_t pid = Process_getPid(proc);
-
-   pmAtomValue atom;
-   pmAtomValue* ap = &atom;
-   if (!Metric_instance(this->id, pid, pp->offset, ap, desc->type))
-      ap = NULL;
+   const PCPDynamicValue* value = PCPDynamicColumn_value(this, pp);
 
-   PCPDynamicColumn_writeAtomValue(this, str, settings, this->id, pid, desc, ap);
+   PCPDynamicColumn_writeAtomValue(this, str, settings, this->id, Process_getPid(proc), desc, value ? &value->atom : NULL);
 }
 
 int PCPDynamicColumn_compareByKey(const PCPProcess* p1, const PCPProcess* p2, ProcessField key) {
@@ -476,38 +566,28 @@ int PCPDynamicColumn_compareByKey(const PCPProcess* p1, const PCPProcess* p2, Pr
    if (!column)
       return -1;
 
-   size_t metric = column->id;
-   unsigned int type = Metric_type(metric);
-
-   pmAtomValue atom1 = {0}, atom2 = {0};
-   if (!Metric_instance(metric, Process_getPid(&p1->super), p1->offset, &atom1, type) ||
-       !Metric_instance(metric, Process_getPid(&p2->super), p2->offset, &atom2, type)) {
-      if (type == PM_TYPE_STRING) {
-         free(atom1.cp);
-         free(atom2.cp);
-      }
+   const PCPDynamicValue* value1 = PCPDynamicColumn_value(column, p1);
+   const PCPDynamicValue* value2 = PCPDynamicColumn_value(column, p2);
+   if (!value1 || !value2)
       return -1;
-   }
 
-   switch (type) {
-      case PM_TYPE_STRING: {
-         int cmp = SPACESHIP_NULLSTR(atom2.cp, atom1.cp);
-         free(atom2.cp);
-         free(atom1.cp);
-         return cmp;
-      }
+   const pmAtomValue* atom1 = &value1->atom;
+   const pmAtomValue* atom2 = &value2->atom;
+   switch (value1->type) {
+      case PM_TYPE_STRING:
+         return SPACESHIP_NULLSTR(atom2->cp, atom1->cp);
       case PM_TYPE_32:
-         return SPACESHIP_NUMBER(atom2.l, atom1.l);
+         return SPACESHIP_NUMBER(atom2->l, atom1->l);
       case PM_TYPE_U32:
-         return SPACESHIP_NUMBER(atom2.ul, atom1.ul);
+         return SPACESHIP_NUMBER(atom2->ul, atom1->ul);
       case PM_TYPE_64:
-         return SPACESHIP_NUMBER(atom2.ll, atom1.ll);
+         return SPACESHIP_NUMBER(atom2->ll, atom1->ll);
       case PM_TYPE_U64:
-         return SPACESHIP_NUMBER(atom2.ull, atom1.ull);
+         return SPACESHIP_NUMBER(atom2->ull, atom1->ull);
       case PM_TYPE_FLOAT:
-         return compareRealNumbers(atom2.f, atom1.f);
+         return compareRealNumbers(atom2->f, atom1->f);
       case PM_TYPE_DOUBLE:
-         return compareRealNumbers(atom2.d, atom1.d);
+         return compareRealNumbers(atom2->d, atom1->d);
       default:
          break;
    }
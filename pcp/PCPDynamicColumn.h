@@ -13,6 +13,7 @@ in the source distribution for its full text.
 #include "Hashtable.h"
 #include "Process.h"
 #include "RichString.h"
+#include "Settings.h"
 
 #include "pcp/PCPProcess.h"
 
@@ -22,12 +23,14 @@ struct pmDesc;
 typedef struct PCPDynamicColumn_ {
    DynamicColumn super;
    char* metricName;
+   char* expression;  /* of metricName, for its help text */
    char* format;
    size_t id;  /* identifier for metric array lookups */
    int width;  /* optional width from configuration file */
    bool defaultEnabled;  /* default enabled in dynamic screen */
    bool percent;
    bool instances;  /* an instance *names* column, not values */
+   bool resolved;  /* metric looked up, see PCPDynamicColumns_resolve() */
 } PCPDynamicColumn;
 
 typedef struct PCPDynamicColumns_ {
@@ -43,6 +46,21 @@ void PCPDynamicColumns_done(Hashtable* table);
 
 void PCPDynamicColumns_setupWidths(PCPDynamicColumns* columns);
 
+/*
+ * Looks up and enables the metrics of the columns, in one go for those not
+ * resolved yet, once a screen shows them; their help text and width follow.
+ */
+void PCPDynamicColumns_resolve(PCPDynamicColumn* const* columns, size_t count);
+
+/*
+ * Extracts the values of the dynamic columns in `shown` and of `sortColumn`
+ * (NULL if sorted by another one) for the process from the last fetch, so
+ * sorting and drawing read them from the process instead.
+ */
+void PCPDynamicColumns_updateValues(const PCPDynamicColumns* columns, PCPProcess* pp, const ScreenColumn* shown, int shownCount, const PCPDynamicColumn* sortColumn);
+
+void PCPDynamicColumns_freeValues(PCPProcess* pp);
+
 void PCPDynamicColumn_writeField(PCPDynamicColumn* this, const Process* proc, RichString* str);
 
 void PCPDynamicColumn_writeAtomValue(PCPDynamicColumn* column, RichString* str, const struct Settings_* settings, int metric, int instance, const struct pmDesc* desc, const void* atomvalue);
@@ -73,7 +73,7 @@ static void PCPDynamicMeter_parseMetric(PCPDynamicMeters* meters, PCPDynamicMete
 
       /* use derived metrics in dynamic meters for simplicity */
       char* error;
-      if (pmRegisterDerivedMetric(metric->name, value, &error) < 0) {
+      if (Metric_defineDerived(metric->name, value, &error) < 0) {
          char* note;
          xAsprintf(&note,
                    "%s: failed to parse expression in %s at line %u\n%s\n%s",
@@ -309,6 +309,13 @@ void PCPDynamicMeters_done(Hashtable* table) {
 }
 
 void PCPDynamicMeter_enable(PCPDynamicMeter* this) {
+   /* the metrics of meters in the header only are looked up, on first use */
+   size_t* metrics = xMallocArray(MAXIMUM(this->totalMetrics, 1), sizeof(size_t));
+   for (size_t i = 0; i < this->totalMetrics; i++)
+      metrics[i] = this->metrics[i].id;
+   Metric_resolve(metrics, this->totalMetrics);
+   free(metrics);
+
    for (size_t i = 0; i < this->totalMetrics; i++)
       Metric_enable(this->metrics[i].id, true);
 }
@@ -22,6 +22,7 @@ in the source distribution for its full text.
 #include "XUtils.h"
 
 #include "pcp/InDomTable.h"
+#include "pcp/Metric.h"
 #include "pcp/PCPDynamicColumn.h"
 
 
@@ -115,7 +116,7 @@ static void PCPDynamicScreen_parseColumn(PCPDynamicScreen* screen, const char* p
 
    if (String_eq(p, "metric")) {
       char* error;
-      if (pmRegisterDerivedMetric(column->metricName, value, &error) < 0) {
+      if (Metric_defineDerived(column->metricName, value, &error) < 0) {
          char* note;
          xAsprintf(&note,
                    "%s: failed to parse expression in %s at line %u\n%s\n",
@@ -126,9 +127,8 @@ static void PCPDynamicScreen_parseColumn(PCPDynamicScreen* screen, const char* p
          free(note);
       }
 
-      /* pmLookupText - add optional metric help text */
-      if (!column->super.description && !column->instances)
-         Metric_lookupText(value, &column->super.description);
+      /* pmLookupText - optional metric help text, once the column is resolved */
+      free_and_xStrdup(&column->expression, value);
 
    } else {
       /* this is a property of a dynamic column - the column expression */
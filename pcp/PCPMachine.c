@@ -22,13 +22,24 @@ in the source distribution for its full text.
 #include "Macros.h"
 #include "Object.h"
 #include "Platform.h"
+#include "Process.h"
+#include "ProcessTable.h"
+#include "Profile.h"
+#include "Row.h"
 #include "Settings.h"
+#include "Table.h"
+#include "Vector.h"
 #include "XUtils.h"
 
 #include "pcp/Metric.h"
+#include "pcp/PCPDynamicColumn.h"
+#include "pcp/PCPDynamicScreen.h"
 #include "pcp/PCPProcess.h"
 
 
+extern Platform* pcp;
+
+
 static void PCPMachine_updateCPUcount(PCPMachine* this) {
    Machine* super = &this->super;
    super->activeCPUs = Metric_instanceCount(PCP_PERCPU_SYSTEM);
@@ -264,10 +275,163 @@ static void PCPMachine_scan(PCPMachine* this) {
    PCPMachine_scanZswapInfo(this);
 }
 
-void Machine_scan(Machine* super) {
-   PCPMachine* host = (PCPMachine*) super;
-   const Settings* settings = super->settings;
-   uint32_t flags = settings->ss->flags;
+/* Metrics of columns only displayed, fetched for the rows on screen only with lazy collection */
+static const struct {
+   Metric metric;
+   uint64_t flag;
+} PCPMachine_lazyMetrics[] = {
+   { PCP_PROC_IO_RCHAR,       PROCESS_FLAG_IO },
+   { PCP_PROC_IO_WCHAR,       PROCESS_FLAG_IO },
+   { PCP_PROC_IO_SYSCR,       PROCESS_FLAG_IO },
+   { PCP_PROC_IO_SYSCW,       PROCESS_FLAG_IO },
+   { PCP_PROC_IO_READB,       PROCESS_FLAG_IO },
+   { PCP_PROC_IO_WRITEB,      PROCESS_FLAG_IO },
+   { PCP_PROC_IO_CANCELLED,   PROCESS_FLAG_IO },
+   { PCP_PROC_CWD,            PROCESS_FLAG_CWD },
+   { PCP_PROC_CGROUPS,        PROCESS_FLAG_LINUX_CGROUP },
+   { PCP_PROC_OOMSCORE,       PROCESS_FLAG_LINUX_OOM },
+   { PCP_PROC_LABELS,         PROCESS_FLAG_LINUX_SECATTR },
+   { PCP_PROC_AUTOGROUP_ID,   PROCESS_FLAG_LINUX_AUTOGROUP },
+   { PCP_PROC_AUTOGROUP_NICE, PROCESS_FLAG_LINUX_AUTOGROUP },
+};
+
+/*
+ * With lazy collection the metrics of display-only columns are left out
+ * of the fetch of all processes, and fetched for the rows on screen in a
+ * second one; whatever the table is sorted by is still fetched for all.
+ */
+static void PCPMachine_updateLazyFlags(PCPMachine* this, const Settings* settings) {
+   const Machine* super = &this->super;
+   const ProcessTable* pt = (const ProcessTable*) super->processTable;
+
+   this->lazyFlags = 0;
+   if (!settings->lazyCollection || !pt || !Metric_profiling())
+      return;
+
+   /* a filtered view shows every process matching, wherever it is */
+   if (pt->pidMatchList || super->userId != (uid_t)-1)
+      return;
+
+   uint64_t flags = settings->ss->flags;
+   const RowField sortKey = ScreenSettings_getActiveSortKey(settings->ss);
+   if (sortKey > 0 && sortKey < LAST_PROCESSFIELD)
+      flags &= ~Process_fields[sortKey].flags;
+
+   for (size_t i = 0; i < ARRAYSIZE(PCPMachine_lazyMetrics); i++) {
+      if (!(flags & PCPMachine_lazyMetrics[i].flag))
+         continue;
+
+      Metric_enableProfiled(PCPMachine_lazyMetrics[i].metric);
+      this->lazyFlags |= PCPMachine_lazyMetrics[i].flag;
+   }
+}
+
+/* Collects the instances of the rows on screen, shown after the last scan */
+static int PCPMachine_profile(PCPMachine* this) {
+   const Table* table = this->super.processTable;
+
+   size_t count = 0;
+   for (int i = 0; i < Vector_size(table->rows); i++) {
+      const Row* row = (const Row*) Vector_get(table->rows, i);
+      if (!Table_isRowOnScreen(table, row))
+         continue;
+
+      if (count == this->profileSize) {
+         this->profileSize = this->profileSize ? this->profileSize * 2 : 64;
+         this->profile = xReallocArray(this->profile, this->profileSize, sizeof(int));
+      }
+      this->profile[count++] = row->id;
+   }
+
+   return (int)count;
+}
+
+/*
+ * Threads are only fetched while they are shown, and in a tree not those of
+ * processes folded up: their instances of the last scan are left out of the
+ * fetch, new threads of such a process come along once. Each thread is an
+ * instance of its own, on hosts running thread-heavy JVMs most of them.
+ */
+static void PCPMachine_updateThreads(PCPMachine* this, const Settings* settings) {
+   const Table* table = this->super.processTable;
+
+   this->threadsFetched = Metric_enableThreads(!settings->hideUserlandThreads);
+   this->threadsFolded = this->threadsFetched && settings->ss->treeView && table && Metric_profiling();
+
+   size_t count = 0;
+   for (int i = 0; this->threadsFolded && i < Vector_size(table->rows); i++) {
+      const Process* proc = (const Process*) Vector_get(table->rows, i);
+      if (!Process_isUserlandThread(proc))
+         continue;
+
+      const Row* main = Table_findRow(table, Process_getThreadGroup(proc));
+      if (!main || main->showChildren)
+         continue;
+
+      if (count == this->foldedSize) {
+         this->foldedSize = this->foldedSize ? this->foldedSize * 2 : 64;
+         this->folded = xReallocArray(this->folded, this->foldedSize, sizeof(int));
+      }
+      this->folded[count++] = proc->super.id;
+   }
+
+   Metric_excludeInstances(Metric_desc(PCP_PROC_PID)->indom, this->folded, (int)count);
+}
+
+/* Dynamic columns to be resolved together */
+typedef struct PendingColumns_ {
+   PCPDynamicColumn** columns;
+   size_t count;
+   size_t size;
+} PendingColumns;
+
+static void PendingColumns_add(PendingColumns* this, PCPDynamicColumn* column) {
+   if (!column || column->resolved)
+      return;
+
+   if (this->count == this->size) {
+      this->size = this->size ? this->size * 2 : 16;
+      this->columns = xReallocArray(this->columns, this->size, sizeof(PCPDynamicColumn*));
+   }
+   this->columns[this->count++] = column;
+}
+
+/*
+ * The metrics of the dynamic columns the screens use, and of the key
+ * column of the dynamic screens among them, are looked up together the
+ * first time the settings have them; columns added later on are looked
+ * up as they are added, see Platform_dynamicColumnName().
+ */
+static void PCPMachine_resolveColumns(const Settings* settings) {
+   PendingColumns pending = { .columns = NULL, .count = 0, .size = 0 };
+   Hashtable* columns = pcp->columns.table;
+
+   for (unsigned int i = 0; i < settings->nScreens; i++) {
+      const ScreenSettings* ss = settings->screens[i];
+      for (const RowField* field = ss->fields; field && *field; field++) {
+         if (*field >= LAST_PROCESSFIELD)
+            PendingColumns_add(&pending, Hashtable_get(columns, *field));
+      }
+      if (ss->sortKey >= LAST_PROCESSFIELD)
+         PendingColumns_add(&pending, Hashtable_get(columns, ss->sortKey));
+
+      unsigned int key;
+      if (!ss->dynamic || !DynamicScreen_search(pcp->screens.table, ss->dynamic, &key))
+         continue;
+      const PCPDynamicScreen* ds = Hashtable_get(pcp->screens.table, key);
+      if (ds && ds->totalColumns > 0)
+         PendingColumns_add(&pending, ds->columns[0]);
+   }
+
+   if (pending.count > 0)
+      PCPDynamicColumns_resolve(pending.columns, pending.count);
+   free(pending.columns);
+}
+
+/* Enables the metrics the settings need, returning the instances of the rows on screen */
+static int PCPMachine_enableMetrics(PCPMachine* host) {
+   const Settings* settings = host->super.settings;
+   uint64_t flags = settings->ss->flags;
    bool flagged;
 
    for (int metric = PCP_PROC_PID; metric < PCP_METRIC_COUNT; metric++)
@@ -294,8 +458,27 @@ void Machine_scan(Machine* super) {
    Metric_enable(PCP_PROC_SMAPS_SWAP, host->smaps_flag);
    Metric_enable(PCP_PROC_SMAPS_SWAPPSS, host->smaps_flag);
 
+   PCPMachine_resolveColumns(settings);
+   PCPMachine_updateLazyFlags(host, settings);
+   PCPMachine_updateThreads(host, settings);
+   return PCPMachine_profile(host);
+}
+
+bool PCPMachine_fetchAhead(PCPMachine* this) {
+   const int count = PCPMachine_enableMetrics(this);
+   return Metric_fetchAhead(Metric_desc(PCP_PROC_PID)->indom, this->profile, count);
+}
+
+void Machine_scan(Machine* super) {
+   PCPMachine* host = (PCPMachine*) super;
+   const int count = PCPMachine_enableMetrics(host);
+
+   /* with a fetch started ahead, only waits for it to complete */
    struct timeval timestamp;
-   if (Metric_fetch(&timestamp) != true)
+   const ProfileMark mark = Profile_begin();
+   host->fetchFailed = !Metric_fetchCollect(&timestamp, Metric_desc(PCP_PROC_PID)->indom, host->profile, count);
+   Profile_end(host->fetchPhase, mark);
+   if (host->fetchFailed)
       return;
 
    double sample = host->timestamp;
@@ -315,6 +498,8 @@ Machine* Machine_new(UsersTable* usersTable, uid_t userId) {
    gettimeofday(&timestamp, NULL);
    this->timestamp = pmtimevalToReal(&timestamp);
 
+   this->fetchPhase = Profile_addPhase("pcp fetch");
+
    this->cpu = xCalloc(CPU_METRIC_COUNT, sizeof(pmAtomValue));
    PCPMachine_updateCPUcount(this);
 
@@ -327,6 +512,8 @@ void Machine_delete(Machine* super) {
    PCPMachine* this = (PCPMachine*) super;
    Machine_done(super);
    free(this->values);
+   free(this->profile);
+   free(this->folded);
    for (unsigned int i = 0; i < super->existingCPUs; i++)
       free(this->percpu[i]);
    free(this->percpu);
@@ -8,6 +8,8 @@ in the source distribution for its full text.
 */
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <sys/types.h>
 
 #include "Hashtable.h"
@@ -58,14 +60,28 @@ typedef struct PCPMachine_ {
    int smaps_flag;
    double period;
    double timestamp;     /* previous sample timestamp */
+   bool fetchFailed;     /* no sample in the last scan, as at the end of an archive */
+   int fetchPhase;       /* Profile phase of the fetch of a scan */
 
    pmAtomValue* cpu;     /* aggregate values for each metric */
    pmAtomValue** percpu; /* per-processor values for each metric */
    pmAtomValue* values;  /* per-processor buffer for just one metric */
 
+   uint64_t lazyFlags;   /* PROCESS_FLAG_* metrics fetched for the rows on screen only */
+   int* profile;         /* their instances, see Metric_fetchProfiled() */
+   size_t profileSize;
+
+   bool threadsFetched;  /* threads are among the instances fetched */
+   bool threadsFolded;   /* but not those of processes folded up in the tree */
+   int* folded;          /* their instances, left out of the fetch */
+   size_t foldedSize;
+
    ZfsArcStats zfs;
    /*ZramStats zram; -- not needed, calculated in-line in Platform.c */
    ZswapStats zswap;
 } PCPMachine;
 
+/* Starts the fetch of the next Machine_scan() in the background, false if it can not be */
+bool PCPMachine_fetchAhead(PCPMachine* this);
+
 #endif
@@ -9,6 +9,8 @@ in the source distribution for its full text.
 
 #include "config.h" // IWYU pragma: keep
 
+#define HEAP_CLASS HEAP_PROCESSES
+
 #include "pcp/PCPProcess.h"
 
 #include <math.h>
@@ -89,12 +91,15 @@ const ProcessFieldData Process_fields[] = {
    [PROC_COMM] = { .name = "COMM", .title = "COMM            ", .description = "comm string of the process", .flags = 0, },
    [PROC_EXE] = { .name = "EXE", .title = "EXE             ", .description = "Basename of exe of the process", .flags = 0, },
    [CWD] = { .name = "CWD", .title = "CWD                       ", .description = "The current working directory of the process", .flags = PROCESS_FLAG_CWD, },
+   [CPU_HISTORY] = { .name = "CPU_HISTORY", .title = "CPU HISTORY                    ", .description = "Sparkline of the CPU usage over the last updates, full height being one CPU busy", .flags = PROCESS_FLAG_HISTORY, .defaultSortDesc = true, },
+   [MEM_HISTORY] = { .name = "MEM_HISTORY", .title = "RES HISTORY                    ", .description = "Sparkline of the resident memory over the last updates, against its peak", .flags = PROCESS_FLAG_HISTORY, .defaultSortDesc = true, },
+   [MEM_GROWTH] = { .name = "MEM_GROWTH", .title = "  RES/h ", .description = "Growth of the resident memory per hour, fitted over the memory growth window (leak suspects)", .flags = PROCESS_FLAG_MEM_GROWTH, .defaultSortDesc = true, },
    [AUTOGROUP_ID] = { .name = "AUTOGROUP_ID", .title = "AGRP", .description = "The autogroup identifier of the process", .flags = PROCESS_FLAG_LINUX_AUTOGROUP, },
    [AUTOGROUP_NICE] = { .name = "AUTOGROUP_NICE", .title = " ANI", .description = "Nice value (the higher the value, the more other processes take priority) associated with the process autogroup", .flags = PROCESS_FLAG_LINUX_AUTOGROUP, },
 };
 
 Process* PCPProcess_new(const Machine* host) {
-   PCPProcess* this = xCalloc(1, sizeof(PCPProcess));
+   PCPProcess* this = Process_allocate(sizeof(PCPProcess));
    Object_setClass(this, Class(PCPProcess));
    Process_init(&this->super, host);
    return &this->super;
@@ -106,7 +111,8 @@ void Process_delete(Object* cast) {
    free(this->cgroup_short);
    free(this->cgroup);
    free(this->secattr);
-   free(this);
+   PCPDynamicColumns_freeValues(this);
+   Process_release(this, sizeof(PCPProcess));
 }
 
 static void PCPProcess_printDelay(float delay_percent, char* buffer, size_t n) {
@@ -118,14 +124,16 @@ static void PCPProcess_printDelay(float delay_percent, char* buffer, size_t n) {
 }
 
 static double PCPProcess_totalIORate(const PCPProcess* pp) {
+   const double readRate = Rate_value(&pp->io_read_rate);
+   const double writeRate = Rate_value(&pp->io_write_rate);
    double totalRate = NAN;
-   if (isNonnegative(pp->io_rate_read_bps)) {
-      totalRate = pp->io_rate_read_bps;
-      if (isNonnegative(pp->io_rate_write_bps)) {
-         totalRate += pp->io_rate_write_bps;
+   if (isNonnegative(readRate)) {
+      totalRate = readRate;
+      if (isNonnegative(writeRate)) {
+         totalRate += writeRate;
       }
-   } else if (isNonnegative(pp->io_rate_write_bps)) {
-      totalRate = pp->io_rate_write_bps;
+   } else if (isNonnegative(writeRate)) {
+      totalRate = writeRate;
    }
    return totalRate;
 }
@@ -161,8 +169,8 @@ static void PCPProcess_rowWriteField(const Row* super, RichString* str, ProcessF
    case RBYTES: Row_printBytes(str, pp->io_read_bytes, coloring); return;
    case WBYTES: Row_printBytes(str, pp->io_write_bytes, coloring); return;
    case CNCLWB: Row_printBytes(str, pp->io_cancelled_write_bytes, coloring); return;
-   case IO_READ_RATE:  Row_printRate(str, pp->io_rate_read_bps, coloring); return;
-   case IO_WRITE_RATE: Row_printRate(str, pp->io_rate_write_bps, coloring); return;
+   case IO_READ_RATE:  Row_printRate(str, Rate_value(&pp->io_read_rate), coloring); return;
+   case IO_WRITE_RATE: Row_printRate(str, Rate_value(&pp->io_write_rate), coloring); return;
    case IO_RATE: Row_printRate(str, PCPProcess_totalIORate(pp), coloring); return;
    case CGROUP: xSnprintf(buffer, n, "%-35.35s ", pp->cgroup ? pp->cgroup : "N/A"); break;
    case CCGROUP: xSnprintf(buffer, n, "%-35.35s ", pp->cgroup_short ? pp->cgroup_short : (pp->cgroup ? pp->cgroup : "N/A")); break;
@@ -257,9 +265,9 @@ static int PCPProcess_compareByKey(const Process* v1, const Process* v2, Process
    case CNCLWB:
       return SPACESHIP_NUMBER(p1->io_cancelled_write_bytes, p2->io_cancelled_write_bytes);
    case IO_READ_RATE:
-      return compareRealNumbers(p1->io_rate_read_bps, p2->io_rate_read_bps);
+      return compareRealNumbers(Rate_value(&p1->io_read_rate), Rate_value(&p2->io_read_rate));
    case IO_WRITE_RATE:
-      return compareRealNumbers(p1->io_rate_write_bps, p2->io_rate_write_bps);
+      return compareRealNumbers(Rate_value(&p1->io_write_rate), Rate_value(&p2->io_write_rate));
    case IO_RATE:
       return compareRealNumbers(PCPProcess_totalIORate(p1), PCPProcess_totalIORate(p2));
    case CGROUP:
@@ -10,10 +10,12 @@ in the source distribution for its full text.
 */
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "Machine.h"
 #include "Object.h"
 #include "Process.h"
+#include "Rate.h"
 
 
 #define PROCESS_FLAG_LINUX_CGROUP    0x00000800
@@ -66,11 +68,9 @@ typedef struct PCPProcess_ {
    /* Storage data cancelled (in kilobytes) */
    unsigned long long io_cancelled_write_bytes;
 
-   /* Point in time of last io scan (in seconds elapsed since the Epoch) */
-   unsigned long long io_last_scan_time;
-
-   double io_rate_read_bps;
-   double io_rate_write_bps;
+   /* Storage data read and written (in bytes per second) */
+   Rate io_read_rate;
+   Rate io_write_rate;
    char* cgroup;
    char* cgroup_short;
    char* container_short;
@@ -88,6 +88,10 @@ typedef struct PCPProcess_ {
    unsigned long ctxt_diff;
    char* secattr;
    unsigned long long int last_mlrs_calctime;
+
+   /* values of the dynamic columns in the last fetch, see PCPDynamicColumns_updateValues() */
+   struct PCPDynamicValue_* dynamicValues;
+   size_t dynamicValueCount;
 } PCPProcess;
 
 extern const ProcessFieldData Process_fields[LAST_PROCESSFIELD];
@@ -18,20 +18,26 @@ in the source distribution for its full text.
 #include <string.h>
 #include <sys/time.h>
 
+#include "Hashtable.h"
 #include "Machine.h"
 #include "Macros.h"
 #include "Object.h"
 #include "Platform.h"
 #include "Process.h"
+#include "Rate.h"
 #include "Settings.h"
+#include "Table.h"
 #include "XUtils.h"
 
 #include "linux/CGroupUtils.h"
 #include "pcp/Metric.h"
+#include "pcp/PCPDynamicColumn.h"
 #include "pcp/PCPMachine.h"
 #include "pcp/PCPProcess.h"
 
 
+extern Platform* pcp;
+
 ProcessTable* ProcessTable_new(Machine* host, Hashtable* pidMatchList) {
    PCPProcessTable* this = xCalloc(1, sizeof(PCPProcessTable));
    Object_setClass(this, Class(ProcessTable));
@@ -48,67 +54,57 @@ void ProcessTable_delete(Object* cast) {
    free(this);
 }
 
-static inline long Metric_instance_s32(int metric, int pid, int offset, long fallback) {
-   pmAtomValue value;
-   if (Metric_instance(metric, pid, offset, &value, PM_TYPE_32))
-      return value.l;
-   return fallback;
-}
+/* The process metrics of the result being gone through, each walked once in instance order */
+static MetricCursor PCPProcessTable_cursors[PCP_METRIC_COUNT];
 
-static inline long long Metric_instance_s64(int metric, int pid, int offset, long long fallback) {
-   pmAtomValue value;
-   if (Metric_instance(metric, pid, offset, &value, PM_TYPE_64))
-      return value.l;
-   return fallback;
+static void PCPProcessTable_initCursors(void) {
+   for (int metric = PCP_PROC_PID; metric < PCP_METRIC_COUNT; metric++)
+      MetricCursor_init(&PCPProcessTable_cursors[metric], metric);
 }
 
-static inline unsigned long Metric_instance_u32(int metric, int pid, int offset, unsigned long fallback) {
-   pmAtomValue value;
-   if (Metric_instance(metric, pid, offset, &value, PM_TYPE_U32))
-      return value.ul;
+static inline long long Metric_instance_signed(int metric, int pid, long long fallback) {
+   long long value;
+   if (MetricCursor_signed(&PCPProcessTable_cursors[metric], pid, &value))
+      return value;
    return fallback;
 }
 
-static inline unsigned long long Metric_instance_u64(int metric, int pid, int offset, unsigned long long fallback) {
-   pmAtomValue value;
-   if (Metric_instance(metric, pid, offset, &value, PM_TYPE_U64))
-      return value.ull;
+static inline unsigned long long Metric_instance_unsigned(int metric, int pid, unsigned long long fallback) {
+   unsigned long long value;
+   if (MetricCursor_unsigned(&PCPProcessTable_cursors[metric], pid, &value))
+      return value;
    return fallback;
 }
 
-static inline unsigned long long Metric_instance_time(int metric, int pid, int offset) {
-   pmAtomValue value;
-   if (Metric_instance(metric, pid, offset, &value, PM_TYPE_U64))
-      return value.ull / 10;
-   return 0;
+static inline unsigned long long Metric_instance_time(int metric, int pid) {
+   return Metric_instance_unsigned(metric, pid, 0) / 10;
 }
 
-static inline unsigned long long Metric_instance_ONE_K(int metric, int pid, int offset) {
-   pmAtomValue value;
-   if (Metric_instance(metric, pid, offset, &value, PM_TYPE_U64))
-      return value.ull / ONE_K;
+static inline unsigned long long Metric_instance_ONE_K(int metric, int pid) {
+   unsigned long long value;
+   if (MetricCursor_unsigned(&PCPProcessTable_cursors[metric], pid, &value))
+      return value / ONE_K;
    return ULLONG_MAX;
 }
 
-static inline char Metric_instance_char(int metric, int pid, int offset, char fallback) {
-   pmAtomValue value;
-   if (Metric_instance(metric, pid, offset, &value, PM_TYPE_STRING)) {
-      char uchar = value.cp[0];
-      free(value.cp);
-      return uchar;
-   }
-   return fallback;
+static inline const char* Metric_instance_string(int metric, int pid) {
+   return MetricCursor_string(&PCPProcessTable_cursors[metric], pid);
+}
+
+static inline char Metric_instance_char(int metric, int pid, char fallback) {
+   const char* value = Metric_instance_string(metric, pid);
+   return value ? value[0] : fallback;
 }
 
-static char* setUser(UsersTable* this, unsigned int uid, int pid, int offset) {
+static char* setUser(UsersTable* this, unsigned int uid, int pid) {
    char* name = Hashtable_get(this->users, uid);
    if (name)
       return name;
 
-   pmAtomValue value;
-   if (Metric_instance(PCP_PROC_ID_USER, pid, offset, &value, PM_TYPE_STRING)) {
-      Hashtable_put(this->users, uid, value.cp);
-      name = value.cp;
+   const char* value = Metric_instance_string(PCP_PROC_ID_USER, pid);
+   if (value) {
+      name = xStrdup(value);
+      Hashtable_put(this->users, uid, name);
    }
    return name;
 }
@@ -130,130 +126,118 @@ static inline ProcessState PCPProcessTable_getProcessState(char state) {
    }
 }
 
-static void PCPProcessTable_updateID(Process* process, int pid, int offset) {
-   Process_setThreadGroup(process, Metric_instance_u32(PCP_PROC_TGID, pid, offset, 1));
-   Process_setParent(process, Metric_instance_u32(PCP_PROC_PPID, pid, offset, 1));
-   process->state = PCPProcessTable_getProcessState(Metric_instance_char(PCP_PROC_STATE, pid, offset, '?'));
+static void PCPProcessTable_updateID(Process* process, int pid) {
+   Process_setThreadGroup(process, Metric_instance_unsigned(PCP_PROC_TGID, pid, 1));
+   Process_setParent(process, Metric_instance_unsigned(PCP_PROC_PPID, pid, 1));
+   process->state = PCPProcessTable_getProcessState(Metric_instance_char(PCP_PROC_STATE, pid, '?'));
 }
 
-static void PCPProcessTable_updateInfo(PCPProcess* pp, int pid, int offset, char* command, size_t commLen) {
+static void PCPProcessTable_updateInfo(PCPProcess* pp, int pid, char* command, size_t commLen) {
    Process* process = &pp->super;
-   pmAtomValue value;
-
-   if (!Metric_instance(PCP_PROC_CMD, pid, offset, &value, PM_TYPE_STRING))
-      value.cp = xStrdup("<unknown>");
-   String_safeStrncpy(command, value.cp, commLen);
-   free(value.cp);
-
-   process->pgrp = Metric_instance_u32(PCP_PROC_PGRP, pid, offset, 0);
-   process->session = Metric_instance_u32(PCP_PROC_SESSION, pid, offset, 0);
-   process->tty_nr = Metric_instance_u32(PCP_PROC_TTY, pid, offset, 0);
-   process->tpgid = Metric_instance_u32(PCP_PROC_TTYPGRP, pid, offset, 0);
-   process->minflt = Metric_instance_u32(PCP_PROC_MINFLT, pid, offset, 0);
-   pp->cminflt = Metric_instance_u32(PCP_PROC_CMINFLT, pid, offset, 0);
-   process->majflt = Metric_instance_u32(PCP_PROC_MAJFLT, pid, offset, 0);
-   pp->cmajflt = Metric_instance_u32(PCP_PROC_CMAJFLT, pid, offset, 0);
-   pp->utime = Metric_instance_time(PCP_PROC_UTIME, pid, offset);
-   pp->stime = Metric_instance_time(PCP_PROC_STIME, pid, offset);
-   pp->cutime = Metric_instance_time(PCP_PROC_CUTIME, pid, offset);
-   pp->cstime = Metric_instance_time(PCP_PROC_CSTIME, pid, offset);
-   process->priority = Metric_instance_u32(PCP_PROC_PRIORITY, pid, offset, 0);
-   process->nice = Metric_instance_s32(PCP_PROC_NICE, pid, offset, 0);
-   process->nlwp = Metric_instance_u32(PCP_PROC_THREADS, pid, offset, 0);
-   process->starttime_ctime = Metric_instance_time(PCP_PROC_STARTTIME, pid, offset);
-   process->processor = Metric_instance_u32(PCP_PROC_PROCESSOR, pid, offset, 0);
+
+   const char* value = Metric_instance_string(PCP_PROC_CMD, pid);
+   String_safeStrncpy(command, value ? value : "<unknown>", commLen);
+
+   process->pgrp = Metric_instance_unsigned(PCP_PROC_PGRP, pid, 0);
+   process->session = Metric_instance_unsigned(PCP_PROC_SESSION, pid, 0);
+   process->tty_nr = Metric_instance_unsigned(PCP_PROC_TTY, pid, 0);
+   process->tpgid = Metric_instance_unsigned(PCP_PROC_TTYPGRP, pid, 0);
+   process->minflt = Metric_instance_unsigned(PCP_PROC_MINFLT, pid, 0);
+   pp->cminflt = Metric_instance_unsigned(PCP_PROC_CMINFLT, pid, 0);
+   process->majflt = Metric_instance_unsigned(PCP_PROC_MAJFLT, pid, 0);
+   pp->cmajflt = Metric_instance_unsigned(PCP_PROC_CMAJFLT, pid, 0);
+   pp->utime = Metric_instance_time(PCP_PROC_UTIME, pid);
+   pp->stime = Metric_instance_time(PCP_PROC_STIME, pid);
+   pp->cutime = Metric_instance_time(PCP_PROC_CUTIME, pid);
+   pp->cstime = Metric_instance_time(PCP_PROC_CSTIME, pid);
+   process->priority = Metric_instance_unsigned(PCP_PROC_PRIORITY, pid, 0);
+   process->nice = Metric_instance_signed(PCP_PROC_NICE, pid, 0);
+   process->nlwp = Metric_instance_unsigned(PCP_PROC_THREADS, pid, 0);
+   process->starttime_ctime = Metric_instance_time(PCP_PROC_STARTTIME, pid);
+   process->processor = Metric_instance_unsigned(PCP_PROC_PROCESSOR, pid, 0);
 
    process->time = pp->utime + pp->stime;
 }
 
-static void PCPProcessTable_updateIO(PCPProcess* pp, int pid, int offset, unsigned long long now) {
-   pmAtomValue value;
+static void PCPProcessTable_updateIO(PCPProcess* pp, int pid, unsigned long long now) {
+   unsigned long long value;
 
-   pp->io_rchar = Metric_instance_ONE_K(PCP_PROC_IO_RCHAR, pid, offset);
-   pp->io_wchar = Metric_instance_ONE_K(PCP_PROC_IO_WCHAR, pid, offset);
-   pp->io_syscr = Metric_instance_u64(PCP_PROC_IO_SYSCR, pid, offset, ULLONG_MAX);
-   pp->io_syscw = Metric_instance_u64(PCP_PROC_IO_SYSCW, pid, offset, ULLONG_MAX);
-   pp->io_cancelled_write_bytes = Metric_instance_ONE_K(PCP_PROC_IO_CANCELLED, pid, offset);
+   pp->io_rchar = Metric_instance_ONE_K(PCP_PROC_IO_RCHAR, pid);
+   pp->io_wchar = Metric_instance_ONE_K(PCP_PROC_IO_WCHAR, pid);
+   pp->io_syscr = Metric_instance_unsigned(PCP_PROC_IO_SYSCR, pid, ULLONG_MAX);
+   pp->io_syscw = Metric_instance_unsigned(PCP_PROC_IO_SYSCW, pid, ULLONG_MAX);
+   pp->io_cancelled_write_bytes = Metric_instance_ONE_K(PCP_PROC_IO_CANCELLED, pid);
 
-   if (Metric_instance(PCP_PROC_IO_READB, pid, offset, &value, PM_TYPE_U64)) {
-      unsigned long long last_read = pp->io_read_bytes;
-      pp->io_read_bytes = value.ull / ONE_K;
-      pp->io_rate_read_bps = ONE_K * (pp->io_read_bytes - last_read) /
-                                     (now - pp->io_last_scan_time);
+   if (MetricCursor_unsigned(&PCPProcessTable_cursors[PCP_PROC_IO_READB], pid, &value)) {
+      pp->io_read_bytes = value / ONE_K;
+      Rate_update(&pp->io_read_rate, value, now);
    } else {
       pp->io_read_bytes = ULLONG_MAX;
-      pp->io_rate_read_bps = NAN;
+      Rate_reset(&pp->io_read_rate);
    }
 
-   if (Metric_instance(PCP_PROC_IO_WRITEB, pid, offset, &value, PM_TYPE_U64)) {
-      unsigned long long last_write = pp->io_write_bytes;
-      pp->io_write_bytes = value.ull;
-      pp->io_rate_write_bps = ONE_K * (pp->io_write_bytes - last_write) /
-                                      (now - pp->io_last_scan_time);
+   if (MetricCursor_unsigned(&PCPProcessTable_cursors[PCP_PROC_IO_WRITEB], pid, &value)) {
+      pp->io_write_bytes = value;
+      Rate_update(&pp->io_write_rate, value, now);
    } else {
       pp->io_write_bytes = ULLONG_MAX;
-      pp->io_rate_write_bps = NAN;
+      Rate_reset(&pp->io_write_rate);
    }
-
-   pp->io_last_scan_time = now;
 }
 
-static void PCPProcessTable_updateMemory(PCPProcess* pp, int pid, int offset) {
-   pp->super.m_virt = Metric_instance_u32(PCP_PROC_MEM_SIZE, pid, offset, 0);
-   pp->super.m_resident = Metric_instance_u32(PCP_PROC_MEM_RSS, pid, offset, 0);
-   pp->m_share = Metric_instance_u32(PCP_PROC_MEM_SHARE, pid, offset, 0);
+static void PCPProcessTable_updateMemory(PCPProcess* pp, int pid) {
+   pp->super.m_virt = Metric_instance_unsigned(PCP_PROC_MEM_SIZE, pid, 0);
+   pp->super.m_resident = Metric_instance_unsigned(PCP_PROC_MEM_RSS, pid, 0);
+   pp->m_share = Metric_instance_unsigned(PCP_PROC_MEM_SHARE, pid, 0);
    pp->m_priv = pp->super.m_resident - pp->m_share;
-   pp->m_trs = Metric_instance_u32(PCP_PROC_MEM_TEXTRS, pid, offset, 0);
-   pp->m_lrs = Metric_instance_u32(PCP_PROC_MEM_LIBRS, pid, offset, 0);
-   pp->m_drs = Metric_instance_u32(PCP_PROC_MEM_DATRS, pid, offset, 0);
-   pp->m_dt = Metric_instance_u32(PCP_PROC_MEM_DIRTY, pid, offset, 0);
+   pp->m_trs = Metric_instance_unsigned(PCP_PROC_MEM_TEXTRS, pid, 0);
+   pp->m_lrs = Metric_instance_unsigned(PCP_PROC_MEM_LIBRS, pid, 0);
+   pp->m_drs = Metric_instance_unsigned(PCP_PROC_MEM_DATRS, pid, 0);
+   pp->m_dt = Metric_instance_unsigned(PCP_PROC_MEM_DIRTY, pid, 0);
 }
 
-static void PCPProcessTable_updateSmaps(PCPProcess* pp, pid_t pid, int offset) {
-   pp->m_pss = Metric_instance_u64(PCP_PROC_SMAPS_PSS, pid, offset, 0);
-   pp->m_swap = Metric_instance_u64(PCP_PROC_SMAPS_SWAP, pid, offset, 0);
-   pp->m_psswp = Metric_instance_u64(PCP_PROC_SMAPS_SWAPPSS, pid, offset, 0);
+static void PCPProcessTable_updateSmaps(PCPProcess* pp, pid_t pid) {
+   pp->m_pss = Metric_instance_unsigned(PCP_PROC_SMAPS_PSS, pid, 0);
+   pp->m_swap = Metric_instance_unsigned(PCP_PROC_SMAPS_SWAP, pid, 0);
+   pp->m_psswp = Metric_instance_unsigned(PCP_PROC_SMAPS_SWAPPSS, pid, 0);
 }
 
-static void PCPProcessTable_readOomData(PCPProcess* pp, int pid, int offset) {
-   pp->oom = Metric_instance_u32(PCP_PROC_OOMSCORE, pid, offset, 0);
+static void PCPProcessTable_readOomData(PCPProcess* pp, int pid) {
+   pp->oom = Metric_instance_unsigned(PCP_PROC_OOMSCORE, pid, 0);
 }
 
-static void PCPProcessTable_readAutogroup(PCPProcess* pp, int pid, int offset) {
-   pp->autogroup_id = Metric_instance_s64(PCP_PROC_AUTOGROUP_ID, pid, offset, -1);
-   pp->autogroup_nice = Metric_instance_s32(PCP_PROC_AUTOGROUP_NICE, pid, offset, 0);
+static void PCPProcessTable_readAutogroup(PCPProcess* pp, int pid) {
+   pp->autogroup_id = Metric_instance_signed(PCP_PROC_AUTOGROUP_ID, pid, -1);
+   pp->autogroup_nice = Metric_instance_signed(PCP_PROC_AUTOGROUP_NICE, pid, 0);
 }
 
-static void PCPProcessTable_readCtxtData(PCPProcess* pp, int pid, int offset) {
-   pmAtomValue value;
+static void PCPProcessTable_readCtxtData(PCPProcess* pp, int pid) {
    unsigned long ctxt = 0;
 
-   if (Metric_instance(PCP_PROC_VCTXSW, pid, offset, &value, PM_TYPE_U32))
-      ctxt += value.ul;
-   if (Metric_instance(PCP_PROC_NVCTXSW, pid, offset, &value, PM_TYPE_U32))
-      ctxt += value.ul;
+   ctxt += Metric_instance_unsigned(PCP_PROC_VCTXSW, pid, 0);
+   ctxt += Metric_instance_unsigned(PCP_PROC_NVCTXSW, pid, 0);
 
    pp->ctxt_diff = ctxt > pp->ctxt_total ? ctxt - pp->ctxt_total : 0;
    pp->ctxt_total = ctxt;
 }
 
-static char* setString(Metric metric, int pid, int offset, char* string) {
-   if (string)
-      free(string);
-   pmAtomValue value;
-   if (Metric_instance(metric, pid, offset, &value, PM_TYPE_STRING))
-      string = value.cp;
-   else
-      string = NULL;
-   return string;
+static char* setString(Metric metric, int pid, char* string) {
+   const char* value = Metric_instance_string(metric, pid);
+
+   /* mostly the same as in the last scan, then it is kept as is */
+   if (value && string && String_eq(value, string))
+      return string;
+
+   free(string);
+   return value ? xStrdup(value) : NULL;
 }
 
-static void PCPProcessTable_updateTTY(Process* process, int pid, int offset) {
-   process->tty_name = setString(PCP_PROC_TTYNAME, pid, offset, process->tty_name);
+static void PCPProcessTable_updateTTY(Process* process, int pid) {
+   process->tty_name = setString(PCP_PROC_TTYNAME, pid, process->tty_name);
 }
 
-static void PCPProcessTable_readCGroups(PCPProcess* pp, int pid, int offset) {
-   pp->cgroup = setString(PCP_PROC_CGROUPS, pid, offset, pp->cgroup);
+static void PCPProcessTable_readCGroups(PCPProcess* pp, int pid) {
+   pp->cgroup = setString(PCP_PROC_CGROUPS, pid, pp->cgroup);
 
    if (pp->cgroup) {
       char* cgroup_short = CGroup_filterName(pp->cgroup);
@@ -287,37 +271,40 @@ static void PCPProcessTable_readCGroups(PCPProcess* pp, int pid, int offset) {
    }
 }
 
-static void PCPProcessTable_readSecattrData(PCPProcess* pp, int pid, int offset) {
-   pp->secattr = setString(PCP_PROC_LABELS, pid, offset, pp->secattr);
+static void PCPProcessTable_readSecattrData(PCPProcess* pp, int pid) {
+   pp->secattr = setString(PCP_PROC_LABELS, pid, pp->secattr);
 }
 
-static void PCPProcessTable_readCwd(PCPProcess* pp, int pid, int offset) {
-   pp->super.procCwd = setString(PCP_PROC_CWD, pid, offset, pp->super.procCwd);
+static void PCPProcessTable_readCwd(PCPProcess* pp, int pid) {
+   pp->super.procCwd = setString(PCP_PROC_CWD, pid, pp->super.procCwd);
 }
 
-static void PCPProcessTable_updateUsername(Process* process, int pid, int offset, UsersTable* users) {
-   process->st_uid = Metric_instance_u32(PCP_PROC_ID_UID, pid, offset, 0);
-   process->user = setUser(users, process->st_uid, pid, offset);
+static void PCPProcessTable_updateUsername(Process* process, int pid, UsersTable* users) {
+   process->st_uid = Metric_instance_unsigned(PCP_PROC_ID_UID, pid, 0);
+   process->user = setUser(users, process->st_uid, pid);
 }
 
-static void PCPProcessTable_updateCmdline(Process* process, int pid, int offset, const char* comm) {
-   pmAtomValue value;
-   if (!Metric_instance(PCP_PROC_PSARGS, pid, offset, &value, PM_TYPE_STRING)) {
+static void PCPProcessTable_updateCmdline(Process* process, int pid, const char* comm) {
+   const char* value = Metric_instance_string(PCP_PROC_PSARGS, pid);
+   if (!value) {
       if (process->state != ZOMBIE)
          process->isKernelThread = true;
       Process_updateCmdline(process, NULL, 0, 0);
       return;
    }
 
-   char* command = value.cp;
+   const char* command = value;
+   char* trimmed = NULL;
    int length = strlen(command);
    if (command[0] != '(') {
       process->isKernelThread = false;
    } else {
       ++command;
       --length;
-      if (command[length - 1] == ')')
-         command[--length] = '\0';
+      if (length > 0 && command[length - 1] == ')') {
+         trimmed = xStrndup(command, --length);
+         command = trimmed;
+      }
       process->isKernelThread = true;
    }
 
@@ -340,14 +327,18 @@ static void PCPProcessTable_updateCmdline(Process* process, int pid, int offset,
       tokenStart = 0;
 
    Process_updateCmdline(process, command, tokenStart, tokenEnd);
-   free(value.cp);
+   free(trimmed);
 
    Process_updateComm(process, comm);
 
-   if (Metric_instance(PCP_PROC_EXE, pid, offset, &value, PM_TYPE_STRING)) {
-      Process_updateExe(process, value.cp[0] ? value.cp : NULL);
-      free(value.cp);
-   }
+   value = Metric_instance_string(PCP_PROC_EXE, pid);
+   if (value)
+      Process_updateExe(process, value[0] ? value : NULL);
+}
+
+/* Whether the threads of the process were fetched, see PCPMachine_updateThreads(); else they are counted from it */
+static bool PCPProcessTable_threadsFetched(const PCPMachine* phost, const Process* proc) {
+   return phost->threadsFetched && (!phost->threadsFolded || proc->super.showChildren);
 }
 
 static bool PCPProcessTable_updateProcesses(PCPProcessTable* this) {
@@ -358,18 +349,30 @@ static bool PCPProcessTable_updateProcesses(PCPProcessTable* this) {
    const Settings* settings = host->settings;
    bool hideKernelThreads = settings->hideKernelThreads;
    bool hideUserlandThreads = settings->hideUserlandThreads;
-   uint32_t flags = settings->ss->flags;
+
+   /* the metrics may have been fetched more often than this table is updated */
+   const double period = (phost->timestamp - this->timestamp) * 100;
+   this->timestamp = phost->timestamp;
+   uint64_t flags = settings->ss->flags;
 
    unsigned long long now = (unsigned long long)(phost->timestamp * 1000);
    int pid = -1, offset = -1;
 
+   /* the values of the dynamic columns on screen are extracted once, not per comparison */
+   int shownCount;
+   const ScreenColumn* shown = ScreenSettings_getColumns(settings->ss, settings->dynamicColumns, &shownCount);
+   const RowField sortKey = ScreenSettings_getActiveSortKey(settings->ss);
+   const PCPDynamicColumn* sortColumn = sortKey >= LAST_PROCESSFIELD ? Hashtable_get(settings->dynamicColumns, sortKey) : NULL;
+
+   PCPProcessTable_initCursors();
+
    /* for every process ... */
    while (Metric_iterate(PCP_PROC_PID, &pid, &offset)) {
 
       bool preExisting;
       Process* proc = ProcessTable_getProcess(pt, pid, &preExisting, PCPProcess_new);
       PCPProcess* pp = (PCPProcess*) proc;
-      PCPProcessTable_updateID(proc, pid, offset);
+      PCPProcessTable_updateID(proc, pid);
       proc->isUserlandThread = Process_getPid(proc) != Process_getThreadGroup(proc);
       pp->offset = offset >= 0 ? offset : 0;
 
@@ -380,7 +383,7 @@ static bool PCPProcessTable_updateProcesses(PCPProcessTable* this) {
        * But it will short-circuit subsequent scans.
        */
       if (preExisting && hideKernelThreads && Process_isKernelThread(proc)) {
-         proc->super.updated = true;
+         Table_markUpdated(&this->super.super, &proc->super);
          proc->super.show = false;
          if (proc->state == RUNNING)
             pt->runningTasks++;
@@ -389,7 +392,7 @@ static bool PCPProcessTable_updateProcesses(PCPProcessTable* this) {
          continue;
       }
       if (preExisting && hideUserlandThreads && Process_isUserlandThread(proc)) {
-         proc->super.updated = true;
+         Table_markUpdated(&this->super.super, &proc->super);
          proc->super.show = false;
          if (proc->state == RUNNING)
             pt->runningTasks++;
@@ -398,14 +401,19 @@ static bool PCPProcessTable_updateProcesses(PCPProcessTable* this) {
          continue;
       }
 
-      if (flags & PROCESS_FLAG_IO)
-         PCPProcessTable_updateIO(pp, pid, offset, now);
+      /* with lazy collection some metrics were only fetched for the rows on screen */
+      uint64_t procFlags = flags;
+      if (!Table_isRowOnScreen(&pt->super, &proc->super))
+         procFlags &= ~phost->lazyFlags;
 
-      PCPProcessTable_updateMemory(pp, pid, offset);
+      if (procFlags & PROCESS_FLAG_IO)
+         PCPProcessTable_updateIO(pp, pid, now);
+
+      PCPProcessTable_updateMemory(pp, pid);
 
       if ((flags & PROCESS_FLAG_LINUX_SMAPS) && !Process_isKernelThread(proc)) {
          if (Metric_enabled(PCP_PROC_SMAPS_PSS)) {
-            PCPProcessTable_updateSmaps(pp, pid, offset);
+            PCPProcessTable_updateSmaps(pp, pid);
          }
       }
 
@@ -413,47 +421,50 @@ static bool PCPProcessTable_updateProcesses(PCPProcessTable* this) {
       unsigned int tty_nr = proc->tty_nr;
       unsigned long long int lasttimes = pp->utime + pp->stime;
 
-      PCPProcessTable_updateInfo(pp, pid, offset, command, sizeof(command));
+      PCPProcessTable_updateInfo(pp, pid, command, sizeof(command));
       proc->starttime_ctime += Platform_getBootTime();
       if (tty_nr != proc->tty_nr)
-         PCPProcessTable_updateTTY(proc, pid, offset);
+         PCPProcessTable_updateTTY(proc, pid);
 
       proc->percent_cpu = NAN;
-      if (phost->period > 0.0) {
-         float percent_cpu = saturatingSub(pp->utime + pp->stime, lasttimes) / phost->period * 100.0;
+      if (period > 0.0) {
+         float percent_cpu = saturatingSub(pp->utime + pp->stime, lasttimes) / period * 100.0;
          proc->percent_cpu = MINIMUM(percent_cpu, host->activeCPUs * 100.0F);
       }
       proc->percent_mem = proc->m_resident / (double) host->totalMem * 100.0;
       Process_updateCPUFieldWidths(proc->percent_cpu);
 
-      PCPProcessTable_updateUsername(proc, pid, offset, host->usersTable);
+      PCPProcessTable_updateUsername(proc, pid, host->usersTable);
 
       if (!preExisting) {
-         PCPProcessTable_updateCmdline(proc, pid, offset, command);
+         PCPProcessTable_updateCmdline(proc, pid, command);
          Process_fillStarttimeBuffer(proc);
          ProcessTable_add(pt, proc);
       } else if (settings->updateProcessNames && proc->state != ZOMBIE) {
-         PCPProcessTable_updateCmdline(proc, pid, offset, command);
+         PCPProcessTable_updateCmdline(proc, pid, command);
       }
 
-      if (flags & PROCESS_FLAG_LINUX_CGROUP)
-         PCPProcessTable_readCGroups(pp, pid, offset);
+      if (procFlags & PROCESS_FLAG_LINUX_CGROUP)
+         PCPProcessTable_readCGroups(pp, pid);
+
+      if (procFlags & PROCESS_FLAG_LINUX_OOM)
+         PCPProcessTable_readOomData(pp, pid);
 
-      if (flags & PROCESS_FLAG_LINUX_OOM)
-         PCPProcessTable_readOomData(pp, pid, offset);
+      if (procFlags & PROCESS_FLAG_LINUX_CTXT)
+         PCPProcessTable_readCtxtData(pp, pid);
 
-      if (flags & PROCESS_FLAG_LINUX_CTXT)
-         PCPProcessTable_readCtxtData(pp, pid, offset);
+      if (procFlags & PROCESS_FLAG_LINUX_SECATTR)
+         PCPProcessTable_readSecattrData(pp, pid);
 
-      if (flags & PROCESS_FLAG_LINUX_SECATTR)
-         PCPProcessTable_readSecattrData(pp, pid, offset);
+      if (procFlags & PROCESS_FLAG_CWD)
+         PCPProcessTable_readCwd(pp, pid);
 
-      if (flags & PROCESS_FLAG_CWD)
-         PCPProcessTable_readCwd(pp, pid, offset);
+      if (procFlags & PROCESS_FLAG_LINUX_AUTOGROUP)
+         PCPProcessTable_readAutogroup(pp, pid);
 
-      if (flags & PROCESS_FLAG_LINUX_AUTOGROUP)
-         PCPProcessTable_readAutogroup(pp, pid, offset);
+      PCPDynamicColumns_updateValues(&pcp->columns, pp, shown, shownCount, sortColumn);
 
+      bool counted = true;
       if (proc->state == ZOMBIE && !proc->cmdline && command[0]) {
          Process_updateCmdline(proc, command, 0, strlen(command));
       } else if (Process_isThread(proc)) {
@@ -461,21 +472,30 @@ static bool PCPProcessTable_updateProcesses(PCPProcessTable* this) {
             Process_updateCmdline(proc, command, 0, strlen(command));
          }
 
+         const Process* main = (const Process*) Table_findRow(&pt->super, Process_getThreadGroup(proc));
          if (Process_isKernelThread(proc)) {
             pt->kernelThreads++;
-         } else {
+         } else if (!main || PCPProcessTable_threadsFetched(phost, main)) {
             pt->userlandThreads++;
+         } else {
+            /* a new thread of a folded process, counted with it */
+            counted = false;
          }
+      } else if (!PCPProcessTable_threadsFetched(phost, proc) && proc->nlwp > 1) {
+         pt->userlandThreads += proc->nlwp - 1;
+         pt->totalTasks += proc->nlwp - 1;
       }
 
       /* Set at the end when we know if a new entry is a thread */
       proc->super.show = ! ((hideKernelThreads && Process_isKernelThread(proc)) ||
                       (hideUserlandThreads && Process_isUserlandThread(proc)));
 
-      pt->totalTasks++;
-      if (proc->state == RUNNING)
-         pt->runningTasks++;
-      proc->super.updated = true;
+      if (counted) {
+         pt->totalTasks++;
+         if (proc->state == RUNNING)
+            pt->runningTasks++;
+      }
+      Table_markUpdated(&this->super.super, &proc->super);
    }
    return true;
 }
@@ -484,3 +504,16 @@ void ProcessTable_goThroughEntries(ProcessTable* super) {
    PCPProcessTable* this = (PCPProcessTable*) super;
    PCPProcessTable_updateProcesses(this);
 }
+
+#ifdef HAVE_PTHREAD
+
+/* All values of processes come with the fetch of the machine, which is started ahead here */
+bool ProcessTable_prefetchEntries(ProcessTable* super) {
+   return PCPMachine_fetchAhead((PCPMachine*) super->super.host);
+}
+
+bool ProcessTable_entriesPrefetched(ATTR_UNUSED const ProcessTable* super) {
+   return Metric_fetchedAhead();
+}
+
+#endif /* HAVE_PTHREAD */
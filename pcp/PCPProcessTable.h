@@ -19,6 +19,8 @@ in the source distribution for its full text.
 
 typedef struct PCPProcessTable_ {
    ProcessTable super;
+
+   double timestamp;   /* of the metrics this table was last updated from */
 } PCPProcessTable;
 
 #endif
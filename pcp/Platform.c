@@ -29,12 +29,14 @@ in the source distribution for its full text.
 #include "FileDescriptorMeter.h"
 #include "HostnameMeter.h"
 #include "LoadAverageMeter.h"
+#include "Machine.h"
 #include "Macros.h"
 #include "MemoryMeter.h"
 #include "MemorySwapMeter.h"
 #include "Meter.h"
 #include "NetworkIOMeter.h"
 #include "ProcessTable.h"
+#include "SelfMeter.h"
 #include "Settings.h"
 #include "SwapMeter.h"
 #include "SysArchMeter.h"
@@ -45,7 +47,9 @@ in the source distribution for its full text.
 #include "linux/PressureStallMeter.h"
 #include "linux/ZramMeter.h"
 #include "linux/ZramStats.h"
+#include "pcp/ArchiveCache.h"
 #include "pcp/Metric.h"
+#include "pcp/PCPBench.h"
 #include "pcp/PCPDynamicColumn.h"
 #include "pcp/PCPDynamicMeter.h"
 #include "pcp/PCPDynamicScreen.h"
@@ -92,6 +96,7 @@ const MeterClass* const Platform_meterTypes[] = {
    &MemorySwapMeter_class,
    &TasksMeter_class,
    &UptimeMeter_class,
+   &SelfMeter_class,
    &BatteryMeter_class,
    &HostnameMeter_class,
    &AllCPUsMeter_class,
@@ -106,6 +111,16 @@ const MeterClass* const Platform_meterTypes[] = {
    &RightCPUs4Meter_class,
    &LeftCPUs8Meter_class,
    &RightCPUs8Meter_class,
+#ifdef HAVE_LIBHWLOC
+   &CPUNodesMeter_class,
+   &CPUSocketsMeter_class,
+   &CPUCachesMeter_class,
+   &CPUCoresMeter_class,
+   &BusiestCPUNodeMeter_class,
+   &BusiestCPUSocketMeter_class,
+   &BusiestCPUCacheMeter_class,
+   &BusiestCPUCoreMeter_class,
+#endif
    &BlankMeter_class,
    &PressureStallCPUSomeMeter_class,
    &PressureStallIOSomeMeter_class,
@@ -345,8 +360,12 @@ bool Platform_init(void) {
    pcp->pmids = xCalloc(PCP_METRIC_COUNT, sizeof(pmID));
    pcp->names = xCalloc(PCP_METRIC_COUNT, sizeof(char*));
    pcp->descs = xCalloc(PCP_METRIC_COUNT, sizeof(pmDesc));
+   pcp->profiledFetch = xMallocArray(PCP_METRIC_COUNT, sizeof(pmID));
+   for (unsigned int i = 0; i < PCP_METRIC_COUNT; i++)
+      pcp->profiledFetch[i] = PM_ID_NULL;
 
    if (opts.context == PM_CONTEXT_ARCHIVE) {
+      pcp->archive = true;
       gettimeofday(&pcp->offset, NULL);
       pmtimevalDec(&pcp->offset, &opts.start);
    }
@@ -355,20 +374,23 @@ bool Platform_init(void) {
       Platform_addMetric(i, Platform_metricNames[i]);
    pcp->meters.offset = PCP_METRIC_COUNT;
 
+   /* the dynamic metrics the source computes itself need no derived metric here */
+   Metric_loadSourceDerived();
    PCPDynamicMeters_init(&pcp->meters);
 
    pcp->columns.offset = PCP_METRIC_COUNT + pcp->meters.cursor;
    PCPDynamicColumns_init(&pcp->columns);
    PCPDynamicScreens_init(&pcp->screens, &pcp->columns);
 
-   sts = pmLookupName(pcp->totalMetrics, pcp->names, pcp->pmids);
+   /* the metrics of dynamic meters, columns and screens are looked up once used, see Metric_resolve() */
+   sts = pmLookupName(PCP_METRIC_COUNT, pcp->names, pcp->pmids);
    if (sts < 0) {
       fprintf(stderr, "Error: cannot lookup metric names: %s\n", pmErrStr(sts));
       Platform_done();
       return false;
    }
 
-   sts = pmLookupDescs(pcp->totalMetrics, pcp->pmids, pcp->descs);
+   sts = pmLookupDescs(PCP_METRIC_COUNT, pcp->pmids, pcp->descs);
    if (sts < 1) {
       if (sts < 0)
          fprintf(stderr, "Error: cannot lookup descriptors: %s\n", pmErrStr(sts));
@@ -378,8 +400,8 @@ bool Platform_init(void) {
       return false;
    }
 
-   /* set proc.control.perclient.threads to 1 for live contexts */
-   Metric_enableThreads();
+   /* processes only until the settings ask for threads, see PCPMachine_updateThreads() */
+   Metric_enableThreads(false);
 
    /* extract values needed for setup - e.g. cpu count, pid_max */
    Metric_enable(PCP_PID_MAX, true);
@@ -391,10 +413,6 @@ bool Platform_init(void) {
    Metric_enable(PCP_UNAME_MACHINE, true);
    Metric_enable(PCP_UNAME_DISTRO, true);
 
-   /* enable metrics for all dynamic columns (including those from dynamic screens) */
-   for (size_t i = pcp->columns.offset; i < pcp->columns.offset + pcp->columns.count; i++)
-      Metric_enable(i, true);
-
    Metric_fetch(NULL);
 
    for (Metric metric = 0; metric < PCP_PROC_PID; metric++)
@@ -428,20 +446,57 @@ void Platform_dynamicScreensDone(Hashtable* screens) {
 }
 
 void Platform_done(void) {
+   Metric_done();
    pmDestroyContext(pcp->context);
    if (pcp->result)
       pmFreeResult(pcp->result);
+   if (pcp->profiledResult)
+      pmFreeResult(pcp->profiledResult);
    free(pcp->release);
    free(pcp->fetch);
+   free(pcp->profiledFetch);
    free(pcp->pmids);
    free(pcp->names);
    free(pcp->descs);
    free(pcp);
 }
 
+static Htop_Reaction Platform_actionArchiveStep(State* st, int samples) {
+   int count = Metric_seek(samples);
+   if (count <= 0)
+      return HTOP_OK;
+
+   for (int i = 0; i < count; i++) {
+      Machine_scan(st->host);
+      Machine_scanTables(st->host);
+   }
+   return HTOP_REFRESH | HTOP_REDRAW_BAR | HTOP_KEEP_FOLLOWING;
+}
+
+static Htop_Reaction Platform_actionArchiveBack(State* st) {
+   return Platform_actionArchiveStep(st, -1);
+}
+
+static Htop_Reaction Platform_actionArchiveForward(State* st) {
+   return Platform_actionArchiveStep(st, 1);
+}
+
+static Htop_Reaction Platform_actionArchiveKeyBack(State* st) {
+   return Platform_actionArchiveStep(st, -ARCHIVECACHE_KEY_SPACING);
+}
+
+static Htop_Reaction Platform_actionArchiveKeyForward(State* st) {
+   return Platform_actionArchiveStep(st, ARCHIVECACHE_KEY_SPACING);
+}
+
 void Platform_setBindings(Htop_Action* keys) {
-   /* no platform-specific key bindings */
-   (void)keys;
+   /* stepping through an archive replaces changing priorities, there are no processes to change */
+   if (pcp->archive) {
+      keys['['] = Platform_actionArchiveBack;
+      keys[']'] = Platform_actionArchiveForward;
+      keys['{'] = Platform_actionArchiveKeyBack;
+      keys['}'] = Platform_actionArchiveKeyForward;
+   }
 }
 
 int Platform_getUptime(void) {
@@ -720,6 +775,13 @@ FileLocks_ProcessData* Platform_getProcessLocks(pid_t pid) {
    return NULL;
 }
 
+bool Platform_getProcessOpenFiles(pid_t pid, OpenFiles_AddFile addFile, void* context) {
+   (void)pid;
+   (void)addFile;
+   (void)context;
+   return false;
+}
+
 void Platform_getPressureStall(const char* file, bool some, double* ten, double* sixty, double* threehundred) {
    *ten = *sixty = *threehundred = 0;
 
@@ -791,12 +853,14 @@ void Platform_longOptionsUsage(ATTR_UNUSED const char* name) {
    printf(
 "   --host=HOSTSPEC              metrics source is PMCD at HOSTSPEC [see PCPIntro(1)]\n"
 "   --hostzone                   set reporting timezone to local time of metrics source\n"
-"   --timezone=TZ                set reporting timezone\n");
+"   --timezone=TZ                set reporting timezone\n"
+"   --bench=ARCHIVE              replay ARCHIVE as fast as possible and print timings\n");
 }
 
 CommandLineStatus Platform_getLongOption(int opt, ATTR_UNUSED int argc, char** argv) {
    /* libpcp export without a header definition */
    extern void __pmAddOptHost(pmOptions*, char*);
+   extern void __pmAddOptArchive(pmOptions*, char*);
 
    switch (opt) {
       case PLATFORM_LONGOPT_HOST:  /* --host=HOSTSPEC */
@@ -825,6 +889,13 @@ CommandLineStatus Platform_getLongOption(int opt, ATTR_UNUSED int argc, char** a
          }
          return STATUS_OK;
 
+      case PLATFORM_LONGOPT_BENCH:  /* --bench=ARCHIVE */
+         if (optarg[0] == '\0')
+            return STATUS_ERROR_EXIT;
+         __pmAddOptArchive(&opts, optarg);
+         PCPBench_enabled = true;
+         return STATUS_OK;
+
       default:
          break;
    }
@@ -882,7 +953,7 @@ Hashtable* Platform_dynamicColumns(void) {
 const char* Platform_dynamicColumnName(unsigned int key) {
    PCPDynamicColumn* this = Hashtable_get(pcp->columns.table, key);
    if (this) {
-      Metric_enable(this->id, true);
+      PCPDynamicColumns_resolve(&this, 1);
       if (this->super.caption)
          return this->super.caption;
       if (this->super.heading)
@@ -30,6 +30,7 @@ in the source distribution for its full text.
 #include "Hashtable.h"
 #include "Meter.h"
 #include "NetworkIOMeter.h"
+#include "OpenFilesScreen.h"
 #include "Process.h"
 #include "ProcessLocksScreen.h"
 #include "RichString.h"
@@ -50,6 +51,9 @@ typedef struct Platform_ {
    pmID* fetch;               /* enabled identifiers for sampling */
    pmDesc* descs;             /* metric desc array indexed by Metric */
    pmResult* result;          /* sample values result indexed by Metric */
+   pmID* profiledFetch;       /* enabled identifiers sampled for the profiled instances only */
+   pmResult* profiledResult;  /* values of those, indexed by Metric */
+   bool archive;              /* replaying an archive, each fetch moves on in time */
    PCPDynamicMeters meters;   /* dynamic meters via configuration files */
    PCPDynamicColumns columns; /* dynamic columns via configuration files */
    PCPDynamicScreens screens; /* dynamic screens via configuration files */
@@ -102,6 +106,8 @@ char* Platform_getProcessEnv(pid_t pid);
 
 FileLocks_ProcessData* Platform_getProcessLocks(pid_t pid);
 
+bool Platform_getProcessOpenFiles(pid_t pid, OpenFiles_AddFile addFile, void* context);
+
 void Platform_getPressureStall(const char* file, bool some, double* ten, double* sixty, double* threehundred);
 
 bool Platform_getDiskIO(DiskIOData* data);
@@ -118,12 +124,14 @@ enum {
    PLATFORM_LONGOPT_HOST = 128,
    PLATFORM_LONGOPT_TIMEZONE,
    PLATFORM_LONGOPT_HOSTZONE,
+   PLATFORM_LONGOPT_BENCH,
 };
 
 #define PLATFORM_LONG_OPTIONS \
       {PMLONGOPT_HOST, optional_argument, 0, PLATFORM_LONGOPT_HOST}, \
       {PMLONGOPT_TIMEZONE, optional_argument, 0, PLATFORM_LONGOPT_TIMEZONE}, \
       {PMLONGOPT_HOSTZONE, optional_argument, 0, PLATFORM_LONGOPT_HOSTZONE}, \
+      {"bench", required_argument, 0, PLATFORM_LONGOPT_BENCH}, \
 
 void Platform_longOptionsUsage(const char* name);
 
@@ -34,6 +34,7 @@ typedef struct SolarisProcess_ {
    pid_t      realppid;
    pid_t      realtgid;
    pid_t      lwpid;
+   int        psinfoFd;   /* /proc/<pid>/psinfo kept open for the process row, -1 if not */
 } SolarisProcess;
 
 extern const ProcessClass SolarisProcess_class;
@@ -10,8 +10,11 @@ in the source distribution for its full text.
 
 #include "solaris/SolarisProcessTable.h"
 
+#include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <sys/resource.h>
 #include <sys/types.h>
 #include <sys/user.h>
 #include <limits.h>
@@ -24,25 +27,31 @@ in the source distribution for its full text.
 
 #include "CRT.h"
 #include "solaris/Platform.h"
+#include "solaris/SolarisMachine.h"
 #include "solaris/SolarisProcess.h"
 
 
 #define GZONE "global    "
 #define UZONE "unknown   "
 
-static char* SolarisProcessTable_readZoneName(kstat_ctl_t* kd, SolarisProcess* sproc) {
-   char* zname;
+static char* SolarisProcessTable_readZoneName(SolarisProcessTable* this, const SolarisProcess* sproc) {
+   if ( sproc->zoneid == 0 )
+      return xStrdup(GZONE);
 
-   if ( sproc->zoneid == 0 ) {
-      zname = xStrdup(GZONE);
-   } else if ( kd == NULL ) {
-      zname = xStrdup(UZONE);
-   } else {
-      kstat_t* ks = kstat_lookup_wrapper( kd, "zones", sproc->zoneid, NULL );
-      zname = xStrdup(ks == NULL ? UZONE : ks->ks_name);
+   const char* cached = Hashtable_get(this->zoneNames, (ht_key_t)sproc->zoneid);
+   if (cached)
+      return xStrdup(cached);
+
+   const SolarisMachine* shost = (const SolarisMachine*) this->super.super.host;
+   const char* zname = UZONE;
+   if ( shost->kd != NULL ) {
+      kstat_t* ks = kstat_lookup_wrapper( shost->kd, "zones", sproc->zoneid, NULL );
+      if ( ks != NULL )
+         zname = ks->ks_name;
    }
 
-   return zname;
+   Hashtable_put(this->zoneNames, (ht_key_t)sproc->zoneid, xStrdup(zname));
+   return xStrdup(zname);
 }
 
 ProcessTable* ProcessTable_new(Machine* host, Hashtable* pidMatchList) {
@@ -52,12 +61,24 @@ ProcessTable* ProcessTable_new(Machine* host, Hashtable* pidMatchList) {
    ProcessTable* super = &this->super;
    ProcessTable_init(super, Class(SolarisProcess), host, pidMatchList);
 
+   this->zoneNames = Hashtable_new(16, true);
+
+   /* leave most of the open files limit to the rest of htop */
+   struct rlimit limit;
+   if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+      this->maxPsinfoFds = (unsigned int)MINIMUM(limit.rlim_cur / 2, (rlim_t)UINT_MAX);
+   } else {
+      this->maxPsinfoFds = 1024;
+   }
+
    return super;
 }
 
 void ProcessTable_delete(Object* cast) {
    SolarisProcessTable* this = (SolarisProcessTable*) cast;
    ProcessTable_done(&this->super);
+   Hashtable_delete(this->zoneNames);
+   free(this->lwpBuffer);
    free(this);
 }
 
@@ -100,10 +121,9 @@ static inline ProcessState SolarisProcessTable_getProcessState(char state) {
    }
 }
 
-/* NOTE: the following is a callback function of type proc_walk_f
- *       and MUST conform to the appropriate definition in order
- *       to work.  See libproc(3LIB) on a Solaris or Illumos
- *       system for more info.
+/* NOTE: the following is called once per LWP like a callback of type
+ *       proc_walk_f, see libproc(3LIB) on a Solaris or Illumos system
+ *       for more info.
  */
 
 static int SolarisProcessTable_walkproc(psinfo_t* _psinfo, lwpsinfo_t* _lwpsinfo, void* listptr) {
@@ -171,7 +191,7 @@ static int SolarisProcessTable_walkproc(psinfo_t* _psinfo, lwpsinfo_t* _lwpsinfo
       sproc->realpid        = _psinfo->pr_pid;
       sproc->lwpid          = lwpid_real;
       sproc->zoneid         = _psinfo->pr_zoneid;
-      sproc->zname          = SolarisProcessTable_readZoneName(spt->kd, sproc);
+      sproc->zname          = SolarisProcessTable_readZoneName(spt, sproc);
       SolarisProcessTable_updateExe(_psinfo->pr_pid, proc);
 
       Process_updateComm(proc, _psinfo->pr_fname);
@@ -255,14 +275,132 @@ static int SolarisProcessTable_walkproc(psinfo_t* _psinfo, lwpsinfo_t* _lwpsinfo
       ProcessTable_add(pt, proc);
    }
 
-   proc->super.updated = true;
+   Table_markUpdated(&pt->super, &proc->super);
 
    // End common code pass 2
 
    return 0;
 }
 
+/*
+ * Reads the psinfo of a process through the file its row keeps open, else
+ * through a new one that is handed back in fd. A file stays bound to the
+ * process it was opened for and fails to read once that exits, so a reused
+ * PID always gets a new one.
+ */
+static bool SolarisProcessTable_readPsinfo(SolarisProcess* sproc, pid_t pid, psinfo_t* psinfo, int* fd) {
+   *fd = -1;
+
+   if (sproc && sproc->psinfoFd >= 0) {
+      if (pread(sproc->psinfoFd, psinfo, sizeof(psinfo_t), 0) == (ssize_t)sizeof(psinfo_t))
+         return true;
+
+      close(sproc->psinfoFd);
+      sproc->psinfoFd = -1;
+   }
+
+   char path[32];
+   xSnprintf(path, sizeof(path), "/proc/%d/psinfo", (int)pid);
+   int newFd = open(path, O_RDONLY);
+   if (newFd < 0)
+      return false;
+
+   if (pread(newFd, psinfo, sizeof(psinfo_t), 0) != (ssize_t)sizeof(psinfo_t)) {
+      close(newFd);
+      return false;
+   }
+
+   *fd = newFd;
+   return true;
+}
+
+/* Reads all LWPs of a process at once, returning their header in the buffer */
+static prheader_t* SolarisProcessTable_readLwps(SolarisProcessTable* this, pid_t pid) {
+   char path[32];
+   xSnprintf(path, sizeof(path), "/proc/%d/lpsinfo", (int)pid);
+   int fd = open(path, O_RDONLY);
+   if (fd < 0)
+      return NULL;
+
+   prheader_t header;
+   prheader_t* result = NULL;
+   if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || header.pr_nent <= 0 || header.pr_entsize <= 0)
+      goto out;
+
+   size_t size = sizeof(header) + (size_t)header.pr_nent * (size_t)header.pr_entsize;
+   if (size > this->lwpBufferSize) {
+      free(this->lwpBuffer);
+      this->lwpBuffer = xMalloc(size);
+      this->lwpBufferSize = size;
+   }
+
+   /* the LWPs may have changed since the header was read, its count is what is in the file now */
+   ssize_t len = pread(fd, this->lwpBuffer, size, 0);
+   if (len < (ssize_t)sizeof(header))
+      goto out;
+
+   prheader_t* read = (prheader_t*)(void*) this->lwpBuffer;
+   read->pr_nent = MINIMUM(read->pr_nent, (long)(((size_t)len - sizeof(header)) / (size_t)header.pr_entsize));
+   read->pr_entsize = header.pr_entsize;
+   result = read;
+
+out:
+   close(fd);
+   return result;
+}
+
 void ProcessTable_goThroughEntries(ProcessTable* super) {
+   SolarisProcessTable* this = (SolarisProcessTable*) super;
+   const Settings* settings = super->super.host->settings;
+
    super->kernelThreads = 1;
-   proc_walk(&SolarisProcessTable_walkproc, super, PR_WALK_LWP);
+   this->psinfoFds = 0;
+   Hashtable_clear(this->zoneNames);
+
+   DIR* dir = opendir("/proc");
+   if (!dir)
+      return;
+
+   /* LWP rows are only shown with userland threads, else the representative LWP in psinfo is all it takes */
+   bool walkLwps = !settings->hideUserlandThreads;
+
+   const struct dirent* entry;
+   while ((entry = readdir(dir)) != NULL) {
+      char* end;
+      long id = strtol(entry->d_name, &end, 10);
+      if (*end || id < 0 || id > INT_MAX / 1024)
+         continue;
+
+      pid_t pid = (pid_t)id;
+      SolarisProcess* sproc = (SolarisProcess*) Table_findRow(&super->super, pid * 1024);
+
+      psinfo_t psinfo;
+      int newFd;
+      if (!SolarisProcessTable_readPsinfo(sproc, pid, &psinfo, &newFd))
+         continue;
+
+      prheader_t* lwps = (walkLwps && psinfo.pr_nlwp > 0) ? SolarisProcessTable_readLwps(this, pid) : NULL;
+      if (lwps) {
+         char* lwp = (char*)(lwps + 1);
+         for (long i = 0; i < lwps->pr_nent; i++, lwp += lwps->pr_entsize) {
+            SolarisProcessTable_walkproc(&psinfo, (lwpsinfo_t*)(void*)lwp, this);
+         }
+      } else {
+         SolarisProcessTable_walkproc(&psinfo, &psinfo.pr_lwp, this);
+      }
+
+      sproc = (SolarisProcess*) Table_findRow(&super->super, pid * 1024);
+      if (newFd >= 0) {
+         if (sproc && sproc->psinfoFd < 0 && this->psinfoFds < this->maxPsinfoFds) {
+            sproc->psinfoFd = newFd;
+         } else {
+            close(newFd);
+         }
+      }
+      if (sproc && sproc->psinfoFd >= 0) {
+         this->psinfoFds++;
+      }
+   }
+
+   closedir(dir);
 }
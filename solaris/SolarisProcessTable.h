@@ -10,6 +10,7 @@ in the source distribution for its full text.
 
 #include <kstat.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <sys/param.h>
 #include <sys/uio.h>
@@ -26,6 +27,12 @@ in the source distribution for its full text.
 
 typedef struct SolarisProcessTable_ {
    ProcessTable super;
+
+   Hashtable* zoneNames;          /* zoneid to name, looked up at most once per scan */
+   unsigned int psinfoFds;        /* psinfo files held open by the rows seen this scan */
+   unsigned int maxPsinfoFds;     /* more are read through a new file each scan */
+   char* lwpBuffer;               /* contents of the last lpsinfo file read */
+   size_t lwpBufferSize;
 } SolarisProcessTable;
 
 #endif
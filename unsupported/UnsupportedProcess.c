@@ -7,6 +7,8 @@ in the source distribution for its full text.
 
 #include "config.h" // IWYU pragma: keep
 
+#define HEAP_CLASS HEAP_PROCESSES
+
 #include "unsupported/UnsupportedProcess.h"
 
 #include <stdlib.h>
@@ -31,6 +33,9 @@ const ProcessFieldData Process_fields[LAST_PROCESSFIELD] = {
    [NICE] = { .name = "NICE", .title = " NI ", .description = "Nice value (the higher the value, the more it lets other processes take priority)", .flags = 0, },
    [STARTTIME] = { .name = "STARTTIME", .title = "START ", .description = "Time the process was started", .flags = 0, },
    [ELAPSED] = { .name = "ELAPSED", .title = "ELAPSED  ", .description = "Time since the process was started", .flags = 0, },
+   [CPU_HISTORY] = { .name = "CPU_HISTORY", .title = "CPU HISTORY                    ", .description = "Sparkline of the CPU usage over the last updates, full height being one CPU busy", .flags = PROCESS_FLAG_HISTORY, .defaultSortDesc = true, },
+   [MEM_HISTORY] = { .name = "MEM_HISTORY", .title = "RES HISTORY                    ", .description = "Sparkline of the resident memory over the last updates, against its peak", .flags = PROCESS_FLAG_HISTORY, .defaultSortDesc = true, },
+   [MEM_GROWTH] = { .name = "MEM_GROWTH", .title = "  RES/h ", .description = "Growth of the resident memory per hour, fitted over the memory growth window (leak suspects)", .flags = PROCESS_FLAG_MEM_GROWTH, .defaultSortDesc = true, },
    [PROCESSOR] = { .name = "PROCESSOR", .title = "CPU ", .description = "Id of the CPU the process last executed on", .flags = 0, },
    [M_VIRT] = { .name = "M_VIRT", .title = " VIRT ", .description = "Total program size in virtual memory", .flags = 0, .defaultSortDesc = true, },
    [M_RESIDENT] = { .name = "M_RESIDENT", .title = "  RES ", .description = "Resident set size, size of the text and data sections, plus stack usage", .flags = 0, .defaultSortDesc = true, },
@@ -45,7 +50,7 @@ const ProcessFieldData Process_fields[LAST_PROCESSFIELD] = {
 };
 
 Process* UnsupportedProcess_new(const Machine* host) {
-   Process* this = xCalloc(1, sizeof(UnsupportedProcess));
+   Process* this = Process_allocate(sizeof(UnsupportedProcess));
    Object_setClass(this, Class(UnsupportedProcess));
    Process_init(this, host);
    return this;
@@ -55,7 +60,7 @@ void Process_delete(Object* cast) {
    Process* super = (Process*) cast;
    Process_done(super);
    // free platform-specific fields here
-   free(cast);
+   Process_release(cast, sizeof(UnsupportedProcess));
 }
 
 static void UnsupportedProcess_rowWriteField(const Row* super, RichString* str, ProcessField field) {
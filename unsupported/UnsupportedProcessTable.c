@@ -53,7 +53,7 @@ void ProcessTable_goThroughEntries(ProcessTable* super) {
       free_and_xStrdup(&proc->procCwd, "/current/working/directory");
    }
 
-   proc->super.updated = true;
+   Table_markUpdated(&super->super, &proc->super);
 
    proc->state = RUNNING;
    proc->isKernelThread = false;